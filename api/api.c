@@ -526,6 +526,8 @@ static int API_env_enum(va_list ap)
 	if ((next = (char **)va_arg(ap, uintptr_t)) == NULL)
 		return API_EINVAL;
 
+	env_finish_import();
+
 	if (last == NULL) {
 		var = NULL;
 		i = 0;
@@ -111,6 +111,8 @@ u64 get_tcr(u64 *pips, u64 *pva_bits)
 }
 
 #define MAX_PTE_ENTRIES 512
+/* Number of adjacent entries covered by the contiguous hint (4KB granule) */
+#define CONT_PTE_ENTRIES 16
 
 static int pte_type(u64 *pte)
 {
@@ -260,6 +262,23 @@ static u64 *create_table(void)
 	return new_table;
 }
 
+/*
+ * Drops the contiguous hint from the group of entries holding *pte, since the
+ * entries of a group must stay identical apart from their output address
+ */
+static void clear_cont(u64 *pte)
+{
+	u64 *first;
+	int i;
+
+	if (!IS_ENABLED(CONFIG_ARMV8_PTE_CONT) || !(*pte & PTE_BLOCK_CONT))
+		return;
+
+	first = (u64 *)((ulong)pte & ~(CONT_PTE_ENTRIES * sizeof(u64) - 1));
+	for (i = 0; i < CONT_PTE_ENTRIES; i++)
+		first[i] &= ~PTE_BLOCK_CONT;
+}
+
 static void set_pte_table(u64 *pte, u64 *table)
 {
 	/* Point *pte to the new table */
@@ -281,6 +300,8 @@ static void split_block(u64 *pte, int level)
 		      "modify dcache settings for an range not covered in "
 		      "mem_map.", pte, old_pte);
 
+	clear_cont(pte);
+	old_pte &= ~PTE_BLOCK_CONT;
 	new_table = create_table();
 	debug("Splitting pte %p (%llx) into %p\n", pte, old_pte, new_table);
 
@@ -310,14 +331,30 @@ static void map_range(u64 virt, u64 phys, u64 size, int level,
 
 		if (level >= 1 &&
 		    size >= map_size && !(virt & (map_size - 1))) {
+			u64 cont_size = map_size * CONT_PTE_ENTRIES;
+			u64 pte_attrs = attrs;
+			int j, count = 1;
+
+			/*
+			 * A naturally aligned run of entries mapping adjacent
+			 * memory can share one TLB entry
+			 */
+			if (IS_ENABLED(CONFIG_ARMV8_PTE_CONT) &&
+			    size >= cont_size && !(virt & (cont_size - 1)) &&
+			    !(phys & (cont_size - 1))) {
+				pte_attrs |= PTE_BLOCK_CONT;
+				count = CONT_PTE_ENTRIES;
+			}
 			if (level == 3)
-				table[i] = phys | attrs | PTE_TYPE_PAGE;
-			else
-				table[i] = phys | attrs;
+				pte_attrs |= PTE_TYPE_PAGE;
 
-			virt += map_size;
-			phys += map_size;
-			size -= map_size;
+			for (j = 0; j < count; j++, i++) {
+				table[i] = phys | pte_attrs;
+				virt += map_size;
+				phys += map_size;
+				size -= map_size;
+			}
+			i--;
 
 			continue;
 		}
@@ -525,6 +562,17 @@ void invalidate_dcache_range(unsigned long start, unsigned long stop)
  */
 void flush_dcache_range(unsigned long start, unsigned long stop)
 {
+	/*
+	 * Cleaning a very large range line by line takes far longer than
+	 * cleaning the whole cache by set/way
+	 */
+	if (CONFIG_ARMV8_DCACHE_FLUSH_ALL_SIZE &&
+	    !IS_ENABLED(CONFIG_CMO_BY_VA_ONLY) &&
+	    stop - start >= CONFIG_ARMV8_DCACHE_FLUSH_ALL_SIZE) {
+		flush_dcache_all();
+		return;
+	}
+
 	__asm_flush_dcache_range(start, stop);
 }
 #else
@@ -604,6 +652,7 @@ static u64 set_one_region(u64 start, u64 size, u64 attrs, bool flag, int level)
 
 	/* Can we can just modify the current level block PTE? */
 	if (is_aligned(start, size, levelsize)) {
+		clear_cont(pte);
 		if (flag) {
 			*pte &= ~PMD_ATTRMASK;
 			*pte |= attrs & PMD_ATTRMASK;
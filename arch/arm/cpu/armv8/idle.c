@@ -0,0 +1,50 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Resting in polling loops, using WFE and the generic timer's event stream
+ *
+ * The event stream sets the event register at a fixed rate, so WFE returns
+ * within a bounded time even if no interrupt arrives and no other CPU signals
+ * an event.
+ */
+
+#include <cpu_func.h>
+#include <asm/system.h>
+#include <linux/bitops.h>
+#include <linux/kernel.h>
+
+/* Rate of the event stream, which sets the longest time spent in cpu_idle() */
+#define IDLE_EVENT_HZ		20000
+
+#define CNTKCTL_EVNTEN		BIT(2)
+#define CNTKCTL_EVNTDIR		BIT(3)
+#define CNTKCTL_EVNTI_SHIFT	4
+#define CNTKCTL_EVNTI_MASK	(0xf << CNTKCTL_EVNTI_SHIFT)
+
+static void idle_start_events(ulong cntkctl)
+{
+	ulong freq;
+	int evnti;
+
+	asm volatile("mrs %0, cntfrq_el0" : "=r" (freq));
+
+	/*
+	 * An event is generated each time bit EVNTI of the counter goes from 0
+	 * to 1, i.e. every 2^(EVNTI + 1) ticks
+	 */
+	evnti = clamp(fls(freq / IDLE_EVENT_HZ) - 2, 0, 15);
+	cntkctl &= ~(CNTKCTL_EVNTI_MASK | CNTKCTL_EVNTDIR);
+	cntkctl |= CNTKCTL_EVNTEN | evnti << CNTKCTL_EVNTI_SHIFT;
+	asm volatile("msr cntkctl_el1, %0" : : "r" (cntkctl));
+	isb();
+}
+
+void cpu_idle(void)
+{
+	ulong cntkctl;
+
+	asm volatile("mrs %0, cntkctl_el1" : "=r" (cntkctl));
+	if (!(cntkctl & CNTKCTL_EVNTEN))
+		idle_start_events(cntkctl);
+
+	asm volatile("wfe" : : : "memory");
+}
@@ -0,0 +1,86 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * ARMv8 PMUv3 performance counters
+ *
+ * The cycle counter is used for cycles and event counter 0 counts L1 data
+ * cache refills. Both are set to count at EL2 as well as EL1 and EL3, since
+ * U-Boot may be running at any of these.
+ */
+
+#include <errno.h>
+#include <pmu.h>
+#include <asm/system.h>
+#include <linux/bitops.h>
+
+#define ID_AA64DFR0_PMUVER_SHIFT	8
+#define ID_AA64DFR0_PMUVER_MASK		0xf
+#define ID_AA64DFR0_PMUVER_IMPDEF	0xf
+
+#define PMCR_E			BIT(0)
+#define PMCR_LC			BIT(6)
+#define PMCR_N_SHIFT		11
+#define PMCR_N_MASK		0x1f
+
+#define PMCNTEN_CYCLES		BIT(31)
+#define PMCNTEN_EVENT0		BIT(0)
+
+/* Filter bit to count at EL2 as well; EL0, EL1 and EL3 are counted anyway */
+#define PMU_FILTER_NSH		BIT(27)
+
+#define PMU_EVENT_L1D_CACHE_REFILL	0x03
+
+#define MDCR_EL3_SPME		BIT(17)
+
+/* This is called before relocation, so cannot keep state in BSS */
+static bool have_event_counter(void)
+{
+	ulong pmcr;
+
+	asm volatile("mrs %0, pmcr_el0" : "=r" (pmcr));
+
+	return (pmcr >> PMCR_N_SHIFT) & PMCR_N_MASK;
+}
+
+int pmu_counters_init(void)
+{
+	ulong dfr0, pmcr, mdcr;
+	bool event;
+
+	asm volatile("mrs %0, id_aa64dfr0_el1" : "=r" (dfr0));
+	dfr0 = (dfr0 >> ID_AA64DFR0_PMUVER_SHIFT) & ID_AA64DFR0_PMUVER_MASK;
+	if (!dfr0 || dfr0 == ID_AA64DFR0_PMUVER_IMPDEF)
+		return -ENOSYS;
+
+	/* Allow counting in the secure state */
+	if (current_el() == 3) {
+		asm volatile("mrs %0, mdcr_el3" : "=r" (mdcr));
+		asm volatile("msr mdcr_el3, %0" : : "r" (mdcr | MDCR_EL3_SPME));
+	}
+
+	event = have_event_counter();
+	asm volatile("msr pmccfiltr_el0, %0" : : "r" (PMU_FILTER_NSH));
+	if (event) {
+		asm volatile("msr pmevtyper0_el0, %0" : :
+			     "r" (PMU_FILTER_NSH | PMU_EVENT_L1D_CACHE_REFILL));
+	}
+	asm volatile("msr pmcntenset_el0, %0" : :
+		     "r" (PMCNTEN_CYCLES | (event ? PMCNTEN_EVENT0 : 0)));
+	asm volatile("mrs %0, pmcr_el0" : "=r" (pmcr));
+	asm volatile("msr pmcr_el0, %0" : : "r" (pmcr | PMCR_E | PMCR_LC));
+	isb();
+
+	return 0;
+}
+
+void pmu_counters_read(struct pmu_counts *counts)
+{
+	ulong val;
+
+	asm volatile("mrs %0, pmccntr_el0" : "=r" (val));
+	counts->cycles = val;
+	counts->cache_misses = 0;
+	if (have_event_counter()) {
+		asm volatile("mrs %0, pmevcntr0_el0" : "=r" (val));
+		counts->cache_misses = val;
+	}
+}
@@ -0,0 +1,22 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Sampling profiler interrupt, using the EL1 virtual timer and GICv3
+ */
+
+#include <profiler.h>
+#include <asm/armv8/timer_irq.h>
+
+static void profiler_irq(ulong pc)
+{
+	profiler_record(pc);
+}
+
+int arch_profiler_start(uint hz)
+{
+	return timer_irq_start(TIMER_IRQ_PROFILER, hz, profiler_irq);
+}
+
+void arch_profiler_stop(void)
+{
+	timer_irq_stop(TIMER_IRQ_PROFILER);
+}
@@ -0,0 +1,238 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Periodic interrupts, using the EL1 virtual timer and GICv3
+ *
+ * U-Boot does not otherwise take interrupts on ARMv8, so this sets up just
+ * enough of the GIC to deliver the virtual timer PPI to the boot CPU, and
+ * undoes it when the last user stops. Each user has its own period; the timer
+ * compare value is set to the earliest deadline.
+ */
+
+#include <errno.h>
+#include <log.h>
+#include <asm/gic.h>
+#include <asm/io.h>
+#include <asm/system.h>
+#include <asm/armv8/timer_irq.h>
+#include <dm/ofnode.h>
+#include <linux/bitops.h>
+#include <linux/kernel.h>
+#include <linux/sizes.h>
+#include <linux/stringify.h>
+
+/* PPI used by the EL1 virtual timer */
+#define VTIMER_INTID		27
+
+#define CNTV_CTL_ENABLE		BIT(0)
+
+#define GICR_TYPER_VLPIS	BIT(1)
+#define GICR_TYPER_LAST		BIT(4)
+#define GICR_FRAME_SIZE		(2 * SZ_64K)
+#define GICR_FRAME_SIZE_VLPI	(4 * SZ_64K)
+
+#define ICC_SRE_SRE		BIT(0)
+#define ICC_IAR_INTID		GENMASK(23, 0)
+#define ICC_INTID_SPURIOUS	1023
+
+#define HCR_EL2_IMO		BIT(4)
+
+#define read_sysreg(reg) ({						\
+	ulong __val;							\
+	asm volatile("mrs %0, " __stringify(reg) : "=r" (__val));	\
+	__val;								\
+})
+
+#define write_sysreg(val, reg) \
+	asm volatile("msr " __stringify(reg) ", %0" : : "r" ((ulong)(val)))
+
+/**
+ * struct timer_irq_user - A user of the timer interrupt
+ *
+ * @func: Function to call, or NULL if this user is not running
+ * @period: Timer ticks between calls
+ * @next: Counter value at which to call @func next
+ */
+struct timer_irq_user {
+	timer_irq_func_t func;
+	ulong period;
+	u64 next;
+};
+
+/**
+ * struct armv8_timer_irq - state saved while the interrupt is in use
+ *
+ * @sgi_base: Base of the SGI/PPI frame of this CPU's redistributor
+ * @users: Number of users running
+ * @hcr: Value of HCR_EL2 before the first user started (EL2 only)
+ * @pmr: Value of ICC_PMR_EL1 before the first user started
+ * @igrpen1: Value of ICC_IGRPEN1_EL1 before the first user started
+ * @user: Users of the interrupt
+ */
+static struct armv8_timer_irq {
+	ulong sgi_base;
+	int users;
+	ulong hcr;
+	ulong pmr;
+	ulong igrpen1;
+	struct timer_irq_user user[TIMER_IRQ_COUNT];
+} tirq;
+
+/* Find the SGI/PPI frame of the redistributor for this CPU */
+static ulong find_sgi_base(void)
+{
+	ulong mpidr = read_mpidr();
+	u32 aff = ((mpidr >> 8) & 0xff000000) | (mpidr & 0xffffff);
+	fdt_addr_t rd;
+	ofnode node;
+	u64 typer;
+
+	node = ofnode_by_compatible(ofnode_null(), "arm,gic-v3");
+	if (!ofnode_valid(node))
+		return 0;
+	rd = ofnode_get_addr_index(node, 1);
+	if (rd == FDT_ADDR_T_NONE)
+		return 0;
+
+	do {
+		typer = readq(rd + GICR_TYPER);
+		if (typer >> 32 == aff)
+			return rd + SZ_64K;
+		rd += typer & GICR_TYPER_VLPIS ? GICR_FRAME_SIZE_VLPI :
+			GICR_FRAME_SIZE;
+	} while (!(typer & GICR_TYPER_LAST));
+
+	return 0;
+}
+
+/* Set the timer to fire at the earliest deadline of the users running */
+static void timer_irq_arm(void)
+{
+	u64 next = U64_MAX;
+	int i;
+
+	for (i = 0; i < TIMER_IRQ_COUNT; i++) {
+		if (tirq.user[i].func)
+			next = min(next, tirq.user[i].next);
+	}
+	write_sysreg(next, cntv_cval_el0);
+	isb();
+}
+
+static int timer_irq_setup(void)
+{
+	uint el = current_el();
+
+	/* Interrupts from the timer are group 1 non-secure */
+	if (el == 3)
+		return -EPERM;
+	tirq.sgi_base = find_sgi_base();
+	if (!tirq.sgi_base) {
+		log_err("Cannot find GICv3 redistributor\n");
+		return -ENODEV;
+	}
+
+	/* Use the system-register interface to the GIC */
+	if (el == 2)
+		write_sysreg(read_sysreg(ICC_SRE_EL2) | ICC_SRE_SRE,
+			     ICC_SRE_EL2);
+	else
+		write_sysreg(read_sysreg(ICC_SRE_EL1) | ICC_SRE_SRE,
+			     ICC_SRE_EL1);
+	isb();
+
+	writeb(0xa0, tirq.sgi_base + GICR_IPRIORITYRn + VTIMER_INTID);
+	writel(BIT(VTIMER_INTID), tirq.sgi_base + GICR_ISENABLERn);
+
+	tirq.pmr = read_sysreg(ICC_PMR_EL1);
+	tirq.igrpen1 = read_sysreg(ICC_IGRPEN1_EL1);
+	write_sysreg(0xff, ICC_PMR_EL1);
+	write_sysreg(1, ICC_IGRPEN1_EL1);
+
+	/* Physical interrupts are only taken at EL2 if routed there */
+	if (el == 2) {
+		tirq.hcr = read_sysreg(hcr_el2);
+		write_sysreg(tirq.hcr | HCR_EL2_IMO, hcr_el2);
+	}
+
+	return 0;
+}
+
+int timer_irq_start(enum timer_irq_id id, uint hz, timer_irq_func_t func)
+{
+	struct timer_irq_user *user = &tirq.user[id];
+	ulong period;
+	int ret;
+
+	period = read_sysreg(cntfrq_el0) / hz;
+	if (!period)
+		return -EINVAL;
+
+	asm volatile("msr daifset, #2" : : : "memory");
+	if (!tirq.users) {
+		ret = timer_irq_setup();
+		if (ret)
+			return ret;
+	}
+	if (!user->func)
+		tirq.users++;
+	user->func = func;
+	user->period = period;
+	user->next = read_sysreg(cntvct_el0) + period;
+	timer_irq_arm();
+	write_sysreg(CNTV_CTL_ENABLE, cntv_ctl_el0);
+	isb();
+	asm volatile("msr daifclr, #2" : : : "memory");
+
+	return 0;
+}
+
+void timer_irq_stop(enum timer_irq_id id)
+{
+	struct timer_irq_user *user = &tirq.user[id];
+
+	if (!user->func)
+		return;
+	asm volatile("msr daifset, #2" : : : "memory");
+	user->func = NULL;
+	if (--tirq.users) {
+		timer_irq_arm();
+		asm volatile("msr daifclr, #2" : : : "memory");
+		return;
+	}
+	write_sysreg(0, cntv_ctl_el0);
+	writel(BIT(VTIMER_INTID), tirq.sgi_base + GICR_ICENABLERn);
+	write_sysreg(tirq.pmr, ICC_PMR_EL1);
+	write_sysreg(tirq.igrpen1, ICC_IGRPEN1_EL1);
+	if (current_el() == 2)
+		write_sysreg(tirq.hcr, hcr_el2);
+	isb();
+}
+
+int timer_irq_handle(ulong pc)
+{
+	ulong intid = read_sysreg(ICC_IAR1_EL1) & ICC_IAR_INTID;
+	int i;
+
+	if (intid == ICC_INTID_SPURIOUS)
+		return 0;
+	if (intid == VTIMER_INTID) {
+		u64 now = read_sysreg(cntvct_el0);
+
+		for (i = 0; i < TIMER_IRQ_COUNT; i++) {
+			struct timer_irq_user *user = &tirq.user[i];
+
+			if (!user->func || now < user->next)
+				continue;
+			user->func(pc);
+			user->next += user->period;
+			/* Skip calls which were missed, rather than bunching */
+			if (user->next <= now)
+				user->next = now + user->period;
+		}
+		timer_irq_arm();
+	}
+	write_sysreg(intid, ICC_EOIR1_EL1);
+	isb();
+
+	return intid == VTIMER_INTID ? 0 : -ENOENT;
+}
@@ -0,0 +1,22 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Watchdog servicing from the EL1 virtual timer interrupt
+ */
+
+#include <wdt.h>
+#include <asm/armv8/timer_irq.h>
+
+static void wdt_irq(ulong pc)
+{
+	wdt_irq_service();
+}
+
+int arch_wdt_irq_start(uint hz)
+{
+	return timer_irq_start(TIMER_IRQ_WATCHDOG, hz, wdt_irq);
+}
+
+void arch_wdt_irq_stop(void)
+{
+	timer_irq_stop(TIMER_IRQ_WATCHDOG);
+}
@@ -64,6 +64,7 @@
 #define PTE_BLOCK_INNER_SHARE	(3 << 8)
 #define PTE_BLOCK_AF		(1 << 10)
 #define PTE_BLOCK_NG		(1 << 11)
+#define PTE_BLOCK_CONT		(UL(1) << 52)
 #define PTE_BLOCK_PXN		(UL(1) << 53)
 #define PTE_BLOCK_UXN		(UL(1) << 54)
 
@@ -0,0 +1,65 @@
+/* SPDX-License-Identifier: GPL-2.0+ */
+/*
+ * Periodic interrupts from the EL1 virtual timer, shared by the profiler and
+ * the watchdog
+ */
+
+#ifndef __ASM_ARMV8_TIMER_IRQ_H
+#define __ASM_ARMV8_TIMER_IRQ_H
+
+#include <linux/types.h>
+
+/**
+ * enum timer_irq_id - Users of the timer interrupt
+ *
+ * @TIMER_IRQ_PROFILER: Sampling profiler
+ * @TIMER_IRQ_WATCHDOG: Watchdog servicing
+ * @TIMER_IRQ_COUNT: Number of users
+ */
+enum timer_irq_id {
+	TIMER_IRQ_PROFILER,
+	TIMER_IRQ_WATCHDOG,
+
+	TIMER_IRQ_COUNT,
+};
+
+/**
+ * typedef timer_irq_func_t - Function called from the timer interrupt
+ *
+ * @pc: Run-time address of the code which was interrupted
+ */
+typedef void (*timer_irq_func_t)(ulong pc);
+
+/**
+ * timer_irq_start() - Start calling a function periodically
+ *
+ * The GIC and the timer are set up when the first user starts. If @id is
+ * already running, its rate is changed.
+ *
+ * @id: User of the interrupt
+ * @hz: Rate at which to call @func, in Hz
+ * @func: Function to call from the interrupt
+ * Return: 0 if OK, -EPERM if running at EL3, -ENODEV if the GICv3
+ *	redistributor cannot be found, -EINVAL if @hz is too high
+ */
+int timer_irq_start(enum timer_irq_id id, uint hz, timer_irq_func_t func);
+
+/**
+ * timer_irq_stop() - Stop calling a user's function
+ *
+ * Interrupts are turned off again once there are no users left. This does
+ * nothing if @id is not running.
+ *
+ * @id: User of the interrupt
+ */
+void timer_irq_stop(enum timer_irq_id id);
+
+/**
+ * timer_irq_handle() - Handle an interrupt which may be from the timer
+ *
+ * @pc: Address of the code which was interrupted
+ * Return: 0 if the interrupt was handled, -ENOENT if it is not from the timer
+ */
+int timer_irq_handle(ulong pc);
+
+#endif
@@ -9,8 +9,18 @@
 #undef __HAVE_ARCH_STRRCHR
 extern char * strrchr(const char * s, int c);
 
+#if CONFIG_IS_ENABLED(USE_ARCH_STRING_FUNCS)
+#define __HAVE_ARCH_STRCHR
+#define __HAVE_ARCH_STRLEN
+#define __HAVE_ARCH_STRCMP
+#define __HAVE_ARCH_MEMCMP
+#else
 #undef __HAVE_ARCH_STRCHR
+#endif
 extern char * strchr(const char * s, int c);
+extern __kernel_size_t strlen(const char *);
+extern int strcmp(const char *, const char *);
+extern int memcmp(const void *, const void *, __kernel_size_t);
 
 #if CONFIG_IS_ENABLED(USE_ARCH_MEMCPY)
 #define __HAVE_ARCH_MEMCPY
@@ -14,9 +14,12 @@
 #include <bootm.h>
 #include <bootstage.h>
 #include <command.h>
+#include <cpu.h>
 #include <cpu_func.h>
 #include <dm.h>
 #include <log.h>
+#include <profiler.h>
+#include <wdt.h>
 #include <asm/global_data.h>
 #include <dm/root.h>
 #include <env.h>
@@ -65,10 +68,18 @@ static void announce_and_cleanup(int fake)
 	udc_disconnect();
 #endif
 
+	if (CONFIG_IS_ENABLED(PROFILER))
+		profiler_stop();
+	/* a fake run returns to U-Boot, which still needs the watchdog */
+	if (IS_ENABLED(CONFIG_WATCHDOG_TIMER_IRQ) && !fake)
+		arch_wdt_irq_stop();
+
+	cpu_boot_restore();
 	board_quiesce_devices();
 
 	printf("\nStarting kernel ...%s\n\n", fake ?
 		"(fake run for tracing)" : "");
+	flush();
 	/*
 	 * Call remove function of all devices with a removal flag set.
 	 * This may be useful for last-stage operations, like cancelling
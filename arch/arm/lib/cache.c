@@ -135,7 +135,23 @@ void invalidate_l2_cache(void)
 
 int arch_reserve_mmu(void)
 {
-	return arm_reserve_mmu();
+	int ret;
+
+	ret = arm_reserve_mmu();
+	if (ret)
+		return ret;
+
+	/*
+	 * The page tables now have their final home, so the MMU can be turned
+	 * on for the rest of board_init_f(); they stay valid after relocation
+	 */
+	if (IS_ENABLED(CONFIG_ARMV8_EARLY_CACHES) &&
+	    !IS_ENABLED(CONFIG_SPL_BUILD)) {
+		icache_enable();
+		dcache_enable();
+	}
+
+	return 0;
 }
 
 __weak int arm_reserve_mmu(void)
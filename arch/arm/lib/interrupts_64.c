@@ -7,6 +7,7 @@
 #include <asm/esr.h>
 #include <asm/global_data.h>
 #include <asm/ptrace.h>
+#include <asm/armv8/timer_irq.h>
 #include <irq_func.h>
 #include <linux/compiler.h>
 #include <efi_loader.h>
@@ -212,6 +213,9 @@ void do_sync(struct pt_regs *pt_regs)
 void do_irq(struct pt_regs *pt_regs)
 {
 	efi_restore_gd();
+	if (IS_ENABLED(CONFIG_ARMV8_TIMER_IRQ) &&
+	    !timer_irq_handle(pt_regs->elr))
+		return;
 	printf("\"Irq\" handler, esr 0x%08lx\n", pt_regs->esr);
 	show_regs(pt_regs);
 	show_efi_loaded_images(pt_regs);
@@ -64,6 +64,7 @@ phys_addr_t board_get_usable_ram_top(phys_size_t total_size)
 	/* add 8M for reserved memory for display, fdt, gd,... */
 	size = ALIGN(SZ_8M + CONFIG_SYS_MALLOC_LEN + total_size, MMU_SECTION_SIZE),
 	reg = lmb_alloc(&lmb, size, MMU_SECTION_SIZE);
+	lmb_uninit(&lmb);
 
 	if (!reg)
 		reg = gd->ram_top - size;
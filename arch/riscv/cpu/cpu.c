@@ -130,6 +130,13 @@ int riscv_cpu_setup(void)
 		csr_write(CSR_FCSR, 0);
 	}
 
+	/*
+	 * Enable the vector unit for memcpy() and friends. The VS field is
+	 * read-only zero on cores without one, which the routines check.
+	 */
+	if (CONFIG_IS_ENABLED(RISCV_ISA_V))
+		csr_set(MODE_PREFIX(status), SR_VS_INITIAL);
+
 	if (CONFIG_IS_ENABLED(RISCV_MMODE)) {
 		/*
 		 * Enable perf counters for cycle, time,
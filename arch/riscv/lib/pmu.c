@@ -0,0 +1,32 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * RISC-V performance counters
+ *
+ * Only the cycle counter is used, since the hpmcounter events are
+ * implementation-specific. In S-mode, the SBI firmware must allow access to it
+ * through mcounteren.
+ */
+
+#include <pmu.h>
+#include <asm/csr.h>
+
+int pmu_counters_init(void)
+{
+	return 0;
+}
+
+void pmu_counters_read(struct pmu_counts *counts)
+{
+	__maybe_unused u32 hi, lo;
+
+	if (IS_ENABLED(CONFIG_64BIT)) {
+		counts->cycles = csr_read(CSR_CYCLE);
+	} else {
+		do {
+			hi = csr_read(CSR_CYCLEH);
+			lo = csr_read(CSR_CYCLE);
+		} while (hi != csr_read(CSR_CYCLEH));
+		counts->cycles = ((u64)hi << 32) | lo;
+	}
+	counts->cache_misses = 0;
+}
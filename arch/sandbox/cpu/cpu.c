@@ -10,6 +10,8 @@
 #include <errno.h>
 #include <log.h>
 #include <os.h>
+#include <pmu.h>
+#include <profiler.h>
 #include <asm/global_data.h>
 #include <asm/io.h>
 #include <asm/malloc.h>
@@ -413,3 +415,29 @@ int sandbox_load_other_fdt(void **fdtp, int *sizep)
 
 	return 0;
 }
+
+#if CONFIG_IS_ENABLED(PROFILER)
+int arch_profiler_start(uint hz)
+{
+	return os_profiler_start(hz, profiler_record);
+}
+
+void arch_profiler_stop(void)
+{
+	os_profiler_stop();
+}
+#endif
+
+#if CONFIG_IS_ENABLED(PMU_COUNTERS)
+/* There are no counters on sandbox, so report nanoseconds as cycles */
+int pmu_counters_init(void)
+{
+	return 0;
+}
+
+void pmu_counters_read(struct pmu_counts *counts)
+{
+	counts->cycles = os_get_nsec();
+	counts->cache_misses = 0;
+}
+#endif
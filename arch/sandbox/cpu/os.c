@@ -103,6 +103,8 @@ int os_open(const char *pathname, int os_flags)
 		flags |= O_CREAT;
 	if (os_flags & OS_O_TRUNC)
 		flags |= O_TRUNC;
+	if (os_flags & OS_O_DIRECT)
+		flags |= O_DIRECT;
 	/*
 	 * During a cold reset execv() is used to relaunch the U-Boot binary.
 	 * We must ensure that all files are closed in this case.
@@ -253,10 +255,28 @@ out:
 	return ret;
 }
 
-int os_unmap(void *buf, int size)
+int os_map_fd(int fd, int os_flags, size_t size, void **bufp)
+{
+	int prot = PROT_READ;
+	void *ptr;
+
+	if ((os_flags & OS_O_MASK) != OS_O_RDONLY)
+		prot |= PROT_WRITE;
+
+	ptr = mmap(0, size, prot, MAP_SHARED, fd, 0);
+	if (ptr == MAP_FAILED) {
+		printf("Can't map file: %s\n", strerror(errno));
+		return -EPERM;
+	}
+	*bufp = ptr;
+
+	return 0;
+}
+
+int os_unmap(void *buf, size_t size)
 {
 	if (munmap(buf, size)) {
-		printf("Can't unmap %p %x\n", buf, size);
+		printf("Can't unmap %p %zx\n", buf, size);
 		return -EIO;
 	}
 
@@ -330,28 +350,73 @@ static void os_sigint_handler(int sig)
 	raise(SIGINT);
 }
 
-static void os_signal_handler(int sig, siginfo_t *info, void *con)
+/* Get the program counter from a signal context, or 0 if not supported */
+static unsigned long os_context_pc(void *con)
 {
 	ucontext_t __maybe_unused *context = con;
-	unsigned long pc;
 
 #if defined(__x86_64__)
-	pc = context->uc_mcontext.gregs[REG_RIP];
+	return context->uc_mcontext.gregs[REG_RIP];
 #elif defined(__aarch64__)
-	pc = context->uc_mcontext.pc;
+	return context->uc_mcontext.pc;
 #elif defined(__riscv)
-	pc = context->uc_mcontext.__gregs[REG_PC];
+	return context->uc_mcontext.__gregs[REG_PC];
 #else
-	const char msg[] =
-		"\nUnsupported architecture, cannot read program counter\n";
-
-	os_write(1, msg, sizeof(msg));
-	pc = 0;
+	return 0;
 #endif
+}
+
+static void os_signal_handler(int sig, siginfo_t *info, void *con)
+{
+	unsigned long pc = os_context_pc(con);
+
+	if (!pc) {
+		const char msg[] =
+			"\nUnsupported architecture, cannot read program counter\n";
+
+		os_write(1, msg, sizeof(msg));
+	}
 
 	os_signal_action(sig, pc);
 }
 
+static void (*os_profiler_func)(unsigned long pc);
+
+static void os_profiler_handler(int sig, siginfo_t *info, void *con)
+{
+	os_profiler_func(os_context_pc(con));
+}
+
+int os_profiler_start(unsigned int hz, void (*func)(unsigned long pc))
+{
+	struct itimerval timer = {};
+	struct sigaction act;
+
+	os_profiler_func = func;
+	act.sa_sigaction = os_profiler_handler;
+	sigemptyset(&act.sa_mask);
+	act.sa_flags = SA_SIGINFO | SA_RESTART;
+	if (sigaction(SIGPROF, &act, NULL))
+		return -errno;
+
+	timer.it_interval.tv_usec = 1000000 / hz;
+	if (!timer.it_interval.tv_usec)
+		timer.it_interval.tv_usec = 1;
+	timer.it_value = timer.it_interval;
+	if (setitimer(ITIMER_PROF, &timer, NULL))
+		return -errno;
+
+	return 0;
+}
+
+void os_profiler_stop(void)
+{
+	struct itimerval timer = {};
+
+	setitimer(ITIMER_PROF, &timer, NULL);
+	signal(SIGPROF, SIG_DFL);
+}
+
 int os_setup_signal_handlers(void)
 {
 	struct sigaction act;
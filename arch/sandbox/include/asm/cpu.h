@@ -6,6 +6,32 @@
 #ifndef __SANDBOX_CPU_H
 #define __SANDBOX_CPU_H
 
+struct udevice;
+
 void cpu_sandbox_set_current(const char *name);
 
+/**
+ * cpu_sandbox_set_busy() - Make a CPU refuse new jobs
+ *
+ * @dev: CPU device (UCLASS_CPU)
+ * @busy: true to refuse jobs with -EBUSY, false to accept them
+ */
+void cpu_sandbox_set_busy(struct udevice *dev, bool busy);
+
+/**
+ * cpu_sandbox_get_jobs() - Get the number of jobs a CPU has run
+ *
+ * @dev: CPU device (UCLASS_CPU)
+ * Return: number of jobs
+ */
+int cpu_sandbox_get_jobs(struct udevice *dev);
+
+/**
+ * cpu_sandbox_get_perf() - Get the performance level of a CPU
+ *
+ * @dev: CPU device (UCLASS_CPU)
+ * Return: level, as enum cpu_perf
+ */
+int cpu_sandbox_get_perf(struct udevice *dev);
+
 #endif /* __SANDBOX_CPU_H */
@@ -82,6 +82,8 @@ typedef int sandbox_eth_tx_hand_f(struct udevice *dev, void *pkt,
  * recv_packets - number of packets returned
  * tx_handler - function to generate responses to sent packets
  * priv - a pointer to some structure a test may want to keep track of
+ * batch - use recv_batch() and send_batch() rather than recv() and send()
+ * send_batch_max - largest number of packets passed to one send_batch() call
  */
 struct eth_sandbox_priv {
 	uchar fake_host_hwaddr[ARP_HLEN];
@@ -92,6 +94,8 @@ struct eth_sandbox_priv {
 	int recv_packets;
 	sandbox_eth_tx_hand_f *tx_handler;
 	void *priv;
+	bool batch;
+	int send_batch_max;
 };
 
 /*
@@ -108,4 +112,11 @@ void sandbox_eth_set_tx_handler(int index, sandbox_eth_tx_hand_f *handler);
  */
 void sandbox_eth_set_priv(int index, void *priv);
 
+/*
+ * Select batched receive and transmit
+ *
+ * batch - true to handle packets with recv_batch() and send_batch()
+ */
+void sandbox_eth_set_batch(int index, bool batch);
+
 #endif /* __ETH_H */
@@ -357,4 +357,22 @@ bool sandbox_sf_bootdev_enabled(void);
  */
 void sandbox_sf_set_enable_bootdevs(bool enable);
 
+/**
+ * sandbox_mmc_get_tunings() - Get the number of times an MMC device was tuned
+ *
+ * @dev: MMC device to check
+ * Returns: number of times the full tuning sequence has run
+ */
+int sandbox_mmc_get_tunings(struct udevice *dev);
+
+/**
+ * sandbox_mmc_get_cqe() - Get the command-queue state of an emulated eMMC
+ *
+ * @dev: MMC device to check
+ * @tasksp: Returns the number of command-queue tasks run
+ * @max_queuedp: Returns the most tasks which were queued at once
+ * Returns: true if the card is in command-queue mode, false if not
+ */
+bool sandbox_mmc_get_cqe(struct udevice *dev, int *tasksp, int *max_queuedp);
+
 #endif
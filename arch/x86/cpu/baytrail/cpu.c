@@ -192,6 +192,9 @@ static const struct cpu_ops cpu_x86_baytrail_ops = {
 	.get_info	= baytrail_get_info,
 	.get_count	= baytrail_get_count,
 	.get_vendor	= cpu_x86_get_vendor,
+	.is_current	= cpu_x86_is_current,
+	.start_job	= cpu_x86_start_job,
+	.can_start_job	= cpu_x86_can_start_job,
 };
 
 static const struct udevice_id cpu_x86_baytrail_ids[] = {
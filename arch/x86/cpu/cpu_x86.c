@@ -7,7 +7,10 @@
 #include <dm.h>
 #include <errno.h>
 #include <asm/cpu.h>
+#include <asm/cpu_x86.h>
 #include <asm/global_data.h>
+#include <asm/lapic.h>
+#include <asm/mp.h>
 
 DECLARE_GLOBAL_DATA_PTR;
 
@@ -77,10 +80,35 @@ int cpu_x86_get_count(const struct udevice *dev)
 	return num;
 }
 
+int cpu_x86_is_current(struct udevice *dev)
+{
+	struct cpu_plat *plat = dev_get_parent_plat(dev);
+
+	return plat->cpu_id == lapicid();
+}
+
+int cpu_x86_start_job(struct udevice *dev, struct cpu_job *job)
+{
+	if (!CONFIG_IS_ENABLED(CPU_JOBS))
+		return -ENOSYS;
+
+	return mp_start_job(dev, job);
+}
+
+bool cpu_x86_can_start_job(struct udevice *dev)
+{
+	/* The APs only look for work once mp_init() has finished */
+	return CONFIG_IS_ENABLED(CPU_JOBS) && IS_ENABLED(CONFIG_SMP_AP_WORK) &&
+		(gd->flags & GD_FLG_SMP_READY);
+}
+
 static const struct cpu_ops cpu_x86_ops = {
 	.get_desc	= cpu_x86_get_desc,
 	.get_count	= cpu_x86_get_count,
 	.get_vendor	= cpu_x86_get_vendor,
+	.is_current	= cpu_x86_is_current,
+	.start_job	= cpu_x86_start_job,
+	.can_start_job	= cpu_x86_can_start_job,
 };
 
 static const struct udevice_id cpu_x86_ids[] = {
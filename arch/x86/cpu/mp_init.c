@@ -108,6 +108,12 @@ DECLARE_GLOBAL_DATA_PTR;
  * An example of this is the 'mtrr' command which allows reading and changing
  * the MTRRs on all CPUs.
  *
+ * With CONFIG_CPU_JOBS, cpu_job_start() can hand a job to an idle AP through
+ * mp_start_job() without waiting for it, so the BSP can carry on with other
+ * work. Each AP has its own struct mp_callback for this, in job_callbacks[],
+ * and its slot goes back to NULL once the job is done. run_ap_work() waits for
+ * any jobs to finish before it uses the slots.
+ *
  * Before U-Boot exits it calls mp_park_aps() which tells all CPUs to halt by
  * executing a 'hlt' instruction. That allows them to be used by Linux when it
  * starts up.
@@ -626,6 +632,12 @@ static int run_ap_work(struct mp_callback *callback, struct udevice *bsp,
 		return -ENOTSUPP;
 	}
 
+	/* Wait for any jobs still running on the APs */
+	for (i = 0; i < num_cpus; i++) {
+		while (cur_cpu != i && read_callback(&ap_callbacks[i]))
+			asm ("pause");
+	}
+
 	/* Signal to all the APs to run the func. */
 	for (i = 0; i < num_cpus; i++) {
 		if (cur_cpu != i)
@@ -756,6 +768,44 @@ int mp_run_on_cpus(int cpu_select, mp_run_func func, void *arg)
 	return 0;
 }
 
+#if CONFIG_IS_ENABLED(CPU_JOBS)
+/* Callback for the job running on each AP, indexed by CPU number */
+static struct mp_callback job_callbacks[CONFIG_MAX_CPUS];
+
+static void run_job(void *arg)
+{
+	cpu_job_run(arg);
+}
+
+int mp_start_job(struct udevice *cpu, struct cpu_job *job)
+{
+	struct mp_callback *cb;
+	int seq = dev_seq(cpu);
+	int ret;
+
+	if (!IS_ENABLED(CONFIG_SMP_AP_WORK) ||
+	    !(gd->flags & GD_FLG_SMP_READY))
+		return -ENOTSUPP;
+	if (seq < 0 || seq >= CONFIG_MAX_CPUS)
+		return -EINVAL;
+	ret = get_bsp(NULL, NULL);
+	if (ret < 0)
+		return log_msg_ret("bsp", ret);
+
+	/* The BSP is busy running U-Boot, as is an AP which has a slot set */
+	if (seq == ret || read_callback(&ap_callbacks[seq]))
+		return -EBUSY;
+	cb = &job_callbacks[seq];
+	cb->func = run_job;
+	cb->arg = job;
+	cb->logical_cpu_number = seq;
+	mfence();
+	store_callback(&ap_callbacks[seq], cb);
+
+	return 0;
+}
+#endif
+
 static void park_this_cpu(void *unused)
 {
 	stop_this_cpu();
@@ -0,0 +1,65 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * x86 performance counters
+ *
+ * The time-stamp counter is used for cycles. If the CPU has architectural
+ * performance monitoring with the 'LLC misses' event, general-purpose
+ * counter 0 is set up to count it.
+ */
+
+#include <errno.h>
+#include <pmu.h>
+#include <asm/cpu.h>
+#include <asm/msr.h>
+#include <asm/msr-index.h>
+#include <asm/u-boot-x86.h>
+#include <linux/bitops.h>
+
+#define CPUID_ARCH_PERFMON		0xa
+#define ARCH_PERFMON_VERSION_MASK	0xff
+#define ARCH_PERFMON_LEN_SHIFT		24
+#define ARCH_PERFMON_LLC_MISS_UNAVAIL	BIT(4)
+
+#define EVNTSEL_EVENT_MASK		0xffff
+#define EVNTSEL_LLC_MISSES		0x412e
+#define EVNTSEL_USR			BIT(16)
+#define EVNTSEL_OS			BIT(17)
+#define EVNTSEL_EN			BIT(22)
+
+int pmu_counters_init(void)
+{
+	struct cpuid_result res;
+	uint version;
+
+	if (cpuid_eax(0) < CPUID_ARCH_PERFMON)
+		return 0;
+	res = cpuid(CPUID_ARCH_PERFMON);
+	version = res.eax & ARCH_PERFMON_VERSION_MASK;
+	if (!version || (res.eax >> ARCH_PERFMON_LEN_SHIFT) < 5 ||
+	    (res.ebx & ARCH_PERFMON_LLC_MISS_UNAVAIL))
+		return 0;
+
+	wrmsrl(MSR_P6_EVNTSEL0, EVNTSEL_LLC_MISSES | EVNTSEL_USR | EVNTSEL_OS |
+	       EVNTSEL_EN);
+	if (version >= 2)
+		msr_setbits_64(MSR_CORE_PERF_GLOBAL_CTRL, BIT(0));
+
+	return 0;
+}
+
+void pmu_counters_read(struct pmu_counts *counts)
+{
+	u64 evntsel;
+
+	counts->cycles = rdtsc();
+	counts->cache_misses = 0;
+
+	/*
+	 * This may be called before relocation, so check the event selector
+	 * rather than keeping a flag in BSS
+	 */
+	rdmsrl(MSR_P6_EVNTSEL0, evntsel);
+	if ((evntsel & (EVNTSEL_EN | EVNTSEL_EVENT_MASK)) ==
+	    (EVNTSEL_EN | EVNTSEL_LLC_MISSES))
+		rdmsrl(MSR_P6_PERFCTR0, counts->cache_misses);
+}
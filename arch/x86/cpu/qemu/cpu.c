@@ -8,6 +8,7 @@
 #include <errno.h>
 #include <qfw.h>
 #include <asm/cpu.h>
+#include <asm/cpu_x86.h>
 
 int cpu_qemu_get_desc(const struct udevice *dev, char *buf, int size)
 {
@@ -34,6 +35,9 @@ static int cpu_qemu_get_count(const struct udevice *dev)
 static const struct cpu_ops cpu_qemu_ops = {
 	.get_desc	= cpu_qemu_get_desc,
 	.get_count	= cpu_qemu_get_count,
+	.is_current	= cpu_x86_is_current,
+	.start_job	= cpu_x86_start_job,
+	.can_start_job	= cpu_x86_can_start_job,
 };
 
 static const struct udevice_id cpu_qemu_ids[] = {
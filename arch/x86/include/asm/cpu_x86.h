@@ -6,6 +6,9 @@
 #ifndef _ASM_CPU_X86_H
 #define _ASM_CPU_X86_H
 
+struct cpu_job;
+struct udevice;
+
 /**
  * cpu_x86_bind() - Bind an x86 CPU with the driver
  *
@@ -55,4 +58,38 @@ int cpu_x86_get_count(const struct udevice *dev);
  */
 int cpu_x86_get_vendor(const struct udevice *dev, char *buf, int size);
 
+/**
+ * cpu_x86_is_current() - Check if U-Boot is running on an x86 CPU
+ *
+ * This compares the CPU's APIC ID with that of the CPU running this code.
+ *
+ * @dev:	CPU to check (UCLASS_CPU)
+ * @return:	1 if U-Boot is running on @dev, 0 if not
+ */
+int cpu_x86_is_current(struct udevice *dev);
+
+/**
+ * cpu_x86_start_job() - Start a job on an x86 CPU
+ *
+ * This hands the job to an AP using mp_start_job() and is suitable to use as
+ * the start_job() method for the CPU uclass.
+ *
+ * @dev:	CPU to run the job (UCLASS_CPU)
+ * @job:	Job to run
+ * @return:	0 if started, -EBUSY if the CPU is busy, -ENOSYS if
+ *		CONFIG_CPU_JOBS is not enabled, other -ve on error
+ */
+int cpu_x86_start_job(struct udevice *dev, struct cpu_job *job);
+
+/**
+ * cpu_x86_can_start_job() - Check if an x86 CPU can be given jobs
+ *
+ * The APs only wait for jobs with CONFIG_SMP_AP_WORK, once they have been
+ * started by mp_init().
+ *
+ * @dev:	CPU to check (UCLASS_CPU)
+ * @return:	true if jobs can be started, false if not
+ */
+bool cpu_x86_can_start_job(struct udevice *dev);
+
 #endif /* _ASM_CPU_X86_H */
@@ -13,6 +13,7 @@
 #include <linux/bitops.h>
 #include <linux/errno.h>
 
+struct cpu_job;
 struct udevice;
 
 enum {
@@ -164,6 +165,19 @@ int mp_first_cpu(int cpu_select);
  * Return: next CPU number to run on (e.g. 0)
  */
 int mp_next_cpu(int cpu_select, int prev_cpu);
+
+/**
+ * mp_start_job() - Start a job on an AP without waiting for it
+ *
+ * This is suitable for use as the start_job() method of an x86 CPU driver.
+ * It needs CONFIG_SMP_AP_WORK, since otherwise the APs are asleep.
+ *
+ * @cpu: CPU to run the job (UCLASS_CPU)
+ * @job: Job to run
+ * Return: 0 if started, -EBUSY if @cpu is the BSP or is already busy,
+ *	-ENOTSUPP if the APs are not waiting for work, other -ve on error
+ */
+int mp_start_job(struct udevice *cpu, struct cpu_job *job);
 #else
 static inline int mp_run_on_cpus(int cpu_select, mp_run_func func, void *arg)
 {
@@ -195,6 +209,12 @@ static inline int mp_next_cpu(int cpu_select, int prev_cpu)
 	return -EFBIG;
 }
 
+static inline int mp_start_job(struct udevice *cpu, struct cpu_job *job)
+{
+	/* There are no APs to run it */
+	return -ENOTSUPP;
+}
+
 #endif
 
 #endif /* _X86_MP_H_ */
@@ -33,6 +33,7 @@ struct mrc_region {
 enum mrc_type_t {
 	MRC_TYPE_NORMAL,
 	MRC_TYPE_VAR,
+	MRC_TYPE_ACPI,		/* Generated ACPI code, see acpi_cache.c */
 
 	MRC_TYPE_COUNT,
 };
@@ -93,6 +94,21 @@ int mrccache_get_region(enum mrc_type_t type, struct udevice **devp,
  */
 int mrccache_save(void);
 
+/**
+ * mrccache_save_data() - save a record to the SPI flash straight away
+ *
+ * This is used for data which is produced after relocation, so is not
+ * reserved by mrccache_reserve(). Nothing is written if the latest record is
+ * the same.
+ *
+ * @type:	Type of data to save, which selects the region
+ * @buf:	Data to save
+ * @len:	Length of @buf in bytes
+ * Return: 0 if OK, -ENOMEM if out of memory, other error if the region cannot
+ *	be found or written
+ */
+int mrccache_save_data(enum mrc_type_t type, const void *buf, uint len);
+
 /**
  * mrccache_spl_save() - Save to the MRC region from SPL
  *
@@ -0,0 +1,95 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Cache of the SSDT code generated by devices
+ *
+ * Each device with a fill_ssdt() method is asked to write its part of the
+ * SSDT on every boot, which can take tens of milliseconds. The result only
+ * depends on the devicetree and the U-Boot build, so it is kept in an MRC
+ * cache region in SPI flash and copied from there while neither changes.
+ */
+
+#define LOG_CATEGORY	LOGC_ACPI
+
+#include <fdtdec.h>
+#include <log.h>
+#include <malloc.h>
+#include <version_string.h>
+#include <acpi/acpi_table.h>
+#include <asm/global_data.h>
+#include <asm/mrccache.h>
+#include <dm/acpi.h>
+#include <linux/errno.h>
+#include <linux/string.h>
+#include <u-boot/crc.h>
+
+DECLARE_GLOBAL_DATA_PTR;
+
+/**
+ * struct acpi_cache_hdr - Header of the cached SSDT code
+ *
+ * This is followed by the code itself
+ *
+ * @key: Key of the build and devicetree it was generated with
+ * @addr: Address the code was written to, in case it refers to itself
+ * @size: Size of the code in bytes
+ */
+struct acpi_cache_hdr {
+	u32 key;
+	u32 addr;
+	u32 size;
+};
+
+static u32 acpi_cache_key(void)
+{
+	u32 key;
+
+	key = crc32(0, (const u8 *)version_string, strlen(version_string));
+
+	return crc32(key, gd->fdt_blob, fdt_totalsize(gd->fdt_blob));
+}
+
+int acpi_fill_ssdt_cached(struct acpi_ctx *ctx)
+{
+	struct mrc_data_container *cache;
+	struct acpi_cache_hdr *hdr;
+	struct mrc_region entry;
+	void *start = ctx->current;
+	bool have_region;
+	uint size;
+	u32 key;
+	int ret;
+
+	key = acpi_cache_key();
+	have_region = !mrccache_get_region(MRC_TYPE_ACPI, NULL, &entry);
+	cache = have_region ? mrccache_find_current(&entry) : NULL;
+	if (cache && cache->data_size >= sizeof(*hdr)) {
+		hdr = (struct acpi_cache_hdr *)cache->data;
+		if (hdr->key == key && hdr->addr == (u32)(ulong)start &&
+		    hdr->size == cache->data_size - sizeof(*hdr)) {
+			memcpy(start, hdr + 1, hdr->size);
+			acpi_inc(ctx, hdr->size);
+			log_debug("Using %x bytes of cached SSDT code\n",
+				  hdr->size);
+			return 0;
+		}
+	}
+
+	ret = acpi_fill_ssdt(ctx);
+	if (ret || !have_region)
+		return ret;
+
+	size = ctx->current - start;
+	hdr = malloc(sizeof(*hdr) + size);
+	if (!hdr)
+		return 0;
+	hdr->key = key;
+	hdr->addr = (u32)(ulong)start;
+	hdr->size = size;
+	memcpy(hdr + 1, start, size);
+	ret = mrccache_save_data(MRC_TYPE_ACPI, hdr, sizeof(*hdr) + size);
+	if (ret)
+		log_warning("Cannot save SSDT cache (err=%d)\n", ret);
+	free(hdr);
+
+	return 0;
+}
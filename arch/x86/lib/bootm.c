@@ -10,6 +10,7 @@
 #include <bootm.h>
 #include <bootstage.h>
 #include <command.h>
+#include <cpu.h>
 #include <efi.h>
 #include <hang.h>
 #include <log.h>
@@ -35,6 +36,7 @@ DECLARE_GLOBAL_DATA_PTR;
 void bootm_announce_and_cleanup(void)
 {
 	printf("\nStarting kernel ...\n\n");
+	flush();
 
 #ifdef CONFIG_SYS_COREBOOT
 	timestamp_add_now(TS_START_KERNEL);
@@ -44,6 +46,8 @@ void bootm_announce_and_cleanup(void)
 	bootstage_report();
 #endif
 
+	cpu_boot_restore();
+
 	/*
 	 * Call remove function of all devices with a removal flag set.
 	 * This may be useful for last-stage operations, like cancelling
@@ -23,6 +23,13 @@
 
 DECLARE_GLOBAL_DATA_PTR;
 
+/* Names of the SPI-flash subnodes holding each type of data */
+static const char *const mrc_region_name[MRC_TYPE_COUNT] = {
+	[MRC_TYPE_NORMAL]	= "rw-mrc-cache",
+	[MRC_TYPE_VAR]		= "rw-var-mrc-cache",
+	[MRC_TYPE_ACPI]		= "rw-acpi-cache",
+};
+
 static uint mrc_block_size(uint data_size)
 {
 	uint mrc_size = sizeof(struct mrc_data_container) + data_size;
@@ -273,8 +280,7 @@ int mrccache_get_region(enum mrc_type_t type, struct udevice **devp,
 	}
 
 	/* Find the place where we put the MRC cache */
-	mrc_node = ofnode_find_subnode(node, type == MRC_TYPE_NORMAL ?
-				       "rw-mrc-cache" : "rw-var-mrc-cache");
+	mrc_node = ofnode_find_subnode(node, mrc_region_name[type]);
 	if (!ofnode_valid(mrc_node))
 		return log_msg_ret("Cannot find node", -EPERM);
 
@@ -338,6 +344,26 @@ int mrccache_save(void)
 	return 0;
 }
 
+int mrccache_save_data(enum mrc_type_t type, const void *buf, uint len)
+{
+	struct mrc_output *mrc = &gd->arch.mrc[type];
+	void *data;
+	int ret;
+
+	data = malloc(len + MRC_DATA_HEADER_SIZE);
+	if (!data)
+		return log_msg_ret("Allocate cache block", -ENOMEM);
+	mrc->buf = (char *)buf;
+	mrc->len = len;
+	mrccache_setup(mrc, data);
+	ret = mrccache_save_type(type);
+	mrc->len = 0;
+	mrc->cache = NULL;
+	free(data);
+
+	return ret;
+}
+
 int mrccache_spl_save(void)
 {
 	int i;
@@ -689,6 +689,7 @@ phys_addr_t board_get_usable_ram_top(phys_size_t total_size)
 	boot_fdt_add_mem_rsv_regions(&lmb, (void *)gd->fdt_blob);
 	size = ALIGN(CONFIG_SYS_MALLOC_LEN + total_size, MMU_SECTION_SIZE);
 	reg = lmb_alloc(&lmb, size, MMU_SECTION_SIZE);
+	lmb_uninit(&lmb);
 
 	if (!reg)
 		reg = gd->ram_top - size;
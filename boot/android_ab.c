@@ -5,6 +5,7 @@
 #include <android_ab.h>
 #include <android_bootloader_message.h>
 #include <blk.h>
+#include <event.h>
 #include <log.h>
 #include <malloc.h>
 #include <part.h>
@@ -154,6 +155,91 @@ static int ab_control_store(struct blk_desc *dev_desc,
 	return 0;
 }
 
+#if IS_ENABLED(CONFIG_ANDROID_AB_CACHE)
+/**
+ * struct ab_cache - boot control block kept between slot selections
+ *
+ * Once ab_select_slot() has finished, the primary and any backup copy on disk
+ * both hold @abc, so a later call for the same partition needs no reads
+ *
+ * @bdev: Block device holding the partition
+ * @start: Start block of the partition
+ * @abc: Boot control block and the extra bytes after it up to the nearest
+ *	block boundary, or NULL if nothing is cached
+ */
+static struct ab_cache {
+	struct udevice *bdev;
+	lbaint_t start;
+	struct bootloader_control *abc;
+} ab_cache;
+
+/**
+ * Take the cached boot_control block for a partition, if there is one.
+ *
+ * The cache is left empty.
+ *
+ * @param[in] dev_desc Device holding the boot_control struct
+ * @param[in] part_info Partition in 'dev_desc' holding it
+ * Return: boot_control block, to be passed to ab_cache_put() or freed, or NULL
+ *	if it must be read from disk
+ */
+static struct bootloader_control *
+ab_cache_get(struct blk_desc *dev_desc, const struct disk_partition *part_info)
+{
+	struct bootloader_control *abc = ab_cache.abc;
+
+	ab_cache.abc = NULL;
+	if (abc && (ab_cache.bdev != dev_desc->bdev ||
+		    ab_cache.start != part_info->start)) {
+		free(abc);
+		abc = NULL;
+	}
+
+	return abc;
+}
+
+/**
+ * Keep a boot_control block which matches what is on disk.
+ *
+ * @param[in] dev_desc Device holding the boot_control struct
+ * @param[in] part_info Partition in 'dev_desc' holding it
+ * @param[in] abc boot_control block, which is freed later
+ */
+static void ab_cache_put(struct blk_desc *dev_desc,
+			 const struct disk_partition *part_info,
+			 struct bootloader_control *abc)
+{
+	ab_cache.bdev = dev_desc->bdev;
+	ab_cache.start = part_info->start;
+	ab_cache.abc = abc;
+}
+
+/* A different device may be bound in place of this one, e.g. by 'host bind' */
+static int ab_cache_remove(void *ctx, struct event *event)
+{
+	if (ab_cache.abc && ab_cache.bdev == event->data.dm.dev) {
+		free(ab_cache.abc);
+		ab_cache.abc = NULL;
+	}
+
+	return 0;
+}
+EVENT_SPY_FULL(EVT_DM_PRE_REMOVE, ab_cache_remove);
+#else
+static struct bootloader_control *
+ab_cache_get(struct blk_desc *dev_desc, const struct disk_partition *part_info)
+{
+	return NULL;
+}
+
+static void ab_cache_put(struct blk_desc *dev_desc,
+			 const struct disk_partition *part_info,
+			 struct bootloader_control *abc)
+{
+	free(abc);
+}
+#endif
+
 /**
  * Compare two slots.
  *
@@ -193,30 +279,36 @@ int ab_select_slot(struct blk_desc *dev_desc, struct disk_partition *part_info,
 	bool valid_backup = false;
 	char slot_suffix[4];
 
-	ret = ab_control_create_from_disk(dev_desc, part_info, &abc, 0);
-	if (ret < 0) {
-		/*
-		 * This condition represents an actual problem with the code or
-		 * the board setup, like an invalid partition information.
-		 * Signal a repair mode and do not try to boot from either slot.
-		 */
-		return ret;
-	}
-
-	if (CONFIG_ANDROID_AB_BACKUP_OFFSET) {
-		ret = ab_control_create_from_disk(dev_desc, part_info, &backup_abc,
-						  CONFIG_ANDROID_AB_BACKUP_OFFSET);
+	/* Both copies on disk match the cached block, if there is one */
+	abc = ab_cache_get(dev_desc, part_info);
+	if (!abc) {
+		ret = ab_control_create_from_disk(dev_desc, part_info, &abc, 0);
 		if (ret < 0) {
-			free(abc);
+			/*
+			 * This condition represents an actual problem with the
+			 * code or the board setup, like an invalid partition
+			 * information. Signal a repair mode and do not try to
+			 * boot from either slot.
+			 */
 			return ret;
 		}
+
+		if (CONFIG_ANDROID_AB_BACKUP_OFFSET) {
+			ret = ab_control_create_from_disk(dev_desc, part_info,
+							  &backup_abc,
+							  CONFIG_ANDROID_AB_BACKUP_OFFSET);
+			if (ret < 0) {
+				free(abc);
+				return ret;
+			}
+		}
 	}
 
 	crc32_le = ab_control_compute_crc(abc);
 	if (abc->crc32_le != crc32_le) {
 		log_err("ANDROID: Invalid CRC-32 (expected %.8x, found %.8x),",
 			crc32_le, abc->crc32_le);
-		if (CONFIG_ANDROID_AB_BACKUP_OFFSET) {
+		if (CONFIG_ANDROID_AB_BACKUP_OFFSET && backup_abc) {
 			crc32_le = ab_control_compute_crc(backup_abc);
 			if (backup_abc->crc32_le != crc32_le) {
 				log_err(" ANDROID: Invalid backup CRC-32 ");
@@ -341,9 +433,11 @@ int ab_select_slot(struct blk_desc *dev_desc, struct disk_partition *part_info,
 	if (CONFIG_ANDROID_AB_BACKUP_OFFSET) {
 		/*
 		 * If the backup doesn't match the primary, write the primary
-		 * to the backup offset
+		 * to the backup offset. Without a backup copy in memory, the
+		 * backup matched the primary before any change was made.
 		 */
-		if (memcmp(backup_abc, abc, sizeof(*abc)) != 0) {
+		if (backup_abc ? memcmp(backup_abc, abc, sizeof(*abc)) :
+		    store_needed) {
 			ret = ab_control_store(dev_desc, part_info, abc,
 					       CONFIG_ANDROID_AB_BACKUP_OFFSET);
 			if (ret < 0) {
@@ -355,7 +449,7 @@ int ab_select_slot(struct blk_desc *dev_desc, struct disk_partition *part_info,
 		free(backup_abc);
 	}
 
-	free(abc);
+	ab_cache_put(dev_desc, part_info, abc);
 
 	if (slot < 0)
 		return -EINVAL;
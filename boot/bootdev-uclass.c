@@ -188,10 +188,20 @@ int bootdev_find_in_blk(struct udevice *dev, struct udevice *blk,
 		   (iter->first_bootable ? !info.bootable : iter->part != 1)) {
 		return log_msg_ret("boot", -EINVAL);
 	} else {
+		struct bootstd_probe *probe;
+
+		/* don't look again for a filesystem which is not there */
+		probe = bootstd_find_probe(blk, bflow->part, NULL);
+		if (probe) {
+			bflow->state = BOOTFLOWST_PART;
+			return log_msg_ret("nfs", probe->ret);
+		}
 		ret = fs_set_blk_dev_with_part(desc, bflow->part);
 		bflow->state = BOOTFLOWST_PART;
-		if (ret)
+		if (ret) {
+			bootstd_add_probe(blk, bflow->part, NULL, ret, 0);
 			return log_msg_ret("fs", ret);
+		}
 
 		log_debug("%s: Found partition %x type %x fstype %d\n",
 			  blk->name, bflow->part,
@@ -783,6 +793,8 @@ int bootdev_setup_iter(struct bootflow_iter *iter, const char *label,
 		if (!ok)
 			return log_msg_ret("ord", -ENOMEM);
 		log_debug("setup labels %p\n", iter->labels);
+		if (iter->flags & BOOTFLOWIF_HUNT)
+			bootdev_hunt_start();
 		if (iter->labels) {
 			iter->cur_label = -1;
 			ret = bootdev_next_label(iter, &dev, &method_flags);
@@ -870,6 +882,33 @@ int bootdev_hunt(const char *spec, bool show)
 	return result;
 }
 
+void bootdev_hunt_start(void)
+{
+	struct bootdev_hunter *start;
+	struct bootstd_priv *std;
+	int n_ent, i, ret;
+
+	if (!IS_ENABLED(CONFIG_BOOTSTD_HUNT_START) || bootstd_get_priv(&std))
+		return;
+
+	start = ll_entry_start(struct bootdev_hunter, bootdev_hunter);
+	n_ent = ll_entry_count(struct bootdev_hunter, bootdev_hunter);
+	for (i = 0; i < n_ent; i++) {
+		struct bootdev_hunter *info = start + i;
+
+		if (!info->start ||
+		    ((std->hunters_used | std->hunters_started) & BIT(i)))
+			continue;
+		log_debug("Starting hunter: %s\n",
+			  uclass_get_name(info->uclass));
+		ret = info->start(info);
+		if (ret)
+			log_warning("Failed to start %s hunter (err=%dE)\n",
+				    uclass_get_name(info->uclass), ret);
+		std->hunters_started |= BIT(i);
+	}
+}
+
 int bootdev_unhunt(enum uclass_id id)
 {
 	struct bootdev_hunter *start;
@@ -890,6 +929,7 @@ int bootdev_unhunt(enum uclass_id id)
 			if (!(std->hunters_used & BIT(i)))
 				return -EALREADY;
 			std->hunters_used &= ~BIT(i);
+			std->hunters_started &= ~BIT(i);
 			return 0;
 		}
 	}
@@ -11,9 +11,11 @@
 #include <bootmeth.h>
 #include <bootstd.h>
 #include <dm.h>
+#include <env.h>
 #include <env_internal.h>
 #include <malloc.h>
 #include <serial.h>
+#include <vsprintf.h>
 #include <dm/device-internal.h>
 #include <dm/uclass-internal.h>
 
@@ -23,6 +25,10 @@ enum {
 	BF_NO_MORE_DEVICES	= -ENODEV,
 };
 
+/* environment variable holding the bootflow cache, and its maximum length */
+#define BOOTFLOW_CACHE_VAR	"bootflow_cache"
+#define BOOTFLOW_CACHE_MAX	256
+
 /**
  * bootflow_state - name for each state
  *
@@ -89,6 +95,7 @@ void bootflow_iter_init(struct bootflow_iter *iter, int flags)
 	memset(iter, '\0', sizeof(*iter));
 	iter->first_glob_method = -1;
 	iter->flags = flags;
+	bootstd_clear_probes();
 
 	/* remember the first bootdevs we see */
 	iter->max_devs = BOOTFLOW_MAX_USED_DEVS;
@@ -97,6 +104,7 @@ void bootflow_iter_init(struct bootflow_iter *iter, int flags)
 void bootflow_iter_uninit(struct bootflow_iter *iter)
 {
 	free(iter->method_order);
+	bootstd_clear_probes();
 }
 
 int bootflow_iter_drop_bootmeth(struct bootflow_iter *iter,
@@ -330,6 +338,186 @@ static int iter_incr(struct bootflow_iter *iter)
 	return 0;
 }
 
+/**
+ * bootflow_cache_rec() - Get the cache record for a bootflow
+ *
+ * The record has the form "<prio> <bootdev> <part> <bootmeth> <size> <fname>"
+ * with the numbers in hex, e.g. "2 mmc1.bootdev 1 extlinux 3a
+ * /extlinux/extlinux.conf"
+ *
+ * @bflow: Bootflow to check
+ * @buf: Returns the record
+ * @size: Size of @buf
+ * Return: 0 if OK, -ENOENT if the bootflow cannot be cached (e.g. it comes from
+ *	a global bootmeth), -E2BIG if @buf is too small
+ */
+static int bootflow_cache_rec(const struct bootflow *bflow, char *buf,
+			      int size)
+{
+	struct bootdev_uc_plat *ucp;
+
+	if (!bflow->dev || !bflow->fname || strchr(bflow->fname, ' '))
+		return -ENOENT;
+	ucp = dev_get_uclass_plat(bflow->dev);
+	if (snprintf(buf, size, "%x %s %x %s %x %s", ucp->prio,
+		     bflow->dev->name, bflow->part, bflow->method->name,
+		     bflow->size, bflow->fname) >= size)
+		return -E2BIG;
+
+	return 0;
+}
+
+/**
+ * bootflow_cache_match() - Check if a bootflow is the one in the cache
+ *
+ * @bflow: Bootflow to check
+ * Return: true if it matches the cache record
+ */
+static bool bootflow_cache_match(const struct bootflow *bflow)
+{
+	char rec[BOOTFLOW_CACHE_MAX];
+	const char *val;
+
+	val = env_get(BOOTFLOW_CACHE_VAR);
+
+	return val && !bootflow_cache_rec(bflow, rec, sizeof(rec)) &&
+		!strcmp(val, rec);
+}
+
+/**
+ * bootflow_cache_save() - Record a bootflow in the cache
+ *
+ * With CONFIG_BOOTSTD_CACHE_SAVE the environment is saved as well, but only if
+ * the record changes, so booting the same bootflow again does not write to
+ * storage
+ *
+ * @bflow: Bootflow which is about to be booted
+ */
+static void bootflow_cache_save(const struct bootflow *bflow)
+{
+	char rec[BOOTFLOW_CACHE_MAX];
+	const char *val;
+	int ret;
+
+	ret = bootflow_cache_rec(bflow, rec, sizeof(rec));
+	val = env_get(BOOTFLOW_CACHE_VAR);
+	if (ret ? !val : val && !strcmp(val, rec))
+		return;
+
+	/* drop any old record if this bootflow cannot be cached */
+	if (env_set(BOOTFLOW_CACHE_VAR, ret ? NULL : rec) ||
+	    !IS_ENABLED(CONFIG_BOOTSTD_CACHE_SAVE))
+		return;
+	ret = env_save();
+	if (ret)
+		log_warning("Failed to save bootflow cache (err=%dE)\n", ret);
+}
+
+/**
+ * bootflow_prefetch_take() - Take over the prefetched bootflow
+ *
+ * The prefetched bootflow is only used if it comes from the bootdev, partition
+ * and bootmeth set up in @iter. In any case it is no-longer held afterwards.
+ *
+ * @iter: Iterator set up for the cached bootflow
+ * @bflow: Returns the prefetched bootflow on success
+ * Return: true if the prefetched bootflow was taken over
+ */
+static bool bootflow_prefetch_take(const struct bootflow_iter *iter,
+				   struct bootflow *bflow)
+{
+	struct bootstd_priv *std;
+	struct bootflow *pre;
+
+	if (bootstd_get_priv(&std) || !std->prefetch)
+		return false;
+	pre = std->prefetch;
+	if (pre->dev != iter->dev || pre->part != iter->part ||
+	    pre->method != iter->method) {
+		bootflow_prefetch_drop();
+		return false;
+	}
+	*bflow = *pre;
+	free(pre);
+	std->prefetch = NULL;
+
+	return true;
+}
+
+/**
+ * bootflow_cache_try() - Try to get the bootflow recorded in the cache
+ *
+ * This looks up the bootdev and bootmeth, hunting for the bootdev if needed,
+ * and reads the bootflow from the recorded partition. It is only used if the
+ * filename and size still match.
+ *
+ * @iter: Iterator to set up
+ * @flags: Flags for the iterator (enum bootflow_iter_flags_t)
+ * @bflow: Returns the bootflow on success
+ * Return: 0 if OK, -ENOENT if there is no cache record, -ESTALE if the
+ *	bootflow has changed, other -ve on error
+ */
+static int bootflow_cache_try(struct bootflow_iter *iter, int flags,
+			      struct bootflow *bflow)
+{
+	char buf[BOOTFLOW_CACHE_MAX], *fields[6], *ptr;
+	struct udevice *dev, *meth;
+	const char *val;
+	int i, ret;
+
+	val = env_get(BOOTFLOW_CACHE_VAR);
+	if (!val)
+		return -ENOENT;
+	if (strlcpy(buf, val, sizeof(buf)) >= sizeof(buf))
+		return log_msg_ret("len", -E2BIG);
+	for (ptr = buf, i = 0; i < ARRAY_SIZE(fields); i++) {
+		fields[i] = strsep(&ptr, " ");
+		if (!fields[i])
+			return log_msg_ret("rec", -EINVAL);
+	}
+
+	ret = uclass_get_device_by_name(UCLASS_BOOTMETH, fields[3], &meth);
+	if (ret)
+		return log_msg_ret("meth", ret);
+
+	/* the bootdev may only appear once its hunter has been run */
+	ret = uclass_find_device_by_name(UCLASS_BOOTDEV, fields[1], &dev);
+	if (ret && (flags & BOOTFLOWIF_HUNT)) {
+		ret = bootdev_hunt_prio(hextoul(fields[0], NULL),
+					flags & BOOTFLOWIF_SHOW);
+		if (!ret)
+			ret = uclass_find_device_by_name(UCLASS_BOOTDEV,
+							 fields[1], &dev);
+	}
+	if (ret)
+		return log_msg_ret("dev", ret);
+	ret = device_probe(dev);
+	if (ret)
+		return log_msg_ret("probe", ret);
+
+	bootflow_iter_init(iter, flags | BOOTFLOWIF_SINGLE_PARTITION);
+	iter->method = meth;
+	iter->part = hextoul(fields[2], NULL);
+	bootflow_iter_set_dev(iter, dev, 0);
+
+	if (IS_ENABLED(CONFIG_BOOTSTD_PREFETCH) &&
+	    bootflow_prefetch_take(iter, bflow))
+		ret = 0;
+	else
+		ret = bootdev_get_bootflow(dev, iter, bflow);
+	if (!ret && (bflow->size != hextoul(fields[4], NULL) ||
+		     !bflow->fname || strcmp(bflow->fname, fields[5])))
+		ret = -ESTALE;
+	if (ret) {
+		bootflow_free(bflow);
+		return log_msg_ret("get", ret);
+	}
+	log_debug("Using cached bootflow '%s'\n", bflow->name);
+	iter->flags |= BOOTFLOWIF_CACHED;
+
+	return 0;
+}
+
 /**
  * bootflow_check() - Check if a bootflow can be obtained
  *
@@ -355,6 +543,14 @@ static int bootflow_check(struct bootflow_iter *iter, struct bootflow *bflow)
 	dev = iter->dev;
 	ret = bootdev_get_bootflow(dev, iter, bflow);
 
+	/* Skip the cached bootflow if it has already failed */
+	if (!ret && IS_ENABLED(CONFIG_BOOTSTD_CACHE) &&
+	    (iter->flags & BOOTFLOWIF_SKIP_CACHED) &&
+	    bootflow_cache_match(bflow)) {
+		bootflow_free(bflow);
+		return log_msg_ret("cache", -EALREADY);
+	}
+
 	/* If we got a valid bootflow, return it */
 	if (!ret) {
 		log_debug("Bootdev '%s' part %d method '%s': Found bootflow\n",
@@ -385,6 +581,16 @@ int bootflow_scan_first(struct udevice *dev, const char *label,
 
 	if (dev || label)
 		flags |= BOOTFLOWIF_SKIP_GLOBAL;
+
+	/* Try the cached bootflow first, only falling back to a scan if needed */
+	if (IS_ENABLED(CONFIG_BOOTSTD_CACHE) && (flags & BOOTFLOWIF_CACHE) &&
+	    !(flags & (BOOTFLOWIF_ALL | BOOTFLOWIF_SKIP_CACHED)) && !dev &&
+	    !label) {
+		ret = bootflow_cache_try(iter, flags, bflow);
+		if (!ret)
+			return 0;
+		log_debug("No cached bootflow (err=%d)\n", ret);
+	}
 	bootflow_iter_init(iter, flags);
 
 	/*
@@ -429,6 +635,18 @@ int bootflow_scan_next(struct bootflow_iter *iter, struct bootflow *bflow)
 {
 	int ret;
 
+	/* The cached bootflow did not work out, so do a full scan */
+	if (IS_ENABLED(CONFIG_BOOTSTD_CACHE) &&
+	    (iter->flags & BOOTFLOWIF_CACHED)) {
+		int flags = iter->flags;
+
+		flags &= ~(BOOTFLOWIF_CACHED | BOOTFLOWIF_SINGLE_PARTITION);
+		flags |= BOOTFLOWIF_SKIP_CACHED;
+		bootflow_iter_uninit(iter);
+
+		return bootflow_scan_first(NULL, NULL, iter, flags, bflow);
+	}
+
 	do {
 		ret = iter_incr(iter);
 		log_debug("iter_incr: ret=%d\n", ret);
@@ -500,6 +718,56 @@ int bootflow_read_all(struct bootflow *bflow)
 }
 #endif /* BOOTSTD_FULL */
 
+#if IS_ENABLED(CONFIG_BOOTSTD_PREFETCH)
+int bootflow_prefetch(void)
+{
+	struct bootflow_iter iter;
+	struct bootstd_priv *std;
+	struct bootflow *bflow;
+	int ret;
+
+	ret = bootstd_get_priv(&std);
+	if (ret)
+		return log_msg_ret("std", ret);
+	if (std->prefetch)
+		return -EALREADY;
+
+	bflow = malloc(sizeof(*bflow));
+	if (!bflow)
+		return log_msg_ret("pre", -ENOMEM);
+	ret = bootflow_cache_try(&iter, BOOTFLOWIF_HUNT, bflow);
+	if (ret) {
+		free(bflow);
+		return log_msg_ret("try", ret);
+	}
+
+	/* Large files may only be read when booting, so read them now */
+	if (CONFIG_IS_ENABLED(BOOTSTD_FULL)) {
+		ret = bootflow_read_all(bflow);
+		if (ret && ret != -ENOSYS) {
+			bootflow_free(bflow);
+			free(bflow);
+			return log_msg_ret("all", ret);
+		}
+	}
+	log_debug("Prefetched bootflow '%s'\n", bflow->name);
+	std->prefetch = bflow;
+
+	return 0;
+}
+
+void bootflow_prefetch_drop(void)
+{
+	struct bootstd_priv *std;
+
+	if (bootstd_get_priv(&std) || !std->prefetch)
+		return;
+	bootflow_free(std->prefetch);
+	free(std->prefetch);
+	std->prefetch = NULL;
+}
+#endif /* BOOTSTD_PREFETCH */
+
 int bootflow_boot(struct bootflow *bflow)
 {
 	int ret;
@@ -507,6 +775,8 @@ int bootflow_boot(struct bootflow *bflow)
 	if (bflow->state != BOOTFLOWST_READY)
 		return log_msg_ret("load", -EPROTO);
 
+	/* whatever is booted may change the files, if it returns */
+	bootstd_clear_probes();
 	ret = bootmeth_boot(bflow->method, bflow);
 	if (ret)
 		return log_msg_ret("boot", ret);
@@ -528,6 +798,9 @@ int bootflow_run_boot(struct bootflow_iter *iter, struct bootflow *bflow)
 	if (IS_ENABLED(CONFIG_OF_HAS_PRIOR_STAGE) &&
 	    (bflow->flags & BOOTFLOWF_USE_PRIOR_FDT))
 		printf("Using prior-stage device tree\n");
+	if (IS_ENABLED(CONFIG_BOOTSTD_CACHE) && iter &&
+	    (iter->flags & BOOTFLOWIF_CACHE))
+		bootflow_cache_save(bflow);
 	ret = bootflow_boot(bflow);
 	if (!IS_ENABLED(CONFIG_BOOTSTD_FULL)) {
 		printf("Boot failed (err=%d)\n", ret);
@@ -569,7 +842,20 @@ int bootflow_iter_check_blk(const struct bootflow_iter *iter)
 	enum uclass_id id = device_get_uclass_id(media);
 
 	log_debug("uclass %d: %s\n", id, uclass_get_name(id));
-	if (id != UCLASS_ETH && id != UCLASS_BOOTSTD && id != UCLASS_QFW)
+	if (id != UCLASS_ETH && id != UCLASS_BOOTSTD && id != UCLASS_QFW &&
+	    id != UCLASS_FS)
+		return 0;
+
+	return -ENOTSUPP;
+}
+
+int bootflow_iter_check_fs(const struct bootflow_iter *iter)
+{
+	const struct udevice *media = dev_get_parent(iter->dev);
+	enum uclass_id id = device_get_uclass_id(media);
+
+	log_debug("uclass %d: %s\n", id, uclass_get_name(id));
+	if (id == UCLASS_FS)
 		return 0;
 
 	return -ENOTSUPP;
@@ -257,6 +257,9 @@ static inline void boot_start_lmb(struct bootm_headers *images) { }
 
 static int bootm_start(void)
 {
+	/* Free anything left from an earlier bootm */
+	if (IS_ENABLED(CONFIG_LMB))
+		lmb_uninit(images_lmb(&images));
 	memset((void *)&images, 0, sizeof(images));
 	images.verify = env_get_yesno("verify");
 
@@ -650,9 +653,11 @@ static int bootm_load_os(struct bootm_headers *images, int boot_progress)
 
 	load_buf = map_sysmem(load, 0);
 	image_buf = map_sysmem(os.image_start, image_len);
+	bootstage_pipe_image(images->fit_uname_os ?: "os");
 	err = image_decomp(os.comp, load, os.image_start, os.type,
 			   load_buf, image_buf, image_len,
 			   CONFIG_SYS_BOOTM_LEN, &load_end);
+	bootstage_pipe_image(NULL);
 	if (err) {
 		err = handle_decomp_error(os.comp, load_end - load,
 					  CONFIG_SYS_BOOTM_LEN, err);
@@ -705,7 +710,8 @@ static int bootm_load_os(struct bootm_headers *images, int boot_progress)
 			printf("Moving Image from 0x%lx to 0x%lx, end=%lx\n",
 			       load, relocated_addr,
 			       relocated_addr + image_size);
-			memmove((void *)relocated_addr, load_buf, image_size);
+			memmove_wd((void *)relocated_addr, load_buf,
+				   image_size, CHUNKSZ);
 		}
 
 		images->ep = relocated_addr;
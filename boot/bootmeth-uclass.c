@@ -15,6 +15,7 @@
 #include <fs.h>
 #include <malloc.h>
 #include <mapmem.h>
+#include <virtiofs.h>
 #include <dm/uclass-internal.h>
 
 DECLARE_GLOBAL_DATA_PTR;
@@ -251,6 +252,24 @@ int bootmeth_set_order(const char *order_str)
 	return 0;
 }
 
+/**
+ * bootmeth_set_fs_type() - Select the filesystem fixed by the media, if any
+ *
+ * @bflow: Bootflow being read
+ * Return: 0 if OK, -ve on error
+ */
+static int bootmeth_set_fs_type(struct bootflow *bflow)
+{
+	/* A virtio-fs share must be selected as well */
+	if (CONFIG_IS_ENABLED(VIRTIO) && IS_ENABLED(CONFIG_VIRTIO_FS) &&
+	    bflow->fs_type == FS_TYPE_VIRTIO)
+		return virtio_fs_select(dev_get_parent(bflow->dev));
+	if (IS_ENABLED(CONFIG_BOOTSTD_FULL) && bflow->fs_type)
+		fs_set_type(bflow->fs_type);
+
+	return 0;
+}
+
 int bootmeth_setup_fs(struct bootflow *bflow, struct blk_desc *desc)
 {
 	int ret;
@@ -259,8 +278,10 @@ int bootmeth_setup_fs(struct bootflow *bflow, struct blk_desc *desc)
 		ret = fs_set_blk_dev_with_part(desc, bflow->part);
 		if (ret)
 			return log_msg_ret("set", ret);
-	} else if (IS_ENABLED(CONFIG_BOOTSTD_FULL) && bflow->fs_type) {
-		fs_set_type(bflow->fs_type);
+	} else {
+		ret = bootmeth_set_fs_type(bflow);
+		if (ret)
+			return log_msg_ret("typ", ret);
 	}
 
 	return 0;
@@ -269,6 +290,7 @@ int bootmeth_setup_fs(struct bootflow *bflow, struct blk_desc *desc)
 int bootmeth_try_file(struct bootflow *bflow, struct blk_desc *desc,
 		      const char *prefix, const char *fname)
 {
+	struct bootstd_probe *probe;
 	char path[200];
 	loff_t size;
 	int ret, ret2;
@@ -281,19 +303,38 @@ int bootmeth_try_file(struct bootflow *bflow, struct blk_desc *desc,
 	if (!bflow->fname)
 		return log_msg_ret("name", -ENOMEM);
 
-	if (IS_ENABLED(CONFIG_BOOTSTD_FULL) && bflow->fs_type)
-		fs_set_type(bflow->fs_type);
-
-	ret = fs_size(path, &size);
-	log_debug("   %s - err=%d\n", path, ret);
+	ret = bootmeth_set_fs_type(bflow);
+	if (ret)
+		return log_msg_ret("typ", ret);
+
+	/*
+	 * Another bootmeth may have looked already. If the file is not there,
+	 * the filesystem is left as it is, so it need not be set up again
+	 */
+	probe = desc ? bootstd_find_probe(bflow->blk, bflow->part, path) : NULL;
+	if (probe) {
+		log_debug("   %s - err=%d (seen)\n", path, probe->ret);
+		if (probe->ret)
+			return log_msg_ret("seen", probe->ret);
+		ret = bootmeth_setup_fs(bflow, desc);
+		if (ret)
+			return log_msg_ret("fs", ret);
+		size = probe->size;
+	} else {
+		ret = fs_size(path, &size);
+		log_debug("   %s - err=%d\n", path, ret);
 
-	/* Sadly FS closes the file after fs_size() so we must redo this */
-	ret2 = bootmeth_setup_fs(bflow, desc);
-	if (ret2)
-		return log_msg_ret("fs", ret2);
+		/* Sadly FS closes the file after fs_size() so we must redo this */
+		ret2 = bootmeth_setup_fs(bflow, desc);
+		if (ret2)
+			return log_msg_ret("fs", ret2);
 
-	if (ret)
-		return log_msg_ret("size", ret);
+		if (desc)
+			bootstd_add_probe(bflow->blk, bflow->part, path, ret,
+					  size);
+		if (ret)
+			return log_msg_ret("size", ret);
+	}
 
 	bflow->size = size;
 	bflow->state = BOOTFLOWST_FILE;
@@ -53,12 +53,37 @@ static int extlinux_getfile(struct pxe_context *ctx, const char *file_path,
 	return 0;
 }
 
+static int extlinux_gethead(struct pxe_context *ctx, const char *file_path,
+			    ulong addr, ulong len)
+{
+	struct extlinux_info *info = ctx->userdata;
+	struct bootflow *bflow = info->bflow;
+	struct blk_desc *desc = NULL;
+	loff_t len_read;
+	int ret;
+
+	if (bflow->blk)
+		desc = dev_get_uclass_plat(bflow->blk);
+	ret = bootmeth_setup_fs(bflow, desc);
+	if (ret)
+		return log_msg_ret("fs", ret);
+	ret = fs_read(file_path, addr, 0, len, &len_read);
+	if (ret)
+		return log_msg_ret("read", ret);
+	if (len_read != len)
+		return log_msg_ret("len", -EIO);
+
+	return 0;
+}
+
 static int extlinux_check(struct udevice *dev, struct bootflow_iter *iter)
 {
 	int ret;
 
-	/* This only works on block devices */
+	/* This only works on block devices and host filesystems */
 	ret = bootflow_iter_check_blk(iter);
+	if (ret)
+		ret = bootflow_iter_check_fs(iter);
 	if (ret)
 		return log_msg_ret("blk", ret);
 
@@ -152,6 +177,7 @@ static int extlinux_boot(struct udevice *dev, struct bootflow *bflow)
 			    bflow->fname, false);
 	if (ret)
 		return log_msg_ret("ctx", -EINVAL);
+	ctx.gethead = extlinux_gethead;
 
 	ret = pxe_process(&ctx, addr, false);
 	if (ret)
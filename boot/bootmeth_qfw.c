@@ -13,6 +13,7 @@
 #include <bootflow.h>
 #include <bootmeth.h>
 #include <env.h>
+#include <mapmem.h>
 #include <qfw.h>
 #include <dm.h>
 
@@ -31,7 +32,7 @@ static int qfw_check(struct udevice *dev, struct bootflow_iter *iter)
 static int qfw_read_bootflow(struct udevice *dev, struct bootflow *bflow)
 {
 	struct udevice *qfw_dev = dev_get_parent(bflow->dev);
-	ulong load, initrd;
+	ulong load, initrd, kernel;
 	int ret;
 
 	load = env_get_hex("kernel_addr_r", 0);
@@ -41,11 +42,15 @@ static int qfw_read_bootflow(struct udevice *dev, struct bootflow *bflow)
 	if (!bflow->name)
 		return log_msg_ret("name", -ENOMEM);
 
-	ret = qemu_fwcfg_setup_kernel(qfw_dev, load, initrd);
+	ret = qemu_fwcfg_load_kernel(qfw_dev, load, initrd, &kernel);
 	log_debug("setup kernel result %d\n", ret);
 	if (ret)
 		return log_msg_ret("cmd", -EIO);
 
+	/* Record where the kernel ended up, so it can be booted from there */
+	bflow->buf = map_sysmem(kernel, 0);
+	bflow->flags |= BOOTFLOWF_STATIC_BUF;
+
 	bflow->state = BOOTFLOWST_READY;
 
 	return 0;
@@ -59,13 +64,20 @@ static int qfw_read_file(struct udevice *dev, struct bootflow *bflow,
 
 static int qfw_boot(struct udevice *dev, struct bootflow *bflow)
 {
+	char cmd[80];
+	ulong kernel;
 	int ret;
 
-	ret = run_command("booti ${kernel_addr_r} ${ramdisk_addr_r}:${filesize} ${fdtcontroladdr}",
-			  0);
+	kernel = map_to_sysmem(bflow->buf);
+	snprintf(cmd, sizeof(cmd),
+		 "booti %lx ${ramdisk_addr_r}:${filesize} ${fdtcontroladdr}",
+		 kernel);
+	ret = run_command(cmd, 0);
 	if (ret) {
-		ret = run_command("bootz ${kernel_addr_r} ${ramdisk_addr_r}:${filesize} "
-				  "${fdtcontroladdr}", 0);
+		snprintf(cmd, sizeof(cmd),
+			 "bootz %lx ${ramdisk_addr_r}:${filesize} ${fdtcontroladdr}",
+			 kernel);
+		ret = run_command(cmd, 0);
 	}
 
 	return ret ? -EIO : 0;
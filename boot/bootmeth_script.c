@@ -29,6 +29,10 @@ static int script_check(struct udevice *dev, struct bootflow_iter *iter)
 	if (iter->method_flags & BOOTFLOW_METHF_PXE_ONLY)
 		return log_msg_ret("pxe", -ENOTSUPP);
 
+	/* The script is told the block device to load files from */
+	if (!bootflow_iter_check_fs(iter))
+		return log_msg_ret("fs", -ENOTSUPP);
+
 	return 0;
 }
 
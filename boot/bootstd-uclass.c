@@ -61,6 +61,73 @@ void bootstd_clear_glob(void)
 	bootstd_clear_glob_(std);
 }
 
+static void bootstd_clear_probes_(struct bootstd_priv *std)
+{
+	struct bootstd_probe *probe, *next;
+
+	list_for_each_entry_safe(probe, next, &std->probes, node) {
+		list_del(&probe->node);
+		free(probe->path);
+		free(probe);
+	}
+}
+
+void bootstd_clear_probes(void)
+{
+	struct bootstd_priv *std;
+
+	if (!IS_ENABLED(CONFIG_BOOTSTD_PROBE_CACHE) || bootstd_get_priv(&std))
+		return;
+
+	bootstd_clear_probes_(std);
+}
+
+struct bootstd_probe *bootstd_find_probe(struct udevice *blk, int part,
+					 const char *path)
+{
+	struct bootstd_probe *probe;
+	struct bootstd_priv *std;
+
+	if (!IS_ENABLED(CONFIG_BOOTSTD_PROBE_CACHE) || bootstd_get_priv(&std))
+		return NULL;
+
+	list_for_each_entry(probe, &std->probes, node) {
+		if (probe->blk != blk || probe->part != part)
+			continue;
+		if (path ? probe->path && !strcmp(probe->path, path) :
+		    !probe->path)
+			return probe;
+	}
+
+	return NULL;
+}
+
+void bootstd_add_probe(struct udevice *blk, int part, const char *path,
+		       int ret, loff_t size)
+{
+	struct bootstd_probe *probe;
+	struct bootstd_priv *std;
+
+	if (!IS_ENABLED(CONFIG_BOOTSTD_PROBE_CACHE) || bootstd_get_priv(&std))
+		return;
+
+	probe = calloc(1, sizeof(*probe));
+	if (!probe)
+		return;
+	if (path) {
+		probe->path = strdup(path);
+		if (!probe->path) {
+			free(probe);
+			return;
+		}
+	}
+	probe->blk = blk;
+	probe->part = part;
+	probe->ret = ret;
+	probe->size = size;
+	list_add_tail(&probe->node, &std->probes);
+}
+
 static int bootstd_remove(struct udevice *dev)
 {
 	struct bootstd_priv *priv = dev_get_priv(dev);
@@ -68,6 +135,11 @@ static int bootstd_remove(struct udevice *dev)
 	free(priv->prefixes);
 	free(priv->bootdev_order);
 	bootstd_clear_glob_(priv);
+	bootstd_clear_probes_(priv);
+	if (priv->prefetch) {
+		bootflow_free(priv->prefetch);
+		free(priv->prefetch);
+	}
 
 	return 0;
 }
@@ -118,6 +190,7 @@ static int bootstd_probe(struct udevice *dev)
 	struct bootstd_priv *std = dev_get_priv(dev);
 
 	INIT_LIST_HEAD(&std->glob_head);
+	INIT_LIST_HEAD(&std->probes);
 
 	return 0;
 }
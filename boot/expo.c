@@ -195,18 +195,36 @@ int expo_render(struct expo *exp)
 
 	back = CONFIG_IS_ENABLED(SYS_WHITE_ON_BLACK) ? VID_BLACK : VID_WHITE;
 	colour = video_index_to_colour(vid_priv, back);
-	ret = video_fill(dev, colour);
-	if (ret)
-		return log_msg_ret("fill", ret);
 
 	if (exp->scene_id) {
 		scn = expo_lookup_scene_id(exp, exp->scene_id);
 		if (!scn)
 			return log_msg_ret("scn", -ENOENT);
+	}
 
+	/* if the scene is already on the display, just update it */
+	if (CONFIG_IS_ENABLED(EXPO_INCREMENTAL) && scn && !exp->text_mode &&
+	    exp->drawn_scene_id == scn->id) {
+		ret = scene_render_update(scn, colour);
+		if (!ret) {
+			video_sync(dev, true);
+			return 0;
+		}
+		if (ret != -E2BIG)
+			return log_msg_ret("upd", ret);
+	}
+	exp->drawn_scene_id = 0;
+
+	ret = video_fill(dev, colour);
+	if (ret)
+		return log_msg_ret("fill", ret);
+
+	if (scn) {
 		ret = scene_render(scn);
 		if (ret)
 			return log_msg_ret("ren", ret);
+		if (!exp->text_mode)
+			exp->drawn_scene_id = scn->id;
 	}
 
 	video_sync(dev, true);
@@ -214,6 +232,11 @@ int expo_render(struct expo *exp)
 	return scn ? 0 : -ECHILD;
 }
 
+void expo_redraw(struct expo *exp)
+{
+	exp->drawn_scene_id = 0;
+}
+
 int expo_send_key(struct expo *exp, int key)
 {
 	struct scene *scn = NULL;
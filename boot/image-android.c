@@ -75,6 +75,7 @@ static void android_boot_image_v3_v4_parse_hdr(const struct andr_boot_img_hdr_v3
 	data->kernel_size = hdr->kernel_size;
 	end += ALIGN(hdr->kernel_size, ANDR_GKI_PAGE_SIZE);
 	data->ramdisk_size = hdr->ramdisk_size;
+	data->boot_ramdisk_ptr = end;
 	data->boot_ramdisk_size = hdr->ramdisk_size;
 	end += ALIGN(hdr->ramdisk_size, ANDR_GKI_PAGE_SIZE);
 
@@ -116,11 +117,12 @@ static void android_vendor_boot_image_v3_v4_parse_hdr(const struct andr_vnd_boot
 	end += ALIGN(hdr->vendor_ramdisk_table_size, hdr->page_size);
 	data->bootconfig_addr = end;
 	if (hdr->bootconfig_size) {
-		data->bootconfig_size += add_trailer(data->bootconfig_addr,
-						     data->bootconfig_size);
-		data->ramdisk_size += data->bootconfig_size;
+		/* The trailer is added when the ramdisk is put together */
+		data->ramdisk_size += hdr->bootconfig_size;
+		if (!is_trailer_present(end + hdr->bootconfig_size))
+			data->ramdisk_size += BOOTCONFIG_TRAILER_SIZE;
 	}
-	end += ALIGN(data->bootconfig_size, hdr->page_size);
+	end += ALIGN(hdr->bootconfig_size, hdr->page_size);
 	data->vendor_boot_img_total_size = end - (ulong)hdr;
 }
 
@@ -379,6 +381,22 @@ ulong android_image_get_kcomp(const void *hdr,
 		return image_decomp_type(p, sizeof(u32));
 }
 
+/**
+ * android_image_put_fragment() - Put part of the ramdisk in its place
+ *
+ * @dest: Address to put it
+ * @src: Address of the fragment in the (vendor) boot image
+ * @size: Size of the fragment in bytes
+ * Return: address just after the fragment at @dest
+ */
+static ulong android_image_put_fragment(ulong dest, ulong src, ulong size)
+{
+	if (size && dest != src)
+		memmove((void *)dest, (void *)src, size);
+
+	return dest + size;
+}
+
 int android_image_get_ramdisk(const void *hdr, const void *vendor_boot_img,
 			      ulong *rd_data, ulong *rd_len)
 {
@@ -392,26 +410,39 @@ int android_image_get_ramdisk(const void *hdr, const void *vendor_boot_img,
 		*rd_data = *rd_len = 0;
 		return -1;
 	}
+	ramdisk_ptr = img_data.ramdisk_ptr;
 	if (img_data.header_version > 2) {
-		ramdisk_ptr = img_data.ramdisk_ptr;
-		memcpy((void *)(ramdisk_ptr), (void *)img_data.vendor_ramdisk_ptr,
-		       img_data.vendor_ramdisk_size);
-		memcpy((void *)(ramdisk_ptr + img_data.vendor_ramdisk_size),
-		       (void *)img_data.ramdisk_ptr,
-		       img_data.boot_ramdisk_size);
-		if (img_data.bootconfig_size) {
-			memcpy((void *)
-			       (ramdisk_ptr + img_data.vendor_ramdisk_size +
-			       img_data.boot_ramdisk_size),
-			       (void *)img_data.bootconfig_addr,
-			       img_data.bootconfig_size);
+		bool bootconfig = img_data.bootconfig_size;
+		ulong end;
+
+		/*
+		 * A ramdisk with a single part can be used where it is in the
+		 * image, rather than being copied to ramdisk_addr_r
+		 */
+		if (!bootconfig && !img_data.boot_ramdisk_size) {
+			ramdisk_ptr = img_data.vendor_ramdisk_ptr;
+		} else if (!bootconfig && !img_data.vendor_ramdisk_size) {
+			ramdisk_ptr = img_data.boot_ramdisk_ptr;
+		} else {
+			end = android_image_put_fragment(ramdisk_ptr,
+							 img_data.vendor_ramdisk_ptr,
+							 img_data.vendor_ramdisk_size);
+			end = android_image_put_fragment(end,
+							 img_data.boot_ramdisk_ptr,
+							 img_data.boot_ramdisk_size);
+			if (bootconfig) {
+				android_image_put_fragment(end,
+							   img_data.bootconfig_addr,
+							   img_data.bootconfig_size);
+				add_trailer(end, img_data.bootconfig_size);
+			}
 		}
 	}
 
 	printf("RAM disk load addr 0x%08lx size %u KiB\n",
-	       img_data.ramdisk_ptr, DIV_ROUND_UP(img_data.ramdisk_size, 1024));
+	       ramdisk_ptr, DIV_ROUND_UP(img_data.ramdisk_size, 1024));
 
-	*rd_data = img_data.ramdisk_ptr;
+	*rd_data = ramdisk_ptr;
 
 	*rd_len = img_data.ramdisk_size;
 	return 0;
@@ -12,6 +12,7 @@
 #include <bootstage.h>
 #include <cpu_func.h>
 #include <display_options.h>
+#include <dma.h>
 #include <env.h>
 #include <fpga.h>
 #include <image.h>
@@ -165,6 +166,8 @@ void memmove_wd(void *to, void *from, size_t len, ulong chunksz)
 {
 	if (to == from)
 		return;
+	if (!dma_bulk_copy(to, from, len))
+		return;
 
 	if (IS_ENABLED(CONFIG_HW_WATCHDOG) || IS_ENABLED(CONFIG_WATCHDOG)) {
 		if (to > from) {
@@ -711,6 +714,59 @@ static void fit_loadable_process(u8 img_type,
 			fit_loadable_handler->handler(img_data, img_len);
 }
 
+/* Most loadables which are loaded before any are processed */
+#define BOOT_LOADABLE_BATCH	16
+
+/**
+ * struct boot_loadable - a loadable waiting to be processed
+ *
+ * @dj: Job decompressing the loadable, if @pending
+ * @data: Address of the loadable
+ * @len: Length of the loadable, if not @pending
+ * @type: Image type (IH_TYPE_...)
+ * @pending: true if the loadable is still being decompressed by @dj
+ */
+struct boot_loadable {
+	struct image_decomp_job dj;
+	ulong data;
+	ulong len;
+	u8 type;
+	bool pending;
+};
+
+/**
+ * boot_process_loadables() - Process a batch of loadables, in order
+ *
+ * This waits for each one to be decompressed, if needed
+ *
+ * @list: Loadables to process
+ * @count: Number of loadables
+ * Return: 0 if OK, -ENOEXEC if decompression failed
+ */
+static int boot_process_loadables(struct boot_loadable *list, int count)
+{
+	int ret = 0;
+	int i;
+
+	for (i = 0; i < count; i++) {
+		struct boot_loadable *bl = &list[i];
+		ulong load_end;
+
+		if (bl->pending) {
+			/* All jobs must be waited for, even after an error */
+			if (image_decomp_finish(&bl->dj, &load_end)) {
+				printf("Error decompressing loadable\n");
+				ret = -ENOEXEC;
+			}
+			bl->len = load_end - bl->data;
+		}
+		if (!ret)
+			fit_loadable_process(bl->type, bl->data, bl->len);
+	}
+
+	return ret;
+}
+
 int boot_get_loadable(struct bootm_headers *images)
 {
 	/*
@@ -719,16 +775,19 @@ int boot_get_loadable(struct bootm_headers *images)
 	 */
 	ulong tmp_img_addr;
 	/*
-	 * These two variables are requirements for fit_image_load, but
-	 * their values are not used
+	 * Loadables are loaded in batches. Decompression of each one may be
+	 * handed to another CPU, so that several run at once, and they are
+	 * processed once the batch is complete.
 	 */
-	ulong img_data, img_len;
+	struct boot_loadable list[BOOT_LOADABLE_BATCH];
+	struct boot_loadable *bl;
+	int count = 0;
 	void *buf;
 	int loadables_index;
 	int conf_noffset;
 	int fit_img_result;
 	const char *uname;
-	u8 img_type;
+	int ret;
 
 	/* Check to see if the images struct has a FIT configuration */
 	if (!genimg_has_config(images)) {
@@ -754,6 +813,9 @@ int boot_get_loadable(struct bootm_headers *images)
 						FIT_LOADABLE_PROP,
 						loadables_index, NULL), uname;
 		     loadables_index++) {
+			bl = &list[count];
+			images->decomp_job = CONFIG_IS_ENABLED(CPU_JOBS) ?
+				&bl->dj : NULL;
 			fit_img_result = fit_image_load(images, tmp_img_addr,
 							&uname,
 							&images->fit_uname_cfg,
@@ -761,27 +823,37 @@ int boot_get_loadable(struct bootm_headers *images)
 							IH_TYPE_LOADABLE,
 							BOOTSTAGE_ID_FIT_LOADABLE_START,
 							FIT_LOAD_OPTIONAL_NON_ZERO,
-							&img_data, &img_len);
-			if (fit_img_result < 0) {
-				/* Something went wrong! */
-				return fit_img_result;
+							&bl->data, &bl->len);
+			bl->pending = CONFIG_IS_ENABLED(CPU_JOBS) &&
+				!images->decomp_job;
+			images->decomp_job = NULL;
+			if (fit_img_result >= 0) {
+				fit_img_result = fit_image_get_node(buf, uname);
+				if (fit_img_result >= 0)
+					fit_img_result = fit_image_get_type(buf,
+							fit_img_result,
+							&bl->type);
 			}
-
-			fit_img_result = fit_image_get_node(buf, uname);
-			if (fit_img_result < 0) {
-				/* Something went wrong! */
-				return fit_img_result;
-			}
-			fit_img_result = fit_image_get_type(buf,
-							    fit_img_result,
-							    &img_type);
 			if (fit_img_result < 0) {
+				ulong load_end;
+
 				/* Something went wrong! */
+				if (bl->pending)
+					image_decomp_finish(&bl->dj, &load_end);
+				boot_process_loadables(list, count);
 				return fit_img_result;
 			}
 
-			fit_loadable_process(img_type, img_data, img_len);
+			if (++count == BOOT_LOADABLE_BATCH) {
+				ret = boot_process_loadables(list, count);
+				if (ret)
+					return ret;
+				count = 0;
+			}
 		}
+		ret = boot_process_loadables(list, count);
+		if (ret)
+			return ret;
 		break;
 	default:
 		printf("The given image format is not supported (corrupt?)\n");
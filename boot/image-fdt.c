@@ -8,6 +8,7 @@
  * Wolfgang Denk, DENX Software Engineering, wd@denx.de.
  */
 
+#include <abuf.h>
 #include <command.h>
 #include <fdt_support.h>
 #include <fdtdec.h>
@@ -20,6 +21,7 @@
 #include <asm/global_data.h>
 #include <linux/libfdt.h>
 #include <mapmem.h>
+#include <of_live.h>
 #include <asm/io.h>
 #include <dm/ofnode.h>
 #include <tee/optee.h>
@@ -569,6 +571,67 @@ __weak int arch_fixup_fdt(void *blob)
 	return 0;
 }
 
+/**
+ * fdt_fixup_event_live() - Run the EVT_FT_FIXUP handlers on a live tree
+ *
+ * Each change to a flat tree moves everything after it, so a large number of
+ * fixups on a large tree is slow. Instead, unflatten @blob, let the handlers
+ * change the live tree, then flatten it back into @blob in one pass. The
+ * memory-reservation block is preserved.
+ *
+ * @images: Images which are being booted
+ * @blob: Devicetree to fix up, which keeps its current total size
+ * Return: 0 if OK, -ENOSPC if the result does not fit in @blob, other -ve on
+ *	error
+ */
+static int fdt_fixup_event_live(struct bootm_headers *images, void *blob)
+{
+	struct event_ft_fixup fixup;
+	struct device_node *root;
+	int size = fdt_totalsize(blob);
+	struct abuf buf;
+	int i, count, ret;
+	u64 *rsv;
+
+	/* pairs of address and size */
+	count = fdt_num_mem_rsv(blob);
+	if (count < 0)
+		return -EINVAL;
+	rsv = calloc(count + 1, 2 * sizeof(u64));
+	if (!rsv)
+		return -ENOMEM;
+	for (i = 0; i < count; i++)
+		fdt_get_mem_rsv(blob, i, &rsv[i * 2], &rsv[i * 2 + 1]);
+
+	ret = unflatten_device_tree(blob, &root);
+	if (ret)
+		goto err_rsv;
+	fixup.tree = oftree_from_np(root);
+	fixup.images = images;
+	ret = event_notify(EVT_FT_FIXUP, &fixup, sizeof(fixup));
+	if (!ret)
+		ret = of_live_flatten(root, &buf);
+
+	/* property values point into the blob, so free before overwriting */
+	of_live_free(root);
+	if (ret)
+		goto err_rsv;
+
+	ret = fdt_open_into(abuf_data(&buf), blob, size);
+	for (i = 0; !ret && i < count; i++)
+		ret = fdt_add_mem_rsv(blob, rsv[i * 2], rsv[i * 2 + 1]);
+	abuf_uninit(&buf);
+	if (ret) {
+		log_debug("Cannot store fixed-up tree (err=%s)\n",
+			  fdt_strerror(ret));
+		ret = ret == -FDT_ERR_NOSPACE ? -ENOSPC : -EINVAL;
+	}
+err_rsv:
+	free(rsv);
+
+	return ret;
+}
+
 int image_setup_libfdt(struct bootm_headers *images, void *blob,
 		       struct lmb *lmb)
 {
@@ -654,7 +717,13 @@ int image_setup_libfdt(struct bootm_headers *images, void *blob,
 		goto err;
 
 	/* after here we are using a livetree */
-	if (!of_live_active() && CONFIG_IS_ENABLED(EVENT)) {
+	if (IS_ENABLED(CONFIG_OF_LIVE_FIXUP) && of_live_active()) {
+		ret = fdt_fixup_event_live(images, blob);
+		if (ret) {
+			printf("ERROR: fdt fixup event failed: %d\n", ret);
+			goto err;
+		}
+	} else if (!of_live_active() && CONFIG_IS_ENABLED(EVENT)) {
 		struct event_ft_fixup fixup;
 
 		fixup.tree = oftree_from_fdt(blob);
@@ -7,6 +7,7 @@
 #include "mkimage.h"
 #include <time.h>
 #else
+#include <bloblist.h>
 #include <log.h>
 #include <malloc.h>
 #include <asm/global_data.h>
@@ -224,6 +225,116 @@ int fit_image_verify_required_sigs(const void *fit, int image_noffset,
 	return 0;
 }
 
+#if !defined(USE_HOSTCC) && CONFIG_IS_ENABLED(FIT_SIGNATURE_CACHE)
+/* Most properties expected in a public-key node, e.g. rsa,modulus */
+#define FIT_SIG_KEY_PROPS	16
+
+/**
+ * fit_sig_cache_digest() - Work out the digest which identifies a signature
+ *
+ * This covers the signed data, the signature and each property of the public
+ * key node, so that a recorded digest only matches if all three are the same
+ *
+ * @info: Signature information
+ * @region: Regions of signed data
+ * @count: Number of regions
+ * @sig: Signature
+ * @sig_len: Length of @sig in bytes
+ * @digest: Returns the digest, padded with zeroes to FIT_SIG_DIGEST_LEN bytes
+ * Return: 0 if OK, -E2BIG if the digest or key is too large, other -ve value on
+ *	error
+ */
+static int fit_sig_cache_digest(struct image_sign_info *info,
+				const struct image_region *region, int count,
+				const void *sig, int sig_len, uint8_t *digest)
+{
+	const int max = count + 1 + FIT_SIG_KEY_PROPS * 2;
+	const void *blob = info->fdt_blob;
+	struct image_region all[max];
+	int offset, len, n;
+
+	if (info->required_keynode < 0 ||
+	    info->checksum->checksum_len > FIT_SIG_DIGEST_LEN)
+		return -E2BIG;
+	memcpy(all, region, count * sizeof(*region));
+	n = count;
+	all[n].data = sig;
+	all[n++].size = sig_len;
+	fdt_for_each_property_offset(offset, blob, info->required_keynode) {
+		const char *name;
+		const void *val;
+
+		if (n + 2 > max)
+			return -E2BIG;
+		val = fdt_getprop_by_offset(blob, offset, &name, &len);
+		if (!val)
+			return -EINVAL;
+		all[n].data = name;
+		all[n++].size = strlen(name) + 1;
+		all[n].data = val;
+		all[n++].size = len;
+	}
+	memset(digest, '\0', FIT_SIG_DIGEST_LEN);
+
+	return info->checksum->calculate(info->checksum->name, all, n, digest);
+}
+
+/**
+ * fit_sig_cache_find() - Check whether a signature has already been checked
+ *
+ * @digest: Digest from fit_sig_cache_digest()
+ * Return: true if the digest is recorded in the bloblist
+ */
+static bool fit_sig_cache_find(const uint8_t *digest)
+{
+	struct fit_sig_handoff *ho;
+	int i;
+
+	ho = bloblist_find(BLOBLISTT_U_BOOT_FIT_SIG, sizeof(*ho));
+	if (!ho)
+		return false;
+	for (i = 0; i < FIT_SIG_RECS; i++) {
+		if (!memcmp(ho->digest[i], digest, FIT_SIG_DIGEST_LEN))
+			return true;
+	}
+
+	return false;
+}
+
+/**
+ * fit_sig_cache_add() - Record that a signature has been checked
+ *
+ * @digest: Digest from fit_sig_cache_digest()
+ */
+static void fit_sig_cache_add(const uint8_t *digest)
+{
+	struct fit_sig_handoff *ho;
+
+	ho = bloblist_ensure(BLOBLISTT_U_BOOT_FIT_SIG, sizeof(*ho));
+	if (!ho)
+		return;
+	memcpy(ho->digest[ho->next % FIT_SIG_RECS], digest,
+	       FIT_SIG_DIGEST_LEN);
+	ho->next = (ho->next + 1) % FIT_SIG_RECS;
+}
+#else
+static int fit_sig_cache_digest(struct image_sign_info *info,
+				const struct image_region *region, int count,
+				const void *sig, int sig_len, uint8_t *digest)
+{
+	return -ENOSYS;
+}
+
+static bool fit_sig_cache_find(const uint8_t *digest)
+{
+	return false;
+}
+
+static void fit_sig_cache_add(const uint8_t *digest)
+{
+}
+#endif
+
 /**
  * fit_config_check_sig() - Check the signature of a config
  *
@@ -274,7 +385,9 @@ static int fit_config_check_sig(const void *fit, int noffset, int conf_noffset,
 	bool found_config;
 	int max_regions;
 	int i, prop_len;
+	uint8_t digest[FIT_SIG_DIGEST_LEN];
 	char path[200];
+	bool cached;
 	int count;
 
 	config_name = fit_get_name(fit, conf_noffset, NULL);
@@ -375,11 +488,19 @@ static int fit_config_check_sig(const void *fit, int noffset, int conf_noffset,
 	struct image_region region[count];
 
 	fit_region_make_list(fit, fdt_regions, count, region);
+	cached = !fit_sig_cache_digest(&info, region, count, fit_value,
+				       fit_value_len, digest);
+	if (cached && fit_sig_cache_find(digest)) {
+		debug("%s: Signature already checked\n", __func__);
+		return 0;
+	}
 	if (info.crypto->verify(&info, region, count, fit_value,
 				fit_value_len)) {
 		*err_msgp = "Verification failed";
 		return -1;
 	}
+	if (cached)
+		fit_sig_cache_add(digest);
 
 	return 0;
 }
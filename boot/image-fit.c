@@ -17,6 +17,7 @@
 #include <u-boot/crc.h>
 #include <linux/kconfig.h>
 #else
+#include <abuf.h>
 #include <linux/compiler.h>
 #include <linux/sizes.h>
 #include <errno.h>
@@ -25,11 +26,10 @@
 #include <asm/io.h>
 #include <malloc.h>
 #include <memalign.h>
+#include <of_overlay.h>
 #include <asm/global_data.h>
-#ifdef CONFIG_DM_HASH
+#include <cpu.h>
 #include <dm.h>
-#include <u-boot/hash.h>
-#endif
 DECLARE_GLOBAL_DATA_PTR;
 #endif /* !USE_HOSTCC*/
 
@@ -1252,31 +1252,6 @@ int fit_set_timestamp(void *fit, int noffset, time_t timestamp)
 int calculate_hash(const void *data, int data_len, const char *name,
 			uint8_t *value, int *value_len)
 {
-#if !defined(USE_HOSTCC) && defined(CONFIG_DM_HASH)
-	int rc;
-	enum HASH_ALGO hash_algo;
-	struct udevice *dev;
-
-	rc = uclass_get_device(UCLASS_HASH, 0, &dev);
-	if (rc) {
-		debug("failed to get hash device, rc=%d\n", rc);
-		return -1;
-	}
-
-	hash_algo = hash_algo_lookup_by_name(name);
-	if (hash_algo == HASH_ALGO_INVALID) {
-		debug("Unsupported hash algorithm\n");
-		return -1;
-	};
-
-	rc = hash_digest_wd(dev, hash_algo, data, data_len, value, CHUNKSZ);
-	if (rc) {
-		debug("failed to get hash value, rc=%d\n", rc);
-		return -1;
-	}
-
-	*value_len = hash_algo_digest_size(hash_algo);
-#else
 	struct hash_algo *algo;
 	int ret;
 
@@ -1288,13 +1263,125 @@ int calculate_hash(const void *data, int data_len, const char *name,
 
 	algo->hash_func_ws(data, data_len, value, algo->chunk_size);
 	*value_len = algo->digest_size;
-#endif
 
 	return 0;
 }
 
+int fit_hasher_start(struct fit_hasher *hsr, const void *fit,
+		     int image_noffset)
+{
+	int noffset;
+
+	hsr->count = 0;
+
+	fdt_for_each_subnode(noffset, fit, image_noffset) {
+		const char *name = fit_get_name(fit, noffset, NULL);
+		struct fit_hasher_algo *ha;
+		struct hash_algo *algo;
+		const char *algo_name;
+		int ignore = 0;
+
+		if (strncmp(name, FIT_HASH_NODENAME, strlen(FIT_HASH_NODENAME)))
+			continue;
+		if (fit_image_hash_get_algo(fit, noffset, &algo_name))
+			continue;
+		if (!tools_build())
+			fit_image_hash_get_ignore(fit, noffset, &ignore);
+		if (ignore)
+			continue;
+
+		/* Leave anything unusual to the normal path */
+		if (hsr->count == FIT_HASHER_MAX ||
+		    hash_lookup_algo(algo_name, &algo) || !algo->hash_init ||
+		    algo->digest_size > FIT_MAX_HASH_LEN)
+			goto err;
+		ha = &hsr->hash[hsr->count];
+		if (algo->hash_init(algo, &ha->ctx))
+			goto err;
+		ha->noffset = noffset;
+		ha->algo = algo;
+		hsr->count++;
+	}
+
+	return 0;
+
+err:
+	fit_hasher_abort(hsr);
+
+	return -ENOSYS;
+}
+
+int fit_hasher_update(struct fit_hasher *hsr, const void *buf, size_t size)
+{
+	int i;
+
+	for (i = 0; i < hsr->count; i++) {
+		struct fit_hasher_algo *ha = &hsr->hash[i];
+
+		if (ha->ctx &&
+		    ha->algo->hash_update(ha->algo, ha->ctx, buf, size, 0))
+			return -EIO;
+	}
+
+	return 0;
+}
+
+void fit_hasher_abort(struct fit_hasher *hsr)
+{
+	uint8_t value[FIT_MAX_HASH_LEN];
+	int i;
+
+	/* Finishing the hash is the only way to free its context */
+	for (i = 0; i < hsr->count; i++) {
+		struct fit_hasher_algo *ha = &hsr->hash[i];
+
+		if (ha->ctx)
+			ha->algo->hash_finish(ha->algo, ha->ctx, value,
+					      sizeof(value));
+		ha->ctx = NULL;
+	}
+	hsr->count = 0;
+}
+
+/**
+ * fit_hasher_finish() - Get the value of a hash calculated by a hasher
+ *
+ * @hsr: Hasher to use, or NULL if none
+ * @noffset: Offset of the hash node
+ * @value: Returns the hash value
+ * @value_len: Returns the length of the hash value
+ * Return: 0 if OK, -ENOENT if the hasher does not have this hash
+ */
+static int fit_hasher_finish(struct fit_hasher *hsr, int noffset,
+			     uint8_t *value, int *value_len)
+{
+	struct fit_hasher_algo *ha;
+	int i;
+
+	for (i = 0; hsr && i < hsr->count; i++) {
+		ha = &hsr->hash[i];
+		if (ha->noffset != noffset || !ha->ctx)
+			continue;
+
+		if (ha->algo->hash_finish(ha->algo, ha->ctx, value,
+					  FIT_MAX_HASH_LEN))
+			return -EIO;
+		ha->ctx = NULL;
+
+		/* calculate_hash() produces a big-endian crc32 */
+		if (!strcmp(ha->algo->name, "crc32"))
+			*(uint32_t *)value = cpu_to_be32(*(uint32_t *)value);
+		*value_len = ha->algo->digest_size;
+
+		return 0;
+	}
+
+	return -ENOENT;
+}
+
 static int fit_image_check_hash(const void *fit, int noffset, const void *data,
-				size_t size, char **err_msgp)
+				size_t size, struct fit_hasher *hsr,
+				char **err_msgp)
 {
 	ALLOC_CACHE_ALIGN_BUFFER(uint8_t, value, FIT_MAX_HASH_LEN);
 	int value_len;
@@ -1325,7 +1412,8 @@ static int fit_image_check_hash(const void *fit, int noffset, const void *data,
 		return -1;
 	}
 
-	if (calculate_hash(data, size, algo, value, &value_len)) {
+	if (fit_hasher_finish(hsr, noffset, value, &value_len) &&
+	    calculate_hash(data, size, algo, value, &value_len)) {
 		*err_msgp = "Unsupported hash algorithm";
 		return -1;
 	}
@@ -1341,22 +1429,26 @@ static int fit_image_check_hash(const void *fit, int noffset, const void *data,
 	return 0;
 }
 
-int fit_image_verify_with_data(const void *fit, int image_noffset,
-			       const void *key_blob, const void *data,
-			       size_t size)
+int fit_image_verify_hashed(const void *fit, int image_noffset,
+			    const void *key_blob, const void *data,
+			    size_t size, struct fit_hasher *hsr)
 {
 	int		noffset = 0;
 	char		*err_msg = "";
 	int verify_all = 1;
+	ulong start_us;
 	int ret;
 
 	/* Verify all required signatures */
+	start_us = bootstage_pipe_start();
 	if (FIT_IMAGE_ENABLE_VERIFY &&
 	    fit_image_verify_required_sigs(fit, image_noffset, data, size,
 					   key_blob, &verify_all)) {
 		err_msg = "Unable to verify required signature";
 		goto error;
 	}
+	if (FIT_IMAGE_ENABLE_VERIFY)
+		bootstage_pipe_end(BOOTSTAGE_PIPE_VERIFY, start_us, size, 0);
 
 	/* Process all hash subnodes of the component image node */
 	fdt_for_each_subnode(noffset, fit, image_noffset) {
@@ -1367,17 +1459,22 @@ int fit_image_verify_with_data(const void *fit, int image_noffset,
 		 * Multiple hash nodes require unique unit node
 		 * names, e.g. hash-1, hash-2, etc.
 		 */
+		start_us = bootstage_pipe_start();
 		if (!strncmp(name, FIT_HASH_NODENAME,
 			     strlen(FIT_HASH_NODENAME))) {
-			if (fit_image_check_hash(fit, noffset, data, size,
+			if (fit_image_check_hash(fit, noffset, data, size, hsr,
 						 &err_msg))
 				goto error;
+			bootstage_pipe_end(BOOTSTAGE_PIPE_HASH, start_us, size,
+					   0);
 			puts("+ ");
 		} else if (FIT_IMAGE_ENABLE_VERIFY && verify_all &&
 				!strncmp(name, FIT_SIG_NODENAME,
 					strlen(FIT_SIG_NODENAME))) {
 			ret = fit_image_check_sig(fit, noffset, data, size,
 						  gd_fdt_blob(), -1, &err_msg);
+			bootstage_pipe_end(BOOTSTAGE_PIPE_VERIFY, start_us,
+					   size, 0);
 
 			/*
 			 * Show an indication on failure, but do not return
@@ -1406,6 +1503,14 @@ error:
 	return 0;
 }
 
+int fit_image_verify_with_data(const void *fit, int image_noffset,
+			       const void *key_blob, const void *data,
+			       size_t size)
+{
+	return fit_image_verify_hashed(fit, image_noffset, key_blob, data,
+				       size, NULL);
+}
+
 /**
  * fit_image_verify - verify data integrity
  * @fit: pointer to the FIT format image header
@@ -1419,7 +1524,8 @@ error:
  *     1, if all hashes are valid
  *     0, otherwise (or on error)
  */
-int fit_image_verify(const void *fit, int image_noffset)
+static int fit_image_verify_hsr(const void *fit, int image_noffset,
+				struct fit_hasher *hsr)
 {
 	const char *name = fit_get_name(fit, image_noffset, NULL);
 	const void	*data;
@@ -1440,8 +1546,8 @@ int fit_image_verify(const void *fit, int image_noffset)
 		goto err;
 	}
 
-	return fit_image_verify_with_data(fit, image_noffset, gd_fdt_blob(),
-					  data, size);
+	return fit_image_verify_hashed(fit, image_noffset, gd_fdt_blob(),
+				       data, size, hsr);
 
 err:
 	printf("error!\n%s in '%s' image node\n", err_msg,
@@ -1449,6 +1555,97 @@ err:
 	return 0;
 }
 
+int fit_image_verify(const void *fit, int image_noffset)
+{
+	return fit_image_verify_hsr(fit, image_noffset, NULL);
+}
+
+#ifndef USE_HOSTCC
+/**
+ * struct fit_verify_job - hashing of one image, done by another CPU
+ *
+ * @job: Job which does the hashing
+ * @hsr: Hasher for the image
+ * @data: Image data
+ * @size: Size of image data
+ */
+struct fit_verify_job {
+	struct cpu_job job;
+	struct fit_hasher hsr;
+	const void *data;
+	size_t size;
+};
+
+static int fit_verify_job_run(struct cpu_job *job)
+{
+	struct fit_verify_job *vj = container_of(job, struct fit_verify_job,
+						 job);
+
+	return fit_hasher_update(&vj->hsr, vj->data, vj->size);
+}
+
+/**
+ * fit_start_verify_jobs() - Hash all images in parallel, on other CPUs
+ *
+ * @fit: FIT to check
+ * @images_noffset: Offset of images node
+ * Return: array of jobs, one for each image, or NULL if it is not worth trying
+ */
+static struct fit_verify_job *fit_start_verify_jobs(const void *fit,
+						    int images_noffset)
+{
+	struct fit_verify_job *jobs, *vj;
+	int noffset, count = 0;
+	struct udevice *dev;
+
+	/* A hash accelerator cannot be shared between CPUs */
+	if (!CONFIG_IS_ENABLED(CPU_JOBS) || IS_ENABLED(CONFIG_SHA_HW_ACCEL))
+		return NULL;
+	if (CONFIG_IS_ENABLED(DM_HASH) && !uclass_first_device_err(UCLASS_HASH,
+								   &dev))
+		return NULL;
+
+	fdt_for_each_subnode(noffset, fit, images_noffset)
+		count++;
+	if (count < 2)
+		return NULL;
+	/* The extra, empty, job marks the end */
+	jobs = calloc(count + 1, sizeof(*jobs));
+	if (!jobs)
+		return NULL;
+
+	vj = jobs;
+	fdt_for_each_subnode(noffset, fit, images_noffset) {
+		vj->job.func = fit_verify_job_run;
+		vj->job.done = true;
+		if (!fit_image_get_data_and_size(fit, noffset, &vj->data,
+						 &vj->size) &&
+		    !fit_hasher_start(&vj->hsr, fit, noffset))
+			cpu_job_start(&vj->job);
+		vj++;
+	}
+
+	return jobs;
+}
+
+/**
+ * fit_finish_verify_job() - Wait for an image to be hashed
+ *
+ * @vj: Job to wait for
+ * Return: hasher with the results, or NULL if the hashes must be calculated
+ *	again
+ */
+static struct fit_hasher *fit_finish_verify_job(struct fit_verify_job *vj)
+{
+	if (cpu_job_wait(&vj->job)) {
+		fit_hasher_abort(&vj->hsr);
+		return NULL;
+	}
+
+	return &vj->hsr;
+}
+#endif
+
 /**
  * fit_all_image_verify - verify data integrity for all images
  * @fit: pointer to the FIT format image header
@@ -1462,10 +1659,15 @@ err:
  */
 int fit_all_image_verify(const void *fit)
 {
+#ifndef USE_HOSTCC
+	struct fit_verify_job *jobs;
+#endif
+	struct fit_hasher *hsr = NULL;
 	int images_noffset;
 	int noffset;
 	int ndepth;
 	int count;
+	int ret = 1;
 
 	/* Find images parent node offset */
 	images_noffset = fdt_path_offset(fit, FIT_IMAGES_PATH);
@@ -1478,6 +1680,9 @@ int fit_all_image_verify(const void *fit)
 	/* Process all image subnodes, check hashes for each */
 	printf("## Checking hash(es) for FIT Image at %08lx ...\n",
 	       (ulong)fit);
+#ifndef USE_HOSTCC
+	jobs = fit_start_verify_jobs(fit, images_noffset);
+#endif
 	for (ndepth = 0, count = 0,
 	     noffset = fdt_next_node(fit, images_noffset, &ndepth);
 			(noffset >= 0) && (ndepth > 0);
@@ -1489,14 +1694,32 @@ int fit_all_image_verify(const void *fit)
 			 */
 			printf("   Hash(es) for Image %u (%s): ", count,
 			       fit_get_name(fit, noffset, NULL));
+#ifndef USE_HOSTCC
+			if (jobs)
+				hsr = fit_finish_verify_job(&jobs[count]);
+#endif
 			count++;
 
-			if (!fit_image_verify(fit, noffset))
-				return 0;
+			if (!fit_image_verify_hsr(fit, noffset, hsr)) {
+				ret = 0;
+				break;
+			}
 			printf("\n");
 		}
 	}
-	return 1;
+#ifndef USE_HOSTCC
+	if (jobs) {
+		struct fit_verify_job *vj;
+
+		for (vj = jobs; vj->job.func; vj++) {
+			cpu_job_wait(&vj->job);
+			fit_hasher_abort(&vj->hsr);
+		}
+		free(jobs);
+	}
+#endif
+
+	return ret;
 }
 
 static int fit_image_uncipher(const void *fit, int image_noffset,
@@ -2050,6 +2273,41 @@ static const char *fit_get_image_type_property(int type)
 	return "unknown";
 }
 
+/**
+ * fit_image_decomp_start() - Start decompressing a loadable on another CPU
+ *
+ * This is used if the caller of fit_image_load() provides a job in
+ * @images->decomp_job. The job is used up, so @images->decomp_job is set to
+ * NULL.
+ *
+ * @images: Images information
+ * @image_type: Type of the image being loaded (IH_TYPE_...)
+ * @comp: Compression algorithm that is used (IH_COMP_...)
+ * @load: Destination load address in U-Boot memory
+ * @data: Image start address (where we are decompressing from)
+ * @loadbuf: Place to decompress to
+ * @buf: Address to decompress from
+ * @len: Number of bytes in @buf to decompress
+ * @max_len: Available space for decompression
+ * Return: true if started, false if the image must be decompressed now
+ */
+static bool fit_image_decomp_start(struct bootm_headers *images,
+				   int image_type, int comp, ulong load,
+				   ulong data, void *loadbuf, void *buf,
+				   ulong len, ulong max_len)
+{
+#ifndef USE_HOSTCC
+	if (images->decomp_job && image_type == IH_TYPE_LOADABLE &&
+	    !image_decomp_start(images->decomp_job, comp, load, data,
+				image_type, loadbuf, buf, len, max_len)) {
+		images->decomp_job = NULL;
+		return true;
+	}
+#endif
+
+	return false;
+}
+
 int fit_image_load(struct bootm_headers *images, ulong addr,
 		   const char **fit_unamep, const char **fit_uname_configp,
 		   int arch, int ph_type, int bootstage_id,
@@ -2117,13 +2375,19 @@ int fit_image_load(struct bootm_headers *images, ulong addr,
 			images->fit_uname_cfg = fit_base_uname_config;
 
 		if (FIT_IMAGE_ENABLE_VERIFY && images->verify) {
+			ulong start_us;
+
 			puts("   Verifying Hash Integrity ... ");
+			bootstage_pipe_image(fit_base_uname_config);
+			start_us = bootstage_pipe_start();
 			if (fit_config_verify(fit, cfg_noffset)) {
 				puts("Bad Data Hash\n");
 				bootstage_error(bootstage_id +
 					BOOTSTAGE_SUB_HASH);
 				return -EACCES;
 			}
+			bootstage_pipe_end(BOOTSTAGE_PIPE_VERIFY, start_us, 0,
+					   0);
 			puts("OK\n");
 		}
 
@@ -2140,6 +2404,7 @@ int fit_image_load(struct bootm_headers *images, ulong addr,
 	}
 
 	printf("   Trying '%s' %s subimage\n", fit_uname, prop_name);
+	bootstage_pipe_image(fit_uname);
 
 	ret = fit_image_select(fit, noffset, images->verify);
 	if (ret) {
@@ -2273,16 +2538,25 @@ int fit_image_load(struct bootm_headers *images, ulong addr,
 		} else {
 			loadbuf = map_sysmem(load, max_decomp_len);
 		}
-		if (image_decomp(comp, load, data, image_type,
+		if (fit_image_decomp_start(images, image_type, comp, load,
+					   data, loadbuf, buf, len,
+					   max_decomp_len)) {
+			/* The caller waits for this and works out the length */
+			len = 0;
+		} else if (image_decomp(comp, load, data, image_type,
 				loadbuf, buf, len, max_decomp_len, &load_end)) {
 			printf("Error decompressing %s\n", prop_name);
 
 			return -ENOEXEC;
+		} else {
+			len = load_end - load;
 		}
-		len = load_end - load;
 	} else if (load != data) {
+		ulong start_us = bootstage_pipe_start();
+
 		loadbuf = map_sysmem(load, len);
-		memcpy(loadbuf, buf, len);
+		memmove_wd(loadbuf, buf, len, CHUNKSZ);
+		bootstage_pipe_end(BOOTSTAGE_PIPE_COPY, start_us, len, 0);
 	}
 
 	if (image_type == IH_TYPE_RAMDISK && comp != IH_COMP_NONE)
@@ -2296,6 +2570,7 @@ int fit_image_load(struct bootm_headers *images, ulong addr,
 	}
 
 	bootstage_mark(bootstage_id + BOOTSTAGE_SUB_LOAD);
+	bootstage_pipe_image(NULL);
 
 	*datap = load;
 	*lenp = len;
@@ -2347,6 +2622,7 @@ int boot_get_fdt_fit(struct bootm_headers *images, ulong addr,
 	const char *uname;
 	void *base, *ov, *ovcopy = NULL;
 	int i, err, noffset, ov_noffset;
+	struct of_overlay_ctx ovctx = {};
 #endif
 
 	fit_uname = fit_unamep ? *fit_unamep : NULL;
@@ -2399,6 +2675,14 @@ int boot_get_fdt_fit(struct bootm_headers *images, ulong addr,
 	}
 
 	base = map_sysmem(load, len);
+	if (CONFIG_IS_ENABLED(OF_LIVE_OVERLAY)) {
+		err = of_overlay_begin(&ovctx, base);
+		if (err) {
+			printf("failed to set up overlays (err=%dE)\n", err);
+			fdt_noffset = err;
+			goto out;
+		}
+	}
 
 	/* apply extra configs in FIT first, followed by args */
 	for (i = 1; ; i++) {
@@ -2444,6 +2728,18 @@ int boot_get_fdt_fit(struct bootm_headers *images, ulong addr,
 				uname, ovload, ovlen);
 		ov = map_sysmem(ovload, ovlen);
 
+		/* this copies the overlay and flattens the tree at the end */
+		if (CONFIG_IS_ENABLED(OF_LIVE_OVERLAY)) {
+			err = of_overlay_apply(&ovctx, ov);
+			if (err) {
+				printf("failed to apply overlay %s (err=%dE)\n",
+				       uname, err);
+				fdt_noffset = err;
+				goto out;
+			}
+			continue;
+		}
+
 		ovcopylen = ALIGN(fdt_totalsize(ov), SZ_4K);
 		ovcopy = malloc(ovcopylen);
 		if (!ovcopy) {
@@ -2476,6 +2772,21 @@ int boot_get_fdt_fit(struct bootm_headers *images, ulong addr,
 		fdt_pack(base);
 		len = fdt_totalsize(base);
 	}
+	if (CONFIG_IS_ENABLED(OF_LIVE_OVERLAY)) {
+		struct abuf buf;
+
+		err = of_overlay_flatten(&ovctx, &buf);
+		/* the live tree refers to base, so free it before writing */
+		of_overlay_end(&ovctx);
+		if (err) {
+			printf("failed to flatten overlaid FDT (err=%dE)\n", err);
+			fdt_noffset = err;
+			goto out;
+		}
+		len = abuf_size(&buf);
+		memcpy(map_sysmem(load, len), abuf_data(&buf), len);
+		abuf_uninit(&buf);
+	}
 #else
 	printf("config with overlays but CONFIG_OF_LIBFDT_OVERLAY not set\n");
 	fdt_noffset = -EBADF;
@@ -2493,6 +2804,8 @@ out:
 
 #ifdef CONFIG_OF_LIBFDT_OVERLAY
 	free(ovcopy);
+	if (CONFIG_IS_ENABLED(OF_LIVE_OVERLAY))
+		of_overlay_end(&ovctx);
 #endif
 	free(fit_uname_config_copy);
 	return fdt_noffset;
@@ -54,6 +54,7 @@ DECLARE_GLOBAL_DATA_PTR;
 #endif /* !USE_HOSTCC*/
 
 #include <abuf.h>
+#include <bootstage.h>
 #include <bzlib.h>
 #include <display_options.h>
 #include <gzip.h>
@@ -445,30 +446,26 @@ int image_decomp_type(const unsigned char *buf, ulong len)
 	return cmagic->comp_id;
 }
 
-int image_decomp(int comp, ulong load, ulong image_start, int type,
-		 void *load_buf, void *image_buf, ulong image_len,
-		 uint unc_len, ulong *load_end)
+/**
+ * image_decomp_buf() - decompress an image held in memory
+ *
+ * @comp:	Compression algorithm that is used (IH_COMP_...), not
+ *		IH_COMP_NONE
+ * @load_buf:	Place to decompress to
+ * @image_buf:	Address to decompress from
+ * @image_lenp:	Number of bytes in @image_buf to decompress, updated to the
+ *		number of bytes decompressed
+ * @unc_len:	Available space for decompression
+ * Return: 0 if OK, -ENOSYS if @comp is not supported, other non-zero value on
+ *	error
+ */
+static int image_decomp_buf(int comp, void *load_buf, void *image_buf,
+			    ulong *image_lenp, uint unc_len)
 {
+	ulong image_len = *image_lenp;
 	int ret = -ENOSYS;
 
-	*load_end = load;
-	print_decomp_msg(comp, type, load == image_start, load);
-
-	/*
-	 * Load the image to the right place, decompressing if needed. After
-	 * this, image_len will be set to the number of uncompressed bytes
-	 * loaded, ret will be non-zero on error.
-	 */
 	switch (comp) {
-	case IH_COMP_NONE:
-		ret = 0;
-		if (load == image_start)
-			break;
-		if (image_len <= unc_len)
-			memmove_wd(load_buf, image_buf, image_len, CHUNKSZ);
-		else
-			ret = -ENOSPC;
-		break;
 	case IH_COMP_GZIP:
 		if (!tools_build() && CONFIG_IS_ENABLED(GZIP))
 			ret = gunzip(load_buf, unc_len, image_buf, &image_len);
@@ -526,18 +523,198 @@ int image_decomp(int comp, ulong load, ulong image_start, int type,
 		}
 		break;
 	}
+	*image_lenp = image_len;
+
+	return ret;
+}
+
+int image_decomp(int comp, ulong load, ulong image_start, int type,
+		 void *load_buf, void *image_buf, ulong image_len,
+		 uint unc_len, ulong *load_end)
+{
+	ulong start_us, in_len = image_len;
+	int ret;
+
+	*load_end = load;
+	print_decomp_msg(comp, type, load == image_start, load);
+	start_us = bootstage_pipe_start();
+
+	/*
+	 * Load the image to the right place, decompressing if needed. After
+	 * this, image_len will be set to the number of uncompressed bytes
+	 * loaded, ret will be non-zero on error.
+	 */
+	switch (comp) {
+	case IH_COMP_NONE:
+		ret = 0;
+		if (load == image_start)
+			break;
+		if (image_len <= unc_len)
+			memmove_wd(load_buf, image_buf, image_len, CHUNKSZ);
+		else
+			ret = -ENOSPC;
+		break;
+	default:
+		ret = image_decomp_buf(comp, load_buf, image_buf, &image_len,
+				       unc_len);
+		break;
+	}
 	if (ret == -ENOSYS) {
 		printf("Unimplemented compression type %d\n", comp);
 		return ret;
 	}
 	if (ret)
 		return ret;
+	if (comp != IH_COMP_NONE)
+		bootstage_pipe_end(BOOTSTAGE_PIPE_DECOMP, start_us, in_len,
+				   image_len);
+	else if (load != image_start)
+		bootstage_pipe_end(BOOTSTAGE_PIPE_COPY, start_us, in_len, 0);
 
 	*load_end = load + image_len;
 
 	return 0;
 }
 
+#ifndef USE_HOSTCC
+bool image_decomp_job_ok(int comp)
+{
+	/*
+	 * These decompressors only touch the buffers they are given, with no
+	 * malloc() and no calls to schedule()
+	 */
+	return (comp == IH_COMP_LZ4 && CONFIG_IS_ENABLED(LZ4)) ||
+		(comp == IH_COMP_LZO && CONFIG_IS_ENABLED(LZO));
+}
+
+static int image_decomp_job_run(struct cpu_job *job)
+{
+	struct image_decomp_job *dj = container_of(job, struct image_decomp_job,
+						   job);
+
+	return image_decomp_buf(dj->comp, dj->load_buf, dj->image_buf,
+				&dj->len, dj->unc_len);
+}
+
+int image_decomp_start(struct image_decomp_job *dj, int comp, ulong load,
+		       ulong image_start, int type, void *load_buf,
+		       void *image_buf, ulong image_len, uint unc_len)
+{
+	if (!image_decomp_job_ok(comp))
+		return -ENOSYS;
+
+	print_decomp_msg(comp, type, load == image_start, load);
+	dj->comp = comp;
+	dj->load = load;
+	dj->load_buf = load_buf;
+	dj->image_buf = image_buf;
+	dj->len = image_len;
+	dj->unc_len = unc_len;
+	dj->job.func = image_decomp_job_run;
+
+	return cpu_job_start(&dj->job);
+}
+
+int image_decomp_finish(struct image_decomp_job *dj, ulong *load_end)
+{
+	int ret;
+
+	ret = cpu_job_wait(&dj->job);
+	if (ret)
+		return ret;
+	*load_end = dj->load + dj->len;
+
+	return 0;
+}
+
+long image_reader_fill(struct image_reader *rd, void *buf, ulong size,
+		       ulong used, ulong *lenp)
+{
+	ulong len = *lenp - used;
+	ulong added = 0;
+	long ret;
+
+	memmove(buf, buf + used, len);
+	do {
+		ret = rd->read(rd, rd->offset, buf + len + added,
+			       size - len - added);
+		if (ret < 0)
+			return ret;
+		rd->offset += ret;
+		added += ret;
+	} while (ret && len + added < size);
+	*lenp = len + added;
+
+	return added;
+}
+
+/* Read an uncompressed image straight to its destination */
+static int image_read_plain(void *load_buf, ulong unc_len,
+			    struct image_reader *rd, ulong *lenp)
+{
+	ulong len = 0;
+	char extra;
+	long ret;
+
+	do {
+		ret = rd->read(rd, len, load_buf + len, unc_len - len);
+		if (ret < 0)
+			return ret;
+		len += ret;
+	} while (ret && len < unc_len);
+	*lenp = len;
+
+	/* Check whether there is more which would not fit */
+	if (len == unc_len) {
+		ret = rd->read(rd, len, &extra, 1);
+		if (ret)
+			return ret < 0 ? ret : -ENOSPC;
+	}
+
+	return 0;
+}
+
+int image_decomp_stream(int comp, void *load_buf, ulong unc_len,
+			struct image_reader *rd, ulong *lenp)
+{
+	int ret = -ENOSYS;
+
+	*lenp = 0;
+	rd->offset = 0;
+	switch (comp) {
+	case IH_COMP_NONE:
+		ret = image_read_plain(load_buf, unc_len, rd, lenp);
+		break;
+	case IH_COMP_GZIP:
+		if (CONFIG_IS_ENABLED(GZIP))
+			ret = gunzip_read(load_buf, unc_len, rd, lenp);
+		break;
+	case IH_COMP_LZ4:
+		if (CONFIG_IS_ENABLED(LZ4)) {
+			size_t size = unc_len;
+
+			ret = ulz4fn_read(rd, load_buf, &size);
+			*lenp = size;
+		}
+		break;
+	case IH_COMP_ZSTD:
+		if (CONFIG_IS_ENABLED(ZSTD)) {
+			struct abuf out;
+
+			abuf_init_set(&out, load_buf, unc_len);
+			ret = zstd_decompress_read(rd, &out);
+			if (ret >= 0) {
+				*lenp = ret;
+				ret = 0;
+			}
+		}
+		break;
+	}
+
+	return ret;
+}
+#endif
+
 const table_entry_t *get_table_entry(const table_entry_t *table, int id)
 {
 	for (; table->id >= 0; ++table) {
@@ -80,6 +80,37 @@ int format_mac_pxe(char *outbuf, size_t outbuf_len)
 	return 1;
 }
 
+/**
+ * get_relpath() - Work out the path of a file relative to the PXE file
+ *
+ * @ctx: PXE context
+ * @file_path: File path to process (relative to the PXE file)
+ * @relfile: Returns the full path; must hold MAX_TFTP_PATH_LEN + 1 bytes
+ * Returns 0 if OK, -ENAMETOOLONG if the path is too long
+ */
+static int get_relpath(struct pxe_context *ctx, const char *file_path,
+		       char *relfile)
+{
+	size_t path_len;
+
+	if (file_path[0] == '/' && ctx->allow_abs_path)
+		*relfile = '\0';
+	else
+		strncpy(relfile, ctx->bootdir, MAX_TFTP_PATH_LEN);
+
+	path_len = strlen(file_path) + strlen(relfile);
+
+	if (path_len > MAX_TFTP_PATH_LEN) {
+		printf("Base path too long (%s%s)\n", relfile, file_path);
+
+		return -ENAMETOOLONG;
+	}
+
+	strcat(relfile, file_path);
+
+	return 0;
+}
+
 /**
  * get_relfile() - read a file relative to the PXE file
  *
@@ -97,26 +128,14 @@ int format_mac_pxe(char *outbuf, size_t outbuf_len)
 static int get_relfile(struct pxe_context *ctx, const char *file_path,
 		       unsigned long file_addr, ulong *filesizep)
 {
-	size_t path_len;
 	char relfile[MAX_TFTP_PATH_LEN + 1];
 	char addr_buf[18];
 	ulong size;
 	int ret;
 
-	if (file_path[0] == '/' && ctx->allow_abs_path)
-		*relfile = '\0';
-	else
-		strncpy(relfile, ctx->bootdir, MAX_TFTP_PATH_LEN);
-
-	path_len = strlen(file_path) + strlen(relfile);
-
-	if (path_len > MAX_TFTP_PATH_LEN) {
-		printf("Base path too long (%s%s)\n", relfile, file_path);
-
-		return -ENAMETOOLONG;
-	}
-
-	strcat(relfile, file_path);
+	ret = get_relpath(ctx, file_path, relfile);
+	if (ret)
+		return ret;
 
 	printf("Retrieving file: %s\n", relfile);
 
@@ -218,6 +237,52 @@ static int get_relfile_envaddr(struct pxe_context *ctx, const char *file_path,
 	return get_relfile(ctx, file_path, file_addr, filesizep);
 }
 
+/**
+ * get_kernel_final_addr() - Work out where booti will want a kernel
+ *
+ * booti moves an Image to the address required by its header if it is not
+ * there already. Read just the header to find that address, so the kernel
+ * can be loaded there in the first place and the copy is avoided.
+ *
+ * @ctx: PXE context
+ * @file_path: Path to the kernel (relative to the PXE file)
+ * @addr: Address to read the header to
+ * @finalp: Returns the address to load the kernel to
+ * Returns 0 if OK, -ENOSYS if the header cannot be read on its own, -ENOENT
+ *	if the kernel is not an uncompressed booti Image, or other value < 0 on
+ *	other error
+ */
+static int get_kernel_final_addr(struct pxe_context *ctx,
+				 const char *file_path, ulong addr,
+				 ulong *finalp)
+{
+	char relfile[MAX_TFTP_PATH_LEN + 1];
+	ulong size;
+	void *buf;
+	bool ok;
+	int ret;
+
+	if (!IS_ENABLED(CONFIG_PXE_KERNEL_DIRECT_LOAD) || !ctx->gethead)
+		return -ENOSYS;
+
+	ret = get_relpath(ctx, file_path, relfile);
+	if (ret)
+		return ret;
+	ret = ctx->gethead(ctx, relfile, addr, BOOTI_HEADER_SIZE);
+	if (ret)
+		return log_msg_ret("hdr", ret);
+
+	/* Leave anything which booti does not handle as it is */
+	buf = map_sysmem(addr, BOOTI_HEADER_SIZE);
+	ok = genimg_get_format(buf) == IMAGE_FORMAT_INVALID &&
+		image_decomp_type(buf, BOOTI_HEADER_SIZE) == IH_COMP_NONE;
+	unmap_sysmem(buf);
+	if (!ok || booti_setup(addr, finalp, &size, false))
+		return -ENOENT;
+
+	return 0;
+}
+
 /**
  * label_create() - crate a new PXE label
  *
@@ -473,7 +538,8 @@ skip_overlay:
  * returns.
  *
  * The kernel will be stored in the location given by the 'kernel_addr_r'
- * environment variable.
+ * environment variable. With CONFIG_PXE_KERNEL_DIRECT_LOAD, a booti Image is
+ * instead stored where booti would otherwise move it to.
  *
  * If the label specifies an initrd file, it will be stored in the location
  * given by the 'ramdisk_addr_r' environment variable.
@@ -501,7 +567,10 @@ static int label_boot(struct pxe_context *ctx, struct pxe_label *label)
 	int zboot_argc = 3;
 	int len = 0;
 	ulong kernel_addr_r;
+	ulong final_addr;
+	char final_str[18];
 	void *buf;
+	int ret;
 
 	label_print(label);
 
@@ -519,14 +588,26 @@ static int label_boot(struct pxe_context *ctx, struct pxe_label *label)
 		return 1;
 	}
 
-	if (get_relfile_envaddr(ctx, label->kernel, "kernel_addr_r",
-				NULL) < 0) {
+	kernel_addr = env_get("kernel_addr_r");
+	if (!label->config && kernel_addr &&
+	    !strict_strtoul(kernel_addr, 16, &kernel_addr_r) &&
+	    !get_kernel_final_addr(ctx, label->kernel, kernel_addr_r,
+				   &final_addr) &&
+	    final_addr != kernel_addr_r) {
+		snprintf(final_str, sizeof(final_str), "%lx", final_addr);
+		kernel_addr = final_str;
+		ret = get_relfile(ctx, label->kernel, final_addr, NULL);
+	} else {
+		ret = get_relfile_envaddr(ctx, label->kernel, "kernel_addr_r",
+					  NULL);
+		kernel_addr = env_get("kernel_addr_r");
+	}
+	if (ret < 0) {
 		printf("Skipping %s for failure retrieving kernel\n",
 		       label->name);
 		return 1;
 	}
 
-	kernel_addr = env_get("kernel_addr_r");
 	/* for FIT, append the configuration identifier */
 	if (label->config) {
 		int len = strlen(kernel_addr) + strlen(label->config) + 1;
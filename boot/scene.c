@@ -18,6 +18,9 @@
 #include <linux/input.h>
 #include "scene_internal.h"
 
+/* Most areas to redraw separately before giving up and redrawing everything */
+#define SCENE_MAX_DIRTY		16
+
 int scene_new(struct expo *exp, const char *name, uint id, struct scene **scnp)
 {
 	struct scene *scn;
@@ -567,6 +570,276 @@ int scene_render(struct scene *scn)
 		if (ret && ret != -ENOTSUPP)
 			return log_msg_ret("dep", ret);
 	}
+	if (!exp->text_mode)
+		scene_mark_drawn(scn);
+
+	return 0;
+}
+
+/**
+ * scene_sig_add() - Add a value to an object signature
+ *
+ * @sig: Signature so far
+ * @val: Value to add
+ * Return: updated signature
+ */
+static u32 scene_sig_add(u32 sig, ulong val)
+{
+	return sig * 31 + val;
+}
+
+/**
+ * scene_obj_sig() - Work out the signature of an object's current state
+ *
+ * This covers everything which affects how the object is drawn, so that a
+ * change in the signature means that the object must be redrawn
+ *
+ * @obj: Object to check
+ * Return: signature
+ */
+static u32 scene_obj_sig(struct scene_obj *obj)
+{
+	struct expo *exp = obj->scene->expo;
+	u32 sig;
+
+	sig = scene_sig_add(obj->type, obj->flags & ~SCENEOF_REDRAW);
+	sig = scene_sig_add(sig, obj->dim.x);
+	sig = scene_sig_add(sig, obj->dim.y);
+	sig = scene_sig_add(sig, obj->dim.w);
+	sig = scene_sig_add(sig, obj->dim.h);
+
+	switch (obj->type) {
+	case SCENEOBJT_NONE:
+		break;
+	case SCENEOBJT_IMAGE: {
+		struct scene_obj_img *img = (struct scene_obj_img *)obj;
+
+		sig = scene_sig_add(sig, (ulong)img->data);
+		break;
+	}
+	case SCENEOBJT_TEXT: {
+		struct scene_obj_txt *txt = (struct scene_obj_txt *)obj;
+		const char *str;
+
+		sig = scene_sig_add(sig, (ulong)txt->font_name);
+		sig = scene_sig_add(sig, txt->font_size);
+		str = expo_get_str(exp, txt->str_id);
+		if (str) {
+			for (; *str; str++)
+				sig = scene_sig_add(sig, *str);
+		}
+		break;
+	}
+	case SCENEOBJT_MENU: {
+		struct scene_obj_menu *menu = (struct scene_obj_menu *)obj;
+
+		sig = scene_sig_add(sig, menu->cur_item_id);
+		sig = scene_sig_add(sig, exp->popup);
+		break;
+	}
+	case SCENEOBJT_TEXTLINE:
+		/* the cursor is drawn while the line is being edited */
+		if (obj->flags & SCENEOF_OPEN) {
+			sig = scene_sig_add(sig, obj->scene->cls.num);
+			sig = scene_sig_add(sig, obj->scene->cls.eol_num);
+		}
+		break;
+	}
+
+	return sig;
+}
+
+/**
+ * scene_obj_area() - Work out the area of the display covered by an object
+ *
+ * This errs on the large side, since anything drawn outside the area will not
+ * be erased when the object changes
+ *
+ * @obj: Object to check
+ * @area: Returns the area, with a width and height of 0 if nothing is drawn
+ */
+static void scene_obj_area(struct scene_obj *obj, struct scene_dim *area)
+{
+	struct scene *scn = obj->scene;
+	const struct expo_theme *theme = &scn->expo->theme;
+	struct vidconsole_bbox bbox, label_bbox;
+	int x0, y0, x1, y1;
+	int width, height;
+
+	if (obj->flags & SCENEOF_HIDE) {
+		memset(area, '\0', sizeof(*area));
+		return;
+	}
+	x0 = obj->dim.x;
+	y0 = obj->dim.y;
+	x1 = x0 + obj->dim.w;
+	y1 = y0 + obj->dim.h;
+
+	switch (obj->type) {
+	case SCENEOBJT_NONE:
+		break;
+	case SCENEOBJT_IMAGE:
+	case SCENEOBJT_TEXT:
+		/* the content may be larger than the dimensions suggest */
+		height = scene_obj_get_hw(scn, obj->id, &width);
+		if (height > 0) {
+			x1 = max(x1, x0 + width);
+			y1 = max(y1, y0 + height);
+		}
+		if (obj->flags & SCENEOF_POINT)
+			x0 -= theme->menu_inset;
+		break;
+	case SCENEOBJT_MENU:
+	case SCENEOBJT_TEXTLINE:
+		if (!scene_obj_calc_bbox(obj, &bbox, &label_bbox) &&
+		    label_bbox.valid) {
+			x0 = min(x0, label_bbox.x0 - (int)theme->menu_inset);
+			y0 = min(y0, label_bbox.y0 - (int)theme->menu_inset);
+			x1 = max(x1, label_bbox.x1 + (int)theme->menu_inset);
+			y1 = max(y1, label_bbox.y1 + (int)theme->menu_inset);
+		}
+		break;
+	}
+	area->x = x0;
+	area->y = y0;
+	area->w = max(x1 - x0, 0);
+	area->h = max(y1 - y0, 0);
+}
+
+static bool scene_dim_overlap(const struct scene_dim *a,
+			      const struct scene_dim *b)
+{
+	return a->w && a->h && b->w && b->h &&
+		a->x < b->x + b->w && b->x < a->x + a->w &&
+		a->y < b->y + b->h && b->y < a->y + a->h;
+}
+
+void scene_mark_drawn(struct scene *scn)
+{
+	struct scene_obj *obj;
+
+	list_for_each_entry(obj, &scn->obj_head, sibling) {
+		obj->flags &= ~SCENEOF_REDRAW;
+		scene_obj_area(obj, &obj->drawn);
+		obj->drawn_sig = scene_obj_sig(obj);
+	}
+	scn->drawn_highlight_id = scn->highlight_id;
+}
+
+/**
+ * scene_add_dirty() - Add an area to the list of areas to redraw
+ *
+ * The area is clipped to the display and ignored if it is empty
+ *
+ * @scn: Scene being rendered
+ * @dirty: List of areas
+ * @countp: Number of areas in the list, updated on success
+ * @area: Area to add
+ * Return: 0 if OK, -E2BIG if the list is full
+ */
+static int scene_add_dirty(struct scene *scn, struct scene_dim *dirty,
+			   int *countp, const struct scene_dim *area)
+{
+	struct video_priv *vid_priv = dev_get_uclass_priv(scn->expo->display);
+	int x0, y0, x1, y1;
+
+	x0 = max(area->x, 0);
+	y0 = max(area->y, 0);
+	x1 = min(area->x + area->w, (int)vid_priv->xsize);
+	y1 = min(area->y + area->h, (int)vid_priv->ysize);
+	if (x0 >= x1 || y0 >= y1)
+		return 0;
+	if (*countp == SCENE_MAX_DIRTY)
+		return -E2BIG;
+	dirty[*countp].x = x0;
+	dirty[*countp].y = y0;
+	dirty[*countp].w = x1 - x0;
+	dirty[*countp].h = y1 - y0;
+	(*countp)++;
+
+	return 0;
+}
+
+int scene_render_update(struct scene *scn, u32 colour)
+{
+	struct scene_dim dirty[SCENE_MAX_DIRTY];
+	struct expo *exp = scn->expo;
+	struct scene_obj *obj, *prev;
+	struct scene_dim area;
+	int count = 0;
+	int i, ret;
+
+	/* redraw the old and new position of anything which has changed */
+	list_for_each_entry(obj, &scn->obj_head, sibling) {
+		scene_obj_area(obj, &area);
+		if (scene_obj_sig(obj) == obj->drawn_sig &&
+		    !memcmp(&area, &obj->drawn, sizeof(area)))
+			continue;
+		if (scene_add_dirty(scn, dirty, &count, &obj->drawn) ||
+		    scene_add_dirty(scn, dirty, &count, &area))
+			return -E2BIG;
+	}
+
+	/* the highlighted object is drawn on top, so moving it matters too */
+	if (scn->highlight_id != scn->drawn_highlight_id) {
+		obj = scene_obj_find(scn, scn->drawn_highlight_id,
+				     SCENEOBJT_NONE);
+		if (obj && scene_add_dirty(scn, dirty, &count, &obj->drawn))
+			return -E2BIG;
+		obj = scene_obj_find(scn, scn->highlight_id, SCENEOBJT_NONE);
+		if (obj) {
+			scene_obj_area(obj, &area);
+			if (scene_add_dirty(scn, dirty, &count, &area))
+				return -E2BIG;
+		}
+	}
+	if (!count)
+		return 0;
+	log_debug("Redrawing %d areas\n", count);
+
+	for (i = 0; i < count; i++) {
+		ret = video_fill_part(exp->display, dirty[i].x, dirty[i].y,
+				      dirty[i].x + dirty[i].w,
+				      dirty[i].y + dirty[i].h, colour);
+		if (ret)
+			return log_msg_ret("fil", ret);
+	}
+
+	/*
+	 * Redraw everything which touches a cleared area, in the normal order.
+	 * An object drawn over one of those must be redrawn too, since it may
+	 * have been partly overwritten.
+	 */
+	list_for_each_entry(obj, &scn->obj_head, sibling) {
+		bool redraw = false;
+
+		if (obj->flags & SCENEOF_HIDE)
+			continue;
+		scene_obj_area(obj, &area);
+		for (i = 0; !redraw && i < count; i++)
+			redraw = scene_dim_overlap(&area, &dirty[i]);
+		list_for_each_entry(prev, &scn->obj_head, sibling) {
+			if (redraw || prev == obj)
+				break;
+			if (prev->flags & SCENEOF_REDRAW)
+				redraw = scene_dim_overlap(&area, &prev->drawn);
+		}
+		if (!redraw)
+			continue;
+
+		obj->flags |= SCENEOF_REDRAW;
+		obj->drawn = area;
+		ret = scene_obj_render(obj, false);
+		if (ret && ret != -ENOTSUPP)
+			return log_msg_ret("ren", ret);
+	}
+
+	if (scn->highlight_id) {
+		ret = scene_render_deps(scn, scn->highlight_id);
+		if (ret && ret != -ENOTSUPP)
+			return log_msg_ret("dep", ret);
+	}
+	scene_mark_drawn(scn);
 
 	return 0;
 }
@@ -179,6 +179,30 @@ void scene_destroy(struct scene *scn);
  */
 int scene_render(struct scene *scn);
 
+/**
+ * scene_render_update() - Redraw the parts of a scene which have changed
+ *
+ * This is called from expo_render() when the scene is already on the display.
+ * Areas which have changed since the last render are filled with the
+ * background colour, then the objects touching them are drawn again.
+ *
+ * @scn: Scene to render
+ * @colour: Background colour for the display
+ * Returns: 0 if OK, -E2BIG if too much has changed, so the whole scene should
+ * be redrawn instead, other -ve on error
+ */
+int scene_render_update(struct scene *scn, u32 colour);
+
+/**
+ * scene_mark_drawn() - Record the current state of a scene as drawn
+ *
+ * This notes the position and state of each object, so that
+ * scene_render_update() can tell what has changed
+ *
+ * @scn: Scene which has been rendered
+ */
+void scene_mark_drawn(struct scene *scn);
+
 /**
  * scene_send_key() - set a keypress to a scene
  *
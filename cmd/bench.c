@@ -0,0 +1,287 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Throughput benchmarks for memory, storage, network, hashing and
+ * decompression
+ *
+ * All results are reported in MB/s (10^6 bytes per second) so that they can
+ * be compared between boards and releases.
+ */
+
+#include <blk.h>
+#include <command.h>
+#include <env.h>
+#include <fs.h>
+#include <hash.h>
+#include <image.h>
+#include <mapmem.h>
+#include <time.h>
+#include <vsprintf.h>
+#include <linux/math64.h>
+#include <linux/sizes.h>
+
+/* Repeat short tests until they have run for at least this long */
+#define BENCH_MIN_US		(200 * 1000)
+
+/* Default amount of data to use for each test */
+#define BENCH_DEFAULT_SIZE	SZ_16M
+
+/* Transfer sizes used for block reads */
+static const ulong bench_blk_sizes[] = {
+	SZ_4K, SZ_16K, SZ_64K, SZ_256K, SZ_1M, SZ_4M,
+};
+
+/**
+ * bench_show() - Show the result of a test
+ *
+ * @name: Name of the test
+ * @size: Transfer size to show, or 0 if not relevant
+ * @bytes: Number of bytes processed
+ * @us: Time taken in microseconds
+ */
+static void bench_show(const char *name, ulong size, u64 bytes, ulong us)
+{
+	char detail[20] = "";
+	ulong rate;
+
+	if (size >= SZ_1M && !(size % SZ_1M))
+		snprintf(detail, sizeof(detail), "%lu MiB", size / SZ_1M);
+	else if (size >= SZ_1K && !(size % SZ_1K))
+		snprintf(detail, sizeof(detail), "%lu KiB", size / SZ_1K);
+	else if (size)
+		snprintf(detail, sizeof(detail), "%lu B", size);
+
+	/* Bytes per microsecond is MB/s; keep two decimal places */
+	rate = us ? div_u64(bytes * 100, us) : 0;
+	printf("%-14s %-8s %7lu.%02lu MB/s\n", name, detail, rate / 100,
+	       rate % 100);
+}
+
+/* Get a size argument, or the default if not provided */
+static ulong bench_get_size(int argc, char *const argv[], int arg)
+{
+	return argc > arg ? hextoul(argv[arg], NULL) : BENCH_DEFAULT_SIZE;
+}
+
+static int do_bench_mem(struct cmd_tbl *cmdtp, int flag, int argc,
+			char *const argv[])
+{
+	ulong size = bench_get_size(argc, argv, 1);
+	ulong start, us;
+	void *src, *dst;
+	u64 bytes;
+
+	if (!size)
+		return CMD_RET_USAGE;
+	src = map_sysmem(image_load_addr, size * 2);
+	dst = src + size;
+
+	start = timer_get_us();
+	for (bytes = 0; us = timer_get_us() - start, us < BENCH_MIN_US;
+	     bytes += size)
+		memset(dst, bytes & 0xff, size);
+	bench_show("memset", size, bytes, us);
+
+	start = timer_get_us();
+	for (bytes = 0; us = timer_get_us() - start, us < BENCH_MIN_US;
+	     bytes += size)
+		memcpy(dst, src, size);
+	bench_show("memcpy", size, bytes, us);
+	unmap_sysmem(src);
+
+	return 0;
+}
+
+#if CONFIG_IS_ENABLED(HASH)
+static int do_bench_hash(struct cmd_tbl *cmdtp, int flag, int argc,
+			 char *const argv[])
+{
+	u8 output[HASH_MAX_DIGEST_SIZE];
+	struct hash_algo *algo;
+	ulong size, start, us;
+	void *buf;
+	u64 bytes;
+
+	if (argc < 2)
+		return CMD_RET_USAGE;
+	if (hash_lookup_algo(argv[1], &algo)) {
+		printf("Unknown hash algorithm '%s'\n", argv[1]);
+		return CMD_RET_FAILURE;
+	}
+	size = bench_get_size(argc, argv, 2);
+	buf = map_sysmem(image_load_addr, size);
+
+	start = timer_get_us();
+	for (bytes = 0; us = timer_get_us() - start, us < BENCH_MIN_US;
+	     bytes += size)
+		algo->hash_func_ws(buf, size, output, algo->chunk_size);
+	bench_show(algo->name, size, bytes, us);
+	unmap_sysmem(buf);
+
+	return 0;
+}
+#endif
+
+static int do_bench_unzip(struct cmd_tbl *cmdtp, int flag, int argc,
+			  char *const argv[])
+{
+	ulong src, len, dst, dst_len, load_end, start, us;
+	int comp, ret;
+
+	if (argc < 4)
+		return CMD_RET_USAGE;
+	comp = genimg_get_comp_id(argv[1]);
+	if (comp < 0) {
+		printf("Unknown compression '%s'\n", argv[1]);
+		return CMD_RET_FAILURE;
+	}
+	src = hextoul(argv[2], NULL);
+	len = hextoul(argv[3], NULL);
+	dst = argc > 4 ? hextoul(argv[4], NULL) : image_load_addr;
+	dst_len = argc > 5 ? hextoul(argv[5], NULL) : SZ_64M;
+
+	start = timer_get_us();
+	ret = image_decomp(comp, dst, src, IH_TYPE_FIRMWARE,
+			   map_sysmem(dst, dst_len), map_sysmem(src, len), len,
+			   dst_len, &load_end);
+	us = timer_get_us() - start;
+	if (ret) {
+		printf("Decompression failed (err=%d)\n", ret);
+		return CMD_RET_FAILURE;
+	}
+	bench_show(genimg_get_comp_short_name(comp), 0, load_end - dst, us);
+
+	return 0;
+}
+
+#if CONFIG_IS_ENABLED(BLK)
+static int do_bench_blk(struct cmd_tbl *cmdtp, int flag, int argc,
+			char *const argv[])
+{
+	struct blk_desc *desc;
+	ulong total, start, us;
+	lbaint_t blk, max_blks;
+	void *buf;
+	int i;
+
+	if (argc < 3)
+		return CMD_RET_USAGE;
+	desc = blk_get_devnum_by_uclass_idname(argv[1],
+					       dectoul(argv[2], NULL));
+	if (!desc) {
+		printf("Cannot find %s device %s\n", argv[1], argv[2]);
+		return CMD_RET_FAILURE;
+	}
+	blk = argc > 3 ? hextoul(argv[3], NULL) : 0;
+	total = bench_get_size(argc, argv, 4);
+	if (blk >= desc->lba)
+		return CMD_RET_USAGE;
+	max_blks = desc->lba - blk;
+	if (total / desc->blksz > max_blks)
+		total = max_blks * desc->blksz;
+	buf = map_sysmem(image_load_addr, bench_blk_sizes[
+			 ARRAY_SIZE(bench_blk_sizes) - 1]);
+
+	for (i = 0; i < ARRAY_SIZE(bench_blk_sizes); i++) {
+		ulong size = bench_blk_sizes[i];
+		lbaint_t cnt = size / desc->blksz;
+		lbaint_t todo = total / size * cnt;
+		lbaint_t done;
+
+		if (!cnt || !todo)
+			break;
+		start = timer_get_us();
+		for (done = 0; done < todo; done += cnt) {
+			if (blk_dread(desc, blk + done, cnt, buf) != cnt) {
+				printf("Read error at block " LBAF "\n",
+				       blk + done);
+				unmap_sysmem(buf);
+				return CMD_RET_FAILURE;
+			}
+		}
+		us = timer_get_us() - start;
+		bench_show("blk read", size, (u64)todo * desc->blksz, us);
+	}
+	unmap_sysmem(buf);
+
+	return 0;
+}
+
+static int do_bench_fs(struct cmd_tbl *cmdtp, int flag, int argc,
+		       char *const argv[])
+{
+	ulong start, us;
+	loff_t actread;
+	int ret;
+
+	if (argc < 4)
+		return CMD_RET_USAGE;
+	if (fs_set_blk_dev(argv[1], argv[2], FS_TYPE_ANY))
+		return CMD_RET_FAILURE;
+
+	start = timer_get_us();
+	ret = fs_read(argv[3], image_load_addr, 0, 0, &actread);
+	us = timer_get_us() - start;
+	if (ret) {
+		printf("Cannot read '%s' (err=%d)\n", argv[3], ret);
+		return CMD_RET_FAILURE;
+	}
+	bench_show("fs read", 0, actread, us);
+
+	return 0;
+}
+#endif
+
+#if CONFIG_IS_ENABLED(CMD_TFTPBOOT)
+static int do_bench_tftp(struct cmd_tbl *cmdtp, int flag, int argc,
+			 char *const argv[])
+{
+	ulong start, us;
+	int ret;
+
+	start = timer_get_us();
+	if (argc > 1)
+		ret = run_commandf("tftpboot %lx %s", image_load_addr, argv[1]);
+	else
+		ret = run_commandf("tftpboot %lx", image_load_addr);
+	us = timer_get_us() - start;
+	if (ret)
+		return CMD_RET_FAILURE;
+	bench_show("tftp", 0, env_get_hex("filesize", 0), us);
+
+	return 0;
+}
+#endif
+
+U_BOOT_LONGHELP(bench,
+	"mem [<size>]                  - memset/memcpy bandwidth\n"
+#if CONFIG_IS_ENABLED(HASH)
+	"bench hash <algo> [<size>]          - hashing throughput\n"
+#endif
+	"bench unzip <comp> <addr> <len> [<dst> [<dstlen>]]\n"
+	"                                    - decompression throughput\n"
+#if CONFIG_IS_ENABLED(BLK)
+	"bench blk <if> <dev> [<blk> [<size>]] - raw block read throughput at\n"
+	"                                    various transfer sizes\n"
+	"bench fs <if> <dev[:part]> <file>   - filesystem read throughput\n"
+#endif
+#if CONFIG_IS_ENABLED(CMD_TFTPBOOT)
+	"bench tftp [<file>]                 - TFTP download throughput\n"
+#endif
+	"\n"
+	"Sizes are in hex and default to 16MiB. Memory at $loadaddr is used\n"
+	"as a buffer and is overwritten.");
+
+U_BOOT_CMD_WITH_SUBCMDS(bench, "Measure throughput in MB/s", bench_help_text,
+	U_BOOT_SUBCMD_MKENT(mem, 2, 1, do_bench_mem),
+#if CONFIG_IS_ENABLED(HASH)
+	U_BOOT_SUBCMD_MKENT(hash, 3, 1, do_bench_hash),
+#endif
+	U_BOOT_SUBCMD_MKENT(unzip, 6, 1, do_bench_unzip),
+#if CONFIG_IS_ENABLED(BLK)
+	U_BOOT_SUBCMD_MKENT(blk, 5, 1, do_bench_blk),
+	U_BOOT_SUBCMD_MKENT(fs, 4, 1, do_bench_fs),
+#endif
+#if CONFIG_IS_ENABLED(CMD_TFTPBOOT)
+	U_BOOT_SUBCMD_MKENT(tftp, 2, 1, do_bench_tftp),
+#endif
+	);
@@ -182,6 +182,9 @@ static int do_bootflow_scan(struct cmd_tbl *cmdtp, int flag, int argc,
 		flags |= BOOTFLOWIF_SKIP_GLOBAL;
 	if (!no_hunter)
 		flags |= BOOTFLOWIF_HUNT;
+	if (IS_ENABLED(CONFIG_BOOTSTD_CACHE) && boot && !menu && !dev &&
+	    !label)
+		flags |= BOOTFLOWIF_CACHE;
 
 	/*
 	 * If we have a device, just scan for bootflows attached to that device
@@ -80,7 +80,8 @@ static int booti_start(struct bootm_info *bmi)
 	if (relocated_addr != ld) {
 		printf("Moving Image from 0x%lx to 0x%lx, end=%lx\n", ld,
 		       relocated_addr, relocated_addr + image_size);
-		memmove((void *)relocated_addr, (void *)ld, image_size);
+		memmove_wd((void *)relocated_addr, (void *)ld, image_size,
+			   CHUNKSZ);
 	}
 
 	images->ep = relocated_addr;
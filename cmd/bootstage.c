@@ -15,6 +15,30 @@ static int do_bootstage_report(struct cmd_tbl *cmdtp, int flag, int argc,
 	return 0;
 }
 
+#if CONFIG_IS_ENABLED(BOOTSTAGE_PROFILE)
+static int do_bootstage_prof(struct cmd_tbl *cmdtp, int flag, int argc,
+			     char *const argv[])
+{
+	int count = 10;
+
+	if (argc > 1)
+		count = dectoul(argv[1], NULL);
+	bootstage_prof_report(count);
+
+	return 0;
+}
+#endif
+
+#if CONFIG_IS_ENABLED(BOOTSTAGE_PIPELINE)
+static int do_bootstage_pipeline(struct cmd_tbl *cmdtp, int flag, int argc,
+				 char *const argv[])
+{
+	bootstage_pipe_report();
+
+	return 0;
+}
+#endif
+
 static int get_base_size(int argc, char *const argv[], ulong *basep,
 			 ulong *sizep)
 {
@@ -61,6 +85,12 @@ static int do_bootstage_stash(struct cmd_tbl *cmdtp, int flag, int argc,
 
 static struct cmd_tbl cmd_bootstage_sub[] = {
 	U_BOOT_CMD_MKENT(report, 2, 1, do_bootstage_report, "", ""),
+#if CONFIG_IS_ENABLED(BOOTSTAGE_PROFILE)
+	U_BOOT_CMD_MKENT(prof, 2, 1, do_bootstage_prof, "", ""),
+#endif
+#if CONFIG_IS_ENABLED(BOOTSTAGE_PIPELINE)
+	U_BOOT_CMD_MKENT(pipeline, 1, 1, do_bootstage_pipeline, "", ""),
+#endif
 	U_BOOT_CMD_MKENT(stash, 4, 0, do_bootstage_stash, "", ""),
 	U_BOOT_CMD_MKENT(unstash, 4, 0, do_bootstage_stash, "", ""),
 };
@@ -91,6 +121,12 @@ U_BOOT_CMD(bootstage, 4, 1, do_boostage,
 	"Boot stage command",
 	" - check boot progress and timing\n"
 	"report                      - Print a report\n"
+#if CONFIG_IS_ENABLED(BOOTSTAGE_PROFILE)
+	"prof [<count>]              - Print the slowest probes/initcalls\n"
+#endif
+#if CONFIG_IS_ENABLED(BOOTSTAGE_PIPELINE)
+	"pipeline                    - Print time/throughput of image loading\n"
+#endif
 	"stash [<start> [<size>]]    - Stash data into memory\n"
 	"unstash [<start> [<size>]]  - Unstash data from memory"
 );
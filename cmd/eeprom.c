@@ -84,7 +84,7 @@ static int eeprom_addr(unsigned dev_addr, unsigned offset, uchar *addr)
 	return alen;
 }
 
-static int eeprom_len(unsigned offset, unsigned end)
+static int eeprom_len(unsigned offset, unsigned end, bool read)
 {
 	unsigned len = end - offset;
 
@@ -97,6 +97,14 @@ static int eeprom_len(unsigned offset, unsigned end)
 	unsigned blk_off = offset & 0xff;
 	unsigned maxlen = EEPROM_PAGE_SIZE - EEPROM_PAGE_OFFSET(blk_off);
 
+	/*
+	 * Only writes are limited to a page. A read can continue to the end
+	 * of the block, since eeprom_addr() may change the device address
+	 * for the next one.
+	 */
+	if (read)
+		maxlen = 0x100 - blk_off;
+
 	if (maxlen > I2C_RXTX_LEN)
 		maxlen = I2C_RXTX_LEN;
 
@@ -156,7 +164,7 @@ static int eeprom_rw(unsigned dev_addr, unsigned offset, uchar *buffer,
 	while (offset < end) {
 		alen = eeprom_addr(dev_addr, offset, addr);
 
-		len = eeprom_len(offset, end);
+		len = eeprom_len(offset, end, read);
 
 		rcode = eeprom_rw_block(offset, addr, alen, buffer, len, read);
 
@@ -175,9 +183,9 @@ static int eeprom_rw(unsigned dev_addr, unsigned offset, uchar *buffer,
 int eeprom_read(unsigned dev_addr, unsigned offset, uchar *buffer, unsigned cnt)
 {
 	/*
-	 * Read data until done or would cross a page boundary.
-	 * We must write the address again when changing pages
-	 * because the next page may be in a different device.
+	 * Read data until done or would cross a block boundary.
+	 * We must write the address again when changing blocks
+	 * because the next block may be in a different device.
 	 */
 	return eeprom_rw(dev_addr, offset, buffer, cnt, 1);
 }
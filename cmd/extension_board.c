@@ -4,18 +4,29 @@
  * Köry Maincent, Bootlin, <kory.maincent@bootlin.com>
  */
 
+#include <abuf.h>
 #include <bootdev.h>
 #include <command.h>
 #include <dm.h>
 #include <malloc.h>
 #include <extension_board.h>
 #include <mapmem.h>
+#include <of_overlay.h>
 #include <linux/libfdt.h>
 #include <fdt_support.h>
 
 static LIST_HEAD(extension_list);
 
-static int extension_apply(struct extension *extension)
+/**
+ * extension_apply() - Apply the overlay for an extension board
+ *
+ * @extension: Extension board
+ * @ctx: Context to apply the overlay to, or NULL to apply it to working_fdt
+ *	directly
+ * Return: CMD_RET_SUCCESS if OK, CMD_RET_FAILURE on error
+ */
+static int extension_apply(struct extension *extension,
+			   struct of_overlay_ctx *ctx)
 {
 	char *overlay_cmd;
 	ulong extrasize, overlay_addr;
@@ -47,9 +58,23 @@ static int extension_apply(struct extension *extension)
 	if (!extrasize)
 		return CMD_RET_FAILURE;
 
-	fdt_shrink_to_minimum(working_fdt, extrasize);
-
 	blob = map_sysmem(overlay_addr, 0);
+	if (ctx) {
+		int ret;
+
+		if (!fdt_valid(&blob))
+			return CMD_RET_FAILURE;
+		ret = of_overlay_apply(ctx, blob);
+		if (ret) {
+			printf("Cannot apply overlay %s (err=%dE)\n",
+			       extension->overlay, ret);
+			return CMD_RET_FAILURE;
+		}
+
+		return CMD_RET_SUCCESS;
+	}
+
+	fdt_shrink_to_minimum(working_fdt, extrasize);
 	if (!fdt_valid(&blob))
 		return CMD_RET_FAILURE;
 
@@ -60,6 +85,57 @@ static int extension_apply(struct extension *extension)
 	return CMD_RET_SUCCESS;
 }
 
+/**
+ * extension_apply_all() - Apply the overlays for all extension boards
+ *
+ * With CONFIG_OF_LIVE_OVERLAY the overlays are applied to a live tree, which
+ * is flattened back into working_fdt once at the end. On error working_fdt
+ * is left unchanged in that case.
+ *
+ * Return: CMD_RET_SUCCESS if OK, CMD_RET_FAILURE on error
+ */
+static int extension_apply_all(void)
+{
+	struct of_overlay_ctx ctx, *ctxp = NULL;
+	struct extension *extension;
+	struct abuf buf;
+	int ret = CMD_RET_FAILURE, err;
+
+	if (CONFIG_IS_ENABLED(OF_LIVE_OVERLAY) && working_fdt) {
+		err = of_overlay_begin(&ctx, working_fdt);
+		if (err) {
+			printf("Cannot read devicetree (err=%dE)\n", err);
+			return CMD_RET_FAILURE;
+		}
+		ctxp = &ctx;
+	}
+
+	list_for_each_entry(extension, &extension_list, list) {
+		ret = extension_apply(extension, ctxp);
+		if (ret != CMD_RET_SUCCESS)
+			break;
+	}
+	if (!ctxp)
+		return ret;
+
+	err = ret == CMD_RET_SUCCESS ? of_overlay_flatten(ctxp, &buf) : 0;
+	/* the live tree refers to working_fdt, so free it before writing */
+	of_overlay_end(ctxp);
+	if (ret != CMD_RET_SUCCESS)
+		return ret;
+	if (!err) {
+		err = fdt_open_into(abuf_data(&buf), working_fdt,
+				    abuf_size(&buf));
+		abuf_uninit(&buf);
+	}
+	if (err) {
+		printf("Cannot write devicetree (err=%d)\n", err);
+		return CMD_RET_FAILURE;
+	}
+
+	return CMD_RET_SUCCESS;
+}
+
 static int do_extension_list(struct cmd_tbl *cmdtp, int flag,
 			     int argc, char *const argv[])
 {
@@ -122,12 +198,7 @@ static int do_extension_apply(struct cmd_tbl *cmdtp, int flag,
 		return CMD_RET_USAGE;
 
 	if (strcmp(argv[1], "all") == 0) {
-		ret = CMD_RET_FAILURE;
-		list_for_each_entry(extension, &extension_list, list) {
-			ret = extension_apply(extension);
-			if (ret != CMD_RET_SUCCESS)
-				break;
-		}
+		ret = extension_apply_all();
 	} else {
 		extension_id = simple_strtol(argv[1], NULL, 10);
 		list_for_each(entry, &extension_list) {
@@ -143,7 +214,7 @@ static int do_extension_apply(struct cmd_tbl *cmdtp, int flag,
 			return CMD_RET_FAILURE;
 		}
 
-		ret = extension_apply(extension);
+		ret = extension_apply(extension, NULL);
 	}
 
 	return ret;
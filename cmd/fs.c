@@ -38,6 +38,11 @@ U_BOOT_CMD(
 	"      If 'bytes' is 0 or omitted, the file is read until the end.\n"
 	"      'pos' gives the file byte position to start reading from.\n"
 	"      If 'pos' is 0 or omitted, the file is read from the start."
+#ifdef CONFIG_CMD_LOAD_DECOMP
+	"\nload -d <interface> [<dev[:part]> [<addr> [<filename> [bytes]]]]\n"
+	"    - Load a file, decompressing it to 'addr' as it is read.\n"
+	"      'bytes' gives the space available for the decompressed data."
+#endif
 );
 
 static int do_save_wrapper(struct cmd_tbl *cmdtp, int flag, int argc,
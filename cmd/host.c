@@ -41,6 +41,7 @@ static int do_host_save(struct cmd_tbl *cmdtp, int flag, int argc,
 static int do_host_bind(struct cmd_tbl *cmdtp, int flag, int argc,
 			char *const argv[])
 {
+	enum host_mode mode = HOST_MODE_RW;
 	bool removable = false;
 	struct udevice *dev;
 	const char *label;
@@ -54,8 +55,15 @@ static int do_host_bind(struct cmd_tbl *cmdtp, int flag, int argc,
 	if (argc < 2)
 		return CMD_RET_USAGE;
 
-	if (!strcmp(argv[0], "-r")) {
-		removable = true;
+	while (argc && *argv[0] == '-') {
+		if (!strcmp(argv[0], "-r"))
+			removable = true;
+		else if (!strcmp(argv[0], "-m"))
+			mode = HOST_MODE_MMAP;
+		else if (!strcmp(argv[0], "-d"))
+			mode = HOST_MODE_DIRECT;
+		else
+			return CMD_RET_USAGE;
 		argc--;
 		argv++;
 	}
@@ -72,7 +80,8 @@ static int do_host_bind(struct cmd_tbl *cmdtp, int flag, int argc,
 		}
 	}
 
-	ret = host_create_attach_file(label, file, removable, blksz, &dev);
+	ret = host_create_attach_file_mode(label, file, removable, blksz, mode,
+					   &dev);
 	if (ret) {
 		printf("Cannot create device / bind file\n");
 		return CMD_RET_FAILURE;
@@ -262,9 +271,11 @@ U_BOOT_CMD(
 	"host save hostfs - <addr> <filename> <bytes> [<offset>] - "
 		"save a file to host\n"
 	"host size hostfs - <filename> - determine size of file on host\n"
-	"host bind [-r] <label> <filename> [<blksz>] - bind \"host\" device to file,\n"
-	"     and optionally set the device's logical block size\n"
+	"host bind [-r] [-m | -d] <label> <filename> [<blksz>] - bind \"host\" device\n"
+	"     to file, and optionally set the device's logical block size\n"
 	"     -r = mark as removable\n"
+	"     -m = map the file into memory (fastest)\n"
+	"     -d = bypass the host's page cache (O_DIRECT)\n"
 	"host unbind <label>     - unbind file from \"host\" device\n"
 	"host info [<label>]     - show device binding & info\n"
 	"host dev [<label>]      - set or retrieve the current host device\n"
@@ -44,6 +44,7 @@ static int do_log_level(struct cmd_tbl *cmdtp, int flag, int argc,
 		if (log_level == LOGL_NONE)
 			return CMD_RET_FAILURE;
 		gd->default_log_level = log_level;
+		log_site_update();
 	} else {
 		for (log_level = LOGL_FIRST; log_level <= _LOG_MAX_LEVEL;
 		     log_level++)
@@ -337,6 +338,44 @@ static int do_log_format(struct cmd_tbl *cmdtp, int flag, int argc,
 	return 0;
 }
 
+#if CONFIG_IS_ENABLED(LOG_SITES)
+static int do_log_site(struct cmd_tbl *cmdtp, int flag, int argc,
+		       char *const argv[])
+{
+	int force, count;
+
+	if (argc < 3)
+		return CMD_RET_USAGE;
+	if (!strcmp(argv[1], "on"))
+		force = 1;
+	else if (!strcmp(argv[1], "off"))
+		force = -1;
+	else if (!strcmp(argv[1], "auto"))
+		force = 0;
+	else
+		return CMD_RET_USAGE;
+
+	count = log_site_force(argv[2], force);
+	if (!count) {
+		printf("No log sites match '%s'\n", argv[2]);
+		return CMD_RET_FAILURE;
+	}
+	printf("%d log site%s updated\n", count, count == 1 ? "" : "s");
+
+	return 0;
+}
+#endif
+
+#if CONFIG_IS_ENABLED(LOG_DEFER)
+static int do_log_flush(struct cmd_tbl *cmdtp, int flag, int argc,
+			char *const argv[])
+{
+	log_defer_flush();
+
+	return 0;
+}
+#endif
+
 static int do_log_rec(struct cmd_tbl *cmdtp, int flag, int argc,
 		      char *const argv[])
 {
@@ -403,7 +442,16 @@ U_BOOT_LONGHELP(log,
 	"\tc=category, l=level, F=file, L=line number, f=function, m=msg\n"
 	"\tor 'default', or 'all' for all\n"
 	"log rec <category> <level> <file> <line> <func> <message> - "
-		"output a log record");
+		"output a log record"
+#if CONFIG_IS_ENABLED(LOG_DEFER)
+	"\nlog flush - output log records which are waiting to be formatted"
+#endif
+#if CONFIG_IS_ENABLED(LOG_SITES)
+	"\nlog site on|off|auto <func|file> - always/never emit debug records\n"
+	"\tfrom a function or a file (matching the end of its name), or go\n"
+	"\tback to following the log level and filters"
+#endif
+	);
 
 U_BOOT_CMD_WITH_SUBCMDS(log, "log system", log_help_text,
 	U_BOOT_SUBCMD_MKENT(level, 2, 1, do_log_level),
@@ -415,4 +463,10 @@ U_BOOT_CMD_WITH_SUBCMDS(log, "log system", log_help_text,
 	U_BOOT_SUBCMD_MKENT(filter-remove, 4, 1, do_log_filter_remove),
 	U_BOOT_SUBCMD_MKENT(format, 2, 1, do_log_format),
 	U_BOOT_SUBCMD_MKENT(rec, 7, 1, do_log_rec),
+#if CONFIG_IS_ENABLED(LOG_DEFER)
+	U_BOOT_SUBCMD_MKENT(flush, 1, 1, do_log_flush),
+#endif
+#if CONFIG_IS_ENABLED(LOG_SITES)
+	U_BOOT_SUBCMD_MKENT(site, 3, 1, do_log_site),
+#endif
 );
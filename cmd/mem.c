@@ -12,10 +12,13 @@
 
 #include <console.h>
 #include <bootretry.h>
+#include <cpu.h>
+#include <cpu_func.h>
 #include <cli.h>
 #include <command.h>
 #include <console.h>
 #include <display_options.h>
+#include <dma.h>
 #ifdef CONFIG_MTD_NOR_FLASH
 #include <flash.h>
 #endif
@@ -25,12 +28,14 @@
 #include <rand.h>
 #include <time.h>
 #include <watchdog.h>
+#include <asm/cache.h>
 #include <asm/global_data.h>
 #include <asm/io.h>
 #include <linux/bitops.h>
 #include <linux/compiler.h>
 #include <linux/ctype.h>
 #include <linux/delay.h>
+#include <linux/sizes.h>
 
 DECLARE_GLOBAL_DATA_PTR;
 
@@ -359,7 +364,8 @@ static int do_mem_cp(struct cmd_tbl *cmdtp, int flag, int argc,
 	}
 #endif
 
-	memmove(dst, src, count * size);
+	if (dma_bulk_copy(dst, src, count * size))
+		memmove(dst, src, count * size);
 
 	unmap_sysmem(src);
 	unmap_sysmem(dst);
@@ -999,20 +1005,20 @@ static ulong mem_test_bitflip(vu_long *buf, ulong start, ulong end)
 	return test_bitflip_comparison(buf, buf + half_size, half_size);
 }
 
-static ulong mem_test_quick(vu_long *buf, ulong start_addr, ulong end_addr,
-			    vu_long pattern, int iteration)
+/**
+ * mem_test_pattern() - Work out the pattern for an iteration of the quick test
+ *
+ * @pattern: Pattern provided by the user
+ * @iteration: Iteration number, starting at 0
+ * @incrp: Returns the amount to add to the pattern for each word
+ * Return: pattern for the first word
+ */
+static ulong mem_test_pattern(ulong pattern, int iteration, ulong *incrp)
 {
-	vu_long *end;
-	vu_long *addr;
-	ulong errs = 0;
-	ulong incr, length;
-	ulong val, readback;
-	const int plen = 2 * sizeof(ulong);
-
 	/* Alternate the pattern */
-	incr = 1;
+	*incrp = 1;
 	if (iteration & 1) {
-		incr = -incr;
+		*incrp = -1;
 		/*
 		 * Flip the pattern each time to make lots of zeros and
 		 * then, the next time, lots of ones.  We decrement
@@ -1024,6 +1030,21 @@ static ulong mem_test_quick(vu_long *buf, ulong start_addr, ulong end_addr,
 		else
 			pattern = ~pattern;
 	}
+
+	return pattern;
+}
+
+static ulong mem_test_quick(vu_long *buf, ulong start_addr, ulong end_addr,
+			    vu_long pattern, int iteration)
+{
+	vu_long *end;
+	vu_long *addr;
+	ulong errs = 0;
+	ulong incr, length;
+	ulong val, readback;
+	const int plen = 2 * sizeof(ulong);
+
+	pattern = mem_test_pattern(pattern, iteration, &incr);
 	length = (end_addr - start_addr) / sizeof(ulong);
 	end = buf + length;
 	printf("\rPattern %0*lX  Writing..."
@@ -1058,6 +1079,137 @@ static ulong mem_test_quick(vu_long *buf, ulong start_addr, ulong end_addr,
 	return errs;
 }
 
+/* Amount of memory tested by each job in the fast test */
+#define MEM_TEST_FAST_CHUNK	SZ_16M
+
+/* Most jobs to run at once in the fast test */
+#define MEM_TEST_FAST_JOBS	8
+
+/**
+ * struct mem_test_chunk - A chunk of memory for the fast test
+ *
+ * @job: Job which tests the chunk
+ * @buf: Start of the chunk
+ * @words: Number of words in the chunk
+ * @pattern: Pattern for the first word
+ * @incr: Amount to add to the pattern for each word
+ * @errs: Returns the number of errors found
+ * @err_word: Returns the index of the first bad word
+ * @err_found: Returns the value found in the first bad word
+ */
+struct mem_test_chunk {
+	struct cpu_job job;
+	ulong *buf;
+	ulong words;
+	ulong pattern;
+	ulong incr;
+	ulong errs;
+	ulong err_word;
+	ulong err_found;
+};
+
+/*
+ * This may run on another CPU, so it just records the first error for the
+ * caller to report
+ */
+static int mem_test_fast_chunk(struct cpu_job *job)
+{
+	struct mem_test_chunk *chunk = container_of(job, struct mem_test_chunk,
+						    job);
+	ulong *buf = chunk->buf;
+	ulong start, end;
+	ulong val, i;
+
+	for (i = 0, val = chunk->pattern; i < chunk->words; i++) {
+		buf[i] = val;
+		val += chunk->incr;
+	}
+
+	/* Read back from memory, not the cache */
+	start = ALIGN_DOWN((ulong)buf, ARCH_DMA_MINALIGN);
+	end = ALIGN((ulong)(buf + chunk->words), ARCH_DMA_MINALIGN);
+	flush_dcache_range(start, end);
+
+	chunk->errs = 0;
+	for (i = 0, val = chunk->pattern; i < chunk->words; i++) {
+		if (buf[i] != val) {
+			if (!chunk->errs++) {
+				chunk->err_word = i;
+				chunk->err_found = buf[i];
+			}
+		}
+		val += chunk->incr;
+	}
+
+	return 0;
+}
+
+/**
+ * mem_test_fast() - Run the quick test at the speed of the memory
+ *
+ * This writes and checks the same values as mem_test_quick(), but splits the
+ * range into chunks which are spread across any secondary CPUs that can take
+ * jobs. The console is only checked between chunks and just the first error
+ * in each chunk is shown.
+ *
+ * @buf: Pointer to the start of the range
+ * @start_addr: Address of the start of the range
+ * @end_addr: Address of the end of the range (exclusive)
+ * @pattern: Pattern provided by the user
+ * @iteration: Iteration number, starting at 0
+ * Return: number of errors, or -1 if interrupted
+ */
+static ulong mem_test_fast(ulong *buf, ulong start_addr, ulong end_addr,
+			   ulong pattern, int iteration)
+{
+	struct mem_test_chunk chunks[MEM_TEST_FAST_JOBS];
+	const int plen = 2 * sizeof(ulong);
+	ulong length, done, incr;
+	ulong errs = 0;
+	int njobs, i;
+
+	pattern = mem_test_pattern(pattern, iteration, &incr);
+	length = (end_addr - start_addr) / sizeof(ulong);
+	njobs = min(cpu_job_cpus(), MEM_TEST_FAST_JOBS);
+	printf("\rPattern %0*lX  Testing on %d CPU(s)...%12s", plen, pattern,
+	       njobs, "");
+
+	for (done = 0; done < length;) {
+		for (i = 0; i < njobs && done < length; i++) {
+			struct mem_test_chunk *chunk = &chunks[i];
+
+			chunk->buf = buf + done;
+			chunk->words = min(length - done,
+					   MEM_TEST_FAST_CHUNK / sizeof(ulong));
+			chunk->pattern = pattern + done * incr;
+			chunk->incr = incr;
+			chunk->job.func = mem_test_fast_chunk;
+			cpu_job_start(&chunk->job);
+			done += chunk->words;
+		}
+		njobs = i;
+		for (i = 0; i < njobs; i++) {
+			struct mem_test_chunk *chunk = &chunks[i];
+			ulong offset = chunk->buf - buf + chunk->err_word;
+
+			cpu_job_wait(&chunk->job);
+			if (!chunk->errs)
+				continue;
+			printf("\nMem error @ 0x%0*lX: found %0*lX, expected %0*lX (%lu errors in chunk)\n",
+			       plen, start_addr + offset * sizeof(ulong),
+			       plen, chunk->err_found, plen,
+			       chunk->pattern + chunk->err_word * incr,
+			       chunk->errs);
+			errs += chunk->errs;
+		}
+		schedule();
+		if (ctrlc())
+			return -1;
+	}
+
+	return errs;
+}
+
 /*
  * Perform a memory test. A more complete alternative test can be
  * configured using CONFIG_SYS_ALT_MEMTEST. The complete test loops until
@@ -1073,8 +1225,16 @@ static int do_mem_mtest(struct cmd_tbl *cmdtp, int flag, int argc,
 	ulong count = 0;
 	ulong errs = 0;	/* number of errors, or -1 if interrupted */
 	ulong pattern = 0;
+	bool fast = false;
 	int iteration;
 
+	if (IS_ENABLED(CONFIG_SYS_FAST_MEMTEST) && argc > 1 &&
+	    !strcmp(argv[1], "-f")) {
+		fast = true;
+		argc--;
+		argv++;
+	}
+
 	start = CONFIG_SYS_MEMTEST_START;
 	end = CONFIG_SYS_MEMTEST_END;
 
@@ -1114,7 +1274,10 @@ static int do_mem_mtest(struct cmd_tbl *cmdtp, int flag, int argc,
 
 		printf("Iteration: %6d\r", iteration + 1);
 		debug("\n");
-		if (IS_ENABLED(CONFIG_SYS_ALT_MEMTEST)) {
+		if (IS_ENABLED(CONFIG_SYS_FAST_MEMTEST) && fast) {
+			errs = mem_test_fast((ulong *)buf, start, end, pattern,
+					     iteration);
+		} else if (IS_ENABLED(CONFIG_SYS_ALT_MEMTEST)) {
 			errs = mem_test_alt(buf, start, end, dummy);
 			if (errs == -1UL)
 				break;
@@ -1415,9 +1578,14 @@ U_BOOT_CMD(
 
 #ifdef CONFIG_CMD_MEMTEST
 U_BOOT_CMD(
-	mtest,	5,	1,	do_mem_mtest,
+	mtest,	6,	1,	do_mem_mtest,
 	"simple RAM read/write test",
+#ifdef CONFIG_SYS_FAST_MEMTEST
+	"[-f] [start [end [pattern [iterations]]]]\n"
+	"  -f  fast test, using all CPUs and checking once per chunk"
+#else
 	"[start [end [pattern [iterations]]]]"
+#endif
 );
 #endif	/* CONFIG_CMD_MEMTEST */
 
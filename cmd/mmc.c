@@ -386,6 +386,14 @@ static lbaint_t mmc_sparse_reserve(struct sparse_storage *info,
 	return blkcnt;
 }
 
+static lbaint_t mmc_sparse_discard(struct sparse_storage *info,
+				   lbaint_t blk, lbaint_t blkcnt)
+{
+	struct blk_desc *dev_desc = info->priv;
+
+	return blk_ddiscard(dev_desc, blk, blkcnt) ? 0 : blkcnt;
+}
+
 static int do_mmc_sparse_write(struct cmd_tbl *cmdtp, int flag,
 			       int argc, char *const argv[])
 {
@@ -426,6 +434,8 @@ static int do_mmc_sparse_write(struct cmd_tbl *cmdtp, int flag,
 	sparse.size = dev_desc->lba - blk;
 	sparse.write = mmc_sparse_write;
 	sparse.reserve = mmc_sparse_reserve;
+	sparse.discard = mmc_sparse_discard;
+	sparse.discard_align = dev_desc->discard_align;
 	sparse.mssg = NULL;
 	sprintf(dest, "0x" LBAF, sparse.start * sparse.blksz);
 
@@ -21,6 +21,7 @@
 #include <net/udp.h>
 #include <net/sntp.h>
 #include <net/ncsi.h>
+#include <net/wget.h>
 
 static int netboot_common(enum proto_t, struct cmd_tbl *, int, char * const []);
 
@@ -197,13 +198,25 @@ U_BOOT_CMD(
 #if defined(CONFIG_CMD_WGET)
 static int do_wget(struct cmd_tbl *cmdtp, int flag, int argc, char * const argv[])
 {
-	return netboot_common(WGET, cmdtp, argc, argv);
+	int ret;
+
+	/* Any more files come as pairs of address and path */
+	if (argc > 3) {
+		if (wget_set_files(argc - 3, argv + 3))
+			return CMD_RET_USAGE;
+		argc = 3;
+	}
+	ret = netboot_common(WGET, cmdtp, argc, argv);
+	wget_set_files(0, NULL);
+
+	return ret;
 }
 
 U_BOOT_CMD(
-	wget,   3,      1,      do_wget,
+	wget,   3 + 2 * (WGET_MAX_FILES - 1),      1,      do_wget,
 	"boot image via network using HTTP protocol",
-	"[loadAddress] [[hostIPaddr:]path and image name]"
+	"[loadAddress] [[hostIPaddr:]path and image name] [loadAddress path]...\n"
+	"    - more files are fetched from the same server over one connection"
 );
 #endif
 
@@ -60,6 +60,8 @@ static int env_print(char *name, int flag)
 	char *res = NULL;
 	ssize_t len;
 
+	env_finish_import();
+
 	if (name) {		/* print a single name */
 		struct env_entry e, *ep;
 
@@ -167,6 +169,7 @@ static int do_env_grep(struct cmd_tbl *cmdtp, int flag,
 	}
 
 DONE:
+	env_finish_import();
 	len = hexport_r(&env_htab, '\n',
 			flag | grep_what | grep_how,
 			&res, 0, argc, argv);
@@ -341,6 +344,7 @@ int do_env_callback(struct cmd_tbl *cmdtp, int flag, int argc,
 	puts("Active callback bindings:\n");
 	printf("\t%-20s %-20s\n", "Variable Name", "Callback Name");
 	printf("\t%-20s %-20s\n", "-------------", "-------------");
+	env_finish_import();
 	hwalk_r(&env_htab, print_active_callback);
 	return 0;
 }
@@ -414,6 +418,7 @@ int do_env_flags(struct cmd_tbl *cmdtp, int flag, int argc, char *const argv[])
 		"Variable Access");
 	printf("\t%-20s %-20s %-20s\n", "-------------", "-------------",
 		"---------------");
+	env_finish_import();
 	hwalk_r(&env_htab, print_active_flags);
 	return 0;
 }
@@ -568,6 +573,8 @@ static int do_env_delete(struct cmd_tbl *cmdtp, int flag,
 	debug("Final value for argc=%d\n", argc);
 
 	env_inc_id();
+	if (env_finish_import())
+		return 1;
 
 	while (--argc > 0) {
 		char *name = *++argv;
@@ -684,6 +691,9 @@ NXTARG:		;
 	argc--;
 	argv++;
 
+	if (env_finish_import())
+		return 1;
+
 	if (sep) {		/* export as text file */
 		len = hexport_r(&env_htab, sep,
 				H_MATCH_KEY | H_MATCH_IDENT,
@@ -863,6 +873,9 @@ static int do_env_import(struct cmd_tbl *cmdtp, int flag,
 		ptr = (char *)ep->data;
 	}
 
+	if (env_finish_import())
+		return 1;
+
 	if (!himport_r(&env_htab, ptr, size, sep, del ? 0 : H_NOCLEAR,
 		       crlf_is_lf, wl ? argc - 2 : 0, wl ? &argv[2] : NULL)) {
 		pr_err("## Error: Environment import failed: errno = %d\n",
@@ -1044,6 +1057,7 @@ static int do_env_exists(struct cmd_tbl *cmdtp, int flag, int argc,
 	if (argc < 2)
 		return CMD_RET_USAGE;
 
+	env_finish_import();
 	e.key = argv[1];
 	e.data = NULL;
 	hsearch_r(e, ENV_FIND, &ep, &env_htab, 0);
@@ -0,0 +1,107 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Control the sampling profiler
+ */
+
+#include <command.h>
+#include <errno.h>
+#include <malloc.h>
+#include <profiler.h>
+#include <sort.h>
+#include <vsprintf.h>
+
+/* Default sampling rate in Hz */
+#define PROFILER_DEFAULT_HZ	1000
+
+static int do_profiler_start(struct cmd_tbl *cmdtp, int flag, int argc,
+			     char *const argv[])
+{
+	uint hz = PROFILER_DEFAULT_HZ;
+	int ret;
+
+	if (argc > 1)
+		hz = dectoul(argv[1], NULL);
+	ret = profiler_start(hz);
+	if (ret) {
+		printf("Cannot start profiler (err=%dE)\n", ret);
+		return CMD_RET_FAILURE;
+	}
+
+	return 0;
+}
+
+static int do_profiler_stop(struct cmd_tbl *cmdtp, int flag, int argc,
+			    char *const argv[])
+{
+	profiler_stop();
+
+	return 0;
+}
+
+static int do_profiler_info(struct cmd_tbl *cmdtp, int flag, int argc,
+			    char *const argv[])
+{
+	struct profiler_info info;
+
+	profiler_get_info(&info);
+	if (info.hz)
+		printf("Running at %u Hz\n", info.hz);
+	else
+		printf("Stopped\n");
+	printf("Samples: %u held, %lu taken\n", info.count, info.total);
+
+	return 0;
+}
+
+static int h_compare_addr(const void *v1, const void *v2)
+{
+	ulong addr1 = *(ulong *)v1, addr2 = *(ulong *)v2;
+
+	return addr1 < addr2 ? -1 : addr1 > addr2;
+}
+
+static int do_profiler_dump(struct cmd_tbl *cmdtp, int flag, int argc,
+			    char *const argv[])
+{
+	struct profiler_info info;
+	ulong *addr;
+	uint i, start;
+
+	/* Stop first, so the buffer does not change underneath us */
+	profiler_stop();
+	profiler_get_info(&info);
+	addr = malloc(info.count * sizeof(ulong));
+	if (!addr && info.count) {
+		printf("Out of memory\n");
+		return CMD_RET_FAILURE;
+	}
+	for (i = 0; i < info.count; i++)
+		addr[i] = profiler_get_sample(i);
+	qsort(addr, info.count, sizeof(ulong), h_compare_addr);
+
+	/* Print each address once, with the number of times it was seen */
+	printf("profiler: %u samples\n", info.count);
+	for (start = 0, i = 1; i <= info.count; i++) {
+		if (i == info.count || addr[i] != addr[start]) {
+			printf("%lx %u\n", addr[start], i - start);
+			start = i;
+		}
+	}
+	free(addr);
+
+	return 0;
+}
+
+U_BOOT_LONGHELP(profiler,
+	"start [<hz>] - start sampling (default 1000 Hz)\n"
+	"profiler stop        - stop sampling\n"
+	"profiler info        - show sampling status\n"
+	"profiler dump        - stop and print each address with its sample count\n"
+	"\n"
+	"Use tools/profiler.py with u-boot.map or System.map to decode the dump");
+
+U_BOOT_CMD_WITH_SUBCMDS(profiler, "Sampling profiler", profiler_help_text,
+	U_BOOT_SUBCMD_MKENT(start, 2, 1, do_profiler_start),
+	U_BOOT_SUBCMD_MKENT(stop, 1, 1, do_profiler_stop),
+	U_BOOT_SUBCMD_MKENT(info, 1, 1, do_profiler_info),
+	U_BOOT_SUBCMD_MKENT(dump, 1, 1, do_profiler_dump));
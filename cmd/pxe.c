@@ -5,6 +5,7 @@
  */
 
 #include <command.h>
+#include <env.h>
 #include <fs.h>
 #include <net.h>
 #include <net6.h>
@@ -53,6 +54,24 @@ static int do_get_tftp(struct pxe_context *ctx, const char *file_path,
 	return 1;
 }
 
+/*
+ * Looks for a pxe file in the pxelinux.cfg directory, recording the name if
+ * it is found so that it can be tried first next time.
+ *
+ * Returns 1 on success or < 0 on error.
+ */
+static int pxe_try_path(struct pxe_context *ctx, const char *name,
+			unsigned long pxefile_addr_r)
+{
+	int ret;
+
+	ret = get_pxelinux_path(ctx, name, pxefile_addr_r);
+	if (ret > 0 && IS_ENABLED(CONFIG_CMD_PXE_REMEMBER))
+		env_set("pxefile_last", name);
+
+	return ret;
+}
+
 /*
  * Looks for a pxe file with specified config file name,
  * which is received from DHCPv4 option 209 or
@@ -83,7 +102,7 @@ static int pxe_uuid_path(struct pxe_context *ctx, unsigned long pxefile_addr_r)
 	if (!uuid_str)
 		return -ENOENT;
 
-	return get_pxelinux_path(ctx, uuid_str, pxefile_addr_r);
+	return pxe_try_path(ctx, uuid_str, pxefile_addr_r);
 }
 
 /*
@@ -102,7 +121,7 @@ static int pxe_mac_path(struct pxe_context *ctx, unsigned long pxefile_addr_r)
 	if (err < 0)
 		return err;
 
-	return get_pxelinux_path(ctx, mac_str, pxefile_addr_r);
+	return pxe_try_path(ctx, mac_str, pxefile_addr_r);
 }
 
 /*
@@ -120,7 +139,7 @@ static int pxe_ipaddr_paths(struct pxe_context *ctx, unsigned long pxefile_addr_
 	sprintf(ip_addr, "%08X", ntohl(net_ip.s_addr));
 
 	for (mask_pos = 7; mask_pos >= 0;  mask_pos--) {
-		err = get_pxelinux_path(ctx, ip_addr, pxefile_addr_r);
+		err = pxe_try_path(ctx, ip_addr, pxefile_addr_r);
 
 		if (err > 0)
 			return err;
@@ -135,6 +154,7 @@ int pxe_get(ulong pxefile_addr_r, char **bootdirp, ulong *sizep, bool use_ipv6)
 {
 	struct cmd_tbl cmdtp[] = {};	/* dummy */
 	struct pxe_context ctx;
+	const char *last;
 	int i;
 
 	if (pxe_setup_ctx(&ctx, cmdtp, do_get_tftp, NULL, false,
@@ -157,6 +177,12 @@ int pxe_get(ulong pxefile_addr_r, char **bootdirp, ulong *sizep, bool use_ipv6)
 		goto error_exit;
 	}
 
+	/* Start with the file found last time, which is likely still there */
+	last = env_get("pxefile_last");
+	if (IS_ENABLED(CONFIG_CMD_PXE_REMEMBER) && last &&
+	    get_pxelinux_path(&ctx, last, pxefile_addr_r) > 0)
+		goto done;
+
 	/*
 	 * Keep trying paths until we successfully get a file we're looking
 	 * for.
@@ -168,8 +194,8 @@ int pxe_get(ulong pxefile_addr_r, char **bootdirp, ulong *sizep, bool use_ipv6)
 
 	i = 0;
 	while (pxe_default_paths[i]) {
-		if (get_pxelinux_path(&ctx, pxe_default_paths[i],
-				      pxefile_addr_r) > 0)
+		if (pxe_try_path(&ctx, pxe_default_paths[i],
+				 pxefile_addr_r) > 0)
 			goto done;
 		i++;
 	}
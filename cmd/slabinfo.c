@@ -0,0 +1,29 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Show statistics for the slab front-end of malloc()
+ */
+
+#include <command.h>
+#include <malloc.h>
+
+static int do_slabinfo(struct cmd_tbl *cmdtp, int flag, int argc,
+		       char *const argv[])
+{
+	struct malloc_slab_stats st;
+	int class;
+
+	printf("%5s %6s %8s %10s %10s\n", "size", "pages", "in use",
+	       "allocs", "fallbacks");
+	for (class = 0; !malloc_slab_get_stats(class, &st); class++) {
+		printf("%5u %6u %8u %10lu %10lu\n", st.size, st.pages,
+		       st.in_use, st.allocs, st.fallbacks);
+	}
+
+	return 0;
+}
+
+U_BOOT_CMD(
+	slabinfo,	1,	1,	do_slabinfo,
+	"show malloc() slab statistics",
+	""
+);
@@ -2,6 +2,7 @@
 
 #include <command.h>
 #include <env.h>
+#include <errno.h>
 #include <fs.h>
 #include <pxe_utils.h>
 #include <vsprintf.h>
@@ -42,6 +43,25 @@ static int sysboot_read_file(struct pxe_context *ctx, const char *file_path,
 	return 0;
 }
 
+static int sysboot_read_head(struct pxe_context *ctx, const char *file_path,
+			     ulong addr, ulong len)
+{
+	struct sysboot_info *info = ctx->userdata;
+	loff_t len_read;
+	int ret;
+
+	ret = fs_set_blk_dev(info->ifname, info->dev_part_str, info->fstype);
+	if (ret)
+		return ret;
+	ret = fs_read(file_path, addr, 0, len, &len_read);
+	if (ret)
+		return ret;
+	if (len_read != len)
+		return -EIO;
+
+	return 0;
+}
+
 /*
  * Boots a system using a local disk syslinux/extlinux file
  *
@@ -109,6 +129,7 @@ static int do_sysboot(struct cmd_tbl *cmdtp, int flag, int argc,
 		printf("Out of memory\n");
 		return CMD_RET_FAILURE;
 	}
+	ctx.gethead = sysboot_read_head;
 
 	if (get_pxe_file(&ctx, filename, pxefile_addr_r) < 0) {
 		printf("Error reading config file\n");
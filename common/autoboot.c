@@ -24,6 +24,7 @@
 #include <linux/delay.h>
 #include <u-boot/sha256.h>
 #include <bootcount.h>
+#include <bootflow.h>
 #include <crypt.h>
 #include <dm/ofnode.h>
 
@@ -338,6 +339,19 @@ static bool fallback_to_sha256(void)
 		return true;
 }
 
+/* Read the default bootflow while waiting, so that autoboot can use it */
+static void autoboot_prefetch(void)
+{
+	int ret;
+
+	if (!IS_ENABLED(CONFIG_BOOTSTD_PREFETCH))
+		return;
+
+	ret = bootflow_prefetch();
+	if (ret)
+		debug("No bootflow prefetched (err=%d)\n", ret);
+}
+
 /***************************************************************************
  * Watch for 'delay' seconds for autoboot stop or autoboot delay string.
  * returns: 0 -  no key string, allow autoboot 1 - got key string, abort
@@ -356,6 +370,7 @@ static int abortboot_key_sequence(int bootdelay)
 	 */
 	printf(CONFIG_AUTOBOOT_PROMPT, bootdelay);
 #  endif
+	autoboot_prefetch();
 
 	if (IS_ENABLED(CONFIG_AUTOBOOT_ENCRYPTION)) {
 		if (IS_ENABLED(CONFIG_CRYPT_PW) && !fallback_to_sha256())
@@ -387,10 +402,14 @@ static int abortboot_single_key(int bootdelay)
 		abort = 1;	/* don't auto boot	*/
 	}
 
+	/* the time taken by this counts towards the delay */
+	ts = get_timer(0);
+	if (!abort)
+		autoboot_prefetch();
+
 	while ((bootdelay > 0) && (!abort)) {
 		--bootdelay;
 		/* delay 1000 ms */
-		ts = get_timer(0);
 		do {
 			if (tstc()) {	/* we got a key press	*/
 				int key;
@@ -404,6 +423,7 @@ static int abortboot_single_key(int bootdelay)
 			}
 			udelay(10000);
 		} while (!abort && get_timer(ts) < 1000);
+		ts += 1000;
 
 		printf("\b\b\b%2d ", bootdelay);
 	}
@@ -426,6 +446,8 @@ static int abortboot(int bootdelay)
 
 	if (IS_ENABLED(CONFIG_SILENT_CONSOLE) && abort)
 		gd->flags &= ~GD_FLG_SILENT;
+	if (IS_ENABLED(CONFIG_BOOTSTD_PREFETCH) && abort)
+		bootflow_prefetch_drop();
 
 	return abort;
 }
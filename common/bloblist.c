@@ -61,6 +61,9 @@ static struct tag_name {
 	{ BLOBLISTT_U_BOOT_SPL_HANDOFF, "SPL hand-off" },
 	{ BLOBLISTT_VBE, "VBE" },
 	{ BLOBLISTT_U_BOOT_VIDEO, "SPL video handoff" },
+	{ BLOBLISTT_U_BOOT_MMC_TUNING, "MMC tuning results" },
+	{ BLOBLISTT_U_BOOT_FIT_SIG, "FIT signatures checked" },
+	{ BLOBLISTT_U_BOOT_INDEX, "Bloblist index" },
 
 	/* BLOBLISTT_VENDOR_AREA */
 };
@@ -128,6 +131,131 @@ static struct bloblist_rec *bloblist_next_blob(struct bloblist_hdr *hdr,
 	     _rec; \
 	     _rec = bloblist_next_blob(_hdr, _rec))
 
+/**
+ * bloblist_get_index() - Get the index of a bloblist, if it has one
+ *
+ * @hdr: Bloblist to check
+ * @maxp: Returns the maximum number of entries the index can hold
+ * Return: index, or NULL if none
+ */
+static struct bloblist_index *bloblist_get_index(struct bloblist_hdr *hdr,
+						 uint *maxp)
+{
+	struct bloblist_rec *rec;
+
+	if (!IS_ENABLED(CONFIG_BLOBLIST_INDEX))
+		return NULL;
+	rec = bloblist_first_blob(hdr);
+	if (!rec || rec_tag(rec) != BLOBLISTT_U_BOOT_INDEX ||
+	    rec->size < sizeof(struct bloblist_index))
+		return NULL;
+	*maxp = (rec->size - sizeof(struct bloblist_index)) /
+		sizeof(struct bloblist_index_ent);
+
+	return (void *)rec + rec_hdr_size(rec);
+}
+
+/**
+ * bloblist_index_add() - Record a new blob in the index, if there is one
+ *
+ * @hdr: Bloblist containing the blob
+ * @rec: New blob
+ */
+static void bloblist_index_add(struct bloblist_hdr *hdr,
+			       struct bloblist_rec *rec)
+{
+	struct bloblist_index *idx;
+	struct bloblist_index_ent *ent;
+	uint tag = rec_tag(rec);
+	uint max;
+
+	if (tag == BLOBLISTT_VOID || tag == BLOBLISTT_U_BOOT_INDEX)
+		return;
+	idx = bloblist_get_index(hdr, &max);
+	if (!idx)
+		return;
+	idx->used_size = hdr->used_size;
+	if (idx->count >= max) {
+		idx->complete = 0;
+		return;
+	}
+	ent = &idx->ent[idx->count++];
+	ent->tag = tag;
+	ent->offset = (void *)rec - (void *)hdr;
+}
+
+/**
+ * bloblist_index_find() - Look up a blob in the index
+ *
+ * Entries are checked against the record they point to, so a stale index
+ * (e.g. one not updated by an earlier phase) just falls back to walking the
+ * list
+ *
+ * @hdr: Bloblist to search
+ * @tag: Tag to find
+ * @recp: Returns the record found, or NULL if the tag is known not to be
+ *	present
+ * Return: true if @recp is valid, false if the list must be walked instead
+ */
+static bool bloblist_index_find(struct bloblist_hdr *hdr, uint tag,
+				struct bloblist_rec **recp)
+{
+	struct bloblist_index *idx;
+	struct bloblist_rec *rec;
+	uint i, max;
+
+	/* These are not recorded in the index */
+	if (tag == BLOBLISTT_VOID || tag == BLOBLISTT_U_BOOT_INDEX)
+		return false;
+	idx = bloblist_get_index(hdr, &max);
+	if (!idx)
+		return false;
+	for (i = 0; i < idx->count && i < max; i++) {
+		struct bloblist_index_ent *ent = &idx->ent[i];
+
+		if (ent->tag != tag)
+			continue;
+		if (ent->offset < hdr->hdr_size ||
+		    ent->offset + sizeof(*rec) > hdr->used_size)
+			return false;
+		rec = (void *)hdr + ent->offset;
+		if (rec_tag(rec) != tag)
+			return false;
+		*recp = rec;
+
+		return true;
+	}
+	/* Something else may have added blobs after the index was updated */
+	if (!idx->complete || idx->used_size != hdr->used_size)
+		return false;
+	*recp = NULL;
+
+	return true;
+}
+
+/**
+ * bloblist_index_move() - Update the index after blobs have moved
+ *
+ * @hdr: Bloblist containing the blobs
+ * @from_ofs: Offset of the first blob which moved
+ * @move_by: Number of bytes moved by (-ve if moved down)
+ */
+static void bloblist_index_move(struct bloblist_hdr *hdr, ulong from_ofs,
+				int move_by)
+{
+	struct bloblist_index *idx;
+	uint i, max;
+
+	idx = bloblist_get_index(hdr, &max);
+	if (!idx)
+		return;
+	for (i = 0; i < idx->count && i < max; i++) {
+		if (idx->ent[i].offset >= from_ofs)
+			idx->ent[i].offset += move_by;
+	}
+	idx->used_size = hdr->used_size;
+}
+
 static struct bloblist_rec *bloblist_findrec(uint tag)
 {
 	struct bloblist_hdr *hdr = gd->bloblist;
@@ -136,6 +264,9 @@ static struct bloblist_rec *bloblist_findrec(uint tag)
 	if (!hdr)
 		return NULL;
 
+	if (bloblist_index_find(hdr, tag, &rec))
+		return rec;
+
 	foreach_rec(rec, hdr) {
 		if (rec_tag(rec) == tag)
 			return rec;
@@ -193,6 +324,7 @@ static int bloblist_addrec(uint tag, int size, int align_log2,
 	memset((void *)rec + rec_hdr_size(rec), '\0', rec->size);
 
 	hdr->used_size = new_alloced;
+	bloblist_index_add(hdr, rec);
 	*recp = rec;
 
 	return 0;
@@ -311,6 +443,7 @@ static int bloblist_resize_rec(struct bloblist_hdr *hdr,
 			(void *)hdr + next_ofs, new_alloced - next_ofs);
 	}
 	hdr->used_size = new_alloced;
+	bloblist_index_move(hdr, next_ofs, expand_by);
 
 	/* Zero the new part of the blob */
 	if (expand_by > 0) {
@@ -373,6 +506,25 @@ int bloblist_new(ulong addr, uint size, uint flags, uint align_log2)
 	return 0;
 }
 
+int bloblist_add_index(uint count)
+{
+	struct bloblist_hdr *hdr = gd->bloblist;
+	struct bloblist_index *idx;
+
+	if (!IS_ENABLED(CONFIG_BLOBLIST_INDEX))
+		return -ENOSYS;
+	if (bloblist_first_blob(hdr))
+		return log_msg_ret("idx", -EEXIST);
+	idx = bloblist_add(BLOBLISTT_U_BOOT_INDEX,
+			   sizeof(*idx) + count * sizeof(idx->ent[0]), 0);
+	if (!idx)
+		return log_msg_ret("idx", -ENOSPC);
+	idx->complete = 1;
+	idx->used_size = hdr->used_size;
+
+	return 0;
+}
+
 int bloblist_check(ulong addr, uint size)
 {
 	struct bloblist_hdr *hdr;
@@ -550,6 +702,10 @@ int bloblist_init(void)
 		log_debug("Creating new bloblist size %lx at %lx\n", size,
 			  addr);
 		ret = bloblist_new(addr, size, 0, 0);
+		if (!ret && IS_ENABLED(CONFIG_BLOBLIST_INDEX) &&
+		    bloblist_add_index(IF_ENABLED_INT(CONFIG_BLOBLIST_INDEX,
+					CONFIG_BLOBLIST_INDEX_SIZE)))
+			log_warning("Cannot add bloblist index\n");
 	} else {
 		log_debug("Found existing bloblist size %lx at %lx\n", size,
 			  addr);
@@ -475,7 +475,22 @@ static int reserve_trace(void)
 
 static int reserve_uboot(void)
 {
-	if (!(gd->flags & GD_FLG_SKIP_RELOC)) {
+	if (IS_ENABLED(CONFIG_SKIP_RELOC)) {
+		ulong start = (ulong)map_to_sysmem(_start);
+
+		/*
+		 * U-Boot stays where it was loaded, so reserve everything else
+		 * below it, as if it had been relocated there
+		 */
+		if (start < gd->ram_base || start + gd->mon_len > gd->relocaddr) {
+			log_err("U-Boot at %08lx overlaps reserved memory at %08lx\n",
+				start, gd->relocaddr);
+			return -ENOSPC;
+		}
+		gd->relocaddr = start & ~(4096 - 1);
+		debug("Keeping U-Boot (%ldk) at: %08lx\n", gd->mon_len >> 10,
+		      start);
+	} else if (!(gd->flags & GD_FLG_SKIP_RELOC)) {
 		/*
 		 * reserve memory for U-Boot code, data & bss
 		 * round down to next 4 kB limit
@@ -620,6 +635,13 @@ static int reserve_stacks(void)
 static int reserve_bloblist(void)
 {
 #ifdef CONFIG_BLOBLIST
+	/* Keep using the bloblist where it is, if it is large enough */
+	if (IS_ENABLED(CONFIG_BLOBLIST_IN_PLACE) && gd->bloblist &&
+	    bloblist_get_total_size() >= CONFIG_BLOBLIST_SIZE_RELOC) {
+		debug("Using bloblist in place at %p\n", gd->bloblist);
+		return 0;
+	}
+
 	/* Align to a 4KB boundary for easier reading of addresses */
 	gd->start_addr_sp = ALIGN_DOWN(gd->start_addr_sp -
 				       CONFIG_BLOBLIST_SIZE_RELOC, 0x1000);
@@ -637,6 +659,15 @@ static int display_new_sp(void)
 	return 0;
 }
 
+static int show_malloc_f_usage(void)
+{
+	/* The pool is left behind on relocation, so report on it now */
+	if (CONFIG_IS_ENABLED(SYS_MALLOC_F_STATS))
+		malloc_simple_info();
+
+	return 0;
+}
+
 __weak int arch_setup_bdinfo(void)
 {
 	return 0;
@@ -739,6 +770,14 @@ static int setup_reloc(void)
 #endif
 	}
 
+	if (IS_ENABLED(CONFIG_SKIP_RELOC) &&
+	    (gd->start_addr_sp < gd->ram_base ||
+	     gd->start_addr_sp > gd->relocaddr)) {
+		log_err("Not enough memory below U-Boot at %08lx\n",
+			gd->relocaddr);
+		return -ENOSPC;
+	}
+
 	memcpy(gd->new_gd, (char *)gd, sizeof(gd_t));
 
 	if (gd->flags & GD_FLG_SKIP_RELOC) {
@@ -846,6 +885,20 @@ static int initf_dm(void)
 	return 0;
 }
 
+#if CONFIG_IS_ENABLED(CPU_BOOT_BOOST)
+/* Speed up the rest of the boot; it does not matter if this fails */
+static int initf_cpu_boost(void)
+{
+	int ret;
+
+	ret = cpu_boot_boost();
+	if (ret && ret != -EAGAIN)
+		log_warning("Cannot boost CPUs (err=%d)\n", ret);
+
+	return 0;
+}
+#endif
+
 /* Architecture-specific memory reservation */
 __weak int reserve_arch(void)
 {
@@ -895,6 +948,9 @@ static const init_fnc_t init_sequence_f[] = {
 #endif
 #if defined(CONFIG_BOARD_POSTCLK_INIT)
 	board_postclk_init,
+#endif
+#if CONFIG_IS_ENABLED(CPU_BOOT_BOOST)
+	initf_cpu_boost,
 #endif
 	env_init,		/* initialize environment */
 	init_baud_rate,		/* initialze baudrate settings */
@@ -974,6 +1030,7 @@ static const init_fnc_t init_sequence_f[] = {
 	INIT_FUNC_WATCHDOG_RESET
 	setup_bdinfo,
 	display_new_sp,
+	show_malloc_f_usage,
 	INIT_FUNC_WATCHDOG_RESET
 	reloc_fdt,
 	reloc_bootstage,
@@ -1003,6 +1060,8 @@ static const init_fnc_t init_sequence_f[] = {
 void board_init_f(ulong boot_flags)
 {
 	gd->flags = boot_flags;
+	if (IS_ENABLED(CONFIG_SKIP_RELOC))
+		gd->flags |= GD_FLG_SKIP_RELOC;
 	gd->have_console = 0;
 
 	if (initcall_run_list(init_sequence_f))
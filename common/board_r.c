@@ -47,6 +47,7 @@
 #include <nand.h>
 #include <of_live.h>
 #include <onenand_uboot.h>
+#include <profiler.h>
 #include <pvblock.h>
 #include <scsi.h>
 #include <serial.h>
@@ -95,6 +96,19 @@ static int initr_trace(void)
 	return 0;
 }
 
+#if CONFIG_PROFILER_BOOT_HZ
+static int initr_profiler(void)
+{
+	int ret;
+
+	ret = profiler_start(CONFIG_PROFILER_BOOT_HZ);
+	if (ret)
+		log_warning("Cannot start profiler (err=%d)\n", ret);
+
+	return 0;
+}
+#endif
+
 static int initr_reloc(void)
 {
 	/* tell others: relocation done */
@@ -233,6 +247,8 @@ static int initr_dm(void)
 	/* Save the pre-reloc driver model and start a new one */
 	gd->dm_root_f = gd->dm_root;
 	gd->dm_root = NULL;
+	/* The compatible-string index is in pre-relocation memory */
+	gd_set_dm_compat_index(NULL);
 #ifdef CONFIG_TIMER
 	gd->timer = NULL;
 #endif
@@ -586,6 +602,9 @@ static init_fnc_t init_sequence_r[] = {
 	initr_malloc,
 	log_init,
 	initr_bootstage,	/* Needs malloc() but has its own timer */
+#if CONFIG_PROFILER_BOOT_HZ
+	initr_profiler,
+#endif
 #if defined(CONFIG_CONSOLE_RECORD)
 	console_record_init,
 #endif
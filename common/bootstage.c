@@ -15,16 +15,26 @@
 #include <hang.h>
 #include <log.h>
 #include <malloc.h>
+#include <pmu.h>
 #include <sort.h>
 #include <spl.h>
 #include <asm/global_data.h>
 #include <linux/compiler.h>
+#include <linux/kernel.h>
 #include <linux/libfdt.h>
+#include <linux/math64.h>
 
 DECLARE_GLOBAL_DATA_PTR;
 
 enum {
 	RECORD_COUNT = CONFIG_VAL(BOOTSTAGE_RECORD_COUNT),
+#if CONFIG_IS_ENABLED(BOOTSTAGE_PROFILE)
+	PROF_COUNT = CONFIG_BOOTSTAGE_PROFILE_COUNT,
+#endif
+#if CONFIG_IS_ENABLED(BOOTSTAGE_PIPELINE)
+	PIPE_COUNT = CONFIG_BOOTSTAGE_PIPELINE_COUNT,
+	PIPE_NAME_LEN = 32,
+#endif
 };
 
 struct bootstage_record {
@@ -33,18 +43,86 @@ struct bootstage_record {
 	const char *name;
 	int flags;		/* see enum bootstage_flags */
 	enum bootstage_id id;
+#if CONFIG_IS_ENABLED(BOOTSTAGE_PMU)
+	/* Not stashed; must come last */
+	struct pmu_counts pmu;		/* counts at mark, or accumulated */
+	struct pmu_counts pmu_start;	/* counts at bootstage_start() */
+#endif
 };
 
+/* Size of each record in the stash, which is the same in all phases */
+#if CONFIG_IS_ENABLED(BOOTSTAGE_PMU)
+#define STASH_REC_SIZE	offsetof(struct bootstage_record, pmu)
+#else
+#define STASH_REC_SIZE	sizeof(struct bootstage_record)
+#endif
+
+/**
+ * struct bootstage_prof - Profile entry for a device probe or initcall
+ *
+ * @name: Name of the item, or NULL if none
+ * @addr: Address of the item, used when @name is NULL
+ * @time_us: Time spent in the item, excluding nested items
+ * @type: Type of item (enum bootstage_prof_type)
+ */
+struct bootstage_prof {
+	const char *name;
+	ulong addr;
+	uint32_t time_us;
+	int type;
+};
+
+#if CONFIG_IS_ENABLED(BOOTSTAGE_PIPELINE)
+/**
+ * struct bootstage_pipe_stat - Totals for one stage of the boot pipeline
+ *
+ * @time_us: Total time spent in the stage
+ * @in_bytes: Total number of bytes consumed
+ * @out_bytes: Total number of bytes produced
+ * @count: Number of times the stage was run
+ */
+struct bootstage_pipe_stat {
+	ulong time_us;
+	ulong in_bytes;
+	ulong out_bytes;
+	uint count;
+};
+
+/**
+ * struct bootstage_pipe - Boot-pipeline totals for an image
+ *
+ * @name: Name of the image, truncated if needed
+ * @stat: Totals for each stage, indexed by enum bootstage_pipe_stage
+ */
+struct bootstage_pipe {
+	char name[PIPE_NAME_LEN];
+	struct bootstage_pipe_stat stat[BOOTSTAGE_PIPE_COUNT];
+};
+#endif
+
 struct bootstage_data {
 	uint rec_count;
 	uint next_id;
 	struct bootstage_record record[RECORD_COUNT];
+#if CONFIG_IS_ENABLED(BOOTSTAGE_PROFILE)
+	uint prof_count;
+	ulong prof_nested_us;	/* time in nested items of the current one */
+	struct bootstage_prof prof[PROF_COUNT];
+#endif
+#if CONFIG_IS_ENABLED(BOOTSTAGE_PIPELINE)
+	uint pipe_count;
+	uint pipe_cur;	/* 1 + index of the current image, 0 for none */
+	struct bootstage_pipe pipe_other;	/* stages not for any image */
+	struct bootstage_pipe pipe[PIPE_COUNT];
+#endif
 };
 
 enum {
 	BOOTSTAGE_VERSION	= 0,
 	BOOTSTAGE_MAGIC		= 0xb00757a3,
 	BOOTSTAGE_DIGITS	= 9,
+	BOOTSTAGE_PMU_DIGITS	= 12,
+	BOOTSTAGE_BYTE_DIGITS	= 12,
 };
 
 struct bootstage_hdr {
@@ -76,6 +154,17 @@ int bootstage_relocate(void)
 		data->record[i].name = ptr;
 		ptr += strlen(ptr) + 1;
 	}
+#if CONFIG_IS_ENABLED(BOOTSTAGE_PROFILE)
+	for (i = 0; i < data->prof_count; i++) {
+		const char *from = data->prof[i].name;
+
+		if (!from)
+			continue;
+		strcpy(ptr, from);
+		data->prof[i].name = ptr;
+		ptr += strlen(ptr) + 1;
+	}
+#endif
 
 	return 0;
 }
@@ -135,6 +224,9 @@ ulong bootstage_add_record(enum bootstage_id id, const char *name,
 			rec->name = name;
 			rec->flags = flags;
 			rec->id = id;
+#if CONFIG_IS_ENABLED(BOOTSTAGE_PMU)
+			pmu_counters_read(&rec->pmu);
+#endif
 		} else {
 			log_warning("Bootstage space exhausted\n");
 		}
@@ -198,11 +290,26 @@ uint32_t bootstage_start(enum bootstage_id id, const char *name)
 	if (rec) {
 		rec->start_us = start_us;
 		rec->name = name;
+#if CONFIG_IS_ENABLED(BOOTSTAGE_PMU)
+		pmu_counters_read(&rec->pmu_start);
+#endif
 	}
 
 	return start_us;
 }
 
+#if CONFIG_IS_ENABLED(BOOTSTAGE_PMU)
+/* Add the counts since bootstage_start() to an accumulated record */
+static void accum_pmu(struct bootstage_record *rec)
+{
+	struct pmu_counts now;
+
+	pmu_counters_read(&now);
+	rec->pmu.cycles += now.cycles - rec->pmu_start.cycles;
+	rec->pmu.cache_misses += now.cache_misses - rec->pmu_start.cache_misses;
+}
+#endif
+
 uint32_t bootstage_accum(enum bootstage_id id)
 {
 	struct bootstage_data *data = gd->bootstage;
@@ -213,10 +320,111 @@ uint32_t bootstage_accum(enum bootstage_id id)
 		return 0;
 	duration = (uint32_t)timer_get_boot_us() - rec->start_us;
 	rec->time_us += duration;
+#if CONFIG_IS_ENABLED(BOOTSTAGE_PMU)
+	accum_pmu(rec);
+#endif
 
 	return duration;
 }
 
+#if CONFIG_IS_ENABLED(BOOTSTAGE_PROFILE)
+void bootstage_prof_start(struct bootstage_prof_mark *mark)
+{
+	struct bootstage_data *data = gd->bootstage;
+
+	mark->start_us = timer_get_boot_us();
+	mark->outer_us = 0;
+	if (data) {
+		mark->outer_us = data->prof_nested_us;
+		data->prof_nested_us = 0;
+	}
+}
+
+void bootstage_prof_end(struct bootstage_prof_mark *mark,
+			enum bootstage_prof_type type, const char *name,
+			ulong addr)
+{
+	struct bootstage_data *data = gd->bootstage;
+	struct bootstage_prof *prof, *fastest;
+	ulong total, own;
+	int i;
+
+	/* The first initcalls run before bootstage is set up */
+	if (!data)
+		return;
+	total = timer_get_boot_us() - mark->start_us;
+	own = total > data->prof_nested_us ? total - data->prof_nested_us : 0;
+	data->prof_nested_us = mark->outer_us + total;
+
+	/* Once the table is full, replace the fastest entry */
+	if (data->prof_count < PROF_COUNT) {
+		prof = &data->prof[data->prof_count++];
+	} else {
+		fastest = data->prof;
+		for (i = 1, prof = data->prof + 1; i < PROF_COUNT; i++, prof++) {
+			if (prof->time_us < fastest->time_us)
+				fastest = prof;
+		}
+		if (own <= fastest->time_us)
+			return;
+		prof = fastest;
+	}
+	prof->name = name;
+	prof->addr = addr;
+	prof->time_us = own;
+	prof->type = type;
+}
+#endif
+
+#if CONFIG_IS_ENABLED(BOOTSTAGE_PIPELINE)
+void bootstage_pipe_image(const char *name)
+{
+	struct bootstage_data *data = gd->bootstage;
+	int i;
+
+	if (!data)
+		return;
+	data->pipe_cur = 0;
+	if (!name)
+		return;
+	for (i = 0; i < data->pipe_count; i++) {
+		if (!strncmp(data->pipe[i].name, name, PIPE_NAME_LEN - 1)) {
+			data->pipe_cur = i + 1;
+			return;
+		}
+	}
+
+	/* Once the table is full, further images are not counted separately */
+	if (data->pipe_count == PIPE_COUNT)
+		return;
+	strlcpy(data->pipe[data->pipe_count].name, name, PIPE_NAME_LEN);
+	data->pipe_cur = ++data->pipe_count;
+}
+
+ulong bootstage_pipe_start(void)
+{
+	return timer_get_boot_us();
+}
+
+void bootstage_pipe_end(enum bootstage_pipe_stage stage, ulong start_us,
+			ulong in_bytes, ulong out_bytes)
+{
+	struct bootstage_data *data = gd->bootstage;
+	struct bootstage_pipe *pipe;
+	struct bootstage_pipe_stat *stat;
+
+	if (!data)
+		return;
+	pipe = data->pipe_cur ? &data->pipe[data->pipe_cur - 1] :
+		&data->pipe_other;
+	stat = &pipe->stat[stage];
+	stat->time_us += timer_get_boot_us() - start_us;
+	stat->in_bytes += in_bytes;
+	stat->out_bytes += out_bytes ? out_bytes : in_bytes;
+	stat->count++;
+}
+#endif
+
 /**
  * Get a record name as a printable string
  *
@@ -238,7 +446,29 @@ static const char *get_record_name(char *buf, int len,
 	return buf;
 }
 
-static uint32_t print_time_record(struct bootstage_record *rec, uint32_t prev)
+#if CONFIG_IS_ENABLED(BOOTSTAGE_PMU)
+/**
+ * print_pmu() - Print the counts for a record
+ *
+ * @rec: Record to print
+ * @prev: Previous mark to subtract, or NULL to print the counts as they are
+ */
+static void print_pmu(const struct bootstage_record *rec,
+		      const struct bootstage_record *prev)
+{
+	u64 cycles = rec->pmu.cycles, misses = rec->pmu.cache_misses;
+
+	if (prev) {
+		cycles -= prev->pmu.cycles;
+		misses -= prev->pmu.cache_misses;
+	}
+	print_grouped_ull(cycles, BOOTSTAGE_PMU_DIGITS);
+	print_grouped_ull(misses, BOOTSTAGE_PMU_DIGITS);
+}
+#endif
+
+static uint32_t print_time_record(struct bootstage_record *rec, uint32_t prev,
+				  const struct bootstage_record *prev_rec)
 {
 	char buf[20];
 
@@ -249,6 +479,9 @@ static uint32_t print_time_record(struct bootstage_record *rec, uint32_t prev)
 		print_grouped_ull(rec->time_us, BOOTSTAGE_DIGITS);
 		print_grouped_ull(rec->time_us - prev, BOOTSTAGE_DIGITS);
 	}
+#if CONFIG_IS_ENABLED(BOOTSTAGE_PMU)
+	print_pmu(rec, prev_rec);
+#endif
 	printf("  %s\n", get_record_name(buf, sizeof(buf), rec));
 
 	return rec->time_us;
@@ -261,7 +494,218 @@ static int h_compare_record(const void *r1, const void *r2)
 	return rec1->time_us > rec2->time_us ? 1 : -1;
 }
 
+#if CONFIG_IS_ENABLED(BOOTSTAGE_PROFILE)
+static const char *const prof_type_name[] = {
+	[BOOTSTAGE_PROF_PROBE]		= "probe",
+	[BOOTSTAGE_PROF_INITCALL]	= "initcall",
+};
+
+/**
+ * get_prof_name() - Get a profile entry name as a printable string
+ *
+ * @buf: Buffer to put name if needed
+ * @len: Length of buffer
+ * @prof: Profile entry to get the name from
+ * Return: pointer to name, either from the entry or pointing to buf
+ */
+static const char *get_prof_name(char *buf, int len,
+				 const struct bootstage_prof *prof)
+{
+	if (prof->name)
+		return prof->name;
+	snprintf(buf, len, "%lx", prof->addr);
+
+	return buf;
+}
+
+/* Sort profile entries by decreasing time */
+static int h_compare_prof(const void *p1, const void *p2)
+{
+	const struct bootstage_prof *prof1 = p1, *prof2 = p2;
+
+	return prof1->time_us < prof2->time_us ? 1 : -1;
+}
+
+void bootstage_prof_report(int count)
+{
+	struct bootstage_data *data = gd->bootstage;
+	struct bootstage_prof *prof;
+	char buf[20];
+	int i;
+
+	qsort(data->prof, data->prof_count, sizeof(*prof), h_compare_prof);
+	count = min_t(int, count, data->prof_count);
+	printf("Slowest %d of %d profiled items, in microseconds:\n", count,
+	       data->prof_count);
+	printf("%11s  %-9s%s\n", "Time", "Type", "Name");
+	for (i = 0, prof = data->prof; i < count; i++, prof++) {
+		print_grouped_ull(prof->time_us, BOOTSTAGE_DIGITS);
+		printf("  %-9s%s\n", prof_type_name[prof->type],
+		       get_prof_name(buf, sizeof(buf), prof));
+	}
+}
+#endif
+
+#if CONFIG_IS_ENABLED(BOOTSTAGE_PIPELINE)
+static const char *const pipe_stage_name[BOOTSTAGE_PIPE_COUNT] = {
+	[BOOTSTAGE_PIPE_BLK]		= "blk-read",
+	[BOOTSTAGE_PIPE_FS]		= "fs-read",
+	[BOOTSTAGE_PIPE_HASH]		= "hash",
+	[BOOTSTAGE_PIPE_VERIFY]		= "verify",
+	[BOOTSTAGE_PIPE_DECOMP]		= "decomp",
+	[BOOTSTAGE_PIPE_COPY]		= "copy",
+};
+
+/**
+ * pipe_rate() - Work out the throughput of a stage
+ *
+ * @stat: Stage totals
+ * Return: bytes consumed per microsecond (i.e. MB/s), multiplied by 10
+ */
+static ulong pipe_rate(const struct bootstage_pipe_stat *stat)
+{
+	if (!stat->time_us)
+		return 0;
+
+	return div_u64((u64)stat->in_bytes * 10, stat->time_us);
+}
+
+/**
+ * pipe_ratio() - Work out the expansion ratio of a stage
+ *
+ * @stat: Stage totals
+ * Return: bytes produced per byte consumed, multiplied by 100
+ */
+static ulong pipe_ratio(const struct bootstage_pipe_stat *stat)
+{
+	if (!stat->in_bytes)
+		return 0;
+
+	return div_u64((u64)stat->out_bytes * 100, stat->in_bytes);
+}
+
+static void print_pipe(const struct bootstage_pipe *pipe, const char *name)
+{
+	const struct bootstage_pipe_stat *stat;
+	ulong val;
+	int i;
+
+	for (i = 0, stat = pipe->stat; i < BOOTSTAGE_PIPE_COUNT; i++, stat++) {
+		if (!stat->count)
+			continue;
+		if (name) {
+			printf("%s:\n", name);
+			name = NULL;
+		}
+		printf("  %-9s%6u", pipe_stage_name[i], stat->count);
+		print_grouped_ull(stat->time_us, BOOTSTAGE_DIGITS);
+		print_grouped_ull(stat->in_bytes, BOOTSTAGE_BYTE_DIGITS);
+		val = pipe_rate(stat);
+		printf("%7lu.%lu", val / 10, val % 10);
+		if (stat->out_bytes != stat->in_bytes) {
+			val = pipe_ratio(stat);
+			printf("%6lu.%02lux", val / 100, val % 100);
+		}
+		printf("\n");
+	}
+}
+
+void bootstage_pipe_report(void)
+{
+	struct bootstage_data *data = gd->bootstage;
+	int i;
+
+	printf("Boot pipeline, times in microseconds:\n");
+	printf("  %-9s%6s%11s%15s%9s%10s\n", "Stage", "Count", "Time",
+	       "Bytes", "MB/s", "Ratio");
+	for (i = 0; i < data->pipe_count; i++)
+		print_pipe(&data->pipe[i], data->pipe[i].name);
+	print_pipe(&data->pipe_other, "(no image)");
+}
+#endif
+
 #ifdef CONFIG_OF_LIBFDT
+#if CONFIG_IS_ENABLED(BOOTSTAGE_PIPELINE)
+/**
+ * add_pipe_devicetree() - Add the pipeline totals for an image to a device tree
+ *
+ * Each stage which ran gets a subnode with its totals
+ *
+ * @blob: Device tree blob
+ * @node: Node to add the stages to
+ * @pipe: Totals for the image
+ * Return: 0 if OK, -ve on error
+ */
+static int add_pipe_devicetree(void *blob, int node,
+			       const struct bootstage_pipe *pipe)
+{
+	const struct bootstage_pipe_stat *stat;
+	int i;
+
+	for (i = 0, stat = pipe->stat; i < BOOTSTAGE_PIPE_COUNT; i++, stat++) {
+		int subnode;
+
+		if (!stat->count)
+			continue;
+		subnode = fdt_add_subnode(blob, node, pipe_stage_name[i]);
+		if (subnode < 0)
+			return subnode;
+		if (fdt_setprop_cell(blob, subnode, "count", stat->count) ||
+		    fdt_setprop_cell(blob, subnode, "accum", stat->time_us) ||
+		    fdt_setprop_cell(blob, subnode, "in-bytes",
+				     stat->in_bytes) ||
+		    fdt_setprop_cell(blob, subnode, "out-bytes",
+				     stat->out_bytes))
+			return -EINVAL;
+	}
+
+	return 0;
+}
+
+/**
+ * add_pipeline_devicetree() - Add the boot-pipeline totals to a device tree
+ *
+ * This adds a 'pipeline' node with a numbered subnode for each image, plus an
+ * 'other' subnode for stages not attributed to any image
+ *
+ * @blob: Device tree blob
+ * @bootstage: Offset of the 'bootstage' node
+ * Return: 0 if OK, -ve on error
+ */
+static int add_pipeline_devicetree(void *blob, int bootstage)
+{
+	struct bootstage_data *data = gd->bootstage;
+	int pipeline, node, ret;
+	int i;
+
+	pipeline = fdt_add_subnode(blob, bootstage, "pipeline");
+	if (pipeline < 0)
+		return pipeline;
+
+	/* Add in reverse, as above, so the first image comes first */
+	node = fdt_add_subnode(blob, pipeline, "other");
+	if (node < 0)
+		return node;
+	ret = add_pipe_devicetree(blob, node, &data->pipe_other);
+	if (ret)
+		return ret;
+	for (i = data->pipe_count - 1; i >= 0; i--) {
+		struct bootstage_pipe *pipe = &data->pipe[i];
+
+		node = fdt_add_subnode(blob, pipeline, simple_itoa(i));
+		if (node < 0)
+			return node;
+		if (fdt_setprop_string(blob, node, "name", pipe->name))
+			return -EINVAL;
+		ret = add_pipe_devicetree(blob, node, pipe);
+		if (ret)
+			return ret;
+	}
+
+	return 0;
+}
+#endif
+
 /**
  * Add all bootstage timings to a device tree.
  *
@@ -314,6 +758,40 @@ static int add_bootstages_devicetree(struct fdt_header *blob)
 			return -EINVAL;
 	}
 
+#if CONFIG_IS_ENABLED(BOOTSTAGE_PROFILE)
+	if (data->prof_count) {
+		int profile;
+
+		profile = fdt_add_subnode(blob, bootstage, "profile");
+		if (profile < 0)
+			return -EINVAL;
+
+		/* As above, add in reverse so the slowest item comes first */
+		qsort(data->prof, data->prof_count, sizeof(data->prof[0]),
+		      h_compare_prof);
+		for (i = data->prof_count - 1; i >= 0; i--) {
+			struct bootstage_prof *prof = &data->prof[i];
+			int node;
+
+			node = fdt_add_subnode(blob, profile, simple_itoa(i));
+			if (node < 0)
+				break;
+			if (fdt_setprop_string(blob, node, "name",
+					       get_prof_name(buf, sizeof(buf),
+							     prof)) ||
+			    fdt_setprop_string(blob, node, "type",
+					       prof_type_name[prof->type]) ||
+			    fdt_setprop_cell(blob, node, "accum",
+					     prof->time_us))
+				return -EINVAL;
+		}
+	}
+#endif
+#if CONFIG_IS_ENABLED(BOOTSTAGE_PIPELINE)
+	if (add_pipeline_devicetree(blob, bootstage))
+		return -EINVAL;
+#endif
+
 	return 0;
 }
 
@@ -330,21 +808,27 @@ void bootstage_report(void)
 {
 	struct bootstage_data *data = gd->bootstage;
 	struct bootstage_record *rec = data->record;
+	struct bootstage_record *prev_rec;
 	uint32_t prev;
 	int i;
 
 	printf("Timer summary in microseconds (%d records):\n",
 	       data->rec_count);
-	printf("%11s%11s  %s\n", "Mark", "Elapsed", "Stage");
+	printf("%11s%11s", "Mark", "Elapsed");
+	if (CONFIG_IS_ENABLED(BOOTSTAGE_PMU))
+		printf("%15s%15s", "Cycles", "Cache misses");
+	printf("  %s\n", "Stage");
 
-	prev = print_time_record(rec, 0);
+	prev = print_time_record(rec, 0, NULL);
 
 	/* Sort records by increasing time */
 	qsort(data->record, data->rec_count, sizeof(*rec), h_compare_record);
 
-	for (i = 1, rec++; i < data->rec_count; i++, rec++) {
-		if (rec->id && !rec->start_us)
-			prev = print_time_record(rec, prev);
+	for (i = 1, prev_rec = rec++; i < data->rec_count; i++, rec++) {
+		if (rec->id && !rec->start_us) {
+			prev = print_time_record(rec, prev, prev_rec);
+			prev_rec = rec;
+		}
 	}
 	if (data->rec_count > RECORD_COUNT)
 		printf("Overflowed internal boot id table by %d entries\n"
@@ -354,7 +838,7 @@ void bootstage_report(void)
 	puts("\nAccumulated time:\n");
 	for (i = 0, rec = data->record; i < data->rec_count; i++, rec++) {
 		if (rec->start_us)
-			prev = print_time_record(rec, -1);
+			prev = print_time_record(rec, -1, NULL);
 	}
 }
 
@@ -405,7 +889,7 @@ int bootstage_stash(void *base, int size)
 
 	/* Write the records, silently stopping when we run out of space */
 	for (rec = data->record, i = 0; i < data->rec_count; i++, rec++)
-		append_data(&ptr, end, rec, sizeof(*rec));
+		append_data(&ptr, end, rec, STASH_REC_SIZE);
 
 	/* Write the name strings */
 	for (rec = data->record, i = 0; i < data->rec_count; i++, rec++) {
@@ -455,10 +939,10 @@ int bootstage_unstash(const void *base, int size)
 		return -ENOSPC;
 	}
 
-	if (hdr->count * sizeof(*rec) > hdr->size) {
+	if (hdr->count * STASH_REC_SIZE > hdr->size) {
 		debug("%s: Bootstage has %d records needing %lu bytes, but "
 			"only %d bytes is available\n", __func__, hdr->count,
-		      (ulong)hdr->count * sizeof(*rec), hdr->size);
+		      (ulong)hdr->count * STASH_REC_SIZE, hdr->size);
 		return -ENOSPC;
 	}
 
@@ -478,8 +962,16 @@ int bootstage_unstash(const void *base, int size)
 	ptr += sizeof(*hdr);
 
 	/* Read the records */
-	rec_size = hdr->count * sizeof(*data->record);
-	memcpy(data->record + data->rec_count, ptr, rec_size);
+	rec_size = hdr->count * STASH_REC_SIZE;
+	if (STASH_REC_SIZE == sizeof(*rec)) {
+		memcpy(data->record + data->rec_count, ptr, rec_size);
+	} else {
+		for (rec = data->record + data->rec_count, i = 0;
+		     i < hdr->count; i++, rec++) {
+			memset(rec, '\0', sizeof(*rec));
+			memcpy(rec, ptr + i * STASH_REC_SIZE, STASH_REC_SIZE);
+		}
+	}
 
 	/* Read the name strings */
 	ptr += rec_size;
@@ -526,6 +1018,12 @@ int bootstage_get_size(void)
 	for (rec = data->record, i = 0; i < data->rec_count;
 	     i++, rec++)
 		size += strlen(rec->name) + 1;
+#if CONFIG_IS_ENABLED(BOOTSTAGE_PROFILE)
+	for (i = 0; i < data->prof_count; i++) {
+		if (data->prof[i].name)
+			size += strlen(data->prof[i].name) + 1;
+	}
+#endif
 
 	return size;
 }
@@ -540,6 +1038,8 @@ int bootstage_init(bool first)
 		return -ENOMEM;
 	data = gd->bootstage;
 	memset(data, '\0', size);
+	if (CONFIG_IS_ENABLED(BOOTSTAGE_PMU))
+		pmu_counters_init();
 	if (first) {
 		data->next_id = BOOTSTAGE_ID_USER;
 		bootstage_add_record(BOOTSTAGE_ID_AWAKE, "reset", 0, 0);
@@ -11,12 +11,58 @@
 #include <errno.h>
 #include <bouncebuf.h>
 #include <asm/cache.h>
+#include <asm/global_data.h>
 #include <linux/dma-mapping.h>
+#include <linux/sizes.h>
 
-static int addr_aligned(struct bounce_buffer *state)
+DECLARE_GLOBAL_DATA_PTR;
+
+/*
+ * A buffer kept from an earlier session, so that drivers which bounce every
+ * transfer do not need to allocate and free one each time. Only one session
+ * can use it at once; any others allocate their own.
+ */
+static void *pool_buf __section(".data");
+static size_t pool_size __section(".data");
+static size_t pool_align __section(".data");
+static bool pool_busy __section(".data");
+
+static void *pool_get(size_t len, size_t alignment)
 {
-	const ulong align_mask = ARCH_DMA_MINALIGN - 1;
+	if (pool_buf && pool_size >= len && pool_align >= alignment &&
+	    !pool_busy) {
+		pool_busy = true;
+		return pool_buf;
+	}
+
+	return memalign(alignment, len);
+}
 
+static void pool_put(void *buf, size_t len, size_t alignment)
+{
+	if (buf == pool_buf) {
+		pool_busy = false;
+		return;
+	}
+
+	/*
+	 * Keep the largest buffer within the limit, but not one from the
+	 * pre-relocation heap, since that does not survive relocation
+	 */
+	if (pool_busy || len <= pool_size ||
+	    len > CONFIG_BOUNCE_BUFFER_POOL_SIZE * SZ_1K ||
+	    !(gd->flags & GD_FLG_FULL_MALLOC_INIT)) {
+		free(buf);
+		return;
+	}
+	free(pool_buf);
+	pool_buf = buf;
+	pool_size = len;
+	pool_align = alignment;
+}
+
+static int check_aligned(struct bounce_buffer *state, ulong align_mask)
+{
 	/* Check if start is aligned */
 	if ((ulong)state->user_buffer & align_mask) {
 		debug("Unaligned buffer address %p\n", state->user_buffer);
@@ -33,6 +79,22 @@ static int addr_aligned(struct bounce_buffer *state)
 	return 1;
 }
 
+static int addr_aligned(struct bounce_buffer *state)
+{
+	return check_aligned(state, ARCH_DMA_MINALIGN - 1);
+}
+
+/*
+ * Without cache maintenance for DMA, the CPU puts no constraints on the buffer
+ * so only the controller's own alignment needs to be met
+ */
+static bool dma_needs_cache_align(void)
+{
+	return !CONFIG_IS_ENABLED(SYS_DCACHE_OFF) &&
+		!IS_ENABLED(CONFIG_SYS_DISABLE_DCACHE_OPS) &&
+		!IS_ENABLED(CONFIG_X86) && !IS_ENABLED(CONFIG_SANDBOX);
+}
+
 int bounce_buffer_start_extalign(struct bounce_buffer *state, void *data,
 				 size_t len, unsigned int flags,
 				 size_t alignment,
@@ -43,10 +105,10 @@ int bounce_buffer_start_extalign(struct bounce_buffer *state, void *data,
 	state->len = len;
 	state->len_aligned = roundup(len, alignment);
 	state->flags = flags;
+	state->alignment = alignment;
 
 	if (!addr_is_aligned(state)) {
-		state->bounce_buffer = memalign(alignment,
-						state->len_aligned);
+		state->bounce_buffer = pool_get(state->len_aligned, alignment);
 		if (!state->bounce_buffer)
 			return -ENOMEM;
 
@@ -74,6 +136,33 @@ int bounce_buffer_start(struct bounce_buffer *state, void *data,
 					    addr_aligned);
 }
 
+int bounce_buffer_start_align(struct bounce_buffer *state, void *data,
+			      size_t len, unsigned int flags,
+			      unsigned int dma_align)
+{
+	int ret;
+
+	if (dma_needs_cache_align())
+		return bounce_buffer_start(state, data, len, flags);
+
+	state->user_buffer = data;
+	state->len = len;
+	state->len_aligned = len;
+	if (check_aligned(state, dma_align - 1)) {
+		state->bounce_buffer = data;
+		state->flags = flags;
+		state->alignment = dma_align;
+		dma_map_single(data, len, DMA_BIDIRECTIONAL);
+
+		return 0;
+	}
+	ret = bounce_buffer_start(state, data, len, flags);
+	if (ret)
+		return log_msg_ret("bba", ret);
+
+	return 0;
+}
+
 int bounce_buffer_stop(struct bounce_buffer *state)
 {
 	if (state->flags & GEN_BB_WRITE) {
@@ -89,7 +178,7 @@ int bounce_buffer_stop(struct bounce_buffer *state)
 	if (state->flags & GEN_BB_WRITE)
 		memcpy(state->user_buffer, state->bounce_buffer, state->len);
 
-	free(state->bounce_buffer);
+	pool_put(state->bounce_buffer, state->len_aligned, state->alignment);
 
 	return 0;
 }
@@ -475,7 +475,9 @@ static int parse_string(o_string *dest, struct p_context *ctx, const char *src);
 #endif
 static int parse_stream(o_string *dest, struct p_context *ctx, struct in_str *input0, int end_trigger);
 /*   setup: */
-static int parse_stream_outer(struct in_str *inp, int flag);
+struct parse_cache;
+static int parse_stream_outer(struct in_str *inp, int flag,
+			      struct parse_cache *rec);
 #ifndef __U_BOOT__
 static int parse_string_outer(const char *s, int flag);
 static int parse_file_outer(FILE *f);
@@ -3173,9 +3175,178 @@ static void update_ifs_map(void)
 	mapset(ifs, 2);            /* also flow through if quoted */
 }
 
+#ifdef CONFIG_HUSH_PARSE_CACHE
+/* Number of scripts whose parsed form is kept */
+#define PARSE_CACHE_SIZE	8
+
+/**
+ * struct parse_cache - Parsed form of a script
+ *
+ * A script is parsed and run one list at a time, so this holds each list
+ * parsed, in order. The lists here are never run themselves, since running a
+ * list changes it; a copy of each is run instead.
+ *
+ * @text: Copy of the script, NULL if this entry is not in use
+ * @flag: Flags the script was parsed with
+ * @lists: Parsed lists
+ * @count: Number of lists in @lists
+ * @valid: true if the whole script was parsed and run without error, so that
+ *	@lists can be used
+ * @users: Number of callers using @lists or filling them in; the entry cannot
+ *	be reused while this is non-zero
+ * @last_used: Value of parse_cache_seq when this entry was last used
+ */
+struct parse_cache {
+	char *text;
+	int flag;
+	struct pipe **lists;
+	int count;
+	bool valid;
+	int users;
+	uint last_used;
+};
+
+static struct parse_cache parse_cache[PARSE_CACHE_SIZE];
+static uint parse_cache_seq;
+
+/* Make a copy of a parsed list, which can be run and freed */
+static struct pipe *pipe_list_dup(struct pipe *head)
+{
+	struct pipe *first = NULL, **nextp = &first;
+	struct pipe *pi, *copy;
+	int i, a;
+
+	for (pi = head; pi; pi = pi->next) {
+		copy = xmalloc(sizeof(*copy));
+		*copy = *pi;
+		copy->next = NULL;
+		copy->progs = xmalloc((pi->num_progs + 1) * sizeof(*copy->progs));
+		memset(copy->progs, '\0',
+		       (pi->num_progs + 1) * sizeof(*copy->progs));
+		for (i = 0; i < pi->num_progs; i++) {
+			struct child_prog *src = &pi->progs[i];
+			struct child_prog *dst = &copy->progs[i];
+
+			*dst = *src;
+			if (src->argv) {
+				dst->argv = xmalloc((src->argc + 1) *
+						    sizeof(*dst->argv));
+				dst->argv_nonnull = xmalloc((src->argc + 1) *
+						sizeof(*dst->argv_nonnull));
+				for (a = 0; a < src->argc; a++)
+					dst->argv[a] = xstrdup(src->argv[a]);
+				dst->argv[a] = NULL;
+				memcpy(dst->argv_nonnull, src->argv_nonnull,
+				       (src->argc + 1) *
+				       sizeof(*dst->argv_nonnull));
+			}
+			if (src->group)
+				dst->group = pipe_list_dup(src->group);
+		}
+		*nextp = copy;
+		nextp = &copy->next;
+	}
+
+	return first;
+}
+
+static void parse_cache_clear(struct parse_cache *entry)
+{
+	int i;
+
+	for (i = 0; i < entry->count; i++)
+		free_pipe_list(entry->lists[i], 0);
+	free(entry->lists);
+	free(entry->text);
+	memset(entry, '\0', sizeof(*entry));
+}
+
+/**
+ * parse_cache_get() - Find the parsed form of a script, or make room for it
+ *
+ * @s: Script
+ * @flag: Flags to parse it with
+ * Return: entry, with @users incremented, or NULL if there is no room. The
+ *	entry is valid if the script has been parsed before; otherwise the
+ *	caller should fill it in while parsing the script
+ */
+static struct parse_cache *parse_cache_get(const char *s, int flag)
+{
+	struct parse_cache *entry, *victim = NULL;
+	int i;
+
+	if (!(gd->flags & GD_FLG_FULL_MALLOC_INIT))
+		return NULL;
+
+	for (i = 0; i < PARSE_CACHE_SIZE; i++) {
+		entry = &parse_cache[i];
+		if (entry->valid && entry->flag == flag &&
+		    !strcmp(entry->text, s)) {
+			entry->users++;
+			entry->last_used = ++parse_cache_seq;
+			return entry;
+		}
+		if (!entry->users &&
+		    (!victim || entry->last_used < victim->last_used))
+			victim = entry;
+	}
+	if (!victim)
+		return NULL;
+
+	parse_cache_clear(victim);
+	victim->text = strdup(s);
+	if (!victim->text)
+		return NULL;
+	victim->flag = flag;
+	victim->users = 1;
+	victim->last_used = ++parse_cache_seq;
+
+	return victim;
+}
+
+/* Record a list parsed from the script, before it is run */
+static void parse_cache_add(struct parse_cache *rec, struct pipe *list)
+{
+	struct pipe **lists;
+
+	lists = realloc(rec->lists, (rec->count + 1) * sizeof(*lists));
+	if (!lists) {
+		rec->text[0] = '\0';	/* give up on this script */
+		return;
+	}
+	rec->lists = lists;
+	rec->lists[rec->count++] = pipe_list_dup(list);
+}
+
+/**
+ * parse_cache_run() - Run a script which was parsed before
+ *
+ * This behaves the same as parse_stream_outer() for a script which parses
+ * without error
+ *
+ * @entry: Parsed form of the script
+ * Return: as parse_stream_outer()
+ */
+static int parse_cache_run(struct parse_cache *entry)
+{
+	int i, code = 0;
+
+	for (i = 0; i < entry->count; i++) {
+		code = run_list(pipe_list_dup(entry->lists[i]));
+		if (code == -2)
+			return -2;
+		if (code == -1)
+			flag_repeat = 0;
+	}
+
+	return code != 0 ? 1 : 0;
+}
+#endif /* CONFIG_HUSH_PARSE_CACHE */
+
 /* most recursion does not come through here, the exeception is
  * from builtin_source() */
-static int parse_stream_outer(struct in_str *inp, int flag)
+static int parse_stream_outer(struct in_str *inp, int flag,
+			      struct parse_cache *rec)
 {
 
 	struct p_context ctx;
@@ -3207,8 +3378,17 @@ static int parse_stream_outer(struct in_str *inp, int flag)
 #ifndef __U_BOOT__
 			run_list(ctx.list_head);
 #else
+#ifdef CONFIG_HUSH_PARSE_CACHE
+			if (rec)
+				parse_cache_add(rec, ctx.list_head);
+#endif
 			code = run_list(ctx.list_head);
 			if (code == -2) {	/* exit */
+#ifdef CONFIG_HUSH_PARSE_CACHE
+				/* the rest of the script was not parsed */
+				if (rec)
+					rec->text[0] = '\0';
+#endif
 				b_free(&temp);
 				code = 0;
 				/* XXX hackish way to not allow exit from main loop */
@@ -3230,6 +3410,10 @@ static int parse_stream_outer(struct in_str *inp, int flag)
 			    flag_repeat = 0;
 #endif
 		} else {
+#ifdef CONFIG_HUSH_PARSE_CACHE
+			if (rec)
+				rec->text[0] = '\0';
+#endif
 			if (ctx.old_flag != 0) {
 				free(ctx.stack);
 				b_reset(&temp);
@@ -3261,6 +3445,7 @@ int parse_string_outer(const char *s, int flag)
 #endif	/* __U_BOOT__ */
 {
 	struct in_str input;
+	struct parse_cache *rec = NULL;
 	int rcode;
 #ifdef __U_BOOT__
 	char *p = NULL;
@@ -3268,22 +3453,40 @@ int parse_string_outer(const char *s, int flag)
 		return 1;
 	if (!*s)
 		return 0;
+#ifdef CONFIG_HUSH_PARSE_CACHE
+	/* reparsed strings come from variables, so are rarely the same */
+	if (!(flag & FLAG_REPARSING))
+		rec = parse_cache_get(s, flag);
+	if (rec && rec->valid) {
+		rcode = parse_cache_run(rec);
+		rec->users--;
+		return rcode == -2 ? last_return_code : rcode;
+	}
+#endif
 	if (!(p = strchr(s, '\n')) || *++p) {
 		p = xmalloc(strlen(s) + 2);
 		strcpy(p, s);
 		strcat(p, "\n");
 		setup_string_in_str(&input, p);
-		rcode = parse_stream_outer(&input, flag);
+		rcode = parse_stream_outer(&input, flag, rec);
 		free(p);
-		return rcode == -2 ? last_return_code : rcode;
 	} else {
 #endif
 	setup_string_in_str(&input, s);
-	rcode = parse_stream_outer(&input, flag);
-	return rcode == -2 ? last_return_code : rcode;
+	rcode = parse_stream_outer(&input, flag, rec);
 #ifdef __U_BOOT__
 	}
 #endif
+#ifdef CONFIG_HUSH_PARSE_CACHE
+	if (rec) {
+		rec->users--;
+		if (*rec->text)
+			rec->valid = true;
+		else
+			parse_cache_clear(rec);
+	}
+#endif
+	return rcode == -2 ? last_return_code : rcode;
 }
 
 #ifndef __U_BOOT__
@@ -3299,7 +3502,7 @@ int parse_file_outer(void)
 #else
 	setup_file_in_str(&input);
 #endif
-	rcode = parse_stream_outer(&input, FLAG_PARSE_SEMICOLON);
+	rcode = parse_stream_outer(&input, FLAG_PARSE_SEMICOLON, NULL);
 	return rcode == -2 ? last_return_code : rcode;
 }
 
@@ -15,7 +15,9 @@
 #include <env.h>
 #include <image.h>
 #include <log.h>
+#include <malloc.h>
 #include <mapmem.h>
+#include <sort.h>
 #include <time.h>
 #include <asm/global_data.h>
 #include <linux/ctype.h>
@@ -126,10 +128,105 @@ struct cmd_tbl *find_cmd_tbl(const char *cmd, struct cmd_tbl *table,
 	return NULL;	/* not found or ambiguous command */
 }
 
+#ifdef CONFIG_CMDLINE
+static int cmd_index_cmp(const void *a, const void *b)
+{
+	const struct cmd_tbl *const *cmd_a = a, *const *cmd_b = b;
+
+	return strcmp((*cmd_a)->name, (*cmd_b)->name);
+}
+
+/**
+ * cmd_index_get() - Get the list of commands, sorted by name
+ *
+ * The linker list is sorted by symbol name, which is not always the same as
+ * the command name (e.g. for "?"), so the index is built the first time it is
+ * needed, once malloc() is fully available
+ *
+ * Return: array of pointers to the commands, or NULL if not available
+ */
+static struct cmd_tbl **cmd_index_get(void)
+{
+	static struct cmd_tbl **cmd_index;
+	struct cmd_tbl *start;
+	int i, count;
+
+	if (!(gd->flags & GD_FLG_FULL_MALLOC_INIT))
+		return NULL;
+	if (cmd_index)
+		return cmd_index;
+
+	start = ll_entry_start(struct cmd_tbl, cmd);
+	count = ll_entry_count(struct cmd_tbl, cmd);
+	cmd_index = malloc(count * sizeof(*cmd_index));
+	if (!cmd_index)
+		return NULL;
+	for (i = 0; i < count; i++)
+		cmd_index[i] = start + i;
+	qsort(cmd_index, count, sizeof(*cmd_index), cmd_index_cmp);
+
+	return cmd_index;
+}
+
+/**
+ * find_cmd_index() - Find a command using the sorted index
+ *
+ * This behaves the same as find_cmd_tbl() on the whole command table: a
+ * command whose name matches in full is returned, otherwise the only command
+ * whose name starts with @cmd
+ *
+ * @cmd: Command name, possibly abbreviated, possibly with a size suffix
+ * @cmd_index: Sorted index from cmd_index_get()
+ * @count: Number of commands
+ * Return: command, or NULL if none or ambiguous
+ */
+static struct cmd_tbl *find_cmd_index(const char *cmd,
+				      struct cmd_tbl **cmd_index, int count)
+{
+	struct cmd_tbl *found = NULL;
+	int lo = 0, hi = count;
+	const char *p;
+	int len;
+
+	/* Compare command name only until first dot, as in find_cmd_tbl() */
+	len = ((p = strchr(cmd, '.')) == NULL) ? strlen(cmd) : (p - cmd);
+
+	/* Find the first command which does not sort before @cmd */
+	while (lo < hi) {
+		int mid = (lo + hi) / 2;
+
+		if (strncmp(cmd_index[mid]->name, cmd, len) < 0)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+
+	/* The matches follow, with a full match (the shortest) first */
+	for (; lo < count && !strncmp(cmd_index[lo]->name, cmd, len); lo++) {
+		if (!cmd_index[lo]->name[len])
+			return cmd_index[lo];
+		if (found)
+			return NULL;	/* ambiguous */
+		found = cmd_index[lo];
+	}
+
+	return found;
+}
+#endif /* CONFIG_CMDLINE */
+
 struct cmd_tbl *find_cmd(const char *cmd)
 {
 	struct cmd_tbl *start = ll_entry_start(struct cmd_tbl, cmd);
 	const int len = ll_entry_count(struct cmd_tbl, cmd);
+
+#ifdef CONFIG_CMDLINE
+	struct cmd_tbl **cmd_index;
+
+	cmd_index = cmd_index_get();
+	if (cmd && cmd_index)
+		return find_cmd_index(cmd, cmd_index, len);
+#endif
+
 	return find_cmd_tbl(cmd, start, len);
 }
 
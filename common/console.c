@@ -5,12 +5,14 @@
  */
 
 #include <console.h>
+#include <cpu_func.h>
 #include <debug_uart.h>
 #include <display_options.h>
 #include <dm.h>
 #include <env.h>
 #include <stdarg.h>
 #include <iomux.h>
+#include <log.h>
 #include <malloc.h>
 #include <mapmem.h>
 #include <os.h>
@@ -524,6 +526,7 @@ int fgetc(int file)
 			 */
 			if (IS_ENABLED(CONFIG_WATCHDOG))
 				udelay(1);
+			cpu_idle();
 		}
 	}
 
@@ -778,6 +781,8 @@ void flush(void)
 	if (!gd)
 		return;
 
+	log_defer_flush();
+
 	/* sandbox can send characters to stdout before it has a console */
 	if (IS_ENABLED(CONFIG_SANDBOX) && !(gd->flags & GD_FLG_SERIAL_READY)) {
 		os_flush();
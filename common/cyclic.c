@@ -45,6 +45,9 @@ struct cyclic_info *cyclic_register(cyclic_func_t func, uint64_t delay_us,
 	cyclic->start_time_us = timer_get_us();
 	hlist_add_head(&cyclic->list, cyclic_get_list());
 
+	/* It is due straight away */
+	gd->cyclic_next = cyclic->start_time_us;
+
 	return cyclic;
 }
 
@@ -60,19 +63,29 @@ void cyclic_run(void)
 {
 	struct cyclic_info *cyclic;
 	struct hlist_node *tmp;
-	uint64_t now, cpu_time;
+	uint64_t now, cpu_time, next;
 
 	/* Prevent recursion */
 	if (gd->flags & GD_FLG_CYCLIC_RUNNING)
 		return;
 
+	/* Nothing to do until the first function is due */
+	if (hlist_empty(cyclic_get_list()))
+		return;
+	now = timer_get_us();
+	if (time_before64(now, gd->cyclic_next))
+		return;
+
 	gd->flags |= GD_FLG_CYCLIC_RUNNING;
+
+	/* A function registered by a cyclic function lowers this again */
+	next = now + (1ULL << 62);
+	gd->cyclic_next = next;
 	hlist_for_each_entry_safe(cyclic, tmp, cyclic_get_list(), list) {
 		/*
 		 * Check if this cyclic function needs to get called, e.g.
 		 * do not call the cyclic func too often
 		 */
-		now = timer_get_us();
 		if (time_after_eq64(now, cyclic->next_call)) {
 			/* Call cyclic function and account it's cpu-time */
 			cyclic->next_call = now + cyclic->delay_us;
@@ -80,6 +93,7 @@ void cyclic_run(void)
 			cyclic->run_cnt++;
 			cpu_time = timer_get_us() - now;
 			cyclic->cpu_time_us += cpu_time;
+			now += cpu_time;
 
 			/* Check if cpu-time exceeds max allowed time */
 			if ((cpu_time > CONFIG_CYCLIC_MAX_CPU_TIME_US) &&
@@ -95,7 +109,11 @@ void cyclic_run(void)
 				cyclic->already_warned = true;
 			}
 		}
+		if (time_before64(cyclic->next_call, next))
+			next = cyclic->next_call;
 	}
+	if (time_before64(next, gd->cyclic_next))
+		gd->cyclic_next = next;
 	gd->flags &= ~GD_FLG_CYCLIC_RUNNING;
 }
 
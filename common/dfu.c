@@ -103,6 +103,9 @@ int run_usb_dnl_gadget(int usbctrl_index, char *usb_dnl_gadget)
 		if (dfu_reinit_needed)
 			goto exit;
 
+		/* Write buffered data while the host sends more */
+		dfu_write_pending();
+
 		schedule();
 		dm_usb_gadget_handle_interrupts(udc);
 	}
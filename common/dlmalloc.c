@@ -17,6 +17,7 @@
 
 #include <malloc.h>
 #include <asm/io.h>
+#include <linux/errno.h>
 #include <valgrind/memcheck.h>
 
 #ifdef DEBUG
@@ -620,11 +621,14 @@ void *sbrk(ptrdiff_t increment)
 	return (void *)old;
 }
 
+static void slab_reset(void);
+
 void mem_malloc_init(ulong start, ulong size)
 {
 	mem_malloc_start = start;
 	mem_malloc_end = start + size;
 	mem_malloc_brk = start;
+	slab_reset();
 
 #ifdef CONFIG_SYS_MALLOC_DEFAULT_TO_INIT
 	malloc_init();
@@ -1284,11 +1288,10 @@ static void malloc_extend_top(nb) INTERNAL_SIZE_T nb;
 
 */
 
-STATIC_IF_MCHECK
 #if __STD_C
-Void_t* mALLOc_impl(size_t bytes)
+static Void_t* mALLOc_chunk(size_t bytes)
 #else
-Void_t* mALLOc_impl(bytes) size_t bytes;
+static Void_t* mALLOc_chunk(bytes) size_t bytes;
 #endif
 {
   mchunkptr victim;                  /* inspected/selected chunk */
@@ -1570,6 +1573,185 @@ Void_t* mALLOc_impl(bytes) size_t bytes;
 */
 
 
+/*
+  Slab front-end
+
+  Driver model, libfdt helpers and filesystems make many small allocations,
+  each of which costs a chunk header and a bin search above. Requests of up
+  to SLAB_MAX_SIZE bytes are instead served from per-size-class free lists,
+  backed by a fixed arena of 4KB pages taken from the heap on first use.
+  Each page belongs to one class, so objects need no header and free() can
+  find the class from the address alone. Pages are never returned to the
+  heap. When the arena has no free page left, requests fall back to the
+  allocator above.
+*/
+
+#if CONFIG_IS_ENABLED(SYS_MALLOC_SLAB)
+
+#define SLAB_PAGE_SIZE	4096
+#define SLAB_PAGES	(CONFIG_SYS_MALLOC_SLAB_SIZE / SLAB_PAGE_SIZE)
+#define SLAB_MAX_SIZE	256
+
+struct slab_obj {
+	struct slab_obj *next;
+};
+
+static const unsigned short slab_size[] = {
+	16, 32, 48, 64, 96, 128, 192, SLAB_MAX_SIZE
+};
+
+#define SLAB_CLASSES	ARRAY_SIZE(slab_size)
+
+static char *slab_base;		/* arena, or NULL if not set up */
+static bool slab_failed;	/* arena could not be allocated */
+static unsigned int slab_pages_used;
+static unsigned char slab_page_class[SLAB_PAGES];
+static struct slab_obj *slab_free_list[SLAB_CLASSES];
+static struct malloc_slab_stats slab_stats[SLAB_CLASSES];
+
+static void slab_reset(void)
+{
+	slab_base = NULL;
+	slab_failed = false;
+	slab_pages_used = 0;
+	memset(slab_free_list, '\0', sizeof(slab_free_list));
+	memset(slab_stats, '\0', sizeof(slab_stats));
+}
+
+static inline bool slab_owns(Void_t *mem)
+{
+	return slab_base && (char *)mem >= slab_base &&
+		(char *)mem < slab_base + SLAB_PAGES * SLAB_PAGE_SIZE;
+}
+
+static int slab_class(size_t bytes)
+{
+	int class;
+
+	for (class = 0; slab_size[class] < bytes; class++)
+		;
+
+	return class;
+}
+
+/* Carve a new page into objects for a class; returns false if none left */
+static bool slab_grow(int class)
+{
+	unsigned int size = slab_size[class];
+	struct slab_obj **tail = &slab_free_list[class];
+	char *page, *obj;
+
+	if (slab_pages_used == SLAB_PAGES)
+		return false;
+
+	page = slab_base + slab_pages_used * SLAB_PAGE_SIZE;
+	slab_page_class[slab_pages_used++] = class;
+	slab_stats[class].pages++;
+	for (obj = page; obj + size <= page + SLAB_PAGE_SIZE; obj += size) {
+		*tail = (struct slab_obj *)obj;
+		tail = &(*tail)->next;
+	}
+	*tail = NULL;
+
+	return true;
+}
+
+static Void_t *slab_alloc(size_t bytes)
+{
+	struct slab_obj *obj;
+	int class;
+
+	if (!slab_base) {
+		if (slab_failed)
+			return NULL;
+		slab_base = mALLOc_chunk(SLAB_PAGES * SLAB_PAGE_SIZE);
+		if (!slab_base) {
+			slab_failed = true;
+			return NULL;
+		}
+	}
+
+	class = slab_class(bytes);
+	obj = slab_free_list[class];
+	if (!obj) {
+		if (!slab_grow(class)) {
+			slab_stats[class].fallbacks++;
+			return NULL;
+		}
+		obj = slab_free_list[class];
+	}
+	slab_free_list[class] = obj->next;
+	slab_stats[class].in_use++;
+	slab_stats[class].allocs++;
+
+	return obj;
+}
+
+static int slab_obj_class(Void_t *mem)
+{
+	return slab_page_class[((char *)mem - slab_base) / SLAB_PAGE_SIZE];
+}
+
+static void slab_free(Void_t *mem)
+{
+	struct slab_obj *obj = mem;
+	int class = slab_obj_class(mem);
+
+	obj->next = slab_free_list[class];
+	slab_free_list[class] = obj;
+	slab_stats[class].in_use--;
+}
+
+int malloc_slab_get_stats(int class, struct malloc_slab_stats *stats)
+{
+	if (class < 0 || class >= SLAB_CLASSES)
+		return -ENOENT;
+	*stats = slab_stats[class];
+	stats->size = slab_size[class];
+
+	return 0;
+}
+
+#else
+
+static inline void slab_reset(void) {}
+static inline bool slab_owns(Void_t *mem) { return false; }
+static inline Void_t *slab_alloc(size_t bytes) { return NULL; }
+static inline void slab_free(Void_t *mem) {}
+static inline int slab_obj_class(Void_t *mem) { return 0; }
+static const unsigned short slab_size[] = { 0 };
+#define SLAB_MAX_SIZE	0
+
+int malloc_slab_get_stats(int class, struct malloc_slab_stats *stats)
+{
+	return -ENOSYS;
+}
+
+#endif /* SYS_MALLOC_SLAB */
+
+STATIC_IF_MCHECK
+#if __STD_C
+Void_t* mALLOc_impl(size_t bytes)
+#else
+Void_t* mALLOc_impl(bytes) size_t bytes;
+#endif
+{
+	/*
+	 * Allocation-failure tests count calls to the allocator above, so
+	 * leave the slab out of the picture while they run
+	 */
+	if (bytes && bytes <= SLAB_MAX_SIZE &&
+	    (gd->flags & GD_FLG_FULL_MALLOC_INIT) &&
+	    !(CONFIG_IS_ENABLED(UNIT_TEST) && malloc_testing)) {
+		Void_t *mem = slab_alloc(bytes);
+
+		if (mem)
+			return mem;
+	}
+
+	return mALLOc_chunk(bytes);
+}
+
 STATIC_IF_MCHECK
 #if __STD_C
 void fREe_impl(Void_t* mem)
@@ -1589,9 +1771,9 @@ void fREe_impl(mem) Void_t* mem;
   int       islr;      /* track whether merging with last_remainder */
 
 #if CONFIG_IS_ENABLED(SYS_MALLOC_F)
-	/* free() is a no-op - all the memory will be freed on relocation */
+	/* Early pool: all of it is dropped on relocation anyway */
 	if (!(gd->flags & GD_FLG_FULL_MALLOC_INIT)) {
-		VALGRIND_FREELIKE_BLOCK(mem, SIZE_SZ);
+		free_simple(mem);
 		return;
 	}
 #endif
@@ -1599,6 +1781,11 @@ void fREe_impl(mem) Void_t* mem;
   if (mem == NULL)                              /* free(0) has no effect */
     return;
 
+  if (slab_owns(mem)) {
+    slab_free(mem);
+    return;
+  }
+
   p = mem2chunk(mem);
   hd = p->size;
 
@@ -1759,6 +1946,20 @@ Void_t* rEALLOc_impl(oldmem, bytes) Void_t* oldmem; size_t bytes;
 	}
 #endif
 
+  if (slab_owns(oldmem))
+  {
+    size_t oldbytes = slab_size[slab_obj_class(oldmem)];
+
+    if (bytes <= oldbytes)
+      return oldmem;
+    newmem = mALLOc_impl(bytes);
+    if (newmem == NULL)
+      return NULL;
+    MALLOC_COPY(newmem, oldmem, oldbytes);
+    slab_free(oldmem);
+    return newmem;
+  }
+
   newp    = oldp    = mem2chunk(oldmem);
   newsize = oldsize = chunksize(oldp);
 
@@ -1775,7 +1976,7 @@ Void_t* rEALLOc_impl(oldmem, bytes) Void_t* oldmem; size_t bytes;
     /* Note the extra SIZE_SZ overhead. */
     if(oldsize - SIZE_SZ >= nb) return oldmem; /* do nothing */
     /* Must alloc, copy, free. */
-    newmem = mALLOc_impl(bytes);
+    newmem = mALLOc_chunk(bytes);
     if (!newmem)
 	return NULL; /* propagate failure */
     MALLOC_COPY(newmem, oldmem, oldsize - 2*SIZE_SZ);
@@ -1886,7 +2087,7 @@ Void_t* rEALLOc_impl(oldmem, bytes) Void_t* oldmem; size_t bytes;
 
     /* Must allocate */
 
-    newmem = mALLOc_impl (bytes);
+    newmem = mALLOc_chunk (bytes);
 
     if (newmem == NULL)  /* propagate failure */
       return NULL;
@@ -1992,7 +2193,7 @@ Void_t* mEMALIGn_impl(alignment, bytes) size_t alignment; size_t bytes;
   /* Call malloc with worst case padding to hit alignment. */
 
   nb = request2size(bytes);
-  m  = (char*)(mALLOc_impl(nb + alignment + MINSIZE));
+  m  = (char*)(mALLOc_chunk(nb + alignment + MINSIZE));
 
   /*
   * The attempt to over-allocate (with a size large enough to guarantee the
@@ -2008,7 +2209,7 @@ Void_t* mEMALIGn_impl(alignment, bytes) size_t alignment; size_t bytes;
      * Use bytes not nb, since mALLOc internally calls request2size too, and
      * each call increases the size to allocate, to account for the header.
      */
-    m  = (char*)(mALLOc_impl(bytes));
+    m  = (char*)(mALLOc_chunk(bytes));
     /* Aligned -> return it */
     if ((((unsigned long)(m)) % alignment) == 0)
       return m;
@@ -2019,7 +2220,7 @@ Void_t* mEMALIGn_impl(alignment, bytes) size_t alignment; size_t bytes;
     fREe_impl(m);
     /* Add in extra bytes to match misalignment of unexpanded allocation */
     extra = alignment - (((unsigned long)(m)) % alignment);
-    m  = (char*)(mALLOc_impl(bytes + extra));
+    m  = (char*)(mALLOc_chunk(bytes + extra));
     /*
      * m might not be the same as before. Validate that the previous value of
      * extra still works for the current value of m.
@@ -2178,6 +2379,10 @@ Void_t* cALLOc_impl(n, elem_size) size_t n; size_t elem_size;
 		return mem;
 	}
 #endif
+    if (slab_owns(mem)) {
+      memset(mem, 0, sz);
+      return mem;
+    }
     p = mem2chunk(mem);
 
     /* Two optional cases in which clearing not necessary */
@@ -2410,6 +2615,8 @@ size_t malloc_usable_size(mem) Void_t* mem;
   mchunkptr p;
   if (mem == NULL)
     return 0;
+  else if (slab_owns(mem))
+    return slab_size[slab_obj_class(mem)];
   else
   {
     p = mem2chunk(mem);
@@ -11,6 +11,7 @@
 
 #ifndef USE_HOSTCC
 #include <command.h>
+#include <dm.h>
 #include <env.h>
 #include <log.h>
 #include <malloc.h>
@@ -20,6 +21,7 @@
 #include <asm/global_data.h>
 #include <asm/io.h>
 #include <linux/errno.h>
+#include <u-boot/hash.h>
 #else
 #include "mkimage.h"
 #include <linux/compiler_attributes.h>
@@ -317,6 +319,205 @@ static struct hash_algo hash_algo[] = {
 #endif
 };
 
+#if CONFIG_IS_ENABLED(DM_HASH) && !defined(USE_HOSTCC)
+/**
+ * struct hash_dm_ctx - Context for progressive hashing with a hash device
+ *
+ * @dev: Hash device, or NULL if it cannot handle this algorithm
+ * @sw: Software algorithm to use if @dev is NULL
+ * @ctx: Context for @dev or @sw
+ */
+struct hash_dm_ctx {
+	struct udevice *dev;
+	struct hash_algo *sw;
+	void *ctx;
+};
+
+static struct hash_algo *hash_sw_lookup(const char *algo_name)
+{
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(hash_algo); i++) {
+		if (!strcmp(algo_name, hash_algo[i].name))
+			return &hash_algo[i];
+	}
+
+	return NULL;
+}
+
+static struct udevice *hash_dm_dev(void)
+{
+	struct udevice *dev;
+
+	if (uclass_first_device_err(UCLASS_HASH, &dev))
+		return NULL;
+
+	return dev;
+}
+
+static void hash_dm_func_ws(const char *algo_name, const unsigned char *input,
+			    unsigned int ilen, unsigned char *output,
+			    unsigned int chunk_sz)
+{
+	struct udevice *dev = hash_dm_dev();
+	struct hash_algo *sw;
+
+	if (dev && !hash_digest_wd(dev, hash_algo_lookup_by_name(algo_name),
+				   input, ilen, output, chunk_sz))
+		return;
+
+	sw = hash_sw_lookup(algo_name);
+	if (sw)
+		sw->hash_func_ws(input, ilen, output, chunk_sz);
+}
+
+static int hash_dm_init(struct hash_algo *algo, void **ctxp)
+{
+	struct hash_dm_ctx *ctx;
+	int ret;
+
+	ctx = malloc(sizeof(*ctx));
+	if (!ctx)
+		return -ENOMEM;
+
+	ctx->dev = hash_dm_dev();
+	if (ctx->dev && !hash_init(ctx->dev,
+				   hash_algo_lookup_by_name(algo->name),
+				   &ctx->ctx)) {
+		*ctxp = ctx;
+		return 0;
+	}
+
+	ctx->dev = NULL;
+	ctx->sw = hash_sw_lookup(algo->name);
+	if (!ctx->sw) {
+		free(ctx);
+		return -EPROTONOSUPPORT;
+	}
+	ret = ctx->sw->hash_init(ctx->sw, &ctx->ctx);
+	if (ret) {
+		free(ctx);
+		return ret;
+	}
+	*ctxp = ctx;
+
+	return 0;
+}
+
+static int hash_dm_update(struct hash_algo *algo, void *ctx, const void *buf,
+			  unsigned int size, int is_last)
+{
+	struct hash_dm_ctx *dctx = ctx;
+
+	if (!dctx->dev)
+		return dctx->sw->hash_update(dctx->sw, dctx->ctx, buf, size,
+					     is_last);
+
+	/* on error the context is still freed by hash_dm_finish() */
+	return hash_update(dctx->dev, dctx->ctx, buf, size);
+}
+
+static int hash_dm_finish(struct hash_algo *algo, void *ctx, void *dest_buf,
+			  int size)
+{
+	struct hash_dm_ctx *dctx = ctx;
+	int ret;
+
+	if (size < algo->digest_size)
+		return -ENOSPC;
+
+	if (dctx->dev)
+		ret = hash_finish(dctx->dev, dctx->ctx, dest_buf);
+	else
+		ret = dctx->sw->hash_finish(dctx->sw, dctx->ctx, dest_buf,
+					    size);
+	free(dctx);
+
+	return ret;
+}
+
+#define HASH_DM_ALGO(_name, _digest_size, _chunk_size)			\
+	static void hash_dm_func_ws_##_name(const unsigned char *input,	\
+					    unsigned int ilen,		\
+					    unsigned char *output,	\
+					    unsigned int chunk_sz)	\
+	{								\
+		hash_dm_func_ws(#_name, input, ilen, output, chunk_sz);	\
+	}								\
+									\
+	static struct hash_algo hash_dm_algo_##_name = {		\
+		.name		= #_name,				\
+		.digest_size	= _digest_size,				\
+		.chunk_size	= _chunk_size,				\
+		.hash_func_ws	= hash_dm_func_ws_##_name,		\
+		.hash_init	= hash_dm_init,				\
+		.hash_update	= hash_dm_update,			\
+		.hash_finish	= hash_dm_finish,			\
+	}
+
+#if CONFIG_IS_ENABLED(SHA1)
+HASH_DM_ALGO(sha1, SHA1_SUM_LEN, CHUNKSZ_SHA1);
+#endif
+#if CONFIG_IS_ENABLED(SHA256)
+HASH_DM_ALGO(sha256, SHA256_SUM_LEN, CHUNKSZ_SHA256);
+#endif
+#if CONFIG_IS_ENABLED(SHA384)
+HASH_DM_ALGO(sha384, SHA384_SUM_LEN, CHUNKSZ_SHA384);
+#endif
+#if CONFIG_IS_ENABLED(SHA512)
+HASH_DM_ALGO(sha512, SHA512_SUM_LEN, CHUNKSZ_SHA512);
+#endif
+
+/*
+ * These are the algorithms for which a hash device is preferred, if there is
+ * one. The CRCs are left alone since the hash devices produce them in CPU
+ * byte order, which differs from the software versions.
+ */
+static struct hash_algo *hash_dm_algo[] = {
+#if CONFIG_IS_ENABLED(SHA1)
+	&hash_dm_algo_sha1,
+#endif
+#if CONFIG_IS_ENABLED(SHA256)
+	&hash_dm_algo_sha256,
+#endif
+#if CONFIG_IS_ENABLED(SHA384)
+	&hash_dm_algo_sha384,
+#endif
+#if CONFIG_IS_ENABLED(SHA512)
+	&hash_dm_algo_sha512,
+#endif
+};
+
+/**
+ * hash_dm_lookup() - Look up an algorithm to run on a hash device
+ *
+ * @algo_name: Name of the algorithm
+ * @algop: Returns the algorithm
+ * Return: 0 if OK, -ENOENT if there is no hash device or the algorithm is not
+ *	one which uses it
+ */
+static int hash_dm_lookup(const char *algo_name, struct hash_algo **algop)
+{
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(hash_dm_algo); i++) {
+		if (!strcmp(algo_name, hash_dm_algo[i]->name)) {
+			if (!hash_dm_dev())
+				break;
+			*algop = hash_dm_algo[i];
+			return 0;
+		}
+	}
+
+	return -ENOENT;
+}
+#else
+static int hash_dm_lookup(const char *algo_name, struct hash_algo **algop)
+{
+	return -ENOENT;
+}
+#endif /* DM_HASH */
+
 /* Try to minimize code size for boards that don't want much hashing */
 #if CONFIG_IS_ENABLED(SHA256) || IS_ENABLED(CONFIG_CMD_SHA1SUM) || \
 	CONFIG_IS_ENABLED(CRC32_VERIFY) || IS_ENABLED(CONFIG_CMD_HASH) || \
@@ -331,6 +532,9 @@ int hash_lookup_algo(const char *algo_name, struct hash_algo **algop)
 {
 	int i;
 
+	if (!hash_dm_lookup(algo_name, algop))
+		return 0;
+
 	for (i = 0; i < ARRAY_SIZE(hash_algo); i++) {
 		if (!strcmp(algo_name, hash_algo[i].name)) {
 			*algop = &hash_algo[i];
@@ -347,6 +551,9 @@ int hash_progressive_lookup_algo(const char *algo_name,
 {
 	int i;
 
+	if (!hash_dm_lookup(algo_name, algop))
+		return 0;
+
 	for (i = 0; i < ARRAY_SIZE(hash_algo); i++) {
 		if (!strcmp(algo_name, hash_algo[i].name)) {
 			if (hash_algo[i].hash_init) {
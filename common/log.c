@@ -191,6 +191,42 @@ static bool log_passes_filters(struct log_device *ldev, struct log_rec *rec)
 	return false;
 }
 
+/**
+ * log_wanted() - Check whether any log device accepts a log record
+ *
+ * @rec:	log record to check
+ * Return:	true if at least one enabled device passes the record
+ */
+static bool log_wanted(struct log_rec *rec)
+{
+	struct log_device *ldev;
+
+	list_for_each_entry(ldev, &gd->log_head, sibling_node) {
+		if ((ldev->flags & LOGDF_ENABLE) &&
+		    log_passes_filters(ldev, rec))
+			return true;
+	}
+
+	return false;
+}
+
+int log_emit(struct log_rec *rec)
+{
+	struct log_device *ldev;
+
+	if (gd->processing_msg)
+		return 1;
+
+	gd->processing_msg = true;
+	list_for_each_entry(ldev, &gd->log_head, sibling_node) {
+		if ((ldev->flags & LOGDF_ENABLE) &&
+		    log_passes_filters(ldev, rec))
+			ldev->drv->emit(ldev, rec);
+	}
+	gd->processing_msg = false;
+	return 0;
+}
+
 /**
  * log_dispatch() - Send a log record to all log devices for processing
  *
@@ -215,6 +251,17 @@ static int log_dispatch(struct log_rec *rec, const char *fmt, va_list args)
 	if (gd->processing_msg)
 		return 1;
 
+	/* Keep the record to format later, unless it reports an error */
+	if (CONFIG_IS_ENABLED(LOG_DEFER) && rec->level > LOGL_ERR) {
+		if (!log_wanted(rec))
+			return 0;
+		if (!log_defer(rec, fmt, args)) {
+			gd->log_cont = *fmt && fmt[strlen(fmt) - 1] != '\n';
+			return 0;
+		}
+	}
+	log_defer_flush();
+
 	/* Emit message */
 	gd->processing_msg = true;
 	list_for_each_entry(ldev, &gd->log_head, sibling_node) {
@@ -360,6 +407,7 @@ int log_add_filter_flags(const char *drv_name, enum log_category_t cat_list[],
 		list_add(&filt->sibling_node, &ldev->filter_head);
 	else
 		list_add_tail(&filt->sibling_node, &ldev->filter_head);
+	log_site_update();
 
 	return filt->filter_num;
 
@@ -381,6 +429,7 @@ int log_remove_filter(const char *drv_name, int filter_num)
 		if (filt->filter_num == filter_num) {
 			list_del(&filt->sibling_node);
 			free(filt);
+			log_site_update();
 
 			return 0;
 		}
@@ -465,6 +514,56 @@ int log_init(void)
 	gd->log_fmt = log_get_default_format();
 	gd->logc_prev = LOGC_NONE;
 	gd->logl_prev = LOGL_INFO;
+	log_site_update();
 
 	return 0;
 }
+
+#if CONFIG_IS_ENABLED(LOG_SITES)
+void log_site_update(void)
+{
+	struct log_site *site = ll_entry_start(struct log_site, log_site);
+	const int count = ll_entry_count(struct log_site, log_site);
+	struct log_device *ldev;
+	bool filtered = false;
+	int i;
+
+	if (!(gd->flags & GD_FLG_RELOC))
+		return;
+
+	/* A filter may allow any level, so let the filters decide */
+	list_for_each_entry(ldev, &gd->log_head, sibling_node) {
+		if (!list_empty(&ldev->filter_head))
+			filtered = true;
+	}
+
+	for (i = 0; i < count; i++, site++) {
+		if (site->force)
+			site->enabled = site->force > 0;
+		else
+			site->enabled = filtered ||
+				site->level <= gd->default_log_level;
+	}
+}
+
+int log_site_force(const char *match, int force)
+{
+	struct log_site *site = ll_entry_start(struct log_site, log_site);
+	const int count = ll_entry_count(struct log_site, log_site);
+	int len = strlen(match);
+	int i, found = 0;
+
+	for (i = 0; i < count; i++, site++) {
+		int flen = strlen(site->file);
+
+		if (strcmp(site->func, match) &&
+		    (flen < len || strcmp(site->file + flen - len, match)))
+			continue;
+		site->force = force;
+		found++;
+	}
+	log_site_update();
+
+	return found;
+}
+#endif
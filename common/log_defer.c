@@ -0,0 +1,359 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Deferred formatting of log records
+ *
+ * Formatting a log record takes much longer than the code which produces it.
+ * Instead, the format string and the raw arguments are kept in a ring buffer,
+ * then formatted and sent to the log devices when U-Boot is idle (from a
+ * cyclic function), on flush(), or with 'log flush'. Strings passed with %s
+ * are copied, since they may not exist later. Records with arguments which
+ * cannot be kept this way (e.g. %pU, which points to data) are formatted
+ * straight away.
+ */
+
+#include <cyclic.h>
+#include <log.h>
+#include <malloc.h>
+#include <membuff.h>
+#include <asm/global_data.h>
+#include <linux/ctype.h>
+#include <linux/errno.h>
+#include <linux/string.h>
+
+DECLARE_GLOBAL_DATA_PTR;
+
+/* Most arguments in a record which can be deferred */
+#define LOG_DEFER_MAX_ARGS	16
+
+/* Longest conversion specification, e.g. "%-08lx" */
+#define LOG_DEFER_MAX_SPEC	16
+
+/* Argument stored for a %s with a NULL pointer */
+#define LOG_DEFER_NULL_STR	((u64)-1)
+
+/**
+ * enum log_defer_arg - Type of the argument taken by a conversion
+ *
+ * @ARG_NONE: None, e.g. "%%"
+ * @ARG_INT: int, or a shorter type
+ * @ARG_LONG: long
+ * @ARG_LLONG: long long
+ * @ARG_PTR: Pointer, printed as a number
+ * @ARG_STR: String
+ * @ARG_BAD: Conversion which cannot be deferred
+ */
+enum log_defer_arg {
+	ARG_NONE,
+	ARG_INT,
+	ARG_LONG,
+	ARG_LLONG,
+	ARG_PTR,
+	ARG_STR,
+	ARG_BAD,
+};
+
+/**
+ * struct log_defer_hdr - Header of a deferred record in the ring buffer
+ *
+ * This is followed by the arguments, one u64 each, then the strings: the
+ * format string if @fmt is NULL, then those passed for %s. A string argument
+ * holds the offset of the string from the end of the arguments.
+ *
+ * @size: Number of bytes after the header
+ * @nargs: Number of arguments
+ * @line: Line number where the record was generated
+ * @cat: Category of the record
+ * @level: Level of the record
+ * @flags: Flags of the record (enum log_rec_flags)
+ * @file: File where the record was generated
+ * @func: Function where the record was generated
+ * @fmt: Format string, or NULL if it is stored after the arguments
+ */
+struct log_defer_hdr {
+	u16 size;
+	u16 nargs;
+	u16 line;
+	u16 cat;
+	u8 level;
+	u8 flags;
+	const char *file;
+	const char *func;
+	const char *fmt;
+};
+
+/* Only set up once full malloc() is ready, so after relocation */
+static struct membuff log_defer_buf;
+static bool log_defer_ready;
+
+/**
+ * log_defer_conv() - Find the next conversion in a format string
+ *
+ * @fmt: Format string, pointing at a '%'
+ * @typep: Returns the type of argument taken by the conversion
+ * Return: pointer to the character after the conversion
+ */
+static const char *log_defer_conv(const char *fmt, enum log_defer_arg *typep)
+{
+	const char *p = fmt + 1;
+	int longs = 0;
+
+	*typep = ARG_BAD;
+	if (*p == '%') {
+		*typep = ARG_NONE;
+		return p + 1;
+	}
+	while (strchr("-+ #0", *p) && *p)
+		p++;
+	while (isdigit(*p))
+		p++;
+	if (*p == '.') {
+		p++;
+		while (isdigit(*p))
+			p++;
+	}
+	for (;; p++) {
+		if (*p == 'l' || *p == 'z' || *p == 't')
+			longs++;
+		else if (*p == 'L' || *p == 'q' || *p == 'j')
+			longs = 2;
+		else if (*p != 'h')
+			break;
+	}
+	if (p - fmt + 1 >= LOG_DEFER_MAX_SPEC)
+		return p;
+
+	switch (*p) {
+	case 'd':
+	case 'i':
+	case 'u':
+	case 'x':
+	case 'X':
+	case 'o':
+	case 'c':
+		*typep = longs > 1 ? ARG_LLONG : longs ? ARG_LONG : ARG_INT;
+		break;
+	case 'p':
+		/* %p extensions print the data the pointer refers to */
+		if (!isalnum(p[1]))
+			*typep = ARG_PTR;
+		break;
+	case 's':
+		if (!longs)
+			*typep = ARG_STR;
+		break;
+	}
+
+	return *p ? p + 1 : p;
+}
+
+/* Check whether a string is part of the U-Boot image, so will not change */
+static bool log_defer_in_image(const char *str)
+{
+	return (ulong)str - gd->relocaddr < gd->mon_len;
+}
+
+static void log_defer_cyclic(void *ctx)
+{
+	log_defer_flush();
+}
+
+static int log_defer_setup(void)
+{
+	int ret;
+
+	if (!(gd->flags & GD_FLG_FULL_MALLOC_INIT))
+		return -EAGAIN;
+	ret = membuff_new(&log_defer_buf, CONFIG_LOG_DEFER_SIZE);
+	if (ret)
+		return ret;
+	if (IS_ENABLED(CONFIG_CYCLIC))
+		cyclic_register(log_defer_cyclic, 10000, "log_defer", NULL);
+	log_defer_ready = true;
+
+	return 0;
+}
+
+int log_defer(struct log_rec *rec, const char *fmt, va_list args)
+{
+	const char *strs[LOG_DEFER_MAX_ARGS];
+	int lens[LOG_DEFER_MAX_ARGS];
+	u64 argv[LOG_DEFER_MAX_ARGS];
+	struct log_defer_hdr hdr;
+	int nargs = 0, nstrs = 0;
+	enum log_defer_arg type;
+	int fmt_len = 0, size, i;
+	const char *p;
+	va_list ap;
+	int ret;
+
+	if (!log_defer_ready) {
+		ret = log_defer_setup();
+		if (ret)
+			return ret;
+	}
+
+	hdr.fmt = fmt;
+	if (!log_defer_in_image(fmt)) {
+		hdr.fmt = NULL;
+		fmt_len = strlen(fmt) + 1;
+	}
+
+	va_copy(ap, args);
+	size = fmt_len;
+	for (p = strchr(fmt, '%'); p; p = strchr(p, '%')) {
+		p = log_defer_conv(p, &type);
+		if (type == ARG_NONE)
+			continue;
+		if (type == ARG_BAD || nargs == LOG_DEFER_MAX_ARGS) {
+			va_end(ap);
+			return -E2BIG;
+		}
+		switch (type) {
+		case ARG_INT:
+			argv[nargs] = va_arg(ap, int);
+			break;
+		case ARG_LONG:
+			argv[nargs] = va_arg(ap, long);
+			break;
+		case ARG_LLONG:
+			argv[nargs] = va_arg(ap, long long);
+			break;
+		case ARG_PTR:
+			argv[nargs] = (ulong)va_arg(ap, void *);
+			break;
+		case ARG_STR:
+			strs[nstrs] = va_arg(ap, const char *);
+			if (strs[nstrs]) {
+				lens[nstrs] = strlen(strs[nstrs]) + 1;
+				argv[nargs] = size;
+				size += lens[nstrs];
+			} else {
+				lens[nstrs] = 0;
+				argv[nargs] = LOG_DEFER_NULL_STR;
+			}
+			nstrs++;
+			break;
+		default:
+			break;
+		}
+		nargs++;
+	}
+	va_end(ap);
+
+	size += nargs * sizeof(u64);
+	if (size > CONFIG_SYS_CBSIZE)
+		return -E2BIG;
+
+	/* Make room by sending out what is there already */
+	if (membuff_free(&log_defer_buf) < sizeof(hdr) + size)
+		log_defer_flush();
+	if (membuff_free(&log_defer_buf) < sizeof(hdr) + size)
+		return -ENOSPC;
+
+	hdr.size = size;
+	hdr.nargs = nargs;
+	hdr.line = rec->line;
+	hdr.cat = rec->cat;
+	hdr.level = rec->level;
+	hdr.flags = rec->flags;
+	hdr.file = rec->file;
+	hdr.func = rec->func;
+	membuff_put(&log_defer_buf, (char *)&hdr, sizeof(hdr));
+	membuff_put(&log_defer_buf, (char *)argv, nargs * sizeof(u64));
+	if (fmt_len)
+		membuff_put(&log_defer_buf, fmt, fmt_len);
+	for (i = 0; i < nstrs; i++)
+		membuff_put(&log_defer_buf, strs[i], lens[i]);
+
+	return 0;
+}
+
+/**
+ * log_defer_format() - Format a deferred record
+ *
+ * @hdr: Header of the record
+ * @data: Data following the header
+ * @buf: Buffer for the message
+ * @size: Size of @buf
+ * Return: length of the message
+ */
+static int log_defer_format(struct log_defer_hdr *hdr, const char *data,
+			    char *buf, int size)
+{
+	const u64 *argv = (const u64 *)data;
+	const char *strs = data + hdr->nargs * sizeof(u64);
+	const char *fmt = hdr->fmt ? hdr->fmt : strs;
+	char spec[LOG_DEFER_MAX_SPEC];
+	enum log_defer_arg type;
+	const char *p, *next;
+	int len = 0, nargs = 0;
+
+	for (p = fmt; *p && len < size - 1; p = next) {
+		if (*p != '%') {
+			buf[len++] = *p;
+			next = p + 1;
+			continue;
+		}
+		next = log_defer_conv(p, &type);
+		if (type == ARG_NONE) {
+			buf[len++] = '%';
+			continue;
+		}
+		memcpy(spec, p, next - p);
+		spec[next - p] = '\0';
+		switch (type) {
+		case ARG_INT:
+			len += snprintf(buf + len, size - len, spec,
+					(int)argv[nargs]);
+			break;
+		case ARG_LONG:
+			len += snprintf(buf + len, size - len, spec,
+					(long)argv[nargs]);
+			break;
+		case ARG_LLONG:
+			len += snprintf(buf + len, size - len, spec,
+					(long long)argv[nargs]);
+			break;
+		case ARG_PTR:
+			len += snprintf(buf + len, size - len, spec,
+					(void *)(ulong)argv[nargs]);
+			break;
+		case ARG_STR:
+			len += snprintf(buf + len, size - len, spec,
+					argv[nargs] == LOG_DEFER_NULL_STR ?
+					NULL : strs + argv[nargs]);
+			break;
+		default:
+			break;
+		}
+		nargs++;
+	}
+	len = min(len, size - 1);
+	buf[len] = '\0';
+
+	return len;
+}
+
+void log_defer_flush(void)
+{
+	char data[CONFIG_SYS_CBSIZE] __aligned(sizeof(u64));
+	char buf[CONFIG_SYS_CBSIZE];
+	struct log_defer_hdr hdr;
+	struct log_rec rec;
+
+	if (!log_defer_ready || gd->processing_msg)
+		return;
+	while (membuff_get(&log_defer_buf, (char *)&hdr, sizeof(hdr)) ==
+	       sizeof(hdr)) {
+		membuff_get(&log_defer_buf, data, hdr.size);
+		log_defer_format(&hdr, data, buf, sizeof(buf));
+		rec.cat = hdr.cat;
+		rec.level = hdr.level;
+		rec.flags = hdr.flags;
+		rec.file = hdr.file;
+		rec.line = hdr.line;
+		rec.func = hdr.func;
+		rec.msg = buf;
+		log_emit(&rec);
+	}
+}
@@ -16,12 +16,138 @@
 
 DECLARE_GLOBAL_DATA_PTR;
 
+/* Maximum number of subsystems tracked with malloc_simple_owner() */
+#define MF_OWNERS	8
+
+/* Sizes of blocks kept on free lists, smallest first */
+static const u16 mf_class_size[] = { 16, 32, 64, 128, 256 };
+
+#define MF_CLASSES	ARRAY_SIZE(mf_class_size)
+
+/**
+ * struct mf_hdr - header placed before each block when tracking is enabled
+ *
+ * @size: Size of the block in bytes, after rounding up to a size class
+ * @owner: Index of the owner in struct mf_state
+ */
+struct mf_hdr {
+	u32 size;
+	u32 owner;
+};
+
+/**
+ * struct mf_owner - usage of the pool by one subsystem
+ *
+ * @name: Name passed to malloc_simple_owner(), NULL for allocations made
+ *	without an owner
+ * @cur: Number of bytes currently allocated
+ * @peak: Highest value reached by @cur
+ */
+struct mf_owner {
+	const char *name;
+	ulong cur;
+	ulong peak;
+};
+
+/**
+ * struct mf_state - tracking state, held at the start of the pool
+ *
+ * Global data is the only other writable memory available this early, so
+ * this lives in the pool itself. It is set up by the first allocation after
+ * the pool is (re)initialised, i.e. when gd->malloc_ptr is 0.
+ *
+ * @free_list: Freed blocks of each size class, linked through their first word
+ * @owner: Index of the current owner in @owners
+ * @cur: Total number of bytes currently allocated
+ * @peak: Highest value reached by @cur
+ * @owners: Usage by each owner, with slot 0 used when there is no owner
+ */
+struct mf_state {
+	void *free_list[MF_CLASSES];
+	uint owner;
+	ulong cur;
+	ulong peak;
+	struct mf_owner owners[MF_OWNERS];
+};
+
+static bool mf_enabled(void)
+{
+	return CONFIG_IS_ENABLED(SYS_MALLOC_F_FREELIST) ||
+		CONFIG_IS_ENABLED(SYS_MALLOC_F_STATS);
+}
+
+static struct mf_state *mf_get_state(void)
+{
+	struct mf_state *st;
+
+	if (!gd->malloc_ptr) {
+		if (sizeof(*st) > gd->malloc_limit)
+			return NULL;
+		st = map_sysmem(gd->malloc_base, sizeof(*st));
+		memset(st, '\0', sizeof(*st));
+		gd->malloc_ptr = ALIGN(sizeof(*st), sizeof(ulong));
+	}
+
+	return map_sysmem(gd->malloc_base, sizeof(*st));
+}
+
+static int mf_get_class(size_t bytes)
+{
+	int i;
+
+	for (i = 0; i < MF_CLASSES; i++) {
+		if (bytes <= mf_class_size[i])
+			return i;
+	}
+
+	return -1;
+}
+
+static void mf_account(struct mf_state *st, struct mf_hdr *hdr, bool alloc)
+{
+	struct mf_owner *owner = &st->owners[hdr->owner];
+
+	if (alloc) {
+		st->cur += hdr->size;
+		owner->cur += hdr->size;
+		st->peak = max(st->peak, st->cur);
+		owner->peak = max(owner->peak, owner->cur);
+	} else {
+		st->cur -= hdr->size;
+		owner->cur -= hdr->size;
+	}
+}
+
 static void *alloc_simple(size_t bytes, int align)
 {
-	ulong addr, new_ptr;
+	struct mf_state *st = NULL;
+	ulong addr, new_ptr, hdr_size = 0;
+	struct mf_hdr *hdr;
 	void *ptr;
+	int cls;
+
+	if (mf_enabled()) {
+		st = mf_get_state();
+		if (!st) {
+			log_err("alloc space exhausted\n");
+			return NULL;
+		}
+		hdr_size = sizeof(*hdr);
+	}
+	if (CONFIG_IS_ENABLED(SYS_MALLOC_F_FREELIST)) {
+		cls = mf_get_class(bytes);
+		if (cls >= 0) {
+			bytes = mf_class_size[cls];
+			ptr = st->free_list[cls];
+			if (ptr && align <= sizeof(ulong)) {
+				st->free_list[cls] = *(void **)ptr;
+				hdr = ptr - hdr_size;
+				goto found;
+			}
+		}
+	}
 
-	addr = ALIGN(gd->malloc_base + gd->malloc_ptr, align);
+	addr = ALIGN(gd->malloc_base + gd->malloc_ptr + hdr_size, align);
 	new_ptr = addr + bytes - gd->malloc_base;
 	log_debug("size=%lx, ptr=%lx, limit=%lx: ", (ulong)bytes, new_ptr,
 		  gd->malloc_limit);
@@ -32,6 +158,14 @@ static void *alloc_simple(size_t bytes, int align)
 
 	ptr = map_sysmem(addr, bytes);
 	gd->malloc_ptr = ALIGN(new_ptr, sizeof(new_ptr));
+	if (!st)
+		return ptr;
+
+	hdr = ptr - hdr_size;
+	hdr->size = bytes;
+found:
+	hdr->owner = st->owner;
+	mf_account(st, hdr, true);
 
 	return ptr;
 }
@@ -77,16 +211,90 @@ void *calloc(size_t nmemb, size_t elem_size)
 	return ptr;
 }
 
-#if IS_ENABLED(CONFIG_VALGRIND)
+#endif
+
 void free_simple(void *ptr)
 {
+	struct mf_state *st;
+	struct mf_hdr *hdr;
+	ulong addr;
+	int cls;
+
 	VALGRIND_FREELIKE_BLOCK(ptr, 0);
+	if (!mf_enabled() || !ptr || !gd->malloc_ptr)
+		return;
+
+	/* Ignore anything not allocated from the current pool */
+	addr = map_to_sysmem(ptr);
+	if (addr < gd->malloc_base + sizeof(*st) + sizeof(*hdr) ||
+	    addr >= gd->malloc_base + gd->malloc_ptr)
+		return;
+
+	st = map_sysmem(gd->malloc_base, sizeof(*st));
+	hdr = ptr - sizeof(*hdr);
+	mf_account(st, hdr, false);
+	if (!CONFIG_IS_ENABLED(SYS_MALLOC_F_FREELIST))
+		return;
+
+	/* Give back the most recent allocation, else keep it for reuse */
+	if (ALIGN(addr + hdr->size, sizeof(ulong)) ==
+	    gd->malloc_base + gd->malloc_ptr) {
+		gd->malloc_ptr = map_to_sysmem(hdr) - gd->malloc_base;
+	} else {
+		cls = mf_get_class(hdr->size);
+		if (cls >= 0 && mf_class_size[cls] == hdr->size) {
+			*(void **)ptr = st->free_list[cls];
+			st->free_list[cls] = ptr;
+		}
+	}
+}
+
+#if CONFIG_IS_ENABLED(SYS_MALLOC_F_STATS)
+const char *malloc_simple_owner(const char *name)
+{
+	struct mf_state *st;
+	const char *prev;
+	uint i;
+
+	if (gd->flags & GD_FLG_FULL_MALLOC_INIT)
+		return NULL;
+	st = mf_get_state();
+	if (!st)
+		return NULL;
+
+	prev = st->owners[st->owner].name;
+	st->owner = 0;
+	for (i = 1; name && i < MF_OWNERS; i++) {
+		if (!st->owners[i].name)
+			st->owners[i].name = name;
+		if (!strcmp(st->owners[i].name, name)) {
+			st->owner = i;
+			break;
+		}
+	}
+
+	return prev;
 }
-#endif
 #endif
 
 void malloc_simple_info(void)
 {
+	struct mf_state *st;
+	uint i;
+
 	log_info("malloc_simple: %lx bytes used, %lx remain\n", gd->malloc_ptr,
-		 CONFIG_VAL(SYS_MALLOC_F_LEN) - gd->malloc_ptr);
+		 gd->malloc_limit - gd->malloc_ptr);
+	if (!CONFIG_IS_ENABLED(SYS_MALLOC_F_STATS) || !gd->malloc_ptr)
+		return;
+
+	st = map_sysmem(gd->malloc_base, sizeof(*st));
+	log_info("%-12s %8lx in use, %8lx peak\n", "total", st->cur, st->peak);
+	for (i = 0; i < MF_OWNERS; i++) {
+		struct mf_owner *owner = &st->owners[i];
+
+		if (i && !owner->name)
+			break;
+		log_info("%-12s %8lx in use, %8lx peak\n",
+			 owner->name ?: "(other)", owner->cur, owner->peak);
+	}
 }
@@ -6,11 +6,15 @@
 
 #include <dm.h>
 #include <env.h>
+#include <image.h>
 #include <mapmem.h>
 #include <qfw.h>
 #include <stdlib.h>
 #include <dm/uclass.h>
 
+/* Size of the arm64 / RISC-V Image header, which gives its load offset */
+#define QFW_IMAGE_HDR_SIZE	64
+
 int qfw_get_dev(struct udevice **devp)
 {
 	return uclass_first_device_err(UCLASS_QFW, devp);
@@ -105,20 +109,65 @@ bool qfw_file_iter_end(struct fw_cfg_file_iter *iter)
 	return iter->entry == iter->end;
 }
 
-int qemu_fwcfg_setup_kernel(struct udevice *qfw_dev, ulong load_addr,
-			    ulong initrd_addr)
+/**
+ * qfw_kernel_dest() - Work out where booti will run the kernel from
+ *
+ * booti moves an Image to a suitably aligned address before starting it, so
+ * load it there in the first place and save a copy of the whole kernel. The
+ * header is read to @load_addr to find out the address.
+ *
+ * @qfw_dev: QEMU firmware config device
+ * @load_addr: Load address for the kernel, used if it cannot be moved
+ * @initrd_addr: Load address for the ramdisk, which must not be overwritten
+ * @initrd_size: Size of the ramdisk
+ * Return: address to load the kernel to
+ */
+static ulong qfw_kernel_dest(struct udevice *qfw_dev, ulong load_addr,
+			     ulong initrd_addr, ulong initrd_size)
+{
+	ulong dest, size;
+	void *hdr;
+	int ctype;
+
+	if (!IS_ENABLED(CONFIG_CMD_BOOTI))
+		return load_addr;
+
+	hdr = map_sysmem(load_addr, QFW_IMAGE_HDR_SIZE);
+	qfw_read_entry(qfw_dev, FW_CFG_KERNEL_DATA, QFW_IMAGE_HDR_SIZE, hdr);
+	ctype = image_decomp_type(hdr, 2);
+	unmap_sysmem(hdr);
+
+	/* A compressed kernel is decompressed in place by booti */
+	if (ctype > 0 || booti_setup(load_addr, &dest, &size, false))
+		return load_addr;
+	if (initrd_size && dest < initrd_addr + initrd_size &&
+	    initrd_addr < dest + size)
+		return load_addr;
+
+	return dest;
+}
+
+static int qfw_setup_kernel(struct udevice *qfw_dev, ulong load_addr,
+			    ulong initrd_addr, bool direct,
+			    ulong *kernel_addrp)
 {
 	char *data_addr;
 	u32 setup_size, kernel_size, cmdline_size, initrd_size;
 
 	qfw_read_entry(qfw_dev, FW_CFG_SETUP_SIZE, 4, &setup_size);
 	qfw_read_entry(qfw_dev, FW_CFG_KERNEL_SIZE, 4, &kernel_size);
+	qfw_read_entry(qfw_dev, FW_CFG_INITRD_SIZE, 4, &initrd_size);
 
 	if (!kernel_size) {
 		printf("fatal: no kernel available\n");
 		return -ENOENT;
 	}
 
+	if (direct && !setup_size)
+		load_addr = qfw_kernel_dest(qfw_dev, load_addr, initrd_addr,
+					    le32_to_cpu(initrd_size));
+
+	/* Each entry is read in one go, which is a single DMA transfer */
 	data_addr = map_sysmem(load_addr, 0);
 	if (setup_size) {
 		qfw_read_entry(qfw_dev, FW_CFG_SETUP_DATA,
@@ -132,7 +181,6 @@ int qemu_fwcfg_setup_kernel(struct udevice *qfw_dev, ulong load_addr,
 	env_set_hex("filesize", le32_to_cpu(kernel_size));
 
 	data_addr = map_sysmem(initrd_addr, 0);
-	qfw_read_entry(qfw_dev, FW_CFG_INITRD_SIZE, 4, &initrd_size);
 	if (!initrd_size) {
 		printf("warning: no initrd available\n");
 	} else {
@@ -163,6 +211,21 @@ int qemu_fwcfg_setup_kernel(struct udevice *qfw_dev, ulong load_addr,
 		       le32_to_cpu(initrd_size));
 	else
 		printf("\n");
+	if (kernel_addrp)
+		*kernel_addrp = load_addr;
 
 	return 0;
 }
+
+int qemu_fwcfg_setup_kernel(struct udevice *qfw_dev, ulong load_addr,
+			    ulong initrd_addr)
+{
+	return qfw_setup_kernel(qfw_dev, load_addr, initrd_addr, false, NULL);
+}
+
+int qemu_fwcfg_load_kernel(struct udevice *qfw_dev, ulong load_addr,
+			   ulong initrd_addr, ulong *kernel_addrp)
+{
+	return qfw_setup_kernel(qfw_dev, load_addr, initrd_addr, true,
+				kernel_addrp);
+}
@@ -179,6 +179,13 @@ config TPL_CRC32
 	  for detected accidental image corruption. For secure applications you
 	  should consider SHA1 or SHA256.
 
+config TPL_DRAM_CACHE
+	bool "Support caching DRAM training results in TPL"
+	select TPL_CRC32
+	help
+	  Enable DRAM training results to be saved and restored in TPL. See
+	  SPL_DRAM_CACHE for details.
+
 config TPL_DRIVERS_MISC
 	bool "Support misc drivers in TPL"
 	help
@@ -783,6 +783,8 @@ void board_init_r(gd_t *dummy1, ulong dummy2)
 	    !IS_ENABLED(CONFIG_SPL_SYS_MALLOC_SIZE))
 		debug("SPL malloc() used 0x%lx bytes (%ld KB)\n",
 		      gd_malloc_ptr(), gd_malloc_ptr() / 1024);
+	if (CONFIG_IS_ENABLED(SYS_MALLOC_F_STATS))
+		malloc_simple_info();
 
 	bootstage_mark_name(get_bootstage_id(false), "end phase");
 	ret = bootstage_stash_default();
@@ -894,6 +896,8 @@ ulong spl_relocate_stack_gd(void)
 	if (CONFIG_SPL_STACK_R_MALLOC_SIMPLE_LEN) {
 		debug("SPL malloc() before relocation used 0x%lx bytes (%ld KB)\n",
 		      gd->malloc_ptr, gd->malloc_ptr / 1024);
+		if (CONFIG_IS_ENABLED(SYS_MALLOC_F_STATS))
+			malloc_simple_info();
 		ptr -= CONFIG_SPL_STACK_R_MALLOC_SIMPLE_LEN;
 		gd->malloc_base = ptr;
 		gd->malloc_limit = CONFIG_SPL_STACK_R_MALLOC_SIMPLE_LEN;
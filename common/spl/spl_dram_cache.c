@@ -0,0 +1,216 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Saving and restoring DRAM training results
+ */
+
+#define LOG_CATEGORY LOGC_BOOT
+
+#include <blk.h>
+#include <errno.h>
+#include <log.h>
+#include <malloc.h>
+#include <memalign.h>
+#include <mmc.h>
+#include <spi_flash.h>
+#include <spl_dram_cache.h>
+#include <u-boot/crc.h>
+#include <asm/byteorder.h>
+
+__weak u32 spl_dram_cache_board_id(void)
+{
+	return 0;
+}
+
+#if IS_ENABLED(CONFIG_SPL_DRAM_CACHE_SPI)
+static struct spi_flash *dram_cache_flash(void)
+{
+	return spi_flash_probe(CONFIG_SF_DEFAULT_BUS, CONFIG_SF_DEFAULT_CS,
+			       CONFIG_SF_DEFAULT_SPEED, CONFIG_SF_DEFAULT_MODE);
+}
+
+static int dram_cache_read(void *buf, uint size)
+{
+	struct spi_flash *flash = dram_cache_flash();
+
+	if (!flash)
+		return -ENODEV;
+
+	return spi_flash_read(flash, CONFIG_SPL_DRAM_CACHE_OFFSET, size, buf);
+}
+
+static int dram_cache_write(const void *buf, uint size)
+{
+	struct spi_flash *flash;
+	int ret;
+
+	if (CONFIG_IS_ENABLED(SPI_FLASH_TINY))
+		return -ENOSYS;
+	flash = dram_cache_flash();
+	if (!flash)
+		return -ENODEV;
+	ret = spi_flash_erase(flash, CONFIG_SPL_DRAM_CACHE_OFFSET,
+			      ALIGN(size, flash->erase_size));
+	if (ret)
+		return ret;
+
+	return spi_flash_write(flash, CONFIG_SPL_DRAM_CACHE_OFFSET, size, buf);
+}
+#elif IS_ENABLED(CONFIG_SPL_DRAM_CACHE_MMC)
+/**
+ * dram_cache_mmc() - Read or write the results on MMC
+ *
+ * The hardware partition is restored afterwards, since the same device is
+ * often used to load the next phase
+ *
+ * @buf: Buffer for the results
+ * @size: Number of bytes to transfer
+ * @write: true to write, false to read
+ * Return: 0 if OK, -ve on error
+ */
+static int dram_cache_mmc(void *buf, uint size, bool write)
+{
+	struct blk_desc *desc;
+	struct mmc *mmc;
+	lbaint_t start, count;
+	int hwpart, ret;
+
+	ret = mmc_initialize(NULL);
+	if (ret)
+		return ret;
+	mmc = find_mmc_device(CONFIG_SPL_DRAM_CACHE_MMC_DEV);
+	if (!mmc)
+		return -ENODEV;
+	ret = mmc_init(mmc);
+	if (ret)
+		return ret;
+	desc = mmc_get_blk_desc(mmc);
+	if (!desc)
+		return -ENODEV;
+
+	hwpart = desc->hwpart;
+	ret = blk_dselect_hwpart(desc, CONFIG_SPL_DRAM_CACHE_MMC_HWPART);
+	if (ret)
+		return ret;
+	start = CONFIG_SPL_DRAM_CACHE_OFFSET / desc->blksz;
+	count = DIV_ROUND_UP(size, desc->blksz);
+	if (write)
+		ret = blk_dwrite(desc, start, count, buf) == count ? 0 : -EIO;
+	else
+		ret = blk_dread(desc, start, count, buf) == count ? 0 : -EIO;
+	blk_dselect_hwpart(desc, hwpart);
+
+	return ret;
+}
+
+static int dram_cache_read(void *buf, uint size)
+{
+	return dram_cache_mmc(buf, size, false);
+}
+
+static int dram_cache_write(const void *buf, uint size)
+{
+	if (!CONFIG_IS_ENABLED(MMC_WRITE))
+		return -ENOSYS;
+
+	return dram_cache_mmc((void *)buf, size, true);
+}
+#endif
+
+/**
+ * dram_cache_fill_hdr() - Set up the header for some results
+ *
+ * @hdr: Header to fill in
+ * @id: ID chosen by the driver
+ * @data: Results
+ * @size: Size of the results in bytes
+ */
+static void dram_cache_fill_hdr(struct spl_dram_cache_hdr *hdr, u32 id,
+				const void *data, uint size)
+{
+	u32 crc;
+
+	memset(hdr, '\0', sizeof(*hdr));
+	hdr->magic = cpu_to_le32(DRAM_CACHE_MAGIC);
+	hdr->id = cpu_to_le32(id);
+	hdr->board_id = cpu_to_le32(spl_dram_cache_board_id());
+	hdr->size = cpu_to_le32(size);
+	crc = crc32(0, (uchar *)hdr, sizeof(*hdr));
+	crc = crc32(crc, data, size);
+	hdr->crc = cpu_to_le32(crc);
+}
+
+/**
+ * dram_cache_alloc() - Allocate a buffer and read the stored results
+ *
+ * @size: Size of the results in bytes
+ * @bufp: Returns the buffer, which must be freed by the caller
+ * Return: 0 if OK, -E2BIG if @size is too large, -ENOMEM if out of memory,
+ *	other -ve error if the storage could not be read
+ */
+static int dram_cache_alloc(uint size, struct spl_dram_cache_hdr **bufp)
+{
+	struct spl_dram_cache_hdr *buf;
+	int ret;
+
+	if (size > CONFIG_SPL_DRAM_CACHE_SIZE - sizeof(*buf))
+		return -E2BIG;
+	buf = malloc_cache_aligned(CONFIG_SPL_DRAM_CACHE_SIZE);
+	if (!buf)
+		return -ENOMEM;
+	ret = dram_cache_read(buf, sizeof(*buf) + size);
+	if (ret) {
+		free(buf);
+		return ret;
+	}
+	*bufp = buf;
+
+	return 0;
+}
+
+int spl_dram_cache_load(u32 id, void *data, uint size)
+{
+	struct spl_dram_cache_hdr *buf, hdr;
+	int ret;
+
+	ret = dram_cache_alloc(size, &buf);
+	if (ret) {
+		log_debug("Cannot read DRAM training results (err=%dE)\n", ret);
+		return ret;
+	}
+
+	dram_cache_fill_hdr(&hdr, id, buf + 1, size);
+	if (memcmp(&hdr, buf, sizeof(hdr))) {
+		log_debug("No valid DRAM training results\n");
+		ret = -ENOENT;
+	} else {
+		memcpy(data, buf + 1, size);
+	}
+	free(buf);
+
+	return ret;
+}
+
+int spl_dram_cache_save(u32 id, const void *data, uint size)
+{
+	struct spl_dram_cache_hdr *buf, hdr;
+	int ret;
+
+	ret = dram_cache_alloc(size, &buf);
+	if (ret)
+		return ret;
+
+	dram_cache_fill_hdr(&hdr, id, data, size);
+	if (!memcmp(&hdr, buf, sizeof(hdr)) && !memcmp(data, buf + 1, size)) {
+		log_debug("DRAM training results unchanged\n");
+	} else {
+		memcpy(buf, &hdr, sizeof(hdr));
+		memcpy(buf + 1, data, size);
+		ret = dram_cache_write(buf, sizeof(hdr) + size);
+		if (ret)
+			log_err("Cannot save DRAM training results (err=%dE)\n",
+				ret);
+	}
+	free(buf);
+
+	return ret;
+}
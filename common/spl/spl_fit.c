@@ -4,6 +4,8 @@
  * Written by Simon Glass <sjg@chromium.org>
  */
 
+#include <cpu.h>
+#include <dma.h>
 #include <errno.h>
 #include <fpga.h>
 #include <gzip.h>
@@ -13,18 +15,62 @@
 #include <mapmem.h>
 #include <spl.h>
 #include <sysinfo.h>
+#include <u-boot/sha256.h>
 #include <asm/global_data.h>
 #include <asm/io.h>
 #include <linux/libfdt.h>
 #include <linux/printk.h>
+#include <linux/sizes.h>
 
 DECLARE_GLOBAL_DATA_PTR;
 
+/* Amount to read before passing the data on to be hashed */
+#define SPL_FIT_HASH_CHUNK	SZ_256K
+
+/* Most images which can be read together in one span */
+#define SPL_FIT_SPAN_MAX	8
+
+/* Largest gap between images which are read together in one span */
+#define SPL_FIT_SPAN_GAP	SZ_4K
+
+/**
+ * struct spl_fit_part - an image within data which is being read
+ *
+ * @node: Offset of the image node in the FIT
+ * @start: Offset of the image data in the buffer being read into
+ * @length: Length of the image data
+ * @bad: true if hashing failed, so the hashes must be calculated again
+ * @hsr: Hasher for the image
+ */
+struct spl_fit_part {
+	int node;
+	ulong start;
+	ulong length;
+	bool bad;
+	struct fit_hasher hsr;
+};
+
+/**
+ * struct spl_fit_span - images which were read from the FIT in one go
+ *
+ * @buf: Buffer holding the data
+ * @count: Number of images in @part
+ * @part: Information about each image, in order of position in the FIT
+ */
+struct spl_fit_span {
+	void *buf;
+	int count;
+	struct spl_fit_part part[SPL_FIT_SPAN_MAX];
+};
+
 struct spl_fit_info {
 	const void *fit;	/* Pointer to a valid FIT blob */
 	size_t ext_data_offset;	/* Offset to FIT external data (end of FIT) */
 	int images_node;	/* FDT offset to "/images" node */
 	int conf_node;		/* FDT offset to selected configuration node */
+	struct spl_fit_span *span;	/* Images already read, or NULL */
+	bool verified;		/* Board says FIT needs no verification */
+	u8 digest[SHA256_SUM_LEN];	/* SHA256 of FIT header */
 };
 
 __weak ulong board_spl_fit_size_align(ulong size)
@@ -186,6 +232,237 @@ static int get_aligned_image_size(struct spl_load_info *info, int data_size,
 	return ALIGN(data_size, spl_get_bl_len(info));
 }
 
+/**
+ * struct spl_fit_hash_job - hashing of the data which has just been read
+ *
+ * @job: Job which does the hashing
+ * @part: Images within the data
+ * @count: Number of images in @part
+ * @buf: Buffer holding the data
+ * @from: Offset in @buf of the first byte to hash
+ * @to: Offset in @buf after the last byte to hash
+ */
+struct spl_fit_hash_job {
+	struct cpu_job job;
+	struct spl_fit_part *part;
+	int count;
+	const void *buf;
+	ulong from;
+	ulong to;
+};
+
+static int spl_fit_hash_job_run(struct cpu_job *job)
+{
+	struct spl_fit_hash_job *hj = container_of(job,
+						   struct spl_fit_hash_job,
+						   job);
+	int i;
+
+	for (i = 0; i < hj->count; i++) {
+		struct spl_fit_part *part = &hj->part[i];
+		ulong from = max(hj->from, part->start);
+		ulong to = min(hj->to, part->start + part->length);
+
+		if (!part->bad && from < to &&
+		    fit_hasher_update(&part->hsr, hj->buf + from, to - from))
+			part->bad = true;
+	}
+
+	return 0;
+}
+
+/**
+ * spl_fit_read_hashed() - Read images, hashing each piece as it arrives
+ *
+ * The data is read in pieces. Each piece is hashed while the next one is
+ * read, if another CPU is available, else straight after it is read, while it
+ * is still in the cache. If hashing of an image fails, or the image is not
+ * read completely, its hasher is aborted so that the hashes are calculated
+ * again when the image is verified.
+ *
+ * @info: Information about the device to read from
+ * @offset: Offset to read from, aligned to the block length
+ * @size: Number of bytes to read, aligned to the block length
+ * @buf: Buffer to read into
+ * @part: Images within the data, with hashers started
+ * @count: Number of images in @part
+ * Return: number of bytes read
+ */
+static ulong spl_fit_read_hashed(struct spl_load_info *info, ulong offset,
+				 ulong size, void *buf,
+				 struct spl_fit_part *part, int count)
+{
+	struct spl_fit_hash_job hj = {
+		.job = { .func = spl_fit_hash_job_run, .done = true },
+		.part = part,
+		.count = count,
+		.buf = buf,
+	};
+	ulong pos, chunk, got, total = 0;
+	int i;
+
+	for (pos = 0; pos < size; pos += chunk) {
+		chunk = min(size - pos, (ulong)SPL_FIT_HASH_CHUNK);
+		got = info->read(info, offset + pos, chunk, buf + pos);
+		total += got;
+
+		/* Only one piece can be hashed at a time */
+		cpu_job_wait(&hj.job);
+		hj.from = hj.to;
+		hj.to = total;
+		cpu_job_start(&hj.job);
+		if (got < chunk)
+			break;
+	}
+	cpu_job_wait(&hj.job);
+
+	for (i = 0; i < count; i++) {
+		if (part[i].bad || part[i].start + part[i].length > total)
+			fit_hasher_abort(&part[i].hsr);
+	}
+
+	return total;
+}
+
+/**
+ * spl_fit_find_part() - Find an image which has already been read
+ *
+ * @ctx: FIT context
+ * @node: Offset of the image node
+ * Return: the image, or NULL if it has not been read
+ */
+static struct spl_fit_part *spl_fit_find_part(const struct spl_fit_info *ctx,
+					      int node)
+{
+	int i;
+
+	for (i = 0; ctx->span && i < ctx->span->count; i++) {
+		if (ctx->span->part[i].node == node)
+			return &ctx->span->part[i];
+	}
+
+	return NULL;
+}
+
+/**
+ * spl_fit_decomp_inplace() - Check if an image can be decompressed in place
+ *
+ * Such an image is read to the end of the space available for it and
+ * decompressed from there to its load address, so no other buffer is needed
+ *
+ * @comp: Compression used by the image (IH_COMP_...)
+ * Return: true if the image can be decompressed in place
+ */
+static bool spl_fit_decomp_inplace(int comp)
+{
+	return (IS_ENABLED(CONFIG_SPL_LZ4) && comp == IH_COMP_LZ4) ||
+	       (IS_ENABLED(CONFIG_SPL_ZSTD) && comp == IH_COMP_ZSTD);
+}
+
+/*
+ * Space to leave between the end of the output and the end of the input when
+ * decompressing in place. This covers lz4, which needs 1/256th of the output
+ * size plus a little, and zstd, which needs one 128KiB block plus three bytes
+ * for each block.
+ */
+#define SPL_FIT_INPLACE_MARGIN	\
+	((CONFIG_SYS_BOOTM_LEN >> 8) + SZ_128K + SZ_4K)
+
+/* Amount to read at a time when decompressing an image as it is read */
+#define SPL_FIT_STREAM_CHUNK	SZ_64K
+
+/**
+ * struct spl_fit_reader - reader for an image which is decompressed as it is
+ *	read
+ *
+ * @rd: Reader passed to image_decomp_stream()
+ * @info: Information about the device to read from
+ * @offset: Offset of the image data on the device
+ * @length: Length of the image data
+ * @buf: Buffer holding data read from the device, SPL_FIT_STREAM_CHUNK bytes
+ * @start: Offset on the device of the data in @buf
+ * @end: Offset on the device after the last byte in @buf
+ */
+struct spl_fit_reader {
+	struct image_reader rd;
+	struct spl_load_info *info;
+	ulong offset;
+	ulong length;
+	void *buf;
+	ulong start;
+	ulong end;
+};
+
+static long spl_fit_reader_read(struct image_reader *rd, ulong offset,
+				void *buf, ulong size)
+{
+	struct spl_fit_reader *frd = container_of(rd, struct spl_fit_reader,
+						  rd);
+	ulong pos = frd->offset + offset;
+	ulong got;
+
+	if (offset >= frd->length)
+		return 0;
+	size = min(size, frd->length - offset);
+
+	/* Device reads must be aligned, so go through a buffer */
+	if (pos < frd->start || pos >= frd->end) {
+		frd->start = get_aligned_image_offset(frd->info, pos);
+		got = frd->info->read(frd->info, frd->start,
+				      SPL_FIT_STREAM_CHUNK, frd->buf);
+		frd->end = frd->start + got;
+		if (pos >= frd->end)
+			return -EIO;
+	}
+	size = min(size, frd->end - pos);
+	memcpy(buf, frd->buf + pos - frd->start, size);
+
+	return size;
+}
+
+/**
+ * spl_fit_load_stream() - Decompress an image as it is read
+ *
+ * This is used when the image is not verified, so there is no need to have
+ * all the compressed data in memory at once
+ *
+ * @info: Information about the device to read from
+ * @offset: Offset of the image data on the device
+ * @len: Length of the image data
+ * @comp: Compression used by the image (IH_COMP_...)
+ * @load_addr: Address to decompress to
+ * @lenp: Returns the decompressed size
+ * Return: 0 if OK, -ve on error
+ */
+static int spl_fit_load_stream(struct spl_load_info *info, ulong offset,
+			       ulong len, int comp, ulong load_addr,
+			       size_t *lenp)
+{
+	struct spl_fit_reader frd = {
+		.rd = { .read = spl_fit_reader_read },
+		.info = info,
+		.offset = offset,
+		.length = len,
+	};
+	ulong size;
+	int ret;
+
+	frd.buf = malloc_cache_aligned(SPL_FIT_STREAM_CHUNK);
+	if (!frd.buf)
+		return -ENOMEM;
+	ret = image_decomp_stream(comp, map_sysmem(load_addr,
+						   CONFIG_SYS_BOOTM_LEN),
+				  CONFIG_SYS_BOOTM_LEN, &frd.rd, &size);
+	free(frd.buf);
+	if (ret) {
+		printf("Uncompressing error (err=%d)\n", ret);
+		return -EIO;
+	}
+	*lenp = size;
+
+	return 0;
+}
+
 /**
  * load_simple_fit(): load the image described in a certain FIT node
  * @info:	points to information about the device to load data from
@@ -216,6 +493,9 @@ static int load_simple_fit(struct spl_load_info *info, ulong fit_offset,
 	const void *data;
 	const void *fit = ctx->fit;
 	bool external_data = false;
+	struct fit_hasher hsr = { .count = 0 };
+	struct spl_fit_part *part;
+	int ret;
 
 	if (IS_ENABLED(CONFIG_SPL_FPGA) ||
 	    (IS_ENABLED(CONFIG_SPL_OS_BOOT) && spl_decompression_enabled())) {
@@ -246,8 +526,19 @@ static int load_simple_fit(struct spl_load_info *info, ulong fit_offset,
 		external_data = true;
 	}
 
-	if (external_data) {
+	part = external_data ? spl_fit_find_part(ctx, node) : NULL;
+	if (part) {
+		/* Already read, along with its neighbours */
+		length = part->length;
+		src = ctx->span->buf + part->start;
+
+		/* Take over the hashes, in case the image is loaded again */
+		hsr = part->hsr;
+		part->hsr.count = 0;
+	} else if (external_data) {
+		ulong read_offset;
 		void *src_ptr;
+		struct spl_fit_part one = { .node = node };
 
 		/* External data */
 		if (fit_image_get_data_size(fit, node, &len))
@@ -260,21 +551,54 @@ static int load_simple_fit(struct spl_load_info *info, ulong fit_offset,
 			return 0;
 		}
 
+		if (IS_ENABLED(CONFIG_SPL_LOAD_FIT_DECOMP_STREAM) &&
+		    (image_comp == IH_COMP_GZIP || image_comp == IH_COMP_LZ4 ||
+		     image_comp == IH_COMP_ZSTD)) {
+			ret = spl_fit_load_stream(info, fit_offset + offset,
+						  len, image_comp, load_addr,
+						  &length);
+			if (ret)
+				return ret;
+			goto done;
+		}
+
+		overhead = get_aligned_image_overhead(info, offset);
+		size = get_aligned_image_size(info, len, offset);
 		if (spl_decompression_enabled() &&
 		    (image_comp == IH_COMP_GZIP || image_comp == IH_COMP_LZMA))
 			src_ptr = map_sysmem(ALIGN(CONFIG_SYS_LOAD_ADDR, ARCH_DMA_MINALIGN), len);
+		else if (spl_fit_decomp_inplace(image_comp))
+			/* Read to the end of the space, to decompress in place */
+			src_ptr = map_sysmem(ALIGN_DOWN(load_addr +
+							CONFIG_SYS_BOOTM_LEN -
+							size,
+							ARCH_DMA_MINALIGN),
+					     size);
+		else if (IS_ENABLED(CONFIG_SPL_LOAD_FIT_READ_BELOW_LOAD) &&
+			 IS_ALIGNED(load_addr - overhead, ARCH_DMA_MINALIGN))
+			/* Read straight to the load address, so no copy needed */
+			src_ptr = map_sysmem(load_addr - overhead, len);
 		else
 			src_ptr = map_sysmem(ALIGN(load_addr, ARCH_DMA_MINALIGN), len);
 		length = len;
 
-		overhead = get_aligned_image_overhead(info, offset);
-		size = get_aligned_image_size(info, length, offset);
-
-		if (info->read(info,
-			       fit_offset +
-			       get_aligned_image_offset(info, offset), size,
-			       src_ptr) < length)
+		read_offset = fit_offset + get_aligned_image_offset(info,
+								    offset);
+
+		if (CONFIG_IS_ENABLED(FIT_SIGNATURE) && !ctx->verified &&
+		    !fit_hasher_start(&one.hsr, fit, node)) {
+			one.start = overhead;
+			one.length = length;
+			if (spl_fit_read_hashed(info, read_offset, size,
+						src_ptr, &one, 1) < length) {
+				fit_hasher_abort(&one.hsr);
+				return -EIO;
+			}
+			hsr = one.hsr;
+		} else if (info->read(info, read_offset, size, src_ptr) <
+			   length) {
 			return -EIO;
+		}
 
 		debug("External data: dst=%p, offset=%x, size=%lx\n",
 		      src_ptr, offset, (unsigned long)length);
@@ -290,11 +614,13 @@ static int load_simple_fit(struct spl_load_info *info, ulong fit_offset,
 		src = (void *)data;	/* cast away const */
 	}
 
-	if (CONFIG_IS_ENABLED(FIT_SIGNATURE)) {
+	if (CONFIG_IS_ENABLED(FIT_SIGNATURE) && !ctx->verified) {
 		printf("## Checking hash(es) for Image %s ... ",
 		       fit_get_name(fit, node, NULL));
-		if (!fit_image_verify_with_data(fit, node, gd_fdt_blob(), src,
-						length))
+		ret = fit_image_verify_hashed(fit, node, gd_fdt_blob(), src,
+					      length, &hsr);
+		fit_hasher_abort(&hsr);
+		if (!ret)
 			return -EPERM;
 		puts("OK\n");
 	}
@@ -320,10 +646,22 @@ static int load_simple_fit(struct spl_load_info *info, ulong fit_offset,
 			return -EIO;
 		}
 		length = loadEnd - CONFIG_SYS_LOAD_ADDR;
-	} else {
-		memcpy(load_ptr, src, length);
+	} else if (spl_fit_decomp_inplace(image_comp)) {
+		ulong load_end;
+
+		if (image_decomp(image_comp, load_addr, 0, 0, load_ptr, src,
+				 length, CONFIG_SYS_BOOTM_LEN -
+				 SPL_FIT_INPLACE_MARGIN, &load_end)) {
+			puts("Uncompressing error\n");
+			return -EIO;
+		}
+		length = load_end - load_addr;
+	} else if (src != load_ptr) {
+		if (dma_bulk_copy(load_ptr, src, length))
+			memcpy(load_ptr, src, length);
 	}
 
+done:
 	if (image_info) {
 		ulong entry_point;
 
@@ -565,6 +903,16 @@ __weak void *board_spl_fit_buffer_addr(ulong fit_size, int sectors, int bl_len)
 	return spl_get_fit_load_buffer(sectors * bl_len);
 }
 
+/* By default, every FIT is verified in full */
+__weak bool board_spl_fit_verified(const void *fit, const u8 *digest)
+{
+	return false;
+}
+
+__weak void board_spl_fit_set_verified(const void *fit, const u8 *digest)
+{
+}
+
 /*
  * Weak default function to allow customizing SPL fit loading for load-only
  * use cases by allowing to skip the parsing/processing of the FIT contents
@@ -690,12 +1038,22 @@ static int spl_simple_fit_parse(struct spl_fit_info *ctx)
 	if (ctx->conf_node < 0)
 		return -EINVAL;
 
+	if (IS_ENABLED(CONFIG_SPL_FIT_VERIFY_CACHE)) {
+		sha256_csum_wd(ctx->fit, fdt_totalsize(ctx->fit), ctx->digest,
+			       CHUNKSZ_SHA256);
+		ctx->verified = board_spl_fit_verified(ctx->fit, ctx->digest);
+	}
+
 	if (IS_ENABLED(CONFIG_SPL_FIT_SIGNATURE)) {
 		printf("## Checking hash(es) for config %s ... ",
 		       fit_get_name(ctx->fit, ctx->conf_node, NULL));
-		if (fit_config_verify(ctx->fit, ctx->conf_node))
-			return -EPERM;
-		puts("OK\n");
+		if (ctx->verified) {
+			puts("already verified\n");
+		} else {
+			if (fit_config_verify(ctx->fit, ctx->conf_node))
+				return -EPERM;
+			puts("OK\n");
+		}
 	}
 
 	/* find the node holding the images information */
@@ -709,11 +1067,160 @@ static int spl_simple_fit_parse(struct spl_fit_info *ctx)
 	return 0;
 }
 
+/**
+ * spl_fit_span_add() - Add an image to the list of those to read together
+ *
+ * @ctx: FIT context
+ * @span: Span to add to, with images kept in order of their data offset
+ * @node: Offset of the image node
+ * Return: 0 if OK (or the image was already added, or has no external data),
+ *	-E2BIG if there are too many images
+ */
+static int spl_fit_span_add(const struct spl_fit_info *ctx,
+			    struct spl_fit_span *span, int node)
+{
+	int offset, len, i;
+
+	if (fit_image_get_data_position(ctx->fit, node, &offset)) {
+		if (fit_image_get_data_offset(ctx->fit, node, &offset))
+			return 0;
+		offset += ctx->ext_data_offset;
+	}
+	if (fit_image_get_data_size(ctx->fit, node, &len) || !len)
+		return 0;
+
+	for (i = 0; i < span->count; i++) {
+		if (span->part[i].node == node)
+			return 0;
+	}
+	if (span->count == SPL_FIT_SPAN_MAX)
+		return -E2BIG;
+
+	for (i = span->count; i && span->part[i - 1].start > offset; i--)
+		span->part[i] = span->part[i - 1];
+	span->part[i].node = node;
+	span->part[i].start = offset;
+	span->part[i].length = len;
+	span->part[i].bad = false;
+	span->part[i].hsr.count = 0;
+	span->count++;
+
+	return 0;
+}
+
+/**
+ * spl_fit_free_span() - Free images which were read together
+ *
+ * @ctx: FIT context
+ */
+static void spl_fit_free_span(struct spl_fit_info *ctx)
+{
+	struct spl_fit_span *span = ctx->span;
+	int i;
+
+	if (!span)
+		return;
+	for (i = 0; i < span->count; i++)
+		fit_hasher_abort(&span->part[i].hsr);
+	free(span->buf);
+	free(span);
+	ctx->span = NULL;
+}
+
+/**
+ * spl_fit_read_span() - Read all the images in the configuration together
+ *
+ * If the external data of the images to be loaded is adjacent in the FIT, it
+ * is read with a single read, in pieces, hashing each image as its data
+ * arrives. This avoids the cost of starting a separate read for each image,
+ * which is high for some devices and filesystems. The images are then copied
+ * or decompressed from the buffer by load_simple_fit()
+ *
+ * If the images are not adjacent or there is not enough memory, nothing is
+ * done and the images are read separately.
+ *
+ * @ctx: FIT context, whose @span is set up if the images are read
+ * @info: Information about the device to read from
+ * @fit_offset: Offset of the FIT on the device
+ */
+static void spl_fit_read_span(struct spl_fit_info *ctx,
+			      struct spl_load_info *info, ulong fit_offset)
+{
+	static const char *const props[] = {
+		FIT_FIRMWARE_PROP, FIT_KERNEL_PROP, FIT_LOADABLE_PROP,
+		FIT_FDT_PROP,
+	};
+	struct spl_fit_span *span;
+	ulong start, end, overhead, size;
+	int node, index, i;
+
+	span = malloc(sizeof(*span));
+	if (!span)
+		return;
+	span->buf = NULL;
+	span->count = 0;
+	ctx->span = span;
+
+	for (i = 0; i < ARRAY_SIZE(props); i++) {
+		if (!IS_ENABLED(CONFIG_SPL_OS_BOOT) &&
+		    !strcmp(props[i], FIT_KERNEL_PROP))
+			continue;
+		for (index = 0;; index++) {
+			node = spl_fit_get_image_node(ctx, props[i], index);
+			if (node < 0)
+				break;
+			if (spl_fit_span_add(ctx, span, node))
+				goto skip;
+		}
+	}
+	if (span->count < 2)
+		goto skip;
+
+	start = span->part[0].start;
+	end = start;
+	for (i = 0; i < span->count; i++) {
+		struct spl_fit_part *part = &span->part[i];
+
+		if (part->start > end + SPL_FIT_SPAN_GAP) {
+			debug("%s: images are not adjacent\n", __func__);
+			goto skip;
+		}
+		end = max(end, part->start + part->length);
+	}
+
+	overhead = get_aligned_image_overhead(info, start);
+	size = get_aligned_image_size(info, end - start, start);
+	span->buf = malloc_cache_aligned(size);
+	if (!span->buf) {
+		debug("%s: no memory for %lx bytes\n", __func__, size);
+		goto skip;
+	}
+
+	for (i = 0; i < span->count; i++) {
+		struct spl_fit_part *part = &span->part[i];
+
+		part->start += overhead - start;
+		if (CONFIG_IS_ENABLED(FIT_SIGNATURE) && !ctx->verified)
+			fit_hasher_start(&part->hsr, ctx->fit, part->node);
+	}
+	debug("%s: reading %d images, %lx bytes\n", __func__, span->count,
+	      size);
+	if (spl_fit_read_hashed(info, fit_offset +
+				get_aligned_image_offset(info, start), size,
+				span->buf, span->part, span->count) <
+	    overhead + end - start)
+		goto skip;
+
+	return;
+skip:
+	spl_fit_free_span(ctx);
+}
+
 int spl_load_simple_fit(struct spl_image_info *spl_image,
 			struct spl_load_info *info, ulong offset, void *fit)
 {
 	struct spl_image_info image_info;
-	struct spl_fit_info ctx;
+	struct spl_fit_info ctx = { .span = NULL, .verified = false };
 	int node = -1;
 	int ret;
 	int index = 0;
@@ -736,6 +1243,9 @@ int spl_load_simple_fit(struct spl_image_info *spl_image,
 	if (IS_ENABLED(CONFIG_SPL_FPGA))
 		spl_fit_load_fpga(&ctx, info, offset);
 
+	if (IS_ENABLED(CONFIG_SPL_LOAD_FIT_READ_SPAN))
+		spl_fit_read_span(&ctx, info, offset);
+
 	/*
 	 * Find the U-Boot image using the following search order:
 	 *   - start at 'firmware' (e.g. an ARM Trusted Firmware)
@@ -760,13 +1270,14 @@ int spl_load_simple_fit(struct spl_image_info *spl_image,
 	if (node < 0) {
 		debug("%s: Cannot find u-boot image node: %d\n",
 		      __func__, node);
-		return -1;
+		ret = -1;
+		goto out;
 	}
 
 	/* Load the image and set up the spl_image structure */
 	ret = load_simple_fit(info, offset, &ctx, node, spl_image);
 	if (ret)
-		return ret;
+		goto out;
 
 	/*
 	 * For backward compatibility, we treat the first node that is
@@ -784,7 +1295,7 @@ int spl_load_simple_fit(struct spl_image_info *spl_image,
 	if (os_takes_devicetree(spl_image->os)) {
 		ret = spl_fit_append_fdt(spl_image, info, offset, &ctx);
 		if (ret < 0 && spl_image->os != IH_OS_U_BOOT)
-			return ret;
+			goto out;
 	}
 
 	firmware_node = node;
@@ -809,7 +1320,7 @@ int spl_load_simple_fit(struct spl_image_info *spl_image,
 		if (ret < 0) {
 			printf("%s: can't load image loadables index %d (ret = %d)\n",
 			       __func__, index, ret);
-			return ret;
+			goto out;
 		}
 
 		if (spl_fit_image_is_fpga(ctx.fit, node))
@@ -847,8 +1358,14 @@ int spl_load_simple_fit(struct spl_image_info *spl_image,
 		spl_image->entry_point = spl_image->load_addr;
 
 	spl_image->flags |= SPL_FIT_FOUND;
+	if (IS_ENABLED(CONFIG_SPL_FIT_VERIFY_CACHE) && !ctx.verified)
+		board_spl_fit_set_verified(ctx.fit, ctx.digest);
+	ret = 0;
 
-	return 0;
+out:
+	spl_fit_free_span(&ctx);
+
+	return ret;
 }
 
 /* Parse and load full fitImage in SPL */
@@ -867,6 +1384,8 @@ int spl_load_fit_image(struct spl_image_info *spl_image,
 #ifdef CONFIG_SPL_FIT_SIGNATURE
 	images.verify = 1;
 #endif
+	/* Each image is decompressed before fit_image_load() returns */
+	images.decomp_job = NULL;
 	ret = fit_image_load(&images, virt_to_phys((void *)header),
 			     NULL, &fit_uname_config,
 			     IH_ARCH_DEFAULT, IH_TYPE_STANDALONE, -1,
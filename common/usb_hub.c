@@ -59,6 +59,7 @@ struct usb_device_scan {
 };
 
 static LIST_HEAD(usb_scan_list);
+static bool usb_scan_deferred;
 
 __weak void usb_hub_reset_devices(struct usb_hub_device *hub, int port)
 {
@@ -574,8 +575,11 @@ static int usb_device_list_scan(void)
 	static int running;
 	int ret = 0;
 
-	/* Only run this loop once for each controller */
-	if (running)
+	/*
+	 * Only run this loop once for each controller, or once for all of
+	 * them if scanning is deferred
+	 */
+	if (running || usb_scan_deferred)
 		return 0;
 
 	running = 1;
@@ -606,6 +610,18 @@ out:
 	return ret;
 }
 
+void usb_hub_scan_defer(void)
+{
+	usb_scan_deferred = true;
+}
+
+int usb_hub_scan_pending(void)
+{
+	usb_scan_deferred = false;
+
+	return usb_device_list_scan();
+}
+
 static struct usb_hub_device *usb_get_hub_device(struct usb_device *dev)
 {
 	struct usb_hub_device *hub;
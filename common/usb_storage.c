@@ -43,6 +43,7 @@
 #include <asm/byteorder.h>
 #include <asm/cache.h>
 #include <asm/processor.h>
+#include <asm/unaligned.h>
 #include <dm/device-internal.h>
 #include <dm/lists.h>
 #include <linux/delay.h>
@@ -68,6 +69,22 @@ static const unsigned char us_direction[256/8] = {
 static struct scsi_cmd usb_ccb __aligned(ARCH_DMA_MINALIGN);
 static __u32 CBWTag;
 
+/* Most UAS commands kept in flight at once, each on its own stream */
+#define US_UAS_MAX_CMDS		8
+
+/* Information units of a UAS command, each in its own cache lines */
+struct us_uas_cmd {
+	struct uas_command_iu ciu __aligned(ARCH_DMA_MINALIGN);
+	struct uas_sense_iu siu __aligned(ARCH_DMA_MINALIGN);
+	unsigned int queued;
+#	define UAS_QUEUED_STATUS	(1 << 0)
+#	define UAS_QUEUED_DATA		(1 << 1)
+#	define UAS_QUEUED_CMD		(1 << 2)
+};
+
+static struct us_uas_cmd usb_uas_cmds[US_UAS_MAX_CMDS];
+static struct scsi_cmd usb_uas_ccbs[US_UAS_MAX_CMDS] __aligned(ARCH_DMA_MINALIGN);
+
 static int usb_max_devs; /* number of highest available usb device */
 
 #if !CONFIG_IS_ENABLED(BLK)
@@ -102,12 +119,33 @@ struct us_data {
 	trans_cmnd	transport;		/* transport routine */
 	unsigned short	max_xfer_blk;		/* maximum transfer blocks */
 	bool		cmd12;			/* use 12-byte commands (RBC/UFI) */
+	unsigned char	ep_cmd;			/* UAS command pipe */
+	unsigned char	ep_status;		/* UAS status pipe */
+	unsigned char	uas_cmds;		/* UAS commands in flight */
+	bool		sense_valid;		/* UAS sense not yet requested */
+	unsigned char	sense[18];		/* UAS sense of last command */
+	unsigned int	quirks;			/* US_QUIRK_... */
 };
 
 #if !CONFIG_IS_ENABLED(BLK)
 static struct us_data usb_stor[USB_MAX_STOR_DEV];
 #endif
 
+/* Devices which cannot take the usual transfer size, or VPD requests */
+struct us_quirk {
+	unsigned short	vendor;
+	unsigned short	product;
+	unsigned short	max_xfer_blk;		/* 0 for no extra limit */
+	unsigned int	flags;
+#	define US_QUIRK_NO_VPD	(1 << 0)	/* VPD pages upset it */
+};
+
+static const struct us_quirk usb_stor_quirks[] = {
+	/* Genesys Logic USB-IDE bridges hang with more than 64 sectors */
+	{ 0x05e3, 0x0701, 64, US_QUIRK_NO_VPD },
+	{ 0x05e3, 0x0702, 64, US_QUIRK_NO_VPD },
+};
+
 #define USB_STOR_TRANSPORT_GOOD	   0
 #define USB_STOR_TRANSPORT_FAILED -1
 #define USB_STOR_TRANSPORT_ERROR  -2
@@ -176,6 +214,11 @@ static unsigned int usb_get_max_lun(struct us_data *us)
 {
 	int len;
 	ALLOC_CACHE_ALIGN_BUFFER(unsigned char, result, 1);
+
+	/* UAS has no class request for this; only LUN 0 is used */
+	if (us->protocol == US_PR_UAS)
+		return 0;
+
 	len = usb_control_msg(us->pusb_dev,
 			      usb_rcvctrlpipe(us->pusb_dev, 0),
 			      US_BBB_GET_MAX_LUN,
@@ -544,16 +587,16 @@ static int usb_stor_CB_reset(struct us_data *us)
 }
 
 /*
- * Set up the command for a BBB device. Note that the actual SCSI
+ * Fill in the CBW for a BBB device. Note that the actual SCSI
  * command is copied into cbw.CBWCDB.
  */
-static int usb_stor_BBB_comdat(struct scsi_cmd *srb, struct us_data *us)
+static int usb_stor_BBB_fill_cbw(struct scsi_cmd *srb,
+				 struct umass_bbb_cbw *cbw)
 {
-	int result;
-	int actlen;
 	int dir_in;
-	unsigned int pipe;
-	ALLOC_CACHE_ALIGN_BUFFER(struct umass_bbb_cbw, cbw, 1);
+#ifdef BBB_COMDAT_TRACE
+	int result;
+#endif
 
 	dir_in = US_DIRECTION(srb->cmd[0]);
 
@@ -573,9 +616,6 @@ static int usb_stor_BBB_comdat(struct scsi_cmd *srb, struct us_data *us)
 		return -1;
 	}
 
-	/* always OUT to the ep */
-	pipe = usb_sndbulkpipe(us->pusb_dev, us->ep_out);
-
 	cbw->dCBWSignature = cpu_to_le32(CBWSIGNATURE);
 	cbw->dCBWTag = cpu_to_le32(CBWTag++);
 	cbw->dCBWDataTransferLength = cpu_to_le32(srb->datalen);
@@ -586,6 +626,27 @@ static int usb_stor_BBB_comdat(struct scsi_cmd *srb, struct us_data *us)
 	/* DST SRC LEN!!! */
 
 	memcpy(cbw->CBWCDB, srb->cmd, srb->cmdlen);
+
+	return 0;
+}
+
+/*
+ * Set up the command for a BBB device and send it.
+ */
+static int usb_stor_BBB_comdat(struct scsi_cmd *srb, struct us_data *us)
+{
+	int result;
+	int actlen;
+	unsigned int pipe;
+	ALLOC_CACHE_ALIGN_BUFFER(struct umass_bbb_cbw, cbw, 1);
+
+	result = usb_stor_BBB_fill_cbw(srb, cbw);
+	if (result < 0)
+		return result;
+
+	/* always OUT to the ep */
+	pipe = usb_sndbulkpipe(us->pusb_dev, us->ep_out);
+
 	result = usb_bulk_msg(us->pusb_dev, pipe, cbw, UMASS_BBB_CBW_SIZE,
 			      &actlen, USB_CNTL_TIMEOUT * 5);
 	if (result < 0)
@@ -593,6 +654,93 @@ static int usb_stor_BBB_comdat(struct scsi_cmd *srb, struct us_data *us)
 	return result;
 }
 
+/*
+ * Queue the CBW, the data stage and the CSW of a BBB command on the host
+ * controller at once, and then reap them in order. This saves the per-phase
+ * round trip on host controllers which support several bulk transfers in
+ * flight.
+ *
+ * Returns 0 if all three stages completed, -ENOSYS or -EBUSY if the host
+ * could not take the whole command (nothing has been sent in that case, so
+ * the caller should use the synchronous path), -EIO if the command itself
+ * could not be delivered and the device needs a reset, or another negative
+ * value if the data or status stage failed. In the last case *data_result
+ * and *csw_result tell which stage went wrong, so the caller can run the
+ * usual stall recovery.
+ */
+static int usb_stor_BBB_pipelined(struct scsi_cmd *srb, struct us_data *us,
+				  struct umass_bbb_csw *csw, int *data_actlen,
+				  int *data_result, int *csw_result)
+{
+	struct usb_device *udev = us->pusb_dev;
+	unsigned int pipein, pipeout, pipe;
+	unsigned long data_status = 0;
+	int cbw_result;
+	int result;
+	ALLOC_CACHE_ALIGN_BUFFER(struct umass_bbb_cbw, cbw, 1);
+
+	pipein = usb_rcvbulkpipe(udev, us->ep_in);
+	pipeout = usb_sndbulkpipe(udev, us->ep_out);
+	pipe = US_DIRECTION(srb->cmd[0]) ? pipein : pipeout;
+
+	/* Only take this path once the device has settled */
+	if (!(us->flags & USB_READY))
+		return -EBUSY;
+
+	result = usb_stor_BBB_fill_cbw(srb, cbw);
+	if (result < 0)
+		return -EIO;
+
+	result = usb_queue_bulk_msg(udev, pipeout, 0, cbw, UMASS_BBB_CBW_SIZE);
+	if (result < 0) {
+		/* The tag was not used after all */
+		CBWTag--;
+		return result;
+	}
+	if (srb->datalen) {
+		result = usb_queue_bulk_msg(udev, pipe, 0, srb->pdata,
+					    srb->datalen);
+		if (result < 0)
+			goto err_reap_cbw;
+	}
+	result = usb_queue_bulk_msg(udev, pipein, 0, csw, UMASS_BBB_CSW_SIZE);
+	if (result < 0)
+		goto err_reap_data;
+
+	cbw_result = usb_reap_bulk_msg(udev, pipeout);
+	*data_result = 0;
+	*data_actlen = 0;
+	if (srb->datalen) {
+		*data_result = usb_reap_bulk_msg(udev, pipe);
+		*data_actlen = udev->act_len;
+		data_status = udev->status;
+	}
+	*csw_result = usb_reap_bulk_msg(udev, pipein);
+
+	if (cbw_result < 0) {
+		debug("failed to send CBW status %ld\n", udev->status);
+		return -EIO;
+	}
+	if (*data_result < 0) {
+		/* Report the data stage status to the caller */
+		udev->status = data_status;
+		return *data_result;
+	}
+
+	return *csw_result;
+
+err_reap_data:
+	/*
+	 * The host ran out of room part way through; let the already-queued
+	 * stages complete and fall back to the synchronous path for the rest.
+	 */
+	if (srb->datalen)
+		usb_reap_bulk_msg(udev, pipe);
+err_reap_cbw:
+	usb_reap_bulk_msg(udev, pipeout);
+	return -EIO;
+}
+
 /* FIXME: we also need a CBI_command which sets up the completion
  * interrupt, and waits for it
  */
@@ -733,6 +881,44 @@ static int usb_stor_BBB_transport(struct scsi_cmd *srb, struct us_data *us)
 #endif
 
 	dir_in = US_DIRECTION(srb->cmd[0]);
+	pipein = usb_rcvbulkpipe(us->pusb_dev, us->ep_in);
+	pipeout = usb_sndbulkpipe(us->pusb_dev, us->ep_out);
+
+	if (IS_ENABLED(CONFIG_USB_STORAGE_PIPELINE)) {
+		int data_result, csw_result;
+
+		result = usb_stor_BBB_pipelined(srb, us, csw, &data_actlen,
+						&data_result, &csw_result);
+		if (!result)
+			goto check_csw;
+		if (result != -ENOSYS && result != -EBUSY) {
+			if (result == -EIO) {
+				usb_stor_BBB_reset(us);
+				return USB_STOR_TRANSPORT_FAILED;
+			}
+			/* A failed CSW is re-read synchronously */
+			if (data_result >= 0)
+				goto st;
+			if (!(us->pusb_dev->status & USB_ST_STALLED)) {
+				debug("usb_bulk_msg error status %ld\n",
+				      us->pusb_dev->status);
+				usb_stor_BBB_reset(us);
+				return USB_STOR_TRANSPORT_FAILED;
+			}
+			/* Data stage stalled: clear it and re-read the CSW */
+			debug("DATA:stall\n");
+			result = usb_stor_BBB_clear_endpt_stall(us,
+					dir_in ? us->ep_in : us->ep_out);
+			if (result < 0) {
+				usb_stor_BBB_reset(us);
+				return USB_STOR_TRANSPORT_FAILED;
+			}
+			/* The CSW may already be in after an OUT stall */
+			if (csw_result >= 0)
+				goto check_csw;
+			goto st;
+		}
+	}
 
 	/* COMMAND phase */
 	debug("COMMAND phase\n");
@@ -745,8 +931,6 @@ static int usb_stor_BBB_transport(struct scsi_cmd *srb, struct us_data *us)
 	}
 	if (!(us->flags & USB_READY))
 		mdelay(5);
-	pipein = usb_rcvbulkpipe(us->pusb_dev, us->ep_in);
-	pipeout = usb_sndbulkpipe(us->pusb_dev, us->ep_out);
 	/* DATA phase + error handling */
 	data_actlen = 0;
 	/* no data, go immediately to the STATUS phase */
@@ -805,6 +989,7 @@ again:
 		usb_stor_BBB_reset(us);
 		return USB_STOR_TRANSPORT_FAILED;
 	}
+check_csw:
 #ifdef BBB_XPORT_TRACE
 	ptr = (unsigned char *)csw;
 	for (index = 0; index < UMASS_BBB_CSW_SIZE; index++)
@@ -955,6 +1140,266 @@ do_retry:
 	return USB_STOR_TRANSPORT_FAILED;
 }
 
+static unsigned long usb_stor_UAS_data_pipe(struct scsi_cmd *srb,
+					    struct us_data *us)
+{
+	if (US_DIRECTION(srb->cmd[0]))
+		return usb_rcvbulkpipe(us->pusb_dev, us->ep_in);
+
+	return usb_sndbulkpipe(us->pusb_dev, us->ep_out);
+}
+
+static int usb_stor_UAS_reset(struct us_data *us)
+{
+	struct usb_device *udev = us->pusb_dev;
+
+	debug("UAS reset\n");
+	usb_clear_halt(udev, usb_sndbulkpipe(udev, us->ep_cmd));
+	usb_clear_halt(udev, usb_rcvbulkpipe(udev, us->ep_status));
+	usb_clear_halt(udev, usb_rcvbulkpipe(udev, us->ep_in));
+	usb_clear_halt(udev, usb_sndbulkpipe(udev, us->ep_out));
+
+	return 0;
+}
+
+/*
+ * Run up to us->uas_cmds commands at once. Command n is sent with tag and
+ * stream n + 1. For each command the data and status buffers are posted to
+ * the host controller before the command itself, so the device can answer
+ * on any stream as soon as it likes. If the host has no room for the data
+ * of a later command, only the earlier ones are run and *count is reduced
+ * to match. The sense data of a failed command is kept for the REQUEST
+ * SENSE which usually follows.
+ */
+static int usb_stor_UAS_run(struct scsi_cmd *srbs, int *count,
+			    struct us_data *us)
+{
+	struct usb_device *udev = us->pusb_dev;
+	unsigned long cmd_pipe = usb_sndbulkpipe(udev, us->ep_cmd);
+	unsigned long status_pipe = usb_rcvbulkpipe(udev, us->ep_status);
+	int result = USB_STOR_TRANSPORT_GOOD;
+	struct scsi_cmd *srb;
+	struct us_uas_cmd *uc;
+	int i, n, ret;
+
+	for (n = 0; n < *count; n++) {
+		srb = &srbs[n];
+		uc = &usb_uas_cmds[n];
+
+		memset(&uc->ciu, 0, sizeof(uc->ciu));
+		uc->ciu.iu_id = UAS_IU_COMMAND;
+		uc->ciu.tag = cpu_to_be16(n + 1);
+		uc->ciu.lun[1] = srb->lun;
+		memcpy(uc->ciu.cdb, srb->cmd, srb->cmdlen);
+		uc->queued = 0;
+
+		if (srb->datalen) {
+			ret = usb_queue_bulk_msg(udev,
+						 usb_stor_UAS_data_pipe(srb, us),
+						 n + 1, srb->pdata,
+						 srb->datalen);
+			if (ret == -EBUSY && n) {
+				/* Run the commands queued so far */
+				*count = n;
+				break;
+			}
+			if (ret)
+				break;
+			uc->queued |= UAS_QUEUED_DATA;
+		}
+		ret = usb_queue_bulk_msg(udev, status_pipe, n + 1, &uc->siu,
+					 sizeof(uc->siu));
+		if (ret)
+			break;
+		uc->queued |= UAS_QUEUED_STATUS;
+		ret = usb_queue_bulk_msg(udev, cmd_pipe, 0, &uc->ciu,
+					 sizeof(uc->ciu));
+		if (ret)
+			break;
+		uc->queued |= UAS_QUEUED_CMD;
+	}
+	if (n < *count) {
+		debug("UAS: cannot queue command %d: %d\n", n, ret);
+		result = USB_STOR_TRANSPORT_ERROR;
+		/* Whatever was queued for it must be reaped too */
+		n++;
+	}
+
+	/* Reap everything in the order it was queued on each pipe */
+	for (i = 0; i < n; i++) {
+		if ((usb_uas_cmds[i].queued & UAS_QUEUED_CMD) &&
+		    usb_reap_bulk_msg(udev, cmd_pipe))
+			result = USB_STOR_TRANSPORT_ERROR;
+	}
+	for (i = 0; i < n; i++) {
+		srb = &srbs[i];
+		uc = &usb_uas_cmds[i];
+
+		if (uc->queued & UAS_QUEUED_DATA) {
+			ret = usb_reap_bulk_msg(udev,
+						usb_stor_UAS_data_pipe(srb, us));
+			srb->trans_bytes = udev->act_len;
+			if (ret)
+				result = USB_STOR_TRANSPORT_ERROR;
+		}
+		if (!(uc->queued & UAS_QUEUED_STATUS))
+			continue;
+		if (usb_reap_bulk_msg(udev, status_pipe) ||
+		    !(uc->queued & UAS_QUEUED_CMD)) {
+			result = USB_STOR_TRANSPORT_ERROR;
+			continue;
+		}
+
+		if (uc->siu.iu_id != UAS_IU_SENSE ||
+		    be16_to_cpu(uc->siu.tag) != i + 1) {
+			debug("UAS: bad status IU %#x tag %d\n",
+			      uc->siu.iu_id, be16_to_cpu(uc->siu.tag));
+			result = USB_STOR_TRANSPORT_ERROR;
+		} else if (uc->siu.status) {
+			debug("UAS: cmd %#x status %#x\n", srb->cmd[0],
+			      uc->siu.status);
+			memset(us->sense, 0, sizeof(us->sense));
+			memcpy(us->sense, uc->siu.sense,
+			       min_t(int, be16_to_cpu(uc->siu.len),
+				     sizeof(us->sense)));
+			us->sense_valid = true;
+			if (result == USB_STOR_TRANSPORT_GOOD)
+				result = USB_STOR_TRANSPORT_FAILED;
+		}
+	}
+
+	if (result == USB_STOR_TRANSPORT_ERROR) {
+		usb_stor_UAS_reset(us);
+		return USB_STOR_TRANSPORT_FAILED;
+	}
+
+	return result;
+}
+
+static int usb_stor_UAS_transport(struct scsi_cmd *srb, struct us_data *us)
+{
+	int count = 1;
+
+	/* The sense data came with the status of the failed command */
+	if (srb->cmd[0] == SCSI_REQ_SENSE && us->sense_valid) {
+		memset(srb->pdata, 0, srb->datalen);
+		memcpy(srb->pdata, us->sense,
+		       min_t(unsigned long, srb->datalen, sizeof(us->sense)));
+		us->sense_valid = false;
+		return USB_STOR_TRANSPORT_GOOD;
+	}
+	us->sense_valid = false;
+
+	return usb_stor_UAS_run(srb, &count, us);
+}
+
+/*
+ * Find the UAS alternate setting of the interface and its pipes, switch to
+ * it and set up streams on the status and data pipes. This needs a USB 3
+ * device, since USB 2 UAS works without streams and is not supported here.
+ */
+static int usb_stor_UAS_setup(struct usb_device *dev,
+			      struct usb_interface *iface, struct us_data *ss)
+{
+	unsigned char pipe_ep[UAS_PIPE_DATA_OUT + 1] = { 0 };
+	unsigned int max_streams = US_UAS_MAX_CMDS;
+	struct usb_endpoint_descriptor *ep_desc = NULL;
+	struct usb_interface_descriptor *if_desc;
+	struct usb_ss_ep_comp_descriptor *comp;
+	struct usb_descriptor_header *head;
+	unsigned int ep_streams = 0;
+	unsigned long pipes[3];
+	int len, index, ret;
+	bool in_uas = false;
+	int alt = -1;
+	u8 *buf;
+
+	if (dev->speed < USB_SPEED_SUPER)
+		return -ENODEV;
+
+	len = dev->config.desc.wTotalLength;
+	buf = malloc_cache_aligned(len);
+	if (!buf)
+		return -ENOMEM;
+	ret = usb_get_configuration_no(dev, 0, buf, len);
+	if (ret < 0)
+		goto out;
+
+	for (index = 0; index + 2 <= len; index += head->bLength) {
+		head = (struct usb_descriptor_header *)&buf[index];
+		if (head->bLength < 2 || index + head->bLength > len)
+			break;
+
+		switch (head->bDescriptorType) {
+		case USB_DT_INTERFACE:
+			if_desc = (struct usb_interface_descriptor *)head;
+			in_uas = alt < 0 &&
+				 if_desc->bInterfaceNumber ==
+					iface->desc.bInterfaceNumber &&
+				 if_desc->bInterfaceClass ==
+					USB_CLASS_MASS_STORAGE &&
+				 if_desc->bInterfaceSubClass == US_SC_SCSI &&
+				 if_desc->bInterfaceProtocol == US_PR_UAS;
+			if (in_uas)
+				alt = if_desc->bAlternateSetting;
+			ep_desc = NULL;
+			break;
+		case USB_DT_ENDPOINT:
+			ep_desc = (struct usb_endpoint_descriptor *)head;
+			ep_streams = 0;
+			break;
+		case USB_DT_SS_ENDPOINT_COMP:
+			comp = (struct usb_ss_ep_comp_descriptor *)head;
+			if (ep_desc && usb_endpoint_xfer_bulk(ep_desc) &&
+			    (comp->bmAttributes & 0x1f))
+				ep_streams = 1 << (comp->bmAttributes & 0x1f);
+			break;
+		case USB_DT_PIPE_USAGE:
+			if (!in_uas || !ep_desc || head->bLength < 4 ||
+			    buf[index + 2] > UAS_PIPE_DATA_OUT)
+				break;
+			pipe_ep[buf[index + 2]] = ep_desc->bEndpointAddress &
+						  USB_ENDPOINT_NUMBER_MASK;
+			if (buf[index + 2] != UAS_PIPE_CMD)
+				max_streams = min(max_streams, ep_streams);
+			break;
+		}
+	}
+
+	ret = -ENODEV;
+	if (alt < 0 || !pipe_ep[UAS_PIPE_CMD] || !pipe_ep[UAS_PIPE_STATUS] ||
+	    !pipe_ep[UAS_PIPE_DATA_IN] || !pipe_ep[UAS_PIPE_DATA_OUT] ||
+	    !max_streams)
+		goto out;
+
+	ret = usb_set_interface(dev, iface->desc.bInterfaceNumber, alt);
+	if (ret)
+		goto out;
+
+	pipes[0] = usb_rcvbulkpipe(dev, pipe_ep[UAS_PIPE_STATUS]);
+	pipes[1] = usb_rcvbulkpipe(dev, pipe_ep[UAS_PIPE_DATA_IN]);
+	pipes[2] = usb_sndbulkpipe(dev, pipe_ep[UAS_PIPE_DATA_OUT]);
+	ret = usb_alloc_streams(dev, pipes, ARRAY_SIZE(pipes), max_streams);
+	if (ret < 1) {
+		debug("UAS: no streams: %d\n", ret);
+		usb_set_interface(dev, iface->desc.bInterfaceNumber, 0);
+		ret = ret ? ret : -ENODEV;
+		goto out;
+	}
+
+	ss->ep_cmd = pipe_ep[UAS_PIPE_CMD];
+	ss->ep_status = pipe_ep[UAS_PIPE_STATUS];
+	ss->ep_in = pipe_ep[UAS_PIPE_DATA_IN];
+	ss->ep_out = pipe_ep[UAS_PIPE_DATA_OUT];
+	ss->uas_cmds = min(ret, US_UAS_MAX_CMDS);
+	ss->protocol = US_PR_UAS;
+	ss->subclass = US_SC_SCSI;
+	ret = 0;
+out:
+	free(buf);
+	return ret;
+}
+
 static void usb_stor_set_max_xfer_blk(struct usb_device *udev,
 				      struct us_data *us)
 {
@@ -973,9 +1418,15 @@ static void usb_stor_set_max_xfer_blk(struct usb_device *udev,
 	 * Tests show that other operating have similar limits with Microsoft
 	 * Windows 7 limiting transfers to 128 sectors for both USB2 and USB3
 	 * and Apple Mac OS X 10.11 limiting transfers to 256 sectors for USB2
-	 * and 2048 for USB3 devices.
+	 * and 2048 for USB3 devices. SuperSpeed devices do not use such old
+	 * bridges, so follow Mac OS X (and Linux) there.
+	 *
+	 * The host controller may allow less, and quirky devices even less.
+	 * This is refined by usb_stor_limit_xfer_blk() once the block size
+	 * and the device's own limit are known.
 	 */
-	unsigned short blk = 240;
+	unsigned short blk = udev->speed >= USB_SPEED_SUPER ? 2048 : 240;
+	const struct us_quirk *quirk;
 
 #if CONFIG_IS_ENABLED(DM_USB)
 	size_t size;
@@ -986,9 +1437,82 @@ static void usb_stor_set_max_xfer_blk(struct usb_device *udev,
 		blk = size / 512;
 #endif
 
+	for (quirk = usb_stor_quirks;
+	     quirk < usb_stor_quirks + ARRAY_SIZE(usb_stor_quirks); quirk++) {
+		if (quirk->vendor != udev->descriptor.idVendor ||
+		    quirk->product != udev->descriptor.idProduct)
+			continue;
+		debug("USB storage quirks %#x, max %d blocks\n",
+		      quirk->flags, quirk->max_xfer_blk);
+		us->quirks = quirk->flags;
+		if (quirk->max_xfer_blk && quirk->max_xfer_blk < blk)
+			blk = quirk->max_xfer_blk;
+	}
+
 	us->max_xfer_blk = blk;
 }
 
+/*
+ * Lower the transfer size set up by usb_stor_set_max_xfer_blk() to what
+ * the host controller allows in blocks of the real size, and to the
+ * device's Maximum Transfer Length if it reports one. As the limit is
+ * shared by all LUNs, it is never raised.
+ */
+static void usb_stor_limit_xfer_blk(struct usb_device *udev,
+				    struct us_data *us, u32 blksz,
+				    u32 dev_max_blk)
+{
+	u32 blk = us->max_xfer_blk;
+
+#if CONFIG_IS_ENABLED(DM_USB)
+	size_t size;
+
+	if (blksz > 512 && usb_get_max_xfer_size(udev, &size) >= 0)
+		blk = min_t(u32, blk, size / blksz);
+#endif
+	if (dev_max_blk)
+		blk = min(blk, dev_max_blk);
+
+	us->max_xfer_blk = max_t(u32, blk, 1);
+	debug("USB storage transfers of up to %d blocks\n", us->max_xfer_blk);
+}
+
+/*
+ * Read the Maximum Transfer Length from the Block Limits VPD page, for
+ * devices claiming SPC-3 or later. Older devices, which are most USB
+ * sticks, often misbehave when asked for VPD pages. Returns 0 if there is
+ * no limit or it is unknown.
+ */
+static u32 usb_stor_vpd_max_xfer_blk(struct scsi_cmd *srb,
+				     struct us_data *ss, u8 version)
+{
+	ALLOC_CACHE_ALIGN_BUFFER(u8, vpd, 64);
+	unsigned char *ptr = srb->pdata;
+	int ret;
+
+	if (version < 5 || (ss->quirks & US_QUIRK_NO_VPD))
+		return 0;
+
+	memset(vpd, 0, 64);
+	memset(&srb->cmd[0], 0, 12);
+	srb->cmd[0] = SCSI_INQUIRY;
+	srb->cmd[1] = srb->lun << 5 | 0x01;	/* EVPD */
+	srb->cmd[2] = 0xb0;			/* Block Limits */
+	srb->cmd[4] = 64;
+	srb->datalen = 64;
+	srb->pdata = vpd;
+	srb->cmdlen = ss->cmd12 ? 12 : 6;
+	ret = ss->transport(srb, ss);
+	srb->pdata = ptr;
+	if (ret != USB_STOR_TRANSPORT_GOOD || vpd[1] != 0xb0)
+		return 0;
+
+	debug("Block Limits: max %u, optimal %u blocks\n",
+	      get_unaligned_be32(&vpd[8]), get_unaligned_be32(&vpd[12]));
+
+	return get_unaligned_be32(&vpd[8]);
+}
+
 static int usb_inquiry(struct scsi_cmd *srb, struct us_data *ss)
 {
 	int retry, i;
@@ -1082,11 +1606,12 @@ static int usb_read_capacity(struct scsi_cmd *srb, struct us_data *ss)
 	return -1;
 }
 
-static int usb_read_10(struct scsi_cmd *srb, struct us_data *ss,
-		       unsigned long start, unsigned short blocks)
+static void usb_setup_rw_10(struct scsi_cmd *srb, struct us_data *ss,
+			    unsigned char opcode, unsigned long start,
+			    unsigned short blocks)
 {
 	memset(&srb->cmd[0], 0, 12);
-	srb->cmd[0] = SCSI_READ10;
+	srb->cmd[0] = opcode;
 	srb->cmd[1] = srb->lun << 5;
 	srb->cmd[2] = ((unsigned char) (start >> 24)) & 0xff;
 	srb->cmd[3] = ((unsigned char) (start >> 16)) & 0xff;
@@ -1095,6 +1620,12 @@ static int usb_read_10(struct scsi_cmd *srb, struct us_data *ss,
 	srb->cmd[7] = ((unsigned char) (blocks >> 8)) & 0xff;
 	srb->cmd[8] = (unsigned char) blocks & 0xff;
 	srb->cmdlen = ss->cmd12 ? 12 : 10;
+}
+
+static int usb_read_10(struct scsi_cmd *srb, struct us_data *ss,
+		       unsigned long start, unsigned short blocks)
+{
+	usb_setup_rw_10(srb, ss, SCSI_READ10, start, blocks);
 	debug("read10: start %lx blocks %x\n", start, blocks);
 	return ss->transport(srb, ss);
 }
@@ -1102,20 +1633,51 @@ static int usb_read_10(struct scsi_cmd *srb, struct us_data *ss,
 static int usb_write_10(struct scsi_cmd *srb, struct us_data *ss,
 			unsigned long start, unsigned short blocks)
 {
-	memset(&srb->cmd[0], 0, 12);
-	srb->cmd[0] = SCSI_WRITE10;
-	srb->cmd[1] = srb->lun << 5;
-	srb->cmd[2] = ((unsigned char) (start >> 24)) & 0xff;
-	srb->cmd[3] = ((unsigned char) (start >> 16)) & 0xff;
-	srb->cmd[4] = ((unsigned char) (start >> 8)) & 0xff;
-	srb->cmd[5] = ((unsigned char) (start)) & 0xff;
-	srb->cmd[7] = ((unsigned char) (blocks >> 8)) & 0xff;
-	srb->cmd[8] = (unsigned char) blocks & 0xff;
-	srb->cmdlen = ss->cmd12 ? 12 : 10;
+	usb_setup_rw_10(srb, ss, SCSI_WRITE10, start, blocks);
 	debug("write10: start %lx blocks %x\n", start, blocks);
 	return ss->transport(srb, ss);
 }
 
+/*
+ * Issue up to ss->uas_cmds READ(10)/WRITE(10) commands of ss->max_xfer_blk
+ * blocks each at once. Returns the number of blocks transferred, or 0 if
+ * any command failed, in which case the caller goes on one command at a
+ * time so that errors are retried as usual.
+ */
+static lbaint_t usb_stor_UAS_rw(struct us_data *ss, struct blk_desc *block_dev,
+				lbaint_t start, lbaint_t blks,
+				uintptr_t buf_addr, bool write)
+{
+	unsigned short smallblks;
+	struct scsi_cmd *srb;
+	lbaint_t done = 0;
+	int count;
+
+	for (count = 0; count < ss->uas_cmds && done < blks; count++) {
+		srb = &usb_uas_ccbs[count];
+		smallblks = min_t(lbaint_t, blks - done, ss->max_xfer_blk);
+		srb->lun = block_dev->lun;
+		srb->pdata = (unsigned char *)buf_addr;
+		srb->datalen = block_dev->blksz * smallblks;
+		usb_setup_rw_10(srb, ss, write ? SCSI_WRITE10 : SCSI_READ10,
+				start + done, smallblks);
+		done += smallblks;
+		buf_addr += srb->datalen;
+	}
+
+	ss->sense_valid = false;
+	if (usb_stor_UAS_run(usb_uas_ccbs, &count, ss))
+		return 0;
+
+	/* Fewer commands may have fitted on the host controller */
+	for (done = 0; count > 0; count--)
+		done += usb_uas_ccbs[count - 1].datalen / block_dev->blksz;
+	debug("uas %s: start " LBAF " blocks " LBAF "\n",
+	      write ? "write" : "read", start, done);
+
+	return done;
+}
+
 
 #ifdef CONFIG_USB_BIN_FIXUP
 /*
@@ -1148,7 +1710,7 @@ static unsigned long usb_stor_read(struct blk_desc *block_dev, lbaint_t blknr,
 				   lbaint_t blkcnt, void *buffer)
 #endif
 {
-	lbaint_t start, blks;
+	lbaint_t start, blks, done;
 	uintptr_t buf_addr;
 	unsigned short smallblks;
 	struct usb_device *udev;
@@ -1187,6 +1749,18 @@ static unsigned long usb_stor_read(struct blk_desc *block_dev, lbaint_t blknr,
 	      block_dev->devnum, start, blks, buf_addr);
 
 	do {
+		/* Keep several commands in flight on UAS streams */
+		if (ss->protocol == US_PR_UAS && ss->uas_cmds > 1 &&
+		    blks > ss->max_xfer_blk) {
+			done = usb_stor_UAS_rw(ss, block_dev, start, blks,
+					       buf_addr, false);
+			if (done) {
+				start += done;
+				blks -= done;
+				buf_addr += done * block_dev->blksz;
+				continue;
+			}
+		}
 		/* XXX need some comment here */
 		retry = 2;
 		srb->pdata = (unsigned char *)buf_addr;
@@ -1231,7 +1805,7 @@ static unsigned long usb_stor_write(struct blk_desc *block_dev, lbaint_t blknr,
 				    lbaint_t blkcnt, const void *buffer)
 #endif
 {
-	lbaint_t start, blks;
+	lbaint_t start, blks, done;
 	uintptr_t buf_addr;
 	unsigned short smallblks;
 	struct usb_device *udev;
@@ -1272,6 +1846,18 @@ static unsigned long usb_stor_write(struct blk_desc *block_dev, lbaint_t blknr,
 	      block_dev->devnum, start, blks, buf_addr);
 
 	do {
+		/* Keep several commands in flight on UAS streams */
+		if (ss->protocol == US_PR_UAS && ss->uas_cmds > 1 &&
+		    blks > ss->max_xfer_blk) {
+			done = usb_stor_UAS_rw(ss, block_dev, start, blks,
+					       buf_addr, true);
+			if (done) {
+				start += done;
+				blks -= done;
+				buf_addr += done * block_dev->blksz;
+				continue;
+			}
+		}
 		/* If write fails retry for max retry count else
 		 * return with number of blocks written successfully.
 		 */
@@ -1345,6 +1931,17 @@ int usb_storage_probe(struct usb_device *dev, unsigned int ifnum,
 	ss->subclass = iface->desc.bInterfaceSubClass;
 	ss->protocol = iface->desc.bInterfaceProtocol;
 
+	/* Prefer UAS when both the device and the host controller can do it */
+	if (IS_ENABLED(CONFIG_USB_STORAGE_UAS) &&
+	    !usb_stor_UAS_setup(dev, iface, ss)) {
+		debug("USB Attached SCSI, %d commands\n", ss->uas_cmds);
+		ss->transport = usb_stor_UAS_transport;
+		ss->transport_reset = usb_stor_UAS_reset;
+		usb_stor_set_max_xfer_blk(dev, ss);
+		dev->privptr = (void *)ss;
+		return 1;
+	}
+
 	/* set the handler pointers based on the protocol */
 	debug("Transport: ");
 	switch (ss->protocol) {
@@ -1442,7 +2039,7 @@ int usb_storage_probe(struct usb_device *dev, unsigned int ifnum,
 int usb_stor_get_info(struct usb_device *dev, struct us_data *ss,
 		      struct blk_desc *dev_desc)
 {
-	unsigned char perq, modi;
+	unsigned char perq, modi, version;
 	ALLOC_CACHE_ALIGN_BUFFER(u32, cap, 2);
 	ALLOC_CACHE_ALIGN_BUFFER(u8, usb_stor_buf, 36);
 	u32 capacity, blksz;
@@ -1486,6 +2083,7 @@ int usb_stor_get_info(struct usb_device *dev, struct us_data *ss,
 #endif /* CONFIG_USB_BIN_FIXUP */
 	debug("ISO Vers %X, Response Data %X\n", usb_stor_buf[2],
 	      usb_stor_buf[3]);
+	version = usb_stor_buf[2];
 	if (usb_test_unit_ready(pccb, ss)) {
 		printf("Device NOT ready\n"
 		       "   Request Sense returned %02X %02X %02X\n",
@@ -1522,6 +2120,9 @@ int usb_stor_get_info(struct usb_device *dev, struct us_data *ss,
 	dev_desc->type = perq;
 	debug(" address %d\n", dev_desc->target);
 
+	usb_stor_limit_xfer_blk(dev, ss, blksz,
+				usb_stor_vpd_max_xfer_blk(pccb, ss, version));
+
 	return 1;
 }
 
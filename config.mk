@@ -61,6 +61,14 @@ endif
 
 ifdef FTRACE
 PLATFORM_CPPFLAGS += -finstrument-functions -DFTRACE
+ifneq ($(CONFIG_TRACE_EXCLUDE_FILES),)
+PLATFORM_CPPFLAGS += \
+	-finstrument-functions-exclude-file-list=$(CONFIG_TRACE_EXCLUDE_FILES:"%"=%)
+endif
+ifneq ($(CONFIG_TRACE_EXCLUDE_FUNCS),)
+PLATFORM_CPPFLAGS += \
+	-finstrument-functions-exclude-function-list=$(CONFIG_TRACE_EXCLUDE_FUNCS:"%"=%)
+endif
 endif
 
 #########################################################################
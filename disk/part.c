@@ -13,6 +13,7 @@
 #include <malloc.h>
 #include <part.h>
 #include <ubifs_uboot.h>
+#include <virtiofs.h>
 #include <dm/uclass.h>
 
 #undef	PART_DEBUG
@@ -474,6 +475,25 @@ int blk_get_device_part_str(const char *ifname, const char *dev_part_str,
 	}
 #endif
 
+#if CONFIG_IS_ENABLED(VIRTIO) && IS_ENABLED(CONFIG_VIRTIO_FS)
+	/*
+	 * Special-case virtio-fs, which is a directory shared by the host
+	 * rather than a block device
+	 */
+	if (!strcmp(ifname, "virtiofs")) {
+		ret = virtio_fs_select_name(dev_part_str);
+		if (ret) {
+			printf("** No virtio-fs device %s **\n",
+			       dev_part_str ? dev_part_str : "");
+			return ret;
+		}
+
+		strcpy((char *)info->type, BOOT_PART_TYPE);
+		strcpy((char *)info->name, VIRTIO_FS_PART_NAME);
+		return 0;
+	}
+#endif
+
 #if IS_ENABLED(CONFIG_CMD_UBIFS) && !IS_ENABLED(CONFIG_SPL_BUILD)
 	/*
 	 * Special-case ubi, ubi goes through a mtd, rather than through
@@ -31,6 +31,8 @@
 #include <linux/printk.h>
 #include <u-boot/crc.h>
 
+DECLARE_GLOBAL_DATA_PTR;
+
 /* GUID for basic data partitons */
 #if CONFIG_IS_ENABLED(EFI_PARTITION)
 static const efi_guid_t partition_basic_data_guid = PARTITION_BASIC_DATA_GUID;
@@ -62,6 +64,144 @@ static int is_pte_valid(gpt_entry * pte);
 static int find_valid_gpt(struct blk_desc *desc, gpt_header *gpt_head,
 			  gpt_entry **pgpt_pte);
 
+#if CONFIG_IS_ENABLED(EFI_PARTITION_CACHE)
+/* Number of disks whose GPT is cached */
+#define GPT_CACHE_DISKS		4
+
+/**
+ * struct gpt_cache - A GPT which has been checked
+ *
+ * @desc: Block device the GPT is on, NULL if this entry is not in use
+ * @lba: Block holding @head (the primary or backup header)
+ * @head: GPT header
+ * @pte: Partition entries, which match the CRC in @head
+ * @size: Size of @pte in bytes
+ */
+struct gpt_cache {
+	struct blk_desc *desc;
+	lbaint_t lba;
+	gpt_header head;
+	gpt_entry *pte;
+	size_t size;
+};
+
+static struct gpt_cache gpt_cache[GPT_CACHE_DISKS];
+static int gpt_cache_next;
+
+static struct gpt_cache *gpt_cache_find(struct blk_desc *desc)
+{
+	int i;
+
+	for (i = 0; i < GPT_CACHE_DISKS; i++) {
+		if (gpt_cache[i].desc == desc)
+			return &gpt_cache[i];
+	}
+
+	return NULL;
+}
+
+/**
+ * gpt_cache_drop() - Forget the cached GPT of a disk
+ *
+ * This must be called before writing a GPT
+ *
+ * @desc: Block device
+ */
+static void gpt_cache_drop(struct blk_desc *desc)
+{
+	struct gpt_cache *cache = gpt_cache_find(desc);
+
+	if (cache) {
+		free(cache->pte);
+		memset(cache, '\0', sizeof(*cache));
+	}
+}
+
+/**
+ * gpt_cache_get() - Get the GPT of a disk from the cache
+ *
+ * The header is read again to check that the GPT has not been changed. Since
+ * the header holds the CRC of the entries, any change to them shows up there.
+ *
+ * @desc: Block device
+ * @gpt_head: Returns the GPT header
+ * @pgpt_pte: Returns the partition entries, allocated, which the caller must
+ *	free
+ * Return: true if the GPT was found in the cache, false if not
+ */
+static bool gpt_cache_get(struct blk_desc *desc, gpt_header *gpt_head,
+			  gpt_entry **pgpt_pte)
+{
+	struct gpt_cache *cache = gpt_cache_find(desc);
+	gpt_entry *pte;
+
+	/* is_gpt_valid() sets up the disk signature, so let it do that */
+	if (!cache || desc->sig_type == SIG_TYPE_NONE)
+		return false;
+	if (blk_dread(desc, cache->lba, 1, gpt_head) != 1 ||
+	    memcmp(gpt_head, &cache->head, sizeof(cache->head))) {
+		gpt_cache_drop(desc);
+		return false;
+	}
+	pte = memalign(ARCH_DMA_MINALIGN, cache->size);
+	if (!pte)
+		return false;
+	memcpy(pte, cache->pte, cache->size);
+	*pgpt_pte = pte;
+
+	return true;
+}
+
+/**
+ * gpt_cache_set() - Add a checked GPT to the cache
+ *
+ * @desc: Block device
+ * @lba: Block holding @gpt_head
+ * @gpt_head: GPT header
+ * @gpt_pte: Partition entries
+ */
+static void gpt_cache_set(struct blk_desc *desc, lbaint_t lba,
+			  gpt_header *gpt_head, gpt_entry *gpt_pte)
+{
+	struct gpt_cache *cache;
+	size_t size;
+
+	if (!(gd->flags & GD_FLG_FULL_MALLOC_INIT))
+		return;
+	gpt_cache_drop(desc);
+	cache = &gpt_cache[gpt_cache_next];
+	gpt_cache_next = (gpt_cache_next + 1) % GPT_CACHE_DISKS;
+	free(cache->pte);
+	memset(cache, '\0', sizeof(*cache));
+
+	size = le32_to_cpu(gpt_head->num_partition_entries) *
+		le32_to_cpu(gpt_head->sizeof_partition_entry);
+	cache->pte = malloc(size);
+	if (!cache->pte)
+		return;
+	memcpy(cache->pte, gpt_pte, size);
+	cache->size = size;
+	cache->head = *gpt_head;
+	cache->lba = lba;
+	cache->desc = desc;
+}
+#else
+static void gpt_cache_drop(struct blk_desc *desc)
+{
+}
+
+static bool gpt_cache_get(struct blk_desc *desc, gpt_header *gpt_head,
+			  gpt_entry **pgpt_pte)
+{
+	return false;
+}
+
+static void gpt_cache_set(struct blk_desc *desc, lbaint_t lba,
+			  gpt_header *gpt_head, gpt_entry *gpt_pte)
+{
+}
+#endif
+
 static char *print_efiname(gpt_entry *pte)
 {
 	static char name[PARTNAME_SZ + 1];
@@ -371,6 +511,7 @@ int write_gpt_table(struct blk_desc *desc, gpt_header *gpt_h, gpt_entry *gpt_e)
 	u32 calc_crc32;
 
 	debug("max lba: %x\n", (u32)desc->lba);
+	gpt_cache_drop(desc);
 	/* Setup the Protective MBR */
 	if (set_protective_mbr(desc) < 0)
 		goto err;
@@ -728,6 +869,7 @@ static int write_one_gpt_table(struct blk_desc *desc, gpt_header *gpt_h,
 	lbaint_t start;
 	int ret = 0;
 
+	gpt_cache_drop(desc);
 	start = le64_to_cpu(gpt_h->my_lba);
 	if (blk_dwrite(desc, start, 1, gpt_h) != 1) {
 		ret = -1;
@@ -906,6 +1048,8 @@ int write_mbr_and_gpt_partitions(struct blk_desc *desc, void *buf)
 				   le32_to_cpu(gpt_h->sizeof_partition_entry)),
 				  desc);
 
+	gpt_cache_drop(desc);
+
 	/* write MBR */
 	lba = 0;	/* MBR is always at 0 */
 	cnt = 1;	/* MBR (1 block) */
@@ -1085,23 +1229,28 @@ static int is_gpt_valid(struct blk_desc *desc, u64 lba, gpt_header *pgpt_head,
 static int find_valid_gpt(struct blk_desc *desc, gpt_header *gpt_head,
 			  gpt_entry **pgpt_pte)
 {
+	lbaint_t lba = GPT_PRIMARY_PARTITION_TABLE_LBA;
 	int r;
 
-	r = is_gpt_valid(desc, GPT_PRIMARY_PARTITION_TABLE_LBA, gpt_head,
-			 pgpt_pte);
+	if (gpt_cache_get(desc, gpt_head, pgpt_pte))
+		return 1;
+
+	r = is_gpt_valid(desc, lba, gpt_head, pgpt_pte);
 
 	if (r != 1) {
 		if (r != 2)
 			log_debug("Invalid GPT\n");
 
-		if (is_gpt_valid(desc, desc->lba - 1, gpt_head, pgpt_pte)
-		    != 1) {
+		lba = desc->lba - 1;
+		if (is_gpt_valid(desc, lba, gpt_head, pgpt_pte) != 1) {
 			log_debug("Invalid Backup GPT\n");
 			return 0;
 		}
 		if (r != 2)
 			log_debug("        Using Backup GPT\n");
 	}
+	gpt_cache_set(desc, lba, gpt_head, *pgpt_pte);
+
 	return 1;
 }
 
@@ -52,6 +52,8 @@ static int ata_io_flush(struct ahci_uc_priv *uc_priv, u8 port);
 #define WAIT_MS_LINKUP	200
 
 #define AHCI_CAP_S64A BIT(31)
+#define AHCI_CAP_SNCQ BIT(30)
+#define AHCI_CAP_NCS(cap)	((((cap) >> 8) & 0x1f) + 1)
 
 __weak void __iomem *ahci_port_base(void __iomem *base, u32 port)
 {
@@ -569,6 +571,189 @@ static int ahci_device_data_io(struct ahci_uc_priv *uc_priv, u8 port, u8 *fis,
 	return 0;
 }
 
+/*
+ * Set up Native Command Queuing on a port, if both the controller and the
+ * drive support it. Each slot in use needs its own command table.
+ */
+static void ahci_ncq_init(struct ahci_uc_priv *uc_priv, u8 port)
+{
+	struct ahci_ioports *pp = &(uc_priv->port[port]);
+	u16 *id = uc_priv->ataid[port];
+	void *mem;
+	int depth;
+
+	if (!IS_ENABLED(CONFIG_AHCI_NCQ) || !(uc_priv->cap & AHCI_CAP_SNCQ) ||
+	    !ata_id_has_ncq(id))
+		return;
+
+	depth = min_t(int, ata_id_queue_depth(id), AHCI_CAP_NCS(uc_priv->cap));
+	if (depth < 2)
+		return;
+
+	if (!pp->ncq_tbl) {
+		mem = memalign(2048, AHCI_MAX_CMD_SLOT * AHCI_NCQ_TBL_SZ);
+		if (!mem) {
+			printf("%s: No mem for NCQ tables!\n", __func__);
+			return;
+		}
+		memset(mem, 0, AHCI_MAX_CMD_SLOT * AHCI_NCQ_TBL_SZ);
+		pp->ncq_tbl = virt_to_phys(mem);
+	}
+	pp->ncq_depth = depth;
+	debug("Port %d: NCQ depth %d\n", port, depth);
+}
+
+/*
+ * Stop and restart the command list after an NCQ error or timeout, which
+ * clears all outstanding commands. Commands are issued one at a time after
+ * this, until the port is scanned again.
+ */
+static void ahci_ncq_recover(struct ahci_ioports *pp)
+{
+	void __iomem *port_mmio = pp->port_mmio;
+
+	writel(readl(port_mmio + PORT_CMD) & ~PORT_CMD_START,
+	       port_mmio + PORT_CMD);
+	if (waiting_for_cmd_completed(port_mmio + PORT_CMD, 500,
+				      PORT_CMD_LIST_ON))
+		debug("scsi_ahci: command list did not stop\n");
+	writel(readl(port_mmio + PORT_SCR_ERR), port_mmio + PORT_SCR_ERR);
+	writel(readl(port_mmio + PORT_IRQ_STAT), port_mmio + PORT_IRQ_STAT);
+	writel_with_flush(readl(port_mmio + PORT_CMD) | PORT_CMD_START,
+			  port_mmio + PORT_CMD);
+	pp->ncq_depth = 0;
+}
+
+/* Set up a READ FPDMA QUEUED command in slot @tag */
+static int ahci_ncq_prep(struct ahci_uc_priv *uc_priv, struct ahci_ioports *pp,
+			 int tag, lbaint_t lba, u16 blocks, u8 *buf)
+{
+	ulong tbl = pp->ncq_tbl + tag * AHCI_NCQ_TBL_SZ;
+	struct ahci_sg *ahci_sg = (struct ahci_sg *)(tbl + AHCI_CMD_TBL_HDR);
+	struct ahci_cmd_hdr *cmd_slot = &pp->cmd_slot[tag];
+	phys_addr_t pa = virt_to_phys(buf);
+	u8 *fis = (u8 *)tbl;
+	u64 lba64 = lba;
+
+	if (upper_32_bits(pa) && !(uc_priv->cap & AHCI_CAP_S64A)) {
+		printf("Error: DMA address too high\n");
+		return -EINVAL;
+	}
+
+	memset(fis, 0, 20);
+	fis[0] = 0x27;		/* Host to device FIS. */
+	fis[1] = 1 << 7;	/* Command FIS. */
+	fis[2] = ATA_CMD_FPDMA_READ;
+	fis[3] = blocks & 0xff;	/* sector count goes in features */
+	fis[4] = (lba64 >> 0) & 0xff;
+	fis[5] = (lba64 >> 8) & 0xff;
+	fis[6] = (lba64 >> 16) & 0xff;
+	fis[7] = 1 << 6;	/* device reg: set LBA mode */
+	fis[8] = (lba64 >> 24) & 0xff;
+	fis[9] = (lba64 >> 32) & 0xff;
+	fis[10] = (lba64 >> 40) & 0xff;
+	fis[11] = blocks >> 8;
+	fis[12] = tag << 3;	/* tag goes in sector count */
+
+	ahci_sg->addr = cpu_to_le32(lower_32_bits(pa));
+	ahci_sg->addr_hi = cpu_to_le32(upper_32_bits(pa));
+	ahci_sg->flags_size = cpu_to_le32(blocks * ATA_SECT_SIZE - 1);
+
+	pa = virt_to_phys((void *)tbl);
+	cmd_slot->opts = cpu_to_le32(5 | (1 << 16));	/* 5-dword FIS, 1 sg */
+	cmd_slot->status = 0;
+	cmd_slot->tbl_addr = cpu_to_le32(lower_32_bits(pa));
+#ifdef CONFIG_PHYS_64BIT
+	cmd_slot->tbl_addr_hi = cpu_to_le32(upper_32_bits(pa));
+#endif
+	ahci_dcache_flush_range(tbl, AHCI_NCQ_TBL_SZ);
+	ahci_dcache_flush_range((unsigned long)pp->cmd_slot,
+				AHCI_CMD_SLOT_SZ * AHCI_MAX_CMD_SLOT);
+
+	return 0;
+}
+
+/*
+ * Read using Native Command Queuing, keeping up to ncq_depth commands of
+ * MAX_SATA_BLOCKS_READ_WRITE blocks outstanding on the drive
+ */
+static int ahci_ncq_read(struct ahci_uc_priv *uc_priv, u8 port,
+			 lbaint_t lba, u16 blocks, u8 *buf)
+{
+	struct ahci_ioports *pp = &(uc_priv->port[port]);
+	void __iomem *port_mmio = pp->port_mmio;
+	u8 *tag_buf[AHCI_MAX_CMD_SLOT];
+	u32 tag_len[AHCI_MAX_CMD_SLOT];
+	u32 active = 0, done;
+	int queued = 0;
+	ulong start;
+	int ret = 0;
+	int tag;
+
+	writel(readl(port_mmio + PORT_IRQ_STAT), port_mmio + PORT_IRQ_STAT);
+	start = get_timer(0);
+	while (blocks || active) {
+		/* keep the drive's queue full */
+		while (blocks && queued < pp->ncq_depth) {
+			u16 now_blocks = min((u16)MAX_SATA_BLOCKS_READ_WRITE,
+					     blocks);
+
+			tag = ffs(~active) - 1;
+			ret = ahci_ncq_prep(uc_priv, pp, tag, lba, now_blocks,
+					    buf);
+			if (ret) {
+				if (!active)
+					return ret;
+				blocks = 0;
+				break;
+			}
+			tag_buf[tag] = buf;
+			tag_len[tag] = now_blocks * ATA_SECT_SIZE;
+			ahci_dcache_flush_range((unsigned long)buf, tag_len[tag]);
+
+			active |= BIT(tag);
+			queued++;
+			writel(BIT(tag), port_mmio + PORT_SCR_ACT);
+			writel_with_flush(BIT(tag), port_mmio + PORT_CMD_ISSUE);
+
+			buf += tag_len[tag];
+			lba += now_blocks;
+			blocks -= now_blocks;
+		}
+
+		if (readl(port_mmio + PORT_IRQ_STAT) & (PORT_IRQ_FATAL)) {
+			printf("scsi_ahci: NCQ read error on port %d, tfdata %x\n",
+			       port, readl(port_mmio + PORT_TFDATA));
+			ahci_ncq_recover(pp);
+			return -EIO;
+		}
+
+		/* the drive clears a tag's SActive bit when it is done */
+		done = active & ~readl(port_mmio + PORT_SCR_ACT);
+		if (!done) {
+			if (get_timer(start) > WAIT_MS_DATAIO) {
+				printf("scsi_ahci: NCQ timeout on port %d\n",
+				       port);
+				ahci_ncq_recover(pp);
+				return -EIO;
+			}
+			continue;
+		}
+
+		start = get_timer(0);
+		while (done) {
+			tag = ffs(done) - 1;
+			done &= ~BIT(tag);
+			active &= ~BIT(tag);
+			queued--;
+			ahci_dcache_invalidate_range((unsigned long)tag_buf[tag],
+						     tag_len[tag]);
+		}
+	}
+
+	return ret;
+}
+
 static char *ata_id_strcpy(u16 *target, u16 *src, int len)
 {
 	int i;
@@ -636,6 +821,7 @@ static int ata_scsiop_inquiry(struct ahci_uc_priv *uc_priv,
 
 	memcpy(idbuf, tmpid, ATA_ID_WORDS * 2);
 	ata_swap_buf_le16(idbuf, ATA_ID_WORDS);
+	ahci_ncq_init(uc_priv, port);
 
 	memcpy(&pccb->pdata[8], "ATA     ", 8);
 	ata_id_strcpy((u16 *)&pccb->pdata[16], &idbuf[ATA_ID_PROD], 16);
@@ -689,6 +875,18 @@ static int ata_scsiop_read_write(struct ahci_uc_priv *uc_priv,
 	debug("scsi_ahci: %s %u blocks starting from lba 0x" LBAFU "\n",
 	      is_write ?  "write" : "read", blocks, lba);
 
+	/* Queue large reads if the drive can take more than one command */
+	if (!is_write && uc_priv->port[pccb->target].ncq_depth &&
+	    blocks > MAX_SATA_BLOCKS_READ_WRITE) {
+		if (ATA_SECT_SIZE * blocks > user_buffer_size) {
+			printf("scsi_ahci: Error: buffer too small.\n");
+			return -EIO;
+		}
+
+		return ahci_ncq_read(uc_priv, pccb->target, lba, blocks,
+				     user_buffer);
+	}
+
 	/* Preset the FIS */
 	memset(fis, 0, sizeof(fis));
 	fis[0] = 0x27;		 /* Host to device FIS. */
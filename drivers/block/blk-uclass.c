@@ -7,14 +7,18 @@
 #define LOG_CATEGORY UCLASS_BLK
 
 #include <blk.h>
+#include <bootstage.h>
 #include <dm.h>
 #include <log.h>
 #include <malloc.h>
+#include <memalign.h>
 #include <part.h>
+#include <watchdog.h>
 #include <dm/device-internal.h>
 #include <dm/lists.h>
 #include <dm/uclass-internal.h>
 #include <linux/err.h>
+#include <linux/math64.h>
 
 #define blk_get_ops(dev)	((struct blk_ops *)(dev)->driver->ops)
 
@@ -407,6 +411,18 @@ int blk_get_device(int uclass_id, int devnum, struct udevice **devp)
 	return device_probe(*devp);
 }
 
+/**
+ * struct blk_uclass_priv - uclass-private information for each block device
+ *
+ * @inflight: List of asynchronous reads submitted to the driver, which have
+ *	not yet completed (struct blk_req)
+ * @count: Number of requests in @inflight
+ */
+struct blk_uclass_priv {
+	struct list_head inflight;
+	uint count;
+};
+
 struct blk_bounce_buffer {
 	struct udevice		*dev;
 	struct bounce_buffer	state;
@@ -427,19 +443,14 @@ static int blk_buffer_aligned(struct bounce_buffer *state)
 	return 1;	/* Default, any buffer is OK */
 }
 
-long blk_read(struct udevice *dev, lbaint_t start, lbaint_t blkcnt, void *buf)
+static long blk_read_dev(struct udevice *dev, lbaint_t start, lbaint_t blkcnt,
+			 void *buf)
 {
 	struct blk_desc *desc = dev_get_uclass_plat(dev);
 	const struct blk_ops *ops = blk_get_ops(dev);
+	ulong start_us = bootstage_pipe_start();
 	ulong blks_read;
 
-	if (!ops->read)
-		return -ENOSYS;
-
-	if (blkcache_read(desc->uclass_id, desc->devnum,
-			  start, blkcnt, desc->blksz, buf))
-		return blkcnt;
-
 	if (IS_ENABLED(CONFIG_BOUNCE_BUFFER) && desc->bb) {
 		struct blk_bounce_buffer bbstate = { .dev = dev };
 		int ret;
@@ -457,7 +468,72 @@ long blk_read(struct udevice *dev, lbaint_t start, lbaint_t blkcnt, void *buf)
 	} else {
 		blks_read = ops->read(dev, start, blkcnt, buf);
 	}
+	if ((long)blks_read > 0)
+		bootstage_pipe_end(BOOTSTAGE_PIPE_BLK, start_us,
+				   blks_read * desc->blksz, 0);
+
+	return blks_read;
+}
+
+/**
+ * blk_read_ahead() - read a wider range which can be kept in the cache
+ *
+ * @dev: Device to read from
+ * @start: Start block for the requested read
+ * @blkcnt: Number of blocks requested
+ * @buf: Place to put the requested blocks
+ * Return: true if the requested blocks were read, false if the caller
+ *	should read them directly
+ */
+static bool blk_read_ahead(struct udevice *dev, lbaint_t start,
+			   lbaint_t blkcnt, void *buf)
+{
+	struct blk_desc *desc = dev_get_uclass_plat(dev);
+	lbaint_t ra_start, ra_cnt;
+	bool ok = false;
+	void *ra_buf;
+
+	if (!blkcache_readahead(desc->uclass_id, desc->devnum, start, blkcnt,
+				&ra_start, &ra_cnt))
+		return false;
+	if (desc->lba && ra_start + ra_cnt > desc->lba)
+		ra_cnt = desc->lba - ra_start;
+	if (ra_start + ra_cnt < start + blkcnt)
+		return false;
+
+	ra_buf = malloc_cache_aligned(ra_cnt * desc->blksz);
+	if (!ra_buf)
+		return false;
+	if (blk_read_dev(dev, ra_start, ra_cnt, ra_buf) == ra_cnt) {
+		blkcache_fill(desc->uclass_id, desc->devnum, ra_start, ra_cnt,
+			      desc->blksz, ra_buf);
+		memcpy(buf, ra_buf + (start - ra_start) * desc->blksz,
+		       blkcnt * desc->blksz);
+		ok = true;
+	}
+	free(ra_buf);
+
+	return ok;
+}
+
+long blk_read(struct udevice *dev, lbaint_t start, lbaint_t blkcnt, void *buf)
+{
+	struct blk_desc *desc = dev_get_uclass_plat(dev);
+	const struct blk_ops *ops = blk_get_ops(dev);
+	long blks_read;
+
+	if (!ops->read)
+		return -ENOSYS;
+
+	if (blkcache_read(desc->uclass_id, desc->devnum,
+			  start, blkcnt, desc->blksz, buf))
+		return blkcnt;
 
+	if (CONFIG_IS_ENABLED(BLOCK_CACHE) &&
+	    blk_read_ahead(dev, start, blkcnt, buf))
+		return blkcnt;
+
+	blks_read = blk_read_dev(dev, start, blkcnt, buf);
 	if (blks_read == blkcnt)
 		blkcache_fill(desc->uclass_id, desc->devnum, start, blkcnt,
 			      desc->blksz, buf);
@@ -512,6 +588,170 @@ long blk_erase(struct udevice *dev, lbaint_t start, lbaint_t blkcnt)
 	return ops->erase(dev, start, blkcnt);
 }
 
+int blk_discard(struct udevice *dev, lbaint_t start, lbaint_t blkcnt)
+{
+	struct blk_desc *desc = dev_get_uclass_plat(dev);
+	const struct blk_ops *ops = blk_get_ops(dev);
+	u32 align = max(desc->discard_align, 1U);
+	u32 rem1, rem2;
+
+	if (!ops->discard)
+		return -ENOSYS;
+	div_u64_rem(start, align, &rem1);
+	div_u64_rem(blkcnt, align, &rem2);
+	if (rem1 || rem2 || start + blkcnt > desc->lba)
+		return -EINVAL;
+
+	blkcache_invalidate(desc->uclass_id, desc->devnum);
+
+	return ops->discard(dev, start, blkcnt);
+}
+
+lbaint_t blk_write_split(struct blk_desc *desc, lbaint_t start,
+			 lbaint_t blkcnt, lbaint_t max)
+{
+	lbaint_t end = start + max;
+	u32 rem;
+
+	if (blkcnt <= max)
+		return blkcnt;
+	if (desc->write_align) {
+		div_u64_rem(end, desc->write_align, &rem);
+		if (rem < max)
+			end -= rem;
+	}
+
+	return end - start;
+}
+
+/**
+ * blk_submit() - Start an asynchronous request
+ *
+ * @dev: Device to read from or write to
+ * @req: Request to submit
+ * @write: true to write, false to read
+ * Return: 0 if submitted or completed, -EBUSY if the queue is full, other -ve
+ * on error
+ */
+static int blk_submit(struct udevice *dev, struct blk_req *req, bool write)
+{
+#if CONFIG_IS_ENABLED(BLK_ASYNC)
+	struct blk_uclass_priv *priv = dev_get_uclass_priv(dev);
+	struct blk_desc *desc = dev_get_uclass_plat(dev);
+	const struct blk_ops *ops = blk_get_ops(dev);
+	int (*submit)(struct udevice *dev, struct blk_req *req);
+	int ret;
+#endif
+
+	req->done = false;
+	req->result = 0;
+	req->write = write;
+
+#if CONFIG_IS_ENABLED(BLK_ASYNC)
+	submit = write ? ops->submit_write : ops->submit_read;
+
+	/* The bounce-buffer path needs to copy data back after the read */
+	if (submit && ops->poll && !desc->bb) {
+		if (write) {
+			blkcache_invalidate(desc->uclass_id, desc->devnum);
+		} else if (blkcache_read(desc->uclass_id, desc->devnum,
+					 req->start, req->blkcnt, desc->blksz,
+					 req->buffer)) {
+			req->result = req->blkcnt;
+			req->done = true;
+			return 0;
+		}
+		if (priv->count >= max(desc->queue_depth, 1U))
+			return -EBUSY;
+
+		list_add_tail(&req->sibling, &priv->inflight);
+		priv->count++;
+		ret = submit(dev, req);
+		if (ret) {
+			/* the driver may have completed it already */
+			if (!req->done) {
+				list_del(&req->sibling);
+				priv->count--;
+			}
+			return ret;
+		}
+
+		return 0;
+	}
+#endif
+	if (write)
+		req->result = blk_write(dev, req->start, req->blkcnt,
+					req->buffer);
+	else
+		req->result = blk_read(dev, req->start, req->blkcnt,
+				       req->buffer);
+	req->done = true;
+
+	return 0;
+}
+
+int blk_submit_read(struct udevice *dev, struct blk_req *req)
+{
+	return blk_submit(dev, req, false);
+}
+
+int blk_submit_write(struct udevice *dev, struct blk_req *req)
+{
+	return blk_submit(dev, req, true);
+}
+
+void blk_req_complete(struct udevice *dev, struct blk_req *req, long result)
+{
+#if CONFIG_IS_ENABLED(BLK_ASYNC)
+	struct blk_uclass_priv *priv = dev_get_uclass_priv(dev);
+	struct blk_desc *desc = dev_get_uclass_plat(dev);
+
+	list_del(&req->sibling);
+	priv->count--;
+	if (!req->write && result == req->blkcnt)
+		blkcache_fill(desc->uclass_id, desc->devnum, req->start,
+			      req->blkcnt, desc->blksz, req->buffer);
+#endif
+	req->result = result;
+	req->done = true;
+}
+
+int blk_poll(struct udevice *dev)
+{
+#if CONFIG_IS_ENABLED(BLK_ASYNC)
+	struct blk_uclass_priv *priv = dev_get_uclass_priv(dev);
+	const struct blk_ops *ops = blk_get_ops(dev);
+	int ret;
+
+	if (!priv->count)
+		return 0;
+	ret = ops->poll(dev);
+	if (ret)
+		return log_msg_ret("pol", ret);
+
+	return priv->count;
+#else
+	return 0;
+#endif
+}
+
+long blk_wait(struct udevice *dev, struct blk_req *req)
+{
+	int ret;
+
+	while (!req->done) {
+		ret = blk_poll(dev);
+		if (ret < 0)
+			return ret;
+		/* nothing in flight, so this request was never submitted */
+		if (!req->done && !ret)
+			return -EINVAL;
+		schedule();
+	}
+
+	return req->result;
+}
+
 ulong blk_dread(struct blk_desc *desc, lbaint_t start, lbaint_t blkcnt,
 		void *buffer)
 {
@@ -529,6 +769,11 @@ ulong blk_derase(struct blk_desc *desc, lbaint_t start, lbaint_t blkcnt)
 	return blk_erase(desc->bdev, start, blkcnt);
 }
 
+int blk_ddiscard(struct blk_desc *desc, lbaint_t start, lbaint_t blkcnt)
+{
+	return blk_discard(desc->bdev, start, blkcnt);
+}
+
 int blk_find_from_parent(struct udevice *parent, struct udevice **devp)
 {
 	struct udevice *dev;
@@ -835,6 +1080,17 @@ static int part_create_block_devices(struct udevice *blk_dev)
 	return 0;
 }
 
+static int blk_pre_probe(struct udevice *dev)
+{
+	if (CONFIG_IS_ENABLED(BLK_ASYNC)) {
+		struct blk_uclass_priv *priv = dev_get_uclass_priv(dev);
+
+		INIT_LIST_HEAD(&priv->inflight);
+	}
+
+	return 0;
+}
+
 static int blk_post_probe(struct udevice *dev)
 {
 	if (CONFIG_IS_ENABLED(PARTITIONS) && blk_enabled()) {
@@ -853,6 +1109,10 @@ static int blk_post_probe(struct udevice *dev)
 UCLASS_DRIVER(blk) = {
 	.id		= UCLASS_BLK,
 	.name		= "blk",
+	.pre_probe	= blk_pre_probe,
 	.post_probe	= blk_post_probe,
 	.per_device_plat_auto	= sizeof(struct blk_desc),
+#if CONFIG_IS_ENABLED(BLK_ASYNC)
+	.per_device_auto	= sizeof(struct blk_uclass_priv),
+#endif
 };
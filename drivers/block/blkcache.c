@@ -5,6 +5,7 @@
  *
  */
 #include <blk.h>
+#include <div64.h>
 #include <log.h>
 #include <malloc.h>
 #include <part.h>
@@ -12,42 +13,150 @@
 #include <linux/ctype.h>
 #include <linux/list.h>
 
-struct block_cache_node {
-	struct list_head lh;
+/*
+ * The cache is made up of lines, each holding max_blocks_per_entry blocks
+ * starting at a multiple of that number. Lines are grouped into sets of
+ * CONFIG_BLOCK_CACHE_WAYS lines; a hash of the device and line address
+ * selects the set, so a lookup only needs to check one set. Within a set
+ * the least recently used line is replaced.
+ */
+
+/**
+ * struct block_cache_line - a cached group of blocks
+ *
+ * @iftype: uclass ID of the device
+ * @devnum: device number
+ * @start: first block held, a multiple of the line size
+ * @blksz: block size of the device
+ * @age: value of the cache clock when last used, for LRU replacement
+ * @valid: true if the line holds data
+ * @size: number of bytes allocated at @data
+ * @data: the cached blocks
+ */
+struct block_cache_line {
 	int iftype;
 	int devnum;
 	lbaint_t start;
-	lbaint_t blkcnt;
 	unsigned long blksz;
-	char *cache;
+	uint age;
+	bool valid;
+	size_t size;
+	char *data;
 };
 
-static LIST_HEAD(block_cache);
+/**
+ * struct block_cache_dev - per-device information
+ *
+ * @lh: node in the list of devices
+ * @stats: statistics for this device
+ * @next: block following the last read, to detect sequential access
+ * @seq: true if the current read follows on from the previous one
+ */
+struct block_cache_dev {
+	struct list_head lh;
+	struct block_cache_dev_stats stats;
+	lbaint_t next;
+	bool seq;
+};
+
+static struct block_cache_line *lines;
+static LIST_HEAD(block_cache_devs);
+static uint clock;
 
 static struct block_cache_stats _stats = {
-	.max_blocks_per_entry = 8,
-	.max_entries = 32
+	.max_blocks_per_entry = CONFIG_BLOCK_CACHE_LINE_BLOCKS,
+	/* a whole number of sets, so that num_sets() is never 0 */
+	.max_entries = DIV_ROUND_UP(CONFIG_BLOCK_CACHE_LINES,
+				    CONFIG_BLOCK_CACHE_WAYS) *
+		       CONFIG_BLOCK_CACHE_WAYS,
+	.ways = CONFIG_BLOCK_CACHE_WAYS,
+	.readahead = CONFIG_BLOCK_CACHE_READAHEAD,
 };
 
-static struct block_cache_node *cache_find(int iftype, int devnum,
-					   lbaint_t start, lbaint_t blkcnt,
+static uint num_sets(void)
+{
+	return _stats.max_entries / _stats.ways;
+}
+
+/* Reads larger than this are not cached, to avoid flushing out metadata */
+static lbaint_t max_fill(void)
+{
+	return max((lbaint_t)_stats.max_entries * _stats.max_blocks_per_entry /
+		   4, (lbaint_t)_stats.max_blocks_per_entry);
+}
+
+static lbaint_t line_start(lbaint_t blk)
+{
+	u64 line = blk;
+
+	return blk - do_div(line, _stats.max_blocks_per_entry);
+}
+
+static struct block_cache_line *cache_set(int iftype, int devnum,
+					  lbaint_t start)
+{
+	u64 line = start;
+	ulong hash;
+
+	do_div(line, _stats.max_blocks_per_entry);
+	hash = (ulong)line * 0x9e3779b1;
+	hash ^= devnum * 0x85ebca6b ^ iftype;
+	hash ^= hash >> 16;
+
+	return &lines[(hash % num_sets()) * _stats.ways];
+}
+
+static struct block_cache_dev *cache_dev(int iftype, int devnum, bool create)
+{
+	struct block_cache_dev *dev;
+
+	list_for_each_entry(dev, &block_cache_devs, lh) {
+		if (dev->stats.iftype == iftype && dev->stats.devnum == devnum)
+			return dev;
+	}
+	if (!create)
+		return NULL;
+
+	dev = calloc(1, sizeof(*dev));
+	if (!dev)
+		return NULL;
+	dev->stats.iftype = iftype;
+	dev->stats.devnum = devnum;
+	list_add_tail(&dev->lh, &block_cache_devs);
+
+	return dev;
+}
+
+static struct block_cache_line *cache_find(int iftype, int devnum,
+					   lbaint_t start,
 					   unsigned long blksz)
 {
-	struct block_cache_node *node;
-
-	list_for_each_entry(node, &block_cache, lh)
-		if ((node->iftype == iftype) &&
-		    (node->devnum == devnum) &&
-		    (node->blksz == blksz) &&
-		    (node->start <= start) &&
-		    (node->start + node->blkcnt >= start + blkcnt)) {
-			if (block_cache.next != &node->lh) {
-				/* maintain MRU ordering */
-				list_del(&node->lh);
-				list_add(&node->lh, &block_cache);
-			}
-			return node;
+	struct block_cache_line *set, *line;
+	int i;
+
+	set = cache_set(iftype, devnum, start);
+	for (i = 0, line = set; i < _stats.ways; i++, line++) {
+		if (line->valid && line->start == start &&
+		    line->devnum == devnum && line->iftype == iftype &&
+		    line->blksz == blksz) {
+			line->age = ++clock;
+			return line;
 		}
+	}
+
+	return NULL;
+}
+
+static int cache_alloc(void)
+{
+	if (lines)
+		return 0;
+	if (!_stats.max_entries || !_stats.max_blocks_per_entry)
+		return -ENOSPC;
+	lines = calloc(_stats.max_entries, sizeof(*lines));
+	if (!lines)
+		return -ENOMEM;
+
 	return 0;
 }
 
@@ -55,100 +164,206 @@ int blkcache_read(int iftype, int devnum,
 		  lbaint_t start, lbaint_t blkcnt,
 		  unsigned long blksz, void *buffer)
 {
-	struct block_cache_node *node = cache_find(iftype, devnum, start,
-						   blkcnt, blksz);
-	if (node) {
-		const char *src = node->cache + (start - node->start) * blksz;
-		memcpy(buffer, src, blksz * blkcnt);
-		debug("hit: start " LBAF ", count " LBAFU "\n",
-		      start, blkcnt);
-		++_stats.hits;
-		return 1;
+	struct block_cache_dev *dev = cache_dev(iftype, devnum, true);
+	struct block_cache_line *line;
+	lbaint_t blk, end = start + blkcnt;
+	lbaint_t count;
+
+	if (dev) {
+		dev->seq = dev->next && dev->next == start;
+		dev->next = end;
 	}
+	if (!lines || blkcnt > max_fill())
+		goto miss;
+
+	/* Check every line is present before copying anything */
+	for (blk = line_start(start); blk < end;
+	     blk += _stats.max_blocks_per_entry) {
+		if (!cache_find(iftype, devnum, blk, blksz))
+			goto miss;
+	}
+
+	for (blk = start; blk < end; blk += count) {
+		line = cache_find(iftype, devnum, line_start(blk), blksz);
+		count = min(line->start + _stats.max_blocks_per_entry,
+			    end) - blk;
+		memcpy(buffer, line->data + (blk - line->start) * blksz,
+		       count * blksz);
+		buffer += count * blksz;
+	}
+	debug("hit: start " LBAF ", count " LBAFU "\n",
+	      start, blkcnt);
+	++_stats.hits;
+	if (dev)
+		++dev->stats.hits;
 
+	return 1;
+
+miss:
 	debug("miss: start " LBAF ", count " LBAFU "\n",
 	      start, blkcnt);
 	++_stats.misses;
+	if (dev)
+		++dev->stats.misses;
+
 	return 0;
 }
 
+bool blkcache_readahead(int iftype, int devnum, lbaint_t start,
+			lbaint_t blkcnt, lbaint_t *startp, lbaint_t *blkcntp)
+{
+	struct block_cache_dev *dev = cache_dev(iftype, devnum, false);
+	lbaint_t first, end;
+
+	if (!_stats.max_entries || !_stats.max_blocks_per_entry ||
+	    blkcnt > max_fill())
+		return false;
+
+	first = line_start(start);
+	end = line_start(start + blkcnt + _stats.max_blocks_per_entry - 1);
+
+	/* Sequential access suggests the following lines will be wanted */
+	if (dev && dev->seq && _stats.readahead) {
+		end += (lbaint_t)_stats.readahead * _stats.max_blocks_per_entry;
+		if (end - first > max_fill())
+			end = first + line_start(max_fill());
+		++dev->stats.readaheads;
+	}
+
+	if (first == start && end == start + blkcnt)
+		return false;
+	*startp = first;
+	*blkcntp = end - first;
+
+	return true;
+}
+
 void blkcache_fill(int iftype, int devnum,
 		   lbaint_t start, lbaint_t blkcnt,
 		   unsigned long blksz, void const *buffer)
 {
-	lbaint_t bytes;
-	struct block_cache_node *node;
+	struct block_cache_line *set, *line, *victim;
+	lbaint_t blk, end = start + blkcnt;
+	size_t bytes;
+	int i;
 
 	/* don't cache big stuff */
-	if (blkcnt > _stats.max_blocks_per_entry)
+	if (blkcnt > max_fill())
 		return;
 
-	if (_stats.max_entries == 0)
+	if (cache_alloc())
 		return;
 
-	bytes = blksz * blkcnt;
-	if (_stats.max_entries <= _stats.entries) {
-		/* pop LRU */
-		node = (struct block_cache_node *)block_cache.prev;
-		list_del(&node->lh);
-		_stats.entries--;
-		debug("drop: start " LBAF ", count " LBAFU "\n",
-		      node->start, node->blkcnt);
-		if (node->blkcnt * node->blksz < bytes) {
-			free(node->cache);
-			node->cache = 0;
-		}
-	} else {
-		node = malloc(sizeof(*node));
-		if (!node)
-			return;
-		node->cache = 0;
-	}
+	bytes = blksz * _stats.max_blocks_per_entry;
 
-	if (!node->cache) {
-		node->cache = malloc(bytes);
-		if (!node->cache) {
-			free(node);
-			return;
+	/* Only whole lines are cached */
+	for (blk = line_start(start + _stats.max_blocks_per_entry - 1);
+	     blk + _stats.max_blocks_per_entry <= end;
+	     blk += _stats.max_blocks_per_entry) {
+		line = cache_find(iftype, devnum, blk, blksz);
+		if (!line) {
+			set = cache_set(iftype, devnum, blk);
+			for (i = 0, victim = set; i < _stats.ways; i++) {
+				if (!set[i].valid) {
+					victim = &set[i];
+					break;
+				}
+				if (set[i].age < victim->age)
+					victim = &set[i];
+			}
+			line = victim;
+			if (line->valid) {
+				debug("drop: start " LBAF "\n", line->start);
+				_stats.entries--;
+				line->valid = false;
+			}
+			if (line->size < bytes) {
+				free(line->data);
+				line->data = malloc(bytes);
+				line->size = line->data ? bytes : 0;
+				if (!line->data)
+					return;
+			}
+			line->iftype = iftype;
+			line->devnum = devnum;
+			line->start = blk;
+			line->blksz = blksz;
+			line->age = ++clock;
+			line->valid = true;
+			_stats.entries++;
 		}
+
+		debug("fill: start " LBAF "\n", blk);
+		memcpy(line->data, buffer + (blk - start) * blksz, bytes);
 	}
+}
 
-	debug("fill: start " LBAF ", count " LBAFU "\n",
-	      start, blkcnt);
+/**
+ * cache_release() - drop all cached data and free the memory it uses
+ *
+ * @free_devs: true to free per-device statistics too
+ */
+static void cache_release(bool free_devs)
+{
+	struct block_cache_dev *dev, *next;
+	int i;
+
+	for (i = 0; lines && i < _stats.max_entries; i++)
+		free(lines[i].data);
+	free(lines);
+	lines = NULL;
+	_stats.entries = 0;
 
-	node->iftype = iftype;
-	node->devnum = devnum;
-	node->start = start;
-	node->blkcnt = blkcnt;
-	node->blksz = blksz;
-	memcpy(node->cache, buffer, bytes);
-	list_add(&node->lh, &block_cache);
-	_stats.entries++;
+	if (free_devs) {
+		list_for_each_entry_safe(dev, next, &block_cache_devs, lh) {
+			list_del(&dev->lh);
+			free(dev);
+		}
+	}
 }
 
 void blkcache_invalidate(int iftype, int devnum)
 {
-	struct list_head *entry, *n;
-	struct block_cache_node *node;
+	struct block_cache_dev *dev, *next;
+	struct block_cache_line *line;
+	int i;
 
-	list_for_each_safe(entry, n, &block_cache) {
-		node = (struct block_cache_node *)entry;
-		if (iftype == -1 ||
-		    (node->iftype == iftype && node->devnum == devnum)) {
-			list_del(entry);
-			free(node->cache);
-			free(node);
+	for (i = 0, line = lines; lines && i < _stats.max_entries;
+	     i++, line++) {
+		if (line->valid &&
+		    (iftype == -1 ||
+		     (line->iftype == iftype && line->devnum == devnum))) {
+			line->valid = false;
 			--_stats.entries;
+			free(line->data);
+			line->data = NULL;
+			line->size = 0;
+		}
+	}
+
+	list_for_each_entry_safe(dev, next, &block_cache_devs, lh) {
+		if (iftype == -1 ||
+		    (dev->stats.iftype == iftype &&
+		     dev->stats.devnum == devnum)) {
+			list_del(&dev->lh);
+			free(dev);
 		}
 	}
+
+	/* nothing is cached, so give the memory back */
+	if (!_stats.entries)
+		cache_release(false);
 }
 
 void blkcache_configure(unsigned blocks, unsigned entries)
 {
+	/* keep a whole number of sets */
+	entries = DIV_ROUND_UP(entries, _stats.ways) * _stats.ways;
+
 	/* invalidate cache if there is a change */
 	if ((blocks != _stats.max_blocks_per_entry) ||
 	    (entries != _stats.max_entries))
-		blkcache_invalidate(-1, 0);
+		cache_release(false);
 
 	_stats.max_blocks_per_entry = blocks;
 	_stats.max_entries = entries;
@@ -157,6 +372,22 @@ void blkcache_configure(unsigned blocks, unsigned entries)
 	_stats.misses = 0;
 }
 
+void blkcache_set_readahead(unsigned lines)
+{
+	_stats.readahead = lines;
+}
+
+static void blkcache_reset_dev_stats(void)
+{
+	struct block_cache_dev *dev;
+
+	list_for_each_entry(dev, &block_cache_devs, lh) {
+		dev->stats.hits = 0;
+		dev->stats.misses = 0;
+		dev->stats.readaheads = 0;
+	}
+}
+
 void blkcache_stats(struct block_cache_stats *stats)
 {
 	memcpy(stats, &_stats, sizeof(*stats));
@@ -164,7 +395,23 @@ void blkcache_stats(struct block_cache_stats *stats)
 	_stats.misses = 0;
 }
 
+int blkcache_dev_stats(int seq, struct block_cache_dev_stats *stats)
+{
+	struct block_cache_dev *dev;
+
+	list_for_each_entry(dev, &block_cache_devs, lh) {
+		if (!seq--) {
+			memcpy(stats, &dev->stats, sizeof(*stats));
+			if (list_is_last(&dev->lh, &block_cache_devs))
+				blkcache_reset_dev_stats();
+			return 0;
+		}
+	}
+
+	return -ENOENT;
+}
+
 void blkcache_free(void)
 {
-	blkcache_invalidate(-1, 0);
+	cache_release(true);
 }
@@ -63,6 +63,31 @@ struct blkmap_slice {
 	 * @read.bms: This slice
 	 */
 	void (*destroy)(struct blkmap *bm, struct blkmap_slice *bms);
+
+	/**
+	 * @merge: - Absorb the following slice, if it continues this one
+	 *
+	 * Called only when @merge.next starts at the block just after
+	 * the end of this slice and is of the same type.
+	 *
+	 * @merge.bm: Blkmap to which this slice belongs
+	 * @merge.bms: This slice
+	 * @merge.next: Slice following this one
+	 * Returns: true if this slice was extended to cover @merge.next
+	 */
+	bool (*merge)(struct blkmap *bm, struct blkmap_slice *bms,
+		      struct blkmap_slice *next);
+
+	/**
+	 * @get_mem: - Get a pointer to the memory backing a block
+	 *
+	 * @get_mem.bm: Blkmap to which this slice belongs
+	 * @get_mem.bms: This slice
+	 * @get_mem.blknr: Block number within the slice
+	 * Returns: Pointer to the data of block @get_mem.blknr
+	 */
+	void *(*get_mem)(struct blkmap *bm, struct blkmap_slice *bms,
+			 lbaint_t blknr);
 };
 
 static bool blkmap_slice_contains(struct blkmap_slice *bms, lbaint_t blknr)
@@ -89,6 +114,30 @@ static bool blkmap_slice_available(struct blkmap *bm, struct blkmap_slice *new)
 	return true;
 }
 
+static bool blkmap_slice_merge(struct blkmap *bm, struct blkmap_slice *bms,
+			       struct blkmap_slice *next)
+{
+	if (!bms->merge || bms->merge != next->merge ||
+	    bms->blknr + bms->blkcnt != next->blknr)
+		return false;
+
+	if (!bms->merge(bm, bms, next))
+		return false;
+
+	list_del(&next->node);
+	if (next->destroy)
+		next->destroy(bm, next);
+	free(next);
+
+	return true;
+}
+
+/*
+ * Adds @new to the blkmap, which takes ownership of it. Where the slice
+ * continues one of its neighbours, the two are merged so that a read
+ * spanning both is a single request to the backing store; @new is freed
+ * in that case.
+ */
 static int blkmap_slice_add(struct blkmap *bm, struct blkmap_slice *new)
 {
 	struct blk_desc *bd = dev_get_uclass_plat(bm->blk);
@@ -108,6 +157,15 @@ static int blkmap_slice_add(struct blkmap *bm, struct blkmap_slice *new)
 
 	list_add_tail(&new->node, insert);
 
+	if (insert != &bm->slices) {
+		bms = list_entry(insert, struct blkmap_slice, node);
+		blkmap_slice_merge(bm, new, bms);
+	}
+	if (new->node.prev != &bm->slices) {
+		bms = list_entry(new->node.prev, struct blkmap_slice, node);
+		blkmap_slice_merge(bm, bms, new);
+	}
+
 	/* Disk might have grown, update the size */
 	bms = list_last_entry(&bm->slices, struct blkmap_slice, node);
 	bd->lba = bms->blknr + bms->blkcnt;
@@ -145,6 +203,20 @@ static ulong blkmap_linear_write(struct blkmap *bm, struct blkmap_slice *bms,
 	return blk_write(bml->blk, bml->blknr + blknr, blkcnt, buffer);
 }
 
+static bool blkmap_linear_merge(struct blkmap *bm, struct blkmap_slice *bms,
+				struct blkmap_slice *next)
+{
+	struct blkmap_linear *bml = container_of(bms, struct blkmap_linear, slice);
+	struct blkmap_linear *nbml = container_of(next, struct blkmap_linear,
+						  slice);
+
+	if (nbml->blk != bml->blk || nbml->blknr != bml->blknr + bms->blkcnt)
+		return false;
+
+	bms->blkcnt += next->blkcnt;
+	return true;
+}
+
 int blkmap_map_linear(struct udevice *dev, lbaint_t blknr, lbaint_t blkcnt,
 		      struct udevice *lblk, lbaint_t lblknr)
 {
@@ -172,6 +244,7 @@ int blkmap_map_linear(struct udevice *dev, lbaint_t blknr, lbaint_t blkcnt,
 
 			.read = blkmap_linear_read,
 			.write = blkmap_linear_write,
+			.merge = blkmap_linear_merge,
 		},
 
 		.blk = lblk,
@@ -225,6 +298,32 @@ static ulong blkmap_mem_write(struct blkmap *bm, struct blkmap_slice *bms,
 	return blkcnt;
 }
 
+static bool blkmap_mem_merge(struct blkmap *bm, struct blkmap_slice *bms,
+			     struct blkmap_slice *next)
+{
+	struct blkmap_mem *bmm = container_of(bms, struct blkmap_mem, slice);
+	struct blkmap_mem *nbmm = container_of(next, struct blkmap_mem, slice);
+	struct blk_desc *bd = dev_get_uclass_plat(bm->blk);
+
+	/* Each remapping must be torn down separately, so keep them apart */
+	if (bmm->remapped || nbmm->remapped)
+		return false;
+	if (nbmm->addr != bmm->addr + (bms->blkcnt << bd->log2blksz))
+		return false;
+
+	bms->blkcnt += next->blkcnt;
+	return true;
+}
+
+static void *blkmap_mem_get_mem(struct blkmap *bm, struct blkmap_slice *bms,
+				lbaint_t blknr)
+{
+	struct blkmap_mem *bmm = container_of(bms, struct blkmap_mem, slice);
+	struct blk_desc *bd = dev_get_uclass_plat(bm->blk);
+
+	return bmm->addr + (blknr << bd->log2blksz);
+}
+
 static void blkmap_mem_destroy(struct blkmap *bm, struct blkmap_slice *bms)
 {
 	struct blkmap_mem *bmm = container_of(bms, struct blkmap_mem, slice);
@@ -252,6 +351,8 @@ int __blkmap_map_mem(struct udevice *dev, lbaint_t blknr, lbaint_t blkcnt,
 			.read = blkmap_mem_read,
 			.write = blkmap_mem_write,
 			.destroy = blkmap_mem_destroy,
+			.merge = blkmap_mem_merge,
+			.get_mem = blkmap_mem_get_mem,
 		},
 
 		.addr = addr,
@@ -297,7 +398,7 @@ static ulong blkmap_blk_read_slice(struct blkmap *bm, struct blkmap_slice *bms,
 	lbaint_t nr, cnt;
 
 	nr = blknr - bms->blknr;
-	cnt = (blkcnt < bms->blkcnt) ? blkcnt : bms->blkcnt;
+	cnt = min(blkcnt, bms->blkcnt - nr);
 	return bms->read(bm, bms, nr, cnt, buffer);
 }
 
@@ -310,6 +411,8 @@ static ulong blkmap_blk_read(struct udevice *dev, lbaint_t blknr,
 	lbaint_t cnt, total = 0;
 
 	list_for_each_entry(bms, &bm->slices, node) {
+		if (!blkcnt)
+			break;
 		if (!blkmap_slice_contains(bms, blknr))
 			continue;
 
@@ -330,7 +433,7 @@ static ulong blkmap_blk_write_slice(struct blkmap *bm, struct blkmap_slice *bms,
 	lbaint_t nr, cnt;
 
 	nr = blknr - bms->blknr;
-	cnt = (blkcnt < bms->blkcnt) ? blkcnt : bms->blkcnt;
+	cnt = min(blkcnt, bms->blkcnt - nr);
 	return bms->write(bm, bms, nr, cnt, buffer);
 }
 
@@ -343,6 +446,8 @@ static ulong blkmap_blk_write(struct udevice *dev, lbaint_t blknr,
 	lbaint_t cnt, total = 0;
 
 	list_for_each_entry(bms, &bm->slices, node) {
+		if (!blkcnt)
+			break;
 		if (!blkmap_slice_contains(bms, blknr))
 			continue;
 
@@ -367,6 +472,30 @@ U_BOOT_DRIVER(blkmap_blk) = {
 	.ops		= &blkmap_blk_ops,
 };
 
+int blkmap_get_mem(struct udevice *blk, lbaint_t blknr, lbaint_t blkcnt,
+		   void **bufp)
+{
+	struct blkmap_slice *bms;
+	struct blkmap *bm;
+
+	if (blk->driver != DM_DRIVER_GET(blkmap_blk))
+		return -ENOSYS;
+
+	bm = dev_get_plat(blk->parent);
+	list_for_each_entry(bms, &bm->slices, node) {
+		if (!blkmap_slice_contains(bms, blknr))
+			continue;
+
+		if (!bms->get_mem || blkcnt > bms->blknr + bms->blkcnt - blknr)
+			return -ENOENT;
+
+		*bufp = bms->get_mem(bm, bms, blknr - bms->blknr);
+		return 0;
+	}
+
+	return -ENOENT;
+}
+
 static int blkmap_dev_bind(struct udevice *dev)
 {
 	struct blkmap *bm = dev_get_plat(dev);
@@ -101,9 +101,28 @@ int host_attach_file(struct udevice *dev, const char *filename)
 	return ops->attach_file(dev, filename);
 }
 
+int host_set_mode(struct udevice *dev, enum host_mode mode)
+{
+	struct host_sb_plat *plat = dev_get_plat(dev);
+
+	if (plat->fd)
+		return -EBUSY;
+	plat->mode = mode;
+
+	return 0;
+}
+
 int host_create_attach_file(const char *label, const char *filename,
 			    bool removable, unsigned long blksz,
 			    struct udevice **devp)
+{
+	return host_create_attach_file_mode(label, filename, removable, blksz,
+					    HOST_MODE_RW, devp);
+}
+
+int host_create_attach_file_mode(const char *label, const char *filename,
+				 bool removable, unsigned long blksz,
+				 enum host_mode mode, struct udevice **devp)
 {
 	struct udevice *dev;
 	int ret;
@@ -112,6 +131,7 @@ int host_create_attach_file(const char *label, const char *filename,
 	if (ret)
 		return log_msg_ret("cre", ret);
 
+	host_set_mode(dev, mode);
 	ret = host_attach_file(dev, filename);
 	if (ret) {
 		device_unbind(dev);
@@ -23,7 +23,7 @@ static int host_sb_attach_file(struct udevice *dev, const char *filename)
 	struct host_sb_plat *plat = dev_get_plat(dev);
 	struct blk_desc *desc;
 	struct udevice *blk;
-	int ret, fd;
+	int ret, fd, flags;
 	off_t size;
 	char *fname;
 
@@ -38,11 +38,15 @@ static int host_sb_attach_file(struct udevice *dev, const char *filename)
 	if (ret)
 		return ret;
 
-	fd = os_open(filename, OS_O_RDWR);
+	flags = OS_O_RDWR;
+	if (plat->mode == HOST_MODE_DIRECT)
+		flags |= OS_O_DIRECT;
+	fd = os_open(filename, flags);
 	if (fd == -1) {
 		printf("Failed to access host backing file '%s', trying read-only\n",
 		       filename);
-		fd = os_open(filename, OS_O_RDONLY);
+		flags = (flags & ~OS_O_MASK) | OS_O_RDONLY;
+		fd = os_open(filename, flags);
 		if (fd == -1) {
 			printf("- still failed\n");
 			return log_msg_ret("open", -ENOENT);
@@ -65,6 +69,13 @@ static int host_sb_attach_file(struct udevice *dev, const char *filename)
 	}
 	desc->lba = size / desc->blksz;
 
+	if (plat->mode == HOST_MODE_MMAP && size) {
+		ret = os_map_fd(fd, flags, size, &plat->buf);
+		if (ret)
+			goto err_fname;
+		plat->size = size;
+	}
+
 	/* write this in last, when nothing can go wrong */
 	plat = dev_get_plat(dev);
 	plat->fd = fd;
@@ -73,6 +84,7 @@ static int host_sb_attach_file(struct udevice *dev, const char *filename)
 	return 0;
 
 err_fname:
+	free(fname);
 	os_close(fd);
 
 	return ret;
@@ -95,6 +107,10 @@ static int host_sb_detach_file(struct udevice *dev)
 	if (ret)
 		return log_msg_ret("unb", ret);
 
+	if (plat->buf) {
+		os_unmap(plat->buf, plat->size);
+		plat->buf = NULL;
+	}
 	os_close(plat->fd);
 	plat->fd = 0;
 	free(plat->filename);
@@ -14,9 +14,45 @@
 #include <dm/device_compat.h>
 #include <dm/device-internal.h>
 #include <linux/errno.h>
+#include <linux/sizes.h>
 
 DECLARE_GLOBAL_DATA_PTR;
 
+/* Buffer alignment needed for reads and writes with HOST_MODE_DIRECT */
+#define HOST_DIRECT_ALIGN	SZ_4K
+
+/* Accesses a file mapped with HOST_MODE_MMAP, stopping at the end of it */
+static ulong host_block_mem(struct blk_desc *desc, struct host_sb_plat *plat,
+			    lbaint_t start, lbaint_t blkcnt, void *buffer,
+			    bool write)
+{
+	void *ptr = plat->buf + start * desc->blksz;
+
+	if (start >= desc->lba)
+		return 0;
+	blkcnt = min(blkcnt, desc->lba - start);
+	if (write)
+		memcpy(ptr, buffer, blkcnt * desc->blksz);
+	else
+		memcpy(buffer, ptr, blkcnt * desc->blksz);
+
+	return blkcnt;
+}
+
+/*
+ * O_DIRECT requires an aligned buffer, so use a bounce buffer if the
+ * caller's is not. Returns NULL on error, else the buffer to use.
+ */
+static void *host_block_bounce(struct host_sb_plat *plat, void *buffer,
+			       ulong size)
+{
+	if (plat->mode != HOST_MODE_DIRECT ||
+	    IS_ALIGNED((ulong)buffer, HOST_DIRECT_ALIGN))
+		return buffer;
+
+	return memalign(HOST_DIRECT_ALIGN, size);
+}
+
 static unsigned long host_block_read(struct udevice *dev,
 				     unsigned long start, lbaint_t blkcnt,
 				     void *buffer)
@@ -24,12 +60,26 @@ static unsigned long host_block_read(struct udevice *dev,
 	struct blk_desc *desc = dev_get_uclass_plat(dev);
 	struct udevice *host_dev = dev_get_parent(dev);
 	struct host_sb_plat *plat = dev_get_plat(host_dev);
+	ulong size = blkcnt * desc->blksz;
+	ssize_t len;
+	void *buf;
+
+	if (plat->buf)
+		return host_block_mem(desc, plat, start, blkcnt, buffer, false);
 
 	if (os_lseek(plat->fd, start * desc->blksz, OS_SEEK_SET) == -1) {
 		printf("ERROR: Invalid block %lx\n", start);
 		return -1;
 	}
-	ssize_t len = os_read(plat->fd, buffer, blkcnt * desc->blksz);
+	buf = host_block_bounce(plat, buffer, size);
+	if (!buf)
+		return -ENOMEM;
+	len = os_read(plat->fd, buf, size);
+	if (buf != buffer) {
+		if (len > 0)
+			memcpy(buffer, buf, len);
+		free(buf);
+	}
 	if (len >= 0)
 		return len / desc->blksz;
 
@@ -43,25 +93,115 @@ static unsigned long host_block_write(struct udevice *dev,
 	struct blk_desc *desc = dev_get_uclass_plat(dev);
 	struct udevice *host_dev = dev_get_parent(dev);
 	struct host_sb_plat *plat = dev_get_plat(host_dev);
+	ulong size = blkcnt * desc->blksz;
+	ssize_t len;
+	void *buf;
+
+	if (plat->buf)
+		return host_block_mem(desc, plat, start, blkcnt, (void *)buffer,
+				      true);
 
 	if (os_lseek(plat->fd, start * desc->blksz, OS_SEEK_SET) == -1) {
 		printf("ERROR: Invalid block %lx\n", start);
 		return -1;
 	}
-	ssize_t len = os_write(plat->fd, buffer, blkcnt * desc->blksz);
+	buf = host_block_bounce(plat, (void *)buffer, size);
+	if (!buf)
+		return -ENOMEM;
+	if (buf != buffer)
+		memcpy(buf, buffer, size);
+	len = os_write(plat->fd, buf, size);
+	if (buf != buffer)
+		free(buf);
 	if (len >= 0)
 		return len / desc->blksz;
 
 	return -EIO;
 }
 
+#if CONFIG_IS_ENABLED(BLK_ASYNC)
+/*
+ * Requests are held in slots until the next poll, which completes them all,
+ * so that the queueing in the uclass can be exercised
+ */
+#define HOST_BLK_QUEUE_DEPTH	4
+
+/**
+ * struct host_blk_priv - private data for a host block device
+ *
+ * @slot: Requests which have been submitted but not yet completed
+ */
+struct host_blk_priv {
+	struct blk_req *slot[HOST_BLK_QUEUE_DEPTH];
+};
+
+static int host_block_submit(struct udevice *dev, struct blk_req *req)
+{
+	struct host_blk_priv *priv = dev_get_priv(dev);
+	int i;
+
+	for (i = 0; i < HOST_BLK_QUEUE_DEPTH; i++) {
+		if (!priv->slot[i]) {
+			priv->slot[i] = req;
+			return 0;
+		}
+	}
+
+	return -EBUSY;
+}
+
+static int host_block_poll(struct udevice *dev)
+{
+	struct host_blk_priv *priv = dev_get_priv(dev);
+	struct blk_req *req;
+	int i;
+
+	for (i = 0; i < HOST_BLK_QUEUE_DEPTH; i++) {
+		req = priv->slot[i];
+		if (!req)
+			continue;
+		priv->slot[i] = NULL;
+		if (req->write)
+			blk_req_complete(dev, req,
+					 host_block_write(dev, req->start,
+							  req->blkcnt,
+							  req->buffer));
+		else
+			blk_req_complete(dev, req,
+					 host_block_read(dev, req->start,
+							 req->blkcnt,
+							 req->buffer));
+	}
+
+	return 0;
+}
+
+static int host_block_probe(struct udevice *dev)
+{
+	struct blk_desc *desc = dev_get_uclass_plat(dev);
+
+	desc->queue_depth = HOST_BLK_QUEUE_DEPTH;
+
+	return 0;
+}
+#endif
+
 static const struct blk_ops sandbox_host_blk_ops = {
 	.read	= host_block_read,
 	.write	= host_block_write,
+#if CONFIG_IS_ENABLED(BLK_ASYNC)
+	.submit_read	= host_block_submit,
+	.submit_write	= host_block_submit,
+	.poll		= host_block_poll,
+#endif
 };
 
 U_BOOT_DRIVER(sandbox_host_blk) = {
 	.name		= "sandbox_host_blk",
 	.id		= UCLASS_BLK,
 	.ops		= &sandbox_host_blk_ops,
+#if CONFIG_IS_ENABLED(BLK_ASYNC)
+	.probe		= host_block_probe,
+	.priv_auto	= sizeof(struct host_blk_priv),
+#endif
 };
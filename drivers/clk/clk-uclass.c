@@ -285,36 +285,74 @@ static int clk_set_default_parents(struct udevice *dev,
 	return 0;
 }
 
+/**
+ * struct clk_default_rate - A rate to set from assigned-clock-rates
+ *
+ * @clk: Clock, as read from assigned-clocks
+ * @c: Private clock struct to set with CCF, or NULL to set @clk
+ * @rate: Rate to set in Hz
+ * @depth: Number of ancestors @c has in the clock tree
+ */
+struct clk_default_rate {
+	struct clk clk;
+	struct clk *c;
+	u32 rate;
+	int depth;
+};
+
+static int clk_get_depth(struct clk *clk)
+{
+	struct udevice *dev;
+	int depth = 0;
+
+	if (!CONFIG_IS_ENABLED(CLK_CCF))
+		return 0;
+
+	for (dev = dev_get_parent(clk->dev);
+	     dev && device_get_uclass_id(dev) == UCLASS_CLK;
+	     dev = dev_get_parent(dev))
+		depth++;
+
+	return depth;
+}
+
 static int clk_set_default_rates(struct udevice *dev,
 				 enum clk_defaults_stage stage)
 {
-	struct clk clk, *c;
-	int index;
+	struct clk_default_rate *rates, *r, tmp;
+	struct clk *c;
+	u32 *vals = NULL;
+	int index, count;
 	int num_rates;
 	int size;
 	int ret = 0;
-	u32 *rates = NULL;
+	int i;
 
 	size = dev_read_size(dev, "assigned-clock-rates");
 	if (size < 0)
 		return 0;
 
 	num_rates = size / sizeof(u32);
-	rates = calloc(num_rates, sizeof(u32));
-	if (!rates)
-		return -ENOMEM;
+	vals = calloc(num_rates, sizeof(u32));
+	rates = calloc(num_rates, sizeof(*rates));
+	if (!vals || !rates) {
+		ret = -ENOMEM;
+		goto fail;
+	}
 
-	ret = dev_read_u32_array(dev, "assigned-clock-rates", rates, num_rates);
+	ret = dev_read_u32_array(dev, "assigned-clock-rates", vals, num_rates);
 	if (ret)
 		goto fail;
 
-	for (index = 0; index < num_rates; index++) {
+	/* Look up all the clocks first */
+	for (index = 0, count = 0; index < num_rates; index++) {
 		/* If 0 is passed, this is a no-op */
-		if (!rates[index])
+		if (!vals[index])
 			continue;
 
+		r = &rates[count];
 		ret = clk_get_by_indexed_prop(dev, "assigned-clocks",
-					      index, &clk);
+					      index, &r->clk);
 		/*
 		 * If the clock provider is not ready yet, let it handle
 		 * the re-programming later.
@@ -334,36 +372,59 @@ static int clk_set_default_rates(struct udevice *dev,
 				continue;
 			}
 
-			return ret;
+			goto fail;
 		}
 
 		/* This is clk provider device trying to program itself
 		 * It cannot be done right now but need to wait after the
 		 * device is probed
 		 */
-		if (stage == CLK_DEFAULTS_PRE && clk.dev == dev)
+		if (stage == CLK_DEFAULTS_PRE && r->clk.dev == dev)
 			continue;
 
-		if (stage != CLK_DEFAULTS_PRE && clk.dev != dev)
+		if (stage != CLK_DEFAULTS_PRE && r->clk.dev != dev)
 			/* do not setup twice the parent clocks */
 			continue;
 
-		c = clk_set_default_get_by_id(&clk);
-		if (IS_ERR(c))
-			return PTR_ERR(c);
+		c = clk_set_default_get_by_id(&r->clk);
+		if (IS_ERR(c)) {
+			ret = PTR_ERR(c);
+			goto fail;
+		}
+		/* Without CCF this is @clk itself, which moves when sorted */
+		r->c = c == &r->clk ? NULL : c;
+		r->rate = vals[index];
+		r->depth = clk_get_depth(c);
+
+		/*
+		 * Keep ancestors ahead of their descendants, so that setting a
+		 * parent's rate does not upset a child's rate set before it.
+		 * Otherwise the order in the devicetree is kept.
+		 */
+		for (i = count; i > 0 && rates[i - 1].depth > r->depth; i--) {
+			tmp = rates[i];
+			rates[i] = rates[i - 1];
+			rates[i - 1] = tmp;
+		}
+		count++;
+	}
 
-		ret = clk_set_rate(c, rates[index]);
+	/* Then set the rates in one pass */
+	for (i = 0; i < count; i++) {
+		r = &rates[i];
+		ret = clk_set_rate(r->c ?: &r->clk, r->rate);
 
 		if (ret < 0) {
 			dev_warn(dev,
-				 "failed to set rate on clock index %d (%ld) (error = %d)\n",
-				 index, clk.id, ret);
+				 "failed to set rate on clock %ld (error = %d)\n",
+				 r->clk.id, ret);
 			break;
 		}
 	}
 
 fail:
 	free(rates);
+	free(vals);
 	return ret;
 }
 
@@ -461,6 +522,7 @@ int clk_request(struct udevice *dev, struct clk *clk)
 ulong clk_get_rate(struct clk *clk)
 {
 	const struct clk_ops *ops;
+	ulong rate;
 
 	debug("%s(clk=%p)\n", __func__, clk);
 	if (!clk_valid(clk))
@@ -470,7 +532,26 @@ ulong clk_get_rate(struct clk *clk)
 	if (!ops->get_rate)
 		return -ENOSYS;
 
-	return ops->get_rate(clk);
+	if (!CONFIG_IS_ENABLED(CLK_CCF))
+		return ops->get_rate(clk);
+
+	/*
+	 * Working out the rate means walking up to the root of the tree, so
+	 * keep it in the private clock struct until this clock or one of its
+	 * ancestors is changed. Providers look up the private struct with
+	 * ccf_clk_get_rate(), which comes back here.
+	 */
+	if (dev_get_clk_ptr(clk->dev) != clk ||
+	    clk->flags & CLK_GET_RATE_NOCACHE)
+		return ops->get_rate(clk);
+	if (!clk->rate) {
+		rate = ops->get_rate(clk);
+		if (IS_ERR_VALUE(rate))
+			return rate;
+		clk->rate = rate;
+	}
+
+	return clk->rate;
 }
 
 struct clk *clk_get_parent(struct clk *clk)
@@ -578,7 +659,12 @@ ulong clk_set_rate(struct clk *clk, ulong rate)
 	/* Clean up cached rates for us and all child clocks */
 	clk_clean_rate_cache(clkp);
 
-	return ops->set_rate(clk, rate);
+	rate = ops->set_rate(clk, rate);
+
+	/* The driver may have read back the old rates while setting it */
+	clk_clean_rate_cache(clkp);
+
+	return rate;
 }
 
 int clk_set_parent(struct clk *clk, struct clk *parent)
@@ -598,9 +684,13 @@ int clk_set_parent(struct clk *clk, struct clk *parent)
 	if (ret)
 		return ret;
 
-	if (CONFIG_IS_ENABLED(CLK_CCF))
+	if (CONFIG_IS_ENABLED(CLK_CCF)) {
 		ret = device_reparent(clk->dev, parent->dev);
 
+		/* Our rate and those of all child clocks may have changed */
+		clk_clean_rate_cache(clk);
+	}
+
 	return ret;
 }
 
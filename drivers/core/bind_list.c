@@ -0,0 +1,186 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Binding of devices in U-Boot proper from a list generated at build time
+ *
+ * dtoc works out which driver lists_bind_fdt() would pick for each node of
+ * the control devicetree. If the devicetree in use at runtime is the same
+ * one, the initial scan binds each node straight from this list, so nodes
+ * without a compatible string are never visited and no driver search is
+ * needed. The tree itself is still there, as a flat or live tree, so it can
+ * be read by drivers, fixed up and passed on as usual.
+ */
+
+#define LOG_CATEGORY UCLASS_ROOT
+
+#include <errno.h>
+#include <log.h>
+#include <malloc.h>
+#include <asm/global_data.h>
+#include <dm/bind_list.h>
+#include <dm/device.h>
+#include <dm/device-internal.h>
+#include <dm/lists.h>
+#include <dm/ofnode.h>
+#include <dm/util.h>
+#include <linux/libfdt.h>
+#include <u-boot/crc.h>
+
+DECLARE_GLOBAL_DATA_PTR;
+
+/* Only set up once relocated, while the initial devices are bound */
+static ofnode *bind_nodes;
+
+/* Last node looked up, since scans mostly go through the tree in order */
+static int bind_last;
+
+static int bind_list_add(ofnode node, int *countp)
+{
+	ofnode subnode;
+	int ret;
+
+	if (*countp == dm_bind_list.node_count)
+		return -ESTALE;
+	bind_nodes[(*countp)++] = node;
+	ofnode_for_each_subnode(subnode, node) {
+		ret = bind_list_add(subnode, countp);
+		if (ret)
+			return ret;
+	}
+
+	return 0;
+}
+
+int dm_bind_list_start(void)
+{
+	const struct dm_bind_list *list = &dm_bind_list;
+	const void *blob = gd->fdt_blob;
+	int count = 0;
+	int ret;
+
+	if (!(gd->flags & GD_FLG_RELOC))
+		return -EAGAIN;
+	if (!blob || fdt_check_header(blob) ||
+	    fdt_totalsize(blob) != list->fdt_size ||
+	    crc32(0, blob, list->fdt_size) != list->fdt_crc32)
+		return -ENOENT;
+
+	bind_nodes = malloc(list->node_count * sizeof(ofnode));
+	if (!bind_nodes)
+		return -ENOMEM;
+	ret = bind_list_add(ofnode_root(), &count);
+	if (!ret && count != list->node_count)
+		ret = -ESTALE;
+	if (ret) {
+		dm_bind_list_end();
+		return ret;
+	}
+	bind_last = 0;
+	log_debug("Binding %d nodes from the list\n", list->count);
+
+	return 0;
+}
+
+void dm_bind_list_end(void)
+{
+	free(bind_nodes);
+	bind_nodes = NULL;
+}
+
+int dm_bind_list_find(ofnode node)
+{
+	int count = dm_bind_list.node_count;
+	int i, idx;
+
+	if (!bind_nodes)
+		return -ENOENT;
+	for (i = 0, idx = bind_last; i < count; i++, idx++) {
+		if (idx == count)
+			idx = 0;
+		if (ofnode_equal(bind_nodes[idx], node)) {
+			bind_last = idx;
+			return idx;
+		}
+	}
+
+	return -ENOENT;
+}
+
+/**
+ * bind_list_bind() - Bind a device for a node in the list
+ *
+ * If the driver chosen at build time is not built in, does not have the
+ * compatible string or refuses to bind, this falls back to lists_bind_fdt()
+ *
+ * @parent: Parent device
+ * @entry: Entry for the node
+ * @node: Node to bind
+ * @pre_reloc_only: true to bind only pre-relocation devices
+ * Return: 0 if OK, -ve on error
+ */
+static int bind_list_bind(struct udevice *parent,
+			  const struct dm_bind_entry *entry, ofnode node,
+			  bool pre_reloc_only)
+{
+	const struct udevice_id *id = NULL;
+	struct driver *drv = entry->drv;
+	int ret;
+
+	if (drv && drv->of_match) {
+		for (id = drv->of_match; id->compatible; id++) {
+			if (!strcmp(id->compatible, entry->compat))
+				break;
+		}
+	}
+	if (!id || !id->compatible)
+		return lists_bind_fdt(parent, node, NULL, NULL, pre_reloc_only);
+
+	if (pre_reloc_only && !ofnode_pre_reloc(node) &&
+	    !(drv->flags & DM_FLAG_PRE_RELOC))
+		return 0;
+	ret = device_bind_with_driver_data(parent, drv, ofnode_get_name(node),
+					   id->data, node, NULL);
+	if (ret == -ENODEV)
+		return lists_bind_fdt(parent, node, NULL, NULL, pre_reloc_only);
+	if (ret) {
+		dm_warn("Error binding driver '%s': %d\n", drv->name, ret);
+		return log_msg_ret("bind", ret);
+	}
+
+	return 0;
+}
+
+int dm_bind_list_scan(struct udevice *parent, int idx, bool pre_reloc_only)
+{
+	const struct dm_bind_list *list = &dm_bind_list;
+	const struct dm_bind_entry *entry, *end;
+	int lo = 0, hi = list->count;
+	int ret = 0, err;
+
+	/* Find the first entry for a subnode of @idx */
+	while (lo < hi) {
+		int mid = (lo + hi) / 2;
+
+		if (list->entries[mid].parent < idx)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+
+	end = list->entries + list->count;
+	for (entry = list->entries + lo; entry != end && entry->parent == idx;
+	     entry++) {
+		ofnode node = bind_nodes[entry->node];
+
+		if (!ofnode_is_enabled(node)) {
+			pr_debug("   - ignoring disabled device\n");
+			continue;
+		}
+		err = bind_list_bind(parent, entry, node, pre_reloc_only);
+		if (err && !ret) {
+			ret = err;
+			debug("%s: ret=%d\n", ofnode_get_name(node), ret);
+		}
+	}
+
+	return ret;
+}
@@ -10,6 +10,8 @@
 
 #include <errno.h>
 #include <log.h>
+#include <malloc.h>
+#include <asm/global_data.h>
 #include <dm/device.h>
 #include <dm/device-internal.h>
 #include <dm/lists.h>
@@ -18,6 +20,10 @@
 #include <dm/util.h>
 #include <fdtdec.h>
 #include <linux/compiler.h>
+#include <linux/err.h>
+#include <linux/log2.h>
+
+DECLARE_GLOBAL_DATA_PTR;
 
 struct driver *lists_driver_lookup_name(const char *name)
 {
@@ -180,6 +186,156 @@ static int driver_check_compatible(const struct udevice_id *of_match,
 	return -ENOENT;
 }
 
+#if CONFIG_IS_ENABLED(DM_COMPAT_INDEX)
+/**
+ * struct dm_compat_entry - A driver compatible string in the hash table
+ *
+ * @hash:	Hash of the compatible string
+ * @drv:	Index of the driver in the driver linker list
+ * @id:		Index of the string in the driver's of_match table
+ * @next:	Next entry in the hash bucket plus one, 0 if none
+ */
+struct dm_compat_entry {
+	u32 hash;
+	u16 drv;
+	u16 id;
+	u16 next;
+};
+
+/**
+ * struct dm_compat_index - Hash table of driver compatible strings
+ *
+ * Entries in each bucket are kept in driver linker-list order, so a lookup
+ * finds the same driver as a search through the list would.
+ *
+ * @mask:	Number of buckets minus one
+ * @heads:	First entry of each bucket plus one, 0 if empty
+ * @entries:	All entries
+ */
+struct dm_compat_index {
+	uint mask;
+	u16 *heads;
+	struct dm_compat_entry *entries;
+};
+
+/* FNV-1a, which is quick and spreads similar strings well */
+static u32 compat_hash(const char *str)
+{
+	u32 hash = 2166136261U;
+
+	while (*str) {
+		hash ^= (u8)*str++;
+		hash *= 16777619U;
+	}
+
+	return hash;
+}
+
+static struct dm_compat_index *compat_index_build(void)
+{
+	struct driver *driver = ll_entry_start(struct driver, driver);
+	const int n_ents = ll_entry_count(struct driver, driver);
+	const struct udevice_id *of_match;
+	struct dm_compat_entry *entry;
+	struct dm_compat_index *idx;
+	uint count = 0, buckets;
+	int i, j;
+
+	for (i = 0; i < n_ents; i++) {
+		for (of_match = driver[i].of_match; of_match &&
+		     of_match->compatible; of_match++)
+			count++;
+	}
+	if (!count || count >= U16_MAX || n_ents > U16_MAX)
+		return ERR_PTR(-E2BIG);
+	buckets = roundup_pow_of_two(count);
+
+	idx = malloc(sizeof(*idx) + buckets * sizeof(u16) +
+		     count * sizeof(struct dm_compat_entry));
+	if (!idx)
+		return ERR_PTR(-ENOMEM);
+	idx->mask = buckets - 1;
+	idx->entries = (struct dm_compat_entry *)(idx + 1);
+	idx->heads = (u16 *)(idx->entries + count);
+	memset(idx->heads, '\0', buckets * sizeof(u16));
+
+	/* Add in reverse, so each bucket ends up in linker-list order */
+	entry = idx->entries;
+	for (i = n_ents - 1; i >= 0; i--) {
+		of_match = driver[i].of_match;
+		if (!of_match)
+			continue;
+		for (j = 0; of_match[j].compatible; j++)
+			;
+		while (j--) {
+			u16 *head;
+
+			entry->hash = compat_hash(of_match[j].compatible);
+			entry->drv = i;
+			entry->id = j;
+			head = &idx->heads[entry->hash & idx->mask];
+			entry->next = *head;
+			*head = entry - idx->entries + 1;
+			entry++;
+		}
+	}
+	log_debug("Indexed %u compatible strings\n", count);
+
+	return idx;
+}
+
+/**
+ * compat_index_lookup() - Find the first driver for a compatible string
+ *
+ * @compat:	Compatible string to look up
+ * @of_idp:	Returns the match that was found
+ * @drvp:	Returns the driver
+ * Return: 0 if found, -ENOENT if no driver has @compat, other -ve error if
+ *	the index is not available
+ */
+static int compat_index_lookup(const char *compat,
+			       const struct udevice_id **of_idp,
+			       struct driver **drvp)
+{
+	struct driver *driver = ll_entry_start(struct driver, driver);
+	struct dm_compat_index *idx = gd_dm_compat_index();
+	struct dm_compat_entry *entry;
+	uint pos;
+	u32 hash;
+
+	if (!idx) {
+		idx = compat_index_build();
+		gd_set_dm_compat_index(idx);
+	}
+	if (IS_ERR(idx))
+		return PTR_ERR(idx);
+
+	hash = compat_hash(compat);
+	for (pos = idx->heads[hash & idx->mask]; pos; pos = entry->next) {
+		const struct udevice_id *of_match;
+
+		entry = &idx->entries[pos - 1];
+		if (entry->hash != hash)
+			continue;
+		of_match = &driver[entry->drv].of_match[entry->id];
+		if (!strcmp(of_match->compatible, compat)) {
+			*of_idp = of_match;
+			*drvp = &driver[entry->drv];
+			return 0;
+		}
+	}
+
+	return -ENOENT;
+}
+#else
+static int compat_index_lookup(const char *compat,
+			       const struct udevice_id **of_idp,
+			       struct driver **drvp)
+{
+	return -ENOSYS;
+}
+#endif
+
 int lists_bind_fdt(struct udevice *parent, ofnode node, struct udevice **devp,
 		   struct driver *drv, bool pre_reloc_only)
 {
@@ -222,6 +378,13 @@ int lists_bind_fdt(struct udevice *parent, ofnode node, struct udevice **devp,
 			  compat);
 
 		id = NULL;
+		if (CONFIG_IS_ENABLED(DM_COMPAT_INDEX) && !drv) {
+			ret = compat_index_lookup(compat, &id, &entry);
+			if (ret == -ENOENT)
+				continue;
+			if (!ret)
+				goto found;
+		}
 		for (entry = driver; entry != driver + n_ents; entry++) {
 			if (drv) {
 				if (drv != entry)
@@ -236,7 +399,7 @@ int lists_bind_fdt(struct udevice *parent, ofnode node, struct udevice **devp,
 		}
 		if (entry == driver + n_ents)
 			continue;
-
+found:
 		if (pre_reloc_only) {
 			if (!ofnode_pre_reloc(node) &&
 			    !(entry->flags & DM_FLAG_PRE_RELOC)) {
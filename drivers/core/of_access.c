@@ -122,15 +122,152 @@ int of_simple_size_cells(const struct device_node *np)
 	return 2;
 }
 
+#if CONFIG_IS_ENABLED(OF_LIVE_ATOMS)
+/**
+ * struct of_atoms - Interned property names of the control devicetree
+ *
+ * Every property name in the live tree which points into the strings block of
+ * the blob is replaced with the first such pointer (in tree order) for the
+ * same string. Lookups then find the atom for a name once and compare
+ * pointers along the property list. Names outside the strings block, such as
+ * those of properties added at runtime, are still compared as strings.
+ *
+ * @blob: Blob the atoms belong to
+ * @base: Start of the strings block of @blob
+ * @size: Size of the strings block
+ * @mask: Number of slots in @tab, minus one
+ * @count: Number of slots used
+ * @tab: Open-addressed hash table of atoms
+ */
+struct of_atoms {
+	const void *blob;
+	const char *base;
+	uint size;
+	uint mask;
+	uint count;
+	const char *tab[];
+};
+
+static struct of_atoms *of_atoms;
+
+static bool of_atom_owns(const struct of_atoms *atoms, const char *name)
+{
+	return name >= atoms->base && name < atoms->base + atoms->size;
+}
+
+/**
+ * of_atom_find() - Find the atom for a property name
+ *
+ * @atoms: Atom table
+ * @name: Property name to look up
+ * @add: true to add @name as a new atom if not found
+ * Return: atom, or NULL if not found and not added
+ */
+static const char *of_atom_find(struct of_atoms *atoms, const char *name,
+				bool add)
+{
+	const char *atom;
+	uint hash = 2166136261u;
+	const char *p;
+
+	for (p = name; *p; p++)
+		hash = (hash ^ (u8)*p) * 16777619u;
+
+	for (hash &= atoms->mask; (atom = atoms->tab[hash]);
+	     hash = (hash + 1) & atoms->mask) {
+		if (atom == name || !strcmp(atom, name))
+			return atom;
+	}
+	if (!add)
+		return NULL;
+	atoms->tab[hash] = name;
+	atoms->count++;
+
+	return name;
+}
+
+void of_atoms_intern(const void *blob, struct device_node *root)
+{
+	struct of_atoms *atoms = of_atoms;
+	struct device_node *np;
+	struct property *pp;
+
+	if (!atoms || blob != atoms->blob)
+		return;
+
+	for (np = root; np; np = of_find_all_nodes(np)) {
+		for (pp = np->properties; pp; pp = pp->next) {
+			if (!of_atom_owns(atoms, pp->name))
+				continue;
+			/* keep the table at most half full */
+			if (atoms->count * 2 > atoms->mask) {
+				log_debug("Atom table full, disabling\n");
+				of_atoms = NULL;
+				free(atoms);
+				return;
+			}
+			pp->name = (char *)of_atom_find(atoms, pp->name, true);
+		}
+	}
+}
+
+int of_atoms_init(const void *blob, struct device_node *root)
+{
+	struct device_node *np;
+	struct property *pp;
+	uint props = 0, slots;
+
+	free(of_atoms);
+	of_atoms = NULL;
+
+	for (np = root; np; np = of_find_all_nodes(np)) {
+		for (pp = np->properties; pp; pp = pp->next)
+			props++;
+	}
+	for (slots = 16; slots < props * 2 + 2; slots <<= 1)
+		;
+
+	of_atoms = calloc(1, sizeof(*of_atoms) + slots * sizeof(char *));
+	if (!of_atoms)
+		return log_msg_ret("atm", -ENOMEM);
+	of_atoms->blob = blob;
+	of_atoms->base = blob + fdt_off_dt_strings(blob);
+	of_atoms->size = fdt_size_dt_strings(blob);
+	of_atoms->mask = slots - 1;
+	of_atoms_intern(blob, root);
+
+	return 0;
+}
+#endif
+
 struct property *of_find_property(const struct device_node *np,
 				  const char *name, int *lenp)
 {
 	struct property *pp;
+#if CONFIG_IS_ENABLED(OF_LIVE_ATOMS)
+	struct of_atoms *atoms = of_atoms;
+	const char *atom = NULL;
+#endif
 
 	if (!np)
 		return NULL;
 
+#if CONFIG_IS_ENABLED(OF_LIVE_ATOMS)
+	if (atoms)
+		atom = of_atom_find(atoms, name, false);
+#endif
+
 	for (pp = np->properties; pp; pp = pp->next) {
+#if CONFIG_IS_ENABLED(OF_LIVE_ATOMS)
+		/* interned names match only if they are the same atom */
+		if (atoms && of_atom_owns(atoms, pp->name)) {
+			if (pp->name != atom)
+				continue;
+			if (lenp)
+				*lenp = pp->length;
+			break;
+		}
+#endif
 		if (strcmp(pp->name, name) == 0) {
 			if (lenp)
 				*lenp = pp->length;
@@ -444,6 +581,68 @@ struct device_node *of_find_node_by_prop_value(struct device_node *from,
 	return np;
 }
 
+#if CONFIG_IS_ENABLED(OF_PHANDLE_CACHE)
+/* Number of cache entries, as a power of two; phandles are mostly small */
+#define OF_PHANDLE_CACHE_SIZE	256
+
+struct of_phandle_cache {
+	const struct device_node *root;
+	struct device_node *np;
+};
+
+static struct of_phandle_cache *of_phandle_cache;
+
+void of_phandle_cache_inval(void)
+{
+	if (of_phandle_cache)
+		memset(of_phandle_cache, '\0',
+		       OF_PHANDLE_CACHE_SIZE * sizeof(*of_phandle_cache));
+}
+
+struct device_node *of_find_node_by_phandle(struct device_node *root,
+					    phandle handle)
+{
+	struct of_phandle_cache *cache, *entry;
+	struct device_node *np, *found = NULL;
+	const struct device_node *start = root ? root : gd_of_root();
+
+	if (!handle)
+		return NULL;
+
+	cache = of_phandle_cache;
+	if (!cache && (gd->flags & GD_FLG_FULL_MALLOC_INIT)) {
+		cache = calloc(OF_PHANDLE_CACHE_SIZE, sizeof(*cache));
+		of_phandle_cache = cache;
+	}
+	if (cache) {
+		entry = &cache[handle & (OF_PHANDLE_CACHE_SIZE - 1)];
+		if (entry->np && entry->root == start &&
+		    entry->np->phandle == handle)
+			return of_node_get(entry->np);
+	}
+
+	/* Search, recording every phandle on the way */
+	for_each_of_allnodes_from(root, np) {
+		if (!np->phandle || (np->phandle == handle && found))
+			continue;
+		if (cache) {
+			entry = &cache[np->phandle & (OF_PHANDLE_CACHE_SIZE - 1)];
+			entry->root = start;
+			entry->np = np;
+		}
+		if (np->phandle == handle)
+			found = np;
+	}
+	if (found && cache) {
+		/* Another phandle may have taken the entry since */
+		entry = &cache[handle & (OF_PHANDLE_CACHE_SIZE - 1)];
+		entry->root = start;
+		entry->np = found;
+	}
+
+	return of_node_get(found);
+}
+#else
 struct device_node *of_find_node_by_phandle(struct device_node *root,
 					    phandle handle)
 {
@@ -459,6 +658,7 @@ struct device_node *of_find_node_by_phandle(struct device_node *root,
 
 	return np;
 }
+#endif
 
 /**
  * of_find_property_value_of_size() - find property of given size
@@ -1091,6 +1291,7 @@ int of_remove_node(struct device_node *to_remove)
 		prev->sibling = np->sibling;
 	else
 		parent->child = np->sibling;
+	of_phandle_cache_inval();
 
 	/*
 	 * don't free it, since if this is an unflattened tree, all the memory
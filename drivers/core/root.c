@@ -16,6 +16,7 @@
 #include <asm/global_data.h>
 #include <linux/libfdt.h>
 #include <dm/acpi.h>
+#include <dm/bind_list.h>
 #include <dm/device.h>
 #include <dm/device-internal.h>
 #include <dm/lists.h>
@@ -195,6 +196,15 @@ static int dm_scan_fdt_node(struct udevice *parent, ofnode parent_node,
 	if (!ofnode_valid(parent_node))
 		return 0;
 
+	if (CONFIG_IS_ENABLED(DM_BIND_LIST)) {
+		int idx = dm_bind_list_find(parent_node);
+
+		if (idx >= 0) {
+			ret = dm_bind_list_scan(parent, idx, pre_reloc_only);
+			goto done;
+		}
+	}
+
 	for (node = ofnode_first_subnode(parent_node);
 	     ofnode_valid(node);
 	     node = ofnode_next_subnode(node)) {
@@ -211,6 +221,7 @@ static int dm_scan_fdt_node(struct udevice *parent, ofnode parent_node,
 		}
 	}
 
+done:
 	if (ret)
 		dm_warn("Some drivers failed to bind\n");
 
@@ -292,6 +303,15 @@ static int dm_probe_devices(struct udevice *dev, bool pre_reloc_only)
 		goto probe_children;
 
 	if (dev_get_flags(dev) & DM_FLAG_PROBE_AFTER_BIND) {
+		/*
+		 * The board may know that the device is not needed to boot,
+		 * in which case leave it to be probed on first use, if any
+		 */
+		if (ofnode_valid(node) &&
+		    ofnode_read_bool(node, "u-boot,lazy-probe")) {
+			log_debug("Not probing %s until used\n", dev->name);
+			goto probe_children;
+		}
 		ret = device_probe(dev);
 		if (ret)
 			return ret;
@@ -325,7 +345,14 @@ static int dm_scan(bool pre_reloc_only)
 	}
 
 	if (CONFIG_IS_ENABLED(OF_REAL)) {
+		if (CONFIG_IS_ENABLED(DM_BIND_LIST)) {
+			ret = dm_bind_list_start();
+			if (ret)
+				log_debug("Bind list not used: err=%d\n", ret);
+		}
 		ret = dm_extended_scan(pre_reloc_only);
+		if (CONFIG_IS_ENABLED(DM_BIND_LIST))
+			dm_bind_list_end();
 		if (ret) {
 			debug("dm_extended_scan() failed: %d\n", ret);
 			return ret;
@@ -341,8 +368,10 @@ static int dm_scan(bool pre_reloc_only)
 
 int dm_init_and_scan(bool pre_reloc_only)
 {
+	const char *owner;
 	int ret;
 
+	owner = malloc_simple_owner("dm");
 	ret = dm_init(CONFIG_IS_ENABLED(OF_LIVE));
 	if (ret) {
 		debug("dm_init() failed: %d\n", ret);
@@ -355,6 +384,7 @@ int dm_init_and_scan(bool pre_reloc_only)
 			return ret;
 		}
 	}
+	malloc_simple_owner(owner);
 	if (CONFIG_IS_ENABLED(DM_EVENT)) {
 		ret = event_notify_null(gd->flags & GD_FLG_RELOC ?
 					EVT_DM_POST_INIT_R :
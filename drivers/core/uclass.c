@@ -22,6 +22,115 @@
 
 DECLARE_GLOBAL_DATA_PTR;
 
+enum uclass_cache_t {
+	UCLASS_CACHE_SEQ,
+	UCLASS_CACHE_OFNODE,
+	UCLASS_CACHE_NAME,
+	UCLASS_CACHE_PHANDLE,
+};
+
+#if CONFIG_IS_ENABLED(DM_UCLASS_CACHE)
+/* Number of entries in each uclass lookup cache, as a power of two */
+#define UCLASS_CACHE_BITS	5
+#define UCLASS_CACHE_SIZE	(1 << UCLASS_CACHE_BITS)
+
+/**
+ * struct uclass_cache - Results of recent device lookups in a uclass
+ *
+ * This is a direct-mapped cache. Only devices found by searching the uclass
+ * are added, so a hit gives the same device as a search would, provided the
+ * device still has the key; this is checked on each hit since drivers may
+ * change a device's sequence number or node after binding.
+ *
+ * @key:	Hash of the lookup type and value for each entry
+ * @dev:	Device found for each entry, NULL if none
+ */
+struct uclass_cache {
+	uint key[UCLASS_CACHE_SIZE];
+	struct udevice *dev[UCLASS_CACHE_SIZE];
+};
+
+static uint uclass_cache_key(enum uclass_cache_t type, ulong val)
+{
+	/* Fibonacci hashing, with the top bits selecting the entry */
+	return ((uint)val ^ upper_32_bits(val) ^ type) * 0x9e3779b9U;
+}
+
+static uint uclass_cache_name_key(const char *name, int len)
+{
+	uint hash = 2166136261U;
+
+	while (len--) {
+		hash ^= (u8)*name++;
+		hash *= 16777619U;
+	}
+
+	return uclass_cache_key(UCLASS_CACHE_NAME, hash);
+}
+
+static struct udevice *uclass_cache_get(struct uclass *uc, uint key)
+{
+	uint pos = key >> (32 - UCLASS_CACHE_BITS);
+
+	if (!uc->cache || uc->cache->key[pos] != key)
+		return NULL;
+
+	return uc->cache->dev[pos];
+}
+
+static void uclass_cache_add(struct uclass *uc, uint key, struct udevice *dev)
+{
+	uint pos = key >> (32 - UCLASS_CACHE_BITS);
+
+	/* Keep the early malloc() area for devices */
+	if (!uc->cache) {
+		if (!(gd->flags & GD_FLG_FULL_MALLOC_INIT))
+			return;
+		uc->cache = calloc(1, sizeof(*uc->cache));
+		if (!uc->cache)
+			return;
+	}
+	uc->cache->key[pos] = key;
+	uc->cache->dev[pos] = dev;
+}
+
+static void uclass_cache_drop(struct uclass *uc, struct udevice *dev)
+{
+	int i;
+
+	if (!uc->cache)
+		return;
+	for (i = 0; i < UCLASS_CACHE_SIZE; i++) {
+		if (uc->cache->dev[i] == dev)
+			uc->cache->dev[i] = NULL;
+	}
+}
+#else
+static inline uint uclass_cache_key(enum uclass_cache_t type, ulong val)
+{
+	return 0;
+}
+
+static inline uint uclass_cache_name_key(const char *name, int len)
+{
+	return 0;
+}
+
+static inline struct udevice *uclass_cache_get(struct uclass *uc, uint key)
+{
+	return NULL;
+}
+
+static inline void uclass_cache_add(struct uclass *uc, uint key,
+				    struct udevice *dev)
+{
+}
+
+static inline void uclass_cache_drop(struct uclass *uc, struct udevice *dev)
+{
+}
+#endif
+
 struct uclass *uclass_find(enum uclass_id key)
 {
 	struct uclass *uc;
@@ -136,6 +245,9 @@ int uclass_destroy(struct uclass *uc)
 	list_del(&uc->sibling_node);
 	if (uc_drv->priv_auto)
 		free(uclass_get_priv(uc));
+#if CONFIG_IS_ENABLED(DM_UCLASS_CACHE)
+	free(uc->cache);
+#endif
 	free(uc);
 
 	return 0;
@@ -278,6 +390,7 @@ int uclass_find_device_by_namelen(enum uclass_id id, const char *name, int len,
 {
 	struct uclass *uc;
 	struct udevice *dev;
+	uint key;
 	int ret;
 
 	*devp = NULL;
@@ -287,9 +400,18 @@ int uclass_find_device_by_namelen(enum uclass_id id, const char *name, int len,
 	if (ret)
 		return ret;
 
+	key = uclass_cache_name_key(name, len);
+	dev = uclass_cache_get(uc, key);
+	if (dev && !strncmp(dev->name, name, len) &&
+	    strlen(dev->name) == len) {
+		*devp = dev;
+		return 0;
+	}
+
 	uclass_foreach_dev(dev, uc) {
 		if (!strncmp(dev->name, name, len) &&
 		    strlen(dev->name) == len) {
+			uclass_cache_add(uc, key, dev);
 			*devp = dev;
 			return 0;
 		}
@@ -331,6 +453,7 @@ int uclass_find_device_by_seq(enum uclass_id id, int seq, struct udevice **devp)
 {
 	struct uclass *uc;
 	struct udevice *dev;
+	uint key;
 	int ret;
 
 	*devp = NULL;
@@ -341,9 +464,18 @@ int uclass_find_device_by_seq(enum uclass_id id, int seq, struct udevice **devp)
 	if (ret)
 		return ret;
 
+	key = uclass_cache_key(UCLASS_CACHE_SEQ, seq);
+	dev = uclass_cache_get(uc, key);
+	if (dev && dev->seq_ == seq) {
+		*devp = dev;
+		log_debug("   - found '%s' in cache\n", dev->name);
+		return 0;
+	}
+
 	uclass_foreach_dev(dev, uc) {
 		log_debug("   - %d '%s'\n", dev->seq_, dev->name);
 		if (dev->seq_ == seq) {
+			uclass_cache_add(uc, key, dev);
 			*devp = dev;
 			log_debug("   - found\n");
 			return 0;
@@ -383,6 +515,7 @@ int uclass_find_device_by_ofnode(enum uclass_id id, ofnode node,
 {
 	struct uclass *uc;
 	struct udevice *dev;
+	uint key;
 	int ret;
 
 	log(LOGC_DM, LOGL_DEBUG, "Looking for %s\n", ofnode_get_name(node));
@@ -393,10 +526,19 @@ int uclass_find_device_by_ofnode(enum uclass_id id, ofnode node,
 	if (ret)
 		return ret;
 
+	/* As with ofnode_equal(), the contents are enough to tell nodes apart */
+	key = uclass_cache_key(UCLASS_CACHE_OFNODE, node.of_offset);
+	dev = uclass_cache_get(uc, key);
+	if (dev && ofnode_equal(dev_ofnode(dev), node)) {
+		*devp = dev;
+		goto done;
+	}
+
 	uclass_foreach_dev(dev, uc) {
 		log(LOGC_DM, LOGL_DEBUG_CONTENT, "      - checking %s\n",
 		    dev->name);
 		if (ofnode_equal(dev_ofnode(dev), node)) {
+			uclass_cache_add(uc, key, dev);
 			*devp = dev;
 			goto done;
 		}
@@ -416,18 +558,27 @@ static int uclass_find_device_by_phandle_id(enum uclass_id id,
 {
 	struct udevice *dev;
 	struct uclass *uc;
+	uint key;
 	int ret;
 
 	ret = uclass_get(id, &uc);
 	if (ret)
 		return ret;
 
+	key = uclass_cache_key(UCLASS_CACHE_PHANDLE, find_phandle);
+	dev = uclass_cache_get(uc, key);
+	if (dev && dev_read_phandle(dev) == find_phandle) {
+		*devp = dev;
+		return 0;
+	}
+
 	uclass_foreach_dev(dev, uc) {
 		uint phandle;
 
 		phandle = dev_read_phandle(dev);
 
 		if (phandle == find_phandle) {
+			uclass_cache_add(uc, key, dev);
 			*devp = dev;
 			return 0;
 		}
@@ -707,6 +858,7 @@ int uclass_bind_device(struct udevice *dev)
 	return 0;
 err:
 	/* There is no need to undo the parent's post_bind call */
+	uclass_cache_drop(uc, dev);
 	list_del(&dev->uclass_node);
 
 	return ret;
@@ -730,6 +882,7 @@ int uclass_pre_unbind_device(struct udevice *dev)
 
 int uclass_unbind_device(struct udevice *dev)
 {
+	uclass_cache_drop(dev->uclass, dev);
 	list_del(&dev->uclass_node);
 
 	return 0;
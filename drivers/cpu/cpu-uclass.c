@@ -7,6 +7,7 @@
 #define LOG_CATEGORY UCLASS_CPU
 
 #include <cpu.h>
+#include <cpu_func.h>
 #include <dm.h>
 #include <errno.h>
 #include <log.h>
@@ -14,6 +15,8 @@
 #include <dm/root.h>
 #include <linux/err.h>
 #include <relocate.h>
+#include <thermal.h>
+#include <asm/global_data.h>
 
 DECLARE_GLOBAL_DATA_PTR;
 
@@ -61,6 +64,147 @@ struct udevice *cpu_get_current_dev(void)
 	return cpu;
 }
 
+#if CONFIG_IS_ENABLED(CPU_JOBS)
+/* Check if a CPU, other than the current one, can be given jobs */
+static bool cpu_job_ready(struct udevice *cpu)
+{
+	struct cpu_ops *ops = cpu_get_ops(cpu);
+
+	if (!ops->start_job || cpu_is_current(cpu) > 0)
+		return false;
+
+	return !ops->can_start_job || ops->can_start_job(cpu);
+}
+
+int cpu_job_start(struct cpu_job *job)
+{
+	struct udevice *cpu;
+	int ret;
+
+	job->done = false;
+	uclass_foreach_dev_probe(UCLASS_CPU, cpu) {
+		if (!cpu_job_ready(cpu))
+			continue;
+		job->dev = cpu;
+		ret = cpu_get_ops(cpu)->start_job(cpu, job);
+		if (!ret)
+			return 0;
+		if (ret != -EBUSY)
+			log_debug("Cannot start job on %s (err=%d)\n",
+				  cpu->name, ret);
+	}
+
+	/* Nothing is free, so do it here */
+	job->dev = NULL;
+	cpu_job_run(job);
+
+	return 0;
+}
+
+int cpu_job_wait(struct cpu_job *job)
+{
+	while (!__atomic_load_n(&job->done, __ATOMIC_ACQUIRE))
+		cpu_idle();
+
+	return job->ret;
+}
+
+int cpu_job_cpus(void)
+{
+	struct udevice *cpu;
+	int count = 1;
+
+	uclass_foreach_dev_probe(UCLASS_CPU, cpu) {
+		if (cpu_job_ready(cpu))
+			count++;
+	}
+
+	return count;
+}
+#endif
+
+int cpu_set_perf(struct udevice *dev, enum cpu_perf perf)
+{
+	struct cpu_ops *ops = cpu_get_ops(dev);
+	int ret;
+
+	if (!ops->set_perf)
+		return -ENOSYS;
+
+	ret = ops->set_perf(dev, perf);
+	if (!ret && perf == CPU_PERF_BOOT)
+		gd->flags |= GD_FLG_CPU_BOOST;
+
+	return ret;
+}
+
+#if CONFIG_IS_ENABLED(CPU_BOOT_BOOST)
+static int cpu_check_temp(void)
+{
+#if CONFIG_IS_ENABLED(DM_THERMAL)
+	struct udevice *dev;
+	int temp, ret;
+
+	uclass_foreach_dev_probe(UCLASS_THERMAL, dev) {
+		ret = thermal_get_temp(dev, &temp);
+		if (ret) {
+			log_debug("Cannot read %s (err=%d)\n", dev->name, ret);
+			continue;
+		}
+		if (temp >= CONFIG_CPU_BOOT_BOOST_MAX_TEMP) {
+			log_warning("%s at %dC, not boosting CPUs\n", dev->name,
+				    temp);
+			return -EAGAIN;
+		}
+	}
+#endif
+
+	return 0;
+}
+
+static int cpu_set_perf_all(enum cpu_perf perf)
+{
+	struct udevice *dev;
+	int ret, err = 0;
+
+	uclass_foreach_dev_probe(UCLASS_CPU, dev) {
+		ret = cpu_set_perf(dev, perf);
+		if (ret && ret != -ENOSYS) {
+			log_err("Cannot set %s to level %d (err=%d)\n",
+				dev->name, perf, ret);
+			err = ret;
+		}
+	}
+
+	return err;
+}
+
+int cpu_boot_boost(void)
+{
+	int ret;
+
+	ret = cpu_check_temp();
+	if (ret)
+		return ret;
+
+	return cpu_set_perf_all(CPU_PERF_BOOT);
+}
+
+int cpu_boot_restore(void)
+{
+	int ret;
+
+	if (!(gd->flags & GD_FLG_CPU_BOOST))
+		return 0;
+
+	ret = cpu_set_perf_all(CPU_PERF_OS);
+	if (!ret)
+		gd->flags &= ~GD_FLG_CPU_BOOST;
+
+	return ret;
+}
+#endif
+
 int cpu_get_desc(const struct udevice *dev, char *buf, int size)
 {
 	struct cpu_ops *ops = cpu_get_ops(dev);
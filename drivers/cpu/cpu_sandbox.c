@@ -6,6 +6,20 @@
 
 #include <dm.h>
 #include <cpu.h>
+#include <asm/cpu.h>
+
+/**
+ * struct cpu_sandbox_priv - private data for a sandbox CPU
+ *
+ * @busy: true to refuse new jobs, as if the CPU were already running one
+ * @jobs: number of jobs run by this CPU
+ * @perf: current performance level
+ */
+struct cpu_sandbox_priv {
+	bool busy;
+	int jobs;
+	enum cpu_perf perf;
+};
 
 static int cpu_sandbox_get_desc(const struct udevice *dev, char *buf, int size)
 {
@@ -52,12 +66,57 @@ static int cpu_sandbox_is_current(struct udevice *dev)
 	return 0;
 }
 
+void cpu_sandbox_set_busy(struct udevice *dev, bool busy)
+{
+	struct cpu_sandbox_priv *priv = dev_get_priv(dev);
+
+	priv->busy = busy;
+}
+
+int cpu_sandbox_get_jobs(struct udevice *dev)
+{
+	struct cpu_sandbox_priv *priv = dev_get_priv(dev);
+
+	return priv->jobs;
+}
+
+/* Sandbox only has one thread, so the job runs to completion straight away */
+static int cpu_sandbox_start_job(struct udevice *dev, struct cpu_job *job)
+{
+	struct cpu_sandbox_priv *priv = dev_get_priv(dev);
+
+	if (priv->busy)
+		return -EBUSY;
+	priv->jobs++;
+	cpu_job_run(job);
+
+	return 0;
+}
+
+int cpu_sandbox_get_perf(struct udevice *dev)
+{
+	struct cpu_sandbox_priv *priv = dev_get_priv(dev);
+
+	return priv->perf;
+}
+
+static int cpu_sandbox_set_perf(struct udevice *dev, enum cpu_perf perf)
+{
+	struct cpu_sandbox_priv *priv = dev_get_priv(dev);
+
+	priv->perf = perf;
+
+	return 0;
+}
+
 static const struct cpu_ops cpu_sandbox_ops = {
 	.get_desc = cpu_sandbox_get_desc,
 	.get_info = cpu_sandbox_get_info,
 	.get_count = cpu_sandbox_get_count,
 	.get_vendor = cpu_sandbox_get_vendor,
 	.is_current = cpu_sandbox_is_current,
+	.start_job = cpu_sandbox_start_job,
+	.set_perf = cpu_sandbox_set_perf,
 };
 
 static int cpu_sandbox_bind(struct udevice *dev)
@@ -92,4 +151,5 @@ U_BOOT_DRIVER(cpu_sandbox) = {
 	.of_match       = cpu_sandbox_ids,
 	.bind		= cpu_sandbox_bind,
 	.probe          = cpu_sandbox_probe,
+	.priv_auto	= sizeof(struct cpu_sandbox_priv),
 };
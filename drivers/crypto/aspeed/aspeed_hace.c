@@ -188,15 +188,18 @@ static int aspeed_hace_update(struct udevice *dev, void *ctx, const void *ibuf,
 		left = 0;
 	}
 
-	while (ilen >= hace_ctx->blk_size) {
-		rc = aspeed_hace_process(dev, ctx, ibuf, hace_ctx->blk_size);
+	/* hand all the whole blocks to the engine in one go */
+	if (ilen >= hace_ctx->blk_size) {
+		uint32_t len = ilen & ~(hace_ctx->blk_size - 1);
+
+		rc = aspeed_hace_process(dev, ctx, ibuf, len);
 		if (rc) {
 			debug("failed to process hash, rc=%d\n", rc);
 			return rc;
 		}
 
-		ibuf += hace_ctx->blk_size;
-		ilen -= hace_ctx->blk_size;
+		ibuf += len;
+		ilen -= len;
 	}
 
 	if (ilen)
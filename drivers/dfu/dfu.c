@@ -183,10 +183,18 @@ static unsigned char *dfu_buf;
 static unsigned long dfu_buf_size;
 static enum dfu_device_type dfu_buf_device_type;
 
+/* Second buffer, received into while the first is written */
+static unsigned char *dfu_buf2;
+
+/* Entity with a full buffer still to be written, if any */
+static struct dfu_entity *dfu_pending;
+
 unsigned char *dfu_free_buf(void)
 {
 	free(dfu_buf);
 	dfu_buf = NULL;
+	free(dfu_buf2);
+	dfu_buf2 = NULL;
 	return dfu_buf;
 }
 
@@ -221,6 +229,10 @@ unsigned char *dfu_get_buf(struct dfu_entity *dfu)
 		printf("%s: Could not memalign 0x%lx bytes\n",
 		       __func__, dfu_buf_size);
 
+	/* Without the second buffer, buffers are written as they fill */
+	if (dfu_buf && CONFIG_IS_ENABLED(DFU_WRITE_BACKGROUND))
+		dfu_buf2 = memalign(CONFIG_SYS_CACHELINE_SIZE, dfu_buf_size);
+
 	dfu_buf_device_type = dfu->dev_type;
 	return dfu_buf;
 }
@@ -242,19 +254,103 @@ static char *dfu_get_hash_algo(void)
 	return NULL;
 }
 
-static int dfu_write_buffer_drain(struct dfu_entity *dfu)
+/**
+ * dfu_write_pending_part() - Write the next part of the full buffer
+ *
+ * @dfu: Entity being written
+ * @all: true to write all of it, false to write as little as possible
+ * Return: 0 if OK, -ve on error
+ */
+static int dfu_write_pending_part(struct dfu_entity *dfu, bool all)
+{
+	long size, w_size;
+	int ret;
+
+	while (dfu->p_left) {
+		size = dfu->p_left;
+		if (!all && dfu->write_align) {
+			w_size = config_opt_enabled(CONFIG_DFU_WRITE_BACKGROUND,
+						    CONFIG_DFU_WRITE_CHUNK, 0);
+			w_size = rounddown(w_size, dfu->write_align);
+			size = min(size, max(w_size, (long)dfu->write_align));
+		}
+
+		w_size = size;
+		ret = dfu->write_medium(dfu, dfu->offset, dfu->p_buf, &w_size);
+		if (ret) {
+			debug("%s: Write error!\n", __func__);
+			dfu->p_left = 0;
+			return ret;
+		}
+		dfu->offset += w_size;
+		dfu->p_buf += size;
+		dfu->p_left -= size;
+		if (!dfu->p_left)
+			puts("#");
+		if (!all)
+			break;
+	}
+
+	return 0;
+}
+
+bool dfu_write_pending(void)
+{
+	struct dfu_entity *dfu = dfu_pending;
+	int ret;
+
+	if (!CONFIG_IS_ENABLED(DFU_WRITE_BACKGROUND) || !dfu)
+		return false;
+
+	ret = dfu_write_pending_part(dfu, false);
+	if (ret)
+		dfu->p_err = ret;
+	if (!dfu->p_left)
+		dfu_pending = NULL;
+
+	return dfu_pending;
+}
+
+/**
+ * dfu_write_buffer_drain() - Write the data in the buffer to the medium
+ *
+ * A full buffer left from before is always written first
+ *
+ * @dfu: Entity being written
+ * @wait: false to write the data in the background, if possible
+ * Return: 0 if OK, -ve on error
+ */
+static int dfu_write_buffer_drain(struct dfu_entity *dfu, bool wait)
 {
 	long w_size;
 	int ret;
 
+	ret = dfu_write_pending_part(dfu, true);
+	if (dfu_pending == dfu)
+		dfu_pending = NULL;
+	if (!ret)
+		ret = dfu->p_err;
+	if (ret)
+		return ret;
+
 	/* flush size? */
 	w_size = dfu->i_buf - dfu->i_buf_start;
 	if (w_size == 0)
 		return 0;
 
-	if (dfu_hash_algo)
-		dfu_hash_algo->hash_update(dfu_hash_algo, &dfu->crc,
-					   dfu->i_buf_start, w_size, 0);
+	if (!wait && dfu_buf2) {
+		dfu->p_buf = dfu->i_buf_start;
+		dfu->p_left = w_size;
+		dfu_pending = dfu;
+
+		/* carry on with the other buffer */
+		dfu->i_buf_start = dfu->i_buf_start == dfu_buf ? dfu_buf2 :
+			dfu_buf;
+		dfu->i_buf_end = dfu->i_buf_start + dfu_get_buf_size();
+		dfu->i_buf = dfu->i_buf_start;
+
+		return 0;
+	}
 
 	ret = dfu->write_medium(dfu, dfu->offset, dfu->i_buf_start, &w_size);
 	if (ret)
@@ -283,6 +379,10 @@ void dfu_transaction_cleanup(struct dfu_entity *dfu)
 	dfu->r_left = 0;
 	dfu->b_left = 0;
 	dfu->bad_skip = 0;
+	dfu->p_left = 0;
+	dfu->p_err = 0;
+	if (dfu_pending == dfu)
+		dfu_pending = NULL;
 
 	dfu->inited = 0;
 }
@@ -318,7 +418,7 @@ int dfu_flush(struct dfu_entity *dfu, void *buf, int size, int blk_seq_num)
 {
 	int ret = 0;
 
-	ret = dfu_write_buffer_drain(dfu);
+	ret = dfu_write_buffer_drain(dfu, true);
 	if (ret)
 		return ret;
 
@@ -356,6 +456,14 @@ int dfu_write(struct dfu_entity *dfu, void *buf, int size, int blk_seq_num)
 		return -1;
 	}
 
+	/* writing an earlier buffer in the background failed */
+	if (dfu->p_err) {
+		ret = dfu->p_err;
+		dfu_transaction_cleanup(dfu);
+		dfu_error_callback(dfu, "DFU write error");
+		return ret;
+	}
+
 	/* DFU 1.1 standard says:
 	 * The wBlockNum field is a block sequence number. It increments each
 	 * time a block is transferred, wrapping to zero from 65,535. It is used
@@ -374,7 +482,7 @@ int dfu_write(struct dfu_entity *dfu, void *buf, int size, int blk_seq_num)
 
 	/* flush buffer if overflow */
 	if ((dfu->i_buf + size) > dfu->i_buf_end) {
-		ret = dfu_write_buffer_drain(dfu);
+		ret = dfu_write_buffer_drain(dfu, false);
 		if (ret) {
 			dfu_transaction_cleanup(dfu);
 			dfu_error_callback(dfu, "DFU write error");
@@ -392,11 +500,14 @@ int dfu_write(struct dfu_entity *dfu, void *buf, int size, int blk_seq_num)
 	}
 
 	memcpy(dfu->i_buf, buf, size);
+	if (dfu_hash_algo)
+		dfu_hash_algo->hash_update(dfu_hash_algo, &dfu->crc,
+					   dfu->i_buf, size, 0);
 	dfu->i_buf += size;
 
 	/* if end or if buffer full flush */
 	if (size == 0 || (dfu->i_buf + size) > dfu->i_buf_end) {
-		ret = dfu_write_buffer_drain(dfu);
+		ret = dfu_write_buffer_drain(dfu, !size);
 		if (ret) {
 			dfu_transaction_cleanup(dfu);
 			dfu_error_callback(dfu, "DFU write error");
@@ -527,6 +638,7 @@ static int dfu_fill_entity(struct dfu_entity *dfu, char *s, int alt,
 
 	dfu->alt = alt;
 	dfu->max_buf_size = 0;
+	dfu->write_align = 0;
 	dfu->free_entity = NULL;
 
 	/* Specific for mmc device */
@@ -462,6 +462,11 @@ int dfu_fill_entity_mmc(struct dfu_entity *dfu, char *devstr, char **argv, int a
 	dfu->get_medium_size = dfu_get_medium_size_mmc;
 	dfu->read_medium = dfu_read_medium_mmc;
 	dfu->write_medium = dfu_write_medium_mmc;
+	/* Scripts must be run whole */
+	if (dfu->layout == DFU_RAW_ADDR)
+		dfu->write_align = dfu->data.mmc.lba_blk_size;
+	else if (dfu->layout == DFU_FS_FAT || dfu->layout == DFU_FS_EXT4)
+		dfu->write_align = 1;
 	dfu->flush_medium = dfu_flush_medium_mmc;
 	dfu->inited = 0;
 	dfu->free_entity = dfu_free_entity_mmc;
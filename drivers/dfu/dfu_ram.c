@@ -78,6 +78,7 @@ int dfu_fill_entity_ram(struct dfu_entity *dfu, char *devstr, char **argv, int a
 		return -EINVAL;
 
 	dfu->write_medium = dfu_write_medium_ram;
+	dfu->write_align = 1;
 	dfu->get_medium_size = dfu_get_medium_size_ram;
 	dfu->read_medium = dfu_read_medium_ram;
 
@@ -260,6 +260,35 @@ int dma_memcpy(void *dst, void *src, size_t len)
 	return ret;
 }
 
+#if CONFIG_IS_ENABLED(DMA_BULK_COPY)
+int dma_bulk_copy(void *dst, const void *src, size_t len)
+{
+	ulong start = (ulong)dst, from = (ulong)src;
+	size_t head, mid;
+	int ret;
+
+	if (len < CONFIG_DMA_BULK_COPY_MIN)
+		return -EINVAL;
+	if (start < from + len && from < start + len)
+		return -EINVAL;
+	if ((start - from) & (ARCH_DMA_MINALIGN - 1))
+		return -EINVAL;
+
+	/* Only whole cache lines of @dst can be invalidated safely */
+	head = -start & (ARCH_DMA_MINALIGN - 1);
+	if (len < head + ARCH_DMA_MINALIGN)
+		return -EINVAL;
+	mid = (len - head) & ~(ARCH_DMA_MINALIGN - 1);
+	ret = dma_memcpy(dst + head, (void *)src + head, mid);
+	if (ret < 0)
+		return ret;
+	memcpy(dst, src, head);
+	memcpy(dst + head + mid, src + head + mid, len - head - mid);
+
+	return 0;
+}
+#endif
+
 UCLASS_DRIVER(dma) = {
 	.id		= UCLASS_DMA,
 	.name		= "dma",
@@ -30,6 +30,36 @@ static u32 fastboot_bytes_received;
  */
 static u32 fastboot_bytes_expected;
 
+/**
+ * stream_part - partition to write downloads to as they arrive, if any
+ */
+static char stream_part[PART_NAME_LEN];
+
+/**
+ * stream_active - true if the current download is being written to stream_part
+ */
+static bool stream_active;
+
+/**
+ * stream_used - number of bytes of the current download already written
+ */
+static u32 stream_used;
+
+/**
+ * stream_failed - true if writing the current download failed
+ */
+static bool stream_failed;
+
+/**
+ * stream_flashed - true if the last download was written to stream_part
+ */
+static bool stream_flashed;
+
+/**
+ * stream_response - response to send once the download is complete, on failure
+ */
+static char stream_response[FASTBOOT_RESPONSE_LEN];
+
 static void okay(char *, char *);
 static void getvar(char *, char *);
 static void download(char *, char *);
@@ -43,6 +73,7 @@ static void oem_partconf(char *, char *);
 static void oem_bootbus(char *, char *);
 static void oem_console(char *, char *);
 static void oem_board(char *, char *);
+static void oem_stream(char *, char *);
 static void run_ucmd(char *, char *);
 static void run_acmd(char *, char *);
 
@@ -118,6 +149,10 @@ static const struct {
 		.command = "oem board",
 		.dispatch = CONFIG_IS_ENABLED(FASTBOOT_OEM_BOARD, (oem_board), (NULL))
 	},
+	[FASTBOOT_COMMAND_OEM_STREAM] = {
+		.command = "oem stream",
+		.dispatch = CONFIG_IS_ENABLED(FASTBOOT_STREAM, (oem_stream), (NULL))
+	},
 	[FASTBOOT_COMMAND_UCMD] = {
 		.command = "UCmd",
 		.dispatch = CONFIG_IS_ENABLED(FASTBOOT_UUU_SUPPORT, (run_ucmd), (NULL))
@@ -233,6 +268,7 @@ static void download(char *cmd_parameter, char *response)
 		return;
 	}
 	fastboot_bytes_received = 0;
+	stream_flashed = false;
 	fastboot_bytes_expected = hextoul(cmd_parameter, &tmp);
 	if (fastboot_bytes_expected == 0) {
 		fastboot_fail("Expected nonzero image size", response);
@@ -246,11 +282,17 @@ static void download(char *cmd_parameter, char *response)
 	 */
 	if (fastboot_bytes_expected > fastboot_buf_size) {
 		fastboot_fail(cmd_parameter, response);
-	} else {
-		printf("Starting download of %d bytes\n",
-		       fastboot_bytes_expected);
-		fastboot_response("DATA", response, "%s", cmd_parameter);
+		return;
+	}
+	if (CONFIG_IS_ENABLED(FASTBOOT_STREAM) && *stream_part) {
+		if (fastboot_mmc_stream_open(stream_part, response))
+			return;
+		stream_active = true;
+		stream_used = 0;
+		stream_failed = false;
 	}
+	printf("Starting download of %d bytes\n", fastboot_bytes_expected);
+	fastboot_response("DATA", response, "%s", cmd_parameter);
 }
 
 /**
@@ -307,18 +349,72 @@ void fastboot_data_download(const void *fastboot_data,
 	*response = '\0';
 }
 
+/**
+ * fastboot_data_stream() - Write the data received so far to the partition
+ *
+ * This does nothing unless the download is being streamed to a partition with
+ * "oem stream". Data is only written once there is enough of it. An error is
+ * reported when the download completes.
+ */
+void fastboot_data_stream(void)
+{
+	int ret;
+
+	if (!CONFIG_IS_ENABLED(FASTBOOT_STREAM) || !stream_active ||
+	    stream_failed)
+		return;
+
+	ret = fastboot_mmc_stream_write(fastboot_buf_addr + stream_used,
+					fastboot_bytes_received - stream_used,
+					false, stream_response);
+	if (ret < 0)
+		stream_failed = true;
+	else
+		stream_used += ret;
+}
+
+/**
+ * fastboot_stream_complete() - Finish writing a download to the partition
+ *
+ * Return: 0 if OK, -ve on error, with stream_response set
+ */
+static int fastboot_stream_complete(void)
+{
+	int ret;
+
+	stream_active = false;
+	if (stream_failed)
+		return -EIO;
+
+	ret = fastboot_mmc_stream_write(fastboot_buf_addr + stream_used,
+					fastboot_bytes_received - stream_used,
+					true, stream_response);
+	if (ret < 0)
+		return ret;
+
+	return fastboot_mmc_stream_close(stream_response);
+}
+
 /**
  * fastboot_data_complete() - Mark current transfer complete
  *
  * @response: Pointer to fastboot response buffer
  *
  * Set image_size and ${filesize} to the total size of the downloaded image.
+ * If the download is being streamed to a partition, finish writing it.
  */
 void fastboot_data_complete(char *response)
 {
 	/* Download complete. Respond with "OKAY" */
 	fastboot_okay(NULL, response);
 	printf("\ndownloading of %d bytes finished\n", fastboot_bytes_received);
+	if (CONFIG_IS_ENABLED(FASTBOOT_STREAM) && stream_active) {
+		if (fastboot_stream_complete())
+			strlcpy(response, stream_response,
+				FASTBOOT_RESPONSE_LEN);
+		else
+			stream_flashed = true;
+	}
 	image_size = fastboot_bytes_received;
 	env_set_hex("filesize", image_size);
 	fastboot_bytes_expected = 0;
@@ -336,6 +432,15 @@ void fastboot_data_complete(char *response)
  */
 static void __maybe_unused flash(char *cmd_parameter, char *response)
 {
+	bool flashed = stream_flashed;
+
+	/* The image was already written while it was downloaded */
+	stream_flashed = false;
+	if (flashed && cmd_parameter && !strcmp(cmd_parameter, stream_part)) {
+		fastboot_okay(NULL, response);
+		return;
+	}
+
 	if (IS_ENABLED(CONFIG_FASTBOOT_FLASH_MMC))
 		fastboot_mmc_flash_write(cmd_parameter, fastboot_buf_addr,
 					 image_size, response);
@@ -572,3 +677,28 @@ static void __maybe_unused oem_board(char *cmd_parameter, char *response)
 {
 	fastboot_oem_board(cmd_parameter, (void *)fastboot_buf_addr, image_size, response);
 }
+
+/**
+ * oem_stream() - Execute the OEM stream command
+ *
+ * @cmd_parameter: Partition to write downloads to, or empty to stop this
+ * @response: Pointer to fastboot response buffer
+ */
+static void __maybe_unused oem_stream(char *cmd_parameter, char *response)
+{
+	if (!cmd_parameter || !*cmd_parameter) {
+		*stream_part = '\0';
+		fastboot_okay(NULL, response);
+		return;
+	}
+	if (strlen(cmd_parameter) >= sizeof(stream_part)) {
+		fastboot_fail("partition name too long", response);
+		return;
+	}
+
+	/* Check that the partition exists */
+	if (fastboot_mmc_stream_open(cmd_parameter, response))
+		return;
+	strcpy(stream_part, cmd_parameter);
+	fastboot_okay(NULL, response);
+}
@@ -129,20 +129,23 @@ static lbaint_t fb_mmc_blk_write(struct blk_desc *block_dev, lbaint_t start,
 	lbaint_t blks_written;
 	lbaint_t cur_blkcnt;
 	lbaint_t blks = 0;
-	int i;
 
-	for (i = 0; i < blkcnt; i += FASTBOOT_MAX_BLK_WRITE) {
-		cur_blkcnt = min((int)blkcnt - i, FASTBOOT_MAX_BLK_WRITE);
+	while (blks < blkcnt) {
+		/* End each piece on an erase group where possible */
+		cur_blkcnt = blk_write_split(block_dev, blk, blkcnt - blks,
+					     FASTBOOT_MAX_BLK_WRITE);
 		if (buffer) {
 			if (fastboot_progress_callback)
 				fastboot_progress_callback("writing");
 			blks_written = blk_dwrite(block_dev, blk, cur_blkcnt,
-						  buffer + (i * block_dev->blksz));
+						  buffer + (blks * block_dev->blksz));
 		} else {
 			if (fastboot_progress_callback)
 				fastboot_progress_callback("erasing");
 			blks_written = blk_derase(block_dev, blk, cur_blkcnt);
 		}
+		if (blks_written != cur_blkcnt)
+			break;
 		blk += blks_written;
 		blks += blks_written;
 	}
@@ -164,6 +167,17 @@ static lbaint_t fb_mmc_sparse_reserve(struct sparse_storage *info,
 	return blkcnt;
 }
 
+static lbaint_t fb_mmc_sparse_discard(struct sparse_storage *info,
+		lbaint_t blk, lbaint_t blkcnt)
+{
+	struct fb_mmc_sparse *sparse = info->priv;
+
+	if (fastboot_progress_callback)
+		fastboot_progress_callback("erasing");
+
+	return blk_ddiscard(sparse->dev_desc, blk, blkcnt) ? 0 : blkcnt;
+}
+
 static void write_raw_image(struct blk_desc *dev_desc,
 			    struct disk_partition *info, const char *part_name,
 			    void *buffer, u32 download_bytes, char *response)
@@ -620,6 +634,8 @@ void fastboot_mmc_flash_write(const char *cmd, void *download_buffer,
 		sparse.size = info.size;
 		sparse.write = fb_mmc_sparse_write;
 		sparse.reserve = fb_mmc_sparse_reserve;
+		sparse.discard = fb_mmc_sparse_discard;
+		sparse.discard_align = dev_desc->discard_align;
 		sparse.mssg = fastboot_fail;
 
 		printf("Flashing sparse image at offset " LBAFU "\n",
@@ -636,6 +652,129 @@ void fastboot_mmc_flash_write(const char *cmd, void *download_buffer,
 	}
 }
 
+#if CONFIG_IS_ENABLED(FASTBOOT_STREAM)
+/**
+ * struct fb_mmc_stream - Image being written while it is downloaded
+ *
+ * @info: Partition being written
+ * @sparse_priv: Private data for @sparse
+ * @sparse: Storage for a sparse image
+ * @ss: State of a sparse image
+ * @started: true once it is known whether the image is sparse
+ * @is_sparse: true if the image is sparse
+ * @blk: Next block to write, for a raw image
+ */
+static struct fb_mmc_stream {
+	struct disk_partition info;
+	struct fb_mmc_sparse sparse_priv;
+	struct sparse_storage sparse;
+	struct sparse_stream ss;
+	bool started;
+	bool is_sparse;
+	lbaint_t blk;
+} fb_mmc_stream;
+
+int fastboot_mmc_stream_open(const char *cmd, char *response)
+{
+	struct fb_mmc_stream *st = &fb_mmc_stream;
+	struct blk_desc *dev_desc = NULL;
+
+	memset(st, '\0', sizeof(*st));
+#if IS_ENABLED(CONFIG_FASTBOOT_MMC_USER_SUPPORT)
+	if (strcmp(cmd, CONFIG_FASTBOOT_MMC_USER_NAME) == 0) {
+		dev_desc = fastboot_mmc_get_dev(response);
+		if (!dev_desc)
+			return -ENODEV;
+
+		strlcpy((char *)&st->info.name, cmd, sizeof(st->info.name));
+		st->info.size	= dev_desc->lba;
+		st->info.blksz	= dev_desc->blksz;
+	}
+#endif
+
+	if (!st->info.name[0] &&
+	    fastboot_mmc_get_part_info(cmd, &dev_desc, &st->info,
+				       response) < 0)
+		return -ENOENT;
+
+	st->sparse_priv.dev_desc = dev_desc;
+	st->sparse.blksz = st->info.blksz;
+	st->sparse.start = st->info.start;
+	st->sparse.size = st->info.size;
+	st->sparse.write = fb_mmc_sparse_write;
+	st->sparse.reserve = fb_mmc_sparse_reserve;
+	st->sparse.discard = fb_mmc_sparse_discard;
+	st->sparse.discard_align = dev_desc->discard_align;
+	st->sparse.mssg = fastboot_fail;
+	st->sparse.priv = &st->sparse_priv;
+	sparse_stream_init(&st->ss, &st->sparse);
+	st->ss.min_write = CONFIG_FASTBOOT_STREAM_SIZE;
+	st->blk = st->info.start;
+
+	return 0;
+}
+
+int fastboot_mmc_stream_write(void *buffer, u32 len, bool last,
+			      char *response)
+{
+	struct fb_mmc_stream *st = &fb_mmc_stream;
+	lbaint_t blksz = st->info.blksz;
+	lbaint_t blkcnt, blks;
+
+	if (!st->started) {
+		if (len < sizeof(sparse_header_t) && !last)
+			return 0;
+		st->started = true;
+		st->is_sparse = len >= sizeof(sparse_header_t) &&
+			is_sparse_image(buffer);
+		if (st->is_sparse)
+			printf("Flashing sparse image at offset " LBAFU "\n",
+			       st->info.start);
+		else
+			puts("Flashing Raw Image\n");
+	}
+	if (st->is_sparse)
+		return sparse_stream_write(&st->ss, buffer, len, last,
+					   response);
+
+	/* The last block of a raw image is padded, as write_raw_image() */
+	blkcnt = last ? DIV_ROUND_UP(len, blksz) : len / blksz;
+	if (!blkcnt || (!last && blkcnt * blksz < CONFIG_FASTBOOT_STREAM_SIZE))
+		return 0;
+	if (st->blk + blkcnt > st->info.start + st->info.size) {
+		pr_err("too large for partition: '%s'\n", st->info.name);
+		fastboot_fail("too large for partition", response);
+		return -EFBIG;
+	}
+
+	blks = fb_mmc_blk_write(st->sparse_priv.dev_desc, st->blk, blkcnt,
+				buffer);
+	if (blks != blkcnt) {
+		pr_err("failed writing to device %d\n",
+		       st->sparse_priv.dev_desc->devnum);
+		fastboot_fail("failed writing to device", response);
+		return -EIO;
+	}
+	st->blk += blkcnt;
+
+	return min_t(lbaint_t, len, blkcnt * blksz);
+}
+
+int fastboot_mmc_stream_close(char *response)
+{
+	struct fb_mmc_stream *st = &fb_mmc_stream;
+
+	if (st->is_sparse)
+		return sparse_stream_finish(&st->ss, (const char *)st->info.name,
+					    response);
+
+	printf("........ wrote " LBAFU " bytes to '%s'\n",
+	       (st->blk - st->info.start) * st->info.blksz, st->info.name);
+
+	return 0;
+}
+#endif
+
 /**
  * fastboot_mmc_flash_erase() - Erase eMMC for fastboot
  *
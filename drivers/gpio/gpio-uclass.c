@@ -21,6 +21,7 @@
 #include <asm/global_data.h>
 #include <asm/gpio.h>
 #include <dm/device_compat.h>
+#include <linux/bitops.h>
 #include <linux/bug.h>
 #include <linux/ctype.h>
 #include <linux/delay.h>
@@ -29,6 +30,9 @@ DECLARE_GLOBAL_DATA_PTR;
 
 #define GPIO_ALLOC_BITS	32
 
+/* GPIOs at or above this offset are not passed to get_values()/set_values() */
+#define GPIO_BATCH_OFFSETS	256
+
 /**
  * gpio_desc_init() - Initialize the GPIO descriptor
  *
@@ -643,6 +647,156 @@ int dm_gpio_set_value(const struct gpio_desc *desc, int value)
 	return 0;
 }
 
+/**
+ * gpio_batch_mask() - Work out which GPIOs in a list can be handled together
+ *
+ * This finds the GPIOs in the list which are in the same device as the first
+ * one, starting at @first, and which can be handled by one call to the driver
+ *
+ * @desc_list: List of GPIOs
+ * @count: Number of GPIOs in the list
+ * @first: Index of the first GPIO to handle
+ * @set: true if the GPIOs are being set, false if being read
+ * @mask: Returns bitmap of the offsets within the device
+ * Return: bitmap of the indexes in @desc_list which are covered by @mask
+ */
+static ulong gpio_batch_mask(const struct gpio_desc *desc_list, int count,
+			     int first, bool set, ulong *mask)
+{
+	struct udevice *dev = desc_list[first].dev;
+	ulong batch = 0;
+	int i;
+
+	memset(mask, '\0', BITS_TO_LONGS(GPIO_BATCH_OFFSETS) * sizeof(ulong));
+	for (i = first; i < count; i++) {
+		const struct gpio_desc *desc = &desc_list[i];
+
+		if (desc->dev != dev || desc->offset >= GPIO_BATCH_OFFSETS)
+			continue;
+		if (set && (!(desc->flags & GPIOD_IS_OUT) ||
+			    (desc->flags & GPIOD_MASK_DSTYPE)))
+			continue;
+		mask[BIT_WORD(desc->offset)] |= BIT_MASK(desc->offset);
+		batch |= BIT(i);
+	}
+
+	return batch;
+}
+
+int dm_gpio_get_values(const struct gpio_desc *desc_list, int count,
+		       ulong *valuesp)
+{
+	ulong mask[BITS_TO_LONGS(GPIO_BATCH_OFFSETS)];
+	ulong bits[BITS_TO_LONGS(GPIO_BATCH_OFFSETS)];
+	ulong batch, done = 0, values = 0;
+	int i, ret;
+
+	if (count > BITS_PER_LONG)
+		return -E2BIG;
+	for (i = 0; i < count; i++) {
+		ret = check_reserved(&desc_list[i], "get_values");
+		if (ret)
+			return ret;
+	}
+
+	for (i = 0; i < count; i++) {
+		const struct gpio_desc *desc = &desc_list[i];
+		const struct dm_gpio_ops *ops = gpio_get_ops(desc->dev);
+		int j;
+
+		if (done & BIT(i))
+			continue;
+		batch = 0;
+		if (ops->get_values)
+			batch = gpio_batch_mask(desc_list, count, i, false,
+						mask);
+		if (!batch) {
+			ret = _gpio_get_value(desc);
+			if (ret < 0)
+				return ret;
+			if (ret)
+				values |= BIT(i);
+			continue;
+		}
+
+		ret = ops->get_values(desc->dev, mask, bits);
+		if (ret)
+			return ret;
+		for (j = i; j < count; j++) {
+			uint offset = desc_list[j].offset;
+			bool val;
+
+			if (!(batch & BIT(j)))
+				continue;
+			val = bits[BIT_WORD(offset)] & BIT_MASK(offset);
+			if (desc_list[j].flags & GPIOD_ACTIVE_LOW)
+				val = !val;
+			if (val)
+				values |= BIT(j);
+		}
+		done |= batch;
+	}
+	*valuesp = values;
+
+	return 0;
+}
+
+int dm_gpio_set_values(const struct gpio_desc *desc_list, int count,
+		       ulong values)
+{
+	ulong mask[BITS_TO_LONGS(GPIO_BATCH_OFFSETS)];
+	ulong bits[BITS_TO_LONGS(GPIO_BATCH_OFFSETS)];
+	ulong batch, done = 0;
+	int i, ret;
+
+	if (count > BITS_PER_LONG)
+		return -E2BIG;
+	for (i = 0; i < count; i++) {
+		ret = check_reserved(&desc_list[i], "set_values");
+		if (ret)
+			return ret;
+	}
+
+	for (i = 0; i < count; i++) {
+		const struct gpio_desc *desc = &desc_list[i];
+		const struct dm_gpio_ops *ops = gpio_get_ops(desc->dev);
+		int j;
+
+		if (done & BIT(i))
+			continue;
+		batch = 0;
+		if (ops->set_values)
+			batch = gpio_batch_mask(desc_list, count, i, true,
+						mask);
+		if (!batch) {
+			ret = dm_gpio_set_value(desc, !!(values & BIT(i)));
+			if (ret)
+				return ret;
+			continue;
+		}
+
+		memset(bits, '\0', sizeof(bits));
+		for (j = i; j < count; j++) {
+			uint offset = desc_list[j].offset;
+			bool val;
+
+			if (!(batch & BIT(j)))
+				continue;
+			val = values & BIT(j);
+			if (desc_list[j].flags & GPIOD_ACTIVE_LOW)
+				val = !val;
+			if (val)
+				bits[BIT_WORD(offset)] |= BIT_MASK(offset);
+		}
+		ret = ops->set_values(desc->dev, mask, bits);
+		if (ret)
+			return ret;
+		done |= batch;
+	}
+
+	return 0;
+}
+
 /* check dir flags invalid configuration */
 static int check_dir_flags(ulong flags)
 {
@@ -1017,8 +1171,17 @@ int dm_gpio_get_values_as_int(const struct gpio_desc *desc_list, int count)
 {
 	unsigned bitmask = 1;
 	unsigned vector = 0;
+	ulong values;
 	int ret, i;
 
+	if (count <= BITS_PER_LONG) {
+		ret = dm_gpio_get_values(desc_list, count, &values);
+		if (ret)
+			return ret;
+
+		return (uint)values;
+	}
+
 	for (i = 0; i < count; i++) {
 		ret = dm_gpio_get_value(&desc_list[i]);
 		if (ret < 0)
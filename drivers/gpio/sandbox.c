@@ -189,6 +189,44 @@ static int sb_gpio_set_value(struct udevice *dev, unsigned offset, int value)
 	return 0;
 }
 
+static int sb_gpio_get_values(struct udevice *dev, const ulong *mask,
+			      ulong *bits)
+{
+	struct gpio_dev_priv *uc_priv = dev_get_uclass_priv(dev);
+	uint offset;
+
+	for (offset = 0; offset < uc_priv->gpio_count; offset++) {
+		if (!(mask[BIT_WORD(offset)] & BIT_MASK(offset)))
+			continue;
+		if (sandbox_gpio_get_value(dev, offset))
+			bits[BIT_WORD(offset)] |= BIT_MASK(offset);
+		else
+			bits[BIT_WORD(offset)] &= ~BIT_MASK(offset);
+	}
+
+	return 0;
+}
+
+static int sb_gpio_set_values(struct udevice *dev, const ulong *mask,
+			      const ulong *bits)
+{
+	struct gpio_dev_priv *uc_priv = dev_get_uclass_priv(dev);
+	uint offset;
+	int ret;
+
+	for (offset = 0; offset < uc_priv->gpio_count; offset++) {
+		if (!(mask[BIT_WORD(offset)] & BIT_MASK(offset)))
+			continue;
+		ret = sb_gpio_set_value(dev, offset,
+					!!(bits[BIT_WORD(offset)] &
+					   BIT_MASK(offset)));
+		if (ret)
+			return ret;
+	}
+
+	return 0;
+}
+
 static int sb_gpio_get_function(struct udevice *dev, unsigned offset)
 {
 	if (get_gpio_flag(dev, offset, GPIOD_IS_OUT))
@@ -316,6 +354,8 @@ static const struct dm_gpio_ops gpio_sandbox_ops = {
 	.direction_output	= sb_gpio_direction_output,
 	.get_value		= sb_gpio_get_value,
 	.set_value		= sb_gpio_set_value,
+	.get_values		= sb_gpio_get_values,
+	.set_values		= sb_gpio_set_values,
 	.get_function		= sb_gpio_get_function,
 	.xlate			= sb_gpio_xlate,
 	.set_flags		= sb_gpio_set_flags,
@@ -11,6 +11,7 @@
 #include <log.h>
 #include <malloc.h>
 #include <acpi/acpi_device.h>
+#include <asm/cache.h>
 #include <dm/acpi.h>
 #include <dm/device-internal.h>
 #include <dm/lists.h>
@@ -134,10 +135,13 @@ int dm_i2c_read(struct udevice *dev, uint offset, uint8_t *buffer, int len)
 {
 	struct dm_i2c_chip *chip = dev_get_parent_plat(dev);
 	struct udevice *bus = dev_get_parent(dev);
+	struct dm_i2c_bus *i2c = dev_get_uclass_priv(bus);
 	struct dm_i2c_ops *ops = i2c_get_ops(bus);
 	struct i2c_msg msg[2], *ptr;
 	uint8_t offset_buf[I2C_MAX_OFFSET_LEN];
+	uint8_t *bounce = NULL;
 	int msg_count;
+	int ret;
 
 	if (!ops->xfer)
 		return -ENOSYS;
@@ -153,11 +157,36 @@ int dm_i2c_read(struct udevice *dev, uint offset, uint8_t *buffer, int len)
 		ptr->flags |= I2C_M_RD;
 		ptr->len = len;
 		ptr->buf = buffer;
+
+		/*
+		 * Let the driver use DMA for a large read. The buffer must not
+		 * share a cache line with anything else, since the cache is
+		 * invalidated, so use a bounce buffer if needed.
+		 */
+		if (i2c->dma_min_bytes && len >= i2c->dma_min_bytes) {
+			if (!IS_ALIGNED((ulong)buffer | len,
+					ARCH_DMA_MINALIGN)) {
+				bounce = memalign(ARCH_DMA_MINALIGN,
+						  ALIGN(len, ARCH_DMA_MINALIGN));
+				ptr->buf = bounce;
+			}
+			if (ptr->buf)
+				ptr->flags |= I2C_M_DMA_SAFE;
+			else
+				ptr->buf = buffer;
+		}
 		ptr++;
 	}
 	msg_count = ptr - msg;
 
-	return ops->xfer(bus, msg, msg_count);
+	ret = ops->xfer(bus, msg, msg_count);
+	if (bounce) {
+		if (!ret)
+			memcpy(buffer, bounce, len);
+		free(bounce);
+	}
+
+	return ret;
 }
 
 int dm_i2c_write(struct udevice *dev, uint offset, const uint8_t *buffer,
@@ -635,6 +635,12 @@ static int mtk_i2c_do_transfer(struct mtk_i2c_priv *priv,
 		mtk_i2c_init_hw(priv);
 	}
 
+	/* the data went straight to memory, so drop any stale cache lines */
+	if (!ret && msg_rx && (msg_rx->flags & I2C_M_DMA_SAFE))
+		invalidate_dcache_range((ulong)msg_rx->buf,
+					(ulong)msg_rx->buf +
+					ALIGN(msg_rx->len, ARCH_DMA_MINALIGN));
+
 	return ret;
 }
 
@@ -754,9 +760,13 @@ static int mtk_i2c_of_to_plat(struct udevice *dev)
 static int mtk_i2c_probe(struct udevice *dev)
 {
 	struct mtk_i2c_priv *priv = dev_get_priv(dev);
+	struct dm_i2c_bus *i2c = dev_get_uclass_priv(dev);
 
 	priv->soc_data = (struct mtk_i2c_soc_data *)dev_get_driver_data(dev);
 
+	/* every transfer uses DMA, so ask for a DMA-safe buffer for all reads */
+	i2c->dma_min_bytes = 1;
+
 	if (mtk_i2c_clk_enable(priv))
 		return log_msg_ret("probe enable clk", -1);
 
@@ -9,6 +9,7 @@
 #include <errno.h>
 #include <i2c.h>
 #include <log.h>
+#include <asm/cache.h>
 #include <asm/i2c.h>
 #include <asm/test.h>
 #include <dm/acpi.h>
@@ -51,6 +52,7 @@ static int sandbox_i2c_xfer(struct udevice *bus, struct i2c_msg *msg,
 	struct udevice *emul, *dev;
 	bool is_read;
 	int ret;
+	int i;
 
 	/* Special test code to return success but with no emulation */
 	if (priv->test_mode && msg->addr == SANDBOX_I2C_TEST_ADDR)
@@ -64,6 +66,13 @@ static int sandbox_i2c_xfer(struct udevice *bus, struct i2c_msg *msg,
 	if (ret)
 		return ret;
 
+	/* a DMA-safe buffer must be cache-aligned; its length need not be */
+	for (i = 0; i < nmsgs; i++) {
+		if ((msg[i].flags & I2C_M_DMA_SAFE) &&
+		    !IS_ALIGNED((ulong)msg[i].buf, ARCH_DMA_MINALIGN))
+			return -EFAULT;
+	}
+
 	if (priv->test_mode) {
 		/*
 		* For testing, don't allow writing above 100KHz for writes and
@@ -0,0 +1,251 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * eMMC Command Queueing Host Controller Interface (CQHCI)
+ *
+ * The engine is driven by polling: interrupts are never signalled and the
+ * task-completion notification register is read to find finished tasks.
+ */
+
+#define LOG_CATEGORY UCLASS_MMC
+
+#include <cpu_func.h>
+#include <cqhci.h>
+#include <dm.h>
+#include <log.h>
+#include <malloc.h>
+#include <mmc.h>
+#include <phys2bus.h>
+#include <asm/cache.h>
+#include <asm/io.h>
+#include <linux/bitops.h>
+#include <linux/dma-mapping.h>
+#include <linux/errno.h>
+#include <linux/iopoll.h>
+#include <linux/kernel.h>
+
+/* Time allowed for the engine to halt */
+#define CQHCI_HALT_TIMEOUT_US	100000
+
+static u32 cqhci_readl(struct cqhci_host *cq, int reg)
+{
+	return readl(cq->base + reg);
+}
+
+static void cqhci_writel(struct cqhci_host *cq, u32 val, int reg)
+{
+	writel(val, cq->base + reg);
+}
+
+static uint cqhci_desc_len(struct cqhci_host *cq)
+{
+	return (cq->task_desc_len + cq->link_desc_len) * CQHCI_NUM_SLOTS;
+}
+
+static u32 *cqhci_task_desc(struct cqhci_host *cq, uint tag)
+{
+	return cq->desc_base + tag * (cq->task_desc_len + cq->link_desc_len);
+}
+
+static u32 *cqhci_trans_desc(struct cqhci_host *cq, uint tag)
+{
+	return cq->trans_base + tag * CQHCI_MAX_SEGS * cq->trans_desc_len;
+}
+
+static dma_addr_t cqhci_bus_addr(struct cqhci_host *cq, dma_addr_t addr)
+{
+	return dev_phys_to_bus(cq->mmc->dev, addr);
+}
+
+/* fill in the start of a link or transfer descriptor */
+static void cqhci_set_desc(struct cqhci_host *cq, u32 *desc, u32 attr,
+			   dma_addr_t addr)
+{
+	desc[0] = cpu_to_le32(attr);
+	desc[1] = cpu_to_le32(lower_32_bits(addr));
+	if (cq->dma64)
+		desc[2] = cpu_to_le32(upper_32_bits(addr));
+}
+
+static void cqhci_flush(void *start, uint len)
+{
+	ulong addr = (ulong)start;
+
+	flush_dcache_range(addr, addr + ALIGN(len, ARCH_DMA_MINALIGN));
+}
+
+int cqhci_init(struct cqhci_host *cq, struct mmc *mmc, struct mmc_config *cfg)
+{
+	uint trans_len;
+	uint tag;
+
+	cq->mmc = mmc;
+	cq->task_desc_len = cq->task_desc_128 ? 16 : 8;
+	cq->link_desc_len = cq->dma64 ? 16 : 8;
+	cq->trans_desc_len = cq->dma64 ? 16 : 8;
+	trans_len = CQHCI_NUM_SLOTS * CQHCI_MAX_SEGS * cq->trans_desc_len;
+
+	/* the task-descriptor list must be 1KiB aligned */
+	cq->desc_base = memalign(SZ_1K, cqhci_desc_len(cq));
+	cq->trans_base = memalign(ARCH_DMA_MINALIGN, trans_len);
+	if (!cq->desc_base || !cq->trans_base) {
+		free(cq->desc_base);
+		free(cq->trans_base);
+		return log_msg_ret("cqa", -ENOMEM);
+	}
+	memset(cq->desc_base, '\0', cqhci_desc_len(cq));
+	memset(cq->trans_base, '\0', trans_len);
+
+	/* each task links to its own set of transfer descriptors */
+	for (tag = 0; tag < CQHCI_NUM_SLOTS; tag++) {
+		u32 *link = cqhci_task_desc(cq, tag) + cq->task_desc_len / 4;
+		dma_addr_t addr = (ulong)cqhci_trans_desc(cq, tag);
+
+		cqhci_set_desc(cq, link, CQHCI_VALID | CQHCI_ACT(CQHCI_ACT_LINK),
+			       cqhci_bus_addr(cq, addr));
+	}
+	cqhci_flush(cq->desc_base, cqhci_desc_len(cq));
+	cfg->cqe_b_max = CQHCI_MAX_SEGS * CQHCI_SEG_SIZE / MMC_MAX_BLOCK_LEN;
+
+	return 0;
+}
+
+static int cqhci_halt(struct cqhci_host *cq)
+{
+	u32 ctl;
+
+	cqhci_writel(cq, CQHCI_HALT, CQHCI_CTL);
+
+	return readl_poll_timeout(cq->base + CQHCI_CTL, ctl, ctl & CQHCI_HALT,
+				  CQHCI_HALT_TIMEOUT_US);
+}
+
+int cqhci_enable(struct cqhci_host *cq, bool enable)
+{
+	dma_addr_t addr;
+	u32 cfg;
+	int ret;
+
+	cfg = cqhci_readl(cq, CQHCI_CFG);
+	if (!enable) {
+		if (!(cfg & CQHCI_ENABLE))
+			return 0;
+		ret = cqhci_halt(cq);
+		if (cqhci_readl(cq, CQHCI_TDBR))
+			cqhci_writel(cq, CQHCI_CLEAR_ALL_TASKS | CQHCI_HALT,
+				     CQHCI_CTL);
+		cqhci_writel(cq, cfg & ~CQHCI_ENABLE, CQHCI_CFG);
+		if (ret)
+			return log_msg_ret("cqh", ret);
+
+		return 0;
+	}
+
+	if (cfg & CQHCI_ENABLE)
+		cqhci_writel(cq, cfg & ~CQHCI_ENABLE, CQHCI_CFG);
+	cfg &= ~(CQHCI_DCMD | CQHCI_TASK_DESC_SZ | CQHCI_ENABLE);
+	if (cq->task_desc_128)
+		cfg |= CQHCI_TASK_DESC_SZ;
+	cqhci_writel(cq, cfg, CQHCI_CFG);
+
+	addr = cqhci_bus_addr(cq, (ulong)cq->desc_base);
+	cqhci_writel(cq, lower_32_bits(addr), CQHCI_TDLBA);
+	cqhci_writel(cq, upper_32_bits(addr), CQHCI_TDLBAU);
+	cqhci_writel(cq, cq->mmc->rca, CQHCI_SSC2);
+
+	/* record status but never raise an interrupt */
+	cqhci_writel(cq, CQHCI_IS_MASK, CQHCI_ISTE);
+	cqhci_writel(cq, 0, CQHCI_ISGE);
+	cqhci_writel(cq, CQHCI_IS_MASK, CQHCI_IS);
+	cqhci_writel(cq, cqhci_readl(cq, CQHCI_TCN), CQHCI_TCN);
+
+	cqhci_writel(cq, cfg | CQHCI_ENABLE, CQHCI_CFG);
+	if (cqhci_readl(cq, CQHCI_CTL) & CQHCI_HALT)
+		cqhci_writel(cq, 0, CQHCI_CTL);
+
+	return 0;
+}
+
+int cqhci_request(struct cqhci_host *cq, uint tag, lbaint_t start,
+		  struct mmc_data *data)
+{
+	struct cqhci_slot *slot = &cq->slot[tag];
+	bool read = data->flags & MMC_DATA_READ;
+	u32 *task, *trans;
+	uint len, seg, nsegs;
+	u32 attr;
+	void *buf;
+
+	len = data->blocks * data->blocksize;
+	nsegs = DIV_ROUND_UP(len, CQHCI_SEG_SIZE);
+	if (data->blocks > 0xffff || nsegs > CQHCI_MAX_SEGS)
+		return log_msg_ret("cqb", -E2BIG);
+
+	buf = read ? data->dest : (void *)data->src;
+	slot->addr = dma_map_single(buf, len,
+				    read ? DMA_FROM_DEVICE : DMA_TO_DEVICE);
+	slot->len = len;
+	slot->read = read;
+
+	trans = cqhci_trans_desc(cq, tag);
+	for (seg = 0; seg < nsegs; seg++) {
+		uint seg_len = min_t(uint, len - seg * CQHCI_SEG_SIZE,
+				     CQHCI_SEG_SIZE);
+		dma_addr_t addr = slot->addr + seg * CQHCI_SEG_SIZE;
+
+		attr = CQHCI_VALID | CQHCI_ACT(CQHCI_ACT_TRAN) |
+			CQHCI_DAT_LENGTH(seg_len & 0xffff);
+		if (seg == nsegs - 1)
+			attr |= CQHCI_END;
+		cqhci_set_desc(cq, trans + seg * cq->trans_desc_len / 4, attr,
+			       cqhci_bus_addr(cq, addr));
+	}
+	cqhci_flush(trans, nsegs * cq->trans_desc_len);
+
+	task = cqhci_task_desc(cq, tag);
+	attr = CQHCI_VALID | CQHCI_END | CQHCI_INT |
+		CQHCI_ACT(CQHCI_ACT_TASK) | CQHCI_BLK_COUNT(data->blocks);
+	if (read)
+		attr |= CQHCI_DATA_DIR;
+	task[0] = cpu_to_le32(attr);
+	task[1] = cpu_to_le32(start);
+	cqhci_flush(cq->desc_base, cqhci_desc_len(cq));
+
+	cqhci_writel(cq, BIT(tag), CQHCI_TDBR);
+
+	return 0;
+}
+
+static void cqhci_finish(struct cqhci_host *cq, ulong tags)
+{
+	uint tag;
+
+	for (tag = 0; tag < CQHCI_NUM_SLOTS; tag++) {
+		struct cqhci_slot *slot = &cq->slot[tag];
+
+		if (tags & BIT(tag))
+			dma_unmap_single(slot->addr, slot->len,
+					 slot->read ? DMA_FROM_DEVICE :
+					 DMA_TO_DEVICE);
+	}
+}
+
+int cqhci_poll(struct cqhci_host *cq, ulong *donep, ulong *errp)
+{
+	u32 status, done;
+
+	status = cqhci_readl(cq, CQHCI_IS);
+	cqhci_writel(cq, status, CQHCI_IS);
+	if (status & CQHCI_IS_ERROR) {
+		log_err("Command-queue error %x, task %x\n", status,
+			cqhci_readl(cq, CQHCI_TERRI));
+		return log_msg_ret("cqe", -EIO);
+	}
+
+	done = cqhci_readl(cq, CQHCI_TCN);
+	cqhci_writel(cq, done, CQHCI_TCN);
+	cqhci_finish(cq, done);
+	*donep = done;
+	*errp = 0;
+
+	return 0;
+}
@@ -276,15 +276,17 @@ static int dwmci_send_cmd(struct mmc *mmc, struct mmc_cmd *cmd,
 			dwmci_wait_reset(host, DWMCI_CTRL_FIFO_RESET);
 		} else {
 			if (data->flags == MMC_DATA_READ) {
-				ret = bounce_buffer_start(&bbstate,
+				ret = bounce_buffer_start_align(&bbstate,
 						(void*)data->dest,
 						data->blocksize *
-						data->blocks, GEN_BB_WRITE);
+						data->blocks, GEN_BB_WRITE,
+						DWMCI_IDMAC_ALIGN);
 			} else {
-				ret = bounce_buffer_start(&bbstate,
+				ret = bounce_buffer_start_align(&bbstate,
 						(void*)data->src,
 						data->blocksize *
-						data->blocks, GEN_BB_READ);
+						data->blocks, GEN_BB_READ,
+						DWMCI_IDMAC_ALIGN);
 			}
 
 			if (ret)
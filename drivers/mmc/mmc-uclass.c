@@ -7,6 +7,7 @@
 
 #define LOG_CATEGORY UCLASS_MMC
 
+#include <bloblist.h>
 #include <bootdev.h>
 #include <log.h>
 #include <mmc.h>
@@ -14,6 +15,7 @@
 #include <dm/device-internal.h>
 #include <dm/device_compat.h>
 #include <dm/lists.h>
+#include <asm/cache.h>
 #include <linux/compat.h>
 #include "mmc_private.h"
 
@@ -40,6 +42,11 @@ static int dm_mmc_send_cmd(struct udevice *dev, struct mmc_cmd *cmd,
 	struct dm_mmc_ops *ops = mmc_get_ops(dev);
 	int ret;
 
+	/* normal commands cannot be sent while tasks are queued */
+	ret = mmc_cqe_off(mmc);
+	if (ret)
+		return ret;
+
 	mmmc_trace_before_send(mmc, cmd);
 	if (ops->send_cmd)
 		ret = ops->send_cmd(dev, cmd, data);
@@ -121,12 +128,112 @@ static int dm_mmc_execute_tuning(struct udevice *dev, uint opcode)
 	return ops->execute_tuning(dev, opcode);
 }
 
+#if CONFIG_IS_ENABLED(MMC_TUNING_CACHE)
+/* Number of tuning blocks which must be read to accept a recorded result */
+#define MMC_TUNING_CHECKS	4
+
+static bool mmc_tuning_match(struct mmc *mmc, uint opcode,
+			     const struct mmc_tuning_rec *rec)
+{
+	return rec->opcode == opcode && rec->mode == mmc->selected_mode &&
+		rec->seq == (u8)dev_seq(mmc->dev) &&
+		!memcmp(rec->cid, mmc->cid, sizeof(rec->cid));
+}
+
+/* find the record for a card, or with @add, one that can be used for it */
+static struct mmc_tuning_rec *mmc_tuning_find(struct mmc *mmc, uint opcode,
+					      bool add)
+{
+	struct mmc_tuning_rec *rec, *unused = NULL;
+	struct mmc_tuning_handoff *ho;
+	int i;
+
+	if (add)
+		ho = bloblist_ensure(BLOBLISTT_U_BOOT_MMC_TUNING, sizeof(*ho));
+	else
+		ho = bloblist_find(BLOBLISTT_U_BOOT_MMC_TUNING, sizeof(*ho));
+	if (!ho)
+		return NULL;
+	for (i = 0; i < MMC_TUNING_RECS; i++) {
+		rec = &ho->rec[i];
+		if (mmc_tuning_match(mmc, opcode, rec))
+			return rec;
+		if (!rec->opcode && !unused)
+			unused = rec;
+	}
+	if (!add)
+		return NULL;
+
+	return unused ? unused : &ho->rec[MMC_TUNING_RECS - 1];
+}
+
+/* apply the recorded tuning result for a card, if it still works */
+static int mmc_tuning_restore(struct mmc *mmc, uint opcode)
+{
+	struct dm_mmc_ops *ops = mmc_get_ops(mmc->dev);
+	struct mmc_tuning_rec *rec;
+	int ret, i;
+
+	if (!ops->get_tuning || !ops->set_tuning)
+		return -ENOSYS;
+	rec = mmc_tuning_find(mmc, opcode, false);
+	if (!rec)
+		return -ENOENT;
+	ret = ops->set_tuning(mmc->dev, rec->val);
+	if (ret)
+		return log_msg_ret("tus", ret);
+	for (i = 0; i < MMC_TUNING_CHECKS; i++) {
+		ret = mmc_send_tuning(mmc, opcode);
+		if (ret) {
+			log_debug("%s: Recorded tuning failed (err=%d)\n",
+				  mmc->dev->name, ret);
+			return log_msg_ret("tuc", ret);
+		}
+	}
+
+	return 0;
+}
+
+static void mmc_tuning_save(struct mmc *mmc, uint opcode)
+{
+	struct dm_mmc_ops *ops = mmc_get_ops(mmc->dev);
+	struct mmc_tuning_rec *rec;
+	u32 val;
+
+	if (!ops->get_tuning || ops->get_tuning(mmc->dev, &val))
+		return;
+	rec = mmc_tuning_find(mmc, opcode, true);
+	if (!rec)
+		return;
+	memcpy(rec->cid, mmc->cid, sizeof(rec->cid));
+	rec->seq = dev_seq(mmc->dev);
+	rec->opcode = opcode;
+	rec->mode = mmc->selected_mode;
+	rec->reserved = 0;
+	rec->val = val;
+}
+#else
+static int mmc_tuning_restore(struct mmc *mmc, uint opcode)
+{
+	return -ENOSYS;
+}
+
+static void mmc_tuning_save(struct mmc *mmc, uint opcode)
+{
+}
+#endif
+
 int mmc_execute_tuning(struct mmc *mmc, uint opcode)
 {
 	int ret;
 
 	mmc->tuning = true;
-	ret = dm_mmc_execute_tuning(mmc->dev, opcode);
+	ret = mmc_tuning_restore(mmc, opcode);
+	if (ret) {
+		ret = dm_mmc_execute_tuning(mmc->dev, opcode);
+		if (!ret)
+			mmc_tuning_save(mmc, opcode);
+	}
 	mmc->tuning = false;
 
 	return ret;
@@ -150,6 +257,23 @@ int mmc_set_enhanced_strobe(struct mmc *mmc)
 }
 #endif
 
+#if CONFIG_IS_ENABLED(MMC_SD_EXPRESS)
+static int dm_mmc_init_sd_express(struct udevice *dev)
+{
+	struct dm_mmc_ops *ops = mmc_get_ops(dev);
+
+	if (ops->init_sd_express)
+		return ops->init_sd_express(dev);
+
+	return -ENOSYS;
+}
+
+int mmc_init_sd_express(struct mmc *mmc)
+{
+	return dm_mmc_init_sd_express(mmc->dev);
+}
+#endif
+
 static int dm_mmc_hs400_prepare_ddr(struct udevice *dev)
 {
 	struct dm_mmc_ops *ops = mmc_get_ops(dev);
@@ -368,9 +492,12 @@ void mmc_do_preinit(void)
 
 		m->user_speed_mode = MMC_MODES_END;  /* Initialising user set speed mode */
 
-		if (m->preinit)
+		if (m->preinit && !CONFIG_IS_ENABLED(MMC_PARALLEL_INIT))
 			mmc_start_init(m);
 	}
+
+	/* this covers the preinit devices too */
+	mmc_start_init_all();
 }
 
 #if !defined(CONFIG_SPL_BUILD) || defined(CONFIG_SPL_LIBCOMMON_SUPPORT)
@@ -519,13 +646,43 @@ static int mmc_blk_remove(struct udevice *dev)
 	return mmc_deinit(mmc);
 }
 
+#if CONFIG_IS_ENABLED(MMC_CQE)
+static int mmc_blk_submit_read(struct udevice *dev, struct blk_req *req)
+{
+	struct mmc *mmc = mmc_get_mmc_dev(dev_get_parent(dev));
+	struct blk_desc *desc = dev_get_uclass_plat(dev);
+
+	/* anything which cannot be queued is read straight away */
+	if (!mmc->cqe_depth || req->blkcnt > mmc->cfg->cqe_b_max ||
+	    (ulong)req->buffer & (ARCH_DMA_MINALIGN - 1) ||
+	    req->start + req->blkcnt > desc->lba) {
+		blk_req_complete(dev, req, mmc_bread(dev, req->start,
+						     req->blkcnt,
+						     req->buffer));
+		return 0;
+	}
+
+	return mmc_cqe_submit(mmc, req);
+}
+
+static int mmc_blk_poll(struct udevice *dev)
+{
+	return mmc_cqe_poll(mmc_get_mmc_dev(dev_get_parent(dev)));
+}
+#endif
+
 static const struct blk_ops mmc_blk_ops = {
 	.read	= mmc_bread,
 #if CONFIG_IS_ENABLED(MMC_WRITE)
 	.write	= mmc_bwrite,
 	.erase	= mmc_berase,
+	.discard	= mmc_bdiscard,
 #endif
 	.select_hwpart	= mmc_select_hwpart,
+#if CONFIG_IS_ENABLED(MMC_CQE)
+	.submit_read	= mmc_blk_submit_read,
+	.poll		= mmc_blk_poll,
+#endif
 };
 
 U_BOOT_DRIVER(mmc_blk) = {
@@ -539,9 +696,24 @@ U_BOOT_DRIVER(mmc_blk) = {
 #endif /* CONFIG_BLK */
 
 
+#if CONFIG_IS_ENABLED(MMC_PARALLEL_INIT)
+static int mmc_pre_remove(struct udevice *dev)
+{
+	struct mmc *mmc = mmc_get_mmc_dev(dev);
+
+	if (mmc)
+		mmc_stop_bg_init(mmc);
+
+	return 0;
+}
+#endif
+
 UCLASS_DRIVER(mmc) = {
 	.id		= UCLASS_MMC,
 	.name		= "mmc",
 	.flags		= DM_UC_FLAG_SEQ_ALIAS,
+#if CONFIG_IS_ENABLED(MMC_PARALLEL_INIT)
+	.pre_remove	= mmc_pre_remove,
+#endif
 	.per_device_auto	= sizeof(struct mmc_uclass_priv),
 };
@@ -10,6 +10,7 @@
 #include <config.h>
 #include <blk.h>
 #include <command.h>
+#include <cyclic.h>
 #include <dm.h>
 #include <log.h>
 #include <dm/device-internal.h>
@@ -420,11 +421,32 @@ int mmc_send_stop_transmission(struct mmc *mmc, bool write)
 	return mmc_send_cmd(mmc, &cmd, NULL);
 }
 
+bool mmc_set_block_count(struct mmc *mmc, lbaint_t blkcnt)
+{
+	struct mmc_cmd cmd;
+
+	if (!IS_ENABLED(CONFIG_MMC_SET_BLOCK_COUNT) || blkcnt < 2 ||
+	    blkcnt > 0xffff || mmc_host_is_spi(mmc))
+		return false;
+
+	/* CMD23 is optional for SD cards, but mandatory since MMC v3.1 */
+	if (IS_SD(mmc) ? !(mmc->scr[0] & SD_SCR_CMD23) :
+	    mmc->version < MMC_VERSION_3)
+		return false;
+
+	cmd.cmdidx = MMC_CMD_SET_BLOCK_COUNT;
+	cmd.cmdarg = blkcnt;
+	cmd.resp_type = MMC_RSP_R1;
+
+	return !mmc_send_cmd(mmc, &cmd, NULL);
+}
+
 static int mmc_read_blocks(struct mmc *mmc, void *dst, lbaint_t start,
 			   lbaint_t blkcnt)
 {
 	struct mmc_cmd cmd;
 	struct mmc_data data;
+	bool predef;
 
 	if (blkcnt > 1)
 		cmd.cmdidx = MMC_CMD_READ_MULTIPLE_BLOCK;
@@ -443,10 +465,14 @@ static int mmc_read_blocks(struct mmc *mmc, void *dst, lbaint_t start,
 	data.blocksize = mmc->read_bl_len;
 	data.flags = MMC_DATA_READ;
 
-	if (mmc_send_cmd(mmc, &cmd, &data))
+	predef = mmc_set_block_count(mmc, blkcnt);
+	if (mmc_send_cmd(mmc, &cmd, &data)) {
+		if (predef)
+			mmc_send_stop_transmission(mmc, false);
 		return 0;
+	}
 
-	if (blkcnt > 1) {
+	if (blkcnt > 1 && !predef) {
 		if (mmc_send_stop_transmission(mmc, false)) {
 #if !defined(CONFIG_SPL_BUILD) || defined(CONFIG_SPL_LIBCOMMON_SUPPORT)
 			pr_err("mmc fail to send stop cmd\n");
@@ -506,6 +532,9 @@ ulong mmc_bread(struct blk_desc *block_dev, lbaint_t start, lbaint_t blkcnt,
 		return 0;
 	}
 
+	if (mmc_cqe_can_read(mmc, blkcnt, dst))
+		return mmc_cqe_bread(mmc, start, blkcnt, dst);
+
 	if (mmc_set_blocklen(mmc, mmc->read_bl_len)) {
 		pr_debug("%s: Failed to set blocklen\n", __func__);
 		return 0;
@@ -610,54 +639,55 @@ static int mmc_switch_voltage(struct mmc *mmc, int signal_voltage)
 }
 #endif
 
-static int sd_send_op_cond(struct mmc *mmc, bool uhs_en)
+/* send ACMD41 once, returning -EBUSY while the card is still powering up */
+static int sd_send_op_cond_iter(struct mmc *mmc, bool uhs_en)
 {
-	int timeout = 1000;
-	int err;
 	struct mmc_cmd cmd;
+	int err;
 
-	while (1) {
-		cmd.cmdidx = MMC_CMD_APP_CMD;
-		cmd.resp_type = MMC_RSP_R1;
-		cmd.cmdarg = 0;
+	cmd.cmdidx = MMC_CMD_APP_CMD;
+	cmd.resp_type = MMC_RSP_R1;
+	cmd.cmdarg = 0;
 
-		err = mmc_send_cmd(mmc, &cmd, NULL);
+	err = mmc_send_cmd(mmc, &cmd, NULL);
 
-		if (err)
-			return err;
+	if (err)
+		return err;
 
-		cmd.cmdidx = SD_CMD_APP_SEND_OP_COND;
-		cmd.resp_type = MMC_RSP_R3;
+	cmd.cmdidx = SD_CMD_APP_SEND_OP_COND;
+	cmd.resp_type = MMC_RSP_R3;
 
-		/*
-		 * Most cards do not answer if some reserved bits
-		 * in the ocr are set. However, Some controller
-		 * can set bit 7 (reserved for low voltages), but
-		 * how to manage low voltages SD card is not yet
-		 * specified.
-		 */
-		cmd.cmdarg = mmc_host_is_spi(mmc) ? 0 :
-			(mmc->cfg->voltages & 0xff8000);
+	/*
+	 * Most cards do not answer if some reserved bits
+	 * in the ocr are set. However, Some controller
+	 * can set bit 7 (reserved for low voltages), but
+	 * how to manage low voltages SD card is not yet
+	 * specified.
+	 */
+	cmd.cmdarg = mmc_host_is_spi(mmc) ? 0 :
+		(mmc->cfg->voltages & 0xff8000);
 
-		if (mmc->version == SD_VERSION_2)
-			cmd.cmdarg |= OCR_HCS;
+	if (mmc->version == SD_VERSION_2)
+		cmd.cmdarg |= OCR_HCS;
 
-		if (uhs_en)
-			cmd.cmdarg |= OCR_S18R;
+	if (uhs_en)
+		cmd.cmdarg |= OCR_S18R;
 
-		err = mmc_send_cmd(mmc, &cmd, NULL);
+	err = mmc_send_cmd(mmc, &cmd, NULL);
 
-		if (err)
-			return err;
+	if (err)
+		return err;
 
-		if (cmd.response[0] & OCR_BUSY)
-			break;
+	mmc->ocr = cmd.response[0];
 
-		if (timeout-- <= 0)
-			return -EOPNOTSUPP;
+	return mmc->ocr & OCR_BUSY ? 0 : -EBUSY;
+}
 
-		udelay(1000);
-	}
+/* finish setting up an SD card once it has powered up */
+static int sd_complete_op_cond(struct mmc *mmc, bool uhs_en)
+{
+	struct mmc_cmd cmd;
+	int err;
 
 	if (mmc->version != SD_VERSION_2)
 		mmc->version = SD_VERSION_1_0;
@@ -671,12 +701,12 @@ static int sd_send_op_cond(struct mmc *mmc, bool uhs_en)
 
 		if (err)
 			return err;
-	}
 
-	mmc->ocr = cmd.response[0];
+		mmc->ocr = cmd.response[0];
+	}
 
 #if CONFIG_IS_ENABLED(MMC_UHS_SUPPORT)
-	if (uhs_en && !(mmc_host_is_spi(mmc)) && (cmd.response[0] & 0x41000000)
+	if (uhs_en && !(mmc_host_is_spi(mmc)) && (mmc->ocr & 0x41000000)
 	    == 0x41000000) {
 		err = mmc_switch_voltage(mmc, MMC_SIGNAL_VOLTAGE_180);
 		if (err)
@@ -690,6 +720,39 @@ static int sd_send_op_cond(struct mmc *mmc, bool uhs_en)
 	return 0;
 }
 
+/*
+ * Power up an SD card. With @bg this returns as soon as the card has been
+ * told to power up, leaving the rest to mmc_complete_bg_op_cond()
+ */
+static int sd_send_op_cond(struct mmc *mmc, bool uhs_en, bool bg)
+{
+	int timeout = 1000;
+	int err;
+
+	while (1) {
+		err = sd_send_op_cond_iter(mmc, uhs_en);
+		if (err != -EBUSY)
+			break;
+
+		if (bg) {
+			mmc->op_cond_uhs = uhs_en;
+			mmc->op_cond_busy = 1;
+			mmc->op_cond_bg = 1;
+			mmc->op_cond_start = get_timer(0);
+			return 0;
+		}
+
+		if (timeout-- <= 0)
+			return -EOPNOTSUPP;
+
+		udelay(1000);
+	}
+	if (err)
+		return err;
+
+	return sd_complete_op_cond(mmc, uhs_en);
+}
+
 static int mmc_send_op_cond_iter(struct mmc *mmc, int use_arg)
 {
 	struct mmc_cmd cmd;
@@ -711,7 +774,11 @@ static int mmc_send_op_cond_iter(struct mmc *mmc, int use_arg)
 	return 0;
 }
 
-static int mmc_send_op_cond(struct mmc *mmc)
+/*
+ * Power up an MMC card. With @bg this returns as soon as the card has been
+ * told to power up, leaving the rest to mmc_complete_bg_op_cond()
+ */
+static int mmc_send_op_cond(struct mmc *mmc, bool bg)
 {
 	int err, i;
 	int timeout = 1000;
@@ -731,6 +798,13 @@ static int mmc_send_op_cond(struct mmc *mmc)
 		if (mmc->ocr & OCR_BUSY)
 			break;
 
+		if (bg && i) {
+			mmc->op_cond_busy = 1;
+			mmc->op_cond_bg = 1;
+			mmc->op_cond_start = start;
+			break;
+		}
+
 		if (get_timer(start) > timeout)
 			return -ETIMEDOUT;
 		udelay(100);
@@ -2330,6 +2404,7 @@ static int mmc_startup_v4(struct mmc *mmc)
 		return -EINVAL;
 
 	mmc->version = mmc_versions[ext_csd[EXT_CSD_REV]];
+	mmc_cqe_init(mmc, ext_csd);
 
 	if (mmc->version >= MMC_VERSION_4_2) {
 		/*
@@ -2690,6 +2765,12 @@ static int mmc_startup(struct mmc *mmc)
 	bdesc->blksz = mmc->read_bl_len;
 	bdesc->log2blksz = LOG2(bdesc->blksz);
 	bdesc->lba = lldiv(mmc->capacity, mmc->read_bl_len);
+#if CONFIG_IS_ENABLED(MMC_WRITE)
+	bdesc->write_align = mmc->erase_grp_size;
+	/* SD cards erase single blocks, eMMC needs trim to do so */
+	bdesc->discard_align = IS_SD(mmc) || mmc->can_trim ? 1 :
+		mmc->erase_grp_size;
+#endif
 #if !defined(CONFIG_SPL_BUILD) || \
 		(defined(CONFIG_SPL_LIBCOMMON_SUPPORT) && \
 		!CONFIG_IS_ENABLED(USE_TINY_PRINTF))
@@ -2715,14 +2796,29 @@ static int mmc_startup(struct mmc *mmc)
 	return 0;
 }
 
+/**
+ * mmc_send_if_cond() - Check for an SD v2 card
+ *
+ * @mmc: MMC device
+ * Return: 0 if OK, 1 if the card is SD Express and its PCIe interface can be
+ *	used, -ve on error
+ */
 static int mmc_send_if_cond(struct mmc *mmc)
 {
+	bool sd_express = false;
 	struct mmc_cmd cmd;
 	int err;
 
+	/* Only offer PCIe if the host can move the card over to it */
+	if (CONFIG_IS_ENABLED(MMC_SD_EXPRESS) &&
+	    (mmc->host_caps & MMC_CAP_SD_EXPRESS))
+		sd_express = true;
+
 	cmd.cmdidx = SD_CMD_SEND_IF_COND;
 	/* We set the bit if the host supports voltages between 2.7 and 3.6 V */
 	cmd.cmdarg = ((mmc->cfg->voltages & 0xff8000) != 0) << 8 | 0xaa;
+	if (sd_express)
+		cmd.cmdarg |= SD_IF_COND_PCIE;
 	cmd.resp_type = MMC_RSP_R7;
 
 	err = mmc_send_cmd(mmc, &cmd, NULL);
@@ -2735,8 +2831,37 @@ static int mmc_send_if_cond(struct mmc *mmc)
 	else
 		mmc->version = SD_VERSION_2;
 
+	return sd_express && (cmd.response[0] & SD_IF_COND_PCIE);
+}
+
+#if CONFIG_IS_ENABLED(MMC_SD_EXPRESS)
+/**
+ * mmc_switch_sd_express() - Hand an SD Express card over to PCIe
+ *
+ * @mmc: MMC device
+ * Return: 0 if the card is now on PCIe, -ve if it should be used as an SD
+ *	card
+ */
+static int mmc_switch_sd_express(struct mmc *mmc)
+{
+	int ret;
+
+	ret = mmc_init_sd_express(mmc);
+	if (ret) {
+		log_debug("Cannot switch to PCIe (err=%d), using SD\n", ret);
+		return ret;
+	}
+	printf("%s: SD Express card switched to PCIe, use NVMe to access it\n",
+	       mmc->cfg->name);
+
 	return 0;
 }
+#else
+static int mmc_switch_sd_express(struct mmc *mmc)
+{
+	return -ENOSYS;
+}
+#endif
 
 #if !CONFIG_IS_ENABLED(DM_MMC)
 /* board-specific MMC power initializations. */
@@ -2845,7 +2970,8 @@ static int mmc_power_cycle(struct mmc *mmc)
 	return mmc_power_on(mmc);
 }
 
-int mmc_get_op_cond(struct mmc *mmc, bool quiet)
+/* @bg: leave the card powering up, as with sd/mmc_send_op_cond() */
+static int __mmc_get_op_cond(struct mmc *mmc, bool quiet, bool bg)
 {
 	bool uhs_en = supports_uhs(mmc->cfg->host_caps);
 	int err;
@@ -2853,6 +2979,10 @@ int mmc_get_op_cond(struct mmc *mmc, bool quiet)
 	if (mmc->has_init)
 		return 0;
 
+	mmc->op_cond_pending = 0;
+	mmc->op_cond_bg = 0;
+	mmc->op_cond_busy = 0;
+
 	err = mmc_power_init(mmc);
 	if (err)
 		return err;
@@ -2906,9 +3036,19 @@ retry:
 
 	/* Test for SD version 2 */
 	err = mmc_send_if_cond(mmc);
+	if (err == 1) {
+		/* The card is no longer on the SD bus once this succeeds */
+		if (!mmc_switch_sd_express(mmc))
+			return -ENODEV;
+
+		/* Start again so the card does not expect PCIe */
+		mmc->host_caps &= ~MMC_CAP_SD_EXPRESS;
+		mmc_power_cycle(mmc);
+		goto retry;
+	}
 
 	/* Now try to get the SD card's operating condition */
-	err = sd_send_op_cond(mmc, uhs_en);
+	err = sd_send_op_cond(mmc, uhs_en, bg);
 	if (err && uhs_en) {
 		uhs_en = false;
 		mmc_power_cycle(mmc);
@@ -2917,7 +3057,7 @@ retry:
 
 	/* If the command timed out, we check for an MMC card */
 	if (err == -ETIMEDOUT) {
-		err = mmc_send_op_cond(mmc);
+		err = mmc_send_op_cond(mmc, bg);
 
 		if (err) {
 #if !defined(CONFIG_SPL_BUILD) || defined(CONFIG_SPL_LIBCOMMON_SUPPORT)
@@ -2931,7 +3071,70 @@ retry:
 	return err;
 }
 
-int mmc_start_init(struct mmc *mmc)
+int mmc_get_op_cond(struct mmc *mmc, bool quiet)
+{
+	return __mmc_get_op_cond(mmc, quiet, false);
+}
+
+/* send one power-up poll, returning -EBUSY if the card is still busy */
+static int mmc_poll_op_cond(struct mmc *mmc)
+{
+	int err;
+
+	mmc->op_cond_polling = 1;
+	if (mmc->op_cond_pending) {
+		err = mmc_send_op_cond_iter(mmc, 1);
+		if (!err && !(mmc->ocr & OCR_BUSY))
+			err = -EBUSY;
+	} else {
+		err = sd_send_op_cond_iter(mmc, mmc->op_cond_uhs);
+	}
+	mmc->op_cond_polling = 0;
+
+	if (err == -EBUSY && get_timer(mmc->op_cond_start) < 1000)
+		return -EBUSY;
+
+	/* mmc_complete_bg_op_cond() checks the OCR to see how this went */
+	mmc->op_cond_busy = 0;
+
+	return err;
+}
+
+void mmc_stop_bg_init(struct mmc *mmc)
+{
+	/* the cyclic function cannot remove itself, so it is done here */
+	if (mmc->op_cond_cyclic) {
+		cyclic_unregister(mmc->op_cond_cyclic);
+		mmc->op_cond_cyclic = NULL;
+	}
+	mmc->op_cond_busy = 0;
+}
+
+/* wait for a card powering up in the background to finish */
+static int mmc_complete_bg_op_cond(struct mmc *mmc)
+{
+	int err;
+
+	mmc->op_cond_bg = 0;
+	while (mmc->op_cond_busy) {
+		if (mmc_poll_op_cond(mmc) == -EBUSY)
+			udelay(100);
+	}
+	mmc_stop_bg_init(mmc);
+
+	if (mmc->ocr & OCR_BUSY) {
+		if (mmc->op_cond_pending)
+			return 0;
+		err = sd_complete_op_cond(mmc, mmc->op_cond_uhs);
+		if (!err)
+			return 0;
+	}
+
+	/* try again, waiting this time so that any fallbacks are used */
+	return __mmc_get_op_cond(mmc, false, false);
+}
+
+static int __mmc_start_init(struct mmc *mmc, bool bg)
 {
 	bool no_card;
 	int err = 0;
@@ -2975,12 +3178,13 @@ int mmc_start_init(struct mmc *mmc)
 	if (no_card) {
 		mmc->has_init = 0;
 #if !defined(CONFIG_SPL_BUILD) || defined(CONFIG_SPL_LIBCOMMON_SUPPORT)
-		pr_err("MMC: no card present\n");
+		if (!bg)
+			pr_err("MMC: no card present\n");
 #endif
 		return -ENOMEDIUM;
 	}
 
-	err = mmc_get_op_cond(mmc, false);
+	err = __mmc_get_op_cond(mmc, bg, bg);
 
 	if (!err)
 		mmc->init_in_progress = 1;
@@ -2988,12 +3192,62 @@ int mmc_start_init(struct mmc *mmc)
 	return err;
 }
 
+int mmc_start_init(struct mmc *mmc)
+{
+	return __mmc_start_init(mmc, false);
+}
+
+#if CONFIG_IS_ENABLED(MMC_PARALLEL_INIT)
+static void mmc_op_cond_cyclic(void *ctx)
+{
+	struct mmc *mmc = ctx;
+
+	/* skip the card if this is called while it is being polled */
+	if (mmc->op_cond_busy && !mmc->op_cond_polling)
+		mmc_poll_op_cond(mmc);
+}
+
+int mmc_start_init_all(void)
+{
+	struct udevice *dev;
+	struct uclass *uc;
+	int count = 0;
+	int ret;
+
+	if (uclass_get(UCLASS_MMC, &uc))
+		return 0;
+	uclass_foreach_dev(dev, uc) {
+		struct mmc *m;
+
+		if (!device_active(dev))
+			continue;
+		m = mmc_get_mmc_dev(dev);
+		if (!m || m->has_init || m->init_in_progress)
+			continue;
+		ret = __mmc_start_init(m, true);
+		if (ret) {
+			log_debug("%s: power-up failed: %d\n", dev->name, ret);
+			continue;
+		}
+		if (!m->op_cond_busy)
+			continue;
+		m->op_cond_cyclic = cyclic_register(mmc_op_cond_cyclic, 1000,
+						    dev->name, m);
+		count++;
+	}
+
+	return count;
+}
+#endif
+
 static int mmc_complete_init(struct mmc *mmc)
 {
 	int err = 0;
 
 	mmc->init_in_progress = 0;
-	if (mmc->op_cond_pending)
+	if (CONFIG_IS_ENABLED(MMC_PARALLEL_INIT) && mmc->op_cond_bg)
+		err = mmc_complete_bg_op_cond(mmc);
+	if (!err && mmc->op_cond_pending)
 		err = mmc_complete_op_cond(mmc);
 
 	if (!err)
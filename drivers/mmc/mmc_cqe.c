@@ -0,0 +1,259 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * eMMC command queueing
+ *
+ * With command queueing enabled the card accepts up to 32 data transfers
+ * (tasks) at once, which the host's command-queue engine issues and tracks.
+ * Normal commands cannot be sent while it is enabled, so it is switched on
+ * when tasks are queued and off again before any other command is sent.
+ */
+
+#define LOG_CATEGORY UCLASS_MMC
+
+#include <blk.h>
+#include <cyclic.h>
+#include <dm.h>
+#include <log.h>
+#include <mmc.h>
+#include <time.h>
+#include <asm/cache.h>
+#include <linux/bitops.h>
+#include "mmc_private.h"
+
+/* Time allowed without any task finishing before giving up */
+#define CQE_TIMEOUT_MS		2000
+
+/* Number of tasks which mmc_cqe_bread() keeps in flight */
+#define CQE_BREAD_TASKS		8
+
+void mmc_cqe_init(struct mmc *mmc, const u8 *ext_csd)
+{
+	const struct dm_mmc_ops *ops = mmc_get_ops(mmc->dev);
+	struct blk_desc *desc = mmc_get_blk_desc(mmc);
+
+	mmc->cqe_on = false;
+	mmc->cqe_busy = 0;
+	mmc->cqe_local = 0;
+	mmc->cqe_depth = 0;
+	if (mmc->version >= MMC_VERSION_5_1 && mmc->high_capacity &&
+	    (ext_csd[EXT_CSD_CMDQ_SUPPORT] & 1) && mmc->cfg->cqe_b_max &&
+	    ops->cqe_enable && ops->cqe_request && ops->cqe_poll)
+		mmc->cqe_depth = min((ext_csd[EXT_CSD_CMDQ_DEPTH] & 0x1f) + 1,
+				     MMC_CQE_MAX_TASKS);
+	if (desc)
+		desc->queue_depth = mmc->cqe_depth;
+}
+
+static void cqe_complete(struct mmc *mmc, uint tag, long result)
+{
+	struct blk_req *req = mmc->cqe_req[tag];
+
+	mmc->cqe_busy &= ~BIT(tag);
+	mmc->cqe_req[tag] = NULL;
+	if (mmc->cqe_local & BIT(tag)) {
+		mmc->cqe_local &= ~BIT(tag);
+		req->result = result;
+		req->done = true;
+	} else {
+		blk_req_complete(mmc_get_blk_desc(mmc)->bdev, req, result);
+	}
+}
+
+static void cqe_fail_all(struct mmc *mmc, long result)
+{
+	uint tag;
+
+	for (tag = 0; tag < MMC_CQE_MAX_TASKS; tag++) {
+		if (mmc->cqe_busy & BIT(tag))
+			cqe_complete(mmc, tag, result);
+	}
+}
+
+static int cqe_on(struct mmc *mmc)
+{
+	const struct dm_mmc_ops *ops = mmc_get_ops(mmc->dev);
+	int ret;
+
+	if (mmc->cqe_on)
+		return 0;
+	ret = mmc_switch(mmc, EXT_CSD_CMD_SET_NORMAL, EXT_CSD_CMDQ_MODE_EN, 1);
+	if (ret)
+		return log_msg_ret("cqs", ret);
+	ret = ops->cqe_enable(mmc->dev, true);
+	if (ret) {
+		mmc_switch(mmc, EXT_CSD_CMD_SET_NORMAL, EXT_CSD_CMDQ_MODE_EN, 0);
+		return log_msg_ret("cqe", ret);
+	}
+	mmc->cqe_on = true;
+
+	return 0;
+}
+
+int mmc_cqe_off(struct mmc *mmc)
+{
+	const struct dm_mmc_ops *ops;
+	ulong start;
+	int ret;
+
+	if (!mmc->cqe_on)
+		return 0;
+	ops = mmc_get_ops(mmc->dev);
+	start = get_timer(0);
+	while (mmc->cqe_busy && get_timer(start) < CQE_TIMEOUT_MS) {
+		mmc_cqe_poll(mmc);
+		schedule();
+	}
+	if (!mmc->cqe_on)
+		return 0;
+
+	/* normal commands are sent from now on, so stop the engine first */
+	mmc->cqe_on = false;
+	ret = ops->cqe_enable(mmc->dev, false);
+	cqe_fail_all(mmc, -ETIMEDOUT);
+	if (ret)
+		return log_msg_ret("cqd", ret);
+	ret = mmc_switch(mmc, EXT_CSD_CMD_SET_NORMAL, EXT_CSD_CMDQ_MODE_EN, 0);
+	if (ret)
+		return log_msg_ret("cqm", ret);
+
+	return 0;
+}
+
+static int cqe_queue(struct mmc *mmc, struct blk_req *req, bool local)
+{
+	const struct dm_mmc_ops *ops = mmc_get_ops(mmc->dev);
+	struct mmc_data data;
+	uint tag;
+	int ret;
+
+	ret = cqe_on(mmc);
+	if (ret)
+		return ret;
+	for (tag = 0; tag < mmc->cqe_depth; tag++) {
+		if (!(mmc->cqe_busy & BIT(tag)))
+			break;
+	}
+	if (tag == mmc->cqe_depth)
+		return -EBUSY;
+
+	data.dest = req->buffer;
+	data.blocks = req->blkcnt;
+	data.blocksize = mmc->read_bl_len;
+	data.flags = MMC_DATA_READ;
+	ret = ops->cqe_request(mmc->dev, tag, req->start, &data);
+	if (ret)
+		return log_msg_ret("cqr", ret);
+	mmc->cqe_busy |= BIT(tag);
+	if (local)
+		mmc->cqe_local |= BIT(tag);
+	mmc->cqe_req[tag] = req;
+
+	return 0;
+}
+
+int mmc_cqe_submit(struct mmc *mmc, struct blk_req *req)
+{
+	return cqe_queue(mmc, req, false);
+}
+
+int mmc_cqe_poll(struct mmc *mmc)
+{
+	const struct dm_mmc_ops *ops = mmc_get_ops(mmc->dev);
+	ulong done, err;
+	uint tag;
+	int ret;
+
+	if (!mmc->cqe_busy)
+		return 0;
+	ret = ops->cqe_poll(mmc->dev, &done, &err);
+	if (ret) {
+		/* the engine has stopped, so everything it had is lost */
+		cqe_fail_all(mmc, -EIO);
+		mmc_cqe_off(mmc);
+		return log_msg_ret("cqp", ret);
+	}
+	for (tag = 0; tag < MMC_CQE_MAX_TASKS; tag++) {
+		if (!(mmc->cqe_busy & BIT(tag)))
+			continue;
+		if (err & BIT(tag))
+			cqe_complete(mmc, tag, -EIO);
+		else if (done & BIT(tag))
+			cqe_complete(mmc, tag, mmc->cqe_req[tag]->blkcnt);
+	}
+
+	return 0;
+}
+
+bool mmc_cqe_can_read(struct mmc *mmc, lbaint_t blkcnt, const void *buf)
+{
+	if (!mmc->cqe_depth || (ulong)buf & (ARCH_DMA_MINALIGN - 1))
+		return false;
+
+	/*
+	 * Leaving and entering command-queue mode costs two commands, so
+	 * only do that for reads which can use several tasks
+	 */
+	return mmc->cqe_on || blkcnt > mmc->cfg->cqe_b_max;
+}
+
+ulong mmc_cqe_bread(struct mmc *mmc, lbaint_t start, lbaint_t blkcnt,
+		    void *dst)
+{
+	struct blk_req reqs[CQE_BREAD_TASKS];
+	bool busy[CQE_BREAD_TASKS] = { };
+	uint depth = min(mmc->cqe_depth, (uint)CQE_BREAD_TASKS);
+	lbaint_t todo = blkcnt;
+	bool failed = false;
+	uint i, inflight;
+	ulong last;
+	int ret;
+
+	last = get_timer(0);
+	do {
+		inflight = 0;
+		for (i = 0; i < depth; i++) {
+			struct blk_req *req = &reqs[i];
+
+			if (busy[i]) {
+				if (!req->done) {
+					inflight++;
+					continue;
+				}
+				busy[i] = false;
+				last = get_timer(0);
+				if (req->result != req->blkcnt)
+					failed = true;
+			}
+			if (!todo || failed)
+				continue;
+
+			req->start = start;
+			req->blkcnt = min(todo, (lbaint_t)mmc->cfg->cqe_b_max);
+			req->buffer = dst;
+			req->done = false;
+			ret = cqe_queue(mmc, req, true);
+			if (ret == -EBUSY)
+				continue;
+			if (ret) {
+				failed = true;
+				continue;
+			}
+			busy[i] = true;
+			inflight++;
+			start += req->blkcnt;
+			dst += req->blkcnt * mmc->read_bl_len;
+			todo -= req->blkcnt;
+		}
+		if (get_timer(last) > CQE_TIMEOUT_MS) {
+			log_err("Command-queue read timed out\n");
+			mmc_cqe_off(mmc);
+			failed = true;
+		}
+		if (inflight || (todo && !failed)) {
+			mmc_cqe_poll(mmc);
+			schedule();
+		}
+	} while (inflight || (todo && !failed));
+
+	return failed ? 0 : blkcnt;
+}
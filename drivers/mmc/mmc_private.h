@@ -17,6 +17,20 @@ int mmc_poll_for_busy(struct mmc *mmc, int timeout);
 
 int mmc_set_blocklen(struct mmc *mmc, int len);
 
+/**
+ * mmc_set_block_count() - Tell the card the length of the next transfer
+ *
+ * If the card supports SET_BLOCK_COUNT (and CONFIG_MMC_SET_BLOCK_COUNT is
+ * enabled), this sends CMD23 so that the following multiple-block transfer
+ * finishes by itself, without needing mmc_send_stop_transmission()
+ *
+ * @mmc: MMC device
+ * @blkcnt: Number of blocks in the transfer
+ * Return: true if CMD23 was sent, false if the transfer must be stopped with
+ *	CMD12 as usual (this includes the case where CMD23 fails)
+ */
+bool mmc_set_block_count(struct mmc *mmc, lbaint_t blkcnt);
+
 #if CONFIG_IS_ENABLED(BLK)
 ulong mmc_bread(struct udevice *dev, lbaint_t start, lbaint_t blkcnt,
 		void *dst);
@@ -31,6 +45,7 @@ ulong mmc_bread(struct blk_desc *block_dev, lbaint_t start, lbaint_t blkcnt,
 ulong mmc_bwrite(struct udevice *dev, lbaint_t start, lbaint_t blkcnt,
 		 const void *src);
 ulong mmc_berase(struct udevice *dev, lbaint_t start, lbaint_t blkcnt);
+int mmc_bdiscard(struct udevice *dev, lbaint_t start, lbaint_t blkcnt);
 #else
 ulong mmc_bwrite(struct blk_desc *block_dev, lbaint_t start, lbaint_t blkcnt,
 		 const void *src);
@@ -132,4 +147,98 @@ int mmc_switch_part(struct mmc *mmc, unsigned int part_num);
  */
 int mmc_switch(struct mmc *mmc, u8 set, u8 index, u8 value);
 
+/**
+ * mmc_stop_bg_init() - Stop following a card's power-up in the background
+ *
+ * This removes the cyclic function started by mmc_start_init_all(), if any
+ *
+ * @mmc:	MMC device
+ */
+void mmc_stop_bg_init(struct mmc *mmc);
+
+#if CONFIG_IS_ENABLED(MMC_CQE)
+/**
+ * mmc_cqe_init() - Check whether command queueing can be used with a card
+ *
+ * This sets mmc->cqe_depth and the queue depth of the block device
+ *
+ * @mmc:	MMC device
+ * @ext_csd:	EXT_CSD of the card
+ */
+void mmc_cqe_init(struct mmc *mmc, const u8 *ext_csd);
+
+/**
+ * mmc_cqe_off() - Wait for queued tasks and leave command-queue mode
+ *
+ * This must be called before sending any normal command to the card. It
+ * does nothing if command queueing is not enabled.
+ *
+ * @mmc:	MMC device
+ * Return: 0 if OK, -ve on error
+ */
+int mmc_cqe_off(struct mmc *mmc);
+
+/**
+ * mmc_cqe_submit() - Queue an asynchronous read as a task
+ *
+ * @mmc:	MMC device
+ * @req:	Request to queue, which must not be larger than
+ *		mmc->cfg->cqe_b_max blocks and must have an aligned buffer
+ * Return: 0 if OK, -EBUSY if all tasks are in use, other -ve on error
+ */
+int mmc_cqe_submit(struct mmc *mmc, struct blk_req *req);
+
+/**
+ * mmc_cqe_poll() - Complete any tasks which have finished
+ *
+ * @mmc:	MMC device
+ * Return: 0 if OK, -ve on error
+ */
+int mmc_cqe_poll(struct mmc *mmc);
+
+/**
+ * mmc_cqe_can_read() - Check whether to read using command queueing
+ *
+ * @mmc:	MMC device
+ * @blkcnt:	Number of blocks to read
+ * @buf:	Buffer to read into
+ * Return: true if the card and host support command queueing, @buf is
+ *	suitably aligned and the read is worth doing that way
+ */
+bool mmc_cqe_can_read(struct mmc *mmc, lbaint_t blkcnt, const void *buf);
+
+/**
+ * mmc_cqe_bread() - Read blocks using several queued tasks at once
+ *
+ * @mmc:	MMC device
+ * @start:	First block to read
+ * @blkcnt:	Number of blocks to read
+ * @dst:	Buffer to read into, see mmc_cqe_can_read()
+ * Return: number of blocks read, or 0 on error
+ */
+ulong mmc_cqe_bread(struct mmc *mmc, lbaint_t start, lbaint_t blkcnt,
+		    void *dst);
+#else
+static inline void mmc_cqe_init(struct mmc *mmc, const u8 *ext_csd)
+{
+}
+
+static inline int mmc_cqe_off(struct mmc *mmc)
+{
+	return 0;
+}
+
+static inline bool mmc_cqe_can_read(struct mmc *mmc, lbaint_t blkcnt,
+				    const void *buf)
+{
+	return false;
+}
+
+static inline ulong mmc_cqe_bread(struct mmc *mmc, lbaint_t start,
+				  lbaint_t blkcnt, void *dst)
+{
+	return 0;
+}
+#endif
+
 #endif /* _MMC_PRIVATE_H_ */
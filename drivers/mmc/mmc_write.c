@@ -65,6 +65,44 @@ err_out:
 	return err;
 }
 
+/**
+ * mmc_erase_range() - Erase blocks, a few at a time
+ *
+ * @mmc: MMC device
+ * @start: First block to erase
+ * @blkcnt: Number of blocks to erase
+ * @args: Argument for the erase command, e.g. MMC_TRIM_ARG
+ * Return: number of blocks erased, or 0 if the card stays busy
+ */
+static lbaint_t mmc_erase_range(struct mmc *mmc, lbaint_t start,
+				lbaint_t blkcnt, u32 args)
+{
+	lbaint_t blk = 0, blk_r = 0;
+	int timeout_ms = 1000;
+	int err;
+
+	while (blk < blkcnt) {
+		if (IS_SD(mmc) && mmc->ssr.au) {
+			blk_r = ((blkcnt - blk) > mmc->ssr.au) ?
+				mmc->ssr.au : (blkcnt - blk);
+		} else {
+			blk_r = ((blkcnt - blk) > mmc->erase_grp_size) ?
+				mmc->erase_grp_size : (blkcnt - blk);
+		}
+		err = mmc_erase_t(mmc, start + blk, blk_r, args);
+		if (err)
+			break;
+
+		blk += blk_r;
+
+		/* Waiting for the ready status */
+		if (mmc_poll_for_busy(mmc, timeout_ms))
+			return 0;
+	}
+
+	return blk;
+}
+
 #if CONFIG_IS_ENABLED(BLK)
 ulong mmc_berase(struct udevice *dev, lbaint_t start, lbaint_t blkcnt)
 #else
@@ -78,8 +116,6 @@ ulong mmc_berase(struct blk_desc *block_dev, lbaint_t start, lbaint_t blkcnt)
 	int err = 0;
 	u32 start_rem, blkcnt_rem, erase_args = 0;
 	struct mmc *mmc = find_mmc_device(dev_num);
-	lbaint_t blk = 0, blk_r = 0;
-	int timeout_ms = 1000;
 
 	if (!mmc)
 		return -1;
@@ -116,27 +152,45 @@ ulong mmc_berase(struct blk_desc *block_dev, lbaint_t start, lbaint_t blkcnt)
 		}
 	}
 
-	while (blk < blkcnt) {
-		if (IS_SD(mmc) && mmc->ssr.au) {
-			blk_r = ((blkcnt - blk) > mmc->ssr.au) ?
-				mmc->ssr.au : (blkcnt - blk);
-		} else {
-			blk_r = ((blkcnt - blk) > mmc->erase_grp_size) ?
-				mmc->erase_grp_size : (blkcnt - blk);
-		}
-		err = mmc_erase_t(mmc, start + blk, blk_r, erase_args);
-		if (err)
-			break;
+	return mmc_erase_range(mmc, start, blkcnt, erase_args);
+}
 
-		blk += blk_r;
+#if CONFIG_IS_ENABLED(BLK)
+int mmc_bdiscard(struct udevice *dev, lbaint_t start, lbaint_t blkcnt)
+{
+	struct blk_desc *block_dev = dev_get_uclass_plat(dev);
+	struct mmc *mmc = find_mmc_device(block_dev->devnum);
+	bool zeroes;
+	int err;
 
-		/* Waiting for the ready status */
-		if (mmc_poll_for_busy(mmc, timeout_ms))
-			return 0;
-	}
+	if (!mmc)
+		return -ENODEV;
 
-	return blk;
+	/* The card says what erased (and trimmed) blocks read back as */
+	if (IS_SD(mmc))
+		zeroes = !(mmc->scr[0] & SD_SCR_DATA_STAT_AFTER_ERASE);
+	else
+		zeroes = mmc->ext_csd && !mmc->ext_csd[EXT_CSD_ERASED_MEM_CONT];
+	if (!zeroes)
+		return -ENOTSUPP;
+
+	err = blk_select_hwpart_devnum(UCLASS_MMC, block_dev->devnum,
+				       block_dev->hwpart);
+	if (err < 0)
+		return err;
+
+	/*
+	 * blk_discard() checked that the range is made of whole erase groups
+	 * unless the card can trim single blocks, so nothing else is erased
+	 */
+	if (mmc_erase_range(mmc, start, blkcnt,
+			    mmc->can_trim ? MMC_TRIM_ARG : MMC_ERASE_ARG) !=
+	    blkcnt)
+		return -EIO;
+
+	return 0;
 }
+#endif
 
 static ulong mmc_write_blocks(struct mmc *mmc, lbaint_t start,
 		lbaint_t blkcnt, const void *src)
@@ -144,6 +198,7 @@ static ulong mmc_write_blocks(struct mmc *mmc, lbaint_t start,
 	struct mmc_cmd cmd;
 	struct mmc_data data;
 	int timeout_ms = 1000;
+	bool predef;
 
 	if ((start + blkcnt) > mmc_get_blk_desc(mmc)->lba) {
 		printf("MMC: block number 0x" LBAF " exceeds max(0x" LBAF ")\n",
@@ -170,15 +225,18 @@ static ulong mmc_write_blocks(struct mmc *mmc, lbaint_t start,
 	data.blocksize = mmc->write_bl_len;
 	data.flags = MMC_DATA_WRITE;
 
+	predef = mmc_set_block_count(mmc, blkcnt);
 	if (mmc_send_cmd(mmc, &cmd, &data)) {
 		printf("mmc write failed\n");
+		if (predef)
+			mmc_send_stop_transmission(mmc, true);
 		return 0;
 	}
 
 	/* SPI multiblock writes terminate using a special
 	 * token, not a STOP_TRANSMISSION request.
 	 */
-	if (!mmc_host_is_spi(mmc) && blkcnt > 1) {
+	if (!mmc_host_is_spi(mmc) && blkcnt > 1 && !predef) {
 		cmd.cmdidx = MMC_CMD_STOP_TRANSMISSION;
 		cmd.cmdarg = 0;
 		cmd.resp_type = MMC_RSP_R1b;
@@ -222,8 +280,8 @@ ulong mmc_bwrite(struct blk_desc *block_dev, lbaint_t start, lbaint_t blkcnt,
 		return 0;
 
 	do {
-		cur = (blocks_todo > mmc->cfg->b_max) ?
-			mmc->cfg->b_max : blocks_todo;
+		cur = blk_write_split(block_dev, start, blocks_todo,
+				      mmc->cfg->b_max);
 		if (mmc_write_blocks(mmc, start, cur, src) != cur)
 			return 0;
 		blocks_todo -= cur;
@@ -27,7 +27,6 @@
 #define EMMC_MIN_FREQ	400000
 #define KHz	(1000)
 #define MHz	(1000 * KHz)
-#define SDHCI_TUNING_LOOP_COUNT		40
 
 #define PHYCTRL_CALDONE_MASK		0x1
 #define PHYCTRL_CALDONE_SHIFT		0x6
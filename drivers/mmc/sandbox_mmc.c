@@ -12,11 +12,20 @@
 #include <mmc.h>
 #include <os.h>
 #include <asm/test.h>
+#include <asm/unaligned.h>
+#include <linux/bitops.h>
+
+/* Type of card to emulate, from the driver data */
+enum sandbox_mmc_type {
+	SANDBOX_MMC_SD,
+	SANDBOX_MMC_EMMC,
+};
 
 struct sandbox_mmc_plat {
 	struct mmc_config cfg;
 	struct mmc mmc;
 	const char *fname;
+	bool emmc;	/* emulate an eMMC 5.1 device rather than an SD card */
 };
 
 #define MMC_CMULT		8 /* 8 because the card is high-capacity */
@@ -26,37 +35,127 @@ struct sandbox_mmc_plat {
 /* Granularity of priv->csize - this is 1MB */
 #define SIZE_MULTIPLE		((1 << (MMC_CMULT + 2)) * MMC_BL_LEN)
 
+/* Number of ACMD41s for which the card reports that it is powering up */
+#define POWERUP_POLLS		2
+
+/* Sample-tap setting at which tuning blocks are received correctly */
+#define TUNING_TAP		5
+#define TUNING_TAPS		16
+
+/* Number of command-queue tasks which the eMMC accepts */
+#define CQE_DEPTH		16
+
+/* Most blocks which one command-queue task can transfer */
+#define CQE_B_MAX		64
+
+/* Tuning block for a 4-bit bus, from the SD specification */
+static const u8 tuning_blk_4bit[] = {
+	0xff, 0x0f, 0xff, 0x00, 0xff, 0xcc, 0xc3, 0xcc,
+	0xc3, 0x3c, 0xcc, 0xff, 0xfe, 0xff, 0xfe, 0xef,
+	0xff, 0xdf, 0xff, 0xdd, 0xff, 0xfb, 0xff, 0xfb,
+	0xbf, 0xff, 0x7f, 0xff, 0x77, 0xf7, 0xbd, 0xef,
+	0xff, 0xf0, 0xff, 0xf0, 0x0f, 0xfc, 0xcc, 0x3c,
+	0xcc, 0x33, 0xcc, 0xcf, 0xff, 0xef, 0xff, 0xee,
+	0xff, 0xfd, 0xff, 0xfd, 0xdf, 0xff, 0xbf, 0xff,
+	0xbb, 0xff, 0xf7, 0xff, 0xf7, 0x7f, 0x7b, 0xde,
+};
+
+/**
+ * struct sandbox_mmc_task - a command-queue task waiting to be run
+ *
+ * @start: first block to read
+ * @data: transfer to do
+ */
+struct sandbox_mmc_task {
+	lbaint_t start;
+	struct mmc_data data;
+};
+
 struct sandbox_mmc_priv {
 	char *buf;
 	int csize;	/* CSIZE value to report */
 	int size;
+	uint blk_count;	/* block count set by CMD23, 0 if none */
+	bool predef;	/* last transfer had its length set by CMD23 */
+	int powerup;	/* ACMD41s left before the card is ready */
+	int tap;	/* sample-tap setting */
+	int tunings;	/* number of times full tuning has run */
+	u8 ext_csd[MMC_MAX_BLOCK_LEN];	/* EXT_CSD of an eMMC */
+#if CONFIG_IS_ENABLED(MMC_CQE)
+	bool cqe_on;	/* command-queue engine is running */
+	u32 cqe_queued;	/* mask of tags of queued tasks */
+	struct sandbox_mmc_task tasks[MMC_CQE_MAX_TASKS];
+	int cqe_tasks;	/* number of tasks run */
+	int cqe_max_queued;	/* most tasks queued at once */
+#endif
 };
 
+/*
+ * Check a multiple-block transfer against any block count set by CMD23, which
+ * applies only to the next transfer
+ */
+static int sandbox_mmc_check_count(struct sandbox_mmc_priv *priv,
+				   struct mmc_data *data)
+{
+	priv->predef = priv->blk_count;
+	if (priv->blk_count && priv->blk_count != data->blocks)
+		return -EIO;
+	priv->blk_count = 0;
+
+	return 0;
+}
+
 /**
- * sandbox_mmc_send_cmd() - Emulate SD commands
+ * sandbox_mmc_send_cmd() - Emulate SD and eMMC commands
  *
- * This emulate an SD card version 2. Single-block reads result in zero data.
- * Multiple-block reads return a test string.
+ * This emulate an SD card version 2, or an eMMC 5.1 device. Single-block reads
+ * result in zero data. Multiple-block reads return a test string.
  */
 static int sandbox_mmc_send_cmd(struct udevice *dev, struct mmc_cmd *cmd,
 				struct mmc_data *data)
 {
+	struct sandbox_mmc_plat *plat = dev_get_plat(dev);
 	struct sandbox_mmc_priv *priv = dev_get_priv(dev);
 	static ulong erase_start, erase_end;
 
+#if CONFIG_IS_ENABLED(MMC_CQE)
+	/* the command-queue engine owns the bus while it is running */
+	if (priv->cqe_on)
+		return -EIO;
+#endif
+	/* only tasks can transfer data in command-queue mode */
+	if (plat->emmc && priv->ext_csd[EXT_CSD_CMDQ_MODE_EN] && data)
+		return -EIO;
+
 	switch (cmd->cmdidx) {
+	case MMC_CMD_SEND_OP_COND:
+		cmd->response[0] = OCR_HCS;
+		if (priv->powerup)
+			priv->powerup--;
+		else
+			cmd->response[0] |= OCR_BUSY;
+		break;
 	case MMC_CMD_ALL_SEND_CID:
 		memset(cmd->response, '\0', sizeof(cmd->response));
 		break;
 	case SD_CMD_SEND_RELATIVE_ADDR:
 		cmd->response[0] = 0 << 16; /* mmc->rca */
+		break;
 	case MMC_CMD_GO_IDLE_STATE:
+		priv->powerup = POWERUP_POLLS;
 		break;
 	case SD_CMD_SEND_IF_COND:
+		/* an eMMC does not answer this; with data it is SEND_EXT_CSD */
+		if (plat->emmc) {
+			if (!data)
+				return -ETIMEDOUT;
+			memcpy(data->dest, priv->ext_csd, sizeof(priv->ext_csd));
+			break;
+		}
 		cmd->response[0] = 0xaa;
 		break;
 	case MMC_CMD_SEND_STATUS:
-		cmd->response[0] = MMC_STATUS_RDY_FOR_DATA;
+		cmd->response[0] = MMC_STATUS_RDY_FOR_DATA | MMC_STATE_TRANS;
 		break;
 	case MMC_CMD_SELECT_CARD:
 		break;
@@ -66,8 +165,19 @@ static int sandbox_mmc_send_cmd(struct udevice *dev, struct mmc_cmd *cmd,
 				   ((priv->csize >> 16) & 0x3f);
 		cmd->response[2] = (priv->csize & 0xffff) << 16;
 		cmd->response[3] = 0;
+		/* version 4 of the specification, with 512-byte writes */
+		if (plat->emmc) {
+			cmd->response[0] = 4 << 26;
+			cmd->response[3] = 9 << 22;
+		}
 		break;
 	case SD_CMD_SWITCH_FUNC: {
+		/* on an eMMC this is SWITCH, which writes a byte of EXT_CSD */
+		if (plat->emmc) {
+			priv->ext_csd[(cmd->cmdarg >> 16) & 0xff] =
+				(cmd->cmdarg >> 8) & 0xff;
+			break;
+		}
 		if (!data)
 			break;
 		u32 *resp = (u32 *)data->dest;
@@ -77,22 +187,36 @@ static int sandbox_mmc_send_cmd(struct udevice *dev, struct mmc_cmd *cmd,
 			resp[4] = (cmd->cmdarg & 0xF) << 24;
 		break;
 	}
-	case MMC_CMD_READ_SINGLE_BLOCK:
+	case MMC_CMD_SET_BLOCK_COUNT:
+		priv->blk_count = cmd->cmdarg;
+		break;
 	case MMC_CMD_READ_MULTIPLE_BLOCK:
+		if (sandbox_mmc_check_count(priv, data))
+			return -EIO;
+		fallthrough;
+	case MMC_CMD_READ_SINGLE_BLOCK:
 		memcpy(data->dest, &priv->buf[cmd->cmdarg * data->blocksize],
 		       data->blocks * data->blocksize);
 		break;
-	case MMC_CMD_WRITE_SINGLE_BLOCK:
 	case MMC_CMD_WRITE_MULTIPLE_BLOCK:
+		if (sandbox_mmc_check_count(priv, data))
+			return -EIO;
+		fallthrough;
+	case MMC_CMD_WRITE_SINGLE_BLOCK:
 		memcpy(&priv->buf[cmd->cmdarg * data->blocksize], data->src,
 		       data->blocks * data->blocksize);
 		break;
 	case MMC_CMD_STOP_TRANSMISSION:
+		/* a transfer with a block count set stops by itself */
+		if (priv->predef)
+			return -EILSEQ;
 		break;
 	case SD_CMD_ERASE_WR_BLK_START:
+	case MMC_CMD_ERASE_GROUP_START:
 		erase_start = cmd->cmdarg;
 		break;
 	case SD_CMD_ERASE_WR_BLK_END:
+	case MMC_CMD_ERASE_GROUP_END:
 		erase_end = cmd->cmdarg;
 		break;
 #if CONFIG_IS_ENABLED(MMC_WRITE)
@@ -105,19 +229,33 @@ static int sandbox_mmc_send_cmd(struct udevice *dev, struct mmc_cmd *cmd,
 	}
 #endif
 	case SD_CMD_APP_SEND_OP_COND:
-		cmd->response[0] = OCR_BUSY | OCR_HCS;
+		cmd->response[0] = OCR_HCS;
+		if (priv->powerup)
+			priv->powerup--;
+		else
+			cmd->response[0] |= OCR_BUSY;
 		cmd->response[1] = 0;
 		cmd->response[2] = 0;
 		break;
 	case MMC_CMD_APP_CMD:
+		if (plat->emmc)
+			return -ETIMEDOUT;
 		break;
 	case MMC_CMD_SET_BLOCKLEN:
 		debug("block len %d\n", cmd->cmdarg);
 		break;
+	case MMC_CMD_SEND_TUNING_BLOCK:
+		/* with the wrong sample point the data has CRC errors */
+		if (priv->tap != TUNING_TAP)
+			return -EILSEQ;
+		memcpy(data->dest, tuning_blk_4bit,
+		       min_t(uint, data->blocksize, sizeof(tuning_blk_4bit)));
+		break;
 	case SD_CMD_APP_SEND_SCR: {
 		u32 *scr = (u32 *)data->dest;
 
-		scr[0] = cpu_to_be32(2 << 24 | 1 << 15);  /* SD version 3 */
+		/* SD version 3, with CMD23 */
+		scr[0] = cpu_to_be32(2 << 24 | 1 << 15 | SD_SCR_CMD23);
 		break;
 	}
 	default:
@@ -138,10 +276,143 @@ static int sandbox_mmc_get_cd(struct udevice *dev)
 	return 1;
 }
 
+#if CONFIG_IS_ENABLED(MMC_SUPPORTS_TUNING)
+/* try each sample point in turn, as host drivers do */
+static int sandbox_mmc_execute_tuning(struct udevice *dev, uint opcode)
+{
+	struct sandbox_mmc_priv *priv = dev_get_priv(dev);
+	struct mmc *mmc = mmc_get_mmc_dev(dev);
+
+	priv->tunings++;
+	for (priv->tap = 0; priv->tap < TUNING_TAPS; priv->tap++) {
+		if (!mmc_send_tuning(mmc, opcode))
+			return 0;
+	}
+
+	return -ETIMEDOUT;
+}
+#endif
+
+#if CONFIG_IS_ENABLED(MMC_TUNING_CACHE)
+static int sandbox_mmc_get_tuning(struct udevice *dev, u32 *valp)
+{
+	struct sandbox_mmc_priv *priv = dev_get_priv(dev);
+
+	*valp = priv->tap;
+
+	return 0;
+}
+
+static int sandbox_mmc_set_tuning(struct udevice *dev, u32 val)
+{
+	struct sandbox_mmc_priv *priv = dev_get_priv(dev);
+
+	if (val >= TUNING_TAPS)
+		return -EINVAL;
+	priv->tap = val;
+
+	return 0;
+}
+#endif
+
+int sandbox_mmc_get_tunings(struct udevice *dev)
+{
+	struct sandbox_mmc_priv *priv = dev_get_priv(dev);
+
+	return priv->tunings;
+}
+
+#if CONFIG_IS_ENABLED(MMC_CQE)
+static int sandbox_mmc_cqe_enable(struct udevice *dev, bool enable)
+{
+	struct sandbox_mmc_priv *priv = dev_get_priv(dev);
+
+	/* the card must be in command-queue mode before the engine starts */
+	if (enable && !priv->ext_csd[EXT_CSD_CMDQ_MODE_EN])
+		return -EIO;
+
+	/* halting the engine discards any tasks it still has */
+	priv->cqe_on = enable;
+	priv->cqe_queued = 0;
+
+	return 0;
+}
+
+/* Tasks are only run when polled, so several can be queued at once */
+static int sandbox_mmc_cqe_request(struct udevice *dev, uint tag,
+				   lbaint_t start, struct mmc_data *data)
+{
+	struct sandbox_mmc_priv *priv = dev_get_priv(dev);
+	struct sandbox_mmc_task *task = &priv->tasks[tag];
+
+	if (!priv->cqe_on || tag >= CQE_DEPTH || data->blocks > CQE_B_MAX)
+		return -EIO;
+	if (priv->cqe_queued & BIT(tag))
+		return -EBUSY;
+	task->start = start;
+	task->data = *data;
+	priv->cqe_queued |= BIT(tag);
+	priv->cqe_max_queued = max_t(int, priv->cqe_max_queued,
+				     hweight32(priv->cqe_queued));
+
+	return 0;
+}
+
+/* Run one task each time, the last queued first, as a card may reorder them */
+static int sandbox_mmc_cqe_poll(struct udevice *dev, ulong *donep,
+				ulong *errp)
+{
+	struct sandbox_mmc_priv *priv = dev_get_priv(dev);
+	struct sandbox_mmc_task *task;
+	uint tag;
+
+	*donep = 0;
+	*errp = 0;
+	if (!priv->cqe_queued)
+		return 0;
+	tag = fls(priv->cqe_queued) - 1;
+	task = &priv->tasks[tag];
+	priv->cqe_queued &= ~BIT(tag);
+	priv->cqe_tasks++;
+	if ((task->start + task->data.blocks) * task->data.blocksize >
+	    priv->size) {
+		*errp = BIT(tag);
+		return 0;
+	}
+	memcpy(task->data.dest, &priv->buf[task->start * task->data.blocksize],
+	       task->data.blocks * task->data.blocksize);
+	*donep = BIT(tag);
+
+	return 0;
+}
+
+bool sandbox_mmc_get_cqe(struct udevice *dev, int *tasksp, int *max_queuedp)
+{
+	struct sandbox_mmc_priv *priv = dev_get_priv(dev);
+
+	*tasksp = priv->cqe_tasks;
+	*max_queuedp = priv->cqe_max_queued;
+
+	return priv->ext_csd[EXT_CSD_CMDQ_MODE_EN];
+}
+#endif
+
 static const struct dm_mmc_ops sandbox_mmc_ops = {
 	.send_cmd = sandbox_mmc_send_cmd,
 	.set_ios = sandbox_mmc_set_ios,
 	.get_cd = sandbox_mmc_get_cd,
+#if CONFIG_IS_ENABLED(MMC_SUPPORTS_TUNING)
+	.execute_tuning = sandbox_mmc_execute_tuning,
+#endif
+#if CONFIG_IS_ENABLED(MMC_TUNING_CACHE)
+	.get_tuning = sandbox_mmc_get_tuning,
+	.set_tuning = sandbox_mmc_set_tuning,
+#endif
+#if CONFIG_IS_ENABLED(MMC_CQE)
+	.cqe_enable = sandbox_mmc_cqe_enable,
+	.cqe_request = sandbox_mmc_cqe_request,
+	.cqe_poll = sandbox_mmc_cqe_poll,
+#endif
 };
 
 static int sandbox_mmc_of_to_plat(struct udevice *dev)
@@ -190,6 +461,18 @@ static int sandbox_mmc_probe(struct udevice *dev)
 		}
 	}
 
+	if (plat->emmc) {
+		u8 *ext_csd = priv->ext_csd;
+		uint sectors = priv->size / MMC_MAX_BLOCK_LEN;
+
+		ext_csd[EXT_CSD_REV] = 8;	/* version 5.1 */
+		ext_csd[EXT_CSD_CARD_TYPE] = EXT_CSD_CARD_TYPE_26 |
+			EXT_CSD_CARD_TYPE_52;
+		put_unaligned_le32(sectors, &ext_csd[EXT_CSD_SEC_CNT]);
+		ext_csd[EXT_CSD_CMDQ_SUPPORT] = 1;
+		ext_csd[EXT_CSD_CMDQ_DEPTH] = CQE_DEPTH - 1;
+	}
+
 	return mmc_init(&plat->mmc);
 }
 
@@ -217,6 +500,11 @@ static int sandbox_mmc_bind(struct udevice *dev)
 	cfg->f_min = 1000000;
 	cfg->f_max = 52000000;
 	cfg->b_max = U32_MAX;
+	plat->emmc = dev_get_driver_data(dev) == SANDBOX_MMC_EMMC;
+#if CONFIG_IS_ENABLED(MMC_CQE)
+	if (plat->emmc)
+		cfg->cqe_b_max = CQE_B_MAX;
+#endif
 
 	return mmc_bind(dev, &plat->mmc, cfg);
 }
@@ -229,7 +517,8 @@ static int sandbox_mmc_unbind(struct udevice *dev)
 }
 
 static const struct udevice_id sandbox_mmc_ids[] = {
-	{ .compatible = "sandbox,mmc" },
+	{ .compatible = "sandbox,mmc", .data = SANDBOX_MMC_SD },
+	{ .compatible = "sandbox,emmc", .data = SANDBOX_MMC_EMMC },
 	{ }
 };
 
@@ -8,6 +8,7 @@
  */
 
 #include <cpu_func.h>
+#include <cqhci.h>
 #include <dm.h>
 #include <errno.h>
 #include <log.h>
@@ -352,6 +353,62 @@ static int sdhci_send_command(struct mmc *mmc, struct mmc_cmd *cmd,
 }
 
 #if defined(CONFIG_DM_MMC) && CONFIG_IS_ENABLED(MMC_SUPPORTS_TUNING)
+/*
+ * Tuning as described by the SD Host Controller spec v3.00: the controller
+ * samples the tuning block sent in response to each command and clears
+ * EXEC_TUNING once it has found a sampling point, setting TUNED_CLK if that
+ * worked.
+ */
+static int sdhci_std_execute_tuning(struct mmc *mmc, uint opcode)
+{
+	struct sdhci_host *host = mmc->priv;
+	int loops = SDHCI_TUNING_LOOP_COUNT;
+	struct mmc_cmd cmd;
+	u32 blk_size;
+	u16 ctrl;
+	int ret;
+
+	ctrl = sdhci_readw(host, SDHCI_HOST_CONTROL2);
+	ctrl |= SDHCI_CTRL_EXEC_TUNING;
+	sdhci_writew(host, ctrl, SDHCI_HOST_CONTROL2);
+
+	sdhci_writel(host, SDHCI_INT_DATA_AVAIL, SDHCI_INT_ENABLE);
+
+	blk_size = SDHCI_MAKE_BLKSZ(SDHCI_DEFAULT_BOUNDARY_ARG, 64);
+	if (opcode == MMC_CMD_SEND_TUNING_BLOCK_HS200 && mmc->bus_width == 8)
+		blk_size = SDHCI_MAKE_BLKSZ(SDHCI_DEFAULT_BOUNDARY_ARG, 128);
+	sdhci_writew(host, blk_size, SDHCI_BLOCK_SIZE);
+	sdhci_writew(host, SDHCI_TRNS_READ, SDHCI_TRANSFER_MODE);
+
+	cmd.cmdidx = opcode;
+	cmd.resp_type = MMC_RSP_R1;
+	cmd.cmdarg = 0;
+
+	do {
+		ret = mmc_send_cmd(mmc, &cmd, NULL);
+		ctrl = sdhci_readw(host, SDHCI_HOST_CONTROL2);
+		if (ret || !loops--)
+			break;
+	} while (ctrl & SDHCI_CTRL_EXEC_TUNING);
+
+	if (ret || loops < 0 || !(ctrl & SDHCI_CTRL_TUNED_CLK)) {
+		if (!ret)
+			ret = -EIO;
+		log_debug("Tuning failed: %d\n", ret);
+
+		ctrl &= ~(SDHCI_CTRL_TUNED_CLK | SDHCI_CTRL_EXEC_TUNING);
+		sdhci_writew(host, ctrl, SDHCI_HOST_CONTROL2);
+		sdhci_reset(host, SDHCI_RESET_CMD);
+		sdhci_reset(host, SDHCI_RESET_DATA);
+	}
+
+	/* Enable only interrupts served by the SD controller */
+	sdhci_writel(host, SDHCI_INT_DATA_MASK | SDHCI_INT_CMD_MASK,
+		     SDHCI_INT_ENABLE);
+
+	return ret;
+}
+
 static int sdhci_execute_tuning(struct udevice *dev, uint opcode)
 {
 	int err;
@@ -366,7 +423,15 @@ static int sdhci_execute_tuning(struct udevice *dev, uint opcode)
 			return err;
 		return 0;
 	}
-	return 0;
+
+	/*
+	 * Without tuning, SDR104 may appear to work and then fail with data
+	 * errors, so use the standard method unless the host says otherwise
+	 */
+	if (host->quirks & SDHCI_QUIRK_NO_STD_TUNING)
+		return 0;
+
+	return sdhci_std_execute_tuning(mmc, opcode);
 }
 #endif
 int sdhci_set_clock(struct mmc *mmc, unsigned int clock)
@@ -843,6 +908,65 @@ static int sdhci_set_enhanced_strobe(struct udevice *dev)
 }
 #endif
 
+#if CONFIG_IS_ENABLED(MMC_CQHCI)
+static int sdhci_cqe_enable(struct udevice *dev, bool enable)
+{
+	struct mmc *mmc = mmc_get_mmc_dev(dev);
+	struct sdhci_host *host = mmc->priv;
+	u8 ctrl;
+	int ret;
+
+	if (!host->cqhci)
+		return -ENOSYS;
+	if (enable) {
+		/* the engine uses ADMA2 and 512-byte blocks for every task */
+		ctrl = sdhci_readb(host, SDHCI_HOST_CONTROL);
+		ctrl &= ~SDHCI_CTRL_DMA_MASK;
+		if (host->flags & USE_ADMA64)
+			ctrl |= SDHCI_CTRL_ADMA64;
+		else
+			ctrl |= SDHCI_CTRL_ADMA32;
+		sdhci_writeb(host, ctrl, SDHCI_HOST_CONTROL);
+		sdhci_writew(host, SDHCI_MAKE_BLKSZ(SDHCI_DEFAULT_BOUNDARY_ARG,
+						    MMC_MAX_BLOCK_LEN),
+			     SDHCI_BLOCK_SIZE);
+		sdhci_writeb(host, 0xe, SDHCI_TIMEOUT_CONTROL);
+	}
+	ret = cqhci_enable(host->cqhci, enable);
+	if (!enable)
+		sdhci_reset(host, SDHCI_RESET_CMD | SDHCI_RESET_DATA);
+
+	return ret;
+}
+
+static int sdhci_cqe_request(struct udevice *dev, uint tag, lbaint_t start,
+			     struct mmc_data *data)
+{
+	struct mmc *mmc = mmc_get_mmc_dev(dev);
+	struct sdhci_host *host = mmc->priv;
+
+	return cqhci_request(host->cqhci, tag, start, data);
+}
+
+static int sdhci_cqe_poll(struct udevice *dev, ulong *donep, ulong *errp)
+{
+	struct mmc *mmc = mmc_get_mmc_dev(dev);
+	struct sdhci_host *host = mmc->priv;
+
+	return cqhci_poll(host->cqhci, donep, errp);
+}
+
+int sdhci_cqe_init(struct sdhci_host *host, struct cqhci_host *cq,
+		   struct mmc_config *cfg, void __iomem *base)
+{
+	cq->base = base;
+	cq->dma64 = host->flags & USE_ADMA64;
+	host->cqhci = cq;
+
+	return cqhci_init(cq, host->mmc, cfg);
+}
+#endif
+
 const struct dm_mmc_ops sdhci_ops = {
 	.send_cmd	= sdhci_send_command,
 	.set_ios	= sdhci_set_ios,
@@ -855,6 +979,11 @@ const struct dm_mmc_ops sdhci_ops = {
 #if CONFIG_IS_ENABLED(MMC_HS400_ES_SUPPORT)
 	.set_enhanced_strobe = sdhci_set_enhanced_strobe,
 #endif
+#if CONFIG_IS_ENABLED(MMC_CQHCI)
+	.cqe_enable	= sdhci_cqe_enable,
+	.cqe_request	= sdhci_cqe_request,
+	.cqe_poll	= sdhci_cqe_poll,
+#endif
 };
 #else
 static const struct mmc_ops sdhci_ops = {
@@ -33,7 +33,6 @@
 #define SDHCI_ITAPDLY_ENABLE		BIT(8)
 #define SDHCI_OTAPDLY_ENABLE		BIT(6)
 
-#define SDHCI_TUNING_LOOP_COUNT		40
 #define MMC_BANK2			0x2
 
 #define SD_DLL_CTRL			0xFF180358
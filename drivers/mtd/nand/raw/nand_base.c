@@ -1099,6 +1099,25 @@ int nand_read_page_op(struct nand_chip *chip, unsigned int page,
 }
 EXPORT_SYMBOL_GPL(nand_read_page_op);
 
+/**
+ * nand_read_cache_op - Do a READ CACHE SEQUENTIAL or READ CACHE END operation
+ * @chip: The NAND chip
+ * @last: true to end the sequence, false to start loading the next page
+ *
+ * This moves the page loaded by the previous READ PAGE or READ CACHE
+ * SEQUENTIAL operation into the cache register, ready to be read out. Unless
+ * @last is true, the chip then loads the following page while the data is
+ * being transferred.
+ * This function does not select/unselect the CS line.
+ */
+static void nand_read_cache_op(struct nand_chip *chip, bool last)
+{
+	struct mtd_info *mtd = nand_to_mtd(chip);
+
+	chip->cmdfunc(mtd, last ? NAND_CMD_READCACHEEND :
+		      NAND_CMD_READCACHESEQ, -1, -1);
+}
+
 /**
  * nand_read_param_page_op - Do a READ PARAMETER PAGE operation
  * @chip: The NAND chip
@@ -2282,6 +2301,37 @@ static int nand_setup_read_retry(struct mtd_info *mtd, int retry_mode)
 	return chip->setup_read_retry(mtd, retry_mode);
 }
 
+/**
+ * nand_cache_read_end - [INTERN] Find the last page of a sequential read
+ * @mtd: MTD device structure
+ * @ops: oob ops structure
+ * @page: page to start reading from, at the start of the page
+ * @readlen: number of bytes left to read
+ *
+ * Sequential cache reads are only used for runs of whole pages, where the
+ * ECC layer reads each page straight out of the cache register. A run does
+ * not cross an eraseblock, so it never crosses a chip either.
+ *
+ * Returns the last page of the run, or -1 if it is not worth using one.
+ */
+static int nand_cache_read_end(struct mtd_info *mtd, struct mtd_oob_ops *ops,
+			       int page, uint32_t readlen)
+{
+	struct nand_chip *chip = mtd_to_nand(mtd);
+	int ppb = 1 << (chip->phys_erase_shift - chip->page_shift);
+	int last;
+
+	if (!IS_ENABLED(CONFIG_SYS_NAND_CACHE_READ) || !NAND_HAS_CACHERD(chip) ||
+	    ops->oobbuf || (chip->options & NAND_NEED_READRDY) ||
+	    chip->read_retries > 1 || !nand_standard_page_accessors(&chip->ecc))
+		return -1;
+
+	last = page + (int)(readlen >> chip->page_shift) - 1;
+	last = min(last, page | (ppb - 1));
+
+	return last > page ? last : -1;
+}
+
 /**
  * nand_do_read_ops - [INTERN] Read data with ECC
  * @mtd: MTD device structure
@@ -2305,6 +2355,7 @@ static int nand_do_read_ops(struct mtd_info *mtd, loff_t from,
 	unsigned int max_bitflips = 0;
 	int retry_mode = 0;
 	bool ecc_fail = false;
+	int seq_last = -1;
 
 	chipnr = (int)(from >> chip->chip_shift);
 	chip->select_chip(mtd, chipnr);
@@ -2342,10 +2393,29 @@ static int nand_do_read_ops(struct mtd_info *mtd, loff_t from,
 						 __func__, buf);
 
 read_retry:
-			if (nand_standard_page_accessors(&chip->ecc)) {
+			if (seq_last != -1) {
+				/* The chip has already loaded this page */
+				nand_read_cache_op(chip, page == seq_last);
+				if (page == seq_last)
+					seq_last = -1;
+			} else if (nand_standard_page_accessors(&chip->ecc)) {
 				ret = nand_read_page_op(chip, page, 0, NULL, 0);
 				if (ret)
 					break;
+
+				/*
+				 * Have the chip load the next page while this
+				 * one is transferred
+				 */
+				if (!col)
+					seq_last = nand_cache_read_end(mtd, ops,
+								       page,
+								       readlen);
+				if (seq_last != -1) {
+					/* Later pages must come from the chip */
+					chip->pagebuf = -1;
+					nand_read_cache_op(chip, false);
+				}
 			}
 
 			/*
@@ -2456,6 +2526,9 @@ read_retry:
 			chip->select_chip(mtd, chipnr);
 		}
 	}
+	/* Return the chip to normal operation if a sequence was cut short */
+	if (seq_last != -1)
+		nand_read_cache_op(chip, true);
 	chip->select_chip(mtd, -1);
 
 	ops->retlen = ops->len - (size_t) readlen;
@@ -5147,6 +5220,16 @@ int nand_scan_tail(struct mtd_info *mtd)
 	/* Invalidate the pagebuffer reference */
 	chip->pagebuf = -1;
 
+	/*
+	 * Use sequential cache reads if the chip has them and the commands are
+	 * sent by the generic large-page code, which knows how to handle them
+	 */
+	if (chip->onfi_version &&
+	    (le16_to_cpu(chip->onfi_params.opt_cmd) & ONFI_OPT_CMD_READ_CACHE) &&
+	    chip->cmdfunc == nand_command_lp &&
+	    ecc->mode != NAND_ECC_HW_OOB_FIRST)
+		chip->options |= NAND_CACHERD;
+
 	/* Large page NAND with SOFT_ECC should support subpage reads */
 	switch (ecc->mode) {
 	case NAND_ECC_SOFT:
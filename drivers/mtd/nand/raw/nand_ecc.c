@@ -23,6 +23,8 @@
  */
 
 
+#include <asm/unaligned.h>
+#include <linux/bitops.h>
 #include <linux/errno.h>
 #include <linux/mtd/mtd.h>
 #include <linux/mtd/nand_ecc.h>
@@ -64,24 +66,35 @@ static const u_char nand_ecc_precalc_table[] = {
 int nand_calculate_ecc(struct mtd_info *mtd, const u_char *dat,
 		       u_char *ecc_code)
 {
+	uint32_t cur, all = 0, lines[6] = { 0 };
 	uint8_t idx, reg1, reg2, reg3, tmp1, tmp2;
-	int i;
-
-	/* Initialize variables */
-	reg1 = reg2 = reg3 = 0;
-
-	/* Build up column parity */
-	for(i = 0; i < 256; i++) {
-		/* Get CP0 - CP5 from table */
-		idx = nand_ecc_precalc_table[*dat++];
-		reg1 ^= (idx & 0x3f);
-
-		/* All bit XOR = 1 ? */
-		if (idx & 0x40) {
-			reg3 ^= (uint8_t) i;
-			reg2 ^= ~((uint8_t) i);
-		}
+	int i, k;
+
+	/*
+	 * Line parity bit k is the parity of all the bytes whose offset has
+	 * bit k set. Work through the data a word at a time: offset bits 0
+	 * and 1 select a byte within the word and the rest are the bits of
+	 * the word number, so only the word parities need to be collected.
+	 */
+	for (i = 0; i < 64; i++) {
+		cur = get_unaligned_le32(dat + i * 4);
+		all ^= cur;
+		for (k = 0; k < 6; k++)
+			lines[k] ^= cur & -(uint32_t)((i >> k) & 1);
 	}
+	reg3 = (hweight32(all & 0xff00ff00) & 1) |
+		(hweight32(all & 0xffff0000) & 1) << 1;
+	for (k = 0; k < 6; k++)
+		reg3 |= (hweight32(lines[k]) & 1) << (k + 2);
+
+	/* Column parity is linear, so look up the XOR of all the bytes */
+	all ^= all >> 16;
+	all ^= all >> 8;
+	idx = nand_ecc_precalc_table[all & 0xff];
+	reg1 = idx & 0x3f;
+
+	/* Bit k of reg2 covers the odd-parity bytes with bit k clear */
+	reg2 = idx & 0x40 ? ~reg3 : reg3;
 
 	/* Create non-inverted ECC code from line parity */
 	tmp1  = (reg3 & 0x80) >> 0; /* B7 -> B7 */
@@ -64,6 +64,7 @@ static const char *const state_name[] = {
  * @state: Current state of the device
  * @column: Column of the most-recent command
  * @page_addr: Page address of the most-recent command
+ * @next_page: Page to load on the next READ CACHE command, or -1 if none
  * @fd: File descriptor for the backing data
  * @fd_page_addr: Page address that @fd is seek'd to
  * @selected: Whether this device is selected
@@ -83,7 +84,7 @@ struct sand_nand_chip {
 	u32 err_count, err_step_bits, err_steps, ecc_bits;
 	unsigned int cs;
 	enum sand_nand_state state;
-	int column, page_addr, fd, fd_page_addr;
+	int column, page_addr, next_page, fd, fd_page_addr;
 	bool selected, tmp_dirty;
 	u8 status;
 	u8 id_len;
@@ -293,6 +294,24 @@ static void sand_nand_command(struct mtd_info *mtd, unsigned int command,
 				break;
 
 			chip->page_addr = page_addr;
+			chip->next_page = page_addr;
+			new_state = STATE_READ;
+			break;
+		case NAND_CMD_READCACHESEQ:
+		case NAND_CMD_READCACHEEND:
+			new_state = STATE_IDLE;
+			if (chip->next_page < 0 || chip->next_page >= chip->pages)
+				break;
+
+			chip->column = 0;
+			chip->page_addr = chip->next_page;
+			if (sand_nand_read(chip))
+				break;
+
+			if (command == NAND_CMD_READCACHESEQ)
+				chip->next_page++;
+			else
+				chip->next_page = -1;
 			new_state = STATE_READ;
 			break;
 		case NAND_CMD_ERASE1:
@@ -333,6 +352,7 @@ reset:
 			new_state = STATE_IDLE;
 			chip->column = -1;
 			chip->page_addr = -1;
+			chip->next_page = -1;
 			chip->status = ~NAND_STATUS_FAIL;
 			break;
 		default:
@@ -624,6 +644,10 @@ static int sand_nand_probe(struct udevice *dev)
 		}
 		chip->ecc_bits = nand->ecc.layout->eccbytes * 8 /
 				 chip->err_steps;
+		if (nand->onfi_version &&
+		    (le16_to_cpu(nand->onfi_params.opt_cmd) &
+		     ONFI_OPT_CMD_READ_CACHE))
+			nand->options |= NAND_CACHERD;
 
 		ret = nand_register(devnum, mtd);
 		if (ret) {
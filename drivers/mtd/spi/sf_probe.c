@@ -105,9 +105,12 @@ static int spi_flash_probe_slave(struct spi_flash *flash)
 		if (ret)
 			return ret;
 
-		ret = spi_nor_create_write_dirmap(flash);
-		if (ret)
-			return ret;
+		/* the tiny version can only read */
+		if (!CONFIG_IS_ENABLED(SPI_FLASH_TINY)) {
+			ret = spi_nor_create_write_dirmap(flash);
+			if (ret)
+				return ret;
+		}
 	}
 
 	if (CONFIG_IS_ENABLED(SPI_FLASH_MTD))
@@ -69,6 +69,10 @@ struct sfdp_parameter_header {
 					 * Status, Control and Configuration
 					 * Register Map.
 					 */
+#define SFDP_OCTAL_DTR_SEQ_ID	0xff0a	/*
+					 * Command Sequences to Change to
+					 * Octal DDR (8D-8D-8D) mode.
+					 */
 
 #define SFDP_SIGNATURE		0x50444653U
 #define SFDP_JESD216_MAJOR	1
@@ -182,6 +186,16 @@ struct sfdp_header {
 /* Status, Control and Configuration Register Map(SCCR) */
 #define SCCR_DWORD22_OCTAL_DTR_EN_VOLATILE      BIT(31)
 
+/*
+ * Command Sequences to Change to Octal DDR table (from JESD216D.01). Each
+ * sequence takes two DWORDs: a length byte followed by up to 7 command bytes,
+ * most significant first.
+ */
+#define OCTAL_DTR_SEQS				4
+#define OCTAL_DTR_SEQ_DWORDS			(OCTAL_DTR_SEQS * 2)
+#define OCTAL_DTR_SEQ_LEN			GENMASK(31, 24)
+#define OCTAL_DTR_SEQ_MAX_LEN			7
+
 struct sfdp_bfpt {
 	u32	dwords[BFPT_DWORD_MAX];
 };
@@ -374,6 +388,66 @@ static int spansion_write_any_reg(struct spi_nor *nor, u32 addr, u8 val)
 }
 #endif
 
+/*
+ * Mode bits which keep the flash in continuous-read mode after a read, or
+ * leave it. 0xa5 has the 0xAx pattern most vendors use and differs in its two
+ * nibbles, as Macronix requires.
+ */
+#define SPINOR_CONT_READ_ENTER	0xa5
+#define SPINOR_CONT_READ_EXIT	0xff
+
+#if CONFIG_IS_ENABLED(SPI_FLASH_CONT_READ)
+/**
+ * spi_nor_cont_read_setup() - Prepare a read op to use continuous-read mode
+ * @nor:	pointer to 'struct spi_nor'
+ * @op:		read op, which is updated to send the mode bits as an extra
+ *		address byte
+ *
+ * Return: true if continuous-read mode can be used, false otherwise
+ */
+static bool spi_nor_cont_read_setup(struct spi_nor *nor, struct spi_mem_op *op)
+{
+	struct spi_mem_op next = *op;
+
+	if (!(nor->flags & SNOR_F_CONT_READ) || nor->dirmap.rdesc)
+		return false;
+
+	/* the ops after the first have no opcode */
+	next.cmd.nbytes = 0;
+	next.addr.nbytes++;
+	next.dummy.nbytes--;
+	if (!spi_mem_supports_op(nor->spi, &next))
+		return false;
+	op->addr.nbytes++;
+	op->dummy.nbytes--;
+
+	return true;
+}
+
+/* take the flash out of continuous-read mode after a failed read */
+static void spi_nor_cont_read_exit(struct spi_nor *nor, struct spi_mem_op *op,
+				   loff_t from)
+{
+	u8 buf;
+
+	op->cmd.nbytes = 0;
+	op->addr.val = from << 8 | SPINOR_CONT_READ_EXIT;
+	op->data.nbytes = 1;
+	op->data.buf.in = &buf;
+	spi_mem_exec_op(nor->spi, op);
+}
+#else
+static bool spi_nor_cont_read_setup(struct spi_nor *nor, struct spi_mem_op *op)
+{
+	return false;
+}
+
+static void spi_nor_cont_read_exit(struct spi_nor *nor, struct spi_mem_op *op,
+				   loff_t from)
+{
+}
+#endif
+
 static ssize_t spi_nor_read_data(struct spi_nor *nor, loff_t from, size_t len,
 				 u_char *buf)
 {
@@ -383,6 +457,7 @@ static ssize_t spi_nor_read_data(struct spi_nor *nor, loff_t from, size_t len,
 				   SPI_MEM_OP_DUMMY(nor->read_dummy, 0),
 				   SPI_MEM_OP_DATA_IN(len, buf, 0));
 	size_t remaining = len;
+	bool cont;
 	int ret;
 
 	spi_nor_setup_op(nor, &op, nor->read_proto);
@@ -392,6 +467,13 @@ static ssize_t spi_nor_read_data(struct spi_nor *nor, loff_t from, size_t len,
 	if (spi_nor_protocol_is_dtr(nor->read_proto))
 		op.dummy.nbytes *= 2;
 
+	/*
+	 * In continuous-read mode the flash expects just the address and mode
+	 * bits after the first op, which saves sending the opcode for each
+	 * chunk the controller splits the read into
+	 */
+	cont = spi_nor_cont_read_setup(nor, &op);
+
 	while (remaining) {
 		op.data.nbytes = remaining < UINT_MAX ? remaining : UINT_MAX;
 
@@ -413,12 +495,24 @@ static ssize_t spi_nor_read_data(struct spi_nor *nor, loff_t from, size_t len,
 			if (ret)
 				return ret;
 
+			/* stay in continuous-read mode until the last chunk */
+			if (cont)
+				op.addr.val = from << 8 |
+					(op.data.nbytes < remaining ?
+					 SPINOR_CONT_READ_ENTER :
+					 SPINOR_CONT_READ_EXIT);
 			ret = spi_mem_exec_op(nor->spi, &op);
-			if (ret)
+			if (ret) {
+				if (cont && !op.cmd.nbytes)
+					spi_nor_cont_read_exit(nor, &op, from);
 				return ret;
+			}
+			if (cont)
+				op.cmd.nbytes = 0;
 		}
 
-		op.addr.val += op.data.nbytes;
+		from += op.data.nbytes;
+		op.addr.val = from;
 		remaining -= op.data.nbytes;
 		op.data.buf.in += op.data.nbytes;
 	}
@@ -2579,6 +2673,103 @@ out:
 	return ret;
 }
 
+/**
+ * spi_nor_sfdp_octal_dtr_enable() - Enable octal DTR using the SFDP sequences
+ * @nor:	pointer to a 'struct spi_nor'
+ *
+ * Send the command sequences from the Command Sequences to Change to Octal
+ * DDR table, for flashes which have no specific method.
+ *
+ * Return: 0 on success, -errno otherwise.
+ */
+static int spi_nor_sfdp_octal_dtr_enable(struct spi_nor *nor)
+{
+	u8 buf[OCTAL_DTR_SEQ_MAX_LEN];
+	struct spi_mem_op op;
+	int i, j, len, ret;
+
+	for (i = 0; i < OCTAL_DTR_SEQS; i++) {
+		const u32 *seq = &nor->octal_dtr_seqs[i * 2];
+
+		len = FIELD_GET(OCTAL_DTR_SEQ_LEN, seq[0]);
+		if (!len)
+			continue;
+		for (j = 1; j <= len; j++)
+			buf[j - 1] = seq[j / 4] >> (24 - 8 * (j % 4));
+
+		op = (struct spi_mem_op)
+			SPI_MEM_OP(SPI_MEM_OP_CMD(buf[0], 1),
+				   SPI_MEM_OP_NO_ADDR,
+				   SPI_MEM_OP_NO_DUMMY,
+				   SPI_MEM_OP_DATA_OUT(len - 1, buf + 1, 1));
+		if (len == 1)
+			op.data.dir = SPI_MEM_NO_DATA;
+
+		ret = spi_mem_exec_op(nor->spi, &op);
+		if (ret) {
+			dev_err(nor->dev, "Failed to enable octal DTR mode\n");
+			return ret;
+		}
+	}
+	nor->reg_proto = SNOR_PROTO_8_8_8_DTR;
+
+	return 0;
+}
+
+/**
+ * spi_nor_parse_octal_dtr_seq() - Parse the Command Sequences to Change to
+ *				   Octal DDR table
+ * @nor:		pointer to a 'struct spi_nor'
+ * @seq_header:		pointer to the 'struct sfdp_parameter_header' describing
+ *			the table length and version.
+ *
+ * This provides a way to switch to 8D-8D-8D mode for flashes which do not
+ * have their own octal_dtr_enable() method.
+ *
+ * Return: 0 on success, -errno otherwise.
+ */
+static int spi_nor_parse_octal_dtr_seq(struct spi_nor *nor,
+				       const struct sfdp_parameter_header *seq_header)
+{
+	u32 *table, addr;
+	size_t len;
+	int ret, i;
+	bool found;
+
+	if (nor->octal_dtr_enable)
+		return 0;
+
+	table = devm_kzalloc(nor->dev, OCTAL_DTR_SEQ_DWORDS * sizeof(*table),
+			     GFP_KERNEL);
+	if (!table)
+		return -ENOMEM;
+
+	len = min_t(size_t, seq_header->length, OCTAL_DTR_SEQ_DWORDS) *
+		sizeof(*table);
+	addr = SFDP_PARAM_HEADER_PTP(seq_header);
+	ret = spi_nor_read_sfdp(nor, addr, len, table);
+	if (ret)
+		return ret;
+
+	found = false;
+	for (i = 0; i < OCTAL_DTR_SEQ_DWORDS; i++) {
+		table[i] = le32_to_cpu(table[i]);
+		if (!(i & 1) && FIELD_GET(OCTAL_DTR_SEQ_LEN, table[i])) {
+			if (FIELD_GET(OCTAL_DTR_SEQ_LEN, table[i]) >
+			    OCTAL_DTR_SEQ_MAX_LEN)
+				return -EINVAL;
+			found = true;
+		}
+	}
+	if (!found)
+		return 0;
+
+	nor->octal_dtr_seqs = table;
+	nor->octal_dtr_enable = spi_nor_sfdp_octal_dtr_enable;
+
+	return 0;
+}
+
 /**
  * spi_nor_parse_sccr() - Parse the Status, Control and Configuration Register
  *			  Map.
@@ -2637,6 +2828,7 @@ static int spi_nor_parse_sfdp(struct spi_nor *nor,
 	const struct sfdp_parameter_header *param_header, *bfpt_header;
 	struct sfdp_parameter_header *param_headers = NULL;
 	struct sfdp_header header;
+	bool xspi = false;
 	size_t psize;
 	int i, err;
 
@@ -2721,12 +2913,17 @@ static int spi_nor_parse_sfdp(struct spi_nor *nor,
 
 		case SFDP_PROFILE1_ID:
 			err = spi_nor_parse_profile1(nor, param_header, params);
+			xspi = !err;
 			break;
 
 		case SFDP_SCCR_MAP_ID:
 			err = spi_nor_parse_sccr(nor, param_header);
 			break;
 
+		case SFDP_OCTAL_DTR_SEQ_ID:
+			err = spi_nor_parse_octal_dtr_seq(nor, param_header);
+			break;
+
 		default:
 			break;
 		}
@@ -2745,6 +2942,14 @@ static int spi_nor_parse_sfdp(struct spi_nor *nor,
 		}
 	}
 
+	/*
+	 * Read and Page Program are required commands in the xSPI Profile 1.0,
+	 * so 8D-8D-8D can be used if the flash can be switched to it
+	 */
+	if (xspi && nor->octal_dtr_enable)
+		params->hwcaps.mask |= SNOR_HWCAPS_READ_8_8_8_DTR |
+			SNOR_HWCAPS_PP_8_8_8_DTR;
+
 exit:
 	kfree(param_headers);
 	return err;
@@ -2889,7 +3094,7 @@ static int spi_nor_init_params(struct spi_nor *nor,
 	nor->addr_width = 0;
 	nor->mtd.erasesize = 0;
 	if ((info->flags & (SPI_NOR_DUAL_READ | SPI_NOR_QUAD_READ |
-	     SPI_NOR_OCTAL_DTR_READ)) &&
+	     SPI_NOR_OCTAL_READ | SPI_NOR_OCTAL_DTR_READ)) &&
 	    !(info->flags & SPI_NOR_SKIP_SFDP)) {
 		struct spi_nor_flash_parameter sfdp_params;
 
@@ -3151,6 +3356,36 @@ spi_nor_adjust_hwcaps(struct spi_nor *nor,
 }
 #endif /* CONFIG_SPI_FLASH_SMART_HWCAPS */
 
+/**
+ * spi_nor_can_cont_read() - Check if the flash can use continuous-read mode
+ * @nor:	pointer to 'struct spi_nor', with the read settings selected
+ *
+ * Continuous-read mode is entered by sending the right mode bits in the
+ * dummy cycles, which need exactly one byte on the address lines. Only the
+ * vendors whose flashes accept SPINOR_CONT_READ_ENTER are included.
+ *
+ * Return: true if continuous-read mode can be used, false otherwise
+ */
+static bool spi_nor_can_cont_read(struct spi_nor *nor)
+{
+	u8 addr_nbits = spi_nor_get_protocol_addr_nbits(nor->read_proto);
+
+	if (spi_nor_protocol_is_dtr(nor->read_proto) || addr_nbits == 1 ||
+	    nor->read_mode_clocks * addr_nbits != 8)
+		return false;
+
+	switch (JEDEC_MFR(nor->info)) {
+	case SNOR_MFR_GIGADEVICE:
+	case SNOR_MFR_ISSI:
+	case SNOR_MFR_MACRONIX:
+	case SNOR_MFR_SPANSION:
+	case SNOR_MFR_WINBOND:
+		return true;
+	default:
+		return false;
+	}
+}
+
 static int spi_nor_select_read(struct spi_nor *nor,
 			       const struct spi_nor_flash_parameter *params,
 			       u32 shared_hwcaps)
@@ -3177,9 +3412,15 @@ static int spi_nor_select_read(struct spi_nor *nor,
 	 * (Continuous Read / XIP) mode.
 	 * eXecution In Place is out of the scope of the mtd sub-system.
 	 * Hence we choose to merge both mode and wait state clock cycles
-	 * into the so called dummy clock cycles.
+	 * into the so called dummy clock cycles. The number of mode clock
+	 * cycles is kept for spi_nor_read_data(), which can use Continuous
+	 * Read mode to speed up large reads.
 	 */
 	nor->read_dummy = read->num_mode_clocks + read->num_wait_states;
+	nor->read_mode_clocks = read->num_mode_clocks;
+	if (CONFIG_IS_ENABLED(SPI_FLASH_CONT_READ) && spi_nor_can_cont_read(nor))
+		nor->flags |= SNOR_F_CONT_READ;
+
 	return 0;
 }
 
@@ -833,6 +833,7 @@ static int scan_peb(struct ubi_device *ubi, struct ubi_attach_info *ai,
 		return 0;
 	}
 
+	ubi_io_prefetch_hdrs(ubi, pnum);
 	err = ubi_io_read_ec_hdr(ubi, pnum, ech, 0);
 	if (err < 0)
 		return err;
@@ -1407,6 +1408,15 @@ int ubi_attach(struct ubi_device *ubi, int force_scan)
 	if (!ai)
 		return -ENOMEM;
 
+	/*
+	 * Read both headers of each PEB with one flash access while scanning.
+	 * This is only an optimisation, so carry on without it if there is
+	 * no memory.
+	 */
+	ubi->hdrs_len = ubi->vid_hdr_aloffset + ubi->vid_hdr_alsize;
+	ubi->hdrs_buf = kmalloc(ubi->hdrs_len, GFP_KERNEL);
+	ubi->hdrs_pnum = -1;
+
 #ifdef CONFIG_MTD_UBI_FASTMAP
 	/* On small flash devices we disable fastmap in any case. */
 	if ((int)mtd_div_by_eb(ubi->mtd->size, ubi->mtd) <= UBI_FM_MAX_START) {
@@ -1434,6 +1444,9 @@ int ubi_attach(struct ubi_device *ubi, int force_scan)
 #else
 	err = scan_all(ubi, ai, 0);
 #endif
+	ubi_io_prefetch_hdrs(ubi, -1);
+	kfree(ubi->hdrs_buf);
+	ubi->hdrs_buf = NULL;
 	if (err)
 		goto out_ai;
 
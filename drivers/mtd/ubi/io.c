@@ -690,6 +690,44 @@ bad:
 	return 1;
 }
 
+/**
+ * ubi_io_prefetch_hdrs - read both headers of a PEB in one go.
+ * @ubi: UBI device description object
+ * @pnum: physical eraseblock to read, or %-1 to drop the copy
+ *
+ * When attaching, the EC and VID headers of every PEB are read one after the
+ * other, which costs two flash accesses per PEB. This function reads the start
+ * of the PEB up to the end of the VID header with a single access, so that
+ * the following header reads for @pnum are served from memory. If the read
+ * reports bit-flips or fails, nothing is kept and the headers are read
+ * separately as usual, so that the error is reported against the right
+ * header. This does nothing unless @ubi->hdrs_buf has been allocated.
+ */
+void ubi_io_prefetch_hdrs(struct ubi_device *ubi, int pnum)
+{
+	ubi->hdrs_pnum = -1;
+	if (pnum < 0 || !ubi->hdrs_buf)
+		return;
+	if (!ubi_io_read(ubi, ubi->hdrs_buf, pnum, 0, ubi->hdrs_len))
+		ubi->hdrs_pnum = pnum;
+}
+
+/*
+ * Read part of the header area of a PEB, using the copy made by
+ * ubi_io_prefetch_hdrs() if there is one
+ */
+static int ubi_io_read_hdr(struct ubi_device *ubi, void *buf, int pnum,
+			   int offset, int len)
+{
+	if (ubi->hdrs_buf && ubi->hdrs_pnum == pnum &&
+	    offset + len <= ubi->hdrs_len) {
+		memcpy(buf, ubi->hdrs_buf + offset, len);
+		return 0;
+	}
+
+	return ubi_io_read(ubi, buf, pnum, offset, len);
+}
+
 /**
  * ubi_io_read_ec_hdr - read and check an erase counter header.
  * @ubi: UBI device description object
@@ -721,7 +759,7 @@ int ubi_io_read_ec_hdr(struct ubi_device *ubi, int pnum,
 	dbg_io("read EC header from PEB %d", pnum);
 	ubi_assert(pnum >= 0 && pnum < ubi->peb_count);
 
-	read_err = ubi_io_read(ubi, ec_hdr, pnum, 0, UBI_EC_HDR_SIZE);
+	read_err = ubi_io_read_hdr(ubi, ec_hdr, pnum, 0, UBI_EC_HDR_SIZE);
 	if (read_err) {
 		if (read_err != UBI_IO_BITFLIPS && !mtd_is_eccerr(read_err))
 			return read_err;
@@ -996,8 +1034,8 @@ int ubi_io_read_vid_hdr(struct ubi_device *ubi, int pnum,
 	ubi_assert(pnum >= 0 &&  pnum < ubi->peb_count);
 
 	p = (char *)vid_hdr - ubi->vid_hdr_shift;
-	read_err = ubi_io_read(ubi, p, pnum, ubi->vid_hdr_aloffset,
-			  ubi->vid_hdr_alsize);
+	read_err = ubi_io_read_hdr(ubi, p, pnum, ubi->vid_hdr_aloffset,
+				   ubi->vid_hdr_alsize);
 	if (read_err && read_err != UBI_IO_BITFLIPS && !mtd_is_eccerr(read_err))
 		return read_err;
 
@@ -527,6 +527,10 @@ struct ubi_debug_info {
  *
  * @peb_buf: a buffer of PEB size used for different purposes
  * @buf_mutex: protects @peb_buf
+ * @hdrs_buf: copy of the EC and VID headers of PEB @hdrs_pnum, only allocated
+ *            while attaching (see ubi_io_prefetch_hdrs())
+ * @hdrs_len: size of @hdrs_buf
+ * @hdrs_pnum: PEB held in @hdrs_buf, or %-1 if none
  * @ckvol_mutex: serializes static volume checking when opening
  *
  * @dbg: debugging information for this UBI device
@@ -628,6 +632,10 @@ struct ubi_device {
 	struct mutex buf_mutex;
 	struct mutex ckvol_mutex;
 
+	void *hdrs_buf;
+	int hdrs_len;
+	int hdrs_pnum;
+
 	struct ubi_debug_info dbg;
 };
 
@@ -899,6 +907,7 @@ int ubi_io_read_vid_hdr(struct ubi_device *ubi, int pnum,
 			struct ubi_vid_hdr *vid_hdr, int verbose);
 int ubi_io_write_vid_hdr(struct ubi_device *ubi, int pnum,
 			 struct ubi_vid_hdr *vid_hdr);
+void ubi_io_prefetch_hdrs(struct ubi_device *ubi, int pnum);
 
 /* build.c */
 int ubi_attach_mtd_dev(struct mtd_info *mtd, int ubi_num,
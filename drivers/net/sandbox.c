@@ -319,6 +319,27 @@ void sandbox_eth_set_priv(int index, void *priv)
 	dev_priv->priv = priv;
 }
 
+/*
+ * sandbox_eth_set_batch()
+ *
+ * index - The alias index (also DM seq number)
+ * batch - true to handle packets with recv_batch() and send_batch()
+ */
+void sandbox_eth_set_batch(int index, bool batch)
+{
+	struct udevice *dev;
+	struct eth_sandbox_priv *priv;
+	int ret;
+
+	ret = uclass_get_device(UCLASS_ETH, index, &dev);
+	if (ret)
+		return;
+
+	priv = dev_get_priv(dev);
+	priv->batch = batch;
+	priv->send_batch_max = 0;
+}
+
 static int sb_eth_start(struct udevice *dev)
 {
 	struct eth_sandbox_priv *priv = dev_get_priv(dev);
@@ -386,6 +407,51 @@ static int sb_eth_free_pkt(struct udevice *dev, uchar *packet, int length)
 	return 0;
 }
 
+static int sb_eth_recv_batch(struct udevice *dev, int flags,
+			     struct eth_pkt *pkts, int count)
+{
+	struct eth_sandbox_priv *priv = dev_get_priv(dev);
+	int i;
+
+	if (!priv->batch)
+		return -ENOSYS;
+
+	if (skip_timeout) {
+		timer_test_add_offset(11000UL);
+		skip_timeout = false;
+	}
+
+	/* free_pkt() releases the packets in order, from the front */
+	for (i = 0; i < count && i < priv->recv_packets; i++) {
+		pkts[i].packet = priv->recv_packet_buffer[i];
+		pkts[i].length = priv->recv_packet_length[i];
+	}
+	debug("eth_sandbox: received %d packets, %d waiting\n", i,
+	      priv->recv_packets - i);
+
+	return i;
+}
+
+static int sb_eth_send_batch(struct udevice *dev, struct eth_pkt *pkts,
+			     int count)
+{
+	struct eth_sandbox_priv *priv = dev_get_priv(dev);
+	int i, ret;
+
+	debug("eth_sandbox: Send %d packets\n", count);
+	priv->send_batch_max = max(priv->send_batch_max, count);
+
+	for (i = 0; i < count; i++) {
+		if (priv->disabled)
+			continue;
+		ret = priv->tx_handler(dev, pkts[i].packet, pkts[i].length);
+		if (ret)
+			return ret;
+	}
+
+	return count;
+}
+
 static void sb_eth_stop(struct udevice *dev)
 {
 	debug("eth_sandbox: Stop\n");
@@ -407,6 +473,8 @@ static const struct eth_ops sb_eth_ops = {
 	.send			= sb_eth_send,
 	.recv			= sb_eth_recv,
 	.free_pkt		= sb_eth_free_pkt,
+	.recv_batch		= sb_eth_recv_batch,
+	.send_batch		= sb_eth_send_batch,
 	.stop			= sb_eth_stop,
 	.write_hwaddr		= sb_eth_write_hwaddr,
 };
@@ -17,7 +17,7 @@
 #include <linux/compat.h>
 #include "nvme.h"
 
-#define NVME_Q_DEPTH		2
+#define NVME_Q_DEPTH		32
 #define NVME_AQ_DEPTH		2
 #define NVME_SQ_SIZE(depth)	(depth * sizeof(struct nvme_command))
 #define NVME_CQ_SIZE(depth)	(depth * sizeof(struct nvme_completion))
@@ -26,6 +26,8 @@
 #define ADMIN_TIMEOUT		60
 #define IO_TIMEOUT		30
 #define MAX_PRP_POOL		512
+/* Maximum number of I/O commands submitted together by nvme_blk_rw() */
+#define NVME_IO_SLOTS		16
 
 static int nvme_wait_csts(struct nvme_dev *dev, u32 mask, u32 val)
 {
@@ -44,7 +46,18 @@ static int nvme_wait_csts(struct nvme_dev *dev, u32 mask, u32 val)
 	return -ETIME;
 }
 
-static int nvme_setup_prps(struct nvme_dev *dev, u64 *prp2,
+/**
+ * nvme_setup_prps() - set up the PRP entries for a transfer
+ *
+ * @dev:	NVMe device
+ * @prp_list:	Memory to hold the PRP list, large enough for @total_len, or
+ *		NULL to use (and if necessary enlarge) the device's PRP pool
+ * @prp2:	Returns the value to use for the PRP2 field of the command
+ * @total_len:	Number of bytes to transfer
+ * @dma_addr:	Address of the buffer
+ * Return: 0 if OK, -ENOMEM if the PRP pool could not be enlarged
+ */
+static int nvme_setup_prps(struct nvme_dev *dev, u64 *prp_list, u64 *prp2,
 			   int total_len, u64 dma_addr)
 {
 	u32 page_size = dev->page_size;
@@ -73,36 +86,41 @@ static int nvme_setup_prps(struct nvme_dev *dev, u64 *prp2,
 	nprps = DIV_ROUND_UP(length, page_size);
 	num_pages = DIV_ROUND_UP(nprps - 1, prps_per_page - 1);
 
-	if (nprps > dev->prp_entry_num) {
-		free(dev->prp_pool);
-		/*
-		 * Always increase in increments of pages.  It doesn't waste
-		 * much memory and reduces the number of allocations.
-		 */
-		dev->prp_pool = memalign(page_size, num_pages * page_size);
-		if (!dev->prp_pool) {
-			printf("Error: malloc prp_pool fail\n");
-			return -ENOMEM;
+	if (!prp_list) {
+		if (nprps > dev->prp_entry_num) {
+			free(dev->prp_pool);
+			/*
+			 * Always increase in increments of pages. It doesn't
+			 * waste much memory and reduces the number of
+			 * allocations.
+			 */
+			dev->prp_pool = memalign(page_size,
+						 num_pages * page_size);
+			if (!dev->prp_pool) {
+				printf("Error: malloc prp_pool fail\n");
+				return -ENOMEM;
+			}
+			dev->prp_entry_num = num_pages * (prps_per_page - 1) + 1;
 		}
-		dev->prp_entry_num = num_pages * (prps_per_page - 1) + 1;
+		prp_list = dev->prp_pool;
 	}
 
-	prp_pool = dev->prp_pool;
+	prp_pool = prp_list;
 	i = 0;
 	while (nprps) {
 		if ((i == (prps_per_page - 1)) && nprps > 1) {
 			*(prp_pool + i) = cpu_to_le64((ulong)prp_pool +
 					page_size);
 			i = 0;
-			prp_pool += page_size;
+			prp_pool += prps_per_page;
 		}
 		*(prp_pool + i++) = cpu_to_le64(dma_addr);
 		dma_addr += page_size;
 		nprps--;
 	}
-	*prp2 = (ulong)dev->prp_pool;
+	*prp2 = (ulong)prp_list;
 
-	flush_dcache_range((ulong)dev->prp_pool, (ulong)dev->prp_pool +
+	flush_dcache_range((ulong)prp_list, (ulong)prp_list +
 			   num_pages * page_size);
 
 	return 0;
@@ -132,30 +150,109 @@ static u16 nvme_read_completion_status(struct nvme_queue *nvmeq, u16 index)
 }
 
 /**
- * nvme_submit_cmd() - copy a command into a queue and ring the doorbell
+ * nvme_copy_cmd() - copy a command into the next free slot of a queue
  *
  * @nvmeq:	The queue to use
- * @cmd:	The command to send
+ * @cmd:	The command to copy
  */
-static void nvme_submit_cmd(struct nvme_queue *nvmeq, struct nvme_command *cmd)
+static void nvme_copy_cmd(struct nvme_queue *nvmeq, struct nvme_command *cmd)
 {
-	struct nvme_ops *ops;
 	u16 tail = nvmeq->sq_tail;
 
 	memcpy(&nvmeq->sq_cmds[tail], cmd, sizeof(*cmd));
 	flush_dcache_range((ulong)&nvmeq->sq_cmds[tail],
 			   (ulong)&nvmeq->sq_cmds[tail] + sizeof(*cmd));
+}
+
+/**
+ * nvme_queue_cmd() - add a command to a queue without ringing the doorbell
+ *
+ * Several commands can be queued and then started together with
+ * nvme_ring_sq_doorbell(). This must not be used with controllers which
+ * provide their own submit_cmd() operation.
+ *
+ * @nvmeq:	The queue to use
+ * @cmd:	The command to queue
+ */
+static void nvme_queue_cmd(struct nvme_queue *nvmeq, struct nvme_command *cmd)
+{
+	nvme_copy_cmd(nvmeq, cmd);
+	if (++nvmeq->sq_tail == nvmeq->q_depth)
+		nvmeq->sq_tail = 0;
+}
+
+static void nvme_ring_sq_doorbell(struct nvme_queue *nvmeq)
+{
+	writel(nvmeq->sq_tail, nvmeq->q_db);
+}
+
+static void nvme_ring_cq_doorbell(struct nvme_queue *nvmeq)
+{
+	writel(nvmeq->cq_head, nvmeq->q_db + nvmeq->dev->db_stride);
+}
+
+/**
+ * nvme_submit_cmd() - copy a command into a queue and ring the doorbell
+ *
+ * @nvmeq:	The queue to use
+ * @cmd:	The command to send
+ */
+static void nvme_submit_cmd(struct nvme_queue *nvmeq, struct nvme_command *cmd)
+{
+	struct nvme_ops *ops;
 
 	ops = (struct nvme_ops *)nvmeq->dev->udev->driver->ops;
 	if (ops && ops->submit_cmd) {
+		nvme_copy_cmd(nvmeq, cmd);
 		ops->submit_cmd(nvmeq, cmd);
 		return;
 	}
 
-	if (++tail == nvmeq->q_depth)
-		tail = 0;
-	writel(tail, nvmeq->q_db);
-	nvmeq->sq_tail = tail;
+	nvme_queue_cmd(nvmeq, cmd);
+	nvme_ring_sq_doorbell(nvmeq);
+}
+
+/**
+ * nvme_reap_cmd() - wait for the next completion on a queue and consume it
+ *
+ * The completion-queue doorbell is not updated; use nvme_ring_cq_doorbell()
+ * once all expected completions have been reaped.
+ *
+ * @nvmeq:	The queue to check
+ * @cmd_id:	Returns the ID of the command which completed
+ * @timeout_us:	Time to wait for a completion in microseconds
+ * Return: 0 if the command succeeded, -EIO if it failed, -ETIMEDOUT if
+ *	nothing completed in time
+ */
+static int nvme_reap_cmd(struct nvme_queue *nvmeq, u16 *cmd_id,
+			 ulong timeout_us)
+{
+	u16 head = nvmeq->cq_head;
+	u16 status;
+	ulong start_time;
+
+	start_time = timer_get_us();
+	for (;;) {
+		status = nvme_read_completion_status(nvmeq, head);
+		if ((status & 0x01) == nvmeq->cq_phase)
+			break;
+		if (timer_get_us() - start_time >= timeout_us)
+			return -ETIMEDOUT;
+	}
+
+	*cmd_id = readw(&nvmeq->cqes[head].command_id);
+	status >>= 1;
+	if (status)
+		printf("ERROR: status = %x, phase = %d, head = %d\n",
+		       status, nvmeq->cq_phase, head);
+
+	if (++head == nvmeq->q_depth) {
+		head = 0;
+		nvmeq->cq_phase = !nvmeq->cq_phase;
+	}
+	nvmeq->cq_head = head;
+
+	return status ? -EIO : 0;
 }
 
 static int nvme_submit_sync_cmd(struct nvme_queue *nvmeq,
@@ -667,6 +764,38 @@ static int nvme_get_info_from_identify(struct nvme_dev *dev)
 	return 0;
 }
 
+/**
+ * nvme_alloc_io_slots() - allocate PRP lists for batched I/O commands
+ *
+ * Each slot gets a PRP list big enough for a maximum-sized transfer, so that
+ * nvme_blk_rw() can have several commands in flight without building lists
+ * in a shared pool. If this is not possible, commands are sent one at a time.
+ *
+ * @dev:	NVMe device, with the I/O queue set up
+ */
+static void nvme_alloc_io_slots(struct nvme_dev *dev)
+{
+	struct nvme_ops *ops = (struct nvme_ops *)dev->udev->driver->ops;
+	u32 prps_per_page = dev->page_size >> 3;
+	u32 nprps, num_pages;
+
+	/* Controllers with their own submission method do not support this */
+	if (ops && ops->submit_cmd)
+		return;
+
+	nprps = (1 << dev->max_transfer_shift) / dev->page_size;
+	num_pages = max_t(u32, DIV_ROUND_UP(nprps - 1, prps_per_page - 1), 1);
+	dev->io_prp_entries = num_pages * prps_per_page;
+	dev->io_slots = min_t(u32, dev->queues[NVME_IO_Q]->q_depth - 1,
+			      NVME_IO_SLOTS);
+	dev->io_prp_lists = memalign(dev->page_size, dev->io_slots *
+				     dev->io_prp_entries * sizeof(u64));
+	if (!dev->io_prp_lists) {
+		log_debug("No memory for %u I/O slots\n", dev->io_slots);
+		dev->io_slots = 0;
+	}
+}
+
 int nvme_get_namespace_id(struct udevice *udev, u32 *ns_id, u8 *eui64)
 {
 	struct nvme_ns *ns = dev_get_priv(udev);
@@ -732,6 +861,9 @@ static int nvme_blk_probe(struct udevice *udev)
 	desc->lba = le64_to_cpu(id->nsze);
 	desc->log2blksz = ns->lba_shift;
 	desc->blksz = 1 << ns->lba_shift;
+	/* Optimal write size, which is also what writes should align to */
+	if (id->nsfeat & NVME_NS_FEAT_IO_OPT)
+		desc->write_align = le16_to_cpu(id->nows) + 1;
 	desc->bdev = udev;
 	memcpy(desc->vendor, ndev->vendor, sizeof(ndev->vendor));
 	memcpy(desc->product, ndev->serial, sizeof(ndev->serial));
@@ -741,6 +873,78 @@ static int nvme_blk_probe(struct udevice *udev)
 	return 0;
 }
 
+/**
+ * nvme_rw_batch() - run a batch of read/write commands on the I/O queue
+ *
+ * The transfer is split into up to dev->io_slots commands of at most @lbas
+ * blocks, each using its own preallocated PRP list. All of them are queued
+ * before the doorbell is rung, so the controller can work on them in
+ * parallel, then the completions are collected.
+ *
+ * @ns:		Namespace to access
+ * @c:		Command template, with everything except the addresses set up
+ * @slba:	First block to transfer
+ * @blkcnt:	Number of blocks remaining in the whole transfer
+ * @buffer:	Buffer address for @slba
+ * @lbas:	Maximum number of blocks in each command
+ * @donep:	Returns the number of blocks successfully transferred, starting
+ *		from @slba
+ * Return: 0 if all commands succeeded, -EIO if one failed, -ETIMEDOUT if the
+ *	controller did not respond
+ */
+static int nvme_rw_batch(struct nvme_ns *ns, struct nvme_command *c, u64 slba,
+			 u64 blkcnt, uintptr_t buffer, u16 lbas, u64 *donep)
+{
+	struct nvme_dev *dev = ns->dev;
+	struct nvme_queue *nvmeq = dev->queues[NVME_IO_Q];
+	u16 cmd_ids[NVME_IO_SLOTS];
+	u16 count[NVME_IO_SLOTS];
+	int n, i, j, failed;
+	int ret = 0;
+	u64 prp2;
+	u16 id;
+
+	for (n = 0; blkcnt && n < dev->io_slots; n++) {
+		count[n] = min_t(u64, blkcnt, lbas);
+		nvme_setup_prps(dev, dev->io_prp_lists + n * dev->io_prp_entries,
+				&prp2, count[n] << ns->lba_shift, buffer);
+		c->rw.command_id = nvme_get_cmd_id();
+		cmd_ids[n] = le16_to_cpu(c->rw.command_id);
+		c->rw.slba = cpu_to_le64(slba);
+		c->rw.length = cpu_to_le16(count[n] - 1);
+		c->rw.prp1 = cpu_to_le64(buffer);
+		c->rw.prp2 = cpu_to_le64(prp2);
+		nvme_queue_cmd(nvmeq, c);
+
+		slba += count[n];
+		blkcnt -= count[n];
+		buffer += count[n] << ns->lba_shift;
+	}
+	nvme_ring_sq_doorbell(nvmeq);
+
+	/* Completions may arrive in any order; find the first failure */
+	failed = n;
+	for (i = 0; i < n; i++) {
+		ret = nvme_reap_cmd(nvmeq, &id, IO_TIMEOUT * 100000);
+		if (ret == -ETIMEDOUT) {
+			failed = 0;
+			break;
+		}
+		for (j = 0; ret && j < n; j++) {
+			if (cmd_ids[j] == id && j < failed)
+				failed = j;
+		}
+	}
+	nvme_ring_cq_doorbell(nvmeq);
+
+	for (*donep = 0, i = 0; i < failed; i++)
+		*donep += count[i];
+	if (ret == -ETIMEDOUT)
+		return ret;
+
+	return failed < n ? -EIO : 0;
+}
+
 static ulong nvme_blk_rw(struct udevice *udev, lbaint_t blknr,
 			 lbaint_t blkcnt, void *buffer, bool read)
 {
@@ -757,6 +961,7 @@ static ulong nvme_blk_rw(struct udevice *udev, lbaint_t blknr,
 	u64 slba = blknr;
 	u16 lbas = 1 << (dev->max_transfer_shift - ns->lba_shift);
 	u64 total_lbas = blkcnt;
+	u64 done;
 
 	flush_dcache_range((unsigned long)buffer,
 			   (unsigned long)buffer + total_len);
@@ -771,6 +976,17 @@ static ulong nvme_blk_rw(struct udevice *udev, lbaint_t blknr,
 	c.rw.appmask = 0;
 	c.rw.metadata = 0;
 
+	while (total_lbas && dev->io_slots) {
+		status = nvme_rw_batch(ns, &c, slba, total_lbas, temp_buffer,
+				       lbas, &done);
+		total_lbas -= done;
+		slba += done;
+		temp_len -= done << ns->lba_shift;
+		temp_buffer += done << ns->lba_shift;
+		if (status)
+			goto out;
+	}
+
 	while (total_lbas) {
 		if (total_lbas < lbas) {
 			lbas = (u16)total_lbas;
@@ -779,7 +995,7 @@ static ulong nvme_blk_rw(struct udevice *udev, lbaint_t blknr,
 			total_lbas -= lbas;
 		}
 
-		if (nvme_setup_prps(dev, &prp2,
+		if (nvme_setup_prps(dev, NULL, &prp2,
 				    lbas << ns->lba_shift, temp_buffer))
 			return -EIO;
 		c.rw.slba = cpu_to_le64(slba);
@@ -795,6 +1011,7 @@ static ulong nvme_blk_rw(struct udevice *udev, lbaint_t blknr,
 		temp_buffer += lbas << ns->lba_shift;
 	}
 
+out:
 	if (read)
 		invalidate_dcache_range((unsigned long)buffer,
 					(unsigned long)buffer + total_len);
@@ -876,6 +1093,7 @@ int nvme_init(struct udevice *udev)
 	}
 
 	nvme_get_info_from_identify(ndev);
+	nvme_alloc_io_slots(ndev);
 
 	/* Create a blk device for each namespace */
 
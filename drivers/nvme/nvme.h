@@ -112,7 +112,12 @@ struct nvme_id_ns {
 	__le16			nabspf;
 	__u16			rsvd46;
 	__le64			nvmcap[2];
-	__u8			rsvd64[40];
+	__le16			npwg;
+	__le16			npwa;
+	__le16			npdg;
+	__le16			npda;
+	__le16			nows;
+	__u8			rsvd74[30];
 	__u8			nguid[16];
 	__u8			eui64[8];
 	struct nvme_lbaf	lbaf[16];
@@ -122,6 +127,7 @@ struct nvme_id_ns {
 
 enum {
 	NVME_NS_FEAT_THIN	= 1 << 0,
+	NVME_NS_FEAT_IO_OPT	= 1 << 4,
 	NVME_NS_FLBAS_LBA_MASK	= 0xf,
 	NVME_NS_FLBAS_META_EXT	= 0x10,
 	NVME_LBAF_RP_BEST	= 0,
@@ -620,6 +626,10 @@ struct nvme_dev {
 	u8 vwc;
 	u64 *prp_pool;
 	u32 prp_entry_num;
+	/* PRP lists for batched I/O, io_prp_entries for each of io_slots */
+	u64 *io_prp_lists;
+	u32 io_prp_entries;
+	u32 io_slots;
 	u32 nn;
 };
 
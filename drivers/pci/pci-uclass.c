@@ -858,6 +858,64 @@ __weak extern void board_pci_fixup_dev(struct udevice *bus, struct udevice *dev)
 {
 }
 
+/**
+ * pci_bus_max_dev() - Get the highest device number worth scanning on a bus
+ *
+ * The secondary bus of a PCIe root port or switch downstream port is a
+ * point-to-point link, so only device 0 can be present. Probing the other 31
+ * device numbers is slow on some controllers, since each access has to time
+ * out. The exception is when ARI forwarding is enabled, since functions of
+ * device 0 then appear at higher device numbers.
+ *
+ * With CONFIG_PCI_SKIP_LINK_DOWN, a port which reports that its link is down
+ * is not scanned at all.
+ *
+ * @bus: Bus to check
+ * Return: highest device number to scan, or -ENOLINK if there is nothing to
+ *	scan
+ */
+static int pci_bus_max_dev(struct udevice *bus)
+{
+	u16 exp_flags, exp_lnksta, exp_devctl2;
+	u32 exp_lnkcap;
+	int pcie_off;
+
+	if (!device_is_on_pci_bus(bus))
+		return PCI_MAX_PCI_DEVICES - 1;
+	pcie_off = dm_pci_find_capability(bus, PCI_CAP_ID_EXP);
+	if (!pcie_off)
+		return PCI_MAX_PCI_DEVICES - 1;
+
+	dm_pci_read_config16(bus, pcie_off + PCI_EXP_FLAGS, &exp_flags);
+	switch ((exp_flags & PCI_EXP_FLAGS_TYPE) >> 4) {
+	case PCI_EXP_TYPE_ROOT_PORT:
+	case PCI_EXP_TYPE_DOWNSTREAM:
+		break;
+	default:
+		return PCI_MAX_PCI_DEVICES - 1;
+	}
+
+	if (IS_ENABLED(CONFIG_PCI_SKIP_LINK_DOWN)) {
+		dm_pci_read_config32(bus, pcie_off + PCI_EXP_LNKCAP,
+				     &exp_lnkcap);
+		dm_pci_read_config16(bus, pcie_off + PCI_EXP_LNKSTA,
+				     &exp_lnksta);
+		if ((exp_lnkcap & PCI_EXP_LNKCAP_DLLLARC) &&
+		    !(exp_lnksta & PCI_EXP_LNKSTA_DLLLA))
+			return -ENOLINK;
+	}
+
+	/* Device Control 2 is only present from version 2 */
+	if ((exp_flags & PCI_EXP_FLAGS_VERS) >= 2) {
+		dm_pci_read_config16(bus, pcie_off + PCI_EXP_DEVCTL2,
+				     &exp_devctl2);
+		if (exp_devctl2 & PCI_EXP_DEVCTL2_ARI)
+			return PCI_MAX_PCI_DEVICES - 1;
+	}
+
+	return 0;
+}
+
 int pci_bind_bus_devices(struct udevice *bus)
 {
 	ulong vendor, device;
@@ -865,11 +923,18 @@ int pci_bind_bus_devices(struct udevice *bus)
 	pci_dev_t bdf, end;
 	bool found_multi;
 	int ari_off;
+	int max_dev;
 	int ret;
 
+	max_dev = pci_bus_max_dev(bus);
+	if (max_dev < 0) {
+		debug("%s: bus %d/%s: link down, not scanning\n", __func__,
+		      dev_seq(bus), bus->name);
+		return 0;
+	}
+
 	found_multi = false;
-	end = PCI_BDF(dev_seq(bus), PCI_MAX_PCI_DEVICES - 1,
-		      PCI_MAX_PCI_FUNCTIONS - 1);
+	end = PCI_BDF(dev_seq(bus), max_dev, PCI_MAX_PCI_FUNCTIONS - 1);
 	for (bdf = PCI_BDF(dev_seq(bus), 0, 0); bdf <= end;
 	     bdf += PCI_BDF(0, 0, 1)) {
 		struct pci_child_plat *pplat;
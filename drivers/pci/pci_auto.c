@@ -527,13 +527,18 @@ int dm_pciauto_config_device(struct udevice *dev)
 	unsigned short class;
 	struct udevice *ctlr = pci_get_controller(dev);
 	struct pci_controller *ctlr_hose = dev_get_uclass_priv(ctlr);
+	struct pci_child_plat *pplat = dev_get_parent_plat(dev);
 	int ret;
 
 	pci_mem = ctlr_hose->pci_mem;
 	pci_prefetch = ctlr_hose->pci_prefetch;
 	pci_io = ctlr_hose->pci_io;
 
-	dm_pci_read_config16(dev, PCI_CLASS_DEVICE, &class);
+	/* use the class read by pci_bind_bus_devices(), if any */
+	if (pplat->vendor && pplat->vendor != 0xffff)
+		class = pplat->class >> 8;
+	else
+		dm_pci_read_config16(dev, PCI_CLASS_DEVICE, &class);
 
 	switch (class) {
 	case PCI_CLASS_BRIDGE_PCI:
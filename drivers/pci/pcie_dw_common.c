@@ -11,6 +11,7 @@
 #include <dm.h>
 #include <log.h>
 #include <pci.h>
+#include <time.h>
 #include <dm/device_compat.h>
 #include <asm/io.h>
 #include <linux/delay.h>
@@ -28,6 +29,31 @@ int pcie_dw_get_link_width(struct pcie_dw *pci)
 		PCIE_LINK_STATUS_WIDTH_MASK) >> PCIE_LINK_STATUS_WIDTH_OFF;
 }
 
+/**
+ * pcie_dw_no_link_partner() - Check whether nothing is attached to a port
+ *
+ * The LTSSM stays in the Detect states until receiver detection finds a link
+ * partner, which a device must allow within 20ms of leaving reset. If it is
+ * still there after CONFIG_PCIE_DW_DETECT_TIMEOUT milliseconds the slot is
+ * empty, so the caller can give up rather than wait for the full link-up
+ * timeout.
+ *
+ * @ltssm: Current LTSSM state (only the low bits are used)
+ * @start: Time at which the device was taken out of reset, from get_timer(0)
+ * Return: true if the slot is known to be empty, false if it may still come up
+ */
+bool pcie_dw_no_link_partner(u32 ltssm, ulong start)
+{
+	if (!CONFIG_PCIE_DW_DETECT_TIMEOUT ||
+	    get_timer(start) < CONFIG_PCIE_DW_DETECT_TIMEOUT)
+		return false;
+
+	ltssm &= PCIE_LTSSM_STATE_MASK;
+
+	return ltssm == PCIE_LTSSM_DETECT_QUIET ||
+		ltssm == PCIE_LTSSM_DETECT_ACT;
+}
+
 static void dw_pcie_writel_ob_unroll(struct pcie_dw *pci, u32 index, u32 reg,
 				     u32 val)
 {
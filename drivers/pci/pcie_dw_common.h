@@ -20,6 +20,12 @@
 #define PCIE_LINK_STATUS_WIDTH_OFF	20
 #define PCIE_LINK_STATUS_WIDTH_MASK	(0xf << PCIE_LINK_STATUS_WIDTH_OFF)
 
+/* LTSSM state, as found in the port debug register and most glue layers */
+#define PCIE_LTSSM_STATE_MASK		0x3f
+#define PCIE_LTSSM_DETECT_QUIET		0x00
+#define PCIE_LTSSM_DETECT_ACT		0x01
+#define PCIE_LTSSM_L0			0x11
+
 /*
  * iATU Unroll-specific register definitions
  * From 4.80 core version the address translation will be made by unroll.
@@ -130,6 +136,8 @@ int pcie_dw_get_link_speed(struct pcie_dw *pci);
 
 int pcie_dw_get_link_width(struct pcie_dw *pci);
 
+bool pcie_dw_no_link_partner(u32 ltssm, ulong start);
+
 int pcie_dw_prog_outbound_atu_unroll(struct pcie_dw *pci, int index, int type, u64 cpu_addr,
 				     u64 pci_addr, u32 size);
 
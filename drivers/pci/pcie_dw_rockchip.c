@@ -12,6 +12,7 @@
 #include <power-domain.h>
 #include <reset.h>
 #include <syscon.h>
+#include <time.h>
 #include <asm/arch-rockchip/clock.h>
 #include <asm/global_data.h>
 #include <asm/io.h>
@@ -64,6 +65,9 @@ struct rk_pcie {
 
 #define PCIE_TYPE0_HDR_DBI2_OFFSET	0x100000
 
+/* Time allowed for the link to come up after PERST# is released */
+#define RK_PCIE_LINK_TIMEOUT_MS		1000
+
 static int rk_pcie_read(void __iomem *addr, int size, u32 *val)
 {
 	if ((uintptr_t)addr & (size - 1)) {
@@ -261,7 +265,7 @@ static int is_link_up(struct rk_pcie *priv)
 
 	val = rk_pcie_readl_apb(priv, PCIE_CLIENT_LTSSM_STATUS);
 	if ((val & (RDLH_LINKUP | SMLH_LINKUP)) == 0x30000 &&
-	    (val & GENMASK(5, 0)) == 0x11)
+	    (val & PCIE_LTSSM_STATE_MASK) == PCIE_LTSSM_L0)
 		return 1;
 
 	return 0;
@@ -276,7 +280,7 @@ static int is_link_up(struct rk_pcie *priv)
  */
 static int rk_pcie_link_up(struct rk_pcie *priv)
 {
-	int retries;
+	ulong start;
 
 	if (is_link_up(priv)) {
 		printf("PCI Link already up before configuration!\n");
@@ -308,18 +312,22 @@ static int rk_pcie_link_up(struct rk_pcie *priv)
 	if (dm_gpio_is_valid(&priv->rst_gpio))
 		dm_gpio_set_value(&priv->rst_gpio, 1);
 
-	/* Check if the link is up or not */
-	for (retries = 0; retries < 10; retries++) {
-		if (is_link_up(priv))
-			break;
-
-		mdelay(100);
-	}
-
-	if (retries >= 10) {
-		dev_err(priv->dw.dev, "PCIe-%d Link Fail\n",
-			dev_seq(priv->dw.dev));
-		return -EIO;
+	/* Check if the link is up or not, giving up early if the slot is empty */
+	start = get_timer(0);
+	while (!is_link_up(priv)) {
+		if (pcie_dw_no_link_partner(rk_pcie_readl_apb(priv,
+						PCIE_CLIENT_LTSSM_STATUS),
+					    start)) {
+			dev_info(priv->dw.dev, "PCIe-%d: No device detected\n",
+				 dev_seq(priv->dw.dev));
+			return -ENODEV;
+		}
+		if (get_timer(start) > RK_PCIE_LINK_TIMEOUT_MS) {
+			dev_err(priv->dw.dev, "PCIe-%d Link Fail\n",
+				dev_seq(priv->dw.dev));
+			return -EIO;
+		}
+		mdelay(1);
 	}
 
 	dev_info(priv->dw.dev, "PCIe Link up, LTSSM is 0x%x\n",
@@ -104,8 +104,8 @@ static int fixed_clock_regulator_set_enable(struct udevice *dev, bool enable)
 	if (ret)
 		return ret;
 
-	if (enable && plat->startup_delay_us)
-		udelay(plat->startup_delay_us);
+	if (enable)
+		regulator_set_ready_delay(dev, plat->startup_delay_us);
 
 	if (!enable && plat->off_on_delay_us)
 		udelay(plat->off_on_delay_us);
@@ -9,6 +9,7 @@
 #include <errno.h>
 #include <dm.h>
 #include <log.h>
+#include <time.h>
 #include <dm/uclass-internal.h>
 #include <linux/delay.h>
 #include <power/pmic.h>
@@ -38,6 +39,33 @@ int regulator_get_value(struct udevice *dev)
 	return ops->get_value(dev);
 }
 
+void regulator_set_ready_delay(const struct udevice *dev, uint delay_us)
+{
+	struct dm_regulator_uclass_plat *uc_pdata = dev_get_uclass_plat(dev);
+	ulong ready_us;
+
+	if (!delay_us)
+		return;
+
+	ready_us = timer_get_us() + delay_us;
+	if (!uc_pdata->ready_us || (long)(ready_us - uc_pdata->ready_us) > 0)
+		uc_pdata->ready_us = ready_us;
+}
+
+void regulator_wait_ready(struct udevice *dev)
+{
+	struct dm_regulator_uclass_plat *uc_pdata = dev_get_uclass_plat(dev);
+	long left;
+
+	if (!uc_pdata->ready_us)
+		return;
+
+	left = uc_pdata->ready_us - timer_get_us();
+	if (left > 0)
+		udelay(left);
+	uc_pdata->ready_us = 0;
+}
+
 static void regulator_set_value_ramp_delay(struct udevice *dev, int old_uV,
 					   int new_uV, unsigned int ramp_delay)
 {
@@ -46,7 +74,7 @@ static void regulator_set_value_ramp_delay(struct udevice *dev, int old_uV,
 	debug("regulator %s: delay %u us (%d uV -> %d uV)\n", dev->name, delay,
 	      old_uV, new_uV);
 
-	udelay(delay);
+	regulator_set_ready_delay(dev, delay);
 }
 
 int regulator_set_value(struct udevice *dev, int uV)
@@ -75,6 +103,7 @@ int regulator_set_value(struct udevice *dev, int uV)
 		if (uc_pdata->ramp_delay && old_uV > 0 && is_enabled)
 			regulator_set_value_ramp_delay(dev, old_uV, uV,
 						       uc_pdata->ramp_delay);
+		regulator_wait_ready(dev);
 	}
 
 	return ret;
@@ -158,7 +187,7 @@ int regulator_get_enable(struct udevice *dev)
 	return ops->get_enable(dev);
 }
 
-int regulator_set_enable(struct udevice *dev, bool enable)
+int regulator_set_enable_nowait(struct udevice *dev, bool enable)
 {
 	const struct dm_regulator_ops *ops = dev_get_driver_ops(dev);
 	struct dm_regulator_uclass_plat *uc_pdata;
@@ -189,6 +218,17 @@ int regulator_set_enable(struct udevice *dev, bool enable)
 	return ret;
 }
 
+int regulator_set_enable(struct udevice *dev, bool enable)
+{
+	int ret;
+
+	ret = regulator_set_enable_nowait(dev, enable);
+	if (enable && (!ret || ret == -EALREADY))
+		regulator_wait_ready(dev);
+
+	return ret;
+}
+
 int regulator_set_enable_if_allowed(struct udevice *dev, bool enable)
 {
 	int ret;
@@ -285,7 +325,7 @@ int device_get_supply_regulator(struct udevice *dev, const char *supply_name,
 					    supply_name, devp);
 }
 
-int regulator_autoset(struct udevice *dev)
+static int regulator_autoset_nowait(struct udevice *dev)
 {
 	struct dm_regulator_uclass_plat *uc_pdata;
 	int ret = 0;
@@ -314,7 +354,7 @@ int regulator_autoset(struct udevice *dev)
 	}
 
 	if (uc_pdata->type == REGULATOR_TYPE_FIXED) {
-		ret = regulator_set_enable(dev, true);
+		ret = regulator_set_enable_nowait(dev, true);
 		goto out;
 	}
 
@@ -326,7 +366,7 @@ int regulator_autoset(struct udevice *dev)
 		ret = regulator_set_current(dev, uc_pdata->min_uA);
 
 	if (!ret)
-		ret = regulator_set_enable(dev, true);
+		ret = regulator_set_enable_nowait(dev, true);
 
 out:
 	uc_pdata->flags |= REGULATOR_FLAG_AUTOSET_DONE;
@@ -334,6 +374,16 @@ out:
 	return ret;
 }
 
+int regulator_autoset(struct udevice *dev)
+{
+	int ret;
+
+	ret = regulator_autoset_nowait(dev);
+	regulator_wait_ready(dev);
+
+	return ret;
+}
+
 int regulator_unset(struct udevice *dev)
 {
 	struct dm_regulator_uclass_plat *uc_pdata;
@@ -516,7 +566,7 @@ int regulators_enable_boot_on(bool verbose)
 	for (uclass_first_device(UCLASS_REGULATOR, &dev);
 	     dev;
 	     uclass_next_device(&dev)) {
-		ret = regulator_autoset(dev);
+		ret = regulator_autoset_nowait(dev);
 		if (ret == -EMEDIUMTYPE) {
 			ret = 0;
 			continue;
@@ -527,6 +577,13 @@ int regulators_enable_boot_on(bool verbose)
 			ret = 0;
 	}
 
+	/*
+	 * Other hardware may rely on these supplies without asking for them,
+	 * so wait for them all, which takes as long as the slowest
+	 */
+	uclass_foreach_dev(dev, uc)
+		regulator_wait_ready(dev);
+
 	return ret;
 }
 
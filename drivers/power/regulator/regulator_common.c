@@ -97,8 +97,8 @@ int regulator_common_set_enable(const struct udevice *dev,
 		return ret;
 	}
 
-	if (enable && plat->startup_delay_us)
-		udelay(plat->startup_delay_us);
+	if (enable)
+		regulator_set_ready_delay(dev, plat->startup_delay_us);
 	debug("%s: done\n", __func__);
 
 	if (!enable && plat->off_on_delay_us)
@@ -553,16 +553,6 @@ static void k3_ddrss_set_ecc_range_r0(u32 base, u32 start_address, u32 size)
 	writel((start_address + size - 1) >> 16, base + DDRSS_ECC_R0_END_ADDR_REG);
 }
 
-static void k3_ddrss_preload_ecc_mem_region(u32 *addr, u32 size, u32 word)
-{
-	int i;
-
-	printf("ECC is enabled, priming DDR which will take several seconds.\n");
-
-	for (i = 0; i < (size / 4); i++)
-		addr[i] = word;
-}
-
 static void k3_ddrss_lpddr4_ecc_calc_reserved_mem(struct k3_ddrss_desc *ddrss)
 {
 	fdtdec_setup_mem_size_base_lowest();
@@ -574,12 +564,13 @@ static void k3_ddrss_lpddr4_ecc_calc_reserved_mem(struct k3_ddrss_desc *ddrss)
 	ddrss->ecc_reserved_space = 1ull << (fls(ddrss->ecc_reserved_space));
 }
 
-static void k3_ddrss_lpddr4_ecc_init(struct k3_ddrss_desc *ddrss)
+static int k3_ddrss_lpddr4_ecc_init(struct k3_ddrss_desc *ddrss)
 {
 	u32 ecc_region_start = ddrss->ecc_regions[0].start;
 	u32 ecc_range = ddrss->ecc_regions[0].range;
 	u32 base = (u32)ddrss->ddrss_ss_cfg;
 	u32 val;
+	int ret;
 
 	/* Only Program region 0 which covers full ddr space */
 	k3_ddrss_set_ecc_range_r0(base, ecc_region_start - gd->ram_base, ecc_range);
@@ -589,8 +580,9 @@ static void k3_ddrss_lpddr4_ecc_init(struct k3_ddrss_desc *ddrss)
 	       DDRSS_ECC_CTRL_REG_WR_ALLOC, base + DDRSS_ECC_CTRL_REG);
 
 	/* Preload ECC Mem region with 0's */
-	k3_ddrss_preload_ecc_mem_region((u32 *)ecc_region_start, ecc_range,
-					0x00000000);
+	ret = ram_scrub(ddrss->dev, ecc_region_start, ecc_range);
+	if (ret)
+		return ret;
 
 	/* Clear Error Count Register */
 	writel(0x1, base + DDRSS_ECC_1B_ERR_CNT_REG);
@@ -599,6 +591,8 @@ static void k3_ddrss_lpddr4_ecc_init(struct k3_ddrss_desc *ddrss)
 	val = readl(base + DDRSS_ECC_CTRL_REG);
 	val |= DDRSS_ECC_CTRL_REG_ECC_CK;
 	writel(val, base + DDRSS_ECC_CTRL_REG);
+
+	return 0;
 }
 
 static int k3_ddrss_probe(struct udevice *dev)
@@ -647,7 +641,12 @@ static int k3_ddrss_probe(struct udevice *dev)
 		/* Always configure one region that covers full DDR space */
 		ddrss->ecc_regions[0].start = gd->ram_base;
 		ddrss->ecc_regions[0].range = gd->ram_size - ddrss->ecc_reserved_space;
-		k3_ddrss_lpddr4_ecc_init(ddrss);
+		ret = k3_ddrss_lpddr4_ecc_init(ddrss);
+		if (ret) {
+			printf("%s: failed to prime ECC memory: %d\n", __func__,
+			       ret);
+			return ret;
+		}
 	}
 
 	return ret;
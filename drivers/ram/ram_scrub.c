@@ -0,0 +1,112 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Initialising ECC memory
+ *
+ * Memory with ECC must be written before it is read, or the check bits are
+ * garbage. Where the controller cannot do this itself, the memory is cleared
+ * in chunks by the CPUs. memset() of zero uses 'dc zva' on arm64 when the
+ * caches are on, which is much faster than storing each word, and the chunks
+ * are spread across any secondary CPUs which can take jobs.
+ */
+
+#define LOG_CATEGORY UCLASS_RAM
+
+#include <cpu.h>
+#include <cpu_func.h>
+#include <cyclic.h>
+#include <dm.h>
+#include <log.h>
+#include <mapmem.h>
+#include <ram.h>
+#include <asm/cache.h>
+#include <linux/errno.h>
+#include <linux/kernel.h>
+#include <linux/math64.h>
+#include <linux/sizes.h>
+#include <linux/string.h>
+
+/* Amount of memory cleared by each job */
+#define RAM_SCRUB_CHUNK		SZ_64M
+
+/* Most jobs to run at once, i.e. CPUs to use */
+#define RAM_SCRUB_MAX_JOBS	8
+
+/**
+ * struct ram_scrub_chunk - A chunk of memory to clear
+ *
+ * @job: Job which clears the chunk
+ * @buf: Start of the chunk
+ * @size: Size of the chunk in bytes
+ */
+struct ram_scrub_chunk {
+	struct cpu_job job;
+	void *buf;
+	ulong size;
+};
+
+static int ram_scrub_chunk(struct cpu_job *job)
+{
+	struct ram_scrub_chunk *chunk = container_of(job,
+						     struct ram_scrub_chunk,
+						     job);
+	ulong start = (ulong)chunk->buf;
+
+	memset(chunk->buf, '\0', chunk->size);
+	flush_dcache_range(start, start + chunk->size);
+
+	return 0;
+}
+
+int ram_scrub(struct udevice *dev, phys_addr_t base, phys_size_t size)
+{
+	struct ram_scrub_chunk chunks[RAM_SCRUB_MAX_JOBS];
+	phys_size_t done = 0;
+	int pct, last_pct = -1;
+	int njobs, i;
+	int ret;
+
+	if (!IS_ALIGNED(base | size, ARCH_DMA_MINALIGN))
+		return -EINVAL;
+	if (base + size - 1 > (phys_addr_t)ULONG_MAX)
+		return -E2BIG;
+
+	if (dev && ram_get_ops(dev)->scrub) {
+		log_debug("Scrubbing %llx bytes at %llx using %s\n",
+			  (unsigned long long)size, (unsigned long long)base,
+			  dev->name);
+		ret = ram_get_ops(dev)->scrub(dev, base, size);
+		if (ret != -ENOSYS)
+			return ret;
+	}
+
+	njobs = min(cpu_job_cpus(), RAM_SCRUB_MAX_JOBS);
+	log_debug("Scrubbing %llx bytes at %llx with %d CPUs\n",
+		  (unsigned long long)size, (unsigned long long)base, njobs);
+	while (done < size) {
+		for (i = 0; i < njobs && done < size; i++) {
+			ulong len = min_t(phys_size_t, size - done,
+					  RAM_SCRUB_CHUNK);
+
+			chunks[i].buf = map_sysmem(base + done, len);
+			chunks[i].size = len;
+			chunks[i].job.func = ram_scrub_chunk;
+			cpu_job_start(&chunks[i].job);
+			done += len;
+		}
+		while (i--) {
+			cpu_job_wait(&chunks[i].job);
+			unmap_sysmem(chunks[i].buf);
+		}
+
+		pct = div64_u64(done * 100, size);
+		if (pct != last_pct) {
+			printf("\rScrubbing ECC memory: %3d%%", pct);
+			last_pct = pct;
+		}
+		schedule();
+	}
+	if (last_pct != -1)
+		printf("\n");
+
+	return 0;
+}
@@ -6,6 +6,8 @@
 #define LOG_CATEGORY UCLASS_SERIAL
 
 #include <config.h>
+#include <cpu_func.h>
+#include <cyclic.h>
 #include <dm.h>
 #include <env_internal.h>
 #include <errno.h>
@@ -231,10 +233,100 @@ int serial_initialize(void)
 	return serial_init();
 }
 
+#if CONFIG_IS_ENABLED(SERIAL_TX_BUFFER)
+/**
+ * serial_tx_drain() - Send what the UART will take from the TX buffer
+ *
+ * This does not wait for the UART
+ *
+ * @dev: Serial device
+ * Return: true if the TX buffer is now empty
+ */
+static bool serial_tx_drain(struct udevice *dev)
+{
+	struct serial_dev_priv *upriv = dev_get_uclass_priv(dev);
+	struct dm_serial_ops *ops = serial_get_ops(dev);
+
+	while (upriv->tx_rd_ptr != upriv->tx_wr_ptr) {
+		if (ops->putc(dev, upriv->tx_buf[upriv->tx_rd_ptr]) == -EAGAIN)
+			return false;
+		upriv->tx_rd_ptr++;
+		upriv->tx_rd_ptr %= CONFIG_SERIAL_TX_BUFFER_SIZE;
+	}
+
+	return true;
+}
+
+static void serial_tx_cyclic(void *ctx)
+{
+	struct udevice *dev = ctx;
+	struct serial_dev_priv *upriv = dev_get_uclass_priv(dev);
+
+	/* Leave it to the code already sending, if this interrupted it */
+	if (!upriv->tx_busy)
+		serial_tx_drain(dev);
+}
+
+/**
+ * serial_tx_put() - Send a character, or add it to the TX buffer
+ *
+ * @dev: Serial device
+ * @ch: Character to send
+ * Return: true if done, false if the device has no TX buffer
+ */
+static bool serial_tx_put(struct udevice *dev, char ch)
+{
+	struct serial_dev_priv *upriv = dev_get_uclass_priv(dev);
+	struct dm_serial_ops *ops = serial_get_ops(dev);
+	int next;
+
+	if (!upriv->tx_buf)
+		return false;
+
+	upriv->tx_busy = true;
+	if (!serial_tx_drain(dev) || ops->putc(dev, ch) == -EAGAIN) {
+		next = (upriv->tx_wr_ptr + 1) % CONFIG_SERIAL_TX_BUFFER_SIZE;
+
+		/* If the buffer is full, wait for room */
+		while (next == upriv->tx_rd_ptr)
+			serial_tx_drain(dev);
+		upriv->tx_buf[upriv->tx_wr_ptr] = ch;
+		upriv->tx_wr_ptr = next;
+	}
+	upriv->tx_busy = false;
+
+	return true;
+}
+
+static bool serial_tx_buffered(struct udevice *dev)
+{
+	struct serial_dev_priv *upriv = dev_get_uclass_priv(dev);
+
+	return upriv->tx_buf;
+}
+#else
+static bool serial_tx_drain(struct udevice *dev)
+{
+	return true;
+}
+
+static bool serial_tx_put(struct udevice *dev, char ch)
+{
+	return false;
+}
+
+static bool serial_tx_buffered(struct udevice *dev)
+{
+	return false;
+}
+#endif /* CONFIG_IS_ENABLED(SERIAL_TX_BUFFER) */
+
 static void _serial_flush(struct udevice *dev)
 {
 	struct dm_serial_ops *ops = serial_get_ops(dev);
 
+	while (!serial_tx_drain(dev))
+		;
 	if (!ops->pending)
 		return;
 	while (ops->pending(dev, false) > 0)
@@ -249,9 +341,11 @@ static void _serial_putc(struct udevice *dev, char ch)
 	if (ch == '\n')
 		_serial_putc(dev, '\r');
 
-	do {
-		err = ops->putc(dev, ch);
-	} while (err == -EAGAIN);
+	if (!serial_tx_put(dev, ch)) {
+		do {
+			err = ops->putc(dev, ch);
+		} while (err == -EAGAIN);
+	}
 
 	if (IS_ENABLED(CONFIG_CONSOLE_FLUSH_ON_NEWLINE) && ch == '\n')
 		_serial_flush(dev);
@@ -277,7 +371,8 @@ static void _serial_puts(struct udevice *dev, const char *str)
 {
 	struct dm_serial_ops *ops = serial_get_ops(dev);
 
-	if (!CONFIG_IS_ENABLED(SERIAL_PUTS) || !ops->puts) {
+	if (!CONFIG_IS_ENABLED(SERIAL_PUTS) || !ops->puts ||
+	    serial_tx_buffered(dev)) {
 		while (*str)
 			_serial_putc(dev, *str++);
 		return;
@@ -307,8 +402,10 @@ static int __serial_getc(struct udevice *dev)
 
 	do {
 		err = ops->getc(dev);
-		if (err == -EAGAIN)
+		if (err == -EAGAIN) {
 			schedule();
+			cpu_idle();
+		}
 	} while (err == -EAGAIN);
 
 	return err >= 0 ? err : 0;
@@ -586,6 +683,18 @@ static int serial_post_probe(struct udevice *dev)
 	/* Allocate the RX buffer */
 	upriv->buf = malloc(CONFIG_SERIAL_RX_BUFFER_SIZE);
 #endif
+#if CONFIG_IS_ENABLED(SERIAL_TX_BUFFER)
+	/* Allocate the TX buffer, which is sent out in the background */
+	upriv->tx_buf = malloc(CONFIG_SERIAL_TX_BUFFER_SIZE);
+	if (upriv->tx_buf) {
+		upriv->tx_cyclic = cyclic_register(serial_tx_cyclic, 1000,
+						   dev->name, dev);
+		if (!upriv->tx_cyclic) {
+			free(upriv->tx_buf);
+			upriv->tx_buf = NULL;
+		}
+	}
+#endif
 
 	stdio_register_dev(&sdev, &upriv->sdev);
 #endif
@@ -594,12 +703,24 @@ static int serial_post_probe(struct udevice *dev)
 
 static int serial_pre_remove(struct udevice *dev)
 {
-#if CONFIG_IS_ENABLED(SYS_STDIO_DEREGISTER)
+#if CONFIG_IS_ENABLED(SYS_STDIO_DEREGISTER) || \
+	CONFIG_IS_ENABLED(SERIAL_TX_BUFFER)
 	struct serial_dev_priv *upriv = dev_get_uclass_priv(dev);
+#endif
 
+#if CONFIG_IS_ENABLED(SYS_STDIO_DEREGISTER)
 	if (stdio_deregister_dev(upriv->sdev, true))
 		return -EPERM;
 #endif
+#if CONFIG_IS_ENABLED(SERIAL_TX_BUFFER)
+	if (upriv->tx_buf) {
+		while (!serial_tx_drain(dev))
+			;
+		cyclic_unregister(upriv->tx_cyclic);
+		free(upriv->tx_buf);
+		upriv->tx_buf = NULL;
+	}
+#endif
 
 	return 0;
 }
@@ -581,8 +581,8 @@ static int atmel_qspi_transfer(struct atmel_qspi *aq,
 
 		/* Send/Receive data */
 		if (op->data.dir == SPI_MEM_DATA_IN)
-			memcpy_fromio(op->data.buf.in, aq->mem + offset,
-				      op->data.nbytes);
+			spi_mem_dirmap_copy(op->data.buf.in, aq->mem + offset,
+					    op->data.nbytes);
 		else
 			memcpy_toio(aq->mem + offset, op->data.buf.out,
 				    op->data.nbytes);
@@ -722,8 +722,8 @@ static int atmel_qspi_sama7g5_transfer(struct atmel_qspi *aq,
 
 	/* Send/Receive data. */
 	if (op->data.dir == SPI_MEM_DATA_IN) {
-		memcpy_fromio(op->data.buf.in, aq->mem + offset,
-			      op->data.nbytes);
+		spi_mem_dirmap_copy(op->data.buf.in, aq->mem + offset,
+				    op->data.nbytes);
 
 		if (op->addr.nbytes) {
 			err = readl_poll_timeout(aq->regs + QSPI_SR2, val,
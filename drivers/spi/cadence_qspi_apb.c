@@ -27,7 +27,6 @@
 
 #include <log.h>
 #include <asm/io.h>
-#include <dma.h>
 #include <linux/bitops.h>
 #include <linux/delay.h>
 #include <linux/errno.h>
@@ -766,10 +765,7 @@ int cadence_qspi_apb_read_execute(struct cadence_spi_priv *priv,
 	cadence_qspi_apb_enable_linear_mode(true);
 
 	if (priv->use_dac_mode && (from + len < priv->ahbsize)) {
-		if (len < 256 ||
-		    dma_memcpy(buf, priv->ahbbase + from, len) < 0) {
-			memcpy_fromio(buf, priv->ahbbase + from, len);
-		}
+		spi_mem_dirmap_copy(buf, priv->ahbbase + from, len);
 		if (!cadence_qspi_wait_idle(priv->regbase))
 			return -EIO;
 		return 0;
@@ -538,9 +538,10 @@ static void fsl_qspi_read_ahb(struct fsl_qspi *q, const struct spi_mem_op *op)
 			ahb_read_addr += op->addr.val;
 	}
 
-	memcpy_fromio(op->data.buf.in,
-		      ahb_read_addr + q->selected * fsl_qspi_memsize_per_cs(q),
-		      op->data.nbytes);
+	spi_mem_dirmap_copy(op->data.buf.in,
+			    ahb_read_addr +
+			    q->selected * fsl_qspi_memsize_per_cs(q),
+			    op->data.nbytes);
 }
 
 static void fsl_qspi_fill_txfifo(struct fsl_qspi *q,
@@ -779,10 +780,53 @@ static int fsl_qspi_default_setup(struct fsl_qspi *q)
 	return 0;
 }
 
+static int fsl_qspi_dirmap_create(struct spi_mem_dirmap_desc *desc)
+{
+	struct fsl_qspi *q = dev_get_priv(desc->slave->dev->parent);
+
+	/*
+	 * Only the full AHB map covers the whole flash, which lets a read of
+	 * any length go straight through it. Writes still use IP commands.
+	 */
+	if (!IS_ENABLED(CONFIG_FSL_QSPI_AHB_FULL_MAP) ||
+	    desc->info.op_tmpl.data.dir != SPI_MEM_DATA_IN ||
+	    desc->info.offset + desc->info.length > fsl_qspi_memsize_per_cs(q))
+		return -EOPNOTSUPP;
+
+	return 0;
+}
+
+static ssize_t fsl_qspi_dirmap_read(struct spi_mem_dirmap_desc *desc,
+				    u64 offs, size_t len, void *buf)
+{
+	struct fsl_qspi *q = dev_get_priv(desc->slave->dev->parent);
+	struct spi_mem_op op = desc->info.op_tmpl;
+	void __iomem *base = q->iobase;
+
+	op.addr.val = desc->info.offset + offs;
+	op.data.nbytes = len;
+	op.data.buf.in = buf;
+
+	/* wait for the controller being ready */
+	fsl_qspi_readl_poll_tout(q, base + QUADSPI_SR, (QUADSPI_SR_IP_ACC_MASK |
+				 QUADSPI_SR_AHB_ACC_MASK), 10, 1000);
+
+	fsl_qspi_select_mem(q, desc->slave);
+	fsl_qspi_prepare_lut(q, &op);
+	fsl_qspi_read_ahb(q, &op);
+
+	/* Invalidate the data in the AHB buffer. */
+	fsl_qspi_invalidate(q);
+
+	return len;
+}
+
 static const struct spi_controller_mem_ops fsl_qspi_mem_ops = {
 	.adjust_op_size = fsl_qspi_adjust_op_size,
 	.supports_op = fsl_qspi_supports_op,
 	.exec_op = fsl_qspi_exec_op,
+	.dirmap_create = fsl_qspi_dirmap_create,
+	.dirmap_read = fsl_qspi_dirmap_read,
 };
 
 static int fsl_qspi_probe(struct udevice *bus)
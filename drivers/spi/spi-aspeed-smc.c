@@ -738,7 +738,8 @@ static ssize_t aspeed_spi_dirmap_read(struct spi_mem_dirmap_desc *desc,
 		if (ret != 0)
 			return 0;
 	} else {
-		memcpy_fromio(buf, priv->flashes[cs].ahb_base + offs, len);
+		spi_mem_dirmap_copy(buf, priv->flashes[cs].ahb_base + offs,
+				    len);
 	}
 
 	return len;
@@ -14,6 +14,7 @@
 #include "internals.h"
 #else
 #include <dm.h>
+#include <dma.h>
 #include <errno.h>
 #include <malloc.h>
 #include <spi.h>
@@ -22,6 +23,7 @@
 #include <dm/device_compat.h>
 #include <dm/devres.h>
 #include <linux/bug.h>
+#include <linux/io.h>
 #endif
 
 #ifndef __UBOOT__
@@ -399,7 +401,8 @@ int spi_mem_exec_op(struct spi_slave *slave, const struct spi_mem_op *op)
 	 */
 	u8 op_buf[op_len];
 
-	op_buf[pos++] = op->cmd.opcode;
+	if (op->cmd.nbytes)
+		op_buf[pos++] = op->cmd.opcode;
 
 	if (op->addr.nbytes) {
 		for (i = 0; i < op->addr.nbytes; i++)
@@ -722,6 +725,31 @@ ssize_t spi_mem_dirmap_read(struct spi_mem_dirmap_desc *desc,
 }
 EXPORT_SYMBOL_GPL(spi_mem_dirmap_read);
 
+/**
+ * spi_mem_dirmap_copy() - Copy data out of a memory-mapped flash window
+ * @buf: destination buffer
+ * @src: address in the controller's memory-mapped window
+ * @len: length in bytes
+ *
+ * Controller drivers can use this in their ->dirmap_read() method, or any
+ * other place where they read from their memory-mapped window. With
+ * CONFIG_SPI_DIRMAP_DMA the copy is handed to a DMA device which can copy
+ * memory to memory, if there is one, since a CPU copy from the window runs
+ * at the speed of the SPI bus with the CPU stalled throughout. Small copies,
+ * and those the DMA device fails, are done by the CPU.
+ */
+void spi_mem_dirmap_copy(void *buf, const void __iomem *src, size_t len)
+{
+#if IS_ENABLED(CONFIG_SPI_DIRMAP_DMA)
+	if (len >= CONFIG_SPI_DIRMAP_DMA_MIN &&
+	    dma_memcpy(buf, (void *)src, len) >= 0)
+		return;
+#endif
+
+	memcpy_fromio(buf, src, len);
+}
+EXPORT_SYMBOL_GPL(spi_mem_dirmap_copy);
+
 /**
  * spi_mem_dirmap_write() - Write data through a direct mapping
  * @desc: direct mapping descriptor
@@ -51,6 +51,20 @@ static bool tpm_tis_check_locality(struct udevice *dev, int loc)
 	return false;
 }
 
+/**
+ * tpm_tis_poll_delay - Wait before polling the TPM again
+ *
+ * The TPM is often ready again after a few microseconds, so the delay starts
+ * short and doubles on each retry, up to TPM_TIMEOUT_MS
+ *
+ * @delay_us: delay to wait, updated to the delay to use next time
+ */
+static void tpm_tis_poll_delay(uint *delay_us)
+{
+	udelay(*delay_us);
+	*delay_us = min(*delay_us * 2, (uint)TPM_TIMEOUT_MS * 1000);
+}
+
 /**
  * tpm_tis_request_locality - Request a locality from the TPM
  *
@@ -65,6 +79,7 @@ int tpm_tis_request_locality(struct udevice *dev, int loc)
 	struct tpm_tis_phy_ops *phy_ops = chip->phy_ops;
 	u8 buf = TPM_ACCESS_REQUEST_USE;
 	unsigned long start, stop;
+	uint delay_us = TPM_POLL_MIN_US;
 
 	if (tpm_tis_check_locality(dev, loc))
 		return 0;
@@ -75,7 +90,7 @@ int tpm_tis_request_locality(struct udevice *dev, int loc)
 	do {
 		if (tpm_tis_check_locality(dev, loc))
 			return 0;
-		mdelay(TPM_TIMEOUT_MS);
+		tpm_tis_poll_delay(&delay_us);
 	} while (get_timer(start) < stop);
 
 	return -1;
@@ -146,16 +161,17 @@ static int tpm_tis_wait_for_stat(struct udevice *dev, u8 mask,
 {
 	unsigned long start = get_timer(0);
 	unsigned long stop = timeout;
+	uint delay_us = TPM_POLL_MIN_US;
 	int ret;
 
 	do {
-		mdelay(TPM_TIMEOUT_MS);
 		ret = tpm_tis_status(dev, status);
 		if (ret)
 			return ret;
 
 		if ((*status & mask) == mask)
 			return 0;
+		tpm_tis_poll_delay(&delay_us);
 	} while (get_timer(start) < stop);
 
 	return -ETIMEDOUT;
@@ -174,6 +190,7 @@ static int tpm_tis_get_burstcount(struct udevice *dev, size_t *burstcount)
 	struct tpm_chip *chip = dev_get_priv(dev);
 	struct tpm_tis_phy_ops *phy_ops = chip->phy_ops;
 	unsigned long start, stop;
+	uint delay_us = TPM_POLL_MIN_US;
 	u32 burst;
 
 	if (chip->locality < 0)
@@ -192,7 +209,7 @@ static int tpm_tis_get_burstcount(struct udevice *dev, size_t *burstcount)
 		if (*burstcount)
 			return 0;
 
-		mdelay(TPM_TIMEOUT_MS);
+		tpm_tis_poll_delay(&delay_us);
 	} while (get_timer(start) < stop);
 
 	return -ETIMEDOUT;
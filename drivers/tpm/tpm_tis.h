@@ -96,6 +96,9 @@ enum tpm_timeout {
 	SLEEP_DURATION_LONG_US		= 210,
 };
 
+/* Shortest delay between polls of the TPM, doubled on each retry */
+#define TPM_POLL_MIN_US			20
+
 /* Size of external transmit buffer (used in tpm_transmit)*/
 #define TPM_BUFSIZE 4096
 
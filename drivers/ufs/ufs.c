@@ -21,6 +21,7 @@
 #include <scsi.h>
 #include <asm/io.h>
 #include <asm/dma-mapping.h>
+#include <asm/unaligned.h>
 #include <linux/bitops.h>
 #include <linux/delay.h>
 #include <linux/dma-mapping.h>
@@ -59,6 +60,23 @@
 /* maximum bytes per request */
 #define UFS_MAX_BYTES	(128 * 256 * 1024)
 
+/* size of each command when a large read is split up and queued */
+#define UFS_QUEUE_CHUNK	(4 * MAX_PRDT_ENTRY)
+
+/*
+ * Transfer request descriptors are only 32 bytes, so several share a cache
+ * line. Leave gaps between the slots in use, so that preparing one slot
+ * never writes back a line which the controller is updating for another.
+ */
+#define UFS_SLOT_STRIDE	\
+	max_t(int, 1, ARCH_DMA_MINALIGN / sizeof(struct utp_transfer_req_desc))
+
+/* Get the task tag (and doorbell bit) used by a slot */
+static inline int ufshcd_slot_tag(int slot)
+{
+	return slot * UFS_SLOT_STRIDE;
+}
+
 static inline bool ufshcd_is_hba_active(struct ufs_hba *hba);
 static inline void ufshcd_hba_stop(struct ufs_hba *hba);
 static int ufshcd_hba_enable(struct ufs_hba *hba);
@@ -602,21 +620,26 @@ static void ufshcd_host_memory_configure(struct ufs_hba *hba)
 	dma_addr_t cmd_desc_dma_addr;
 	u16 response_offset;
 	u16 prdt_offset;
+	int slot;
+
+	response_offset = offsetof(struct utp_transfer_cmd_desc, response_upiu);
+	prdt_offset = offsetof(struct utp_transfer_cmd_desc, prd_table);
 
-	utrdlp = hba->utrdl;
-	cmd_desc_dma_addr = (dma_addr_t)hba->ucdl;
+	for (slot = 0; slot < hba->queue_depth; slot++) {
+		utrdlp = &hba->utrdl[ufshcd_slot_tag(slot)];
+		cmd_desc_dma_addr = (dma_addr_t)&hba->ucdl[slot];
 
-	utrdlp->command_desc_base_addr_lo =
+		utrdlp->command_desc_base_addr_lo =
 				cpu_to_le32(lower_32_bits(cmd_desc_dma_addr));
-	utrdlp->command_desc_base_addr_hi =
+		utrdlp->command_desc_base_addr_hi =
 				cpu_to_le32(upper_32_bits(cmd_desc_dma_addr));
 
-	response_offset = offsetof(struct utp_transfer_cmd_desc, response_upiu);
-	prdt_offset = offsetof(struct utp_transfer_cmd_desc, prd_table);
-
-	utrdlp->response_upiu_offset = cpu_to_le16(response_offset >> 2);
-	utrdlp->prd_table_offset = cpu_to_le16(prdt_offset >> 2);
-	utrdlp->response_upiu_length = cpu_to_le16(ALIGNED_UPIU_SIZE >> 2);
+		utrdlp->response_upiu_offset =
+				cpu_to_le16(response_offset >> 2);
+		utrdlp->prd_table_offset = cpu_to_le16(prdt_offset >> 2);
+		utrdlp->response_upiu_length =
+				cpu_to_le16(ALIGNED_UPIU_SIZE >> 2);
+	}
 
 	hba->ucd_req_ptr = (struct utp_upiu_req *)hba->ucdl;
 	hba->ucd_rsp_ptr =
@@ -630,19 +653,28 @@ static void ufshcd_host_memory_configure(struct ufs_hba *hba)
  */
 static int ufshcd_memory_alloc(struct ufs_hba *hba)
 {
-	/* Allocate one Transfer Request Descriptor
+	int nutrs = (hba->capabilities & MASK_TRANSFER_REQUESTS_SLOTS) + 1;
+
+	/* Use every UFS_SLOT_STRIDE'th slot, up to CONFIG_UFS_QUEUE_DEPTH */
+	hba->queue_depth = min_t(int, CONFIG_UFS_QUEUE_DEPTH,
+				 DIV_ROUND_UP(nutrs, UFS_SLOT_STRIDE));
+
+	/* Allocate the Transfer Request Descriptors
 	 * Should be aligned to 1k boundary.
 	 */
-	hba->utrdl = memalign(1024, sizeof(struct utp_transfer_req_desc));
+	hba->utrdl = memalign(1024, sizeof(struct utp_transfer_req_desc) *
+			      nutrs);
 	if (!hba->utrdl) {
 		dev_err(hba->dev, "Transfer Descriptor memory allocation failed\n");
 		return -ENOMEM;
 	}
+	memset(hba->utrdl, '\0', sizeof(struct utp_transfer_req_desc) * nutrs);
 
-	/* Allocate one Command Descriptor
+	/* Allocate one Command Descriptor for each slot in use
 	 * Should be aligned to 1k boundary.
 	 */
-	hba->ucdl = memalign(1024, sizeof(struct utp_transfer_cmd_desc));
+	hba->ucdl = memalign(1024, sizeof(struct utp_transfer_cmd_desc) *
+			     hba->queue_depth);
 	if (!hba->ucdl) {
 		dev_err(hba->dev, "Command descriptor memory allocation failed\n");
 		return -ENOMEM;
@@ -710,11 +742,12 @@ static void ufshcd_cache_flush_and_invalidate(void *addr, unsigned long size)
  * ufshcd_prepare_req_desc_hdr() - Fills the requests header
  * descriptor according to request
  */
-static void ufshcd_prepare_req_desc_hdr(struct ufs_hba *hba,
+static void ufshcd_prepare_req_desc_hdr(struct ufs_hba *hba, int slot,
 					u32 *upiu_flags,
 					enum dma_data_direction cmd_dir)
 {
-	struct utp_transfer_req_desc *req_desc = hba->utrdl;
+	struct utp_transfer_req_desc *req_desc =
+		&hba->utrdl[ufshcd_slot_tag(slot)];
 	u32 data_direction;
 	u32 dword_0;
 
@@ -821,7 +854,7 @@ static int ufshcd_comp_devman_upiu(struct ufs_hba *hba,
 
 	hba->dev_cmd.type = cmd_type;
 
-	ufshcd_prepare_req_desc_hdr(hba, &upiu_flags, DMA_NONE);
+	ufshcd_prepare_req_desc_hdr(hba, TASK_TAG, &upiu_flags, DMA_NONE);
 	switch (cmd_type) {
 	case DEV_CMD_TYPE_QUERY:
 		ufshcd_prepare_utp_query_req_upiu(hba, upiu_flags);
@@ -1410,16 +1443,20 @@ static int ufshcd_uic_change_pwr_mode(struct ufs_hba *hba, u8 mode)
 }
 
 static
-void ufshcd_prepare_utp_scsi_cmd_upiu(struct ufs_hba *hba,
+void ufshcd_prepare_utp_scsi_cmd_upiu(struct ufs_hba *hba, int slot,
 				      struct scsi_cmd *pccb, u32 upiu_flags)
 {
-	struct utp_upiu_req *ucd_req_ptr = hba->ucd_req_ptr;
+	struct utp_transfer_cmd_desc *cmd_desc = &hba->ucdl[slot];
+	struct utp_upiu_req *ucd_req_ptr =
+		(struct utp_upiu_req *)cmd_desc->command_upiu;
+	struct utp_upiu_rsp *ucd_rsp_ptr =
+		(struct utp_upiu_rsp *)cmd_desc->response_upiu;
 	unsigned int cdb_len;
 
 	/* command descriptor fields */
 	ucd_req_ptr->header.dword_0 =
 			UPIU_HEADER_DWORD(UPIU_TRANSACTION_COMMAND, upiu_flags,
-					  pccb->lun, TASK_TAG);
+					  pccb->lun, ufshcd_slot_tag(slot));
 	ucd_req_ptr->header.dword_1 =
 			UPIU_HEADER_DWORD(UPIU_COMMAND_SET_TYPE_SCSI, 0, 0, 0);
 
@@ -1432,9 +1469,9 @@ void ufshcd_prepare_utp_scsi_cmd_upiu(struct ufs_hba *hba,
 	memset(ucd_req_ptr->sc.cdb, 0, UFS_CDB_SIZE);
 	memcpy(ucd_req_ptr->sc.cdb, pccb->cmd, cdb_len);
 
-	memset(hba->ucd_rsp_ptr, 0, sizeof(struct utp_upiu_rsp));
+	memset(ucd_rsp_ptr, 0, sizeof(struct utp_upiu_rsp));
 	ufshcd_cache_flush_and_invalidate(ucd_req_ptr, sizeof(*ucd_req_ptr));
-	ufshcd_cache_flush_and_invalidate(hba->ucd_rsp_ptr, sizeof(*hba->ucd_rsp_ptr));
+	ufshcd_cache_flush_and_invalidate(ucd_rsp_ptr, sizeof(*ucd_rsp_ptr));
 }
 
 static inline void prepare_prdt_desc(struct ufshcd_sg_entry *entry,
@@ -1445,10 +1482,12 @@ static inline void prepare_prdt_desc(struct ufshcd_sg_entry *entry,
 	entry->upper_addr = cpu_to_le32(upper_32_bits((unsigned long)buf));
 }
 
-static void prepare_prdt_table(struct ufs_hba *hba, struct scsi_cmd *pccb)
+static void prepare_prdt_table(struct ufs_hba *hba, int slot,
+			       struct scsi_cmd *pccb)
 {
-	struct utp_transfer_req_desc *req_desc = hba->utrdl;
-	struct ufshcd_sg_entry *prd_table = hba->ucd_prdt_ptr;
+	struct utp_transfer_req_desc *req_desc =
+		&hba->utrdl[ufshcd_slot_tag(slot)];
+	struct ufshcd_sg_entry *prd_table = hba->ucdl[slot].prd_table;
 	uintptr_t aaddr = (uintptr_t)(pccb->pdata) & ~(ARCH_DMA_MINALIGN - 1);
 	ulong datalen = pccb->datalen;
 	int table_length;
@@ -1487,26 +1526,26 @@ static void prepare_prdt_table(struct ufs_hba *hba, struct scsi_cmd *pccb)
 	ufshcd_cache_flush_and_invalidate(req_desc, sizeof(*req_desc));
 }
 
-static int ufs_scsi_exec(struct udevice *scsi_dev, struct scsi_cmd *pccb)
+/* Check the result of a SCSI command which has completed in a slot */
+static int ufshcd_scsi_result(struct ufs_hba *hba, int slot)
 {
-	struct ufs_hba *hba = dev_get_uclass_priv(scsi_dev->parent);
-	u32 upiu_flags;
-	int ocs, result = 0;
+	struct utp_transfer_req_desc *req_desc =
+		&hba->utrdl[ufshcd_slot_tag(slot)];
+	struct utp_upiu_rsp *ucd_rsp_ptr =
+		(struct utp_upiu_rsp *)hba->ucdl[slot].response_upiu;
+	int ocs, result;
 	u8 scsi_status;
 
-	ufshcd_prepare_req_desc_hdr(hba, &upiu_flags, pccb->dma_dir);
-	ufshcd_prepare_utp_scsi_cmd_upiu(hba, pccb, upiu_flags);
-	prepare_prdt_table(hba, pccb);
-
-	ufshcd_send_command(hba, TASK_TAG);
+	ufshcd_cache_flush_and_invalidate(req_desc, sizeof(*req_desc));
+	ufshcd_cache_flush_and_invalidate(ucd_rsp_ptr, sizeof(*ucd_rsp_ptr));
 
-	ocs = ufshcd_get_tr_ocs(hba);
+	ocs = le32_to_cpu(req_desc->header.dword_2) & MASK_OCS;
 	switch (ocs) {
 	case OCS_SUCCESS:
-		result = ufshcd_get_req_rsp(hba->ucd_rsp_ptr);
+		result = ufshcd_get_req_rsp(ucd_rsp_ptr);
 		switch (result) {
 		case UPIU_TRANSACTION_RESPONSE:
-			result = ufshcd_get_rsp_upiu_result(hba->ucd_rsp_ptr);
+			result = ufshcd_get_rsp_upiu_result(ucd_rsp_ptr);
 
 			scsi_status = result & MASK_SCSI_STATUS;
 			if (scsi_status)
@@ -1533,6 +1572,151 @@ static int ufs_scsi_exec(struct udevice *scsi_dev, struct scsi_cmd *pccb)
 	return 0;
 }
 
+/* Get the start and length of a READ(10) or READ(16) command */
+static bool ufs_scsi_get_read(struct scsi_cmd *pccb, u64 *lba, u32 *blocks)
+{
+	switch (pccb->cmd[0]) {
+	case SCSI_READ10:
+		*lba = get_unaligned_be32(&pccb->cmd[2]);
+		*blocks = get_unaligned_be16(&pccb->cmd[7]);
+		return true;
+	case SCSI_READ16:
+		*lba = get_unaligned_be64(&pccb->cmd[2]);
+		*blocks = get_unaligned_be32(&pccb->cmd[10]);
+		return true;
+	default:
+		return false;
+	}
+}
+
+static void ufs_scsi_set_read(struct scsi_cmd *pccb, u64 lba, u32 blocks)
+{
+	if (pccb->cmd[0] == SCSI_READ10) {
+		put_unaligned_be32(lba, &pccb->cmd[2]);
+		put_unaligned_be16(blocks, &pccb->cmd[7]);
+	} else {
+		put_unaligned_be64(lba, &pccb->cmd[2]);
+		put_unaligned_be32(blocks, &pccb->cmd[10]);
+	}
+}
+
+/*
+ * Split a large read into UFS_QUEUE_CHUNK-sized commands and keep up to
+ * queue_depth of them outstanding, each in its own slot. The controller
+ * clears a slot's doorbell bit once its command has completed.
+ */
+static int ufs_scsi_read_queued(struct ufs_hba *hba, struct scsi_cmd *pccb,
+				u64 lba, u32 blocks)
+{
+	struct scsi_cmd chunk = *pccb;
+	u32 blksz = pccb->datalen / blocks;
+	u32 chunk_blocks = UFS_QUEUE_CHUNK / blksz;
+	u8 *buf = pccb->pdata;
+	u32 active = 0, done, doorbell, intr_status, upiu_flags;
+	ulong start;
+	int slot, err, ret = 0;
+
+	start = get_timer(0);
+	while (blocks || active) {
+		/* keep every slot busy */
+		while (blocks && active != GENMASK(hba->queue_depth - 1, 0)) {
+			u32 now_blocks = min(blocks, chunk_blocks);
+
+			slot = ffs(~active) - 1;
+			ufs_scsi_set_read(&chunk, lba, now_blocks);
+			chunk.pdata = buf;
+			chunk.datalen = now_blocks * blksz;
+
+			ufshcd_prepare_req_desc_hdr(hba, slot, &upiu_flags,
+						    DMA_FROM_DEVICE);
+			ufshcd_prepare_utp_scsi_cmd_upiu(hba, slot, &chunk,
+							 upiu_flags);
+			prepare_prdt_table(hba, slot, &chunk);
+
+			active |= BIT(slot);
+			ufshcd_writel(hba, BIT(ufshcd_slot_tag(slot)),
+				      REG_UTP_TRANSFER_REQ_DOOR_BELL);
+
+			buf += chunk.datalen;
+			lba += now_blocks;
+			blocks -= now_blocks;
+		}
+
+		intr_status = ufshcd_readl(hba, REG_INTERRUPT_STATUS);
+		if (intr_status & hba->intr_mask & UFSHCD_ERROR_MASK) {
+			dev_err(hba->dev, "Error in status:%08x\n",
+				intr_status);
+			ret = -EIO;
+			break;
+		}
+
+		doorbell = ufshcd_readl(hba, REG_UTP_TRANSFER_REQ_DOOR_BELL);
+		for (done = 0, slot = 0; slot < hba->queue_depth; slot++) {
+			if ((active & BIT(slot)) &&
+			    !(doorbell & BIT(ufshcd_slot_tag(slot))))
+				done |= BIT(slot);
+		}
+		if (!done) {
+			if (get_timer(start) > QUERY_REQ_TIMEOUT) {
+				dev_err(hba->dev,
+					"Timedout waiting for UTP response\n");
+				ret = -ETIMEDOUT;
+				break;
+			}
+			continue;
+		}
+
+		start = get_timer(0);
+		for (; done; done &= ~BIT(slot)) {
+			slot = ffs(done) - 1;
+			active &= ~BIT(slot);
+			err = ufshcd_scsi_result(hba, slot);
+			if (err && !ret) {
+				/* stop issuing, but let the others finish */
+				ret = err;
+				blocks = 0;
+			}
+		}
+	}
+
+	/* abandon anything still outstanding after an error */
+	if (active) {
+		u32 tags = 0;
+
+		for (slot = 0; slot < hba->queue_depth; slot++) {
+			if (active & BIT(slot))
+				tags |= BIT(ufshcd_slot_tag(slot));
+		}
+		ufshcd_writel(hba, ~tags, REG_UTP_TRANSFER_REQ_LIST_CLEAR);
+	}
+	ufshcd_writel(hba, ufshcd_readl(hba, REG_INTERRUPT_STATUS),
+		      REG_INTERRUPT_STATUS);
+
+	return ret;
+}
+
+static int ufs_scsi_exec(struct udevice *scsi_dev, struct scsi_cmd *pccb)
+{
+	struct ufs_hba *hba = dev_get_uclass_priv(scsi_dev->parent);
+	u32 upiu_flags, blocks;
+	u64 lba;
+
+	if (hba->queue_depth > 1 && pccb->dma_dir == DMA_FROM_DEVICE &&
+	    pccb->datalen > UFS_QUEUE_CHUNK &&
+	    ufs_scsi_get_read(pccb, &lba, &blocks) && blocks &&
+	    !(pccb->datalen % blocks) &&
+	    pccb->datalen / blocks <= UFS_QUEUE_CHUNK)
+		return ufs_scsi_read_queued(hba, pccb, lba, blocks);
+
+	ufshcd_prepare_req_desc_hdr(hba, TASK_TAG, &upiu_flags, pccb->dma_dir);
+	ufshcd_prepare_utp_scsi_cmd_upiu(hba, TASK_TAG, pccb, upiu_flags);
+	prepare_prdt_table(hba, TASK_TAG, pccb);
+
+	ufshcd_send_command(hba, TASK_TAG);
+
+	return ufshcd_scsi_result(hba, TASK_TAG);
+}
+
 static inline int ufshcd_read_desc(struct ufs_hba *hba, enum desc_idn desc_id,
 				   int desc_index, u8 *buf, u32 size)
 {
@@ -741,6 +741,8 @@ struct ufs_hba {
 	struct utp_upiu_req *ucd_req_ptr;
 	struct utp_upiu_rsp *ucd_rsp_ptr;
 	struct ufshcd_sg_entry *ucd_prdt_ptr;
+	/* Number of transfer request slots used for queued reads */
+	int queue_depth;
 
 	/* Power Mode information */
 	enum ufs_dev_pwr_mode curr_dev_pwr_mode;
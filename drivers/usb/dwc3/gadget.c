@@ -779,6 +779,20 @@ static void dwc3_prepare_one_trb(struct dwc3_ep *dep,
 	dwc3_flush_cache((uintptr_t)trb, sizeof(*trb));
 }
 
+/*
+ * dwc3_gadget_can_chain - check whether requests can be chained on an endpoint
+ * @dep: endpoint to check
+ *
+ * Several queued requests on a bulk endpoint can be put in one transfer,
+ * with one TRB each. Otherwise each transfer has a single request.
+ */
+static bool dwc3_gadget_can_chain(struct dwc3_ep *dep)
+{
+	return IS_ENABLED(CONFIG_USB_DWC3_GADGET_CHAIN) &&
+		usb_endpoint_xfer_bulk(dep->endpoint.desc) &&
+		!dep->stream_capable;
+}
+
 /*
  * dwc3_prepare_trbs - setup TRBs from requests
  * @dep: endpoint for which requests are being prepared
@@ -841,15 +855,26 @@ static void dwc3_prepare_trbs(struct dwc3_ep *dep, bool starting)
 
 	list_for_each_entry_safe(req, n, &dep->request_list, list) {
 		unsigned	length;
+		unsigned	last = true;
 		dma_addr_t	dma;
 
 		dma = req->request.dma;
 		length = req->request.length;
+		trbs_left--;
+
+		/*
+		 * Chain the next request on to this one, so the controller
+		 * moves straight on to it. Each still gets its own interrupt.
+		 */
+		if (dwc3_gadget_can_chain(dep) && trbs_left &&
+		    &n->list != &dep->request_list)
+			last = false;
 
 		dwc3_prepare_one_trb(dep, req, dma, length,
-				     true, false, 0);
+				     last, false, 0);
 
-		break;
+		if (last)
+			break;
 	}
 }
 
@@ -1795,6 +1820,26 @@ static int dwc3_cleanup_done_reqs(struct dwc3 *dwc, struct dwc3_ep *dep,
 		return 1;
 	}
 
+	if (dwc3_gadget_can_chain(dep) && !list_empty(&dep->req_queued)) {
+		/* The rest of the chain is still in progress */
+		if (event->endpoint_event != DWC3_DEPEVT_XFERCOMPLETE)
+			return 0;
+
+		/*
+		 * A short packet ended the transfer early, so the rest of the
+		 * chain was not used. Take the TRBs back and start the requests
+		 * again in the next transfer.
+		 */
+		list_for_each_entry(req, &dep->req_queued, list) {
+			req->trb->ctrl &= ~DWC3_TRB_CTRL_HWO;
+			dwc3_flush_cache((uintptr_t)req->trb, sizeof(*req->trb));
+			req->trb = NULL;
+			req->queued = false;
+		}
+		list_splice_init(&dep->req_queued, &dep->request_list);
+		dep->busy_slot = dep->free_slot;
+	}
+
 	return 1;
 }
 
@@ -466,7 +466,7 @@ static void reconfig_usbd(struct dwc2_udc *dev)
 	unsigned int uTemp = writel(CORE_SOFT_RESET, &reg->grstctl);
 	uint32_t dflt_gusbcfg;
 	uint32_t rx_fifo_sz, tx_fifo_sz, np_tx_fifo_sz;
-	u32 max_hw_ep;
+	u32 max_hw_ep, hwcfg3;
 	int pdata_hw_ep;
 
 	debug("Resetting OTG controller\n");
@@ -550,6 +550,15 @@ static void reconfig_usbd(struct dwc2_udc *dev)
 	writel((np_tx_fifo_sz << 16) | rx_fifo_sz,
 	       &reg->gnptxfsiz);
 
+	/* retrieve the widths of the transfer size and packet count fields */
+	hwcfg3 = readl(&reg->ghwcfg3);
+	i = (hwcfg3 & GHWCFG3_XFER_SIZE_WIDTH_MASK) >>
+		GHWCFG3_XFER_SIZE_WIDTH_SHIFT;
+	dev->xfer_size_max = (1 << (11 + i)) - 1;
+	i = (hwcfg3 & GHWCFG3_PKT_SIZE_WIDTH_MASK) >>
+		GHWCFG3_PKT_SIZE_WIDTH_SHIFT;
+	dev->pkt_count_max = (1 << (4 + i)) - 1;
+
 	/* retrieve the number of IN Endpoints (excluding ep0) */
 	max_hw_ep = (readl(&reg->ghwcfg4) & GHWCFG4_NUM_IN_EPS_MASK) >>
 		    GHWCFG4_NUM_IN_EPS_SHIFT;
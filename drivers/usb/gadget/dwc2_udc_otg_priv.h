@@ -15,8 +15,6 @@
 #include <usb/dwc2_udc.h>
 
 /*-------------------------------------------------------------------------*/
-/* DMA bounce buffer size, 16K is enough even for mass storage */
-#define DMA_BUFFER_SIZE	(16*SZ_1K)
 
 #define EP0_FIFO_SIZE		64
 #define EP_FIFO_SIZE		512
@@ -80,6 +78,10 @@ struct dwc2_udc {
 	int ep0state;
 	struct dwc2_ep ep[DWC2_MAX_ENDPOINTS];
 
+	/* Largest values of the transfer size and packet count fields */
+	u32 xfer_size_max;
+	u32 pkt_count_max;
+
 	unsigned char usb_address;
 
 	unsigned req_pending:1, req_std:1;
@@ -63,7 +63,8 @@ struct dwc2_usbotg_reg {
 	u32 gnptxfsiz; /* Non-Periodic Transmit FIFO Size */
 	u8  res0[12];
 	u32 ggpio;     /* 0x038 */
-	u8  res1[20];
+	u8  res1[16];
+	u32 ghwcfg3; /* User HW Config3 */
 	u32 ghwcfg4; /* User HW Config4 */
 	u8  res2[176];
 	u32 dieptxf[15]; /* Device Periodic Transmit FIFO size register */
@@ -275,7 +276,6 @@ struct dwc2_usbotg_reg {
 #define DOEPT_SIZ_PKT_CNT(x)                      (x << 19)
 #define DOEPT_SIZ_XFER_SIZE(x)                    (x << 0)
 #define DOEPT_SIZ_XFER_SIZE_MAX_EP0               (0x7F << 0)
-#define DOEPT_SIZ_XFER_SIZE_MAX_EP                (0x7FFF << 0)
 
 /* Device Endpoint-N Control Register (DIEPCTLn/DOEPCTLn) */
 #define DIEPCTL_TX_FIFO_NUM(x)                    (x << 22)
@@ -285,6 +285,12 @@ struct dwc2_usbotg_reg {
 #define DAINT_IN_EP_INT(x)                        (x << 0)
 #define DAINT_OUT_EP_INT(x)                       (x << 16)
 
+/* User HW Config3 */
+#define GHWCFG3_XFER_SIZE_WIDTH_MASK	(0xf << 0)
+#define GHWCFG3_XFER_SIZE_WIDTH_SHIFT	0
+#define GHWCFG3_PKT_SIZE_WIDTH_MASK	(0x7 << 4)
+#define GHWCFG3_PKT_SIZE_WIDTH_SHIFT	4
+
 /* User HW Config4 */
 #define GHWCFG4_NUM_IN_EPS_MASK		(0xf << 26)
 #define GHWCFG4_NUM_IN_EPS_SHIFT	26
@@ -93,6 +93,20 @@ static inline void dwc2_ep0_complete_out(void)
 }
 
 
+/*
+ * Largest amount a non-control endpoint can transfer in one go, which is set
+ * by the widths of the transfer size and packet count fields
+ */
+static u32 dwc2_max_xfer(struct dwc2_ep *ep)
+{
+	struct dwc2_udc *dev = ep->dev;
+	u32 max;
+
+	max = min(dev->xfer_size_max, dev->pkt_count_max * ep->ep.maxpacket);
+
+	return rounddown(max, ep->ep.maxpacket);
+}
+
 static int setdma_rx(struct dwc2_ep *ep, struct dwc2_request *req)
 {
 	u32 *buf, ctrl;
@@ -101,7 +115,7 @@ static int setdma_rx(struct dwc2_ep *ep, struct dwc2_request *req)
 
 	buf = req->req.buf + req->req.actual;
 	length = min_t(u32, req->req.length - req->req.actual,
-		       ep_num ? DMA_BUFFER_SIZE : ep->ep.maxpacket);
+		       ep_num ? dwc2_max_xfer(ep) : ep->ep.maxpacket);
 
 	ep->len = length;
 	ep->dma_buf = buf;
@@ -146,6 +160,8 @@ static int setdma_tx(struct dwc2_ep *ep, struct dwc2_request *req)
 
 	if (ep_num == EP0_CON)
 		length = min(length, (u32)ep_maxpacket(ep));
+	else
+		length = min(length, dwc2_max_xfer(ep));
 
 	ep->len = length;
 	ep->dma_buf = buf;
@@ -213,7 +229,7 @@ static void complete_rx(struct dwc2_udc *dev, u8 ep_num)
 	if (ep_num == EP0_CON)
 		xfer_size = (ep_tsr & DOEPT_SIZ_XFER_SIZE_MAX_EP0);
 	else
-		xfer_size = (ep_tsr & DOEPT_SIZ_XFER_SIZE_MAX_EP);
+		xfer_size = (ep_tsr & dev->xfer_size_max);
 
 	xfer_size = ep->len - xfer_size;
 
@@ -38,6 +38,17 @@
  * that expect bulk OUT requests to be divisible by maxpacket size.
  */
 
+/*
+ * Size of the buffer for downloads. When downloads are written as they
+ * arrive, the next data is received while the previous data is written.
+ */
+#if CONFIG_IS_ENABLED(FASTBOOT_STREAM)
+#define RX_BUFFER_SIZE	max(EP_BUFFER_SIZE, \
+			    ALIGN(CONFIG_FASTBOOT_STREAM_SIZE, EP_BUFFER_SIZE))
+#else
+#define RX_BUFFER_SIZE	EP_BUFFER_SIZE
+#endif
+
 struct f_fastboot {
 	struct usb_function usb_function;
 
@@ -294,7 +305,7 @@ static void fastboot_disable(struct usb_function *f)
 	}
 }
 
-static struct usb_request *fastboot_start_ep(struct usb_ep *ep)
+static struct usb_request *fastboot_start_ep(struct usb_ep *ep, size_t size)
 {
 	struct usb_request *req;
 
@@ -303,7 +314,7 @@ static struct usb_request *fastboot_start_ep(struct usb_ep *ep)
 		return NULL;
 
 	req->length = EP_BUFFER_SIZE;
-	req->buf = memalign(CONFIG_SYS_CACHELINE_SIZE, EP_BUFFER_SIZE);
+	req->buf = memalign(CONFIG_SYS_CACHELINE_SIZE, size);
 	if (!req->buf) {
 		usb_ep_free_request(ep, req);
 		return NULL;
@@ -332,7 +343,7 @@ static int fastboot_set_alt(struct usb_function *f,
 		return ret;
 	}
 
-	f_fb->out_req = fastboot_start_ep(f_fb->out_ep);
+	f_fb->out_req = fastboot_start_ep(f_fb->out_ep, RX_BUFFER_SIZE);
 	if (!f_fb->out_req) {
 		puts("failed to alloc out req\n");
 		ret = -EINVAL;
@@ -347,7 +358,7 @@ static int fastboot_set_alt(struct usb_function *f,
 		goto err;
 	}
 
-	f_fb->in_req = fastboot_start_ep(f_fb->in_ep);
+	f_fb->in_req = fastboot_start_ep(f_fb->in_ep, EP_BUFFER_SIZE);
 	if (!f_fb->in_req) {
 		puts("failed alloc req in\n");
 		ret = -EINVAL;
@@ -433,8 +444,8 @@ static unsigned int rx_bytes_expected(struct usb_ep *ep)
 
 	if (rx_remain <= 0)
 		return 0;
-	else if (rx_remain > EP_BUFFER_SIZE)
-		return EP_BUFFER_SIZE;
+	else if (rx_remain > RX_BUFFER_SIZE)
+		return RX_BUFFER_SIZE;
 
 	/*
 	 * Some controllers e.g. DWC3 don't like OUT transfers to be
@@ -483,6 +494,10 @@ static void rx_handler_dl_image(struct usb_ep *ep, struct usb_request *req)
 
 	req->actual = 0;
 	usb_ep_queue(ep, req, 0);
+
+	/* Write the data while the next data is received */
+	if (!response[0])
+		fastboot_data_stream();
 }
 
 static void do_exit_on_complete(struct usb_ep *ep, struct usb_request *req)
@@ -693,7 +693,126 @@ static int sleep_thread(struct fsg_common *common)
 
 /*-------------------------------------------------------------------------*/
 
-static int do_read(struct fsg_common *common)
+/* Figure out how much we need to read:
+ * Try to read the remaining amount.
+ * But don't read more than the buffer size.
+ * Finally, if we're not at a page boundary, don't read past
+ *	the next page. */
+static unsigned int fsg_read_amount(loff_t file_offset, u32 amount_left)
+{
+	unsigned int amount, partial_page;
+
+	amount = min(amount_left, FSG_BUFLEN);
+	partial_page = file_offset & (PAGE_CACHE_SIZE - 1);
+	if (partial_page > 0)
+		amount = min(amount, (unsigned int) PAGE_CACHE_SIZE -
+				partial_page);
+
+	return amount;
+}
+
+#if CONFIG_IS_ENABLED(BLK_ASYNC)
+/**
+ * fsg_read_ahead() - Start storage reads into the free buffers after @bh
+ *
+ * While USB sends @bh to the host, this starts reading the data which follows
+ * it into the buffers after it, so the storage device keeps busy. Reads are
+ * started in order and stop at the first buffer which is still in use.
+ *
+ * @common: Mass storage state
+ * @bh: Buffer which has just been filled
+ * @file_offset: Offset of the data which follows that in @bh
+ * @amount_left: Amount of data left to read after @bh
+ */
+static void fsg_read_ahead(struct fsg_common *common, struct fsg_buffhd *bh,
+			   loff_t file_offset, u32 amount_left)
+{
+	struct fsg_lun *curlun = &common->luns[common->lun];
+	struct ums *ums_dev = &ums[common->lun];
+	unsigned int amount;
+	int i;
+
+	for (i = 1, bh = bh->next; i < FSG_NUM_BUFFERS && amount_left;
+	     i++, bh = bh->next) {
+		amount = fsg_read_amount(file_offset, amount_left);
+		if (!bh->reading) {
+			struct blk_req *req = &bh->req;
+
+			if (bh->state != BUF_STATE_EMPTY)
+				break;
+			req->start = ums_dev->start_sector +
+				lldiv(file_offset, curlun->blksize);
+			req->blkcnt = lldiv(amount, curlun->blksize);
+			req->buffer = bh->buf;
+			if (blk_submit_read(ums_dev->block_dev.bdev, req))
+				break;
+			bh->reading = true;
+		}
+		file_offset += amount;
+		amount_left -= amount;
+	}
+}
+
+/**
+ * fsg_read_ahead_end() - Wait for any storage reads started ahead of time
+ *
+ * This must be called before the buffers are used for anything else.
+ *
+ * @common: Mass storage state
+ */
+static void fsg_read_ahead_end(struct fsg_common *common)
+{
+	struct ums *ums_dev = &ums[common->lun];
+	int i;
+
+	for (i = 0; i < FSG_NUM_BUFFERS; ++i) {
+		struct fsg_buffhd *bh = &common->buffhds[i];
+
+		if (bh->reading) {
+			blk_wait(ums_dev->block_dev.bdev, &bh->req);
+			bh->reading = false;
+		}
+	}
+}
+#else
+static inline void fsg_read_ahead(struct fsg_common *common,
+				  struct fsg_buffhd *bh, loff_t file_offset,
+				  u32 amount_left)
+{
+}
+
+static inline void fsg_read_ahead_end(struct fsg_common *common)
+{
+}
+#endif
+
+/* Read into @bh, using the data read ahead of time if there is some.
+ * Returns the number of blocks read, or 0 on error. */
+static int fsg_read_sectors(struct fsg_common *common, struct fsg_buffhd *bh,
+			    loff_t file_offset, unsigned int amount)
+{
+	struct fsg_lun *curlun = &common->luns[common->lun];
+	struct ums *ums_dev = &ums[common->lun];
+	lbaint_t start = lldiv(file_offset, curlun->blksize);
+	lbaint_t blkcnt = lldiv(amount, curlun->blksize);
+
+#if CONFIG_IS_ENABLED(BLK_ASYNC)
+	if (bh->reading) {
+		long ret;
+
+		bh->reading = false;
+		ret = blk_wait(ums_dev->block_dev.bdev, &bh->req);
+		if (bh->req.start == ums_dev->start_sector + start &&
+		    bh->req.blkcnt == blkcnt)
+			return ret < 0 ? 0 : ret;
+	}
+#endif
+
+	return ums_dev->read_sector(ums_dev, start, blkcnt,
+				    (char __user *)bh->buf);
+}
+
+static int do_read_data(struct fsg_common *common)
 {
 	struct fsg_lun		*curlun = &common->luns[common->lun];
 	u32			lba;
@@ -702,7 +821,6 @@ static int do_read(struct fsg_common *common)
 	u32			amount_left;
 	loff_t			file_offset;
 	unsigned int		amount;
-	unsigned int		partial_page;
 	ssize_t			nread;
 
 	/* Get the starting Logical Block Address and check that it's
@@ -734,19 +852,10 @@ static int do_read(struct fsg_common *common)
 
 	for (;;) {
 
-		/* Figure out how much we need to read:
-		 * Try to read the remaining amount.
-		 * But don't read more than the buffer size.
-		 * And don't try to read past the end of the file.
-		 * Finally, if we're not at a page boundary, don't read past
-		 *	the next page.
+		/* Figure out how much we need to read.
 		 * If this means reading 0 then we were asked to read past
 		 *	the end of file. */
-		amount = min(amount_left, FSG_BUFLEN);
-		partial_page = file_offset & (PAGE_CACHE_SIZE - 1);
-		if (partial_page > 0)
-			amount = min(amount, (unsigned int) PAGE_CACHE_SIZE -
-					partial_page);
+		amount = fsg_read_amount(file_offset, amount_left);
 
 		/* Wait for the next buffer to become available */
 		bh = common->next_buffhd_to_fill;
@@ -768,10 +877,7 @@ static int do_read(struct fsg_common *common)
 		}
 
 		/* Perform the read */
-		rc = ums[common->lun].read_sector(&ums[common->lun],
-				      lldiv(file_offset, curlun->blksize),
-				      lldiv(amount, curlun->blksize),
-				      (char __user *)bh->buf);
+		rc = fsg_read_sectors(common, bh, file_offset, amount);
 		if (!rc)
 			return -EIO;
 
@@ -813,12 +919,23 @@ static int do_read(struct fsg_common *common)
 			/* Don't know what to do if
 			 * common->fsg is NULL */
 			return -EIO;
+		fsg_read_ahead(common, bh, file_offset, amount_left);
 		common->next_buffhd_to_fill = bh->next;
 	}
 
 	return -EIO;		/* No default reply */
 }
 
+static int do_read(struct fsg_common *common)
+{
+	int rc;
+
+	rc = do_read_data(common);
+	fsg_read_ahead_end(common);
+
+	return rc;
+}
+
 /*-------------------------------------------------------------------------*/
 
 static int do_write(struct fsg_common *common)
@@ -91,6 +91,46 @@ int submit_bulk_msg(struct usb_device *udev, unsigned long pipe, void *buffer,
 	return ops->bulk(bus, udev, pipe, buffer, length);
 }
 
+int usb_queue_bulk_msg(struct usb_device *udev, unsigned long pipe,
+		       unsigned int stream_id, void *buffer, int length)
+{
+	struct udevice *bus = udev->controller_dev;
+	struct dm_usb_ops *ops = usb_get_ops(bus);
+
+	if (!ops->queue_bulk || !ops->reap_bulk)
+		return -ENOSYS;
+
+	return ops->queue_bulk(bus, udev, pipe, stream_id, buffer, length);
+}
+
+int usb_reap_bulk_msg(struct usb_device *udev, unsigned long pipe)
+{
+	struct udevice *bus = udev->controller_dev;
+	struct dm_usb_ops *ops = usb_get_ops(bus);
+	int ret;
+
+	if (!ops->reap_bulk)
+		return -ENOSYS;
+
+	ret = ops->reap_bulk(bus, udev, pipe);
+	if (!ret && udev->status)
+		ret = -EIO;
+
+	return ret;
+}
+
+int usb_alloc_streams(struct usb_device *udev, unsigned long *pipes,
+		      int num_pipes, unsigned int num_streams)
+{
+	struct udevice *bus = udev->controller_dev;
+	struct dm_usb_ops *ops = usb_get_ops(bus);
+
+	if (!ops->alloc_streams || !ops->queue_bulk)
+		return -ENOSYS;
+
+	return ops->alloc_streams(bus, udev, pipes, num_pipes, num_streams);
+}
+
 struct int_queue *create_int_queue(struct usb_device *udev,
 		unsigned long pipe, int queuesize, int elementsize,
 		void *buffer, int interval)
@@ -221,25 +261,47 @@ int usb_stop(void)
 	return err;
 }
 
-static void usb_scan_bus(struct udevice *bus, bool recurse)
+/*
+ * Scan the primary controllers, or their companions. The root hubs of all
+ * of them are powered up first and their ports scanned together, so that
+ * the power-good and connect timeouts of each controller overlap rather
+ * than adding up.
+ */
+static void usb_scan_buses(struct uclass *uc, bool companion)
 {
 	struct usb_bus_priv *priv;
-	struct udevice *dev;
-	int ret;
+	struct udevice *bus, *dev;
 
-	priv = dev_get_uclass_priv(bus);
+	usb_hub_scan_defer();
+	uclass_foreach_dev(bus, uc) {
+		if (!device_active(bus))
+			continue;
 
-	assert(recurse);	/* TODO: Support non-recusive */
+		priv = dev_get_uclass_priv(bus);
+		if (priv->companion != companion)
+			continue;
 
-	printf("scanning bus %s for devices... ", bus->name);
-	debug("\n");
-	ret = usb_scan_device(bus, 0, USB_SPEED_FULL, &dev);
-	if (ret)
-		printf("failed, error %d\n", ret);
-	else if (priv->next_addr == 0)
-		printf("No USB Device found\n");
-	else
-		printf("%d USB Device(s) found\n", priv->next_addr);
+		debug("starting scan of bus %s\n", bus->name);
+		priv->scan_ret = usb_scan_device(bus, 0, USB_SPEED_FULL, &dev);
+	}
+	usb_hub_scan_pending();
+
+	uclass_foreach_dev(bus, uc) {
+		if (!device_active(bus))
+			continue;
+
+		priv = dev_get_uclass_priv(bus);
+		if (priv->companion != companion)
+			continue;
+
+		printf("scanning bus %s for devices... ", bus->name);
+		if (priv->scan_ret)
+			printf("failed, error %d\n", priv->scan_ret);
+		else if (priv->next_addr == 0)
+			printf("No USB Device found\n");
+		else
+			printf("%d USB Device(s) found\n", priv->next_addr);
+	}
 }
 
 static void remove_inactive_children(struct uclass *uc, struct udevice *bus)
@@ -291,7 +353,6 @@ int usb_init(void)
 {
 	int controllers_initialized = 0;
 	struct usb_uclass_priv *uc_priv;
-	struct usb_bus_priv *priv;
 	struct udevice *bus;
 	struct uclass *uc;
 	int ret;
@@ -350,30 +411,15 @@ int usb_init(void)
 	 * lowlevel init done, now scan the bus for devices i.e. search HUBs
 	 * and configure them, first scan primary controllers.
 	 */
-	uclass_foreach_dev(bus, uc) {
-		if (!device_active(bus))
-			continue;
-
-		priv = dev_get_uclass_priv(bus);
-		if (!priv->companion)
-			usb_scan_bus(bus, true);
-	}
+	usb_scan_buses(uc, false);
 
 	/*
 	 * Now that the primary controllers have been scanned and have handed
 	 * over any devices they do not understand to their companions, scan
 	 * the companions if necessary.
 	 */
-	if (uc_priv->companion_device_count) {
-		uclass_foreach_dev(bus, uc) {
-			if (!device_active(bus))
-				continue;
-
-			priv = dev_get_uclass_priv(bus);
-			if (priv->companion)
-				usb_scan_bus(bus, true);
-		}
-	}
+	if (uc_priv->companion_device_count)
+		usb_scan_buses(uc, true);
 
 	debug("scan end\n");
 
@@ -161,9 +161,11 @@ static void xhci_free_virt_devices(struct xhci_ctrl *ctrl)
 
 		ctrl->dcbaa->dev_context_ptrs[slot_id] = 0;
 
-		for (i = 0; i < 31; ++i)
+		for (i = 0; i < 31; ++i) {
 			if (virt_dev->eps[i].ring)
 				xhci_ring_free(ctrl, virt_dev->eps[i].ring);
+			xhci_free_stream_info(ctrl, &virt_dev->eps[i]);
+		}
 
 		if (virt_dev->in_ctx)
 			xhci_free_container_ctx(ctrl, virt_dev->in_ctx);
@@ -355,6 +357,73 @@ struct xhci_ring *xhci_ring_alloc(struct xhci_ctrl *ctrl, unsigned int num_segs,
 	return ring;
 }
 
+/**
+ * Allocate a linear stream context array for an endpoint, with one transfer
+ * ring per stream. The endpoint context still has to be pointed at the
+ * array by the caller.
+ *
+ * @ctrl		host controller data structure
+ * @ep			endpoint to set up
+ * @num_stream_ctxs	size of the array, a power of two; stream 0 is reserved
+ *			so this allows num_stream_ctxs - 1 streams
+ * Return:	0 on success, -ENOMEM if allocation fails
+ */
+int xhci_alloc_stream_info(struct xhci_ctrl *ctrl, struct xhci_virt_ep *ep,
+			   unsigned int num_stream_ctxs)
+{
+	size_t size = num_stream_ctxs * sizeof(struct xhci_stream_ctx);
+	struct xhci_ring *ring;
+	u64 addr;
+	int i;
+
+	ep->stream_rings = calloc(num_stream_ctxs, sizeof(struct xhci_ring *));
+	if (!ep->stream_rings)
+		return -ENOMEM;
+
+	ep->stream_ctx = xhci_malloc(size);
+	ep->num_stream_ctxs = num_stream_ctxs;
+
+	for (i = 1; i < num_stream_ctxs; i++) {
+		ring = xhci_ring_alloc(ctrl, 1, true);
+		ep->stream_rings[i] = ring;
+
+		addr = xhci_trb_virt_to_dma(ring->enq_seg, ring->enqueue);
+		ep->stream_ctx[i].stream_ring = cpu_to_le64(addr |
+				SCT_FOR_CTX(SCT_PRI_TR) | ring->cycle_state);
+	}
+
+	xhci_flush_cache((uintptr_t)ep->stream_ctx, size);
+	ep->stream_ctx_dma = xhci_dma_map(ctrl, ep->stream_ctx, size);
+
+	return 0;
+}
+
+/**
+ * Free the stream context array and stream rings of an endpoint, if any
+ *
+ * @ctrl	host controller data structure
+ * @ep		endpoint to clean up
+ * Return:	none
+ */
+void xhci_free_stream_info(struct xhci_ctrl *ctrl, struct xhci_virt_ep *ep)
+{
+	int i;
+
+	if (!ep->num_stream_ctxs)
+		return;
+
+	for (i = 1; i < ep->num_stream_ctxs; i++)
+		xhci_ring_free(ctrl, ep->stream_rings[i]);
+
+	xhci_dma_unmap(ctrl, ep->stream_ctx_dma,
+		       ep->num_stream_ctxs * sizeof(struct xhci_stream_ctx));
+	free(ep->stream_ctx);
+	free(ep->stream_rings);
+	ep->stream_ctx = NULL;
+	ep->stream_rings = NULL;
+	ep->num_stream_ctxs = 0;
+}
+
 /**
  * Set up the scratchpad buffer array and scratchpad buffers
  *
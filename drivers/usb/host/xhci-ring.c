@@ -280,18 +280,20 @@ static int prepare_ring(struct xhci_ctrl *ctrl, struct xhci_ring *ep_ring,
 }
 
 /**
- * Generic function for queueing a command TRB on the command ring.
- * Check to make sure there's room on the command ring for one command TRB.
+ * Queues a command TRB on the command ring, with a Stream ID for the
+ * 'set TR dequeue pointer' command of an endpoint which has streams.
  *
  * @param ctrl		Host controller data structure
  * @param ptr		Pointer address to write in the first two fields (opt.)
  * @param slot_id	Slot ID to encode in the flags field (opt.)
  * @param ep_index	Endpoint index to encode in the flags field (opt.)
+ * @param stream_id	Stream ID to encode in the status field (opt.)
  * @param cmd		Command type to enqueue
  * Return: none
  */
-void xhci_queue_command(struct xhci_ctrl *ctrl, dma_addr_t addr, u32 slot_id,
-			u32 ep_index, trb_type cmd)
+static void queue_command(struct xhci_ctrl *ctrl, dma_addr_t addr,
+			  u32 slot_id, u32 ep_index, u32 stream_id,
+			  trb_type cmd)
 {
 	u32 fields[4];
 
@@ -299,7 +301,7 @@ void xhci_queue_command(struct xhci_ctrl *ctrl, dma_addr_t addr, u32 slot_id,
 
 	fields[0] = lower_32_bits(addr);
 	fields[1] = upper_32_bits(addr);
-	fields[2] = 0;
+	fields[2] = STREAM_ID_FOR_TRB(stream_id);
 	fields[3] = TRB_TYPE(cmd) | SLOT_ID_FOR_TRB(slot_id) |
 		    ctrl->cmd_ring->cycle_state;
 
@@ -316,6 +318,23 @@ void xhci_queue_command(struct xhci_ctrl *ctrl, dma_addr_t addr, u32 slot_id,
 	xhci_writel(&ctrl->dba->doorbell[0], DB_VALUE_HOST);
 }
 
+/**
+ * Generic function for queueing a command TRB on the command ring.
+ * Check to make sure there's room on the command ring for one command TRB.
+ *
+ * @param ctrl		Host controller data structure
+ * @param ptr		Pointer address to write in the first two fields (opt.)
+ * @param slot_id	Slot ID to encode in the flags field (opt.)
+ * @param ep_index	Endpoint index to encode in the flags field (opt.)
+ * @param cmd		Command type to enqueue
+ * Return: none
+ */
+void xhci_queue_command(struct xhci_ctrl *ctrl, dma_addr_t addr, u32 slot_id,
+			u32 ep_index, trb_type cmd)
+{
+	queue_command(ctrl, addr, slot_id, ep_index, 0, cmd);
+}
+
 /*
  * For xHCI 1.0 host controllers, TD size is the number of max packet sized
  * packets remaining in the TD (*not* including this TRB).
@@ -374,12 +393,13 @@ static u32 xhci_td_remainder(struct xhci_ctrl *ctrl, int transferred,
  *
  * @param udev		pointer to the USB device structure
  * @param ep_index	index of the endpoint
+ * @param stream_id	stream the TRBs were queued on, 0 if none
  * @param start_cycle	cycle flag of the first TRB
  * @param start_trb	pionter to the first TRB
  * Return: none
  */
 static void giveback_first_trb(struct usb_device *udev, int ep_index,
-				int start_cycle,
+				unsigned int stream_id, int start_cycle,
 				struct xhci_generic_trb *start_trb)
 {
 	struct xhci_ctrl *ctrl = xhci_get_ctrl(udev);
@@ -397,7 +417,7 @@ static void giveback_first_trb(struct usb_device *udev, int ep_index,
 
 	/* Ringing EP doorbell here */
 	xhci_writel(&ctrl->dba->doorbell[udev->slot_id],
-				DB_VALUE(ep_index, 0));
+				DB_VALUE(ep_index, stream_id));
 
 	return;
 }
@@ -465,8 +485,12 @@ union xhci_trb *xhci_wait_for_event(struct xhci_ctrl *ctrl, trb_type expected)
 	do {
 		union xhci_trb *event = ctrl->event_ring->dequeue;
 
-		if (!event_ready(ctrl))
+		if (!event_ready(ctrl)) {
+			/* Let the CPU rest if the transfer is taking a while */
+			if (get_timer(ts) >= XHCI_IDLE_MS)
+				cpu_idle();
 			continue;
+		}
 
 		type = TRB_FIELD_TO_TYPE(le32_to_cpu(event->event_cmd.flags));
 		if (type == expected ||
@@ -501,6 +525,52 @@ union xhci_trb *xhci_wait_for_event(struct xhci_ctrl *ctrl, trb_type expected)
 	return NULL;
 }
 
+/*
+ * Move the xHC's dequeue pointer for a ring of the given endpoint to our
+ * enqueue pointer, throwing away any TRBs not processed yet.
+ */
+static void set_ring_deq(struct usb_device *udev, int ep_index,
+			 unsigned int stream_id, struct xhci_ring *ring)
+{
+	struct xhci_ctrl *ctrl = xhci_get_ctrl(udev);
+	union xhci_trb *event;
+	u64 addr;
+
+	addr = xhci_trb_virt_to_dma(ring->enq_seg,
+		(void *)((uintptr_t)ring->enqueue | ring->cycle_state));
+	if (stream_id)
+		addr |= SCT_FOR_CTX(SCT_PRI_TR);
+	queue_command(ctrl, addr, udev->slot_id, ep_index, stream_id,
+		      TRB_SET_DEQ);
+	event = xhci_wait_for_event(ctrl, TRB_COMPLETION);
+	if (!event)
+		return;
+
+	BUG_ON(TRB_TO_SLOT_ID(le32_to_cpu(event->event_cmd.flags))
+		!= udev->slot_id || GET_COMP_CODE(le32_to_cpu(
+		event->event_cmd.status)) != COMP_SUCCESS);
+	xhci_acknowledge_event(ctrl);
+}
+
+/*
+ * Set the dequeue pointer of each ring of a stopped or halted endpoint:
+ * the endpoint ring, or every stream ring if it has streams.
+ */
+static void set_ep_deq(struct usb_device *udev, int ep_index)
+{
+	struct xhci_ctrl *ctrl = xhci_get_ctrl(udev);
+	struct xhci_virt_ep *ep = &ctrl->devs[udev->slot_id]->eps[ep_index];
+	int i;
+
+	if (!ep->num_stream_ctxs) {
+		set_ring_deq(udev, ep_index, 0, ep->ring);
+		return;
+	}
+
+	for (i = 1; i < ep->num_stream_ctxs; i++)
+		set_ring_deq(udev, ep_index, i, ep->stream_rings[i]);
+}
+
 /*
  * Send reset endpoint command for given endpoint. This recovers from a
  * halted endpoint (e.g. due to a stall error).
@@ -508,9 +578,7 @@ union xhci_trb *xhci_wait_for_event(struct xhci_ctrl *ctrl, trb_type expected)
 static void reset_ep(struct usb_device *udev, int ep_index)
 {
 	struct xhci_ctrl *ctrl = xhci_get_ctrl(udev);
-	struct xhci_ring *ring =  ctrl->devs[udev->slot_id]->eps[ep_index].ring;
 	union xhci_trb *event;
-	u64 addr;
 	u32 field;
 
 	printf("Resetting EP %d...\n", ep_index);
@@ -523,17 +591,7 @@ static void reset_ep(struct usb_device *udev, int ep_index)
 	BUG_ON(TRB_TO_SLOT_ID(field) != udev->slot_id);
 	xhci_acknowledge_event(ctrl);
 
-	addr = xhci_trb_virt_to_dma(ring->enq_seg,
-		(void *)((uintptr_t)ring->enqueue | ring->cycle_state));
-	xhci_queue_command(ctrl, addr, udev->slot_id, ep_index, TRB_SET_DEQ);
-	event = xhci_wait_for_event(ctrl, TRB_COMPLETION);
-	if (!event)
-		return;
-
-	BUG_ON(TRB_TO_SLOT_ID(le32_to_cpu(event->event_cmd.flags))
-		!= udev->slot_id || GET_COMP_CODE(le32_to_cpu(
-		event->event_cmd.status)) != COMP_SUCCESS);
-	xhci_acknowledge_event(ctrl);
+	set_ep_deq(udev, ep_index);
 }
 
 /*
@@ -547,11 +605,9 @@ static void reset_ep(struct usb_device *udev, int ep_index)
 static void abort_td(struct usb_device *udev, int ep_index)
 {
 	struct xhci_ctrl *ctrl = xhci_get_ctrl(udev);
-	struct xhci_ring *ring =  ctrl->devs[udev->slot_id]->eps[ep_index].ring;
 	union xhci_trb *event;
 	xhci_comp_code comp;
 	trb_type type;
-	u64 addr;
 	u32 field;
 
 	xhci_queue_command(ctrl, 0, udev->slot_id, ep_index, TRB_STOP_RING);
@@ -585,59 +641,143 @@ static void abort_td(struct usb_device *udev, int ep_index)
 		!= COMP_CTX_STATE));
 	xhci_acknowledge_event(ctrl);
 
-	addr = xhci_trb_virt_to_dma(ring->enq_seg,
-		(void *)((uintptr_t)ring->enqueue | ring->cycle_state));
-	xhci_queue_command(ctrl, addr, udev->slot_id, ep_index, TRB_SET_DEQ);
-	event = xhci_wait_for_event(ctrl, TRB_COMPLETION);
-	if (!event)
-		return;
-
-	BUG_ON(TRB_TO_SLOT_ID(le32_to_cpu(event->event_cmd.flags))
-		!= udev->slot_id || GET_COMP_CODE(le32_to_cpu(
-		event->event_cmd.status)) != COMP_SUCCESS);
-	xhci_acknowledge_event(ctrl);
+	set_ep_deq(udev, ep_index);
 }
 
-static void record_transfer_result(struct usb_device *udev,
-				   union xhci_trb *event, int length)
+static unsigned long transfer_result(union xhci_trb *event, int length,
+				     int *act_len)
 {
-	udev->act_len = min(length, length -
+	*act_len = min(length, length -
 		(int)EVENT_TRB_LEN(le32_to_cpu(event->trans_event.transfer_len)));
 
 	switch (GET_COMP_CODE(le32_to_cpu(event->trans_event.transfer_len))) {
 	case COMP_SUCCESS:
-		BUG_ON(udev->act_len != length);
+		BUG_ON(*act_len != length);
 		/* fallthrough */
 	case COMP_SHORT_TX:
-		udev->status = 0;
-		break;
+		return 0;
 	case COMP_STALL:
-		udev->status = USB_ST_STALLED;
-		break;
+		return USB_ST_STALLED;
 	case COMP_DB_ERR:
 	case COMP_TRB_ERR:
-		udev->status = USB_ST_BUF_ERR;
-		break;
+		return USB_ST_BUF_ERR;
 	case COMP_BABBLE:
-		udev->status = USB_ST_BABBLE_DET;
-		break;
+		return USB_ST_BABBLE_DET;
 	default:
-		udev->status = 0x80;  /* USB_ST_TOO_LAZY_TO_MAKE_A_NEW_MACRO */
+		return 0x80;  /* USB_ST_TOO_LAZY_TO_MAKE_A_NEW_MACRO */
+	}
+}
+
+static void record_transfer_result(struct usb_device *udev,
+				   union xhci_trb *event, int length)
+{
+	udev->status = transfer_result(event, length, &udev->act_len);
+}
+
+/*
+ * Check whether a TRB is part of a TD. The TRBs of a TD are contiguous in
+ * its single-segment ring, except where the TD wraps around the link TRB.
+ */
+static bool td_holds_trb(struct xhci_td *td, u64 trb_addr)
+{
+	u64 seg_start = td->ring->first_seg->dma;
+
+	if (trb_addr < seg_start || trb_addr >= seg_start + SEGMENT_SIZE)
+		return false;
+
+	if (td->first_trb_addr <= td->last_trb_addr)
+		return trb_addr >= td->first_trb_addr &&
+		       trb_addr <= td->last_trb_addr;
+
+	return trb_addr >= td->first_trb_addr ||
+	       trb_addr <= td->last_trb_addr;
+}
+
+/**
+ * Handles a transfer event for a bulk TD, which may belong to any endpoint
+ * with TDs queued, not just the one being waited for
+ *
+ * @param ctrl	Host controller data structure
+ * @param event	transfer event TRB
+ * Return: none
+ */
+static void handle_bulk_event(struct xhci_ctrl *ctrl, union xhci_trb *event)
+{
+	u32 field = le32_to_cpu(event->trans_event.flags);
+	struct xhci_virt_device *virt_dev;
+	struct xhci_virt_ep *ep;
+	struct xhci_td *td;
+	u64 trb_addr;
+	int i, j;
+
+	virt_dev = ctrl->devs[TRB_TO_SLOT_ID(field)];
+	if (!virt_dev) {
+		printf("XHCI transfer event for unknown slot, skipping...\n");
+		return;
+	}
+	ep = &virt_dev->eps[TRB_TO_EP_INDEX(field)];
+	trb_addr = le64_to_cpu(event->trans_event.buffer);
+
+	/*
+	 * Without streams the event is for the oldest TD which has not
+	 * completed. With streams the TDs on different stream rings complete
+	 * in any order, so find the one holding the TRB.
+	 */
+	for (i = 0; i < ep->td_count; i++) {
+		td = &ep->tds[(ep->td_head + i) % XHCI_MAX_TDS];
+		if (td->done)
+			continue;
+		if (!ep->num_stream_ctxs || td_holds_trb(td, trb_addr))
+			break;
+	}
+	if (i == ep->td_count) {
+		printf("XHCI transfer event with no TD queued, skipping...\n");
+		return;
+	}
+
+	if ((uintptr_t)trb_addr != (uintptr_t)td->last_trb_addr) {
+		td->available_length -=
+			(int)EVENT_TRB_LEN(le32_to_cpu(event->trans_event.transfer_len));
+		return;
+	}
+
+	td->status = transfer_result(event, td->available_length,
+				     &td->act_len);
+	td->done = true;
+
+	/*
+	 * A stall halts the endpoint, so the other TDs on it (on any stream)
+	 * will never complete. They are thrown away when it is reset.
+	 */
+	if (td->status == USB_ST_STALLED) {
+		for (j = 0; j < ep->td_count; j++) {
+			td = &ep->tds[(ep->td_head + j) % XHCI_MAX_TDS];
+			if (td->done)
+				continue;
+			td->act_len = 0;
+			td->status = USB_ST_NOT_PROC;
+			td->done = true;
+		}
 	}
 }
 
 /**** Bulk and Control transfer methods ****/
 /**
- * Queues up the BULK Request
+ * Queues up the BULK Request and rings the doorbell, without waiting for it
+ * to complete. Several requests can be queued on an endpoint, up to the
+ * space in its transfer ring, and on several endpoints at once. Each must
+ * then be completed by xhci_bulk_reap(), in the order they were queued.
  *
  * @param udev		pointer to the USB device structure
  * @param pipe		contains the DIR_IN or OUT , devnum
+ * @param stream_id	stream to queue on, if the endpoint has streams; else 0
  * @param length	length of the buffer
  * @param buffer	buffer to be read/written based on the request
- * Return: returns 0 if successful else -1 on failure
+ * Return: 0 if successful, -EBUSY if there is no room for the request,
+ *	   other -ve on error
  */
-int xhci_bulk_tx(struct usb_device *udev, unsigned long pipe,
-			int length, void *buffer)
+int xhci_bulk_queue(struct usb_device *udev, unsigned long pipe,
+		    unsigned int stream_id, int length, void *buffer)
 {
 	int num_trbs = 0;
 	struct xhci_generic_trb *start_trb;
@@ -649,9 +789,10 @@ int xhci_bulk_tx(struct usb_device *udev, unsigned long pipe,
 	int slot_id = udev->slot_id;
 	int ep_index;
 	struct xhci_virt_device *virt_dev;
+	struct xhci_virt_ep *ep;
 	struct xhci_ep_ctx *ep_ctx;
 	struct xhci_ring *ring;		/* EP transfer ring */
-	union xhci_trb *event;
+	struct xhci_td *td;
 
 	int running_total, trb_buff_len;
 	bool more_trbs_coming = true;
@@ -659,16 +800,15 @@ int xhci_bulk_tx(struct usb_device *udev, unsigned long pipe,
 	u64 addr;
 	int ret;
 	u32 trb_fields[4];
-	u64 buf_64 = xhci_dma_map(ctrl, buffer, length);
+	u64 buf_64;
 	dma_addr_t last_transfer_trb_addr;
-	int available_length;
 
 	debug("dev=%p, pipe=%lx, buffer=%p, length=%d\n",
 		udev, pipe, buffer, length);
 
-	available_length = length;
 	ep_index = usb_pipe_ep_index(pipe);
 	virt_dev = ctrl->devs[slot_id];
+	ep = &virt_dev->eps[ep_index];
 
 	xhci_inval_cache((uintptr_t)virt_dev->out_ctx->bytes,
 			 virt_dev->out_ctx->size);
@@ -678,12 +818,24 @@ int xhci_bulk_tx(struct usb_device *udev, unsigned long pipe,
 	/*
 	 * If the endpoint was halted due to a prior error, resume it before
 	 * the next transfer. It is the responsibility of the upper layer to
-	 * have dealt with whatever caused the error.
+	 * have dealt with whatever caused the error, and to have reaped the
+	 * TDs which were queued when it happened.
 	 */
-	if ((le32_to_cpu(ep_ctx->ep_info) & EP_STATE_MASK) == EP_STATE_HALTED)
+	if ((le32_to_cpu(ep_ctx->ep_info) & EP_STATE_MASK) == EP_STATE_HALTED) {
+		if (ep->td_count)
+			return -EBUSY;
 		reset_ep(udev, ep_index);
+	}
 
-	ring = virt_dev->eps[ep_index].ring;
+	if (ep->num_stream_ctxs) {
+		if (!stream_id || stream_id >= ep->num_stream_ctxs)
+			return -EINVAL;
+		ring = ep->stream_rings[stream_id];
+	} else {
+		if (stream_id)
+			return -EINVAL;
+		ring = ep->ring;
+	}
 	if (!ring)
 		return -EINVAL;
 
@@ -693,6 +845,7 @@ int xhci_bulk_tx(struct usb_device *udev, unsigned long pipe,
 	 * that the buffer should not span 64KB boundary. if so
 	 * we send request in more than 1 TRB by chaining them.
 	 */
+	buf_64 = xhci_dma_map(ctrl, buffer, length);
 	running_total = TRB_MAX_BUFF_SIZE -
 			(lower_32_bits(buf_64) & (TRB_MAX_BUFF_SIZE - 1));
 	trb_buff_len = running_total;
@@ -712,14 +865,22 @@ int xhci_bulk_tx(struct usb_device *udev, unsigned long pipe,
 	}
 
 	/*
-	 * XXX: Calling routine prepare_ring() called in place of
-	 * prepare_trasfer() as there in 'Linux' since we are not
-	 * maintaining multiple TDs/transfer at the same time.
+	 * The ring has a single segment, one TRB of which is the link TRB.
+	 * A TD on its own is always allowed, as before TDs could be queued.
 	 */
+	if (ep->td_count &&
+	    (ep->td_count == XHCI_MAX_TDS ||
+	     ep->trbs_queued + num_trbs > TRBS_PER_SEGMENT - 1)) {
+		xhci_dma_unmap(ctrl, buf_64, length);
+		return -EBUSY;
+	}
+
 	ret = prepare_ring(ctrl, ring,
 			   le32_to_cpu(ep_ctx->ep_info) & EP_STATE_MASK);
-	if (ret < 0)
+	if (ret < 0) {
+		xhci_dma_unmap(ctrl, buf_64, length);
 		return ret;
+	}
 
 	/*
 	 * Don't give the first TRB to the hardware (by toggling the cycle bit)
@@ -729,6 +890,17 @@ int xhci_bulk_tx(struct usb_device *udev, unsigned long pipe,
 	start_trb = &ring->enqueue->generic;
 	start_cycle = ring->cycle_state;
 
+	td = &ep->tds[(ep->td_head + ep->td_count) % XHCI_MAX_TDS];
+	td->buffer = buffer;
+	td->buf_64 = buf_64;
+	td->length = length;
+	td->available_length = length;
+	td->num_trbs = num_trbs;
+	td->ring = ring;
+	td->first_trb_addr = xhci_trb_virt_to_dma(ring->enq_seg,
+						  ring->enqueue);
+	td->done = false;
+
 	running_total = 0;
 	maxpacketsize = usb_maxpacket(udev, pipe);
 
@@ -802,38 +974,91 @@ int xhci_bulk_tx(struct usb_device *udev, unsigned long pipe,
 		trb_buff_len = min((length - running_total), TRB_MAX_BUFF_SIZE);
 	} while (running_total < length);
 
-	giveback_first_trb(udev, ep_index, start_cycle, start_trb);
+	td->last_trb_addr = last_transfer_trb_addr;
+	ep->td_count++;
+	ep->trbs_queued += td->num_trbs;
 
-again:
-	event = xhci_wait_for_event(ctrl, TRB_TRANSFER);
-	if (!event) {
-		debug("XHCI bulk transfer timed out, aborting...\n");
-		abort_td(udev, ep_index);
-		udev->status = USB_ST_NAK_REC;  /* closest thing to a timeout */
-		udev->act_len = 0;
-		return -ETIMEDOUT;
-	}
+	giveback_first_trb(udev, ep_index, stream_id, start_cycle, start_trb);
 
-	if ((uintptr_t)(le64_to_cpu(event->trans_event.buffer)) !=
-	    (uintptr_t)last_transfer_trb_addr) {
-		available_length -=
-			(int)EVENT_TRB_LEN(le32_to_cpu(event->trans_event.transfer_len));
+	return 0;
+}
+
+/**
+ * Waits for the oldest BULK Request queued on an endpoint by
+ * xhci_bulk_queue() to complete. Events for requests on other endpoints are
+ * recorded for when those are reaped.
+ *
+ * @param udev		pointer to the USB device structure
+ * @param pipe		contains the DIR_IN or OUT , devnum
+ * Return: returns 0 if successful else -1 on failure
+ */
+int xhci_bulk_reap(struct usb_device *udev, unsigned long pipe)
+{
+	struct xhci_ctrl *ctrl = xhci_get_ctrl(udev);
+	int ep_index = usb_pipe_ep_index(pipe);
+	struct xhci_virt_ep *ep = &ctrl->devs[udev->slot_id]->eps[ep_index];
+	union xhci_trb *event;
+	struct xhci_td *td;
+
+	if (!ep->td_count)
+		return -EINVAL;
+	td = &ep->tds[ep->td_head];
+
+	while (!td->done) {
+		event = xhci_wait_for_event(ctrl, TRB_TRANSFER);
+		if (!event) {
+			debug("XHCI bulk transfer timed out, aborting...\n");
+			abort_td(udev, ep_index);
+			/* the ring has been emptied */
+			while (ep->td_count) {
+				td = &ep->tds[ep->td_head];
+				xhci_dma_unmap(ctrl, td->buf_64, td->length);
+				ep->td_head = (ep->td_head + 1) % XHCI_MAX_TDS;
+				ep->td_count--;
+			}
+			ep->trbs_queued = 0;
+			udev->status = USB_ST_NAK_REC;  /* closest thing to a timeout */
+			udev->act_len = 0;
+			return -ETIMEDOUT;
+		}
+
+		handle_bulk_event(ctrl, event);
 		xhci_acknowledge_event(ctrl);
-		goto again;
 	}
 
-	field = le32_to_cpu(event->trans_event.flags);
-	BUG_ON(TRB_TO_SLOT_ID(field) != slot_id);
-	BUG_ON(TRB_TO_EP_INDEX(field) != ep_index);
+	udev->status = td->status;
+	udev->act_len = td->act_len;
+	xhci_inval_cache((uintptr_t)td->buffer, td->length);
+	xhci_dma_unmap(ctrl, td->buf_64, td->length);
 
-	record_transfer_result(udev, event, available_length);
-	xhci_acknowledge_event(ctrl);
-	xhci_inval_cache((uintptr_t)buffer, length);
-	xhci_dma_unmap(ctrl, buf_64, length);
+	ep->trbs_queued -= td->num_trbs;
+	ep->td_head = (ep->td_head + 1) % XHCI_MAX_TDS;
+	ep->td_count--;
 
 	return (udev->status != USB_ST_NOT_PROC) ? 0 : -1;
 }
 
+/**
+ * Queues up the BULK Request and waits for it to complete
+ *
+ * @param udev		pointer to the USB device structure
+ * @param pipe		contains the DIR_IN or OUT , devnum
+ * @param length	length of the buffer
+ * @param buffer	buffer to be read/written based on the request
+ * Return: returns 0 if successful else -1 on failure
+ */
+int xhci_bulk_tx(struct usb_device *udev, unsigned long pipe,
+			int length, void *buffer)
+{
+	int ret;
+
+	ret = xhci_bulk_queue(udev, pipe, 0, length, buffer);
+	if (ret)
+		return ret;
+
+	return xhci_bulk_reap(udev, pipe);
+}
+
 /**
  * Queues up the Control Transfer Request
  *
@@ -1007,7 +1232,7 @@ int xhci_ctrl_tx(struct usb_device *udev, unsigned long pipe,
 
 	queue_trb(ctrl, ep_ring, false, trb_fields);
 
-	giveback_first_trb(udev, ep_index, start_cycle, start_trb);
+	giveback_first_trb(udev, ep_index, 0, start_cycle, start_trb);
 
 	event = xhci_wait_for_event(ctrl, TRB_TRANSFER);
 	if (!event)
@@ -35,6 +35,7 @@
 #include <linux/delay.h>
 #include <linux/errno.h>
 #include <linux/iopoll.h>
+#include <linux/log2.h>
 
 static struct descriptor {
 	struct usb_hub_descriptor hub;
@@ -650,6 +651,97 @@ static int xhci_set_configuration(struct usb_device *udev)
 	return xhci_configure_endpoints(udev, false);
 }
 
+/**
+ * Switch bulk endpoints of a configured device over to using streams, with a
+ * linear stream context array and one transfer ring per stream.
+ *
+ * @param udev		pointer to the USB device structure
+ * @param pipes		bulk pipes of the endpoints to set up
+ * @param num_pipes	number of entries in @pipes
+ * @param num_streams	number of streams wanted on each endpoint
+ * Return: number of streams allocated, which may be fewer than asked for,
+ *	   or -ve on error
+ */
+static int _xhci_alloc_streams(struct usb_device *udev, unsigned long *pipes,
+			       int num_pipes, unsigned int num_streams)
+{
+	struct xhci_ctrl *ctrl = xhci_get_ctrl(udev);
+	struct xhci_virt_device *virt_dev = ctrl->devs[udev->slot_id];
+	struct xhci_container_ctx *in_ctx = virt_dev->in_ctx;
+	struct xhci_container_ctx *out_ctx = virt_dev->out_ctx;
+	struct xhci_input_control_ctx *ctrl_ctx;
+	struct xhci_ep_ctx *ep_ctx;
+	struct xhci_virt_ep *ep;
+	unsigned int num_stream_ctxs, max_stream_ctxs;
+	u32 hcc_params;
+	int ep_index;
+	int i, ret;
+
+	hcc_params = xhci_readl(&ctrl->hccr->cr_hccparams);
+	/* A Max Primary Stream Array size of zero means no streams */
+	if (!(hcc_params & (0xf << 12)))
+		return -ENOSYS;
+	max_stream_ctxs = HCC_MAX_PSA(hcc_params);
+
+	/* Stream 0 is reserved and the array size is a power of two */
+	num_stream_ctxs = roundup_pow_of_two(num_streams + 1);
+	num_stream_ctxs = min(num_stream_ctxs, max_stream_ctxs);
+
+	for (i = 0; i < num_pipes; i++) {
+		if (usb_pipetype(pipes[i]) != PIPE_BULK)
+			return -EINVAL;
+		ep = &virt_dev->eps[usb_pipe_ep_index(pipes[i])];
+		if (!ep->ring || ep->num_stream_ctxs || ep->td_count)
+			return -EBUSY;
+	}
+
+	ctrl_ctx = xhci_get_input_control_ctx(in_ctx);
+	ctrl_ctx->add_flags = cpu_to_le32(SLOT_FLAG);
+	ctrl_ctx->drop_flags = 0;
+
+	xhci_inval_cache((uintptr_t)out_ctx->bytes, out_ctx->size);
+	xhci_slot_copy(ctrl, in_ctx, out_ctx);
+
+	for (i = 0; i < num_pipes; i++) {
+		ep_index = usb_pipe_ep_index(pipes[i]);
+		ep = &virt_dev->eps[ep_index];
+
+		ret = xhci_alloc_stream_info(ctrl, ep, num_stream_ctxs);
+		if (ret)
+			goto err;
+
+		xhci_endpoint_copy(ctrl, in_ctx, out_ctx, ep_index);
+		ep_ctx = xhci_get_ep_ctx(ctrl, in_ctx, ep_index);
+		ep_ctx->ep_info &= cpu_to_le32(~(EP_MAXPSTREAMS_MASK |
+						 EP_STATE_MASK));
+		ep_ctx->ep_info |=
+			cpu_to_le32(EP_MAXPSTREAMS(ilog2(num_stream_ctxs) - 1) |
+				    EP_HAS_LSA);
+		ep_ctx->deq = cpu_to_le64(ep->stream_ctx_dma);
+
+		/* The endpoint is dropped and added back with streams */
+		ctrl_ctx->add_flags |= cpu_to_le32(1 << (ep_index + 1));
+		ctrl_ctx->drop_flags |= cpu_to_le32(1 << (ep_index + 1));
+	}
+
+	ret = xhci_configure_endpoints(udev, false);
+	if (ret)
+		goto err;
+
+	for (i = 0; i < num_pipes; i++)
+		virt_dev->eps[usb_pipe_ep_index(pipes[i])].ep_state |=
+			EP_HAS_STREAMS;
+
+	return num_stream_ctxs - 1;
+
+err:
+	for (i = 0; i < num_pipes; i++)
+		xhci_free_stream_info(ctrl,
+				      &virt_dev->eps[usb_pipe_ep_index(pipes[i])]);
+
+	return ret;
+}
+
 /**
  * Issue an Address Device command (which will issue a SetAddress request to
  * the device).
@@ -1333,6 +1425,31 @@ static int xhci_submit_bulk_msg(struct udevice *dev, struct usb_device *udev,
 	return _xhci_submit_bulk_msg(udev, pipe, buffer, length);
 }
 
+static int xhci_queue_bulk_msg(struct udevice *dev, struct usb_device *udev,
+			       unsigned long pipe, unsigned int stream_id,
+			       void *buffer, int length)
+{
+	debug("%s: dev='%s', udev=%p\n", __func__, dev->name, udev);
+	if (usb_pipetype(pipe) != PIPE_BULK)
+		return -EINVAL;
+
+	return xhci_bulk_queue(udev, pipe, stream_id, length, buffer);
+}
+
+static int xhci_reap_bulk_msg(struct udevice *dev, struct usb_device *udev,
+			      unsigned long pipe)
+{
+	return xhci_bulk_reap(udev, pipe);
+}
+
+static int xhci_alloc_streams(struct udevice *dev, struct usb_device *udev,
+			      unsigned long *pipes, int num_pipes,
+			      unsigned int num_streams)
+{
+	debug("%s: dev='%s', udev=%p\n", __func__, dev->name, udev);
+	return _xhci_alloc_streams(udev, pipes, num_pipes, num_streams);
+}
+
 static int xhci_submit_int_msg(struct udevice *dev, struct usb_device *udev,
 			       unsigned long pipe, void *buffer, int length,
 			       int interval, bool nonblock)
@@ -1477,6 +1594,9 @@ int xhci_deregister(struct udevice *dev)
 struct dm_usb_ops xhci_usb_ops = {
 	.control = xhci_submit_control_msg,
 	.bulk = xhci_submit_bulk_msg,
+	.queue_bulk = xhci_queue_bulk_msg,
+	.reap_bulk = xhci_reap_bulk_msg,
+	.alloc_streams = xhci_alloc_streams,
 	.interrupt = xhci_submit_int_msg,
 	.alloc_device = xhci_alloc_device,
 	.update_hub_device = xhci_update_hub_device,
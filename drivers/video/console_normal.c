@@ -18,28 +18,10 @@ static int console_set_row(struct udevice *dev, uint row, int clr)
 	struct video_priv *vid_priv = dev_get_uclass_priv(dev->parent);
 	struct console_simple_priv *priv = dev_get_priv(dev);
 	struct video_fontdata *fontdata = priv->fontdata;
-	void *line, *dst, *end;
-	int pixels = fontdata->height * vid_priv->xsize;
-	int ret;
-	int i;
-	int pbytes;
-
-	ret = check_bpix_support(vid_priv->bpix);
-	if (ret)
-		return ret;
-
-	line = vid_priv->fb + row * fontdata->height * vid_priv->line_length;
-	dst = line;
-	pbytes = VNBYTES(vid_priv->bpix);
-	for (i = 0; i < pixels; i++)
-		fill_pixel_and_goto_next(&dst, clr, pbytes, pbytes);
-	end = dst;
+	int y = row * fontdata->height;
 
-	ret = vidconsole_sync_copy(dev, line, end);
-	if (ret)
-		return ret;
-
-	return 0;
+	return video_fill_part(dev->parent, 0, y, vid_priv->xsize,
+			       y + fontdata->height, clr);
 }
 
 static int console_move_rows(struct udevice *dev, uint rowdst,
@@ -123,7 +105,7 @@ static int console_set_cursor_visible(struct udevice *dev, bool visible,
 	draw_cursor_vertically(&line, vid_priv, vc_priv->y_charsize,
 			       NORMAL_DIRECTION);
 
-	return 0;
+	return vidconsole_sync_copy(dev, start, line);
 }
 
 struct vidconsole_ops console_ops = {
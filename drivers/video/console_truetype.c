@@ -10,6 +10,7 @@
 #include <spl.h>
 #include <video.h>
 #include <video_console.h>
+#include <linux/list.h>
 
 /* Functions needed by stb_truetype.h */
 static int tt_floor(double val)
@@ -155,6 +156,33 @@ struct console_tt_metrics {
 	double scale;
 };
 
+/**
+ * struct console_tt_glyph - A rendered character, kept in the glyph cache
+ *
+ * @sibling:	Node in the list of cached glyphs, most recently used first
+ * @met:	Font and size the glyph was rendered with
+ * @cp:		Unicode code point of the character
+ * @x_shift:	Fraction of a pixel the glyph was shifted right by
+ * @width:	Width of the image in pixels
+ * @height:	Height of the image in pixels
+ * @xoff:	X offset of the image from the cursor position
+ * @yoff:	Y offset of the image from the baseline
+ * @size:	Memory used by the glyph, in bytes
+ * @data:	8-bit-per-pixel image, or NULL for an empty character like ' '
+ */
+struct console_tt_glyph {
+	struct list_head sibling;
+	struct console_tt_metrics *met;
+	int cp;
+	double x_shift;
+	int width;
+	int height;
+	int xoff;
+	int yoff;
+	int size;
+	u8 *data;
+};
+
 /**
  * struct console_tt_priv - Private data for this driver
  *
@@ -167,6 +195,9 @@ struct console_tt_metrics {
  *		last character. We record enough characters to go back to the
  *		start of the current command line.
  * @pos_ptr:	Current position in the position history
+ * @glyphs:	Cached glyphs (struct console_tt_glyph), most recently used
+ *		first
+ * @glyph_bytes:	Memory used by @glyphs, in bytes
  */
 struct console_tt_priv {
 	struct console_tt_metrics *cur_met;
@@ -174,6 +205,8 @@ struct console_tt_priv {
 	int num_metrics;
 	struct pos_info pos[POS_HISTORY_SIZE];
 	int pos_ptr;
+	struct list_head glyphs;
+	int glyph_bytes;
 };
 
 /**
@@ -192,48 +225,10 @@ static int console_truetype_set_row(struct udevice *dev, uint row, int clr)
 	struct video_priv *vid_priv = dev_get_uclass_priv(dev->parent);
 	struct console_tt_priv *priv = dev_get_priv(dev);
 	struct console_tt_metrics *met = priv->cur_met;
-	void *end, *line;
-	int ret;
-
-	line = vid_priv->fb + row * met->font_size * vid_priv->line_length;
-	end = line + met->font_size * vid_priv->line_length;
-
-	switch (vid_priv->bpix) {
-	case VIDEO_BPP8: {
-		u8 *dst;
-
-		if (IS_ENABLED(CONFIG_VIDEO_BPP8)) {
-			for (dst = line; dst < (u8 *)end; ++dst)
-				*dst = clr;
-		}
-		break;
-	}
-	case VIDEO_BPP16: {
-		u16 *dst = line;
-
-		if (IS_ENABLED(CONFIG_VIDEO_BPP16)) {
-			for (dst = line; dst < (u16 *)end; ++dst)
-				*dst = clr;
-		}
-		break;
-	}
-	case VIDEO_BPP32: {
-		u32 *dst = line;
-
-		if (IS_ENABLED(CONFIG_VIDEO_BPP32)) {
-			for (dst = line; dst < (u32 *)end; ++dst)
-				*dst = clr;
-		}
-		break;
-	}
-	default:
-		return -ENOSYS;
-	}
-	ret = vidconsole_sync_copy(dev, line, end);
-	if (ret)
-		return ret;
+	int y = row * met->font_size;
 
-	return 0;
+	return video_fill_part(dev->parent, 0, y, vid_priv->xsize,
+			       y + met->font_size, clr);
 }
 
 static int console_truetype_move_rows(struct udevice *dev, uint rowdst,
@@ -261,6 +256,87 @@ static int console_truetype_move_rows(struct udevice *dev, uint rowdst,
 	return 0;
 }
 
+static void truetype_drop_glyph(struct console_tt_priv *priv,
+				struct console_tt_glyph *glyph)
+{
+	list_del(&glyph->sibling);
+	priv->glyph_bytes -= glyph->size;
+	free(glyph->data);
+	free(glyph);
+}
+
+/**
+ * truetype_get_glyph() - Get the image of a character
+ *
+ * The image is taken from the glyph cache if it is there, otherwise it is
+ * rendered and added to the cache, dropping the least recently used glyphs if
+ * the cache is full. Redrawing the same text, e.g. in a menu, then only needs
+ * the images to be copied to the frame buffer.
+ *
+ * @priv:	Private data
+ * @met:	Font and size to use
+ * @cp:		Unicode code point of the character
+ * @x_shift:	Fraction of a pixel to shift the glyph right by
+ * Return: glyph, which must be passed to truetype_put_glyph() when done, or
+ *	NULL if out of memory
+ */
+static struct console_tt_glyph *truetype_get_glyph(struct console_tt_priv *priv,
+						   struct console_tt_metrics *met,
+						   int cp, double x_shift)
+{
+	const int max_bytes = CONFIG_CONSOLE_TRUETYPE_GLYPH_CACHE;
+	struct console_tt_glyph *glyph;
+
+	list_for_each_entry(glyph, &priv->glyphs, sibling) {
+		if (glyph->cp == cp && glyph->met == met &&
+		    glyph->x_shift == x_shift) {
+			list_move(&glyph->sibling, &priv->glyphs);
+			return glyph;
+		}
+	}
+
+	glyph = malloc(sizeof(*glyph));
+	if (!glyph)
+		return NULL;
+	glyph->met = met;
+	glyph->cp = cp;
+	glyph->x_shift = x_shift;
+	glyph->data = stbtt_GetCodepointBitmapSubpixel(&met->font, met->scale,
+						       met->scale, x_shift, 0,
+						       cp, &glyph->width,
+						       &glyph->height,
+						       &glyph->xoff,
+						       &glyph->yoff);
+	glyph->size = sizeof(*glyph);
+	if (glyph->data)
+		glyph->size += glyph->width * glyph->height;
+	if (!max_bytes)
+		return glyph;
+
+	list_add(&glyph->sibling, &priv->glyphs);
+	priv->glyph_bytes += glyph->size;
+	while (priv->glyph_bytes > max_bytes &&
+	       priv->glyphs.prev != &glyph->sibling)
+		truetype_drop_glyph(priv, list_last_entry(&priv->glyphs,
+							  struct console_tt_glyph,
+							  sibling));
+
+	return glyph;
+}
+
+/**
+ * truetype_put_glyph() - Finish with a glyph from truetype_get_glyph()
+ *
+ * @glyph:	Glyph to put
+ */
+static void truetype_put_glyph(struct console_tt_glyph *glyph)
+{
+	if (!CONFIG_CONSOLE_TRUETYPE_GLYPH_CACHE) {
+		free(glyph->data);
+		free(glyph);
+	}
+}
+
 static int console_truetype_putc_xy(struct udevice *dev, uint x, uint y,
 				    int cp)
 {
@@ -270,12 +346,14 @@ static int console_truetype_putc_xy(struct udevice *dev, uint x, uint y,
 	struct console_tt_priv *priv = dev_get_priv(dev);
 	struct console_tt_metrics *met = priv->cur_met;
 	stbtt_fontinfo *font = &met->font;
+	struct console_tt_glyph *glyph;
 	int width, height, xoff, yoff;
+	bool invert, set;
 	double xpos, x_shift;
 	int lsb;
 	int width_frac, linenum;
 	struct pos_info *pos;
-	u8 *bits, *data;
+	u8 *bits;
 	int advance;
 	void *start, *end, *line;
 	int row, ret;
@@ -316,17 +394,25 @@ static int console_truetype_putc_xy(struct udevice *dev, uint x, uint y,
 	/*
 	 * Figure out how much past the start of a pixel we are, and pass this
 	 * information into the render, which will return a 8-bit-per-pixel
-	 * image of the character. For empty characters, like ' ', data will
-	 * return NULL;
+	 * image of the character. For empty characters, like ' ', there is no
+	 * image.
 	 */
-	data = stbtt_GetCodepointBitmapSubpixel(font, met->scale, met->scale,
-						x_shift, 0, cp, &width, &height,
-						&xoff, &yoff);
-	if (!data)
+	glyph = truetype_get_glyph(priv, met, cp, x_shift);
+	if (!glyph)
+		return -ENOMEM;
+	if (!glyph->data) {
+		truetype_put_glyph(glyph);
 		return width_frac;
+	}
+	width = glyph->width;
+	height = glyph->height;
+	xoff = glyph->xoff;
+	yoff = glyph->yoff;
+	invert = vid_priv->colour_bg;
+	set = vid_priv->colour_fg;
 
 	/* Figure out where to write the character in the frame buffer */
-	bits = data;
+	bits = glyph->data;
 	start = vid_priv->fb + y * vid_priv->line_length +
 		VID_TO_PIXEL(x) * VNBYTES(vid_priv->bpix);
 	linenum = met->baseline + yoff;
@@ -350,10 +436,10 @@ static int console_truetype_putc_xy(struct udevice *dev, uint x, uint y,
 					int val = *bits;
 					int out;
 
-					if (vid_priv->colour_bg)
+					if (invert)
 						val = 255 - val;
 					out = val;
-					if (vid_priv->colour_fg)
+					if (set)
 						*dst++ |= out;
 					else
 						*dst++ &= out;
@@ -371,12 +457,12 @@ static int console_truetype_putc_xy(struct udevice *dev, uint x, uint y,
 					int val = *bits;
 					int out;
 
-					if (vid_priv->colour_bg)
+					if (invert)
 						val = 255 - val;
 					out = val >> 3 |
 						(val >> 2) << 5 |
 						(val >> 3) << 11;
-					if (vid_priv->colour_fg)
+					if (set)
 						*dst++ |= out;
 					else
 						*dst++ &= out;
@@ -395,13 +481,13 @@ static int console_truetype_putc_xy(struct udevice *dev, uint x, uint y,
 					int val = *bits;
 					int out;
 
-					if (vid_priv->colour_bg)
+					if (invert)
 						val = 255 - val;
 					if (vid_priv->format == VIDEO_X2R10G10B10)
 						out = val << 2 | val << 12 | val << 22;
 					else
 						out = val | val << 8 | val << 16;
-					if (vid_priv->colour_fg)
+					if (set)
 						*dst++ |= out;
 					else
 						*dst++ &= out;
@@ -412,16 +498,16 @@ static int console_truetype_putc_xy(struct udevice *dev, uint x, uint y,
 			break;
 		}
 		default:
-			free(data);
+			truetype_put_glyph(glyph);
 			return -ENOSYS;
 		}
 
 		line += vid_priv->line_length;
 	}
+	truetype_put_glyph(glyph);
 	ret = vidconsole_sync_copy(dev, start, line);
 	if (ret)
 		return ret;
-	free(data);
 
 	return width_frac;
 }
@@ -978,6 +1064,7 @@ static int console_truetype_probe(struct udevice *dev)
 		return -EBFONT;
 	}
 
+	INIT_LIST_HEAD(&priv->glyphs);
 	ret = truetype_add_metrics(dev, tab->name, font_size, tab->begin);
 	if (ret < 0)
 		return log_msg_ret("add", ret);
@@ -990,6 +1077,17 @@ static int console_truetype_probe(struct udevice *dev)
 	return 0;
 }
 
+static int console_truetype_remove(struct udevice *dev)
+{
+	struct console_tt_priv *priv = dev_get_priv(dev);
+	struct console_tt_glyph *glyph, *next;
+
+	list_for_each_entry_safe(glyph, next, &priv->glyphs, sibling)
+		truetype_drop_glyph(priv, glyph);
+
+	return 0;
+}
+
 struct vidconsole_ops console_truetype_ops = {
 	.putc_xy	= console_truetype_putc_xy,
 	.move_rows	= console_truetype_move_rows,
@@ -1011,5 +1109,6 @@ U_BOOT_DRIVER(vidconsole_truetype) = {
 	.id	= UCLASS_VIDEO_CONSOLE,
 	.ops	= &console_truetype_ops,
 	.probe	= console_truetype_probe,
+	.remove	= console_truetype_remove,
 	.priv_auto	= sizeof(struct console_tt_priv),
 };
@@ -9,6 +9,7 @@
 #include <console.h>
 #include <cpu_func.h>
 #include <dm.h>
+#include <dma.h>
 #include <log.h>
 #include <malloc.h>
 #include <mapmem.h>
@@ -22,6 +23,7 @@
 #include <dm/device_compat.h>
 #include <dm/device-internal.h>
 #include <dm/uclass-internal.h>
+#include <linux/sizes.h>
 #ifdef CONFIG_SANDBOX
 #include <asm/sdl.h>
 #endif
@@ -146,49 +148,72 @@ int video_reserve(ulong *addrp)
 	return 0;
 }
 
+/**
+ * video_fill_line() - Fill part of a line with a colour
+ *
+ * @priv: Video device information
+ * @line: Place to start filling, within the frame buffer
+ * @pixels: Number of pixels to fill
+ * @colour: Value to write
+ * Return: 0 if OK, -ENOSYS if the display depth is not supported
+ */
+static int video_fill_line(struct video_priv *priv, void *line, int pixels,
+			   u32 colour)
+{
+	int i;
+
+	switch (priv->bpix) {
+	case VIDEO_BPP8:
+		if (!IS_ENABLED(CONFIG_VIDEO_BPP8))
+			return -ENOSYS;
+		memset(line, colour, pixels);
+		break;
+	case VIDEO_BPP16: {
+		u16 *dst = line;
+
+		if (!IS_ENABLED(CONFIG_VIDEO_BPP16))
+			return -ENOSYS;
+		for (i = 0; i < pixels; i++)
+			*dst++ = colour;
+		break;
+	}
+	case VIDEO_BPP32: {
+		u32 *dst = line;
+
+		if (!IS_ENABLED(CONFIG_VIDEO_BPP32))
+			return -ENOSYS;
+		for (i = 0; i < pixels; i++)
+			*dst++ = colour;
+		break;
+	}
+	default:
+		return -ENOSYS;
+	}
+
+	return 0;
+}
+
 int video_fill_part(struct udevice *dev, int xstart, int ystart, int xend,
 		    int yend, u32 colour)
 {
 	struct video_priv *priv = dev_get_uclass_priv(dev);
-	void *start, *line;
 	int pixels = xend - xstart;
-	int row, i, ret;
+	int size = pixels * VNBYTES(priv->bpix);
+	void *start, *line;
+	int row, ret;
 
+	if (ystart >= yend)
+		return 0;
 	start = priv->fb + ystart * priv->line_length;
 	start += xstart * VNBYTES(priv->bpix);
-	line = start;
-	for (row = ystart; row < yend; row++) {
-		switch (priv->bpix) {
-		case VIDEO_BPP8: {
-			u8 *dst = line;
-
-			if (IS_ENABLED(CONFIG_VIDEO_BPP8)) {
-				for (i = 0; i < pixels; i++)
-					*dst++ = colour;
-			}
-			break;
-		}
-		case VIDEO_BPP16: {
-			u16 *dst = line;
-
-			if (IS_ENABLED(CONFIG_VIDEO_BPP16)) {
-				for (i = 0; i < pixels; i++)
-					*dst++ = colour;
-			}
-			break;
-		}
-		case VIDEO_BPP32: {
-			u32 *dst = line;
+	ret = video_fill_line(priv, start, pixels, colour);
+	if (ret)
+		return ret;
 
-			if (IS_ENABLED(CONFIG_VIDEO_BPP32)) {
-				for (i = 0; i < pixels; i++)
-					*dst++ = colour;
-			}
-			break;
-		}
-		default:
-			return -ENOSYS;
-		}
+	/* The other lines are the same, so copy the first, which is faster */
+	line = start + priv->line_length;
+	for (row = ystart + 1; row < yend; row++) {
+		memcpy(line, start, size);
 		line += priv->line_length;
 	}
 	ret = video_sync_copy(dev, start, line);
@@ -346,10 +371,99 @@ void video_set_default_colors(struct udevice *dev, bool invert)
 	priv->colour_bg = video_index_to_colour(priv, back);
 }
 
+#ifdef CONFIG_VIDEO_DAMAGE
+void video_damage(struct udevice *vid, int x, int y, int width, int height)
+{
+	struct video_priv *priv = dev_get_uclass_priv(vid);
+	struct video_bbox *damage = &priv->damage;
+	int x1 = min(x + width, (int)priv->xsize);
+	int y1 = min(y + height, (int)priv->ysize);
+
+	x = max(x, 0);
+	y = max(y, 0);
+	if (x >= x1 || y >= y1)
+		return;
+	if (damage->x1 <= damage->x0) {
+		damage->x0 = x;
+		damage->y0 = y;
+		damage->x1 = x1;
+		damage->y1 = y1;
+	} else {
+		damage->x0 = min(damage->x0, x);
+		damage->y0 = min(damage->y0, y);
+		damage->x1 = max(damage->x1, x1);
+		damage->y1 = max(damage->y1, y1);
+	}
+}
+
+/**
+ * video_damage_range() - Record the damage from writing a range of bytes
+ *
+ * @vid: Video device
+ * @offset: Offset of the first byte written, within the frame buffer
+ * @size: Number of bytes written
+ */
+static void video_damage_range(struct udevice *vid, long offset, long size)
+{
+	struct video_priv *priv = dev_get_uclass_priv(vid);
+	int bits = VNBITS(priv->bpix);
+	long last = offset + size - 1;
+	int y0, y1, x0, x1;
+
+	if (size <= 0)
+		return;
+	y0 = offset / priv->line_length;
+	y1 = last / priv->line_length;
+	if (y0 != y1) {
+		video_damage(vid, 0, y0, priv->xsize, y1 - y0 + 1);
+		return;
+	}
+	x0 = offset % priv->line_length * 8 / bits;
+	x1 = (last % priv->line_length * 8 + 7) / bits;
+	video_damage(vid, x0, y0, x1 - x0 + 1, 1);
+}
+
+#if defined(CONFIG_ARM) && !CONFIG_IS_ENABLED(SYS_DCACHE_OFF)
+/**
+ * video_flush_damage() - Flush the damaged part of the frame buffer
+ *
+ * Damage covering the full width is flushed in one go, otherwise each line is
+ * flushed separately, so that the rest of the line is left alone
+ *
+ * @priv: Video device information
+ */
+static void video_flush_damage(struct video_priv *priv)
+{
+	struct video_bbox *damage = &priv->damage;
+	int bits = VNBITS(priv->bpix);
+	ulong line, start, end;
+	int y;
+
+	if (damage->x1 <= damage->x0)
+		return;
+	line = (ulong)priv->fb + damage->y0 * priv->line_length;
+	if (!damage->x0 && damage->x1 == priv->xsize) {
+		end = (ulong)priv->fb + damage->y1 * priv->line_length;
+		flush_dcache_range(ALIGN_DOWN(line, CONFIG_SYS_CACHELINE_SIZE),
+				   ALIGN(end, CONFIG_SYS_CACHELINE_SIZE));
+		return;
+	}
+	for (y = damage->y0; y < damage->y1; y++) {
+		start = line + damage->x0 * bits / 8;
+		end = line + DIV_ROUND_UP(damage->x1 * bits, 8);
+		flush_dcache_range(ALIGN_DOWN(start, CONFIG_SYS_CACHELINE_SIZE),
+				   ALIGN(end, CONFIG_SYS_CACHELINE_SIZE));
+		line += priv->line_length;
+	}
+}
+#endif
+#endif
+
 /* Flush video activity to the caches */
 int video_sync(struct udevice *vid, bool force)
 {
 	struct video_ops *ops = video_get_ops(vid);
+	struct video_priv *priv = dev_get_uclass_priv(vid);
 	int ret;
 
 	if (ops && ops->video_sync) {
@@ -364,15 +478,16 @@ int video_sync(struct udevice *vid, bool force)
 	 * out whether it exists? For now, ARM is safe.
 	 */
 #if defined(CONFIG_ARM) && !CONFIG_IS_ENABLED(SYS_DCACHE_OFF)
-	struct video_priv *priv = dev_get_uclass_priv(vid);
-
 	if (priv->flush_dcache) {
+#ifdef CONFIG_VIDEO_DAMAGE
+		video_flush_damage(priv);
+#else
 		flush_dcache_range((ulong)priv->fb,
 				   ALIGN((ulong)priv->fb + priv->fb_size,
 					 CONFIG_SYS_CACHELINE_SIZE));
+#endif
 	}
 #elif defined(CONFIG_VIDEO_SANDBOX_SDL)
-	struct video_priv *priv = dev_get_uclass_priv(vid);
 	static ulong last_sync;
 
 	if (force || get_timer(last_sync) > 100) {
@@ -380,6 +495,9 @@ int video_sync(struct udevice *vid, bool force)
 		last_sync = get_timer(0);
 	}
 #endif
+	if (IS_ENABLED(CONFIG_VIDEO_DAMAGE))
+		memset(&priv->damage, '\0', sizeof(priv->damage));
+
 	return 0;
 }
 
@@ -431,12 +549,35 @@ int video_get_ysize(struct udevice *dev)
 	return priv->ysize;
 }
 
-#ifdef CONFIG_VIDEO_COPY
+#if defined(CONFIG_VIDEO_COPY) || defined(CONFIG_VIDEO_DAMAGE)
+/* Smallest copy which is worth handing to a DMA channel */
+#define VIDEO_COPY_DMA_MIN	SZ_64K
+
+/**
+ * video_copy() - Copy part of the frame buffer to the copy frame buffer
+ *
+ * Large copies, such as when scrolling, use a DMA channel if there is one
+ *
+ * @priv: Video device information
+ * @offset: Offset of the first byte to copy
+ * @size: Number of bytes to copy
+ */
+static void video_copy(struct video_priv *priv, long offset, long size)
+{
+	void *dst = priv->copy_fb + offset;
+	void *src = priv->fb + offset;
+
+	if (IS_ENABLED(CONFIG_VIDEO_COPY_DMA) && size >= VIDEO_COPY_DMA_MIN &&
+	    !dma_memcpy(dst, src, size))
+		return;
+	memcpy(dst, src, size);
+}
+
 int video_sync_copy(struct udevice *dev, void *from, void *to)
 {
 	struct video_priv *priv = dev_get_uclass_priv(dev);
 
-	if (priv->copy_fb) {
+	if (priv->copy_fb || IS_ENABLED(CONFIG_VIDEO_DAMAGE)) {
 		long offset, size;
 
 		/* Find the offset of the first byte to copy */
@@ -477,7 +618,11 @@ int video_sync_copy(struct udevice *dev, void *from, void *to)
 			offset = 0;
 		}
 
-		memcpy(priv->copy_fb + offset, priv->fb + offset, size);
+#ifdef CONFIG_VIDEO_DAMAGE
+		video_damage_range(dev, offset, size);
+#endif
+		if (priv->copy_fb)
+			video_copy(priv, offset, size);
 	}
 
 	return 0;
@@ -12,28 +12,86 @@
 #include <virtio_types.h>
 #include <virtio.h>
 #include <virtio_ring.h>
+#include <linux/err.h>
 #include "virtio_blk.h"
 
+/* Number of requests which can be in flight at once */
+#define VIRTIO_BLK_SLOTS	16
+
+/**
+ * struct virtio_blk_slot - a request which has been passed to the device
+ *
+ * @out_hdr: request header; this is the first buffer of the request, so its
+ *	address is what virtqueue_get_buf() returns when the request completes
+ * @status: status written by the device
+ * @busy: true if the slot is in use
+ * @done: true once a synchronous request has completed
+ * @blkcnt: number of blocks requested
+ * @req: asynchronous request, or NULL if the caller is waiting for this one
+ */
+struct virtio_blk_slot {
+	struct virtio_blk_outhdr out_hdr;
+	u8 status;
+	bool busy;
+	bool done;
+	lbaint_t blkcnt;
+	struct blk_req *req;
+};
+
+/**
+ * struct virtio_blk_priv - private data for a virtio block device
+ *
+ * @vq: request virtqueue
+ * @slots: requests in flight
+ */
 struct virtio_blk_priv {
 	struct virtqueue *vq;
+	struct virtio_blk_slot slots[VIRTIO_BLK_SLOTS];
 };
 
-static ulong virtio_blk_do_req(struct udevice *dev, u64 sector,
-			       lbaint_t blkcnt, void *buffer, u32 type)
+/**
+ * virtio_blk_queue() - add a request to the virtqueue
+ *
+ * The device is not notified, so that several requests can be passed to it
+ * with a single kick.
+ *
+ * @dev:	virtio block device
+ * @sector:	first sector to transfer
+ * @blkcnt:	number of sectors to transfer
+ * @buffer:	data buffer
+ * @type:	VIRTIO_BLK_T_IN or VIRTIO_BLK_T_OUT
+ * @req:	asynchronous request, or NULL
+ * Return: slot used, or ERR_PTR(-EBUSY) if no slot or ring space is free
+ */
+static struct virtio_blk_slot *virtio_blk_queue(struct udevice *dev,
+						u64 sector, lbaint_t blkcnt,
+						void *buffer, u32 type,
+						struct blk_req *req)
 {
 	struct virtio_blk_priv *priv = dev_get_priv(dev);
 	unsigned int num_out = 0, num_in = 0;
+	struct virtio_sg hdr_sg, data_sg, status_sg;
+	struct virtio_blk_slot *slot;
 	struct virtio_sg *sgs[3];
-	u8 status;
-	int ret;
+	int i, ret;
+
+	for (i = 0, slot = priv->slots; i < VIRTIO_BLK_SLOTS; i++, slot++) {
+		if (!slot->busy)
+			break;
+	}
+	if (i == VIRTIO_BLK_SLOTS)
+		return ERR_PTR(-EBUSY);
+
+	slot->out_hdr.type = cpu_to_virtio32(dev, type);
+	slot->out_hdr.ioprio = 0;
+	slot->out_hdr.sector = cpu_to_virtio64(dev, sector);
+	slot->blkcnt = blkcnt;
+	slot->req = req;
+	slot->done = false;
 
-	struct virtio_blk_outhdr out_hdr = {
-		.type = cpu_to_virtio32(dev, type),
-		.sector = cpu_to_virtio64(dev, sector),
-	};
-	struct virtio_sg hdr_sg = { &out_hdr, sizeof(out_hdr) };
-	struct virtio_sg data_sg = { buffer, blkcnt * 512 };
-	struct virtio_sg status_sg = { &status, sizeof(status) };
+	hdr_sg = (struct virtio_sg){ &slot->out_hdr, sizeof(slot->out_hdr) };
+	data_sg = (struct virtio_sg){ buffer, blkcnt * 512 };
+	status_sg = (struct virtio_sg){ &slot->status, sizeof(slot->status) };
 
 	sgs[num_out++] = &hdr_sg;
 
@@ -48,18 +106,102 @@ static ulong virtio_blk_do_req(struct udevice *dev, u64 sector,
 
 	ret = virtqueue_add(priv->vq, sgs, num_out, num_in);
 	if (ret)
-		return ret;
+		return ERR_PTR(ret == -ENOSPC ? -EBUSY : ret);
+	slot->busy = true;
+
+	return slot;
+}
+
+/**
+ * virtio_blk_reap() - handle all requests which the device has completed
+ *
+ * Asynchronous requests are completed and their slots freed. Synchronous
+ * ones are marked as done and freed by the caller waiting on them.
+ *
+ * @dev:	virtio block device
+ */
+static void virtio_blk_reap(struct udevice *dev)
+{
+	struct virtio_blk_priv *priv = dev_get_priv(dev);
+	struct virtio_blk_slot *slot;
+	void *buf;
+
+	while ((buf = virtqueue_get_buf(priv->vq, NULL))) {
+		long result;
+
+		slot = container_of(buf, struct virtio_blk_slot, out_hdr);
+		result = slot->status == VIRTIO_BLK_S_OK ? slot->blkcnt : -EIO;
+		if (slot->req) {
+			slot->busy = false;
+			blk_req_complete(dev, slot->req, result);
+		} else {
+			slot->done = true;
+		}
+	}
+}
+
+static ulong virtio_blk_do_req(struct udevice *dev, u64 sector,
+			       lbaint_t blkcnt, void *buffer, u32 type)
+{
+	struct virtio_blk_priv *priv = dev_get_priv(dev);
+	struct virtio_blk_slot *slot;
+
+	/* Wait for space if asynchronous requests are using it all */
+	while (1) {
+		slot = virtio_blk_queue(dev, sector, blkcnt, buffer, type,
+					NULL);
+		if (PTR_ERR(slot) != -EBUSY)
+			break;
+		virtqueue_kick(priv->vq);
+		virtio_blk_reap(dev);
+	}
+	if (IS_ERR(slot))
+		return PTR_ERR(slot);
 
 	virtqueue_kick(priv->vq);
 
 	log_debug("wait...");
-	while (!virtqueue_get_buf(priv->vq, NULL))
-		;
+	while (!slot->done)
+		virtio_blk_reap(dev);
 	log_debug("done\n");
+	slot->busy = false;
+
+	return slot->status == VIRTIO_BLK_S_OK ? blkcnt : -EIO;
+}
+
+#if CONFIG_IS_ENABLED(BLK_ASYNC)
+static int virtio_blk_submit_read(struct udevice *dev, struct blk_req *req)
+{
+	struct virtio_blk_slot *slot;
+
+	/* The kick is left to virtio_blk_poll(), to cover a whole batch */
+	slot = virtio_blk_queue(dev, req->start, req->blkcnt, req->buffer,
+				VIRTIO_BLK_T_IN, req);
+
+	return IS_ERR(slot) ? PTR_ERR(slot) : 0;
+}
+
+static int virtio_blk_submit_write(struct udevice *dev, struct blk_req *req)
+{
+	struct virtio_blk_slot *slot;
+
+	slot = virtio_blk_queue(dev, req->start, req->blkcnt, req->buffer,
+				VIRTIO_BLK_T_OUT, req);
 
-	return status == VIRTIO_BLK_S_OK ? blkcnt : -EIO;
+	return IS_ERR(slot) ? PTR_ERR(slot) : 0;
 }
 
+static int virtio_blk_poll(struct udevice *dev)
+{
+	struct virtio_blk_priv *priv = dev_get_priv(dev);
+
+	virtqueue_kick(priv->vq);
+	virtio_blk_reap(dev);
+
+	return 0;
+}
+#endif
+
 static ulong virtio_blk_read(struct udevice *dev, lbaint_t start,
 			     lbaint_t blkcnt, void *buffer)
 {
@@ -75,6 +217,11 @@ static ulong virtio_blk_write(struct udevice *dev, lbaint_t start,
 				 VIRTIO_BLK_T_OUT);
 }
 
+static const u32 feature[] = {
+	VIRTIO_RING_F_INDIRECT_DESC,
+	VIRTIO_RING_F_EVENT_IDX,
+};
+
 static int virtio_blk_bind(struct udevice *dev)
 {
 	struct virtio_dev_priv *uc_priv = dev_get_uclass_priv(dev->parent);
@@ -104,7 +251,8 @@ static int virtio_blk_bind(struct udevice *dev)
 	desc->bdev = dev;
 
 	/* Indicate what driver features we support */
-	virtio_driver_features_init(uc_priv, NULL, 0, NULL, 0);
+	virtio_driver_features_init(uc_priv, feature, ARRAY_SIZE(feature),
+				    NULL, 0);
 
 	return 0;
 }
@@ -113,6 +261,7 @@ static int virtio_blk_probe(struct udevice *dev)
 {
 	struct virtio_blk_priv *priv = dev_get_priv(dev);
 	struct blk_desc *desc = dev_get_uclass_plat(dev);
+	uint depth;
 	u64 cap;
 	int ret;
 
@@ -125,12 +274,26 @@ static int virtio_blk_probe(struct udevice *dev)
 	virtio_cread(dev, struct virtio_blk_config, capacity, &cap);
 	desc->lba = cap;
 
+	/*
+	 * Each request needs three descriptors unless they can go in an
+	 * indirect table
+	 */
+	depth = virtqueue_get_vring_size(priv->vq);
+	if (!priv->vq->indirect_desc)
+		depth /= 3;
+	desc->queue_depth = clamp(depth, 1U, (uint)VIRTIO_BLK_SLOTS);
+
 	return 0;
 }
 
 static const struct blk_ops virtio_blk_ops = {
 	.read	= virtio_blk_read,
 	.write	= virtio_blk_write,
+#if CONFIG_IS_ENABLED(BLK_ASYNC)
+	.submit_read	= virtio_blk_submit_read,
+	.submit_write	= virtio_blk_submit_write,
+	.poll		= virtio_blk_poll,
+#endif
 };
 
 U_BOOT_DRIVER(virtio_blk) = {
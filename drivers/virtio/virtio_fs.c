@@ -0,0 +1,653 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * virtio-fs: read files from a directory shared by the host
+ *
+ * The device carries FUSE requests, so the host directory can be read
+ * without building a disk image for it. Each request is queued on the first
+ * request queue and waited for before the next is sent. File data is read
+ * straight into the caller's buffer.
+ */
+
+#define LOG_CATEGORY UCLASS_FS
+
+#include <bootdev.h>
+#include <bootflow.h>
+#include <bootmeth.h>
+#include <dm.h>
+#include <fs.h>
+#include <log.h>
+#include <malloc.h>
+#include <part.h>
+#include <virtiofs.h>
+#include <virtio_types.h>
+#include <virtio.h>
+#include <virtio_ring.h>
+#include <dm/device-internal.h>
+#include <linux/sizes.h>
+#include <linux/stat.h>
+#include "virtio_fs.h"
+
+/* Longest path which can be looked up, including symlink targets */
+#define VIRTIO_FS_PATH_MAX	1024
+
+/* Most symlinks to follow when looking up a path */
+#define VIRTIO_FS_MAX_LINKS	8
+
+/* Size of the buffer for reading directory entries */
+#define VIRTIO_FS_DIR_BUF_SIZE	SZ_4K
+
+/**
+ * struct virtio_fs_priv - Information about a virtio-fs device
+ *
+ * @vqs: Virtqueues: the high-priority queue, then the first request queue
+ * @tag: Mount tag, NUL-terminated
+ * @unique: ID of the last request sent
+ * @max_read: Largest read to request, in bytes
+ * @ready: true once the FUSE session has been set up
+ */
+struct virtio_fs_priv {
+	struct virtqueue *vqs[2];
+	char tag[VIRTIO_FS_TAG_LEN + 1];
+	u64 unique;
+	uint max_read;
+	bool ready;
+};
+
+/* Device used by the virtio_fs_...() filesystem functions */
+static struct udevice *virtio_fs_cur;
+
+/**
+ * virtio_fs_xfer() - Send a FUSE request and wait for the reply
+ *
+ * @dev: virtio-fs device
+ * @opcode: Request to send (enum fuse_opcode)
+ * @nodeid: Node the request is for
+ * @in: Argument to send, or NULL if none
+ * @in_len: Length of @in in bytes
+ * @out: Buffer for the reply, or NULL if none is expected
+ * @out_len: Size of @out in bytes
+ * @actualp: Returns the length of the reply in bytes, if not NULL
+ * Return: 0 if OK, -ve error from the host or -EIO if the reply is invalid
+ */
+static int virtio_fs_xfer(struct udevice *dev, u32 opcode, u64 nodeid,
+			  const void *in, uint in_len, void *out, uint out_len,
+			  uint *actualp)
+{
+	struct virtio_fs_priv *priv = dev_get_priv(dev);
+	struct virtqueue *vq = priv->vqs[1];
+	struct fuse_in_header in_hdr;
+	struct fuse_out_header out_hdr;
+	struct virtio_sg in_hdr_sg = { &in_hdr, sizeof(in_hdr) };
+	struct virtio_sg in_sg = { (void *)in, in_len };
+	struct virtio_sg out_hdr_sg = { &out_hdr, sizeof(out_hdr) };
+	struct virtio_sg out_sg = { out, out_len };
+	struct virtio_sg *sgs[4];
+	uint num_out = 0, num_in = 0;
+	uint len;
+	int error;
+	int ret;
+
+	memset(&in_hdr, '\0', sizeof(in_hdr));
+	in_hdr.len = cpu_to_le32(sizeof(in_hdr) + in_len);
+	in_hdr.opcode = cpu_to_le32(opcode);
+	in_hdr.unique = cpu_to_le64(++priv->unique);
+	in_hdr.nodeid = cpu_to_le64(nodeid);
+
+	sgs[num_out++] = &in_hdr_sg;
+	if (in_len)
+		sgs[num_out++] = &in_sg;
+	sgs[num_out + num_in++] = &out_hdr_sg;
+	if (out_len)
+		sgs[num_out + num_in++] = &out_sg;
+
+	ret = virtqueue_add(vq, sgs, num_out, num_in);
+	if (ret)
+		return ret;
+	virtqueue_kick(vq);
+	while (!virtqueue_get_buf(vq, NULL))
+		;
+
+	len = le32_to_cpu(out_hdr.len);
+	error = (int)le32_to_cpu(out_hdr.error);
+	if (le64_to_cpu(out_hdr.unique) != priv->unique ||
+	    len < sizeof(out_hdr) || len > sizeof(out_hdr) + out_len) {
+		log_debug("Invalid reply to opcode %u\n", opcode);
+		return -EIO;
+	}
+	if (error) {
+		log_debug("Opcode %u on node %llx: err=%d\n", opcode,
+			  (unsigned long long)nodeid, error);
+		return error < 0 ? error : -EIO;
+	}
+	if (actualp)
+		*actualp = len - sizeof(out_hdr);
+
+	return 0;
+}
+
+/* Set up the FUSE session, once the device is running */
+static int virtio_fs_start(struct udevice *dev)
+{
+	struct virtio_fs_priv *priv = dev_get_priv(dev);
+	struct fuse_init_in init_in;
+	struct fuse_init_out init_out;
+	uint flags, max_pages;
+	int ret;
+
+	if (priv->ready)
+		return 0;
+
+	memset(&init_in, '\0', sizeof(init_in));
+	init_in.major = cpu_to_le32(FUSE_KERNEL_VERSION);
+	init_in.minor = cpu_to_le32(FUSE_KERNEL_MINOR_VERSION);
+	init_in.flags = cpu_to_le32(FUSE_MAX_PAGES);
+	memset(&init_out, '\0', sizeof(init_out));
+	ret = virtio_fs_xfer(dev, FUSE_INIT, 0, &init_in, sizeof(init_in),
+			     &init_out, sizeof(init_out), NULL);
+	if (ret)
+		return log_msg_ret("init", ret);
+	if (le32_to_cpu(init_out.major) != FUSE_KERNEL_VERSION)
+		return log_msg_ret("ver", -EPROTONOSUPPORT);
+
+	/* Without FUSE_MAX_PAGES the host expects no more than 32 pages */
+	flags = le32_to_cpu(init_out.flags);
+	max_pages = 32;
+	if (flags & FUSE_MAX_PAGES && le16_to_cpu(init_out.max_pages))
+		max_pages = le16_to_cpu(init_out.max_pages);
+	priv->max_read = max_pages * SZ_4K;
+	priv->ready = true;
+	log_debug("%s: tag '%s', max read %x\n", dev->name, priv->tag,
+		  priv->max_read);
+
+	return 0;
+}
+
+static int virtio_fs_getattr(struct udevice *dev, u64 nodeid,
+			     struct fuse_entry_out *entry)
+{
+	struct fuse_getattr_in getattr_in;
+	struct fuse_attr_out attr_out;
+	int ret;
+
+	memset(&getattr_in, '\0', sizeof(getattr_in));
+	ret = virtio_fs_xfer(dev, FUSE_GETATTR, nodeid, &getattr_in,
+			     sizeof(getattr_in), &attr_out, sizeof(attr_out),
+			     NULL);
+	if (ret)
+		return ret;
+	memset(entry, '\0', sizeof(*entry));
+	entry->nodeid = cpu_to_le64(nodeid);
+	entry->attr = attr_out.attr;
+
+	return 0;
+}
+
+/**
+ * virtio_fs_lookup() - Look up a path, following symlinks
+ *
+ * The host keeps a lookup count for each node found. These are not given
+ * back, since the device is reset before the OS starts.
+ *
+ * @dev: virtio-fs device
+ * @path: Path to look up, relative to the root of the share
+ * @entry: Returns the node ID and attributes
+ * Return: 0 if OK, -ve on error
+ */
+static int virtio_fs_lookup(struct udevice *dev, const char *path,
+			    struct fuse_entry_out *entry)
+{
+	u64 nodeid = FUSE_ROOT_ID;
+	char *buf, *target, *name, *rest;
+	int links = 0;
+	uint len, rest_len;
+	int ret;
+
+	buf = malloc(2 * VIRTIO_FS_PATH_MAX);
+	if (!buf)
+		return -ENOMEM;
+	target = buf + VIRTIO_FS_PATH_MAX;
+	if (strlcpy(buf, path, VIRTIO_FS_PATH_MAX) >= VIRTIO_FS_PATH_MAX) {
+		ret = -ENAMETOOLONG;
+		goto out;
+	}
+
+	ret = virtio_fs_getattr(dev, nodeid, entry);
+	for (rest = buf; !ret;) {
+		while (*rest == '/')
+			rest++;
+		if (!*rest)
+			break;
+		name = rest;
+		rest = strchr(name, '/');
+		if (rest)
+			*rest++ = '\0';
+		else
+			rest = name + strlen(name);
+		if (!strcmp(name, "."))
+			continue;
+
+		ret = virtio_fs_xfer(dev, FUSE_LOOKUP, nodeid, name,
+				     strlen(name) + 1, entry, sizeof(*entry),
+				     NULL);
+		if (ret)
+			break;
+		if (!S_ISLNK(le32_to_cpu(entry->attr.mode))) {
+			nodeid = le64_to_cpu(entry->nodeid);
+			continue;
+		}
+
+		/* Carry on with the link target, then the rest of the path */
+		if (++links > VIRTIO_FS_MAX_LINKS) {
+			ret = -ELOOP;
+			break;
+		}
+		ret = virtio_fs_xfer(dev, FUSE_READLINK,
+				     le64_to_cpu(entry->nodeid), NULL, 0,
+				     target, VIRTIO_FS_PATH_MAX, &len);
+		if (ret)
+			break;
+		rest_len = strlen(rest);
+		if (len + 1 + rest_len >= VIRTIO_FS_PATH_MAX) {
+			ret = -ENAMETOOLONG;
+			break;
+		}
+		memmove(buf + len + 1, rest, rest_len + 1);
+		memcpy(buf, target, len);
+		buf[len] = '/';
+		rest = buf;
+		if (*target == '/')
+			nodeid = FUSE_ROOT_ID;
+		ret = virtio_fs_getattr(dev, nodeid, entry);
+	}
+out:
+	free(buf);
+
+	return ret;
+}
+
+static int virtio_fs_open(struct udevice *dev, u64 nodeid, bool dir,
+			  u64 *fhp)
+{
+	struct fuse_open_in open_in;
+	struct fuse_open_out open_out;
+	int ret;
+
+	memset(&open_in, '\0', sizeof(open_in));
+	ret = virtio_fs_xfer(dev, dir ? FUSE_OPENDIR : FUSE_OPEN, nodeid,
+			     &open_in, sizeof(open_in), &open_out,
+			     sizeof(open_out), NULL);
+	if (ret)
+		return ret;
+	*fhp = le64_to_cpu(open_out.fh);
+
+	return 0;
+}
+
+static void virtio_fs_release(struct udevice *dev, u64 nodeid, bool dir,
+			      u64 fh)
+{
+	struct fuse_release_in release_in;
+
+	memset(&release_in, '\0', sizeof(release_in));
+	release_in.fh = cpu_to_le64(fh);
+	virtio_fs_xfer(dev, dir ? FUSE_RELEASEDIR : FUSE_RELEASE, nodeid,
+		       &release_in, sizeof(release_in), NULL, 0, NULL);
+}
+
+/* Read from an open file or directory, returning the number of bytes read */
+static int virtio_fs_read_fh(struct udevice *dev, u64 nodeid, bool dir,
+			     u64 fh, u64 offset, void *buf, uint size,
+			     uint *actualp)
+{
+	struct fuse_read_in read_in;
+
+	memset(&read_in, '\0', sizeof(read_in));
+	read_in.fh = cpu_to_le64(fh);
+	read_in.offset = cpu_to_le64(offset);
+	read_in.size = cpu_to_le32(size);
+
+	return virtio_fs_xfer(dev, dir ? FUSE_READDIR : FUSE_READ, nodeid,
+			      &read_in, sizeof(read_in), buf, size, actualp);
+}
+
+int virtio_fs_select(struct udevice *dev)
+{
+	int ret;
+
+	ret = device_probe(dev);
+	if (ret)
+		return log_msg_ret("probe", ret);
+	ret = virtio_fs_start(dev);
+	if (ret)
+		return ret;
+	virtio_fs_cur = dev;
+	fs_set_type(FS_TYPE_VIRTIO);
+
+	return 0;
+}
+
+int virtio_fs_select_name(const char *name)
+{
+	struct udevice *dev;
+	char tag[VIRTIO_FS_TAG_LEN + 1];
+	char *end;
+	int seq;
+
+	/* Drop any partition, since there is only one filesystem */
+	strlcpy(tag, name ? name : "", sizeof(tag));
+	end = strchr(tag, ':');
+	if (end)
+		*end = '\0';
+
+	seq = *tag ? simple_strtol(tag, &end, 10) : 0;
+	if (!*tag || !*end) {
+		if (uclass_get_device_by_seq(UCLASS_FS, seq, &dev))
+			return -ENODEV;
+		return virtio_fs_select(dev);
+	}
+
+	uclass_foreach_dev_probe(UCLASS_FS, dev) {
+		struct virtio_fs_priv *priv = dev_get_priv(dev);
+
+		if (dev->driver == DM_DRIVER_GET(virtio_fs) &&
+		    !strcmp(priv->tag, tag))
+			return virtio_fs_select(dev);
+	}
+
+	return -ENODEV;
+}
+
+int virtio_fs_set_blk_dev(struct blk_desc *rbdd, struct disk_partition *info)
+{
+	/* Only accept the pseudo-partition set up by virtio_fs_select_name() */
+	if (rbdd || !virtio_fs_cur ||
+	    strcmp((char *)info->name, VIRTIO_FS_PART_NAME))
+		return -1;
+
+	return 0;
+}
+
+int virtio_fs_ls(const char *dirname)
+{
+	struct udevice *dev = virtio_fs_cur;
+	struct fuse_entry_out entry;
+	struct fuse_dirent *de;
+	int nfiles = 0, ndirs = 0;
+	uint len, pos, reclen, namelen;
+	u64 nodeid, fh, offset;
+	char *buf, *name;
+	int ret;
+
+	ret = virtio_fs_lookup(dev, dirname, &entry);
+	if (ret)
+		return ret;
+	if (!S_ISDIR(le32_to_cpu(entry.attr.mode)))
+		return -ENOTDIR;
+	nodeid = le64_to_cpu(entry.nodeid);
+
+	buf = malloc(VIRTIO_FS_DIR_BUF_SIZE + FS_DIRENT_NAME_LEN);
+	if (!buf)
+		return -ENOMEM;
+	name = buf + VIRTIO_FS_DIR_BUF_SIZE;
+	ret = virtio_fs_open(dev, nodeid, true, &fh);
+	if (ret)
+		goto err_buf;
+
+	for (offset = 0;;) {
+		ret = virtio_fs_read_fh(dev, nodeid, true, fh, offset, buf,
+					VIRTIO_FS_DIR_BUF_SIZE, &len);
+		if (ret || !len)
+			break;
+		for (pos = 0; pos + sizeof(*de) <= len; pos += reclen) {
+			de = (struct fuse_dirent *)(buf + pos);
+			reclen = FUSE_DIRENT_ALIGN(sizeof(*de) +
+						   le32_to_cpu(de->namelen));
+			if (!reclen || pos + reclen > len)
+				break;
+			namelen = min_t(uint, le32_to_cpu(de->namelen),
+					FS_DIRENT_NAME_LEN - 1);
+			memcpy(name, de->name, namelen);
+			name[namelen] = '\0';
+			offset = le64_to_cpu(de->off);
+
+			switch (le32_to_cpu(de->type)) {
+			case FS_DT_DIR:
+				printf("            %s/\n", name);
+				ndirs++;
+				break;
+			case FS_DT_LNK:
+				printf("    <SYM>   %s\n", name);
+				nfiles++;
+				break;
+			default:
+				/* The entry does not include the size */
+				if (virtio_fs_xfer(dev, FUSE_LOOKUP, nodeid,
+						   name, strlen(name) + 1,
+						   &entry, sizeof(entry), NULL))
+					entry.attr.size = 0;
+				printf(" %8lld   %s\n",
+				       le64_to_cpu(entry.attr.size), name);
+				nfiles++;
+			}
+		}
+	}
+	virtio_fs_release(dev, nodeid, true, fh);
+	if (!ret)
+		printf("\n%d file(s), %d dir(s)\n\n", nfiles, ndirs);
+
+err_buf:
+	free(buf);
+
+	return ret;
+}
+
+int virtio_fs_exists(const char *filename)
+{
+	struct fuse_entry_out entry;
+
+	return !virtio_fs_lookup(virtio_fs_cur, filename, &entry);
+}
+
+int virtio_fs_size(const char *filename, loff_t *size)
+{
+	struct fuse_entry_out entry;
+	int ret;
+
+	ret = virtio_fs_lookup(virtio_fs_cur, filename, &entry);
+	if (ret)
+		return ret;
+	if (S_ISDIR(le32_to_cpu(entry.attr.mode)))
+		return -EISDIR;
+	*size = le64_to_cpu(entry.attr.size);
+
+	return 0;
+}
+
+int virtio_fs_read(const char *filename, void *buf, loff_t offset, loff_t len,
+		   loff_t *actread)
+{
+	struct udevice *dev = virtio_fs_cur;
+	struct virtio_fs_priv *priv = dev_get_priv(dev);
+	struct fuse_entry_out entry;
+	loff_t size, done;
+	u64 nodeid, fh;
+	uint actual;
+	int ret;
+
+	ret = virtio_fs_lookup(dev, filename, &entry);
+	if (ret)
+		return ret;
+	if (S_ISDIR(le32_to_cpu(entry.attr.mode)))
+		return -EISDIR;
+	nodeid = le64_to_cpu(entry.nodeid);
+	size = le64_to_cpu(entry.attr.size);
+	if (offset > size)
+		return -EINVAL;
+	if (!len || len > size - offset)
+		len = size - offset;
+
+	ret = virtio_fs_open(dev, nodeid, false, &fh);
+	if (ret)
+		return ret;
+	for (done = 0; done < len; done += actual) {
+		ret = virtio_fs_read_fh(dev, nodeid, false, fh, offset + done,
+					buf + done,
+					min_t(loff_t, len - done,
+					      priv->max_read),
+					&actual);
+		if (ret || !actual)
+			break;
+	}
+	virtio_fs_release(dev, nodeid, false, fh);
+	if (ret)
+		return ret;
+	*actread = done;
+
+	return 0;
+}
+
+void virtio_fs_close(void)
+{
+}
+
+static int virtio_fs_bind(struct udevice *dev)
+{
+	struct virtio_dev_priv *uc_priv = dev_get_uclass_priv(dev->parent);
+	int ret;
+
+	/* Indicate what driver features we support */
+	virtio_driver_features_init(uc_priv, NULL, 0, NULL, 0);
+
+	ret = bootdev_setup_for_dev(dev, "virtio_fs_bootdev");
+	if (ret)
+		return log_msg_ret("bootdev", ret);
+
+	return 0;
+}
+
+static int virtio_fs_probe(struct udevice *dev)
+{
+	struct virtio_fs_priv *priv = dev_get_priv(dev);
+	int ret;
+
+	/* The requests are in FUSE format, which the legacy spec lacks */
+	if (!virtio_has_feature(dev, VIRTIO_F_VERSION_1))
+		return -ENODEV;
+
+	virtio_cread_bytes(dev, offsetof(struct virtio_fs_config, tag),
+			   priv->tag, VIRTIO_FS_TAG_LEN);
+	priv->tag[VIRTIO_FS_TAG_LEN] = '\0';
+
+	ret = virtio_find_vqs(dev, ARRAY_SIZE(priv->vqs), priv->vqs);
+	if (ret < 0)
+		return ret;
+
+	return 0;
+}
+
+static int virtio_fs_remove(struct udevice *dev)
+{
+	struct virtio_fs_priv *priv = dev_get_priv(dev);
+
+	if (virtio_fs_cur == dev)
+		virtio_fs_cur = NULL;
+	priv->ready = false;
+
+	return virtio_reset(dev);
+}
+
+U_BOOT_DRIVER(virtio_fs) = {
+	.name	= VIRTIO_FS_DRV_NAME,
+	.id	= UCLASS_FS,
+	.bind	= virtio_fs_bind,
+	.probe	= virtio_fs_probe,
+	.remove	= virtio_fs_remove,
+	.priv_auto	= sizeof(struct virtio_fs_priv),
+	.flags	= DM_FLAG_ACTIVE_DMA,
+};
+
+UCLASS_DRIVER(fs) = {
+	.id		= UCLASS_FS,
+	.name		= "fs",
+};
+
+static int virtio_fs_get_bootflow(struct udevice *dev,
+				  struct bootflow_iter *iter,
+				  struct bootflow *bflow)
+{
+	struct udevice *media = dev_get_parent(dev);
+	int ret;
+
+	if (!CONFIG_IS_ENABLED(BOOTSTD))
+		return -ENOSYS;
+
+	ret = bootmeth_check(bflow->method, iter);
+	if (ret)
+		return log_msg_ret("check", ret);
+
+	/* There is only the whole share, with no partitions */
+	if (iter->part)
+		return log_msg_ret("max", -ESHUTDOWN);
+
+	ret = virtio_fs_select(media);
+	if (ret)
+		return log_msg_ret("sel", ret);
+	bflow->fs_type = FS_TYPE_VIRTIO;
+
+	log_debug("reading bootflow with method: %s\n", bflow->method->name);
+	ret = bootmeth_read_bootflow(bflow->method, bflow);
+	if (ret)
+		return log_msg_ret("method", ret);
+
+	return 0;
+}
+
+static int virtio_fs_bootdev_bind(struct udevice *dev)
+{
+	struct bootdev_uc_plat *ucp = dev_get_uclass_plat(dev);
+
+	ucp->prio = BOOTDEVP_4_SCAN_FAST;
+
+	return 0;
+}
+
+static int virtio_fs_bootdev_hunt(struct bootdev_hunter *info, bool show)
+{
+	int ret;
+
+	if (IS_ENABLED(CONFIG_PCI)) {
+		ret = uclass_probe_all(UCLASS_PCI);
+		if (ret && ret != -ENOENT)
+			return log_msg_ret("pci", ret);
+	}
+
+	ret = virtio_init();
+	if (ret && ret != -ENOENT)
+		return log_msg_ret("vir", ret);
+
+	return 0;
+}
+
+struct bootdev_ops virtio_fs_bootdev_ops = {
+	.get_bootflow	= virtio_fs_get_bootflow,
+};
+
+static const struct udevice_id virtio_fs_bootdev_ids[] = {
+	{ .compatible = "u-boot,bootdev-virtio-fs" },
+	{ }
+};
+
+U_BOOT_DRIVER(virtio_fs_bootdev) = {
+	.name		= "virtio_fs_bootdev",
+	.id		= UCLASS_BOOTDEV,
+	.ops		= &virtio_fs_bootdev_ops,
+	.bind		= virtio_fs_bootdev_bind,
+	.of_match	= virtio_fs_bootdev_ids,
+};
+
+BOOTDEV_HUNTER(virtio_fs_bootdev_hunter) = {
+	.prio		= BOOTDEVP_4_SCAN_FAST,
+	.uclass		= UCLASS_FS,
+	.hunt		= virtio_fs_bootdev_hunt,
+	.drv		= DM_DRIVER_REF(virtio_fs_bootdev),
+};
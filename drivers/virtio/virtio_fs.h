@@ -0,0 +1,166 @@
+/* SPDX-License-Identifier: GPL-2.0+ */
+/*
+ * The subset of the FUSE protocol used by the virtio-fs driver
+ *
+ * This comes from the Linux kernel include/uapi/linux/fuse.h, with the
+ * structures trimmed to protocol version 7.31. virtio-fs carries FUSE
+ * messages in little-endian byte order.
+ */
+
+#ifndef _LINUX_VIRTIO_FS_H
+#define _LINUX_VIRTIO_FS_H
+
+#include <linux/types.h>
+
+/* Length of the mount tag in the device configuration space */
+#define VIRTIO_FS_TAG_LEN		36
+
+struct __packed virtio_fs_config {
+	/* Filesystem name, UTF-8, not NUL-terminated if 36 bytes long */
+	__u8 tag[VIRTIO_FS_TAG_LEN];
+	/* Number of request queues */
+	__le32 num_request_queues;
+};
+
+#define FUSE_KERNEL_VERSION		7
+#define FUSE_KERNEL_MINOR_VERSION	31
+
+/* The node ID of the root directory */
+#define FUSE_ROOT_ID			1
+
+/* fuse_init_in / fuse_init_out flags */
+#define FUSE_MAX_PAGES			(1 << 22)
+
+enum fuse_opcode {
+	FUSE_LOOKUP		= 1,
+	FUSE_GETATTR		= 3,
+	FUSE_READLINK		= 5,
+	FUSE_OPEN		= 14,
+	FUSE_READ		= 15,
+	FUSE_RELEASE		= 18,
+	FUSE_INIT		= 26,
+	FUSE_OPENDIR		= 27,
+	FUSE_READDIR		= 28,
+	FUSE_RELEASEDIR		= 29,
+};
+
+struct fuse_attr {
+	__le64 ino;
+	__le64 size;
+	__le64 blocks;
+	__le64 atime;
+	__le64 mtime;
+	__le64 ctime;
+	__le32 atimensec;
+	__le32 mtimensec;
+	__le32 ctimensec;
+	__le32 mode;
+	__le32 nlink;
+	__le32 uid;
+	__le32 gid;
+	__le32 rdev;
+	__le32 blksize;
+	__le32 flags;
+};
+
+struct fuse_entry_out {
+	__le64 nodeid;		/* Inode ID */
+	__le64 generation;	/* Inode generation: nodeid:gen must be unique */
+	__le64 entry_valid;	/* Cache timeout for the name */
+	__le64 attr_valid;	/* Cache timeout for the attributes */
+	__le32 entry_valid_nsec;
+	__le32 attr_valid_nsec;
+	struct fuse_attr attr;
+};
+
+struct fuse_getattr_in {
+	__le32 getattr_flags;
+	__le32 dummy;
+	__le64 fh;
+};
+
+struct fuse_attr_out {
+	__le64 attr_valid;	/* Cache timeout for the attributes */
+	__le32 attr_valid_nsec;
+	__le32 dummy;
+	struct fuse_attr attr;
+};
+
+struct fuse_open_in {
+	__le32 flags;
+	__le32 open_flags;
+};
+
+struct fuse_open_out {
+	__le64 fh;
+	__le32 open_flags;
+	__le32 padding;
+};
+
+struct fuse_release_in {
+	__le64 fh;
+	__le32 flags;
+	__le32 release_flags;
+	__le64 lock_owner;
+};
+
+struct fuse_read_in {
+	__le64 fh;
+	__le64 offset;
+	__le32 size;
+	__le32 read_flags;
+	__le64 lock_owner;
+	__le32 flags;
+	__le32 padding;
+};
+
+struct fuse_init_in {
+	__le32 major;
+	__le32 minor;
+	__le32 max_readahead;
+	__le32 flags;
+};
+
+struct fuse_init_out {
+	__le32 major;
+	__le32 minor;
+	__le32 max_readahead;
+	__le32 flags;
+	__le16 max_background;
+	__le16 congestion_threshold;
+	__le32 max_write;
+	__le32 time_gran;
+	__le16 max_pages;
+	__le16 map_alignment;
+	__le32 flags2;
+	__le32 unused[7];
+};
+
+struct fuse_in_header {
+	__le32 len;
+	__le32 opcode;
+	__le64 unique;
+	__le64 nodeid;
+	__le32 uid;
+	__le32 gid;
+	__le32 pid;
+	__le32 padding;
+};
+
+struct fuse_out_header {
+	__le32 len;
+	__le32 error;
+	__le64 unique;
+};
+
+struct fuse_dirent {
+	__le64 ino;
+	__le64 off;
+	__le32 namelen;
+	__le32 type;
+	char name[];
+};
+
+#define FUSE_DIRENT_ALIGN(x)	ALIGN(x, sizeof(__u64))
+
+#endif /* _LINUX_VIRTIO_FS_H */
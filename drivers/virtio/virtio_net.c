@@ -5,21 +5,33 @@
  */
 
 #include <dm.h>
+#include <malloc.h>
 #include <net.h>
 #include <virtio_types.h>
 #include <virtio.h>
 #include <virtio_ring.h>
 #include "virtio_net.h"
 
-/* Amount of buffers to keep in the RX virtqueue */
-#define VIRTIO_NET_NUM_RX_BUFS	32
-
 /*
  * This value comes from the VirtIO spec: 1500 for maximum packet size,
  * 14 for the Ethernet header, 12 for virtio_net_hdr. In total 1526 bytes.
  */
 #define VIRTIO_NET_RX_BUF_SIZE	1526
 
+/* Amount of buffers for packets which the device has not sent yet */
+#define VIRTIO_NET_NUM_TX_BUFS	32
+
+/**
+ * struct virtio_net_tx_buf - A packet waiting to be sent
+ *
+ * @hdr: Header passed to the device, always zero
+ * @data: Copy of the packet
+ */
+struct virtio_net_tx_buf {
+	struct virtio_net_hdr_v1 hdr;
+	uchar data[PKTSIZE_ALIGN];
+};
+
 struct virtio_net_priv {
 	union {
 		struct virtqueue *vqs[2];
@@ -29,91 +41,203 @@ struct virtio_net_priv {
 		};
 	};
 
-	char rx_buff[VIRTIO_NET_NUM_RX_BUFS][VIRTIO_NET_RX_BUF_SIZE];
+	char (*rx_buff)[VIRTIO_NET_RX_BUF_SIZE];
+	int rx_nbufs;
+	/* Buffers put back in the rx ring since the device was last told */
+	int rx_pending;
 	bool rx_running;
+	bool mrg_rxbuf;
 	int net_hdr_len;
+	struct virtio_net_tx_buf *tx_buff;
+	/* Transmit buffers not owned by the device */
+	struct virtio_net_tx_buf *tx_free[VIRTIO_NET_NUM_TX_BUFS];
+	int tx_nfree;
 };
 
 /*
- * For simplicity, the driver only negotiates the VIRTIO_NET_F_MAC feature.
- * For the VIRTIO_NET_F_STATUS feature, we don't negotiate it, hence per spec
- * we should assume the link is always active.
+ * For simplicity, the driver only negotiates the VIRTIO_NET_F_MAC,
+ * VIRTIO_NET_F_MRG_RXBUF and VIRTIO_NET_F_GUEST_CSUM features. For the
+ * VIRTIO_NET_F_STATUS feature, we don't negotiate it, hence per spec we should
+ * assume the link is always active.
  */
 static const u32 feature[] = {
-	VIRTIO_NET_F_MAC
+	VIRTIO_NET_F_MAC,
+	VIRTIO_NET_F_MRG_RXBUF,
+	VIRTIO_NET_F_GUEST_CSUM,
 };
 
 static const u32 feature_legacy[] = {
-	VIRTIO_NET_F_MAC
+	VIRTIO_NET_F_MAC,
+	VIRTIO_NET_F_MRG_RXBUF,
+	VIRTIO_NET_F_GUEST_CSUM,
 };
 
-static int virtio_net_start(struct udevice *dev)
+static void virtio_net_rx_add(struct virtio_net_priv *priv, void *buf)
 {
-	struct virtio_net_priv *priv = dev_get_priv(dev);
-	struct virtio_sg sg;
+	struct virtio_sg sg = { buf, VIRTIO_NET_RX_BUF_SIZE };
 	struct virtio_sg *sgs[] = { &sg };
-	int i;
-
-	if (!priv->rx_running) {
-		/* receive buffer length is always 1526 */
-		sg.length = VIRTIO_NET_RX_BUF_SIZE;
 
-		/* setup the receive buffer address */
-		for (i = 0; i < VIRTIO_NET_NUM_RX_BUFS; i++) {
-			sg.addr = priv->rx_buff[i];
-			virtqueue_add(priv->rx_vq, sgs, 0, 1);
-		}
+	virtqueue_add(priv->rx_vq, sgs, 0, 1);
+	priv->rx_pending++;
+}
 
+/*
+ * Tell the device about the buffers put back in the rx ring. This is done
+ * once a quarter of the ring is waiting, or when there are no packets, so
+ * that the device is never left without buffers.
+ */
+static void virtio_net_rx_kick(struct virtio_net_priv *priv, bool idle)
+{
+	if (!priv->rx_pending)
+		return;
+	if (idle || priv->rx_pending >= priv->rx_nbufs / 4) {
 		virtqueue_kick(priv->rx_vq);
+		priv->rx_pending = 0;
+	}
+}
 
-		/* setup the receive queue only once */
-		priv->rx_running = true;
+static void *virtio_net_rx_get(struct udevice *dev, unsigned int *lenp)
+{
+	struct virtio_net_priv *priv = dev_get_priv(dev);
+	struct virtio_net_hdr_v1 *hdr;
+	unsigned int len;
+	void *buf;
+	int nbufs;
+
+	while ((buf = virtqueue_get_buf(priv->rx_vq, &len))) {
+		hdr = buf;
+		nbufs = priv->mrg_rxbuf ?
+			virtio16_to_cpu(dev, hdr->num_buffers) : 1;
+		if (nbufs == 1) {
+			*lenp = len;
+			return buf;
+		}
+
+		/*
+		 * The packet is too large for one buffer, so it cannot be
+		 * bigger than the MTU and is dropped
+		 */
+		debug("%s: dropping packet in %d buffers\n", __func__, nbufs);
+		virtio_net_rx_add(priv, buf);
+		while (--nbufs > 0) {
+			buf = virtqueue_get_buf(priv->rx_vq, NULL);
+			if (!buf)
+				break;
+			virtio_net_rx_add(priv, buf);
+		}
 	}
 
-	return 0;
+	return NULL;
 }
 
-static int virtio_net_send(struct udevice *dev, void *packet, int length)
+static void virtio_net_tx_reclaim(struct virtio_net_priv *priv)
 {
-	struct virtio_net_priv *priv = dev_get_priv(dev);
-	struct virtio_net_hdr hdr;
-	struct virtio_net_hdr_v1 hdr_v1;
-	struct virtio_sg hdr_sg;
-	struct virtio_sg data_sg = { packet, length };
+	struct virtio_net_tx_buf *tb;
+
+	while ((tb = virtqueue_get_buf(priv->tx_vq, NULL)))
+		priv->tx_free[priv->tx_nfree++] = tb;
+}
+
+static int virtio_net_tx_add(struct virtio_net_priv *priv, void *packet,
+			     int length)
+{
+	struct virtio_net_tx_buf *tb;
+	struct virtio_sg hdr_sg, data_sg;
 	struct virtio_sg *sgs[] = { &hdr_sg, &data_sg };
 	int ret;
 
-	if (priv->net_hdr_len == sizeof(struct virtio_net_hdr))
-		hdr_sg.addr = &hdr;
-	else
-		hdr_sg.addr = &hdr_v1;
-	hdr_sg.length = priv->net_hdr_len;
+	if (length > PKTSIZE_ALIGN)
+		return -EMSGSIZE;
 
-	memset(hdr_sg.addr, 0, priv->net_hdr_len);
+	if (!priv->tx_nfree)
+		virtio_net_tx_reclaim(priv);
+	if (!priv->tx_nfree)
+		return -ENOSPC;
+	tb = priv->tx_free[--priv->tx_nfree];
 
+	memcpy(tb->data, packet, length);
+	hdr_sg.addr = &tb->hdr;
+	hdr_sg.length = priv->net_hdr_len;
+	data_sg.addr = tb->data;
+	data_sg.length = length;
 	ret = virtqueue_add(priv->tx_vq, sgs, 2, 0);
 	if (ret)
-		return ret;
+		priv->tx_free[priv->tx_nfree++] = tb;
 
-	virtqueue_kick(priv->tx_vq);
+	return ret;
+}
 
-	while (1) {
-		if (virtqueue_get_buf(priv->tx_vq, NULL))
-			break;
+static int virtio_net_start(struct udevice *dev)
+{
+	struct virtio_net_priv *priv = dev_get_priv(dev);
+	int i;
+
+	if (!priv->rx_running) {
+		/* setup the receive buffer address */
+		for (i = 0; i < priv->rx_nbufs; i++)
+			virtio_net_rx_add(priv, priv->rx_buff[i]);
+
+		virtio_net_rx_kick(priv, true);
+
+		/* setup the receive queue only once */
+		priv->rx_running = true;
 	}
 
 	return 0;
 }
 
+static int virtio_net_send_batch(struct udevice *dev, struct eth_pkt *pkts,
+				 int count)
+{
+	struct virtio_net_priv *priv = dev_get_priv(dev);
+	int sent, ret = 0;
+
+	/*
+	 * Packets are copied, so there is no need to wait for the device to
+	 * send them. Kick once for the whole batch, unless the ring fills up.
+	 */
+	for (sent = 0; sent < count; sent++) {
+		ret = virtio_net_tx_add(priv, pkts[sent].packet,
+					pkts[sent].length);
+		if (ret == -ENOSPC) {
+			if (sent)
+				virtqueue_kick(priv->tx_vq);
+			do {
+				ret = virtio_net_tx_add(priv, pkts[sent].packet,
+							pkts[sent].length);
+			} while (ret == -ENOSPC);
+		}
+		if (ret)
+			break;
+	}
+	if (sent)
+		virtqueue_kick(priv->tx_vq);
+
+	return sent ? sent : ret;
+}
+
+static int virtio_net_send(struct udevice *dev, void *packet, int length)
+{
+	struct eth_pkt pkt = { packet, length };
+	int ret;
+
+	ret = virtio_net_send_batch(dev, &pkt, 1);
+
+	return ret < 0 ? ret : 0;
+}
+
 static int virtio_net_recv(struct udevice *dev, int flags, uchar **packetp)
 {
 	struct virtio_net_priv *priv = dev_get_priv(dev);
 	unsigned int len;
 	void *buf;
 
-	buf = virtqueue_get_buf(priv->rx_vq, &len);
-	if (!buf)
+	virtio_net_rx_kick(priv, false);
+	buf = virtio_net_rx_get(dev, &len);
+	if (!buf) {
+		virtio_net_rx_kick(priv, true);
 		return -EAGAIN;
+	}
 
 	*packetp = buf + priv->net_hdr_len;
 	return len - priv->net_hdr_len;
@@ -122,23 +246,59 @@ static int virtio_net_recv(struct udevice *dev, int flags, uchar **packetp)
 static int virtio_net_free_pkt(struct udevice *dev, uchar *packet, int length)
 {
 	struct virtio_net_priv *priv = dev_get_priv(dev);
-	void *buf = packet - priv->net_hdr_len;
-	struct virtio_sg sg = { buf, VIRTIO_NET_RX_BUF_SIZE };
-	struct virtio_sg *sgs[] = { &sg };
 
 	/* Put the buffer back to the rx ring */
-	virtqueue_add(priv->rx_vq, sgs, 0, 1);
+	virtio_net_rx_add(priv, packet - priv->net_hdr_len);
 
 	return 0;
 }
 
+static int virtio_net_recv_batch(struct udevice *dev, int flags,
+				 struct eth_pkt *pkts, int count)
+{
+	struct virtio_net_priv *priv = dev_get_priv(dev);
+	struct virtio_net_hdr_v1 *hdr;
+	unsigned int len;
+	void *buf;
+	int i;
+
+	/* Tell the device about the buffers freed by the last batches */
+	virtio_net_rx_kick(priv, false);
+
+	for (i = 0; i < count; i++) {
+		buf = virtio_net_rx_get(dev, &len);
+		if (!buf)
+			break;
+		pkts[i].packet = buf + priv->net_hdr_len;
+		pkts[i].length = len - priv->net_hdr_len;
+
+		/*
+		 * With VIRTIO_NET_F_GUEST_CSUM the device either checked the
+		 * checksum or left it unfilled for a packet from the host
+		 */
+		hdr = buf;
+		if (hdr->flags & (VIRTIO_NET_HDR_F_DATA_VALID |
+				  VIRTIO_NET_HDR_F_NEEDS_CSUM))
+			pkts[i].flags |= ETH_PKT_CSUM_VALID;
+	}
+	if (!i)
+		virtio_net_rx_kick(priv, true);
+
+	return i;
+}
+
 static void virtio_net_stop(struct udevice *dev)
 {
+	struct virtio_net_priv *priv = dev_get_priv(dev);
+
 	/*
 	 * There is no way to stop the queue from running, unless we issue
 	 * a reset to the virtio device, and re-do the queue initialization
-	 * from the beginning.
+	 * from the beginning. Do make sure that the last packets have gone
+	 * out though, since the device may be reset next.
 	 */
+	while (priv->tx_nfree < VIRTIO_NET_NUM_TX_BUFS)
+		virtio_net_tx_reclaim(priv);
 }
 
 static int virtio_net_write_hwaddr(struct udevice *dev)
@@ -194,12 +354,26 @@ static int virtio_net_probe(struct udevice *dev)
 {
 	struct virtio_net_priv *priv = dev_get_priv(dev);
 	struct virtio_dev_priv *uc_priv = dev_get_uclass_priv(dev->parent);
-	int ret;
+	int ret, i;
 
 	ret = virtio_find_vqs(dev, 2, priv->vqs);
 	if (ret < 0)
 		return ret;
 
+	priv->rx_nbufs = min_t(uint, CONFIG_VIRTIO_NET_RX_BUFS,
+			       virtqueue_get_vring_size(priv->rx_vq));
+	priv->rx_buff = malloc(priv->rx_nbufs * VIRTIO_NET_RX_BUF_SIZE);
+	priv->tx_buff = calloc(VIRTIO_NET_NUM_TX_BUFS, sizeof(*priv->tx_buff));
+	if (!priv->rx_buff || !priv->tx_buff) {
+		free(priv->rx_buff);
+		free(priv->tx_buff);
+		virtio_del_vqs(dev);
+		return -ENOMEM;
+	}
+	for (i = 0; i < VIRTIO_NET_NUM_TX_BUFS; i++)
+		priv->tx_free[i] = &priv->tx_buff[i];
+	priv->tx_nfree = VIRTIO_NET_NUM_TX_BUFS;
+
 	/*
 	 * For v1.0 compliant device, it always assumes the member
 	 * 'num_buffers' exists in the struct virtio_net_hdr while
@@ -207,7 +381,8 @@ static int virtio_net_probe(struct udevice *dev)
 	 * VIRTIO_NET_F_MRG_RXBUF was negotiated. Without that feature
 	 * the structure was 2 bytes shorter.
 	 */
-	if (uc_priv->legacy)
+	priv->mrg_rxbuf = virtio_has_feature(dev, VIRTIO_NET_F_MRG_RXBUF);
+	if (uc_priv->legacy && !priv->mrg_rxbuf)
 		priv->net_hdr_len = sizeof(struct virtio_net_hdr);
 	else
 		priv->net_hdr_len = sizeof(struct virtio_net_hdr_v1);
@@ -215,11 +390,25 @@ static int virtio_net_probe(struct udevice *dev)
 	return 0;
 }
 
+static int virtio_net_remove(struct udevice *dev)
+{
+	struct virtio_net_priv *priv = dev_get_priv(dev);
+	int ret;
+
+	ret = virtio_reset(dev);
+	free(priv->rx_buff);
+	free(priv->tx_buff);
+
+	return ret;
+}
+
 static const struct eth_ops virtio_net_ops = {
 	.start = virtio_net_start,
 	.send = virtio_net_send,
 	.recv = virtio_net_recv,
 	.free_pkt = virtio_net_free_pkt,
+	.recv_batch = virtio_net_recv_batch,
+	.send_batch = virtio_net_send_batch,
 	.stop = virtio_net_stop,
 	.write_hwaddr = virtio_net_write_hwaddr,
 	.read_rom_hwaddr = virtio_net_read_rom_hwaddr,
@@ -230,7 +419,7 @@ U_BOOT_DRIVER(virtio_net) = {
 	.id	= UCLASS_ETH,
 	.bind	= virtio_net_bind,
 	.probe	= virtio_net_probe,
-	.remove = virtio_reset,
+	.remove = virtio_net_remove,
 	.ops	= &virtio_net_ops,
 	.priv_auto	= sizeof(struct virtio_net_priv),
 	.plat_auto	= sizeof(struct eth_pdata),
@@ -95,6 +95,108 @@ static void virtqueue_detach_desc(struct virtqueue *vq, unsigned int idx)
 	bb = &vq->vring.bouncebufs[idx];
 	bounce_buffer_stop(bb);
 	desc->addr = cpu_to_virtio64(vq->vdev, (u64)(uintptr_t)bb->user_buffer);
+	vq->vring_desc_shadow[idx].addr = (u64)(uintptr_t)bb->user_buffer;
+}
+
+/**
+ * virtqueue_expose() - make a descriptor chain available to the device
+ *
+ * @vq:		the struct virtqueue we're talking about
+ * @head:	first descriptor of the chain
+ */
+static void virtqueue_expose(struct virtqueue *vq, unsigned int head)
+{
+	unsigned int avail;
+
+	/* Mark the descriptor as the head of a chain. */
+	vq->vring_desc_shadow[head].chain_head = true;
+
+	/*
+	 * Put entry in available array (but don't update avail->idx
+	 * until they do sync).
+	 */
+	avail = vq->avail_idx_shadow & (vq->vring.num - 1);
+	vq->vring.avail->ring[avail] = cpu_to_virtio16(vq->vdev, head);
+
+	/*
+	 * Descriptors and available array need to be set before we expose the
+	 * new available array entries.
+	 */
+	virtio_wmb();
+	vq->avail_idx_shadow++;
+	vq->vring.avail->idx = cpu_to_virtio16(vq->vdev, vq->avail_idx_shadow);
+	vq->num_added++;
+
+	/*
+	 * This is very unlikely, but theoretically possible.
+	 * Kick just in case.
+	 */
+	if (unlikely(vq->num_added == (1 << 16) - 1))
+		virtqueue_kick(vq);
+}
+
+/**
+ * virtqueue_add_indirect() - add buffers using a single ring descriptor
+ *
+ * The buffers are described by a table of descriptors, reserved for this
+ * ring slot, which is pointed to by a single descriptor in the ring. This
+ * means that each request uses one ring entry however many buffers it has.
+ *
+ * @vq:		the struct virtqueue we're talking about
+ * @sgs:	array of terminated scatterlists
+ * @out_sgs:	the number of scatterlists readable by other side
+ * @in_sgs:	the number of scatterlists which are writable
+ * Return: 0 if OK, -ENOSPC if the ring is full
+ */
+static int virtqueue_add_indirect(struct virtqueue *vq,
+				  struct virtio_sg *sgs[],
+				  unsigned int out_sgs, unsigned int in_sgs)
+{
+	unsigned int descs_used = out_sgs + in_sgs;
+	struct vring_desc_shadow *desc_shadow;
+	struct vring_desc *desc, *table;
+	unsigned int head, n;
+
+	if (!vq->num_free) {
+		debug("Can't add indirect buf - ring full\n");
+		if (out_sgs)
+			virtio_notify(vq->vdev, vq);
+		return -ENOSPC;
+	}
+
+	head = vq->free_head;
+	table = &vq->indirect_desc[head * VIRTQUEUE_MAX_INDIRECT];
+	for (n = 0; n < descs_used; n++) {
+		u16 flags = n < descs_used - 1 ? VRING_DESC_F_NEXT : 0;
+
+		if (n >= out_sgs)
+			flags |= VRING_DESC_F_WRITE;
+		table[n].addr = cpu_to_virtio64(vq->vdev,
+						(u64)(uintptr_t)sgs[n]->addr);
+		table[n].len = cpu_to_virtio32(vq->vdev, sgs[n]->length);
+		table[n].flags = cpu_to_virtio16(vq->vdev, flags);
+		table[n].next = cpu_to_virtio16(vq->vdev, n + 1);
+	}
+
+	/*
+	 * The shadow records the first buffer, so that virtqueue_get_buf()
+	 * returns it as for a normal chain
+	 */
+	desc_shadow = &vq->vring_desc_shadow[head];
+	desc_shadow->addr = (u64)(uintptr_t)sgs[0]->addr;
+	desc_shadow->len = descs_used * sizeof(*table);
+	desc_shadow->flags = VRING_DESC_F_INDIRECT;
+
+	desc = &vq->vring.desc[head];
+	desc->addr = cpu_to_virtio64(vq->vdev, (u64)(uintptr_t)table);
+	desc->len = cpu_to_virtio32(vq->vdev, desc_shadow->len);
+	desc->flags = cpu_to_virtio16(vq->vdev, VRING_DESC_F_INDIRECT);
+
+	vq->num_free--;
+	vq->free_head = desc_shadow->next;
+	virtqueue_expose(vq, head);
+
+	return 0;
 }
 
 int virtqueue_add(struct virtqueue *vq, struct virtio_sg *sgs[],
@@ -102,11 +204,15 @@ int virtqueue_add(struct virtqueue *vq, struct virtio_sg *sgs[],
 {
 	struct vring_desc *desc;
 	unsigned int descs_used = out_sgs + in_sgs;
-	unsigned int i, n, avail, uninitialized_var(prev);
+	unsigned int i, n, uninitialized_var(prev);
 	int head;
 
 	WARN_ON(descs_used == 0);
 
+	if (vq->indirect_desc && descs_used > 1 &&
+	    descs_used <= VIRTQUEUE_MAX_INDIRECT)
+		return virtqueue_add_indirect(vq, sgs, out_sgs, in_sgs);
+
 	head = vq->free_head;
 
 	desc = vq->vring.desc;
@@ -143,31 +249,7 @@ int virtqueue_add(struct virtqueue *vq, struct virtio_sg *sgs[],
 	/* Update free pointer */
 	vq->free_head = i;
 
-	/* Mark the descriptor as the head of a chain. */
-	vq->vring_desc_shadow[head].chain_head = true;
-
-	/*
-	 * Put entry in available array (but don't update avail->idx
-	 * until they do sync).
-	 */
-	avail = vq->avail_idx_shadow & (vq->vring.num - 1);
-	vq->vring.avail->ring[avail] = cpu_to_virtio16(vq->vdev, head);
-
-	/*
-	 * Descriptors and available array need to be set before we expose the
-	 * new available array entries.
-	 */
-	virtio_wmb();
-	vq->avail_idx_shadow++;
-	vq->vring.avail->idx = cpu_to_virtio16(vq->vdev, vq->avail_idx_shadow);
-	vq->num_added++;
-
-	/*
-	 * This is very unlikely, but theoretically possible.
-	 * Kick just in case.
-	 */
-	if (unlikely(vq->num_added == (1 << 16) - 1))
-		virtqueue_kick(vq);
+	virtqueue_expose(vq, head);
 
 	return 0;
 }
@@ -316,6 +398,18 @@ static struct virtqueue *__vring_new_virtqueue(unsigned int index,
 
 	vq->event = virtio_has_feature(vdev, VIRTIO_RING_F_EVENT_IDX);
 
+	/* Indirect tables are not used with bounce buffers */
+	vq->indirect_desc = NULL;
+	if (virtio_has_feature(vdev, VIRTIO_RING_F_INDIRECT_DESC) &&
+	    !vring.bouncebufs) {
+		vq->indirect_desc = memalign(VRING_DESC_ALIGN_SIZE,
+					     vring.num * VIRTQUEUE_MAX_INDIRECT *
+					     sizeof(struct vring_desc));
+		if (!vq->indirect_desc)
+			debug("(%s): no memory for indirect descriptors\n",
+			      vdev->name);
+	}
+
 	/* Tell other side not to bother us */
 	vq->avail_flags_shadow |= VRING_AVAIL_F_NO_INTERRUPT;
 	if (!vq->event)
@@ -397,6 +491,7 @@ void vring_del_virtqueue(struct virtqueue *vq)
 	virtio_free_pages(vq->vdev, vq->vring.desc,
 			  DIV_ROUND_UP(vq->vring.size, PAGE_SIZE));
 	free(vq->vring_desc_shadow);
+	free(vq->indirect_desc);
 	list_del(&vq->list);
 	free(vq->vring.bouncebufs);
 	free(vq);
@@ -151,6 +151,7 @@ static const struct wdt_ops designware_wdt_ops = {
 	.start = designware_wdt_start,
 	.reset = designware_wdt_reset,
 	.stop = designware_wdt_stop,
+	.flags = WDT_RESET_IRQ_SAFE,
 };
 
 static const struct udevice_id designware_wdt_ids[] = {
@@ -150,6 +150,7 @@ static const struct wdt_ops imx_wdt_ops = {
 	.start		= imx_wdt_start,
 	.reset		= imx_wdt_reset,
 	.expire_now	= imx_wdt_expire_now,
+	.flags		= WDT_RESET_IRQ_SAFE,
 };
 
 static const struct udevice_id imx_wdt_ids[] = {
@@ -113,6 +113,7 @@ static const struct wdt_ops sbsa_gwdt_ops = {
 	.reset = sbsa_gwdt_reset,
 	.stop = sbsa_gwdt_stop,
 	.expire_now = sbsa_gwdt_expire_now,
+	.flags = WDT_RESET_IRQ_SAFE,
 };
 
 static const struct udevice_id sbsa_gwdt_ids[] = {
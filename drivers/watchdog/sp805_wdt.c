@@ -130,6 +130,7 @@ static const struct wdt_ops sp805_wdt_ops = {
 	.reset = sp805_wdt_reset,
 	.stop = sp805_wdt_stop,
 	.expire_now = sp805_wdt_expire_now,
+	.flags = WDT_RESET_IRQ_SAFE,
 };
 
 static const struct udevice_id sp805_wdt_ids[] = {
@@ -39,6 +39,8 @@ struct wdt_priv {
 	bool running;
 	/* autostart */
 	bool autostart;
+	/* Whether the device is serviced from the timer interrupt */
+	bool irq;
 
 	struct cyclic_info *cyclic;
 };
@@ -58,6 +60,51 @@ static void wdt_cyclic(void *ctx)
 	wdt_reset(dev);
 }
 
+void wdt_irq_service(void)
+{
+	struct wdt_priv *priv;
+	struct udevice *dev;
+	struct uclass *uc;
+
+	uclass_id_foreach_dev(UCLASS_WDT, dev, uc) {
+		if (!device_active(dev))
+			continue;
+		priv = dev_get_uclass_priv(dev);
+		if (priv->irq && priv->running)
+			wdt_reset(dev);
+	}
+}
+
+/**
+ * wdt_irq_update() - Set up the timer interrupt for the watchdogs using it
+ *
+ * The interrupt runs as often as the watchdog with the shortest reset period
+ * needs, and is stopped when no watchdog uses it
+ *
+ * Return: 0 if OK, -ve on error
+ */
+static int wdt_irq_update(void)
+{
+	ulong period = ULONG_MAX;
+	struct wdt_priv *priv;
+	struct udevice *dev;
+	struct uclass *uc;
+
+	uclass_id_foreach_dev(UCLASS_WDT, dev, uc) {
+		if (!device_active(dev))
+			continue;
+		priv = dev_get_uclass_priv(dev);
+		if (priv->irq)
+			period = min(period, priv->reset_period);
+	}
+	if (period == ULONG_MAX) {
+		arch_wdt_irq_stop();
+		return 0;
+	}
+
+	return arch_wdt_irq_start(max(1000 / max(period, 1UL), 1UL));
+}
+
 static void init_watchdog_dev(struct udevice *dev)
 {
 	struct wdt_priv *priv;
@@ -119,12 +166,23 @@ int wdt_start(struct udevice *dev, u64 timeout_ms, ulong flags)
 	ret = ops->start(dev, timeout_ms, flags);
 	if (ret == 0) {
 		struct wdt_priv *priv = dev_get_uclass_priv(dev);
-		char str[16];
+		char str[24];
 
 		priv->running = true;
 
-		memset(str, 0, 16);
-		if (IS_ENABLED(CONFIG_WATCHDOG)) {
+		memset(str, 0, sizeof(str));
+		if (IS_ENABLED(CONFIG_WATCHDOG_TIMER_IRQ) &&
+		    (ops->flags & WDT_RESET_IRQ_SAFE)) {
+			priv->irq = true;
+			if (wdt_irq_update()) {
+				priv->irq = false;
+				wdt_irq_update();
+			} else {
+				snprintf(str, sizeof(str), "every %ldms (irq)",
+					 priv->reset_period);
+			}
+		}
+		if (IS_ENABLED(CONFIG_WATCHDOG) && !priv->irq) {
 			/* Register the watchdog driver as a cyclic function */
 			priv->cyclic = cyclic_register(wdt_cyclic,
 						       priv->reset_period * 1000,
@@ -134,7 +192,7 @@ int wdt_start(struct udevice *dev, u64 timeout_ms, ulong flags)
 				       dev->name);
 				return -ENODEV;
 			} else {
-				snprintf(str, 16, "every %ldms",
+				snprintf(str, sizeof(str), "every %ldms",
 					 priv->reset_period);
 			}
 		}
@@ -160,6 +218,10 @@ int wdt_stop(struct udevice *dev)
 		struct wdt_priv *priv = dev_get_uclass_priv(dev);
 
 		priv->running = false;
+		if (IS_ENABLED(CONFIG_WATCHDOG_TIMER_IRQ) && priv->irq) {
+			priv->irq = false;
+			wdt_irq_update();
+		}
 	}
 
 	return ret;
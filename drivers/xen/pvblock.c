@@ -36,6 +36,15 @@
 #define O_RDWR		02
 #define WAIT_RING_TO_MS	10
 
+/* Most segments to put in an indirect request, which fit in one page */
+#define BLKFRONT_MAX_INDIRECT_SEGS	32
+
+/*
+ * Most data pages to share with the backend at once. There is only one page
+ * of grant entries, which is shared between all devices.
+ */
+#define BLKFRONT_MAX_GRANTS		128
+
 struct blkfront_info {
 	u64 sectors;
 	unsigned int sector_size;
@@ -43,6 +52,33 @@ struct blkfront_info {
 	int info;
 	int barrier;
 	int flush;
+	int persistent;
+	int max_indirect_segs;
+};
+
+/**
+ * struct blkfront_req - A request, with its own pages to transfer data
+ * @buf: Data pages, which the backend reads from or writes to
+ * @gref: Grant references for the pages in @buf
+ * @indirect: Page holding the list of segments for an indirect request, or
+ *	      NULL if indirect requests are not used
+ * @indirect_gref: Grant reference for @indirect
+ * @dest: Buffer to copy the data to when a read completes, or NULL
+ * @nbytes: Number of bytes to transfer
+ * @nsegs: Number of pages used in @buf
+ * @sector: First sector to transfer
+ * @busy: true while the request is with the backend
+ */
+struct blkfront_req {
+	u8 *buf;
+	grant_ref_t gref[BLKFRONT_MAX_INDIRECT_SEGS];
+	struct blkif_request_segment *indirect;
+	grant_ref_t indirect_gref;
+	void *dest;
+	size_t nbytes;
+	int nsegs;
+	u64 sector;
+	bool busy;
 };
 
 /**
@@ -57,6 +93,10 @@ struct blkfront_info {
  * @backend: Backend XenStore path
  * @info: Private data
  * @devid: Device id
+ * @reqs: Requests which can be with the backend at once
+ * @nr_reqs: Number of requests in @reqs
+ * @max_segs: Most pages in a request
+ * @errors: Number of requests which have failed
  */
 struct blkfront_dev {
 	domid_t dom;
@@ -70,41 +110,104 @@ struct blkfront_dev {
 	char *backend;
 	struct blkfront_info info;
 	unsigned int devid;
-	u8 *bounce_buffer;
+
+	struct blkfront_req *reqs;
+	int nr_reqs;
+	int max_segs;
+	int errors;
 };
 
 struct blkfront_plat {
 	unsigned int devid;
 };
 
-/**
- * struct blkfront_aiocb - AIO control block
- * @aio_dev: Blockfront device
- * @aio_buf: Memory buffer, which must be sector-aligned for
- *	     @aio_dev sector
- * @aio_nbytes: Size of AIO, which must be less than @aio_dev
- *		sector-sized amounts
- * @aio_offset: Offset, which must not go beyond @aio_dev
- *		sector-aligned location
- * @data: Data used to receiving response from ring
- * @gref: Array of grant references
- * @n: Number of segments
- * @aio_cb: Represents one I/O request.
+static void blkfront_sync(struct blkfront_dev *dev);
+
+static void free_blkfront_reqs(struct blkfront_dev *dev)
+{
+	struct blkfront_req *req;
+	int i, j;
+
+	for (i = 0; i < dev->nr_reqs; i++) {
+		req = &dev->reqs[i];
+		if (dev->info.persistent) {
+			for (j = 0; j < dev->max_segs; j++)
+				gnttab_end_access(req->gref[j]);
+			if (req->indirect)
+				gnttab_end_access(req->indirect_gref);
+		}
+		free(req->buf);
+		free(req->indirect);
+	}
+	free(dev->reqs);
+	dev->reqs = NULL;
+	dev->nr_reqs = 0;
+}
+
+/*
+ * Set up the requests. With persistent grants the backend keeps its pages
+ * mapped, so they are granted once here, with write access, as reads and
+ * writes share them.
  */
-struct blkfront_aiocb {
-	struct blkfront_dev *aio_dev;
-	u8 *aio_buf;
-	size_t aio_nbytes;
-	off_t aio_offset;
-	void *data;
+static int init_blkfront_reqs(struct blkfront_dev *dev)
+{
+	struct blkfront_req *req;
+	bool indirect;
+	int i, j;
+
+	indirect = dev->info.max_indirect_segs > BLKIF_MAX_SEGMENTS_PER_REQUEST;
+	if (indirect)
+		dev->max_segs = min(dev->info.max_indirect_segs,
+				    BLKFRONT_MAX_INDIRECT_SEGS);
+	else
+		dev->max_segs = BLKIF_MAX_SEGMENTS_PER_REQUEST;
+	dev->nr_reqs = min_t(int, RING_SIZE(&dev->ring),
+			     BLKFRONT_MAX_GRANTS / dev->max_segs);
+
+	dev->reqs = calloc(dev->nr_reqs, sizeof(*dev->reqs));
+	if (!dev->reqs) {
+		dev->nr_reqs = 0;
+		return -ENOMEM;
+	}
 
-	grant_ref_t gref[BLKIF_MAX_SEGMENTS_PER_REQUEST];
-	int n;
+	for (i = 0; i < dev->nr_reqs; i++) {
+		req = &dev->reqs[i];
+		req->buf = memalign(PAGE_SIZE, dev->max_segs * PAGE_SIZE);
+		if (!req->buf)
+			goto err;
+		if (indirect) {
+			req->indirect = memalign(PAGE_SIZE, PAGE_SIZE);
+			if (!req->indirect)
+				goto err;
+		}
+	}
 
-	void (*aio_cb)(struct blkfront_aiocb *aiocb, int ret);
-};
+	for (i = 0; dev->info.persistent && i < dev->nr_reqs; i++) {
+		req = &dev->reqs[i];
+		for (j = 0; j < dev->max_segs; j++)
+			req->gref[j] = gnttab_grant_access(dev->dom,
+				virt_to_pfn(req->buf + j * PAGE_SIZE), 0);
+		if (indirect)
+			req->indirect_gref = gnttab_grant_access(dev->dom,
+				virt_to_pfn(req->indirect), 0);
+	}
+	debug("%d requests of up to %d pages%s%s\n", dev->nr_reqs,
+	      dev->max_segs, indirect ? ", indirect" : "",
+	      dev->info.persistent ? ", persistent grants" : "");
 
-static void blkfront_sync(struct blkfront_dev *dev);
+	return 0;
+
+err:
+	for (i = 0; i < dev->nr_reqs; i++) {
+		free(dev->reqs[i].buf);
+		free(dev->reqs[i].indirect);
+	}
+	free(dev->reqs);
+	dev->reqs = NULL;
+	dev->nr_reqs = 0;
+
+	return -ENOMEM;
+}
 
 static void free_blkfront(struct blkfront_dev *dev)
 {
@@ -116,7 +219,7 @@ static void free_blkfront(struct blkfront_dev *dev)
 
 	unbind_evtchn(dev->evtchn);
 
-	free(dev->bounce_buffer);
+	free_blkfront_reqs(dev);
 	free(dev->nodename);
 	free(dev);
 }
@@ -177,6 +280,11 @@ again:
 		message = "writing protocol";
 		goto abort_transaction;
 	}
+	err = xenbus_printf(xbt, nodename, "feature-persistent", "%u", 1);
+	if (err) {
+		message = "writing feature-persistent";
+		goto abort_transaction;
+	}
 
 	snprintf(path, sizeof(path), "%s/state", nodename);
 	err = xenbus_switch_state(xbt, path, XenbusStateConnected);
@@ -214,7 +322,7 @@ done:
 	{
 		XenbusState state;
 		char path[strlen(dev->backend) +
-			strlen("/feature-flush-cache") + 1];
+			strlen("/feature-max-indirect-segments") + 1];
 
 		snprintf(path, sizeof(path), "%s/mode", dev->backend);
 		msg = xenbus_read(XBT_NIL, path, &c);
@@ -259,19 +367,24 @@ done:
 		snprintf(path, sizeof(path), "%s/feature-flush-cache",
 			 dev->backend);
 		dev->info.flush = xenbus_read_integer(path);
+
+		snprintf(path, sizeof(path), "%s/feature-persistent",
+			 dev->backend);
+		dev->info.persistent = xenbus_read_integer(path) == 1;
+
+		snprintf(path, sizeof(path), "%s/feature-max-indirect-segments",
+			 dev->backend);
+		dev->info.max_indirect_segs = xenbus_read_integer(path);
 	}
 	unmask_evtchn(dev->evtchn);
 
-	dev->bounce_buffer = memalign(dev->info.sector_size,
-				      dev->info.sector_size);
-	if (!dev->bounce_buffer) {
-		printf("Failed to allocate bouncing buffer\n");
+	if (init_blkfront_reqs(dev)) {
+		printf("Failed to allocate requests\n");
 		goto error;
 	}
 
-	debug("%llu sectors of %u bytes, bounce buffer at %p\n",
-	      dev->info.sectors, dev->info.sector_size,
-	      dev->bounce_buffer);
+	debug("%llu sectors of %u bytes\n", dev->info.sectors,
+	      dev->info.sector_size);
 
 	return 0;
 
@@ -355,7 +468,8 @@ close:
  * Here we receive response from the ring and check its status. This happens
  * until we read all data from the ring. We read the data from consumed pointer
  * to the response pointer. Then increase consumed pointer to make it clear that
- * the data has been read.
+ * the data has been read. When a read completes, its data is copied to the
+ * caller's buffer and the request is free to be used again.
  *
  * Return: Number of consumed bytes.
  */
@@ -373,32 +487,41 @@ moretodo:
 
 	nr_consumed = 0;
 	while ((cons != rp)) {
-		struct blkfront_aiocb *aiocbp;
+		struct blkfront_req *req;
 		int status;
 
 		rsp = RING_GET_RESPONSE(&dev->ring, cons);
 		nr_consumed++;
 
-		aiocbp = (void *)(uintptr_t)rsp->id;
 		status = rsp->status;
 
 		switch (rsp->operation) {
 		case BLKIF_OP_READ:
 		case BLKIF_OP_WRITE:
+		case BLKIF_OP_INDIRECT:
 		{
 			int j;
 
-			if (status != BLKIF_RSP_OKAY)
-				printf("%s error %d on %s at offset %llu, num bytes %llu\n",
-				       rsp->operation == BLKIF_OP_READ ?
-				       "read" : "write",
-				       status, aiocbp->aio_dev->nodename,
-				       (unsigned long long)aiocbp->aio_offset,
-				       (unsigned long long)aiocbp->aio_nbytes);
-
-			for (j = 0; j < aiocbp->n; j++)
-				gnttab_end_access(aiocbp->gref[j]);
-
+			/* The ID is the request's index plus one */
+			req = &dev->reqs[rsp->id - 1];
+			if (status != BLKIF_RSP_OKAY) {
+				printf("%s error %d on %s at sector %llu, num bytes %llu\n",
+				       req->dest ? "read" : "write",
+				       status, dev->nodename,
+				       (unsigned long long)req->sector,
+				       (unsigned long long)req->nbytes);
+				dev->errors++;
+			} else if (req->dest) {
+				memcpy(req->dest, req->buf, req->nbytes);
+			}
+
+			if (!dev->info.persistent) {
+				for (j = 0; j < req->nsegs; j++)
+					gnttab_end_access(req->gref[j]);
+				if (req->nsegs > BLKIF_MAX_SEGMENTS_PER_REQUEST)
+					gnttab_end_access(req->indirect_gref);
+			}
+			req->busy = false;
 			break;
 		}
 
@@ -418,12 +541,6 @@ moretodo:
 		}
 
 		dev->ring.rsp_cons = ++cons;
-		/* Nota: callback frees aiocbp itself */
-		if (aiocbp && aiocbp->aio_cb)
-			aiocbp->aio_cb(aiocbp, status ? -EIO : 0);
-		if (dev->ring.rsp_cons != cons)
-			/* We reentered, we must not continue here */
-			break;
 	}
 
 	RING_FINAL_CHECK_FOR_RESPONSES(&dev->ring, more);
@@ -448,74 +565,112 @@ static void blkfront_wait_slot(struct blkfront_dev *dev)
 }
 
 /**
- * blkfront_aio_poll() - Issue an aio.
- * @aiocbp: AIO control block structure
+ * blkfront_get_req() - Get a request which is not in use
+ * @dev: Blkfront device
+ *
+ * If all requests are with the backend, this waits for one to complete.
+ *
+ * Return: Free request
+ */
+static struct blkfront_req *blkfront_get_req(struct blkfront_dev *dev)
+{
+	int i;
+
+	while (true) {
+		for (i = 0; i < dev->nr_reqs; i++) {
+			if (!dev->reqs[i].busy)
+				return &dev->reqs[i];
+		}
+		blkfront_aio_poll(dev);
+		cpu_relax();
+	}
+}
+
+/**
+ * blkfront_wait_reqs() - Wait for all requests to complete
+ * @dev: Blkfront device
+ */
+static void blkfront_wait_reqs(struct blkfront_dev *dev)
+{
+	int i;
+
+	for (i = 0; i < dev->nr_reqs; i++) {
+		while (dev->reqs[i].busy) {
+			blkfront_aio_poll(dev);
+			cpu_relax();
+		}
+	}
+}
+
+/**
+ * blkfront_aio() - Issue an aio.
+ * @dev: Blkfront device
+ * @req: Request with @nbytes and @sector set up, and for a write, the data
+ *	 in @buf
  * @write: Describes is it read or write operation
  *	   0 - read
  *	   1 - write
  *
- * We check whether the AIO parameters meet the requirements of the device.
- * Then receive request from ring and define its arguments. After this we
- * grant access to the grant references. The last step is notifying about AIO
- * via event channel.
+ * We put the request on the ring, using an indirect request if it has too
+ * many pages to list in the ring itself. Without persistent grants, we grant
+ * the backend access to the pages here and end it once the request completes.
+ * The last step is notifying about AIO via event channel.
  */
-static void blkfront_aio(struct blkfront_aiocb *aiocbp, int write)
+static void blkfront_aio(struct blkfront_dev *dev, struct blkfront_req *req,
+			 int write)
 {
-	struct blkfront_dev *dev = aiocbp->aio_dev;
-	struct blkif_request *req;
+	struct blkif_request_segment *seg;
+	struct blkif_request *ring_req;
+	u8 op = write ? BLKIF_OP_WRITE : BLKIF_OP_READ;
+	int secs_per_page = PAGE_SIZE / dev->info.sector_size;
+	int readonly = write;
 	RING_IDX i;
 	int notify;
-	int n, j;
-	uintptr_t start, end;
+	int j;
 
-	/* Can't io at non-sector-aligned location */
-	BUG_ON(aiocbp->aio_offset & (dev->info.sector_size - 1));
-	/* Can't io non-sector-sized amounts */
-	BUG_ON(aiocbp->aio_nbytes & (dev->info.sector_size - 1));
-	/* Can't io non-sector-aligned buffer */
-	BUG_ON(((uintptr_t)aiocbp->aio_buf & (dev->info.sector_size - 1)));
-
-	start = (uintptr_t)aiocbp->aio_buf & PAGE_MASK;
-	end = ((uintptr_t)aiocbp->aio_buf + aiocbp->aio_nbytes +
-	       PAGE_SIZE - 1) & PAGE_MASK;
-	n = (end - start) / PAGE_SIZE;
-	aiocbp->n = n;
-
-	BUG_ON(n > BLKIF_MAX_SEGMENTS_PER_REQUEST);
+	req->nsegs = DIV_ROUND_UP(req->nbytes, PAGE_SIZE);
+	BUG_ON(req->nsegs > dev->max_segs);
 
 	blkfront_wait_slot(dev);
 	i = dev->ring.req_prod_pvt;
-	req = RING_GET_REQUEST(&dev->ring, i);
-
-	req->operation = write ? BLKIF_OP_WRITE : BLKIF_OP_READ;
-	req->nr_segments = n;
-	req->handle = dev->handle;
-	req->id = (uintptr_t)aiocbp;
-	req->sector_number = aiocbp->aio_offset / dev->info.sector_size;
+	ring_req = RING_GET_REQUEST(&dev->ring, i);
+
+	if (req->nsegs > BLKIF_MAX_SEGMENTS_PER_REQUEST) {
+		struct blkif_request_indirect *ind = (void *)ring_req;
+
+		ind->operation = BLKIF_OP_INDIRECT;
+		ind->indirect_op = op;
+		ind->nr_segments = req->nsegs;
+		ind->handle = dev->handle;
+		ind->id = req - dev->reqs + 1;
+		ind->sector_number = req->sector;
+		if (!dev->info.persistent)
+			req->indirect_gref = gnttab_grant_access(dev->dom,
+					virt_to_pfn(req->indirect), 1);
+		ind->indirect_grefs[0] = req->indirect_gref;
+		seg = req->indirect;
+	} else {
+		ring_req->operation = op;
+		ring_req->nr_segments = req->nsegs;
+		ring_req->handle = dev->handle;
+		ring_req->id = req - dev->reqs + 1;
+		ring_req->sector_number = req->sector;
+		seg = ring_req->seg;
+	}
 
-	for (j = 0; j < n; j++) {
-		req->seg[j].first_sect = 0;
-		req->seg[j].last_sect = PAGE_SIZE / dev->info.sector_size - 1;
+	for (j = 0; j < req->nsegs; j++) {
+		if (!dev->info.persistent)
+			req->gref[j] = gnttab_grant_access(dev->dom,
+				virt_to_pfn(req->buf + j * PAGE_SIZE),
+				readonly);
+		seg[j].gref = req->gref[j];
+		seg[j].first_sect = 0;
+		seg[j].last_sect = secs_per_page - 1;
 	}
-	req->seg[0].first_sect = ((uintptr_t)aiocbp->aio_buf & ~PAGE_MASK) /
+	seg[req->nsegs - 1].last_sect = ((req->nbytes - 1) & ~PAGE_MASK) /
 		dev->info.sector_size;
-	req->seg[n - 1].last_sect = (((uintptr_t)aiocbp->aio_buf +
-		aiocbp->aio_nbytes - 1) & ~PAGE_MASK) / dev->info.sector_size;
-	for (j = 0; j < n; j++) {
-		uintptr_t data = start + j * PAGE_SIZE;
-
-		if (!write) {
-			/* Trigger CoW if needed */
-			*(char *)(data + (req->seg[j].first_sect *
-					  dev->info.sector_size)) = 0;
-			barrier();
-		}
-		req->seg[j].gref = gnttab_grant_access(dev->dom,
-						       virt_to_pfn((void *)data),
-						       write);
-		aiocbp->gref[j] = req->seg[j].gref;
-	}
 
+	req->busy = true;
 	dev->ring.req_prod_pvt = i + 1;
 
 	wmb();
@@ -525,26 +680,6 @@ static void blkfront_aio(struct blkfront_aiocb *aiocbp, int write)
 		notify_remote_via_evtchn(dev->evtchn);
 }
 
-static void blkfront_aio_cb(struct blkfront_aiocb *aiocbp, int ret)
-{
-	aiocbp->data = (void *)1;
-	aiocbp->aio_cb = NULL;
-}
-
-static void blkfront_io(struct blkfront_aiocb *aiocbp, int write)
-{
-	aiocbp->aio_cb = blkfront_aio_cb;
-	blkfront_aio(aiocbp, write);
-	aiocbp->data = NULL;
-
-	while (true) {
-		blkfront_aio_poll(aiocbp->aio_dev);
-		if (aiocbp->data)
-			break;
-		cpu_relax();
-	}
-}
-
 static void blkfront_push_operation(struct blkfront_dev *dev, u8 op,
 				    uint64_t id)
 {
@@ -597,16 +732,17 @@ static void blkfront_sync(struct blkfront_dev *dev)
  *	   1 - write
  *
  * Depending on the operation - reading or writing, data is read / written from the
- * specified address (@buffer) to the sector (@blknr).
+ * specified address (@buffer) to the sector (@blknr). The transfer is split
+ * into requests which go to the backend without waiting for the previous ones
+ * to complete, so the backend has several to work on at once.
  */
 static ulong pvblock_iop(struct udevice *udev, lbaint_t blknr,
 			 lbaint_t blkcnt, void *buffer, int write)
 {
 	struct blkfront_dev *blk_dev = dev_get_priv(udev);
 	struct blk_desc *desc = dev_get_uclass_plat(udev);
-	struct blkfront_aiocb aiocb;
-	lbaint_t blocks_todo;
-	bool unaligned;
+	struct blkfront_req *req;
+	lbaint_t blocks_todo, max_blocks, count;
 
 	if (blkcnt == 0)
 		return 0;
@@ -617,34 +753,32 @@ static ulong pvblock_iop(struct udevice *udev, lbaint_t blknr,
 		return 0;
 	}
 
-	unaligned = (uintptr_t)buffer & (blk_dev->info.sector_size - 1);
-
-	aiocb.aio_dev = blk_dev;
-	aiocb.aio_offset = blknr * desc->blksz;
-	aiocb.aio_cb = NULL;
-	aiocb.data = NULL;
+	max_blocks = blk_dev->max_segs * PAGE_SIZE / desc->blksz;
+	blk_dev->errors = 0;
 	blocks_todo = blkcnt;
 	do {
-		aiocb.aio_buf = unaligned ? blk_dev->bounce_buffer : buffer;
-
-		if (write && unaligned)
-			memcpy(blk_dev->bounce_buffer, buffer, desc->blksz);
-
-		aiocb.aio_nbytes = unaligned ? desc->blksz :
-			min((size_t)((BLKIF_MAX_SEGMENTS_PER_REQUEST - 1)
-					* PAGE_SIZE),
-			    (size_t)(blocks_todo * desc->blksz));
-
-		blkfront_io(&aiocb, write);
+		count = min(blocks_todo, max_blocks);
+		req = blkfront_get_req(blk_dev);
+		req->nbytes = count * desc->blksz;
+		req->sector = blknr * desc->blksz / blk_dev->info.sector_size;
+		if (write) {
+			memcpy(req->buf, buffer, req->nbytes);
+			req->dest = NULL;
+		} else {
+			req->dest = buffer;
+		}
 
-		if (!write && unaligned)
-			memcpy(buffer, blk_dev->bounce_buffer, desc->blksz);
+		blkfront_aio(blk_dev, req, write);
 
-		aiocb.aio_offset += aiocb.aio_nbytes;
-		buffer += aiocb.aio_nbytes;
-		blocks_todo -= aiocb.aio_nbytes / desc->blksz;
+		blknr += count;
+		buffer += req->nbytes;
+		blocks_todo -= count;
 	} while (blocks_todo > 0);
 
+	blkfront_wait_reqs(blk_dev);
+	if (blk_dev->errors)
+		return 0;
+
 	return blkcnt;
 }
 
@@ -53,6 +53,218 @@ void env_inc_id(void)
 	env_id++;
 }
 
+#if CONFIG_IS_ENABLED(ENV_LAZY_IMPORT)
+/**
+ * struct env_lazy - Environment which is loaded but not fully imported
+ *
+ * Variables are looked up in place in @data until something needs the whole
+ * environment in env_htab, such as changing or listing variables. Only those
+ * variables with a callback are imported straight away, so that the callback
+ * sees the loaded value just as with a normal import.
+ *
+ * @data: Copy of the environment data (ENV_SIZE bytes). This is kept until
+ *	the environment is replaced, since env_get() may have handed out
+ *	pointers into it
+ * @index: Pointer to the start of each variable in @data, sorted by name
+ *	with duplicates removed, or NULL if the environment is fully imported
+ * @count: Number of entries in @index
+ */
+static struct env_lazy {
+	char *data;
+	char **index;
+	int count;
+} env_lazy;
+
+/*
+ * Compare the name of a variable with a string. The name in @var ends at the
+ * '=', or at a '\0' while env_finish_import() is importing the variable.
+ */
+static int env_lazy_cmp_name(const char *name, const char *var)
+{
+	for (; *name && *name == *var; name++, var++)
+		;
+	if (*var == '=')
+		return (unsigned char)*name;
+
+	return (unsigned char)*name - (unsigned char)*var;
+}
+
+/* Check if two variables have the same name */
+static bool env_lazy_same(const char *a, const char *b)
+{
+	for (; *a != '=' && *a == *b; a++, b++)
+		;
+
+	return *a == '=' && *b == '=';
+}
+
+/* Sort by name, and for the same name by position in the environment */
+static int env_lazy_cmp(const void *a, const void *b)
+{
+	const char *var_a = *(const char **)a;
+	const char *var_b = *(const char **)b;
+	const char *pa, *pb;
+
+	if (env_lazy_same(var_a, var_b))
+		return var_a < var_b ? -1 : var_a > var_b;
+
+	/* the '=' ends the name, so sorts before any other character */
+	for (pa = var_a, pb = var_b; *pa == *pb; pa++, pb++)
+		;
+
+	return (*pa == '=' ? 0 : (unsigned char)*pa) -
+		(*pb == '=' ? 0 : (unsigned char)*pb);
+}
+
+static void env_lazy_drop(void)
+{
+	free(env_lazy.index);
+	free(env_lazy.data);
+	memset(&env_lazy, '\0', sizeof(env_lazy));
+}
+
+/**
+ * env_lazy_load() - Index an environment without importing it
+ *
+ * @data: Environment data to use, ENV_SIZE bytes
+ * @flags: Flags to use when importing variables with a callback (H_...)
+ * Return: 0 if OK, -ENOMEM if out of memory
+ */
+static int env_lazy_load(const char *data, int flags)
+{
+	char *p, *end, *eq;
+	int count, i, upto;
+
+	env_lazy_drop();
+	if (env_htab.table)
+		hdestroy_r(&env_htab);
+
+	env_lazy.data = malloc(ENV_SIZE + 1);
+	if (!env_lazy.data)
+		return -ENOMEM;
+	memcpy(env_lazy.data, data, ENV_SIZE);
+	env_lazy.data[ENV_SIZE] = '\0';
+	end = env_lazy.data + ENV_SIZE;
+
+	/* count the variables, then record where each one starts */
+	for (count = 0, p = env_lazy.data; p < end && *p; p += strlen(p) + 1)
+		count++;
+	env_lazy.index = malloc(sizeof(char *) * (count + 1));
+	if (!env_lazy.index) {
+		env_lazy_drop();
+		return -ENOMEM;
+	}
+	for (count = 0, p = env_lazy.data; p < end && *p; p += strlen(p) + 1) {
+		/* skip leading white space, comments and deletions */
+		for (; isblank(*p); p++)
+			;
+		eq = strchr(p, '=');
+		if (*p == '#' || !eq || eq == p)
+			continue;
+		env_lazy.index[count++] = p;
+	}
+
+	/* keep only the last occurrence of each name, as himport_r() does */
+	qsort(env_lazy.index, count, sizeof(char *), env_lazy_cmp);
+	for (i = 0, upto = 0; i < count; i++) {
+		if (upto && env_lazy_same(env_lazy.index[upto - 1],
+					  env_lazy.index[i]))
+			upto--;
+		env_lazy.index[upto++] = env_lazy.index[i];
+	}
+	env_lazy.count = upto;
+
+	/* size the table for everything, so importing it later is cheap */
+	if (!hcreate_r(CONFIG_ENV_MIN_ENTRIES + upto * 4 / 3, &env_htab)) {
+		env_lazy_drop();
+		return -ENOMEM;
+	}
+	gd->flags |= GD_FLG_ENV_READY;
+
+	for (i = 0; i < env_lazy.count; i++) {
+		struct env_entry e, *ep;
+
+		p = env_lazy.index[i];
+		eq = strchr(p, '=');
+		*eq = '\0';
+		e.key = p;
+		e.data = eq + 1;
+		env_callback_init(&e);
+		if (e.callback)
+			hsearch_r(e, ENV_ENTER, &ep, &env_htab, flags);
+		*eq = '=';
+	}
+
+	return 0;
+}
+
+/* Look up a variable in the lazily loaded environment */
+static char *env_lazy_get(const char *name)
+{
+	int lo = 0, hi = env_lazy.count;
+
+	while (lo < hi) {
+		int mid = (lo + hi) / 2;
+		int cmp = env_lazy_cmp_name(name, env_lazy.index[mid]);
+
+		if (!cmp)
+			return env_lazy.index[mid] + strlen(name) + 1;
+		if (cmp < 0)
+			hi = mid;
+		else
+			lo = mid + 1;
+	}
+
+	return NULL;
+}
+
+int env_finish_import(void)
+{
+	int ret = 0;
+	int i;
+
+	if (!env_lazy.index)
+		return 0;
+
+	for (i = 0; i < env_lazy.count; i++) {
+		struct env_entry e, *ep;
+		char *eq;
+
+		e.key = env_lazy.index[i];
+		eq = strchr(e.key, '=');
+		*eq = '\0';
+		e.data = NULL;
+		hsearch_r(e, ENV_FIND, &ep, &env_htab, 0);
+		if (!ep) {
+			e.data = eq + 1;
+			hsearch_r(e, ENV_ENTER, &ep, &env_htab, H_EXTERNAL);
+			if (!ep) {
+				printf("## Error inserting \"%s\" variable, errno=%d\n",
+				       e.key, errno);
+				ret = -EIO;
+			}
+		}
+		*eq = '=';
+	}
+	free(env_lazy.index);
+	env_lazy.index = NULL;
+	env_lazy.count = 0;
+
+	return ret;
+}
+#else
+static inline void env_lazy_drop(void) {}
+static inline int env_lazy_load(const char *data, int flags)
+{
+	return -ENOSYS;
+}
+
+static inline char *env_lazy_get(const char *name)
+{
+	return NULL;
+}
+#endif
+
 int env_do_env_set(int flag, int argc, char *const argv[], int env_flag)
 {
 	int   i, len;
@@ -91,6 +303,9 @@ int env_do_env_set(int flag, int argc, char *const argv[], int env_flag)
 
 	env_inc_id();
 
+	if (env_finish_import())
+		return 1;
+
 	/* Delete only ? */
 	if (argc < 3 || argv[2] == NULL) {
 		int rc = hdelete_r(name, &env_htab, env_flag);
@@ -226,7 +441,7 @@ char *env_get(const char *name)
 		e.data	= NULL;
 		hsearch_r(e, ENV_FIND, &ep, &env_htab, 0);
 
-		return ep ? ep->data : NULL;
+		return ep ? ep->data : env_lazy_get(name);
 	}
 
 	/* restricted capabilities before import */
@@ -382,6 +597,7 @@ void env_set_default(const char *s, int flags)
 	}
 
 	flags |= H_DEFAULT;
+	env_lazy_drop();
 	if (himport_r(&env_htab, default_environment,
 			sizeof(default_environment), '\0', flags, 0,
 			0, NULL) == 0) {
@@ -403,6 +619,8 @@ int env_set_default_vars(int nvars, char * const vars[], int flags)
 	 * (and use \0 as a separator)
 	 */
 	flags |= H_NOCLEAR | H_DEFAULT;
+	if (env_finish_import())
+		return 0;
 	return himport_r(&env_htab, default_environment,
 				sizeof(default_environment), '\0',
 				flags, 0, nvars, vars);
@@ -427,8 +645,11 @@ int env_import(const char *buf, int check, int flags)
 		}
 	}
 
-	if (himport_r(&env_htab, (char *)ep->data, ENV_SIZE, '\0', flags, 0,
-			0, NULL)) {
+	if (CONFIG_IS_ENABLED(ENV_LAZY_IMPORT)) {
+		if (!env_lazy_load((char *)ep->data, flags))
+			return 0;
+	} else if (himport_r(&env_htab, (char *)ep->data, ENV_SIZE, '\0',
+			     flags, 0, 0, NULL)) {
 		gd->flags |= GD_FLG_ENV_READY;
 		return 0;
 	}
@@ -525,6 +746,9 @@ int env_export(env_t *env_out)
 	char *res;
 	ssize_t	len;
 
+	if (env_finish_import())
+		return 1;
+
 	res = (char *)env_out->data;
 	len = hexport_r(&env_htab, '\0', 0, &res, ENV_SIZE, 0, NULL);
 	if (len < 0) {
@@ -587,6 +811,7 @@ int env_complete(char *var, int maxv, char *cmdv[], int bufsz, char *buf,
 	idx = 0;
 	found = 0;
 	cmdv[0] = NULL;
+	env_finish_import();
 
 
 	while ((idx = hmatch_r(var, idx, &match, &env_htab))) {
@@ -64,46 +64,106 @@ static int setup_flash_device(struct spi_flash **env_flash)
 	return 0;
 }
 
-#if defined(CONFIG_ENV_OFFSET_REDUND)
-static int env_sf_save(void)
+/**
+ * env_sf_update() - Write data to flash, skipping anything which is unchanged
+ *
+ * Each erase block covered by the data is read and compared with the new
+ * contents. The block is left alone if it is the same, written without erasing
+ * if the new data only clears bits, or otherwise erased and rewritten. Any
+ * other data in the block is preserved.
+ *
+ * @flash: Flash to write to
+ * @offset: Offset to write at
+ * @data: Data to write
+ * @size: Size of data in bytes
+ * Return: 0 if OK, -ve on error
+ */
+static int env_sf_update(struct spi_flash *flash, u32 offset, const void *data,
+			 u32 size)
 {
-	env_t	env_new;
-	char	*saved_buffer = NULL, flag = ENV_REDUND_OBSOLETE;
-	u32	saved_size = 0, saved_offset = 0, sector;
-	u32	sect_size = CONFIG_ENV_SECT_SIZE;
-	int	ret;
-	struct spi_flash *env_flash;
-
-	ret = setup_flash_device(&env_flash);
-	if (ret)
-		return ret;
-
-	if (IS_ENABLED(CONFIG_ENV_SECT_SIZE_AUTO))
-		sect_size = env_flash->mtd.erasesize;
+	u32 esize = flash->mtd.erasesize;
+	u32 pos, start, skip, len, first, last, end;
+	const u8 *new = data;
+	bool erase;
+	u8 *buf, *old;
+	int ret = 0;
+	int i;
+
+	buf = memalign(ARCH_DMA_MINALIGN, esize);
+	if (!buf)
+		return -ENOMEM;
+
+	for (pos = 0; pos < size; pos += len, new += len) {
+		start = rounddown(offset + pos, esize);
+		skip = offset + pos - start;
+		len = min(esize - skip, size - pos);
+
+		ret = spi_flash_read(flash, start, esize, buf);
+		if (ret)
+			break;
+		old = buf + skip;
+		if (!memcmp(old, new, len))
+			continue;
+
+		/* erasing is only needed if a bit must go from 0 to 1 */
+		for (erase = false, i = 0; !erase && i < len; i++)
+			erase = (old[i] & new[i]) != new[i];
+
+		if (!erase) {
+			/* just write the bytes which differ */
+			for (first = 0; old[first] == new[first]; first++)
+				;
+			for (last = len; old[last - 1] == new[last - 1]; last--)
+				;
+			ret = spi_flash_write(flash, offset + pos + first,
+					      last - first, new + first);
+		} else {
+			memcpy(old, new, len);
+			ret = spi_flash_erase(flash, start, esize);
+			if (ret)
+				break;
+
+			/* there is no need to write the erased bytes at the end */
+			for (end = esize; end && buf[end - 1] == 0xff; end--)
+				;
+			if (end)
+				ret = spi_flash_write(flash, start, end, buf);
+		}
+		if (ret)
+			break;
+	}
+	free(buf);
 
-	ret = env_export(&env_new);
-	if (ret)
-		return -EIO;
-	env_new.flags	= ENV_REDUND_ACTIVE;
+	return ret;
+}
 
-	if (gd->env_valid == ENV_VALID) {
-		env_new_offset = CONFIG_ENV_OFFSET_REDUND;
-		env_offset = CONFIG_ENV_OFFSET;
-	} else {
-		env_new_offset = CONFIG_ENV_OFFSET;
-		env_offset = CONFIG_ENV_OFFSET_REDUND;
-	}
+/**
+ * env_sf_write() - Erase the environment sectors and write the environment
+ *
+ * If the sector is larger than the environment, the rest of it is read first
+ * and written back afterwards
+ *
+ * @flash: Flash to write to
+ * @offset: Offset of the environment
+ * @env: Environment to write
+ * @sect_size: Erase-sector size to use
+ * Return: 0 if OK, -ve on error
+ */
+static int env_sf_write(struct spi_flash *flash, u32 offset, env_t *env,
+			u32 sect_size)
+{
+	u32	saved_size = 0, saved_offset = 0, sector;
+	char	*saved_buffer = NULL;
+	int	ret;
 
 	/* Is the sector larger than the env (i.e. embedded) */
 	if (sect_size > CONFIG_ENV_SIZE) {
 		saved_size = sect_size - CONFIG_ENV_SIZE;
-		saved_offset = env_new_offset + CONFIG_ENV_SIZE;
+		saved_offset = offset + CONFIG_ENV_SIZE;
 		saved_buffer = memalign(ARCH_DMA_MINALIGN, saved_size);
-		if (!saved_buffer) {
-			ret = -ENOMEM;
-			goto done;
-		}
-		ret = spi_flash_read(env_flash, saved_offset,
+		if (!saved_buffer)
+			return -ENOMEM;
+		ret = spi_flash_read(flash, saved_offset,
 					saved_size, saved_buffer);
 		if (ret)
 			goto done;
@@ -112,25 +172,83 @@ static int env_sf_save(void)
 	sector = DIV_ROUND_UP(CONFIG_ENV_SIZE, sect_size);
 
 	puts("Erasing SPI flash...");
-	ret = spi_flash_erase(env_flash, env_new_offset,
-				sector * sect_size);
+	ret = spi_flash_erase(flash, offset, sector * sect_size);
 	if (ret)
 		goto done;
 
 	puts("Writing to SPI flash...");
 
-	ret = spi_flash_write(env_flash, env_new_offset,
-		CONFIG_ENV_SIZE, &env_new);
+	ret = spi_flash_write(flash, offset, CONFIG_ENV_SIZE, env);
 	if (ret)
 		goto done;
 
 	if (sect_size > CONFIG_ENV_SIZE) {
-		ret = spi_flash_write(env_flash, saved_offset,
+		ret = spi_flash_write(flash, saved_offset,
 					saved_size, saved_buffer);
 		if (ret)
 			goto done;
 	}
 
+done:
+	free(saved_buffer);
+
+	return ret;
+}
+
+/**
+ * env_sf_store() - Store the environment at a given offset
+ *
+ * @flash: Flash to write to
+ * @offset: Offset of the environment
+ * @env: Environment to write
+ * Return: 0 if OK, -ve on error
+ */
+static int env_sf_store(struct spi_flash *flash, u32 offset, env_t *env)
+{
+	u32	sect_size = CONFIG_ENV_SECT_SIZE;
+
+	if (IS_ENABLED(CONFIG_ENV_SPI_UPDATE_CHANGED)) {
+		puts("Writing to SPI flash...");
+		return env_sf_update(flash, offset, env, CONFIG_ENV_SIZE);
+	}
+
+	if (IS_ENABLED(CONFIG_ENV_SECT_SIZE_AUTO))
+		sect_size = flash->mtd.erasesize;
+
+	return env_sf_write(flash, offset, env, sect_size);
+}
+
+#if defined(CONFIG_ENV_OFFSET_REDUND)
+static int env_sf_save(void)
+{
+	env_t	env_new;
+	char	flag = ENV_REDUND_OBSOLETE;
+	int	ret;
+	struct spi_flash *env_flash;
+
+	ret = setup_flash_device(&env_flash);
+	if (ret)
+		return ret;
+
+	ret = env_export(&env_new);
+	if (ret) {
+		ret = -EIO;
+		goto done;
+	}
+	env_new.flags	= ENV_REDUND_ACTIVE;
+
+	if (gd->env_valid == ENV_VALID) {
+		env_new_offset = CONFIG_ENV_OFFSET_REDUND;
+		env_offset = CONFIG_ENV_OFFSET;
+	} else {
+		env_new_offset = CONFIG_ENV_OFFSET;
+		env_offset = CONFIG_ENV_OFFSET_REDUND;
+	}
+
+	ret = env_sf_store(env_flash, env_new_offset, &env_new);
+	if (ret)
+		goto done;
+
 	ret = spi_flash_write(env_flash, env_offset + offsetof(env_t, flags),
 				sizeof(env_new.flags), &flag);
 	if (ret)
@@ -145,9 +263,6 @@ static int env_sf_save(void)
 done:
 	spi_flash_free(env_flash);
 
-	if (saved_buffer)
-		free(saved_buffer);
-
 	return ret;
 }
 
@@ -190,10 +305,7 @@ out:
 #else
 static int env_sf_save(void)
 {
-	u32	saved_size = 0, saved_offset = 0, sector;
-	u32	sect_size = CONFIG_ENV_SECT_SIZE;
-	char	*saved_buffer = NULL;
-	int	ret = 1;
+	int	ret;
 	env_t	env_new;
 	struct spi_flash *env_flash;
 
@@ -201,59 +313,19 @@ static int env_sf_save(void)
 	if (ret)
 		return ret;
 
-	if (IS_ENABLED(CONFIG_ENV_SECT_SIZE_AUTO))
-		sect_size = env_flash->mtd.erasesize;
-
-	/* Is the sector larger than the env (i.e. embedded) */
-	if (sect_size > CONFIG_ENV_SIZE) {
-		saved_size = sect_size - CONFIG_ENV_SIZE;
-		saved_offset = CONFIG_ENV_OFFSET + CONFIG_ENV_SIZE;
-		saved_buffer = malloc(saved_size);
-		if (!saved_buffer) {
-			ret = -ENOMEM;
-			goto done;
-		}
-
-		ret = spi_flash_read(env_flash, saved_offset,
-			saved_size, saved_buffer);
-		if (ret)
-			goto done;
-	}
-
 	ret = env_export(&env_new);
 	if (ret)
 		goto done;
 
-	sector = DIV_ROUND_UP(CONFIG_ENV_SIZE, sect_size);
-
-	puts("Erasing SPI flash...");
-	ret = spi_flash_erase(env_flash, CONFIG_ENV_OFFSET,
-		sector * sect_size);
-	if (ret)
-		goto done;
-
-	puts("Writing to SPI flash...");
-	ret = spi_flash_write(env_flash, CONFIG_ENV_OFFSET,
-		CONFIG_ENV_SIZE, &env_new);
+	ret = env_sf_store(env_flash, CONFIG_ENV_OFFSET, &env_new);
 	if (ret)
 		goto done;
 
-	if (sect_size > CONFIG_ENV_SIZE) {
-		ret = spi_flash_write(env_flash, saved_offset,
-			saved_size, saved_buffer);
-		if (ret)
-			goto done;
-	}
-
-	ret = 0;
 	puts("done\n");
 
 done:
 	spi_flash_free(env_flash);
 
-	if (saved_buffer)
-		free(saved_buffer);
-
 	return ret;
 }
 
@@ -659,6 +659,8 @@ int btrfs_prev_leaf(struct btrfs_root *root, struct btrfs_path *path)
  * More generic version of btrfs_next_leaf(), as it could find sibling nodes
  * if @path->lowest_level is not 0.
  *
+ * Leaves are read ahead, since the caller is most likely walking along them.
+ *
  * returns 0 if it found something or 1 if there are no greater leaves.
  * returns < 0 on io errors.
  */
@@ -684,6 +686,8 @@ int btrfs_next_sibling_tree_block(struct btrfs_fs_info *fs_info,
 			continue;
 		}
 
+		if (level == 1)
+			readahead_tree_blocks(fs_info, c, slot);
 		next = read_node_slot(fs_info, c, slot);
 		if (!extent_buffer_uptodate(next))
 			return -EIO;
@@ -698,6 +702,8 @@ int btrfs_next_sibling_tree_block(struct btrfs_fs_info *fs_info,
 		path->slots[level] = 0;
 		if (level == path->lowest_level)
 			break;
+		if (level == 1)
+			readahead_tree_blocks(fs_info, next, 0);
 		next = read_node_slot(fs_info, next, 0);
 		if (!extent_buffer_uptodate(next))
 			return -EIO;
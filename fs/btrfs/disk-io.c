@@ -533,7 +533,7 @@ struct extent_buffer* read_tree_block(struct btrfs_fs_info *fs_info, u64 bytenr,
 	 * We failed to read this tree block, it be should deleted right now
 	 * to avoid stale cache populate the cache.
 	 */
-	free_extent_buffer(eb);
+	free_extent_buffer_nocache(eb);
 	return ERR_PTR(ret);
 }
 
@@ -578,6 +578,71 @@ err:
 	return ret;
 }
 
+/*
+ * Read the children of @node from @slot onwards that are laid out back to
+ * back on disk with a single request, to save a round trip per tree block
+ * when walking along a tree. Only blocks which pass the same checks as in
+ * read_tree_block() are marked up to date, anything else is left for
+ * read_tree_block() to read again from the right mirror.
+ */
+void readahead_tree_blocks(struct btrfs_fs_info *fs_info,
+			   struct extent_buffer *node, int slot)
+{
+	u32 nodesize = fs_info->nodesize;
+	int nritems = btrfs_header_nritems(node);
+	struct extent_buffer *eb;
+	u64 bytenr, len;
+	int max, nr, i;
+	char *buf;
+
+	/* Don't read ahead more than the cache can usefully hold */
+	max = min_t(u64, BTRFS_READAHEAD_BLOCKS,
+		    fs_info->extent_cache.max_cache_size / 2 / nodesize);
+	bytenr = btrfs_node_blockptr(node, slot);
+	for (nr = 0; nr < max && slot + nr < nritems; nr++) {
+		u64 cur = btrfs_node_blockptr(node, slot + nr);
+
+		if (cur != bytenr + (u64)nr * nodesize)
+			break;
+		eb = btrfs_find_tree_block(fs_info, cur, nodesize);
+		if (eb) {
+			free_extent_buffer(eb);
+			break;
+		}
+	}
+	if (nr < 2)
+		return;
+
+	len = (u64)nr * nodesize;
+	buf = malloc(len);
+	if (!buf)
+		return;
+	if (read_extent_data(fs_info, buf, bytenr, &len, 1))
+		goto out;
+
+	for (i = 0; i < nr; i++) {
+		eb = btrfs_find_create_tree_block(fs_info,
+						  bytenr + (u64)i * nodesize);
+		if (!eb)
+			break;
+		if (!extent_buffer_uptodate(eb)) {
+			write_extent_buffer(eb, buf + i * nodesize, 0,
+					    nodesize);
+			if (csum_tree_block(fs_info, eb, 1) == 0 &&
+			    check_tree_block(fs_info, eb) == 0 &&
+			    btrfs_header_generation(eb) ==
+			    btrfs_node_ptr_generation(node, slot + i) &&
+			    (btrfs_header_level(eb) ?
+			     btrfs_check_node(fs_info, NULL, eb) :
+			     btrfs_check_leaf(fs_info, NULL, eb)) == 0)
+				btrfs_set_buffer_uptodate(eb);
+		}
+		free_extent_buffer(eb);
+	}
+out:
+	free(buf);
+}
+
 void btrfs_setup_root(struct btrfs_root *root, struct btrfs_fs_info *fs_info,
 		      u64 objectid)
 {
@@ -7,6 +7,7 @@
 
 #include <linux/kernel.h>
 #include <linux/bug.h>
+#include <linux/sizes.h>
 #include <malloc.h>
 #include <memalign.h>
 #include "btrfs.h"
@@ -18,7 +19,9 @@ void extent_io_tree_init(struct extent_io_tree *tree)
 {
 	cache_tree_init(&tree->state);
 	cache_tree_init(&tree->cache);
+	INIT_LIST_HEAD(&tree->lru);
 	tree->cache_size = 0;
+	tree->max_cache_size = (u64)CONFIG_FS_BTRFS_EXTENT_BUFFER_CACHE * SZ_1K;
 }
 
 static struct extent_state *alloc_extent_state(void)
@@ -54,6 +57,17 @@ static void free_extent_state_func(struct cache_extent *cache)
 static void free_extent_buffer_final(struct extent_buffer *eb);
 void extent_io_tree_cleanup(struct extent_io_tree *tree)
 {
+	struct extent_buffer *eb;
+
+	while (!list_empty(&tree->lru)) {
+		eb = list_first_entry(&tree->lru, struct extent_buffer, lru);
+		if (eb->refs) {
+			debug("extent buffer leak: start %llu len %u\n",
+			      eb->start, eb->len);
+			eb->refs = 0;
+		}
+		free_extent_buffer_final(eb);
+	}
 	cache_tree_free_extents(&tree->state, free_extent_state_func);
 }
 
@@ -582,6 +596,7 @@ static struct extent_buffer *__alloc_extent_buffer(struct btrfs_fs_info *info,
 	eb->cache_node.start = bytenr;
 	eb->cache_node.size = blocksize;
 	eb->fs_info = info;
+	INIT_LIST_HEAD(&eb->lru);
 	memset_extent_buffer(eb, 0, 0, blocksize);
 
 	return eb;
@@ -608,6 +623,7 @@ static void free_extent_buffer_final(struct extent_buffer *eb)
 		struct extent_io_tree *tree = &eb->fs_info->extent_cache;
 
 		remove_cache_extent(&tree->cache, &eb->cache_node);
+		list_del(&eb->lru);
 		BUG_ON(tree->cache_size < eb->len);
 		tree->cache_size -= eb->len;
 	}
@@ -628,16 +644,43 @@ static void free_extent_buffer_internal(struct extent_buffer *eb, bool free_now)
 			"dirty eb leak (aborted trans): start %llu len %u",
 				eb->start, eb->len);
 		}
-		if (eb->flags & EXTENT_BUFFER_DUMMY || free_now)
+		if (eb->flags & EXTENT_BUFFER_DUMMY || free_now ||
+		    !eb->fs_info->extent_cache.max_cache_size)
 			free_extent_buffer_final(eb);
 	}
 }
 
+/*
+ * Drop a reference to @eb. Unreferenced buffers stay in the cache until
+ * trim_extent_buffer_cache() needs the space.
+ */
 void free_extent_buffer(struct extent_buffer *eb)
+{
+	free_extent_buffer_internal(eb, 0);
+}
+
+/* Drop a reference to @eb, and free it now if this was the last one */
+void free_extent_buffer_nocache(struct extent_buffer *eb)
 {
 	free_extent_buffer_internal(eb, 1);
 }
 
+/*
+ * Free the least recently used unreferenced buffers until the cache is back
+ * below 90% of its maximum size
+ */
+static void trim_extent_buffer_cache(struct extent_io_tree *tree)
+{
+	struct extent_buffer *eb, *tmp;
+
+	list_for_each_entry_safe(eb, tmp, &tree->lru, lru) {
+		if (eb->refs == 0)
+			free_extent_buffer_final(eb);
+		if (tree->cache_size <= tree->max_cache_size / 10 * 9)
+			break;
+	}
+}
+
 struct extent_buffer *find_extent_buffer(struct extent_io_tree *tree,
 					 u64 bytenr, u32 blocksize)
 {
@@ -648,6 +691,7 @@ struct extent_buffer *find_extent_buffer(struct extent_io_tree *tree,
 	if (cache && cache->start == bytenr &&
 	    cache->size == blocksize) {
 		eb = container_of(cache, struct extent_buffer, cache_node);
+		list_move_tail(&eb->lru, &tree->lru);
 		eb->refs++;
 	}
 	return eb;
@@ -678,6 +722,7 @@ struct extent_buffer *alloc_extent_buffer(struct btrfs_fs_info *fs_info,
 	if (cache && cache->start == bytenr &&
 	    cache->size == blocksize) {
 		eb = container_of(cache, struct extent_buffer, cache_node);
+		list_move_tail(&eb->lru, &tree->lru);
 		eb->refs++;
 	} else {
 		int ret;
@@ -685,17 +730,24 @@ struct extent_buffer *alloc_extent_buffer(struct btrfs_fs_info *fs_info,
 		if (cache) {
 			eb = container_of(cache, struct extent_buffer,
 					  cache_node);
-			free_extent_buffer(eb);
+			if (eb->refs)
+				free_extent_buffer_nocache(eb);
+			else
+				free_extent_buffer_final(eb);
 		}
 		eb = __alloc_extent_buffer(fs_info, bytenr, blocksize);
 		if (!eb)
 			return NULL;
 		ret = insert_cache_extent(&tree->cache, &eb->cache_node);
 		if (ret) {
+			free(eb->data);
 			free(eb);
 			return NULL;
 		}
+		list_add_tail(&eb->lru, &tree->lru);
 		tree->cache_size += blocksize;
+		if (tree->cache_size >= tree->max_cache_size)
+			trim_extent_buffer_cache(tree);
 	}
 	return eb;
 }
@@ -6,9 +6,7 @@
  * Modification includes:
  * - extent_buffer:data
  *   Use pointer to provide better alignment.
- * - Remove max_cache_size related interfaces
- *   Includes free_extent_buffer_nocache()
- *   As we don't cache eb in U-Boot.
+ * - Cache size is set by CONFIG_FS_BTRFS_EXTENT_BUFFER_CACHE
  * - Include headers
  *
  * Write related functions are kept as we still need to modify dummy extent
@@ -66,7 +64,9 @@ struct btrfs_fs_info;
 struct extent_io_tree {
 	struct cache_tree state;
 	struct cache_tree cache;
+	struct list_head lru;
 	u64 cache_size;
+	u64 max_cache_size;
 };
 
 struct extent_state {
@@ -80,6 +80,7 @@ struct extent_state {
 
 struct extent_buffer {
 	struct cache_extent cache_node;
+	struct list_head lru;
 	u64 start;
 	u32 len;
 	int refs;
@@ -136,6 +137,7 @@ struct extent_buffer *btrfs_clone_extent_buffer(struct extent_buffer *src);
 struct extent_buffer *alloc_dummy_extent_buffer(struct btrfs_fs_info *fs_info,
 						u64 bytenr, u32 blocksize);
 void free_extent_buffer(struct extent_buffer *eb);
+void free_extent_buffer_nocache(struct extent_buffer *eb);
 int read_extent_from_disk(struct blk_desc *desc, struct disk_partition *part,
 			  u64 physical, struct extent_buffer *eb,
 			  unsigned long offset, unsigned long len);
@@ -429,6 +429,7 @@ int btrfs_read_extent_reg(struct btrfs_path *path,
 	u64 read;
 	char *cbuf = NULL;
 	char *dbuf = NULL;
+	char *buf;
 	u32 csize;
 	u32 dsize;
 	bool finished = false;
@@ -478,8 +479,15 @@ int btrfs_read_extent_reg(struct btrfs_path *path,
 	num_copies = btrfs_num_copies(fs_info, disk_bytenr, csize);
 
 	cbuf = malloc_cache_aligned(csize);
-	dbuf = malloc_cache_aligned(dsize);
-	if (!cbuf || !dbuf) {
+	/* Decompress straight into @dest if the whole extent is wanted */
+	if (len == dsize && offset == key.offset &&
+	    !btrfs_file_extent_offset(leaf, fi)) {
+		buf = dest;
+	} else {
+		dbuf = malloc_cache_aligned(dsize);
+		buf = dbuf;
+	}
+	if (!cbuf || !buf) {
 		ret = -ENOMEM;
 		goto out;
 	}
@@ -499,7 +507,7 @@ int btrfs_read_extent_reg(struct btrfs_path *path,
 	}
 
 	ret = btrfs_decompress(btrfs_file_extent_compression(leaf, fi), cbuf,
-			       csize, dbuf, dsize);
+			       csize, buf, dsize);
 	if (ret < 0) {
 		ret = -EIO;
 		goto out;
@@ -509,11 +517,11 @@ int btrfs_read_extent_reg(struct btrfs_path *path,
 	 * to be zeroed out.
 	 */
 	if (ret < dsize)
-		memset(dbuf + ret, 0, dsize - ret);
+		memset(buf + ret, 0, dsize - ret);
 	/* Then copy the needed part */
-	memcpy(dest,
-	       dbuf + btrfs_file_extent_offset(leaf, fi) + offset - key.offset,
-	       len);
+	if (buf != dest)
+		memcpy(dest, buf + btrfs_file_extent_offset(leaf, fi) +
+		       offset - key.offset, len);
 	ret = len;
 out:
 	free(cbuf);
@@ -619,6 +627,65 @@ check_next:
 	return 1;
 }
 
+/*
+ * Read the uncompressed regular extent at @path from @cur, together with the
+ * following extents in the same leaf which carry on where it ends both in the
+ * file and on disk, using a single read. Reading stops at @end.
+ *
+ * Return 0 and set @len_ret to the number of bytes read.
+ * Return <0 for error.
+ */
+static int read_contig_extents(struct btrfs_path *path, u64 ino, u64 cur,
+			       u64 end, char *dest, u64 *len_ret)
+{
+	struct extent_buffer *leaf = path->nodes[0];
+	struct btrfs_fs_info *fs_info = leaf->fs_info;
+	struct btrfs_file_extent_item *fi;
+	struct btrfs_key key;
+	int slot = path->slots[0];
+	u64 logical;
+	u64 next;
+	u64 len;
+	u64 read;
+	int num_copies;
+	int ret = -EIO;
+	int i;
+
+	btrfs_item_key_to_cpu(leaf, &key, slot);
+	fi = btrfs_item_ptr(leaf, slot, struct btrfs_file_extent_item);
+	logical = btrfs_file_extent_disk_bytenr(leaf, fi) +
+		  btrfs_file_extent_offset(leaf, fi) + cur - key.offset;
+	next = key.offset + btrfs_file_extent_num_bytes(leaf, fi);
+
+	while (next < end && ++slot < btrfs_header_nritems(leaf)) {
+		btrfs_item_key_to_cpu(leaf, &key, slot);
+		if (key.objectid != ino || key.type != BTRFS_EXTENT_DATA_KEY ||
+		    key.offset != next)
+			break;
+		fi = btrfs_item_ptr(leaf, slot, struct btrfs_file_extent_item);
+		if (btrfs_file_extent_type(leaf, fi) != BTRFS_FILE_EXTENT_REG ||
+		    btrfs_file_extent_compression(leaf, fi) !=
+		    BTRFS_COMPRESS_NONE ||
+		    !btrfs_file_extent_disk_bytenr(leaf, fi) ||
+		    btrfs_file_extent_disk_bytenr(leaf, fi) +
+		    btrfs_file_extent_offset(leaf, fi) != logical + next - cur)
+			break;
+		next += btrfs_file_extent_num_bytes(leaf, fi);
+	}
+	len = min(next, end) - cur;
+
+	num_copies = btrfs_num_copies(fs_info, logical, len);
+	for (i = 1; i <= num_copies; i++) {
+		read = len;
+		ret = read_extent_data(fs_info, dest, logical, &read, i);
+		if (ret < 0 || read != len)
+			continue;
+		*len_ret = len;
+		return 0;
+	}
+	return -EIO;
+}
+
 static int read_and_truncate_page(struct btrfs_path *path,
 				  struct btrfs_file_extent_item *fi,
 				  int start, int len, char *dest)
@@ -703,7 +770,8 @@ int btrfs_file_read(struct btrfs_root *root, u64 ino, u64 file_offset, u64 len,
 
 	/* Read the aligned part */
 	while (cur < aligned_end) {
-		u64 extent_num_bytes;
+		u64 extent_end;
+		u64 read;
 		u8 type;
 
 		btrfs_release_path(&path);
@@ -741,15 +809,28 @@ int btrfs_file_read(struct btrfs_root *root, u64 ino, u64 file_offset, u64 len,
 			continue;
 		}
 
-		/* Read the remaining part of the extent */
-		extent_num_bytes = btrfs_file_extent_num_bytes(path.nodes[0],
-							       fi);
-		ret = btrfs_read_extent_reg(&path, fi, cur,
-				min(extent_num_bytes, aligned_end - cur),
-				dest + cur - file_offset);
+		/*
+		 * Read the remaining part of the extent, and of any adjacent
+		 * extents if it is not compressed
+		 */
+		if (btrfs_file_extent_compression(path.nodes[0], fi) ==
+		    BTRFS_COMPRESS_NONE) {
+			ret = read_contig_extents(&path, ino, cur, aligned_end,
+						  dest + cur - file_offset,
+						  &read);
+			if (ret < 0)
+				goto out;
+			cur += read;
+			continue;
+		}
+		extent_end = key.offset +
+			     btrfs_file_extent_num_bytes(path.nodes[0], fi);
+		read = min(extent_end, aligned_end) - cur;
+		ret = btrfs_read_extent_reg(&path, fi, cur, read,
+					    dest + cur - file_offset);
 		if (ret < 0)
 			goto out;
-		cur += min(extent_num_bytes, aligned_end - cur);
+		cur += read;
 	}
 
 	/* Read the tailing unaligned part*/
@@ -7,6 +7,7 @@
 #include <log.h>
 #include <malloc.h>
 #include <linux/errno.h>
+#include <linux/log2.h>
 #include <asm/byteorder.h>
 
 /* Offset of master header from the start of a coreboot ROM */
@@ -22,6 +23,9 @@ static const u8 good_file_magic[] = "LARCHIVE";
  * @start: Start position of CBFS in memory, typically memory-mapped SPI flash
  * @header: Header read from the CBFS, byte-swapped so U-Boot can access it
  * @file_cache: List of file headers read from CBFS
+ * @index: Hash table of the files in @file_cache, indexed by name, or NULL if
+ *	there is none. Each entry is a list linked by the hash_next member
+ * @index_mask: Number of entries in @index minus one (a power of two minus one)
  * @result: Success/error result
  */
 struct cbfs_priv {
@@ -29,6 +33,8 @@ struct cbfs_priv {
 	void *start;
 	struct cbfs_header header;
 	struct cbfs_cachenode *file_cache;
+	struct cbfs_cachenode **index;
+	uint index_mask;
 	enum cbfs_result result;
 };
 
@@ -98,6 +104,7 @@ static int fill_node(struct cbfs_cachenode *node, void *start,
 		return -EBADF;
 
 	node->next = NULL;
+	node->hash_next = NULL;
 	node->type = header->type;
 	node->data = start + header->offset;
 	node->data_length = header->len;
@@ -182,6 +189,49 @@ static int file_cbfs_next_file(struct cbfs_priv *priv, void *start, int size,
 	return -ENOENT;
 }
 
+static uint cbfs_hash(const char *name)
+{
+	uint hash = 5381;
+
+	while (*name)
+		hash = hash * 33 + *name++;
+
+	return hash;
+}
+
+/**
+ * cbfs_build_index() - Build a hash table of the files in the cache
+ *
+ * If there is not enough memory, no index is built and lookups fall back to
+ * searching the list of files
+ *
+ * @priv: Private data, with @file_cache set up
+ */
+static void cbfs_build_index(struct cbfs_priv *priv)
+{
+	struct cbfs_cachenode *node, **tailp;
+	uint count = 0;
+
+	for (node = priv->file_cache; node; node = node->next)
+		count++;
+	if (!count)
+		return;
+
+	count = __roundup_pow_of_two(count);
+	priv->index = calloc(count, sizeof(*priv->index));
+	if (!priv->index)
+		return;
+	priv->index_mask = count - 1;
+
+	/* add to the end of each chain, so the first file of a name wins */
+	for (node = priv->file_cache; node; node = node->next) {
+		tailp = &priv->index[cbfs_hash(node->name) & priv->index_mask];
+		while (*tailp)
+			tailp = &(*tailp)->hash_next;
+		*tailp = node;
+	}
+}
+
 /* Look through a CBFS instance and copy file metadata into regular memory. */
 static int file_cbfs_fill_cache(struct cbfs_priv *priv, int size, int align)
 {
@@ -198,6 +248,8 @@ static int file_cbfs_fill_cache(struct cbfs_priv *priv, int size, int align)
 		free(old_node);
 	}
 	priv->file_cache = NULL;
+	free(priv->index);
+	priv->index = NULL;
 
 	start = priv->start;
 	while (size >= align) {
@@ -222,6 +274,7 @@ static int file_cbfs_fill_cache(struct cbfs_priv *priv, int size, int align)
 		size -= used;
 		start += used;
 	}
+	cbfs_build_index(priv);
 	priv->result = CBFS_SUCCESS;
 
 	return 0;
@@ -413,10 +466,16 @@ const struct cbfs_cachenode *cbfs_find_file(struct cbfs_priv *priv,
 		return NULL;
 	}
 
-	while (cache_node) {
-		if (!strcmp(name, cache_node->name))
-			break;
-		cache_node = cache_node->next;
+	if (priv->index) {
+		cache_node = priv->index[cbfs_hash(name) & priv->index_mask];
+		while (cache_node && strcmp(name, cache_node->name))
+			cache_node = cache_node->hash_next;
+	} else {
+		while (cache_node) {
+			if (!strcmp(name, cache_node->name))
+				break;
+			cache_node = cache_node->next;
+		}
 	}
 	if (!cache_node)
 		priv->result = CBFS_FILE_NOT_FOUND;
@@ -1,4 +1,5 @@
 // SPDX-License-Identifier: GPL-2.0+
+#include <linux/sizes.h>
 #include "internal.h"
 #include "decompress.h"
 
@@ -271,6 +272,137 @@ int z_erofs_read_one_data(struct erofs_inode *inode,
 	return 0;
 }
 
+#ifdef CONFIG_FS_EROFS_ZIP_CACHE
+#define Z_EROFS_CACHE_ENTRIES	CONFIG_FS_EROFS_ZIP_CACHE
+#else
+#define Z_EROFS_CACHE_ENTRIES	0
+#endif
+
+/* extents decompressing to more than this are never cached */
+#define Z_EROFS_CACHE_MAX_LEN	SZ_1M
+
+/*
+ * Extents which are only partly read are decompressed in full and kept here,
+ * so that reading a file in pieces, e.g. a directory block at a time,
+ * decompresses each pcluster once rather than once per piece.
+ */
+static struct z_erofs_cache_entry {
+	erofs_off_t pa;
+	unsigned int interlaced_offset;
+	char alg;
+	unsigned int len;
+	unsigned int bufsize;
+	unsigned long last_used;
+	char *data;
+} z_erofs_cache[Z_EROFS_CACHE_ENTRIES];
+
+static unsigned long z_erofs_cache_counter;
+
+void z_erofs_cache_flush(void)
+{
+	int i;
+
+	for (i = 0; i < Z_EROFS_CACHE_ENTRIES; i++) {
+		free(z_erofs_cache[i].data);
+		z_erofs_cache[i] = (struct z_erofs_cache_entry) { };
+	}
+}
+
+static struct z_erofs_cache_entry *
+z_erofs_cache_find(struct erofs_map_blocks *map, unsigned int ioff,
+		   erofs_off_t length)
+{
+	struct z_erofs_cache_entry *e;
+	int i;
+
+	for (i = 0; i < Z_EROFS_CACHE_ENTRIES; i++) {
+		e = &z_erofs_cache[i];
+		if (e->len && e->pa == map->m_pa &&
+		    e->alg == map->m_algorithmformat &&
+		    e->interlaced_offset == ioff && e->len >= length) {
+			e->last_used = ++z_erofs_cache_counter;
+			return e;
+		}
+	}
+	return NULL;
+}
+
+static struct z_erofs_cache_entry *z_erofs_cache_get(unsigned int len)
+{
+	struct z_erofs_cache_entry *e = NULL;
+	int i;
+
+	/* use the least recently used entry, unused ones first */
+	for (i = 0; i < Z_EROFS_CACHE_ENTRIES; i++) {
+		if (!e || z_erofs_cache[i].last_used < e->last_used)
+			e = &z_erofs_cache[i];
+	}
+	if (!e)
+		return NULL;
+
+	e->len = 0;
+	if (e->bufsize < len) {
+		free(e->data);
+		e->data = malloc(len);
+		e->bufsize = e->data ? len : 0;
+		if (!e->data)
+			return NULL;
+	}
+	e->last_used = ++z_erofs_cache_counter;
+	return e;
+}
+
+/*
+ * Copy decompressed bytes [skip, length) of the extent in @map to @buffer
+ * using the cache. Returns -EAGAIN if the extent cannot be cached, in which
+ * case the caller decompresses the requested part directly.
+ */
+static int z_erofs_read_cached(struct erofs_inode *inode,
+			       struct erofs_map_blocks *map, char *raw,
+			       char *buffer, erofs_off_t skip,
+			       erofs_off_t length)
+{
+	unsigned int ioff = 0;
+	struct z_erofs_cache_entry *e;
+	int ret;
+
+	if (!Z_EROFS_CACHE_ENTRIES || map->m_flags & EROFS_MAP_FRAGMENT)
+		return -EAGAIN;
+
+	if (map->m_algorithmformat == Z_EROFS_COMPRESSION_INTERLACED)
+		ioff = erofs_blkoff(map->m_la);
+
+	e = z_erofs_cache_find(map, ioff, length);
+	if (!e) {
+		/* find out the full length of the extent */
+		if (!(map->m_flags & EROFS_MAP_FULL_MAPPED)) {
+			ret = z_erofs_map_blocks_iter(inode, map,
+						      EROFS_GET_BLOCKS_FIEMAP);
+			if (ret)
+				return ret;
+		}
+		if (map->m_llen > Z_EROFS_CACHE_MAX_LEN)
+			return -EAGAIN;
+
+		e = z_erofs_cache_get(map->m_llen);
+		if (!e)
+			return -EAGAIN;
+
+		ret = z_erofs_read_one_data(inode, map, raw, e->data, 0,
+					    map->m_llen, false);
+		if (ret < 0)
+			return ret;
+
+		e->pa = map->m_pa;
+		e->interlaced_offset = ioff;
+		e->alg = map->m_algorithmformat;
+		e->len = map->m_llen;
+	}
+
+	memcpy(buffer, e->data + skip, length - skip);
+	return 0;
+}
+
 static int z_erofs_read_data(struct erofs_inode *inode, char *buffer,
 			     erofs_off_t size, erofs_off_t offset)
 {
@@ -327,6 +459,21 @@ static int z_erofs_read_data(struct erofs_inode *inode, char *buffer,
 			}
 		}
 
+		/*
+		 * Extents which are wholly requested are decompressed straight
+		 * into the buffer, the others are read through the cache.
+		 */
+		if (skip || trimmed) {
+			ret = z_erofs_read_cached(inode, &map, raw,
+						  buffer + end - offset, skip,
+						  length);
+			if (ret != -EAGAIN) {
+				if (ret < 0)
+					break;
+				continue;
+			}
+		}
+
 		ret = z_erofs_read_one_data(inode, &map, raw,
 					    buffer + end - offset, skip, length,
 					    trimmed);
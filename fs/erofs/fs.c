@@ -7,6 +7,11 @@ struct erofs_sb_info sbi;
 static struct erofs_ctxt {
 	struct disk_partition cur_part_info;
 	struct blk_desc *cur_dev;
+
+	/* filesystem which the decompressed extent cache belongs to */
+	struct blk_desc *cache_dev;
+	lbaint_t cache_part_start;
+	struct erofs_sb_info cache_sbi;
 } ctxt;
 
 int erofs_dev_read(int device_id, void *buf, u64 offset, size_t len)
@@ -29,6 +34,32 @@ int erofs_blk_read(void *buf, erofs_blk_t start, u32 nblocks)
 			 erofs_pos(nblocks));
 }
 
+/*
+ * Every filesystem operation probes the filesystem again, so the cache of
+ * decompressed extents is kept until a different filesystem is probed. This
+ * is detected using the device, the partition and the superblock, which
+ * records the build time and uuid of the filesystem.
+ */
+static void erofs_check_cache(void)
+{
+	struct erofs_sb_info *old = &ctxt.cache_sbi;
+
+	if (ctxt.cache_dev == ctxt.cur_dev &&
+	    ctxt.cache_part_start == ctxt.cur_part_info.start &&
+	    old->build_time == sbi.build_time &&
+	    old->build_time_nsec == sbi.build_time_nsec &&
+	    old->primarydevice_blocks == sbi.primarydevice_blocks &&
+	    old->root_nid == sbi.root_nid &&
+	    old->checksum == sbi.checksum &&
+	    !memcmp(old->uuid, sbi.uuid, sizeof(sbi.uuid)))
+		return;
+
+	z_erofs_cache_flush();
+	ctxt.cache_dev = ctxt.cur_dev;
+	ctxt.cache_part_start = ctxt.cur_part_info.start;
+	ctxt.cache_sbi = sbi;
+}
+
 int erofs_probe(struct blk_desc *fs_dev_desc,
 		struct disk_partition *fs_partition)
 {
@@ -41,6 +72,8 @@ int erofs_probe(struct blk_desc *fs_dev_desc,
 	if (ret)
 		goto error;
 
+	erofs_check_cache();
+
 	return 0;
 error:
 	ctxt.cur_dev = NULL;
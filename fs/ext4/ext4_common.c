@@ -1641,6 +1641,86 @@ int ext4fs_read_inode(struct ext2_data *data, int ino, struct ext2_inode *inode)
 	return 1;
 }
 
+/**
+ * ext4fs_map_extent() - Map a file block of an extent-based inode
+ *
+ * @inode: Inode to look in
+ * @fileblock: File block to map
+ * @countp: Returns the number of file blocks from @fileblock onwards which
+ *	are contiguous on disk, or which are all part of the same hole
+ * @cache: Cache for extent-tree blocks, or NULL to use a temporary one
+ * Return: first disk block, 0 for a hole, -EINVAL if the extent tree is
+ *	invalid
+ */
+static long int ext4fs_map_extent(struct ext2_inode *inode, int fileblock,
+				  int *countp, struct ext_block_cache *cache)
+{
+	long int startblock, endblock;
+	struct ext_block_cache *c, cd;
+	struct ext4_extent_header *ext_block;
+	struct ext4_extent *extent;
+	unsigned long long start;
+	long int blknr = 0;
+	int log2_blksz;
+	int i;
+
+	log2_blksz = LOG2_BLOCK_SIZE(ext4fs_root) -
+		get_fs()->dev_desc->log2blksz;
+	if (cache) {
+		c = cache;
+	} else {
+		c = &cd;
+		ext_cache_init(c);
+	}
+	*countp = 1;
+	ext_block = ext4fs_get_extent_block(ext4fs_root, c,
+					    (struct ext4_extent_header *)
+					    inode->b.blocks.dir_blocks,
+					    fileblock, log2_blksz);
+	if (!ext_block) {
+		printf("invalid extent block\n");
+		blknr = -EINVAL;
+		goto out;
+	}
+
+	extent = (struct ext4_extent *)(ext_block + 1);
+
+	for (i = 0; i < le16_to_cpu(ext_block->eh_entries); i++) {
+		startblock = le32_to_cpu(extent[i].ee_block);
+		endblock = startblock + le16_to_cpu(extent[i].ee_len);
+
+		if (startblock > fileblock) {
+			/* Sparse file */
+			*countp = startblock - fileblock;
+			break;
+		} else if (fileblock < endblock) {
+			start = le16_to_cpu(extent[i].ee_start_hi);
+			start = (start << 32) +
+				le32_to_cpu(extent[i].ee_start_lo);
+			*countp = endblock - fileblock;
+			blknr = (fileblock - startblock) + start;
+			break;
+		}
+	}
+
+out:
+	if (!cache)
+		ext_cache_fini(c);
+
+	return blknr;
+}
+
+long int ext4fs_map_blocks(struct ext2_inode *inode, int fileblock,
+			   int *countp, struct ext_block_cache *cache)
+{
+	if (le32_to_cpu(inode->flags) & EXT4_EXTENTS_FL)
+		return ext4fs_map_extent(inode, fileblock, countp, cache);
+
+	*countp = 1;
+
+	return read_allocated_block(inode, fileblock, cache);
+}
+
 long int read_allocated_block(struct ext2_inode *inode, int fileblock,
 			      struct ext_block_cache *cache)
 {
@@ -1651,62 +1731,15 @@ long int read_allocated_block(struct ext2_inode *inode, int fileblock,
 	long int rblock;
 	long int perblock_parent;
 	long int perblock_child;
-	unsigned long long start;
 	/* get the blocksize of the filesystem */
 	blksz = EXT2_BLOCK_SIZE(ext4fs_root);
 	log2_blksz = LOG2_BLOCK_SIZE(ext4fs_root)
 		- get_fs()->dev_desc->log2blksz;
 
 	if (le32_to_cpu(inode->flags) & EXT4_EXTENTS_FL) {
-		long int startblock, endblock;
-		struct ext_block_cache *c, cd;
-		struct ext4_extent_header *ext_block;
-		struct ext4_extent *extent;
-		int i;
-
-		if (cache) {
-			c = cache;
-		} else {
-			c = &cd;
-			ext_cache_init(c);
-		}
-		ext_block =
-			ext4fs_get_extent_block(ext4fs_root, c,
-						(struct ext4_extent_header *)
-						inode->b.blocks.dir_blocks,
-						fileblock, log2_blksz);
-		if (!ext_block) {
-			printf("invalid extent block\n");
-			if (!cache)
-				ext_cache_fini(c);
-			return -EINVAL;
-		}
-
-		extent = (struct ext4_extent *)(ext_block + 1);
-
-		for (i = 0; i < le16_to_cpu(ext_block->eh_entries); i++) {
-			startblock = le32_to_cpu(extent[i].ee_block);
-			endblock = startblock + le16_to_cpu(extent[i].ee_len);
-
-			if (startblock > fileblock) {
-				/* Sparse file */
-				if (!cache)
-					ext_cache_fini(c);
-				return 0;
+		int count;
 
-			} else if (fileblock < endblock) {
-				start = le16_to_cpu(extent[i].ee_start_hi);
-				start = (start << 32) +
-					le32_to_cpu(extent[i].ee_start_lo);
-				if (!cache)
-					ext_cache_fini(c);
-				return (fileblock - startblock) + start;
-			}
-		}
-
-		if (!cache)
-			ext_cache_fini(c);
-		return 0;
+		return ext4fs_map_extent(inode, fileblock, &count, cache);
 	}
 
 	/* Direct blocks. */
@@ -2041,36 +2074,38 @@ void ext4fs_close(void)
 	ext4fs_reinit_global();
 }
 
-int ext4fs_iterate_dir(struct ext2fs_node *dir, char *name,
-				struct ext2fs_node **fnode, int *ftype)
+/* Number of directory blocks read at once when scanning a directory */
+#define EXT4_DIR_READ_BLOCKS	16
+
+/**
+ * ext4fs_iterate_block() - Look through directory entries held in memory
+ *
+ * Entries never cross a filesystem block, so @buf must hold whole blocks.
+ * If @name, @fnode and @ftype are all non-NULL, this looks for @name,
+ * otherwise it lists each entry.
+ *
+ * @diro: Directory being scanned
+ * @buf: Directory data
+ * @len: Number of bytes in @buf
+ * @name: Name to look for, or NULL to list the entries
+ * @fnode: Returns the node for @name, if found
+ * @ftype: Returns the FILETYPE_... of @name, if found
+ * Return: 1 if @name was found, 0 if not, -1 on error
+ */
+int ext4fs_iterate_block(struct ext2fs_node *diro, const char *buf, int len,
+			 const char *name, struct ext2fs_node **fnode,
+			 int *ftype)
 {
 	unsigned int fpos = 0;
 	int status;
-	loff_t actread;
-	struct ext2fs_node *diro = (struct ext2fs_node *) dir;
 
-#ifdef DEBUG
-	if (name != NULL)
-		printf("Iterate dir %s\n", name);
-#endif /* of DEBUG */
-	if (!diro->inode_read) {
-		status = ext4fs_read_inode(diro->data, diro->ino, &diro->inode);
-		if (status == 0)
-			return 0;
-	}
-	/* Search the file.  */
-	while (fpos < le32_to_cpu(diro->inode.size)) {
+	while (fpos + sizeof(struct ext2_dirent) <= len) {
 		struct ext2_dirent dirent;
 
-		status = ext4fs_read_file(diro, fpos,
-					   sizeof(struct ext2_dirent),
-					   (char *)&dirent, &actread);
-		if (status < 0)
-			return 0;
-
+		memcpy(&dirent, buf + fpos, sizeof(dirent));
 		if (dirent.direntlen == 0) {
 			printf("Failed to iterate over directory %s\n", name);
-			return 0;
+			return -1;
 		}
 
 		if (dirent.namelen != 0) {
@@ -2078,17 +2113,14 @@ int ext4fs_iterate_dir(struct ext2fs_node *dir, char *name,
 			struct ext2fs_node *fdiro;
 			int type = FILETYPE_UNKNOWN;
 
-			status = ext4fs_read_file(diro,
-						  fpos +
-						  sizeof(struct ext2_dirent),
-						  dirent.namelen, filename,
-						  &actread);
-			if (status < 0)
-				return 0;
+			if (fpos + sizeof(dirent) + dirent.namelen > len)
+				return -1;
+			memcpy(filename, buf + fpos + sizeof(dirent),
+			       dirent.namelen);
 
 			fdiro = zalloc(sizeof(struct ext2fs_node));
 			if (!fdiro)
-				return 0;
+				return -1;
 
 			fdiro->data = diro->data;
 			fdiro->ino = le32_to_cpu(dirent.inode);
@@ -2111,7 +2143,7 @@ int ext4fs_iterate_dir(struct ext2fs_node *dir, char *name,
 							   &fdiro->inode);
 				if (status == 0) {
 					free(fdiro);
-					return 0;
+					return -1;
 				}
 				fdiro->inode_read = 1;
 
@@ -2147,7 +2179,7 @@ int ext4fs_iterate_dir(struct ext2fs_node *dir, char *name,
 								 &fdiro->inode);
 					if (status == 0) {
 						free(fdiro);
-						return 0;
+						return -1;
 					}
 					fdiro->inode_read = 1;
 				}
@@ -2173,9 +2205,60 @@ int ext4fs_iterate_dir(struct ext2fs_node *dir, char *name,
 		}
 		fpos += le16_to_cpu(dirent.direntlen);
 	}
+
 	return 0;
 }
 
+int ext4fs_iterate_dir(struct ext2fs_node *dir, char *name,
+				struct ext2fs_node **fnode, int *ftype)
+{
+	struct ext2fs_node *diro = (struct ext2fs_node *) dir;
+	unsigned int chunk;
+	loff_t fpos, actread;
+	char *buf;
+	int status;
+	int ret = 0;
+
+#ifdef DEBUG
+	if (name != NULL)
+		printf("Iterate dir %s\n", name);
+#endif /* of DEBUG */
+	if (!diro->inode_read) {
+		status = ext4fs_read_inode(diro->data, diro->ino, &diro->inode);
+		if (status == 0)
+			return 0;
+	}
+
+	/* Use the hash-tree index, if there is one, to find a single name */
+	if (IS_ENABLED(CONFIG_EXT4_HTREE) && name && fnode && ftype &&
+	    (le32_to_cpu(diro->inode.flags) & EXT4_INDEX_FL)) {
+		ret = ext4fs_htree_find(diro, name, fnode, ftype);
+		if (ret >= 0)
+			return ret;
+		/* The index is not usable, so fall back to a linear scan */
+		ret = 0;
+	}
+
+	/* Search the file, reading several blocks at a time */
+	chunk = EXT2_BLOCK_SIZE(diro->data) * EXT4_DIR_READ_BLOCKS;
+	buf = malloc(chunk);
+	if (!buf)
+		return 0;
+	for (fpos = 0; fpos < le32_to_cpu(diro->inode.size); fpos += chunk) {
+		status = ext4fs_read_file(diro, fpos, chunk, buf, &actread);
+		if (status < 0)
+			break;
+
+		ret = ext4fs_iterate_block(diro, buf, actread, name, fnode,
+					   ftype);
+		if (ret)
+			break;
+	}
+	free(buf);
+
+	return ret == 1;
+}
+
 static char *ext4fs_read_symlink(struct ext2fs_node *node)
 {
 	char *symlink;
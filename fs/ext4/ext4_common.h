@@ -58,6 +58,23 @@ int ext4fs_find_file1(const char *currpath, struct ext2fs_node *currroot,
 		      struct ext2fs_node **currfound, int *foundtype);
 int ext4fs_iterate_dir(struct ext2fs_node *dir, char *name,
 			struct ext2fs_node **fnode, int *ftype);
+int ext4fs_iterate_block(struct ext2fs_node *diro, const char *buf, int len,
+			 const char *name, struct ext2fs_node **fnode,
+			 int *ftype);
+
+/**
+ * ext4fs_htree_find() - Look up a name using a directory's hash-tree index
+ *
+ * @dir: Directory to search, which must have EXT4_INDEX_FL set
+ * @name: Name to look for
+ * @fnode: Returns the node for @name, if found
+ * @ftype: Returns the FILETYPE_... of @name, if found
+ * Return: 1 if found, 0 if not found, -ve on error, e.g. -EPROTONOSUPPORT if
+ * the index uses a hash which is not supported or -EINVAL if it is corrupt.
+ * The caller should fall back to a linear scan on error.
+ */
+int ext4fs_htree_find(struct ext2fs_node *dir, const char *name,
+		      struct ext2fs_node **fnode, int *ftype);
 
 #if defined(CONFIG_EXT4_WRITE)
 uint32_t ext4fs_div_roundup(uint32_t size, uint32_t n);
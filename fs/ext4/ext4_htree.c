@@ -0,0 +1,479 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Hash-tree (dir_index) directory lookup for ext4
+ *
+ * The directory hashes are taken from the Linux kernel fs/ext4/hash.c
+ * Copyright (C) 2002 by Theodore Ts'o
+ *
+ * An indexed directory keeps an ordinary entry block at block 0, with the
+ * root of the index hidden after the '..' entry. The index maps the hash of
+ * a name to the logical directory block holding that name, so a lookup reads
+ * one block per index level and then scans a single leaf block.
+ */
+
+#include <blk.h>
+#include <ext4fs.h>
+#include <ext_common.h>
+#include <log.h>
+#include <malloc.h>
+#include <linux/errno.h>
+#include <linux/string.h>
+#include "ext4_common.h"
+
+#define DX_HASH_LEGACY			0
+#define DX_HASH_HALF_MD4		1
+#define DX_HASH_TEA			2
+#define DX_HASH_LEGACY_UNSIGNED		3
+#define DX_HASH_HALF_MD4_UNSIGNED	4
+#define DX_HASH_TEA_UNSIGNED		5
+
+/* Superblock flag: hashes use unsigned chars */
+#define EXT2_FLAGS_UNSIGNED_HASH	0x0002
+
+/* Directory entries are hashed on the case-folded name */
+#define EXT4_CASEFOLD_FL		0x40000000
+
+#define EXT4_HTREE_EOF_32BIT		0x7fffffff
+
+/* Most levels in the index, including the root, with the largedir feature */
+#define EXT4_HTREE_MAX_LEVELS		3
+
+/* Offset of the root information, after the '.' and '..' entries */
+#define DX_ROOT_INFO_OFFSET		24
+
+/* Offset of the entries in an index node, after its empty dirent */
+#define DX_NODE_ENTRIES_OFFSET		8
+
+/* The top bits of the block number are reserved */
+#define DX_BLOCK_MASK			0x0fffffff
+
+struct dx_root_info {
+	__le32 reserved_zero;
+	u8 hash_version;
+	u8 info_length;
+	u8 indirect_levels;
+	u8 unused_flags;
+};
+
+/* The count and limit overlay the hash of the first entry */
+struct dx_countlimit {
+	__le16 limit;
+	__le16 count;
+};
+
+struct dx_entry {
+	__le32 hash;
+	__le32 block;
+};
+
+/**
+ * struct dx_frame - One level of the index, while walking it
+ *
+ * @buf: Index block
+ * @entries: Entries in the block
+ * @count: Number of entries
+ * @at: Entry being followed
+ */
+struct dx_frame {
+	char *buf;
+	struct dx_entry *entries;
+	int count;
+	int at;
+};
+
+#define DELTA 0x9E3779B9
+
+static void tea_transform(u32 buf[4], u32 const in[])
+{
+	u32 sum = 0;
+	u32 b0 = buf[0], b1 = buf[1];
+	u32 a = in[0], b = in[1], c = in[2], d = in[3];
+	int n = 16;
+
+	do {
+		sum += DELTA;
+		b0 += ((b1 << 4) + a) ^ (b1 + sum) ^ ((b1 >> 5) + b);
+		b1 += ((b0 << 4) + c) ^ (b0 + sum) ^ ((b0 >> 5) + d);
+	} while (--n);
+
+	buf[0] += b0;
+	buf[1] += b1;
+}
+
+/* F, G and H are basic MD4 functions: selection, majority, parity */
+#define F(x, y, z) ((z) ^ ((x) & ((y) ^ (z))))
+#define G(x, y, z) (((x) & (y)) + (((x) ^ (y)) & (z)))
+#define H(x, y, z) ((x) ^ (y) ^ (z))
+
+static inline u32 rol32(u32 word, unsigned int shift)
+{
+	return (word << (shift & 31)) | (word >> ((-shift) & 31));
+}
+
+#define MD4_ROUND(f, a, b, c, d, x, s)	\
+	(a += f(b, c, d) + x, a = rol32(a, s))
+#define K1 0
+#define K2 013240474631UL
+#define K3 015666365641UL
+
+static void half_md4_transform(u32 buf[4], u32 const in[8])
+{
+	u32 a = buf[0], b = buf[1], c = buf[2], d = buf[3];
+
+	/* Round 1 */
+	MD4_ROUND(F, a, b, c, d, in[0] + K1,  3);
+	MD4_ROUND(F, d, a, b, c, in[1] + K1,  7);
+	MD4_ROUND(F, c, d, a, b, in[2] + K1, 11);
+	MD4_ROUND(F, b, c, d, a, in[3] + K1, 19);
+	MD4_ROUND(F, a, b, c, d, in[4] + K1,  3);
+	MD4_ROUND(F, d, a, b, c, in[5] + K1,  7);
+	MD4_ROUND(F, c, d, a, b, in[6] + K1, 11);
+	MD4_ROUND(F, b, c, d, a, in[7] + K1, 19);
+
+	/* Round 2 */
+	MD4_ROUND(G, a, b, c, d, in[1] + K2,  3);
+	MD4_ROUND(G, d, a, b, c, in[3] + K2,  5);
+	MD4_ROUND(G, c, d, a, b, in[5] + K2,  9);
+	MD4_ROUND(G, b, c, d, a, in[7] + K2, 13);
+	MD4_ROUND(G, a, b, c, d, in[0] + K2,  3);
+	MD4_ROUND(G, d, a, b, c, in[2] + K2,  5);
+	MD4_ROUND(G, c, d, a, b, in[4] + K2,  9);
+	MD4_ROUND(G, b, c, d, a, in[6] + K2, 13);
+
+	/* Round 3 */
+	MD4_ROUND(H, a, b, c, d, in[3] + K3,  3);
+	MD4_ROUND(H, d, a, b, c, in[7] + K3,  9);
+	MD4_ROUND(H, c, d, a, b, in[2] + K3, 11);
+	MD4_ROUND(H, b, c, d, a, in[6] + K3, 15);
+	MD4_ROUND(H, a, b, c, d, in[1] + K3,  3);
+	MD4_ROUND(H, d, a, b, c, in[5] + K3,  9);
+	MD4_ROUND(H, c, d, a, b, in[0] + K3, 11);
+	MD4_ROUND(H, b, c, d, a, in[4] + K3, 15);
+
+	buf[0] += a;
+	buf[1] += b;
+	buf[2] += c;
+	buf[3] += d;
+}
+
+/* The old legacy hash */
+static u32 dx_hack_hash(const char *name, int len, bool unsigned_chars)
+{
+	u32 hash, hash0 = 0x12a3fe2d, hash1 = 0x37abe8f9;
+
+	while (len--) {
+		int c = unsigned_chars ? (unsigned char)*name :
+			(signed char)*name;
+
+		name++;
+		hash = hash1 + (hash0 ^ (c * 7152373));
+		if (hash & 0x80000000)
+			hash -= 0x7fffffff;
+		hash1 = hash0;
+		hash0 = hash;
+	}
+
+	return hash0 << 1;
+}
+
+static void str2hashbuf(const char *msg, int len, u32 *buf, int num,
+			bool unsigned_chars)
+{
+	u32 pad, val;
+	int i;
+
+	pad = (u32)len | ((u32)len << 8);
+	pad |= pad << 16;
+
+	val = pad;
+	if (len > num * 4)
+		len = num * 4;
+	for (i = 0; i < len; i++) {
+		int c = unsigned_chars ? (unsigned char)msg[i] :
+			(signed char)msg[i];
+
+		val = c + (val << 8);
+		if ((i % 4) == 3) {
+			*buf++ = val;
+			val = pad;
+			num--;
+		}
+	}
+	if (--num >= 0)
+		*buf++ = val;
+	while (--num >= 0)
+		*buf++ = pad;
+}
+
+/**
+ * ext4fs_dirhash() - Work out the hash of a directory-entry name
+ *
+ * @sblock: Superblock, holding the hash seed
+ * @version: Hash version (DX_HASH_...)
+ * @name: Name to hash
+ * @len: Length of @name
+ * @hashp: Returns the major hash, with the bottom bit clear
+ * Return: 0 if OK, -EPROTONOSUPPORT if @version is not supported
+ */
+static int ext4fs_dirhash(const struct ext2_sblock *sblock, int version,
+			  const char *name, int len, u32 *hashp)
+{
+	bool unsigned_chars = false;
+	u32 in[8], buf[4];
+	u32 hash;
+	int i;
+
+	/* Initialise the default seed for the hash checksum functions */
+	buf[0] = 0x67452301;
+	buf[1] = 0xefcdab89;
+	buf[2] = 0x98badcfe;
+	buf[3] = 0x10325476;
+
+	/* An all-zero seed means the default */
+	for (i = 0; i < 4; i++) {
+		if (sblock->hash_seed[i]) {
+			for (i = 0; i < 4; i++)
+				buf[i] = le32_to_cpu(sblock->hash_seed[i]);
+			break;
+		}
+	}
+
+	switch (version) {
+	case DX_HASH_LEGACY_UNSIGNED:
+		unsigned_chars = true;
+		fallthrough;
+	case DX_HASH_LEGACY:
+		hash = dx_hack_hash(name, len, unsigned_chars);
+		break;
+	case DX_HASH_HALF_MD4_UNSIGNED:
+		unsigned_chars = true;
+		fallthrough;
+	case DX_HASH_HALF_MD4:
+		for (; len > 0; len -= 32, name += 32) {
+			str2hashbuf(name, len, in, 8, unsigned_chars);
+			half_md4_transform(buf, in);
+		}
+		hash = buf[1];
+		break;
+	case DX_HASH_TEA_UNSIGNED:
+		unsigned_chars = true;
+		fallthrough;
+	case DX_HASH_TEA:
+		for (; len > 0; len -= 16, name += 16) {
+			str2hashbuf(name, len, in, 4, unsigned_chars);
+			tea_transform(buf, in);
+		}
+		hash = buf[0];
+		break;
+	default:
+		return -EPROTONOSUPPORT;
+	}
+	hash &= ~1;
+	if (hash == (EXT4_HTREE_EOF_32BIT << 1))
+		hash = (EXT4_HTREE_EOF_32BIT - 1) << 1;
+	*hashp = hash;
+
+	return 0;
+}
+
+static int dx_read_block(struct ext2fs_node *dir, u32 blk, char *buf)
+{
+	int blocksize = EXT2_BLOCK_SIZE(dir->data);
+	loff_t pos = (loff_t)blk * blocksize;
+	loff_t actread;
+
+	if (pos + blocksize > le32_to_cpu(dir->inode.size))
+		return -EINVAL;
+	if (ext4fs_read_file(dir, pos, blocksize, buf, &actread) < 0 ||
+	    actread != blocksize)
+		return -EIO;
+
+	return 0;
+}
+
+/**
+ * dx_init_frame() - Find the entries in an index block
+ *
+ * @frame: Frame to fill in; @frame->buf must hold the index block
+ * @blocksize: Filesystem block size
+ * @offset: Offset of the count/limit header within the block
+ * Return: 0 if OK, -EINVAL if the block is corrupt
+ */
+static int dx_init_frame(struct dx_frame *frame, int blocksize, int offset)
+{
+	struct dx_countlimit *cl;
+	int count, limit;
+
+	cl = (struct dx_countlimit *)(frame->buf + offset);
+	count = le16_to_cpu(cl->count);
+	limit = le16_to_cpu(cl->limit);
+	if (!count || count > limit ||
+	    offset + limit * sizeof(struct dx_entry) > blocksize) {
+		log_debug("Bad htree block: count %d limit %d\n", count, limit);
+		return -EINVAL;
+	}
+	frame->entries = (struct dx_entry *)cl;
+	frame->count = count;
+	frame->at = 0;
+
+	return 0;
+}
+
+/* Read an index node below the root and find its entries */
+static int dx_load(struct ext2fs_node *dir, struct dx_frame *frame, u32 blk)
+{
+	int ret;
+
+	ret = dx_read_block(dir, blk, frame->buf);
+	if (ret)
+		return ret;
+
+	return dx_init_frame(frame, EXT2_BLOCK_SIZE(dir->data),
+			     DX_NODE_ENTRIES_OFFSET);
+}
+
+static u32 dx_get_block(struct dx_frame *frame)
+{
+	return le32_to_cpu(frame->entries[frame->at].block) & DX_BLOCK_MASK;
+}
+
+/* Find the last entry with a hash no larger than @hash */
+static void dx_search(struct dx_frame *frame, u32 hash)
+{
+	int p = 1, q = frame->count - 1;
+
+	while (p <= q) {
+		int m = p + (q - p) / 2;
+
+		if (le32_to_cpu(frame->entries[m].hash) > hash)
+			q = m - 1;
+		else
+			p = m + 1;
+	}
+	frame->at = p - 1;
+}
+
+/**
+ * dx_next_block() - Move to the next leaf, if it may also hold @hash
+ *
+ * Names with the same hash can spill over into the following leaf block, in
+ * which case the index entry for that leaf has the bottom bit of its hash
+ * set.
+ *
+ * @dir: Directory
+ * @frames: Index frames, from the root down
+ * @levels: Number of levels below the root
+ * @hash: Hash being looked up
+ * Return: 1 if there is another leaf to search, 0 if not, -ve on error
+ */
+static int dx_next_block(struct ext2fs_node *dir, struct dx_frame *frames,
+			 int levels, u32 hash)
+{
+	struct dx_frame *p = &frames[levels];
+	int num_frames = 0;
+	int ret;
+
+	while (++p->at >= p->count) {
+		if (p == frames)
+			return 0;
+		num_frames++;
+		p--;
+	}
+	if ((le32_to_cpu(p->entries[p->at].hash) & ~1) != hash)
+		return 0;
+
+	/* Reload the index nodes below the one which moved on */
+	while (num_frames--) {
+		u32 blk = dx_get_block(p);
+
+		p++;
+		ret = dx_load(dir, p, blk);
+		if (ret)
+			return ret;
+	}
+
+	return 1;
+}
+
+int ext4fs_htree_find(struct ext2fs_node *dir, const char *name,
+		      struct ext2fs_node **fnode, int *ftype)
+{
+	struct ext2_sblock *sblock = &dir->data->sblock;
+	struct dx_frame frames[EXT4_HTREE_MAX_LEVELS];
+	int blocksize = EXT2_BLOCK_SIZE(dir->data);
+	struct dx_root_info *info;
+	int version, levels;
+	char *leaf = NULL;
+	u32 hash;
+	int ret, i;
+
+	if (le32_to_cpu(dir->inode.flags) & EXT4_CASEFOLD_FL)
+		return -EPROTONOSUPPORT;
+
+	memset(frames, '\0', sizeof(frames));
+	frames[0].buf = malloc(blocksize);
+	if (!frames[0].buf)
+		return -ENOMEM;
+
+	ret = dx_read_block(dir, 0, frames[0].buf);
+	if (ret)
+		goto out;
+	info = (struct dx_root_info *)(frames[0].buf + DX_ROOT_INFO_OFFSET);
+	levels = info->indirect_levels;
+	if (info->reserved_zero || levels >= EXT4_HTREE_MAX_LEVELS) {
+		ret = -EINVAL;
+		goto out;
+	}
+
+	version = info->hash_version;
+	if (version <= DX_HASH_TEA &&
+	    (le32_to_cpu(sblock->flags) & EXT2_FLAGS_UNSIGNED_HASH))
+		version += DX_HASH_LEGACY_UNSIGNED;
+	ret = ext4fs_dirhash(sblock, version, name, strlen(name), &hash);
+	if (ret)
+		goto out;
+
+	/* Walk down the index to the leaf which should hold the name */
+	ret = dx_init_frame(&frames[0], blocksize,
+			    DX_ROOT_INFO_OFFSET + info->info_length);
+	if (ret)
+		goto out;
+	dx_search(&frames[0], hash);
+	for (i = 1; i <= levels; i++) {
+		frames[i].buf = malloc(blocksize);
+		if (!frames[i].buf) {
+			ret = -ENOMEM;
+			goto out;
+		}
+		ret = dx_load(dir, &frames[i], dx_get_block(&frames[i - 1]));
+		if (ret)
+			goto out;
+		dx_search(&frames[i], hash);
+	}
+
+	leaf = malloc(blocksize);
+	if (!leaf) {
+		ret = -ENOMEM;
+		goto out;
+	}
+	do {
+		ret = dx_read_block(dir, dx_get_block(&frames[levels]), leaf);
+		if (ret)
+			goto out;
+		ret = ext4fs_iterate_block(dir, leaf, blocksize, name, fnode,
+					   ftype);
+		if (ret) {
+			if (ret < 0)
+				ret = -EIO;
+			goto out;
+		}
+		ret = dx_next_block(dir, frames, levels, hash);
+	} while (ret > 0);
+
+out:
+	free(leaf);
+	for (i = 0; i < EXT4_HTREE_MAX_LEVELS; i++)
+		free(frames[i].buf);
+
+	return ret;
+}
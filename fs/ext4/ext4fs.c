@@ -47,12 +47,16 @@ void ext4fs_free_node(struct ext2fs_node *node, struct ext2fs_node *currroot)
  * Taken from openmoko-kernel mailing list: By Andy green
  * Optimized read file API : collects and defers contiguous sector
  * reads into one potentially more efficient larger sequential read action
+ *
+ * Blocks are mapped a run at a time (a whole extent, for extent-based
+ * inodes), so the extent tree is walked once per extent rather than once
+ * per block.
  */
 int ext4fs_read_file(struct ext2fs_node *node, loff_t pos,
 		loff_t len, char *buf, loff_t *actread)
 {
 	struct ext_filesystem *fs = get_fs();
-	int i;
+	lbaint_t i, firstblock;
 	lbaint_t blockcnt;
 	int log2blksz = fs->dev_desc->log2blksz;
 	int log2_fs_blocksize = LOG2_BLOCK_SIZE(node->data) - log2blksz;
@@ -64,7 +68,6 @@ int ext4fs_read_file(struct ext2fs_node *node, loff_t pos,
 	lbaint_t delayed_skipfirst = 0;
 	lbaint_t delayed_next = 0;
 	char *delayed_buf = NULL;
-	char *start_buf = buf;
 	short status;
 	struct ext_block_cache cache;
 
@@ -80,42 +83,42 @@ int ext4fs_read_file(struct ext2fs_node *node, loff_t pos,
 	}
 
 	blockcnt = lldiv(((len + pos) + blocksize - 1), blocksize);
+	firstblock = lldiv(pos, blocksize);
 
-	for (i = lldiv(pos, blocksize); i < blockcnt; i++) {
+	for (i = firstblock; i < blockcnt;) {
 		long int blknr;
-		int blockoff = pos - (blocksize * i);
-		int blockend = blocksize;
+		loff_t runstart = (loff_t)blocksize * i;
+		loff_t runend;
 		int skipfirst = 0;
-		blknr = read_allocated_block(&node->inode, i, &cache);
+		int count;
+		int n;
+
+		blknr = ext4fs_map_blocks(&node->inode, i, &count, &cache);
 		if (blknr < 0) {
 			ext_cache_fini(&cache);
 			return -1;
 		}
+		if (count > blockcnt - i)
+			count = blockcnt - i;
 
-		blknr = blknr << log2_fs_blocksize;
+		/* The last run stops at the end of the requested data */
+		runend = min((loff_t)blocksize * count, len + pos - runstart);
 
-		/* Last block.  */
-		if (i == blockcnt - 1) {
-			blockend = (len + pos) - (blocksize * i);
-
-			/* The last portion is exactly blocksize. */
-			if (!blockend)
-				blockend = blocksize;
-		}
+		/* The first run starts part-way into its first block */
+		if (i == firstblock)
+			skipfirst = pos - runstart;
+		n = runend - skipfirst;
 
-		/* First block. */
-		if (i == lldiv(pos, blocksize)) {
-			skipfirst = blockoff;
-			blockend -= skipfirst;
-		}
 		if (blknr) {
-			int status;
+			blknr = blknr << log2_fs_blocksize;
 
-			if (previous_block_number != -1) {
-				if (delayed_next == blknr) {
-					delayed_extent += blockend;
-					delayed_next += blockend >> log2blksz;
-				} else {	/* spill */
+			if (previous_block_number != -1 &&
+			    delayed_next == blknr &&
+			    delayed_extent + n <= INT_MAX) {
+				delayed_extent += n;
+			} else {
+				if (previous_block_number != -1) {
+					/* spill */
 					status = ext4fs_devread(delayed_start,
 							delayed_skipfirst,
 							delayed_extent,
@@ -124,26 +127,15 @@ int ext4fs_read_file(struct ext2fs_node *node, loff_t pos,
 						ext_cache_fini(&cache);
 						return -1;
 					}
-					previous_block_number = blknr;
-					delayed_start = blknr;
-					delayed_extent = blockend;
-					delayed_skipfirst = skipfirst;
-					delayed_buf = buf;
-					delayed_next = blknr +
-						(blockend >> log2blksz);
 				}
-			} else {
 				previous_block_number = blknr;
 				delayed_start = blknr;
-				delayed_extent = blockend;
+				delayed_extent = n;
 				delayed_skipfirst = skipfirst;
 				delayed_buf = buf;
-				delayed_next = blknr +
-					(blockend >> log2blksz);
 			}
+			delayed_next = blknr + (count << log2_fs_blocksize);
 		} else {
-			int n;
-			int n_left;
 			if (previous_block_number != -1) {
 				/* spill */
 				status = ext4fs_devread(delayed_start,
@@ -156,14 +148,11 @@ int ext4fs_read_file(struct ext2fs_node *node, loff_t pos,
 				}
 				previous_block_number = -1;
 			}
-			/* Zero no more than `len' bytes. */
-			n = blocksize - skipfirst;
-			n_left = len - ( buf - start_buf );
-			if (n > n_left)
-				n = n_left;
+			/* Hole: zero no more than `len' bytes */
 			memset(buf, 0, n);
 		}
-		buf += blocksize - skipfirst;
+		buf += n;
+		i += count;
 	}
 	if (previous_block_number != -1) {
 		/* spill */
@@ -15,6 +15,7 @@
 #include <exports.h>
 #include <fat.h>
 #include <fs.h>
+#include <fs_internal.h>
 #include <log.h>
 #include <asm/byteorder.h>
 #include <asm/unaligned.h>
@@ -22,8 +23,10 @@
 #include <malloc.h>
 #include <memalign.h>
 #include <asm/cache.h>
+#include <linux/build_bug.h>
 #include <linux/compiler.h>
 #include <linux/ctype.h>
+#include <linux/list.h>
 #include <linux/log2.h>
 
 /* maximum number of clusters for FAT12 */
@@ -45,6 +48,110 @@ static void downcase(char *str, size_t len)
 static struct blk_desc *cur_dev;
 static struct disk_partition cur_part_info;
 
+/* Bytes of the boot sector which identify a filesystem for the dir cache */
+#define FAT_DCACHE_BPB_LEN	0x5a
+
+/* Most directories and entries per directory held by the dir cache */
+#define FAT_DCACHE_MAX_DIRS	16
+#define FAT_DCACHE_MAX_ENTS	1024
+
+/**
+ * struct fat_dcache_ent - A directory entry held by the dir cache
+ *
+ * @hash: Hash of the long name, or of the short name if there is none
+ * @shash: Hash of the short name
+ * @name: Offset of the long name (or the short name) in the name pool
+ * @s_name: Offset of the short name in the name pool
+ * @dent: Copy of the short-name directory entry
+ */
+struct fat_dcache_ent {
+	u32 hash;
+	u32 shash;
+	u32 name;
+	u32 s_name;
+	dir_entry dent;
+};
+
+/**
+ * struct fat_dcache_dir - The decoded contents of a directory
+ *
+ * @node: Entry in fat_dcache.dirs, most recently used first
+ * @clust: First cluster of the directory
+ * @count: Number of entries
+ * @ents: Entries, in directory order
+ * @names: Pool of nul-terminated names
+ * @names_len: Bytes used in @names
+ */
+struct fat_dcache_dir {
+	struct list_head node;
+	u32 clust;
+	int count;
+	struct fat_dcache_ent *ents;
+	char *names;
+	u32 names_len;
+};
+
+/**
+ * struct fat_dcache - Decoded directories of the current filesystem
+ *
+ * Bootmeths probe the same few paths on each partition, mostly for files
+ * which are not there, so remember the directories seen. This is dropped
+ * whenever a different filesystem is selected or anything is written.
+ *
+ * @dev: Device holding the filesystem
+ * @part_start: First block of the partition
+ * @bpb: Start of the boot sector, including the volume ID
+ * @ndirs: Number of directories in @dirs
+ * @dirs: List of struct fat_dcache_dir
+ */
+static struct fat_dcache {
+	struct blk_desc *dev;
+	lbaint_t part_start;
+	u8 bpb[FAT_DCACHE_BPB_LEN];
+	int ndirs;
+	struct list_head dirs;
+} fat_dcache = {
+	.dirs = LIST_HEAD_INIT(fat_dcache.dirs),
+};
+
+static void fat_dcache_free_dir(struct fat_dcache_dir *dir)
+{
+	free(dir->ents);
+	free(dir->names);
+	free(dir);
+}
+
+/* Drop everything in the dir cache */
+static void fat_dcache_drop(void)
+{
+	struct fat_dcache_dir *dir, *next;
+
+	list_for_each_entry_safe(dir, next, &fat_dcache.dirs, node) {
+		list_del(&dir->node);
+		fat_dcache_free_dir(dir);
+	}
+	fat_dcache.ndirs = 0;
+	fat_dcache.dev = NULL;
+}
+
+/**
+ * fat_dcache_check() - Drop the dir cache if the filesystem has changed
+ *
+ * @sect: Boot sector of the filesystem now selected
+ */
+static void fat_dcache_check(const u8 *sect)
+{
+	if (fat_dcache.dev == cur_dev &&
+	    fat_dcache.part_start == cur_part_info.start &&
+	    !memcmp(fat_dcache.bpb, sect, FAT_DCACHE_BPB_LEN))
+		return;
+
+	fat_dcache_drop();
+	fat_dcache.dev = cur_dev;
+	fat_dcache.part_start = cur_part_info.start;
+	memcpy(fat_dcache.bpb, sect, FAT_DCACHE_BPB_LEN);
+}
+
 #define DOS_BOOT_MAGIC_OFFSET	0x1fe
 #define DOS_FS_TYPE_OFFSET	0x36
 #define DOS_FS32_TYPE_OFFSET	0x52
@@ -84,10 +191,12 @@ int fat_set_blk_dev(struct blk_desc *dev_desc, struct disk_partition *info)
 	}
 
 	/* Check for FAT12/FAT16/FAT32 filesystem */
-	if (!memcmp(buffer + DOS_FS_TYPE_OFFSET, "FAT", 3))
-		return 0;
-	if (!memcmp(buffer + DOS_FS32_TYPE_OFFSET, "FAT32", 5))
+	if (!memcmp(buffer + DOS_FS_TYPE_OFFSET, "FAT", 3) ||
+	    !memcmp(buffer + DOS_FS32_TYPE_OFFSET, "FAT32", 5)) {
+		if (CONFIG_IS_ENABLED(FAT_DIR_CACHE))
+			fat_dcache_check(buffer);
 		return 0;
+	}
 
 	cur_dev = NULL;
 	return -1;
@@ -246,14 +355,16 @@ static __u32 get_fatent(fsdata *mydata, __u32 entry)
 }
 
 /*
- * Read at most 'size' bytes from the specified cluster into 'buffer'.
+ * Read 'size' bytes into 'buffer', starting 'offset' bytes into the specified
+ * cluster. Whole sectors are read straight into 'buffer', so only a partial
+ * first and last sector go through a bounce buffer.
  * Return 0 on success, -1 otherwise.
  */
 static int
-get_cluster(fsdata *mydata, __u32 clustnum, __u8 *buffer, unsigned long size)
+get_cluster(fsdata *mydata, __u32 clustnum, __u32 offset, __u8 *buffer,
+	    unsigned long size)
 {
 	__u32 startsect;
-	int ret;
 
 	if (clustnum > 0) {
 		startsect = clust_to_sect(mydata, clustnum);
@@ -263,46 +374,10 @@ get_cluster(fsdata *mydata, __u32 clustnum, __u8 *buffer, unsigned long size)
 
 	debug("gc - clustnum: %d, startsect: %d\n", clustnum, startsect);
 
-	if ((unsigned long)buffer & (ARCH_DMA_MINALIGN - 1)) {
-		ALLOC_CACHE_ALIGN_BUFFER(__u8, tmpbuf, mydata->sect_size);
-
-		debug("FAT: Misaligned buffer address (%p)\n", buffer);
-
-		while (size >= mydata->sect_size) {
-			ret = disk_read(startsect++, 1, tmpbuf);
-			if (ret != 1) {
-				debug("Error reading data (got %d)\n", ret);
-				return -1;
-			}
-
-			memcpy(buffer, tmpbuf, mydata->sect_size);
-			buffer += mydata->sect_size;
-			size -= mydata->sect_size;
-		}
-	} else if (size >= mydata->sect_size) {
-		__u32 bytes_read;
-		__u32 sect_count = size / mydata->sect_size;
-
-		ret = disk_read(startsect, sect_count, buffer);
-		if (ret != sect_count) {
-			debug("Error reading data (got %d)\n", ret);
-			return -1;
-		}
-		bytes_read = sect_count * mydata->sect_size;
-		startsect += sect_count;
-		buffer += bytes_read;
-		size -= bytes_read;
-	}
-	if (size) {
-		ALLOC_CACHE_ALIGN_BUFFER(__u8, tmpbuf, mydata->sect_size);
-
-		ret = disk_read(startsect, 1, tmpbuf);
-		if (ret != 1) {
-			debug("Error reading data (got %d)\n", ret);
-			return -1;
-		}
-
-		memcpy(buffer, tmpbuf, size);
+	if (!cur_dev || !fs_devread(cur_dev, &cur_part_info, startsect, offset,
+				    size, (char *)buffer)) {
+		debug("Error reading data\n");
+		return -1;
 	}
 
 	return 0;
@@ -365,24 +440,14 @@ static int get_contents(fsdata *mydata, dir_entry *dentptr, loff_t pos,
 
 	/* align to beginning of next cluster if any */
 	if (pos) {
-		__u8 *tmp_buffer;
-
 		actsize = min(filesize, (loff_t)bytesperclust);
-		tmp_buffer = malloc_cache_aligned(actsize);
-		if (!tmp_buffer) {
-			debug("Error: allocating buffer\n");
-			return -1;
-		}
-
-		if (get_cluster(mydata, curclust, tmp_buffer, actsize) != 0) {
+		if (get_cluster(mydata, curclust, pos, buffer,
+				actsize - pos) != 0) {
 			printf("Error reading cluster\n");
-			free(tmp_buffer);
 			return -1;
 		}
 		filesize -= actsize;
 		actsize -= pos;
-		memcpy(buffer, tmp_buffer + pos, actsize);
-		free(tmp_buffer);
 		*gotsize += actsize;
 		if (!filesize)
 			return 0;
@@ -416,14 +481,14 @@ static int get_contents(fsdata *mydata, dir_entry *dentptr, loff_t pos,
 
 		/* get remaining bytes */
 		actsize = filesize;
-		if (get_cluster(mydata, curclust, buffer, (int)actsize) != 0) {
+		if (get_cluster(mydata, curclust, 0, buffer, (int)actsize) != 0) {
 			printf("Error reading cluster\n");
 			return -1;
 		}
 		*gotsize += actsize;
 		return 0;
 getit:
-		if (get_cluster(mydata, curclust, buffer, (int)actsize) != 0) {
+		if (get_cluster(mydata, curclust, 0, buffer, (int)actsize) != 0) {
 			printf("Error reading cluster\n");
 			return -1;
 		}
@@ -683,6 +748,8 @@ static int get_fs_info(fsdata *mydata)
 		mydata->root_cluster = 0;
 	}
 
+	/* A FAT12 entry must not straddle two windows */
+	BUILD_BUG_ON(FATBUFBLOCKS % 3);
 	mydata->fatbufnum = -1;
 	mydata->fat_dirty = 0;
 	mydata->fatbuf = malloc_cache_aligned(FATBUFSIZE);
@@ -814,6 +881,30 @@ static int fat_itr_root(fat_itr *itr, fsdata *fsdata)
 	return 0;
 }
 
+/**
+ * fat_itr_enter() - move an iterator to the start of a directory
+ *
+ * @itr: iterator, with @itr->fsdata set
+ * @clustnum: first cluster of the directory, 0 for the root directory
+ */
+static void fat_itr_enter(fat_itr *itr, unsigned clustnum)
+{
+	itr->start_clust = clustnum;
+	if (clustnum > 0) {
+		itr->clust = clustnum;
+		itr->next_clust = clustnum;
+		itr->is_root = 0;
+	} else {
+		itr->clust = itr->fsdata->root_cluster;
+		itr->next_clust = itr->fsdata->root_cluster;
+		itr->start_clust = itr->fsdata->root_cluster;
+		itr->is_root = 1;
+	}
+	itr->dent = NULL;
+	itr->remaining = 0;
+	itr->last_cluster = 0;
+}
+
 /**
  * fat_itr_child() - initialize an iterator to descend into a sub-
  * directory
@@ -839,20 +930,7 @@ static void fat_itr_child(fat_itr *itr, fat_itr *parent)
 	assert(fat_itr_isdir(parent));
 
 	itr->fsdata = parent->fsdata;
-	itr->start_clust = clustnum;
-	if (clustnum > 0) {
-		itr->clust = clustnum;
-		itr->next_clust = clustnum;
-		itr->is_root = 0;
-	} else {
-		itr->clust = parent->fsdata->root_cluster;
-		itr->next_clust = parent->fsdata->root_cluster;
-		itr->start_clust = parent->fsdata->root_cluster;
-		itr->is_root = 1;
-	}
-	itr->dent = NULL;
-	itr->remaining = 0;
-	itr->last_cluster = 0;
+	fat_itr_enter(itr, clustnum);
 }
 
 /**
@@ -1192,6 +1270,246 @@ static int fat_itr_resolve(fat_itr *itr, const char *path, unsigned type)
 	return -ENOENT;
 }
 
+/* Case-insensitive hash of a name, to match strncasecmp() */
+static u32 fat_dcache_hash(const char *name, int len)
+{
+	u32 hash = 0;
+
+	while (len--)
+		hash = hash * 31 + tolower(*name++);
+
+	return hash;
+}
+
+/* Add a name to a directory's pool, returning its offset or -ENOMEM */
+static int fat_dcache_add_name(struct fat_dcache_dir *dir, const char *name)
+{
+	int len = strlen(name) + 1;
+	char *names;
+
+	names = realloc(dir->names, dir->names_len + len);
+	if (!names)
+		return -ENOMEM;
+	dir->names = names;
+	memcpy(dir->names + dir->names_len, name, len);
+	dir->names_len += len;
+
+	return dir->names_len - len;
+}
+
+/**
+ * fat_dcache_fill() - Read a whole directory into the dir cache
+ *
+ * @itr: iterator at the start of the directory; this is used up
+ * Return: the new cache entry, or NULL if the directory is too large or
+ * there is no memory
+ */
+static struct fat_dcache_dir *fat_dcache_fill(fat_itr *itr)
+{
+	struct fat_dcache_dir *dir;
+
+	dir = calloc(1, sizeof(*dir));
+	if (!dir)
+		return NULL;
+	dir->clust = itr->start_clust;
+
+	while (fat_itr_next(itr)) {
+		struct fat_dcache_ent *ent;
+		int ret;
+
+		if (dir->count == FAT_DCACHE_MAX_ENTS)
+			goto err;
+		if (!(dir->count % 32)) {
+			ent = realloc(dir->ents,
+				      (dir->count + 32) * sizeof(*ent));
+			if (!ent)
+				goto err;
+			dir->ents = ent;
+		}
+		ent = &dir->ents[dir->count];
+		memcpy(&ent->dent, itr->dent, sizeof(ent->dent));
+
+		ret = fat_dcache_add_name(dir, itr->s_name);
+		if (ret < 0)
+			goto err;
+		ent->s_name = ret;
+		ent->shash = fat_dcache_hash(itr->s_name, strlen(itr->s_name));
+		if (itr->name != itr->s_name) {
+			ret = fat_dcache_add_name(dir, itr->name);
+			if (ret < 0)
+				goto err;
+			ent->name = ret;
+			ent->hash = fat_dcache_hash(itr->name,
+						    strlen(itr->name));
+		} else {
+			ent->name = ent->s_name;
+			ent->hash = ent->shash;
+		}
+		dir->count++;
+	}
+
+	if (fat_dcache.ndirs == FAT_DCACHE_MAX_DIRS) {
+		struct fat_dcache_dir *last;
+
+		last = list_last_entry(&fat_dcache.dirs, struct fat_dcache_dir,
+				       node);
+		list_del(&last->node);
+		fat_dcache_free_dir(last);
+		fat_dcache.ndirs--;
+	}
+	list_add(&dir->node, &fat_dcache.dirs);
+	fat_dcache.ndirs++;
+
+	return dir;
+
+err:
+	fat_dcache_free_dir(dir);
+	return NULL;
+}
+
+static bool fat_dcache_match(const char *name, const char *path, int len)
+{
+	return strlen(name) == len && !strncasecmp(name, path, len);
+}
+
+/**
+ * fat_dcache_find() - Find a name in a cached directory
+ *
+ * Like fat_itr_resolve(), this checks the long name and then the short name
+ * of each entry in turn.
+ *
+ * @dir: cached directory
+ * @path: name to look for, which need not be nul-terminated
+ * @len: length of @path
+ * Return: the entry, or NULL if not found
+ */
+static struct fat_dcache_ent *fat_dcache_find(struct fat_dcache_dir *dir,
+					      const char *path, int len)
+{
+	u32 hash = fat_dcache_hash(path, len);
+	int i;
+
+	for (i = 0; i < dir->count; i++) {
+		struct fat_dcache_ent *ent = &dir->ents[i];
+
+		if (ent->hash == hash &&
+		    fat_dcache_match(dir->names + ent->name, path, len))
+			return ent;
+		if (ent->name != ent->s_name && ent->shash == hash &&
+		    fat_dcache_match(dir->names + ent->s_name, path, len))
+			return ent;
+	}
+
+	return NULL;
+}
+
+/**
+ * fat_dcache_get() - Get the cached contents of the iterator's directory
+ *
+ * The directory is read into the cache if it is not there already, which
+ * uses up the iterator.
+ *
+ * @itr: iterator at the start of a directory
+ * Return: the cached directory, or NULL if it could not be cached
+ */
+static struct fat_dcache_dir *fat_dcache_get(fat_itr *itr)
+{
+	struct fat_dcache_dir *dir;
+
+	if (fat_dcache.dev != cur_dev)
+		return NULL;
+	list_for_each_entry(dir, &fat_dcache.dirs, node) {
+		if (dir->clust == itr->start_clust) {
+			list_move(&dir->node, &fat_dcache.dirs);
+			return dir;
+		}
+	}
+
+	return fat_dcache_fill(itr);
+}
+
+/**
+ * fat_itr_lookup() - resolve a path for reading, using the dir cache
+ *
+ * This behaves like fat_itr_resolve(), but answers from the dir cache where
+ * it can. When the path is to a file, the iterator is left holding a copy
+ * of the file's directory entry and cannot be used to step through the
+ * rest of the parent directory, nor to update the entry. Use
+ * fat_itr_resolve() for that.
+ *
+ * @itr: iterator initialized to root
+ * @path: the requested path
+ * @type: bitmask of allowable file types
+ * Return: 0 on success or -errno
+ */
+static int fat_itr_lookup(fat_itr *itr, const char *path, unsigned type)
+{
+	fsdata *mydata = itr->fsdata;  /* for silly macros */
+
+	if (!CONFIG_IS_ENABLED(FAT_DIR_CACHE))
+		return fat_itr_resolve(itr, path, type);
+
+	while (1) {
+		struct fat_dcache_dir *dir;
+		struct fat_dcache_ent *ent;
+		const char *next;
+
+		while (path[0] && ISDIRDELIM(path[0]))
+			path++;
+		if (!path[0])
+			return type & TYPE_DIR ? 0 : -ENOENT;
+
+		next = path;
+		while (next[0] && !ISDIRDELIM(next[0]))
+			next++;
+
+		/* root dir doesn't have "." nor ".." */
+		if (itr->is_root &&
+		    (((next - path) == 1 && !strncmp(path, ".", 1)) ||
+		     ((next - path) == 2 && !strncmp(path, "..", 2)))) {
+			fat_itr_enter(itr, 0);
+			path = next;
+			continue;
+		}
+
+		dir = fat_dcache_get(itr);
+		if (!dir) {
+			fat_itr_enter(itr, itr->is_root ? 0 : itr->start_clust);
+			return fat_itr_resolve(itr, path, type);
+		}
+
+		ent = fat_dcache_find(dir, path, next - path);
+		if (!ent)
+			return -ENOENT;
+
+		if (ent->dent.attr & ATTR_DIR) {
+			fat_itr_enter(itr, START(&ent->dent));
+			path = next;
+			continue;
+		} else if (next[0]) {
+			debug("bad trailing path: %s\n", next);
+			return -ENOENT;
+		} else if (!(type & TYPE_FILE)) {
+			return -ENOTDIR;
+		}
+
+		/* leave the entry where the caller expects to find it */
+		memcpy(itr->block, &ent->dent, sizeof(ent->dent));
+		itr->dent = (dir_entry *)itr->block;
+		itr->dent_start = NULL;
+		itr->remaining = 0;
+		itr->last_cluster = 1;
+		strlcpy(itr->s_name, dir->names + ent->s_name,
+			sizeof(itr->s_name));
+		strlcpy(itr->l_name, dir->names + ent->name,
+			sizeof(itr->l_name));
+		itr->name = ent->name == ent->s_name ? itr->s_name :
+			itr->l_name;
+
+		return 0;
+	}
+}
+
 int file_fat_detectfs(void)
 {
 	boot_sector bs;
@@ -1236,7 +1554,7 @@ int fat_exists(const char *filename)
 	if (ret)
 		goto out;
 
-	ret = fat_itr_resolve(itr, filename, TYPE_ANY);
+	ret = fat_itr_lookup(itr, filename, TYPE_ANY);
 	free(fsdata.fatbuf);
 out:
 	free(itr);
@@ -1278,7 +1596,7 @@ int fat_size(const char *filename, loff_t *size)
 	if (ret)
 		goto out_free_itr;
 
-	ret = fat_itr_resolve(itr, filename, TYPE_FILE);
+	ret = fat_itr_lookup(itr, filename, TYPE_FILE);
 	if (ret) {
 		/*
 		 * Directories don't have size, but fs_size() is not
@@ -1288,7 +1606,7 @@ int fat_size(const char *filename, loff_t *size)
 		ret = fat_itr_root(itr, &fsdata);
 		if (ret)
 			goto out_free_itr;
-		ret = fat_itr_resolve(itr, filename, TYPE_DIR);
+		ret = fat_itr_lookup(itr, filename, TYPE_DIR);
 		if (!ret)
 			*size = 0;
 		goto out_free_both;
@@ -1316,7 +1634,7 @@ int fat_read_file(const char *filename, void *buf, loff_t offset, loff_t len,
 	if (ret)
 		goto out_free_itr;
 
-	ret = fat_itr_resolve(itr, filename, TYPE_FILE);
+	ret = fat_itr_lookup(itr, filename, TYPE_FILE);
 	if (ret)
 		goto out_free_both;
 
@@ -1367,7 +1685,7 @@ int fat_opendir(const char *filename, struct fs_dir_stream **dirsp)
 	if (ret)
 		goto fail_free_dir;
 
-	ret = fat_itr_resolve(&dir->itr, filename, TYPE_DIR);
+	ret = fat_itr_lookup(&dir->itr, filename, TYPE_DIR);
 	if (ret)
 		goto fail_free_both;
 
@@ -205,6 +205,9 @@ static int disk_write(__u32 block, __u32 nr_blocks, void *buf)
 		return -1;
 	}
 
+	if (CONFIG_IS_ENABLED(FAT_DIR_CACHE))
+		fat_dcache_drop();
+
 	ret = blk_dwrite(cur_dev, cur_part_info.start + block, nr_blocks, buf);
 	if (nr_blocks && ret == 0)
 		return -1;
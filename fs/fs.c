@@ -5,6 +5,7 @@
 
 #define LOG_CATEGORY LOGC_CORE
 
+#include <bootstage.h>
 #include <command.h>
 #include <config.h>
 #include <display_options.h>
@@ -14,12 +15,15 @@
 #include <log.h>
 #include <malloc.h>
 #include <mapmem.h>
+#include <memalign.h>
 #include <part.h>
 #include <ext4fs.h>
 #include <fat.h>
+#include <image.h>
 #include <fs.h>
 #include <sandboxfs.h>
 #include <semihostingfs.h>
+#include <virtiofs.h>
 #include <time.h>
 #include <ubifs_uboot.h>
 #include <btrfs.h>
@@ -154,6 +158,15 @@ struct fstype_info {
 	 * filesystem.
 	 */
 	bool null_dev_desc_ok;
+	/*
+	 * Signature which the filesystem must have: @magic_len bytes at
+	 * @magic_offset from the start of the partition. With
+	 * CONFIG_FS_PROBE_MAGIC this is checked before .probe() is called.
+	 * @magic_len is 0 if there is no fixed signature.
+	 */
+	uint magic_offset;
+	uint magic_len;
+	const char *magic;
 	int (*probe)(struct blk_desc *fs_dev_desc,
 		     struct disk_partition *fs_partition);
 	int (*ls)(const char *dirname);
@@ -218,6 +231,9 @@ static struct fstype_info fstypes[] = {
 		.fstype = FS_TYPE_EXT,
 		.name = "ext4",
 		.null_dev_desc_ok = false,
+		.magic_offset = 1080,
+		.magic_len = 2,
+		.magic = "\x53\xef",
 		.probe = ext4fs_probe,
 		.close = ext4fs_close,
 		.ls = ext4fs_ls,
@@ -237,6 +253,26 @@ static struct fstype_info fstypes[] = {
 		.mkdir = fs_mkdir_unsupported,
 	},
 #endif
+#if CONFIG_IS_ENABLED(VIRTIO) && IS_ENABLED(CONFIG_VIRTIO_FS)
+	/* This comes before sandbox, which accepts any NULL blk_desc */
+	{
+		.fstype = FS_TYPE_VIRTIO,
+		.name = "virtiofs",
+		.null_dev_desc_ok = true,
+		.probe = virtio_fs_set_blk_dev,
+		.close = virtio_fs_close,
+		.ls = virtio_fs_ls,
+		.exists = virtio_fs_exists,
+		.size = virtio_fs_size,
+		.read = virtio_fs_read,
+		.write = fs_write_unsupported,
+		.uuid = fs_uuid_unsupported,
+		.opendir = fs_opendir_unsupported,
+		.unlink = fs_unlink_unsupported,
+		.mkdir = fs_mkdir_unsupported,
+		.ln = fs_ln_unsupported,
+	},
+#endif
 #if IS_ENABLED(CONFIG_SANDBOX) && !IS_ENABLED(CONFIG_SPL_BUILD)
 	{
 		.fstype = FS_TYPE_SANDBOX,
@@ -262,7 +298,7 @@ static struct fstype_info fstypes[] = {
 		.name = "semihosting",
 		.null_dev_desc_ok = true,
 		.probe = smh_fs_set_blk_dev,
-		.close = fs_close_unsupported,
+		.close = smh_fs_close,
 		.ls = fs_ls_unsupported,
 		.exists = fs_exists_unsupported,
 		.size = smh_fs_size,
@@ -302,6 +338,9 @@ static struct fstype_info fstypes[] = {
 		.fstype = FS_TYPE_BTRFS,
 		.name = "btrfs",
 		.null_dev_desc_ok = false,
+		.magic_offset = 0x10040,
+		.magic_len = 8,
+		.magic = "_BHRfS_M",
 		.probe = btrfs_probe,
 		.close = btrfs_close,
 		.ls = btrfs_ls,
@@ -322,6 +361,9 @@ static struct fstype_info fstypes[] = {
 		.fstype = FS_TYPE_SQUASHFS,
 		.name = "squashfs",
 		.null_dev_desc_ok = false,
+		.magic_offset = 0,
+		.magic_len = 4,
+		.magic = "hsqs",
 		.probe = sqfs_probe,
 		.opendir = sqfs_opendir,
 		.readdir = sqfs_readdir,
@@ -343,6 +385,9 @@ static struct fstype_info fstypes[] = {
 		.fstype = FS_TYPE_EROFS,
 		.name = "erofs",
 		.null_dev_desc_ok = false,
+		.magic_offset = 1024,
+		.magic_len = 4,
+		.magic = "\xe2\xe1\xf5\xe0",
 		.probe = erofs_probe,
 		.opendir = erofs_opendir,
 		.readdir = erofs_readdir,
@@ -418,16 +463,73 @@ const char *fs_get_type_name(void)
 	return fs_get_info(fs_type)->name;
 }
 
-int fs_set_blk_dev(const char *ifname, const char *dev_part_str, int fstype)
+/**
+ * fs_read_magic() - Read the start of the current partition
+ *
+ * This reads enough to cover the signatures of all the filesystems which might
+ * be on the partition, in one go. The read goes through the block cache, so
+ * the probe of the filesystem which matches can find its superblock there.
+ *
+ * @fstype: Filesystem type wanted, or FS_TYPE_ANY
+ * @sizep: Returns the number of bytes read
+ * Return: buffer holding the data (to be freed by the caller), or NULL if
+ *	nothing could be read
+ */
+static u8 *fs_read_magic(int fstype, uint *sizep)
 {
 	struct fstype_info *info;
-	int part, i;
+	lbaint_t blkcnt;
+	uint size = 0;
+	u8 *buf;
+	int i;
 
-	part = part_get_info_by_dev_and_name_or_num(ifname, dev_part_str, &fs_dev_desc,
-						    &fs_partition, 1);
-	if (part < 0)
-		return -1;
+	if (!IS_ENABLED(CONFIG_FS_PROBE_MAGIC) || !fs_dev_desc ||
+	    !fs_dev_desc->blksz)
+		return NULL;
+	for (i = 0, info = fstypes; i < ARRAY_SIZE(fstypes); i++, info++) {
+		if (fstype != FS_TYPE_ANY && info->fstype != fstype)
+			continue;
+		if (info->magic_len)
+			size = max(size, info->magic_offset + info->magic_len);
+	}
+	if (!size)
+		return NULL;
+	blkcnt = DIV_ROUND_UP(size, fs_dev_desc->blksz);
+	blkcnt = min(blkcnt, (lbaint_t)fs_partition.size);
+	if (!blkcnt)
+		return NULL;
 
+	buf = malloc_cache_aligned(blkcnt * fs_dev_desc->blksz);
+	if (!buf)
+		return NULL;
+	if (blk_dread(fs_dev_desc, fs_partition.start, blkcnt, buf) != blkcnt) {
+		free(buf);
+		return NULL;
+	}
+	*sizep = blkcnt * fs_dev_desc->blksz;
+
+	return buf;
+}
+
+/**
+ * fs_probe() - Find the filesystem on the current partition
+ *
+ * Filesystems whose signature is known not to be on the partition are skipped
+ * without calling their .probe()
+ *
+ * @fstype: Filesystem type wanted, or FS_TYPE_ANY
+ * @part: Partition number, to record
+ * Return: 0 if a filesystem was found, -1 if not
+ */
+static int fs_probe(int fstype, int part)
+{
+	struct fstype_info *info;
+	uint size = 0;
+	int ret = -1;
+	u8 *buf;
+	int i;
+
+	buf = fs_read_magic(fstype, &size);
 	for (i = 0, info = fstypes; i < ARRAY_SIZE(fstypes); i++, info++) {
 		if (fstype != FS_TYPE_ANY && info->fstype != FS_TYPE_ANY &&
 				fstype != info->fstype)
@@ -436,21 +538,40 @@ int fs_set_blk_dev(const char *ifname, const char *dev_part_str, int fstype)
 		if (!fs_dev_desc && !info->null_dev_desc_ok)
 			continue;
 
+		if (buf && info->magic_len &&
+		    info->magic_offset + info->magic_len <= size &&
+		    memcmp(buf + info->magic_offset, info->magic,
+			   info->magic_len))
+			continue;
+
 		if (!info->probe(fs_dev_desc, &fs_partition)) {
 			fs_type = info->fstype;
 			fs_dev_part = part;
-			return 0;
+			ret = 0;
+			break;
 		}
 	}
+	free(buf);
 
-	return -1;
+	return ret;
+}
+
+int fs_set_blk_dev(const char *ifname, const char *dev_part_str, int fstype)
+{
+	int part;
+
+	part = part_get_info_by_dev_and_name_or_num(ifname, dev_part_str, &fs_dev_desc,
+						    &fs_partition, 1);
+	if (part < 0)
+		return -1;
+
+	return fs_probe(fstype, part);
 }
 
 /* set current blk device w/ blk_desc + partition # */
 int fs_set_blk_dev_with_part(struct blk_desc *desc, int part)
 {
-	struct fstype_info *info;
-	int ret, i;
+	int ret;
 
 	if (part >= 1)
 		ret = part_get_info(desc, part, &fs_partition);
@@ -460,15 +581,7 @@ int fs_set_blk_dev_with_part(struct blk_desc *desc, int part)
 		return ret;
 	fs_dev_desc = desc;
 
-	for (i = 0, info = fstypes; i < ARRAY_SIZE(fstypes); i++, info++) {
-		if (!info->probe(fs_dev_desc, &fs_partition)) {
-			fs_type = info->fstype;
-			fs_dev_part = part;
-			return 0;
-		}
-	}
-
-	return -1;
+	return fs_probe(FS_TYPE_ANY, part);
 }
 
 void fs_close(void)
@@ -532,6 +645,7 @@ static int fs_read_lmb_check(const char *filename, ulong addr, loff_t offset,
 			     loff_t len, struct fstype_info *info)
 {
 	struct lmb lmb;
+	phys_addr_t base;
 	int ret;
 	loff_t size;
 	loff_t read_len;
@@ -553,7 +667,9 @@ static int fs_read_lmb_check(const char *filename, ulong addr, loff_t offset,
 	lmb_init_and_reserve(&lmb, gd->bd, (void *)gd->fdt_blob);
 	lmb_dump_all(&lmb);
 
-	if (lmb_alloc_addr(&lmb, addr, read_len) == addr)
+	base = lmb_alloc_addr(&lmb, addr, read_len);
+	lmb_uninit(&lmb);
+	if (base == addr)
 		return 0;
 
 	log_err("** Reading file would overwrite reserved memory **\n");
@@ -565,6 +681,7 @@ static int _fs_read(const char *filename, ulong addr, loff_t offset, loff_t len,
 		    int do_lmb_check, loff_t *actread)
 {
 	struct fstype_info *info = fs_get_info(fs_type);
+	ulong start_us;
 	void *buf;
 	int ret;
 
@@ -580,9 +697,14 @@ static int _fs_read(const char *filename, ulong addr, loff_t offset, loff_t len,
 	 * We don't actually know how many bytes are being read, since len==0
 	 * means read the whole file.
 	 */
+	bootstage_pipe_image(filename);
+	start_us = bootstage_pipe_start();
 	buf = map_sysmem(addr, len);
 	ret = info->read(filename, buf, offset, len, actread);
 	unmap_sysmem(buf);
+	if (!ret)
+		bootstage_pipe_end(BOOTSTAGE_PIPE_FS, start_us, *actread, 0);
+	bootstage_pipe_image(NULL);
 
 	/* If we requested a specific number of bytes, check we got it */
 	if (ret == 0 && len && *actread != len)
@@ -598,6 +720,94 @@ int fs_read(const char *filename, ulong addr, loff_t offset, loff_t len,
 	return _fs_read(filename, addr, offset, len, 0, actread);
 }
 
+/**
+ * struct fs_reader - reader for a file which is decompressed as it loads
+ *
+ * @rd: Image reader
+ * @filename: Name of file to read
+ * @type: Filesystem type (FS_TYPE_...) which holds the file
+ * @size: Size of the file in bytes
+ */
+struct fs_reader {
+	struct image_reader rd;
+	const char *filename;
+	int type;
+	loff_t size;
+};
+
+/* Set up the filesystem again, since each access closes it */
+static int fs_reader_reopen(struct fs_reader *frd)
+{
+	struct fstype_info *info = fs_get_info(frd->type);
+
+	if (info->probe(fs_dev_desc, &fs_partition))
+		return -EIO;
+	fs_type = frd->type;
+
+	return 0;
+}
+
+static long fs_reader_read(struct image_reader *rd, ulong offset, void *buf,
+			   ulong size)
+{
+	struct fs_reader *frd = container_of(rd, struct fs_reader, rd);
+	loff_t actread;
+	int ret;
+
+	if (offset >= frd->size)
+		return 0;
+	size = min_t(loff_t, size, frd->size - offset);
+
+	ret = fs_reader_reopen(frd);
+	if (ret)
+		return ret;
+	ret = fs_read(frd->filename, map_to_sysmem(buf), offset, size,
+		      &actread);
+	if (ret)
+		return -EIO;
+
+	return actread;
+}
+
+int fs_read_decomp(const char *filename, ulong addr, ulong maxlen,
+		   loff_t *actread)
+{
+	struct fs_reader frd;
+	u8 magic[2];
+	ulong len;
+	void *buf;
+	long nread;
+	int comp;
+	int ret;
+
+	frd.type = fs_type;
+	frd.filename = filename;
+	frd.rd.read = fs_reader_read;
+	ret = fs_size(filename, &frd.size);
+	if (ret)
+		return log_msg_ret("siz", -ENOENT);
+
+	nread = fs_reader_read(&frd.rd, 0, magic, sizeof(magic));
+	if (nread < 0)
+		return log_msg_ret("mag", nread);
+	comp = image_decomp_type(magic, nread);
+	if (comp < 0)
+		comp = IH_COMP_NONE;
+	log_debug("compression %s\n", genimg_get_comp_name(comp));
+
+	buf = map_sysmem(addr, maxlen);
+	ret = image_decomp_stream(comp, buf, maxlen, &frd.rd, &len);
+	unmap_sysmem(buf);
+	if (ret == -ENOSYS)
+		log_err("Cannot decompress %s while loading\n",
+			genimg_get_comp_name(comp));
+	if (ret)
+		return log_msg_ret("dec", ret);
+	*actread = len;
+
+	return 0;
+}
+
 int fs_write(const char *filename, ulong addr, loff_t offset, loff_t len,
 	     loff_t *actwrite)
 {
@@ -731,6 +941,21 @@ int do_size(struct cmd_tbl *cmdtp, int flag, int argc, char *const argv[],
 	return 0;
 }
 
+/* Work out how much space there is to decompress a file into, 0 if unknown */
+static ulong fs_load_space(ulong addr)
+{
+	struct lmb lmb;
+	ulong space;
+
+	if (!IS_ENABLED(CONFIG_LMB))
+		return 0;
+	lmb_init_and_reserve(&lmb, gd->bd, (void *)gd->fdt_blob);
+	space = lmb_get_free_size(&lmb, addr);
+	lmb_uninit(&lmb);
+
+	return space;
+}
+
 int do_load(struct cmd_tbl *cmdtp, int flag, int argc, char *const argv[],
 	    int fstype)
 {
@@ -740,13 +965,20 @@ int do_load(struct cmd_tbl *cmdtp, int flag, int argc, char *const argv[],
 	loff_t bytes;
 	loff_t pos;
 	loff_t len_read;
+	bool decomp = false;
 	int ret;
 	unsigned long time;
 	char *ep;
 
+	if (IS_ENABLED(CONFIG_CMD_LOAD_DECOMP) && argc >= 2 &&
+	    !strcmp(argv[1], "-d")) {
+		decomp = true;
+		argc--;
+		argv++;
+	}
 	if (argc < 2)
 		return CMD_RET_USAGE;
-	if (argc > 7)
+	if (argc > (decomp ? 6 : 7))
 		return CMD_RET_USAGE;
 
 	if (fs_set_blk_dev(argv[1], cmd_arg2(argc, argv), fstype)) {
@@ -783,8 +1015,27 @@ int do_load(struct cmd_tbl *cmdtp, int flag, int argc, char *const argv[],
 	else
 		pos = 0;
 
+	if (decomp) {
+		ulong space = fs_load_space(addr);
+
+		if (!bytes)
+			bytes = space;
+		if (!bytes) {
+			log_err("** No space to decompress into; give 'bytes' **\n");
+			return 1;
+		}
+		/* The output must not overwrite reserved memory either */
+		if (IS_ENABLED(CONFIG_LMB) && bytes > space) {
+			log_err("** Reading file would overwrite reserved memory **\n");
+			return 1;
+		}
+	}
+
 	time = get_timer(0);
-	ret = _fs_read(filename, addr, pos, bytes, 1, &len_read);
+	if (decomp)
+		ret = fs_read_decomp(filename, addr, bytes, &len_read);
+	else
+		ret = _fs_read(filename, addr, pos, bytes, 1, &len_read);
 	time = get_timer(time);
 	if (ret < 0) {
 		log_err("Failed to load '%s'\n", filename);
@@ -1001,7 +1252,8 @@ int fs_read_alloc(const char *fname, ulong size, uint align, void **bufp)
 	char *buf;
 	int ret;
 
-	buf = memalign(align, size + 1);
+	/* Keep the buffer aligned for DMA, so it can be read into directly */
+	buf = memalign(max_t(uint, align, ARCH_DMA_MINALIGN), size + 1);
 	if (!buf)
 		return log_msg_ret("buf", -ENOMEM);
 	addr = map_to_sysmem(buf);
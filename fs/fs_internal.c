@@ -13,6 +13,38 @@
 #include <part.h>
 #include <memalign.h>
 
+ulong fs_blk_dread(struct blk_desc *blk, lbaint_t start, lbaint_t blkcnt,
+		   void *buf)
+{
+	ulong shift = -(ulong)buf & (ARCH_DMA_MINALIGN - 1);
+	lbaint_t extra = DIV_ROUND_UP(shift, blk->blksz);
+	lbaint_t count;
+	lbaint_t i;
+
+	if (!shift)
+		return blk_dread(blk, start, blkcnt, buf);
+
+	/*
+	 * Read as many blocks as fit after the first aligned address in @buf
+	 * and move them into place, then bounce whatever is left over
+	 */
+	count = blkcnt > extra ? blkcnt - extra : 0;
+	if (count) {
+		if (blk_dread(blk, start, count, buf + shift) != count)
+			return 0;
+		memmove(buf, buf + shift, count * blk->blksz);
+	}
+	for (i = count; i < blkcnt; i++) {
+		ALLOC_CACHE_ALIGN_BUFFER(char, sec_buf, blk->blksz);
+
+		if (blk_dread(blk, start + i, 1, sec_buf) != 1)
+			return i;
+		memcpy(buf + i * blk->blksz, sec_buf, blk->blksz);
+	}
+
+	return blkcnt;
+}
+
 int fs_devread(struct blk_desc *blk, struct disk_partition *partition,
 	       lbaint_t sector, int byte_offset, int byte_len, char *buf)
 {
@@ -61,22 +93,21 @@ int fs_devread(struct blk_desc *blk, struct disk_partition *partition,
 	block_len = byte_len & ~(blk->blksz - 1);
 
 	if (block_len == 0) {
-		ALLOC_CACHE_ALIGN_BUFFER(u8, p, blk->blksz);
-
-		block_len = blk->blksz;
-		blk_dread(blk, partition->start + sector, 1,
-			  (void *)p);
-		memcpy(buf, p, byte_len);
+		if (blk_dread(blk, partition->start + sector, 1,
+			      (void *)sec_buf) != 1) {
+			log_err(" ** %s read error **\n", __func__);
+			return 0;
+		}
+		memcpy(buf, sec_buf, byte_len);
 		return 1;
 	}
 
-	if (blk_dread(blk, partition->start + sector,
-		      block_len >> log2blksz, (void *)buf) !=
+	if (fs_blk_dread(blk, partition->start + sector,
+			 block_len >> log2blksz, buf) !=
 			block_len >> log2blksz) {
 		log_err(" ** %s read error - block\n", __func__);
 		return 0;
 	}
-	block_len = byte_len & ~(blk->blksz - 1);
 	buf += block_len;
 	byte_len -= block_len;
 	sector += block_len / blk->blksz;
@@ -1258,13 +1258,18 @@ static u16 sum_get_unaligned16(u16 *ptr)
 /*
  * Process the stored summary information - helper function for
  * jffs2_sum_scan_sumnode()
+ *
+ * The first pass only checks that every entry is understood and lies within
+ * the summary, so that nothing is added to the lists unless the whole summary
+ * can be used. @max_totlen is updated with the largest node, as the scan does.
  */
 
 static int jffs2_sum_process_sum_data(struct part_info *part, uint32_t offset,
 				struct jffs2_raw_summary *summary,
-				struct b_lists *pL)
+				uint32_t sumsize, struct b_lists *pL,
+				u32 *max_totlen)
 {
-	void *sp;
+	void *sp, *end = (void *)summary + sumsize;
 	int i, pass;
 	struct b_node *b;
 
@@ -1275,9 +1280,14 @@ static int jffs2_sum_process_sum_data(struct part_info *part, uint32_t offset,
 			struct jffs2_sum_unknown_flash *spu = sp;
 			dbg_summary("processing summary index %d\n", i);
 
+			if (sp + sizeof(*spu) > end)
+				return -EBADMSG;
+
 			switch (sum_get_unaligned16(&spu->nodetype)) {
 				case JFFS2_NODETYPE_INODE: {
 				struct jffs2_sum_inode_flash *spi;
+					if (sp + JFFS2_SUMMARY_INODE_SIZE > end)
+						return -EBADMSG;
 					if (pass) {
 						spi = sp;
 
@@ -1293,6 +1303,9 @@ static int jffs2_sum_process_sum_data(struct part_info *part, uint32_t offset,
 						b->ino = sum_get_unaligned32(
 							&spi->inode);
 						b->datacrc = CRC_UNKNOWN;
+						*max_totlen = max(*max_totlen,
+							sum_get_unaligned32(
+								&spi->totlen));
 					}
 
 					sp += JFFS2_SUMMARY_INODE_SIZE;
@@ -1302,6 +1315,10 @@ static int jffs2_sum_process_sum_data(struct part_info *part, uint32_t offset,
 				case JFFS2_NODETYPE_DIRENT: {
 					struct jffs2_sum_dirent_flash *spd;
 					spd = sp;
+					if (sp + JFFS2_SUMMARY_DIRENT_SIZE(0) > end ||
+					    sp + JFFS2_SUMMARY_DIRENT_SIZE(
+							spd->nsize) > end)
+						return -EBADMSG;
 					if (pass) {
 						b = insert_node(&pL->dir);
 						if (!b)
@@ -1315,6 +1332,9 @@ static int jffs2_sum_process_sum_data(struct part_info *part, uint32_t offset,
 						b->pino = sum_get_unaligned32(
 							&spd->pino);
 						b->datacrc = CRC_UNKNOWN;
+						*max_totlen = max(*max_totlen,
+							sum_get_unaligned32(
+								&spd->totlen));
 					}
 
 					sp += JFFS2_SUMMARY_DIRENT_SIZE(
@@ -1340,9 +1360,10 @@ static int jffs2_sum_process_sum_data(struct part_info *part, uint32_t offset,
 }
 
 /* Process the summary node - called from jffs2_scan_eraseblock() */
-int jffs2_sum_scan_sumnode(struct part_info *part, uint32_t offset,
-			   struct jffs2_raw_summary *summary, uint32_t sumsize,
-			   struct b_lists *pL)
+static int jffs2_sum_scan_sumnode(struct part_info *part, uint32_t offset,
+				  struct jffs2_raw_summary *summary,
+				  uint32_t sumsize, struct b_lists *pL,
+				  u32 *max_totlen)
 {
 	struct jffs2_unknown_node crcnode;
 	int ret, __maybe_unused ofs;
@@ -1389,7 +1410,8 @@ int jffs2_sum_scan_sumnode(struct part_info *part, uint32_t offset,
 	if (summary->cln_mkr)
 		dbg_summary("Summary : CLEANMARKER node \n");
 
-	ret = jffs2_sum_process_sum_data(part, offset, summary, pL);
+	ret = jffs2_sum_process_sum_data(part, offset, summary, sumsize, pL,
+					 max_totlen);
 	if (ret == -EBADMSG)
 		return 0;
 	if (ret)
@@ -1534,7 +1556,11 @@ jffs2_1pass_build_lists(struct part_info * part)
 				buf_len, buf_len, buf + buf_size - buf_len);
 
 		sm = (void *)buf + buf_size - sizeof(*sm);
-		if (sm->magic == JFFS2_SUM_MAGIC) {
+		/* Ignore a marker which does not point inside the sector */
+		if (sm->magic == JFFS2_SUM_MAGIC &&
+		    sm->offset < part->sector_size &&
+		    part->sector_size - sm->offset >=
+				JFFS2_SUMMARY_FRAME_SIZE) {
 			sumlen = part->sector_size - sm->offset;
 			sumptr = buf + buf_size - sumlen;
 
@@ -1564,7 +1590,7 @@ jffs2_1pass_build_lists(struct part_info * part)
 
 		if (sumptr) {
 			ret = jffs2_sum_scan_sumnode(part, sector_ofs, sumptr,
-					sumlen, pL);
+					sumlen, pL, &max_totlen);
 
 			if (buf_size && sumlen > buf_size)
 				free(sumptr);
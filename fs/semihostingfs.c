@@ -8,9 +8,64 @@
 #include <fs.h>
 #include <malloc.h>
 #include <os.h>
+#include <string.h>
 #include <semihosting.h>
 #include <semihostingfs.h>
 
+/*
+ * Each semihosting call traps to the debugger, which can take milliseconds on
+ * a simulator or FPGA model. A load asks for the size of the file and then
+ * reads it, so keep the file open in between rather than opening it twice.
+ * The file is closed by smh_fs_close() at the end of each filesystem
+ * operation, so a file rebuilt on the host is picked up by the next command.
+ */
+static struct {
+	char name[256];
+	long fd;
+	long size;
+	long pos;
+} smh_cache = { .fd = -1 };
+
+void smh_fs_close(void)
+{
+	if (smh_cache.fd >= 0)
+		smh_close(smh_cache.fd);
+	smh_cache.fd = -1;
+}
+
+/**
+ * smh_fs_open() - Open a file for reading, using the cache if possible
+ *
+ * @filename: Name of file to open
+ * Return: file descriptor, or -ve on error
+ */
+static long smh_fs_open(const char *filename)
+{
+	long fd, size;
+
+	if (smh_cache.fd >= 0 && !strcmp(filename, smh_cache.name))
+		return smh_cache.fd;
+
+	smh_fs_close();
+	fd = smh_open(filename, MODE_READ | MODE_BINARY);
+	if (fd < 0)
+		return fd;
+	size = smh_flen(fd);
+	if (size < 0) {
+		smh_close(fd);
+		return size;
+	}
+
+	if (strlen(filename) < sizeof(smh_cache.name)) {
+		strcpy(smh_cache.name, filename);
+		smh_cache.fd = fd;
+		smh_cache.size = size;
+		smh_cache.pos = 0;
+	}
+
+	return fd;
+}
+
 int smh_fs_set_blk_dev(struct blk_desc *rbdd, struct disk_partition *info)
 {
 	/*
@@ -24,32 +79,61 @@ static int smh_fs_read_at(const char *filename, loff_t pos, void *buffer,
 			  loff_t maxsize, loff_t *actread)
 {
 	long fd, size, ret;
+	bool cached;
+	loff_t done;
 
-	fd = smh_open(filename, MODE_READ | MODE_BINARY);
+	fd = smh_fs_open(filename);
 	if (fd < 0)
 		return fd;
-	ret = smh_seek(fd, pos);
-	if (ret < 0) {
-		smh_close(fd);
-		return ret;
+	cached = fd == smh_cache.fd;
+
+	if (!cached || pos != smh_cache.pos) {
+		ret = smh_seek(fd, pos);
+		if (ret < 0)
+			goto err;
 	}
 	if (!maxsize) {
-		size = smh_flen(fd);
-		if (ret < 0) {
-			smh_close(fd);
-			return size;
+		if (cached) {
+			size = smh_cache.size;
+		} else {
+			size = smh_flen(fd);
+			if (size < 0) {
+				ret = size;
+				goto err;
+			}
 		}
 
-		maxsize = size;
+		maxsize = size - pos;
 	}
 
-	size = smh_read(fd, buffer, maxsize);
-	smh_close(fd);
-	if (size < 0)
-		return size;
+	/*
+	 * Read straight into the caller's buffer in as few calls as possible.
+	 * The host may return less than was asked for, so carry on until the
+	 * end of the file.
+	 */
+	for (done = 0; done < maxsize; done += size) {
+		size = smh_read(fd, buffer + done, maxsize - done);
+		if (size < 0) {
+			ret = size;
+			goto err;
+		}
+		if (!size)
+			break;
+	}
+	if (cached)
+		smh_cache.pos = pos + done;
+	else
+		smh_close(fd);
 
-	*actread = size;
+	*actread = done;
 	return 0;
+
+err:
+	if (cached)
+		smh_fs_close();
+	else
+		smh_close(fd);
+	return ret;
 }
 
 static int smh_fs_write_at(const char *filename, loff_t pos, void *buffer,
@@ -57,6 +141,9 @@ static int smh_fs_write_at(const char *filename, loff_t pos, void *buffer,
 {
 	long fd, size, ret;
 
+	/* The cached size and position would be wrong after this */
+	smh_fs_close();
+
 	/* Try to open existing file */
 	fd = smh_open(filename, MODE_READ | MODE_BINARY | MODE_PLUS);
 	if (fd < 0)
@@ -80,15 +167,18 @@ int smh_fs_size(const char *filename, loff_t *result)
 {
 	long fd, size;
 
-	fd = smh_open(filename, MODE_READ | MODE_BINARY);
+	fd = smh_fs_open(filename);
 	if (fd < 0)
 		return fd;
 
-	size = smh_flen(fd);
-	smh_close(fd);
-
-	if (size < 0)
-		return size;
+	if (fd == smh_cache.fd) {
+		size = smh_cache.size;
+	} else {
+		size = smh_flen(fd);
+		smh_close(fd);
+		if (size < 0)
+			return size;
+	}
 
 	*result = size;
 	return 0;
@@ -93,6 +93,99 @@ static int sqfs_calc_n_blks(__le64 start, __le64 end, u64 *offset)
 	return DIV_ROUND_UP(table_size + *offset, ctxt.cur_dev->blksz);
 }
 
+/*
+ * A table stored as a series of metadata blocks, e.g. the inode table. Its raw
+ * contents are only read from disk if a block is missing from the metadata
+ * cache.
+ */
+struct sqfs_table {
+	u64 start;
+	u64 end;
+	unsigned char *raw;
+	u64 offset;
+};
+
+static int sqfs_table_load(struct sqfs_table *table)
+{
+	u64 n_blks;
+
+	if (table->raw)
+		return 0;
+
+	n_blks = sqfs_calc_n_blks(cpu_to_le64(table->start),
+				  cpu_to_le64(table->end), &table->offset);
+	table->raw = malloc_cache_aligned(n_blks * ctxt.cur_dev->blksz);
+	if (!table->raw)
+		return -ENOMEM;
+
+	if (sqfs_disk_read(lldiv(table->start, ctxt.cur_dev->blksz), n_blks,
+			   table->raw) < 0) {
+		free(table->raw);
+		table->raw = NULL;
+		return -EINVAL;
+	}
+
+	return 0;
+}
+
+/*
+ * Get the metadata block of @table at byte offset @pos of the filesystem,
+ * from the cache if possible. The block is decompressed into @dest, which
+ * holds SQFS_METADATA_BLOCK_SIZE bytes, and its decompressed size is returned
+ * in @sizep. If @dest is NULL, only the size of the block on disk, which is
+ * always returned in @disk_sizep, is looked up.
+ */
+static int sqfs_table_block(struct sqfs_table *table, u64 pos, void *dest,
+			    u32 *sizep, u32 *disk_sizep)
+{
+	unsigned long dest_len = SQFS_METADATA_BLOCK_SIZE;
+	unsigned char *src;
+	u32 src_len, size;
+	bool compressed;
+	void *data;
+	int ret;
+
+	data = sqfs_cache_find(&ctxt.meta_cache, pos, &size, disk_sizep);
+	if (data) {
+		if (dest) {
+			memcpy(dest, data, size);
+			*sizep = size;
+		}
+		return 0;
+	}
+
+	ret = sqfs_table_load(table);
+	if (ret)
+		return ret;
+
+	if (pos < table->start || pos + SQFS_HEADER_SIZE > table->end)
+		return -EINVAL;
+	ret = sqfs_read_metablock(table->raw,
+				  table->offset + pos - table->start,
+				  &compressed, &src_len);
+	if (ret || pos + SQFS_HEADER_SIZE + src_len > table->end)
+		return -EINVAL;
+
+	*disk_sizep = src_len + SQFS_HEADER_SIZE;
+	if (!dest)
+		return 0;
+
+	src = table->raw + table->offset + pos - table->start +
+		SQFS_HEADER_SIZE;
+	if (compressed) {
+		ret = sqfs_decompress(&ctxt, dest, &dest_len, src, src_len);
+		if (ret)
+			return -EINVAL;
+	} else {
+		memcpy(dest, src, src_len);
+		dest_len = src_len;
+	}
+	*sizep = dest_len;
+	sqfs_cache_add(&ctxt.meta_cache, pos, *disk_sizep, dest, dest_len);
+
+	return 0;
+}
+
 /*
  * Retrieves fragment block entry and returns true if the fragment block is
  * compressed
@@ -100,15 +193,14 @@ static int sqfs_calc_n_blks(__le64 start, __le64 end, u64 *offset)
 static int sqfs_frag_lookup(u32 inode_fragment_index,
 			    struct squashfs_fragment_block_entry *e)
 {
-	u64 start, end, exp_tbl, n_blks, src_len, table_offset, start_block;
-	unsigned char *metadata_buffer, *metadata, *table;
+	u64 start, end, exp_tbl, n_blks, table_offset, start_block;
 	struct squashfs_fragment_block_entry *entries;
 	struct squashfs_super_block *sblk = ctxt.sblk;
-	unsigned long dest_len;
+	struct sqfs_table meta = { };
+	unsigned char *table;
 	int block, offset, ret;
-	u16 header;
+	u32 size, disk_size;
 
-	metadata_buffer = NULL;
 	entries = NULL;
 	table = NULL;
 
@@ -149,47 +241,18 @@ static int sqfs_frag_lookup(u32 inode_fragment_index,
 	start_block = get_unaligned_le64(table + table_offset + block *
 					 sizeof(u64));
 
-	start = start_block / ctxt.cur_dev->blksz;
-	n_blks = sqfs_calc_n_blks(cpu_to_le64(start_block),
-				  sblk->fragment_table_start, &table_offset);
-
-	metadata_buffer = malloc_cache_aligned(n_blks * ctxt.cur_dev->blksz);
-	if (!metadata_buffer) {
-		ret = -ENOMEM;
-		goto out;
-	}
-
-	if (sqfs_disk_read(start, n_blks, metadata_buffer) < 0) {
-		ret = -EINVAL;
-		goto out;
-	}
-
-	/* Every metadata block starts with a 16-bit header */
-	header = get_unaligned_le16(metadata_buffer + table_offset);
-	metadata = metadata_buffer + table_offset + SQFS_HEADER_SIZE;
-
-	if (!metadata || !header) {
-		ret = -ENOMEM;
-		goto out;
-	}
-
 	entries = malloc(SQFS_METADATA_BLOCK_SIZE);
 	if (!entries) {
 		ret = -ENOMEM;
 		goto out;
 	}
 
-	if (SQFS_COMPRESSED_METADATA(header)) {
-		src_len = SQFS_METADATA_SIZE(header);
-		dest_len = SQFS_METADATA_BLOCK_SIZE;
-		ret = sqfs_decompress(&ctxt, entries, &dest_len, metadata,
-				      src_len);
-		if (ret) {
-			ret = -EINVAL;
-			goto out;
-		}
-	} else {
-		memcpy(entries, metadata, SQFS_METADATA_SIZE(header));
+	meta.start = start_block;
+	meta.end = get_unaligned_le64(&sblk->fragment_table_start);
+	ret = sqfs_table_block(&meta, start_block, entries, &size, &disk_size);
+	if (ret || (offset + 1) * sizeof(*entries) > size) {
+		ret = -EINVAL;
+		goto out;
 	}
 
 	*e = entries[offset];
@@ -197,7 +260,7 @@ static int sqfs_frag_lookup(u32 inode_fragment_index,
 
 out:
 	free(entries);
-	free(metadata_buffer);
+	free(meta.raw);
 	free(table);
 
 	return ret;
@@ -288,55 +351,29 @@ static int sqfs_join(char **strings, char *dest, int start, int end,
 }
 
 /*
- * Fills the given token list using its size (count) and a source string (str)
+ * Allocates a token list of the given size (count) in the arena and fills it
+ * from a source string (str). The tokens are split in place in a copy of str,
+ * also held in the arena, so nothing needs to be freed apart from releasing
+ * the arena.
  */
-static int sqfs_tokenize(char **tokens, int count, const char *str)
+static char **sqfs_tokenize(int count, const char *str)
 {
-	int i, j, ret = 0;
-	char *aux, *strc;
+	char **tokens, *strc;
+	int j;
 
-	strc = strdup(str);
-	if (!strc)
-		return -ENOMEM;
+	tokens = arena_alloc(&ctxt.arena, count * sizeof(char *));
+	strc = arena_strdup(&ctxt.arena, str);
+	if (!tokens || !strc)
+		return NULL;
 
 	if (!strcmp(strc, "/")) {
-		tokens[0] = strdup(strc);
-		if (!tokens[0]) {
-			ret = -ENOMEM;
-			goto free_strc;
-		}
+		tokens[0] = strc;
 	} else {
-		for (j = 0; j < count; j++) {
-			aux = strtok(!j ? strc : NULL, "/");
-			tokens[j] = strdup(aux);
-			if (!tokens[j]) {
-				for (i = 0; i < j; i++)
-					free(tokens[i]);
-				ret = -ENOMEM;
-				goto free_strc;
-			}
-		}
+		for (j = 0; j < count; j++)
+			tokens[j] = strtok(!j ? strc : NULL, "/");
 	}
 
-free_strc:
-	free(strc);
-
-	return ret;
-}
-
-/*
- * Remove last 'updir + 1' tokens from the base path tokens list. This leaves us
- * with a token list containing only the tokens needed to form the resolved
- * path, and returns the decremented size of the token list.
- */
-static int sqfs_clean_base_path(char **base, int count, int updir)
-{
-	int i;
-
-	for (i = count - updir - 1; i < count; i++)
-		free(base[i]);
-
-	return count - updir - 1;
+	return tokens;
 }
 
 /*
@@ -345,33 +382,20 @@ static int sqfs_clean_base_path(char **base, int count, int updir)
  */
 static char *sqfs_get_abs_path(const char *base, const char *rel)
 {
+	int bc, rc, i, updir = 0, resolved_size = 0, offset = 0;
 	char **base_tokens, **rel_tokens, *resolved = NULL;
-	int ret, bc, rc, i, updir = 0, resolved_size = 0, offset = 0;
-
-	base_tokens = NULL;
-	rel_tokens = NULL;
+	struct arena_mark mark;
 
-	/* Memory allocation for the token lists */
 	bc = sqfs_count_tokens(base);
 	rc = sqfs_count_tokens(rel);
 	if (bc < 1 || rc < 1)
 		return NULL;
 
-	base_tokens = calloc(bc, sizeof(char *));
-	if (!base_tokens)
-		return NULL;
-
-	rel_tokens = calloc(rc, sizeof(char *));
-	if (!rel_tokens)
-		goto out;
-
 	/* Fill token lists */
-	ret = sqfs_tokenize(base_tokens, bc, base);
-	if (ret)
-		goto out;
-
-	ret = sqfs_tokenize(rel_tokens, rc, rel);
-	if (ret)
+	mark = arena_begin(&ctxt.arena);
+	base_tokens = sqfs_tokenize(bc, base);
+	rel_tokens = sqfs_tokenize(rc, rel);
+	if (!base_tokens || !rel_tokens)
 		goto out;
 
 	/* count '..' occurrences in target path */
@@ -380,8 +404,8 @@ static char *sqfs_get_abs_path(const char *base, const char *rel)
 			updir++;
 	}
 
-	/* Remove the last token and the '..' occurrences */
-	bc = sqfs_clean_base_path(base_tokens, bc, updir);
+	/* Drop the last token and the '..' occurrences from the base path */
+	bc -= updir + 1;
 	if (bc < 0)
 		goto out;
 
@@ -403,15 +427,7 @@ static char *sqfs_get_abs_path(const char *base, const char *rel)
 	offset += sqfs_join(rel_tokens, resolved + offset, updir, rc, '/');
 
 out:
-	if (rel_tokens)
-		for (i = 0; i < rc; i++)
-			free(rel_tokens[i]);
-	if (base_tokens)
-		for (i = 0; i < bc; i++)
-			free(base_tokens[i]);
-
-	free(rel_tokens);
-	free(base_tokens);
+	arena_release(&ctxt.arena, mark);
 
 	return resolved;
 }
@@ -567,18 +583,12 @@ static int sqfs_search_dir(struct squashfs_dir_stream *dirs, char **token_list,
 				goto out;
 			}
 
-			sym_tokens = malloc(token_count * sizeof(char *));
+			/* Fill tokens list, released by sqfs_opendir() */
+			sym_tokens = sqfs_tokenize(token_count, res);
 			if (!sym_tokens) {
 				ret = -EINVAL;
 				goto out;
 			}
-
-			/* Fill tokens list */
-			ret = sqfs_tokenize(sym_tokens, token_count, res);
-			if (ret) {
-				ret = -EINVAL;
-				goto out;
-			}
 			free(dirs->entry);
 			dirs->entry = NULL;
 
@@ -635,58 +645,72 @@ out:
 	free(rem);
 	free(path);
 	free(target);
-	free(sym_tokens);
 	return ret;
 }
 
 /*
- * Inode and directory tables are stored as a series of metadata blocks, and
- * given the compressed size of this table, we can calculate how much metadata
- * blocks are needed to store the result of the decompression, since a
- * decompressed metadata block should have a size of 8KiB.
+ * Decompress the table of metadata blocks which lies between byte offsets
+ * @start and @end of the filesystem. Each block takes up
+ * SQFS_METADATA_BLOCK_SIZE bytes of the result, returned in @tablep.
+ *
+ * If @pos_listp is not NULL, it returns a list of the positions, relative to
+ * @start, where each block ends. This is used to find an entry in the
+ * directory table from the reference (index and offset) in its inode.
+ *
+ * Returns the number of metadata blocks, or a negative error code.
  */
-static int sqfs_count_metablks(void *table, u32 offset, int table_size)
+static int sqfs_read_table(u64 start, u64 end, unsigned char **tablep,
+			   u32 **pos_listp)
 {
-	int count = 0, cur_size = 0, ret;
-	u32 data_size;
-	bool comp;
+	struct sqfs_table table = { .start = start, .end = end };
+	unsigned char *dest = NULL;
+	u32 *pos_list = NULL;
+	u32 size, disk_size;
+	int j, ret, count = 0;
+	u64 pos;
 
-	do {
-		ret = sqfs_read_metablock(table, offset + cur_size, &comp,
-					  &data_size);
+	/* Calculate size to store the whole decompressed table */
+	for (pos = start; pos < end; pos += disk_size, count++) {
+		ret = sqfs_table_block(&table, pos, NULL, NULL, &disk_size);
 		if (ret)
-			return -EINVAL;
-		cur_size += data_size + SQFS_HEADER_SIZE;
-		count++;
-	} while (cur_size < table_size);
-
-	return count;
-}
-
-/*
- * Storing the metadata blocks header's positions will be useful while looking
- * for an entry in the directory table, using the reference (index and offset)
- * given by its inode.
- */
-static int sqfs_get_metablk_pos(u32 *pos_list, void *table, u32 offset,
-				int metablks_count)
-{
-	u32 data_size, cur_size = 0;
-	int j, ret = 0;
-	bool comp;
+			goto out;
+	}
+	if (!count) {
+		ret = -EINVAL;
+		goto out;
+	}
 
-	if (!metablks_count)
-		return -EINVAL;
+	dest = kcalloc(count, SQFS_METADATA_BLOCK_SIZE, GFP_KERNEL);
+	if (pos_listp)
+		pos_list = malloc(count * sizeof(u32));
+	if (!dest || (pos_listp && !pos_list)) {
+		printf("Error: failed to allocate squashfs table of size %i, increasing CONFIG_SYS_MALLOC_LEN could help\n",
+		       count * SQFS_METADATA_BLOCK_SIZE);
+		ret = -ENOMEM;
+		goto out;
+	}
 
-	for (j = 0; j < metablks_count; j++) {
-		ret = sqfs_read_metablock(table, offset + cur_size, &comp,
-					  &data_size);
+	for (j = 0, pos = start; j < count; j++, pos += disk_size) {
+		ret = sqfs_table_block(&table, pos,
+				       dest + j * SQFS_METADATA_BLOCK_SIZE,
+				       &size, &disk_size);
 		if (ret)
-			return -EINVAL;
+			goto out;
+		if (pos_list)
+			pos_list[j] = pos + disk_size - start;
+	}
+
+	*tablep = dest;
+	if (pos_listp)
+		*pos_listp = pos_list;
+	ret = count;
 
-		cur_size += data_size + SQFS_HEADER_SIZE;
-		pos_list[j] = cur_size;
+out:
+	if (ret < 0) {
+		free(dest);
+		free(pos_list);
 	}
+	free(table.raw);
 
 	return ret;
 }
@@ -694,202 +718,45 @@ static int sqfs_get_metablk_pos(u32 *pos_list, void *table, u32 offset,
 static int sqfs_read_inode_table(unsigned char **inode_table)
 {
 	struct squashfs_super_block *sblk = ctxt.sblk;
-	u64 start, n_blks, table_offset, table_size;
-	int j, ret = 0, metablks_count;
-	unsigned char *src_table, *itb;
-	u32 src_len, dest_offset = 0;
-	unsigned long dest_len = 0;
-	bool compressed;
-
-	table_size = get_unaligned_le64(&sblk->directory_table_start) -
-		get_unaligned_le64(&sblk->inode_table_start);
-	start = get_unaligned_le64(&sblk->inode_table_start) /
-		ctxt.cur_dev->blksz;
-	n_blks = sqfs_calc_n_blks(sblk->inode_table_start,
-				  sblk->directory_table_start, &table_offset);
-
-	/* Allocate a proper sized buffer (itb) to store the inode table */
-	itb = malloc_cache_aligned(n_blks * ctxt.cur_dev->blksz);
-	if (!itb)
-		return -ENOMEM;
-
-	if (sqfs_disk_read(start, n_blks, itb) < 0) {
-		ret = -EINVAL;
-		goto free_itb;
-	}
-
-	/* Parse inode table (metadata block) header */
-	ret = sqfs_read_metablock(itb, table_offset, &compressed, &src_len);
-	if (ret) {
-		ret = -EINVAL;
-		goto free_itb;
-	}
-
-	/* Calculate size to store the whole decompressed table */
-	metablks_count = sqfs_count_metablks(itb, table_offset, table_size);
-	if (metablks_count < 1) {
-		ret = -EINVAL;
-		goto free_itb;
-	}
-
-	*inode_table = kcalloc(metablks_count, SQFS_METADATA_BLOCK_SIZE,
-			       GFP_KERNEL);
-	if (!*inode_table) {
-		ret = -ENOMEM;
-		printf("Error: failed to allocate squashfs inode_table of size %i, increasing CONFIG_SYS_MALLOC_LEN could help\n",
-		       metablks_count * SQFS_METADATA_BLOCK_SIZE);
-		goto free_itb;
-	}
-
-	src_table = itb + table_offset + SQFS_HEADER_SIZE;
-
-	/* Extract compressed Inode table */
-	for (j = 0; j < metablks_count; j++) {
-		sqfs_read_metablock(itb, table_offset, &compressed, &src_len);
-		if (compressed) {
-			dest_len = SQFS_METADATA_BLOCK_SIZE;
-			ret = sqfs_decompress(&ctxt, *inode_table +
-					      dest_offset, &dest_len,
-					      src_table, src_len);
-			if (ret) {
-				free(*inode_table);
-				*inode_table = NULL;
-				goto free_itb;
-			}
-
-			dest_offset += dest_len;
-		} else {
-			memcpy(*inode_table + (j * SQFS_METADATA_BLOCK_SIZE),
-			       src_table, src_len);
-		}
-
-		/*
-		 * Offsets to the decompression destination, to the metadata
-		 * buffer 'itb' and to the decompression source, respectively.
-		 */
-
-		table_offset += src_len + SQFS_HEADER_SIZE;
-		src_table += src_len + SQFS_HEADER_SIZE;
-	}
+	int ret;
 
-free_itb:
-	free(itb);
+	ret = sqfs_read_table(get_unaligned_le64(&sblk->inode_table_start),
+			      get_unaligned_le64(&sblk->directory_table_start),
+			      inode_table, NULL);
 
-	return ret;
+	return ret < 0 ? ret : 0;
 }
 
 static int sqfs_read_directory_table(unsigned char **dir_table, u32 **pos_list)
 {
-	u64 start, n_blks, table_offset, table_size;
 	struct squashfs_super_block *sblk = ctxt.sblk;
-	int j, ret = 0, metablks_count = -1;
-	unsigned char *src_table, *dtb;
-	u32 src_len, dest_offset = 0;
-	unsigned long dest_len = 0;
-	bool compressed;
+	int ret;
 
 	*dir_table = NULL;
 	*pos_list = NULL;
-	/* DIRECTORY TABLE */
-	table_size = get_unaligned_le64(&sblk->fragment_table_start) -
-		get_unaligned_le64(&sblk->directory_table_start);
-	start = get_unaligned_le64(&sblk->directory_table_start) /
-		ctxt.cur_dev->blksz;
-	n_blks = sqfs_calc_n_blks(sblk->directory_table_start,
-				  sblk->fragment_table_start, &table_offset);
-
-	/* Allocate a proper sized buffer (dtb) to store the directory table */
-	dtb = malloc_cache_aligned(n_blks * ctxt.cur_dev->blksz);
-	if (!dtb)
-		return -ENOMEM;
-
-	if (sqfs_disk_read(start, n_blks, dtb) < 0)
-		goto out;
-
-	/* Parse directory table (metadata block) header */
-	ret = sqfs_read_metablock(dtb, table_offset, &compressed, &src_len);
-	if (ret)
-		goto out;
-
-	/* Calculate total size to store the whole decompressed table */
-	metablks_count = sqfs_count_metablks(dtb, table_offset, table_size);
-	if (metablks_count < 1)
-		goto out;
-
-	*dir_table = malloc(metablks_count * SQFS_METADATA_BLOCK_SIZE);
-	if (!*dir_table)
-		goto out;
-
-	*pos_list = malloc(metablks_count * sizeof(u32));
-	if (!*pos_list)
-		goto out;
-
-	ret = sqfs_get_metablk_pos(*pos_list, dtb, table_offset,
-				   metablks_count);
-	if (ret) {
-		metablks_count = -1;
-		goto out;
-	}
+	ret = sqfs_read_table(get_unaligned_le64(&sblk->directory_table_start),
+			      get_unaligned_le64(&sblk->fragment_table_start),
+			      dir_table, pos_list);
 
-	src_table = dtb + table_offset + SQFS_HEADER_SIZE;
-
-	/* Extract compressed Directory table */
-	dest_offset = 0;
-	for (j = 0; j < metablks_count; j++) {
-		sqfs_read_metablock(dtb, table_offset, &compressed, &src_len);
-		if (compressed) {
-			dest_len = SQFS_METADATA_BLOCK_SIZE;
-			ret = sqfs_decompress(&ctxt, *dir_table +
-					      (j * SQFS_METADATA_BLOCK_SIZE),
-					      &dest_len, src_table, src_len);
-			if (ret) {
-				metablks_count = -1;
-				goto out;
-			}
-
-			if (dest_len < SQFS_METADATA_BLOCK_SIZE) {
-				dest_offset += dest_len;
-				break;
-			}
-
-			dest_offset += dest_len;
-		} else {
-			memcpy(*dir_table + (j * SQFS_METADATA_BLOCK_SIZE),
-			       src_table, src_len);
-		}
-
-		/*
-		 * Offsets to the decompression destination, to the metadata
-		 * buffer 'dtb' and to the decompression source, respectively.
-		 */
-		table_offset += src_len + SQFS_HEADER_SIZE;
-		src_table += src_len + SQFS_HEADER_SIZE;
-	}
-
-out:
-	if (metablks_count < 1) {
-		free(*dir_table);
-		free(*pos_list);
-		*dir_table = NULL;
-		*pos_list = NULL;
-	}
-	free(dtb);
-
-	return metablks_count;
+	return ret < 0 ? -1 : ret;
 }
 
 int sqfs_opendir(const char *filename, struct fs_dir_stream **dirsp)
 {
 	unsigned char *inode_table = NULL, *dir_table = NULL;
-	int j, token_count = 0, ret = 0, metablks_count;
+	int token_count = 0, ret = 0, metablks_count;
 	struct squashfs_dir_stream *dirs;
-	char **token_list = NULL, *path = NULL;
+	struct arena_mark mark;
 	u32 *pos_list = NULL;
+	char **token_list;
 
 	dirs = calloc(1, sizeof(*dirs));
 	if (!dirs)
 		return -EINVAL;
 
+	/* All token lists for this lookup, including symlinks, go here */
+	mark = arena_begin(&ctxt.arena);
+
 	/* these should be set to NULL to prevent dangling pointers */
 	dirs->dir_header = NULL;
 	dirs->entry = NULL;
@@ -916,22 +783,12 @@ int sqfs_opendir(const char *filename, struct fs_dir_stream **dirsp)
 		goto out;
 	}
 
-	path = strdup(filename);
-	if (!path) {
-		ret = -EINVAL;
-		goto out;
-	}
-
-	token_list = malloc(token_count * sizeof(char *));
+	/* Fill tokens list */
+	token_list = sqfs_tokenize(token_count, filename);
 	if (!token_list) {
-		ret = -EINVAL;
+		ret = -ENOMEM;
 		goto out;
 	}
-
-	/* Fill tokens list */
-	ret = sqfs_tokenize(token_list, token_count, path);
-	if (ret)
-		goto out;
 	/*
 	 * ldir's (extended directory) size is greater than dir, so it works as
 	 * a general solution for the malloc size, since 'i' is a union.
@@ -960,11 +817,8 @@ int sqfs_opendir(const char *filename, struct fs_dir_stream **dirsp)
 	*dirsp = (struct fs_dir_stream *)dirs;
 
 out:
-	for (j = 0; j < token_count; j++)
-		free(token_list[j]);
-	free(token_list);
+	arena_release(&ctxt.arena, mark);
 	free(pos_list);
-	free(path);
 	if (ret) {
 		free(inode_table);
 		free(dirs);
@@ -1088,6 +942,34 @@ int sqfs_readdir(struct fs_dir_stream *fs_dirs, struct fs_dirent **dentp)
 	return 0;
 }
 
+/*
+ * The caches outlive sqfs_close(), so that a series of commands on the same
+ * filesystem does not decompress the same blocks over and over. They are
+ * dropped when a different filesystem is probed, which is detected using the
+ * device, the partition and the superblock, the latter including the time the
+ * filesystem was created.
+ */
+static void sqfs_check_cache(struct squashfs_super_block *sblk)
+{
+	if (ctxt.cache_dev == ctxt.cur_dev &&
+	    ctxt.cache_part_start == ctxt.cur_part_info.start &&
+	    !memcmp(&ctxt.cache_sblk, sblk, sizeof(*sblk)))
+		return;
+
+	sqfs_cache_flush(&ctxt.meta_cache);
+	sqfs_cache_flush(&ctxt.frag_cache);
+	ctxt.cache_dev = ctxt.cur_dev;
+	ctxt.cache_part_start = ctxt.cur_part_info.start;
+	ctxt.cache_sblk = *sblk;
+
+	sqfs_cache_setup(&ctxt.meta_cache,
+			 CONFIG_FS_SQUASHFS_METADATA_CACHE,
+			 SQFS_METADATA_BLOCK_SIZE);
+	sqfs_cache_setup(&ctxt.frag_cache,
+			 CONFIG_FS_SQUASHFS_FRAGMENT_CACHE,
+			 get_unaligned_le32(&sblk->block_size));
+}
+
 int sqfs_probe(struct blk_desc *fs_dev_desc, struct disk_partition *fs_partition)
 {
 	struct squashfs_super_block *sblk;
@@ -1108,6 +990,7 @@ int sqfs_probe(struct blk_desc *fs_dev_desc, struct disk_partition *fs_partition
 	}
 
 	ctxt.sblk = sblk;
+	sqfs_check_cache(sblk);
 
 	ret = sqfs_decompressor_init(&ctxt);
 	if (ret) {
@@ -1322,6 +1205,7 @@ int sqfs_read(const char *filename, void *buf, loff_t offset, loff_t len,
 {
 	char *dir = NULL, *fragment_block, *datablock = NULL;
 	char *fragment = NULL, *file = NULL, *resolved, *data;
+	char *frag_buf = NULL;
 	u64 start, n_blks, table_size, data_offset, table_offset, sparse_size;
 	int ret, j, i_number, datablk_count = 0;
 	struct squashfs_super_block *sblk = ctxt.sblk;
@@ -1336,6 +1220,7 @@ int sqfs_read(const char *filename, void *buf, loff_t offset, loff_t len,
 	unsigned long dest_len;
 	struct fs_dirent *dent;
 	unsigned char *ipos;
+	u32 frag_len;
 
 	*actread = 0;
 
@@ -1526,52 +1411,63 @@ int sqfs_read(const char *filename, void *buf, loff_t offset, loff_t len,
 		goto out;
 	}
 
-	start = lldiv(frag_entry.start, ctxt.cur_dev->blksz);
 	table_size = SQFS_BLOCK_SIZE(frag_entry.size);
-	table_offset = frag_entry.start - (start * ctxt.cur_dev->blksz);
-	n_blks = DIV_ROUND_UP(table_size + table_offset, ctxt.cur_dev->blksz);
-
-	fragment = malloc_cache_aligned(n_blks * ctxt.cur_dev->blksz);
-
-	if (!fragment) {
-		ret = -ENOMEM;
-		goto out;
-	}
+	fragment_block = sqfs_cache_find(&ctxt.frag_cache, frag_entry.start,
+					 &frag_len, NULL);
+	if (!fragment_block) {
+		start = lldiv(frag_entry.start, ctxt.cur_dev->blksz);
+		table_offset = frag_entry.start -
+			(start * ctxt.cur_dev->blksz);
+		n_blks = DIV_ROUND_UP(table_size + table_offset,
+				      ctxt.cur_dev->blksz);
 
-	ret = sqfs_disk_read(start, n_blks, fragment);
-	if (ret < 0)
-		goto out;
+		fragment = malloc_cache_aligned(n_blks * ctxt.cur_dev->blksz);
 
-	/* File compressed and fragmented */
-	if (finfo.frag && finfo.comp) {
-		dest_len = get_unaligned_le32(&sblk->block_size);
-		fragment_block = malloc(dest_len);
-		if (!fragment_block) {
+		if (!fragment) {
 			ret = -ENOMEM;
 			goto out;
 		}
 
-		ret = sqfs_decompress(&ctxt, fragment_block, &dest_len,
-				      (void *)fragment  + table_offset,
-				      frag_entry.size);
-		if (ret) {
-			free(fragment_block);
+		ret = sqfs_disk_read(start, n_blks, fragment);
+		if (ret < 0)
 			goto out;
-		}
 
-		memcpy(buf + *actread, &fragment_block[finfo.offset], finfo.size - *actread);
-		*actread = finfo.size;
+		if (finfo.comp) {
+			/* File compressed and fragmented */
+			dest_len = get_unaligned_le32(&sblk->block_size);
+			frag_buf = malloc(dest_len);
+			if (!frag_buf) {
+				ret = -ENOMEM;
+				goto out;
+			}
+
+			ret = sqfs_decompress(&ctxt, frag_buf, &dest_len,
+					      (void *)fragment  + table_offset,
+					      frag_entry.size);
+			if (ret)
+				goto out;
 
-		free(fragment_block);
+			fragment_block = frag_buf;
+			frag_len = dest_len;
+		} else {
+			fragment_block = (void *)fragment + table_offset;
+			frag_len = table_size;
+		}
 
-	} else if (finfo.frag && !finfo.comp) {
-		fragment_block = (void *)fragment + table_offset;
+		sqfs_cache_add(&ctxt.frag_cache, frag_entry.start, table_size,
+			       fragment_block, frag_len);
+	}
 
-		memcpy(buf + *actread, &fragment_block[finfo.offset], finfo.size - *actread);
-		*actread = finfo.size;
+	if (finfo.offset + finfo.size - *actread > frag_len) {
+		ret = -EINVAL;
+		goto out;
 	}
 
+	memcpy(buf + *actread, &fragment_block[finfo.offset], finfo.size - *actread);
+	*actread = finfo.size;
+
 out:
+	free(frag_buf);
 	free(fragment);
 	free(datablock);
 	free(file);
@@ -1712,6 +1608,7 @@ free_strings:
 void sqfs_close(void)
 {
 	sqfs_decompressor_cleanup(&ctxt);
+	arena_uninit(&ctxt.arena);
 	free(ctxt.sblk);
 	ctxt.sblk = NULL;
 	ctxt.cur_dev = NULL;
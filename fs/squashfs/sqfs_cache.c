@@ -0,0 +1,96 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * sqfs_cache.c: cache of decompressed metadata and fragment blocks
+ *
+ * Blocks are keyed by their byte offset in the filesystem. Looking up a path,
+ * or reading several small files which share a fragment block, then only
+ * decompresses each block once.
+ */
+
+#include <malloc.h>
+#include <string.h>
+#include <linux/types.h>
+
+#include "sqfs_filesystem.h"
+
+void sqfs_cache_flush(struct sqfs_cache *cache)
+{
+	int i;
+
+	for (i = 0; i < cache->count; i++) {
+		free(cache->entries[i].data);
+		cache->entries[i].data = NULL;
+	}
+}
+
+void sqfs_cache_setup(struct sqfs_cache *cache, int count, u32 buf_size)
+{
+	if (cache->count == count && cache->buf_size == buf_size)
+		return;
+
+	sqfs_cache_flush(cache);
+	free(cache->entries);
+	cache->entries = NULL;
+	cache->count = 0;
+	cache->buf_size = buf_size;
+	if (count > 0) {
+		cache->entries = calloc(count, sizeof(*cache->entries));
+		if (cache->entries)
+			cache->count = count;
+	}
+}
+
+void *sqfs_cache_find(struct sqfs_cache *cache, u64 start, u32 *sizep,
+		      u32 *disk_sizep)
+{
+	struct sqfs_cache_entry *entry;
+	int i;
+
+	for (i = 0; i < cache->count; i++) {
+		entry = &cache->entries[i];
+		if (entry->data && entry->start == start) {
+			entry->last_used = ++cache->counter;
+			*sizep = entry->size;
+			if (disk_sizep)
+				*disk_sizep = entry->disk_size;
+
+			return entry->data;
+		}
+	}
+
+	return NULL;
+}
+
+void sqfs_cache_add(struct sqfs_cache *cache, u64 start, u32 disk_size,
+		    const void *data, u32 size)
+{
+	struct sqfs_cache_entry *entry, *victim = NULL;
+	int i;
+
+	if (size > cache->buf_size)
+		return;
+
+	/* use a free entry if there is one, else the least recently used */
+	for (i = 0; i < cache->count; i++) {
+		entry = &cache->entries[i];
+		if (!entry->data) {
+			victim = entry;
+			break;
+		}
+		if (!victim || entry->last_used < victim->last_used)
+			victim = entry;
+	}
+	if (!victim)
+		return;
+
+	if (!victim->data) {
+		victim->data = malloc(cache->buf_size);
+		if (!victim->data)
+			return;
+	}
+	memcpy(victim->data, data, size);
+	victim->start = start;
+	victim->disk_size = disk_size;
+	victim->size = size;
+	victim->last_used = ++cache->counter;
+}
@@ -8,6 +8,7 @@
 #ifndef SQFS_FILESYSTEM_H
 #define SQFS_FILESYSTEM_H
 
+#include <arena.h>
 #include <asm/unaligned.h>
 #include <fs.h>
 #include <part.h>
@@ -71,6 +72,38 @@ struct squashfs_super_block {
 	__le64 export_table_start;
 };
 
+/**
+ * struct sqfs_cache_entry - a decompressed block held in a cache
+ *
+ * @start: Byte offset of the block in the filesystem, used as the key
+ * @disk_size: Size of the block on disk, including any metadata header
+ * @size: Decompressed size of the block
+ * @last_used: Value of the cache's counter when the entry was last used
+ * @data: Decompressed contents, NULL if the entry is unused
+ */
+struct sqfs_cache_entry {
+	u64 start;
+	u32 disk_size;
+	u32 size;
+	ulong last_used;
+	void *data;
+};
+
+/**
+ * struct sqfs_cache - least-recently-used cache of decompressed blocks
+ *
+ * @entries: Array of entries
+ * @count: Number of entries, 0 if the cache is disabled
+ * @buf_size: Size of the buffer allocated for each entry
+ * @counter: Incremented on each access, to track the least-recently-used entry
+ */
+struct sqfs_cache {
+	struct sqfs_cache_entry *entries;
+	int count;
+	u32 buf_size;
+	ulong counter;
+};
+
 struct squashfs_ctxt {
 	struct disk_partition cur_part_info;
 	struct blk_desc *cur_dev;
@@ -78,6 +111,18 @@ struct squashfs_ctxt {
 #if IS_ENABLED(CONFIG_ZSTD)
 	void *zstd_workspace;
 #endif
+	/*
+	 * Caches of metadata and fragment blocks. These are kept after the
+	 * filesystem is closed and stay valid as long as the same filesystem
+	 * (device, partition and superblock) is probed again.
+	 */
+	struct sqfs_cache meta_cache;
+	struct sqfs_cache frag_cache;
+	struct blk_desc *cache_dev;
+	lbaint_t cache_part_start;
+	struct squashfs_super_block cache_sblk;
+	/* Token lists built while resolving a path, freed in one go */
+	struct arena arena;
 };
 
 struct squashfs_directory_index {
@@ -301,6 +346,51 @@ int sqfs_dir_offset(void *dir_i, u32 *m_list, int m_count);
 int sqfs_read_metablock(unsigned char *file_mapping, int offset,
 			bool *compressed, u32 *data_size);
 
+/**
+ * sqfs_cache_setup() - Set the size of a cache
+ *
+ * This flushes the cache if its size changes.
+ *
+ * @cache: Cache to set up
+ * @count: Number of entries, 0 to disable the cache
+ * @buf_size: Maximum size of a block held in the cache
+ */
+void sqfs_cache_setup(struct sqfs_cache *cache, int count, u32 buf_size);
+
+/**
+ * sqfs_cache_flush() - Drop all blocks held in a cache
+ *
+ * @cache: Cache to flush
+ */
+void sqfs_cache_flush(struct sqfs_cache *cache);
+
+/**
+ * sqfs_cache_find() - Look up a block in a cache
+ *
+ * @cache: Cache to look in
+ * @start: Byte offset of the block in the filesystem
+ * @sizep: Returns the decompressed size of the block
+ * @disk_sizep: Returns the size of the block on disk, if not NULL
+ * Return: decompressed contents, or NULL if the block is not cached
+ */
+void *sqfs_cache_find(struct sqfs_cache *cache, u64 start, u32 *sizep,
+		      u32 *disk_sizep);
+
+/**
+ * sqfs_cache_add() - Add a copy of a block to a cache
+ *
+ * This replaces the least-recently-used entry if the cache is full. Nothing is
+ * done if the cache is disabled or the block is too large.
+ *
+ * @cache: Cache to add to
+ * @start: Byte offset of the block in the filesystem
+ * @disk_size: Size of the block on disk
+ * @data: Decompressed contents of the block
+ * @size: Decompressed size of the block
+ */
+void sqfs_cache_add(struct sqfs_cache *cache, u64 start, u32 disk_size,
+		    const void *data, u32 size);
+
 bool sqfs_is_empty_dir(void *dir_i);
 
 bool sqfs_is_dir(u16 type);
@@ -2256,6 +2256,7 @@ static int ubifs_fill_super(struct super_block *sb, void *data, int silent)
 #else
 	/* U-Boot read only mode */
 	c->ubi = ubi_open_volume(c->vi.ubi_num, c->vi.vol_id, UBI_READONLY);
+	c->bulk_read = IS_ENABLED(CONFIG_UBIFS_BULK_READ);
 #endif
 
 	if (IS_ERR(c->ubi)) {
@@ -712,6 +712,79 @@ dump:
 	return -EINVAL;
 }
 
+/**
+ * read_bulk() - Read a run of blocks with a single flash read
+ *
+ * This looks up the data nodes for @block and the blocks after it which are
+ * stored one after the other in the same LEB, reads them all at once and
+ * decompresses each one straight into the caller's buffer. Holes between the
+ * nodes are zeroed.
+ *
+ * @c: UBIFS file-system description object
+ * @inode: Inode being read
+ * @addr: Buffer for @block
+ * @block: First block to read
+ * @count: Maximum number of blocks to read, all of which must be whole blocks
+ * Return: number of blocks read, 0 if @block was not read (e.g. it is a
+ * hole), -ve on error
+ */
+static int read_bulk(struct ubifs_info *c, struct inode *inode, void *addr,
+		     unsigned int block, int count)
+{
+	struct bu_info *bu = &c->bu;
+	int i, err, len, out_len, next = 0;
+	unsigned int pos;
+	void *buf;
+
+	data_key_init(c, &bu->key, inode->i_ino, block);
+	bu->buf_len = c->max_bu_buf_len;
+	err = ubifs_tnc_get_bu_keys(c, bu);
+	if (err)
+		return err;
+	if (!bu->cnt || key_block(c, &bu->zbranch[0].key) != block)
+		return 0;
+	err = ubifs_tnc_bulk_read(c, bu);
+	if (err)
+		return err;
+
+	buf = bu->buf;
+	for (i = 0; i < bu->cnt; i++) {
+		struct ubifs_data_node *dn = buf;
+
+		pos = key_block(c, &bu->zbranch[i].key) - block;
+		if (pos >= count)
+			break;
+		if (pos > next)
+			memset(addr + next * UBIFS_BLOCK_SIZE, '\0',
+			       (pos - next) * UBIFS_BLOCK_SIZE);
+
+		len = le32_to_cpu(dn->size);
+		out_len = UBIFS_BLOCK_SIZE;
+		if (len <= 0 || len > UBIFS_BLOCK_SIZE)
+			goto dump;
+		err = ubifs_decompress(c, &dn->data,
+				       le32_to_cpu(dn->ch.len) -
+				       UBIFS_DATA_NODE_SZ,
+				       addr + pos * UBIFS_BLOCK_SIZE, &out_len,
+				       le16_to_cpu(dn->compr_type));
+		if (err || len != out_len)
+			goto dump;
+		if (len < UBIFS_BLOCK_SIZE)
+			memset(addr + pos * UBIFS_BLOCK_SIZE + len, '\0',
+			       UBIFS_BLOCK_SIZE - len);
+		next = pos + 1;
+		buf += ALIGN(bu->zbranch[i].len, 8);
+	}
+
+	return next;
+
+dump:
+	ubifs_err(c, "bad data node (block %u, inode %lu)", block + pos,
+		  inode->i_ino);
+	ubifs_dump_node(c, buf);
+	return -EINVAL;
+}
+
 static int do_readpage(struct ubifs_info *c, struct inode *inode,
 		       struct page *page, int last_block_size)
 {
@@ -833,7 +906,7 @@ int ubifs_read(const char *filename, void *buf, loff_t offset,
 	struct inode *inode;
 	struct page page;
 	int err = 0;
-	int i;
+	int i, n;
 	int count;
 	int last_block_size = 0;
 
@@ -883,19 +956,36 @@ int ubifs_read(const char *filename, void *buf, loff_t offset,
 	page.addr = buf;
 	page.index = offset / PAGE_SIZE;
 	page.inode = inode;
-	for (i = 0; i < count; i++) {
+	for (i = 0; i < count; i += n) {
 		/*
-		 * Make sure to not read beyond the requested size
+		 * Read whole blocks in bulk where possible. The last block may
+		 * be partial, so it is always left to do_readpage()
 		 */
-		if (((i + 1) == count) && (size < inode->i_size))
-			last_block_size = size - (i * PAGE_SIZE);
+		n = 0;
+		if (c->bulk_read && UBIFS_BLOCKS_PER_PAGE == 1 &&
+		    i + 1 < count) {
+			n = read_bulk(c, inode, page.addr, page.index,
+				      count - 1 - i);
+			if (n < 0) {
+				err = n;
+				break;
+			}
+		}
+		if (!n) {
+			/*
+			 * Make sure to not read beyond the requested size
+			 */
+			if (((i + 1) == count) && (size < inode->i_size))
+				last_block_size = size - (i * PAGE_SIZE);
 
-		err = do_readpage(c, inode, &page, last_block_size);
-		if (err)
-			break;
+			err = do_readpage(c, inode, &page, last_block_size);
+			if (err)
+				break;
+			n = 1;
+		}
 
-		page.addr += PAGE_SIZE;
-		page.index++;
+		page.addr += n * PAGE_SIZE;
+		page.index += n;
 	}
 
 	if (err) {
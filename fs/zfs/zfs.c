@@ -141,6 +141,15 @@ typedef struct dnode_end {
 	zfs_endian_t endian;
 } dnode_end_t;
 
+/* Number of indirect-block levels to cache in dmu_read() */
+#define ZFS_IND_CACHE_LEVELS	8
+
+/* An indirect block cached by dmu_read(), identified by its block pointer */
+struct zfs_ind_cache {
+	blkptr_t bp;
+	void *buf;
+};
+
 struct zfs_data {
 	/* cache for a file block of the currently zfs_open()-ed file */
 	char *file_buf;
@@ -164,6 +173,9 @@ struct zfs_data {
 
 	uberblock_t current_uberblock;
 
+	/* last indirect block read at each level */
+	struct zfs_ind_cache ind_cache[ZFS_IND_CACHE_LEVELS];
+
 	dnode_end_t mos;
 	dnode_end_t mdn;
 	dnode_end_t dnode;
@@ -633,6 +645,8 @@ dmu_read(dnode_end_t *dn, uint64_t blkid, void **buf,
 	int epbs = dn->dn.dn_indblkshift - SPA_BLKPTRSHIFT;
 	blkptr_t *bp;
 	void *tmpbuf = 0;
+	struct zfs_ind_cache *ic;
+	bool cached = false;
 	zfs_endian_t endian;
 	int err = ZFS_ERR_NONE;
 
@@ -645,8 +659,10 @@ dmu_read(dnode_end_t *dn, uint64_t blkid, void **buf,
 		idx = (blkid >> (epbs * level)) & ((1 << epbs) - 1);
 		*bp = bp_array[idx];
 		if (bp_array != dn->dn.dn_blkptr) {
-			free(bp_array);
+			if (!cached)
+				free(bp_array);
 			bp_array = 0;
+			cached = false;
 		}
 
 		if (BP_IS_HOLE(bp)) {
@@ -667,13 +683,33 @@ dmu_read(dnode_end_t *dn, uint64_t blkid, void **buf,
 			endian = (zfs_to_cpu64(bp->blk_prop, endian) >> 63) & 1;
 			break;
 		}
+
+		/*
+		 * Blocks are never overwritten in place, so an identical block
+		 * pointer means identical contents. Reading a file block by
+		 * block then only needs each indirect block to be read once.
+		 */
+		ic = level < ZFS_IND_CACHE_LEVELS ? &data->ind_cache[level] :
+			NULL;
+		if (ic && ic->buf && !memcmp(&ic->bp, bp, sizeof(*bp))) {
+			endian = (zfs_to_cpu64(bp->blk_prop, endian) >> 63) & 1;
+			bp_array = ic->buf;
+			cached = true;
+			continue;
+		}
 		err = zio_read(bp, endian, &tmpbuf, 0, data);
 		endian = (zfs_to_cpu64(bp->blk_prop, endian) >> 63) & 1;
 		if (err)
 			break;
 		bp_array = tmpbuf;
+		if (ic) {
+			free(ic->buf);
+			ic->bp = *bp;
+			ic->buf = tmpbuf;
+			cached = true;
+		}
 	}
-	if (bp_array != dn->dn.dn_blkptr)
+	if (bp_array != dn->dn.dn_blkptr && !cached)
 		free(bp_array);
 	if (endian_out)
 		*endian_out = endian;
@@ -1853,6 +1889,10 @@ static uint64_t vdev_label_start(uint64_t psize, int l)
 void
 zfs_unmount(struct zfs_data *data)
 {
+	int i;
+
+	for (i = 0; i < ZFS_IND_CACHE_LEVELS; i++)
+		free(data->ind_cache[i].buf);
 	free(data->dnode_buf);
 	free(data->dnode_mdn);
 	free(data->file_buf);
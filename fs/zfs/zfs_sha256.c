@@ -13,6 +13,8 @@
 #include <linux/time.h>
 #include <linux/ctype.h>
 #include <asm/byteorder.h>
+#include <asm/unaligned.h>
+#include <u-boot/sha256.h>
 #include "zfs_common.h"
 
 #include <zfs/zfs.h>
@@ -108,6 +110,18 @@ zio_checksum_SHA256(const void *buf, uint64_t size,
 	unsigned padsize = size & 63;
 	unsigned i;
 
+	/* use the common code if present, which may use crypto instructions */
+	if (CONFIG_IS_ENABLED(SHA256)) {
+		sha256_context ctx;
+
+		sha256_starts(&ctx);
+		sha256_update(&ctx, buf, size);
+		sha256_finish(&ctx, pad);
+		for (i = 0; i < 8; i++)
+			H[i] = get_unaligned_be32(pad + i * 4);
+		goto done;
+	}
+
 	for (i = 0; i < size - padsize; i += 64)
 		SHA256Transform(H, (uint8_t *)buf + i);
 
@@ -123,6 +137,7 @@ zio_checksum_SHA256(const void *buf, uint64_t size,
 	for (i = 0; i < padsize; i += 64)
 		SHA256Transform(H, pad + i);
 
+done:
 	zcp->zc_word[0] = cpu_to_zfs64((uint64_t)H[0] << 32 | H[1],
 										endian);
 	zcp->zc_word[1] = cpu_to_zfs64((uint64_t)H[2] << 32 | H[3],
@@ -333,6 +333,7 @@ struct andr_image_data {
 	u32 ramdisk_size;  /* size in bytes */
 	ulong vendor_ramdisk_ptr;  /* vendor ramdisk address */
 	u32 vendor_ramdisk_size;  /* vendor ramdisk size*/
+	ulong boot_ramdisk_ptr;  /* boot ramdisk address, in the boot image */
 	u32 boot_ramdisk_size;  /* size in bytes */
 	ulong second_ptr;  /* secondary bootloader address */
 	u32 second_size;  /* secondary bootloader size */
@@ -0,0 +1,115 @@
+/* SPDX-License-Identifier: GPL-2.0+ */
+/*
+ * Arena allocator for short-lived, per-operation allocations
+ *
+ * An arena hands out memory from large blocks obtained with malloc(). Nothing
+ * is freed individually: the caller takes a mark with arena_begin() before an
+ * operation and hands it to arena_release() afterwards, which drops
+ * everything allocated since then in one go. The first block is kept so that
+ * the next operation does not need to call malloc() at all.
+ *
+ * Marks nest, so an operation may take its own mark while an outer one is
+ * active, as long as they are released in reverse order.
+ */
+
+#ifndef __ARENA_H
+#define __ARENA_H
+
+#include <linux/types.h>
+
+/* Alignment of every pointer returned by arena_alloc() */
+#define ARENA_ALIGN		8
+
+/* Block size used when arena_init() is given 0, or the arena is zeroed */
+#define ARENA_DEFAULT_BLOCK	1024
+
+struct arena_block;
+
+/**
+ * struct arena - arena from which memory is allocated
+ *
+ * Using memset() to zero all fields is equivalent to arena_init(arena, 0)
+ *
+ * @head: Most recently allocated block, or NULL if none
+ * @block_size: Size of the data area of each block, in bytes. Larger
+ *	allocations get a block of their own
+ */
+struct arena {
+	struct arena_block *head;
+	size_t block_size;
+};
+
+/**
+ * struct arena_mark - position in an arena
+ *
+ * This is returned by arena_begin() and is only meaningful to arena_release()
+ *
+ * @block: Block which was current when the mark was taken, or NULL if none
+ * @used: Number of bytes used in @block at that point
+ */
+struct arena_mark {
+	struct arena_block *block;
+	size_t used;
+};
+
+/**
+ * arena_init() - Set up a new, empty arena
+ *
+ * No memory is allocated until the first call to arena_alloc()
+ *
+ * @arena: Arena to set up
+ * @block_size: Size of each block in bytes, or 0 for ARENA_DEFAULT_BLOCK
+ */
+void arena_init(struct arena *arena, size_t block_size);
+
+/**
+ * arena_uninit() - Free all memory held by an arena
+ *
+ * Any pointers obtained from the arena become invalid. The arena may be used
+ * again afterwards.
+ *
+ * @arena: Arena to free
+ */
+void arena_uninit(struct arena *arena);
+
+/**
+ * arena_begin() - Start an operation using the arena
+ *
+ * @arena: Arena to use
+ * Return: mark to pass to arena_release() when the operation is finished
+ */
+struct arena_mark arena_begin(struct arena *arena);
+
+/**
+ * arena_release() - Free everything allocated since a mark was taken
+ *
+ * Blocks added since the mark are returned to malloc(), except that the
+ * first block in the arena is always kept for reuse.
+ *
+ * @arena: Arena to use
+ * @mark: Mark returned by arena_begin()
+ */
+void arena_release(struct arena *arena, struct arena_mark mark);
+
+/**
+ * arena_alloc() - Allocate memory from an arena
+ *
+ * The memory is not zeroed. It remains valid until the arena is released back
+ * to a mark taken before this call, or the arena is uninited.
+ *
+ * @arena: Arena to allocate from
+ * @size: Number of bytes required
+ * Return: pointer to memory aligned to ARENA_ALIGN, or NULL if out of memory
+ */
+void *arena_alloc(struct arena *arena, size_t size);
+
+/**
+ * arena_strdup() - Copy a string into an arena
+ *
+ * @arena: Arena to allocate from
+ * @str: String to copy
+ * Return: pointer to the copy, or NULL if out of memory
+ */
+char *arena_strdup(struct arena *arena, const char *str);
+
+#endif
@@ -232,6 +232,13 @@ struct global_data {
 	void *dm_priv_base;
 # endif
 #endif
+#if CONFIG_IS_ENABLED(DM_COMPAT_INDEX)
+	/**
+	 * @dm_compat_index: hash table of driver compatible strings, or an
+	 * error pointer if it could not be allocated
+	 */
+	struct dm_compat_index *dm_compat_index;
+#endif
 #ifdef CONFIG_TIMER
 	/**
 	 * @timer: timer instance for Driver Model
@@ -490,6 +497,11 @@ struct global_data {
 	 * @cyclic_list: list of registered cyclic functions
 	 */
 	struct hlist_head cyclic_list;
+	/**
+	 * @cyclic_next: earliest time (in us) at which a cyclic function is
+	 * due, so that cyclic_run() only needs to look at the list then
+	 */
+	uint64_t cyclic_next;
 #endif
 	/**
 	 * @dmtag_list: List of DM tags
@@ -530,6 +542,14 @@ static_assert(sizeof(struct global_data) == GD_SIZE);
 #define gd_dm_driver_rt()		NULL
 #endif
 
+#if CONFIG_IS_ENABLED(DM_COMPAT_INDEX)
+#define gd_set_dm_compat_index(idx)	gd->dm_compat_index = idx
+#define gd_dm_compat_index()		gd->dm_compat_index
+#else
+#define gd_set_dm_compat_index(idx)
+#define gd_dm_compat_index()		NULL
+#endif
+
 #if CONFIG_IS_ENABLED(OF_PLATDATA_RT)
 #define gd_set_dm_udevice_rt(dyn)	gd->dm_udevice_rt = dyn
 #define gd_dm_udevice_rt()		gd->dm_udevice_rt
@@ -705,6 +725,10 @@ enum gd_flags {
 	 * @GD_FLG_HUSH_MODERN_PARSER: Use hush 2021 parser.
 	 */
 	GD_FLG_HUSH_MODERN_PARSER = 0x2000000,
+	/**
+	 * @GD_FLG_CPU_BOOST: A CPU is running at its boot performance level
+	 */
+	GD_FLG_CPU_BOOST = 0x4000000,
 };
 
 #endif /* __ASSEMBLY__ */
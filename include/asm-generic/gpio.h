@@ -296,6 +296,37 @@ struct dm_gpio_ops {
 	 * @value.
 	 */
 	int (*set_value)(struct udevice *dev, unsigned offset, int value);
+
+	/**
+	 * get_values() - Read the values of several GPIOs at once (optional)
+	 *
+	 * This allows the uclass to read a whole bank with one register
+	 * access, e.g. for board-ID straps. Active-low handling is done by the
+	 * uclass, so this returns the raw line levels.
+	 *
+	 * @dev:	GPIO device
+	 * @mask:	Bitmap of GPIO offsets to read (bit n is offset n)
+	 * @bits:	Returns the values, in the same layout as @mask. Bits
+	 *		which are not in @mask are undefined
+	 * @return 0 if OK, -ve on error
+	 */
+	int (*get_values)(struct udevice *dev, const ulong *mask, ulong *bits);
+
+	/**
+	 * set_values() - Set the values of several outputs at once (optional)
+	 *
+	 * This is only called for GPIOs which have been set up as outputs
+	 * and are not open-drain or open-source. The values are the raw line
+	 * levels, since the uclass deals with active-low GPIOs.
+	 *
+	 * @dev:	GPIO device
+	 * @mask:	Bitmap of GPIO offsets to set (bit n is offset n)
+	 * @bits:	Values to set, in the same layout as @mask
+	 * @return 0 if OK, -ve on error
+	 */
+	int (*set_values)(struct udevice *dev, const ulong *mask,
+			  const ulong *bits);
+
 	/**
 	 * get_function() Get the GPIO function
 	 *
@@ -734,6 +765,34 @@ int dm_gpio_get_value(const struct gpio_desc *desc);
 
 int dm_gpio_set_value(const struct gpio_desc *desc, int value);
 
+/**
+ * dm_gpio_get_values() - Get the values of a list of GPIOs
+ *
+ * GPIOs in the same device are read together if the driver supports it,
+ * which is faster than reading them one at a time
+ *
+ * @desc_list:	List of GPIOs to read
+ * @count:	Number of GPIOs in the list, at most BITS_PER_LONG
+ * @valuesp:	Returns the values, with bit n set if GPIO n is active
+ * Return: 0 if OK, -E2BIG if @count is too large, other -ve on error
+ */
+int dm_gpio_get_values(const struct gpio_desc *desc_list, int count,
+		       ulong *valuesp);
+
+/**
+ * dm_gpio_set_values() - Set the values of a list of GPIOs
+ *
+ * Outputs in the same device are set together if the driver supports it, so
+ * that they change at (nearly) the same time and with fewer register writes
+ *
+ * @desc_list:	List of GPIOs to set
+ * @count:	Number of GPIOs in the list, at most BITS_PER_LONG
+ * @values:	Values to set, with bit n set to make GPIO n active
+ * Return: 0 if OK, -E2BIG if @count is too large, other -ve on error
+ */
+int dm_gpio_set_values(const struct gpio_desc *desc_list, int count,
+		       ulong values);
+
 /**
  * dm_gpio_clrset_flags() - Update flags
  *
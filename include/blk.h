@@ -10,6 +10,8 @@
 #include <bouncebuf.h>
 #include <dm/uclass-id.h>
 #include <efi.h>
+#include <linux/errno.h>
+#include <linux/list.h>
 
 #ifdef CONFIG_SYS_64BIT_LBA
 typedef uint64_t lbaint_t;
@@ -72,6 +74,13 @@ struct blk_desc {
 	lbaint_t	lba;		/* number of blocks */
 	unsigned long	blksz;		/* block size */
 	int		log2blksz;	/* for convenience: log2(blksz) */
+	/*
+	 * Preferred alignment of large writes in blocks, e.g. the erase
+	 * group size, or 0 if none. See blk_write_split().
+	 */
+	unsigned int	write_align;
+	/* Alignment required by blk_discard() in blocks, 0 meaning 1 */
+	unsigned int	discard_align;
 	char		vendor[BLK_VEN_SIZE + 1]; /* device vendor string */
 	char		product[BLK_PRD_SIZE + 1]; /* device product number */
 	char		revision[BLK_REV_SIZE + 1]; /* firmware revision */
@@ -87,6 +96,11 @@ struct blk_desc {
 	 * device. Once these functions are removed we can drop this field.
 	 */
 	struct udevice *bdev;
+	/*
+	 * Maximum number of read requests which the driver can have in
+	 * flight at once, see blk_submit_read(). A value of 0 means 1.
+	 */
+	unsigned int	queue_depth;
 #else
 	unsigned long	(*block_read)(struct blk_desc *block_dev,
 				      lbaint_t start,
@@ -149,14 +163,42 @@ void blkcache_fill(int iftype, int dev,
  */
 void blkcache_invalidate(int iftype, int dev);
 
+/**
+ * blkcache_readahead() - work out how much to read after a cache miss
+ *
+ * Reads are widened to whole cache lines so that they can be cached, and
+ * extended by the configured read-ahead when they follow on from the
+ * previous read on the same device.
+ *
+ * @iftype - uclass_id_x for type of device
+ * @dev - device index of particular type
+ * @start - starting block number of the read which missed
+ * @blkcnt - number of blocks in the read which missed
+ * @startp - returns the first block to read from the device
+ * @blkcntp - returns the number of blocks to read from the device
+ *
+ * Return: true if a different range should be read, false to read just
+ * the requested blocks
+ */
+bool blkcache_readahead(int iftype, int dev, lbaint_t start, lbaint_t blkcnt,
+			lbaint_t *startp, lbaint_t *blkcntp);
+
 /**
  * blkcache_configure() - configure block cache
  *
- * @param blocks - maximum blocks per entry
- * @param entries - maximum entries in cache
+ * @param blocks - number of blocks in each entry (cache line)
+ * @param entries - maximum entries in cache, rounded up to a whole number
+ * of sets
  */
 void blkcache_configure(unsigned blocks, unsigned entries);
 
+/**
+ * blkcache_set_readahead() - set the sequential read-ahead
+ *
+ * @lines - number of extra entries to read when access is sequential
+ */
+void blkcache_set_readahead(unsigned lines);
+
 /*
  * statistics of the block cache
  */
@@ -166,6 +208,19 @@ struct block_cache_stats {
 	unsigned entries; /* current entry count */
 	unsigned max_blocks_per_entry;
 	unsigned max_entries;
+	unsigned ways; /* entries in each set */
+	unsigned readahead; /* entries to read ahead on sequential access */
+};
+
+/*
+ * statistics of the block cache for a single device
+ */
+struct block_cache_dev_stats {
+	int iftype;
+	int devnum;
+	unsigned hits;
+	unsigned misses;
+	unsigned readaheads;
 };
 
 /**
@@ -175,6 +230,18 @@ struct block_cache_stats {
  */
 void blkcache_stats(struct block_cache_stats *stats);
 
+/**
+ * blkcache_dev_stats() - return statistics for a device
+ *
+ * The statistics for all devices are reset once the last device has been
+ * read.
+ *
+ * @param seq - index of device to return, starting at 0
+ * @param stats - statistics are copied here
+ * Return: 0 if OK, -ENOENT if there is no device with that index
+ */
+int blkcache_dev_stats(int seq, struct block_cache_dev_stats *stats);
+
 /** blkcache_free() - free all memory allocated to the block cache */
 void blkcache_free(void);
 
@@ -191,6 +258,13 @@ static inline void blkcache_fill(int iftype, int dev,
 				 lbaint_t start, lbaint_t blkcnt,
 				 unsigned long blksz, void const *buffer) {}
 
+static inline bool blkcache_readahead(int iftype, int dev, lbaint_t start,
+				      lbaint_t blkcnt, lbaint_t *startp,
+				      lbaint_t *blkcntp)
+{
+	return false;
+}
+
 static inline void blkcache_invalidate(int iftype, int dev) {}
 
 static inline void blkcache_free(void) {}
@@ -200,6 +274,33 @@ static inline void blkcache_free(void) {}
 #if CONFIG_IS_ENABLED(BLK)
 struct udevice;
 
+/**
+ * struct blk_req - an asynchronous read or write request
+ *
+ * This is set up by the caller and passed to blk_submit_read() or
+ * blk_submit_write(). It must remain valid until @done becomes true.
+ *
+ * @start: Start block number to read or write (0=first)
+ * @blkcnt: Number of blocks to read or write
+ * @buffer: Destination buffer for data read, or source of data to write
+ * @result: Number of blocks read or written, or -ve error number; valid once
+ *	@done is set
+ * @done: true once the request has completed
+ * @write: true for a write, set by the uclass
+ * @priv: Available for use by the driver while the request is in flight
+ * @sibling: Node in the uclass' list of in-flight requests for the device
+ */
+struct blk_req {
+	lbaint_t start;
+	lbaint_t blkcnt;
+	void *buffer;
+	long result;
+	bool done;
+	bool write;
+	void *priv;
+	struct list_head sibling;
+};
+
 /* Operations on block devices */
 struct blk_ops {
 	/**
@@ -240,6 +341,20 @@ struct blk_ops {
 	unsigned long (*erase)(struct udevice *dev, lbaint_t start,
 			       lbaint_t blkcnt);
 
+	/**
+	 * discard() - discard blocks so that they read back as zero
+	 *
+	 * Unlike erase(), this must not change any block outside the range.
+	 * @start and @blkcnt are multiples of blk_desc->discard_align.
+	 *
+	 * @dev:	Device to update
+	 * @start:	Start block number to discard (0=first)
+	 * @blkcnt:	Number of blocks to discard
+	 * @return 0 if OK, -ENOTSUPP if the device cannot guarantee that the
+	 * blocks read back as zero, other -ve on error
+	 */
+	int (*discard)(struct udevice *dev, lbaint_t start, lbaint_t blkcnt);
+
 	/**
 	 * select_hwpart() - select a particular hardware partition
 	 *
@@ -276,6 +391,49 @@ struct blk_ops {
 	 */
 	int (*buffer_aligned)(struct udevice *dev, struct bounce_buffer *state);
 #endif	/* CONFIG_BOUNCE_BUFFER */
+
+#if CONFIG_IS_ENABLED(BLK_ASYNC)
+	/**
+	 * submit_read() - start a read without waiting for it to complete
+	 *
+	 * The uclass never has more than blk_desc->queue_depth requests
+	 * outstanding on a device. Each request is later completed by the
+	 * driver calling blk_req_complete(), normally from poll().
+	 *
+	 * Both this and poll() must be provided for the asynchronous path to
+	 * be used.
+	 *
+	 * @dev:	Device to read from
+	 * @req:	Request to start
+	 * @return 0 if OK, -EBUSY if the device cannot accept another request
+	 * just now, other -ve on error
+	 */
+	int (*submit_read)(struct udevice *dev, struct blk_req *req);
+
+	/**
+	 * submit_write() - start a write without waiting for it to complete
+	 *
+	 * This is optional and works in the same way as submit_read(), with
+	 * which it shares the queue.
+	 *
+	 * @dev:	Device to write to
+	 * @req:	Request to start
+	 * @return 0 if OK, -EBUSY if the device cannot accept another request
+	 * just now, other -ve on error
+	 */
+	int (*submit_write)(struct udevice *dev, struct blk_req *req);
+
+	/**
+	 * poll() - check for completed requests
+	 *
+	 * This must not wait for a request to finish. It calls
+	 * blk_req_complete() for each request which has completed.
+	 *
+	 * @dev:	Device to check
+	 * @return 0 if OK, -ve on error
+	 */
+	int (*poll)(struct udevice *dev);
+#endif	/* BLK_ASYNC */
 };
 
 /*
@@ -328,6 +486,108 @@ long blk_write(struct udevice *dev, lbaint_t start, lbaint_t blkcnt,
  */
 long blk_erase(struct udevice *dev, lbaint_t start, lbaint_t blkcnt);
 
+/**
+ * blk_discard() - Discard blocks so that they read back as zero
+ *
+ * This is much quicker than writing zeroes on devices which support it, e.g.
+ * with the eMMC trim command.
+ *
+ * @dev: Device to update
+ * @start: Start block, a multiple of blk_desc->discard_align
+ * @blkcnt: Number of blocks, a multiple of blk_desc->discard_align
+ * Return: 0 if OK, -ENOSYS or -ENOTSUPP if the device cannot do this,
+ * -EINVAL if the range is not aligned, other -ve on error
+ */
+int blk_discard(struct udevice *dev, lbaint_t start, lbaint_t blkcnt);
+
+/**
+ * blk_ddiscard() - Discard blocks so that they read back as zero
+ *
+ * See blk_discard()
+ *
+ * @desc: Block device descriptor
+ * @start: Start block, a multiple of blk_desc->discard_align
+ * @blkcnt: Number of blocks, a multiple of blk_desc->discard_align
+ * Return: 0 if OK, -ve on error
+ */
+int blk_ddiscard(struct blk_desc *desc, lbaint_t start, lbaint_t blkcnt);
+
+/**
+ * blk_write_split() - Choose how many blocks to write at once
+ *
+ * When a large write is split into pieces, each piece is ended on a multiple
+ * of blk_desc->write_align where possible, so that the device does not have
+ * to deal with partly written erase groups.
+ *
+ * @desc: Block device descriptor
+ * @start: First block of the piece
+ * @blkcnt: Number of blocks left to write
+ * @max: Largest number of blocks to write at once
+ * Return: number of blocks to write, from 1 to the smaller of @blkcnt and
+ * @max
+ */
+lbaint_t blk_write_split(struct blk_desc *desc, lbaint_t start,
+			 lbaint_t blkcnt, lbaint_t max);
+
+/**
+ * blk_submit_read() - Start an asynchronous read from a block device
+ *
+ * The request is passed to the driver if it supports asynchronous reads and
+ * has a free slot. Otherwise (including when the requested blocks are in the
+ * block cache) it is handled synchronously and is complete on return.
+ *
+ * @dev: Device to read from
+ * @req: Request to submit, with @start, @blkcnt and @buffer filled in
+ * Return: 0 if submitted or completed, -EBUSY if the device queue is full
+ * (call blk_poll() and try again), other -ve on error
+ */
+int blk_submit_read(struct udevice *dev, struct blk_req *req);
+
+/**
+ * blk_submit_write() - Start an asynchronous write to a block device
+ *
+ * The request is passed to the driver if it supports asynchronous writes and
+ * has a free slot. Otherwise it is handled synchronously and is complete on
+ * return. The buffer must not be changed until the request is complete.
+ *
+ * @dev: Device to write to
+ * @req: Request to submit, with @start, @blkcnt and @buffer filled in
+ * Return: 0 if submitted or completed, -EBUSY if the device queue is full
+ * (call blk_poll() and try again), other -ve on error
+ */
+int blk_submit_write(struct udevice *dev, struct blk_req *req);
+
+/**
+ * blk_poll() - Check for completion of asynchronous requests
+ *
+ * This does not wait. Any completed requests have their @done member set.
+ *
+ * @dev: Device to check
+ * Return: number of requests still in flight, or -ve on error
+ */
+int blk_poll(struct udevice *dev);
+
+/**
+ * blk_wait() - Wait for an asynchronous request to complete
+ *
+ * @dev: Device the request was submitted to
+ * @req: Request to wait for
+ * Return: number of blocks read or written, or -ve on error
+ */
+long blk_wait(struct udevice *dev, struct blk_req *req);
+
+/**
+ * blk_req_complete() - Mark an asynchronous request as complete
+ *
+ * This is called by drivers when a request started with the submit_read()
+ * or submit_write() operation has finished.
+ *
+ * @dev: Device which received the request
+ * @req: Request which has completed
+ * @result: Number of blocks read or written, or -ve error number
+ */
+void blk_req_complete(struct udevice *dev, struct blk_req *req, long result);
+
 /**
  * blk_find_device() - Find a block device
  *
@@ -571,6 +831,18 @@ static inline ulong blk_derase(struct blk_desc *block_dev, lbaint_t start,
 	return block_dev->block_erase(block_dev, start, blkcnt);
 }
 
+static inline int blk_ddiscard(struct blk_desc *desc, lbaint_t start,
+			       lbaint_t blkcnt)
+{
+	return -ENOSYS;
+}
+
+static inline lbaint_t blk_write_split(struct blk_desc *desc, lbaint_t start,
+				       lbaint_t blkcnt, lbaint_t max)
+{
+	return blkcnt < max ? blkcnt : max;
+}
+
 /**
  * struct blk_driver - Driver for block interface types
  *
@@ -65,6 +65,22 @@ int blkmap_map_mem(struct udevice *dev, lbaint_t blknr, lbaint_t blkcnt,
 int blkmap_map_pmem(struct udevice *dev, lbaint_t blknr, lbaint_t blkcnt,
 		    phys_addr_t paddr);
 
+/**
+ * blkmap_get_mem() - Get a direct pointer to memory-mapped blocks
+ *
+ * This allows a caller to use the data of a memory-backed blkmap in place,
+ * e.g. a disk image downloaded into RAM, rather than reading it into another
+ * buffer. The whole range must lie within a single region of memory.
+ *
+ * @blk: Block device of the blkmap
+ * @blknr: Start block number
+ * @blkcnt: Number of blocks required
+ * @bufp: Returns a pointer to the data of block @blknr
+ * Returns: 0 on success, -ENOSYS if @blk is not a blkmap, -ENOENT if the
+ * blocks are not all backed by the same region of memory
+ */
+int blkmap_get_mem(struct udevice *blk, lbaint_t blknr, lbaint_t blkcnt,
+		   void **bufp);
 
 /**
  * blkmap_from_label() - Find blkmap from label
@@ -154,6 +154,9 @@ enum bloblist_tag_t {
 	BLOBLISTT_U_BOOT_SPL_HANDOFF	= 0xfff000, /* Hand-off info from SPL */
 	BLOBLISTT_VBE			= 0xfff001, /* VBE per-phase state */
 	BLOBLISTT_U_BOOT_VIDEO		= 0xfff002, /* Video info from SPL */
+	BLOBLISTT_U_BOOT_MMC_TUNING	= 0xfff003, /* MMC tuning results */
+	BLOBLISTT_U_BOOT_FIT_SIG	= 0xfff004, /* FIT signatures checked */
+	BLOBLISTT_U_BOOT_INDEX		= 0xfff005, /* Index of the blobs */
 };
 
 /**
@@ -232,6 +235,42 @@ enum {
 	BLOBLIST_REC_HDR_SIZE		= sizeof(struct bloblist_rec),
 };
 
+/**
+ * struct bloblist_index_ent - entry in the index of a bloblist
+ *
+ * @tag: Tag of the blob
+ * @offset: Offset of the blob's record from the start of the bloblist
+ */
+struct bloblist_index_ent {
+	u32 tag;
+	u32 offset;
+};
+
+/**
+ * struct bloblist_index - index of the blobs in a bloblist
+ *
+ * This is the contents of a BLOBLISTT_U_BOOT_INDEX blob, which is only used
+ * if it is the first blob in the bloblist, so it can be found without walking
+ * the list. It lets bloblist_find() go straight to a blob rather than stepping
+ * through every record before it. Since the offsets are relative to the
+ * bloblist header, the index remains valid when the bloblist is relocated.
+ *
+ * @count: Number of entries in use
+ * @complete: 1 if every blob added since the index was created is in it, so
+ *	that a tag which is not in the index is not in the bloblist either; 0
+ *	once the index has filled up
+ * @used_size: Used size of the bloblist when the index was last updated. If
+ *	this no longer matches, blobs have been added by software which does
+ *	not know about the index, so @complete cannot be relied on
+ * @ent: Entries, in the same order as the blobs
+ */
+struct bloblist_index {
+	u32 count;
+	u32 complete;
+	u32 used_size;
+	struct bloblist_index_ent ent[];
+};
+
 /**
  * bloblist_check_magic() - return a bloblist if the magic matches
  *
@@ -344,6 +383,19 @@ int bloblist_resize(uint tag, int new_size);
  */
 int bloblist_new(ulong addr, uint size, uint flags, uint align_log2);
 
+/**
+ * bloblist_add_index() - Add an index to a new bloblist
+ *
+ * This adds a BLOBLISTT_U_BOOT_INDEX blob, which records the position of each
+ * blob added after it. It must be the first blob in the bloblist.
+ *
+ * @count: Maximum number of blobs to record in the index
+ * Return: 0 if OK, -ENOSYS if CONFIG_BLOBLIST_INDEX is not enabled, -EEXIST if
+ *	the bloblist already has blobs in it, -ENOSPC if there is not enough
+ *	space
+ */
+int bloblist_add_index(uint count);
+
 /**
  * bloblist_check() - Check if a bloblist exists
  *
@@ -70,6 +70,19 @@ struct bootdev_hunter;
  */
 typedef int (*bootdev_hunter_func)(struct bootdev_hunter *info, bool show);
 
+/**
+ * bootdev_hunter_start_func - function to start up hardware for a hunter
+ *
+ * This is called at the start of a scan, before any hunting is done. It should
+ * kick off any slow hardware setup which then continues without the CPU, such
+ * as powering up a bus or starting autonegotiation, so that the hunt function
+ * has less to wait for later. It must not wait for that setup to finish.
+ *
+ * @info: Info structure describing this hunter
+ * Returns: 0 if OK, -ve on error (which is ignored apart from being logged)
+ */
+typedef int (*bootdev_hunter_start_func)(struct bootdev_hunter *info);
+
 /**
  * struct bootdev_hunter - information about how to hunt for bootdevs
  *
@@ -77,6 +90,8 @@ typedef int (*bootdev_hunter_func)(struct bootdev_hunter *info, bool show);
  * @uclass: Uclass ID for the media associated with this bootdev
  * @drv: bootdev driver for the things found by this hunter
  * @hunt: Function to call to hunt for bootdevs of this type (NULL if none)
+ * @start: Function to call at the start of a scan, to start up any slow
+ *	hardware needed by @hunt (NULL if none)
  *
  * Some bootdevs are not visible until other devices are enumerated. For
  * example, USB bootdevs only appear when the USB bus is enumerated.
@@ -93,6 +108,7 @@ struct bootdev_hunter {
 	enum uclass_id uclass;
 	struct driver *drv;
 	bootdev_hunter_func hunt;
+	bootdev_hunter_start_func start;
 };
 
 /* declare a new bootdev hunter */
@@ -321,6 +337,15 @@ int bootdev_hunt(const char *spec, bool show);
  */
 int bootdev_hunt_prio(enum bootdev_prio_t prio, bool show);
 
+/**
+ * bootdev_hunt_start() - Start up hardware for all hunters not yet used
+ *
+ * This calls the start() function of each hunter which has one, unless the
+ * hunter has already been used or started. It does nothing unless
+ * CONFIG_BOOTSTD_HUNT_START is enabled.
+ */
+void bootdev_hunt_start(void);
+
 /**
  * bootdev_unhunt() - Mark a device as needing to be hunted again
  *
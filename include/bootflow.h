@@ -125,6 +125,9 @@ struct bootflow {
  * before using it
  * @BOOTFLOWIF_ALL: Return bootflows with errors as well
  * @BOOTFLOWIF_HUNT: Hunt for new bootdevs using the bootdrv hunters
+ * @BOOTFLOWIF_CACHE: Try the bootflow recorded in the bootflow cache before
+ * scanning, and record each bootflow passed to bootflow_run_boot() (needs
+ * CONFIG_BOOTSTD_CACHE)
  *
  * Internal flags:
  * @BOOTFLOWIF_SINGLE_DEV: (internal) Just scan one bootdev
@@ -135,12 +138,16 @@ struct bootflow {
  * with things like "mmc1")
  * @BOOTFLOWIF_SINGLE_PARTITION: (internal) Scan one partition in media device
  * (used with things like "mmc1:3")
+ * @BOOTFLOWIF_CACHED: (internal) The current bootflow came from the cache
+ * @BOOTFLOWIF_SKIP_CACHED: (internal) The cached bootflow was tried and failed
+ * to boot, so skip it when scanning
  */
 enum bootflow_iter_flags_t {
 	BOOTFLOWIF_FIXED		= 1 << 0,
 	BOOTFLOWIF_SHOW			= 1 << 1,
 	BOOTFLOWIF_ALL			= 1 << 2,
 	BOOTFLOWIF_HUNT			= 1 << 3,
+	BOOTFLOWIF_CACHE		= 1 << 4,
 
 	/*
 	 * flags used internally by standard boot - do not set these when
@@ -151,6 +158,8 @@ enum bootflow_iter_flags_t {
 	BOOTFLOWIF_SINGLE_UCLASS	= 1 << 18,
 	BOOTFLOWIF_SINGLE_MEDIA		= 1 << 19,
 	BOOTFLOWIF_SINGLE_PARTITION	= 1 << 20,
+	BOOTFLOWIF_CACHED		= 1 << 21,
+	BOOTFLOWIF_SKIP_CACHED		= 1 << 22,
 };
 
 /**
@@ -389,6 +398,28 @@ int bootflow_run_boot(struct bootflow_iter *iter, struct bootflow *bflow);
  */
 const char *bootflow_state_get_name(enum bootflow_state_t state);
 
+/**
+ * bootflow_prefetch() - Read the cached bootflow ahead of booting it
+ *
+ * This reads the bootflow recorded in the bootflow cache, including any files
+ * which its bootmeth only reads when booting, and holds on to it. The next
+ * scan which uses the cache then takes it over instead of reading it again.
+ *
+ * This is intended to be called during the autoboot countdown
+ *
+ * Return: 0 if OK, -EALREADY if a bootflow is already prefetched, -ENOENT if
+ *	there is no cache record, other -ve on error
+ */
+int bootflow_prefetch(void);
+
+/**
+ * bootflow_prefetch_drop() - Drop any prefetched bootflow
+ *
+ * This frees the bootflow read by bootflow_prefetch(), if it is still held,
+ * e.g. because autoboot was interrupted
+ */
+void bootflow_prefetch_drop(void);
+
 /**
  * bootflow_remove() - Remove a bootflow and free its memory
  *
@@ -407,6 +438,16 @@ void bootflow_remove(struct bootflow *bflow);
  */
 int bootflow_iter_check_blk(const struct bootflow_iter *iter);
 
+/**
+ * bootflow_iter_check_fs() - Check that a bootflow uses a filesystem device
+ *
+ * This checks the bootdev in the bootflow to make sure it is a filesystem
+ * which is not on a block device, such as a virtio-fs share
+ *
+ * Return: 0 if OK, -ENOTSUPP if some other device is used (e.g. MMC)
+ */
+int bootflow_iter_check_fs(const struct bootflow_iter *iter);
+
 /**
  * bootflow_iter_check_sf() - Check that a bootflow uses SPI FLASH
  *
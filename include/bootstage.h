@@ -476,6 +476,157 @@ static inline int bootstage_unstash_default(void)
 	return 0;
 }
 
+/**
+ * enum bootstage_prof_type - Type of item recorded by the boot profile
+ *
+ * @BOOTSTAGE_PROF_PROBE: Device probe, named after the device
+ * @BOOTSTAGE_PROF_INITCALL: board_init_f() / board_init_r() initcall
+ */
+enum bootstage_prof_type {
+	BOOTSTAGE_PROF_PROBE,
+	BOOTSTAGE_PROF_INITCALL,
+};
+
+/**
+ * struct bootstage_prof_mark - Start of an item being profiled
+ *
+ * This is filled in by bootstage_prof_start() and passed to
+ * bootstage_prof_end(). It lives on the caller's stack so that profiled items
+ * can nest.
+ *
+ * @start_us: Time when the item started
+ * @outer_us: Time already spent in nested items of the enclosing item
+ */
+struct bootstage_prof_mark {
+	ulong start_us;
+	ulong outer_us;
+};
+
+#if !defined(USE_HOSTCC) && CONFIG_IS_ENABLED(BOOTSTAGE_PROFILE)
+/**
+ * bootstage_prof_start() - Start timing an item for the boot profile
+ *
+ * @mark: Returns the start information, to pass to bootstage_prof_end()
+ */
+void bootstage_prof_start(struct bootstage_prof_mark *mark);
+
+/**
+ * bootstage_prof_end() - Finish timing an item and record it
+ *
+ * The time recorded excludes any items started and ended in between, so that
+ * (for example) a parent device is not blamed for the time taken by its
+ * children
+ *
+ * @mark: Start information from bootstage_prof_start()
+ * @type: Type of item
+ * @name: Name of the item, or NULL to use @addr
+ * @addr: Address of the item (e.g. initcall function), used if @name is NULL
+ */
+void bootstage_prof_end(struct bootstage_prof_mark *mark,
+			enum bootstage_prof_type type, const char *name,
+			ulong addr);
+
+/**
+ * bootstage_prof_report() - Print the slowest items in the boot profile
+ *
+ * @count: Maximum number of items to print
+ */
+void bootstage_prof_report(int count);
+#else
+static inline void bootstage_prof_start(struct bootstage_prof_mark *mark)
+{
+}
+
+static inline void bootstage_prof_end(struct bootstage_prof_mark *mark,
+				      enum bootstage_prof_type type,
+				      const char *name, ulong addr)
+{
+}
+
+static inline void bootstage_prof_report(int count)
+{
+}
+#endif
+
+/**
+ * enum bootstage_pipe_stage - Stage of the boot pipeline handling an image
+ *
+ * @BOOTSTAGE_PIPE_BLK: Reading blocks from a block device
+ * @BOOTSTAGE_PIPE_FS: Reading a file from a filesystem (includes its block
+ *	reads)
+ * @BOOTSTAGE_PIPE_HASH: Checking the hash of an image
+ * @BOOTSTAGE_PIPE_VERIFY: Checking the signature of an image or configuration
+ * @BOOTSTAGE_PIPE_DECOMP: Decompressing an image
+ * @BOOTSTAGE_PIPE_COPY: Copying an uncompressed image to its load address
+ * @BOOTSTAGE_PIPE_COUNT: Number of stages
+ */
+enum bootstage_pipe_stage {
+	BOOTSTAGE_PIPE_BLK,
+	BOOTSTAGE_PIPE_FS,
+	BOOTSTAGE_PIPE_HASH,
+	BOOTSTAGE_PIPE_VERIFY,
+	BOOTSTAGE_PIPE_DECOMP,
+	BOOTSTAGE_PIPE_COPY,
+
+	BOOTSTAGE_PIPE_COUNT,
+};
+
+#if !defined(USE_HOSTCC) && CONFIG_IS_ENABLED(BOOTSTAGE_PIPELINE)
+/**
+ * bootstage_pipe_image() - Select the image which pipeline stages count against
+ *
+ * Stages recorded after this call are added to the totals for @name, until
+ * another image is selected. Images with the same name share their totals.
+ *
+ * @name: Name of the image (e.g. the file or FIT subimage being loaded), or
+ *	NULL to count stages against no particular image
+ */
+void bootstage_pipe_image(const char *name);
+
+/**
+ * bootstage_pipe_start() - Start timing a pipeline stage
+ *
+ * Return: start time, to pass to bootstage_pipe_end()
+ */
+ulong bootstage_pipe_start(void);
+
+/**
+ * bootstage_pipe_end() - Finish timing a pipeline stage and record it
+ *
+ * @stage: Stage which was run
+ * @start_us: Start time from bootstage_pipe_start()
+ * @in_bytes: Number of bytes consumed by the stage
+ * @out_bytes: Number of bytes produced by the stage, e.g. the uncompressed
+ *	size for BOOTSTAGE_PIPE_DECOMP; 0 if the same as @in_bytes
+ */
+void bootstage_pipe_end(enum bootstage_pipe_stage stage, ulong start_us,
+			ulong in_bytes, ulong out_bytes);
+
+/**
+ * bootstage_pipe_report() - Print the time and throughput of each stage
+ */
+void bootstage_pipe_report(void);
+#else
+static inline void bootstage_pipe_image(const char *name)
+{
+}
+
+static inline ulong bootstage_pipe_start(void)
+{
+	return 0;
+}
+
+static inline void bootstage_pipe_end(enum bootstage_pipe_stage stage,
+				      ulong start_us, ulong in_bytes,
+				      ulong out_bytes)
+{
+}
+
+static inline void bootstage_pipe_report(void)
+{
+}
+#endif
+
 /* Helper macro for adding a bootstage to a line of code */
 #define BOOTSTAGE_MARKER()	\
 		bootstage_mark_code(__FILE__, __func__, __LINE__)
@@ -37,6 +37,12 @@ struct udevice;
  * @theme: Node containing the theme information
  * @hunters_used: Bitmask of used hunters, indexed by their position in the
  * linker list. The bit is set if the hunter has been used already
+ * @hunters_started: Bitmask of hunters whose start() function has been called,
+ * indexed in the same way as @hunters_used
+ * @prefetch: Cached bootflow read during the autoboot countdown, or NULL if
+ * none (see CONFIG_BOOTSTD_PREFETCH)
+ * @probes: List of struct bootstd_probe, holding the files looked for during
+ * the current scan (see CONFIG_BOOTSTD_PROBE_CACHE)
  */
 struct bootstd_priv {
 	const char **prefixes;
@@ -50,6 +56,32 @@ struct bootstd_priv {
 	struct udevice *vbe_bootmeth;
 	ofnode theme;
 	uint hunters_used;
+	uint hunters_started;
+	struct bootflow *prefetch;
+	struct list_head probes;
+};
+
+/**
+ * struct bootstd_probe - The result of looking for a file on a partition
+ *
+ * Bootmeths look for the same few files on every partition, so the results are
+ * remembered for the rest of the scan and shared between bootmeths
+ *
+ * @node: Entry in bootstd_priv->probes
+ * @blk: Block device holding the partition
+ * @part: Partition number (0 for the whole device)
+ * @path: Path looked for, or NULL to record whether the partition has a
+ * filesystem at all
+ * @ret: 0 if found, else the -ve error from looking
+ * @size: Size of the file, if found
+ */
+struct bootstd_probe {
+	struct list_head node;
+	struct udevice *blk;
+	int part;
+	char *path;
+	int ret;
+	loff_t size;
 };
 
 /**
@@ -96,6 +128,40 @@ int bootstd_get_priv(struct bootstd_priv **stdp);
  */
 void bootstd_clear_glob(void);
 
+/**
+ * bootstd_find_probe() - Find an earlier result of looking for a file
+ *
+ * @blk: Block device holding the partition
+ * @part: Partition number
+ * @path: Path looked for, or NULL for the partition's filesystem
+ * Return: the result, or NULL if there is none (always NULL if
+ * CONFIG_BOOTSTD_PROBE_CACHE is not enabled)
+ */
+struct bootstd_probe *bootstd_find_probe(struct udevice *blk, int part,
+					 const char *path);
+
+/**
+ * bootstd_add_probe() - Record the result of looking for a file
+ *
+ * This does nothing if CONFIG_BOOTSTD_PROBE_CACHE is not enabled, or there is
+ * no memory, since the result can always be worked out again
+ *
+ * @blk: Block device holding the partition
+ * @part: Partition number
+ * @path: Path looked for, or NULL for the partition's filesystem
+ * @ret: 0 if found, else -ve error
+ * @size: Size of the file, if found
+ */
+void bootstd_add_probe(struct udevice *blk, int part, const char *path,
+		       int ret, loff_t size);
+
+/**
+ * bootstd_clear_probes() - Forget all the files looked for
+ *
+ * This is called at the start and end of each scan, and before booting
+ */
+void bootstd_clear_probes(void);
+
 /**
  * bootstd_prog_boot() - Run standard boot in a fully programmatic mode
  *
@@ -51,6 +51,8 @@ struct bounce_buffer {
 	size_t len_aligned;
 	/* Copy of flags parameter passed to start() */
 	unsigned int flags;
+	/* Alignment of .bounce_buffer, if it was allocated */
+	size_t alignment;
 };
 
 /**
@@ -77,6 +79,24 @@ int bounce_buffer_start_extalign(struct bounce_buffer *state, void *data,
 				 size_t alignment,
 				 int (*addr_is_aligned)(struct bounce_buffer *state));
 
+/**
+ * bounce_buffer_start_align() -- Start a session, given the controller's needs
+ * state:	stores state passed between bounce_buffer_{start,stop}
+ * data:	pointer to buffer to be aligned
+ * len:		length of the buffer
+ * flags:	flags describing the transaction, see above.
+ * dma_align:	alignment which the DMA controller needs for the buffer address,
+ *		which must be a power of two
+ *
+ * Many controllers can transfer to a buffer with only a small alignment, e.g.
+ * 4 bytes. Where no cache maintenance is needed for DMA, @data is used directly
+ * if it meets @dma_align. Otherwise this behaves like bounce_buffer_start(),
+ * since the buffer must not share cache lines with other data.
+ */
+int bounce_buffer_start_align(struct bounce_buffer *state, void *data,
+			      size_t len, unsigned int flags,
+			      unsigned int dma_align);
+
 /**
  * bounce_buffer_stop() -- Finish the bounce buffer session
  * state:	stores state passed between bounce_buffer_{start,stop}
@@ -165,6 +165,7 @@ struct cbfs_payload {
 
 struct cbfs_cachenode {
 	struct cbfs_cachenode *next;
+	struct cbfs_cachenode *hash_next;
 	void *data;
 	char *name;
 	u32 type;
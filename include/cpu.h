@@ -56,6 +56,40 @@ struct cpu_info {
 	uint address_width;
 };
 
+/**
+ * enum cpu_perf - Performance level for a CPU
+ *
+ * @CPU_PERF_OS: Level set by the platform's policy, which the OS expects to
+ *	find the CPU running at
+ * @CPU_PERF_BOOT: Highest level which is safe to run at while booting
+ */
+enum cpu_perf {
+	CPU_PERF_OS,
+	CPU_PERF_BOOT,
+};
+
+/**
+ * struct cpu_job - a piece of work which can be run on another CPU
+ *
+ * The job function must not use the console, driver model or anything else
+ * which is not safe to access from more than one CPU at a time. It should
+ * just work on the memory it is given, e.g. to calculate a hash.
+ *
+ * @func: Function to run, returning 0 if OK or -ve on error
+ * @priv: Private data for the job
+ * @dev: CPU which ran the job (UCLASS_CPU), or NULL if it was run by the
+ *	current CPU
+ * @ret: Value returned by @func, valid once @done is true
+ * @done: true once the job has finished
+ */
+struct cpu_job {
+	int (*func)(struct cpu_job *job);
+	void *priv;
+	struct udevice *dev;
+	int ret;
+	bool done;
+};
+
 struct cpu_ops {
 	/**
 	 * get_desc() - Get a description string for a CPU
@@ -102,6 +136,45 @@ struct cpu_ops {
 	 *         if not.
 	 */
 	int (*is_current)(struct udevice *dev);
+
+	/**
+	 * start_job() - Start running a job on this CPU
+	 *
+	 * The CPU should call cpu_job_run() on the job and then look for more
+	 * work. This method is optional.
+	 *
+	 * @dev:	Device to use (UCLASS_CPU)
+	 * @job:	Job to run
+	 * @return 0 if started, -EBUSY if the CPU is already running a job,
+	 *	other -ve on error
+	 */
+	int (*start_job)(struct udevice *dev, struct cpu_job *job);
+
+	/**
+	 * can_start_job() - Check if this CPU can be given jobs at present
+	 *
+	 * This tells whether start_job() would work when the CPU is idle, e.g.
+	 * whether it has been started and is waiting for work. It does not
+	 * start anything. This method is optional; if absent, any CPU with
+	 * start_job() is assumed to be able to run jobs.
+	 *
+	 * @dev:	Device to check (UCLASS_CPU)
+	 * @return true if jobs can be started on the CPU, false if not
+	 */
+	bool (*can_start_job)(struct udevice *dev);
+
+	/**
+	 * set_perf() - Set the performance level of a CPU
+	 *
+	 * This sets the CPU clock and, where needed, its supply voltage.
+	 * When raising the level the voltage must be raised before the clock,
+	 * and when lowering it, afterwards. This method is optional.
+	 *
+	 * @dev:	Device to update (UCLASS_CPU)
+	 * @perf:	Level to set
+	 * @return 0 if OK, -ve on error
+	 */
+	int (*set_perf)(struct udevice *dev, enum cpu_perf perf);
 };
 
 #define cpu_get_ops(dev)        ((struct cpu_ops *)(dev)->driver->ops)
@@ -164,4 +237,111 @@ int cpu_is_current(struct udevice *cpu);
  */
 struct udevice *cpu_get_current_dev(void);
 
+/**
+ * cpu_set_perf() - Set the performance level of a CPU
+ *
+ * @dev:	Device to update (UCLASS_CPU)
+ * @perf:	Level to set
+ * Return: 0 if OK, -ENOSYS if not supported, other -ve on error
+ */
+int cpu_set_perf(struct udevice *dev, enum cpu_perf perf);
+
+#if CONFIG_IS_ENABLED(CPU_BOOT_BOOST)
+/**
+ * cpu_boot_boost() - Run all CPUs at their boot performance level
+ *
+ * This is called early in board_f. Nothing is changed if any thermal sensor
+ * reads CONFIG_CPU_BOOT_BOOST_MAX_TEMP or more.
+ *
+ * Return: 0 if OK, -EAGAIN if too hot, other -ve on error
+ */
+int cpu_boot_boost(void);
+
+/**
+ * cpu_boot_restore() - Put all CPUs back to the level the OS expects
+ *
+ * This is called just before the OS is started. It does nothing unless
+ * a CPU was boosted.
+ *
+ * Return: 0 if OK, -ve on error
+ */
+int cpu_boot_restore(void);
+#else
+static inline int cpu_boot_boost(void)
+{
+	return 0;
+}
+
+static inline int cpu_boot_restore(void)
+{
+	return 0;
+}
+#endif
+
+/**
+ * cpu_job_run() - Run a job and mark it as done
+ *
+ * This is called by the CPU running the job
+ *
+ * @job:	Job to run
+ */
+static inline void cpu_job_run(struct cpu_job *job)
+{
+	job->ret = job->func(job);
+
+	/* Make sure the results are visible before the job is seen as done */
+	__atomic_store_n(&job->done, true, __ATOMIC_RELEASE);
+}
+
+#if CONFIG_IS_ENABLED(CPU_JOBS)
+/**
+ * cpu_job_start() - Start a job on an idle CPU
+ *
+ * This looks for a CPU other than the current one which can run the job. If
+ * there is none, the job is run straight away on the current CPU, so the
+ * caller does not need to handle that case.
+ *
+ * @job:	Job to run, with @func and @priv set up
+ * Return: 0 if OK, -ve on error
+ */
+int cpu_job_start(struct cpu_job *job);
+
+/**
+ * cpu_job_wait() - Wait for a job to finish
+ *
+ * @job:	Job to wait for, which must have been started
+ * Return: value returned by the job function
+ */
+int cpu_job_wait(struct cpu_job *job);
+
+/**
+ * cpu_job_cpus() - Get the number of CPUs which can run jobs
+ *
+ * This can be used to decide how many pieces to split some work into. It
+ * counts the current CPU, which runs a job when no other CPU is free, and the
+ * other CPUs which are able to take jobs at present.
+ *
+ * Return: number of CPUs, at least 1
+ */
+int cpu_job_cpus(void);
+#else
+static inline int cpu_job_start(struct cpu_job *job)
+{
+	job->dev = NULL;
+	cpu_job_run(job);
+
+	return 0;
+}
+
+static inline int cpu_job_wait(struct cpu_job *job)
+{
+	return job->ret;
+}
+
+static inline int cpu_job_cpus(void)
+{
+	return 1;
+}
+#endif
+
 #endif
@@ -85,6 +85,22 @@ enum {
  */
 int cleanup_before_linux_select(int flags);
 
+#if CONFIG_IS_ENABLED(CPU_IDLE)
+/**
+ * cpu_idle() - Let the CPU rest briefly in a polling loop
+ *
+ * Loops which poll for something and found nothing to do can call this to wait
+ * for the next interrupt or event instead of spinning. It always returns within
+ * a short time (well under a millisecond), even if nothing happens, so the
+ * caller must still check its condition and any timeout itself.
+ */
+void cpu_idle(void);
+#else
+static inline void cpu_idle(void)
+{
+}
+#endif
+
 void reset_cpu(void);
 
 #endif
@@ -0,0 +1,152 @@
+/* SPDX-License-Identifier: GPL-2.0+ */
+/*
+ * eMMC Command Queueing Host Controller Interface (CQHCI)
+ *
+ * Register layout from JEDEC JESD84-B51, appendix B
+ */
+
+#ifndef __CQHCI_H
+#define __CQHCI_H
+
+#include <mmc.h>
+#include <linux/sizes.h>
+#include <linux/types.h>
+
+#define CQHCI_NUM_SLOTS		32
+
+/* registers, relative to the start of the CQHCI block */
+#define CQHCI_CAP		0x04
+#define CQHCI_CFG		0x08
+#define  CQHCI_DCMD		BIT(12)
+#define  CQHCI_TASK_DESC_SZ	BIT(8)
+#define  CQHCI_ENABLE		BIT(0)
+#define CQHCI_CTL		0x0c
+#define  CQHCI_CLEAR_ALL_TASKS	BIT(8)
+#define  CQHCI_HALT		BIT(0)
+#define CQHCI_IS		0x10
+#define CQHCI_ISTE		0x14
+#define CQHCI_ISGE		0x18
+#define  CQHCI_IS_TERR		BIT(4)
+#define  CQHCI_IS_TCL		BIT(3)
+#define  CQHCI_IS_RED		BIT(2)
+#define  CQHCI_IS_TCC		BIT(1)
+#define  CQHCI_IS_HAC		BIT(0)
+#define  CQHCI_IS_MASK		(CQHCI_IS_TERR | CQHCI_IS_TCL | \
+				 CQHCI_IS_RED | CQHCI_IS_TCC | CQHCI_IS_HAC)
+#define  CQHCI_IS_ERROR		(CQHCI_IS_TERR | CQHCI_IS_RED)
+#define CQHCI_TDLBA		0x20
+#define CQHCI_TDLBAU		0x24
+#define CQHCI_TDBR		0x28
+#define CQHCI_TCN		0x2c
+#define CQHCI_TCLR		0x38
+#define CQHCI_SSC2		0x44
+#define CQHCI_TERRI		0x54
+
+/* descriptor fields */
+#define CQHCI_VALID		BIT(0)
+#define CQHCI_END		BIT(1)
+#define CQHCI_INT		BIT(2)
+#define CQHCI_ACT(x)		((x) << 3)
+#define  CQHCI_ACT_TRAN		0x4
+#define  CQHCI_ACT_TASK		0x5
+#define  CQHCI_ACT_LINK		0x6
+#define CQHCI_DATA_DIR		BIT(12)
+#define CQHCI_BLK_COUNT(x)	((x) << 16)
+#define CQHCI_DAT_LENGTH(x)	((x) << 16)
+
+/* largest transfer descriptor, which must not cross this boundary */
+#define CQHCI_SEG_SIZE		SZ_32K
+/* transfer descriptors for each task */
+#define CQHCI_MAX_SEGS		32
+
+/**
+ * struct cqhci_slot - a task which the engine is working on
+ *
+ * @addr: DMA address of the buffer
+ * @len: Length of the buffer in bytes
+ * @read: true if the engine writes to the buffer
+ */
+struct cqhci_slot {
+	dma_addr_t addr;
+	uint len;
+	bool read;
+};
+
+/**
+ * struct cqhci_host - a CQHCI command-queue engine
+ *
+ * The first three fields are set up by the controller driver before calling
+ * cqhci_init()
+ *
+ * @base: Address of the CQHCI registers
+ * @dma64: true to use 64-bit addresses in descriptors
+ * @task_desc_128: true if the engine needs 128-bit task descriptors
+ * @mmc: MMC device which the engine belongs to
+ * @task_desc_len: Length of each task descriptor in bytes
+ * @link_desc_len: Length of each link descriptor in bytes
+ * @trans_desc_len: Length of each transfer descriptor in bytes
+ * @desc_base: Task-descriptor list, each task followed by a link descriptor
+ * @trans_base: Transfer descriptors, CQHCI_MAX_SEGS for each slot
+ * @slot: Tasks which have been issued to the engine
+ */
+struct cqhci_host {
+	void __iomem *base;
+	bool dma64;
+	bool task_desc_128;
+
+	struct mmc *mmc;
+	uint task_desc_len;
+	uint link_desc_len;
+	uint trans_desc_len;
+	void *desc_base;
+	void *trans_base;
+	struct cqhci_slot slot[CQHCI_NUM_SLOTS];
+};
+
+/**
+ * cqhci_init() - Set up a command-queue engine
+ *
+ * This allocates the descriptor lists and sets @cfg->cqe_b_max so that the
+ * MMC core knows the engine is available
+ *
+ * @cq: Engine to set up, with @base, @dma64 and @task_desc_128 filled in
+ * @mmc: MMC device which the engine belongs to
+ * @cfg: Configuration of the MMC device
+ * Return: 0 if OK, -ENOMEM if out of memory
+ */
+int cqhci_init(struct cqhci_host *cq, struct mmc *mmc, struct mmc_config *cfg);
+
+/**
+ * cqhci_enable() - Start or stop a command-queue engine
+ *
+ * Stopping the engine discards any tasks which have not finished
+ *
+ * @cq: Engine to update
+ * @enable: true to start the engine, false to stop it
+ * Return: 0 if OK, -ETIMEDOUT if the engine did not halt
+ */
+int cqhci_enable(struct cqhci_host *cq, bool enable);
+
+/**
+ * cqhci_request() - Issue a task to a command-queue engine
+ *
+ * @cq: Engine to use
+ * @tag: Slot to use, which must be free
+ * @start: First block to transfer
+ * @data: Buffer and size of the transfer
+ * Return: 0 if OK, -E2BIG if the transfer is too large for a single task
+ */
+int cqhci_request(struct cqhci_host *cq, uint tag, lbaint_t start,
+		  struct mmc_data *data);
+
+/**
+ * cqhci_poll() - Check which tasks a command-queue engine has finished
+ *
+ * @cq: Engine to check
+ * @donep: Returns a bitmask of the slots which finished successfully
+ * @errp: Returns a bitmask of the slots which failed
+ * Return: 0 if OK, -EIO if the engine reported an error and must be stopped
+ */
+int cqhci_poll(struct cqhci_host *cq, ulong *donep, ulong *errp);
+
+#endif
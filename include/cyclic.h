@@ -124,4 +124,17 @@ static inline int cyclic_unregister_all(void)
 }
 #endif
 
+/**
+ * schedule_hot() - Schedule waiting tasks from a hot loop
+ *
+ * This is for loops which call schedule() often only to keep the watchdog
+ * alive. With CONFIG_WATCHDOG_TIMER_IRQ the watchdog is serviced from a timer
+ * interrupt instead, so this does nothing.
+ */
+static inline void schedule_hot(void)
+{
+	if (!IS_ENABLED(CONFIG_WATCHDOG_TIMER_IRQ))
+		schedule();
+}
+
 #endif
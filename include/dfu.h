@@ -119,6 +119,11 @@ struct dfu_entity {
 	enum dfu_device_type    dev_type;
 	enum dfu_layout         layout;
 	unsigned long           max_buf_size;
+	/*
+	 * write_medium() may be given any part of the buffer starting at a
+	 * multiple of this many bytes. 0 means only whole buffers.
+	 */
+	unsigned long           write_align;
 
 	union {
 		struct mmc_internal_data mmc;
@@ -154,6 +159,11 @@ struct dfu_entity {
 	u64 r_left;
 	long b_left;
 
+	/* full buffer still being written, see dfu_write_pending() */
+	u8 *p_buf;
+	long p_left;
+	int p_err;
+
 	u32 bad_skip;	/* for nand use */
 
 	unsigned int inited:1;
@@ -361,6 +371,20 @@ int dfu_write(struct dfu_entity *de, void *buf, int size, int blk_seq_num);
  */
 int dfu_flush(struct dfu_entity *de, void *buf, int size, int blk_seq_num);
 
+/**
+ * dfu_write_pending() - write some buffered data to the medium
+ *
+ * With CONFIG_DFU_WRITE_BACKGROUND, dfu_write() hands a full buffer over to
+ * be written and carries on receiving into a second buffer. This writes the
+ * next part of the full buffer, at most CONFIG_DFU_WRITE_CHUNK bytes if the
+ * medium allows it, so that the caller can handle USB in between. It must
+ * be called regularly while downloading. An error is reported by the next
+ * call to dfu_write() or dfu_flush().
+ *
+ * Return:		true if there is more to write
+ */
+bool dfu_write_pending(void);
+
 /**
  * dfu_initiated_callback() - weak callback called on DFU transaction start
  *
@@ -241,6 +241,18 @@ int acpi_write_dev_tables(struct acpi_ctx *ctx);
  */
 int acpi_fill_ssdt(struct acpi_ctx *ctx);
 
+/**
+ * acpi_fill_ssdt_cached() - Generate ACPI tables for SSDT, using a cache
+ *
+ * This is the same as acpi_fill_ssdt() but copies the code from the last
+ * boot if the devicetree and U-Boot build have not changed. It is provided
+ * by x86 with CONFIG_ACPI_SSDT_CACHE
+ *
+ * @ctx: ACPI context to use
+ * Return: 0 if OK, -ve on error
+ */
+int acpi_fill_ssdt_cached(struct acpi_ctx *ctx);
+
 /**
  * acpi_inject_dsdt() - Generate ACPI tables for DSDT
  *
@@ -0,0 +1,112 @@
+/* SPDX-License-Identifier: GPL-2.0+ */
+/*
+ * Devicetree nodes to bind in U-Boot proper, worked out at build time
+ */
+
+#ifndef _DM_BIND_LIST_H
+#define _DM_BIND_LIST_H
+
+#include <dm/ofnode_decl.h>
+#include <linux/types.h>
+
+struct driver;
+struct udevice;
+
+/**
+ * DM_BIND_DRIVER() - Declare a driver which may not be built in
+ *
+ * The reference is weak, so DM_DRIVER_REF() gives NULL if the driver is not
+ * part of the build.
+ *
+ * @_name: Name of the driver, as passed to U_BOOT_DRIVER()
+ */
+#define DM_BIND_DRIVER(_name)					\
+	extern struct driver _u_boot_list_2_driver_2_##_name	\
+		__attribute__((weak))
+
+/**
+ * struct dm_bind_entry - A devicetree node with a compatible string
+ *
+ * Nodes are numbered in the order in which they appear in the devicetree,
+ * with the root node being 0.
+ *
+ * @node: Number of the node
+ * @parent: Number of its parent node
+ * @compat: Compatible string which selects @drv, or NULL if none
+ * @drv: Driver to bind, or NULL to search for one at runtime
+ */
+struct dm_bind_entry {
+	int node;
+	int parent;
+	const char *compat;
+	struct driver *drv;
+};
+
+/**
+ * struct dm_bind_list - Devicetree nodes to bind, with their drivers
+ *
+ * This is generated by dtoc from the control devicetree when
+ * CONFIG_DM_BIND_LIST is enabled.
+ *
+ * @entries: Nodes to bind, sorted by parent, then in devicetree order
+ * @count: Number of entries
+ * @node_count: Number of nodes in the devicetree
+ * @fdt_size: Total size of the blob the list was generated from
+ * @fdt_crc32: CRC32 of the blob the list was generated from
+ */
+struct dm_bind_list {
+	const struct dm_bind_entry *entries;
+	int count;
+	int node_count;
+	unsigned int fdt_size;
+	unsigned int fdt_crc32;
+};
+
+extern const struct dm_bind_list dm_bind_list;
+
+/**
+ * dm_bind_list_start() - Start binding devices from the list
+ *
+ * This checks that the control devicetree is the one the list was generated
+ * from, then numbers its nodes. It is only done after relocation, since
+ * it needs a pointer for each node.
+ *
+ * Return: 0 if OK, -EAGAIN if not relocated yet, -ENOENT if the control
+ *	devicetree does not match, -ENOMEM if out of memory, -ESTALE if the
+ *	tree has changed since it was loaded
+ */
+int dm_bind_list_start(void);
+
+/**
+ * dm_bind_list_end() - Stop binding devices from the list
+ *
+ * Nodes may be added or moved once the initial devices are bound, so after
+ * this, devices are bound by scanning the devicetree as normal.
+ */
+void dm_bind_list_end(void);
+
+/**
+ * dm_bind_list_find() - Find the number of a devicetree node
+ *
+ * @node: Node to look up
+ * Return: number of the node, or -ENOENT if not found or the list is not in
+ *	use
+ */
+int dm_bind_list_find(ofnode node);
+
+/**
+ * dm_bind_list_scan() - Bind devices for the subnodes of a node
+ *
+ * This does the same as scanning the subnodes and calling lists_bind_fdt()
+ * for each, but without looking at the nodes which have no compatible
+ * string or searching through the drivers
+ *
+ * @parent: Parent device for the devices that will be created
+ * @idx: Number of the parent node, from dm_bind_list_find()
+ * @pre_reloc_only: If true, bind only drivers with the DM_FLAG_PRE_RELOC
+ *	flag. If false bind all drivers.
+ * Return: 0 if OK, -ve on error
+ */
+int dm_bind_list_scan(struct udevice *parent, int idx, bool pre_reloc_only);
+
+#endif
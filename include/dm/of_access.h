@@ -258,6 +258,9 @@ struct device_node *of_find_node_by_prop_value(struct device_node *from,
 /**
  * of_find_node_by_phandle() - Find a node given a phandle
  *
+ * With CONFIG_OF_PHANDLE_CACHE the result is cached, along with the nodes
+ * of any other phandles seen during the search.
+ *
  * @root:	root node to start from (NULL for default device tree)
  * @handle:	phandle of the node to find
  *
@@ -615,4 +618,55 @@ int of_remove_property(struct device_node *np, struct property *prop);
  */
 int of_remove_node(struct device_node *to_remove);
 
+/**
+ * of_phandle_cache_inval() - Forget all cached phandle lookups
+ *
+ * This must be called when nodes are removed from a tree or a tree is freed,
+ * since the cache holds pointers to nodes.
+ */
+#if CONFIG_IS_ENABLED(OF_PHANDLE_CACHE)
+void of_phandle_cache_inval(void);
+#else
+static inline void of_phandle_cache_inval(void) {}
+#endif
+
+/**
+ * of_atoms_init() - Intern the property names of the control devicetree
+ *
+ * This sets up a table of property-name atoms for @blob and replaces the
+ * name of each property in @root with its atom, so that of_find_property()
+ * can compare pointers instead of strings. Any previous table is dropped.
+ *
+ * @blob: Flat tree that @root was unflattened from
+ * @root: Root of the live tree
+ * Return: 0 if OK, -ENOMEM if out of memory
+ */
+#if CONFIG_IS_ENABLED(OF_LIVE_ATOMS)
+int of_atoms_init(const void *blob, struct device_node *root);
+#else
+static inline int of_atoms_init(const void *blob, struct device_node *root)
+{
+	return 0;
+}
+#endif
+
+/**
+ * of_atoms_intern() - Intern the property names of another live tree
+ *
+ * Any tree unflattened from the blob passed to of_atoms_init() must have its
+ * property names interned too, since of_find_property() relies on every name
+ * in that blob's strings block being an atom. This does nothing for trees
+ * from other blobs.
+ *
+ * @blob: Flat tree that @root was unflattened from
+ * @root: Root of the live tree
+ */
+#if CONFIG_IS_ENABLED(OF_LIVE_ATOMS)
+void of_atoms_intern(const void *blob, struct device_node *root);
+#else
+static inline void of_atoms_intern(const void *blob, struct device_node *root)
+{
+}
+#endif
+
 #endif
@@ -66,6 +66,7 @@ enum uclass_id {
 	UCLASS_FFA_EMUL,		/* sandbox FF-A device emulator */
 	UCLASS_FIRMWARE,	/* Firmware */
 	UCLASS_FPGA,		/* FPGA device */
+	UCLASS_FS,		/* Filesystem not on a block device */
 	UCLASS_FUZZING_ENGINE,	/* Fuzzing engine */
 	UCLASS_FS_FIRMWARE_LOADER,		/* Generic loader */
 	UCLASS_FWU_MDATA,	/* FWU Metadata Access */
@@ -30,12 +30,17 @@
  * @dev_head: List of devices in this uclass (devices are attached to their
  * uclass when their bind method is called)
  * @sibling_node: Next uclass in the linked list of uclasses
+ * @cache: Recent results of device lookups by seq, ofnode, name or phandle,
+ * NULL if none yet (do not access outside driver model)
  */
 struct uclass {
 	void *priv_;
 	struct uclass_driver *uc_drv;
 	struct list_head dev_head;
 	struct list_head sibling_node;
+#if CONFIG_IS_ENABLED(DM_UCLASS_CACHE)
+	struct uclass_cache *cache;
+#endif
 };
 
 struct driver;
@@ -342,4 +342,32 @@ static inline int dma_memcpy(void *dst, void *src, size_t len)
 	return -ENOSYS;
 }
 #endif /* CONFIG_DMA */
+
+#if CONFIG_IS_ENABLED(DMA_BULK_COPY)
+/**
+ * dma_bulk_copy() - Copy a large block of memory using DMA, if possible
+ *
+ * This uses the first DMA device which supports memory-to-memory transfers.
+ * The caches are cleaned and invalidated as needed. Any part of @dst which
+ * does not start or end on a cache line is copied by the CPU.
+ *
+ * Nothing is copied on failure, so the caller should do the copy itself,
+ * e.g. with memmove().
+ *
+ * @dst: Destination pointer
+ * @src: Source pointer
+ * @len: Number of bytes to copy
+ * Return: 0 if copied, -EINVAL if @len is smaller than
+ *	CONFIG_DMA_BULK_COPY_MIN, the regions overlap or they are not aligned
+ *	in the same way, other -ve value if there is no suitable DMA device or
+ *	the transfer failed
+ */
+int dma_bulk_copy(void *dst, const void *src, size_t len);
+#else
+static inline int dma_bulk_copy(void *dst, const void *src, size_t len)
+{
+	return -ENOSYS;
+}
+#endif
+
 #endif	/* _DMA_H_ */
@@ -123,6 +123,8 @@
 #define DWMCI_IDMAC_CH		(1 << 4)
 #define DWMCI_IDMAC_FS		(1 << 3)
 #define DWMCI_IDMAC_LD		(1 << 2)
+/* IDMAC buffers must be aligned to the host data width, at most 64 bits */
+#define DWMCI_IDMAC_ALIGN	8
 
 /*  Bus Mode Register */
 #define DWMCI_BMOD_IDMAC_RESET	(1 << 0)
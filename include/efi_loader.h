@@ -17,6 +17,7 @@
 #include <pe.h>
 #include <linux/list.h>
 #include <linux/oid_registry.h>
+#include <u-boot/sha512.h>
 
 struct blk_desc;
 struct jmp_buf_data;
@@ -285,6 +286,8 @@ extern const efi_guid_t efi_guid_host_dev;
 #endif
 /* GUID of the EFI_BLOCK_IO_PROTOCOL */
 extern const efi_guid_t efi_block_io_guid;
+/* GUID of the EFI_BLOCK_IO2_PROTOCOL */
+extern const efi_guid_t efi_block_io2_guid;
 extern const efi_guid_t efi_global_variable_guid;
 extern const efi_guid_t efi_guid_console_control;
 extern const efi_guid_t efi_guid_device_path;
@@ -961,14 +964,22 @@ efi_status_t efi_bootmgr_load(efi_handle_t *handle, void **load_options);
  *
  * @max:	Maximum number of regions
  * @num:	Number of regions
+ * @hash_algo:	Algorithm used for @hash, or NULL if not calculated yet
+ * @hash_len:	Length of @hash
+ * @hash:	Digest of the regions, see efi_image_regions_hash()
  * @reg:	array of regions
  */
 struct efi_image_regions {
 	int			max;
 	int			num;
+	const char		*hash_algo;
+	int			hash_len;
+	u8			hash[SHA512_SUM_LEN];
 	struct image_region	reg[];
 };
 
+struct x509_certificate;
+
 /**
  * struct efi_sig_data - A decoded data of struct efi_signature_data
  *
@@ -979,12 +990,15 @@ struct efi_image_regions {
  * @owner:	Signature owner
  * @data:	Pointer to signature data
  * @size:	Size of signature data
+ * @cert:	Parsed certificate for an X.509 signature, NULL if not parsed
+ *		yet
  */
 struct efi_sig_data {
 	struct efi_sig_data *next;
 	efi_guid_t owner;
 	void *data;
 	size_t size;
+	struct x509_certificate *cert;
 };
 
 /**
@@ -1002,7 +1016,6 @@ struct efi_signature_store {
 	struct efi_sig_data *sig_data_list;
 };
 
-struct x509_certificate;
 struct pkcs7_message;
 
 /**
@@ -1023,6 +1036,8 @@ struct eficonfig_media_boot_option {
 
 bool efi_hash_regions(struct image_region *regs, int count,
 		      void **hash, const char *hash_algo, int *len);
+const void *efi_image_regions_hash(struct efi_image_regions *regs,
+				   const char *hash_algo, int *lenp);
 bool efi_signature_lookup_digest(struct efi_image_regions *regs,
 				 struct efi_signature_store *db,
 				 bool dbx);
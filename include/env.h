@@ -110,6 +110,26 @@ void env_relocate(void);
  */
 char *env_get(const char *varname);
 
+/**
+ * env_finish_import() - Import all variables from a lazily loaded environment
+ *
+ * With CONFIG_ENV_LAZY_IMPORT, env_get() looks up variables in the loaded
+ * environment data and most of them are not in the environment hashtable.
+ * This must be called before anything which changes the environment, or
+ * needs all variables in the hashtable, such as listing or exporting them.
+ * It does nothing if the environment is already fully imported.
+ *
+ * Return: 0 if OK, -EIO if some variables could not be imported
+ */
+#if CONFIG_IS_ENABLED(ENV_LAZY_IMPORT)
+int env_finish_import(void);
+#else
+static inline int env_finish_import(void)
+{
+	return 0;
+}
+#endif
+
 /*
  * Like env_get, but prints an error if envvar isn't defined in the
  * environment.  It always returns what env_get does, so it can be used in
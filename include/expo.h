@@ -81,6 +81,8 @@ struct expo_theme {
  * type set to EXPOACT_NONE if there is no action
  * @text_mode: true to use text mode for the menu (no vidconsole)
  * @popup: true to use popup menus, instead of showing all items
+ * @drawn_scene_id: ID of the scene currently shown on the display, or 0 if the
+ * whole display must be redrawn on the next expo_render()
  * @priv: Private data for the controller
  * @theme: Information about fonts styles, etc.
  * @scene_head: List of scenes
@@ -95,6 +97,7 @@ struct expo {
 	struct expo_action action;
 	bool text_mode;
 	bool popup;
+	uint drawn_scene_id;
 	void *priv;
 	struct expo_theme theme;
 	struct list_head scene_head;
@@ -124,6 +127,7 @@ struct expo_string {
  * @id: ID number of the scene
  * @title_id: String ID of title of the scene (allocated)
  * @highlight_id: ID of highlighted object, if any
+ * @drawn_highlight_id: Value of @highlight_id when the scene was last rendered
  * @cls: cread state to use for input
  * @buf: Buffer for input
  * @entry_save: Buffer to hold vidconsole text-entry information
@@ -136,6 +140,7 @@ struct scene {
 	uint id;
 	uint title_id;
 	uint highlight_id;
+	uint drawn_highlight_id;
 	struct cli_line_state cls;
 	struct abuf buf;
 	struct abuf entry_save;
@@ -184,11 +189,13 @@ struct scene_dim {
  * @SCENEOF_POINT: object should be highlighted
  * @SCENEOF_OPEN: object should be opened (e.g. menu is opened so that an option
  * can be selected)
+ * @SCENEOF_REDRAW: object is being redrawn (used internally by the renderer)
  */
 enum scene_obj_flags_t {
 	SCENEOF_HIDE	= 1 << 0,
 	SCENEOF_POINT	= 1 << 1,
 	SCENEOF_OPEN	= 1 << 2,
+	SCENEOF_REDRAW	= 1 << 3,
 };
 
 enum {
@@ -207,6 +214,9 @@ enum {
  * @flags: Flags for this object
  * @bit_length: Number of bits used for this object in CMOS RAM
  * @start_bit: Start bit to use for this object in CMOS RAM
+ * @drawn: Area of the display covered by this object when it was last rendered
+ * @drawn_sig: Signature of the object's state when it was last rendered, used
+ * to tell whether it must be redrawn
  * @sibling: Node to link this object to its siblings
  */
 struct scene_obj {
@@ -218,6 +228,8 @@ struct scene_obj {
 	u8 flags;
 	u8 bit_length;
 	u16 start_bit;
+	struct scene_dim drawn;
+	u32 drawn_sig;
 	struct list_head sibling;
 };
 
@@ -438,6 +450,10 @@ int expo_first_scene_id(struct expo *exp);
 /**
  * expo_render() - render the expo on the display / console
  *
+ * With CONFIG_EXPO_INCREMENTAL, only the objects which have changed since the
+ * last call (and anything overlapping them) are redrawn, unless the scene has
+ * changed or expo_redraw() has been called
+ *
  * @exp: Expo to render
  *
  * Returns: 0 if OK, -ECHILD if there is no current scene, -ENOENT if the
@@ -445,6 +461,16 @@ int expo_first_scene_id(struct expo *exp);
  */
 int expo_render(struct expo *exp);
 
+/**
+ * expo_redraw() - Make the next expo_render() redraw the whole display
+ *
+ * This must be called if anything other than the expo draws on the display,
+ * since the expo cannot otherwise tell that the display has changed
+ *
+ * @exp: Expo to update
+ */
+void expo_redraw(struct expo *exp);
+
 /**
  * expo_set_text_mode() - Controls whether the expo renders in text mode
  *
@@ -158,6 +158,23 @@ int ext4fs_devread(lbaint_t sector, int byte_offset, int byte_len, char *buf);
 void ext4fs_set_blk_dev(struct blk_desc *rbdd, struct disk_partition *info);
 long int read_allocated_block(struct ext2_inode *inode, int fileblock,
 			      struct ext_block_cache *cache);
+
+/**
+ * ext4fs_map_blocks() - Map a run of file blocks to disk blocks
+ *
+ * This is like read_allocated_block() but also reports how far the mapping
+ * extends, so that callers can deal with a whole extent at once.
+ *
+ * @inode: Inode to look in
+ * @fileblock: First file block to map
+ * @countp: Returns the number of file blocks from @fileblock onwards which
+ *	are contiguous on disk, or which are all part of the same hole. This is
+ *	always at least 1
+ * @cache: Cache for extent-tree blocks, or NULL to use a temporary one
+ * Return: first disk block, 0 for a hole, -ve on error
+ */
+long int ext4fs_map_blocks(struct ext2_inode *inode, int fileblock,
+			   int *countp, struct ext_block_cache *cache);
 int ext4fs_probe(struct blk_desc *fs_dev_desc,
 		 struct disk_partition *fs_partition);
 int ext4_read_file(const char *filename, void *buf, loff_t offset, loff_t len,
@@ -49,6 +49,7 @@ enum {
 	FASTBOOT_COMMAND_OEM_RUN,
 	FASTBOOT_COMMAND_OEM_CONSOLE,
 	FASTBOOT_COMMAND_OEM_BOARD,
+	FASTBOOT_COMMAND_OEM_STREAM,
 	FASTBOOT_COMMAND_ACMD,
 	FASTBOOT_COMMAND_UCMD,
 	FASTBOOT_COMMAND_COUNT
@@ -175,6 +176,16 @@ u32 fastboot_data_remaining(void);
 void fastboot_data_download(const void *fastboot_data,
 			    unsigned int fastboot_data_len, char *response);
 
+/**
+ * fastboot_data_stream() - Write the data received so far to the partition
+ *
+ * This does nothing unless the download is being streamed to a partition with
+ * "oem stream". Transports should call it while a download is in progress,
+ * ideally once they have started receiving the next data, so that receiving
+ * and writing overlap.
+ */
+void fastboot_data_stream(void);
+
 /**
  * fastboot_data_complete() - Mark current transfer complete
  *
@@ -25,7 +25,8 @@ struct disk_partition;
 #define DIRENTSPERCLUST	((mydata->clust_size * mydata->sect_size) / \
 			 sizeof(dir_entry))
 
-#define FATBUFBLOCKS	6
+/* Number of sectors of the FAT to cache, a multiple of 3 for FAT12 */
+#define FATBUFBLOCKS	CONFIG_VAL(FS_FAT_BUFFER_BLOCKS)
 #define FATBUFSIZE	(mydata->sect_size * FATBUFBLOCKS)
 #define FAT12BUFSIZE	((FATBUFSIZE*2)/3)
 #define FAT16BUFSIZE	(FATBUFSIZE/2)
@@ -32,6 +32,39 @@ int fastboot_mmc_get_part_info(const char *part_name,
  */
 void fastboot_mmc_flash_write(const char *cmd, void *download_buffer,
 			      u32 download_bytes, char *response);
+
+/**
+ * fastboot_mmc_stream_open() - Prepare to write an image while it downloads
+ *
+ * @cmd: Named partition to write the image to
+ * @response: Pointer to fastboot response buffer, set on error
+ * Return: 0 if OK, -ve if the partition is not found
+ */
+int fastboot_mmc_stream_open(const char *cmd, char *response);
+
+/**
+ * fastboot_mmc_stream_write() - Write as much of the image as possible
+ *
+ * Data is only written in pieces of at least CONFIG_FASTBOOT_STREAM_SIZE,
+ * until @last is set. Data which is not used must be passed again.
+ *
+ * @buffer: Image data following what was used by the previous call
+ * @len: Number of bytes at @buffer
+ * @last: true if this is the end of the image
+ * @response: Pointer to fastboot response buffer, set on error
+ * Return: number of bytes used, or -ve on error
+ */
+int fastboot_mmc_stream_write(void *buffer, u32 len, bool last,
+			      char *response);
+
+/**
+ * fastboot_mmc_stream_close() - Check the image written
+ *
+ * @response: Pointer to fastboot response buffer, set on error
+ * Return: 0 if OK, -ve if a sparse image is incomplete or inconsistent
+ */
+int fastboot_mmc_stream_close(char *response);
+
 /**
  * fastboot_mmc_flash_erase() - Erase eMMC for fastboot
  *
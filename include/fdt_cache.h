@@ -0,0 +1,114 @@
+/* SPDX-License-Identifier: GPL-2.0+ */
+/*
+ * Cache of libfdt path and compatible-string lookups
+ *
+ * fdt_path_offset() and fdt_node_offset_by_compatible() scan the flat tree
+ * from the root on every call. With CONFIG_OF_LIBFDT_CACHE the libfdt
+ * wrappers in lib/libfdt/ keep the results for each blob here, and the libfdt
+ * functions which write to a blob report their changes, so that the cached
+ * offsets can be moved or dropped. The results are always the same as libfdt
+ * would return.
+ */
+
+#ifndef __FDT_CACHE_H
+#define __FDT_CACHE_H
+
+#include <linux/errno.h>
+
+#if CONFIG_IS_ENABLED(OF_LIBFDT_CACHE)
+/**
+ * fdt_cache_get_path() - Look up a path in the cache
+ *
+ * @fdt: Devicetree blob
+ * @path: Absolute path to look up (need not be nul-terminated)
+ * @namelen: Length of @path
+ * @offsetp: Returns the node offset, or -FDT_ERR_NOTFOUND if the node is
+ *	known not to exist
+ * Return: 0 if found in the cache, -ENOENT if not
+ */
+int fdt_cache_get_path(const void *fdt, const char *path, int namelen,
+		       int *offsetp);
+
+/**
+ * fdt_cache_set_path() - Record the result of looking up a path
+ *
+ * Only node offsets and -FDT_ERR_NOTFOUND are recorded; other errors are
+ * ignored
+ *
+ * @fdt: Devicetree blob
+ * @path: Absolute path which was looked up (need not be nul-terminated)
+ * @namelen: Length of @path
+ * @offset: Result of the lookup
+ */
+void fdt_cache_set_path(const void *fdt, const char *path, int namelen,
+			int offset);
+
+/**
+ * fdt_cache_compat_offset() - Find the next node with a compatible string
+ *
+ * This behaves like fdt_node_offset_by_compatible(), using a cached list of
+ * all the nodes with the compatible string, which is built on first use
+ *
+ * @fdt: Devicetree blob
+ * @startoffset: Only consider nodes after this one (-1 for all nodes)
+ * @compat: Compatible string to look for
+ * @offsetp: Returns the node offset, or -FDT_ERR_NOTFOUND if there is none
+ * Return: 0 if OK, -ENOENT if the cache cannot be used (e.g. before
+ *	relocation), -ENOMEM if out of memory
+ */
+int fdt_cache_compat_offset(const void *fdt, int startoffset,
+			    const char *compat, int *offsetp);
+
+/**
+ * fdt_cache_prop_changed() - Tell the cache that a property was written
+ *
+ * @fdt: Devicetree blob
+ * @nodeoffset: Offset of the node holding the property, before the change
+ * @name: Name of the property (need not be nul-terminated)
+ * @namelen: Length of @name
+ * @delta: Change in the size of the structure block, in bytes
+ */
+void fdt_cache_prop_changed(const void *fdt, int nodeoffset, const char *name,
+			    int namelen, int delta);
+
+/**
+ * fdt_cache_inval() - Forget everything cached for a blob
+ *
+ * This is used when nodes are added, removed or renamed, or a new blob is
+ * written to the memory. Code which overwrites a blob without using libfdt
+ * should call this too, although the cache does check that the header and the
+ * node names have not changed.
+ *
+ * @fdt: Devicetree blob
+ */
+void fdt_cache_inval(const void *fdt);
+#else
+static inline int fdt_cache_get_path(const void *fdt, const char *path,
+				     int namelen, int *offsetp)
+{
+	return -ENOENT;
+}
+
+static inline void fdt_cache_set_path(const void *fdt, const char *path,
+				      int namelen, int offset)
+{
+}
+
+static inline int fdt_cache_compat_offset(const void *fdt, int startoffset,
+					  const char *compat, int *offsetp)
+{
+	return -ENOENT;
+}
+
+static inline void fdt_cache_prop_changed(const void *fdt, int nodeoffset,
+					  const char *name, int namelen,
+					  int delta)
+{
+}
+
+static inline void fdt_cache_inval(const void *fdt)
+{
+}
+#endif
+
+#endif
@@ -691,6 +691,19 @@ int fdtdec_get_chosen_node(const void *blob, const char *name);
  */
 const char *fdtdec_get_compatible(enum fdt_compat_id id);
 
+/**
+ * fdtdec_node_offset_by_phandle() - Find the node with a given phandle
+ *
+ * This works like fdt_node_offset_by_phandle() but uses a cache when
+ * CONFIG_OF_PHANDLE_CACHE is enabled, so that repeated lookups do not
+ * search the whole tree.
+ *
+ * @blob:	FDT blob
+ * @phandle:	phandle to look up
+ * Return: node offset if found, -ve FDT_ERR_... code on error
+ */
+int fdtdec_node_offset_by_phandle(const void *blob, uint32_t phandle);
+
 /* Look up a phandle and follow it to its node. Then return the offset
  * of that node.
  *
@@ -18,6 +18,7 @@ struct cmd_tbl;
 #define FS_TYPE_SQUASHFS 6
 #define FS_TYPE_EROFS   7
 #define FS_TYPE_SEMIHOSTING 8
+#define FS_TYPE_VIRTIO	9
 
 struct blk_desc;
 
@@ -150,6 +151,27 @@ int fs_size(const char *filename, loff_t *size);
 int fs_read(const char *filename, ulong addr, loff_t offset, loff_t len,
 	    loff_t *actread);
 
+/**
+ * fs_read_decomp() - read a file, decompressing it as it is read
+ *
+ * The compression type is detected from the start of the file. The file is
+ * read a piece at a time and decompressed straight to @addr, so that the
+ * compressed data is never held in memory as a whole. Files which are not
+ * compressed are read as normal.
+ *
+ * You must call fs_set_blk_dev() or a similar function before calling this,
+ * since that sets up the block device to use.
+ *
+ * @filename:	full path of the file to read from
+ * @addr:	address of the buffer to decompress to
+ * @maxlen:	size of the buffer in bytes
+ * @actread:	returns the number of bytes written to the buffer
+ * Return:	0 if OK, -ENOSPC if the buffer is too small, -ENOSYS if the
+ *		compression type is not supported, other -ve on error
+ */
+int fs_read_decomp(const char *filename, ulong addr, ulong maxlen,
+		   loff_t *actread);
+
 /**
  * fs_write() - write file to the partition previously set by fs_set_blk_dev()
  *
@@ -13,4 +13,21 @@
 int fs_devread(struct blk_desc *, struct disk_partition *, lbaint_t, int, int,
 	       char *);
 
+/**
+ * fs_blk_dread() - Read whole blocks into a buffer of any alignment
+ *
+ * The blocks are read straight into @buf when it is aligned for DMA.
+ * Otherwise all but the last block or so are read into the first aligned
+ * address in @buf and moved down into place, so that only the remainder
+ * goes through a bounce buffer.
+ *
+ * @blk:	Block device to read from
+ * @start:	First block to read, from the start of the device
+ * @blkcnt:	Number of blocks to read
+ * @buf:	Buffer to read into
+ * Return:	number of blocks read, which is less than @blkcnt on error
+ */
+ulong fs_blk_dread(struct blk_desc *blk, lbaint_t start, lbaint_t blkcnt,
+		   void *buf);
+
 #endif /* __U_BOOT_FS_INTERNAL_H__ */
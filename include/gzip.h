@@ -10,6 +10,7 @@
 #include <linux/types.h>
 
 struct blk_desc;
+struct image_reader;
 
 /**
  * gzip_parse_header() - Parse a header from a gzip file
@@ -33,6 +34,22 @@ int gzip_parse_header(const unsigned char *src, unsigned long len);
  */
 int gunzip(void *dst, int dstlen, unsigned char *src, unsigned long *lenp);
 
+/**
+ * gunzip_read() - Decompress gzipped data as it is read
+ *
+ * The data is read in pieces of IMAGE_READ_CHUNK bytes, so only that much
+ * of the compressed data is in memory at any time
+ *
+ * @dst: Destination for uncompressed data
+ * @dstlen: Size of destination buffer
+ * @rd: Reader for the gzipped data
+ * @lenp: Returns length of uncompressed data
+ * Return: 0 if OK, -ENOSPC if the destination buffer is too small, -EINVAL
+ *	if the data is not valid, other -ve on error
+ */
+int gunzip_read(void *dst, ulong dstlen, struct image_reader *rd,
+		ulong *lenp);
+
 /**
  * zunzip() - Uncompress blocks compressed with zlib without headers
  *
@@ -69,7 +86,9 @@ void gzwrite_progress_finish(int retcode, ulong totalwritten, ulong totalsize,
  * @src:	compressed image address
  * @len:	compressed image length in bytes
  * @dev:	block device descriptor
- * @szwritebuf:	bytes per write (pad to erase size)
+ * @szwritebuf:	bytes per write (pad to erase size). Two buffers of this size
+ *		are used, so that one can be inflated while the other is
+ *		written, if the device supports asynchronous writes
  * @startoffs:	offset in bytes of first write
  * @szexpected:	expected uncompressed length, may be zero to use gzip trailer
  *		for files under 4GiB
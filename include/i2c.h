@@ -120,10 +120,15 @@ struct dm_i2c_chip {
  *
  * @speed_hz: Bus speed in hertz (typically 100000)
  * @max_transaction_bytes: Maximal size of single I2C transfer
+ * @dma_min_bytes: Smallest read for which the driver can use DMA, or 0 if it
+ *	does not support DMA. This is set by the driver in its probe() method.
+ *	Reads of at least this size are given a DMA-safe buffer and have
+ *	I2C_M_DMA_SAFE set
  */
 struct dm_i2c_bus {
 	int speed_hz;
 	int max_transaction_bytes;
+	int dma_min_bytes;
 };
 
 /*
@@ -138,6 +143,7 @@ enum dm_i2c_msg_flags {
 	I2C_M_IGNORE_NAK	= 0x1000, /* continue after NAK */
 	I2C_M_NO_RD_ACK		= 0x0800, /* skip the Ack bit on reads */
 	I2C_M_RECV_LEN		= 0x0400, /* length is first received byte */
+	I2C_M_DMA_SAFE		= 0x0200, /* buffer can be used for DMA */
 };
 
 /**
@@ -384,6 +390,11 @@ struct dm_i2c_ops {
 	/**
 	 * xfer() - transfer a list of I2C messages
 	 *
+	 * If a message has I2C_M_DMA_SAFE set, its buffer starts on an
+	 * ARCH_DMA_MINALIGN boundary and is padded up to a multiple of
+	 * ARCH_DMA_MINALIGN bytes, so the driver may invalidate whole cache
+	 * lines covering it. The length of the message is not padded.
+	 *
 	 * @bus:	Bus to read from
 	 * @msg:	List of messages to transfer
 	 * @nmsgs:	Number of messages in the list
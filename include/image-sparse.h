@@ -26,6 +26,16 @@ struct sparse_storage {
 				 lbaint_t blk,
 				 lbaint_t blkcnt);
 
+	/*
+	 * Optional: make blocks read back as zero without writing them,
+	 * returning blkcnt if done. @blk and @blkcnt are multiples of
+	 * @discard_align (0 meaning 1).
+	 */
+	lbaint_t	(*discard)(struct sparse_storage *info,
+				   lbaint_t blk,
+				   lbaint_t blkcnt);
+	u32		discard_align;
+
 	void		(*mssg)(const char *str, char *response);
 };
 
@@ -40,5 +50,83 @@ static inline int is_sparse_image(void *buf)
 	return 0;
 }
 
+/**
+ * enum sparse_stream_state - What a sparse image stream expects next
+ *
+ * @SPARSE_STREAM_HEADER: the image header
+ * @SPARSE_STREAM_CHUNK: a chunk header, with the data for all but raw chunks
+ * @SPARSE_STREAM_DATA: the data of a raw chunk
+ * @SPARSE_STREAM_DONE: nothing, all chunks have been written
+ */
+enum sparse_stream_state {
+	SPARSE_STREAM_HEADER,
+	SPARSE_STREAM_CHUNK,
+	SPARSE_STREAM_DATA,
+	SPARSE_STREAM_DONE,
+};
+
+/**
+ * struct sparse_stream - State for writing a sparse image as it arrives
+ *
+ * @info: Storage to write to
+ * @state: What is expected next
+ * @header: Image header
+ * @min_write: Smallest amount of raw data to write at once, unless it is the
+ *	end of the chunk or of the data. This is 0 after sparse_stream_init()
+ *	and may be set by the caller.
+ * @chunk: Number of chunks started
+ * @blk: Next block to write
+ * @blkcnt: Number of blocks of raw data left in the current chunk
+ * @total_blocks: Number of blocks of the image handled so far
+ * @bytes_written: Number of bytes written so far
+ */
+struct sparse_stream {
+	struct sparse_storage *info;
+	enum sparse_stream_state state;
+	sparse_header_t header;
+	size_t min_write;
+	unsigned int chunk;
+	lbaint_t blk;
+	lbaint_t blkcnt;
+	u32 total_blocks;
+	u64 bytes_written;
+};
+
+/**
+ * sparse_stream_init() - Prepare to write a sparse image in pieces
+ *
+ * @ss: Stream state to set up
+ * @info: Storage to write to
+ */
+void sparse_stream_init(struct sparse_stream *ss, struct sparse_storage *info);
+
+/**
+ * sparse_stream_write() - Write as much of a sparse image as possible
+ *
+ * Headers and chunks which are not all present are left for the next call,
+ * as are raw data smaller than @ss->min_write. The caller must pass the
+ * unused data again, followed by any more data received.
+ *
+ * @ss: Stream state
+ * @data: Image data following what was used by the previous call
+ * @len: Number of bytes at @data
+ * @last: true if there is no more data to come
+ * @response: Passed to @ss->info->mssg() on error
+ * Return: number of bytes used, or -ve on error
+ */
+ssize_t sparse_stream_write(struct sparse_stream *ss, const void *data,
+			    size_t len, bool last, char *response);
+
+/**
+ * sparse_stream_finish() - Check that the whole image has been written
+ *
+ * @ss: Stream state
+ * @part_name: Name of the partition, for the message
+ * @response: Passed to @ss->info->mssg() on error
+ * Return: 0 if OK, -EINVAL if the image is truncated or inconsistent
+ */
+int sparse_stream_finish(struct sparse_stream *ss, const char *part_name,
+			 char *response);
+
 int write_sparse_image(struct sparse_storage *info, const char *part_name,
 		       void *data, char *response);
@@ -31,6 +31,7 @@ struct fdt_region;
 
 #else
 
+#include <cpu.h>
 #include <lmb.h>
 #include <asm/u-boot.h>
 #include <command.h>
@@ -393,6 +394,12 @@ struct bootm_headers {
 	ulong		cmdline_start;
 	ulong		cmdline_end;
 	struct bd_info		*kbd;
+
+	/*
+	 * If not NULL, fit_image_load() may start decompressing a loadable
+	 * in this job and leave it running. See image_decomp_start()
+	 */
+	struct image_decomp_job	*decomp_job;
 #endif
 
 	int		verify;		/* env_get("verify")[0] != 'n' */
@@ -749,7 +756,9 @@ int boot_get_fdt_fit(struct bootm_headers *images, ulong addr,
  *			calling bootstage_mark()
  * @param load_op	Decribes what to do with the load address
  * @param datap		Returns address of loaded image
- * @param lenp		Returns length of loaded image
+ * @param lenp		Returns length of loaded image, or 0 if a loadable is
+ *			still being decompressed in @images->decomp_job, which
+ *			is then set to NULL
  * Return: node offset of image, or -ve error code on error:
  *   -ENOEXEC - unsupported architecture
  *   -ENOENT - could not find image / subimage
@@ -1021,6 +1030,137 @@ int image_decomp(int comp, ulong load, ulong image_start, int type,
 		 void *load_buf, void *image_buf, ulong image_len,
 		 uint unc_len, ulong *load_end);
 
+#ifndef USE_HOSTCC
+/**
+ * struct image_decomp_job - decompression of an image, done by another CPU
+ *
+ * @job:	Job which does the decompression
+ * @comp:	Compression algorithm that is used (IH_COMP_...)
+ * @load:	Destination load address in U-Boot memory
+ * @load_buf:	Place to decompress to
+ * @image_buf:	Address to decompress from
+ * @len:	Number of bytes in @image_buf to decompress, then the number of
+ *		bytes decompressed once the job is done
+ * @unc_len:	Available space for decompression
+ */
+struct image_decomp_job {
+	struct cpu_job job;
+	int comp;
+	ulong load;
+	void *load_buf;
+	void *image_buf;
+	ulong len;
+	uint unc_len;
+};
+
+/**
+ * image_decomp_job_ok() - Check if a compression type can be done in a job
+ *
+ * Only decompressors which use nothing but the buffers they are given can
+ * run on another CPU
+ *
+ * @comp:	Compression algorithm (IH_COMP_...)
+ * Return: true if image_decomp_start() can handle @comp
+ */
+bool image_decomp_job_ok(int comp);
+
+/**
+ * image_decomp_start() - start decompressing an image, on another CPU
+ *
+ * This is like image_decomp() but returns once the work is handed to an idle
+ * CPU, if there is one. The buffers must stay in place until
+ * image_decomp_finish() is called.
+ *
+ * @dj:		Job to use
+ * @comp:	Compression algorithm that is used (IH_COMP_...)
+ * @load:	Destination load address in U-Boot memory
+ * @image_start Image start address (where we are decompressing from)
+ * @type:	OS type (IH_OS_...)
+ * @load_buf:	Place to decompress to
+ * @image_buf:	Address to decompress from
+ * @image_len:	Number of bytes in @image_buf to decompress
+ * @unc_len:	Available space for decompression
+ * Return: 0 if started, -ENOSYS if image_decomp_job_ok() is false for @comp,
+ *	other -ve on error
+ */
+int image_decomp_start(struct image_decomp_job *dj, int comp, ulong load,
+		       ulong image_start, int type, void *load_buf,
+		       void *image_buf, ulong image_len, uint unc_len);
+
+/**
+ * image_decomp_finish() - wait for an image to be decompressed
+ *
+ * @dj:		Job started by image_decomp_start()
+ * @load_end:	Returns the end address of the decompressed data
+ * Return: 0 if OK, non-zero on error
+ */
+int image_decomp_finish(struct image_decomp_job *dj, ulong *load_end);
+#endif
+
+/* Size of the buffer used to read an image which is decompressed as it loads */
+#define IMAGE_READ_CHUNK	(1UL << 20)
+
+/**
+ * struct image_reader - source of an image which is decompressed as it loads
+ *
+ * This allows a compressed image to be read a piece at a time, e.g. from a
+ * filesystem, so that the whole compressed image never needs to be in memory
+ *
+ * @read: Read part of the image
+ *	@rd: Reader
+ *	@offset: Offset within the image to read from
+ *	@buf: Buffer to read into
+ *	@size: Maximum number of bytes to read
+ *	Return: number of bytes read, 0 at the end of the image, or -ve on error
+ * @offset: Offset within the image of the next byte to read, used by
+ *	image_reader_fill()
+ * @priv: Private data for the reader
+ */
+struct image_reader {
+	long (*read)(struct image_reader *rd, ulong offset, void *buf,
+		     ulong size);
+	ulong offset;
+	void *priv;
+};
+
+/**
+ * image_reader_fill() - top up a buffer with more of an image
+ *
+ * Any bytes in the buffer which have not been used yet are moved to the start
+ * and the rest of the buffer is then filled from the reader, as far as
+ * possible
+ *
+ * @rd:		Reader to use
+ * @buf:	Buffer to fill
+ * @size:	Size of the buffer
+ * @used:	Number of bytes at the start of the buffer which are finished
+ *		with
+ * @lenp:	Number of valid bytes in the buffer, updated on exit
+ * Return: number of bytes added, 0 if the end of the image has been reached,
+ *	or -ve on error
+ */
+long image_reader_fill(struct image_reader *rd, void *buf, ulong size,
+		       ulong used, ulong *lenp);
+
+/**
+ * image_decomp_stream() - decompress an image while it is read
+ *
+ * This is like image_decomp() but reads the compressed data a piece at a
+ * time, so there is no need to hold it all in memory first. Only gzip, zstd
+ * and lz4 are supported, along with uncompressed images.
+ *
+ * @comp:	Compression algorithm that is used (IH_COMP_...)
+ * @load_buf:	Place to decompress to
+ * @unc_len:	Available space for decompression
+ * @rd:		Reader for the compressed image
+ * @lenp:	Returns the number of bytes decompressed
+ * Return: 0 if OK, -ENOSPC if @unc_len is too small (lz4 may report this as
+ *	-EPROTO), -ENOSYS if the compression algorithm is not supported, other
+ *	-ve on error
+ */
+int image_decomp_stream(int comp, void *load_buf, ulong unc_len,
+			struct image_reader *rd, ulong *lenp);
+
 /**
  * Set up properties in the FDT
  *
@@ -1055,6 +1195,9 @@ int image_setup_linux(struct bootm_headers *images);
  */
 int bootz_setup(ulong image, ulong *start, ulong *end);
 
+/* Number of bytes of a Linux Image needed by booti_setup() */
+#define BOOTI_HEADER_SIZE	64
+
 /**
  * Return the correct start address and size of a Linux aarch64 Image.
  *
@@ -1116,6 +1259,29 @@ int booti_setup(ulong image, ulong *relocated_addr, ulong *size,
 
 #define FIT_MAX_HASH_LEN	HASH_MAX_DIGEST_SIZE
 
+/* Number of configuration signatures recorded in struct fit_sig_handoff */
+#define FIT_SIG_RECS		8
+
+/* Space for each digest, enough for SHA512 whatever the phase supports */
+#define FIT_SIG_DIGEST_LEN	64
+
+/**
+ * struct fit_sig_handoff - FIT signatures checked, kept in the bloblist
+ *
+ * This is stored with the tag BLOBLISTT_U_BOOT_FIT_SIG when
+ * CONFIG_FIT_SIGNATURE_CACHE is enabled, so that a configuration signature
+ * checked by one boot phase is not checked again by the next one
+ *
+ * @next: Next record to replace, once all are in use
+ * @digest: For each signature, the digest (using the signature's hash
+ *	algorithm) of the signed data, the signature and the public key,
+ *	padded with zeroes. Unused records are all zero.
+ */
+struct fit_sig_handoff {
+	uint32_t next;
+	uint8_t digest[FIT_SIG_RECS][FIT_SIG_DIGEST_LEN];
+};
+
 /* cmdline argument format parsing */
 int fit_parse_conf(const char *spec, ulong addr_curr,
 		ulong *addr, const char **conf_name);
@@ -1307,11 +1473,13 @@ struct image_summary {
  * @engine_id:	Engine to use for signing
  * @cmdname:	Command name used when reporting errors
  * @algo_name:	Algorithm name, or NULL if to be read from FIT
+ * @jobs:	Number of threads to use to calculate hashes, 0 for one per CPU
  * @summary:	Returns information about what data was written
  *
  * Adds hash values for all component images in the FIT blob.
  * Hashes are calculated for all component images which have hash subnodes
  * with algorithm property set to one of the supported hash algorithms.
+ * These are calculated in parallel, before any are written.
  *
  * Also add signatures if signature nodes are present.
  *
@@ -1323,7 +1491,81 @@ int fit_add_verification_data(const char *keydir, const char *keyfile,
 			      void *keydest, void *fit, const char *comment,
 			      int require_keys, const char *engine_id,
 			      const char *cmdname, const char *algo_name,
-			      struct image_summary *summary);
+			      int jobs, struct image_summary *summary);
+
+/* Maximum number of hash nodes in an image which a hasher can handle */
+#define FIT_HASHER_MAX		4
+
+/**
+ * struct fit_hasher - hashes of an image, calculated as its data arrives
+ *
+ * This allows the hashes to be updated as each part of an image is loaded, so
+ * that they are ready as soon as the last part is in memory
+ *
+ * @count: Number of hashes being calculated
+ * @hash: Information about each hash
+ * @hash.noffset: Offset of the hash node
+ * @hash.algo: Hash algorithm
+ * @hash.ctx: Context for the algorithm, NULL once finished
+ */
+struct fit_hasher {
+	int count;
+	struct fit_hasher_algo {
+		int noffset;
+		struct hash_algo *algo;
+		void *ctx;
+	} hash[FIT_HASHER_MAX];
+};
+
+/**
+ * fit_hasher_start() - Start calculating the hashes of an image
+ *
+ * Hash nodes marked to be ignored are skipped
+ *
+ * @hsr:	Hasher to set up
+ * @fit:	Pointer to the FIT format image header
+ * @image_noffset: Offset in @fit of image to hash
+ * Return: 0 if OK, -ENOSYS if the hashes cannot be calculated this way, in
+ *	which case they are calculated by fit_image_verify_hashed() instead
+ */
+int fit_hasher_start(struct fit_hasher *hsr, const void *fit,
+		     int image_noffset);
+
+/**
+ * fit_hasher_update() - Add more data to the hashes of an image
+ *
+ * @hsr:	Hasher to update
+ * @buf:	Next part of the image data
+ * @size:	Size of @buf in bytes
+ * Return: 0 if OK, -EIO on error
+ */
+int fit_hasher_update(struct fit_hasher *hsr, const void *buf, size_t size);
+
+/**
+ * fit_hasher_abort() - Free any hashes which have not been used
+ *
+ * @hsr:	Hasher to tidy up
+ */
+void fit_hasher_abort(struct fit_hasher *hsr);
+
+/**
+ * fit_image_verify_hashed() - Verify an image whose hashes are calculated
+ *
+ * This is like fit_image_verify_with_data() but uses the hashes calculated by
+ * @hsr, where available, instead of going through the data again. The hashes
+ * are used up, so call fit_hasher_abort() afterwards to free any left over.
+ *
+ * @fit:	Pointer to the FIT format image header
+ * @image_noffset: Offset in @fit of image to verify
+ * @key_blob:	FDT containing public keys
+ * @data:	Image data to verify
+ * @size:	Size of image data
+ * @hsr:	Hasher which has been given all of @data, or NULL
+ * Return: 1 if the image is valid, 0 if not
+ */
+int fit_image_verify_hashed(const void *fit, int image_noffset,
+			    const void *key_blob, const void *data,
+			    size_t size, struct fit_hasher *hsr);
 
 /**
  * fit_image_verify_with_data() - Verify an image with given data
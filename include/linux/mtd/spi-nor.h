@@ -294,6 +294,7 @@ enum spi_nor_option_flags {
 	SNOR_F_BROKEN_RESET	= BIT(6),
 	SNOR_F_SOFT_RESET	= BIT(7),
 	SNOR_F_IO_MODE_EN_VOLATILE = BIT(8),
+	SNOR_F_CONT_READ	= BIT(9),
 };
 
 struct spi_nor;
@@ -487,11 +488,14 @@ struct spi_flash {
  * @dev:		point to a spi device, or a spi nor controller device.
  * @info:		spi-nor part JDEC MFR id and other info
  * @manufacturer_sfdp:	manufacturer specific SFDP table
+ * @octal_dtr_seqs:	SFDP command sequences to switch to 8D-8D-8D mode, or
+ *			NULL if none
  * @page_size:		the page size of the SPI NOR
  * @addr_width:		number of address bytes
  * @erase_opcode:	the opcode for erasing a sector
  * @read_opcode:	the read opcode
  * @read_dummy:		the dummy needed by the read operation
+ * @read_mode_clocks:	the number of @read_dummy cycles which carry mode bits
  * @program_opcode:	the program opcode
  * @rdsr_dummy		dummy cycles needed for Read Status Register command.
  * @rdsr_addr_nbytes:	dummy address bytes needed for Read Status Register
@@ -538,11 +542,13 @@ struct spi_nor {
 	struct spi_slave	*spi;
 	const struct flash_info	*info;
 	u8			*manufacturer_sfdp;
+	u32			*octal_dtr_seqs;
 	u32			page_size;
 	u8			addr_width;
 	u8			erase_opcode;
 	u8			read_opcode;
 	u8			read_dummy;
+	u8			read_mode_clocks;
 	u8			program_opcode;
 	u8			rdsr_dummy;
 	u8			rdsr_addr_nbytes;
@@ -449,10 +449,31 @@ struct abuf;
 /**
  * zstd_decompress() - Decompress Zstandard data
  *
+ * The data may consist of several frames, which are decompressed one after
+ * the other. If each frame header records the frame's size, the frames are
+ * spread across the available CPUs (see cpu_job_start()). Skippable frames
+ * are ignored, as is anything after the last frame.
+ *
  * @in: Input buffer to decompress
  * @out: Output buffer to hold the results (must be large enough)
  * Return: size of the decompressed data, or -ve on error
  */
 int zstd_decompress(struct abuf *in, struct abuf *out);
 
+struct image_reader;
+
+/**
+ * zstd_decompress_read() - Decompress Zstandard data as it is read
+ *
+ * The data is read in pieces of IMAGE_READ_CHUNK bytes. Besides that, only
+ * the window given in the first frame header needs to be allocated. Any
+ * following frames are decompressed in turn, so must not need a larger one.
+ *
+ * @rd: Reader for the compressed data
+ * @out: Output buffer to hold the results
+ * Return: size of the decompressed data, -ENOSPC if @out is too small, or
+ *	other -ve on error
+ */
+int zstd_decompress_read(struct image_reader *rd, struct abuf *out);
+
 #endif  /* LINUX_ZSTD_H */
@@ -51,14 +51,19 @@ struct lmb_property {
  *         lmb_region.region is only a pointer to the correct buffer,
  *         initialized in lmb_init(). This configuration is useful to manage
  *         more reserved memory regions with CONFIG_LMB_RESERVED_REGIONS.
+ *         With CONFIG_LMB_GROW a full array is replaced by a larger one
+ *         allocated with malloc(), which lmb_uninit() frees.
  */
 
 /**
  * struct lmb_region - Description of a set of region.
  *
+ * The regions are sorted by base address and do not overlap.
+ *
  * @cnt: Number of regions.
  * @max: Size of the region array, max value of cnt.
  * @region: Array of the region properties
+ * @alloced: true if @region was allocated with malloc() as the list grew
  */
 struct lmb_region {
 	unsigned long cnt;
@@ -67,6 +72,7 @@ struct lmb_region {
 	struct lmb_property region[CONFIG_LMB_MAX_REGIONS];
 #else
 	struct lmb_property *region;
+	bool alloced;
 #endif
 };
 
@@ -93,6 +99,24 @@ struct lmb {
 };
 
 void lmb_init(struct lmb *lmb);
+
+/**
+ * lmb_uninit() - Free memory allocated for a logical memory block handle
+ *
+ * This frees any region arrays grown beyond their initial size. It must be
+ * called before a handle set up by lmb_init() goes out of scope or is set up
+ * again. It is safe to call this on a handle which is all zeroes.
+ *
+ * @lmb:	the logical memory block struct
+ */
+#if IS_ENABLED(CONFIG_LMB_GROW)
+void lmb_uninit(struct lmb *lmb);
+#else
+static inline void lmb_uninit(struct lmb *lmb)
+{
+}
+#endif
+
 void lmb_init_and_reserve(struct lmb *lmb, struct bd_info *bd, void *fdt_blob);
 void lmb_init_and_reserve_range(struct lmb *lmb, phys_addr_t base,
 				phys_size_t size, void *fdt_blob);
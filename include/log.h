@@ -157,6 +157,29 @@ int _log_buffer(enum log_category_t cat, enum log_level_t level,
 #define pr_fmt(fmt) fmt
 #endif
 
+/**
+ * struct log_site - A call site of log_debug(), log_content() or log_io()
+ *
+ * With CONFIG_LOG_SITES, each of these calls has one of these in a linker
+ * list, so that it can be enabled or disabled by itself
+ *
+ * @file: File containing the call
+ * @func: Function containing the call
+ * @line: Line number of the call
+ * @level: Log level of the call
+ * @enabled: true if records from this site are passed to the log system
+ * @force: 1 to always emit records from this site, -1 to never emit them, 0
+ *	to follow the log level and filters
+ */
+struct log_site {
+	const char *file;
+	const char *func;
+	u16 line;
+	u8 level;
+	bool enabled;
+	s8 force;
+};
+
 /* Use a default category if this file does not supply one */
 #ifndef LOG_CATEGORY
 #define LOG_CATEGORY LOGC_NONE
@@ -179,9 +202,9 @@ int _log_buffer(enum log_category_t cat, enum log_level_t level,
 #define log_warning(_fmt...)	log(LOG_CATEGORY, LOGL_WARNING, ##_fmt)
 #define log_notice(_fmt...)	log(LOG_CATEGORY, LOGL_NOTICE, ##_fmt)
 #define log_info(_fmt...)	log(LOG_CATEGORY, LOGL_INFO, ##_fmt)
-#define log_debug(_fmt...)	log(LOG_CATEGORY, LOGL_DEBUG, ##_fmt)
-#define log_content(_fmt...)	log(LOG_CATEGORY, LOGL_DEBUG_CONTENT, ##_fmt)
-#define log_io(_fmt...)		log(LOG_CATEGORY, LOGL_DEBUG_IO, ##_fmt)
+#define log_debug(_fmt...)	log_site(LOG_CATEGORY, LOGL_DEBUG, ##_fmt)
+#define log_content(_fmt...)	log_site(LOG_CATEGORY, LOGL_DEBUG_CONTENT, ##_fmt)
+#define log_io(_fmt...)		log_site(LOG_CATEGORY, LOGL_DEBUG_IO, ##_fmt)
 #define log_cont(_fmt...)	log(LOGC_CONT, LOGL_CONT, ##_fmt)
 
 #ifdef LOG_DEBUG
@@ -205,6 +228,31 @@ int _log_buffer(enum log_category_t cat, enum log_level_t level,
 		      pr_fmt(_fmt), ##_args); \
 	})
 
+#if CONFIG_IS_ENABLED(LOG_SITES)
+/*
+ * Emit a debug record if its call site is enabled. The site is only checked
+ * when it may be emitted, so a disabled site costs a single branch.
+ */
+#define log_site(_cat, _level, _fmt, _args...) ({ \
+	static struct log_site _site __aligned(4) __used \
+		__section("__u_boot_list_2_log_site_2_s") = { \
+		.file = __FILE__, \
+		.func = __func__, \
+		.line = __LINE__, \
+		.level = _level, \
+		.enabled = _level <= CONFIG_LOG_DEFAULT_LEVEL, \
+	}; \
+	if (_LOG_DEBUG != 0 || \
+	    (_level <= _LOG_MAX_LEVEL && unlikely(_site.enabled))) \
+		_log((enum log_category_t)(_cat), \
+		     (enum log_level_t)(_level | _LOG_DEBUG | \
+			(_site.force > 0 ? LOGL_FORCE_DEBUG : 0)), \
+		     __FILE__, __LINE__, __func__, pr_fmt(_fmt), ##_args); \
+	})
+#else
+#define log_site	log
+#endif
+
 /* Emit a dump if the level is less that the maximum */
 #define log_buffer(_cat, _level, _addr, _data, _width, _count, _linelen)  ({ \
 	int _l = _level; \
@@ -216,6 +264,8 @@ int _log_buffer(enum log_category_t cat, enum log_level_t level,
 	})
 #else
 
+#define log_site	log
+
 /* Note: _LOG_DEBUG != 0 avoids a warning with clang */
 #define log(_cat, _level, _fmt, _args...) ({ \
 	int _l = _level; \
@@ -672,6 +722,67 @@ static inline int log_init(void)
 }
 #endif
 
+#if CONFIG_IS_ENABLED(LOG_SITES)
+/**
+ * log_site_update() - Work out which log call sites are enabled
+ *
+ * This must be called when the default log level, the filters or the forced
+ * state of any site change. It does nothing before relocation, when the
+ * sites may not be writable, so they keep their build-time setting.
+ */
+void log_site_update(void);
+
+/**
+ * log_site_force() - Force log call sites on or off
+ *
+ * @match: Function name, or the end of a file name (e.g. "mmc.c"), to match
+ * @force: 1 to always emit records from matching sites, -1 to never emit
+ *	them, 0 to go back to following the log level and filters
+ * Return: number of sites which match
+ */
+int log_site_force(const char *match, int force);
+#else
+static inline void log_site_update(void)
+{
+}
+#endif
+
+/**
+ * log_defer() - Keep a log record, to be formatted and emitted later
+ *
+ * The format string is kept if it is part of the U-Boot image, otherwise it
+ * is copied, along with any strings passed for %s
+ *
+ * @rec: Log record, without a message
+ * @fmt: printf() format string for the message
+ * @args: Arguments for @fmt
+ * Return: 0 if kept, -E2BIG if the record cannot be kept (e.g. it uses a %p
+ *	extension), -ENOSPC if there is no room for it, -EAGAIN if it is too
+ *	early, -ENOMEM if out of memory
+ */
+int log_defer(struct log_rec *rec, const char *fmt, va_list args);
+
+/**
+ * log_emit() - Send a log record with a message to the log devices
+ *
+ * This is for use by log_defer_flush()
+ *
+ * @rec: Log record to emit
+ * Return: 0 if sent, 1 if not sent while already dispatching another record
+ */
+int log_emit(struct log_rec *rec);
+
+#if CONFIG_IS_ENABLED(LOG_DEFER)
+/**
+ * log_defer_flush() - Format and emit all records kept by log_defer()
+ */
+void log_defer_flush(void);
+#else
+static inline void log_defer_flush(void)
+{
+}
+#endif
+
 /**
  * log_get_default_format() - get default log format
  *
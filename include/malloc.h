@@ -895,11 +895,41 @@ void malloc_enable_testing(int max_allocs);
 /** malloc_disable_testing() - Put malloc() into normal mode */
 void malloc_disable_testing(void);
 
+/**
+ * struct malloc_slab_stats - Statistics for one slab size class
+ *
+ * @size: Size of each object in the class, in bytes
+ * @pages: Number of pages given to the class
+ * @in_use: Number of objects currently allocated
+ * @allocs: Total number of allocations from the class
+ * @fallbacks: Number of requests for the class passed on to dlmalloc
+ *	because there were no free pages left
+ */
+struct malloc_slab_stats {
+	unsigned int size;
+	unsigned int pages;
+	unsigned int in_use;
+	unsigned long allocs;
+	unsigned long fallbacks;
+};
+
+/**
+ * malloc_slab_get_stats() - Get statistics for a slab size class
+ *
+ * @class: Size class, counting from 0 for the smallest
+ * @stats: Returns the statistics
+ * Return: 0 if OK, -ENOENT if @class is out of range, -ENOSYS if the slab
+ * front-end is not enabled
+ */
+int malloc_slab_get_stats(int class, struct malloc_slab_stats *stats);
+
 #if CONFIG_IS_ENABLED(SYS_MALLOC_SIMPLE)
 #define malloc malloc_simple
 #define realloc realloc_simple
 #define memalign memalign_simple
-#if IS_ENABLED(CONFIG_VALGRIND)
+#if IS_ENABLED(CONFIG_VALGRIND) || \
+	CONFIG_IS_ENABLED(SYS_MALLOC_F_FREELIST) || \
+	CONFIG_IS_ENABLED(SYS_MALLOC_F_STATS)
 #define free free_simple
 #else
 static inline void free(void *ptr) {}
@@ -955,6 +985,27 @@ int initf_malloc(void);
 /* Simple versions which can be used when space is tight */
 void *malloc_simple(size_t size);
 void *memalign_simple(size_t alignment, size_t bytes);
+void free_simple(void *ptr);
+
+/**
+ * malloc_simple_owner() - Set the subsystem charged for early allocations
+ *
+ * Allocations from the pre-relocation (or SPL) malloc() pool are counted
+ * against the named subsystem until the owner is changed again. The usage
+ * and high-water mark of each subsystem is shown by malloc_simple_info().
+ * This does nothing once the full malloc() is set up.
+ *
+ * @name: Name of the subsystem, or NULL to stop charging any subsystem
+ * Return: previous owner, to be passed back to this function afterwards
+ */
+#if CONFIG_IS_ENABLED(SYS_MALLOC_F_STATS)
+const char *malloc_simple_owner(const char *name);
+#else
+static inline const char *malloc_simple_owner(const char *name)
+{
+	return NULL;
+}
+#endif
 
 #pragma GCC visibility push(hidden)
 # if __STD_C
@@ -17,6 +17,8 @@
 #include <part.h>
 
 struct bd_info;
+struct blk_req;
+struct cyclic_info;
 
 /* SD/MMC version bits; 8 flags, 8 major, 8 minor, 8 change */
 #define SD_VERSION_SD	(1U << 31)
@@ -67,6 +69,7 @@ struct bd_info;
 #define MMC_CAP_NONREMOVABLE	BIT(14)
 #define MMC_CAP_NEEDS_POLL	BIT(15)
 #define MMC_CAP_CD_ACTIVE_HIGH  BIT(16)
+#define MMC_CAP_SD_EXPRESS	BIT(17)	/* Can switch SD Express cards to PCIe */
 
 #define MMC_MODE_8BIT		BIT(30)
 #define MMC_MODE_4BIT		BIT(29)
@@ -74,7 +77,12 @@ struct bd_info;
 #define MMC_MODE_SPI		BIT(27)
 
 
+/* Most tasks which eMMC command queueing allows */
+#define MMC_CQE_MAX_TASKS	32
+
 #define SD_DATA_4BIT	0x00040000
+#define SD_SCR_CMD23	0x00000002
+#define SD_SCR_DATA_STAT_AFTER_ERASE	0x00800000
 
 #define IS_SD(x)	((x)->version & SD_VERSION_SD)
 #define IS_MMC(x)	((x)->version & MMC_VERSION_MMC)
@@ -134,6 +142,9 @@ static inline bool mmc_is_tuning_cmd(uint cmdidx)
 	return false;
 }
 
+/* SEND_IF_COND argument / response bits */
+#define SD_IF_COND_PCIE		0x00001000	/* PCIe available */
+
 /* SCR definitions in different words */
 #define SD_HIGHSPEED_BUSY	0x00020000
 #define SD_HIGHSPEED_SUPPORTED	0x00020000
@@ -206,6 +217,7 @@ static inline bool mmc_is_tuning_cmd(uint cmdidx)
 /*
  * EXT_CSD fields
  */
+#define EXT_CSD_CMDQ_MODE_EN		15	/* R/W */
 #define EXT_CSD_ENH_START_ADDR		136	/* R/W */
 #define EXT_CSD_ENH_SIZE_MULT		140	/* R/W */
 #define EXT_CSD_GP_SIZE_MULT		143	/* R/W */
@@ -224,6 +236,7 @@ static inline bool mmc_is_tuning_cmd(uint cmdidx)
 #define EXT_CSD_ERASE_GROUP_DEF		175	/* R/W */
 #define EXT_CSD_BOOT_BUS_WIDTH		177
 #define EXT_CSD_PART_CONF		179	/* R/W */
+#define EXT_CSD_ERASED_MEM_CONT		181	/* RO */
 #define EXT_CSD_BUS_WIDTH		183	/* R/W */
 #define EXT_CSD_STROBE_SUPPORT		184	/* R/W */
 #define EXT_CSD_HS_TIMING		185	/* R/W */
@@ -236,6 +249,8 @@ static inline bool mmc_is_tuning_cmd(uint cmdidx)
 #define EXT_CSD_BOOT_MULT		226	/* RO */
 #define EXT_CSD_SEC_FEATURE		231	/* RO */
 #define EXT_CSD_GENERIC_CMD6_TIME       248     /* RO */
+#define EXT_CSD_CMDQ_DEPTH		307	/* RO */
+#define EXT_CSD_CMDQ_SUPPORT		308	/* RO */
 #define EXT_CSD_BKOPS_SUPPORT		502	/* RO */
 
 /*
@@ -487,6 +502,29 @@ struct dm_mmc_ops {
 	 * @return 0 if OK, -ve on error
 	 */
 	int (*execute_tuning)(struct udevice *dev, uint opcode);
+
+#if CONFIG_IS_ENABLED(MMC_TUNING_CACHE)
+	/**
+	 * get_tuning() - Read back the result of tuning
+	 *
+	 * This is called after execute_tuning() succeeds, to obtain a value
+	 * which set_tuning() can later use to restore the same settings
+	 *
+	 * @dev:	Device to check
+	 * @valp:	Returns the host-specific tuning value (e.g. sample taps)
+	 * @return 0 if OK, -ve on error
+	 */
+	int (*get_tuning)(struct udevice *dev, u32 *valp);
+
+	/**
+	 * set_tuning() - Apply an earlier result of tuning
+	 *
+	 * @dev:	Device to update
+	 * @val:	Tuning value, as returned by get_tuning()
+	 * @return 0 if OK, -ve on error
+	 */
+	int (*set_tuning)(struct udevice *dev, u32 val);
+#endif
 #endif
 
 	/**
@@ -535,10 +573,99 @@ struct dm_mmc_ops {
 	 * @return 0 if success, -ve on error
 	 */
 	int (*hs400_prepare_ddr)(struct udevice *dev);
+
+#if CONFIG_IS_ENABLED(MMC_SD_EXPRESS)
+	/**
+	 * init_sd_express() - switch an SD Express card to PCIe
+	 *
+	 * This is called when the card reports that its PCIe interface is
+	 * available. The host must power the card for PCIe and route its
+	 * lanes to the PCIe root port, so that it can be found by the NVMe
+	 * driver when that bus is probed.
+	 *
+	 * @dev:	Device to use
+	 * @return 0 if OK, -ve on error, in which case the card is used as
+	 * a normal SD card
+	 */
+	int (*init_sd_express)(struct udevice *dev);
+#endif
+
+#if CONFIG_IS_ENABLED(MMC_CQE)
+	/**
+	 * cqe_enable() - start or halt the command-queue engine
+	 *
+	 * The card has already been switched into command-queue mode when
+	 * this is called to start the engine. Once it is halted, normal
+	 * commands can be sent again.
+	 *
+	 * @dev:	Device to update
+	 * @enable:	true to start the engine, false to halt it
+	 * @return 0 if OK, -ve on error
+	 */
+	int (*cqe_enable)(struct udevice *dev, bool enable);
+
+	/**
+	 * cqe_request() - queue a data transfer as a task
+	 *
+	 * This must not wait for the transfer to finish.
+	 *
+	 * @dev:	Device to use
+	 * @tag:	Task tag, from 0 to MMC_CQE_MAX_TASKS - 1
+	 * @start:	First block to transfer
+	 * @data:	Transfer to do, with a buffer aligned to
+	 *		ARCH_DMA_MINALIGN and at most cfg->cqe_b_max blocks
+	 * @return 0 if OK, -ve on error
+	 */
+	int (*cqe_request)(struct udevice *dev, uint tag, lbaint_t start,
+			   struct mmc_data *data);
+
+	/**
+	 * cqe_poll() - check for finished tasks, without waiting
+	 *
+	 * @dev:	Device to check
+	 * @donep:	Returns a mask of the tags of tasks which completed
+	 * @errp:	Returns a mask of the tags of tasks which failed
+	 * @return 0 if OK, -ve if the engine failed and must be halted
+	 */
+	int (*cqe_poll)(struct udevice *dev, ulong *donep, ulong *errp);
+#endif
 };
 
 #define mmc_get_ops(dev)        ((struct dm_mmc_ops *)(dev)->driver->ops)
 
+#define MMC_TUNING_RECS		4
+
+/**
+ * struct mmc_tuning_rec - the result of tuning a card
+ *
+ * @cid: CID of the card
+ * @seq: Sequence number of the MMC controller
+ * @opcode: Tuning command, MMC_CMD_SEND_TUNING_BLOCK(_HS200), 0 if unused
+ * @mode: Bus mode which the card was tuned for (enum bus_mode)
+ * @reserved: Reserved, must be zero
+ * @val: Host-specific tuning value from the get_tuning() method
+ */
+struct mmc_tuning_rec {
+	u32 cid[4];
+	u8 seq;
+	u8 opcode;
+	u8 mode;
+	u8 reserved;
+	u32 val;
+};
+
+/**
+ * struct mmc_tuning_handoff - tuning results, kept in the bloblist
+ *
+ * This is stored with the tag BLOBLISTT_U_BOOT_MMC_TUNING, so that later boot
+ * phases can skip tuning
+ *
+ * @rec: Tuning results
+ */
+struct mmc_tuning_handoff {
+	struct mmc_tuning_rec rec[MMC_TUNING_RECS];
+};
+
 /* Transition functions for compatibility */
 int mmc_set_ios(struct mmc *mmc);
 int mmc_getcd(struct mmc *mmc);
@@ -551,6 +678,7 @@ int mmc_deferred_probe(struct mmc *mmc);
 int mmc_reinit(struct mmc *mmc);
 int mmc_get_b_max(struct mmc *mmc, void *dst, lbaint_t blkcnt);
 int mmc_hs400_prepare_ddr(struct mmc *mmc);
+int mmc_init_sd_express(struct mmc *mmc);
 int mmc_send_stop_transmission(struct mmc *mmc, bool write);
 
 #else
@@ -582,6 +710,9 @@ struct mmc_config {
 	uint f_min;
 	uint f_max;
 	uint b_max;
+#if CONFIG_IS_ENABLED(MMC_CQE)
+	uint cqe_b_max;		/* max blocks per queued task, 0 if no CQE */
+#endif
 	unsigned char part_type;
 #if CONFIG_IS_ENABLED(MMC_PWRSEQ)
 	struct udevice *pwr_dev;
@@ -711,6 +842,12 @@ struct mmc {
 	char op_cond_pending;	/* 1 if we are waiting on an op_cond command */
 	char init_in_progress;	/* 1 if we have done mmc_start_init() */
 	char preinit;		/* start init as early as possible */
+	char op_cond_bg;	/* 1 if power-up is followed in the background */
+	char op_cond_busy;	/* 1 while the card is still powering up */
+	char op_cond_polling;	/* 1 while a power-up poll is being sent */
+	char op_cond_uhs;	/* 1 to ask for 1.8V signalling (SD only) */
+	ulong op_cond_start;	/* time when power-up polling started */
+	struct cyclic_info *op_cond_cyclic;	/* polls while powering up */
 	int ddr_mode;
 #if CONFIG_IS_ENABLED(DM_MMC)
 	struct udevice *dev;	/* Device for this MMC controller */
@@ -733,6 +870,13 @@ struct mmc {
 	bool hs400_tuning:1;
 
 	enum bus_mode user_speed_mode; /* input speed mode from user */
+#if CONFIG_IS_ENABLED(MMC_CQE)
+	uint cqe_depth;		/* number of tasks which can be queued, or 0 */
+	bool cqe_on;		/* command queueing is enabled on the card */
+	u32 cqe_busy;		/* mask of task tags in use */
+	u32 cqe_local;		/* mask of tags used by mmc_bread() itself */
+	struct blk_req *cqe_req[MMC_CQE_MAX_TASKS];
+#endif
 };
 
 #if CONFIG_IS_ENABLED(DM_MMC)
@@ -926,6 +1070,26 @@ int mmc_get_op_cond(struct mmc *mmc, bool quiet);
  */
 int mmc_start_init(struct mmc *mmc);
 
+/**
+ * mmc_start_init_all() - Start powering up all cards at once
+ *
+ * This starts initialisation of every probed MMC device which is not already
+ * initialised, without waiting for the cards to finish powering up. With
+ * CONFIG_MMC_PARALLEL_INIT a cyclic function then polls the cards until they
+ * are ready, so that mmc_init() has little left to wait for. Empty slots are
+ * skipped silently.
+ *
+ * Return: number of cards which are powering up
+ */
+#if CONFIG_IS_ENABLED(MMC_PARALLEL_INIT)
+int mmc_start_init_all(void);
+#else
+static inline int mmc_start_init_all(void)
+{
+	return 0;
+}
+#endif
+
 /**
  * Set preinit flag of mmc device.
  *
@@ -97,6 +97,18 @@ void ndisc_request(void);
  * Return: 0 if no timeout, -1 otherwise
  */
 int ndisc_timeout_check(void);
+
+/**
+ * ndisc_lookup() - Look up the MAC address to send a packet to
+ *
+ * This looks in the neighbour cache for @ip, or for the gateway if @ip is not
+ * on the local network
+ *
+ * @ip:		destination of the packet
+ * @ethaddr:	returns the MAC address, if known
+ * Return: true if known, false if neighbour discovery is needed
+ */
+bool ndisc_lookup(struct in6_addr *ip, uchar *ethaddr);
 bool validate_ra(struct ip6_hdr *ip6);
 int process_ra(struct ip6_hdr *ip6, int len);
 #else
@@ -119,6 +131,11 @@ static inline int ndisc_timeout_check(void)
 	return 0;
 }
 
+static inline bool ndisc_lookup(struct in6_addr *ip, uchar *ethaddr)
+{
+	return false;
+}
+
 static inline void ip6_send_rs(void)
 {
 }
@@ -43,6 +43,12 @@ struct udevice;
 /* Number of packets processed together */
 #define ETH_PACKETS_BATCH_RECV	32
 
+/* Number of transmitted packets which may be handed to a driver together */
+#define ETH_PACKETS_BATCH_SEND	16
+
+/* Most packets handled by one call to eth_rx() using recv_batch() */
+#define ETH_PACKETS_BUDGET	(4 * ETH_PACKETS_BATCH_RECV)
+
 /* ARP hardware address length */
 #define ARP_HLEN 6
 /*
@@ -143,6 +149,28 @@ enum eth_recv_flags {
 	ETH_RECV_CHECK_DEVICE		= 1 << 0,
 };
 
+enum eth_pkt_flags {
+	/*
+	 * The hardware has checked the UDP or TCP checksum of a received
+	 * packet (or the packet came from a trusted source which did not fill
+	 * it in), so the network stack need not do so
+	 */
+	ETH_PKT_CSUM_VALID		= 1 << 0,
+};
+
+/**
+ * struct eth_pkt - a packet passed to or from a driver in a batch
+ *
+ * @packet: packet data, starting with the Ethernet header
+ * @length: length of the packet in bytes
+ * @flags: flags for the packet (enum eth_pkt_flags), set by recv_batch
+ */
+struct eth_pkt {
+	uchar *packet;
+	int length;
+	uint flags;
+};
+
 /**
  * struct eth_ops - functions of Ethernet MAC controllers
  *
@@ -156,6 +184,17 @@ enum eth_recv_flags {
  * free_pkt: Give the driver an opportunity to manage its packet buffer memory
  *	     when the network stack is finished processing it. This will only be
  *	     called when no error was returned from recv - optional
+ * recv_batch: Like recv, but return up to count packets at once in pkts[],
+ *	       giving the number returned, 0 if there are none, or an error.
+ *	       The flags of each packet start at 0 and the driver may set
+ *	       ETH_PKT_CSUM_VALID if its hardware checked the checksum.
+ *	       Packets must stay valid until free_pkt is called for each of
+ *	       them, which happens once the whole batch is processed. Return
+ *	       -ENOSYS to have recv used instead - optional
+ * send_batch: Send count packets from pkts[], returning the number sent or
+ *	       an error. When provided, packets sent while a batch from
+ *	       recv_batch is processed are collected and passed here together,
+ *	       once processing is complete - optional
  * stop: Stop the hardware from looking for packets - may be called even if
  *	 state == PASSIVE
  * mcast: Join or leave a multicast group (for TFTP) - optional
@@ -178,6 +217,10 @@ struct eth_ops {
 	int (*send)(struct udevice *dev, void *packet, int length);
 	int (*recv)(struct udevice *dev, int flags, uchar **packetp);
 	int (*free_pkt)(struct udevice *dev, uchar *packet, int length);
+	int (*recv_batch)(struct udevice *dev, int flags, struct eth_pkt *pkts,
+			  int count);
+	int (*send_batch)(struct udevice *dev, struct eth_pkt *pkts,
+			  int count);
 	void (*stop)(struct udevice *dev);
 	int (*mcast)(struct udevice *dev, const u8 *enetaddr, int join);
 	int (*write_hwaddr)(struct udevice *dev);
@@ -503,6 +546,7 @@ extern uchar		*net_tx_packet;		/* THE transmit packet */
 extern uchar		*net_rx_packets[PKTBUFSRX]; /* Receive packets */
 extern uchar		*net_rx_packet;		/* Current receive packet */
 extern int		net_rx_packet_len;	/* Current rx packet length */
+extern bool		net_rx_csum_valid;	/* UDP/TCP checksum checked */
 extern const u8		net_bcast_ethaddr[ARP_HLEN];	/* Ethernet broadcast address */
 extern const u8		net_null_ethaddr[ARP_HLEN];
 
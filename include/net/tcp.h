@@ -5,6 +5,8 @@
  * Copyright 2017 Duncan Hare, All rights reserved.
  */
 
+#include <linux/log2.h>
+
 #define TCP_ACTIVITY 127		/* Number of packets received   */
 					/* before console progress mark */
 /**
@@ -86,7 +88,9 @@ struct ip_tcp_hdr {
 #define TCP_OPT_LEN_8	0x08
 #define TCP_OPT_LEN_A	0x0a		/* Timestamp Length		*/
 #define TCP_MSS		1460		/* Max segment size		*/
-#define TCP_SCALE	0x01		/* Scale			*/
+#define TCP_RCV_WND	(PKTBUFSRX * TCP_MSS)	/* Receive window	*/
+/* Scale: at least 1, and enough for the window to fit in 16 bits */
+#define TCP_SCALE	(TCP_RCV_WND >> 17 ? ilog2(TCP_RCV_WND >> 16) + 1 : 1)
 
 /**
  * struct tcp_mss - TCP option structure for MSS (Max segment size)
@@ -279,6 +283,7 @@ enum tcp_state {
 
 enum tcp_state tcp_get_tcp_state(void);
 void tcp_set_tcp_state(enum tcp_state new_state);
+u32 tcp_get_ack_edge(void);
 int tcp_set_tcp_header(uchar *pkt, int dport, int sport, int payload_len,
 		       u8 action, u32 tcp_seq_num, u32 tcp_ack_num);
 
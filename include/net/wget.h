@@ -8,6 +8,20 @@
  */
 void wget_start(void);
 
+/**
+ * wget_set_files() - Set more files to fetch after the first one
+ *
+ * The files are fetched one after another from the server of the first file,
+ * over the same connection, using HTTP/1.1 keep-alive. The list applies to
+ * the next wget operation and should be cleared afterwards.
+ *
+ * @argc: Number of arguments, 0 to clear the list
+ * @argv: Pairs of load address (hex) and path on the server
+ * Return: 0 if OK, -EINVAL if an argument is missing or invalid, -E2BIG if
+ *	there are too many files
+ */
+int wget_set_files(int argc, char *const argv[]);
+
 enum wget_state {
 	WGET_CLOSED,
 	WGET_CONNECTING,
@@ -19,3 +33,5 @@ enum wget_state {
 #define DEBUG_WGET		0	/* Set to 1 for debug messages */
 #define WGET_RETRY_COUNT	30
 #define WGET_TIMEOUT		2000UL
+#define WGET_ACK_DELAY		2UL	/* ms to hold back an ACK */
+#define WGET_MAX_FILES		8	/* files fetched by one command */
@@ -11,10 +11,41 @@
 
 struct abuf;
 struct device_node;
+struct property;
+
+/**
+ * struct of_live_prebuilt - Live tree laid out at build time
+ *
+ * This is generated by scripts/dtb_live.py from the control devicetree when
+ * CONFIG_OF_LIVE_PREBUILT is enabled. Pointers into the devicetree blob
+ * (names, types and property values) hold offsets from the start of the blob
+ * until of_live_build() fixes them up.
+ *
+ * @np: Nodes, with the root node first
+ * @np_count: Number of nodes
+ * @pp: Properties
+ * @pp_count: Number of properties
+ * @fdt_size: Total size of the blob the tree was generated from
+ * @fdt_crc32: CRC32 of the blob the tree was generated from
+ */
+struct of_live_prebuilt {
+	struct device_node *np;
+	int np_count;
+	struct property *pp;
+	int pp_count;
+	unsigned int fdt_size;
+	unsigned int fdt_crc32;
+};
+
+extern const struct of_live_prebuilt of_live_prebuilt;
 
 /**
  * of_live_build() - build a live (hierarchical) tree from a flat DT
  *
+ * With CONFIG_OF_LIVE_PREBUILT, if @fdt_blob matches the control devicetree
+ * seen at build time, the prebuilt tree is used instead of unflattening the
+ * blob. The prebuilt tree can only be used once, and is never freed.
+ *
  * @fdt_blob: Input tree to convert
  * @rootp: Returns live tree that was created
  * Return: 0 if OK, -ve on error
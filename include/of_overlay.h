@@ -0,0 +1,106 @@
+/* SPDX-License-Identifier: GPL-2.0+ */
+/*
+ * Applying devicetree overlays to a live tree
+ *
+ * fdt_overlay_apply() rescans the whole base tree for each overlay, to find
+ * the largest phandle, the fragment targets and the symbols, and every node
+ * and property it adds moves the rest of the blob. When many overlays are
+ * applied this is slow. These functions unflatten the base tree once, keep
+ * indexes of its phandles and symbols, apply any number of overlays to the
+ * live tree and then flatten the result once.
+ *
+ * The result is the same as applying the overlays in order with
+ * fdt_overlay_apply()
+ */
+
+#ifndef __OF_OVERLAY_H
+#define __OF_OVERLAY_H
+
+#include <dm/of.h>
+#include <linux/types.h>
+
+struct abuf;
+struct of_overlay_phandle;
+struct of_overlay_sym;
+
+/**
+ * struct of_overlay_ctx - State for applying overlays to a live tree
+ *
+ * @root: Root of the live tree
+ * @symbols: /__symbols__ node, or NULL if none
+ * @phandles: Index of nodes with a phandle, sorted by phandle
+ * @phandle_count: Number of entries in @phandles
+ * @phandle_max: Number of entries allocated for @phandles
+ * @syms: Index of the properties in @symbols, sorted by name
+ * @sym_count: Number of entries in @syms
+ * @sym_max: Number of entries allocated for @syms
+ * @rsv: Memory reservations of the base tree, as pairs of address and size
+ * @rsv_count: Number of memory reservations
+ * @allocs: Memory allocated for the tree, freed by of_overlay_end()
+ * @alloc_count: Number of entries in @allocs
+ * @alloc_max: Number of entries allocated for @allocs
+ * @gen: Incremented when a node is added which may change the result of a
+ *	path lookup
+ */
+struct of_overlay_ctx {
+	struct device_node *root;
+	struct device_node *symbols;
+	struct of_overlay_phandle *phandles;
+	int phandle_count;
+	int phandle_max;
+	struct of_overlay_sym *syms;
+	int sym_count;
+	int sym_max;
+	u64 *rsv;
+	int rsv_count;
+	void **allocs;
+	int alloc_count;
+	int alloc_max;
+	uint gen;
+};
+
+/**
+ * of_overlay_begin() - Prepare to apply overlays to a devicetree
+ *
+ * The live tree refers to @fdt, so @fdt must not be changed until
+ * of_overlay_end() is called
+ *
+ * @ctx: Context to set up
+ * @fdt: Base devicetree
+ * Return: 0 if OK, -EINVAL if @fdt is not valid, -ENOMEM if out of memory
+ */
+int of_overlay_begin(struct of_overlay_ctx *ctx, const void *fdt);
+
+/**
+ * of_overlay_apply() - Apply an overlay
+ *
+ * The overlay is copied, so @fdto is not changed and can be freed afterwards.
+ * If this fails, the tree may be partly updated and should not be used.
+ *
+ * @ctx: Context from of_overlay_begin()
+ * @fdto: Overlay to apply
+ * Return: 0 if OK, -EINVAL if the overlay is not valid, -ENOENT if it refers
+ *	to a node or symbol which is not in the tree, -ERANGE if the phandles
+ *	overflow, -ENOMEM if out of memory
+ */
+int of_overlay_apply(struct of_overlay_ctx *ctx, const void *fdto);
+
+/**
+ * of_overlay_flatten() - Flatten the tree with the overlays applied
+ *
+ * The memory reservations of the base tree are kept
+ *
+ * @ctx: Context from of_overlay_begin()
+ * @buf: Returns the devicetree (inited by this function)
+ * Return: 0 if OK, -ENOMEM if out of memory, other -ve on error
+ */
+int of_overlay_flatten(struct of_overlay_ctx *ctx, struct abuf *buf);
+
+/**
+ * of_overlay_end() - Free the live tree and the indexes
+ *
+ * @ctx: Context from of_overlay_begin()
+ */
+void of_overlay_end(struct of_overlay_ctx *ctx);
+
+#endif
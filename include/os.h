@@ -81,6 +81,7 @@ int os_open(const char *pathname, int flags);
 #define OS_O_MASK	3	/* Mask for read/write flags */
 #define OS_O_CREAT	0100
 #define OS_O_TRUNC	01000
+#define OS_O_DIRECT	040000	/* Bypass the host's page cache */
 
 /**
  * os_close() - access to the OS close() system call
@@ -478,6 +479,20 @@ int os_read_file(const char *name, void **bufp, int *sizep);
  */
 int os_map_file(const char *pathname, int os_flags, void **bufp, int *sizep);
 
+/**
+ * os_map_fd() - Map an open file into memory
+ *
+ * Unlike os_map_file() this can map files larger than 2GB. The mapping is
+ * shared, so writes to it are written back to the file.
+ *
+ * @fd:		File descriptor as returned by os_open()
+ * @os_flags:	Flags the file was opened with, like OS_O_RDONLY, OS_O_RDWR
+ * @size:	Number of bytes to map, from the start of the file
+ * @bufp:	Returns the mapped address
+ * Return:	0 if OK, -ve on error
+ */
+int os_map_fd(int fd, int os_flags, size_t size, void **bufp);
+
 /**
  * os_unmap() - Unmap a file previously mapped
  *
@@ -485,7 +500,7 @@ int os_map_file(const char *pathname, int os_flags, void **bufp, int *sizep);
  * @size: Size in bytes
  * Return:	0 if OK, -ve on error
  */
-int os_unmap(void *buf, int size);
+int os_unmap(void *buf, size_t size);
 
 /*
  * os_find_text_base() - Find the text section in this running process
@@ -530,6 +545,22 @@ int os_setup_signal_handlers(void);
  */
 void os_signal_action(int sig, unsigned long pc);
 
+/**
+ * os_profiler_start() - start sampling the program counter
+ *
+ * This uses SIGPROF, so only counts time when sandbox is actually running.
+ *
+ * @hz:		sampling rate in Hz
+ * @func:	function to call with each sample, from the signal handler
+ * Return:	0 if OK, -ve on error
+ */
+int os_profiler_start(unsigned int hz, void (*func)(unsigned long pc));
+
+/**
+ * os_profiler_stop() - stop sampling the program counter
+ */
+void os_profiler_stop(void);
+
 /**
  * os_get_time_offset() - get time offset
  *
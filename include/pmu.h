@@ -0,0 +1,60 @@
+/* SPDX-License-Identifier: GPL-2.0+ */
+/*
+ * Access to the CPU's hardware performance counters
+ *
+ * Each architecture provides a cycle counter and, where there is a standard
+ * event for it, a cache-miss counter. The counters run freely once enabled;
+ * callers read them at two points and subtract.
+ */
+
+#ifndef __PMU_H
+#define __PMU_H
+
+#include <linux/errno.h>
+#include <linux/types.h>
+
+/**
+ * struct pmu_counts - Values of the performance counters
+ *
+ * @cycles: CPU cycles
+ * @cache_misses: Cache misses (refills), or 0 if the architecture cannot
+ *	count them. This is the L1 data cache on ARMv8 and the last-level
+ *	cache on x86
+ */
+struct pmu_counts {
+	u64 cycles;
+	u64 cache_misses;
+};
+
+#if CONFIG_IS_ENABLED(PMU_COUNTERS)
+/**
+ * pmu_counters_init() - Enable the performance counters
+ *
+ * This does not reset the counters, so it can be called again (e.g. by
+ * U-Boot proper after SPL) without losing the counts so far
+ *
+ * Return: 0 if OK, -EPERM if the counters cannot be used at the current
+ *	privilege level, -ENOSYS if the CPU does not have them
+ */
+int pmu_counters_init(void);
+
+/**
+ * pmu_counters_read() - Read the performance counters
+ *
+ * @counts: Returns the current values
+ */
+void pmu_counters_read(struct pmu_counts *counts);
+#else
+static inline int pmu_counters_init(void)
+{
+	return -ENOSYS;
+}
+
+static inline void pmu_counters_read(struct pmu_counts *counts)
+{
+	counts->cycles = 0;
+	counts->cache_misses = 0;
+}
+#endif
+
+#endif
@@ -157,6 +157,8 @@ enum regulator_flag {
  * @force_off* - bool type, true or false
  * TODO(sjg@chromium.org): Consider putting the above two into @flags
  * @ramp_delay - Time to settle down after voltage change (unit: uV/us)
+ * @ready_us   - timer_get_us() value at which the output will have settled,
+ *		or 0 if it has
  * @flags:     - flags value (see REGULATOR_FLAG_...)
  * @name**     - fdt regulator name - should be taken from the device tree
  * ctrl_reg:   - Control register offset used to enable/disable regulator
@@ -178,6 +180,7 @@ struct dm_regulator_uclass_plat {
 	int min_uA;
 	int max_uA;
 	unsigned int ramp_delay;
+	ulong ready_us;
 	bool always_on;
 	bool boot_on;
 	bool force_off;
@@ -359,6 +362,40 @@ int regulator_get_enable(struct udevice *dev);
  */
 int regulator_set_enable(struct udevice *dev, bool enable);
 
+/**
+ * regulator_set_enable_nowait: set regulator enable state without waiting
+ *
+ * This is the same as regulator_set_enable(), except that it does not wait
+ * for the output to settle after enabling it. This allows several regulators
+ * to ramp up at once, or other work to be done in the meantime. Call
+ * regulator_wait_ready() before using the supply. regulator_set_enable()
+ * also does this, so a consumer which enables an already enabled regulator
+ * waits for it to be ready.
+ *
+ * @dev    - pointer to the regulator device
+ * @enable - set true or false
+ * Return: - 0 on success or -errno val if fails
+ */
+int regulator_set_enable_nowait(struct udevice *dev, bool enable);
+
+/**
+ * regulator_wait_ready: wait for the regulator output to settle
+ *
+ * @dev    - pointer to the regulator device
+ */
+void regulator_wait_ready(struct udevice *dev);
+
+/**
+ * regulator_set_ready_delay: record how long the output takes to settle
+ *
+ * This is called by regulator drivers when changing the output, instead of
+ * waiting. If a delay is already pending, the later of the two is used.
+ *
+ * @dev      - pointer to the regulator device
+ * @delay_us - time from now until the output has settled, in microseconds
+ */
+void regulator_set_ready_delay(const struct udevice *dev, uint delay_us);
+
 /**
  * regulator_set_enable_if_allowed: set regulator enable state if allowed by
  *					regulator
@@ -421,7 +458,8 @@ int regulator_set_mode(struct udevice *dev, int mode_id);
  * only works for regulators which don't have a range for voltage/current,
  * since in that case it is not possible to know which value to use.
  *
- * This effectively calls regulator_autoset() for every regulator.
+ * This effectively calls regulator_autoset() for every regulator, except
+ * that the regulators all ramp up at once and it only waits for the slowest.
  */
 int regulators_enable_boot_on(bool verbose);
 
@@ -604,6 +642,15 @@ static inline int regulator_set_enable(struct udevice *dev, bool enable)
 	return -ENOSYS;
 }
 
+static inline int regulator_set_enable_nowait(struct udevice *dev, bool enable)
+{
+	return -ENOSYS;
+}
+
+static inline void regulator_wait_ready(struct udevice *dev)
+{
+}
+
 static inline int regulator_set_enable_if_allowed(struct udevice *dev, bool enable)
 {
 	return -ENOSYS;
@@ -0,0 +1,93 @@
+/* SPDX-License-Identifier: GPL-2.0+ */
+/*
+ * Statistical (sampling) profiler
+ *
+ * A periodic timer interrupt records the program counter of whatever code was
+ * running into a ring buffer. The samples can be printed with the 'profiler'
+ * command and turned into a per-function histogram on the host with
+ * tools/profiler.py, which looks up each address in u-boot.map or System.map
+ *
+ * Unlike function tracing (CONFIG_TRACE), this needs no special compiler
+ * flags, so it can be used with production configurations.
+ */
+
+#ifndef __PROFILER_H
+#define __PROFILER_H
+
+#include <linux/types.h>
+
+/**
+ * struct profiler_info - Information about the samples collected
+ *
+ * @hz: Sampling rate in Hz, or 0 if the profiler is not running
+ * @count: Number of samples currently held in the buffer
+ * @total: Number of samples taken since the profiler was last started. If
+ *	this is larger than @count, the oldest samples were overwritten
+ */
+struct profiler_info {
+	uint hz;
+	uint count;
+	ulong total;
+};
+
+/**
+ * profiler_start() - Start collecting samples
+ *
+ * Any samples from a previous run are discarded
+ *
+ * @hz: Sampling rate in Hz
+ * Return: 0 if OK, -EALREADY if already running, -EINVAL if @hz is 0, or
+ *	other -ve error from the architecture
+ */
+int profiler_start(uint hz);
+
+/**
+ * profiler_stop() - Stop collecting samples
+ *
+ * The samples collected so far remain available. This does nothing if the
+ * profiler is not running.
+ */
+void profiler_stop(void);
+
+/**
+ * profiler_get_info() - Get information about the samples collected
+ *
+ * @info: Returns the information
+ */
+void profiler_get_info(struct profiler_info *info);
+
+/**
+ * profiler_get_sample() - Get a sample from the buffer
+ *
+ * @seq: Sample number, with 0 being the oldest sample in the buffer
+ * Return: link-time address of the code which was running, or 0 if @seq is
+ *	out of range
+ */
+ulong profiler_get_sample(uint seq);
+
+/**
+ * profiler_record() - Record a sample
+ *
+ * This is called from the architecture's timer interrupt
+ *
+ * @pc: Run-time address of the code which was interrupted
+ */
+void profiler_record(ulong pc);
+
+/**
+ * arch_profiler_start() - Start the periodic sampling interrupt
+ *
+ * This is implemented by the architecture, which must call profiler_record()
+ * from the interrupt
+ *
+ * @hz: Sampling rate in Hz
+ * Return: 0 if OK, -ve on error
+ */
+int arch_profiler_start(uint hz);
+
+/**
+ * arch_profiler_stop() - Stop the periodic sampling interrupt
+ */
+void arch_profiler_stop(void);
+
+#endif
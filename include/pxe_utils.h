@@ -82,13 +82,17 @@ struct pxe_menu {
 struct pxe_context;
 typedef int (*pxe_getfile_func)(struct pxe_context *ctx, const char *file_path,
 				char *file_addr, ulong *filesizep);
+typedef int (*pxe_gethead_func)(struct pxe_context *ctx,
+				const char *file_path, ulong addr, ulong len);
 
 /**
  * struct pxe_context - context information for PXE parsing
  *
  * @cmdtp: Pointer to command table to use when calling other commands
  * @getfile: Function called by PXE to read a file
- * @userdata: Data the caller requires for @getfile
+ * @gethead: Function called by PXE to read the start of a file, or NULL if
+ *	not supported. This is set by the caller after pxe_setup_ctx()
+ * @userdata: Data the caller requires for @getfile and @gethead
  * @allow_abs_path: true to allow absolute paths
  * @bootdir: Directory that files are loaded from ("" if no directory). This is
  *	allocated
@@ -108,6 +112,16 @@ struct pxe_context {
 	 * Return 0 if OK, -ve on error
 	 */
 	pxe_getfile_func getfile;
+	/**
+	 * gethead() - read the start of a file
+	 *
+	 * @ctx: PXE context
+	 * @file_path: Path to the file
+	 * @addr: Address to put the data in memory
+	 * @len: Number of bytes to read
+	 * Return 0 if OK, -ve on error
+	 */
+	pxe_gethead_func gethead;
 
 	void *userdata;
 	bool allow_abs_path;
@@ -329,4 +329,22 @@ int qemu_cpu_fixup(void);
 int qemu_fwcfg_setup_kernel(struct udevice *qfw_dev, ulong load_addr,
 			    ulong initrd_addr);
 
+/**
+ * qemu_fwcfg_load_kernel() - Load the kernel where booti will run it
+ *
+ * This is like qemu_fwcfg_setup_kernel() except that an uncompressed arm64 or
+ * RISC-V Image is read straight to the address booti would move it to, so it
+ * does not need to be copied again before it is started. Other kernels are
+ * loaded to @load_addr as usual.
+ *
+ * @qfw_dev: QEMU firmware config device
+ * @load_addr: Load address for kernel, used for the header and if the kernel
+ *	cannot be loaded to its final address
+ * @initrd_addr: Load address for ramdisk
+ * @kernel_addrp: Returns the address the kernel was loaded to
+ * Return: 0 if OK, -ENOENT if no kernel
+ */
+int qemu_fwcfg_load_kernel(struct udevice *qfw_dev, ulong load_addr,
+			   ulong initrd_addr, ulong *kernel_addrp);
+
 #endif
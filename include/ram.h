@@ -25,6 +25,21 @@ struct ram_ops {
 	 * @return 0 if OK, -ve on error
 	 */
 	int (*get_info)(struct udevice *dev, struct ram_info *info);
+
+	/**
+	 * scrub() - Initialise a region of ECC memory (optional)
+	 *
+	 * This uses the controller's own scrubber to write every location in
+	 * the region, so that its ECC check bits are valid. It does not return
+	 * until this is complete.
+	 *
+	 * @dev:	Device to use (UCLASS_RAM)
+	 * @base:	Start of the region
+	 * @size:	Size of the region in bytes
+	 * @return 0 if OK, -ENOSYS if the region cannot be scrubbed by the
+	 *	controller, other -ve on error
+	 */
+	int (*scrub)(struct udevice *dev, phys_addr_t base, phys_size_t size);
 };
 
 #define ram_get_ops(dev)        ((struct ram_ops *)(dev)->driver->ops)
@@ -38,4 +53,20 @@ struct ram_ops {
  */
 int ram_get_info(struct udevice *dev, struct ram_info *info);
 
+/**
+ * ram_scrub() - Initialise a region of ECC memory
+ *
+ * This writes zeroes to every location in the region so that its ECC check
+ * bits are valid. The controller's scrubber is used if @dev has one. If not,
+ * the memory is cleared by the CPUs, with the data cache (if enabled) flushed
+ * afterwards so that the writes reach the memory.
+ *
+ * @dev:	RAM controller (UCLASS_RAM), or NULL if not known
+ * @base:	Start of the region, aligned to ARCH_DMA_MINALIGN
+ * @size:	Size of the region in bytes, aligned to ARCH_DMA_MINALIGN
+ * Return: 0 if OK, -EINVAL if the region is not aligned, -E2BIG if it cannot
+ *	be mapped, other -ve on error
+ */
+int ram_scrub(struct udevice *dev, phys_addr_t base, phys_size_t size);
+
 #endif
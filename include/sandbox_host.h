@@ -8,17 +8,39 @@
 #ifndef __SANDBOX_HOST__
 #define __SANDBOX_HOST__
 
+/**
+ * enum host_mode - How a host device accesses its file
+ *
+ * @HOST_MODE_RW: Use read() and write() on the file, through the host's page
+ *	cache
+ * @HOST_MODE_MMAP: Map the whole file into memory, so that accesses are just
+ *	memcpy(). This is the fastest mode for large images.
+ * @HOST_MODE_DIRECT: Open the file with O_DIRECT, bypassing the host's page
+ *	cache, so that access times are closer to those of a real device
+ */
+enum host_mode {
+	HOST_MODE_RW,
+	HOST_MODE_MMAP,
+	HOST_MODE_DIRECT,
+};
+
 /**
  * struct host_sb_plat - platform data for a host device
  *
  * @label: Label for this device (allocated)
  * @filename: Name of file this is attached to, or NULL (allocated)
  * @fd: File descriptor of file, or 0 for none (file is not open)
+ * @mode: How the file is accessed
+ * @buf: Mapping of the file with HOST_MODE_MMAP, else NULL
+ * @size: Size of the mapping in bytes
  */
 struct host_sb_plat {
 	char *label;
 	char *filename;
 	int fd;
+	enum host_mode mode;
+	void *buf;
+	size_t size;
 };
 
 /**
@@ -57,6 +79,17 @@ struct host_ops {
  */
 int host_attach_file(struct udevice *dev, const char *filename);
 
+/**
+ * host_set_mode() - Set how the device accesses its file
+ *
+ * This must be called before a file is attached
+ *
+ * @dev: Device to update
+ * @mode: Access mode to use
+ * Returns: 0 if OK, -EBUSY if a file is already attached
+ */
+int host_set_mode(struct udevice *dev, enum host_mode mode);
+
 /**
  * host_detach_file() - Detach a file from the device
  *
@@ -96,6 +129,25 @@ int host_create_attach_file(const char *label, const char *filename,
 			    bool removable, unsigned long blksz,
 			    struct udevice **devp);
 
+/**
+ * host_create_attach_file_mode() - Create a host device with an access mode
+ *
+ * This is the same as host_create_attach_file() but allows the file to be
+ * accessed in a mode other than HOST_MODE_RW
+ *
+ * @label: Label of the attachment, e.g. "test1"
+ * @filename: Name of the file, e.g. "/path/to/disk.img"
+ * @removable: true if the device should be marked as removable, false
+ *	if it is fixed. See enum blk_flag_t
+ * @blksz: logical block size of the device
+ * @mode: How to access the file
+ * @devp: Returns the device created, on success
+ * Returns: 0 if OK, -ve on error
+ */
+int host_create_attach_file_mode(const char *label, const char *filename,
+				 bool removable, unsigned long blksz,
+				 enum host_mode mode, struct udevice **devp);
+
 /**
  * host_find_by_label() - Find a host by label
  *
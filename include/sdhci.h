@@ -253,8 +253,14 @@
 #define SDHCI_QUIRK_SUPPORT_SINGLE	(1 << 10)
 /* Capability register bit-63 indicates HS400 support */
 #define SDHCI_QUIRK_CAPS_BIT63_FOR_HS400	BIT(11)
+/* Host needs no tuning, or cannot use the standard tuning procedure */
+#define SDHCI_QUIRK_NO_STD_TUNING	BIT(12)
+
+/* Most tuning commands to send before giving up */
+#define SDHCI_TUNING_LOOP_COUNT		40
 
 /* to make gcc happy */
+struct cqhci_host;
 struct sdhci_host;
 
 /*
@@ -362,6 +368,9 @@ struct sdhci_host {
 #if CONFIG_IS_ENABLED(MMC_SDHCI_ADMA)
 	struct sdhci_adma_desc *adma_desc_table;
 #endif
+#if CONFIG_IS_ENABLED(MMC_CQHCI)
+	struct cqhci_host *cqhci;
+#endif
 };
 
 #ifdef CONFIG_MMC_SDHCI_IO_ACCESSORS
@@ -528,6 +537,23 @@ int sdhci_set_clock(struct mmc *mmc, unsigned int clock);
  * @host: SDHCI host structure
  */
 void sdhci_set_control_reg(struct sdhci_host *host);
+
+/**
+ * sdhci_cqe_init() - Set up the command-queue engine of an SDHCI controller
+ *
+ * This should be called from the driver's probe() method after
+ * sdhci_setup_cfg(), for controllers which have a CQHCI engine. The MMC core
+ * then uses the engine for eMMC command queueing.
+ *
+ * @host:	SDHCI host structure
+ * @cq:		Engine to set up, which must stay valid while the device is
+ *		in use. Its @task_desc_128 field must be set up if needed.
+ * @cfg:	Configuration structure (generally &plat->cfg)
+ * @base:	Address of the CQHCI registers
+ * Return: 0 if OK, -ve on error
+ */
+int sdhci_cqe_init(struct sdhci_host *host, struct cqhci_host *cq,
+		   struct mmc_config *cfg, void __iomem *base);
 extern const struct dm_mmc_ops sdhci_ops;
 #else
 #endif
@@ -1044,6 +1044,29 @@ struct legacy_img_hdr *spl_get_load_buffer(ssize_t offset, size_t size);
  */
 int board_spl_fit_append_fdt_skip(const char *name);
 
+/**
+ * board_spl_fit_verified() - Check whether a FIT is known to be verified
+ *
+ * This is used with CONFIG_SPL_FIT_VERIFY_CACHE. See the help for that
+ * option for the security requirements.
+ *
+ * @fit:	Pointer to the FIT header
+ * @digest:	SHA256 digest of the FIT header (SHA256_SUM_LEN bytes)
+ * Return:	true if the signature and hashes of this FIT need not be checked
+ */
+bool board_spl_fit_verified(const void *fit, const u8 *digest);
+
+/**
+ * board_spl_fit_set_verified() - Record that a FIT has been verified
+ *
+ * This is called with CONFIG_SPL_FIT_VERIFY_CACHE once all the images in a FIT
+ * have been loaded and their signature and hashes checked
+ *
+ * @fit:	Pointer to the FIT header
+ * @digest:	SHA256 digest of the FIT header (SHA256_SUM_LEN bytes)
+ */
+void board_spl_fit_set_verified(const void *fit, const u8 *digest);
+
 void board_boot_order(u32 *spl_boot_list);
 void spl_save_restore_data(void);
 
@@ -1064,6 +1087,7 @@ int spl_load_fit_image(struct spl_image_info *spl_image,
  */
 static inline bool spl_decompression_enabled(void)
 {
-	return IS_ENABLED(CONFIG_SPL_GZIP) || IS_ENABLED(CONFIG_SPL_LZMA);
+	return IS_ENABLED(CONFIG_SPL_GZIP) || IS_ENABLED(CONFIG_SPL_LZMA) ||
+		IS_ENABLED(CONFIG_SPL_LZ4) || IS_ENABLED(CONFIG_SPL_ZSTD);
 }
 #endif
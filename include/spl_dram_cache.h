@@ -0,0 +1,98 @@
+/* SPDX-License-Identifier: GPL-2.0+ */
+/*
+ * Saving and restoring DRAM training results
+ *
+ * DRAM drivers which support this save their training results after training
+ * and, on the next boot, restore them and program the controller and PHY
+ * directly instead of training again. The results are stored in SPI flash or
+ * on an MMC device, with a CRC32 and the board ID, so that results from
+ * another board, another driver or a corrupted write are never used.
+ *
+ * A driver should fall back to full training (and save the new results) if
+ * the restored results do not work, e.g. a memory test fails.
+ */
+
+#ifndef __SPL_DRAM_CACHE_H
+#define __SPL_DRAM_CACHE_H
+
+#include <linux/errno.h>
+#include <linux/types.h>
+
+/* Magic number at the start of the stored results */
+#define DRAM_CACHE_MAGIC	0x43415244	/* "DRAC" */
+
+/**
+ * struct spl_dram_cache_hdr - header in front of the stored results
+ *
+ * All values are little-endian
+ *
+ * @magic: DRAM_CACHE_MAGIC
+ * @id: ID chosen by the driver, which should change whenever the layout of
+ *	its results changes
+ * @board_id: Value of spl_dram_cache_board_id() when the results were saved
+ * @size: Size of the results in bytes, not including this header
+ * @crc: CRC32 of this header (with @crc set to 0) followed by the results
+ * @reserved: Set to 0
+ */
+struct spl_dram_cache_hdr {
+	u32 magic;
+	u32 id;
+	u32 board_id;
+	u32 size;
+	u32 crc;
+	u32 reserved[3];
+};
+
+#if CONFIG_IS_ENABLED(DRAM_CACHE)
+/**
+ * spl_dram_cache_load() - Read saved DRAM training results
+ *
+ * @id: ID chosen by the driver
+ * @data: Buffer to hold the results
+ * @size: Size of the results in bytes
+ * Return: 0 if OK, -ENOENT if there are no valid results for this board,
+ *	driver ID and size, -E2BIG if @size is too large for
+ *	CONFIG_SPL_DRAM_CACHE_SIZE, other -ve error if the storage could not
+ *	be read
+ */
+int spl_dram_cache_load(u32 id, void *data, uint size);
+
+/**
+ * spl_dram_cache_save() - Save DRAM training results
+ *
+ * This does nothing if the same results are already saved, to avoid wearing
+ * out the storage
+ *
+ * @id: ID chosen by the driver
+ * @data: Results to save
+ * @size: Size of the results in bytes
+ * Return: 0 if OK, -E2BIG if @size is too large for
+ *	CONFIG_SPL_DRAM_CACHE_SIZE, -ENOSYS if the storage cannot be written in
+ *	this phase, other -ve error if the storage could not be written
+ */
+int spl_dram_cache_save(u32 id, const void *data, uint size);
+
+/**
+ * spl_dram_cache_board_id() - Get an ID for this board
+ *
+ * Boards should implement this to return a value which is different for
+ * each board (e.g. derived from a serial number in the SoC fuses) and which
+ * changes if the memory is changed (e.g. includes the board revision). The
+ * default returns 0.
+ *
+ * Return: board ID
+ */
+u32 spl_dram_cache_board_id(void);
+#else
+static inline int spl_dram_cache_load(u32 id, void *data, uint size)
+{
+	return -ENOSYS;
+}
+
+static inline int spl_dram_cache_save(u32 id, const void *data, uint size)
+{
+	return -ENOSYS;
+}
+#endif
+
+#endif
@@ -57,6 +57,9 @@ enum tpm_version {
  * @pcr_select_min:	Minimum size in bytes of the pcrSelect array
  * @plat_hier_disabled:	Platform hierarchy has been disabled (TPM is locked
  *			down until next reboot)
+ * @active_pcr_banks:	Bitmask of the active PCR banks, read from the TPM on
+ *			first use since U-Boot never changes them; 0 if not
+ *			read yet
  */
 struct tpm_chip_priv {
 	enum tpm_version version;
@@ -69,6 +72,7 @@ struct tpm_chip_priv {
 	uint pcr_count;
 	uint pcr_select_min;
 	bool plat_hier_disabled;
+	u32 active_pcr_banks;
 };
 
 /**
@@ -21,6 +21,22 @@
  */
 int ulz4fn(const void *src, size_t srcn, void *dst, size_t *dstn);
 
+struct image_reader;
+
+/**
+ * ulz4fn_read() - Decompress LZ4 data as it is read
+ *
+ * The data is read into a buffer of IMAGE_READ_CHUNK bytes, or the maximum
+ * block size given in the frame header if that is larger
+ *
+ * @rd: Reader for the compressed data
+ * @dst: Destination for uncompressed data
+ * @dstn: Size of the destination buffer; returns length of uncompressed data
+ * Return: as ulz4fn(), or -ENOMEM if there is not enough memory for the
+ *	buffer
+ */
+int ulz4fn_read(struct image_reader *rd, void *dst, size_t *dstn);
+
 /**
  * LZ4_decompress_safe() - Decompression protected against buffer overflow
  * @source: source address of the compressed data
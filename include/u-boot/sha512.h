@@ -27,6 +27,32 @@ void sha512_finish(sha512_context * ctx, uint8_t digest[SHA512_SUM_LEN]);
 void sha512_csum_wd(const unsigned char *input, unsigned int ilen,
 		unsigned char *output, unsigned int chunk_sz);
 
+/**
+ * sha512_process() - Run the SHA-512 compression function over some blocks
+ *
+ * This is shared by SHA-384 and SHA-512. It is weak so that architectures
+ * can provide an accelerated version.
+ *
+ * @ctx: SHA-512 context to update
+ * @data: Input data, @blocks * SHA512_BLOCK_SIZE bytes long
+ * @blocks: Number of blocks to process
+ */
+void sha512_process(sha512_context *ctx, const uint8_t *data,
+		    unsigned int blocks);
+
+/**
+ * sha512_process_generic() - Portable C version of sha512_process()
+ *
+ * This is for use by accelerated versions which must fall back to software
+ * when the CPU lacks the required instructions.
+ *
+ * @ctx: SHA-512 context to update
+ * @data: Input data, @blocks * SHA512_BLOCK_SIZE bytes long
+ * @blocks: Number of blocks to process
+ */
+void sha512_process_generic(sha512_context *ctx, const uint8_t *data,
+			    unsigned int blocks);
+
 extern const uint8_t sha384_der_prefix[];
 
 void sha384_starts(sha512_context * ctx);
@@ -17,6 +17,7 @@
 #include <linux/usb/ch9.h>
 #include <asm/cache.h>
 #include <part.h>
+#include <linux/errno.h>
 
 extern bool usb_started; /* flag for the started/stopped USB status */
 
@@ -196,6 +197,35 @@ int submit_control_msg(struct usb_device *dev, unsigned long pipe, void *buffer,
 int submit_int_msg(struct usb_device *dev, unsigned long pipe, void *buffer,
 			int transfer_len, int interval, bool nonblock);
 
+#if CONFIG_IS_ENABLED(DM_USB)
+int usb_queue_bulk_msg(struct usb_device *dev, unsigned long pipe,
+		       unsigned int stream_id, void *buffer, int transfer_len);
+int usb_reap_bulk_msg(struct usb_device *dev, unsigned long pipe);
+int usb_alloc_streams(struct usb_device *dev, unsigned long *pipes,
+		      int num_pipes, unsigned int num_streams);
+#else
+static inline int usb_queue_bulk_msg(struct usb_device *dev,
+				     unsigned long pipe,
+				     unsigned int stream_id, void *buffer,
+				     int transfer_len)
+{
+	return -ENOSYS;
+}
+
+static inline int usb_reap_bulk_msg(struct usb_device *dev,
+				    unsigned long pipe)
+{
+	return -ENOSYS;
+}
+
+static inline int usb_alloc_streams(struct usb_device *dev,
+				    unsigned long *pipes, int num_pipes,
+				    unsigned int num_streams)
+{
+	return -ENOSYS;
+}
+#endif
+
 #if defined CONFIG_USB_EHCI_HCD || defined CONFIG_USB_MUSB_HOST \
 	|| CONFIG_IS_ENABLED(DM_USB)
 struct int_queue *create_int_queue(struct usb_device *dev, unsigned long pipe,
@@ -668,11 +698,14 @@ struct usb_dev_plat {
  *		so this will be false.
  * @companion:  True if this is a companion controller to another USB
  *		controller
+ * @scan_ret:	Result of starting the scan of the root hub, reported once
+ *		the ports of all controllers have been scanned
  */
 struct usb_bus_priv {
 	int next_addr;
 	bool desc_before_addr;
 	bool companion;
+	int scan_ret;
 };
 
 /**
@@ -723,6 +756,49 @@ struct dm_usb_ops {
 	 */
 	int (*bulk)(struct udevice *bus, struct usb_device *udev,
 		    unsigned long pipe, void *buffer, int length);
+	/**
+	 * queue_bulk() - Queue a bulk message without waiting for it
+	 *
+	 * Most parameters are as above. Several messages can be queued on a
+	 * pipe, and on several pipes at once. Each must be completed by
+	 * calling reap_bulk(), in the order in which they were queued on the
+	 * pipe. Other messages must not be sent to the device until then.
+	 * This method is optional.
+	 *
+	 * @stream_id: Stream to queue the message on, for a pipe set up by
+	 *	alloc_streams(); 0 otherwise
+	 * @return 0 if OK, -EBUSY if there is no room to queue the message,
+	 * other -ve on error
+	 */
+	int (*queue_bulk)(struct udevice *bus, struct usb_device *udev,
+			  unsigned long pipe, unsigned int stream_id,
+			  void *buffer, int length);
+	/**
+	 * reap_bulk() - Wait for the oldest bulk message queued on a pipe
+	 *
+	 * This sets udev->status and udev->act_len for that message, as
+	 * bulk() does.
+	 *
+	 * @return 0 if OK, -ve on error
+	 */
+	int (*reap_bulk)(struct udevice *bus, struct usb_device *udev,
+			 unsigned long pipe);
+	/**
+	 * alloc_streams() - Set up bulk endpoints to use streams
+	 *
+	 * This is needed by USB 3 devices which use streams, such as UAS
+	 * storage. Messages are then queued on a given stream with
+	 * queue_bulk(). This method is optional.
+	 *
+	 * @pipes: Bulk pipes of the endpoints to set up
+	 * @num_pipes: Number of entries in @pipes
+	 * @num_streams: Number of streams wanted, numbered from 1
+	 * @return number of streams set up, which may be fewer than asked
+	 * for, or -ve on error
+	 */
+	int (*alloc_streams)(struct udevice *bus, struct usb_device *udev,
+			     unsigned long *pipes, int num_pipes,
+			     unsigned int num_streams);
 	/**
 	 * interrupt() - Send an interrupt message
 	 *
@@ -853,6 +929,27 @@ bool usb_hub_is_root_hub(struct udevice *hub);
  */
 int usb_hub_scan(struct udevice *hub);
 
+/**
+ * usb_hub_scan_defer() - Defer scanning of hub ports
+ *
+ * Until usb_hub_scan_pending() is called, usb_hub_scan() powers up the
+ * ports of a hub and adds them to the scan list, but does not wait for
+ * devices to connect. This lets the power-good and connect timeouts of the
+ * root hubs of several controllers run at the same time.
+ */
+void usb_hub_scan_defer(void);
+
+/**
+ * usb_hub_scan_pending() - Scan all hub ports collected since deferring
+ *
+ * This scans the ports of all hubs set up since usb_hub_scan_defer(),
+ * together with those of any hubs found behind them, until each has a
+ * device enumerated or has timed out.
+ *
+ * Return: 0 if OK, -ve on error
+ */
+int usb_hub_scan_pending(void);
+
 /**
  * usb_scan_device() - Scan a device on a bus
  *
@@ -28,6 +28,8 @@
 #define XHCI_ALIGNMENT		64
 /* Generic timeout for XHCI events */
 #define XHCI_TIMEOUT		5000
+/* Time in ms after which a wait for an event lets the CPU rest */
+#define XHCI_IDLE_MS		1
 /* Max number of USB devices for any host controller - limit in section 6.1 */
 #define MAX_HC_SLOTS            256
 /* Section 5.3.3 - MaxPorts */
@@ -597,6 +599,25 @@ struct xhci_ep_ctx {
 	__le32	reserved[3];
 };
 
+/**
+ * struct xhci_stream_ctx - entry of a stream context array (section 6.2.4.1)
+ *
+ * @stream_ring:	64-bit stream ring address, cycle state and stream
+ *			context type
+ */
+struct xhci_stream_ctx {
+	__le64	stream_ring;
+	/* offset 0x8 - 0xf reserved for HC internal use */
+	__le32	reserved[2];
+};
+
+/* Stream Context Types (section 6.4.1) - bits 3:1 of stream ctx deq ptr */
+#define SCT_FOR_CTX(p)		(((p) & 0x7) << 1)
+/* Secondary stream array type, dequeue pointer is to a transfer ring */
+#define SCT_SEC_TR		0
+/* Primary stream array type, dequeue pointer is to a transfer ring */
+#define SCT_PRI_TR		1
+
 /* ep_info bitmasks */
 /*
  * Endpoint State - bits 0:2
@@ -1059,8 +1080,39 @@ struct xhci_scratchpad {
 #define XHCI_STOP_EP_CMD_TIMEOUT	5
 /* XXX: Make these module parameters */
 
+/* Most bulk TDs which can be queued on an endpoint at once */
+#define XHCI_MAX_TDS	8
+
+/*
+ * A bulk TD queued by xhci_bulk_queue() and not yet reaped. available_length
+ * is reduced by any short-packet events before the last TRB of the TD.
+ */
+struct xhci_td {
+	void *buffer;
+	u64 buf_64;
+	int length;
+	int available_length;
+	int num_trbs;
+	struct xhci_ring *ring;
+	dma_addr_t first_trb_addr;
+	dma_addr_t last_trb_addr;
+	bool done;
+	unsigned long status;
+	int act_len;
+};
+
 struct xhci_virt_ep {
 	struct xhci_ring		*ring;
+	/* TDs in flight, oldest first */
+	struct xhci_td			tds[XHCI_MAX_TDS];
+	unsigned int			td_head;
+	unsigned int			td_count;
+	unsigned int			trbs_queued;
+	/* Set up by xhci_alloc_streams(); stream 0 is reserved */
+	struct xhci_stream_ctx		*stream_ctx;
+	dma_addr_t			stream_ctx_dma;
+	struct xhci_ring		**stream_rings;
+	unsigned int			num_stream_ctxs;
 	unsigned int			ep_state;
 #define SET_DEQ_PENDING		(1 << 0)
 #define EP_HALTED		(1 << 1)	/* For stall handling */
@@ -1259,6 +1311,9 @@ void xhci_queue_command(struct xhci_ctrl *ctrl, dma_addr_t addr,
 			u32 slot_id, u32 ep_index, trb_type cmd);
 void xhci_acknowledge_event(struct xhci_ctrl *ctrl);
 union xhci_trb *xhci_wait_for_event(struct xhci_ctrl *ctrl, trb_type expected);
+int xhci_bulk_queue(struct usb_device *udev, unsigned long pipe,
+		    unsigned int stream_id, int length, void *buffer);
+int xhci_bulk_reap(struct usb_device *udev, unsigned long pipe);
 int xhci_bulk_tx(struct usb_device *udev, unsigned long pipe,
 		 int length, void *buffer);
 int xhci_ctrl_tx(struct usb_device *udev, unsigned long pipe,
@@ -1269,6 +1324,9 @@ void xhci_inval_cache(uintptr_t addr, u32 type_len);
 void xhci_cleanup(struct xhci_ctrl *ctrl);
 struct xhci_ring *xhci_ring_alloc(struct xhci_ctrl *ctrl, unsigned int num_segs,
 				  bool link_trbs);
+int xhci_alloc_stream_info(struct xhci_ctrl *ctrl, struct xhci_virt_ep *ep,
+			   unsigned int num_stream_ctxs);
+void xhci_free_stream_info(struct xhci_ctrl *ctrl, struct xhci_virt_ep *ep);
 int xhci_alloc_virt_device(struct xhci_ctrl *ctrl, unsigned int slot_id);
 int xhci_mem_init(struct xhci_ctrl *ctrl, struct xhci_hccr *hccr,
 		  struct xhci_hcor *hcor);
@@ -73,6 +73,21 @@ enum video_format {
 	VIDEO_X2R10G10B10,
 };
 
+/**
+ * struct video_bbox - Rectangle within the display
+ *
+ * @x0: Left edge, in pixels
+ * @y0: Top edge, in pixels
+ * @x1: Right edge, exclusive
+ * @y1: Bottom edge, exclusive
+ */
+struct video_bbox {
+	int x0;
+	int y0;
+	int x1;
+	int y1;
+};
+
 /**
  * struct video_priv - Device information used by the video uclass
  *
@@ -97,6 +112,8 @@ enum video_format {
  *		the LCD is updated
  * @fg_col_idx:	Foreground color code (bit 3 = bold, bit 0-2 = color)
  * @bg_col_idx:	Background color code (bit 3 = bold, bit 0-2 = color)
+ * @damage:	Area of the frame buffer changed since the last video_sync(),
+ *		empty if x1 <= x0 (only used with CONFIG_VIDEO_DAMAGE)
  */
 struct video_priv {
 	/* Things set up by the driver: */
@@ -121,6 +138,7 @@ struct video_priv {
 	bool flush_dcache;
 	u8 fg_col_idx;
 	u8 bg_col_idx;
+	struct video_bbox damage;
 };
 
 /**
@@ -341,13 +359,17 @@ void video_set_default_colors(struct udevice *dev, bool invert);
  */
 int video_default_font_height(struct udevice *dev);
 
-#ifdef CONFIG_VIDEO_COPY
+#if defined(CONFIG_VIDEO_COPY) || defined(CONFIG_VIDEO_DAMAGE)
 /**
- * vidconsole_sync_copy() - Sync back to the copy framebuffer
+ * video_sync_copy() - Sync back to the copy framebuffer
  *
  * This ensures that the copy framebuffer has the same data as the framebuffer
  * for a particular region. It should be called after the framebuffer is updated
  *
+ * With CONFIG_VIDEO_DAMAGE the region is also added to the damage, so that the
+ * next video_sync() flushes it. A region covering more than one line is
+ * treated as covering the full width of the display.
+ *
  * @from and @to can be in either order. The region between them is synced.
  *
  * @dev: Vidconsole device being updated
@@ -378,6 +400,28 @@ static inline int video_sync_copy_all(struct udevice *dev)
 
 #endif
 
+#ifdef CONFIG_VIDEO_DAMAGE
+/**
+ * video_damage() - Record an area of the display which has changed
+ *
+ * Only this area is flushed by the next video_sync(). Anything which writes to
+ * the frame buffer without calling video_sync_copy() must call this. The area
+ * is clipped to the display.
+ *
+ * @vid: Video device
+ * @x: Left edge of the area, in pixels
+ * @y: Top edge of the area, in pixels
+ * @width: Width of the area, in pixels
+ * @height: Height of the area, in pixels
+ */
+void video_damage(struct udevice *vid, int x, int y, int width, int height);
+#else
+static inline void video_damage(struct udevice *vid, int x, int y, int width,
+				int height)
+{
+}
+#endif
+
 /**
  * video_is_active() - Test if one video device it active
  *
@@ -103,6 +103,8 @@ struct vring {
  * @vring: actual memory layout for this queue
  * @vring_desc_shadow: guest-only copy of descriptors
  * @event: host publishes avail event idx
+ * @indirect_desc: tables of indirect descriptors, VIRTQUEUE_MAX_INDIRECT
+ *	for each ring entry, or NULL if indirect descriptors are not in use
  * @free_head: head of free buffer list
  * @num_added: number we've added since last sync
  * @last_used_idx: last used index we've seen
@@ -117,6 +119,7 @@ struct virtqueue {
 	struct vring vring;
 	struct vring_desc_shadow *vring_desc_shadow;
 	bool event;
+	struct vring_desc *indirect_desc;
 	unsigned int free_head;
 	unsigned int num_added;
 	u16 last_used_idx;
@@ -124,6 +127,9 @@ struct virtqueue {
 	u16 avail_idx_shadow;
 };
 
+/* Maximum number of buffers in a request which uses an indirect table */
+#define VIRTQUEUE_MAX_INDIRECT		8
+
 /*
  * Alignment requirements for vring elements.
  * When using pre-virtio 1.0 layout, these fall out naturally.
@@ -0,0 +1,50 @@
+/* SPDX-License-Identifier: GPL-2.0+ */
+/*
+ * Filesystem access to a directory shared by the host through virtio-fs
+ */
+
+#ifndef __VIRTIOFS_H
+#define __VIRTIOFS_H
+
+#include <linux/types.h>
+
+struct blk_desc;
+struct disk_partition;
+struct udevice;
+
+/* Partition name used for virtio-fs, which has no block device */
+#define VIRTIO_FS_PART_NAME	"virtio-fs"
+
+/**
+ * virtio_fs_select() - Select the virtio-fs device for filesystem access
+ *
+ * This sets up the device if needed and selects FS_TYPE_VIRTIO, so that the
+ * following fs_...() call uses it
+ *
+ * @dev: virtio-fs device (UCLASS_FS)
+ * Return: 0 if OK, -ve on error
+ */
+int virtio_fs_select(struct udevice *dev);
+
+/**
+ * virtio_fs_select_name() - Select a virtio-fs device by number or tag
+ *
+ * This is used for the 'virtiofs' interface, e.g. 'load virtiofs 0 ...' or
+ * 'load virtiofs myfs ...'. A partition number after a colon is ignored,
+ * since there is only one filesystem per device.
+ *
+ * @name: Sequence number or mount tag of the device, NULL or "" for the
+ *	first device
+ * Return: 0 if OK, -ENODEV if not found, other -ve on error
+ */
+int virtio_fs_select_name(const char *name);
+
+int virtio_fs_set_blk_dev(struct blk_desc *rbdd, struct disk_partition *info);
+int virtio_fs_ls(const char *dirname);
+int virtio_fs_exists(const char *filename);
+int virtio_fs_size(const char *filename, loff_t *size);
+int virtio_fs_read(const char *filename, void *buf, loff_t offset, loff_t len,
+		   loff_t *actread);
+void virtio_fs_close(void);
+
+#endif
@@ -6,6 +6,8 @@
 #ifndef _WDT_H_
 #define _WDT_H_
 
+#include <linux/types.h>
+
 struct udevice;
 
 /*
@@ -111,8 +113,46 @@ struct wdt_ops {
 	 * @return 0 if OK -ve on error. May not return.
 	 */
 	int (*expire_now)(struct udevice *dev, ulong flags);
+	/*
+	 * Driver flags (WDT_...)
+	 *
+	 * With CONFIG_WATCHDOG_TIMER_IRQ only drivers setting
+	 * WDT_RESET_IRQ_SAFE are reset from the timer interrupt, the others
+	 * are reset by a cyclic function
+	 */
+	ulong flags;
 };
 
+/* reset() only writes the device's own registers, so works in an interrupt */
+#define WDT_RESET_IRQ_SAFE	(1 << 0)
+
 int initr_watchdog(void);
 
+/*
+ * Reset all watchdogs serviced from the timer interrupt
+ *
+ * This is called by the architecture from the interrupt started by
+ * arch_wdt_irq_start(), with CONFIG_WATCHDOG_TIMER_IRQ
+ */
+void wdt_irq_service(void);
+
+/*
+ * Start calling wdt_irq_service() from a periodic interrupt
+ *
+ * This is implemented by the architecture. If the interrupt is already
+ * running, its rate is changed.
+ *
+ * @hz: Rate of the interrupt, in Hz
+ * @return: 0 if OK, -ve on error
+ */
+int arch_wdt_irq_start(uint hz);
+
+/*
+ * Stop calling wdt_irq_service()
+ *
+ * This must be done before starting an OS, which is then responsible for
+ * servicing any watchdog which is still running
+ */
+void arch_wdt_irq_stop(void);
+
 #endif  /* _WDT_H_ */
@@ -28,7 +28,10 @@ int acpi_write_ssdt(struct acpi_ctx *ctx, const struct acpi_writer *entry)
 
 	acpi_inc(ctx, sizeof(struct acpi_table_header));
 
-	ret = acpi_fill_ssdt(ctx);
+	if (IS_ENABLED(CONFIG_ACPI_SSDT_CACHE))
+		ret = acpi_fill_ssdt_cached(ctx);
+	else
+		ret = acpi_fill_ssdt(ctx);
 	if (ret) {
 		ctx->current = ssdt;
 		return log_msg_ret("fill", ret);
@@ -0,0 +1,101 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Arena allocator for short-lived, per-operation allocations
+ */
+
+#include <arena.h>
+#include <malloc.h>
+#include <linux/kernel.h>
+#include <linux/string.h>
+
+/**
+ * struct arena_block - block of memory within an arena
+ *
+ * @next: Next older block, or NULL if this is the first one
+ * @size: Size of @data in bytes
+ * @used: Number of bytes of @data handed out so far
+ * @data: Memory handed out by arena_alloc()
+ */
+struct arena_block {
+	struct arena_block *next;
+	size_t size;
+	size_t used;
+	char data[] __aligned(ARENA_ALIGN);
+};
+
+void arena_init(struct arena *arena, size_t block_size)
+{
+	arena->head = NULL;
+	arena->block_size = block_size;
+}
+
+void arena_uninit(struct arena *arena)
+{
+	struct arena_block *blk, *next;
+
+	for (blk = arena->head; blk; blk = next) {
+		next = blk->next;
+		free(blk);
+	}
+	arena->head = NULL;
+}
+
+struct arena_mark arena_begin(struct arena *arena)
+{
+	struct arena_mark mark;
+
+	mark.block = arena->head;
+	mark.used = arena->head ? arena->head->used : 0;
+
+	return mark;
+}
+
+void arena_release(struct arena *arena, struct arena_mark mark)
+{
+	struct arena_block *blk;
+
+	while ((blk = arena->head) && blk != mark.block && blk->next) {
+		arena->head = blk->next;
+		free(blk);
+	}
+
+	/* The only block left is the first one, or the one holding the mark */
+	if (blk)
+		blk->used = blk == mark.block ? mark.used : 0;
+}
+
+void *arena_alloc(struct arena *arena, size_t size)
+{
+	struct arena_block *blk = arena->head;
+	size_t block_size;
+	void *ptr;
+
+	size = ALIGN(size, ARENA_ALIGN);
+	if (!blk || blk->size - blk->used < size) {
+		block_size = arena->block_size ?: ARENA_DEFAULT_BLOCK;
+		block_size = max(block_size, size);
+		blk = malloc(sizeof(*blk) + block_size);
+		if (!blk)
+			return NULL;
+		blk->next = arena->head;
+		blk->size = block_size;
+		blk->used = 0;
+		arena->head = blk;
+	}
+	ptr = blk->data + blk->used;
+	blk->used += size;
+
+	return ptr;
+}
+
+char *arena_strdup(struct arena *arena, const char *str)
+{
+	size_t len = strlen(str) + 1;
+	char *copy;
+
+	copy = arena_alloc(arena, len);
+	if (copy)
+		memcpy(copy, str, len);
+
+	return copy;
+}
@@ -387,7 +387,7 @@ static void compute_syndromes(struct bch_control *bch, uint32_t *ecc,
 			      unsigned int *syn)
 {
 	int i, j, s;
-	unsigned int m;
+	unsigned int m, e, step;
 	uint32_t poly;
 	const int t = GF_T(bch);
 
@@ -399,14 +399,22 @@ static void compute_syndromes(struct bch_control *bch, uint32_t *ecc,
 		ecc[s/32] &= ~((1u << (32-m))-1);
 	memset(syn, 0, 2*t*sizeof(*syn));
 
-	/* compute v(a^j) for j=1 .. 2t-1 */
+	/*
+	 * compute v(a^j) for j=1 .. 2t-1; the exponents for a bit at position
+	 * i+s are (i+s), 3(i+s), 5(i+s)... so step through them by adding
+	 * 2(i+s) rather than multiplying and reducing each one
+	 */
 	do {
 		poly = *ecc++;
 		s -= 32;
 		while (poly) {
 			i = deg(poly);
-			for (j = 0; j < 2*t; j += 2)
-				syn[j] ^= a_pow(bch, (j+1)*(i+s));
+			e = modulo(bch, i+s);
+			step = mod_s(bch, 2*e);
+			for (j = 0; j < 2*t; j += 2) {
+				syn[j] ^= bch->a_pow_tab[e];
+				e = mod_s(bch, e+step);
+			}
 
 			poly ^= (1 << i);
 		}
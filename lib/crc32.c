@@ -184,8 +184,21 @@ uint32_t __efi_runtime crc32_no_comp(uint32_t crc, const Bytef *buf, uInt len)
 {
 #ifdef CONFIG_ARM64_CRC32
     crc = cpu_to_le32(crc);
-    while (len--)
+    /* Align it, then do eight bytes at a time */
+    for (; len && ((ulong)buf & 7); len--)
         crc = __builtin_aarch64_crc32b(crc, *buf++);
+    for (; len >= 8; len -= 8, buf += 8)
+        crc = __builtin_aarch64_crc32x(crc, le64_to_cpu(*(const u64 *)buf));
+    if (len & 4) {
+        crc = __builtin_aarch64_crc32w(crc, le32_to_cpu(*(const u32 *)buf));
+        buf += 4;
+    }
+    if (len & 2) {
+        crc = __builtin_aarch64_crc32h(crc, le16_to_cpu(*(const u16 *)buf));
+        buf += 2;
+    }
+    if (len & 1)
+        crc = __builtin_aarch64_crc32b(crc, *buf);
     return le32_to_cpu(crc);
 #else
     const uint32_t *tab = crc_table;
@@ -253,7 +266,7 @@ uint32_t crc32_wd(uint32_t crc, const unsigned char *buf, uInt len,
 			chunk = chunk_sz;
 		crc = crc32(crc, curr, chunk);
 		curr += chunk;
-		schedule();
+		schedule_hot();
 	}
 #else
 	crc = crc32(crc, buf, len);
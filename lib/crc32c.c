@@ -12,9 +12,32 @@
 
 #include <compiler.h>
 
+/* Bit-reflected Castagnoli polynomial, as used by the CRC32C instructions */
+#define CRC32C_POLY	0x82f63b78
+
+#ifdef CONFIG_ARM64_CRC32
+static uint32_t crc32c_arm64(uint32_t crc, const u8 *data, int length)
+{
+	for (; length && ((ulong)data & 7); length--)
+		crc = __builtin_aarch64_crc32cb(crc, *data++);
+	for (; length >= 8; length -= 8, data += 8)
+		crc = __builtin_aarch64_crc32cx(crc,
+				le64_to_cpu(*(const u64 *)data));
+	while (length--)
+		crc = __builtin_aarch64_crc32cb(crc, *data++);
+
+	return crc;
+}
+#endif
+
 uint32_t crc32c_cal(uint32_t crc, const char *data, int length,
 		    uint32_t *crc32c_table)
 {
+#ifdef CONFIG_ARM64_CRC32
+	/* The table entry for 0x80 is the polynomial it was made from */
+	if (crc32c_table[0x80] == CRC32C_POLY)
+		return crc32c_arm64(crc, (const u8 *)data, length);
+#endif
 	while (length--)
 		crc = crc32c_table[(u8)(crc ^ *data++)] ^ (crc >> 8);
 
@@ -6,6 +6,7 @@
  */
 
 #include <bootm.h>
+#include <cpu.h>
 #include <div64.h>
 #include <dm/device.h>
 #include <dm/root.h>
@@ -2234,6 +2235,7 @@ static efi_status_t EFIAPI efi_exit_boot_services(efi_handle_t image_handle,
 		bootm_disable_interrupts();
 		if (IS_ENABLED(CONFIG_USB_DEVICE))
 			udc_disconnect();
+		cpu_boot_restore();
 		board_quiesce_devices();
 		dm_remove_devices_flags(DM_REMOVE_ACTIVE_ALL);
 	}
@@ -18,19 +18,30 @@
 #include <log.h>
 #include <part.h>
 #include <malloc.h>
+#include <asm/cache.h>
+#include <linux/sizes.h>
 
 struct efi_system_partition efi_system_partition = {
 	.uclass_id = UCLASS_INVALID,
 };
 
 const efi_guid_t efi_block_io_guid = EFI_BLOCK_IO_PROTOCOL_GUID;
+const efi_guid_t efi_block_io2_guid = EFI_BLOCK_IO2_PROTOCOL_GUID;
 const efi_guid_t efi_system_partition_guid = PARTITION_SYSTEM_GUID;
 
+/*
+ * Transfer size reported to EFI applications as the optimal granularity.
+ * Block drivers are much more efficient with large transfers, so this
+ * encourages loaders to read a kernel in a few large pieces.
+ */
+#define EFI_DISK_OPTIMAL_TRANSFER	SZ_1M
+
 /**
  * struct efi_disk_obj - EFI disk object
  *
  * @header:	EFI object header
  * @ops:	EFI disk I/O protocol interface
+ * @ops2:	EFI disk I/O 2 protocol interface
  * @media:	block I/O media information
  * @dp:		device path to the block device
  * @volume:	simple file system protocol of the partition
@@ -38,6 +49,7 @@ const efi_guid_t efi_system_partition_guid = PARTITION_SYSTEM_GUID;
 struct efi_disk_obj {
 	struct efi_object header;
 	struct efi_block_io ops;
+	struct efi_block_io2 ops2;
 	struct efi_block_io_media media;
 	struct efi_device_path *dp;
 	struct efi_simple_file_system_protocol *volume;
@@ -147,6 +159,38 @@ static efi_status_t efi_disk_rw_blocks(struct efi_block_io *this,
 	return EFI_SUCCESS;
 }
 
+/**
+ * efi_disk_check() - check the parameters of a read or write request
+ *
+ * @this:		pointer to the BLOCK_IO_PROTOCOL
+ * @media_id:		id of the medium to be accessed
+ * @lba:		starting logical block
+ * @buffer_size:	size of the buffer
+ * @buffer:		pointer to the buffer
+ * Return:		status code
+ */
+static efi_status_t efi_disk_check(struct efi_block_io *this, u32 media_id,
+				   u64 lba, efi_uintn_t buffer_size,
+				   void *buffer)
+{
+	if (!this)
+		return EFI_INVALID_PARAMETER;
+	/* TODO: check for media changes */
+	if (media_id != this->media->media_id)
+		return EFI_MEDIA_CHANGED;
+	if (!this->media->media_present)
+		return EFI_NO_MEDIA;
+	/* media->io_align is a power of 2 or 0 */
+	if (this->media->io_align &&
+	    (uintptr_t)buffer & (this->media->io_align - 1))
+		return EFI_INVALID_PARAMETER;
+	if (lba * this->media->block_size + buffer_size >
+	    (this->media->last_block + 1) * this->media->block_size)
+		return EFI_INVALID_PARAMETER;
+
+	return EFI_SUCCESS;
+}
+
 /**
  * efi_disk_read_blocks() - reads blocks from device
  *
@@ -169,20 +213,9 @@ static efi_status_t EFIAPI efi_disk_read_blocks(struct efi_block_io *this,
 	void *real_buffer = buffer;
 	efi_status_t r;
 
-	if (!this)
-		return EFI_INVALID_PARAMETER;
-	/* TODO: check for media changes */
-	if (media_id != this->media->media_id)
-		return EFI_MEDIA_CHANGED;
-	if (!this->media->media_present)
-		return EFI_NO_MEDIA;
-	/* media->io_align is a power of 2 or 0 */
-	if (this->media->io_align &&
-	    (uintptr_t)buffer & (this->media->io_align - 1))
-		return EFI_INVALID_PARAMETER;
-	if (lba * this->media->block_size + buffer_size >
-	    (this->media->last_block + 1) * this->media->block_size)
-		return EFI_INVALID_PARAMETER;
+	r = efi_disk_check(this, media_id, lba, buffer_size, buffer);
+	if (r != EFI_SUCCESS)
+		return r;
 
 #ifdef CONFIG_EFI_LOADER_BOUNCE_BUFFER
 	if (buffer_size > EFI_LOADER_BOUNCE_BUFFER_SIZE) {
@@ -239,18 +272,9 @@ static efi_status_t EFIAPI efi_disk_write_blocks(struct efi_block_io *this,
 		return EFI_INVALID_PARAMETER;
 	if (this->media->read_only)
 		return EFI_WRITE_PROTECTED;
-	/* TODO: check for media changes */
-	if (media_id != this->media->media_id)
-		return EFI_MEDIA_CHANGED;
-	if (!this->media->media_present)
-		return EFI_NO_MEDIA;
-	/* media->io_align is a power of 2 or 0 */
-	if (this->media->io_align &&
-	    (uintptr_t)buffer & (this->media->io_align - 1))
-		return EFI_INVALID_PARAMETER;
-	if (lba * this->media->block_size + buffer_size >
-	    (this->media->last_block + 1) * this->media->block_size)
-		return EFI_INVALID_PARAMETER;
+	r = efi_disk_check(this, media_id, lba, buffer_size, buffer);
+	if (r != EFI_SUCCESS)
+		return r;
 
 #ifdef CONFIG_EFI_LOADER_BOUNCE_BUFFER
 	if (buffer_size > EFI_LOADER_BOUNCE_BUFFER_SIZE) {
@@ -301,12 +325,362 @@ static efi_status_t EFIAPI efi_disk_flush_blocks(struct efi_block_io *this)
 }
 
 static const struct efi_block_io block_io_disk_template = {
+	.revision = EFI_BLOCK_IO_PROTOCOL_REVISION3,
 	.reset = &efi_disk_reset,
 	.read_blocks = &efi_disk_read_blocks,
 	.write_blocks = &efi_disk_write_blocks,
 	.flush_blocks = &efi_disk_flush_blocks,
 };
 
+#if IS_ENABLED(CONFIG_EFI_BLOCK_IO2)
+/**
+ * struct efi_disk_req - a read started by ReadBlocksEx()
+ *
+ * @req:	block-layer request
+ * @link:	node in efi_disk_reqs
+ * @diskobj:	disk being read
+ * @dev:	block device the request was submitted to
+ * @token:	token to update and signal when the read completes
+ */
+struct efi_disk_req {
+	struct blk_req req;
+	struct list_head link;
+	struct efi_disk_obj *diskobj;
+	struct udevice *dev;
+	struct efi_block_io2_token *token;
+};
+
+/* Reads started by ReadBlocksEx() which have not yet been reported */
+static LIST_HEAD(efi_disk_reqs);
+
+/* Timer event used to check for completed reads */
+static struct efi_event *efi_disk_poll_event;
+
+/**
+ * efi_disk_req_finish() - report a completed read to the application
+ *
+ * @r:		request, which is freed
+ * @signal:	true to signal the token's event
+ */
+static void efi_disk_req_finish(struct efi_disk_req *r, bool signal)
+{
+	struct efi_block_io2_token *token = r->token;
+
+	token->transaction_status = r->req.result == r->req.blkcnt ?
+		EFI_SUCCESS : EFI_DEVICE_ERROR;
+	list_del(&r->link);
+	free(r);
+	if (signal)
+		efi_signal_event(token->event);
+}
+
+/**
+ * efi_disk_finish_all() - wait for outstanding reads and report them
+ *
+ * The events are not signalled, since the application is no longer able to
+ * handle them.
+ *
+ * @diskobj:	disk whose reads should be finished, or NULL for all disks
+ */
+static void efi_disk_finish_all(struct efi_disk_obj *diskobj)
+{
+	struct efi_disk_req *r, *next;
+
+	list_for_each_entry_safe(r, next, &efi_disk_reqs, link) {
+		if (diskobj && r->diskobj != diskobj)
+			continue;
+		blk_wait(r->dev, &r->req);
+		efi_disk_req_finish(r, false);
+	}
+}
+
+/**
+ * efi_disk_poll_notify() - check for completed reads
+ *
+ * This is the notification function of the timer event which runs while
+ * there are reads in flight.
+ *
+ * @event:	timer event
+ * @context:	not used
+ */
+static void EFIAPI efi_disk_poll_notify(struct efi_event *event, void *context)
+{
+	struct efi_disk_req *r, *next;
+
+	EFI_ENTRY("%p, %p", event, context);
+
+	list_for_each_entry_safe(r, next, &efi_disk_reqs, link) {
+		if (!r->req.done)
+			blk_poll(r->dev);
+		if (r->req.done)
+			efi_disk_req_finish(r, true);
+	}
+	if (list_empty(&efi_disk_reqs))
+		efi_set_timer(efi_disk_poll_event, EFI_TIMER_STOP, 0);
+
+	EFI_EXIT(EFI_SUCCESS);
+}
+
+/**
+ * efi_disk_exit_boot_services() - finish reads before the OS takes over
+ *
+ * The device must not write to memory once the OS is running.
+ *
+ * @event:	exit boot services event
+ * @context:	not used
+ */
+static void EFIAPI efi_disk_exit_boot_services(struct efi_event *event,
+					       void *context)
+{
+	EFI_ENTRY("%p, %p", event, context);
+
+	efi_disk_finish_all(NULL);
+
+	EFI_EXIT(EFI_SUCCESS);
+}
+
+/**
+ * efi_disk_start_poll() - make sure reads in flight are checked regularly
+ *
+ * Return:	status code
+ */
+static efi_status_t efi_disk_start_poll(void)
+{
+	struct efi_event *ebs_event;
+	efi_status_t ret;
+
+	if (!efi_disk_poll_event) {
+		ret = efi_create_event(EVT_TIMER | EVT_NOTIFY_SIGNAL,
+				       TPL_CALLBACK, efi_disk_poll_notify, NULL,
+				       NULL, &efi_disk_poll_event);
+		if (ret != EFI_SUCCESS)
+			return ret;
+		ret = efi_create_event(EVT_SIGNAL_EXIT_BOOT_SERVICES,
+				       TPL_CALLBACK,
+				       efi_disk_exit_boot_services, NULL,
+				       NULL, &ebs_event);
+		if (ret != EFI_SUCCESS)
+			return ret;
+	}
+
+	/* Check on every timer tick, i.e. whenever the application waits */
+	return efi_set_timer(efi_disk_poll_event, EFI_TIMER_PERIODIC, 0);
+}
+
+/**
+ * efi_disk_reset_ex() - reset block device
+ *
+ * This function implements the Reset service of the EFI_BLOCK_IO2_PROTOCOL.
+ *
+ * See the Unified Extensible Firmware Interface (UEFI) specification for
+ * details.
+ *
+ * @this:			pointer to the BLOCK_IO2_PROTOCOL
+ * @extended_verification:	extended verification
+ * Return:			status code
+ */
+static efi_status_t EFIAPI efi_disk_reset_ex(struct efi_block_io2 *this,
+					     bool extended_verification)
+{
+	EFI_ENTRY("%p, %x", this, extended_verification);
+	return EFI_EXIT(EFI_SUCCESS);
+}
+
+/**
+ * efi_disk_complete() - report a request which completed synchronously
+ *
+ * @token:	token passed by the application, or NULL
+ * @ret:	status of the request
+ * Return:	status to return to the application
+ */
+static efi_status_t efi_disk_complete(struct efi_block_io2_token *token,
+				      efi_status_t ret)
+{
+	if (ret == EFI_SUCCESS && token && token->event) {
+		token->transaction_status = ret;
+		efi_signal_event(token->event);
+	}
+
+	return ret;
+}
+
+/**
+ * efi_disk_read_blocks_ex() - reads blocks from device
+ *
+ * This function implements the ReadBlocksEx service of the
+ * EFI_BLOCK_IO2_PROTOCOL.
+ *
+ * If the application provides an event, the read is submitted to the block
+ * device and this returns straight away. The event is signalled once the
+ * read completes, which is checked each time the EFI timer is processed.
+ *
+ * See the Unified Extensible Firmware Interface (UEFI) specification for
+ * details.
+ *
+ * @this:			pointer to the BLOCK_IO2_PROTOCOL
+ * @media_id:			id of the medium to be read from
+ * @lba:			starting logical block for reading
+ * @token:			token for non-blocking reads, or NULL
+ * @buffer_size:		size of the read buffer
+ * @buffer:			pointer to the destination buffer
+ * Return:			status code
+ */
+static efi_status_t EFIAPI
+efi_disk_read_blocks_ex(struct efi_block_io2 *this, u32 media_id, u64 lba,
+			struct efi_block_io2_token *token,
+			efi_uintn_t buffer_size, void *buffer)
+{
+	struct efi_disk_obj *diskobj;
+	struct efi_disk_req *r;
+	struct udevice *dev;
+	efi_status_t ret;
+	int err;
+
+	EFI_ENTRY("%p, %x, %llx, %p, %zx, %p", this, media_id, lba, token,
+		  buffer_size, buffer);
+
+	if (!this) {
+		ret = EFI_INVALID_PARAMETER;
+		goto out;
+	}
+	diskobj = container_of(this, struct efi_disk_obj, ops2);
+
+	/* Blocking reads, and reads through the bounce buffer */
+	if (!token || !token->event ||
+	    IS_ENABLED(CONFIG_EFI_LOADER_BOUNCE_BUFFER)) {
+		ret = EFI_CALL(efi_disk_read_blocks(&diskobj->ops, media_id,
+						    lba, buffer_size, buffer));
+		ret = efi_disk_complete(token, ret);
+		goto out;
+	}
+
+	ret = efi_disk_check(&diskobj->ops, media_id, lba, buffer_size,
+			     buffer);
+	if (ret != EFI_SUCCESS)
+		goto out;
+	if (buffer_size & (this->media->block_size - 1)) {
+		ret = EFI_BAD_BUFFER_SIZE;
+		goto out;
+	}
+	if (!buffer_size) {
+		ret = efi_disk_complete(token, EFI_SUCCESS);
+		goto out;
+	}
+
+	r = calloc(1, sizeof(*r));
+	if (!r) {
+		ret = EFI_OUT_OF_RESOURCES;
+		goto out;
+	}
+	dev = diskobj->header.dev;
+	r->req.start = lba;
+	if (CONFIG_IS_ENABLED(PARTITIONS) &&
+	    device_get_uclass_id(dev) == UCLASS_PARTITION) {
+		struct disk_part *part = dev_get_uclass_plat(dev);
+
+		r->req.start += part->gpt_part_info.start;
+		dev = dev_get_parent(dev);
+	}
+	r->req.blkcnt = buffer_size / this->media->block_size;
+	r->req.buffer = buffer;
+	r->diskobj = diskobj;
+	r->dev = dev;
+	r->token = token;
+
+	/* Wait for a free slot if the device queue is full */
+	while ((err = blk_submit_read(dev, &r->req)) == -EBUSY)
+		blk_poll(dev);
+	if (err) {
+		free(r);
+		ret = EFI_DEVICE_ERROR;
+		goto out;
+	}
+
+	token->transaction_status = EFI_NOT_READY;
+	list_add_tail(&r->link, &efi_disk_reqs);
+	if (r->req.done)
+		efi_disk_req_finish(r, true);
+	else
+		ret = efi_disk_start_poll();
+
+out:
+	return EFI_EXIT(ret);
+}
+
+/**
+ * efi_disk_write_blocks_ex() - writes blocks to device
+ *
+ * This function implements the WriteBlocksEx service of the
+ * EFI_BLOCK_IO2_PROTOCOL.
+ *
+ * Writes are always carried out synchronously. If the application provides
+ * an event, it is signalled before this returns.
+ *
+ * See the Unified Extensible Firmware Interface (UEFI) specification for
+ * details.
+ *
+ * @this:			pointer to the BLOCK_IO2_PROTOCOL
+ * @media_id:			id of the medium to be written to
+ * @lba:			starting logical block for writing
+ * @token:			token for non-blocking writes, or NULL
+ * @buffer_size:		size of the write buffer
+ * @buffer:			pointer to the source buffer
+ * Return:			status code
+ */
+static efi_status_t EFIAPI
+efi_disk_write_blocks_ex(struct efi_block_io2 *this, u32 media_id, u64 lba,
+			 struct efi_block_io2_token *token,
+			 efi_uintn_t buffer_size, void *buffer)
+{
+	struct efi_disk_obj *diskobj;
+	efi_status_t ret;
+
+	EFI_ENTRY("%p, %x, %llx, %p, %zx, %p", this, media_id, lba, token,
+		  buffer_size, buffer);
+
+	if (!this) {
+		ret = EFI_INVALID_PARAMETER;
+		goto out;
+	}
+	diskobj = container_of(this, struct efi_disk_obj, ops2);
+	ret = EFI_CALL(efi_disk_write_blocks(&diskobj->ops, media_id, lba,
+					     buffer_size, buffer));
+	ret = efi_disk_complete(token, ret);
+out:
+	return EFI_EXIT(ret);
+}
+
+/**
+ * efi_disk_flush_blocks_ex() - flushes modified data to the device
+ *
+ * This function implements the FlushBlocksEx service of the
+ * EFI_BLOCK_IO2_PROTOCOL.
+ *
+ * As we always write synchronously nothing is done here.
+ *
+ * See the Unified Extensible Firmware Interface (UEFI) specification for
+ * details.
+ *
+ * @this:			pointer to the BLOCK_IO2_PROTOCOL
+ * @token:			token for non-blocking flushes, or NULL
+ * Return:			status code
+ */
+static efi_status_t EFIAPI
+efi_disk_flush_blocks_ex(struct efi_block_io2 *this,
+			 struct efi_block_io2_token *token)
+{
+	EFI_ENTRY("%p, %p", this, token);
+	return EFI_EXIT(efi_disk_complete(token, EFI_SUCCESS));
+}
+
+static const struct efi_block_io2 block_io2_disk_template = {
+	.reset = &efi_disk_reset_ex,
+	.read_blocks_ex = &efi_disk_read_blocks_ex,
+	.write_blocks_ex = &efi_disk_write_blocks_ex,
+	.flush_blocks_ex = &efi_disk_flush_blocks_ex,
+};
+#endif
+
 /**
  * efi_fs_from_path() - retrieve simple file system protocol
  *
@@ -485,6 +859,12 @@ static efi_status_t efi_disk_add_dev(
 		log_debug("install failed %lx\n", ret);
 		goto error;
 	}
+#if IS_ENABLED(CONFIG_EFI_BLOCK_IO2)
+	ret = efi_add_protocol(&diskobj->header, &efi_block_io2_guid,
+			       &diskobj->ops2);
+	if (ret != EFI_SUCCESS)
+		goto error;
+#endif
 
 	/*
 	 * On partitions or whole disks without partitions install the
@@ -514,10 +894,21 @@ static efi_status_t efi_disk_add_dev(
 	 */
 	diskobj->media.media_id = 1;
 	diskobj->media.block_size = desc->blksz;
-	diskobj->media.io_align = desc->blksz;
+	/*
+	 * Drivers only need buffers to be aligned for DMA; the block layer
+	 * bounces anything else for devices which need it
+	 */
+	diskobj->media.io_align = ARCH_DMA_MINALIGN;
+	diskobj->media.logical_blocks_per_physical_block = 1;
+	diskobj->media.optimal_transfer_length_granualarity =
+		max(EFI_DISK_OPTIMAL_TRANSFER / desc->blksz, 1UL);
 	if (part)
 		diskobj->media.logical_partition = 1;
 	diskobj->ops.media = &diskobj->media;
+#if IS_ENABLED(CONFIG_EFI_BLOCK_IO2)
+	diskobj->ops2 = block_io2_disk_template;
+	diskobj->ops2.media = &diskobj->media;
+#endif
 	if (disk)
 		*disk = diskobj;
 
@@ -754,6 +1145,9 @@ int efi_disk_remove(void *ctx, struct event *event)
 	dp = diskobj->dp;
 	volume = diskobj->volume;
 
+#if IS_ENABLED(CONFIG_EFI_BLOCK_IO2)
+	efi_disk_finish_all(diskobj);
+#endif
 	ret = efi_delete_handle(handle);
 	/* Do not delete DM device if there are still EFI drivers attached. */
 	if (ret != EFI_SUCCESS)
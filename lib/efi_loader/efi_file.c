@@ -38,6 +38,12 @@ struct file_handle {
 	struct fs_dir_stream *dirs;
 	struct fs_dirent *dent;
 
+	/* for reading a file opened read-only: */
+	loff_t size;		/* file size, or -1 if not yet known */
+	void *ra_buf;		/* read-ahead buffer */
+	loff_t ra_start;	/* file offset of the data in ra_buf */
+	loff_t ra_len;		/* number of bytes of data in ra_buf */
+
 	char path[0];
 };
 #define to_fh(x) container_of(x, struct file_handle, base)
@@ -200,6 +206,7 @@ static struct efi_file_handle *file_open(struct file_system *fs,
 	fh->open_mode = open_mode;
 	fh->base = efi_file_handle_protocol;
 	fh->fs = fs;
+	fh->size = -1;
 
 	if (parent) {
 		char *p = fh->path;
@@ -366,6 +373,7 @@ out:
 static efi_status_t file_close(struct file_handle *fh)
 {
 	fs_closedir(fh->dirs);
+	free(fh->ra_buf);
 	free(fh);
 	return EFI_SUCCESS;
 }
@@ -397,6 +405,21 @@ static efi_status_t EFIAPI efi_file_delete(struct efi_file_handle *file)
 	return EFI_EXIT(ret);
 }
 
+/**
+ * file_cacheable() - check whether file data can be cached in the handle
+ *
+ * Only files opened read-only are cached, since this handle cannot change
+ * them. Another handle writing to the same file while it is open is not
+ * noticed.
+ *
+ * @fh:		file handle
+ * Return:	true if the size and data of the file may be cached
+ */
+static bool file_cacheable(struct file_handle *fh)
+{
+	return !(fh->open_mode & EFI_FILE_MODE_WRITE);
+}
+
 /**
  * efi_get_file_size() - determine the size of a file
  *
@@ -407,11 +430,18 @@ static efi_status_t EFIAPI efi_file_delete(struct efi_file_handle *file)
 static efi_status_t efi_get_file_size(struct file_handle *fh,
 				      loff_t *file_size)
 {
+	if (fh->size >= 0) {
+		*file_size = fh->size;
+		return EFI_SUCCESS;
+	}
+
 	if (set_blk_dev(fh))
 		return EFI_DEVICE_ERROR;
 
 	if (fs_size(fh->path, file_size))
 		return EFI_DEVICE_ERROR;
+	if (file_cacheable(fh))
+		fh->size = *file_size;
 
 	return EFI_SUCCESS;
 }
@@ -455,6 +485,65 @@ out:
 	return ret;
 }
 
+/**
+ * file_read_ahead() - read part of a file through the read-ahead buffer
+ *
+ * Each fs_read() call probes the file system and looks up the file again,
+ * so loaders reading a file in small pieces are very slow. Small reads are
+ * therefore served from a buffer, which is filled with
+ * CONFIG_EFI_FILE_READ_AHEAD bytes at a time.
+ *
+ * @fh:		file handle
+ * @offset:	file offset to read from
+ * @len:	number of bytes to read, which must not go past the end of
+ *		the file
+ * @buffer:	buffer to read into
+ * Return:	number of bytes read, or -ve on error
+ */
+static loff_t file_read_ahead(struct file_handle *fh, loff_t offset,
+			      loff_t len, void *buffer)
+{
+	loff_t done = 0, actread, count;
+
+	/* Use what is already in the buffer */
+	if (offset >= fh->ra_start && offset < fh->ra_start + fh->ra_len) {
+		done = min(len, fh->ra_start + fh->ra_len - offset);
+		memcpy(buffer, fh->ra_buf + offset - fh->ra_start, done);
+		if (done == len)
+			return done;
+	}
+
+	/* Read large requests straight into the caller's buffer */
+	if (len - done >= CONFIG_EFI_FILE_READ_AHEAD ||
+	    !file_cacheable(fh)) {
+		if (set_blk_dev(fh) ||
+		    fs_read(fh->path, map_to_sysmem(buffer + done),
+			    offset + done, len - done, &actread))
+			return -EIO;
+
+		return done + actread;
+	}
+
+	if (!fh->ra_buf) {
+		fh->ra_buf = malloc(CONFIG_EFI_FILE_READ_AHEAD);
+		if (!fh->ra_buf)
+			return -ENOMEM;
+	}
+	fh->ra_len = 0;
+	count = min((loff_t)CONFIG_EFI_FILE_READ_AHEAD,
+		    fh->size - offset - done);
+	if (set_blk_dev(fh) ||
+	    fs_read(fh->path, map_to_sysmem(fh->ra_buf), offset + done, count,
+		    &actread))
+		return -EIO;
+	fh->ra_start = offset + done;
+	fh->ra_len = actread;
+	count = min(len - done, actread);
+	memcpy(buffer + done, fh->ra_buf, count);
+
+	return done + count;
+}
+
 static efi_status_t file_read(struct file_handle *fh, u64 *buffer_size,
 		void *buffer)
 {
@@ -475,11 +564,26 @@ static efi_status_t file_read(struct file_handle *fh, u64 *buffer_size,
 		return ret;
 	}
 
-	if (set_blk_dev(fh))
-		return EFI_DEVICE_ERROR;
-	if (fs_read(fh->path, map_to_sysmem(buffer), fh->offset,
-		    *buffer_size, &actread))
-		return EFI_DEVICE_ERROR;
+	/* fs_read() treats a length of 0 as meaning the whole file */
+	if (!*buffer_size || file_size == fh->offset) {
+		*buffer_size = 0;
+		return EFI_SUCCESS;
+	}
+
+	if (CONFIG_EFI_FILE_READ_AHEAD) {
+		actread = file_read_ahead(fh, fh->offset,
+					  min_t(u64, *buffer_size,
+						file_size - fh->offset),
+					  buffer);
+		if (actread < 0)
+			return EFI_DEVICE_ERROR;
+	} else {
+		if (set_blk_dev(fh))
+			return EFI_DEVICE_ERROR;
+		if (fs_read(fh->path, map_to_sysmem(buffer), fh->offset,
+			    *buffer_size, &actread))
+			return EFI_DEVICE_ERROR;
+	}
 
 	*buffer_size = actread;
 	fh->offset += actread;
@@ -271,6 +271,7 @@ efi_status_t efi_image_region_add(struct efi_image_regions *regs,
 	reg->data = start;
 	reg->size = end - start;
 	regs->num++;
+	regs->hash_algo = NULL;
 
 	return EFI_SUCCESS;
 }
@@ -531,7 +532,7 @@ static bool efi_image_verify_digest(struct efi_image_regions *regs,
 				    struct pkcs7_message *msg)
 {
 	struct pefile_context ctx;
-	void *hash;
+	const void *hash;
 	int hash_len, ret;
 
 	const void *data;
@@ -549,9 +550,8 @@ static bool efi_image_verify_digest(struct efi_image_regions *regs,
 		return false;
 
 	/* calculate a hash value of PE image */
-	hash = NULL;
-	if (!efi_hash_regions(regs->reg, regs->num, &hash, ctx.digest_algo,
-			      &hash_len))
+	hash = efi_image_regions_hash(regs, ctx.digest_algo, &hash_len);
+	if (!hash)
 		return false;
 
 	/* match the digest */
@@ -16,7 +16,6 @@
 #include <asm/cache.h>
 #include <asm/global_data.h>
 #include <asm/sections.h>
-#include <linux/list_sort.h>
 #include <linux/sizes.h>
 
 DECLARE_GLOBAL_DATA_PTR;
@@ -26,18 +25,18 @@ DECLARE_GLOBAL_DATA_PTR;
 
 efi_uintn_t efi_memory_map_key;
 
-struct efi_mem_list {
-	struct list_head link;
-	struct efi_mem_desc desc;
-};
-
-#define EFI_CARVE_NO_OVERLAP		-1
-#define EFI_CARVE_LOOP_AGAIN		-2
-#define EFI_CARVE_OVERLAPS_NONRAM	-3
-#define EFI_CARVE_OUT_OF_RESOURCES	-4
+/*
+ * The memory map, sorted from the highest address to the lowest. Entries never
+ * overlap and adjacent entries with the same type and attributes are always
+ * merged, so an entry can be found with a binary search and adding a region
+ * only touches the entries which it overlaps.
+ */
+static struct efi_mem_desc *efi_mem;
+static int efi_mem_count;
+static int efi_mem_max;
 
-/* This list contains all memory map items */
-static LIST_HEAD(efi_mem);
+/* Number of spare entries to allocate when the memory map fills up */
+#define EFI_MEM_GROW	32
 
 #ifdef CONFIG_EFI_LOADER_BOUNCE_BUFFER
 void *efi_bounce_buffer;
@@ -66,6 +65,46 @@ struct efi_pool_allocation {
 	char data[] __aligned(ARCH_DMA_MINALIGN);
 };
 
+/* Magic number identifying a page divided into small pool allocations */
+#define EFI_POOL_PAGE_MAGIC 0x4c4f4f50454c4946ULL
+
+/* Number of block sizes for small pool allocations, doubling from 64 bytes */
+#define EFI_POOL_BUCKETS	5
+#define EFI_POOL_MIN_BLOCK	64
+
+/**
+ * struct efi_pool_page - header of a page holding small pool allocations
+ *
+ * @magic:	EFI_POOL_PAGE_MAGIC
+ * @link:	node in the list of pages with free blocks of this type and size
+ * @free:	first free block, the first word of which points to the next
+ * @type:	memory type of the page
+ * @size:	size of each block in bytes
+ * @used:	number of blocks which are allocated
+ *
+ * Pool allocations which fit in a block of up to 1KiB are taken from pages
+ * divided into blocks of one size, rather than from whole pages. This avoids
+ * adding an entry to the memory map for each allocation and wasting most of
+ * a page on each. The blocks follow this header and are aligned to
+ * ARCH_DMA_MINALIGN, like other pool allocations. A page is freed when none
+ * of its blocks are in use.
+ */
+struct efi_pool_page {
+	u64 magic;
+	struct list_head link;
+	void *free;
+	u32 type;
+	u16 size;
+	u16 used;
+};
+
+/* Offset of the first block in a page of small pool allocations */
+#define EFI_POOL_FIRST_BLOCK	ALIGN(sizeof(struct efi_pool_page), \
+				      ARCH_DMA_MINALIGN)
+
+/* Pages with free blocks, for each memory type and block size */
+static struct list_head efi_pool[EFI_MAX_MEMORY_TYPE][EFI_POOL_BUCKETS];
+
 /**
  * checksum() - calculate checksum for memory allocated from pool
  *
@@ -82,33 +121,6 @@ static u64 checksum(struct efi_pool_allocation *alloc)
 	return ret;
 }
 
-/**
- * efi_mem_cmp() - comparator function for sorting memory map
- *
- * Sorts the memory list from highest address to lowest address
- *
- * When allocating memory we should always start from the highest
- * address chunk, so sort the memory list such that the first list
- * iterator gets the highest address and goes lower from there.
- *
- * @priv:	unused
- * @a:		first memory area
- * @b:		second memory area
- * Return:	1 if @a is before @b, -1 if @b is before @a, 0 if equal
- */
-static int efi_mem_cmp(void *priv, struct list_head *a, struct list_head *b)
-{
-	struct efi_mem_list *mema = list_entry(a, struct efi_mem_list, link);
-	struct efi_mem_list *memb = list_entry(b, struct efi_mem_list, link);
-
-	if (mema->desc.physical_start == memb->desc.physical_start)
-		return 0;
-	else if (mema->desc.physical_start < memb->desc.physical_start)
-		return 1;
-	else
-		return -1;
-}
-
 /**
  * desc_get_end() - get end address of memory area
  *
@@ -121,143 +133,95 @@ static uint64_t desc_get_end(struct efi_mem_desc *desc)
 }
 
 /**
- * efi_mem_sort() - sort memory map
+ * efi_mem_find() - find the first memory map entry starting below an address
  *
- * Sort the memory map and then try to merge adjacent memory areas.
+ * @addr:	address
+ * Return:	index of the first entry which starts below @addr, or
+ *		efi_mem_count if there is none
  */
-static void efi_mem_sort(void)
+static int efi_mem_find(uint64_t addr)
 {
-	struct list_head *lhandle;
-	struct efi_mem_list *prevmem = NULL;
-	bool merge_again = true;
-
-	list_sort(NULL, &efi_mem, efi_mem_cmp);
-
-	/* Now merge entries that can be merged */
-	while (merge_again) {
-		merge_again = false;
-		list_for_each(lhandle, &efi_mem) {
-			struct efi_mem_list *lmem;
-			struct efi_mem_desc *prev = &prevmem->desc;
-			struct efi_mem_desc *cur;
-			uint64_t pages;
-
-			lmem = list_entry(lhandle, struct efi_mem_list, link);
-			if (!prevmem) {
-				prevmem = lmem;
-				continue;
-			}
-
-			cur = &lmem->desc;
-
-			if ((desc_get_end(cur) == prev->physical_start) &&
-			    (prev->type == cur->type) &&
-			    (prev->attribute == cur->attribute)) {
-				/* There is an existing map before, reuse it */
-				pages = cur->num_pages;
-				prev->num_pages += pages;
-				prev->physical_start -= pages << EFI_PAGE_SHIFT;
-				prev->virtual_start -= pages << EFI_PAGE_SHIFT;
-				list_del(&lmem->link);
-				free(lmem);
-
-				merge_again = true;
-				break;
-			}
-
-			prevmem = lmem;
-		}
+	int low = 0, high = efi_mem_count;
+
+	while (low < high) {
+		int mid = low + (high - low) / 2;
+
+		if (efi_mem[mid].physical_start < addr)
+			high = mid;
+		else
+			low = mid + 1;
 	}
+
+	return low;
 }
 
 /**
- * efi_mem_carve_out() - unmap memory region
- *
- * @map:		memory map
- * @carve_desc:		memory region to unmap
- * @overlap_only_ram:	the carved out region may only overlap RAM
- * Return:		the number of overlapping pages which have been
- *			removed from the map,
- *			EFI_CARVE_NO_OVERLAP, if the regions don't overlap,
- *			EFI_CARVE_OVERLAPS_NONRAM, if the carve and map overlap,
- *			and the map contains anything but free ram
- *			(only when overlap_only_ram is true),
- *			EFI_CARVE_LOOP_AGAIN, if the mapping list should be
- *			traversed again, as it has been altered.
- *
- * Unmaps all memory occupied by the carve_desc region from the list entry
- * pointed to by map.
- *
- * In case of EFI_CARVE_OVERLAPS_NONRAM it is the callers responsibility
- * to re-add the already carved out pages to the mapping.
+ * efi_mem_replace() - replace entries in the memory map
+ *
+ * @first:	index of the first entry to replace
+ * @count:	number of entries to replace
+ * @desc:	new entries, from the highest address to the lowest
+ * @num:	number of new entries
+ * Return:	0 if OK, -ENOMEM if out of memory
  */
-static s64 efi_mem_carve_out(struct efi_mem_list *map,
-			     struct efi_mem_desc *carve_desc,
-			     bool overlap_only_ram)
+static int efi_mem_replace(int first, int count,
+			   const struct efi_mem_desc *desc, int num)
 {
-	struct efi_mem_list *newmap;
-	struct efi_mem_desc *map_desc = &map->desc;
-	uint64_t map_start = map_desc->physical_start;
-	uint64_t map_end = map_start + (map_desc->num_pages << EFI_PAGE_SHIFT);
-	uint64_t carve_start = carve_desc->physical_start;
-	uint64_t carve_end = carve_start +
-			     (carve_desc->num_pages << EFI_PAGE_SHIFT);
-
-	/* check whether we're overlapping */
-	if ((carve_end <= map_start) || (carve_start >= map_end))
-		return EFI_CARVE_NO_OVERLAP;
-
-	/* We're overlapping with non-RAM, warn the caller if desired */
-	if (overlap_only_ram && (map_desc->type != EFI_CONVENTIONAL_MEMORY))
-		return EFI_CARVE_OVERLAPS_NONRAM;
-
-	/* Sanitize carve_start and carve_end to lie within our bounds */
-	carve_start = max(carve_start, map_start);
-	carve_end = min(carve_end, map_end);
-
-	/* Carving at the beginning of our map? Just move it! */
-	if (carve_start == map_start) {
-		if (map_end == carve_end) {
-			/* Full overlap, just remove map */
-			list_del(&map->link);
-			free(map);
-		} else {
-			map->desc.physical_start = carve_end;
-			map->desc.virtual_start = carve_end;
-			map->desc.num_pages = (map_end - carve_end)
-					      >> EFI_PAGE_SHIFT;
-		}
+	int new_count = efi_mem_count - count + num;
+
+	if (new_count > efi_mem_max) {
+		struct efi_mem_desc *map;
+		int max = new_count + EFI_MEM_GROW;
 
-		return (carve_end - carve_start) >> EFI_PAGE_SHIFT;
+		map = realloc(efi_mem, max * sizeof(*map));
+		if (!map)
+			return -ENOMEM;
+		efi_mem = map;
+		efi_mem_max = max;
 	}
+	memmove(&efi_mem[first + num], &efi_mem[first + count],
+		(efi_mem_count - first - count) * sizeof(*efi_mem));
+	if (num)
+		memcpy(&efi_mem[first], desc, num * sizeof(*desc));
+	efi_mem_count = new_count;
 
-	/*
-	 * Overlapping maps, just split the list map at carve_start,
-	 * it will get moved or removed in the next iteration.
-	 *
-	 * [ map_desc |__carve_start__| newmap ]
-	 */
+	return 0;
+}
 
-	/* Create a new map from [ carve_start ... map_end ] */
-	newmap = calloc(1, sizeof(*newmap));
-	if (!newmap)
-		return EFI_CARVE_OUT_OF_RESOURCES;
-	newmap->desc = map->desc;
-	newmap->desc.physical_start = carve_start;
-	newmap->desc.virtual_start = carve_start;
-	newmap->desc.num_pages = (map_end - carve_start) >> EFI_PAGE_SHIFT;
-	/* Insert before current entry (descending address order) */
-	list_add_tail(&newmap->link, &map->link);
-
-	/* Shrink the map to [ map_start ... carve_start ] */
-	map_desc->num_pages = (carve_start - map_start) >> EFI_PAGE_SHIFT;
-
-	return EFI_CARVE_LOOP_AGAIN;
+/**
+ * efi_mem_merge() - merge a memory map entry with the one below it
+ *
+ * The entries are merged if they are adjacent and have the same type and
+ * attributes
+ *
+ * @i:		index of the upper entry, may be -1 or the last entry, in which
+ *		case nothing is done
+ */
+static void efi_mem_merge(int i)
+{
+	struct efi_mem_desc *upper, *lower;
+
+	if (i < 0 || i + 1 >= efi_mem_count)
+		return;
+	upper = &efi_mem[i];
+	lower = &efi_mem[i + 1];
+	if (desc_get_end(lower) != upper->physical_start ||
+	    upper->type != lower->type || upper->attribute != lower->attribute)
+		return;
+
+	upper->physical_start = lower->physical_start;
+	upper->virtual_start = lower->virtual_start;
+	upper->num_pages += lower->num_pages;
+	/* Removing an entry cannot fail */
+	efi_mem_replace(i + 1, 1, NULL, 0);
 }
 
 /**
  * efi_add_memory_map_pg() - add pages to the memory map
  *
+ * Any parts of existing entries which overlap the new region are removed,
+ * splitting an entry if the region lies within it.
+ *
  * @start:		start address, must be a multiple of EFI_PAGE_SIZE
  * @pages:		number of pages to add
  * @memory_type:	type of memory added
@@ -268,11 +232,11 @@ static efi_status_t efi_add_memory_map_pg(u64 start, u64 pages,
 					  int memory_type,
 					  bool overlap_only_ram)
 {
-	struct list_head *lhandle;
-	struct efi_mem_list *newlist;
-	bool carve_again;
-	uint64_t carved_pages = 0;
+	uint64_t end = start + (pages << EFI_PAGE_SHIFT);
+	struct efi_mem_desc piece[3], *desc, *newdesc;
+	uint64_t covered_pages = 0;
 	struct efi_event *evt;
+	int first, i, num;
 
 	EFI_PRINT("%s: 0x%llx 0x%llx %d %s\n", __func__,
 		  start, pages, memory_type, overlap_only_ram ? "yes" : "no");
@@ -284,86 +248,79 @@ static efi_status_t efi_add_memory_map_pg(u64 start, u64 pages,
 		return EFI_SUCCESS;
 
 	++efi_memory_map_key;
-	newlist = calloc(1, sizeof(*newlist));
-	if (!newlist)
-		return EFI_OUT_OF_RESOURCES;
-	newlist->desc.type = memory_type;
-	newlist->desc.physical_start = start;
-	newlist->desc.virtual_start = start;
-	newlist->desc.num_pages = pages;
+
+	/* Find the entries which overlap the new region, [first, i) */
+	first = efi_mem_find(end);
+	for (i = first; i < efi_mem_count; i++) {
+		desc = &efi_mem[i];
+		if (desc_get_end(desc) <= start)
+			break;
+		/*
+		 * The user requested to only have RAM overlaps, but we hit a
+		 * non-RAM region. Error out.
+		 */
+		if (overlap_only_ram && desc->type != EFI_CONVENTIONAL_MEMORY)
+			return EFI_NO_MAPPING;
+		covered_pages += (min(end, desc_get_end(desc)) -
+				  max(start, desc->physical_start)) >>
+				 EFI_PAGE_SHIFT;
+	}
+
+	if (overlap_only_ram && covered_pages != pages) {
+		/*
+		 * The payload wanted to have RAM overlaps, but we overlapped
+		 * with an unallocated region. Error out.
+		 */
+		return EFI_NO_MAPPING;
+	}
+
+	/* Keep any part of the highest overlapping entry above the region */
+	num = 0;
+	if (i > first && desc_get_end(&efi_mem[first]) > end) {
+		desc = &piece[num++];
+		*desc = efi_mem[first];
+		desc->physical_start = end;
+		desc->virtual_start = end;
+		desc->num_pages = (desc_get_end(&efi_mem[first]) - end) >>
+				  EFI_PAGE_SHIFT;
+	}
+
+	newdesc = &piece[num++];
+	memset(newdesc, '\0', sizeof(*newdesc));
+	newdesc->type = memory_type;
+	newdesc->physical_start = start;
+	newdesc->virtual_start = start;
+	newdesc->num_pages = pages;
 
 	switch (memory_type) {
 	case EFI_RUNTIME_SERVICES_CODE:
 	case EFI_RUNTIME_SERVICES_DATA:
-		newlist->desc.attribute = EFI_MEMORY_WB | EFI_MEMORY_RUNTIME;
+		newdesc->attribute = EFI_MEMORY_WB | EFI_MEMORY_RUNTIME;
 		break;
 	case EFI_MMAP_IO:
-		newlist->desc.attribute = EFI_MEMORY_RUNTIME;
+		newdesc->attribute = EFI_MEMORY_RUNTIME;
 		break;
 	default:
-		newlist->desc.attribute = EFI_MEMORY_WB;
+		newdesc->attribute = EFI_MEMORY_WB;
 		break;
 	}
 
-	/* Add our new map */
-	do {
-		carve_again = false;
-		list_for_each(lhandle, &efi_mem) {
-			struct efi_mem_list *lmem;
-			s64 r;
-
-			lmem = list_entry(lhandle, struct efi_mem_list, link);
-			r = efi_mem_carve_out(lmem, &newlist->desc,
-					      overlap_only_ram);
-			switch (r) {
-			case EFI_CARVE_OUT_OF_RESOURCES:
-				free(newlist);
-				return EFI_OUT_OF_RESOURCES;
-			case EFI_CARVE_OVERLAPS_NONRAM:
-				/*
-				 * The user requested to only have RAM overlaps,
-				 * but we hit a non-RAM region. Error out.
-				 */
-				free(newlist);
-				return EFI_NO_MAPPING;
-			case EFI_CARVE_NO_OVERLAP:
-				/* Just ignore this list entry */
-				break;
-			case EFI_CARVE_LOOP_AGAIN:
-				/*
-				 * We split an entry, but need to loop through
-				 * the list again to actually carve it.
-				 */
-				carve_again = true;
-				break;
-			default:
-				/* We carved a number of pages */
-				carved_pages += r;
-				carve_again = true;
-				break;
-			}
-
-			if (carve_again) {
-				/* The list changed, we need to start over */
-				break;
-			}
-		}
-	} while (carve_again);
-
-	if (overlap_only_ram && (carved_pages != pages)) {
-		/*
-		 * The payload wanted to have RAM overlaps, but we overlapped
-		 * with an unallocated region. Error out.
-		 */
-		free(newlist);
-		return EFI_NO_MAPPING;
+	/* Keep any part of the lowest overlapping entry below the region */
+	if (i > first && efi_mem[i - 1].physical_start < start) {
+		desc = &piece[num++];
+		*desc = efi_mem[i - 1];
+		desc->num_pages = (start - desc->physical_start) >>
+				  EFI_PAGE_SHIFT;
 	}
 
 	/* Add our new map */
-        list_add_tail(&newlist->link, &efi_mem);
+	if (efi_mem_replace(first, i - first, piece, num))
+		return EFI_OUT_OF_RESOURCES;
 
-	/* And make sure memory is listed in descending order */
-	efi_mem_sort();
+	/* Merge it with its neighbours, lower first so its index is kept */
+	i = first + (newdesc - piece);
+	efi_mem_merge(i);
+	efi_mem_merge(i - 1);
 
 	/* Notify that the memory map was changed */
 	list_for_each_entry(evt, &efi_events, link) {
@@ -417,20 +374,18 @@ efi_status_t efi_add_memory_map(u64 start, u64 size, int memory_type)
  */
 static efi_status_t efi_check_allocated(u64 addr, bool must_be_allocated)
 {
-	struct efi_mem_list *item;
-
-	list_for_each_entry(item, &efi_mem, link) {
-		u64 start = item->desc.physical_start;
-		u64 end = start + (item->desc.num_pages << EFI_PAGE_SHIFT);
-
-		if (addr >= start && addr < end) {
-			if (must_be_allocated ^
-			    (item->desc.type == EFI_CONVENTIONAL_MEMORY))
-				return EFI_SUCCESS;
-			else
-				return EFI_NOT_FOUND;
-		}
-	}
+	struct efi_mem_desc *desc;
+	int i;
+
+	/* Find the entry which starts at or below addr */
+	i = efi_mem_find(addr + 1);
+	if (i == efi_mem_count)
+		return EFI_NOT_FOUND;
+	desc = &efi_mem[i];
+	if (addr >= desc_get_end(desc))
+		return EFI_NOT_FOUND;
+	if (must_be_allocated ^ (desc->type == EFI_CONVENTIONAL_MEMORY))
+		return EFI_SUCCESS;
 
 	return EFI_NOT_FOUND;
 }
@@ -444,7 +399,7 @@ static efi_status_t efi_check_allocated(u64 addr, bool must_be_allocated)
  */
 static uint64_t efi_find_free_memory(uint64_t len, uint64_t max_addr)
 {
-	struct list_head *lhandle;
+	int i;
 
 	/*
 	 * Prealign input max address, so we simplify our matching
@@ -452,10 +407,9 @@ static uint64_t efi_find_free_memory(uint64_t len, uint64_t max_addr)
 	 */
 	max_addr &= ~EFI_PAGE_MASK;
 
-	list_for_each(lhandle, &efi_mem) {
-		struct efi_mem_list *lmem = list_entry(lhandle,
-			struct efi_mem_list, link);
-		struct efi_mem_desc *desc = &lmem->desc;
+	/* Skip entries which start above max_addr */
+	for (i = efi_mem_find(max_addr + 1); i < efi_mem_count; i++) {
+		struct efi_mem_desc *desc = &efi_mem[i];
 		uint64_t desc_len = desc->num_pages << EFI_PAGE_SHIFT;
 		uint64_t desc_end = desc->physical_start + desc_len;
 		uint64_t curmax = min(max_addr, desc_end);
@@ -633,6 +587,126 @@ void *efi_alloc_aligned_pages(u64 len, int memory_type, size_t align)
 	return (void *)(uintptr_t)aligned_mem;
 }
 
+/**
+ * efi_pool_bucket() - get the block size to use for a small pool allocation
+ *
+ * @size:	number of bytes requested
+ * Return:	index of the smallest block size which can hold @size bytes, or
+ *		-1 if @size must be allocated in whole pages
+ */
+static int efi_pool_bucket(efi_uintn_t size)
+{
+	uint block = EFI_POOL_MIN_BLOCK;
+	int bucket;
+
+	size = max_t(efi_uintn_t, size, ARCH_DMA_MINALIGN);
+	for (bucket = 0; bucket < EFI_POOL_BUCKETS; bucket++, block <<= 1) {
+		if (size <= block)
+			return bucket;
+	}
+
+	return -1;
+}
+
+/**
+ * efi_pool_alloc_block() - allocate a small block from pool
+ *
+ * @pool_type:	type of the pool from which memory is to be allocated
+ * @bucket:	index of the block size, from efi_pool_bucket()
+ * @buffer:	allocated memory
+ * Return:	status code
+ */
+static efi_status_t efi_pool_alloc_block(enum efi_memory_type pool_type,
+					 int bucket, void **buffer)
+{
+	struct list_head *head = &efi_pool[pool_type][bucket];
+	struct efi_pool_page *page;
+	void **block;
+
+	if (!head->next)
+		INIT_LIST_HEAD(head);
+
+	if (list_empty(head)) {
+		uint size = EFI_POOL_MIN_BLOCK << bucket;
+		efi_status_t r;
+		ulong offset;
+		u64 addr;
+
+		r = efi_allocate_pages(EFI_ALLOCATE_ANY_PAGES, pool_type, 1,
+				       &addr);
+		if (r != EFI_SUCCESS)
+			return r;
+		page = (struct efi_pool_page *)(uintptr_t)addr;
+		page->magic = EFI_POOL_PAGE_MAGIC;
+		page->type = pool_type;
+		page->size = size;
+		page->used = 0;
+		page->free = NULL;
+		for (offset = EFI_POOL_FIRST_BLOCK;
+		     offset + size <= EFI_PAGE_SIZE; offset += size) {
+			block = (void *)page + offset;
+			*block = page->free;
+			page->free = block;
+		}
+		list_add(&page->link, head);
+	}
+
+	page = list_first_entry(head, struct efi_pool_page, link);
+	block = page->free;
+	page->free = *block;
+	page->used++;
+	if (!page->free)
+		list_del(&page->link);
+	*buffer = block;
+
+	return EFI_SUCCESS;
+}
+
+/**
+ * efi_pool_free_block() - free a small block allocated from pool
+ *
+ * @page:	page containing the block
+ * @buffer:	start of the block
+ * Return:	status code
+ */
+static efi_status_t efi_pool_free_block(struct efi_pool_page *page,
+					void *buffer)
+{
+	ulong offset = buffer - (void *)page;
+	void **block;
+
+	/* Check that this is the start of a block and that it is in use */
+	if (offset < EFI_POOL_FIRST_BLOCK ||
+	    (offset - EFI_POOL_FIRST_BLOCK) % page->size || !page->used)
+		goto err;
+	for (block = page->free; block; block = *block) {
+		if (block == buffer)
+			goto err;
+	}
+
+	if (!--page->used) {
+		if (page->free)
+			list_del(&page->link);
+		page->magic = 0;
+
+		return efi_free_pages((uintptr_t)page, 1);
+	}
+	if (!page->free) {
+		list_add(&page->link, &efi_pool[page->type][
+			 efi_pool_bucket(page->size)]);
+	}
+	block = buffer;
+	*block = page->free;
+	page->free = block;
+
+	return EFI_SUCCESS;
+
+err:
+	printf("%s: illegal free 0x%p\n", __func__, buffer);
+
+	return EFI_INVALID_PARAMETER;
+}
+
 /**
  * efi_allocate_pool - allocate memory from pool
  *
@@ -648,6 +722,7 @@ efi_status_t efi_allocate_pool(enum efi_memory_type pool_type, efi_uintn_t size,
 	struct efi_pool_allocation *alloc;
 	u64 num_pages = efi_size_in_pages(size +
 					  sizeof(struct efi_pool_allocation));
+	int bucket;
 
 	if (!buffer)
 		return EFI_INVALID_PARAMETER;
@@ -657,6 +732,10 @@ efi_status_t efi_allocate_pool(enum efi_memory_type pool_type, efi_uintn_t size,
 		return EFI_SUCCESS;
 	}
 
+	bucket = efi_pool_bucket(size);
+	if (pool_type < EFI_MAX_MEMORY_TYPE && bucket >= 0)
+		return efi_pool_alloc_block(pool_type, bucket, buffer);
+
 	r = efi_allocate_pages(EFI_ALLOCATE_ANY_PAGES, pool_type, num_pages,
 			       &addr);
 	if (r == EFI_SUCCESS) {
@@ -701,6 +780,7 @@ efi_status_t efi_free_pool(void *buffer)
 {
 	efi_status_t ret;
 	struct efi_pool_allocation *alloc;
+	struct efi_pool_page *page;
 
 	if (!buffer)
 		return EFI_INVALID_PARAMETER;
@@ -709,6 +789,10 @@ efi_status_t efi_free_pool(void *buffer)
 	if (ret != EFI_SUCCESS)
 		return ret;
 
+	page = (struct efi_pool_page *)((uintptr_t)buffer & ~EFI_PAGE_MASK);
+	if (page->magic == EFI_POOL_PAGE_MAGIC)
+		return efi_pool_free_block(page, buffer);
+
 	alloc = container_of(buffer, struct efi_pool_allocation, data);
 
 	/* Check that this memory was allocated by efi_allocate_pool() */
@@ -743,18 +827,15 @@ efi_status_t efi_get_memory_map(efi_uintn_t *memory_map_size,
 				uint32_t *descriptor_version)
 {
 	efi_uintn_t map_size = 0;
-	int map_entries = 0;
-	struct list_head *lhandle;
+	int map_entries = efi_mem_count;
 	efi_uintn_t provided_map_size;
+	int i;
 
 	if (!memory_map_size)
 		return EFI_INVALID_PARAMETER;
 
 	provided_map_size = *memory_map_size;
 
-	list_for_each(lhandle, &efi_mem)
-		map_entries++;
-
 	map_size = map_entries * sizeof(struct efi_mem_desc);
 
 	*memory_map_size = map_size;
@@ -771,16 +852,9 @@ efi_status_t efi_get_memory_map(efi_uintn_t *memory_map_size,
 	if (!memory_map)
 		return EFI_INVALID_PARAMETER;
 
-	/* Copy list into array */
-	/* Return the list in ascending order */
-	memory_map = &memory_map[map_entries - 1];
-	list_for_each(lhandle, &efi_mem) {
-		struct efi_mem_list *lmem;
-
-		lmem = list_entry(lhandle, struct efi_mem_list, link);
-		*memory_map = lmem->desc;
-		memory_map--;
-	}
+	/* Return the map in ascending order */
+	for (i = 0; i < map_entries; i++)
+		memory_map[map_entries - 1 - i] = efi_mem[i];
 
 	if (map_key)
 		*map_key = efi_memory_map_key;
@@ -10,6 +10,7 @@
 #include <image.h>
 #include <hexdump.h>
 #include <malloc.h>
+#include <sort.h>
 #include <crypto/pkcs7.h>
 #include <crypto/pkcs7_parser.h>
 #include <crypto/public_key.h>
@@ -159,6 +160,37 @@ bool efi_hash_regions(struct image_region *regs, int count,
 	return true;
 }
 
+/**
+ * efi_image_regions_hash - get the digest of an image
+ * @regs:	List of regions to be authenticated
+ * @hash_algo:	Hash algorithm to use
+ * @lenp:	Returns the length of the digest
+ *
+ * An image is checked against dbx, each of its signatures and db, so the
+ * digest is kept in @regs once it has been calculated.
+ *
+ * Return:	Pointer to the digest, NULL on error
+ */
+const void *efi_image_regions_hash(struct efi_image_regions *regs,
+				   const char *hash_algo, int *lenp)
+{
+	void *hash = regs->hash;
+
+	if (!hash_algo)
+		return NULL;
+	if (!regs->hash_algo || strcmp(regs->hash_algo, hash_algo)) {
+		regs->hash_algo = NULL;
+		if (algo_to_len(hash_algo) > sizeof(regs->hash) ||
+		    !efi_hash_regions(regs->reg, regs->num, &hash, hash_algo,
+				      &regs->hash_len))
+			return NULL;
+		regs->hash_algo = hash_algo;
+	}
+	*lenp = regs->hash_len;
+
+	return regs->hash;
+}
+
 /**
  * hash_algo_supported - check if the requested hash algorithm is supported
  * @guid: guid of the algorithm
@@ -183,6 +215,78 @@ static bool hash_algo_supported(const efi_guid_t guid)
 	return true;
 }
 
+/**
+ * struct efi_sigdb_cache - A signature database kept between authentications
+ *
+ * db and dbx are read for every image which is authenticated, and dbx may
+ * hold thousands of digests. The signature store is kept while the variable
+ * does not change, along with a sorted index of the SHA-256 digests in it.
+ *
+ * @name:	Variable name
+ * @raw:	Copy of the variable which @store was built from
+ * @size:	Size of @raw
+ * @store:	Signature store, or NULL if none
+ * @digests:	Sorted SHA-256 digests in @store, or NULL to search @store
+ * @count:	Number of @digests
+ */
+static struct efi_sigdb_cache {
+	const u16 *name;
+	void *raw;
+	efi_uintn_t size;
+	struct efi_signature_store *store;
+	u8 (*digests)[SHA256_SUM_LEN];
+	int count;
+} efi_sigdb_cache[] = {
+	{ .name = u"db" },
+	{ .name = u"dbx" },
+};
+
+/**
+ * efi_sigdb_cache_find - find the cache entry holding a signature store
+ * @sigstore:	Signature store
+ *
+ * Return:	Pointer to cache entry, NULL if @sigstore is not cached
+ */
+static struct efi_sigdb_cache *
+efi_sigdb_cache_find(struct efi_signature_store *sigstore)
+{
+	int i;
+
+	for (i = 0; sigstore && i < ARRAY_SIZE(efi_sigdb_cache); i++) {
+		if (efi_sigdb_cache[i].store == sigstore)
+			return &efi_sigdb_cache[i];
+	}
+
+	return NULL;
+}
+
+/**
+ * efi_sigdb_find_digest - search the index of a cached signature store
+ * @cache:	Cache entry
+ * @hash:	SHA-256 digest to search for
+ *
+ * Return:	true if found, false if not
+ */
+static bool efi_sigdb_find_digest(const struct efi_sigdb_cache *cache,
+				  const void *hash)
+{
+	int lo = 0, hi = cache->count;
+
+	while (lo < hi) {
+		int mid = (lo + hi) / 2;
+		int cmp = memcmp(cache->digests[mid], hash, SHA256_SUM_LEN);
+
+		if (!cmp)
+			return true;
+		if (cmp < 0)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+
+	return false;
+}
+
 /**
  * efi_signature_lookup_digest - search for an image's digest in sigdb
  * @regs:	List of regions to be authenticated
@@ -201,19 +305,22 @@ bool efi_signature_lookup_digest(struct efi_image_regions *regs,
 
 {
 	struct efi_signature_store *siglist;
+	struct efi_sigdb_cache *cache;
 	struct efi_sig_data *sig_data;
-	void *hash = NULL;
+	const char *hash_algo;
+	const void *hash;
 	bool found = false;
-	bool hash_done = false;
+	bool indexed = false;
+	int len;
 
 	EFI_PRINT("%s: Enter, %p, %p\n", __func__, regs, db);
 
 	if (!regs || !db || !db->sig_data_list)
 		goto out;
 
+	cache = efi_sigdb_cache_find(db);
+	hash_algo = guid_to_sha_str(&efi_guid_sha256);
 	for (siglist = db; siglist; siglist = siglist->next) {
-		int len = 0;
-		const char *hash_algo = NULL;
 		/*
 		 * if the hash algorithm is unsupported and we get an entry in
 		 * dbx reject the image
@@ -229,18 +336,22 @@ bool efi_signature_lookup_digest(struct efi_image_regions *regs,
 		if (guidcmp(&siglist->sig_type, &efi_guid_sha256))
 			continue;
 
-		hash_algo = guid_to_sha_str(&efi_guid_sha256);
-		/*
-		 * We could check size and hash_algo but efi_hash_regions()
-		 * will do that for us
-		 */
-		if (!hash_done &&
-		    !efi_hash_regions(regs->reg, regs->num, &hash, hash_algo,
-				      &len)) {
+		hash = efi_image_regions_hash(regs, hash_algo, &len);
+		if (!hash) {
 			EFI_PRINT("Digesting an image failed\n");
 			break;
 		}
-		hash_done = true;
+
+		/* The index covers all the SHA-256 lists */
+		if (cache && cache->digests) {
+			if (!indexed && len == SHA256_SUM_LEN &&
+			    efi_sigdb_find_digest(cache, hash)) {
+				found = true;
+				goto out;
+			}
+			indexed = true;
+			continue;
+		}
 
 		for (sig_data = siglist->sig_data_list; sig_data;
 		     sig_data = sig_data->next) {
@@ -252,13 +363,9 @@ bool efi_signature_lookup_digest(struct efi_image_regions *regs,
 			if (sig_data->size == len &&
 			    !memcmp(sig_data->data, hash, len)) {
 				found = true;
-				free(hash);
 				goto out;
 			}
 		}
-
-		free(hash);
-		hash = NULL;
 	}
 
 out:
@@ -266,6 +373,26 @@ out:
 	return found;
 }
 
+/**
+ * efi_sig_data_cert - get the certificate in a signature
+ * @sig_data:	Signature data of an X.509 signature list
+ *
+ * The certificate is parsed on first use and kept with the signature
+ * store, so cached databases are only parsed once.
+ *
+ * Return:	Pointer to certificate, NULL if it cannot be parsed
+ */
+static struct x509_certificate *efi_sig_data_cert(struct efi_sig_data *sig_data)
+{
+	if (!sig_data->cert)
+		sig_data->cert = x509_cert_parse(sig_data->data,
+						 sig_data->size);
+	if (IS_ERR_OR_NULL(sig_data->cert))
+		return NULL;
+
+	return sig_data->cert;
+}
+
 /**
  * efi_lookup_certificate - find a certificate within db
  * @msg:	Signature
@@ -281,30 +408,14 @@ static bool efi_lookup_certificate(struct x509_certificate *cert,
 {
 	struct efi_signature_store *siglist;
 	struct efi_sig_data *sig_data;
-	struct image_region reg[1];
-	void *hash = NULL, *hash_tmp = NULL;
-	int len = 0;
 	bool found = false;
-	const char *hash_algo = NULL;
 
 	EFI_PRINT("%s: Enter, %p, %p\n", __func__, cert, db);
 
 	if (!cert || !db || !db->sig_data_list)
 		goto out;
 
-	/*
-	 * TODO: identify a certificate using sha256 digest
-	 * Is there any better way?
-	 */
-	/* calculate hash of TBSCertificate */
-	reg[0].data = cert->tbs;
-	reg[0].size = cert->tbs_size;
-
-	/* We just need any sha256 algo to start the matching */
-	hash_algo = guid_to_sha_str(&efi_guid_sha256);
-	if (!efi_hash_regions(reg, 1, &hash, hash_algo, &len))
-		goto out;
-
+	/* Certificates are the same if their TBSCertificates are */
 	EFI_PRINT("%s: searching for %s\n", __func__, cert->subject);
 	for (siglist = db; siglist; siglist = siglist->next) {
 		/* only with x509 certificate */
@@ -315,31 +426,20 @@ static bool efi_lookup_certificate(struct x509_certificate *cert,
 		     sig_data = sig_data->next) {
 			struct x509_certificate *cert_tmp;
 
-			cert_tmp = x509_cert_parse(sig_data->data,
-						   sig_data->size);
-			if (IS_ERR_OR_NULL(cert_tmp))
+			cert_tmp = efi_sig_data_cert(sig_data);
+			if (!cert_tmp)
 				continue;
 
 			EFI_PRINT("%s: against %s\n", __func__,
 				  cert_tmp->subject);
-			reg[0].data = cert_tmp->tbs;
-			reg[0].size = cert_tmp->tbs_size;
-			if (!efi_hash_regions(reg, 1, &hash_tmp, hash_algo,
-					      NULL))
-				goto out;
-
-			x509_free_certificate(cert_tmp);
-
-			if (!memcmp(hash, hash_tmp, len)) {
+			if (cert_tmp->tbs_size == cert->tbs_size &&
+			    !memcmp(cert_tmp->tbs, cert->tbs, cert->tbs_size)) {
 				found = true;
 				goto out;
 			}
 		}
 	}
 out:
-	free(hash);
-	free(hash_tmp);
-
 	EFI_PRINT("%s: Exit, found: %d\n", __func__, found);
 	return found;
 }
@@ -348,52 +448,65 @@ out:
  * efi_verify_certificate - verify certificate's signature with database
  * @signer:	Certificate
  * @db:		Signature database
- * @root:	Certificate to verify @signer
+ * @root:	Certificate to verify @signer, which belongs to @db
  *
  * Determine if certificate pointed to by @signer may be verified
  * by one of certificates in signature database pointed to by @db.
  *
+ * Certificates whose subject key identifier matches the authority key
+ * identifier of @signer are tried first, since one of them is normally the
+ * issuer. The others are tried after that.
+ *
  * Return:	true if certificate is verified, false otherwise.
  */
 static bool efi_verify_certificate(struct x509_certificate *signer,
 				   struct efi_signature_store *db,
 				   struct x509_certificate **root)
 {
+	const struct asymmetric_key_id *akid;
 	struct efi_signature_store *siglist;
 	struct efi_sig_data *sig_data;
 	struct x509_certificate *cert;
 	bool verified = false;
-	int ret;
+	int pass;
 
 	EFI_PRINT("%s: Enter, %p, %p\n", __func__, signer, db);
 
 	if (!signer || !db || !db->sig_data_list)
 		goto out;
 
-	for (siglist = db; siglist; siglist = siglist->next) {
-		/* only with x509 certificate */
-		if (guidcmp(&siglist->sig_type, &efi_guid_cert_x509))
-			continue;
-
-		for (sig_data = siglist->sig_data_list; sig_data;
-		     sig_data = sig_data->next) {
-			cert = x509_cert_parse(sig_data->data, sig_data->size);
-			if (IS_ERR_OR_NULL(cert)) {
-				EFI_PRINT("Cannot parse x509 certificate\n");
+	akid = signer->sig->auth_ids[1];
+	for (pass = akid ? 0 : 1; pass < 2; pass++) {
+		for (siglist = db; siglist; siglist = siglist->next) {
+			/* only with x509 certificate */
+			if (guidcmp(&siglist->sig_type, &efi_guid_cert_x509))
 				continue;
-			}
 
-			ret = public_key_verify_signature(cert->pub,
-							  signer->sig);
-			if (!ret) {
-				verified = true;
-				if (root)
-					*root = cert;
-				else
-					x509_free_certificate(cert);
-				goto out;
+			for (sig_data = siglist->sig_data_list; sig_data;
+			     sig_data = sig_data->next) {
+				bool match;
+
+				cert = efi_sig_data_cert(sig_data);
+				if (!cert) {
+					EFI_PRINT("Cannot parse x509 certificate\n");
+					continue;
+				}
+
+				/* First pass: issuer; second pass: the rest */
+				match = akid && cert->skid &&
+					asymmetric_key_id_same(cert->skid,
+							       akid);
+				if (match != !pass)
+					continue;
+
+				if (!public_key_verify_signature(cert->pub,
+								 signer->sig)) {
+					verified = true;
+					if (root)
+						*root = cert;
+					goto out;
+				}
 			}
-			x509_free_certificate(cert);
 		}
 	}
 
@@ -556,7 +669,6 @@ bool efi_signature_verify(struct efi_image_regions *regs,
 
 			check = efi_signature_check_revocation(sinfo, root,
 							       dbx);
-			x509_free_certificate(root);
 			if (check)
 				break;
 		}
@@ -616,12 +728,18 @@ void efi_sigstore_free(struct efi_signature_store *sigstore)
 	struct efi_signature_store *sigstore_next;
 	struct efi_sig_data *sig_data, *sig_data_next;
 
+	/* Cached stores are freed when the variable changes */
+	if (efi_sigdb_cache_find(sigstore))
+		return;
+
 	while (sigstore) {
 		sigstore_next = sigstore->next;
 
 		sig_data = sigstore->sig_data_list;
 		while (sig_data) {
 			sig_data_next = sig_data->next;
+			if (!IS_ERR_OR_NULL(sig_data->cert))
+				x509_free_certificate(sig_data->cert);
 			free(sig_data->data);
 			free(sig_data);
 			sig_data = sig_data_next;
@@ -702,8 +820,7 @@ efi_sigstore_parse_siglist(struct efi_signature_list *esl)
 			goto err;
 		}
 
-		sig_data = calloc(esl->signature_size
-					- sizeof(esd->signature_owner), 1);
+		sig_data = calloc(sizeof(*sig_data), 1);
 		if (!sig_data) {
 			EFI_PRINT("Out of memory\n");
 			goto err;
@@ -796,6 +913,109 @@ err:
 	return NULL;
 }
 
+static int efi_sigdb_digest_cmp(const void *a, const void *b)
+{
+	return memcmp(a, b, SHA256_SUM_LEN);
+}
+
+/**
+ * efi_sigdb_cache_index - build the digest index of a cached signature store
+ * @cache:	Cache entry
+ *
+ * If this fails, @cache->digests is left as NULL and the store is searched
+ * as usual.
+ */
+static void efi_sigdb_cache_index(struct efi_sigdb_cache *cache)
+{
+	struct efi_signature_store *siglist;
+	struct efi_sig_data *sig_data;
+	int count = 0;
+
+	for (siglist = cache->store; siglist; siglist = siglist->next) {
+		if (guidcmp(&siglist->sig_type, &efi_guid_sha256))
+			continue;
+		for (sig_data = siglist->sig_data_list; sig_data;
+		     sig_data = sig_data->next)
+			count += sig_data->size == SHA256_SUM_LEN;
+	}
+	if (!count)
+		return;
+
+	cache->digests = malloc(count * SHA256_SUM_LEN);
+	if (!cache->digests)
+		return;
+	for (siglist = cache->store; siglist; siglist = siglist->next) {
+		if (guidcmp(&siglist->sig_type, &efi_guid_sha256))
+			continue;
+		for (sig_data = siglist->sig_data_list; sig_data;
+		     sig_data = sig_data->next) {
+			if (sig_data->size == SHA256_SUM_LEN)
+				memcpy(cache->digests[cache->count++],
+				       sig_data->data, SHA256_SUM_LEN);
+		}
+	}
+	qsort(cache->digests, count, SHA256_SUM_LEN, efi_sigdb_digest_cmp);
+}
+
+/**
+ * efi_sigdb_cache_drop - free a cached signature store
+ * @cache:	Cache entry
+ */
+static void efi_sigdb_cache_drop(struct efi_sigdb_cache *cache)
+{
+	struct efi_signature_store *store = cache->store;
+
+	cache->store = NULL;
+	efi_sigstore_free(store);
+	free(cache->raw);
+	free(cache->digests);
+	cache->raw = NULL;
+	cache->size = 0;
+	cache->digests = NULL;
+	cache->count = 0;
+}
+
+/**
+ * efi_sigdb_cache_get - get the signature store for a cached variable
+ * @cache:	Cache entry
+ * @db:		Value of the variable, which is freed
+ * @db_size:	Size of @db
+ *
+ * The cached store is used if the variable has not changed. Otherwise a new
+ * one is built and cached.
+ *
+ * Return:	Pointer to signature store on success, NULL on error
+ */
+static struct efi_signature_store *
+efi_sigdb_cache_get(struct efi_sigdb_cache *cache, void *db,
+		    efi_uintn_t db_size)
+{
+	struct efi_signature_store *store;
+	void *raw;
+
+	if (cache->store && cache->size == db_size &&
+	    !memcmp(cache->raw, db, db_size)) {
+		free(db);
+		return cache->store;
+	}
+	efi_sigdb_cache_drop(cache);
+
+	raw = malloc(db_size);
+	if (raw)
+		memcpy(raw, db, db_size);
+	store = efi_build_signature_store(db, db_size);
+	if (!store || !raw) {
+		free(raw);
+		return store;
+	}
+	cache->raw = raw;
+	cache->size = db_size;
+	cache->store = store;
+	efi_sigdb_cache_index(cache);
+
+	return store;
+}
+
 /**
  * efi_sigstore_parse_sigdb - parse a signature database variable
  * @name:	Variable's name
@@ -810,6 +1030,7 @@ struct efi_signature_store *efi_sigstore_parse_sigdb(u16 *name)
 	const efi_guid_t *vendor;
 	void *db;
 	efi_uintn_t db_size;
+	int i;
 
 	vendor = efi_auth_var_get_guid(name);
 	db = efi_get_var(name, vendor, &db_size);
@@ -818,5 +1039,11 @@ struct efi_signature_store *efi_sigstore_parse_sigdb(u16 *name)
 		return calloc(sizeof(struct efi_signature_store), 1);
 	}
 
+	for (i = 0; i < ARRAY_SIZE(efi_sigdb_cache); i++) {
+		if (!u16_strcmp(name, efi_sigdb_cache[i].name))
+			return efi_sigdb_cache_get(&efi_sigdb_cache[i], db,
+						   db_size);
+	}
+
 	return efi_build_signature_store(db, db_size);
 }
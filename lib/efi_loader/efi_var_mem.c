@@ -18,6 +18,83 @@
 static struct efi_var_file __efi_runtime_data *efi_var_buf;
 static struct efi_var_entry __efi_runtime_data *efi_current_var;
 
+/*
+ * Hash index of the variables in efi_var_buf, using linear probing. Each
+ * slot holds the offset of a variable from the start of efi_var_buf, or 0 if
+ * the slot is empty. Offsets are used rather than pointers so that nothing
+ * needs converting for SetVirtualAddressMap().
+ *
+ * There is always at least one slot for each 32 bytes of the buffer, i.e.
+ * more slots than there can be variables, so a probe always finds an empty
+ * slot. If the index cannot be allocated, variables are found by walking
+ * the buffer.
+ */
+static u32 __efi_runtime_data *efi_var_index;
+static u32 __efi_runtime_data efi_var_index_mask;
+
+/**
+ * efi_var_hash() - calculate the hash of a variable's GUID and name
+ *
+ * This uses the FNV-1a hash.
+ *
+ * @guid:	vendor GUID
+ * @name:	variable name
+ * Return:	hash value
+ */
+static u32 __efi_runtime efi_var_hash(const efi_guid_t *guid, const u16 *name)
+{
+	const u8 *pos = (const u8 *)guid;
+	u32 hash = 2166136261U;
+	int i;
+
+	for (i = 0; i < sizeof(efi_guid_t); i++)
+		hash = (hash ^ pos[i]) * 16777619;
+	for (; *name; name++)
+		hash = (hash ^ *name) * 16777619;
+
+	return hash;
+}
+
+/**
+ * efi_var_index_add() - add a variable to the hash index
+ *
+ * @var:	variable in efi_var_buf
+ */
+static void __efi_runtime efi_var_index_add(struct efi_var_entry *var)
+{
+	u32 slot;
+
+	if (!efi_var_index)
+		return;
+
+	slot = efi_var_hash(&var->guid, var->name) & efi_var_index_mask;
+	while (efi_var_index[slot])
+		slot = (slot + 1) & efi_var_index_mask;
+	efi_var_index[slot] = (uintptr_t)var - (uintptr_t)efi_var_buf;
+}
+
+/**
+ * efi_var_index_build() - build the hash index from scratch
+ *
+ * This is needed whenever variables move within efi_var_buf.
+ */
+static void __efi_runtime efi_var_index_build(void)
+{
+	struct efi_var_entry *var, *last;
+	u32 slot;
+
+	if (!efi_var_index)
+		return;
+
+	for (slot = 0; slot <= efi_var_index_mask; slot++)
+		efi_var_index[slot] = 0;
+	last = (struct efi_var_entry *)
+	       ((uintptr_t)efi_var_buf + efi_var_buf->length);
+	for (var = efi_var_buf->var; var < last;
+	     var = (void *)var + efi_var_entry_len(var))
+		efi_var_index_add(var);
+}
+
 /**
  * efi_var_mem_compare() - compare GUID and name with a variable
  *
@@ -102,6 +179,24 @@ struct efi_var_entry __efi_runtime
 		return efi_current_var;
 	}
 
+	if (efi_var_index) {
+		u32 slot = efi_var_hash(guid, name) & efi_var_index_mask;
+
+		for (; efi_var_index[slot];
+		     slot = (slot + 1) & efi_var_index_mask) {
+			var = (struct efi_var_entry *)
+			      ((uintptr_t)efi_var_buf + efi_var_index[slot]);
+			if (efi_var_mem_compare(var, guid, name, next)) {
+				if (next && *next >= last)
+					*next = NULL;
+				return var;
+			}
+		}
+		if (next)
+			*next = NULL;
+		return NULL;
+	}
+
 	var = efi_var_buf->var;
 	if (var < last) {
 		for (; var;) {
@@ -149,6 +244,9 @@ void __efi_runtime efi_var_mem_del(struct efi_var_entry *var)
 	efi_var_buf->crc32 = crc32(0, (u8 *)efi_var_buf->var,
 				   efi_var_buf->length -
 				   sizeof(struct efi_var_file));
+
+	/* The following variables have moved */
+	efi_var_index_build();
 }
 
 efi_status_t __efi_runtime efi_var_mem_ins(
@@ -180,6 +278,7 @@ efi_status_t __efi_runtime efi_var_mem_ins(
 			   sizeof(u16) * var_name_len);
 	efi_memcpy_runtime(data, data1, size1);
 	efi_memcpy_runtime((u8 *)data + size1, data2, size2);
+	efi_var_index_add(var);
 
 	var = (struct efi_var_entry *)
 	      ALIGN((uintptr_t)data + var->length, 8);
@@ -211,6 +310,8 @@ static void EFIAPI __efi_runtime
 efi_var_mem_notify_virtual_address_map(struct efi_event *event, void *context)
 {
 	efi_convert_pointer(0, (void **)&efi_var_buf);
+	if (efi_var_index)
+		efi_convert_pointer(0, (void **)&efi_var_index);
 	efi_current_var = NULL;
 }
 
@@ -219,6 +320,7 @@ efi_status_t efi_var_mem_init(void)
 	u64 memory;
 	efi_status_t ret;
 	struct efi_event *event;
+	u32 slots;
 
 	ret = efi_allocate_pages(EFI_ALLOCATE_ANY_PAGES,
 				 EFI_RUNTIME_SERVICES_DATA,
@@ -232,6 +334,18 @@ efi_status_t efi_var_mem_init(void)
 	efi_var_buf->length = (uintptr_t)efi_var_buf->var -
 			      (uintptr_t)efi_var_buf;
 
+	/* Without the index, variables are found by walking the buffer */
+	for (slots = 1; slots < EFI_VAR_BUF_SIZE / 32; slots <<= 1)
+		;
+	if (efi_allocate_pages(EFI_ALLOCATE_ANY_PAGES,
+			       EFI_RUNTIME_SERVICES_DATA,
+			       efi_size_in_pages(slots * sizeof(u32)),
+			       &memory) == EFI_SUCCESS) {
+		efi_var_index = (u32 *)(uintptr_t)memory;
+		efi_var_index_mask = slots - 1;
+		efi_var_index_build();
+	}
+
 	ret = efi_create_event(EVT_SIGNAL_VIRTUAL_ADDRESS_CHANGE, TPL_CALLBACK,
 			       efi_var_mem_notify_virtual_address_map, NULL,
 			       NULL, &event);
@@ -396,4 +510,6 @@ skip:
 void efi_var_buf_update(struct efi_var_file *var_buf)
 {
 	memcpy(efi_var_buf, var_buf, EFI_VAR_BUF_SIZE);
+	efi_current_var = NULL;
+	efi_var_index_build();
 }
@@ -12,7 +12,7 @@
  * file protocol.
  * A known file is read from the file system and verified.
  * The same block is read via the EFI_BLOCK_IO_PROTOCOL and compared to the file
- * contents.
+ * contents. If available, it is also read via the EFI_BLOCK_IO2_PROTOCOL.
  */
 
 #include <efi_selftest.h>
@@ -28,6 +28,7 @@
 static struct efi_boot_services *boottime;
 
 static const efi_guid_t block_io_protocol_guid = EFI_BLOCK_IO_PROTOCOL_GUID;
+static const efi_guid_t block_io2_protocol_guid = EFI_BLOCK_IO2_PROTOCOL_GUID;
 static const efi_guid_t guid_device_path = EFI_DEVICE_PATH_PROTOCOL_GUID;
 static const efi_guid_t guid_simple_file_system_protocol =
 					EFI_SIMPLE_FILE_SYSTEM_PROTOCOL_GUID;
@@ -315,6 +316,11 @@ static int execute(void)
 	u32 part1_size;
 	u64 pos;
 	char block_io_aligned[1 << LB_BLOCK_SIZE] __aligned(1 << LB_BLOCK_SIZE);
+#ifdef CONFIG_EFI_BLOCK_IO2
+	struct efi_block_io2 *block_io2_protocol;
+	struct efi_block_io2_token token;
+	efi_uintn_t index;
+#endif
 
 	/* Connect controller to virtual disk */
 	ret = boottime->connect_controller(disk_handle, NULL, NULL, 1);
@@ -476,6 +482,52 @@ static int execute(void)
 		return EFI_ST_FAILURE;
 	}
 
+#ifdef CONFIG_EFI_BLOCK_IO2
+	/* Read the same block with a non-blocking ReadBlocksEx() */
+	ret = boottime->open_protocol(handle_partition,
+				      &block_io2_protocol_guid,
+				      (void **)&block_io2_protocol, NULL, NULL,
+				      EFI_OPEN_PROTOCOL_GET_PROTOCOL);
+	if (ret != EFI_SUCCESS) {
+		efi_st_error("Failed to open block IO 2 protocol\n");
+		return EFI_ST_FAILURE;
+	}
+	ret = boottime->create_event(0, TPL_CALLBACK, NULL, NULL,
+				     &token.event);
+	if (ret != EFI_SUCCESS) {
+		efi_st_error("Could not create event\n");
+		return EFI_ST_FAILURE;
+	}
+	memset(block_io_aligned, 0, sizeof(block_io_aligned));
+	ret = block_io2_protocol->read_blocks_ex(block_io2_protocol,
+				block_io2_protocol->media->media_id,
+				(0x5000 >> LB_BLOCK_SIZE) - 1, &token,
+				block_io2_protocol->media->block_size,
+				block_io_aligned);
+	if (ret != EFI_SUCCESS) {
+		efi_st_error("ReadBlocksEx failed\n");
+		return EFI_ST_FAILURE;
+	}
+	ret = boottime->wait_for_event(1, &token.event, &index);
+	if (ret != EFI_SUCCESS) {
+		efi_st_error("Could not wait for event\n");
+		return EFI_ST_FAILURE;
+	}
+	ret = boottime->close_event(token.event);
+	if (ret != EFI_SUCCESS) {
+		efi_st_error("Could not close event\n");
+		return EFI_ST_FAILURE;
+	}
+	if (token.transaction_status != EFI_SUCCESS) {
+		efi_st_error("ReadBlocksEx transaction failed\n");
+		return EFI_ST_FAILURE;
+	}
+	if (memcmp(block_io_aligned + 1, buf, 11)) {
+		efi_st_error("Unexpected block content from ReadBlocksEx\n");
+		return EFI_ST_FAILURE;
+	}
+#endif
+
 #ifdef CONFIG_FAT_WRITE
 	/* Write file */
 	ret = root->open(root, &file, u"u-boot.txt", EFI_FILE_MODE_READ |
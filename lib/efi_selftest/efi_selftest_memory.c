@@ -5,7 +5,7 @@
  * Copyright (c) 2018 Heinrich Schuchardt <xypron.glpk@gmx.de>
  *
  * This unit test checks the following boottime services:
- * AllocatePages, FreePages, GetMemoryMap
+ * AllocatePages, FreePages, GetMemoryMap, AllocatePool, FreePool
  *
  * The memory type used for the device tree is checked.
  */
@@ -13,6 +13,7 @@
 #include <efi_selftest.h>
 
 #define EFI_ST_NUM_PAGES 8
+#define EFI_ST_NUM_POOLS 24
 
 static const efi_guid_t fdt_guid = EFI_FDT_GUID;
 static struct efi_boot_services *boottime;
@@ -93,6 +94,55 @@ static int find_in_memory_map(efi_uintn_t map_size,
 	return EFI_ST_SUCCESS;
 }
 
+/**
+ * test_pool() - check small pool allocations
+ *
+ * Allocate pools of various sizes, check that they are aligned and do not
+ * overlap, then free them.
+ *
+ * Return:	EFI_ST_SUCCESS for success
+ */
+static int test_pool(void)
+{
+	u8 *pool[EFI_ST_NUM_POOLS];
+	efi_uintn_t size;
+	efi_status_t ret;
+	int i, j;
+
+	for (i = 0; i < EFI_ST_NUM_POOLS; i++) {
+		size = 1 + i * 97;
+		ret = boottime->allocate_pool(EFI_LOADER_DATA, size,
+					      (void **)&pool[i]);
+		if (ret != EFI_SUCCESS) {
+			efi_st_error("AllocatePool did not return EFI_SUCCESS\n");
+			return EFI_ST_FAILURE;
+		}
+		if ((uintptr_t)pool[i] & 7) {
+			efi_st_error("AllocatePool returned unaligned memory\n");
+			return EFI_ST_FAILURE;
+		}
+		boottime->set_mem(pool[i], size, i);
+	}
+	for (i = 0; i < EFI_ST_NUM_POOLS; i++) {
+		size = 1 + i * 97;
+		for (j = 0; j < size; j++) {
+			if (pool[i][j] != i) {
+				efi_st_error("Pools overlap\n");
+				return EFI_ST_FAILURE;
+			}
+		}
+	}
+	for (i = 0; i < EFI_ST_NUM_POOLS; i++) {
+		ret = boottime->free_pool(pool[i]);
+		if (ret != EFI_SUCCESS) {
+			efi_st_error("FreePool did not return EFI_SUCCESS\n");
+			return EFI_ST_FAILURE;
+		}
+	}
+
+	return EFI_ST_SUCCESS;
+}
+
 /*
  * execute() - execute unit test
  *
@@ -167,11 +217,6 @@ static int execute(void)
 		efi_st_error("FreePages did not return EFI_SUCCESS\n");
 		return EFI_ST_FAILURE;
 	}
-	ret = boottime->free_pool(memory_map);
-	if (ret != EFI_SUCCESS) {
-		efi_st_error("FreePool did not return EFI_SUCCESS\n");
-		return EFI_ST_FAILURE;
-	}
 
 	/* Check memory reservation for the device tree */
 	if (fdt_addr &&
@@ -181,7 +226,15 @@ static int execute(void)
 			("Device tree not marked as ACPI reclaim memory\n");
 		return EFI_ST_FAILURE;
 	}
-	return EFI_ST_SUCCESS;
+
+	/* Free the memory map only once it is no longer used */
+	ret = boottime->free_pool(memory_map);
+	if (ret != EFI_SUCCESS) {
+		efi_st_error("FreePool did not return EFI_SUCCESS\n");
+		return EFI_ST_FAILURE;
+	}
+
+	return test_pool();
 }
 
 EFI_UNIT_TEST(memory) = {
@@ -0,0 +1,389 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Cache of libfdt path and compatible-string lookups
+ *
+ * Each blob has a small table of paths and their node offsets, and a list of
+ * the offsets of all the nodes with each compatible string looked up. Writing
+ * a property moves the offsets of the nodes after it, so the libfdt wrappers
+ * report the change in size and the cached offsets are adjusted. Adding,
+ * removing or renaming nodes drops everything cached for the blob.
+ */
+
+#include <fdt_cache.h>
+#include <malloc.h>
+#include <asm/global_data.h>
+#include <linux/libfdt.h>
+#include <linux/string.h>
+
+DECLARE_GLOBAL_DATA_PTR;
+
+/* Number of blobs cached, e.g. U-Boot's own and the one passed to the OS */
+#define FDT_CACHE_BLOBS		2
+
+/* Number of paths cached for each blob, as a power of two */
+#define FDT_CACHE_PATHS		32
+
+/* Longest path cached */
+#define FDT_CACHE_PATH_LEN	48
+
+/* Number of compatible strings cached for each blob */
+#define FDT_CACHE_COMPATS	16
+
+/**
+ * struct fdt_cache_path - A path and the node it refers to
+ *
+ * @offset: Node offset, or -FDT_ERR_NOTFOUND if the node does not exist
+ * @len: Length of @path, 0 if this entry is not in use
+ * @path: Path, not nul-terminated
+ */
+struct fdt_cache_path {
+	int offset;
+	int len;
+	char path[FDT_CACHE_PATH_LEN];
+};
+
+/**
+ * struct fdt_cache_compat - Nodes with a compatible string
+ *
+ * @compat: Compatible string (allocated), NULL if this entry is not in use
+ * @offsets: Offsets of the nodes, in order
+ * @count: Number of entries in @offsets
+ */
+struct fdt_cache_compat {
+	char *compat;
+	int *offsets;
+	int count;
+};
+
+/**
+ * struct fdt_cache_blob - Everything cached for a blob
+ *
+ * @fdt: Blob this belongs to
+ * @valid: true if @totalsize and @size_struct have been set for the blob
+ * @totalsize: Total size of the blob, used to spot a new blob at @fdt
+ * @size_struct: Size of the structure block, which any change to the nodes
+ *	or properties not reported to the cache is very likely to change
+ * @paths: Paths looked up, indexed by a hash of the path
+ * @compats: Compatible strings looked up
+ * @next_compat: Next entry in @compats to replace
+ */
+struct fdt_cache_blob {
+	const void *fdt;
+	bool valid;
+	u32 totalsize;
+	u32 size_struct;
+	struct fdt_cache_path paths[FDT_CACHE_PATHS];
+	struct fdt_cache_compat compats[FDT_CACHE_COMPATS];
+	int next_compat;
+};
+
+/* Only allocated once full malloc() is ready, so after relocation */
+static struct fdt_cache_blob *fdt_cache[FDT_CACHE_BLOBS];
+static int fdt_cache_next;
+
+static void fdt_cache_drop_compats(struct fdt_cache_blob *blob)
+{
+	int i;
+
+	for (i = 0; i < FDT_CACHE_COMPATS; i++) {
+		struct fdt_cache_compat *entry = &blob->compats[i];
+
+		free(entry->compat);
+		free(entry->offsets);
+		memset(entry, '\0', sizeof(*entry));
+	}
+}
+
+static void fdt_cache_reset(struct fdt_cache_blob *blob)
+{
+	fdt_cache_drop_compats(blob);
+	memset(blob->paths, '\0', sizeof(blob->paths));
+	blob->valid = false;
+}
+
+static struct fdt_cache_blob *fdt_cache_slot(const void *fdt)
+{
+	int i;
+
+	for (i = 0; i < FDT_CACHE_BLOBS; i++) {
+		if (fdt_cache[i] && fdt_cache[i]->fdt == fdt)
+			return fdt_cache[i];
+	}
+
+	return NULL;
+}
+
+/**
+ * fdt_cache_find() - Find the cache for a blob
+ *
+ * If the blob's header shows that it has changed, everything cached for it is
+ * dropped
+ *
+ * @fdt: Devicetree blob
+ * @create: true to set up a cache for the blob if there is none
+ * Return: cache, or NULL if none
+ */
+static struct fdt_cache_blob *fdt_cache_find(const void *fdt, bool create)
+{
+	struct fdt_cache_blob *blob = fdt_cache_slot(fdt);
+
+	if (blob) {
+		if (blob->valid && fdt_magic(fdt) == FDT_MAGIC &&
+		    fdt_totalsize(fdt) == blob->totalsize &&
+		    fdt_size_dt_struct(fdt) == blob->size_struct)
+			return blob;
+		fdt_cache_reset(blob);
+	} else if (create && (gd->flags & GD_FLG_FULL_MALLOC_INIT)) {
+		int i = fdt_cache_next;
+
+		fdt_cache_next = (i + 1) % FDT_CACHE_BLOBS;
+		blob = fdt_cache[i];
+		if (blob) {
+			fdt_cache_reset(blob);
+		} else {
+			blob = calloc(1, sizeof(*blob));
+			if (!blob)
+				return NULL;
+			fdt_cache[i] = blob;
+		}
+		blob->fdt = fdt;
+	}
+	if (!blob || !create || fdt_check_header(fdt))
+		return NULL;
+	blob->totalsize = fdt_totalsize(fdt);
+	blob->size_struct = fdt_size_dt_struct(fdt);
+	blob->valid = true;
+
+	return blob;
+}
+
+static struct fdt_cache_path *fdt_cache_path_entry(struct fdt_cache_blob *blob,
+						   const char *path,
+						   int namelen)
+{
+	uint hash = 0;
+	int i;
+
+	for (i = 0; i < namelen; i++)
+		hash = hash * 31 + path[i];
+
+	return &blob->paths[hash & (FDT_CACHE_PATHS - 1)];
+}
+
+/**
+ * fdt_cache_check_name() - Check that a node has the name at the end of a path
+ *
+ * This matches names the same way as fdt_subnode_offset_namelen(), so that a
+ * path without a unit address matches a node with one
+ *
+ * @fdt: Devicetree blob
+ * @offset: Node offset
+ * @path: Path to the node
+ * @namelen: Length of @path
+ * Return: true if the name matches
+ */
+static bool fdt_cache_check_name(const void *fdt, int offset, const char *path,
+				 int namelen)
+{
+	const char *comp, *name;
+	int len, complen;
+
+	while (namelen && path[namelen - 1] == '/')
+		namelen--;
+	if (!namelen)
+		return !offset;
+	comp = path + namelen;
+	while (comp[-1] != '/')
+		comp--;
+	complen = path + namelen - comp;
+
+	name = fdt_get_name(fdt, offset, &len);
+	if (!name || len < complen || memcmp(name, comp, complen))
+		return false;
+
+	return len == complen ||
+		(name[complen] == '@' && !memchr(comp, '@', complen));
+}
+
+int fdt_cache_get_path(const void *fdt, const char *path, int namelen,
+		       int *offsetp)
+{
+	struct fdt_cache_path *entry;
+	struct fdt_cache_blob *blob;
+
+	if (namelen > FDT_CACHE_PATH_LEN)
+		return -ENOENT;
+	blob = fdt_cache_find(fdt, false);
+	if (!blob)
+		return -ENOENT;
+	entry = fdt_cache_path_entry(blob, path, namelen);
+	if (entry->len != namelen || memcmp(entry->path, path, namelen))
+		return -ENOENT;
+	if (entry->offset >= 0 &&
+	    !fdt_cache_check_name(fdt, entry->offset, path, namelen)) {
+		fdt_cache_reset(blob);
+		return -ENOENT;
+	}
+	*offsetp = entry->offset;
+
+	return 0;
+}
+
+void fdt_cache_set_path(const void *fdt, const char *path, int namelen,
+			int offset)
+{
+	struct fdt_cache_path *entry;
+	struct fdt_cache_blob *blob;
+
+	if (!namelen || namelen > FDT_CACHE_PATH_LEN ||
+	    (offset < 0 && offset != -FDT_ERR_NOTFOUND))
+		return;
+	blob = fdt_cache_find(fdt, true);
+	if (!blob)
+		return;
+	entry = fdt_cache_path_entry(blob, path, namelen);
+	entry->offset = offset;
+	entry->len = namelen;
+	memcpy(entry->path, path, namelen);
+}
+
+/**
+ * fdt_cache_scan_compat() - Find all the nodes with a compatible string
+ *
+ * @fdt: Devicetree blob
+ * @entry: Entry to fill in, with @entry->compat already set
+ * Return: 0 if OK, -ENOMEM if out of memory, -EINVAL if the blob is invalid
+ */
+static int fdt_cache_scan_compat(const void *fdt,
+				 struct fdt_cache_compat *entry)
+{
+	int offset, err, max = 0;
+
+	for (offset = fdt_next_node(fdt, -1, NULL);
+	     offset >= 0;
+	     offset = fdt_next_node(fdt, offset, NULL)) {
+		err = fdt_node_check_compatible(fdt, offset, entry->compat);
+		if (err < 0 && err != -FDT_ERR_NOTFOUND)
+			return -EINVAL;
+		if (err)
+			continue;
+		if (entry->count == max) {
+			int *offsets;
+
+			max = max ? max * 2 : 4;
+			offsets = realloc(entry->offsets,
+					  max * sizeof(*offsets));
+			if (!offsets)
+				return -ENOMEM;
+			entry->offsets = offsets;
+		}
+		entry->offsets[entry->count++] = offset;
+	}
+	if (offset != -FDT_ERR_NOTFOUND)
+		return -EINVAL;
+
+	return 0;
+}
+
+int fdt_cache_compat_offset(const void *fdt, int startoffset,
+			    const char *compat, int *offsetp)
+{
+	struct fdt_cache_compat *entry = NULL;
+	struct fdt_cache_blob *blob;
+	int i, lo, hi, ret;
+
+	blob = fdt_cache_find(fdt, true);
+	if (!blob)
+		return -ENOENT;
+	for (i = 0; i < FDT_CACHE_COMPATS; i++) {
+		if (blob->compats[i].compat &&
+		    !strcmp(blob->compats[i].compat, compat)) {
+			entry = &blob->compats[i];
+			break;
+		}
+	}
+	if (!entry) {
+		entry = &blob->compats[blob->next_compat];
+		blob->next_compat = (blob->next_compat + 1) % FDT_CACHE_COMPATS;
+		free(entry->compat);
+		free(entry->offsets);
+		memset(entry, '\0', sizeof(*entry));
+		entry->compat = strdup(compat);
+		if (!entry->compat)
+			return -ENOMEM;
+		ret = fdt_cache_scan_compat(fdt, entry);
+		if (ret) {
+			free(entry->compat);
+			free(entry->offsets);
+			memset(entry, '\0', sizeof(*entry));
+			return ret == -EINVAL ? -ENOENT : ret;
+		}
+	}
+
+	/* Find the first node after @startoffset */
+	lo = 0;
+	hi = entry->count;
+	while (lo < hi) {
+		int mid = (lo + hi) / 2;
+
+		if (entry->offsets[mid] > startoffset)
+			hi = mid;
+		else
+			lo = mid + 1;
+	}
+	if (lo == entry->count) {
+		*offsetp = -FDT_ERR_NOTFOUND;
+		return 0;
+	}
+	if (fdt_node_check_compatible(fdt, entry->offsets[lo], compat)) {
+		fdt_cache_reset(blob);
+		return -ENOENT;
+	}
+	*offsetp = entry->offsets[lo];
+
+	return 0;
+}
+
+void fdt_cache_prop_changed(const void *fdt, int nodeoffset, const char *name,
+			    int namelen, int delta)
+{
+	struct fdt_cache_blob *blob = fdt_cache_slot(fdt);
+	int i, j;
+
+	if (!blob || !blob->valid)
+		return;
+	if (fdt_size_dt_struct(fdt) != blob->size_struct + delta) {
+		fdt_cache_reset(blob);
+		return;
+	}
+	blob->size_struct += delta;
+	if (namelen == sizeof("compatible") - 1 &&
+	    !memcmp(name, "compatible", namelen))
+		fdt_cache_drop_compats(blob);
+	if (!delta)
+		return;
+
+	/* Nodes after this one have moved */
+	for (i = 0; i < FDT_CACHE_PATHS; i++) {
+		struct fdt_cache_path *entry = &blob->paths[i];
+
+		if (entry->len && entry->offset > nodeoffset)
+			entry->offset += delta;
+	}
+	for (i = 0; i < FDT_CACHE_COMPATS; i++) {
+		struct fdt_cache_compat *entry = &blob->compats[i];
+
+		for (j = 0; j < entry->count; j++) {
+			if (entry->offsets[j] > nodeoffset)
+				entry->offsets[j] += delta;
+		}
+	}
+}
+
+void fdt_cache_inval(const void *fdt)
+{
+	struct fdt_cache_blob *blob = fdt_cache_slot(fdt);
+
+	if (blob)
+		fdt_cache_reset(blob);
+}
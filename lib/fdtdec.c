@@ -636,6 +636,76 @@ int fdtdec_check_fdt(void)
 	return 0;
 }
 
+#if CONFIG_IS_ENABLED(OF_PHANDLE_CACHE)
+/* Number of cache entries, as a power of two; phandles are mostly small */
+#define FDT_PHANDLE_CACHE_SIZE	256
+
+struct fdt_phandle_cache {
+	const void *blob;
+	int offset;
+};
+
+/* Only used once full malloc() is ready, so after relocation */
+static struct fdt_phandle_cache *fdt_phandle_cache;
+
+int fdtdec_node_offset_by_phandle(const void *blob, uint32_t phandle)
+{
+	struct fdt_phandle_cache *cache, *entry;
+	int offset, found = -1;
+
+	if (!(gd->flags & GD_FLG_FULL_MALLOC_INIT) || !phandle ||
+	    phandle == ~0U)
+		return fdt_node_offset_by_phandle(blob, phandle);
+
+	cache = fdt_phandle_cache;
+	if (!cache) {
+		cache = calloc(FDT_PHANDLE_CACHE_SIZE, sizeof(*cache));
+		if (!cache)
+			return fdt_node_offset_by_phandle(blob, phandle);
+		fdt_phandle_cache = cache;
+	}
+
+	/*
+	 * The blob may have changed since the entry was added, so check that
+	 * the offset is still in range and still has the phandle
+	 */
+	entry = &cache[phandle & (FDT_PHANDLE_CACHE_SIZE - 1)];
+	if (entry->blob == blob &&
+	    entry->offset < fdt_size_dt_struct(blob) &&
+	    fdt_get_phandle(blob, entry->offset) == phandle)
+		return entry->offset;
+
+	/* Search as libfdt does, recording every phandle on the way */
+	for (offset = fdt_next_node(blob, -1, NULL);
+	     offset >= 0;
+	     offset = fdt_next_node(blob, offset, NULL)) {
+		uint32_t this = fdt_get_phandle(blob, offset);
+
+		if (!this || (this == phandle && found >= 0))
+			continue;
+		entry = &cache[this & (FDT_PHANDLE_CACHE_SIZE - 1)];
+		entry->blob = blob;
+		entry->offset = offset;
+		if (this == phandle)
+			found = offset;
+	}
+	if (found >= 0) {
+		/* Another phandle may have taken the entry since */
+		entry = &cache[phandle & (FDT_PHANDLE_CACHE_SIZE - 1)];
+		entry->blob = blob;
+		entry->offset = found;
+		return found;
+	}
+
+	return offset;
+}
+#else
+int fdtdec_node_offset_by_phandle(const void *blob, uint32_t phandle)
+{
+	return fdt_node_offset_by_phandle(blob, phandle);
+}
+#endif
+
 int fdtdec_lookup_phandle(const void *blob, int node, const char *prop_name)
 {
 	const u32 *phandle;
@@ -646,7 +716,7 @@ int fdtdec_lookup_phandle(const void *blob, int node, const char *prop_name)
 	if (!phandle)
 		return -FDT_ERR_NOTFOUND;
 
-	lookup = fdt_node_offset_by_phandle(blob, fdt32_to_cpu(*phandle));
+	lookup = fdtdec_node_offset_by_phandle(blob, fdt32_to_cpu(*phandle));
 	return lookup;
 }
 
@@ -777,8 +847,8 @@ int fdtdec_parse_phandle_with_args(const void *blob, int src_node,
 			 * below.
 			 */
 			if (cells_name || cur_index == index) {
-				node = fdt_node_offset_by_phandle(blob,
-								  phandle);
+				node = fdtdec_node_offset_by_phandle(blob,
+								     phandle);
 				if (node < 0) {
 					debug("%s: could not find phandle\n",
 					      fdt_get_name(blob, src_node,
@@ -1500,7 +1570,7 @@ int fdtdec_get_carveout(const void *blob, const char *node,
 
 	phandle = fdt32_to_cpu(prop[index]);
 
-	offset = fdt_node_offset_by_phandle(blob, phandle);
+	offset = fdtdec_node_offset_by_phandle(blob, phandle);
 	if (offset < 0) {
 		debug("failed to find node for phandle %u\n", phandle);
 		return offset;
@@ -81,6 +81,71 @@ int gunzip(void *dst, int dstlen, unsigned char *src, unsigned long *lenp)
 	return zunzip(dst, dstlen, src, lenp, 1, offset);
 }
 
+int gunzip_read(void *dst, ulong dstlen, struct image_reader *rd,
+		ulong *lenp)
+{
+	ulong len = 0;
+	z_stream s;
+	u8 *buf;
+	long ret;
+	int r;
+
+	*lenp = 0;
+	buf = malloc(IMAGE_READ_CHUNK);
+	if (!buf)
+		return -ENOMEM;
+
+	ret = image_reader_fill(rd, buf, IMAGE_READ_CHUNK, 0, &len);
+	if (ret >= 0) {
+		ret = gzip_parse_header(buf, len);
+		if (ret < 0)
+			ret = -EINVAL;
+	}
+	if (ret < 0)
+		goto err;
+
+	s.zalloc = gzalloc;
+	s.zfree = gzfree;
+	r = inflateInit2(&s, -MAX_WBITS);
+	if (r != Z_OK) {
+		ret = -ENOMEM;
+		goto err;
+	}
+	s.next_in = buf + ret;
+	s.avail_in = len - ret;
+	s.next_out = dst;
+	s.avail_out = dstlen;
+	do {
+		if (!s.avail_in) {
+			ret = image_reader_fill(rd, buf, IMAGE_READ_CHUNK, len,
+						&len);
+			if (ret <= 0) {
+				/* the image stopped short */
+				if (!ret)
+					ret = -EINVAL;
+				break;
+			}
+			s.next_in = buf;
+			s.avail_in = len;
+		}
+		r = inflate(&s, Z_NO_FLUSH);
+		if (r == Z_STREAM_END) {
+			ret = 0;
+		} else if (r == Z_BUF_ERROR && !s.avail_out) {
+			ret = -ENOSPC;
+		} else if (r != Z_OK && r != Z_BUF_ERROR) {
+			printf("Error: inflate() returned %d\n", r);
+			ret = -EINVAL;
+		}
+	} while (r == Z_OK || (r == Z_BUF_ERROR && s.avail_out));
+	*lenp = s.next_out - (u8 *)dst;
+	inflateEnd(&s);
+err:
+	free(buf);
+
+	return ret;
+}
+
 #ifdef CONFIG_CMD_UNZIP
 __weak
 void gzwrite_progress_init(ulong expectedsize)
@@ -115,16 +180,96 @@ void gzwrite_progress_finish(int returnval,
 	}
 }
 
+/**
+ * struct gzwrite_buf - A buffer which inflate() fills and which is then written
+ *
+ * @data: Buffer, of the size passed to gzwrite()
+ * @blkcnt: Number of blocks being written from @data
+ * @req: Write request, while @busy is true
+ * @busy: true if @data is being written and must not be changed
+ */
+struct gzwrite_buf {
+	unsigned char *data;
+	lbaint_t blkcnt;
+#if CONFIG_IS_ENABLED(BLK)
+	struct blk_req req;
+#endif
+	bool busy;
+};
+
+/**
+ * gzwrite_submit() - Start writing a buffer
+ *
+ * With driver model the write is queued if the device supports it, so that
+ * the next buffer can be inflated while this one is written. Otherwise the
+ * write is done before returning.
+ *
+ * @dev: Block device to write to
+ * @buf: Buffer to write
+ * @start: First block to write
+ * @blkcnt: Number of blocks to write
+ * Return: 0 if OK, -EIO if the write was short, other -ve on error
+ */
+static int gzwrite_submit(struct blk_desc *dev, struct gzwrite_buf *buf,
+			  lbaint_t start, lbaint_t blkcnt)
+{
+#if CONFIG_IS_ENABLED(BLK)
+	int ret;
+
+	buf->blkcnt = blkcnt;
+	buf->req.start = start;
+	buf->req.blkcnt = blkcnt;
+	buf->req.buffer = buf->data;
+	while ((ret = blk_submit_write(dev->bdev, &buf->req)) == -EBUSY)
+		blk_poll(dev->bdev);
+	if (ret)
+		return ret;
+	buf->busy = true;
+
+	return 0;
+#else
+	buf->blkcnt = blkcnt;
+
+	return blk_dwrite(dev, start, blkcnt, buf->data) == blkcnt ? 0 : -EIO;
+#endif
+}
+
+/**
+ * gzwrite_wait() - Wait until a buffer has been written
+ *
+ * @dev: Block device being written
+ * @buf: Buffer to wait for
+ * Return: 0 if OK (or the buffer was not being written), -EIO if the write
+ * was short, other -ve on error
+ */
+static int gzwrite_wait(struct blk_desc *dev, struct gzwrite_buf *buf)
+{
+#if CONFIG_IS_ENABLED(BLK)
+	long ret;
+
+	if (!buf->busy)
+		return 0;
+	buf->busy = false;
+	ret = blk_wait(dev->bdev, &buf->req);
+	if (ret < 0)
+		return ret;
+	if (ret != buf->blkcnt)
+		return -EIO;
+#endif
+
+	return 0;
+}
+
 int gzwrite(unsigned char *src, int len,
 	    struct blk_desc *dev,
 	    unsigned long szwritebuf,
 	    ulong startoffs,
 	    ulong szexpected)
 {
-	int i, flags;
+	struct gzwrite_buf bufs[2] = {}, *buf;
+	int i, flags, ret, cur = 0;
 	z_stream s;
 	int r = 0;
-	unsigned char *writebuf;
 	unsigned crc = 0;
 	ulong totalfilled = 0;
 	lbaint_t blksperbuf, outblock;
@@ -204,7 +349,16 @@ int gzwrite(unsigned char *src, int len,
 
 	s.next_in = src + i;
 	s.avail_in = payload_size+8;
-	writebuf = (unsigned char *)malloc_cache_aligned(szwritebuf);
+
+	/* inflate into one buffer while the other is written */
+	for (i = 0; i < ARRAY_SIZE(bufs); i++) {
+		bufs[i].data = malloc_cache_aligned(szwritebuf);
+		if (!bufs[i].data) {
+			printf("%s: out of memory\n", __func__);
+			r = -1;
+			goto out;
+		}
+	}
 
 	/* decompress until deflate stream ends or end of file */
 	do {
@@ -216,12 +370,19 @@ int gzwrite(unsigned char *src, int len,
 
 		/* run inflate() on input until output buffer not full */
 		do {
-			unsigned long blocks_written;
 			int numfilled;
 			lbaint_t writeblocks;
 
+			buf = &bufs[cur];
+			ret = gzwrite_wait(dev, buf);
+			if (ret) {
+				printf("%s: write failed (err=%d)\n", __func__,
+				       ret);
+				r = -1;
+				goto out;
+			}
 			s.avail_out = szwritebuf;
-			s.next_out = writebuf;
+			s.next_out = buf->data;
 			r = inflate(&s, Z_SYNC_FLUSH);
 			if ((r != Z_OK) &&
 			    (r != Z_STREAM_END)) {
@@ -229,12 +390,12 @@ int gzwrite(unsigned char *src, int len,
 				goto out;
 			}
 			numfilled = szwritebuf - s.avail_out;
-			crc = crc32(crc, writebuf, numfilled);
+			crc = crc32(crc, buf->data, numfilled);
 			totalfilled += numfilled;
 			if (numfilled < szwritebuf) {
 				writeblocks = (numfilled+dev->blksz-1)
 						/ dev->blksz;
-				memset(writebuf+numfilled, 0,
+				memset(buf->data + numfilled, 0,
 				       dev->blksz-(numfilled%dev->blksz));
 			} else {
 				writeblocks = blksperbuf;
@@ -243,9 +404,15 @@ int gzwrite(unsigned char *src, int len,
 			gzwrite_progress(iteration++,
 					 totalfilled,
 					 szexpected);
-			blocks_written = blk_dwrite(dev, outblock,
-						    writeblocks, writebuf);
-			outblock += blocks_written;
+			ret = gzwrite_submit(dev, buf, outblock, writeblocks);
+			if (ret) {
+				printf("%s: write failed (err=%d)\n", __func__,
+				       ret);
+				r = -1;
+				goto out;
+			}
+			outblock += writeblocks;
+			cur = !cur;
 			if (ctrlc()) {
 				puts("abort\n");
 				goto out;
@@ -262,9 +429,17 @@ int gzwrite(unsigned char *src, int len,
 		r = 0;
 
 out:
+	for (i = 0; i < ARRAY_SIZE(bufs); i++) {
+		ret = gzwrite_wait(dev, &bufs[i]);
+		if (ret && !r) {
+			printf("%s: write failed (err=%d)\n", __func__, ret);
+			r = -1;
+		}
+	}
 	gzwrite_progress_finish(r, totalfilled, szexpected,
 				expected_crc, crc);
-	free(writebuf);
+	for (i = 0; i < ARRAY_SIZE(bufs); i++)
+		free(bufs[i].data);
 	inflateEnd(&s);
 
 	return r;
@@ -127,6 +127,112 @@ int hcreate_r(size_t nel, struct hsearch_data *htab)
 	return 1;
 }
 
+/*
+ * Hash a key with 32-bit FNV-1a. This spreads the short, similar names
+ * typically found in the environment (e.g. "bootcmd_mmc0", "bootcmd_mmc1")
+ * much better than a simple shift-and-add over the characters.
+ */
+static unsigned int hash_key(const char *key)
+{
+	unsigned int hval = 2166136261U;
+
+	while (*key) {
+		hval ^= (unsigned char)*key++;
+		hval *= 16777619U;
+	}
+
+	return hval;
+}
+
+/*
+ * First hash function: simply take the modulus but prevent zero, since
+ * index 0 is never used.
+ */
+static unsigned int hash_first(unsigned int hval, unsigned int size)
+{
+	hval %= size;
+
+	return hval ? hval : 1;
+}
+
+/*
+ * Move to the next slot to probe. The second hash function is as suggested
+ * in [Knuth]; because the size is prime this steps through all indices.
+ */
+static unsigned int hash_next(unsigned int idx, unsigned int hval,
+			      unsigned int size)
+{
+	unsigned int hval2 = 1 + hval % (size - 2);
+
+	if (idx <= hval2)
+		return size + idx - hval2;
+
+	return idx - hval2;
+}
+
+/*
+ * Grow the table to (at least) twice its size, rehashing all entries into
+ * the new table. Deleted slots are dropped along the way, so lookups which
+ * previously had to step over them get shorter as well.
+ *
+ * Entries move to a different slot, so pointers returned by earlier calls to
+ * hsearch_r() or hmatch_r() are invalid afterwards.
+ */
+static int hgrow_r(struct hsearch_data *htab)
+{
+	struct env_entry_node *table;
+	unsigned int size, i;
+
+	size = (htab->size * 2) | 1;
+	while (!isprime(size))
+		size += 2;
+
+	table = calloc(size + 1, sizeof(struct env_entry_node));
+	if (!table)
+		return -ENOMEM;
+
+	for (i = 1; i <= htab->size; i++) {
+		unsigned int hval, idx;
+
+		if (htab->table[i].used <= 0)
+			continue;
+		hval = hash_first(hash_key(htab->table[i].entry.key), size);
+		for (idx = hval; table[idx].used; )
+			idx = hash_next(idx, hval, size);
+		table[idx].used = hval;
+		table[idx].entry = htab->table[i].entry;
+	}
+	debug("hgrow: table %p size %d -> %d, filled %d\n", htab,
+	      htab->size, size, htab->filled);
+
+	free(htab->table);
+	htab->table = table;
+	htab->size = size;
+
+	return 0;
+}
+
+/*
+ * Free all entries but keep the table itself, so that it can be refilled
+ * without another allocation
+ */
+static void hclear_r(struct hsearch_data *htab)
+{
+	int i;
+
+	for (i = 1; i <= htab->size; ++i) {
+		if (htab->table[i].used > 0) {
+			struct env_entry *ep = &htab->table[i].entry;
+
+			free((void *)ep->key);
+			free(ep->data);
+		}
+	}
+	memset(htab->table, '\0',
+	       (htab->size + 1) * sizeof(struct env_entry_node));
+	htab->filled = 0;
+}
+
 
 /*
  * hdestroy()
@@ -169,9 +275,8 @@ void hdestroy_r(struct hsearch_data *htab)
 /*
  * This is the search function. It uses double hashing with open addressing.
  * The argument item.key has to be a pointer to an zero terminated, most
- * probably strings of chars. The function for generating a number of the
- * strings is simple but fast. It can be replaced by a more complex function
- * like ajw (see [Aho,Sethi,Ullman]) if the needs are shown.
+ * probably strings of chars. The number for the string is generated with
+ * FNV-1a, see hash_key().
  *
  * We use an trick to speed up the lookup. The table is created by hcreate
  * with one more element available. This enables us to use the index zero
@@ -197,6 +302,8 @@ void hdestroy_r(struct hsearch_data *htab)
  *   internal hash table, which is also guaranteed to be positive.
  *   This allows us direct access to the found hash table slot for
  *   example for functions like hdelete().
+ * - With CONFIG_ENV_GROW the table is enlarged when it becomes three
+ *   quarters full, instead of failing once every slot is in use.
  */
 
 int hmatch_r(const char *match, int last_idx, struct env_entry **retval,
@@ -284,27 +391,11 @@ int hsearch_r(struct env_entry item, enum env_action action,
 	      struct env_entry **retval, struct hsearch_data *htab, int flag)
 {
 	unsigned int hval;
-	unsigned int count;
-	unsigned int len = strlen(item.key);
 	unsigned int idx;
 	unsigned int first_deleted = 0;
 	int ret;
 
-	/* Compute an value for the given string. Perhaps use a better method. */
-	hval = len;
-	count = len;
-	while (count-- > 0) {
-		hval <<= 4;
-		hval += item.key[count];
-	}
-
-	/*
-	 * First hash function:
-	 * simply take the modul but prevent zero.
-	 */
-	hval %= htab->size;
-	if (hval == 0)
-		++hval;
+	hval = hash_first(hash_key(item.key), htab->size);
 
 	/* The first index tried. */
 	idx = hval;
@@ -314,8 +405,6 @@ int hsearch_r(struct env_entry item, enum env_action action,
 		 * Further action might be required according to the
 		 * action value.
 		 */
-		unsigned hval2;
-
 		if (htab->table[idx].used == USED_DELETED)
 			first_deleted = idx;
 
@@ -324,21 +413,8 @@ int hsearch_r(struct env_entry item, enum env_action action,
 		if (ret != -1)
 			return ret;
 
-		/*
-		 * Second hash function:
-		 * as suggested in [Knuth]
-		 */
-		hval2 = 1 + hval % (htab->size - 2);
-
 		do {
-			/*
-			 * Because SIZE is prime this guarantees to
-			 * step through all available indices.
-			 */
-			if (idx <= hval2)
-				idx = htab->size + idx - hval2;
-			else
-				idx -= hval2;
+			idx = hash_next(idx, hval, htab->size);
 
 			/*
 			 * If we visited all entries leave the loop
@@ -362,6 +438,20 @@ int hsearch_r(struct env_entry item, enum env_action action,
 
 	/* An empty bucket has been found. */
 	if (action == ENV_ENTER) {
+		/*
+		 * Keep the load factor below 3/4 if possible, so that probe
+		 * sequences stay short. The new table has no deleted slots, so
+		 * just take the first free one.
+		 */
+		if (CONFIG_IS_ENABLED(ENV_GROW) &&
+		    (htab->filled + 1) * 4 > htab->size * 3 &&
+		    !hgrow_r(htab)) {
+			hval = hash_first(hash_key(item.key), htab->size);
+			for (idx = hval; htab->table[idx].used; )
+				idx = hash_next(idx, hval, htab->size);
+			first_deleted = 0;
+		}
+
 		/*
 		 * If table is full and another entry should be
 		 * entered return with error.
@@ -789,12 +879,35 @@ static int drop_var_from_set(const char *name, int nvars, char * vars[])
  * '\0' and '\n' have really been tested.
  */
 
+/*
+ * Count the variables in an environment, for sizing the hash table. Escaped
+ * separators and comment lines are not taken into account, so this may
+ * overestimate slightly.
+ */
+static int hcount(const char *data, size_t size, const char sep)
+{
+	const char *p = data, *end = data + size;
+	int count = 0;
+
+	/* an empty variable (e.g. a double '\0') marks the end */
+	while (p < end && *p) {
+		while (p < end && *p && *p != sep)
+			++p;
+		if (p < end && *p == sep)
+			++p;
+		++count;
+	}
+
+	return count;
+}
+
 int himport_r(struct hsearch_data *htab,
 		const char *env, size_t size, const char sep, int flag,
 		int crlf_is_lf, int nvars, char * const vars[])
 {
 	char *data, *sp, *dp, *name, *value;
 	char *localvars[nvars];
+	int nent;
 	int i;
 
 	/* Test for correct arguments.  */
@@ -821,16 +934,9 @@ int himport_r(struct hsearch_data *htab,
 	flag |= H_NOCLEAR;
 #endif
 
-	if ((flag & H_NOCLEAR) == 0 && !nvars) {
-		/* Destroy old hash table if one exists */
-		debug("Destroy Hash Table: %p table = %p\n", htab,
-		       htab->table);
-		if (htab->table)
-			hdestroy_r(htab);
-	}
-
 	/*
-	 * Create new hash table (if needed).  The computation of the hash
+	 * Work out the size of the hash table (if one is needed).  The
+	 * computation of the hash
 	 * table size is based on heuristics: in a sample of some 70+
 	 * existing systems we found an average size of 39+ bytes per entry
 	 * in the environment (for the whole key=value pair). Assuming a
@@ -845,14 +951,37 @@ int himport_r(struct hsearch_data *htab,
 	 * On the other hand we need to add some more entries for free
 	 * space when importing very small buffers. Both boundaries can
 	 * be overwritten in the board config file if needed.
+	 *
+	 * When the table can grow, there is no need for a safety margin, so
+	 * size it for the variables actually present, plus room for
+	 * CONFIG_ENV_MIN_ENTRIES additions. That keeps the import itself from
+	 * ever needing to rehash.
 	 */
-
-	if (!htab->table) {
-		int nent = CONFIG_ENV_MIN_ENTRIES + size / 8;
-
+	if (CONFIG_IS_ENABLED(ENV_GROW)) {
+		nent = CONFIG_ENV_MIN_ENTRIES + hcount(data, size, sep) * 4 / 3;
+	} else {
+		nent = CONFIG_ENV_MIN_ENTRIES + size / 8;
 		if (nent > CONFIG_ENV_MAX_ENTRIES)
 			nent = CONFIG_ENV_MAX_ENTRIES;
+	}
 
+	if ((flag & H_NOCLEAR) == 0 && !nvars && htab->table) {
+		/*
+		 * Empty the old hash table, reusing it if it is big enough,
+		 * which it normally is when the environment is reloaded
+		 */
+		if (htab->size >= nent) {
+			debug("Clear Hash Table: %p table = %p\n", htab,
+			      htab->table);
+			hclear_r(htab);
+		} else {
+			debug("Destroy Hash Table: %p table = %p\n", htab,
+			      htab->table);
+			hdestroy_r(htab);
+		}
+	}
+
+	if (!htab->table) {
 		debug("Create Hash Table: N=%d\n", nent);
 
 		if (hcreate_r(nent, htab) == 0) {
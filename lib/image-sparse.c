@@ -106,41 +106,129 @@ write_fail:
 	return -1;
 }
 
-int write_sparse_image(struct sparse_storage *info,
-		       const char *part_name, void *data, char *response)
+static int write_sparse_fill(struct sparse_storage *info, lbaint_t *blkp,
+			     lbaint_t blkcnt, uint32_t fill_val,
+			     char *response)
 {
-	lbaint_t blk;
-	lbaint_t blkcnt;
+	int fill_buf_num_blks = CONFIG_IMAGE_SPARSE_FILLBUF_SIZE / info->blksz;
+	lbaint_t blk = *blkp;
 	lbaint_t blks;
-	uint64_t bytes_written = 0;
-	unsigned int chunk;
-	unsigned int offset;
-	uint64_t chunk_data_sz;
-	uint32_t *fill_buf = NULL;
-	uint32_t fill_val;
-	sparse_header_t *sparse_header;
-	chunk_header_t *chunk_header;
-	uint32_t total_blocks = 0;
-	int fill_buf_num_blks;
+	uint32_t *fill_buf;
 	int i;
 	int j;
 
-	fill_buf_num_blks = CONFIG_IMAGE_SPARSE_FILLBUF_SIZE / info->blksz;
-
-	/* Read and skip over sparse image header */
-	sparse_header = (sparse_header_t *)data;
+	if (!blkcnt)
+		return 0;
+	fill_buf = (uint32_t *)
+		   memalign(ARCH_DMA_MINALIGN,
+			    ROUNDUP(info->blksz * fill_buf_num_blks,
+				    ARCH_DMA_MINALIGN));
+	if (!fill_buf) {
+		info->mssg("Malloc failed for: CHUNK_TYPE_FILL", response);
+		return -ENOMEM;
+	}
 
-	data += sparse_header->file_hdr_sz;
-	if (sparse_header->file_hdr_sz > sizeof(sparse_header_t)) {
-		/*
-		 * Skip the remaining bytes in a header that is longer than
-		 * we expected.
-		 */
-		data += (sparse_header->file_hdr_sz - sizeof(sparse_header_t));
+	for (i = 0; i < (info->blksz * fill_buf_num_blks / sizeof(fill_val));
+	     i++)
+		fill_buf[i] = fill_val;
+
+	for (i = 0; i < blkcnt;) {
+		j = blkcnt - i;
+		if (j > fill_buf_num_blks)
+			j = fill_buf_num_blks;
+		blks = info->write(info, blk, j, fill_buf);
+		/* blks might be > j (eg. NAND bad-blocks) */
+		if (blks < j) {
+			printf("%s: %s " LBAFU " [%d]\n", __func__,
+			       "Write failed, block #", blk, j);
+			info->mssg("flash write failure", response);
+			free(fill_buf);
+			return -EIO;
+		}
+		blk += blks;
+		i += j;
 	}
+	free(fill_buf);
+	*blkp = blk;
+
+	return 0;
+}
+
+/**
+ * sparse_discard() - Discard the aligned part of a range of blocks
+ *
+ * @info: Storage
+ * @blk: First block of the range
+ * @blkcnt: Number of blocks in the range
+ * @headp: Returns the number of blocks before the part discarded
+ * Return: number of blocks discarded, 0 if none
+ */
+static lbaint_t sparse_discard(struct sparse_storage *info, lbaint_t blk,
+			       lbaint_t blkcnt, lbaint_t *headp)
+{
+	u32 align = max(info->discard_align, 1U);
+	lbaint_t head, count;
+	u32 rem;
+
+	if (!IS_ENABLED(CONFIG_IMAGE_SPARSE_DISCARD) || !info->discard)
+		return 0;
+
+	div_u64_rem(blk, align, &rem);
+	head = rem ? align - rem : 0;
+	if (head >= blkcnt)
+		return 0;
+	div_u64_rem(blkcnt - head, align, &rem);
+	count = blkcnt - head - rem;
+	if (!count || info->discard(info, blk + head, count) != count)
+		return 0;
+	*headp = head;
+
+	return count;
+}
+
+static int write_sparse_chunk_fill(struct sparse_storage *info, lbaint_t *blkp,
+				   lbaint_t blkcnt, uint32_t fill_val,
+				   char *response)
+{
+	lbaint_t blk = *blkp;
+	lbaint_t head, count;
+	int ret;
+
+	count = fill_val ? 0 : sparse_discard(info, blk, blkcnt, &head);
+	if (!count)
+		return write_sparse_fill(info, blkp, blkcnt, fill_val, response);
+
+	/* Only the unaligned ends still need writing */
+	ret = write_sparse_fill(info, &blk, head, 0, response);
+	if (ret)
+		return ret;
+	blk += count;
+	ret = write_sparse_fill(info, &blk, blkcnt - head - count, 0, response);
+	if (ret)
+		return ret;
+	*blkp = blk;
+
+	return 0;
+}
 
+void sparse_stream_init(struct sparse_stream *ss, struct sparse_storage *info)
+{
+	memset(ss, '\0', sizeof(*ss));
+	ss->info = info;
+	ss->state = SPARSE_STREAM_HEADER;
 	if (!info->mssg)
 		info->mssg = default_log;
+}
+
+/* Read and check the sparse image header */
+static int sparse_stream_header(struct sparse_stream *ss, const void *data,
+				char *response)
+{
+	struct sparse_storage *info = ss->info;
+	sparse_header_t *sparse_header = &ss->header;
+	unsigned int offset;
+
+	memcpy(sparse_header, data, sizeof(*sparse_header));
 
 	debug("=== Sparse Image Header ===\n");
 	debug("magic: 0x%x\n", sparse_header->magic);
@@ -152,167 +240,225 @@ int write_sparse_image(struct sparse_storage *info,
 	debug("total_blks: %d\n", sparse_header->total_blks);
 	debug("total_chunks: %d\n", sparse_header->total_chunks);
 
+	if (sparse_header->file_hdr_sz < sizeof(sparse_header_t) ||
+	    sparse_header->chunk_hdr_sz < sizeof(chunk_header_t)) {
+		info->mssg("sparse image header size issue", response);
+		return -EINVAL;
+	}
+
 	/*
 	 * Verify that the sparse block size is a multiple of our
 	 * storage backend block size
 	 */
 	div_u64_rem(sparse_header->blk_sz, info->blksz, &offset);
-	if (offset) {
+	if (offset || !sparse_header->blk_sz) {
 		printf("%s: Sparse image block size issue [%u]\n",
 		       __func__, sparse_header->blk_sz);
 		info->mssg("sparse image block size issue", response);
-		return -1;
+		return -EINVAL;
 	}
 
 	puts("Flashing Sparse Image\n");
+	ss->blk = info->start;
 
-	/* Start processing chunks */
-	blk = info->start;
-	for (chunk = 0; chunk < sparse_header->total_chunks; chunk++) {
-		/* Read and skip over chunk header */
-		chunk_header = (chunk_header_t *)data;
-		data += sizeof(chunk_header_t);
-
-		if (chunk_header->chunk_type != CHUNK_TYPE_RAW) {
-			debug("=== Chunk Header ===\n");
-			debug("chunk_type: 0x%x\n", chunk_header->chunk_type);
-			debug("chunk_data_sz: 0x%x\n", chunk_header->chunk_sz);
-			debug("total_size: 0x%x\n", chunk_header->total_sz);
-		}
-
-		if (sparse_header->chunk_hdr_sz > sizeof(chunk_header_t)) {
-			/*
-			 * Skip the remaining bytes in a header that is longer
-			 * than we expected.
-			 */
-			data += (sparse_header->chunk_hdr_sz -
-				 sizeof(chunk_header_t));
-		}
-
-		chunk_data_sz = ((u64)sparse_header->blk_sz) * chunk_header->chunk_sz;
-		blkcnt = DIV_ROUND_UP_ULL(chunk_data_sz, info->blksz);
-		switch (chunk_header->chunk_type) {
-		case CHUNK_TYPE_RAW:
-			if (chunk_header->total_sz !=
-			    (sparse_header->chunk_hdr_sz + chunk_data_sz)) {
-				info->mssg("Bogus chunk size for chunk type Raw",
-					   response);
-				return -1;
-			}
+	return 0;
+}
 
-			if (blk + blkcnt > info->start + info->size) {
-				printf(
-				    "%s: Request would exceed partition size!\n",
-				    __func__);
-				info->mssg("Request would exceed partition size!",
-					   response);
-				return -1;
-			}
+/*
+ * Process a chunk header and, except for raw data, the chunk data, which must
+ * all be present
+ */
+static int sparse_stream_chunk(struct sparse_stream *ss,
+			       chunk_header_t *chunk_header, const void *data,
+			       char *response)
+{
+	struct sparse_storage *info = ss->info;
+	sparse_header_t *sparse_header = &ss->header;
+	uint64_t chunk_data_sz;
+	lbaint_t blkcnt, head;
+	int ret;
+
+	if (chunk_header->chunk_type != CHUNK_TYPE_RAW) {
+		debug("=== Chunk Header ===\n");
+		debug("chunk_type: 0x%x\n", chunk_header->chunk_type);
+		debug("chunk_data_sz: 0x%x\n", chunk_header->chunk_sz);
+		debug("total_size: 0x%x\n", chunk_header->total_sz);
+	}
 
-			blks = write_sparse_chunk_raw(info, blk, blkcnt,
-						      data, response);
-			if (IS_ERR_VALUE(blks))
-				return -1;
+	chunk_data_sz = ((u64)sparse_header->blk_sz) * chunk_header->chunk_sz;
+	blkcnt = DIV_ROUND_UP_ULL(chunk_data_sz, info->blksz);
+	switch (chunk_header->chunk_type) {
+	case CHUNK_TYPE_RAW:
+		if (chunk_header->total_sz !=
+		    (sparse_header->chunk_hdr_sz + chunk_data_sz)) {
+			info->mssg("Bogus chunk size for chunk type Raw",
+				   response);
+			return -EINVAL;
+		}
+		break;
+	case CHUNK_TYPE_FILL:
+		if (chunk_header->total_sz !=
+		    (sparse_header->chunk_hdr_sz + sizeof(uint32_t))) {
+			info->mssg("Bogus chunk size for chunk type FILL",
+				   response);
+			return -EINVAL;
+		}
+		break;
+	case CHUNK_TYPE_DONT_CARE:
+		if (ss->blk + blkcnt <= info->start + info->size)
+			sparse_discard(info, ss->blk, blkcnt, &head);
+		ss->blk += info->reserve(info, ss->blk, blkcnt);
+		ss->total_blocks += chunk_header->chunk_sz;
+		return 0;
+	case CHUNK_TYPE_CRC32:
+		if (chunk_header->total_sz !=
+		    sparse_header->chunk_hdr_sz + sizeof(uint32_t)) {
+			info->mssg("Bogus chunk size for chunk type CRC32",
+				   response);
+			return -EINVAL;
+		}
+		ss->total_blocks += chunk_header->chunk_sz;
+		return 0;
+	default:
+		printf("%s: Unknown chunk type: %x\n", __func__,
+		       chunk_header->chunk_type);
+		info->mssg("Unknown chunk type", response);
+		return -EINVAL;
+	}
 
-			blk += blks;
-			bytes_written += ((u64)blkcnt) * info->blksz;
-			total_blocks += chunk_header->chunk_sz;
-			data += chunk_data_sz;
-			break;
+	if (ss->blk + blkcnt > info->start + info->size) {
+		printf("%s: Request would exceed partition size!\n", __func__);
+		info->mssg("Request would exceed partition size!", response);
+		return -EINVAL;
+	}
 
-		case CHUNK_TYPE_FILL:
-			if (chunk_header->total_sz !=
-			    (sparse_header->chunk_hdr_sz + sizeof(uint32_t))) {
-				info->mssg("Bogus chunk size for chunk type FILL", response);
-				return -1;
-			}
+	ss->bytes_written += ((u64)blkcnt) * info->blksz;
+	if (chunk_header->chunk_type == CHUNK_TYPE_RAW) {
+		ss->blkcnt = blkcnt;
+		ss->total_blocks += chunk_header->chunk_sz;
+		return 0;
+	}
 
-			fill_buf = (uint32_t *)
-				   memalign(ARCH_DMA_MINALIGN,
-					    ROUNDUP(
-						info->blksz * fill_buf_num_blks,
-						ARCH_DMA_MINALIGN));
-			if (!fill_buf) {
-				info->mssg("Malloc failed for: CHUNK_TYPE_FILL",
-					   response);
-				return -1;
-			}
+	ret = write_sparse_chunk_fill(info, &ss->blk, blkcnt,
+				      *(uint32_t *)data, response);
+	if (ret)
+		return ret;
+	ss->total_blocks += DIV_ROUND_UP_ULL(chunk_data_sz,
+					     sparse_header->blk_sz);
 
-			fill_val = *(uint32_t *)data;
-			data = (char *)data + sizeof(uint32_t);
-
-			for (i = 0;
-			     i < (info->blksz * fill_buf_num_blks /
-				  sizeof(fill_val));
-			     i++)
-				fill_buf[i] = fill_val;
-
-			if (blk + blkcnt > info->start + info->size) {
-				printf(
-				    "%s: Request would exceed partition size!\n",
-				    __func__);
-				info->mssg("Request would exceed partition size!",
-					   response);
-				return -1;
-			}
+	return 0;
+}
 
-			for (i = 0; i < blkcnt;) {
-				j = blkcnt - i;
-				if (j > fill_buf_num_blks)
-					j = fill_buf_num_blks;
-				blks = info->write(info, blk, j, fill_buf);
-				/* blks might be > j (eg. NAND bad-blocks) */
-				if (blks < j) {
-					printf("%s: %s " LBAFU " [%d]\n",
-					       __func__,
-					       "Write failed, block #",
-					       blk, j);
-					info->mssg("flash write failure",
-						   response);
-					free(fill_buf);
-					return -1;
-				}
-				blk += blks;
-				i += j;
+ssize_t sparse_stream_write(struct sparse_stream *ss, const void *data,
+			    size_t len, bool last, char *response)
+{
+	struct sparse_storage *info = ss->info;
+	sparse_header_t *sparse_header = &ss->header;
+	chunk_header_t chunk_header;
+	const void *start = data;
+	lbaint_t blks, n;
+	size_t size;
+	int ret;
+
+	while (ss->state != SPARSE_STREAM_DONE) {
+		switch (ss->state) {
+		case SPARSE_STREAM_HEADER:
+			if (len < sizeof(sparse_header_t))
+				goto out;
+			size = ((sparse_header_t *)data)->file_hdr_sz;
+			if (len < size)
+				goto out;
+			ret = sparse_stream_header(ss, data, response);
+			if (ret)
+				return ret;
+			break;
+		case SPARSE_STREAM_CHUNK:
+			size = sparse_header->chunk_hdr_sz;
+			if (len < size)
+				goto out;
+			memcpy(&chunk_header, data, sizeof(chunk_header));
+			/* The data of all but raw chunks is handled at once */
+			if (chunk_header.chunk_type != CHUNK_TYPE_RAW &&
+			    chunk_header.chunk_type != CHUNK_TYPE_DONT_CARE &&
+			    chunk_header.total_sz > size) {
+				size = chunk_header.total_sz;
+				if (len < size)
+					goto out;
 			}
-			bytes_written += ((u64)blkcnt) * info->blksz;
-			total_blocks += DIV_ROUND_UP_ULL(chunk_data_sz,
-							 sparse_header->blk_sz);
-			free(fill_buf);
+			ret = sparse_stream_chunk(ss, &chunk_header,
+						  data + sparse_header->chunk_hdr_sz,
+						  response);
+			if (ret)
+				return ret;
+			ss->chunk++;
 			break;
-
-		case CHUNK_TYPE_DONT_CARE:
-			blk += info->reserve(info, blk, blkcnt);
-			total_blocks += chunk_header->chunk_sz;
+		case SPARSE_STREAM_DATA:
+			n = min_t(lbaint_t, ss->blkcnt, len / info->blksz);
+			if (!n || (n < ss->blkcnt && !last &&
+				   n * info->blksz < ss->min_write))
+				goto out;
+			blks = write_sparse_chunk_raw(info, ss->blk, n,
+						      (void *)data, response);
+			if (IS_ERR_VALUE(blks))
+				return blks;
+			ss->blk += blks;
+			ss->blkcnt -= n;
+			size = n * info->blksz;
 			break;
-
-		case CHUNK_TYPE_CRC32:
-			if (chunk_header->total_sz !=
-			    sparse_header->chunk_hdr_sz + sizeof(uint32_t)) {
-				info->mssg("Bogus chunk size for chunk type CRC32",
-					   response);
-				return -1;
-			}
-			total_blocks += chunk_header->chunk_sz;
-			data += chunk_data_sz;
+		case SPARSE_STREAM_DONE:
+			size = 0;
 			break;
-
-		default:
-			printf("%s: Unknown chunk type: %x\n", __func__,
-			       chunk_header->chunk_type);
-			info->mssg("Unknown chunk type", response);
-			return -1;
 		}
+		data += size;
+		len -= size;
+
+		if (ss->blkcnt)
+			ss->state = SPARSE_STREAM_DATA;
+		else if (ss->chunk < sparse_header->total_chunks)
+			ss->state = SPARSE_STREAM_CHUNK;
+		else
+			ss->state = SPARSE_STREAM_DONE;
+	}
+out:
+	return data - start;
+}
+
+int sparse_stream_finish(struct sparse_stream *ss, const char *part_name,
+			 char *response)
+{
+	if (ss->state != SPARSE_STREAM_DONE) {
+		printf("%s: Sparse image is truncated (chunk %u of %u)\n",
+		       __func__, ss->chunk, ss->header.total_chunks);
+		ss->info->mssg("sparse image truncated", response);
+		return -EINVAL;
 	}
 
 	debug("Wrote %d blocks, expected to write %d blocks\n",
-	      total_blocks, sparse_header->total_blks);
-	printf("........ wrote %llu bytes to '%s'\n", bytes_written, part_name);
+	      ss->total_blocks, ss->header.total_blks);
+	printf("........ wrote %llu bytes to '%s'\n", ss->bytes_written,
+	       part_name);
 
-	if (total_blocks != sparse_header->total_blks) {
-		info->mssg("sparse image write failure", response);
-		return -1;
+	if (ss->total_blocks != ss->header.total_blks) {
+		ss->info->mssg("sparse image write failure", response);
+		return -EINVAL;
 	}
 
 	return 0;
 }
+
+int write_sparse_image(struct sparse_storage *info,
+		       const char *part_name, void *data, char *response)
+{
+	struct sparse_stream ss;
+	ssize_t ret;
+
+	/* The whole image is in memory, so there is no limit on its size */
+	sparse_stream_init(&ss, info);
+	ret = sparse_stream_write(&ss, data, SIZE_MAX, true, response);
+	if (ret < 0)
+		return -1;
+	if (sparse_stream_finish(&ss, part_name, response))
+		return -1;
+
+	return 0;
+}
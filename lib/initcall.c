@@ -3,6 +3,7 @@
  * Copyright (c) 2013 The Chromium OS Authors.
  */
 
+#include <bootstage.h>
 #include <efi.h>
 #include <initcall.h>
 #include <log.h>
@@ -50,6 +51,7 @@ static int initcall_is_event(init_fnc_t func)
 int initcall_run_list(const init_fnc_t init_sequence[])
 {
 	ulong reloc_ofs = calc_reloc_ofs();
+	struct bootstage_prof_mark mark;
 	const init_fnc_t *ptr;
 	enum event_t type;
 	init_fnc_t func;
@@ -70,7 +72,11 @@ int initcall_run_list(const init_fnc_t init_sequence[])
 			debug("initcall: %p\n", (char *)func - reloc_ofs);
 		}
 
+		bootstage_prof_start(&mark);
 		ret = type ? event_notify_null(type) : func();
+		bootstage_prof_end(&mark, BOOTSTAGE_PROF_INITCALL,
+				   type ? event_type_name(type) : NULL,
+				   (ulong)func - reloc_ofs);
 		if (ret)
 			break;
 	}
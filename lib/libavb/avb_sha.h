@@ -28,6 +28,22 @@ extern "C" {
 /* Block size in bytes of a SHA-512 digest. */
 #define AVB_SHA512_BLOCK_SIZE 128
 
+#ifdef CONFIG_LIBAVB_UBOOT_SHA
+#include <u-boot/sha256.h>
+#include <u-boot/sha512.h>
+
+/* Data structure used for SHA-256, using U-Boot's implementation. */
+typedef struct {
+  sha256_context ctx;
+  uint8_t buf[AVB_SHA256_DIGEST_SIZE]; /* Used for storing the final digest. */
+} AvbSHA256Ctx;
+
+/* Data structure used for SHA-512, using U-Boot's implementation. */
+typedef struct {
+  sha512_context ctx;
+  uint8_t buf[AVB_SHA512_DIGEST_SIZE]; /* Used for storing the final digest. */
+} AvbSHA512Ctx;
+#else
 /* Data structure used for SHA-256. */
 typedef struct {
   uint32_t h[8];
@@ -45,6 +61,7 @@ typedef struct {
   uint8_t block[2 * AVB_SHA512_BLOCK_SIZE];
   uint8_t buf[AVB_SHA512_DIGEST_SIZE]; /* Used for storing the final digest. */
 } AvbSHA512Ctx;
+#endif
 
 /* Initializes the SHA-256 context. */
 void avb_sha256_init(AvbSHA256Ctx* ctx);
@@ -0,0 +1,48 @@
+// SPDX-License-Identifier: MIT
+/*
+ * SHA-256 and SHA-512 for libavb, using U-Boot's implementation so that the
+ * architecture's SHA instructions are used where they are enabled
+ */
+
+#include "avb_sha.h"
+
+/* sha256_update() and sha512_update() take a 32-bit length */
+#define AVB_SHA_UPDATE_MAX 0x40000000
+
+void avb_sha256_init(AvbSHA256Ctx* ctx) {
+  sha256_starts(&ctx->ctx);
+}
+
+void avb_sha256_update(AvbSHA256Ctx* ctx, const uint8_t* data, size_t len) {
+  while (len) {
+    size_t now = len < AVB_SHA_UPDATE_MAX ? len : AVB_SHA_UPDATE_MAX;
+
+    sha256_update(&ctx->ctx, data, now);
+    data += now;
+    len -= now;
+  }
+}
+
+uint8_t* avb_sha256_final(AvbSHA256Ctx* ctx) {
+  sha256_finish(&ctx->ctx, ctx->buf);
+  return ctx->buf;
+}
+
+void avb_sha512_init(AvbSHA512Ctx* ctx) {
+  sha512_starts(&ctx->ctx);
+}
+
+void avb_sha512_update(AvbSHA512Ctx* ctx, const uint8_t* data, size_t len) {
+  while (len) {
+    size_t now = len < AVB_SHA_UPDATE_MAX ? len : AVB_SHA_UPDATE_MAX;
+
+    sha512_update(&ctx->ctx, data, now);
+    data += now;
+    len -= now;
+  }
+}
+
+uint8_t* avb_sha512_final(AvbSHA512Ctx* ctx) {
+  sha512_finish(&ctx->ctx, ctx->buf);
+  return ctx->buf;
+}
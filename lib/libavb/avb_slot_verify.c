@@ -57,12 +57,48 @@ static inline bool result_should_continue(AvbSlotVerifyResult result) {
   return false;
 }
 
+/* Number of bytes read at a time when hashing a partition as it is loaded. */
+#define AVB_LOAD_HASH_CHUNK_SIZE (1024 * 1024)
+
+/* Hash of a partition, calculated as it is loaded. */
+typedef struct {
+  bool is_sha512;
+  AvbSHA256Ctx sha256_ctx;
+  AvbSHA512Ctx sha512_ctx;
+  /* Number of bytes at the start of the partition to hash. */
+  size_t hash_size;
+} AvbLoadHashCtx;
+
+/* Adds |len| bytes of the partition, loaded at |offset|, to the hash. */
+static void load_hash_update(AvbLoadHashCtx* hash,
+                             const uint8_t* data,
+                             size_t offset,
+                             size_t len) {
+  if (hash == NULL || offset >= hash->hash_size) {
+    return;
+  }
+  if (len > hash->hash_size - offset) {
+    len = hash->hash_size - offset;
+  }
+  if (hash->is_sha512) {
+    avb_sha512_update(&hash->sha512_ctx, data, len);
+  } else {
+    avb_sha256_update(&hash->sha256_ctx, data, len);
+  }
+}
+
+/* Loads |image_size| bytes of a partition. If |hash| is not NULL the data is
+ * added to it as it is read, a chunk at a time, while it is still in the
+ * cache, rather than in a second pass over the whole image.
+ */
 static AvbSlotVerifyResult load_full_partition(AvbOps* ops,
                                                const char* part_name,
                                                uint64_t image_size,
                                                uint8_t** out_image_buf,
-                                               bool* out_image_preloaded) {
+                                               bool* out_image_preloaded,
+                                               AvbLoadHashCtx* hash) {
   size_t part_num_read;
+  size_t offset;
   AvbIOResult io_ret;
 
   /* Make sure that we do not overwrite existing data. */
@@ -93,6 +129,7 @@ static AvbSlotVerifyResult load_full_partition(AvbOps* ops,
         return AVB_SLOT_VERIFY_RESULT_ERROR_IO;
       }
       *out_image_preloaded = true;
+      load_hash_update(hash, *out_image_buf, 0, image_size);
     }
   }
 
@@ -103,21 +140,29 @@ static AvbSlotVerifyResult load_full_partition(AvbOps* ops,
       return AVB_SLOT_VERIFY_RESULT_ERROR_OOM;
     }
 
-    io_ret = ops->read_from_partition(ops,
-                                      part_name,
-                                      0 /* offset */,
-                                      image_size,
-                                      *out_image_buf,
-                                      &part_num_read);
-    if (io_ret == AVB_IO_RESULT_ERROR_OOM) {
-      return AVB_SLOT_VERIFY_RESULT_ERROR_OOM;
-    } else if (io_ret != AVB_IO_RESULT_OK) {
-      avb_errorv(part_name, ": Error loading data from partition.\n", NULL);
-      return AVB_SLOT_VERIFY_RESULT_ERROR_IO;
-    }
-    if (part_num_read != image_size) {
-      avb_errorv(part_name, ": Read incorrect number of bytes.\n", NULL);
-      return AVB_SLOT_VERIFY_RESULT_ERROR_IO;
+    for (offset = 0; offset < image_size; offset += part_num_read) {
+      size_t chunk_size = image_size - offset;
+
+      if (hash != NULL && chunk_size > AVB_LOAD_HASH_CHUNK_SIZE) {
+        chunk_size = AVB_LOAD_HASH_CHUNK_SIZE;
+      }
+      io_ret = ops->read_from_partition(ops,
+                                        part_name,
+                                        offset,
+                                        chunk_size,
+                                        *out_image_buf + offset,
+                                        &part_num_read);
+      if (io_ret == AVB_IO_RESULT_ERROR_OOM) {
+        return AVB_SLOT_VERIFY_RESULT_ERROR_OOM;
+      } else if (io_ret != AVB_IO_RESULT_OK) {
+        avb_errorv(part_name, ": Error loading data from partition.\n", NULL);
+        return AVB_SLOT_VERIFY_RESULT_ERROR_IO;
+      }
+      if (part_num_read != chunk_size) {
+        avb_errorv(part_name, ": Read incorrect number of bytes.\n", NULL);
+        return AVB_SLOT_VERIFY_RESULT_ERROR_IO;
+      }
+      load_hash_update(hash, *out_image_buf + offset, offset, chunk_size);
     }
   }
 
@@ -281,6 +326,7 @@ static AvbSlotVerifyResult load_and_verify_hash_partition(
   size_t expected_digest_len = 0;
   uint8_t expected_digest_buf[AVB_SHA512_DIGEST_SIZE];
   const uint8_t* expected_digest = NULL;
+  AvbLoadHashCtx hash;
 
   if (!avb_hash_descriptor_validate_and_byteswap(
           (const AvbHashDescriptor*)descriptor, &hash_desc)) {
@@ -363,40 +409,39 @@ static AvbSlotVerifyResult load_and_verify_hash_partition(
     avb_debugv(part_name, ": Loading entire partition.\n", NULL);
   }
 
-  ret = load_full_partition(
-      ops, part_name, image_size, &image_buf, &image_preloaded);
-  if (ret != AVB_SLOT_VERIFY_RESULT_OK) {
-    goto out;
-  }
-  // Although only one of the type might be used, we have to defined the
-  // structure here so that they would live outside the 'if/else' scope to be
-  // used later.
-  AvbSHA256Ctx sha256_ctx;
-  AvbSHA512Ctx sha512_ctx;
-  size_t image_size_to_hash = hash_desc.image_size;
   // If we allow verification error and the whole partition is smaller than
   // image size in hash descriptor, we just hash the whole partition.
-  if (image_size_to_hash > image_size) {
-    image_size_to_hash = image_size;
+  hash.hash_size = hash_desc.image_size;
+  if (hash.hash_size > image_size) {
+    hash.hash_size = image_size;
   }
   if (avb_strcmp((const char*)hash_desc.hash_algorithm, "sha256") == 0) {
-    avb_sha256_init(&sha256_ctx);
-    avb_sha256_update(&sha256_ctx, desc_salt, hash_desc.salt_len);
-    avb_sha256_update(&sha256_ctx, image_buf, image_size_to_hash);
-    digest = avb_sha256_final(&sha256_ctx);
-    digest_len = AVB_SHA256_DIGEST_SIZE;
+    hash.is_sha512 = false;
+    avb_sha256_init(&hash.sha256_ctx);
+    avb_sha256_update(&hash.sha256_ctx, desc_salt, hash_desc.salt_len);
   } else if (avb_strcmp((const char*)hash_desc.hash_algorithm, "sha512") == 0) {
-    avb_sha512_init(&sha512_ctx);
-    avb_sha512_update(&sha512_ctx, desc_salt, hash_desc.salt_len);
-    avb_sha512_update(&sha512_ctx, image_buf, image_size_to_hash);
-    digest = avb_sha512_final(&sha512_ctx);
-    digest_len = AVB_SHA512_DIGEST_SIZE;
+    hash.is_sha512 = true;
+    avb_sha512_init(&hash.sha512_ctx);
+    avb_sha512_update(&hash.sha512_ctx, desc_salt, hash_desc.salt_len);
   } else {
     avb_errorv(part_name, ": Unsupported hash algorithm.\n", NULL);
     ret = AVB_SLOT_VERIFY_RESULT_ERROR_INVALID_METADATA;
     goto out;
   }
 
+  ret = load_full_partition(
+      ops, part_name, image_size, &image_buf, &image_preloaded, &hash);
+  if (ret != AVB_SLOT_VERIFY_RESULT_OK) {
+    goto out;
+  }
+  if (hash.is_sha512) {
+    digest = avb_sha512_final(&hash.sha512_ctx);
+    digest_len = AVB_SHA512_DIGEST_SIZE;
+  } else {
+    digest = avb_sha256_final(&hash.sha256_ctx);
+    digest_len = AVB_SHA256_DIGEST_SIZE;
+  }
+
   if (hash_desc.digest_len == 0) {
     /* Expect a match to a persistent digest. */
     avb_debugv(part_name, ": No digest, using persistent digest.\n", NULL);
@@ -500,7 +545,7 @@ static AvbSlotVerifyResult load_requested_partitions(
     avb_debugv(part_name, ": Loading entire partition.\n", NULL);
 
     ret = load_full_partition(
-        ops, part_name, image_size, &image_buf, &image_preloaded);
+        ops, part_name, image_size, &image_buf, &image_preloaded, NULL);
     if (ret != AVB_SLOT_VERIFY_RESULT_OK) {
       goto out;
     }
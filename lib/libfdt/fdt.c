@@ -1,2 +1,24 @@
 #include <linux/libfdt_env.h>
+
+#if CONFIG_IS_ENABLED(OF_LIBFDT_CACHE)
+#include <fdt_cache.h>
+#include <linux/libfdt.h>
+
+/* Rename fdt_move() so that it can tell the cache about the new blob */
+#define fdt_move fdt_move_
+
+static int fdt_move_(const void *fdt, void *buf, int bufsize);
+#endif
+
 #include "../../scripts/dtc/libfdt/fdt.c"
+
+#if CONFIG_IS_ENABLED(OF_LIBFDT_CACHE)
+#undef fdt_move
+
+int fdt_move(const void *fdt, void *buf, int bufsize)
+{
+	fdt_cache_inval(buf);
+
+	return fdt_move_(fdt, buf, bufsize);
+}
+#endif
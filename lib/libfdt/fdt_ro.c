@@ -1,2 +1,57 @@
 #include <linux/libfdt_env.h>
+
+#if CONFIG_IS_ENABLED(OF_LIBFDT_CACHE)
+#include <fdt_cache.h>
+#include <linux/libfdt.h>
+
+/* Rename the libfdt lookups so that the cached versions can wrap them */
+#define fdt_path_offset_namelen fdt_path_offset_namelen_
+#define fdt_path_offset fdt_path_offset_
+#define fdt_node_offset_by_compatible fdt_node_offset_by_compatible_
+
+static int fdt_path_offset_namelen_(const void *fdt, const char *path,
+				    int namelen);
+static int fdt_path_offset_(const void *fdt, const char *path);
+static int fdt_node_offset_by_compatible_(const void *fdt, int startoffset,
+					  const char *compatible);
+#endif
+
 #include "../../scripts/dtc/libfdt/fdt_ro.c"
+
+#if CONFIG_IS_ENABLED(OF_LIBFDT_CACHE)
+#undef fdt_path_offset_namelen
+#undef fdt_path_offset
+#undef fdt_node_offset_by_compatible
+
+int fdt_path_offset_namelen(const void *fdt, const char *path, int namelen)
+{
+	int offset;
+
+	/* Aliases can change without the cache noticing */
+	if (namelen <= 0 || *path != '/')
+		return fdt_path_offset_namelen_(fdt, path, namelen);
+	if (!fdt_cache_get_path(fdt, path, namelen, &offset))
+		return offset;
+	offset = fdt_path_offset_namelen_(fdt, path, namelen);
+	fdt_cache_set_path(fdt, path, namelen, offset);
+
+	return offset;
+}
+
+int fdt_path_offset(const void *fdt, const char *path)
+{
+	return fdt_path_offset_namelen(fdt, path, strlen(path));
+}
+
+int fdt_node_offset_by_compatible(const void *fdt, int startoffset,
+				  const char *compatible)
+{
+	int offset;
+
+	if ((startoffset < 0 || fdt_check_node_offset_(fdt, startoffset) >= 0) &&
+	    !fdt_cache_compat_offset(fdt, startoffset, compatible, &offset))
+		return offset;
+
+	return fdt_node_offset_by_compatible_(fdt, startoffset, compatible);
+}
+#endif
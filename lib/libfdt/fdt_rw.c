@@ -1,2 +1,132 @@
 #include <linux/libfdt_env.h>
+
+#if CONFIG_IS_ENABLED(OF_LIBFDT_CACHE)
+#include <fdt_cache.h>
+#include <linux/libfdt.h>
+
+/* Rename the libfdt writers so that they can report changes to the cache */
+#define fdt_set_name fdt_set_name_
+#define fdt_setprop_placeholder fdt_setprop_placeholder_
+#define fdt_setprop fdt_setprop_
+#define fdt_appendprop fdt_appendprop_
+#define fdt_delprop fdt_delprop_
+#define fdt_add_subnode_namelen fdt_add_subnode_namelen_
+#define fdt_add_subnode fdt_add_subnode_
+#define fdt_del_node fdt_del_node_
+#define fdt_open_into fdt_open_into_
+
+static int fdt_set_name_(void *fdt, int nodeoffset, const char *name);
+static int fdt_setprop_placeholder_(void *fdt, int nodeoffset,
+				    const char *name, int len,
+				    void **prop_data);
+static int fdt_setprop_(void *fdt, int nodeoffset, const char *name,
+			const void *val, int len);
+static int fdt_appendprop_(void *fdt, int nodeoffset, const char *name,
+			   const void *val, int len);
+static int fdt_delprop_(void *fdt, int nodeoffset, const char *name);
+static int fdt_add_subnode_namelen_(void *fdt, int parentoffset,
+				    const char *name, int namelen);
+static int fdt_add_subnode_(void *fdt, int parentoffset, const char *name);
+static int fdt_del_node_(void *fdt, int nodeoffset);
+static int fdt_open_into_(const void *fdt, void *buf, int bufsize);
+#endif
+
 #include "../../scripts/dtc/libfdt/fdt_rw.c"
+
+#if CONFIG_IS_ENABLED(OF_LIBFDT_CACHE)
+#undef fdt_set_name
+#undef fdt_setprop_placeholder
+#undef fdt_setprop
+#undef fdt_appendprop
+#undef fdt_delprop
+#undef fdt_add_subnode_namelen
+#undef fdt_add_subnode
+#undef fdt_del_node
+#undef fdt_open_into
+
+/*
+ * Report a property write to the cache, given the size of the structure
+ * block before the write
+ */
+static int fdt_prop_changed(void *fdt, int nodeoffset, const char *name,
+			    int old_size, int ret)
+{
+	fdt_cache_prop_changed(fdt, nodeoffset, name, strlen(name),
+			       fdt_size_dt_struct(fdt) - old_size);
+
+	return ret;
+}
+
+int fdt_set_name(void *fdt, int nodeoffset, const char *name)
+{
+	fdt_cache_inval(fdt);
+
+	return fdt_set_name_(fdt, nodeoffset, name);
+}
+
+int fdt_setprop_placeholder(void *fdt, int nodeoffset, const char *name,
+			    int len, void **prop_data)
+{
+	int size = fdt_size_dt_struct(fdt);
+
+	return fdt_prop_changed(fdt, nodeoffset, name, size,
+				fdt_setprop_placeholder_(fdt, nodeoffset, name,
+							 len, prop_data));
+}
+
+int fdt_setprop(void *fdt, int nodeoffset, const char *name,
+		const void *val, int len)
+{
+	int size = fdt_size_dt_struct(fdt);
+
+	return fdt_prop_changed(fdt, nodeoffset, name, size,
+				fdt_setprop_(fdt, nodeoffset, name, val, len));
+}
+
+int fdt_appendprop(void *fdt, int nodeoffset, const char *name,
+		   const void *val, int len)
+{
+	int size = fdt_size_dt_struct(fdt);
+
+	return fdt_prop_changed(fdt, nodeoffset, name, size,
+				fdt_appendprop_(fdt, nodeoffset, name, val,
+						len));
+}
+
+int fdt_delprop(void *fdt, int nodeoffset, const char *name)
+{
+	int size = fdt_size_dt_struct(fdt);
+
+	return fdt_prop_changed(fdt, nodeoffset, name, size,
+				fdt_delprop_(fdt, nodeoffset, name));
+}
+
+int fdt_add_subnode_namelen(void *fdt, int parentoffset,
+			    const char *name, int namelen)
+{
+	fdt_cache_inval(fdt);
+
+	return fdt_add_subnode_namelen_(fdt, parentoffset, name, namelen);
+}
+
+int fdt_add_subnode(void *fdt, int parentoffset, const char *name)
+{
+	fdt_cache_inval(fdt);
+
+	return fdt_add_subnode_(fdt, parentoffset, name);
+}
+
+int fdt_del_node(void *fdt, int nodeoffset)
+{
+	fdt_cache_inval(fdt);
+
+	return fdt_del_node_(fdt, nodeoffset);
+}
+
+int fdt_open_into(const void *fdt, void *buf, int bufsize)
+{
+	fdt_cache_inval(buf);
+
+	return fdt_open_into_(fdt, buf, bufsize);
+}
+#endif
@@ -1,2 +1,63 @@
 #include <linux/libfdt_env.h>
+
+#if CONFIG_IS_ENABLED(OF_LIBFDT_CACHE)
+#include <fdt_cache.h>
+#include <linux/libfdt.h>
+
+/* Rename the libfdt writers so that they can report changes to the cache */
+#define fdt_setprop_inplace_namelen_partial fdt_setprop_inplace_namelen_partial_
+#define fdt_setprop_inplace fdt_setprop_inplace_
+#define fdt_nop_property fdt_nop_property_
+#define fdt_nop_node fdt_nop_node_
+
+static int fdt_setprop_inplace_namelen_partial_(void *fdt, int nodeoffset,
+						const char *name, int namelen,
+						uint32_t idx, const void *val,
+						int len);
+static int fdt_setprop_inplace_(void *fdt, int nodeoffset, const char *name,
+				const void *val, int len);
+static int fdt_nop_property_(void *fdt, int nodeoffset, const char *name);
+static int fdt_nop_node_(void *fdt, int nodeoffset);
+#endif
+
 #include "../../scripts/dtc/libfdt/fdt_wip.c"
+
+#if CONFIG_IS_ENABLED(OF_LIBFDT_CACHE)
+#undef fdt_setprop_inplace_namelen_partial
+#undef fdt_setprop_inplace
+#undef fdt_nop_property
+#undef fdt_nop_node
+
+int fdt_setprop_inplace_namelen_partial(void *fdt, int nodeoffset,
+					const char *name, int namelen,
+					uint32_t idx, const void *val,
+					int len)
+{
+	fdt_cache_prop_changed(fdt, nodeoffset, name, namelen, 0);
+
+	return fdt_setprop_inplace_namelen_partial_(fdt, nodeoffset, name,
+						    namelen, idx, val, len);
+}
+
+int fdt_setprop_inplace(void *fdt, int nodeoffset, const char *name,
+			const void *val, int len)
+{
+	fdt_cache_prop_changed(fdt, nodeoffset, name, strlen(name), 0);
+
+	return fdt_setprop_inplace_(fdt, nodeoffset, name, val, len);
+}
+
+int fdt_nop_property(void *fdt, int nodeoffset, const char *name)
+{
+	fdt_cache_prop_changed(fdt, nodeoffset, name, strlen(name), 0);
+
+	return fdt_nop_property_(fdt, nodeoffset, name);
+}
+
+int fdt_nop_node(void *fdt, int nodeoffset)
+{
+	fdt_cache_inval(fdt);
+
+	return fdt_nop_node_(fdt, nodeoffset);
+}
+#endif
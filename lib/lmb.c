@@ -15,6 +15,7 @@
 
 #include <asm/global_data.h>
 #include <asm/sections.h>
+#include <u-boot/crc.h>
 
 DECLARE_GLOBAL_DATA_PTR;
 
@@ -93,18 +94,84 @@ static long lmb_regions_adjacent(struct lmb_region *rgn, unsigned long r1,
 	return lmb_addrs_adjacent(base1, size1, base2, size2);
 }
 
-static void lmb_remove_region(struct lmb_region *rgn, unsigned long r)
+/**
+ * lmb_first_region() - Find the first region which ends at or after an address
+ *
+ * The regions are sorted and do not overlap, so their ends are sorted too
+ *
+ * @rgn: Regions to search
+ * @addr: Address to look for
+ * Return: index of the region, or rgn->cnt if all regions end before @addr
+ */
+static unsigned long lmb_first_region(struct lmb_region *rgn, phys_addr_t addr)
 {
-	unsigned long i;
+	unsigned long lo = 0, hi = rgn->cnt;
 
-	for (i = r; i < rgn->cnt - 1; i++) {
-		rgn->region[i].base = rgn->region[i + 1].base;
-		rgn->region[i].size = rgn->region[i + 1].size;
-		rgn->region[i].flags = rgn->region[i + 1].flags;
+	while (lo < hi) {
+		unsigned long mid = (lo + hi) / 2;
+		phys_addr_t end = rgn->region[mid].base +
+			rgn->region[mid].size - 1;
+
+		if (end < addr)
+			lo = mid + 1;
+		else
+			hi = mid;
 	}
+
+	return lo;
+}
+
+static void lmb_remove_region(struct lmb_region *rgn, unsigned long r)
+{
+	memmove(&rgn->region[r], &rgn->region[r + 1],
+		(rgn->cnt - r - 1) * sizeof(*rgn->region));
 	rgn->cnt--;
 }
 
+#if IS_ENABLED(CONFIG_LMB_GROW)
+/**
+ * lmb_grow_region() - Make room for more regions
+ *
+ * @rgn: Regions to grow
+ * Return: 0 if OK, -ENOMEM if out of memory
+ */
+static int lmb_grow_region(struct lmb_region *rgn)
+{
+	struct lmb_property *region;
+	unsigned long max = rgn->max * 2;
+
+	region = malloc(max * sizeof(*region));
+	if (!region)
+		return -ENOMEM;
+	memcpy(region, rgn->region, rgn->cnt * sizeof(*region));
+	if (rgn->alloced)
+		free(rgn->region);
+	rgn->region = region;
+	rgn->max = max;
+	rgn->alloced = true;
+
+	return 0;
+}
+
+static void lmb_uninit_region(struct lmb_region *rgn)
+{
+	if (rgn->alloced)
+		free(rgn->region);
+	rgn->alloced = false;
+}
+
+void lmb_uninit(struct lmb *lmb)
+{
+	lmb_uninit_region(&lmb->memory);
+	lmb_uninit_region(&lmb->reserved);
+}
+#else
+static int lmb_grow_region(struct lmb_region *rgn)
+{
+	return -ENOSPC;
+}
+#endif
+
 /* Assumption: base addr of region 1 < base addr of region 2 */
 static void lmb_coalesce_regions(struct lmb_region *rgn, unsigned long r1,
 				 unsigned long r2)
@@ -140,6 +207,8 @@ void lmb_init(struct lmb *lmb)
 	lmb->reserved.max = CONFIG_LMB_RESERVED_REGIONS;
 	lmb->memory.region = lmb->memory_regions;
 	lmb->reserved.region = lmb->reserved_regions;
+	lmb->memory.alloced = false;
+	lmb->reserved.alloced = false;
 #endif
 	lmb->memory.cnt = 0;
 	lmb->reserved.cnt = 0;
@@ -214,11 +283,9 @@ static __maybe_unused int efi_lmb_reserve(struct lmb *lmb)
 	return 0;
 }
 
-static void lmb_reserve_common(struct lmb *lmb, void *fdt_blob)
+/* Add the reservations from the devicetree and the EFI memory map */
+static void lmb_reserve_firmware(struct lmb *lmb, void *fdt_blob)
 {
-	arch_lmb_reserve(lmb);
-	board_lmb_reserve(lmb);
-
 	if (CONFIG_IS_ENABLED(OF_LIBFDT) && fdt_blob)
 		boot_fdt_add_mem_rsv_regions(lmb, fdt_blob);
 
@@ -226,6 +293,125 @@ static void lmb_reserve_common(struct lmb *lmb, void *fdt_blob)
 		efi_lmb_reserve(lmb);
 }
 
+#if IS_ENABLED(CONFIG_LMB_CACHE)
+/**
+ * struct lmb_saved - Firmware reservations kept for the next lmb user
+ *
+ * @lmb: Reservations from lmb_reserve_firmware(), without any memory
+ * @fdt_blob: Devicetree they were read from, or NULL if none
+ * @fdt_crc: Checksum of the reservations in @fdt_blob, from lmb_fdt_crc()
+ * @efi_key: EFI memory map key when they were read
+ * @valid: true if @lmb is up to date with the other fields
+ */
+static struct lmb_saved {
+	struct lmb lmb;
+	const void *fdt_blob;
+	u32 fdt_crc;
+	efi_uintn_t efi_key;
+	bool valid;
+} lmb_saved;
+
+/**
+ * lmb_fdt_crc() - Checksum the parts of a devicetree which reserve memory
+ *
+ * This covers the memory-reservation block and the /reserved-memory node with
+ * its subnodes, so that changes made by 'fdt rsvmem' or to the reserved-memory
+ * nodes are noticed, without reading the whole devicetree.
+ *
+ * @fdt_blob: Devicetree to check
+ * Return: CRC32 of the reservations
+ */
+static u32 lmb_fdt_crc(const void *fdt_blob)
+{
+	int node, end, depth = 0;
+	u32 crc;
+
+	if (fdt_check_header(fdt_blob))
+		return 0;
+	crc = crc32(0, fdt_blob + fdt_off_mem_rsvmap(fdt_blob),
+		    (fdt_num_mem_rsv(fdt_blob) + 1) *
+		    sizeof(struct fdt_reserve_entry));
+
+	node = fdt_subnode_offset(fdt_blob, 0, "reserved-memory");
+	if (node < 0)
+		return crc;
+	end = node;
+	do {
+		end = fdt_next_node(fdt_blob, end, &depth);
+	} while (end >= 0 && depth > 0);
+	if (end < 0)
+		end = fdt_size_dt_struct(fdt_blob);
+
+	return crc32(crc, fdt_blob + fdt_off_dt_struct(fdt_blob) + node,
+		     end - node);
+}
+
+static bool lmb_saved_ok(const void *fdt_blob)
+{
+	if (!lmb_saved.valid || fdt_blob != lmb_saved.fdt_blob)
+		return false;
+	if (CONFIG_IS_ENABLED(OF_LIBFDT) && fdt_blob &&
+	    lmb_fdt_crc(fdt_blob) != lmb_saved.fdt_crc)
+		return false;
+	if (CONFIG_IS_ENABLED(EFI_LOADER) &&
+	    efi_memory_map_key != lmb_saved.efi_key)
+		return false;
+
+	return true;
+}
+
+/**
+ * lmb_reserve_saved() - Add the firmware reservations, reading them if needed
+ *
+ * Parsing the reserved-memory nodes and the EFI memory map is slow, so the
+ * result is kept and reused until the reservations in the devicetree or the
+ * EFI memory map change. Only these are shared: allocations made in @lmb stay in @lmb.
+ *
+ * @lmb: the logical memory block struct to add the reservations to
+ * @fdt_blob: devicetree to read the reservations from, or NULL
+ */
+static void lmb_reserve_saved(struct lmb *lmb, void *fdt_blob)
+{
+	struct lmb_region *rgn = &lmb_saved.lmb.reserved;
+	unsigned long i;
+
+	/* static data is not writable before relocation */
+	if (!(gd->flags & GD_FLG_RELOC)) {
+		lmb_reserve_firmware(lmb, fdt_blob);
+		return;
+	}
+
+	if (!lmb_saved_ok(fdt_blob)) {
+		lmb_uninit(&lmb_saved.lmb);
+		lmb_init(&lmb_saved.lmb);
+		lmb_reserve_firmware(&lmb_saved.lmb, fdt_blob);
+		lmb_saved.fdt_blob = fdt_blob;
+		if (CONFIG_IS_ENABLED(OF_LIBFDT) && fdt_blob)
+			lmb_saved.fdt_crc = lmb_fdt_crc(fdt_blob);
+		/* reading the map allocates memory, so this is done last */
+		if (CONFIG_IS_ENABLED(EFI_LOADER))
+			lmb_saved.efi_key = efi_memory_map_key;
+		lmb_saved.valid = true;
+	}
+
+	for (i = 0; i < rgn->cnt; i++)
+		lmb_reserve_flags(lmb, rgn->region[i].base, rgn->region[i].size,
+				  rgn->region[i].flags);
+}
+#else
+static void lmb_reserve_saved(struct lmb *lmb, void *fdt_blob)
+{
+	lmb_reserve_firmware(lmb, fdt_blob);
+}
+#endif
+
+static void lmb_reserve_common(struct lmb *lmb, void *fdt_blob)
+{
+	arch_lmb_reserve(lmb);
+	board_lmb_reserve(lmb);
+	lmb_reserve_saved(lmb, fdt_blob);
+}
+
 /* Initialize the struct, add memory and call arch/board reserve functions */
 void lmb_init_and_reserve(struct lmb *lmb, struct bd_info *bd, void *fdt_blob)
 {
@@ -267,8 +453,12 @@ static long lmb_add_region_flags(struct lmb_region *rgn, phys_addr_t base,
 		return 0;
 	}
 
-	/* First try and coalesce this LMB with another. */
-	for (i = 0; i < rgn->cnt; i++) {
+	/*
+	 * First try and coalesce this LMB with another. Regions which end
+	 * before base - 1 can neither overlap nor be adjacent to it.
+	 */
+	i = base ? lmb_first_region(rgn, base - 1) : 0;
+	for (; i < rgn->cnt; i++) {
 		phys_addr_t rgnbase = rgn->region[i].base;
 		phys_size_t rgnsize = rgn->region[i].size;
 		phys_size_t rgnflags = rgn->region[i].flags;
@@ -285,20 +475,37 @@ static long lmb_add_region_flags(struct lmb_region *rgn, phys_addr_t base,
 		adjacent = lmb_addrs_adjacent(base, size, rgnbase, rgnsize);
 		if (adjacent > 0) {
 			if (flags != rgnflags)
-				break;
+				continue;
 			rgn->region[i].base -= size;
 			rgn->region[i].size += size;
 			coalesced++;
 			break;
 		} else if (adjacent < 0) {
+			/* the next region may still overlap or be adjacent */
 			if (flags != rgnflags)
-				break;
+				continue;
+			/*
+			 * Only an overlap with the next region which the merge
+			 * below can fix up is allowed
+			 */
+			if (i + 1 < rgn->cnt &&
+			    lmb_addrs_overlap(base, size,
+					      rgn->region[i + 1].base,
+					      rgn->region[i + 1].size) &&
+			    (rgn->region[i + 1].flags != flags ||
+			     end > rgn->region[i + 1].base +
+				   rgn->region[i + 1].size - 1))
+				return -1;
 			rgn->region[i].size += size;
 			coalesced++;
 			break;
 		} else if (lmb_addrs_overlap(base, size, rgnbase, rgnsize)) {
 			/* regions overlap */
 			return -1;
+		} else if (rgnbase > end) {
+			/* this and all later regions are beyond the new one */
+			i = rgn->cnt;
+			break;
 		}
 	}
 
@@ -315,29 +522,16 @@ static long lmb_add_region_flags(struct lmb_region *rgn, phys_addr_t base,
 
 	if (coalesced)
 		return coalesced;
-	if (rgn->cnt >= rgn->max)
+	if (rgn->cnt >= rgn->max && lmb_grow_region(rgn))
 		return -1;
 
 	/* Couldn't coalesce the LMB, so add it to the sorted table. */
-	for (i = rgn->cnt-1; i >= 0; i--) {
-		if (base < rgn->region[i].base) {
-			rgn->region[i + 1].base = rgn->region[i].base;
-			rgn->region[i + 1].size = rgn->region[i].size;
-			rgn->region[i + 1].flags = rgn->region[i].flags;
-		} else {
-			rgn->region[i + 1].base = base;
-			rgn->region[i + 1].size = size;
-			rgn->region[i + 1].flags = flags;
-			break;
-		}
-	}
-
-	if (base < rgn->region[0].base) {
-		rgn->region[0].base = base;
-		rgn->region[0].size = size;
-		rgn->region[0].flags = flags;
-	}
-
+	i = lmb_first_region(rgn, base);
+	memmove(&rgn->region[i + 1], &rgn->region[i],
+		(rgn->cnt - i) * sizeof(*rgn->region));
+	rgn->region[i].base = base;
+	rgn->region[i].size = size;
+	rgn->region[i].flags = flags;
 	rgn->cnt++;
 
 	return 0;
@@ -362,21 +556,17 @@ long lmb_free(struct lmb *lmb, phys_addr_t base, phys_size_t size)
 	struct lmb_region *rgn = &(lmb->reserved);
 	phys_addr_t rgnbegin, rgnend;
 	phys_addr_t end = base + size - 1;
-	int i;
-
-	rgnbegin = rgnend = 0; /* supress gcc warnings */
+	unsigned long i;
 
 	/* Find the region where (base, size) belongs to */
-	for (i = 0; i < rgn->cnt; i++) {
-		rgnbegin = rgn->region[i].base;
-		rgnend = rgnbegin + rgn->region[i].size - 1;
-
-		if ((rgnbegin <= base) && (end <= rgnend))
-			break;
-	}
+	i = lmb_first_region(rgn, base);
+	if (i == rgn->cnt)
+		return -1;
+	rgnbegin = rgn->region[i].base;
+	rgnend = rgnbegin + rgn->region[i].size - 1;
 
 	/* Didn't find the region */
-	if (i == rgn->cnt)
+	if (rgnbegin > base || end > rgnend)
 		return -1;
 
 	/* Check to see if we are removing entire region */
@@ -420,19 +610,17 @@ long lmb_reserve(struct lmb *lmb, phys_addr_t base, phys_size_t size)
 	return lmb_reserve_flags(lmb, base, size, LMB_NONE);
 }
 
+/* Return the index of the first region overlapping (base, size), or -1 */
 static long lmb_overlaps_region(struct lmb_region *rgn, phys_addr_t base,
 				phys_size_t size)
 {
-	unsigned long i;
+	unsigned long i = lmb_first_region(rgn, base);
 
-	for (i = 0; i < rgn->cnt; i++) {
-		phys_addr_t rgnbase = rgn->region[i].base;
-		phys_size_t rgnsize = rgn->region[i].size;
-		if (lmb_addrs_overlap(base, size, rgnbase, rgnsize))
-			break;
-	}
+	if (i < rgn->cnt && lmb_addrs_overlap(base, size, rgn->region[i].base,
+					      rgn->region[i].size))
+		return i;
 
-	return (i < rgn->cnt) ? i : -1;
+	return -1;
 }
 
 phys_addr_t lmb_alloc(struct lmb *lmb, phys_size_t size, ulong align)
@@ -477,6 +665,8 @@ phys_addr_t __lmb_alloc_base(struct lmb *lmb, phys_size_t size, ulong align, phy
 			if (base < lmbbase)
 				base = -1;
 			base = min(base, max_addr);
+			if (base < size)
+				continue;
 			base = lmb_align_down(base - size, align);
 		} else
 			continue;
@@ -528,22 +718,20 @@ phys_addr_t lmb_alloc_addr(struct lmb *lmb, phys_addr_t base, phys_size_t size)
 /* Return number of bytes from a given address that are free */
 phys_size_t lmb_get_free_size(struct lmb *lmb, phys_addr_t addr)
 {
-	int i;
+	unsigned long i;
 	long rgn;
 
 	/* check if the requested address is in the memory regions */
 	rgn = lmb_overlaps_region(&lmb->memory, addr, 1);
 	if (rgn >= 0) {
-		for (i = 0; i < lmb->reserved.cnt; i++) {
+		i = lmb_first_region(&lmb->reserved, addr);
+		if (i < lmb->reserved.cnt) {
 			if (addr < lmb->reserved.region[i].base) {
 				/* first reserved range > requested address */
 				return lmb->reserved.region[i].base - addr;
 			}
-			if (lmb->reserved.region[i].base +
-			    lmb->reserved.region[i].size > addr) {
-				/* requested addr is in this reserved range */
-				return 0;
-			}
+			/* requested addr is in this reserved range */
+			return 0;
 		}
 		/* if we come here: no reserved ranges above requested addr */
 		return lmb->memory.region[lmb->memory.cnt - 1].base +
@@ -554,14 +742,11 @@ phys_size_t lmb_get_free_size(struct lmb *lmb, phys_addr_t addr)
 
 int lmb_is_reserved_flags(struct lmb *lmb, phys_addr_t addr, int flags)
 {
-	int i;
+	unsigned long i = lmb_first_region(&lmb->reserved, addr);
+
+	if (i < lmb->reserved.cnt && addr >= lmb->reserved.region[i].base)
+		return (lmb->reserved.region[i].flags & flags) == flags;
 
-	for (i = 0; i < lmb->reserved.cnt; i++) {
-		phys_addr_t upper = lmb->reserved.region[i].base +
-			lmb->reserved.region[i].size - 1;
-		if ((addr >= lmb->reserved.region[i].base) && (addr <= upper))
-			return (lmb->reserved.region[i].flags & flags) == flags;
-	}
 	return 0;
 }
 
@@ -36,6 +36,12 @@
 
 #define FORCE_INLINE inline __attribute__((always_inline))
 
+/*
+ * U-Boot builds with -fno-builtin, so spell out fixed-size copies as
+ * builtins to let the compiler turn them into (wide) loads and stores
+ */
+#define LZ4_memcpy(dst, src, size) __builtin_memcpy(dst, src, size)
+
 static FORCE_INLINE u16 LZ4_readLE16(const void *src)
 {
 	return get_unaligned_le16(src);
@@ -71,6 +77,83 @@ static void LZ4_wildCopy(void* dstPtr, const void* srcPtr, void* dstEnd)
     do { LZ4_copy8(d,s); d+=8; s+=8; } while (d<e);
 }
 
+/*
+ * customized version of memcpy, which may overwrite up to 31 bytes beyond
+ * dstEnd. It copies 16 bytes at a time rather than 32, so that it remains
+ * correct for overlapping matches with an offset of 16 or more.
+ */
+static FORCE_INLINE void LZ4_wildCopy32(void *dstPtr, const void *srcPtr,
+					void *dstEnd)
+{
+	BYTE *d = (BYTE *)dstPtr;
+	const BYTE *s = (const BYTE *)srcPtr;
+	BYTE * const e = (BYTE *)dstEnd;
+
+	do {
+		LZ4_memcpy(d, s, 16);
+		LZ4_memcpy(d + 16, s + 16, 16);
+		d += 32;
+		s += 32;
+	} while (d < e);
+}
+
+static const unsigned int inc32table[8] = {0, 1, 2, 1, 0, 4, 4, 4};
+static const int dec64table[8] = {0, 0, 0, -1, -4, 1, 2, 3};
+
+/*
+ * LZ4_memcpy_using_offset() :
+ * copy an overlapping match with an offset below 16, where srcPtr + offset
+ * == dstPtr. Offsets of 1, 2 and 4 are expanded into an 8-byte pattern which
+ * is then stored repeatedly; other offsets are first spread to at least 8
+ * bytes apart so that the rest can be copied 8 bytes at a time.
+ * Presumes dstEnd >= dstPtr + MINMATCH and may overwrite up to 7 bytes
+ * beyond dstEnd.
+ */
+static FORCE_INLINE void LZ4_memcpy_using_offset(BYTE *dstPtr,
+						 const BYTE *srcPtr,
+						 BYTE *dstEnd,
+						 const size_t offset)
+{
+	BYTE v[8];
+
+	switch (offset) {
+	case 1:
+		__builtin_memset(v, *srcPtr, 8);
+		break;
+	case 2:
+		LZ4_memcpy(v, srcPtr, 2);
+		LZ4_memcpy(&v[2], srcPtr, 2);
+		LZ4_memcpy(&v[4], v, 4);
+		break;
+	case 4:
+		LZ4_memcpy(v, srcPtr, 4);
+		LZ4_memcpy(&v[4], srcPtr, 4);
+		break;
+	default:
+		if (offset < 8) {
+			dstPtr[0] = srcPtr[0];
+			dstPtr[1] = srcPtr[1];
+			dstPtr[2] = srcPtr[2];
+			dstPtr[3] = srcPtr[3];
+			srcPtr += inc32table[offset];
+			LZ4_memcpy(dstPtr + 4, srcPtr, 4);
+			srcPtr -= dec64table[offset];
+		} else {
+			LZ4_memcpy(dstPtr, srcPtr, 8);
+			srcPtr += 8;
+		}
+		dstPtr += 8;
+		if (dstPtr < dstEnd)
+			LZ4_wildCopy(dstPtr, srcPtr, dstEnd);
+		return;
+	}
+
+	do {
+		LZ4_memcpy(dstPtr, v, 8);
+		dstPtr += 8;
+	} while (dstPtr < dstEnd);
+}
+
 
 /**************************************
 *  Common Constants
@@ -87,6 +170,12 @@ static void LZ4_wildCopy(void* dstPtr, const void* srcPtr, void* dstEnd)
  */
 #define MATCH_SAFEGUARD_DISTANCE  ((2 * WILDCOPYLENGTH) - MINMATCH)
 
+/*
+ * with at least this much room left in the output buffer, literals and
+ * matches can be copied with LZ4_wildCopy32() without any further checks
+ */
+#define FASTLOOP_SAFE_DISTANCE 64
+
 #define KB (1 <<10)
 
 #define MAXD_LOG 16
@@ -150,8 +239,6 @@ static FORCE_INLINE int LZ4_decompress_generic(
 	BYTE *cpy;
 
 	const BYTE * const dictEnd = (const BYTE *)dictStart + dictSize;
-	static const unsigned int inc32table[8] = {0, 1, 2, 1, 0, 4, 4, 4};
-	static const int dec64table[8] = {0, 0, 0, -1, -4, 1, 2, 3};
 
 	const int safeDecode = (endOnInput == endOnInputSize);
 	const int checkOffset = ((safeDecode) && (dictSize < (int)(64 * KB)));
@@ -215,7 +302,7 @@ static FORCE_INLINE int LZ4_decompress_generic(
 		   && likely((endOnInput ? ip < shortiend : 1) &
 			     (op <= shortoend))) {
 			/* Copy the literals */
-			memcpy(op, ip, endOnInput ? 16 : 8);
+			LZ4_memcpy(op, ip, endOnInput ? 16 : 8);
 			op += length; ip += length;
 
 			/*
@@ -234,9 +321,9 @@ static FORCE_INLINE int LZ4_decompress_generic(
 			    (offset >= 8) &&
 			    (dict == withPrefix64k || match >= lowPrefix)) {
 				/* Copy the match. */
-				memcpy(op + 0, match + 0, 8);
-				memcpy(op + 8, match + 8, 8);
-				memcpy(op + 16, match + 16, 2);
+				LZ4_memcpy(op + 0, match + 0, 8);
+				LZ4_memcpy(op + 8, match + 8, 8);
+				LZ4_memcpy(op + 16, match + 16, 2);
 				op += length + MINMATCH;
 				/* Both stages worked, load the next token. */
 				continue;
@@ -336,6 +423,13 @@ static FORCE_INLINE int LZ4_decompress_generic(
 			/* Necessarily EOF, due to parsing restrictions */
 			if (!partialDecoding || (cpy == oend))
 				break;
+		} else if ((endOnInput) &&
+			   likely((cpy <= oend - FASTLOOP_SAFE_DISTANCE) &&
+				  (ip + length <= iend - 32))) {
+			/* long literal run well away from either end */
+			LZ4_wildCopy32(op, ip, cpy);
+			ip += length;
+			op = cpy;
 		} else {
 			/* may overwrite up to WILDCOPYLENGTH beyond cpy */
 			LZ4_wildCopy(op, ip, cpy);
@@ -436,6 +530,16 @@ _copy_match:
 		/* copy match within block */
 		cpy = op + length;
 
+		if (likely(cpy <= oend - FASTLOOP_SAFE_DISTANCE)) {
+			/* plenty of room left: copy the match in wide chunks */
+			if (unlikely(offset < 16))
+				LZ4_memcpy_using_offset(op, match, cpy, offset);
+			else
+				LZ4_wildCopy32(op, match, cpy);
+			op = cpy;
+			continue;
+		}
+
 		/*
 		 * partialDecoding :
 		 * may not respect endBlock parsing restrictions
@@ -5,6 +5,7 @@
 
 #include <compiler.h>
 #include <image.h>
+#include <malloc.h>
 #include <linux/kernel.h>
 #include <linux/types.h>
 #include <asm/unaligned.h>
@@ -83,7 +84,7 @@ int ulz4fn(const void *src, size_t srcn, void *dst, size_t *dstn)
 			memcpy(out, in, size);
 			out += size;
 			if (size < block_size) {
-				ret = -ENOBUFS;	/* output overrun */
+				ret = -ENOSPC;	/* output overrun */
 				break;
 			}
 		} else {
@@ -106,3 +107,131 @@ int ulz4fn(const void *src, size_t srcn, void *dst, size_t *dstn)
 	*dstn = out - dst;
 	return ret;
 }
+
+/* Make sure at least @need bytes are available in the buffer at *@posp */
+static int ulz4fn_need(struct image_reader *rd, u8 *buf, ulong size,
+		       ulong *posp, ulong *lenp, ulong need)
+{
+	long ret;
+
+	if (need > size)
+		return -EINVAL;
+	while (*lenp - *posp < need) {
+		ret = image_reader_fill(rd, buf, size, *posp, lenp);
+		*posp = 0;
+		if (ret < 0)
+			return ret;
+		if (!ret)
+			return -EINVAL;	/* input overrun */
+	}
+
+	return 0;
+}
+
+int ulz4fn_read(struct image_reader *rd, void *dst, size_t *dstn)
+{
+	const void *end = dst + *dstn;
+	void *out = dst;
+	ulong pos = 0, len = 0, size;
+	int has_block_checksum;
+	u8 flags, block_desc;
+	u8 *buf, *in;
+	int ret;
+
+	*dstn = 0;
+	buf = malloc(IMAGE_READ_CHUNK);
+	if (!buf)
+		return -ENOMEM;
+	size = IMAGE_READ_CHUNK;
+
+	ret = ulz4fn_need(rd, buf, size, &pos, &len, sizeof(u32) + 3);
+	if (ret)
+		goto err;
+	flags = buf[4];
+	block_desc = buf[5];
+	has_block_checksum = (flags >> 4) & 0x1;
+	if (get_unaligned_le32(buf) != LZ4F_MAGIC || ((flags >> 6) & 0x3) != 1) {
+		ret = -EPROTONOSUPPORT;	/* unknown format */
+		goto err;
+	}
+	if ((flags & 0x03) || (block_desc & 0x8f)) {
+		ret = -EINVAL;	/* reserved bits must be zero */
+		goto err;
+	}
+	if (!((flags >> 5) & 0x1)) {
+		ret = -EPROTONOSUPPORT; /* we can't support this yet */
+		goto err;
+	}
+	if ((flags >> 3) & 0x1) {
+		ret = ulz4fn_need(rd, buf, size, &pos, &len,
+				  sizeof(u32) + 3 + sizeof(u64));
+		if (ret)
+			goto err;
+		pos += sizeof(u64);
+	}
+	pos += sizeof(u32) + 3;
+
+	/* Each block must fit in the buffer along with its header */
+	if ((1UL << (8 + 2 * (block_desc >> 4))) + 8 > size) {
+		size = (1UL << (8 + 2 * (block_desc >> 4))) + 8;
+		in = realloc(buf, size);
+		if (!in) {
+			ret = -ENOMEM;
+			goto err;
+		}
+		buf = in;
+	}
+
+	while (1) {
+		u32 block_header, block_size;
+
+		ret = ulz4fn_need(rd, buf, size, &pos, &len, sizeof(u32));
+		if (ret)
+			break;
+		block_header = get_unaligned_le32(buf + pos);
+		block_size = block_header & ~LZ4F_BLOCKUNCOMPRESSED_FLAG;
+		if (!block_size) {
+			ret = 0;	/* decompression successful */
+			break;
+		}
+
+		ret = ulz4fn_need(rd, buf, size, &pos, &len, sizeof(u32) +
+				  block_size +
+				  (has_block_checksum ? sizeof(u32) : 0));
+		if (ret)
+			break;
+		in = buf + pos + sizeof(u32);
+
+		if (block_header & LZ4F_BLOCKUNCOMPRESSED_FLAG) {
+			size_t count = min((ptrdiff_t)block_size,
+					   (ptrdiff_t)(end - out));
+
+			memcpy(out, in, count);
+			out += count;
+			if (count < block_size) {
+				ret = -ENOSPC;	/* output overrun */
+				break;
+			}
+		} else {
+			/* constant folding essential, do not touch params! */
+			ret = LZ4_decompress_generic(in, out, block_size,
+					end - out, endOnInputSize,
+					decode_full_block, noDict, out, NULL, 0);
+			if (ret < 0) {
+				ret = -EPROTO;	/* decompression error */
+				break;
+			}
+			out += ret;
+		}
+
+		pos += sizeof(u32) + block_size;
+		if (has_block_checksum)
+			pos += sizeof(u32);
+	}
+
+	*dstn = out - dst;
+err:
+	free(buf);
+
+	return ret;
+}
@@ -27,6 +27,17 @@
 #define GET_BIT(p, i) GET_BIT2(p, i, ; , ;)
 
 #define TREE_GET_BIT(probs, i) { GET_BIT((probs + i), i); }
+
+/*
+ * Decode one bit of a literal, using the byte at rep0 for context. This is
+ * the branch-reduced form from later LZMA SDK releases
+ */
+#define MATCHED_LITER_DEC \
+  matchByte += matchByte; \
+  bit = offs; \
+  offs &= matchByte; \
+  probLit = prob + (offs + bit + symbol); \
+  GET_BIT2(probLit, symbol, offs ^= bit; , ; )
 #define TREE_DECODE(probs, limit, i) \
   { i = 1; do { TREE_GET_BIT(probs, i); } while (i < limit); i -= limit; }
 
@@ -161,7 +172,7 @@ static int MY_FAST_CALL LzmaDec_DecodeReal(CLzmaDec *p, SizeT limit, const Byte
     unsigned posState = processedPos & pbMask;
 
     if (!(loop++ & 1023))
-	    schedule();
+	    schedule_hot();
 
     prob = probs + IsMatch + (state << kNumPosBitsMax) + posState;
     IF_BIT_0(prob)
@@ -177,26 +188,39 @@ static int MY_FAST_CALL LzmaDec_DecodeReal(CLzmaDec *p, SizeT limit, const Byte
       {
         state -= (state < 4) ? state : 3;
         symbol = 1;
-
-        do { GET_BIT(prob + symbol, symbol) } while (symbol < 0x100);
+#ifdef _LZMA_SIZE_OPT
+        do { TREE_GET_BIT(prob, symbol) } while (symbol < 0x100);
+#else
+        TREE_GET_BIT(prob, symbol)
+        TREE_GET_BIT(prob, symbol)
+        TREE_GET_BIT(prob, symbol)
+        TREE_GET_BIT(prob, symbol)
+        TREE_GET_BIT(prob, symbol)
+        TREE_GET_BIT(prob, symbol)
+        TREE_GET_BIT(prob, symbol)
+        TREE_GET_BIT(prob, symbol)
+#endif
       }
       else
       {
-        unsigned matchByte = p->dic[(dicPos - rep0) + ((dicPos < rep0) ? dicBufSize : 0)];
+        unsigned matchByte = dic[(dicPos - rep0) + ((dicPos < rep0) ? dicBufSize : 0)];
         unsigned offs = 0x100;
+        unsigned bit;
+        CLzmaProb *probLit;
         state -= (state < 10) ? 3 : 6;
         symbol = 1;
-
-        do
-        {
-          unsigned bit;
-          CLzmaProb *probLit;
-          matchByte <<= 1;
-          bit = (matchByte & offs);
-          probLit = prob + offs + bit + symbol;
-          GET_BIT2(probLit, symbol, offs &= ~bit, offs &= bit)
-        }
-        while (symbol < 0x100);
+#ifdef _LZMA_SIZE_OPT
+        do { MATCHED_LITER_DEC } while (symbol < 0x100);
+#else
+        MATCHED_LITER_DEC
+        MATCHED_LITER_DEC
+        MATCHED_LITER_DEC
+        MATCHED_LITER_DEC
+        MATCHED_LITER_DEC
+        MATCHED_LITER_DEC
+        MATCHED_LITER_DEC
+        MATCHED_LITER_DEC
+#endif
       }
       dic[dicPos++] = (Byte)symbol;
       processedPos++;
@@ -395,7 +419,13 @@ static int MY_FAST_CALL LzmaDec_DecodeReal(CLzmaDec *p, SizeT limit, const Byte
         processedPos += curLen;
 
         len -= curLen;
-        if (pos + curLen <= dicBufSize)
+        if (dicPos >= rep0 && rep0 >= curLen)
+        {
+          /* The source is behind the destination and does not overlap it */
+          memcpy(dic + dicPos, dic + pos, curLen);
+          dicPos += curLen;
+        }
+        else if (pos + curLen <= dicBufSize)
         {
           Byte *dest = dic + dicPos;
           ptrdiff_t src = (ptrdiff_t)pos - (ptrdiff_t)dicPos;
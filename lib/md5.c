@@ -303,7 +303,7 @@ md5_wd(const unsigned char *input, unsigned int len, unsigned char output[16],
 			chunk = chunk_sz;
 		MD5Update(&context, curr, chunk);
 		curr += chunk;
-		schedule();
+		schedule_hot();
 	}
 #else
 	MD5Update(&context, input, len);
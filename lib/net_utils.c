@@ -169,25 +169,53 @@ void string_to_enetaddr(const char *addr, uint8_t *enetaddr)
 
 uint compute_ip_checksum(const void *vptr, uint nbytes)
 {
-	int sum, oddbyte;
-	const unsigned short *ptr = vptr;
+	const u8 *ptr = vptr;
+	u64 sum = 0;
+	u32 sum32;
+	u16 oddbyte;
+
+	/* The data is 16-bit aligned, so this reaches 32-bit alignment */
+	if (((ulong)ptr & 2) && nbytes > 1) {
+		sum += *(const u16 *)ptr;
+		ptr += 2;
+		nbytes -= 2;
+	}
 
-	sum = 0;
-	while (nbytes > 1) {
-		sum += *ptr++;
+	/*
+	 * Add 32-bit words into a 64-bit total, which cannot overflow. Folding
+	 * this down to 16 bits at the end gives the same result as adding the
+	 * 16-bit words one at a time (RFC 1071).
+	 */
+	while (nbytes >= 16) {
+		sum += *(const u32 *)ptr;
+		sum += *(const u32 *)(ptr + 4);
+		sum += *(const u32 *)(ptr + 8);
+		sum += *(const u32 *)(ptr + 12);
+		ptr += 16;
+		nbytes -= 16;
+	}
+	while (nbytes >= 4) {
+		sum += *(const u32 *)ptr;
+		ptr += 4;
+		nbytes -= 4;
+	}
+	if (nbytes >= 2) {
+		sum += *(const u16 *)ptr;
+		ptr += 2;
 		nbytes -= 2;
 	}
-	if (nbytes == 1) {
+	if (nbytes) {
 		oddbyte = 0;
-		((u8 *)&oddbyte)[0] = *(u8 *)ptr;
-		((u8 *)&oddbyte)[1] = 0;
+		*(u8 *)&oddbyte = *ptr;
 		sum += oddbyte;
 	}
-	sum = (sum >> 16) + (sum & 0xffff);
-	sum += (sum >> 16);
-	sum = ~sum & 0xffff;
 
-	return sum;
+	sum = (sum & 0xffffffff) + (sum >> 32);
+	sum32 = (sum & 0xffffffff) + (sum >> 32);
+	sum32 = (sum32 & 0xffff) + (sum32 >> 16);
+	sum32 = (sum32 & 0xffff) + (sum32 >> 16);
+
+	return ~sum32 & 0xffff;
 }
 
 uint add_ip_checksums(uint offset, uint sum, uint new)
@@ -12,6 +12,7 @@
 
 #include <abuf.h>
 #include <log.h>
+#include <u-boot/crc.h>
 #include <linux/libfdt.h>
 #include <of_live.h>
 #include <malloc.h>
@@ -313,21 +314,79 @@ int unflatten_device_tree(const void *blob, struct device_node **mynodes)
 		return -ENOSPC;
 	}
 
+	of_atoms_intern(blob, *mynodes);
+
 	debug(" <- unflatten_device_tree()\n");
 
 	return 0;
 }
 
+/**
+ * of_live_use_prebuilt() - Use the live tree laid out at build time
+ *
+ * The prebuilt tree holds blob offsets in place of pointers into the blob.
+ * These are converted to pointers, which can only be done once.
+ *
+ * @blob: Control devicetree blob
+ * @rootp: Returns the root node
+ * Return: 0 if OK, -ENOENT if @blob does not match the prebuilt tree,
+ * -EALREADY if the prebuilt tree has already been used
+ */
+static int of_live_use_prebuilt(const void *blob, struct device_node **rootp)
+{
+	const struct of_live_prebuilt *pre = &of_live_prebuilt;
+	static bool used;
+	int i;
+
+	if (used)
+		return -EALREADY;
+	if (fdt_check_header(blob) || fdt_totalsize(blob) != pre->fdt_size ||
+	    crc32(0, blob, pre->fdt_size) != pre->fdt_crc32)
+		return -ENOENT;
+
+	for (i = 0; i < pre->np_count; i++) {
+		struct device_node *np = &pre->np[i];
+
+		np->name = blob + (ulong)np->name;
+		np->type = np->type ? blob + (ulong)np->type : "<NULL>";
+	}
+	for (i = 0; i < pre->pp_count; i++) {
+		struct property *pp = &pre->pp[i];
+
+		pp->name = (char *)blob + (ulong)pp->name;
+		pp->value = (char *)blob + (ulong)pp->value;
+	}
+	used = true;
+	*rootp = pre->np;
+
+	return 0;
+}
+
+static bool of_live_is_prebuilt(struct device_node *root)
+{
+	return CONFIG_IS_ENABLED(OF_LIVE_PREBUILT) &&
+		root == of_live_prebuilt.np;
+}
+
 int of_live_build(const void *fdt_blob, struct device_node **rootp)
 {
-	int ret;
+	int ret = -ENOENT;
 
 	debug("%s: start\n", __func__);
-	ret = unflatten_device_tree(fdt_blob, rootp);
+	if (CONFIG_IS_ENABLED(OF_LIVE_PREBUILT)) {
+		ret = of_live_use_prebuilt(fdt_blob, rootp);
+		if (ret)
+			log_debug("Prebuilt live tree not used: err=%d\n", ret);
+	}
+	if (ret)
+		ret = unflatten_device_tree(fdt_blob, rootp);
 	if (ret) {
 		debug("Failed to create live tree: err=%d\n", ret);
 		return ret;
 	}
+	ret = of_atoms_init(fdt_blob, *rootp);
+	if (ret)
+		log_debug("Property names not interned: err=%d\n", ret);
 	ret = of_alias_scan();
 	if (ret) {
 		debug("Failed to scan live tree aliases: err=%d\n", ret);
@@ -340,6 +399,10 @@ int of_live_build(const void *fdt_blob, struct device_node **rootp)
 
 void of_live_free(struct device_node *root)
 {
+	of_phandle_cache_inval();
+	/* the prebuilt tree is part of the U-Boot image */
+	if (of_live_is_prebuilt(root))
+		return;
 	/* the tree is stored as a contiguous block of memory */
 	free(root);
 }
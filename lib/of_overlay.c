@@ -0,0 +1,941 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Applying devicetree overlays to a live tree
+ *
+ * This follows scripts/dtc/libfdt/fdt_overlay.c step by step. The overlay
+ * itself is small, so its phandles are still adjusted in a (copied) flat
+ * blob; only the base tree is held as a live tree, with indexes in place of
+ * the scans of the flat tree.
+ */
+
+#define LOG_CATEGORY	LOGC_DT
+
+#include <abuf.h>
+#include <errno.h>
+#include <log.h>
+#include <malloc.h>
+#include <of_live.h>
+#include <of_overlay.h>
+#include <sort.h>
+#include <vsprintf.h>
+#include <dm/of_access.h>
+#include <linux/err.h>
+#include <linux/libfdt.h>
+#include <linux/string.h>
+
+/* Number of entries to add when an array is full, at least */
+#define OF_OVERLAY_GROW		32
+
+/**
+ * struct of_overlay_phandle - Entry in the phandle index
+ *
+ * @phandle: Phandle of the node
+ * @np: Node
+ */
+struct of_overlay_phandle {
+	phandle phandle;
+	struct device_node *np;
+};
+
+/**
+ * struct of_overlay_sym - Entry in the symbol index
+ *
+ * @name: Symbol name (label)
+ * @pp: Property in the /__symbols__ node, holding the path to the node
+ * @value: Value of @pp when @np was looked up
+ * @gen: Value of of_overlay_ctx->gen when @np was looked up
+ * @np: Node the symbol refers to, or NULL if not yet looked up
+ */
+struct of_overlay_sym {
+	const char *name;
+	struct property *pp;
+	const void *value;
+	uint gen;
+	struct device_node *np;
+};
+
+/**
+ * of_overlay_grow() - Make sure there is space for another array entry
+ *
+ * @arrayp: Pointer to the array, updated if it is reallocated
+ * @count: Number of entries in use
+ * @maxp: Pointer to the number of entries allocated, updated if needed
+ * @size: Size of each entry
+ * Return: 0 if OK, -ENOMEM if out of memory
+ */
+static int of_overlay_grow(void *arrayp, int count, int *maxp, size_t size)
+{
+	void **array = arrayp;
+	int max = *maxp * 2 + OF_OVERLAY_GROW;
+	void *new;
+
+	if (count < *maxp)
+		return 0;
+	new = realloc(*array, max * size);
+	if (!new)
+		return -ENOMEM;
+	*array = new;
+	*maxp = max;
+
+	return 0;
+}
+
+/* Allocate memory which is freed by of_overlay_end() */
+static void *of_overlay_alloc(struct of_overlay_ctx *ctx, size_t size)
+{
+	void *ptr;
+
+	if (of_overlay_grow(&ctx->allocs, ctx->alloc_count, &ctx->alloc_max,
+			    sizeof(void *)))
+		return NULL;
+	ptr = malloc(size);
+	if (ptr)
+		ctx->allocs[ctx->alloc_count++] = ptr;
+
+	return ptr;
+}
+
+/* Find the first entry in the phandle index which is >= @ph */
+static int of_overlay_phandle_idx(struct of_overlay_ctx *ctx, phandle ph)
+{
+	int low = 0, high = ctx->phandle_count;
+
+	while (low < high) {
+		int mid = (low + high) / 2;
+
+		if (ctx->phandles[mid].phandle < ph)
+			low = mid + 1;
+		else
+			high = mid;
+	}
+
+	return low;
+}
+
+static int of_overlay_add_phandle(struct of_overlay_ctx *ctx,
+				  struct device_node *np)
+{
+	struct of_overlay_phandle *entry;
+	int ret, i;
+
+	ret = of_overlay_grow(&ctx->phandles, ctx->phandle_count,
+			      &ctx->phandle_max, sizeof(*entry));
+	if (ret)
+		return ret;
+	i = of_overlay_phandle_idx(ctx, np->phandle + 1);
+	entry = &ctx->phandles[i];
+	memmove(entry + 1, entry, (ctx->phandle_count - i) * sizeof(*entry));
+	entry->phandle = np->phandle;
+	entry->np = np;
+	ctx->phandle_count++;
+
+	return 0;
+}
+
+/**
+ * of_overlay_max_phandle() - Get the largest phandle in the tree
+ *
+ * Entries for nodes whose phandle has since been replaced are dropped from
+ * the end of the index
+ *
+ * @ctx: Context
+ * Return: largest phandle, or 0 if none
+ */
+static phandle of_overlay_max_phandle(struct of_overlay_ctx *ctx)
+{
+	struct of_overlay_phandle *entry;
+
+	while (ctx->phandle_count) {
+		entry = &ctx->phandles[ctx->phandle_count - 1];
+		if (entry->np->phandle == entry->phandle)
+			return entry->phandle;
+		ctx->phandle_count--;
+	}
+
+	return 0;
+}
+
+static struct device_node *of_overlay_by_phandle(struct of_overlay_ctx *ctx,
+						 phandle ph)
+{
+	struct device_node *np;
+	int i;
+
+	i = of_overlay_phandle_idx(ctx, ph);
+	if (i < ctx->phandle_count && ctx->phandles[i].np->phandle == ph)
+		return ctx->phandles[i].np;
+
+	/* an overlay may have replaced the phandle of an indexed node */
+	for (np = ctx->root; np; np = of_find_all_nodes(np)) {
+		if (np->phandle == ph)
+			return np;
+	}
+
+	return NULL;
+}
+
+/**
+ * of_overlay_name_eq() - Check if a node name matches, as libfdt does
+ *
+ * A name without a unit address matches a node with any unit address
+ *
+ * @name: Node name
+ * @s: Name to check
+ * @len: Length of @s
+ * Return: true if they match
+ */
+static bool of_overlay_name_eq(const char *name, const char *s, int len)
+{
+	if (strncmp(name, s, len))
+		return false;
+	if (!name[len])
+		return true;
+
+	return name[len] == '@' && !memchr(s, '@', len);
+}
+
+static struct device_node *of_overlay_find_child(struct device_node *parent,
+						 const char *name, int len)
+{
+	struct device_node *np;
+
+	for (np = parent->child; np; np = np->sibling) {
+		if (of_overlay_name_eq(np->name, name, len))
+			return np;
+	}
+
+	return NULL;
+}
+
+/**
+ * of_overlay_find_path() - Find a node by path, as fdt_path_offset() does
+ *
+ * @ctx: Context
+ * @path: Path to the node, which may start with an alias
+ * Return: node, or NULL if not found
+ */
+static struct device_node *of_overlay_find_path(struct of_overlay_ctx *ctx,
+						const char *path)
+{
+	struct device_node *np = ctx->root;
+	const char *p = path, *q;
+
+	if (*path != '/') {
+		struct device_node *aliases;
+		struct property *pp = NULL;
+
+		q = strchrnul(path, '/');
+		aliases = of_overlay_find_child(ctx->root, "aliases",
+						strlen("aliases"));
+		for (pp = aliases ? aliases->properties : NULL; pp;
+		     pp = pp->next) {
+			if (!strncmp(pp->name, path, q - path) &&
+			    !pp->name[q - path])
+				break;
+		}
+		if (!pp || !pp->length || *(char *)pp->value != '/' ||
+		    ((char *)pp->value)[pp->length - 1])
+			return NULL;
+		np = of_overlay_find_path(ctx, pp->value);
+		p = q;
+	}
+
+	while (np && *p) {
+		while (*p == '/')
+			p++;
+		if (!*p)
+			break;
+		q = strchrnul(p, '/');
+		np = of_overlay_find_child(np, p, q - p);
+		p = q;
+	}
+
+	return np;
+}
+
+/* Find the first entry in the symbol index which is >= @name */
+static int of_overlay_sym_idx(struct of_overlay_ctx *ctx, const char *name)
+{
+	int low = 0, high = ctx->sym_count;
+
+	while (low < high) {
+		int mid = (low + high) / 2;
+
+		if (strcmp(ctx->syms[mid].name, name) < 0)
+			low = mid + 1;
+		else
+			high = mid;
+	}
+
+	return low;
+}
+
+static int of_overlay_add_sym(struct of_overlay_ctx *ctx, struct property *pp)
+{
+	struct of_overlay_sym *sym;
+	int ret, i;
+
+	i = of_overlay_sym_idx(ctx, pp->name);
+	if (i < ctx->sym_count && !strcmp(ctx->syms[i].name, pp->name))
+		return 0;
+	ret = of_overlay_grow(&ctx->syms, ctx->sym_count, &ctx->sym_max,
+			      sizeof(*sym));
+	if (ret)
+		return ret;
+	sym = &ctx->syms[i];
+	memmove(sym + 1, sym, (ctx->sym_count - i) * sizeof(*sym));
+	sym->name = pp->name;
+	sym->pp = pp;
+	sym->value = NULL;
+	sym->np = NULL;
+	ctx->sym_count++;
+
+	return 0;
+}
+
+static struct device_node *of_overlay_find_sym(struct of_overlay_ctx *ctx,
+					       const char *name)
+{
+	struct of_overlay_sym *sym;
+	const char *path;
+	int i;
+
+	i = of_overlay_sym_idx(ctx, name);
+	if (i == ctx->sym_count || strcmp(ctx->syms[i].name, name))
+		return NULL;
+	sym = &ctx->syms[i];
+
+	/* look up the path again if it or the tree has changed */
+	if (!sym->np || sym->value != sym->pp->value || sym->gen != ctx->gen) {
+		path = sym->pp->value;
+		if (!sym->pp->length || path[sym->pp->length - 1])
+			return NULL;
+		sym->np = of_overlay_find_path(ctx, path);
+		sym->value = sym->pp->value;
+		sym->gen = ctx->gen;
+	}
+
+	return sym->np;
+}
+
+/**
+ * of_overlay_set_prop() - Set the value of a property, adding it if needed
+ *
+ * New properties are added before the existing ones, as libfdt does
+ *
+ * @ctx: Context
+ * @np: Node to update
+ * @name: Property name, which must remain valid until of_overlay_end()
+ * @value: Property value, which must remain valid until of_overlay_end()
+ * @len: Length of @value
+ * Return: property, or NULL if out of memory
+ */
+static struct property *of_overlay_set_prop(struct of_overlay_ctx *ctx,
+					    struct device_node *np,
+					    const char *name, const void *value,
+					    int len)
+{
+	struct property *pp;
+
+	for (pp = np->properties; pp; pp = pp->next) {
+		if (!strcmp(pp->name, name))
+			break;
+	}
+	if (!pp) {
+		pp = of_overlay_alloc(ctx, sizeof(*pp));
+		if (!pp)
+			return NULL;
+		pp->name = (char *)name;
+		pp->next = np->properties;
+		np->properties = pp;
+	}
+	pp->value = (void *)value;
+	pp->length = len;
+
+	return pp;
+}
+
+/**
+ * of_overlay_add_node() - Add a new subnode
+ *
+ * New subnodes are added before the existing ones, as libfdt does
+ *
+ * @ctx: Context
+ * @parent: Parent node
+ * @name: Name of the node, which must remain valid until of_overlay_end()
+ * Return: new node, or NULL if out of memory
+ */
+static struct device_node *of_overlay_add_node(struct of_overlay_ctx *ctx,
+					       struct device_node *parent,
+					       const char *name)
+{
+	int plen = parent->parent ? strlen(parent->full_name) : 0;
+	struct device_node *np;
+	char *full_name;
+
+	np = of_overlay_alloc(ctx, sizeof(*np) + plen + strlen(name) + 2);
+	if (!np)
+		return NULL;
+	memset(np, '\0', sizeof(*np));
+	full_name = (char *)(np + 1);
+	memcpy(full_name, parent->full_name, plen);
+	full_name[plen] = '/';
+	strcpy(full_name + plen + 1, name);
+
+	np->name = name;
+	/* this may now be the first match for a path without unit address */
+	if (strchr(name, '@'))
+		ctx->gen++;
+	np->type = "<NULL>";
+	np->full_name = full_name;
+	np->parent = parent;
+	np->sibling = parent->child;
+	parent->child = np;
+
+	return np;
+}
+
+/* Add @delta to each phandle in the overlay */
+static int of_overlay_adjust_phandles(void *fdto, phandle delta)
+{
+	static const char *const names[] = { "phandle", "linux,phandle" };
+	int node, i, len;
+
+	for (node = 0; node >= 0; node = fdt_next_node(fdto, node, NULL)) {
+		for (i = 0; i < ARRAY_SIZE(names); i++) {
+			fdt32_t *val;
+			phandle ph;
+
+			val = fdt_getprop_w(fdto, node, names[i], &len);
+			if (!val)
+				continue;
+			if (len != sizeof(*val))
+				return -EINVAL;
+			ph = fdt32_to_cpu(*val);
+			if (ph + delta < ph || ph + delta == (phandle)-1)
+				return -ERANGE;
+			*val = cpu_to_fdt32(ph + delta);
+		}
+	}
+
+	return 0;
+}
+
+/**
+ * of_overlay_local_refs() - Adjust references to phandles in the overlay
+ *
+ * @fdto: Overlay
+ * @node: Node in the overlay to update
+ * @fixup: Matching node in /__local_fixups__
+ * @delta: Amount that the phandles were adjusted by
+ * Return: 0 if OK, -EINVAL if the overlay is not valid
+ */
+static int of_overlay_local_refs(void *fdto, int node, int fixup,
+				 phandle delta)
+{
+	int prop, child, ret;
+
+	fdt_for_each_property_offset(prop, fdto, fixup) {
+		const fdt32_t *offsets;
+		const char *name;
+		int len, tree_len, i;
+		char *val;
+
+		offsets = fdt_getprop_by_offset(fdto, prop, &name, &len);
+		if (!offsets || len % sizeof(fdt32_t))
+			return -EINVAL;
+		val = fdt_getprop_w(fdto, node, name, &tree_len);
+		if (!val)
+			return -EINVAL;
+		for (i = 0; i < len / sizeof(fdt32_t); i++) {
+			uint offset = fdt32_to_cpu(offsets[i]);
+			fdt32_t adj;
+
+			if (tree_len < sizeof(adj) ||
+			    offset > tree_len - sizeof(adj))
+				return -EINVAL;
+			/* these may not be aligned */
+			memcpy(&adj, val + offset, sizeof(adj));
+			adj = cpu_to_fdt32(fdt32_to_cpu(adj) + delta);
+			memcpy(val + offset, &adj, sizeof(adj));
+		}
+	}
+
+	fdt_for_each_subnode(child, fdto, fixup) {
+		int tree_child;
+
+		tree_child = fdt_subnode_offset(fdto, node,
+						fdt_get_name(fdto, child, NULL));
+		if (tree_child < 0)
+			return -EINVAL;
+		ret = of_overlay_local_refs(fdto, tree_child, child, delta);
+		if (ret)
+			return ret;
+	}
+
+	return 0;
+}
+
+/**
+ * of_overlay_fixup_one() - Resolve the references to one symbol
+ *
+ * @fdto: Overlay
+ * @ph: Phandle of the node which the symbol refers to
+ * @value: List of "path:property:offset" strings, each nul-terminated
+ * @len: Length of @value
+ * Return: 0 if OK, -EINVAL if the overlay is not valid
+ */
+static int of_overlay_fixup_one(void *fdto, phandle ph, const char *value,
+				int len)
+{
+	fdt32_t prop_val = cpu_to_fdt32(ph);
+
+	while (len > 0) {
+		const char *path = value, *name, *end, *sep;
+		int node, fixup_len, prop_len;
+		char *endp, *prop;
+		ulong offset;
+
+		end = memchr(value, '\0', len);
+		if (!end)
+			return -EINVAL;
+		fixup_len = end - value;
+		len -= fixup_len + 1;
+		value += fixup_len + 1;
+
+		sep = memchr(path, ':', fixup_len);
+		if (!sep || sep == end - 1)
+			return -EINVAL;
+		name = sep + 1;
+		sep = memchr(name, ':', end - name);
+		if (!sep || sep == name)
+			return -EINVAL;
+		offset = simple_strtoul(sep + 1, &endp, 10);
+		if (*endp || endp == sep + 1)
+			return -EINVAL;
+
+		node = fdt_path_offset_namelen(fdto, path, name - 1 - path);
+		if (node < 0)
+			return -EINVAL;
+		prop = fdt_getprop_namelen_w(fdto, node, name, sep - name,
+					     &prop_len);
+		if (!prop || prop_len < sizeof(prop_val) ||
+		    offset > prop_len - sizeof(prop_val))
+			return -EINVAL;
+		memcpy(prop + offset, &prop_val, sizeof(prop_val));
+	}
+
+	return 0;
+}
+
+/* Resolve the references in the overlay to symbols in the base tree */
+static int of_overlay_fixup_phandles(struct of_overlay_ctx *ctx, void *fdto)
+{
+	int fixups, prop, ret;
+
+	fixups = fdt_path_offset(fdto, "/__fixups__");
+	if (fixups == -FDT_ERR_NOTFOUND)
+		return 0;
+	if (fixups < 0)
+		return -EINVAL;
+
+	fdt_for_each_property_offset(prop, fdto, fixups) {
+		struct device_node *np;
+		const char *value, *label;
+		int len;
+
+		value = fdt_getprop_by_offset(fdto, prop, &label, &len);
+		if (!value)
+			return -EINVAL;
+		np = of_overlay_find_sym(ctx, label);
+		if (!np || !np->phandle) {
+			log_debug("Cannot resolve symbol '%s'\n", label);
+			return -ENOENT;
+		}
+		ret = of_overlay_fixup_one(fdto, np->phandle, value, len);
+		if (ret)
+			return ret;
+	}
+
+	return 0;
+}
+
+/**
+ * of_overlay_get_target() - Find the node a fragment applies to
+ *
+ * @ctx: Context
+ * @fdto: Overlay
+ * @fragment: Fragment node in the overlay
+ * @pathp: Returns the target path, or NULL if the target is a phandle
+ * Return: target node, or ERR_PTR(-ve) on error
+ */
+static struct device_node *of_overlay_get_target(struct of_overlay_ctx *ctx,
+						 const void *fdto, int fragment,
+						 const char **pathp)
+{
+	struct device_node *np;
+	const fdt32_t *val;
+	phandle ph = 0;
+	int len;
+
+	*pathp = NULL;
+	val = fdt_getprop(fdto, fragment, "target", &len);
+	if (val) {
+		if (len != sizeof(*val) || fdt32_to_cpu(*val) == (phandle)-1)
+			return ERR_PTR(-EINVAL);
+		ph = fdt32_to_cpu(*val);
+	}
+	if (ph) {
+		np = of_overlay_by_phandle(ctx, ph);
+	} else {
+		*pathp = fdt_getprop(fdto, fragment, "target-path", NULL);
+		if (!*pathp)
+			return ERR_PTR(-EINVAL);
+		np = of_overlay_find_path(ctx, *pathp);
+	}
+
+	return np ? np : ERR_PTR(-ENOENT);
+}
+
+/* Merge an overlay node into a node of the base tree */
+static int of_overlay_apply_node(struct of_overlay_ctx *ctx,
+				 struct device_node *target, const void *fdto,
+				 int node)
+{
+	int prop, subnode, ret;
+
+	fdt_for_each_property_offset(prop, fdto, node) {
+		const char *name;
+		const void *val;
+		int len;
+
+		val = fdt_getprop_by_offset(fdto, prop, &name, &len);
+		if (!val)
+			return -EINVAL;
+		if (!of_overlay_set_prop(ctx, target, name, val, len))
+			return -ENOMEM;
+
+		if (!strcmp(name, "device_type")) {
+			target->type = val;
+		} else if ((!strcmp(name, "phandle") ||
+			    (!strcmp(name, "linux,phandle") &&
+			     !target->phandle)) && len == sizeof(fdt32_t)) {
+			target->phandle = fdt32_to_cpu(*(fdt32_t *)val);
+			ret = of_overlay_add_phandle(ctx, target);
+			if (ret)
+				return ret;
+		}
+	}
+
+	fdt_for_each_subnode(subnode, fdto, node) {
+		struct device_node *np;
+		const char *name;
+		int len;
+
+		name = fdt_get_name(fdto, subnode, &len);
+		np = of_overlay_find_child(target, name, len);
+		if (!np) {
+			np = of_overlay_add_node(ctx, target, name);
+			if (!np)
+				return -ENOMEM;
+		}
+		ret = of_overlay_apply_node(ctx, np, fdto, subnode);
+		if (ret)
+			return ret;
+	}
+
+	return 0;
+}
+
+/* Merge each fragment of the overlay into its target */
+static int of_overlay_merge(struct of_overlay_ctx *ctx, const void *fdto)
+{
+	int fragment, overlay, ret;
+
+	fdt_for_each_subnode(fragment, fdto, 0) {
+		struct device_node *target;
+		const char *path;
+
+		overlay = fdt_subnode_offset(fdto, fragment, "__overlay__");
+		if (overlay == -FDT_ERR_NOTFOUND)
+			continue;
+		if (overlay < 0)
+			return -EINVAL;
+
+		target = of_overlay_get_target(ctx, fdto, fragment, &path);
+		if (IS_ERR(target))
+			return PTR_ERR(target);
+		ret = of_overlay_apply_node(ctx, target, fdto, overlay);
+		if (ret)
+			return ret;
+	}
+
+	return 0;
+}
+
+/**
+ * of_overlay_add_symbol() - Add a symbol from the overlay to the base tree
+ *
+ * @ctx: Context
+ * @fdto: Overlay
+ * @name: Symbol name
+ * @path: Path of the symbol in the overlay
+ * @path_len: Length of @path including the terminator
+ * Return: 0 if OK, -EINVAL if the overlay is not valid, -ENOENT if the target
+ *	was not found, -ENOMEM if out of memory
+ */
+static int of_overlay_add_symbol(struct of_overlay_ctx *ctx, const void *fdto,
+				 const char *name, const char *path,
+				 int path_len)
+{
+	const int ov_len = strlen("/__overlay__");
+	const char *end = path + path_len, *s, *rel_path, *target_path;
+	struct device_node *target;
+	struct property *pp;
+	int fragment, len, rel_len;
+	char *buf;
+
+	if (path_len < 1 || memchr(path, '\0', path_len) != end - 1 ||
+	    *path != '/')
+		return -EINVAL;
+
+	/* symbols outside a fragment's __overlay__ node are not merged */
+	s = strchr(path + 1, '/');
+	if (!s)
+		return 0;
+	if (end - s > ov_len + 1 && !memcmp(s, "/__overlay__/", ov_len + 1)) {
+		rel_path = s + ov_len + 1;
+		rel_len = end - rel_path;
+	} else if (end - s == ov_len + 1 && !memcmp(s, "/__overlay__", ov_len)) {
+		rel_path = "";
+		rel_len = 1;
+	} else {
+		return 0;
+	}
+
+	fragment = fdt_subnode_offset_namelen(fdto, 0, path + 1, s - path - 1);
+	if (fragment < 0 || fdt_subnode_offset(fdto, fragment, "__overlay__") < 0)
+		return -EINVAL;
+	target = of_overlay_get_target(ctx, fdto, fragment, &target_path);
+	if (IS_ERR(target))
+		return PTR_ERR(target);
+	if (!target_path)
+		target_path = target->full_name;
+
+	/* join the paths, without doubling the '/' if the target is root */
+	len = strlen(target_path);
+	buf = of_overlay_alloc(ctx, len + (len > 1) + rel_len);
+	if (!buf)
+		return -ENOMEM;
+	if (len > 1)
+		memcpy(buf, target_path, len);
+	else
+		len--;
+	buf[len] = '/';
+	memcpy(buf + len + 1, rel_path, rel_len);
+
+	pp = of_overlay_set_prop(ctx, ctx->symbols, name, buf,
+				 len + 1 + rel_len);
+	if (!pp)
+		return -ENOMEM;
+
+	return of_overlay_add_sym(ctx, pp);
+}
+
+/* Add the symbols of the overlay to the base tree */
+static int of_overlay_update_symbols(struct of_overlay_ctx *ctx,
+				     const void *fdto)
+{
+	int ov_sym, prop, ret;
+
+	ov_sym = fdt_subnode_offset(fdto, 0, "__symbols__");
+	if (ov_sym < 0)
+		return 0;
+	if (!ctx->symbols) {
+		ctx->symbols = of_overlay_add_node(ctx, ctx->root,
+						   "__symbols__");
+		if (!ctx->symbols)
+			return -ENOMEM;
+	}
+
+	fdt_for_each_property_offset(prop, fdto, ov_sym) {
+		const char *path, *name;
+		int len;
+
+		path = fdt_getprop_by_offset(fdto, prop, &name, &len);
+		if (!path)
+			return -EINVAL;
+		ret = of_overlay_add_symbol(ctx, fdto, name, path, len);
+		if (ret)
+			return ret;
+	}
+
+	return 0;
+}
+
+static int h_cmp_phandle(const void *v1, const void *v2)
+{
+	const struct of_overlay_phandle *p1 = v1, *p2 = v2;
+
+	return p1->phandle < p2->phandle ? -1 : p1->phandle > p2->phandle;
+}
+
+static int h_cmp_sym(const void *v1, const void *v2)
+{
+	const struct of_overlay_sym *s1 = v1, *s2 = v2;
+
+	return strcmp(s1->name, s2->name);
+}
+
+int of_overlay_begin(struct of_overlay_ctx *ctx, const void *fdt)
+{
+	struct device_node *np;
+	struct property *pp;
+	int i, ret;
+
+	memset(ctx, '\0', sizeof(*ctx));
+	if (fdt_check_header(fdt))
+		return -EINVAL;
+
+	ctx->rsv_count = fdt_num_mem_rsv(fdt);
+	if (ctx->rsv_count < 0)
+		return -EINVAL;
+	ctx->rsv = calloc(ctx->rsv_count + 1, 2 * sizeof(u64));
+	if (!ctx->rsv)
+		return -ENOMEM;
+	for (i = 0; i < ctx->rsv_count; i++)
+		fdt_get_mem_rsv(fdt, i, &ctx->rsv[i * 2], &ctx->rsv[i * 2 + 1]);
+
+	ret = unflatten_device_tree(fdt, &ctx->root);
+	if (ret)
+		goto err;
+
+	/* build the indexes, then sort them once */
+	for (np = ctx->root; np; np = of_find_all_nodes(np)) {
+		if (!np->phandle)
+			continue;
+		ret = of_overlay_grow(&ctx->phandles, ctx->phandle_count,
+				      &ctx->phandle_max,
+				      sizeof(*ctx->phandles));
+		if (ret)
+			goto err;
+		ctx->phandles[ctx->phandle_count].phandle = np->phandle;
+		ctx->phandles[ctx->phandle_count++].np = np;
+	}
+	qsort(ctx->phandles, ctx->phandle_count, sizeof(*ctx->phandles),
+	      h_cmp_phandle);
+
+	ctx->symbols = of_overlay_find_child(ctx->root, "__symbols__",
+					     strlen("__symbols__"));
+	for (pp = ctx->symbols ? ctx->symbols->properties : NULL; pp;
+	     pp = pp->next) {
+		ret = of_overlay_grow(&ctx->syms, ctx->sym_count,
+				      &ctx->sym_max, sizeof(*ctx->syms));
+		if (ret)
+			goto err;
+		memset(&ctx->syms[ctx->sym_count], '\0', sizeof(*ctx->syms));
+		ctx->syms[ctx->sym_count].name = pp->name;
+		ctx->syms[ctx->sym_count++].pp = pp;
+	}
+	qsort(ctx->syms, ctx->sym_count, sizeof(*ctx->syms), h_cmp_sym);
+	log_debug("Tree has %d phandles, %d symbols\n", ctx->phandle_count,
+		  ctx->sym_count);
+
+	return 0;
+
+err:
+	of_overlay_end(ctx);
+
+	return ret;
+}
+
+int of_overlay_apply(struct of_overlay_ctx *ctx, const void *fdto)
+{
+	phandle delta = of_overlay_max_phandle(ctx);
+	int size, fixups, ret;
+	void *ov;
+
+	if (fdt_check_header(fdto))
+		return -EINVAL;
+	size = fdt_totalsize(fdto);
+	ov = of_overlay_alloc(ctx, size);
+	if (!ov)
+		return -ENOMEM;
+	memcpy(ov, fdto, size);
+
+	ret = of_overlay_adjust_phandles(ov, delta);
+	if (ret)
+		return log_msg_ret("adj", ret);
+
+	fixups = fdt_path_offset(ov, "/__local_fixups__");
+	if (fixups >= 0)
+		ret = of_overlay_local_refs(ov, 0, fixups, delta);
+	else if (fixups != -FDT_ERR_NOTFOUND)
+		ret = -EINVAL;
+	if (ret)
+		return log_msg_ret("loc", ret);
+
+	ret = of_overlay_fixup_phandles(ctx, ov);
+	if (ret)
+		return log_msg_ret("fix", ret);
+
+	ret = of_overlay_merge(ctx, ov);
+	if (ret)
+		return log_msg_ret("mrg", ret);
+
+	ret = of_overlay_update_symbols(ctx, ov);
+	if (ret)
+		return log_msg_ret("sym", ret);
+
+	return 0;
+}
+
+int of_overlay_flatten(struct of_overlay_ctx *ctx, struct abuf *buf)
+{
+	int size, i, ret;
+
+	ret = of_live_flatten(ctx->root, buf);
+	if (ret)
+		goto err;
+	if (!ctx->rsv_count)
+		return 0;
+
+	size = abuf_size(buf) + ctx->rsv_count * sizeof(struct fdt_reserve_entry);
+	ret = -ENOMEM;
+	if (!abuf_realloc(buf, size))
+		goto err;
+	ret = fdt_open_into(abuf_data(buf), abuf_data(buf), size);
+	for (i = 0; !ret && i < ctx->rsv_count; i++)
+		ret = fdt_add_mem_rsv(abuf_data(buf), ctx->rsv[i * 2],
+				      ctx->rsv[i * 2 + 1]);
+	if (!ret)
+		ret = fdt_pack(abuf_data(buf));
+	if (ret) {
+		log_debug("Cannot add reservations (err=%s)\n",
+			  fdt_strerror(ret));
+		ret = -EINVAL;
+		goto err;
+	}
+
+	return 0;
+
+err:
+	abuf_uninit(buf);
+
+	return log_msg_ret("flt", ret);
+}
+
+void of_overlay_end(struct of_overlay_ctx *ctx)
+{
+	int i;
+
+	for (i = 0; i < ctx->alloc_count; i++)
+		free(ctx->allocs[i]);
+	free(ctx->allocs);
+	free(ctx->phandles);
+	free(ctx->syms);
+	free(ctx->rsv);
+	if (ctx->root)
+		of_live_free(ctx->root);
+	memset(ctx, '\0', sizeof(*ctx));
+}
@@ -0,0 +1,76 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Statistical (sampling) profiler
+ */
+
+#include <errno.h>
+#include <profiler.h>
+#include <asm/global_data.h>
+#include <linux/kernel.h>
+
+DECLARE_GLOBAL_DATA_PTR;
+
+enum {
+	PROFILER_BUF_SIZE	= CONFIG_PROFILER_BUF_SIZE,
+};
+
+/*
+ * The buffer is only touched after relocation, when BSS is available.
+ * Members written from the interrupt are volatile.
+ */
+static struct {
+	uint hz;
+	volatile ulong total;
+	ulong sample[PROFILER_BUF_SIZE];
+} prof;
+
+void profiler_record(ulong pc)
+{
+	ulong total = prof.total;
+
+	prof.sample[total % PROFILER_BUF_SIZE] = pc - gd->reloc_off;
+	prof.total = total + 1;
+}
+
+int profiler_start(uint hz)
+{
+	int ret;
+
+	if (prof.hz)
+		return -EALREADY;
+	if (!hz)
+		return -EINVAL;
+	prof.total = 0;
+	ret = arch_profiler_start(hz);
+	if (ret)
+		return ret;
+	prof.hz = hz;
+
+	return 0;
+}
+
+void profiler_stop(void)
+{
+	if (!prof.hz)
+		return;
+	arch_profiler_stop();
+	prof.hz = 0;
+}
+
+void profiler_get_info(struct profiler_info *info)
+{
+	info->hz = prof.hz;
+	info->total = prof.total;
+	info->count = min_t(ulong, info->total, PROFILER_BUF_SIZE);
+}
+
+ulong profiler_get_sample(uint seq)
+{
+	ulong total = prof.total;
+	ulong count = min_t(ulong, total, PROFILER_BUF_SIZE);
+
+	if (seq >= count)
+		return 0;
+
+	return prof.sample[(total - count + seq) % PROFILER_BUF_SIZE];
+}
@@ -131,6 +131,124 @@ static void montgomery_mul(const struct rsa_public_key *key,
 		montgomery_mul_add_step(key, result, a[i], b);
 }
 
+#ifdef __SIZEOF_INT128__
+/*
+ * Where the compiler has a 64x64-bit multiply with a 128-bit result (e.g. with
+ * umulh on arm64), the Montgomery multiplication can work in 64-bit words,
+ * which needs a quarter as many multiplications. R is the same as with 32-bit
+ * words, so the R^2 from the key can be used as it is.
+ */
+#define RSA_HAVE_WORDS64	1
+
+typedef unsigned __int128 rsa_dword64_t;
+
+/**
+ * struct rsa_key64 - RSA public key with the modulus in 64-bit words
+ *
+ * @len:	Length of @modulus in number of uint64_t
+ * @n0inv:	-1 / modulus[0] mod 2^64
+ * @modulus:	Modulus, as little endian 64-bit word array
+ */
+struct rsa_key64 {
+	uint len;
+	uint64_t n0inv;
+	uint64_t *modulus;
+};
+
+/**
+ * words_to_64() - Convert a little endian 32-bit word array to 64-bit words
+ *
+ * @dst:	Place to put the 64-bit words
+ * @src:	32-bit words to convert
+ * @len:	Number of 64-bit words to produce
+ */
+static void words_to_64(uint64_t dst[], const uint32_t src[], uint len)
+{
+	uint i;
+
+	for (i = 0; i < len; i++)
+		dst[i] = src[2 * i] | (uint64_t)src[2 * i + 1] << 32;
+}
+
+/**
+ * subtract_modulus64() - subtract modulus from the given value
+ *
+ * @key:	Key containing modulus to subtract
+ * @num:	Number to subtract modulus from, as little endian word array
+ */
+static void subtract_modulus64(const struct rsa_key64 *key, uint64_t num[])
+{
+	rsa_dword64_t acc;
+	uint64_t borrow = 0;
+	uint i;
+
+	for (i = 0; i < key->len; i++) {
+		acc = (rsa_dword64_t)num[i] - key->modulus[i] - borrow;
+		num[i] = (uint64_t)acc;
+		borrow = (uint64_t)(acc >> 64) & 1;
+	}
+}
+
+/**
+ * montgomery_mul_add_step64() - Perform montgomery multiply-add step
+ *
+ * This is the same as montgomery_mul_add_step() but with 64-bit words.
+ *
+ * @key:	RSA key
+ * @result:	Place to put result, as little endian word array
+ * @a:		Multiplier
+ * @b:		Multiplicand, as little endian word array
+ */
+static void montgomery_mul_add_step64(const struct rsa_key64 *key,
+				      uint64_t result[], const uint64_t a,
+				      const uint64_t b[])
+{
+	rsa_dword64_t acc_a, acc_b;
+	uint64_t d0;
+	uint i;
+
+	acc_a = (rsa_dword64_t)a * b[0] + result[0];
+	d0 = (uint64_t)acc_a * key->n0inv;
+	acc_b = (rsa_dword64_t)d0 * key->modulus[0] + (uint64_t)acc_a;
+	for (i = 1; i < key->len; i++) {
+		acc_a = (acc_a >> 64) + (rsa_dword64_t)a * b[i] + result[i];
+		acc_b = (acc_b >> 64) + (rsa_dword64_t)d0 * key->modulus[i] +
+				(uint64_t)acc_a;
+		result[i - 1] = (uint64_t)acc_b;
+	}
+
+	acc_a = (acc_a >> 64) + (acc_b >> 64);
+
+	result[i - 1] = (uint64_t)acc_a;
+
+	if (acc_a >> 64)
+		subtract_modulus64(key, result);
+}
+
+/**
+ * montgomery_mul64() - Perform montgomery mutitply with 64-bit words
+ *
+ * Operation: montgomery result[] = a[] * b[] / n0inv % modulus
+ *
+ * @key:	RSA key
+ * @result:	Place to put result, as little endian word array
+ * @a:		Multiplier, as little endian word array
+ * @b:		Multiplicand, as little endian word array
+ */
+static void montgomery_mul64(const struct rsa_key64 *key, uint64_t result[],
+			     const uint64_t a[], const uint64_t b[])
+{
+	uint i;
+
+	for (i = 0; i < key->len; ++i)
+		result[i] = 0;
+	for (i = 0; i < key->len; ++i)
+		montgomery_mul_add_step64(key, result, a[i], b);
+}
+#else
+#define RSA_HAVE_WORDS64	0
+#endif
+
 /**
  * num_pub_exponent_bits() - Number of bits in the public exponent
  *
@@ -173,6 +291,105 @@ static int is_public_exponent_bit_set(const struct rsa_public_key *key,
 	return key->exponent & (1ULL << pos);
 }
 
+/**
+ * pow_mod_words() - Raise a value to the public exponent
+ *
+ * @key:	RSA key
+ * @k:		Number of bits in the public exponent
+ * @val:	Value, as little endian word array
+ * @result:	Place to put the result, as little endian word array. This is
+ *		less than twice the modulus.
+ */
+static void pow_mod_words(const struct rsa_public_key *key, int k,
+			  uint32_t val[], uint32_t result[])
+{
+	uint32_t acc[key->len], tmp[key->len];
+	uint32_t a_scaled[key->len];
+	int j;
+
+	/* the bit at e[k-1] is 1 by definition, so start with: C := M */
+	montgomery_mul(key, acc, val, key->rr); /* acc = a * RR / R mod n */
+	/* retain scaled version for intermediate use */
+	memcpy(a_scaled, acc, key->len * sizeof(a_scaled[0]));
+
+	for (j = k - 2; j > 0; --j) {
+		montgomery_mul(key, tmp, acc, acc); /* tmp = acc^2 / R mod n */
+
+		if (is_public_exponent_bit_set(key, j)) {
+			/* acc = tmp * val / R mod n */
+			montgomery_mul(key, acc, tmp, a_scaled);
+		} else {
+			/* e[j] == 0, copy tmp back to acc for next operation */
+			memcpy(acc, tmp, key->len * sizeof(acc[0]));
+		}
+	}
+
+	/* the bit at e[0] is always 1 */
+	montgomery_mul(key, tmp, acc, acc); /* tmp = acc^2 / R mod n */
+	montgomery_mul(key, acc, tmp, val); /* acc = tmp * a / R mod M */
+	memcpy(result, acc, key->len * sizeof(result[0]));
+}
+
+#if RSA_HAVE_WORDS64
+/**
+ * pow_mod_words64() - Raise a value to the public exponent, in 64-bit words
+ *
+ * This does the same as pow_mod_words(). The key length must be a multiple of
+ * 64 bits.
+ *
+ * @key:	RSA key
+ * @k:		Number of bits in the public exponent
+ * @val:	Value, as little endian word array
+ * @result:	Place to put the result, as little endian word array
+ */
+static void pow_mod_words64(const struct rsa_public_key *key, int k,
+			    uint32_t val[], uint32_t result[])
+{
+	uint len = key->len / 2;
+	uint64_t modulus[len], rr[len], val64[len];
+	uint64_t acc[len], tmp[len], a_scaled[len];
+	struct rsa_key64 key64;
+	uint64_t inv;
+	uint i;
+	int j;
+
+	key64.len = len;
+	key64.modulus = modulus;
+	words_to_64(modulus, key->modulus, len);
+	words_to_64(rr, key->rr, len);
+	words_to_64(val64, val, len);
+
+	/* Extend 1 / modulus[0] to 64 bits with a step of Newton's method */
+	inv = (uint32_t)-key->n0inv;
+	inv *= 2 - modulus[0] * inv;
+	key64.n0inv = -inv;
+
+	montgomery_mul64(&key64, acc, val64, rr);
+	memcpy(a_scaled, acc, sizeof(acc));
+
+	for (j = k - 2; j > 0; --j) {
+		montgomery_mul64(&key64, tmp, acc, acc);
+		if (is_public_exponent_bit_set(key, j))
+			montgomery_mul64(&key64, acc, tmp, a_scaled);
+		else
+			memcpy(acc, tmp, sizeof(acc));
+	}
+
+	montgomery_mul64(&key64, tmp, acc, acc);
+	montgomery_mul64(&key64, acc, tmp, val64);
+
+	for (i = 0; i < len; i++) {
+		result[2 * i] = (uint32_t)acc[i];
+		result[2 * i + 1] = acc[i] >> 32;
+	}
+}
+#else
+static void pow_mod_words64(const struct rsa_public_key *key, int k,
+			    uint32_t val[], uint32_t result[])
+{
+}
+#endif
+
 /**
  * pow_mod() - in-place public exponentiation
  *
@@ -183,7 +400,7 @@ static int pow_mod(const struct rsa_public_key *key, uint32_t *inout)
 {
 	uint32_t *result, *ptr;
 	uint i;
-	int j, k;
+	int k;
 
 	/* Sanity check for stack size - key->len is in 32-bit words */
 	if (key->len > RSA_MAX_KEY_BITS / 32) {
@@ -192,8 +409,7 @@ static int pow_mod(const struct rsa_public_key *key, uint32_t *inout)
 		return -EINVAL;
 	}
 
-	uint32_t val[key->len], acc[key->len], tmp[key->len];
-	uint32_t a_scaled[key->len];
+	uint32_t val[key->len], tmp[key->len];
 	result = tmp;  /* Re-use location. */
 
 	/* Convert from big endian byte array to little endian word array. */
@@ -214,27 +430,10 @@ static int pow_mod(const struct rsa_public_key *key, uint32_t *inout)
 		return -EINVAL;
 	}
 
-	/* the bit at e[k-1] is 1 by definition, so start with: C := M */
-	montgomery_mul(key, acc, val, key->rr); /* acc = a * RR / R mod n */
-	/* retain scaled version for intermediate use */
-	memcpy(a_scaled, acc, key->len * sizeof(a_scaled[0]));
-
-	for (j = k - 2; j > 0; --j) {
-		montgomery_mul(key, tmp, acc, acc); /* tmp = acc^2 / R mod n */
-
-		if (is_public_exponent_bit_set(key, j)) {
-			/* acc = tmp * val / R mod n */
-			montgomery_mul(key, acc, tmp, a_scaled);
-		} else {
-			/* e[j] == 0, copy tmp back to acc for next operation */
-			memcpy(acc, tmp, key->len * sizeof(acc[0]));
-		}
-	}
-
-	/* the bit at e[0] is always 1 */
-	montgomery_mul(key, tmp, acc, acc); /* tmp = acc^2 / R mod n */
-	montgomery_mul(key, acc, tmp, val); /* acc = tmp * a / R mod M */
-	memcpy(result, acc, key->len * sizeof(result[0]));
+	if (RSA_HAVE_WORDS64 && !(key->len & 1))
+		pow_mod_words64(key, k, val, result);
+	else
+		pow_mod_words(key, k, val, result);
 
 	/* Make sure result < mod; result is at most 1x mod too large. */
 	if (greater_equal_modulus(key, result))
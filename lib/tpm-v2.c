@@ -31,16 +31,24 @@ const enum tpm2_algorithms tpm2_supported_algorithms[4] = {
 
 int tcg2_get_active_pcr_banks(struct udevice *dev, u32 *active_pcr_banks)
 {
+	struct tpm_chip_priv *priv = dev_get_uclass_priv(dev);
 	u32 supported = 0;
 	u32 pcr_banks = 0;
 	u32 active = 0;
 	int rc;
 
+	/* Save a TPM command for each event measured */
+	if (priv->active_pcr_banks) {
+		*active_pcr_banks = priv->active_pcr_banks;
+		return 0;
+	}
+
 	rc = tpm2_get_pcr_info(dev, &supported, &active, &pcr_banks);
 	if (rc)
 		return rc;
 
 	*active_pcr_banks = active;
+	priv->active_pcr_banks = active;
 
 	return 0;
 }
@@ -479,19 +487,11 @@ int tcg2_pcr_extend(struct udevice *dev, u32 pcr_index,
 		    struct tpml_digest_values *digest_list)
 {
 	u32 rc;
-	u32 i;
-
-	for (i = 0; i < digest_list->count; i++) {
-		u32 alg = digest_list->digests[i].hash_alg;
 
-		rc = tpm2_pcr_extend(dev, pcr_index, alg,
-				     (u8 *)&digest_list->digests[i].digest,
-				     tpm2_algorithm_to_len(alg));
-		if (rc) {
-			printf("%s: error pcr:%u alg:%08x\n", __func__,
-			       pcr_index, alg);
-			return rc;
-		}
+	rc = tpm2_pcr_extend_digests(dev, pcr_index, digest_list);
+	if (rc) {
+		printf("%s: error pcr:%u\n", __func__, pcr_index);
+		return rc;
 	}
 
 	return 0;
@@ -884,6 +884,61 @@ u32 tpm2_pcr_extend(struct udevice *dev, u32 index, u32 algorithm,
 	return tpm_sendrecv_command(dev, command_v2, NULL, NULL);
 }
 
+u32 tpm2_pcr_extend_digests(struct udevice *dev, u32 index,
+			    const struct tpml_digest_values *digest_list)
+{
+	/* Length of the message header, up to the number of hashes */
+	uint offset = 27;
+	u8 command_v2[COMMAND_BUFFER_SIZE] = {
+		tpm_u16(TPM2_ST_SESSIONS),	/* TAG */
+		tpm_u32(0),			/* Length, filled in below */
+		tpm_u32(TPM2_CC_PCR_EXTEND),	/* Command code */
+
+		/* HANDLE */
+		tpm_u32(index),			/* Handle (PCR Index) */
+
+		/* AUTH_SESSION */
+		tpm_u32(9),			/* Authorization size */
+		tpm_u32(TPM2_RS_PW),		/* Session handle */
+		tpm_u16(0),			/* Size of <nonce> */
+						/* <nonce> (if any) */
+		0,				/* Attributes: Cont/Excl/Rst */
+		tpm_u16(0),			/* Size of <hmac/password> */
+						/* <hmac/password> (if any) */
+
+		/* hashes, filled in below */
+	};
+	u32 i;
+	int ret;
+
+	ret = pack_byte_string(command_v2, sizeof(command_v2), "d", offset,
+			       digest_list->count);
+	if (ret)
+		return TPM_LIB_ERROR;
+	offset += sizeof(u32);
+
+	for (i = 0; i < digest_list->count; i++) {
+		u16 alg = digest_list->digests[i].hash_alg;
+		int len = tpm2_algorithm_to_len(alg);
+
+		if (!len)
+			return TPM_LIB_ERROR;
+		ret = pack_byte_string(command_v2, sizeof(command_v2), "ws",
+				       offset, alg, offset + sizeof(u16),
+				       (u8 *)&digest_list->digests[i].digest,
+				       len);
+		if (ret)
+			return TPM_LIB_ERROR;
+		offset += sizeof(u16) + len;
+	}
+
+	ret = pack_byte_string(command_v2, sizeof(command_v2), "d", 2, offset);
+	if (ret)
+		return TPM_LIB_ERROR;
+
+	return tpm_sendrecv_command(dev, command_v2, NULL, NULL);
+}
+
 u32 tpm2_nv_read_value(struct udevice *dev, u32 index, void *data, u32 count)
 {
 	u8 command_v2[COMMAND_BUFFER_SIZE] = {
@@ -33,6 +33,7 @@ struct trace_hdr {
 	struct trace_call *ftrace;	/* The function call records */
 	ulong ftrace_size;	/* Num. of ftrace records we have space for */
 	ulong ftrace_count;	/* Num. of ftrace records written */
+	ulong ftrace_pos;	/* Next record to write, with CONFIG_TRACE_RING */
 	ulong ftrace_too_deep_count;	/* Functions that were too deep */
 
 	int depth;		/* Depth of function calls */
@@ -110,7 +111,15 @@ static void notrace add_ftrace(void *func_ptr, void *caller, ulong flags)
 		hdr->ftrace_too_deep_count++;
 		return;
 	}
-	if (hdr->ftrace_count < hdr->ftrace_size) {
+	if (IS_ENABLED(CONFIG_TRACE_RING) && hdr->ftrace_size) {
+		struct trace_call *rec = &hdr->ftrace[hdr->ftrace_pos];
+
+		rec->func = func_ptr_to_num(func_ptr);
+		rec->caller = func_ptr_to_num(caller);
+		rec->flags = flags | (timer_get_us() & FUNCF_TIMESTAMP_MASK);
+		if (++hdr->ftrace_pos == hdr->ftrace_size)
+			hdr->ftrace_pos = 0;
+	} else if (hdr->ftrace_count < hdr->ftrace_size) {
 		struct trace_call *rec = &hdr->ftrace[hdr->ftrace_count];
 
 		rec->func = func_ptr_to_num(func_ptr);
@@ -251,7 +260,7 @@ int trace_list_calls(void *buff, size_t buff_size, size_t *needed)
 	struct trace_output_hdr *output_hdr = NULL;
 	void *end, *ptr = buff;
 	size_t rec, upto;
-	size_t count;
+	size_t count, first;
 
 	end = buff ? buff + buff_size : NULL;
 
@@ -262,13 +271,20 @@ int trace_list_calls(void *buff, size_t buff_size, size_t *needed)
 
 	/* Add information about each call */
 	count = hdr->ftrace_count;
-	if (count > hdr->ftrace_size)
+	first = 0;
+	if (count > hdr->ftrace_size) {
 		count = hdr->ftrace_size;
+
+		/* In a ring, the oldest record is the next to be written */
+		if (IS_ENABLED(CONFIG_TRACE_RING))
+			first = hdr->ftrace_pos;
+	}
 	for (rec = upto = 0; rec < count; rec++) {
 		if (ptr + sizeof(struct trace_call) < end) {
-			struct trace_call *call = &hdr->ftrace[rec];
+			struct trace_call *call;
 			struct trace_call *out = ptr;
 
+			call = &hdr->ftrace[(first + rec) % count];
 			out->func = call->func * FUNC_SITE_SIZE;
 			out->caller = call->caller * FUNC_SITE_SIZE;
 			out->flags = call->flags;
@@ -319,8 +335,10 @@ void trace_print_stats(void)
 	print_grouped_ull(count, 10);
 	puts(" traced function calls");
 	if (hdr->ftrace_count > hdr->ftrace_size) {
-		printf(" (%lu dropped due to overflow)",
-		       hdr->ftrace_count - hdr->ftrace_size);
+		printf(" (%lu %s due to overflow)",
+		       hdr->ftrace_count - hdr->ftrace_size,
+		       IS_ENABLED(CONFIG_TRACE_RING) ? "oldest dropped" :
+		       "dropped");
 	}
 
 	/* Add in minimum depth since the trace did not start at top level */
@@ -370,7 +388,8 @@ int notrace trace_init(void *buff, size_t buff_size)
 
 	if (!was_disabled) {
 #ifdef CONFIG_TRACE_EARLY
-		ulong used, count;
+		ulong used, count, first = 0;
+		struct trace_call *out;
 		char *end;
 
 		/*
@@ -391,9 +410,20 @@ int notrace trace_init(void *buff, size_t buff_size)
 			printf(" (%lu dropped due to overflow)",
 			       hdr->ftrace_count - hdr->ftrace_size);
 			hdr->ftrace_count = hdr->ftrace_size;
+			if (IS_ENABLED(CONFIG_TRACE_RING))
+				first = hdr->ftrace_pos;
 		}
 		puts("\n");
 		memcpy(buff, hdr, used);
+
+		/* Put the records of a full ring back in order */
+		if (first) {
+			out = buff + ((char *)hdr->ftrace - (char *)hdr);
+			memcpy(out, &hdr->ftrace[first],
+			       (count - first) * sizeof(*out));
+			memcpy(out + count - first, hdr->ftrace,
+			       first * sizeof(*out));
+		}
 #else
 		puts("trace: already enabled\n");
 		return -EALREADY;
@@ -417,6 +447,9 @@ int notrace trace_init(void *buff, size_t buff_size)
 	/* Use any remaining space for the timed function trace */
 	hdr->ftrace = (struct trace_call *)(buff + needed);
 	hdr->ftrace_size = (buff_size - needed) / sizeof(*hdr->ftrace);
+	hdr->ftrace_pos = hdr->ftrace_count;
+	if (hdr->ftrace_pos >= hdr->ftrace_size)
+		hdr->ftrace_pos = 0;
 	hdr->depth_limit = CONFIG_TRACE_CALL_DEPTH_LIMIT;
 
 	puts("trace: enabled\n");
@@ -9,3 +9,9 @@
  */
 
 void inflate_fast OF((z_streamp strm, unsigned start));
+
+/* inflate_fast_chunk() needs this much input and output space to run */
+#define INFLATE_CHUNK_MIN_INPUT 16
+#define INFLATE_CHUNK_MIN_OUTPUT (258 + 16)
+
+void inflate_fast_chunk OF((z_streamp strm, unsigned start));
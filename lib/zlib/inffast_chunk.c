@@ -0,0 +1,274 @@
+/* inffast_chunk.c -- fast decoding with a 64-bit bit buffer and chunked copies
+ * Based on inffast.c, Copyright (C) 1995-2008, 2010, 2013 Mark Adler
+ * For conditions of distribution and use, see copyright notice in zlib.h
+ */
+
+/* U-Boot: we already included these
+#include "zutil.h"
+#include "inftrees.h"
+#include "inflate.h"
+#include "inffast.h"
+*/
+
+/*
+   This is a variant of inflate_fast() for large input and output buffers,
+   as used when decompressing a whole image in one go. It differs from
+   inflate_fast() in that:
+
+    - The bit buffer is 64 bits wide and is refilled eight bytes at a time
+      with a single unaligned load, leaving at least 56 bits available. This
+      is enough for two literals followed by a complete length/distance pair
+      with only one further refill.
+
+    - Up to two literals are decoded per loop iteration before falling into
+      the general code, since runs of literals are common.
+
+    - Matches copied from the output buffer are copied eight bytes at a
+      time. Distances below eight are first doubled by copying the pattern
+      onto itself, which keeps the result periodic.
+
+   The chunked copies may write up to seven bytes beyond the end of a match,
+   so this relies on having INFLATE_CHUNK_MIN_OUTPUT bytes of output space
+   available, rather than the 258 needed by inflate_fast(). Reads are bounded
+   in the same way by INFLATE_CHUNK_MIN_INPUT, since each refill reads eight
+   bytes of input without checking. Bytes in the output buffer beyond
+   strm->next_out may be overwritten.
+
+   Entry assumptions:
+
+        state->mode == LEN
+        strm->avail_in >= INFLATE_CHUNK_MIN_INPUT
+        strm->avail_out >= INFLATE_CHUNK_MIN_OUTPUT
+        start >= strm->avail_out
+        state->bits < 8
+
+   On return, state->mode is one of:
+
+        LEN -- ran out of enough output space or enough available input
+        TYPE -- reached end of block code, inflate() to interpret next block
+        BAD -- error in block data
+ */
+
+/* refill the bit buffer so that it holds at least 56 bits */
+#define REFILL() \
+    do { \
+        hold |= get_unaligned_le64(in) << bits; \
+        in += (63 - bits) >> 3; \
+        bits |= 56; \
+    } while (0)
+
+/* copy len bytes from from to out, which may overlap, eight at a time */
+static inline unsigned char FAR *chunk_copy(unsigned char FAR *out,
+                                            const unsigned char FAR *from,
+                                            unsigned len)
+{
+    unsigned char FAR *end = out + len;
+
+    /*
+     * double short distances until chunks no longer overlap; the distance
+     * stays a multiple of the original one, so the pattern is preserved
+     */
+    while (out - from < 8 && out < end) {
+        unsigned dist = out - from;
+
+        zmemcpy(out, from, dist);
+        out += dist;
+    }
+    while (out < end) {
+        put_unaligned(get_unaligned((const u64 *)from), (u64 *)out);
+        out += 8;
+        from += 8;
+    }
+
+    return end;
+}
+
+void ZLIB_INTERNAL inflate_fast_chunk(z_streamp strm, unsigned start)
+{
+    struct inflate_state FAR *state;
+    z_const unsigned char FAR *in;      /* local strm->next_in */
+    z_const unsigned char FAR *last;    /* have enough input while in < last */
+    unsigned char FAR *out;     /* local strm->next_out */
+    unsigned char FAR *beg;     /* inflate()'s initial strm->next_out */
+    unsigned char FAR *end;     /* while out < end, enough space available */
+#ifdef INFLATE_STRICT
+    unsigned dmax;              /* maximum distance from zlib header */
+#endif
+    unsigned wsize;             /* window size or zero if not using window */
+    unsigned whave;             /* valid bytes in the window */
+    unsigned wnext;             /* window write index */
+    unsigned char FAR *window;  /* allocated sliding window, if wsize != 0 */
+    u64 hold;                   /* local strm->hold */
+    unsigned bits;              /* local strm->bits */
+    code const FAR *lcode;      /* local strm->lencode */
+    code const FAR *dcode;      /* local strm->distcode */
+    unsigned lmask;             /* mask for first level of length codes */
+    unsigned dmask;             /* mask for first level of distance codes */
+    code here;                  /* retrieved table entry */
+    unsigned op;                /* code bits, operation, extra bits, or */
+                                /*  window position, window bytes to copy */
+    unsigned len;               /* match length, unused bytes */
+    unsigned dist;              /* match distance */
+    unsigned char FAR *from;    /* where to copy match from */
+
+    /* copy state to local variables */
+    state = (struct inflate_state FAR *)strm->state;
+    in = strm->next_in;
+    last = in + (strm->avail_in - INFLATE_CHUNK_MIN_INPUT);
+    out = strm->next_out;
+    beg = out - (start - strm->avail_out);
+    end = out + (strm->avail_out - INFLATE_CHUNK_MIN_OUTPUT);
+#ifdef INFLATE_STRICT
+    dmax = state->dmax;
+#endif
+    wsize = state->wsize;
+    whave = state->whave;
+    wnext = state->wnext;
+    window = state->window;
+    hold = state->hold;
+    bits = state->bits;
+    lcode = state->lencode;
+    dcode = state->distcode;
+    lmask = (1U << state->lenbits) - 1;
+    dmask = (1U << state->distbits) - 1;
+
+    /* decode literals and length/distances until end-of-block or not enough
+       input data or output space */
+    do {
+        REFILL();
+        here = lcode[hold & lmask];
+        if (here.op == 0) {                     /* literal */
+            hold >>= here.bits;
+            bits -= here.bits;
+            *out++ = (unsigned char)(here.val);
+            here = lcode[hold & lmask];
+            if (here.op == 0) {                 /* another literal */
+                hold >>= here.bits;
+                bits -= here.bits;
+                *out++ = (unsigned char)(here.val);
+                here = lcode[hold & lmask];
+            }
+        }
+        /* a length/distance pair takes at most 48 bits */
+        if (bits < 48) {
+            REFILL();
+            here = lcode[hold & lmask];
+        }
+      dolen:
+        op = (unsigned)(here.bits);
+        hold >>= op;
+        bits -= op;
+        op = (unsigned)(here.op);
+        if (op == 0) {                          /* literal */
+            *out++ = (unsigned char)(here.val);
+        }
+        else if (op & 16) {                     /* length base */
+            len = (unsigned)(here.val);
+            op &= 15;                           /* number of extra bits */
+            if (op) {
+                len += (unsigned)hold & ((1U << op) - 1);
+                hold >>= op;
+                bits -= op;
+            }
+            here = dcode[hold & dmask];
+          dodist:
+            op = (unsigned)(here.bits);
+            hold >>= op;
+            bits -= op;
+            op = (unsigned)(here.op);
+            if (op & 16) {                      /* distance base */
+                dist = (unsigned)(here.val);
+                op &= 15;                       /* number of extra bits */
+                dist += (unsigned)hold & ((1U << op) - 1);
+#ifdef INFLATE_STRICT
+                if (dist > dmax) {
+                    strm->msg = (char *)"invalid distance too far back";
+                    state->mode = BAD;
+                    break;
+                }
+#endif
+                hold >>= op;
+                bits -= op;
+                op = (unsigned)(out - beg);     /* max distance in output */
+                if (dist > op) {                /* see if copy from window */
+                    op = dist - op;             /* distance back in window */
+                    if (op > whave) {
+                        strm->msg =
+                            (char *)"invalid distance too far back";
+                        state->mode = BAD;
+                        break;
+                    }
+                    from = window;
+                    if (wnext == 0) {           /* very common case */
+                        from += wsize - op;
+                    }
+                    else if (wnext < op) {      /* wrap around window */
+                        from += wsize + wnext - op;
+                        op -= wnext;
+                        if (op < len) {         /* some from end of window */
+                            len -= op;
+                            zmemcpy(out, from, op);
+                            out += op;
+                            from = window;
+                            op = wnext;
+                        }
+                    }
+                    else {                      /* contiguous in window */
+                        from += wnext - op;
+                    }
+                    if (op < len) {             /* some from window */
+                        len -= op;
+                        zmemcpy(out, from, op);
+                        out += op;
+                        out = chunk_copy(out, out - dist, len);
+                    }
+                    else {
+                        zmemcpy(out, from, len);
+                        out += len;
+                    }
+                }
+                else {                          /* copy direct from output */
+                    out = chunk_copy(out, out - dist, len);
+                }
+            }
+            else if ((op & 64) == 0) {          /* 2nd level distance code */
+                here = dcode[here.val + (hold & ((1U << op) - 1))];
+                goto dodist;
+            }
+            else {
+                strm->msg = (char *)"invalid distance code";
+                state->mode = BAD;
+                break;
+            }
+        }
+        else if ((op & 64) == 0) {              /* 2nd level length code */
+            here = lcode[here.val + (hold & ((1U << op) - 1))];
+            goto dolen;
+        }
+        else if (op & 32) {                     /* end-of-block */
+            state->mode = TYPE;
+            break;
+        }
+        else {
+            strm->msg = (char *)"invalid literal/length code";
+            state->mode = BAD;
+            break;
+        }
+    } while (in < last && out < end);
+
+    /* return unused bytes */
+    len = bits >> 3;
+    in -= len;
+    bits -= len << 3;
+    hold &= (1U << bits) - 1;
+
+    /* update state and return */
+    strm->next_in = in;
+    strm->next_out = out;
+    strm->avail_in = (unsigned)(last - in) + INFLATE_CHUNK_MIN_INPUT;
+    strm->avail_out = (unsigned)(end - out) + INFLATE_CHUNK_MIN_OUTPUT;
+    state->hold = (unsigned long)hold;
+    state->bits = bits;
+}
+
+#undef REFILL
@@ -541,7 +541,7 @@ int ZEXPORT inflate(z_streamp strm, int flush)
             strm->adler = state->check = adler32(0L, Z_NULL, 0);
             state->mode = TYPE;
         case TYPE:
-	    schedule();
+	    schedule_hot();
             if (flush == Z_BLOCK) goto inf_leave;
         case TYPEDO:
             if (state->last) {
@@ -719,7 +719,15 @@ int ZEXPORT inflate(z_streamp strm, int flush)
             Tracev((stderr, "inflate:       codes ok\n"));
             state->mode = LEN;
         case LEN:
-	    schedule();
+	    schedule_hot();
+            if (IS_ENABLED(CONFIG_ZLIB_INFLATE_CHUNK) &&
+                have >= INFLATE_CHUNK_MIN_INPUT &&
+                left >= INFLATE_CHUNK_MIN_OUTPUT) {
+                RESTORE();
+                inflate_fast_chunk(strm, out);
+                LOAD();
+                break;
+            }
             if (have >= 6 && left >= 258) {
                 RESTORE();
                 inflate_fast(strm, out);
@@ -26,6 +26,9 @@
 #include "inffast.h"
 #include "inffixed.h"
 #include "inffast.c"
+#if IS_ENABLED(CONFIG_ZLIB_INFLATE_CHUNK)
+#include "inffast_chunk.c"
+#endif
 #include "inftrees.c"
 #include "inflate.c"
 #include "zutil.c"
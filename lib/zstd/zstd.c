@@ -6,56 +6,378 @@
 #define LOG_CATEGORY	LOGC_BOOT
 
 #include <abuf.h>
+#include <cpu.h>
+#include <image.h>
 #include <log.h>
 #include <malloc.h>
+#include <asm/unaligned.h>
 #include <linux/errno.h>
 #include <linux/zstd.h>
 
-int zstd_decompress(struct abuf *in, struct abuf *out)
+/* Most frames to decompress at once, each needing its own workspace */
+#define ZSTD_MAX_JOBS	4
+
+/**
+ * struct zstd_frame_job - Decompression of one frame, perhaps on another CPU
+ *
+ * @job: CPU job
+ * @workspace: Workspace for the decompression context
+ * @wsize: Size of @workspace
+ * @src: Compressed frame
+ * @src_len: Size of @src
+ * @dst: Place to put the decompressed data
+ * @dst_len: Space available at @dst
+ * @exact: true if the decompressed data must fill @dst_len exactly
+ * @len: Returns the size of the decompressed data, or a zstd error code
+ */
+struct zstd_frame_job {
+	struct cpu_job job;
+	void *workspace;
+	size_t wsize;
+	const void *src;
+	size_t src_len;
+	void *dst;
+	size_t dst_len;
+	bool exact;
+	size_t len;
+};
+
+static int zstd_frame_job_run(struct cpu_job *job)
 {
+	struct zstd_frame_job *fj = container_of(job, struct zstd_frame_job,
+						 job);
 	zstd_dctx *ctx;
-	size_t wsize, len;
-	void *workspace;
+
+	ctx = zstd_init_dctx(fj->workspace, fj->wsize);
+	if (!ctx)
+		return -EPERM;
+
+	fj->len = zstd_decompress_dctx(ctx, fj->dst, fj->dst_len, fj->src,
+				       fj->src_len);
+	if (zstd_is_error(fj->len))
+		return -EINVAL;
+	if (fj->exact && fj->len != fj->dst_len)
+		return -EBADMSG;
+
+	return 0;
+}
+
+static int zstd_frame_job_wait(struct zstd_frame_job *fj)
+{
+	int ret;
+
+	ret = cpu_job_wait(&fj->job);
+	if (ret == -EPERM)
+		log_err("%s: zstd_init_dctx() failed\n", __func__);
+	else if (ret == -EBADMSG)
+		log_err("%s: frame is not the size in its header\n", __func__);
+	else if (ret)
+		log_err("%s: failed to decompress: %d\n", __func__,
+			zstd_get_error_code(fj->len));
+
+	return ret;
+}
+
+/**
+ * zstd_next_frame() - Find the next zstd frame, passing over skippable ones
+ *
+ * Anything which is not a frame is taken to be junk at the end of the data
+ *
+ * @srcp: Pointer to the data, updated to point to the frame
+ * @end: End of the data
+ * @hdr: Returns the frame header
+ * Return: size of the frame, or 0 if there are no more frames
+ */
+static size_t zstd_next_frame(const u8 **srcp, const u8 *end,
+			      zstd_frame_header *hdr)
+{
+	const u8 *src = *srcp;
+	size_t len;
+
+	while (src < end) {
+		if (zstd_get_frame_header(hdr, src, end - src))
+			break;
+		len = zstd_find_frame_compressed_size(src, end - src);
+		if (zstd_is_error(len))
+			break;
+		if (hdr->frameType != ZSTD_skippableFrame) {
+			*srcp = src;
+			return len;
+		}
+		src += len;
+	}
+
+	return 0;
+}
+
+/**
+ * zstd_count_frames() - Count the frames and work out their total size
+ *
+ * @src: Compressed data
+ * @end: End of the compressed data
+ * @totalp: Returns the total decompressed size, or ZSTD_CONTENTSIZE_UNKNOWN
+ *	if any frame does not record its size
+ * Return: number of frames
+ */
+static int zstd_count_frames(const u8 *src, const u8 *end, u64 *totalp)
+{
+	zstd_frame_header hdr;
+	u64 total = 0;
+	size_t len;
+	int count;
+
+	for (count = 0; (len = zstd_next_frame(&src, end, &hdr)); count++) {
+		if (hdr.frameContentSize == ZSTD_CONTENTSIZE_UNKNOWN)
+			total = ZSTD_CONTENTSIZE_UNKNOWN;
+		else if (total != ZSTD_CONTENTSIZE_UNKNOWN)
+			total += hdr.frameContentSize;
+		src += len;
+	}
+	*totalp = total;
+
+	return count;
+}
+
+/* Decompress each frame after the previous one, whatever its size */
+static int zstd_decompress_serial(struct zstd_frame_job *fj, const u8 *src,
+				  const u8 *end, struct abuf *out)
+{
+	zstd_frame_header hdr;
+	size_t pos = 0, len;
+	int ret;
+
+	while ((len = zstd_next_frame(&src, end, &hdr))) {
+		fj->src = src;
+		fj->src_len = len;
+		fj->dst = abuf_data(out) + pos;
+		fj->dst_len = abuf_size(out) - pos;
+		cpu_job_run(&fj->job);
+		ret = zstd_frame_job_wait(fj);
+		if (ret)
+			return ret;
+		src += len;
+		pos += fj->len;
+	}
+
+	return pos;
+}
+
+/*
+ * Use the sizes in the frame headers to place each frame's output, so that
+ * frames can be decompressed at the same time on different CPUs
+ */
+static int zstd_decompress_parallel(struct zstd_frame_job *jobs, int njobs,
+				    const u8 *src, const u8 *end,
+				    struct abuf *out)
+{
+	zstd_frame_header hdr;
+	size_t pos = 0, len;
+	int i, ret = 0;
+
+	for (i = 0; (len = zstd_next_frame(&src, end, &hdr)); i++) {
+		struct zstd_frame_job *fj = &jobs[i % njobs];
+
+		/* reuse the workspace once its last frame is done */
+		if (i >= njobs && cpu_job_wait(&fj->job))
+			break;
+		fj->src = src;
+		fj->src_len = len;
+		fj->dst = abuf_data(out) + pos;
+		fj->dst_len = hdr.frameContentSize;
+		fj->exact = true;
+		cpu_job_start(&fj->job);
+		src += len;
+		pos += fj->dst_len;
+	}
+
+	/* each job reports its error here, once it has finished */
+	for (i = 0; i < njobs; i++) {
+		int err = zstd_frame_job_wait(&jobs[i]);
+
+		if (!ret)
+			ret = err;
+	}
+
+	return ret ? ret : pos;
+}
+
+int zstd_decompress(struct abuf *in, struct abuf *out)
+{
+	struct zstd_frame_job jobs[ZSTD_MAX_JOBS];
+	const u8 *src = abuf_data(in);
+	const u8 *end = src + abuf_size(in);
+	int count, njobs, i;
+	size_t wsize;
+	u64 total;
 	int ret;
 
+	/*
+	 * There may be junk after the last frame, which
+	 * zstd_decompress_dctx() can't handle, so each frame is found first.
+	 * A payload made of several frames can be decompressed in parallel if
+	 * their sizes are known.
+	 */
+	count = zstd_count_frames(src, end, &total);
+	if (!count) {
+		log_err("%s: failed to detect compressed size\n", __func__);
+		return -EINVAL;
+	}
+	/*
+	 * Frames cannot be decompressed in parallel in place, since one could
+	 * overwrite the input of another before it is read
+	 */
+	njobs = 1;
+	if (CONFIG_IS_ENABLED(CPU_JOBS) && count > 1 &&
+	    total <= abuf_size(out) &&
+	    (src >= (u8 *)abuf_data(out) + abuf_size(out) ||
+	     end <= (u8 *)abuf_data(out)))
+		njobs = min(count, ZSTD_MAX_JOBS);
+
+	memset(jobs, '\0', sizeof(jobs));
 	wsize = zstd_dctx_workspace_bound();
-	workspace = malloc(wsize);
-	if (!workspace) {
+	for (i = 0; i < njobs; i++) {
+		struct zstd_frame_job *fj = &jobs[i];
+
+		fj->workspace = malloc(wsize);
+		if (!fj->workspace)
+			break;
+		fj->wsize = wsize;
+		fj->job.func = zstd_frame_job_run;
+		fj->job.done = true;
+	}
+	if (!i) {
 		debug("%s: cannot allocate workspace of size %zu\n", __func__,
-			wsize);
+		      wsize);
 		return -ENOMEM;
 	}
 
-	ctx = zstd_init_dctx(workspace, wsize);
-	if (!ctx) {
-		log_err("%s: zstd_init_dctx() failed\n", __func__);
-		ret = -EPERM;
-		goto do_free;
+	if (njobs > 1 && i > 1)
+		ret = zstd_decompress_parallel(jobs, i, src, end, out);
+	else
+		ret = zstd_decompress_serial(jobs, src, end, out);
+
+	while (i--)
+		free(jobs[i].workspace);
+
+	return ret;
+}
+
+/**
+ * zstd_frame_follows() - Check whether another frame follows the current one
+ *
+ * This makes sure that the magic number at the start of the next frame is in
+ * the buffer, reading more data if needed
+ *
+ * @rd: Reader for the compressed data
+ * @buf: Buffer for the compressed data, IMAGE_READ_CHUNK bytes
+ * @in_buf: Input-buffer state, updated if more data is read
+ * Return: 1 if a frame follows, 0 if not, -ve on error
+ */
+static long zstd_frame_follows(struct image_reader *rd, void *buf,
+			       zstd_in_buffer *in_buf)
+{
+	ulong len = in_buf->size;
+	u32 magic;
+	long ret;
+
+	if (in_buf->size - in_buf->pos < sizeof(magic)) {
+		ret = image_reader_fill(rd, buf, IMAGE_READ_CHUNK, in_buf->pos,
+					&len);
+		if (ret < 0)
+			return ret;
+		in_buf->size = len;
+		in_buf->pos = 0;
+		if (len < sizeof(magic))
+			return 0;
 	}
+	magic = get_unaligned_le32(in_buf->src + in_buf->pos);
 
-	/*
-	 * Find out how large the frame actually is, there may be junk at
-	 * the end of the frame that zstd_decompress_dctx() can't handle.
-	 */
-	len = zstd_find_frame_compressed_size(abuf_data(in), abuf_size(in));
-	if (zstd_is_error(len)) {
-		log_err("%s: failed to detect compressed size: %d\n", __func__,
-			zstd_get_error_code(len));
+	return magic == ZSTD_MAGICNUMBER ||
+		(magic & ZSTD_MAGIC_SKIPPABLE_MASK) == ZSTD_MAGIC_SKIPPABLE_START;
+}
+
+int zstd_decompress_read(struct image_reader *rd, struct abuf *out)
+{
+	zstd_in_buffer in_buf;
+	zstd_out_buffer out_buf;
+	zstd_frame_header hdr;
+	zstd_dstream *ds;
+	void *workspace = NULL;
+	size_t wsize, res, in_pos;
+	ulong len = 0;
+	void *buf;
+	long ret;
+
+	buf = malloc(IMAGE_READ_CHUNK);
+	if (!buf)
+		return -ENOMEM;
+
+	ret = image_reader_fill(rd, buf, IMAGE_READ_CHUNK, 0, &len);
+	if (ret < 0)
+		goto do_free;
+	res = zstd_get_frame_header(&hdr, buf, len);
+	if (res) {
+		log_err("%s: failed to read frame header\n", __func__);
 		ret = -EINVAL;
 		goto do_free;
 	}
 
-	len = zstd_decompress_dctx(ctx, abuf_data(out), abuf_size(out),
-				   abuf_data(in), len);
-	if (zstd_is_error(len)) {
-		log_err("%s: failed to decompress: %d\n", __func__,
-			zstd_get_error_code(len));
-		ret = -EINVAL;
+	/* The window is the only part of the data which must be kept */
+	wsize = zstd_dstream_workspace_bound(hdr.windowSize);
+	workspace = malloc(wsize);
+	if (!workspace) {
+		debug("%s: cannot allocate workspace of size %zu\n", __func__,
+		      wsize);
+		ret = -ENOMEM;
+		goto do_free;
+	}
+	ds = zstd_init_dstream(hdr.windowSize, workspace, wsize);
+	if (!ds) {
+		log_err("%s: zstd_init_dstream() failed\n", __func__);
+		ret = -EPERM;
 		goto do_free;
 	}
 
-	ret = len;
+	in_buf.src = buf;
+	in_buf.size = len;
+	in_buf.pos = 0;
+	out_buf.dst = abuf_data(out);
+	out_buf.size = abuf_size(out);
+	out_buf.pos = 0;
+	do {
+		if (in_buf.pos == in_buf.size) {
+			ret = image_reader_fill(rd, buf, IMAGE_READ_CHUNK,
+						in_buf.pos, &len);
+			if (ret <= 0) {
+				if (!ret)
+					ret = -EINVAL;
+				goto do_free;
+			}
+			in_buf.size = len;
+			in_buf.pos = 0;
+		}
+		in_pos = in_buf.pos;
+		res = zstd_decompress_stream(ds, &out_buf, &in_buf);
+		if (zstd_is_error(res)) {
+			log_err("%s: failed to decompress: %d\n", __func__,
+				zstd_get_error_code(res));
+			ret = -EINVAL;
+			goto do_free;
+		}
+		/* no progress is possible without more room for output */
+		if (res && out_buf.pos == out_buf.size &&
+		    in_buf.pos == in_pos && in_pos < in_buf.size) {
+			ret = -ENOSPC;
+			goto do_free;
+		}
+	} while (res || (ret = zstd_frame_follows(rd, buf, &in_buf)) > 0);
+	if (ret < 0)
+		goto do_free;
+
+	ret = out_buf.pos;
 do_free:
 	free(workspace);
+	free(buf);
+
 	return ret;
 }
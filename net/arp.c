@@ -16,6 +16,7 @@
 #include <linux/delay.h>
 
 #include "arp.h"
+#include "neigh.h"
 
 struct in_addr net_arp_wait_packet_ip;
 static struct in_addr net_arp_wait_reply_ip;
@@ -68,23 +69,33 @@ void arp_raw_request(struct in_addr source_ip, const uchar *target_ethaddr,
 	net_send_packet(arp_tx_packet, eth_hdr_size + ARP_HDR_SIZE);
 }
 
+/* Return the address to resolve to reach @ip: @ip itself or the gateway */
+static struct in_addr arp_next_hop(struct in_addr ip)
+{
+	if ((ip.s_addr & net_netmask.s_addr) !=
+	    (net_ip.s_addr & net_netmask.s_addr) && net_gateway.s_addr)
+		return net_gateway;
+
+	return ip;
+}
+
 void arp_request(void)
 {
 	if ((net_arp_wait_packet_ip.s_addr & net_netmask.s_addr) !=
-	    (net_ip.s_addr & net_netmask.s_addr)) {
-		if (net_gateway.s_addr == 0) {
-			puts("## Warning: gatewayip needed but not set\n");
-			net_arp_wait_reply_ip = net_arp_wait_packet_ip;
-		} else {
-			net_arp_wait_reply_ip = net_gateway;
-		}
-	} else {
-		net_arp_wait_reply_ip = net_arp_wait_packet_ip;
-	}
+	    (net_ip.s_addr & net_netmask.s_addr) && net_gateway.s_addr == 0)
+		puts("## Warning: gatewayip needed but not set\n");
+	net_arp_wait_reply_ip = arp_next_hop(net_arp_wait_packet_ip);
 
 	arp_raw_request(net_ip, net_null_ethaddr, net_arp_wait_reply_ip);
 }
 
+bool arp_lookup(struct in_addr ip, uchar *ethaddr)
+{
+	struct in_addr hop = arp_next_hop(ip);
+
+	return neigh_lookup(&hop, sizeof(hop), ethaddr);
+}
+
 int arp_timeout_check(void)
 {
 	ulong t;
@@ -116,6 +127,7 @@ void arp_receive(struct ethernet_hdr *et, struct ip_udp_hdr *ip, int len)
 	struct in_addr reply_ip_addr;
 	int eth_hdr_size;
 	uchar *tx_packet;
+	bool for_us;
 
 	/*
 	 * We have to deal with two types of ARP packets:
@@ -145,7 +157,15 @@ void arp_receive(struct ethernet_hdr *et, struct ip_udp_hdr *ip, int len)
 	if (net_ip.s_addr == 0)
 		return;
 
-	if (net_read_ip(&arp->ar_tpa).s_addr != net_ip.s_addr)
+	/*
+	 * Remember the sender of a packet for us and refresh a sender we
+	 * already know, e.g. from a gratuitous ARP
+	 */
+	for_us = net_read_ip(&arp->ar_tpa).s_addr == net_ip.s_addr;
+	if (net_read_ip(&arp->ar_spa).s_addr)
+		neigh_update(&arp->ar_spa, ARP_PLEN, &arp->ar_sha, for_us);
+
+	if (!for_us)
 		return;
 
 	switch (ntohs(arp->ar_op)) {
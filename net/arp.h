@@ -25,6 +25,18 @@ void arp_request(void);
 void arp_raw_request(struct in_addr source_ip, const uchar *targetEther,
 	struct in_addr target_ip);
 int arp_timeout_check(void);
+
+/**
+ * arp_lookup() - Look up the MAC address to send a packet to
+ *
+ * This looks in the neighbour cache for @ip, or for the gateway if @ip is not
+ * on the local network
+ *
+ * @ip: Destination of the packet
+ * @ethaddr: Returns the MAC address, if known
+ * Return: true if known, false if an ARP request is needed
+ */
+bool arp_lookup(struct in_addr ip, uchar *ethaddr);
 void arp_receive(struct ethernet_hdr *et, struct ip_udp_hdr *ip, int len);
 
 #endif /* __ARP_H__ */
@@ -49,6 +49,9 @@
 #define CFG_BOOTP_ID_CACHE_SIZE 4
 #endif
 
+/* Number of requests for the previous lease before falling back to DISCOVER */
+#define DHCP_INIT_REBOOT_TRIES	2
+
 u32		bootp_ids[CFG_BOOTP_ID_CACHE_SIZE];
 unsigned int	bootp_num_ids;
 int		bootp_try;
@@ -65,6 +68,8 @@ static dhcp_state_t dhcp_state = INIT;
 static u32 dhcp_leasetime;
 static struct in_addr dhcp_server_ip;
 static u8 dhcp_option_overload;
+/* Address from the previous lease while asking for it again, else 0 */
+static struct in_addr dhcp_reboot_ip;
 #define OVERLOAD_FILE 1
 #define OVERLOAD_SNAME 2
 static void dhcp_handler(uchar *pkt, unsigned dest, struct in_addr sip,
@@ -505,6 +510,12 @@ static int dhcp_extended(u8 *e, int message_type, struct in_addr server_ip,
 		*e++ = tmp >> 8;
 		*e++ = tmp & 0xff;
 	}
+
+	if (IS_ENABLED(CONFIG_BOOTP_RAPID_COMMIT) &&
+	    message_type == DHCP_DISCOVER) {
+		*e++ = 80;	/* Rapid Commit */
+		*e++ = 0;
+	}
 #if defined(CONFIG_BOOTP_SEND_HOSTNAME)
 	hostname = env_get("hostname");
 	if (hostname) {
@@ -733,6 +744,10 @@ void bootp_request(void)
 	bootstage_mark_name(BOOTSTAGE_ID_BOOTP_START, "bootp_start");
 #if defined(CONFIG_CMD_DHCP)
 	dhcp_state = INIT;
+	if (dhcp_reboot_ip.s_addr && bootp_try >= DHCP_INIT_REBOOT_TRIES) {
+		debug("DHCP: no reply for previous lease, discovering\n");
+		dhcp_reboot_ip.s_addr = 0;
+	}
 #endif
 
 	ep = env_get("bootpretryperiod");
@@ -792,10 +807,14 @@ void bootp_request(void)
 	memcpy(bp->bp_chaddr, net_ethaddr, 6);
 	copy_filename(bp->bp_file, net_boot_file_name, sizeof(bp->bp_file));
 
-	/* Request additional information from the BOOTP/DHCP server */
+	/*
+	 * Request additional information from the BOOTP/DHCP server. In the
+	 * INIT-REBOOT state, ask for the previous lease without a server ID
+	 */
 #if defined(CONFIG_CMD_DHCP)
-	extlen = dhcp_extended((u8 *)bp->bp_vend, DHCP_DISCOVER, zero_ip,
-			       zero_ip);
+	extlen = dhcp_extended((u8 *)bp->bp_vend,
+			       dhcp_reboot_ip.s_addr ? DHCP_REQUEST :
+			       DHCP_DISCOVER, zero_ip, dhcp_reboot_ip);
 #else
 	extlen = bootp_extended((u8 *)bp->bp_vend);
 #endif
@@ -824,7 +843,7 @@ void bootp_request(void)
 	net_set_timeout_handler(bootp_timeout, bootp_timeout_handler);
 
 #if defined(CONFIG_CMD_DHCP)
-	dhcp_state = SELECTING;
+	dhcp_state = dhcp_reboot_ip.s_addr ? INIT_REBOOT : SELECTING;
 	net_set_udp_handler(dhcp_handler);
 #else
 	net_set_udp_handler(bootp_handler);
@@ -1080,6 +1099,16 @@ static void dhcp_handler(uchar *pkt, unsigned dest, struct in_addr sip,
 	debug("DHCPHandler: got DHCP packet: (src=%d, dst=%d, len=%d) state: "
 	      "%d\n", src, dest, len, dhcp_state);
 
+	/* The server refused the previous lease, so start again */
+	if (dhcp_state == INIT_REBOOT &&
+	    dhcp_message_type((u8 *)bp->bp_vend) == DHCP_NAK) {
+		debug("DHCP: previous lease refused, discovering\n");
+		dhcp_reboot_ip.s_addr = 0;
+		env_set("dhcplease", NULL);
+		bootp_request();
+		return;
+	}
+
 	if (net_read_ip(&bp->bp_yiaddr).s_addr == 0) {
 #if defined(CONFIG_SERVERIP_FROM_PROXYDHCP)
 		store_bootp_params(bp);
@@ -1106,6 +1135,12 @@ static void dhcp_handler(uchar *pkt, unsigned dest, struct in_addr sip,
 				debug("got BOOTP response; transitioning to BOUND\n");
 				goto dhcp_got_bootp;
 			}
+			/* Only sent with rapid commit, so there is no offer */
+			if (IS_ENABLED(CONFIG_BOOTP_RAPID_COMMIT) &&
+			    dhcp_message_type((u8 *)bp->bp_vend) == DHCP_ACK) {
+				debug("got rapid-commit ACK; transitioning to BOUND\n");
+				goto dhcp_got_bootp;
+			}
 			dhcp_packet_process_options(bp);
 			if (CONFIG_IS_ENABLED(EFI_LOADER) &&
 			    IS_ENABLED(CONFIG_NETDEVICES))
@@ -1128,15 +1163,29 @@ static void dhcp_handler(uchar *pkt, unsigned dest, struct in_addr sip,
 
 		return;
 		break;
+	case INIT_REBOOT:
 	case REQUESTING:
-		debug("DHCP State: REQUESTING\n");
+		debug("DHCP State: %s\n",
+		      dhcp_state == INIT_REBOOT ? "INIT_REBOOT" : "REQUESTING");
 
 		if (dhcp_message_type((u8 *)bp->bp_vend) == DHCP_ACK) {
 dhcp_got_bootp:
 			dhcp_packet_process_options(bp);
+			/* No offer was passed on if the ACK came straight away */
+			if (dhcp_state != REQUESTING &&
+			    CONFIG_IS_ENABLED(EFI_LOADER) &&
+			    IS_ENABLED(CONFIG_NETDEVICES))
+				efi_net_set_dhcp_ack(pkt, len);
 			/* Store net params from reply */
 			store_net_params(bp);
 			dhcp_state = BOUND;
+			dhcp_reboot_ip.s_addr = 0;
+			if (IS_ENABLED(CONFIG_BOOTP_INIT_REBOOT)) {
+				char tmp[22];
+
+				ip_to_string(net_ip, tmp);
+				env_set("dhcplease", tmp);
+			}
 			printf("DHCP client bound to address %pI4 (%lu ms)\n",
 			       &net_ip, get_timer(bootp_start));
 			net_set_timeout_handler(0, (thand_f *)0);
@@ -1158,6 +1207,8 @@ dhcp_got_bootp:
 
 void dhcp_request(void)
 {
+	if (IS_ENABLED(CONFIG_BOOTP_INIT_REBOOT))
+		dhcp_reboot_ip = env_get_ip("dhcplease");
 	bootp_request();
 }
 #endif	/* CONFIG_CMD_DHCP */
@@ -12,6 +12,7 @@
 #include <dm.h>
 #include <env.h>
 #include <log.h>
+#include <malloc.h>
 #include <net.h>
 #include <nvmem.h>
 #include <asm/global_data.h>
@@ -48,6 +49,26 @@ struct eth_uclass_priv {
 /* eth_errno - This stores the most recent failure code from DM functions */
 static int eth_errno;
 
+/**
+ * struct eth_tx_queue - packets held back for send_batch()
+ *
+ * While a batch of received packets is processed, the replies are copied
+ * here so they can be sent together once processing is complete
+ *
+ * @dev: device the packets are for, or NULL if not collecting packets
+ * @buf: ETH_PACKETS_BATCH_SEND buffers of PKTSIZE_ALIGN bytes
+ * @pkts: packets to send
+ * @count: number of packets in @pkts
+ */
+struct eth_tx_queue {
+	struct udevice *dev;
+	uchar *buf;
+	struct eth_pkt pkts[ETH_PACKETS_BATCH_SEND];
+	int count;
+};
+
+static struct eth_tx_queue eth_txq;
+
 /* board-specific Ethernet Interface initializations. */
 __weak int board_interface_eth_init(struct udevice *dev,
 				    phy_interface_t interface_type)
@@ -375,6 +396,52 @@ int eth_is_active(struct udevice *dev)
 	return priv->state == ETH_STATE_ACTIVE;
 }
 
+/**
+ * eth_flush_tx() - send the packets held in the transmit queue
+ *
+ * Return: number of packets sent, or -ve on error
+ */
+static int eth_flush_tx(void)
+{
+	struct udevice *dev = eth_txq.dev;
+	int count = eth_txq.count;
+	int ret;
+
+	if (!count)
+		return 0;
+	eth_txq.count = 0;
+	if (!eth_is_active(dev))
+		return -EINVAL;
+
+	ret = eth_get_ops(dev)->send_batch(dev, eth_txq.pkts, count);
+	if (ret < 0)
+		debug("%s: send_batch() returned error %d\n", __func__, ret);
+
+	return ret;
+}
+
+/**
+ * eth_queue_tx() - add a packet to the transmit queue
+ *
+ * Return: 0 if queued, -ENOSPC if the packet should be sent directly
+ */
+static int eth_queue_tx(void *packet, int length)
+{
+	struct eth_pkt *pkt;
+
+	if (length > PKTSIZE_ALIGN)
+		return -ENOSPC;
+	if (eth_txq.count == ETH_PACKETS_BATCH_SEND)
+		eth_flush_tx();
+
+	pkt = &eth_txq.pkts[eth_txq.count++];
+	pkt->packet = eth_txq.buf + (pkt - eth_txq.pkts) * PKTSIZE_ALIGN;
+	pkt->length = length;
+	memcpy(pkt->packet, packet, length);
+
+	return 0;
+}
+
 int eth_send(void *packet, int length)
 {
 	struct udevice *current;
@@ -387,7 +454,10 @@ int eth_send(void *packet, int length)
 	if (!eth_is_active(current))
 		return -EINVAL;
 
-	ret = eth_get_ops(current)->send(current, packet, length);
+	if (eth_txq.dev == current && !eth_queue_tx(packet, length))
+		ret = 0;
+	else
+		ret = eth_get_ops(current)->send(current, packet, length);
 	if (ret < 0) {
 		/* We cannot completely return the error at present */
 		debug("%s: send() returned error %d\n", __func__, ret);
@@ -399,6 +469,63 @@ int eth_send(void *packet, int length)
 	return ret;
 }
 
+/**
+ * eth_rx_batch() - receive and process packets using recv_batch()
+ *
+ * Packets are fetched in batches until the driver has no more or
+ * ETH_PACKETS_BUDGET have been handled. If the driver supports
+ * send_batch(), any replies are sent together after each batch.
+ *
+ * @dev: Ethernet device
+ * Return: 0 if OK, -ENOSYS if the driver wants recv() used instead, other
+ *	-ve on error
+ */
+static int eth_rx_batch(struct udevice *dev)
+{
+	const struct eth_ops *ops = eth_get_ops(dev);
+	struct eth_pkt pkts[ETH_PACKETS_BATCH_RECV];
+	int flags = ETH_RECV_CHECK_DEVICE;
+	bool collect = false;
+	int budget, ret, i;
+
+	/* Replies are queued by eth_send() while eth_txq.dev is set */
+	if (ops->send_batch && !eth_txq.dev) {
+		if (!eth_txq.buf)
+			eth_txq.buf = memalign(PKTALIGN, ETH_PACKETS_BATCH_SEND *
+					       PKTSIZE_ALIGN);
+		if (eth_txq.buf) {
+			eth_txq.dev = dev;
+			collect = true;
+		}
+	}
+
+	for (budget = ETH_PACKETS_BUDGET; budget > 0; budget -= ret) {
+		for (i = 0; i < ETH_PACKETS_BATCH_RECV; i++)
+			pkts[i].flags = 0;
+		ret = ops->recv_batch(dev, flags, pkts,
+				      min(budget, ETH_PACKETS_BATCH_RECV));
+		flags = 0;
+		if (ret <= 0)
+			break;
+		for (i = 0; i < ret; i++) {
+			net_rx_csum_valid = pkts[i].flags & ETH_PKT_CSUM_VALID;
+			net_process_received_packet(pkts[i].packet,
+						    pkts[i].length);
+		}
+		net_rx_csum_valid = false;
+		for (i = 0; ops->free_pkt && i < ret; i++)
+			ops->free_pkt(dev, pkts[i].packet, pkts[i].length);
+		if (collect)
+			eth_flush_tx();
+	}
+	if (collect) {
+		eth_flush_tx();
+		eth_txq.dev = NULL;
+	}
+
+	return ret == -EAGAIN || ret > 0 ? 0 : ret;
+}
+
 int eth_rx(void)
 {
 	struct udevice *current;
@@ -414,6 +541,16 @@ int eth_rx(void)
 	if (!eth_is_active(current))
 		return -EINVAL;
 
+	if (eth_get_ops(current)->recv_batch) {
+		ret = eth_rx_batch(current);
+		if (ret != -ENOSYS) {
+			if (ret < 0)
+				debug("%s: recv_batch() returned error %d\n",
+				      __func__, ret);
+			return ret;
+		}
+	}
+
 	/* Process up to 32 packets at one time */
 	flags = ETH_RECV_CHECK_DEVICE;
 	for (i = 0; i < ETH_PACKETS_BATCH_RECV; i++) {
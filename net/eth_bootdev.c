@@ -64,6 +64,29 @@ static int eth_bootdev_bind(struct udevice *dev)
 	return 0;
 }
 
+static int eth_bootdev_start(struct bootdev_hunter *info)
+{
+	struct udevice *dev;
+
+	if (!test_eth_enabled())
+		return 0;
+
+	if (IS_ENABLED(CONFIG_PCI))
+		pci_init();
+
+	/*
+	 * Many drivers configure their PHY when probed, which starts
+	 * autonegotiation. Probe them now so the link can come up while other
+	 * media are scanned, rather than when DHCP is started. Any errors are
+	 * reported when hunting.
+	 */
+	for (uclass_first_device_check(UCLASS_ETH, &dev); dev;
+	     uclass_next_device_check(&dev))
+		;
+
+	return 0;
+}
+
 static int eth_bootdev_hunt(struct bootdev_hunter *info, bool show)
 {
 	int ret;
@@ -114,5 +137,6 @@ BOOTDEV_HUNTER(eth_bootdev_hunt) = {
 	.prio		= BOOTDEVP_6_NET_BASE,
 	.uclass		= UCLASS_ETH,
 	.hunt		= eth_bootdev_hunt,
+	.start		= eth_bootdev_start,
 	.drv		= DM_DRIVER_REF(eth_bootdev),
 };
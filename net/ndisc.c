@@ -15,6 +15,8 @@
 #include <stdlib.h>
 #include <linux/delay.h>
 
+#include "neigh.h"
+
 /* IPv6 destination address of packet waiting for ND */
 struct in6_addr net_nd_sol_packet_ip6 = ZERO_IPV6_ADDR;
 /* IPv6 address we are expecting ND advert from */
@@ -258,23 +260,36 @@ ip6_send_na(uchar *eth_dst_addr, struct in6_addr *neigh_addr,
 	net_send_packet(net_tx_packet, (pkt - net_tx_packet));
 }
 
+/* Set @hop to the address to resolve to reach @ip: @ip or the gateway */
+static void ndisc_next_hop(struct in6_addr *ip, struct in6_addr *hop)
+{
+	if (!ip6_addr_in_subnet(&net_ip6, ip, net_prefix_length) &&
+	    !ip6_is_unspecified_addr(&net_gateway6))
+		*hop = net_gateway6;
+	else
+		*hop = *ip;
+}
+
 void ndisc_request(void)
 {
 	if (!ip6_addr_in_subnet(&net_ip6, &net_nd_sol_packet_ip6,
-				net_prefix_length)) {
-		if (ip6_is_unspecified_addr(&net_gateway6)) {
-			puts("## Warning: gatewayip6 is needed but not set\n");
-			net_nd_rep_packet_ip6 = net_nd_sol_packet_ip6;
-		} else {
-			net_nd_rep_packet_ip6 = net_gateway6;
-		}
-	} else {
-		net_nd_rep_packet_ip6 = net_nd_sol_packet_ip6;
-	}
+				net_prefix_length) &&
+	    ip6_is_unspecified_addr(&net_gateway6))
+		puts("## Warning: gatewayip6 is needed but not set\n");
+	ndisc_next_hop(&net_nd_sol_packet_ip6, &net_nd_rep_packet_ip6);
 
 	ip6_send_ns(&net_nd_rep_packet_ip6);
 }
 
+bool ndisc_lookup(struct in6_addr *ip, uchar *ethaddr)
+{
+	struct in6_addr hop;
+
+	ndisc_next_hop(ip, &hop);
+
+	return neigh_lookup(&hop, sizeof(hop), ethaddr);
+}
+
 int ndisc_timeout_check(void)
 {
 	ulong t;
@@ -436,6 +451,7 @@ int ndisc_receive(struct ethernet_hdr *et, struct ip6_hdr *ip6, int len)
 	struct nd_msg *ndisc = (struct nd_msg *)icmp;
 	uchar neigh_eth_addr[6];
 	int err = 0;	// The error code returned calling functions.
+	bool waiting;
 
 	switch (icmp->icmp6_type) {
 	case IPV6_NDISC_NEIGHBOUR_SOLICITATION:
@@ -444,24 +460,31 @@ int ndisc_receive(struct ethernet_hdr *et, struct ip6_hdr *ip6, int len)
 		if (ip6_is_our_addr(&ndisc->target) &&
 		    ndisc_has_option(ip6, ND_OPT_SOURCE_LL_ADDR)) {
 			ndisc_extract_enetaddr(ndisc, neigh_eth_addr);
+			neigh_update(&ip6->saddr, sizeof(ip6->saddr),
+				     neigh_eth_addr, true);
 			ip6_send_na(neigh_eth_addr, &ip6->saddr,
 				    &ndisc->target);
 		}
 		break;
 
 	case IPV6_NDISC_NEIGHBOUR_ADVERTISEMENT:
-		/* are we waiting for a reply ? */
-		if (ip6_is_unspecified_addr(&net_nd_sol_packet_ip6))
+		if (!ndisc_has_option(ip6, ND_OPT_TARGET_LL_ADDR))
 			break;
+		ndisc_extract_enetaddr(ndisc, neigh_eth_addr);
 
-		if ((memcmp(&ndisc->target, &net_nd_rep_packet_ip6,
-			    sizeof(struct in6_addr)) == 0) &&
-		    ndisc_has_option(ip6, ND_OPT_TARGET_LL_ADDR)) {
-			ndisc_extract_enetaddr(ndisc, neigh_eth_addr);
+		/* are we waiting for a reply ? */
+		waiting = !ip6_is_unspecified_addr(&net_nd_sol_packet_ip6) &&
+			!memcmp(&ndisc->target, &net_nd_rep_packet_ip6,
+				sizeof(struct in6_addr));
+
+		/* refresh a neighbour we know, e.g. from an unsolicited NA */
+		neigh_update(&ndisc->target, sizeof(ndisc->target),
+			     neigh_eth_addr, waiting);
 
+		if (waiting) {
 			/* save address for later use */
-			if (!net_nd_packet_mac)
-				net_nd_packet_mac = neigh_eth_addr;
+			if (net_nd_packet_mac)
+				memcpy(net_nd_packet_mac, neigh_eth_addr, 6);
 
 			/* modify header, and transmit it */
 			memcpy(((struct ethernet_hdr *)net_nd_tx_packet)->et_dest,
@@ -0,0 +1,111 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Cache of the MAC addresses of neighbours, from ARP and neighbour discovery
+ *
+ * Each network command clears the server's MAC address, so without this every
+ * tftp, wget or dns command starts by resolving it again.
+ */
+
+#include <net.h>
+#include <time.h>
+#include <linux/string.h>
+
+#include "neigh.h"
+
+#define NEIGH_ADDR_MAX	16
+
+/**
+ * struct neigh_entry - A neighbour
+ *
+ * @len: Length of @addr, 0 if this entry is not in use
+ * @addr: IPv4 or IPv6 address, in network order
+ * @ethaddr: MAC address
+ * @time: Time when @ethaddr was last confirmed, from get_timer()
+ */
+struct neigh_entry {
+	int len;
+	u8 addr[NEIGH_ADDR_MAX];
+	uchar ethaddr[ARP_HLEN];
+	ulong time;
+};
+
+static struct neigh_entry neigh_cache[CONFIG_NET_NEIGH_CACHE_SIZE];
+
+/* MAC address of the device the entries were learned on */
+static uchar neigh_ethaddr[ARP_HLEN];
+
+void neigh_flush(void)
+{
+	memset(neigh_cache, '\0', sizeof(neigh_cache));
+}
+
+/* Drop the entries if they were learned on a different device */
+static void neigh_check_dev(void)
+{
+	if (memcmp(neigh_ethaddr, net_ethaddr, ARP_HLEN)) {
+		neigh_flush();
+		memcpy(neigh_ethaddr, net_ethaddr, ARP_HLEN);
+	}
+}
+
+static struct neigh_entry *neigh_find(const void *addr, int len)
+{
+	int i;
+
+	for (i = 0; i < CONFIG_NET_NEIGH_CACHE_SIZE; i++) {
+		struct neigh_entry *entry = &neigh_cache[i];
+
+		if (entry->len == len && !memcmp(entry->addr, addr, len))
+			return entry;
+	}
+
+	return NULL;
+}
+
+bool neigh_lookup(const void *addr, int len, uchar *ethaddr)
+{
+	struct neigh_entry *entry;
+
+	neigh_check_dev();
+	entry = neigh_find(addr, len);
+	if (!entry)
+		return false;
+	if (get_timer(entry->time) > CONFIG_NET_NEIGH_CACHE_TTL * 1000UL) {
+		entry->len = 0;
+		return false;
+	}
+	memcpy(ethaddr, entry->ethaddr, ARP_HLEN);
+
+	return true;
+}
+
+void neigh_update(const void *addr, int len, const uchar *ethaddr,
+		  bool create)
+{
+	struct neigh_entry *entry;
+	int i;
+
+	if (len > NEIGH_ADDR_MAX || !is_valid_ethaddr(ethaddr))
+		return;
+	neigh_check_dev();
+	entry = neigh_find(addr, len);
+	if (!entry) {
+		if (!create)
+			return;
+		/* use a free entry, or replace the oldest */
+		entry = &neigh_cache[0];
+		for (i = 0; i < CONFIG_NET_NEIGH_CACHE_SIZE; i++) {
+			if (!neigh_cache[i].len) {
+				entry = &neigh_cache[i];
+				break;
+			}
+			if (get_timer(neigh_cache[i].time) >
+			    get_timer(entry->time))
+				entry = &neigh_cache[i];
+		}
+		entry->len = len;
+		memcpy(entry->addr, addr, len);
+	}
+	memcpy(entry->ethaddr, ethaddr, ARP_HLEN);
+	entry->time = get_timer(0);
+}
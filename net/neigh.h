@@ -0,0 +1,54 @@
+/* SPDX-License-Identifier: GPL-2.0+ */
+/*
+ * Cache of the MAC addresses of neighbours, from ARP and neighbour discovery
+ */
+
+#ifndef __NEIGH_H__
+#define __NEIGH_H__
+
+#include <linux/types.h>
+
+#if IS_ENABLED(CONFIG_NET_NEIGH_CACHE)
+/**
+ * neigh_lookup() - Look up the MAC address of a neighbour
+ *
+ * @addr: IPv4 or IPv6 address of the neighbour, in network order
+ * @len: Length of @addr (4 or 16)
+ * @ethaddr: Returns the MAC address, if found
+ * Return: true if found and not expired, false if not
+ */
+bool neigh_lookup(const void *addr, int len, uchar *ethaddr);
+
+/**
+ * neigh_update() - Record the MAC address of a neighbour
+ *
+ * @addr: IPv4 or IPv6 address of the neighbour, in network order
+ * @len: Length of @addr (4 or 16)
+ * @ethaddr: MAC address of the neighbour
+ * @create: true to add the neighbour if it is not known, false to only
+ *	update an existing entry (e.g. from a gratuitous ARP)
+ */
+void neigh_update(const void *addr, int len, const uchar *ethaddr,
+		  bool create);
+
+/**
+ * neigh_flush() - Forget all neighbours
+ */
+void neigh_flush(void);
+#else
+static inline bool neigh_lookup(const void *addr, int len, uchar *ethaddr)
+{
+	return false;
+}
+
+static inline void neigh_update(const void *addr, int len,
+				const uchar *ethaddr, bool create)
+{
+}
+
+static inline void neigh_flush(void)
+{
+}
+#endif
+
+#endif /* __NEIGH_H__ */
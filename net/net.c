@@ -84,6 +84,7 @@
 #include <bootstage.h>
 #include <command.h>
 #include <console.h>
+#include <cpu_func.h>
 #include <env.h>
 #include <env_internal.h>
 #include <errno.h>
@@ -116,6 +117,7 @@
 #include "dns.h"
 #endif
 #include "link_local.h"
+#include "neigh.h"
 #include "nfs.h"
 #include "ping.h"
 #include "rarp.h"
@@ -154,6 +156,8 @@ struct in_addr	net_server_ip;
 uchar *net_rx_packet;
 /* Current rx packet length */
 int		net_rx_packet_len;
+/* Current rx packet's UDP/TCP checksum was checked by the hardware */
+bool		net_rx_csum_valid;
 /* IP packet ID */
 static unsigned	net_ip_id;
 /* Ethernet bcast address */
@@ -203,6 +207,10 @@ static thand_f *time_handler;
 static ulong	time_start;
 /* Current timeout value */
 static ulong	time_delta;
+/* Number of packets received, to tell when the network is quiet */
+static uint	net_rx_count;
+/* Time in ms without packets after which net_loop() lets the CPU rest */
+#define NET_IDLE_MS	1
 /* THE transmit packet */
 uchar *net_tx_packet;
 
@@ -430,6 +438,8 @@ int net_loop(enum proto_t protocol)
 {
 	int ret = -EINVAL;
 	enum net_loop_state prev_net_state = net_state;
+	ulong quiet_start = get_timer(0);
+	uint rx_count;
 
 #if defined(CONFIG_CMD_PING)
 	if (protocol != PING)
@@ -646,8 +656,17 @@ restart:
 		 *	Most drivers return the most recent packet size, but not
 		 *	errors that may have happened.
 		 */
+		rx_count = net_rx_count;
 		eth_rx();
 
+		/* Rest only once no packets have arrived for a while */
+		if (IS_ENABLED(CONFIG_CPU_IDLE)) {
+			if (net_rx_count != rx_count)
+				quiet_start = get_timer(0);
+			else if (get_timer(quiet_start) >= NET_IDLE_MS)
+				cpu_idle();
+		}
+
 		/*
 		 *	Abort if ctrl-c was pressed.
 		 */
@@ -776,6 +795,9 @@ int net_start_again(void)
 	unsigned long retrycnt = 0;
 	int ret;
 
+	/* a neighbour whose MAC address changed may be why this failed */
+	neigh_flush();
+
 	nretry = env_get("netretry");
 	if (nretry) {
 		if (!strcmp(nretry, "yes"))
@@ -929,6 +951,8 @@ int net_send_ip_packet(uchar *ether, struct in_addr dest, int dport, int sport,
 	/* if broadcast, make the ether address a broadcast and don't do ARP */
 	if (dest.s_addr == 0xFFFFFFFF)
 		ether = (uchar *)net_bcast_ethaddr;
+	else if (!memcmp(ether, net_null_ethaddr, 6))
+		arp_lookup(dest, ether);
 
 	pkt = (uchar *)net_tx_packet;
 
@@ -1200,6 +1224,7 @@ void net_process_received_packet(uchar *in_packet, int len)
 	ushort cti = 0, vlanid = VLAN_NONE, myvlanid, mynvlanid;
 
 	debug_cond(DEBUG_NET_PKT, "packet received\n");
+	net_rx_count++;
 	if (DEBUG_NET_PKT_TRACE)
 		print_hex_dump_bytes("rx: ", DUMP_PREFIX_OFFSET, in_packet,
 				     len);
@@ -1401,9 +1426,9 @@ void net_process_received_packet(uchar *in_packet, int len)
 			   "received UDP (to=%pI4, from=%pI4, len=%d)\n",
 			   &dst_ip, &src_ip, len);
 
-		if (IS_ENABLED(CONFIG_UDP_CHECKSUM) && ip->udp_xsum != 0) {
+		if (IS_ENABLED(CONFIG_UDP_CHECKSUM) && ip->udp_xsum != 0 &&
+		    !net_rx_csum_valid) {
 			ulong   xsum;
-			u8 *sumptr;
 			ushort  sumlen;
 
 			xsum  = ip->ip_p;
@@ -1413,17 +1438,10 @@ void net_process_received_packet(uchar *in_packet, int len)
 			xsum += (ntohl(ip->ip_dst.s_addr) >> 16) & 0x0000ffff;
 			xsum += (ntohl(ip->ip_dst.s_addr) >>  0) & 0x0000ffff;
 
+			/* The IP header is 16-bit aligned, so this is too */
 			sumlen = ntohs(ip->udp_len);
-			sumptr = (u8 *)&ip->udp_src;
-
-			while (sumlen > 1) {
-				/* inlined ntohs() to avoid alignment errors */
-				xsum += (sumptr[0] << 8) + sumptr[1];
-				sumptr += 2;
-				sumlen -= 2;
-			}
-			if (sumlen > 0)
-				xsum += (sumptr[0] << 8) + sumptr[0];
+			xsum += ~ntohs(compute_ip_checksum(&ip->udp_src,
+							   sumlen)) & 0xffff;
 			while ((xsum >> 16) != 0) {
 				xsum = (xsum & 0x0000ffff) +
 				       ((xsum >> 16) & 0x0000ffff);
@@ -347,7 +347,7 @@ int net_send_udp_packet6(uchar *ether, struct in6_addr *dest, int dport,
 	/* if MAC address was not discovered yet, save the packet and do
 	 * neighbour discovery
 	 */
-	if (!memcmp(ether, net_null_ethaddr, 6)) {
+	if (!memcmp(ether, net_null_ethaddr, 6) && !ndisc_lookup(dest, ether)) {
 		net_copy_ip6(&net_nd_sol_packet_ip6, dest);
 		net_nd_packet_mac = ether;
 
@@ -50,12 +50,32 @@
 #define NFS_RPC_ERR	1
 #define NFS_RPC_DROP	124
 
+#if NFS_READ_SIZE > 1024 && \
+	(!defined(CONFIG_IP_DEFRAG) || CONFIG_NET_MAXDEFRAG < NFS_READ_SIZE + 512)
+#error "CONFIG_NFS_READ_SIZE needs CONFIG_IP_DEFRAG and a larger CONFIG_NET_MAXDEFRAG"
+#endif
+
 static int fs_mounted;
 static unsigned long rpc_id;
-static int nfs_offset = -1;
-static int nfs_len;
 static const ulong nfs_timeout = CONFIG_NFS_TIMEOUT;
 
+/**
+ * struct nfs_read - An outstanding read request
+ *
+ * @id: RPC id of the request, 0 if this entry is not in use
+ * @offset: Offset in the file of the first byte requested
+ * @len: Number of bytes requested
+ */
+struct nfs_read {
+	unsigned long id;
+	int offset;
+	int len;
+};
+
+static struct nfs_read nfs_reads[NFS_READ_WINDOW];
+static int nfs_read_next;	/* offset of the next block to request */
+static int nfs_read_eof;	/* size of the file, or -1 if not known yet */
+
 static char dirfh[NFS3_FHSIZE]; /* NFSv2 / NFSv3 file handle of directory */
 static unsigned int dirfh3_length; /* (variable) length of dirfh when NFSv3 */
 static char filefh[NFS3_FHSIZE]; /* NFSv2 / NFSv3 file handle */
@@ -395,7 +415,7 @@ static void nfs_lookup_req(char *fname)
 /**************************************************************************
 NFS_READ - Read File on NFS Server
 **************************************************************************/
-static void nfs_read_req(int offset, int readlen)
+static void nfs_read_req(struct nfs_read *req)
 {
 	uint32_t data[1024];
 	uint32_t *p;
@@ -407,22 +427,76 @@ static void nfs_read_req(int offset, int readlen)
 	if (choosen_nfs_version != NFS_V3) {
 		memcpy(p, filefh, NFS_FHSIZE);
 		p += (NFS_FHSIZE / 4);
-		*p++ = htonl(offset);
-		*p++ = htonl(readlen);
+		*p++ = htonl(req->offset);
+		*p++ = htonl(req->len);
 		*p++ = 0;
 	} else { /* NFS_V3 */
 		*p++ = htonl(filefh3_length);
 		memcpy(p, filefh, filefh3_length);
 		p += (filefh3_length / 4);
 		*p++ = htonl(0); /* offset is 64-bit long, so fill with 0 */
-		*p++ = htonl(offset);
-		*p++ = htonl(readlen);
+		*p++ = htonl(req->offset);
+		*p++ = htonl(req->len);
 		*p++ = 0;
 	}
 
 	len = (uint32_t *)p - (uint32_t *)&(data[0]);
 
 	rpc_req(PROG_NFS, NFS_READ, data, len);
+	req->id = rpc_id;
+}
+
+/**
+ * nfs_read_next_req() - Request the next block of the file
+ *
+ * Nothing is sent once the end of the file is known and has been requested
+ *
+ * @req: Entry to use, which must not be in use
+ */
+static void nfs_read_next_req(struct nfs_read *req)
+{
+	if (nfs_read_eof >= 0 && nfs_read_next >= nfs_read_eof)
+		return;
+	req->offset = nfs_read_next;
+	req->len = NFS_READ_SIZE;
+	nfs_read_next += NFS_READ_SIZE;
+	nfs_read_req(req);
+}
+
+/* Start reading the file, with up to NFS_READ_WINDOW requests outstanding */
+static void nfs_read_start(void)
+{
+	int i;
+
+	memset(nfs_reads, '\0', sizeof(nfs_reads));
+	nfs_read_next = 0;
+	nfs_read_eof = -1;
+	for (i = 0; i < NFS_READ_WINDOW; i++)
+		nfs_read_next_req(&nfs_reads[i]);
+}
+
+/* Send all the outstanding read requests again */
+static void nfs_read_resend(void)
+{
+	int i;
+
+	for (i = 0; i < NFS_READ_WINDOW; i++) {
+		if (nfs_reads[i].id)
+			nfs_read_req(&nfs_reads[i]);
+	}
+}
+
+/* Return true if no read requests are outstanding */
+static bool nfs_read_idle(void)
+{
+	int i;
+
+	for (i = 0; i < NFS_READ_WINDOW; i++) {
+		if (nfs_reads[i].id)
+			return false;
+	}
+
+	return true;
 }
 
 /**************************************************************************
@@ -455,7 +529,7 @@ static void nfs_send(void)
 		nfs_lookup_req(nfs_filename);
 		break;
 	case STATE_READ_REQ:
-		nfs_read_req(nfs_offset, nfs_len);
+		nfs_read_resend();
 		break;
 	case STATE_READLINK_REQ:
 		nfs_readlink_req();
@@ -711,20 +785,43 @@ static int nfs_readlink_reply(uchar *pkt, unsigned len)
 	return 0;
 }
 
-static int nfs_read_reply(uchar *pkt, unsigned len)
+/**
+ * nfs_read_reply() - Handle the reply to a read request
+ *
+ * The data is stored straight from the packet, at the offset requested
+ *
+ * @pkt: Reply packet
+ * @len: Length of @pkt
+ * @reqp: Returns the request this is the reply to
+ * @eofp: Returns true if the server says the end of the file was reached
+ * Return: number of bytes read, -NFS_RPC_DROP if the reply is not for an
+ *	outstanding request, other -ve on error
+ */
+static int nfs_read_reply(uchar *pkt, unsigned len, struct nfs_read **reqp,
+			  bool *eofp)
 {
 	struct rpc_t rpc_pkt;
-	int rlen;
-	uchar *data_ptr;
+	struct nfs_read *req = NULL;
+	unsigned long id;
+	int rlen, i;
+	uint data_off;
 
 	debug("%s\n", __func__);
 
-	memcpy(&rpc_pkt.u.data[0], pkt, sizeof(rpc_pkt.u.reply));
+	/* Only the header is needed; the data is stored from @pkt */
+	memcpy(&rpc_pkt.u.data[0], pkt,
+	       min_t(uint, len, sizeof(rpc_pkt.u.reply) - NFS_READ_SIZE));
 
-	if (ntohl(rpc_pkt.u.reply.id) > rpc_id)
+	id = ntohl(rpc_pkt.u.reply.id);
+	if (id > rpc_id)
 		return -NFS_RPC_ERR;
-	else if (ntohl(rpc_pkt.u.reply.id) < rpc_id)
+	for (i = 0; i < NFS_READ_WINDOW; i++) {
+		if (nfs_reads[i].id && nfs_reads[i].id == id)
+			req = &nfs_reads[i];
+	}
+	if (!req)
 		return -NFS_RPC_DROP;
+	*reqp = req;
 
 	if (rpc_pkt.u.reply.rstatus  ||
 	    rpc_pkt.u.reply.verifier ||
@@ -737,38 +834,74 @@ static int nfs_read_reply(uchar *pkt, unsigned len)
 		return -ntohl(rpc_pkt.u.reply.data[0]);
 	}
 
-	if ((nfs_offset != 0) && !((nfs_offset) %
+	if ((req->offset != 0) && !((req->offset) %
 			(NFS_READ_SIZE / 2 * 10 * HASHES_PER_LINE)))
 		puts("\n\t ");
-	if (!(nfs_offset % ((NFS_READ_SIZE / 2) * 10)))
+	if (!(req->offset % ((NFS_READ_SIZE / 2) * 10)))
 		putc('#');
 
 	if (choosen_nfs_version != NFS_V3) {
 		rlen = ntohl(rpc_pkt.u.reply.data[18]);
-		data_ptr = (uchar *)&(rpc_pkt.u.reply.data[19]);
+		data_off = (uchar *)&rpc_pkt.u.reply.data[19] -
+			(uchar *)&rpc_pkt;
+		*eofp = false;
 	} else {  /* NFS_V3 */
 		int nfsv3_data_offset =
 			nfs3_get_attributes_offset(rpc_pkt.u.reply.data);
 
 		/* count value */
 		rlen = ntohl(rpc_pkt.u.reply.data[1 + nfsv3_data_offset]);
-		/* Skip unused values :
-			EOF:		32 bits value,
-			data_size:	32 bits value,
-		*/
-		data_ptr = (uchar *)
-			&(rpc_pkt.u.reply.data[4 + nfsv3_data_offset]);
+		*eofp = rpc_pkt.u.reply.data[2 + nfsv3_data_offset];
+		/* Skip unused value data_size: 32 bits value */
+		data_off = (uchar *)&rpc_pkt.u.reply.data[4 + nfsv3_data_offset] -
+			(uchar *)&rpc_pkt;
 	}
 
-	if (((uchar *)&(rpc_pkt.u.reply.data[0]) - (uchar *)(&rpc_pkt) + rlen) > len)
-			return -9999;
+	if (rlen < 0 || rlen > req->len || data_off + rlen > len)
+		return -9999;
 
-	if (store_block(data_ptr, nfs_offset, rlen))
-			return -9999;
+	/* a request past the end of the file must not change its size */
+	if (rlen && store_block(pkt + data_off, req->offset, rlen))
+		return -9999;
 
 	return rlen;
 }
 
+/**
+ * nfs_read_done() - Record a block received and request the next one
+ *
+ * A short read with no end of file is requested again for the rest of the
+ * block. Once the end of the file is known, requests beyond it are dropped.
+ *
+ * @req: Request which was answered
+ * @rlen: Number of bytes received
+ * @eof: true if the server says the end of the file was reached
+ */
+static void nfs_read_done(struct nfs_read *req, int rlen, bool eof)
+{
+	int i;
+
+	if (!rlen || eof) {
+		int end = req->offset + rlen;
+
+		if (nfs_read_eof < 0 || end < nfs_read_eof)
+			nfs_read_eof = end;
+		for (i = 0; i < NFS_READ_WINDOW; i++) {
+			if (nfs_reads[i].offset >= nfs_read_eof)
+				nfs_reads[i].id = 0;
+		}
+	}
+
+	if (rlen && rlen < req->len && !eof) {
+		req->offset += rlen;
+		req->len -= rlen;
+		nfs_read_req(req);
+	} else {
+		req->id = 0;
+		nfs_read_next_req(req);
+	}
+}
+
 /**************************************************************************
 Interfaces of U-BOOT
 **************************************************************************/
@@ -789,8 +922,10 @@ static void nfs_timeout_handler(void)
 static void nfs_handler(uchar *pkt, unsigned dest, struct in_addr sip,
 			unsigned src, unsigned len)
 {
+	struct nfs_read *req;
 	int rlen;
 	int reply;
+	bool eof;
 
 	debug("%s\n", __func__);
 
@@ -865,9 +1000,7 @@ static void nfs_handler(uchar *pkt, unsigned dest, struct in_addr sip,
 			nfs_send();
 		} else {
 			nfs_state = STATE_READ_REQ;
-			nfs_offset = 0;
-			nfs_len = NFS_READ_SIZE;
-			nfs_send();
+			nfs_read_start();
 		}
 		break;
 
@@ -890,22 +1023,23 @@ static void nfs_handler(uchar *pkt, unsigned dest, struct in_addr sip,
 		break;
 
 	case STATE_READ_REQ:
-		rlen = nfs_read_reply(pkt, len);
+		rlen = nfs_read_reply(pkt, len, &req, &eof);
 		if (rlen == -NFS_RPC_DROP)
 			break;
 		net_set_timeout_handler(nfs_timeout, nfs_timeout_handler);
-		if (rlen > 0) {
-			nfs_offset += rlen;
+		if (rlen >= 0) {
+			nfs_read_done(req, rlen, eof);
+			if (!nfs_read_idle())
+				break;
+			nfs_download_state = NETLOOP_SUCCESS;
+			nfs_state = STATE_UMOUNT_REQ;
 			nfs_send();
 		} else if ((rlen == -NFSERR_ISDIR) || (rlen == -NFSERR_INVAL)) {
 			/* symbolic link */
 			nfs_state = STATE_READLINK_REQ;
 			nfs_send();
 		} else {
-			if (!rlen)
-				nfs_download_state = NETLOOP_SUCCESS;
-			if (rlen < 0)
-				debug("NFS READ error (%d)\n", rlen);
+			debug("NFS READ error (%d)\n", rlen);
 			nfs_state = STATE_UMOUNT_REQ;
 			nfs_send();
 		}
@@ -38,20 +38,17 @@ static u32 tcp_ack_edge;
 
 static int tcp_activity_count;
 
+/* true if the server sent SACK-permitted in its SYN */
+static bool tcp_sack_permitted;
+
 /*
- * Search for TCP_SACK and review the comments before the code section
- * TCP_SACK is the number of packets at the front of the stream
+ * Blocks of data received beyond the ack edge, in sequence order, with no
+ * two touching. Up to TCP_SACK blocks are remembered; the one containing the
+ * most recently received segment is reported first in the SACK option.
  */
-
-enum pkt_state {PKT, NOPKT};
-struct sack_r {
-	struct sack_edges se;
-	enum pkt_state st;
-};
-
-static struct sack_r edge_a[TCP_SACK];
-static unsigned int sack_idx;
-static unsigned int prev_len;
+static struct sack_edges tcp_ooo[TCP_SACK];
+static unsigned int tcp_ooo_count;
+static unsigned int tcp_ooo_last;
 
 /*
  * TCP lengths are stored as a rounded up number of 32 bit words.
@@ -69,6 +66,17 @@ static enum tcp_state current_tcp_state;
 /* Current TCP RX packet handler */
 static rxhand_tcp *tcp_packet_handler;
 
+/* Sequence number comparisons, allowing for wrap-around */
+static inline bool tcp_seq_before(u32 a, u32 b)
+{
+	return (s32)(a - b) < 0;
+}
+
+static inline bool tcp_seq_after(u32 a, u32 b)
+{
+	return (s32)(a - b) > 0;
+}
+
 /**
  * tcp_get_tcp_state() - get current TCP state
  *
@@ -88,6 +96,16 @@ void tcp_set_tcp_state(enum tcp_state new_state)
 	current_tcp_state = new_state;
 }
 
+/**
+ * tcp_get_ack_edge() - get the sequence number we expect next
+ *
+ * Return: Sequence number following the data received in order
+ */
+u32 tcp_get_ack_edge(void)
+{
+	return tcp_ack_edge;
+}
+
 static void dummy_handler(uchar *pkt, u16 dport,
 			  struct in_addr sip, u16 sport,
 			  u32 tcp_seq_num, u32 tcp_ack_num,
@@ -164,7 +182,7 @@ int net_set_ack_options(union tcp_build_pkt *b)
 	b->sack.sack_v.len = 0;
 
 	if (IS_ENABLED(CONFIG_PROT_TCP_SACK)) {
-		if (tcp_lost.len > TCP_OPT_LEN_2) {
+		if (tcp_lost.len > TCP_OPT_LEN_2 && tcp_sack_permitted) {
 			debug_cond(DEBUG_DEV_PKT, "TCP ack opt lost.len %x\n",
 				   tcp_lost.len);
 			b->sack.sack_v.len = tcp_lost.len;
@@ -186,9 +204,10 @@ int net_set_ack_options(union tcp_build_pkt *b)
 			b->sack.sack_v.hill[3].r = TCP_O_NOP;
 		}
 
-		b->sack.hdr.tcp_hlen = SHIFT_TO_TCPHDRLEN_FIELD(ROUND_TCPHDR_LEN(TCP_HDR_SIZE +
-										 TCP_TSOPT_SIZE +
-										 tcp_lost.len));
+		b->sack.hdr.tcp_hlen =
+			SHIFT_TO_TCPHDRLEN_FIELD(ROUND_TCPHDR_LEN(TCP_HDR_SIZE +
+				TCP_TSOPT_SIZE +
+				(b->sack.sack_v.len ?: TCP_OPT_LEN_2)));
 	} else {
 		b->sack.sack_v.kind = 0;
 		b->sack.hdr.tcp_hlen = SHIFT_TO_TCPHDRLEN_FIELD(ROUND_TCPHDR_LEN(TCP_HDR_SIZE +
@@ -211,6 +230,8 @@ void net_set_syn_options(union tcp_build_pkt *b)
 {
 	if (IS_ENABLED(CONFIG_PROT_TCP_SACK))
 		tcp_lost.len = 0;
+	tcp_sack_permitted = false;
+	tcp_ooo_count = 0;
 
 	b->ip.hdr.tcp_hlen = 0xa0;
 
@@ -317,7 +338,14 @@ int tcp_set_tcp_header(uchar *pkt, int dport, int sport, int payload_len,
 	pkt_len	= pkt_hdr_len + payload_len;
 	tcp_len	= pkt_len - IP_HDR_SIZE;
 
-	tcp_ack_edge = tcp_ack_num;
+	/*
+	 * Once the connection is established, a plain ACK acknowledges all the
+	 * data received in order, which tcp_hole() keeps track of. This may be
+	 * beyond the segment the application is responding to, if that filled
+	 * a hole, or before it, if it arrived out of order.
+	 */
+	if (action != TCP_ACK || current_tcp_state != TCP_ESTABLISHED)
+		tcp_ack_edge = tcp_ack_num;
 	/* TCP Header */
 	b->ip.hdr.tcp_ack = htonl(tcp_ack_edge);
 	b->ip.hdr.tcp_src = htons(sport);
@@ -339,7 +367,11 @@ int tcp_set_tcp_header(uchar *pkt, int dport, int sport, int payload_len,
 	 * it is, then the u-boot tftp or nfs kernel netboot should be
 	 * considered.
 	 */
-	b->ip.hdr.tcp_win = htons(PKTBUFSRX * TCP_MSS >> TCP_SCALE);
+	/* The window in a SYN is never scaled */
+	if (b->ip.hdr.tcp_flags & TCP_SYN)
+		b->ip.hdr.tcp_win = htons(min(TCP_RCV_WND, 0xffff));
+	else
+		b->ip.hdr.tcp_win = htons(TCP_RCV_WND >> TCP_SCALE);
 
 	b->ip.hdr.tcp_xsum = 0;
 	b->ip.hdr.tcp_ugr = 0;
@@ -353,112 +385,92 @@ int tcp_set_tcp_header(uchar *pkt, int dport, int sport, int payload_len,
 	return pkt_hdr_len;
 }
 
+/**
+ * tcp_sack_update() - update the SACK option to send with the next ACK
+ *
+ * The block holding the most recent segment goes first, as RFC 2018 asks,
+ * followed by the others in sequence order while there is room.
+ */
+static void tcp_sack_update(void)
+{
+	unsigned int i, hill = 0;
+
+	if (!IS_ENABLED(CONFIG_PROT_TCP_SACK))
+		return;
+
+	if (tcp_ooo_last < tcp_ooo_count)
+		tcp_lost.hill[hill++] = tcp_ooo[tcp_ooo_last];
+	for (i = 0; i < tcp_ooo_count && hill < TCP_SACK_HILLS - 1; i++) {
+		if (i != tcp_ooo_last)
+			tcp_lost.hill[hill++] = tcp_ooo[i];
+	}
+	tcp_lost.len = TCP_OPT_LEN_2 + hill * TCP_SACK_SIZE;
+}
+
 /**
  * tcp_hole() - Selective Acknowledgment (Essential for fast stream transfer)
+ *
+ * Record the arrival of a segment. If it is the next one expected, the ack
+ * edge moves past it and past any blocks received earlier which it now
+ * joins up with. Otherwise it is recorded as a block beyond a hole, to be
+ * reported to the server with SACK.
+ *
  * @tcp_seq_num: TCP sequence start number
  * @len: the length of sequence numbers
  */
 void tcp_hole(u32 tcp_seq_num, u32 len)
 {
-	u32 idx_sack, sack_in;
-	u32 sack_end = TCP_SACK - 1;
-	u32 hill = 0;
-	enum pkt_state expect = PKT;
-	u32 seq = tcp_seq_num - tcp_seq_init;
-	u32 hol_l = tcp_ack_edge - tcp_seq_init;
-	u32 hol_r = 0;
-
-	/* Place new seq number in correct place in receive array */
-	if (prev_len == 0)
-		prev_len = len;
-
-	idx_sack = sack_idx + ((tcp_seq_num - tcp_ack_edge) / prev_len);
-	if (idx_sack < TCP_SACK) {
-		edge_a[idx_sack].se.l = tcp_seq_num;
-		edge_a[idx_sack].se.r = tcp_seq_num + len;
-		edge_a[idx_sack].st = PKT;
-
-		/*
-		 * The fin (last) packet is not the same length as data
-		 * packets, and if it's length is recorded and used for
-		 *  array index calculation, calculation breaks.
-		 */
-		if (prev_len < len)
-			prev_len = len;
-	}
-
-	debug_cond(DEBUG_DEV_PKT,
-		   "TCP 1 seq %d, edg %d, len %d, sack_idx %d, sack_end %d\n",
-		    seq, hol_l, len, sack_idx, sack_end);
-
-	/* Right edge of contiguous stream, is the left edge of first hill */
-	hol_l = tcp_seq_num - tcp_seq_init;
-	hol_r = hol_l + len;
-
-	if (IS_ENABLED(CONFIG_PROT_TCP_SACK))
-		tcp_lost.len = TCP_OPT_LEN_2;
-
-	debug_cond(DEBUG_DEV_PKT,
-		   "TCP 1 in %d, seq %d, pkt_l %d, pkt_r %d, sack_idx %d, sack_end %d\n",
-		   idx_sack, seq, hol_l, hol_r, sack_idx, sack_end);
-
-	for (sack_in = sack_idx; sack_in < sack_end && hill < TCP_SACK_HILLS;
-	     sack_in++)  {
-		switch (expect) {
-		case NOPKT:
-			switch (edge_a[sack_in].st) {
-			case NOPKT:
-				debug_cond(DEBUG_INT_STATE, "N");
-				break;
-			case PKT:
-				debug_cond(DEBUG_INT_STATE, "n");
-				if (IS_ENABLED(CONFIG_PROT_TCP_SACK)) {
-					tcp_lost.hill[hill].l =
-						edge_a[sack_in].se.l;
-					tcp_lost.hill[hill].r =
-						edge_a[sack_in].se.r;
-				}
-				expect = PKT;
+	u32 l = tcp_seq_num, r = tcp_seq_num + len;
+	unsigned int i, j;
+
+	tcp_ooo_last = TCP_SACK;
+	if (!tcp_seq_after(r, tcp_ack_edge)) {
+		/* Duplicate of data already received */
+		debug_cond(DEBUG_DEV_PKT, "TCP dup seq %u, len %u\n",
+			   l - tcp_seq_init, len);
+	} else if (!tcp_seq_after(l, tcp_ack_edge)) {
+		tcp_ack_edge = r;
+		for (i = 0; i < tcp_ooo_count; i++) {
+			if (tcp_seq_after(tcp_ooo[i].l, tcp_ack_edge))
 				break;
-			}
-			break;
-		case PKT:
-			switch (edge_a[sack_in].st) {
-			case NOPKT:
-				debug_cond(DEBUG_INT_STATE, "p");
-				if (sack_in > sack_idx &&
-				    hill < TCP_SACK_HILLS) {
-					hill++;
-					if (IS_ENABLED(CONFIG_PROT_TCP_SACK))
-						tcp_lost.len += TCP_OPT_LEN_8;
-				}
-				expect = NOPKT;
+			if (tcp_seq_after(tcp_ooo[i].r, tcp_ack_edge))
+				tcp_ack_edge = tcp_ooo[i].r;
+		}
+		tcp_ooo_count -= i;
+		memmove(tcp_ooo, tcp_ooo + i, tcp_ooo_count * sizeof(*tcp_ooo));
+	} else {
+		/* Find the first block which ends at or after this one starts */
+		for (i = 0; i < tcp_ooo_count; i++) {
+			if (!tcp_seq_before(tcp_ooo[i].r, l))
 				break;
-			case PKT:
-				debug_cond(DEBUG_INT_STATE, "P");
-
-				if (tcp_ack_edge == edge_a[sack_in].se.l) {
-					tcp_ack_edge = edge_a[sack_in].se.r;
-					edge_a[sack_in].st = NOPKT;
-					sack_idx++;
-				} else {
-					if (IS_ENABLED(CONFIG_PROT_TCP_SACK) &&
-					    hill < TCP_SACK_HILLS)
-						tcp_lost.hill[hill].r =
-							edge_a[sack_in].se.r;
-				if (IS_ENABLED(CONFIG_PROT_TCP_SACK) &&
-				    sack_in == sack_end - 1)
-					tcp_lost.hill[hill].r =
-						edge_a[sack_in].se.r;
-				}
+		}
+		/* And merge with all those which it overlaps or touches */
+		for (j = i; j < tcp_ooo_count; j++) {
+			if (tcp_seq_after(tcp_ooo[j].l, r))
 				break;
-			}
-			break;
+			if (tcp_seq_before(tcp_ooo[j].l, l))
+				l = tcp_ooo[j].l;
+			if (tcp_seq_after(tcp_ooo[j].r, r))
+				r = tcp_ooo[j].r;
+		}
+		if (i == j && tcp_ooo_count == TCP_SACK) {
+			/* No room; the server will send it again */
+			debug_cond(DEBUG_DEV_PKT, "TCP too many holes\n");
+		} else {
+			memmove(tcp_ooo + i + 1, tcp_ooo + j,
+				(tcp_ooo_count - j) * sizeof(*tcp_ooo));
+			tcp_ooo_count -= j - i - 1;
+			tcp_ooo[i].l = l;
+			tcp_ooo[i].r = r;
+			tcp_ooo_last = i;
 		}
 	}
-	debug_cond(DEBUG_INT_STATE, "\n");
-	if (!IS_ENABLED(CONFIG_PROT_TCP_SACK) || tcp_lost.len <= TCP_OPT_LEN_2)
-		sack_idx = 0;
+
+	debug_cond(DEBUG_DEV_PKT,
+		   "TCP hole seq %u, len %u, edge %u, blocks %u\n",
+		   tcp_seq_num - tcp_seq_init, len,
+		   tcp_ack_edge - tcp_seq_init, tcp_ooo_count);
+	tcp_sack_update();
 }
 
 /**
@@ -469,33 +481,37 @@ void tcp_hole(u32 tcp_seq_num, u32 len)
 void tcp_parse_options(uchar *o, int o_len)
 {
 	struct tcp_t_opt  *tsopt;
+	uchar *end = o + o_len;
 	uchar *p = o;
 
 	/*
 	 * NOPs are options with a zero length, and thus are special.
 	 * All other options have length fields.
 	 */
-	for (p = o; p < (o + o_len); p = p + p[1]) {
-		if (!p[1])
-			return; /* Finished processing options */
+	while (p < end) {
+		if (p[0] == TCP_O_END)
+			return;
+		if (p[0] == TCP_1_NOP) {
+			p++;
+			continue;
+		}
+		if (p + 1 >= end || p[1] < TCP_OPT_LEN_2 || p + p[1] > end)
+			return; /* Malformed */
 
 		switch (p[0]) {
-		case TCP_O_END:
-			return;
+		case TCP_P_SACK:
+			tcp_sack_permitted = true;
+			break;
 		case TCP_O_MSS:
 		case TCP_O_SCL:
-		case TCP_P_SACK:
 		case TCP_V_SACK:
 			break;
 		case TCP_O_TS:
 			tsopt = (struct tcp_t_opt *)p;
 			rmt_timestamp = tsopt->t_snd;
-			return;
+			break;
 		}
-
-		/* Process optional NOPs */
-		if (p[0] == TCP_O_NOP)
-			p++;
+		p += p[1];
 	}
 }
 
@@ -507,7 +523,6 @@ static u8 tcp_state_machine(u8 tcp_flags, u32 tcp_seq_num, int payload_len)
 	u8 tcp_push = tcp_flags & TCP_PUSH;
 	u8 tcp_ack = tcp_flags & TCP_ACK;
 	u8 action = TCP_DATA;
-	int i;
 
 	/*
 	 * tcp_flags are examined to determine TX action in a given state
@@ -550,13 +565,9 @@ static u8 tcp_state_machine(u8 tcp_flags, u32 tcp_seq_num, int payload_len)
 			action |= TCP_ACK;
 			tcp_seq_init = tcp_seq_num;
 			tcp_ack_edge = tcp_seq_num + 1;
-			sack_idx = 0;
-			edge_a[sack_idx].se.l = tcp_ack_edge;
-			edge_a[sack_idx].se.r = tcp_ack_edge;
-			prev_len = 0;
+			tcp_ooo_count = 0;
+			tcp_sack_update();
 			current_tcp_state = TCP_ESTABLISHED;
-			for (i = 0; i < TCP_SACK; i++)
-				edge_a[i].st = NOPKT;
 
 			if (tcp_syn && tcp_ack)
 				action |= TCP_PUSH;
@@ -571,9 +582,8 @@ static u8 tcp_state_machine(u8 tcp_flags, u32 tcp_seq_num, int payload_len)
 			tcp_fin = TCP_DATA;  /* cause standalone FIN */
 		}
 
-		if ((tcp_fin) &&
-		    (!IS_ENABLED(CONFIG_PROT_TCP_SACK) ||
-		     tcp_lost.len <= TCP_OPT_LEN_2)) {
+		/* Don't close while there is data missing */
+		if (tcp_fin && !tcp_ooo_count) {
 			action = action | TCP_FIN | TCP_PUSH | TCP_ACK;
 			current_tcp_state = TCP_CLOSE_WAIT;
 		} else if (tcp_ack) {
@@ -657,10 +667,14 @@ void rxhand_tcp_f(union tcp_build_pkt *b, unsigned int pkt_len)
 		return;
 	}
 
-	/* Build pseudo header and verify TCP header */
+	/*
+	 * Build pseudo header and verify TCP header, unless the hardware has
+	 * done so already
+	 */
 	tcp_rx_xsum = b->ip.hdr.tcp_xsum;
 	b->ip.hdr.tcp_xsum = 0;
-	if (tcp_rx_xsum != tcp_set_pseudo_header((uchar *)b, b->ip.hdr.ip_src,
+	if (!net_rx_csum_valid &&
+	    tcp_rx_xsum != tcp_set_pseudo_header((uchar *)b, b->ip.hdr.ip_src,
 						 b->ip.hdr.ip_dst, tcp_len,
 						 pkt_len)) {
 		debug_cond(DEBUG_DEV_PKT,
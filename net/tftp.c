@@ -27,6 +27,13 @@ DECLARE_GLOBAL_DATA_PTR;
 #define TIMEOUT		5000UL
 /* Number of "loading" hashes per line (for checking the image size) */
 #define HASHES_PER_LINE	65
+/* Shortest time to wait before asking again for a lost block */
+#define TFTP_RTO_MIN_MS	20UL
+/*
+ * A transfer which needs a retransmission in more than one window in this
+ * many is considered lossy, and the next one requests a smaller window
+ */
+#define TFTP_LOSS_RATIO	32
 
 /*
  *	TFTP operations.
@@ -97,6 +104,18 @@ static ushort	tftp_windowsize;
 static ushort	tftp_next_ack;
 /* Last nack block we send */
 static ushort	tftp_last_nack;
+/* Window size to request next time, adjusted after each transfer */
+static ushort	tftp_window_adapt;
+/* Number of windows acknowledged in this transfer */
+static ulong	tftp_window_count;
+/* Number of times we asked the server to send blocks again */
+static ulong	tftp_retransmits;
+/* Time at which the last ACK was sent, 0 if not being timed */
+static ulong	tftp_ack_time;
+/* Smoothed round-trip time to the server in ms, multiplied by 8 */
+static ulong	tftp_srtt8;
+/* Time to wait for the next block before asking for it again */
+static ulong	tftp_rto_ms;
 #ifdef CONFIG_CMD_TFTPPUT
 /* 1 if writing, else 0 */
 static int	tftp_put_active;
@@ -261,6 +280,56 @@ static void restart(const char *msg)
 	net_start_again();
 }
 
+/**
+ * tftp_update_rto() - update the retransmit timeout from a round trip
+ *
+ * This is called when a block arrives. If an ACK is being timed, the time
+ * since it was sent gives a round-trip sample, which is used to keep a
+ * smoothed estimate in the same way as TCP. The retransmit timeout is set to
+ * twice that, but at least TFTP_RTO_MIN_MS and at most the TFTP timeout.
+ */
+static void tftp_update_rto(void)
+{
+	ulong sample;
+
+	if (!IS_ENABLED(CONFIG_TFTP_ADAPTIVE) || !tftp_ack_time)
+		return;
+
+	sample = get_timer(tftp_ack_time);
+	tftp_ack_time = 0;
+	if (tftp_srtt8)
+		tftp_srtt8 += sample - (tftp_srtt8 >> 3);
+	else
+		tftp_srtt8 = sample << 3;
+	tftp_rto_ms = clamp(tftp_srtt8 / 4 + TFTP_RTO_MIN_MS, TFTP_RTO_MIN_MS,
+			    timeout_ms);
+}
+
+/**
+ * tftp_adapt_window() - choose the window size for the next transfer
+ *
+ * RFC 7440 fixes the window size for the whole of a transfer, so this is
+ * adjusted between transfers: it is halved if this one was lossy and doubled
+ * if it had no loss at all, but never exceeds the configured window size.
+ *
+ * @lossy: true if the transfer failed, to treat it as lossy
+ */
+static void tftp_adapt_window(bool lossy)
+{
+	ushort window = tftp_window_adapt;
+
+	if (!IS_ENABLED(CONFIG_TFTP_ADAPTIVE) || tftp_put_active)
+		return;
+
+	if (lossy || tftp_retransmits * TFTP_LOSS_RATIO > tftp_window_count)
+		window = max(window / 2, 1);
+	else if (!tftp_retransmits)
+		window = min_t(uint, window * 2, tftp_window_size_option);
+	if (window != tftp_window_adapt)
+		debug("TFTP window size %d -> %d\n", tftp_window_adapt, window);
+	tftp_window_adapt = window;
+}
+
 /*
  * Check if the block number has wrapped, and update progress
  *
@@ -300,6 +369,11 @@ static void tftp_complete(void)
 		print_size(net_boot_file_size /
 			time_start * 1000, "/s");
 	}
+	if (IS_ENABLED(CONFIG_TFTP_ADAPTIVE) && !tftp_put_active) {
+		printf("\n\t window %d, %lu retransmit%s", tftp_windowsize,
+		       tftp_retransmits, tftp_retransmits == 1 ? "" : "s");
+		tftp_adapt_window(false);
+	}
 	puts("\ndone\n");
 	if (!tftp_put_active)
 		efi_set_bootdev("Net", "", tftp_filename,
@@ -359,9 +433,9 @@ static void tftp_send(void)
 		 * Implemented only for tftp get.
 		 * Don't bother sending if it's 1
 		 */
-		if (tftp_state == STATE_SEND_RRQ && tftp_window_size_option > 1)
+		if (tftp_state == STATE_SEND_RRQ && tftp_window_adapt > 1)
 			pkt += sprintf((char *)pkt, "windowsize%c%d%c",
-					0, tftp_window_size_option, 0);
+					0, tftp_window_adapt, 0);
 		len = pkt - xp;
 		break;
 
@@ -566,6 +640,14 @@ static void tftp_handler(uchar *pkt, unsigned dest, struct in_addr sip,
 					dectoul((char *)pkt + i + 11, NULL);
 				debug("windowsize = %s, %d\n",
 				      (char *)pkt + i + 11, tftp_windowsize);
+				/* RFC 7440: the server may only reduce it */
+				if (!tftp_windowsize ||
+				    tftp_windowsize > max_t(ushort,
+						tftp_window_adapt, 1)) {
+					printf("Invalid window size(=%d)\n",
+					       tftp_windowsize);
+					tftp_state = STATE_INVALID_OPTION;
+				}
 			}
 		}
 
@@ -605,6 +687,8 @@ static void tftp_handler(uchar *pkt, unsigned dest, struct in_addr sip,
 			 */
 			if (tftp_last_nack != tftp_cur_block) {
 				tftp_send();
+				tftp_retransmits++;
+				tftp_ack_time = 0;
 				tftp_last_nack = tftp_cur_block;
 				tftp_next_ack = (ushort)(tftp_cur_block +
 							 tftp_windowsize);
@@ -645,7 +729,8 @@ static void tftp_handler(uchar *pkt, unsigned dest, struct in_addr sip,
 		update_block_number();
 		tftp_prev_block = tftp_cur_block;
 		timeout_count_max = tftp_timeout_count_max;
-		net_set_timeout_handler(timeout_ms, tftp_timeout_handler);
+		tftp_update_rto();
+		net_set_timeout_handler(tftp_rto_ms, tftp_timeout_handler);
 
 		if (store_block(tftp_cur_block, pkt + 2, len)) {
 			eth_halt();
@@ -666,6 +751,9 @@ static void tftp_handler(uchar *pkt, unsigned dest, struct in_addr sip,
 		if (tftp_cur_block == tftp_next_ack) {
 			tftp_send();
 			tftp_next_ack += tftp_windowsize;
+			tftp_window_count++;
+			if (!tftp_ack_time)
+				tftp_ack_time = get_timer(0);
 		}
 		break;
 
@@ -697,7 +785,23 @@ static void tftp_handler(uchar *pkt, unsigned dest, struct in_addr sip,
 
 static void tftp_timeout_handler(void)
 {
+	if (tftp_rto_ms < timeout_ms) {
+		/*
+		 * The block is late compared to the round-trip time, so ask
+		 * for it again, backing off towards the full timeout. Stop
+		 * timing the round trip since the reply will be ambiguous.
+		 */
+		tftp_rto_ms = min(tftp_rto_ms * 2, timeout_ms);
+		tftp_retransmits++;
+		tftp_ack_time = 0;
+		tftp_next_ack = (ushort)(tftp_cur_block + tftp_windowsize);
+		net_set_timeout_handler(tftp_rto_ms, tftp_timeout_handler);
+		tftp_send();
+		return;
+	}
+	tftp_retransmits++;
 	if (++timeout_count > timeout_count_max) {
+		tftp_adapt_window(true);
 		restart("Retry count exceeded");
 	} else {
 		puts("T ");
@@ -717,6 +821,7 @@ static int tftp_init_load_addr(void)
 	lmb_init_and_reserve(&lmb, gd->bd, (void *)gd->fdt_blob);
 
 	max_size = lmb_get_free_size(&lmb, image_load_addr);
+	lmb_uninit(&lmb);
 	if (!max_size)
 		return -1;
 
@@ -815,6 +920,11 @@ void tftp_start(enum proto_t protocol)
 	debug("TFTP blocksize = %i, TFTP windowsize = %d timeout = %ld ms\n",
 	      tftp_block_size_option, tftp_window_size_option, timeout_ms);
 
+	/* Start from the configured window if it has changed */
+	if (!IS_ENABLED(CONFIG_TFTP_ADAPTIVE) || !tftp_window_adapt ||
+	    tftp_window_adapt > tftp_window_size_option)
+		tftp_window_adapt = tftp_window_size_option;
+
 	if (IS_ENABLED(CONFIG_IPV6))
 		tftp_remote_ip6 = net_server_ip6;
 
@@ -943,6 +1053,11 @@ void tftp_start(enum proto_t protocol)
 	tftp_cur_block = 0;
 	tftp_windowsize = 1;
 	tftp_last_nack = 0;
+	tftp_window_count = 0;
+	tftp_retransmits = 0;
+	tftp_ack_time = 0;
+	tftp_srtt8 = 0;
+	tftp_rto_ms = timeout_ms;
 	/* zero out server ether in case the server ip has changed */
 	memset(net_server_ethaddr, 0, 6);
 	/* Revert tftp_block_size to dflt */
@@ -983,6 +1098,10 @@ void tftp_start_server(void)
 	tftp_our_port = WELL_KNOWN_PORT;
 	tftp_windowsize = 1;
 	tftp_next_ack = tftp_windowsize;
+	tftp_retransmits = 0;
+	tftp_ack_time = 0;
+	tftp_srtt8 = 0;
+	tftp_rto_ms = timeout_ms;
 
 #ifdef CONFIG_TFTP_TSIZE
 	tftp_tsize = 0;
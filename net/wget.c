@@ -23,9 +23,12 @@ DECLARE_GLOBAL_DATA_PTR;
 
 static const char bootfile1[] = "GET ";
 static const char bootfile3[] = " HTTP/1.0\r\n\r\n";
+static const char bootfile3_keep[] = " HTTP/1.1\r\nHost: %pI4\r\n"
+	"Connection: %s\r\n\r\n";
 static const char http_eom[] = "\r\n\r\n";
 static const char http_ok[] = "200";
 static const char content_len[] = "Content-Length";
+static const char chunked[] = "Transfer-Encoding: chunked";
 static const char linefeed[] = "\r\n";
 static struct in_addr web_server_ip;
 static int our_port;
@@ -64,8 +67,49 @@ static unsigned int retry_tcp_ack_num;	/* TCP retry acknowledge number*/
 static unsigned int retry_tcp_seq_num;	/* TCP retry sequence number */
 static int retry_len;			/* TCP retry length */
 
+/* Delayed ACK parameters */
+static unsigned int wget_acks_pending;	/* segments not yet acknowledged */
+static unsigned int wget_seg_size;	/* largest segment received */
+
 static ulong wget_load_size;
 
+/* More files to fetch over the same connection, see wget_set_files() */
+struct wget_file {
+	ulong addr;
+	char *path;
+};
+
+static struct wget_file wget_files[WGET_MAX_FILES - 1];
+static int wget_file_count;	/* number of entries in wget_files */
+static int wget_file_idx;	/* number of entries started */
+static ulong wget_first_addr;	/* load address of the first file */
+static unsigned int wget_resp_seq;	/* where the next response starts */
+
+int wget_set_files(int argc, char *const argv[])
+{
+	int i;
+
+	wget_file_count = 0;
+	wget_file_idx = 0;
+	if (argc % 2)
+		return -EINVAL;
+	if (argc / 2 > ARRAY_SIZE(wget_files))
+		return -E2BIG;
+	for (i = 0; i < argc / 2; i++) {
+		struct wget_file *file = &wget_files[i];
+		char *end;
+
+		file->addr = hextoul(argv[i * 2], &end);
+		file->path = argv[i * 2 + 1];
+		if (*end || !*file->path ||
+		    strlen(file->path) >= sizeof(net_boot_file_name))
+			return -EINVAL;
+	}
+	wget_file_count = i;
+
+	return 0;
+}
+
 /**
  * wget_init_max_size() - initialize maximum load size
  *
@@ -79,6 +123,7 @@ static int wget_init_load_size(void)
 	lmb_init_and_reserve(&lmb, gd->bd, (void *)gd->fdt_blob);
 
 	max_size = lmb_get_free_size(&lmb, image_load_addr);
+	lmb_uninit(&lmb);
 	if (!max_size)
 		return -1;
 
@@ -123,6 +168,46 @@ static inline int store_block(uchar *src, unsigned int offset, unsigned int len)
 	return 0;
 }
 
+/**
+ * wget_send_request() - send the request for the current file
+ *
+ * A single file is requested with HTTP/1.0, so the server closes the
+ * connection at the end. When there are more files, HTTP/1.1 is used and the
+ * connection is kept open until the request for the last one.
+ *
+ * @server_port: HTTP server port
+ * @tcp_seq_num: our TCP sequence number
+ * @tcp_ack_num: TCP acknowledgment number to send
+ */
+static void wget_send_request(unsigned int server_port,
+			      unsigned int tcp_seq_num,
+			      unsigned int tcp_ack_num)
+{
+	uchar *ptr, *offset;
+
+	ptr = net_tx_packet + net_eth_hdr_size() +
+		IP_TCP_HDR_SIZE + TCP_TSOPT_SIZE + 2;
+	offset = ptr;
+
+	memcpy(offset, &bootfile1, strlen(bootfile1));
+	offset += strlen(bootfile1);
+
+	memcpy(offset, image_url, strlen(image_url));
+	offset += strlen(image_url);
+
+	if (!wget_file_count) {
+		memcpy(offset, &bootfile3, strlen(bootfile3));
+		offset += strlen(bootfile3);
+	} else {
+		offset += sprintf((char *)offset, bootfile3_keep,
+				  &web_server_ip,
+				  wget_file_idx < wget_file_count ?
+				  "keep-alive" : "close");
+	}
+	net_send_tcp_packet((offset - ptr), server_port, our_port,
+			    TCP_PUSH, tcp_seq_num, tcp_ack_num);
+}
+
 /**
  * wget_send_stored() - wget response dispatcher
  *
@@ -138,9 +223,9 @@ static void wget_send_stored(void)
 	unsigned int tcp_ack_num = retry_tcp_seq_num + (len == 0 ? 1 : len);
 	unsigned int tcp_seq_num = retry_tcp_ack_num;
 	unsigned int server_port;
-	uchar *ptr, *offset;
 
 	server_port = env_get_ulong("httpdstp", 10, SERVER_PORT) & 0xffff;
+	wget_acks_pending = 0;
 
 	switch (current_wget_state) {
 	case WGET_CLOSED:
@@ -154,21 +239,7 @@ static void wget_send_stored(void)
 		pkt_q_idx = 0;
 		net_send_tcp_packet(0, server_port, our_port, action,
 				    tcp_seq_num, tcp_ack_num);
-
-		ptr = net_tx_packet + net_eth_hdr_size() +
-			IP_TCP_HDR_SIZE + TCP_TSOPT_SIZE + 2;
-		offset = ptr;
-
-		memcpy(offset, &bootfile1, strlen(bootfile1));
-		offset += strlen(bootfile1);
-
-		memcpy(offset, image_url, strlen(image_url));
-		offset += strlen(image_url);
-
-		memcpy(offset, &bootfile3, strlen(bootfile3));
-		offset += strlen(bootfile3);
-		net_send_tcp_packet((offset - ptr), server_port, our_port,
-				    TCP_PUSH, tcp_seq_num, tcp_ack_num);
+		wget_send_request(server_port, tcp_seq_num, tcp_ack_num);
 		current_wget_state = WGET_CONNECTED;
 		break;
 	case WGET_CONNECTED:
@@ -224,6 +295,84 @@ static void wget_timeout_handler(void)
 	}
 }
 
+static void wget_ack_timeout_handler(void)
+{
+	net_set_timeout_handler(wget_timeout, wget_timeout_handler);
+	wget_send_stored();
+}
+
+/**
+ * wget_ack() - acknowledge data received
+ *
+ * Up to CONFIG_WGET_ACK_RATIO segments are acknowledged together. An ACK
+ * which is held back is sent after WGET_ACK_DELAY ms if no more data
+ * arrives. The TCP layer fills in the ack edge, which covers all the data
+ * received in order.
+ *
+ * @tcp_seq_num: TCP sequence number of the segment received
+ * @tcp_ack_num: TCP acknowledgment number of the segment received
+ * @len: length of the segment
+ * @now: true to send the ACK straight away
+ */
+static void wget_ack(unsigned int tcp_seq_num, unsigned int tcp_ack_num,
+		     int len, bool now)
+{
+	if (!now && ++wget_acks_pending < CONFIG_WGET_ACK_RATIO) {
+		retry_action = TCP_ACK;
+		retry_tcp_ack_num = tcp_ack_num;
+		retry_tcp_seq_num = tcp_seq_num;
+		retry_len = len;
+		net_set_timeout_handler(WGET_ACK_DELAY,
+					wget_ack_timeout_handler);
+		return;
+	}
+
+	wget_send(TCP_ACK, tcp_seq_num, tcp_ack_num, len);
+}
+
+/**
+ * wget_next_file() - request the next file over the same connection
+ *
+ * This is called once all of the current file has been received
+ *
+ * @tcp_seq_num: TCP sequence number of the last segment received
+ * @tcp_ack_num: TCP acknowledgment number of the last segment received
+ */
+static void wget_next_file(unsigned int tcp_seq_num, unsigned int tcp_ack_num)
+{
+	struct wget_file *file = &wget_files[wget_file_idx++];
+	unsigned int server_port;
+
+	printf("Packets received %d, Transfer Successful\n", packets);
+	printf("Bytes transferred = %u (%x hex)\n", net_boot_file_size,
+	       net_boot_file_size);
+
+	image_load_addr = file->addr;
+	image_url = file->path;
+	if (IS_ENABLED(CONFIG_LMB) && wget_init_load_size()) {
+		printf("\nwget error: ");
+		printf("trying to overwrite reserved memory...\n");
+		wget_send(TCP_RST, tcp_seq_num, tcp_ack_num, 0);
+		net_set_state(NETLOOP_FAIL);
+		return;
+	}
+
+	packets = 0;
+	pkt_q_idx = 0;
+	wget_seg_size = 0;
+	wget_resp_seq = tcp_get_ack_edge();
+	current_wget_state = WGET_CONNECTED;
+
+	/* Keep the ACK for the timeout handler, then ask for the file */
+	retry_action = TCP_ACK;
+	retry_tcp_ack_num = tcp_ack_num;
+	retry_tcp_seq_num = wget_resp_seq;
+	retry_len = 0;
+	wget_acks_pending = 0;
+	server_port = env_get_ulong("httpdstp", 10, SERVER_PORT) & 0xffff;
+	wget_send_request(server_port, tcp_ack_num, wget_resp_seq);
+}
+
 #define PKT_QUEUE_OFFSET 0x20000
 #define PKT_QUEUE_PACKET_SIZE 0x800
 
@@ -296,6 +445,20 @@ static void wget_connected(uchar *pkt, unsigned int tcp_seq_num,
 					   content_length);
 			}
 
+			/*
+			 * The end of a response which is not the last is only
+			 * known from its length, and chunks are not decoded
+			 */
+			if ((wget_file_idx < wget_file_count &&
+			     content_length == -1) ||
+			    (wget_file_count && strstr((char *)pkt, chunked))) {
+				wget_loop_state = NETLOOP_FAIL;
+				wget_fail("wget: response length unknown\n",
+					  tcp_seq_num, tcp_ack_num, action);
+				net_set_state(NETLOOP_FAIL);
+				return;
+			}
+
 			net_boot_file_size = 0;
 
 			if (len > hlen) {
@@ -314,6 +477,10 @@ static void wget_connected(uchar *pkt, unsigned int tcp_seq_num,
 			for (i = 0; i < pkt_q_idx; i++) {
 				int err;
 
+				/* Skip stale copies of the previous response */
+				if ((int)(pkt_q[i].tcp_seq_num -
+					  initial_data_seq_num) < 0)
+					continue;
 				ptr1 = map_sysmem(
 					(phys_addr_t)(pkt_q[i].pkt),
 					pkt_q[i].len);
@@ -332,6 +499,14 @@ static void wget_connected(uchar *pkt, unsigned int tcp_seq_num,
 					return;
 				}
 			}
+
+			/* A small file may come with the header */
+			if (wget_file_idx < wget_file_count &&
+			    tcp_get_ack_edge() - initial_data_seq_num >=
+			    content_length) {
+				wget_next_file(tcp_seq_num, tcp_ack_num);
+				return;
+			}
 		}
 	}
 	wget_send(action, tcp_seq_num, tcp_ack_num, len);
@@ -357,6 +532,7 @@ static void wget_handler(uchar *pkt, u16 dport,
 			 u8 action, unsigned int len)
 {
 	enum tcp_state wget_tcp_state = tcp_get_tcp_state();
+	bool ack_now;
 
 	net_set_timeout_handler(wget_timeout, wget_timeout_handler);
 	packets++;
@@ -385,6 +561,20 @@ static void wget_handler(uchar *pkt, u16 dport,
 	case WGET_CONNECTED:
 		debug_cond(DEBUG_WGET, "wget: Connected seq=%u, len=%x\n",
 			   tcp_seq_num, len);
+		/* Drop anything left over from the previous response */
+		if (wget_file_idx && len &&
+		    (int)(tcp_seq_num - wget_resp_seq) < 0) {
+			unsigned int stale = wget_resp_seq - tcp_seq_num;
+
+			if (stale >= len) {
+				wget_send(TCP_ACK, tcp_seq_num, tcp_ack_num,
+					  len);
+				break;
+			}
+			pkt += stale;
+			tcp_seq_num += stale;
+			len -= stale;
+		}
 		if (!len) {
 			wget_fail("Image not found, no data returned\n",
 				  tcp_seq_num, tcp_ack_num, action);
@@ -397,13 +587,29 @@ static void wget_handler(uchar *pkt, u16 dport,
 			   "wget: Transferring, seq=%x, ack=%x,len=%x\n",
 			   tcp_seq_num, tcp_ack_num, len);
 
-		if (next_data_seq_num != tcp_seq_num) {
-			debug_cond(DEBUG_WGET, "wget: seq=%x packet was lost\n", next_data_seq_num);
-			return;
-		}
-		next_data_seq_num = tcp_seq_num + len;
-
-		if (store_block(pkt, tcp_seq_num - initial_data_seq_num, len) != 0) {
+		/*
+		 * Segments are stored in place as they arrive, in or out of
+		 * order; the TCP layer tracks the holes. Acknowledge at once
+		 * if this segment is out of order or fills a hole, so that the
+		 * server learns about it quickly, or if it is short, since the
+		 * server may be waiting to send more.
+		 */
+		ack_now = tcp_seq_num != next_data_seq_num;
+		if (ack_now)
+			debug_cond(DEBUG_WGET, "wget: seq=%x expected=%x\n",
+				   tcp_seq_num, next_data_seq_num);
+		next_data_seq_num = tcp_get_ack_edge();
+		if (next_data_seq_num != tcp_seq_num + len)
+			ack_now = true;
+		if (len > wget_seg_size)
+			wget_seg_size = len;
+		if (len < wget_seg_size)
+			ack_now = true;
+
+		/* Anything before the body is a stale duplicate */
+		if ((int)(tcp_seq_num - initial_data_seq_num) >= 0 &&
+		    store_block(pkt, tcp_seq_num - initial_data_seq_num,
+				len) != 0) {
 			wget_fail("wget: store error\n",
 				  tcp_seq_num, tcp_ack_num, action);
 			net_set_state(NETLOOP_FAIL);
@@ -422,9 +628,14 @@ static void wget_handler(uchar *pkt, u16 dport,
 			net_set_state(NETLOOP_FAIL);
 			break;
 		case TCP_ESTABLISHED:
-			wget_send(TCP_ACK, tcp_seq_num, tcp_ack_num,
-				  len);
 			wget_loop_state = NETLOOP_SUCCESS;
+			if (wget_file_idx < wget_file_count &&
+			    next_data_seq_num - initial_data_seq_num >=
+			    content_length) {
+				wget_next_file(tcp_seq_num, tcp_ack_num);
+				break;
+			}
+			wget_ack(tcp_seq_num, tcp_ack_num, len, ack_now);
 			break;
 		case TCP_CLOSE_WAIT:     /* End of transfer */
 			current_wget_state = WGET_TRANSFERRED;
@@ -460,6 +671,12 @@ static unsigned int random_port(void)
 
 void wget_start(void)
 {
+	/* Start again from the first file if the transfer is restarted */
+	if (!wget_file_idx)
+		wget_first_addr = image_load_addr;
+	image_load_addr = wget_first_addr;
+	wget_file_idx = 0;
+
 	image_url = strchr(net_boot_file_name, ':');
 	if (image_url > 0) {
 		web_server_ip = string_to_ip(net_boot_file_name);
@@ -510,6 +727,8 @@ void wget_start(void)
 	tcp_set_tcp_handler(wget_handler);
 
 	wget_timeout_count = 0;
+	wget_acks_pending = 0;
+	wget_seg_size = 0;
 	current_wget_state = WGET_CLOSED;
 
 	our_port = random_port();
@@ -0,0 +1,234 @@
+#!/usr/bin/env python3
+# SPDX-License-Identifier: GPL-2.0+
+
+"""Lay out a flat device tree as a pre-unflattened live tree
+
+This reads a .dtb file and writes a C file containing the struct device_node
+and struct property records which unflatten_device_tree() would create for it
+at runtime. Pointers between records are emitted as normal C pointers, so the
+linker relocates them. Pointers into the blob itself (node names, property
+names and values, device_type) are emitted as offsets from the start of the
+blob; of_live_build() adds the blob address to them once at runtime.
+"""
+
+from argparse import ArgumentParser
+import struct
+import sys
+import zlib
+
+FDT_MAGIC = 0xd00dfeed
+FDT_BEGIN_NODE = 1
+FDT_END_NODE = 2
+FDT_PROP = 3
+FDT_NOP = 4
+FDT_END = 9
+
+class Prop:
+    """A property in the tree
+
+    Properties:
+        name_ofs: Offset of the property name from the start of the blob
+        value_ofs: Offset of the property value from the start of the blob
+        length: Length of the property value in bytes
+    """
+    def __init__(self, name_ofs, value_ofs, length):
+        self.name_ofs = name_ofs
+        self.value_ofs = value_ofs
+        self.length = length
+        self.index = None
+
+class Node:
+    """A node in the tree
+
+    Properties:
+        name_ofs: Offset of the node name from the start of the blob
+        full_name: Full path of the node, as built by unflatten_dt_node()
+        parent: Parent Node, or None for the root
+    """
+    def __init__(self, name_ofs, full_name, parent):
+        self.name_ofs = name_ofs
+        self.full_name = full_name
+        self.parent = parent
+        self.props = []
+        self.subnodes = []
+        self.type_ofs = 0
+        self.phandle = 0
+        self.index = None
+
+def align4(val):
+    """Round a value up to the next multiple of 4"""
+    return (val + 3) & ~3
+
+def read_string(data, pos):
+    """Read a nul-terminated string, returning it and its length"""
+    end = data.index(b'\0', pos)
+    return data[pos:end].decode('utf-8'), end - pos
+
+def scan_dtb(data):
+    """Scan a flat tree and build the corresponding node structure
+
+    Args:
+        data (bytes): Contents of the .dtb file
+
+    Returns:
+        Node: root node
+    """
+    (magic, totalsize, off_struct, off_strings, _, version, _, _,
+     _, size_struct) = struct.unpack('>10L', data[:40])
+    if magic != FDT_MAGIC:
+        raise ValueError('Bad magic %#x' % magic)
+    if version < 16:
+        raise ValueError('Unsupported version %d' % version)
+    if totalsize > len(data):
+        raise ValueError('Truncated blob')
+
+    pos = off_struct
+    end = off_struct + size_struct
+    root = None
+    node = None
+    while pos < end:
+        tag, = struct.unpack('>L', data[pos:pos + 4])
+        pos += 4
+        if tag == FDT_BEGIN_NODE:
+            name, length = read_string(data, pos)
+            if not node:
+                full_name = ''
+            elif not node.parent:
+                full_name = '/' + name
+            else:
+                full_name = node.full_name + '/' + name
+            new = Node(pos, full_name, node)
+            if node:
+                node.subnodes.append(new)
+            else:
+                root = new
+            node = new
+            pos = align4(pos + length + 1)
+        elif tag == FDT_END_NODE:
+            node = node.parent
+        elif tag == FDT_PROP:
+            length, nameoff = struct.unpack('>LL', data[pos:pos + 8])
+            pos += 8
+            name_ofs = off_strings + nameoff
+            name, _ = read_string(data, name_ofs)
+            node.props.append(Prop(name_ofs, pos, length))
+            if name in ('phandle', 'linux,phandle') and not node.phandle:
+                node.phandle, = struct.unpack('>L', data[pos:pos + 4])
+            elif name == 'ibm,phandle':
+                node.phandle, = struct.unpack('>L', data[pos:pos + 4])
+            elif name == 'device_type' and not node.type_ofs:
+                node.type_ofs = pos
+            pos = align4(pos + length)
+        elif tag == FDT_NOP:
+            pass
+        elif tag == FDT_END:
+            break
+        else:
+            raise ValueError('Bad tag %d at %#x' % (tag, pos - 4))
+    if not root:
+        raise ValueError('No root node')
+    return root
+
+def number(root):
+    """Assign array indices to nodes and properties in depth-first order"""
+    nodes = []
+    props = []
+    todo = [root]
+    while todo:
+        node = todo.pop(0)
+        node.index = len(nodes)
+        nodes.append(node)
+        for prop in node.props:
+            prop.index = len(props)
+            props.append(prop)
+        todo = node.subnodes + todo
+    return nodes, props
+
+def c_string(val):
+    """Quote a string for use in C source"""
+    return '"%s"' % val.replace('\\', '\\\\').replace('"', '\\"')
+
+def ref(name, obj):
+    """Get a C reference to an array element, or NULL"""
+    return '&%s[%d]' % (name, obj.index) if obj else 'NULL'
+
+def write_c(outf, data, root):
+    """Write out the C file for a tree"""
+    nodes, props = number(root)
+    size, = struct.unpack('>L', data[4:8])
+    crc = zlib.crc32(data[:size]) & 0xffffffff
+
+    outf.write('''// SPDX-License-Identifier: GPL-2.0+
+/*
+ * DO NOT MODIFY
+ *
+ * Pre-unflattened live tree for the control devicetree.
+ * This was generated by scripts/dtb_live.py
+ */
+
+#include <of_live.h>
+#include <dm/of.h>
+
+''')
+    if props:
+        outf.write('static struct property of_live_pp[%d] = {\n' % len(props))
+        for node in nodes:
+            for seq, prop in enumerate(node.props):
+                nxt = node.props[seq + 1] if seq + 1 < len(node.props) \
+                    else None
+                outf.write('\t[%d] = {\n' % prop.index)
+                outf.write('\t\t.name\t\t= (char *)%#x,\n' % prop.name_ofs)
+                outf.write('\t\t.length\t\t= %d,\n' % prop.length)
+                outf.write('\t\t.value\t\t= (void *)%#x,\n' % prop.value_ofs)
+                outf.write('\t\t.next\t\t= %s,\n' % ref('of_live_pp', nxt))
+                outf.write('\t},\n')
+        outf.write('};\n\n')
+
+    outf.write('static struct device_node of_live_np[%d] = {\n' % len(nodes))
+    for node in nodes:
+        sibling = None
+        if node.parent:
+            sibs = node.parent.subnodes
+            pos = sibs.index(node)
+            if pos + 1 < len(sibs):
+                sibling = sibs[pos + 1]
+        outf.write('\t[%d] = {\n' % node.index)
+        outf.write('\t\t.name\t\t= (const char *)%#x,\n' % node.name_ofs)
+        outf.write('\t\t.type\t\t= (const char *)%#x,\n' % node.type_ofs)
+        outf.write('\t\t.phandle\t= %#x,\n' % node.phandle)
+        outf.write('\t\t.full_name\t= %s,\n' % c_string(node.full_name))
+        outf.write('\t\t.properties\t= %s,\n' %
+                   (ref('of_live_pp', node.props[0]) if node.props else 'NULL'))
+        outf.write('\t\t.parent\t\t= %s,\n' % ref('of_live_np', node.parent))
+        outf.write('\t\t.child\t\t= %s,\n' %
+                   (ref('of_live_np', node.subnodes[0]) if node.subnodes
+                    else 'NULL'))
+        outf.write('\t\t.sibling\t= %s,\n' % ref('of_live_np', sibling))
+        outf.write('\t},\n')
+    outf.write('};\n\n')
+
+    outf.write('const struct of_live_prebuilt of_live_prebuilt = {\n')
+    outf.write('\t.np\t\t= of_live_np,\n')
+    outf.write('\t.np_count\t= %d,\n' % len(nodes))
+    outf.write('\t.pp\t\t= %s,\n' % ('of_live_pp' if props else 'NULL'))
+    outf.write('\t.pp_count\t= %d,\n' % len(props))
+    outf.write('\t.fdt_size\t= %#x,\n' % size)
+    outf.write('\t.fdt_crc32\t= %#x,\n' % crc)
+    outf.write('};\n')
+
+def run():
+    """Parse arguments and generate the file"""
+    parser = ArgumentParser(description='Lay out a .dtb as a live tree')
+    parser.add_argument('dtb', help='Input devicetree blob')
+    parser.add_argument('-o', '--output', required=True,
+                        help='Output C file')
+    args = parser.parse_args()
+
+    with open(args.dtb, 'rb') as inf:
+        data = inf.read()
+    root = scan_dtb(data)
+    with open(args.output, 'w', encoding='utf-8') as outf:
+        write_c(outf, data, root)
+
+if __name__ == '__main__':
+    sys.exit(run())
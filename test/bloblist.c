@@ -616,6 +616,75 @@ static int bloblist_test_blob_maxsize(struct unit_test_state *uts)
 }
 BLOBLIST_TEST(bloblist_test_blob_maxsize, 0);
 
+/* Test looking up blobs using the index */
+static int bloblist_test_index(struct unit_test_state *uts)
+{
+	const uint small_size = 0x20;
+	struct bloblist_index *idx;
+	struct bloblist_hdr *hdr;
+	struct bloblist_rec *rec;
+	void *blob1, *blob2;
+	int i;
+
+	if (!IS_ENABLED(CONFIG_BLOBLIST_INDEX))
+		return -EAGAIN;
+	hdr = clear_bloblist();
+	ut_assertok(bloblist_new(TEST_ADDR, TEST_BLOBLIST_SIZE, 0, 0));
+	ut_assertok(bloblist_add_index(3));
+	ut_asserteq(-EEXIST, bloblist_add_index(3));
+	idx = bloblist_find(BLOBLISTT_U_BOOT_INDEX, 0);
+	ut_assertnonnull(idx);
+	ut_asserteq(0, idx->count);
+	ut_asserteq(1, idx->complete);
+
+	blob1 = bloblist_add(TEST_TAG, small_size, 0);
+	ut_assertnonnull(blob1);
+	strcpy(blob1, test1_str);
+	blob2 = bloblist_add(TEST_TAG2, small_size, 0);
+	ut_assertnonnull(blob2);
+	strcpy(blob2, test2_str);
+	ut_asserteq(2, idx->count);
+	ut_asserteq(TEST_TAG2, idx->ent[1].tag);
+	ut_asserteq_ptr(blob2, bloblist_find(TEST_TAG2, small_size));
+	ut_assertnull(bloblist_find(TEST_TAG_MISSING, 0));
+
+	/* Growing the first blob moves the second, and the index with it */
+	ut_assertok(bloblist_resize(TEST_TAG, small_size + BLOBLIST_ALIGN));
+	ut_asserteq_ptr(blob1, bloblist_find(TEST_TAG, 0));
+	blob2 = bloblist_find(TEST_TAG2, small_size);
+	ut_asserteq_str(test2_str, blob2);
+	ut_asserteq(map_to_sysmem(blob2) - TEST_ADDR -
+		    sizeof(struct bloblist_rec), idx->ent[1].offset);
+
+	/* A stale entry falls back to walking the list */
+	idx->ent[1].offset = hdr->hdr_size;
+	ut_asserteq_ptr(blob2, bloblist_find(TEST_TAG2, small_size));
+
+	/*
+	 * A blob added by something which does not know about the index is
+	 * still found, since the index no longer covers the whole list
+	 */
+	rec = (void *)hdr + hdr->hdr_size;
+	rec->tag_and_hdr_size ^= BLOBLISTT_U_BOOT_INDEX ^ BLOBLISTT_VOID;
+	ut_assertnonnull(bloblist_add(TEST_TAG_MISSING + 2, 4, 0));
+	rec->tag_and_hdr_size ^= BLOBLISTT_U_BOOT_INDEX ^ BLOBLISTT_VOID;
+	ut_asserteq(2, idx->count);
+	ut_asserteq(1, idx->complete);
+	ut_assertnonnull(bloblist_find(TEST_TAG_MISSING + 2, 4));
+	ut_assertnull(bloblist_find(TEST_TAG_MISSING + 3, 0));
+
+	/* Once the index is full, further blobs are still found */
+	for (i = 0; i < 2; i++)
+		ut_assertnonnull(bloblist_add(TEST_TAG_MISSING + i, 4, 0));
+	ut_asserteq(3, idx->count);
+	ut_asserteq(0, idx->complete);
+	ut_assertnonnull(bloblist_find(TEST_TAG_MISSING + 1, 4));
+	ut_assertnull(bloblist_find(TEST_TAG_MISSING + 3, 0));
+
+	return 0;
+}
+BLOBLIST_TEST(bloblist_test_index, 0);
+
 int do_ut_bloblist(struct cmd_tbl *cmdtp, int flag, int argc,
 		   char *const argv[])
 {
@@ -483,6 +483,10 @@ static int bootdev_test_hunt_scan(struct unit_test_state *uts)
 					BOOTFLOWIF_SKIP_GLOBAL, &bflow));
 	ut_asserteq(BIT(MMC_HUNTER) | BIT(1), std->hunters_used);
 
+	/* Ethernet (first in the list) is started, but not hunted */
+	ut_asserteq(IS_ENABLED(CONFIG_BOOTSTD_HUNT_START) ? BIT(0) : 0,
+		    std->hunters_started);
+
 	return 0;
 }
 BOOTSTD_TEST(bootdev_test_hunt_scan, UT_TESTF_DM | UT_TESTF_SCAN_FDT);
@@ -254,10 +254,14 @@ static int bootflow_scan_boot(struct unit_test_state *uts)
 {
 	console_record_reset_enable();
 	ut_assertok(inject_response(uts));
+	ut_assertok(env_set("bootflow_cache", NULL));
 	ut_assertok(run_command("bootflow scan -b", 0));
 	ut_assert_nextline(
 		"** Booting bootflow 'mmc1.bootdev.part_1' with extlinux");
+
 	ut_assert_nextline("Ignoring unknown command: ui");
+	if (IS_ENABLED(CONFIG_BOOTSTD_CACHE))
+		ut_assertnonnull(env_get("bootflow_cache"));
 
 	/*
 	 * We expect it to get through to boot although sandbox always returns
@@ -266,6 +270,7 @@ static int bootflow_scan_boot(struct unit_test_state *uts)
 	ut_assert_skip_to_line("sandbox: continuing, as we cannot run Linux");
 	ut_assert_nextline("Boot failed (err=-14)");
 	ut_assert_console_end();
+	ut_assertok(env_set("bootflow_cache", NULL));
 
 	return 0;
 }
@@ -369,6 +374,165 @@ static int bootflow_iter(struct unit_test_state *uts)
 }
 BOOTSTD_TEST(bootflow_iter, UT_TESTF_DM | UT_TESTF_SCAN_FDT);
 
+/* Check that bootmeths share the files they look for during a scan */
+static int bootflow_iter_probe_cache(struct unit_test_state *uts)
+{
+	const char *conf = "/extlinux/extlinux.conf";
+	struct bootflow_iter iter;
+	struct bootstd_probe *probe;
+	struct bootstd_priv *std;
+	struct bootflow bflow;
+	struct blk_desc *desc;
+	struct udevice *blk;
+
+	if (!IS_ENABLED(CONFIG_BOOTSTD_PROBE_CACHE))
+		return -EAGAIN;
+	ut_assertok(bootstd_get_priv(&std));
+	bootstd_clear_glob();
+
+	/* skip mmc2, which has no media, and the whole of mmc1 */
+	ut_asserteq(-EPROTONOSUPPORT,
+		    bootflow_scan_first(NULL, NULL, &iter,
+					BOOTFLOWIF_ALL | BOOTFLOWIF_SKIP_GLOBAL,
+					&bflow));
+	ut_assert(list_empty(&std->probes));
+	bootflow_free(&bflow);
+	ut_asserteq(-EPROTONOSUPPORT, bootflow_scan_next(&iter, &bflow));
+	bootflow_free(&bflow);
+	ut_asserteq(-ENOENT, bootflow_scan_next(&iter, &bflow));
+	bootflow_free(&bflow);
+	ut_asserteq(-ENOENT, bootflow_scan_next(&iter, &bflow));
+	bootflow_free(&bflow);
+
+	/* extlinux finds its file on partition 1 and records it */
+	ut_assertok(bootflow_scan_next(&iter, &bflow));
+	ut_asserteq_str("extlinux", iter.method->name);
+	ut_asserteq(1, iter.part);
+	blk = bflow.blk;
+	probe = bootstd_find_probe(blk, 1, conf);
+	ut_assertnonnull(probe);
+	ut_assertok(probe->ret);
+	ut_asserteq(bflow.size, probe->size);
+	bootflow_free(&bflow);
+
+	/* efi looks on the same partition and adds its own file */
+	ut_asserteq(-ENOENT, bootflow_scan_next(&iter, &bflow));
+	ut_asserteq_str("efi", iter.method->name);
+	ut_asserteq(1, iter.part);
+	probe = bootstd_find_probe(blk, 1, "/EFI/BOOT/" BOOTEFI_NAME);
+	ut_assertnonnull(probe);
+	ut_asserteq(-ENOENT, probe->ret);
+
+	/*
+	 * efi looking for extlinux's file gets the recorded result rather than
+	 * asking the filesystem again, as shown by the size
+	 */
+	probe = bootstd_find_probe(blk, 1, conf);
+	ut_assertnonnull(probe);
+	probe->size = 0x1234;
+	desc = dev_get_uclass_plat(blk);
+	ut_assertok(bootmeth_try_file(&bflow, desc, NULL, conf));
+	ut_asserteq(0x1234, bflow.size);
+	bootflow_free(&bflow);
+
+	/* the results are dropped at the end of the scan */
+	bootflow_iter_uninit(&iter);
+	ut_assert(list_empty(&std->probes));
+
+	return 0;
+}
+BOOTSTD_TEST(bootflow_iter_probe_cache, UT_TESTF_DM | UT_TESTF_SCAN_FDT);
+
+/* Record a bootflow in the bootflow cache, as bootflow_run_boot() would */
+static int set_cache_rec(struct unit_test_state *uts, const char *dev_name,
+			 int part, int size, const char *fname)
+{
+	struct bootdev_uc_plat *ucp;
+	struct udevice *dev;
+	char rec[256];
+
+	ut_assertok(uclass_get_device_by_name(UCLASS_BOOTDEV, "mmc1.bootdev",
+					      &dev));
+	ucp = dev_get_uclass_plat(dev);
+	snprintf(rec, sizeof(rec), "%x %s %x extlinux %x %s", ucp->prio,
+		 dev_name, part, size, fname);
+	ut_assertok(env_set("bootflow_cache", rec));
+
+	return 0;
+}
+
+/* Check the cached bootflow is only used while its media is unchanged */
+static int bootflow_scan_cache(struct unit_test_state *uts)
+{
+	const int flags = BOOTFLOWIF_CACHE | BOOTFLOWIF_SKIP_GLOBAL;
+	const char *conf = "/extlinux/extlinux.conf";
+	struct bootflow_iter iter;
+	struct bootflow bflow;
+	int size;
+
+	if (!IS_ENABLED(CONFIG_BOOTSTD_CACHE))
+		return -EAGAIN;
+	bootstd_clear_glob();
+	ut_assertok(env_set("bootflow_cache", NULL));
+
+	/* with no record, a normal scan finds the bootflow */
+	ut_assertok(bootflow_scan_first(NULL, NULL, &iter, flags, &bflow));
+	ut_asserteq_str("mmc1.bootdev.part_1", bflow.name);
+	ut_asserteq(0, iter.flags & BOOTFLOWIF_CACHED);
+	ut_asserteq_str(conf, bflow.fname);
+	size = bflow.size;
+	bootflow_free(&bflow);
+	bootflow_iter_uninit(&iter);
+
+	/* the recorded bootflow is read directly */
+	ut_assertok(set_cache_rec(uts, "mmc1.bootdev", 1, size, conf));
+	ut_assertok(bootflow_scan_first(NULL, NULL, &iter, flags, &bflow));
+	ut_asserteq_str("mmc1.bootdev.part_1", bflow.name);
+	ut_asserteq(BOOTFLOWIF_CACHED, iter.flags & BOOTFLOWIF_CACHED);
+	ut_asserteq(size, bflow.size);
+	bootflow_free(&bflow);
+	bootflow_iter_uninit(&iter);
+
+	/* the file has changed size, so the record is not used */
+	ut_assertok(set_cache_rec(uts, "mmc1.bootdev", 1, size + 1, conf));
+	ut_assertok(bootflow_scan_first(NULL, NULL, &iter, flags, &bflow));
+	ut_asserteq_str("mmc1.bootdev.part_1", bflow.name);
+	ut_asserteq(0, iter.flags & BOOTFLOWIF_CACHED);
+	ut_asserteq(size, bflow.size);
+	bootflow_free(&bflow);
+	bootflow_iter_uninit(&iter);
+
+	/* the file has a different name */
+	ut_assertok(set_cache_rec(uts, "mmc1.bootdev", 1, size,
+				  "/boot/extlinux/extlinux.conf"));
+	ut_assertok(bootflow_scan_first(NULL, NULL, &iter, flags, &bflow));
+	ut_asserteq(0, iter.flags & BOOTFLOWIF_CACHED);
+	ut_asserteq_str(conf, bflow.fname);
+	bootflow_free(&bflow);
+	bootflow_iter_uninit(&iter);
+
+	/* the partition no-longer holds a bootflow */
+	ut_assertok(set_cache_rec(uts, "mmc1.bootdev", 2, size, conf));
+	ut_assertok(bootflow_scan_first(NULL, NULL, &iter, flags, &bflow));
+	ut_asserteq_str("mmc1.bootdev.part_1", bflow.name);
+	ut_asserteq(0, iter.flags & BOOTFLOWIF_CACHED);
+	bootflow_free(&bflow);
+	bootflow_iter_uninit(&iter);
+
+	/* the media has gone, along with its bootdev */
+	ut_assertok(set_cache_rec(uts, "mmc7.bootdev", 1, size, conf));
+	ut_assertok(bootflow_scan_first(NULL, NULL, &iter, flags, &bflow));
+	ut_asserteq_str("mmc1.bootdev.part_1", bflow.name);
+	ut_asserteq(0, iter.flags & BOOTFLOWIF_CACHED);
+	bootflow_free(&bflow);
+	bootflow_iter_uninit(&iter);
+
+	ut_assertok(env_set("bootflow_cache", NULL));
+
+	return 0;
+}
+BOOTSTD_TEST(bootflow_scan_cache, UT_TESTF_DM | UT_TESTF_SCAN_FDT);
+
 #if defined(CONFIG_SANDBOX) && defined(CONFIG_BOOTMETH_GLOBAL)
 /* Check using the system bootdev */
 static int bootflow_system(struct unit_test_state *uts)
@@ -10,6 +10,7 @@
 #include <menu.h>
 #include <video.h>
 #include <linux/input.h>
+#include <u-boot/crc.h>
 #include <test/suites.h>
 #include <test/ut.h>
 #include "bootstd_common.h"
@@ -580,6 +581,17 @@ static int expo_render_image(struct unit_test_state *uts)
 	ut_asserteq(ITEM2, act.select.id);
 	ut_assertok(expo_render(exp));
 
+	/* an update must leave the display as a full redraw would */
+	if (IS_ENABLED(CONFIG_EXPO_INCREMENTAL)) {
+		struct video_priv *priv = dev_get_uclass_priv(dev);
+		u32 crc;
+
+		crc = crc32(0, priv->fb, priv->fb_size);
+		expo_redraw(exp);
+		ut_assertok(expo_render(exp));
+		ut_asserteq(crc, crc32(0, priv->fb, priv->fb_size));
+	}
+
 	/* make sure only the preview for the second item is shown */
 	obj = scene_obj_find(scn, ITEM1_PREVIEW, SCENEOBJT_NONE);
 	ut_asserteq(true, obj->flags & SCENEOF_HIDE);
@@ -6,11 +6,19 @@
  * Written by Simon Glass <sjg@chromium.org>
  */
 
+#include <dm.h>
 #include <image.h>
+#include <asm/cpu.h>
+#include <dm/device-internal.h>
+#include <dm/uclass-internal.h>
+#include <asm/global_data.h>
+#include <linux/libfdt.h>
 #include <test/suites.h>
 #include <test/ut.h>
 #include "bootstd_common.h"
 
+DECLARE_GLOBAL_DATA_PTR;
+
 /* Test of image phase */
 static int test_image_phase(struct unit_test_state *uts)
 {
@@ -33,3 +41,116 @@ static int test_image_phase(struct unit_test_state *uts)
 	return 0;
 }
 BOOTSTD_TEST(test_image_phase, 0);
+
+/* Add an image with a sha256 and a crc32 hash to a FIT being created */
+static int add_hashed_image(void *fit, const char *name, const char *data,
+			    int size)
+{
+	static const char *const algos[] = {"sha256", "crc32"};
+	uint8_t value[FIT_MAX_HASH_LEN];
+	char node[10];
+	int i, len;
+
+	fdt_begin_node(fit, name);
+	fdt_property(fit, FIT_DATA_PROP, data, size);
+	for (i = 0; i < ARRAY_SIZE(algos); i++) {
+		if (calculate_hash(data, size, algos[i], value, &len))
+			return -EINVAL;
+		snprintf(node, sizeof(node), "hash-%d", i + 1);
+		fdt_begin_node(fit, node);
+		fdt_property_string(fit, FIT_ALGO_PROP, algos[i]);
+		fdt_property(fit, FIT_VALUE_PROP, value, len);
+		fdt_end_node(fit);
+	}
+
+	return fdt_end_node(fit);
+}
+
+/* Create a FIT with two images, each with hashes */
+static int create_hashed_fit(void *fit, int size, const char *data1,
+			     const char *data2)
+{
+	fdt_create(fit, size);
+	fdt_finish_reservemap(fit);
+	fdt_begin_node(fit, "");
+	fdt_begin_node(fit, FIT_IMAGES_PATH + 1);
+	add_hashed_image(fit, "kernel", data1, strlen(data1));
+	add_hashed_image(fit, "fdt", data2, strlen(data2));
+	fdt_end_node(fit);
+	fdt_end_node(fit);
+
+	return fdt_finish(fit);
+}
+
+/* Test calculating the hashes of an image while it arrives */
+static int test_image_hasher(struct unit_test_state *uts)
+{
+	const char *data = "this is the kernel, which is loaded in pieces";
+	struct fit_hasher hsr;
+	char fit[1024];
+	int node, len;
+
+	ut_assertok(create_hashed_fit(fit, sizeof(fit), data, "the fdt"));
+	node = fdt_path_offset(fit, "/images/kernel");
+	ut_assert(node > 0);
+	len = strlen(data);
+
+	ut_assertok(fit_hasher_start(&hsr, fit, node));
+	ut_asserteq(2, hsr.count);
+	ut_assertok(fit_hasher_update(&hsr, data, 7));
+	ut_assertok(fit_hasher_update(&hsr, data + 7, 13));
+	ut_assertok(fit_hasher_update(&hsr, data + 20, len - 20));
+	ut_asserteq(1, fit_image_verify_hashed(fit, node, gd_fdt_blob(), data,
+					       len, &hsr));
+	fit_hasher_abort(&hsr);
+
+	/* The calculated hashes are used, not the data */
+	ut_assertok(fit_hasher_start(&hsr, fit, node));
+	ut_assertok(fit_hasher_update(&hsr, "something else", 14));
+	ut_asserteq(0, fit_image_verify_hashed(fit, node, gd_fdt_blob(), data,
+					       len, &hsr));
+	fit_hasher_abort(&hsr);
+
+	/* Without a hasher, the data is hashed */
+	ut_asserteq(1, fit_image_verify_hashed(fit, node, gd_fdt_blob(), data,
+					       len, NULL));
+
+	return 0;
+}
+BOOTSTD_TEST(test_image_hasher, 0);
+
+/* Test verifying all images with the hashing spread across CPUs */
+static int test_image_verify_all(struct unit_test_state *uts)
+{
+	struct udevice *cpu, *dev;
+	char fit[1024];
+	int node;
+
+	/* A hash device would stop the jobs being used */
+	uclass_find_first_device(UCLASS_HASH, &dev);
+	if (dev) {
+		ut_assertok(device_remove(dev, DM_REMOVE_NORMAL));
+		ut_assertok(device_unbind(dev));
+	}
+
+	ut_assertok(create_hashed_fit(fit, sizeof(fit), "the kernel",
+				      "the fdt"));
+	ut_asserteq(1, fit_all_image_verify(fit));
+
+	/* Sandbox CPUs finish each job at once, so one takes both */
+	if (CONFIG_IS_ENABLED(CPU_JOBS)) {
+		ut_assertok(uclass_get_device_by_name(UCLASS_CPU, "cpu@2",
+						      &cpu));
+		ut_asserteq(2, cpu_sandbox_get_jobs(cpu));
+	}
+
+	/* Corrupt the second image */
+	node = fdt_path_offset(fit, "/images/fdt");
+	ut_assert(node > 0);
+	ut_assertok(fdt_setprop_inplace(fit, node, FIT_DATA_PROP, "THE fdt",
+					7));
+	ut_asserteq(0, fit_all_image_verify(fit));
+
+	return 0;
+}
+BOOTSTD_TEST(test_image_verify_all, UT_TESTF_DM | UT_TESTF_SCAN_FDT);
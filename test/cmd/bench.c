@@ -0,0 +1,25 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Tests for bench command
+ */
+
+#include <command.h>
+#include <dm/test.h>
+#include <test/test.h>
+#include <test/ut.h>
+
+/* Test that 'bench mem' reports both results in MB/s */
+static int dm_test_cmd_bench_mem(struct unit_test_state *uts)
+{
+	ut_assertok(run_command("bench mem 10000", 0));
+	ut_assert_nextlinen("memset         64 KiB   ");
+	ut_assert_nextlinen("memcpy         64 KiB   ");
+	ut_assert_console_end();
+
+	ut_asserteq(1, run_command("bench hash nosuch", 0));
+	ut_assert_nextline("Unknown hash algorithm 'nosuch'");
+	ut_assert_console_end();
+
+	return 0;
+}
+DM_TEST(dm_test_cmd_bench_mem, UT_TESTF_CONSOLE_REC);
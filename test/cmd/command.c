@@ -0,0 +1,37 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Tests for looking up commands by name
+ */
+
+#include <command.h>
+#include <test/cmd.h>
+#include <test/ut.h>
+
+/* Check that find_cmd() matches a linear search of the command table */
+static int cmd_test_find_cmd(struct unit_test_state *uts)
+{
+	struct cmd_tbl *start = ll_entry_start(struct cmd_tbl, cmd);
+	const int count = ll_entry_count(struct cmd_tbl, cmd);
+	char name[40];
+	int i, len;
+
+	for (i = 0; i < count; i++) {
+		const char *cmd = start[i].name;
+
+		for (len = 0; len <= strlen(cmd) && len < 30; len++) {
+			strlcpy(name, cmd, len + 1);
+			ut_asserteq_ptr(find_cmd_tbl(name, start, count),
+					find_cmd(name));
+			strcat(name, ".b");
+			ut_asserteq_ptr(find_cmd_tbl(name, start, count),
+					find_cmd(name));
+		}
+	}
+
+	ut_asserteq_str("help", find_cmd("help")->name);
+	ut_asserteq_str("?", find_cmd("?")->name);
+	ut_assertnull(find_cmd("no-such-command"));
+
+	return 0;
+}
+CMD_TEST(cmd_test_find_cmd, 0);
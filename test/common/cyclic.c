@@ -8,6 +8,7 @@
 #include <test/common.h>
 #include <test/test.h>
 #include <test/ut.h>
+#include <time.h>
 #include <watchdog.h>
 #include <linux/delay.h>
 
@@ -32,3 +33,41 @@ static int dm_test_cyclic_running(struct unit_test_state *uts)
 	return 0;
 }
 COMMON_TEST(dm_test_cyclic_running, 0);
+
+/* Test that each function is called when it is due, and not before */
+static int cyclic_counts[2];
+
+static void cyclic_count(void *ctx)
+{
+	cyclic_counts[(ulong)ctx]++;
+}
+
+static int dm_test_cyclic_due(struct unit_test_state *uts)
+{
+	struct cyclic_info *slow, *fast;
+
+	cyclic_counts[0] = 0;
+	cyclic_counts[1] = 0;
+	slow = cyclic_register(cyclic_count, 1000 * 1000 * 1000, "slow",
+			       (void *)0);
+	ut_assertnonnull(slow);
+	fast = cyclic_register(cyclic_count, 1000, "fast", (void *)1);
+	ut_assertnonnull(fast);
+
+	/* Both are due straight away */
+	schedule();
+	ut_asserteq(1, cyclic_counts[0]);
+	ut_asserteq(1, cyclic_counts[1]);
+
+	/* Only the fast one is due again */
+	timer_test_add_offset(1);
+	schedule();
+	ut_asserteq(1, cyclic_counts[0]);
+	ut_asserteq(2, cyclic_counts[1]);
+
+	ut_assertok(cyclic_unregister(fast));
+	ut_assertok(cyclic_unregister(slow));
+
+	return 0;
+}
+COMMON_TEST(dm_test_cyclic_due, 0);
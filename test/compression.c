@@ -6,12 +6,16 @@
 #include <abuf.h>
 #include <bootm.h>
 #include <command.h>
+#include <dm.h>
 #include <gzip.h>
 #include <image.h>
 #include <log.h>
 #include <malloc.h>
 #include <mapmem.h>
 #include <asm/io.h>
+#ifdef CONFIG_SANDBOX
+#include <asm/cpu.h>
+#endif
 
 #include <u-boot/lz4.h>
 #include <u-boot/zlib.h>
@@ -122,6 +126,49 @@ static const char lz4_compressed[] =
 	"\x9d\x12\x8c\x9d";
 static const unsigned long lz4_compressed_size = sizeof(lz4_compressed) - 1;
 
+/*
+ * Runs of repeated patterns with periods of 1 to 20 bytes (100 bytes each),
+ * followed by 200 bytes of literals, see lz4_pattern_byte()
+ * lz4 -9 /tmp/pattern.bin /tmp/pattern.lz4
+ */
+static const char lz4_pattern_compressed[] =
+	"\x04\x22\x4d\x18\x64\x40\xa7\xef\x01\x00\x00\x1f\x25\x01\x00\x50"
+	"\x2f\x4a\x55\x02\x00\x4f\x3f\x6f\x7a\x85\x03\x00\x4e\x4f\x94\x9f"
+	"\xaa\xb5\x04\x00\x4d\x5f\xb9\xc4\xcf\xda\xe5\x05\x00\x4c\x6f\xde"
+	"\xe9\xf4\xff\x0a\x15\x06\x00\x4b\x7f\x03\x0e\x19\x24\x2f\x3a\x45"
+	"\x07\x00\x4a\x8f\x28\x33\x3e\x49\x54\x5f\x6a\x75\x08\x00\x49\x9f"
+	"\x4d\x58\x63\x6e\x79\x84\x8f\x9a\xa5\x09\x00\x48\xaf\x72\x7d\x88"
+	"\x93\x9e\xa9\xb4\xbf\xca\xd5\x0a\x00\x47\xbf\x97\xa2\xad\xb8\xc3"
+	"\xce\xd9\xe4\xef\xfa\x05\x0b\x00\x46\xcf\xbc\xc7\xd2\xdd\xe8\xf3"
+	"\xfe\x09\x14\x1f\x2a\x35\x0c\x00\x45\xdf\xe1\xec\xf7\x02\x0d\x18"
+	"\x23\x2e\x39\x44\x4f\x5a\x65\x0d\x00\x44\xef\x06\x11\x1c\x27\x32"
+	"\x3d\x48\x53\x5e\x69\x74\x7f\x8a\x95\x0e\x00\x43\xff\x00\x2b\x36"
+	"\x41\x4c\x57\x62\x6d\x78\x83\x8e\x99\xa4\xaf\xba\xc5\x0f\x00\x42"
+	"\xff\x01\x50\x5b\x66\x71\x7c\x87\x92\x9d\xa8\xb3\xbe\xc9\xd4\xdf"
+	"\xea\xf5\x10\x00\x41\xff\x02\x75\x80\x8b\x96\xa1\xac\xb7\xc2\xcd"
+	"\xd8\xe3\xee\xf9\x04\x0f\x1a\x25\x11\x00\x40\xff\x03\x9a\xa5\xb0"
+	"\xbb\xc6\xd1\xdc\xe7\xf2\xfd\x08\x13\x1e\x29\x34\x3f\x4a\x55\x12"
+	"\x00\x3f\xff\x04\xbf\xca\xd5\xe0\xeb\xf6\x01\x0c\x17\x22\x2d\x38"
+	"\x43\x4e\x59\x64\x6f\x7a\x85\x13\x00\x3e\x00\x25\x03\xc0\x10\x1b"
+	"\x26\x31\x3c\x47\x52\x5d\x68\x73\x7e\x89\xf0\x05\x0f\x14\x00\x3d"
+	"\xf0\xb9\x00\x14\x36\x66\xa5\xf1\x4b\xb3\x2a\xae\x40\xe0\x8f\x4b"
+	"\x15\xed\xd4\xc8\xca\xda\xf9\x25\x5f\xa7\xfe\x62\xd4\x54\xe3\x7f"
+	"\x29\xe1\xa8\x7c\x5e\x4e\x4d\x59\x73\x9b\xd2\x16\x68\xc8\x37\xb3"
+	"\x3d\xd5\x7c\x30\xf2\xc2\xa1\x8d\x87\x8f\xa6\xca\xfc\x3c\x8b\xe7"
+	"\x51\xc9\x50\xe4\x86\x36\xf5\xc1\x9b\x83\x7a\x7e\x90\xb0\xdf\x1b"
+	"\x65\xbd\x24\x98\x1a\xaa\x49\xf5\xaf\x77\x4e\x32\x24\x24\x33\x4f"
+	"\x79\xb1\xf8\x4c\xae\x1e\x9d\x29\xc3\x6b\x22\xe6\xb8\x98\x87\x83"
+	"\x8d\xa5\xcc\x00\x42\x92\xf1\x5d\xd7\x5f\xf6\x9a\x4c\x0c\xdb\xb7"
+	"\xa1\x99\xa0\xb4\xd6\x06\x45\x91\xeb\x53\xca\x4e\xe0\x80\x2f\xeb"
+	"\xb5\x8d\x74\x68\x6a\x7a\x99\xc5\xff\x47\x9e\x02\x74\xf4\x83\x1f"
+	"\xc9\x81\x48\x1c\xfe\xee\xed\xf9\x13\x3b\x72\xb6\x08\x68\xd7\x53"
+	"\xdd\x75\x1c\xd0\x92\x62\x41\x2d\x27\x2f\x46\x6a\x9c\xdc\x2b\x87"
+	"\xf1\x69\xf0\x84\x26\xd6\x95\x61\x3b\x23\x00\x00\x00\x00\x25\x14"
+	"\x65\x50";
+static const unsigned long lz4_pattern_compressed_size =
+	sizeof(lz4_pattern_compressed) - 1;
+static const unsigned long lz4_pattern_size = 20 * 100 + 200;
+
 /* zstd -19 -c /tmp/plain.txt > /tmp/plain.zst */
 static const char zstd_compressed[] =
 	"\x28\xb5\x2f\xfd\x64\x5e\x00\xbd\x05\x00\x02\x0e\x26\x1a\x70\x17"
@@ -500,6 +547,43 @@ static int compression_test_lz4(struct unit_test_state *uts)
 }
 COMPRESSION_TEST(compression_test_lz4, 0);
 
+static u8 lz4_pattern_byte(int i)
+{
+	int period = i / 100 + 1;
+
+	if (i >= 20 * 100) {
+		i -= 20 * 100;
+		return i * i * 7 + i * 13 + (i >> 2);
+	}
+
+	return period * 37 + (i % 100 % period) * 11;
+}
+
+/* Check overlapping matches with short offsets and long literal runs */
+static int compression_test_lz4_patterns(struct unit_test_state *uts)
+{
+	size_t size = lz4_pattern_size;
+	u8 *out;
+	int i;
+
+	out = malloc(size + 1);
+	ut_assertnonnull(out);
+	out[size] = 0xa5;
+
+	ut_assertok(ulz4fn(lz4_pattern_compressed, lz4_pattern_compressed_size,
+			   out, &size));
+	ut_asserteq(lz4_pattern_size, size);
+	for (i = 0; i < size; i++)
+		ut_asserteq(lz4_pattern_byte(i), out[i]);
+
+	/* nothing may be written past the end of the buffer */
+	ut_asserteq(0xa5, out[size]);
+	free(out);
+
+	return 0;
+}
+COMPRESSION_TEST(compression_test_lz4_patterns, 0);
+
 static int compression_test_zstd(struct unit_test_state *uts)
 {
 	return run_test(uts, "zstd", compress_using_zstd,
@@ -609,6 +693,131 @@ static int compression_test_bootm_none(struct unit_test_state *uts)
 }
 COMPRESSION_TEST(compression_test_bootm_none, 0);
 
+/* Largest read done by mem_reader_read(), so that buffers must be refilled */
+#define STREAM_READ_MAX	7
+
+/**
+ * struct mem_reader - reader which provides an image from memory
+ *
+ * @rd: Image reader
+ * @buf: Image data
+ * @size: Size of image data
+ */
+struct mem_reader {
+	struct image_reader rd;
+	const void *buf;
+	ulong size;
+};
+
+static long mem_reader_read(struct image_reader *rd, ulong offset, void *buf,
+			    ulong size)
+{
+	struct mem_reader *mrd = container_of(rd, struct mem_reader, rd);
+
+	if (offset >= mrd->size)
+		return 0;
+	size = min(size, mrd->size - offset);
+	size = min(size, (ulong)STREAM_READ_MAX);
+	memcpy(buf, mrd->buf + offset, size);
+
+	return size;
+}
+
+/**
+ * run_stream_test() - Run tests on decompression while an image is read
+ *
+ * @comp_type:	Compression type to test
+ * @compress:	Our function to compress data
+ * Return: 0 if OK, non-zero on failure
+ */
+static int run_stream_test(struct unit_test_state *uts, int comp_type,
+			   mutate_func compress)
+{
+	struct mem_reader mrd;
+	ulong compress_size = 1024;
+	char compress_buff[1024];
+	char out[1024];
+	ulong unc_len;
+	ulong len;
+	int ret;
+
+	unc_len = strlen(plain);
+	ut_assertok(compress(uts, (void *)plain, unc_len, compress_buff,
+			     compress_size, &compress_size));
+	mrd.rd.read = mem_reader_read;
+	mrd.buf = compress_buff;
+	mrd.size = compress_size;
+
+	memset(out, '\0', sizeof(out));
+	ut_assertok(image_decomp_stream(comp_type, out, sizeof(out), &mrd.rd,
+					&len));
+	ut_asserteq(unc_len, len);
+	ut_asserteq_mem(plain, out, unc_len);
+
+	/* Exactly enough space */
+	ut_assertok(image_decomp_stream(comp_type, out, unc_len, &mrd.rd,
+					&len));
+	ut_asserteq(unc_len, len);
+
+	/* lz4 cannot tell an output overrun from corrupt data */
+	ret = image_decomp_stream(comp_type, out, unc_len - 1, &mrd.rd, &len);
+	if (comp_type == IH_COMP_LZ4)
+		ut_assert(ret);
+	else
+		ut_asserteq(-ENOSPC, ret);
+
+	/* We can't detect corruption when not decompressing */
+	if (comp_type == IH_COMP_NONE)
+		return 0;
+
+	/* A truncated image must fail */
+	mrd.size = compress_size / 2;
+	ut_assert(image_decomp_stream(comp_type, out, sizeof(out), &mrd.rd,
+				      &len));
+
+	return 0;
+}
+
+static int compression_test_stream_gzip(struct unit_test_state *uts)
+{
+	return run_stream_test(uts, IH_COMP_GZIP, compress_using_gzip);
+}
+COMPRESSION_TEST(compression_test_stream_gzip, 0);
+
+static int compression_test_stream_lz4(struct unit_test_state *uts)
+{
+	return run_stream_test(uts, IH_COMP_LZ4, compress_using_lz4);
+}
+COMPRESSION_TEST(compression_test_stream_lz4, 0);
+
+static int compression_test_stream_zstd(struct unit_test_state *uts)
+{
+	return run_stream_test(uts, IH_COMP_ZSTD, compress_using_zstd);
+}
+COMPRESSION_TEST(compression_test_stream_zstd, 0);
+
+static int compression_test_stream_none(struct unit_test_state *uts)
+{
+	return run_stream_test(uts, IH_COMP_NONE, compress_using_none);
+}
+COMPRESSION_TEST(compression_test_stream_none, 0);
+
+static int compression_test_stream_bzip2(struct unit_test_state *uts)
+{
+	struct mem_reader mrd;
+	ulong len;
+	char out[16];
+
+	mrd.rd.read = mem_reader_read;
+	mrd.buf = bzip2_compressed;
+	mrd.size = bzip2_compressed_size;
+	ut_asserteq(-ENOSYS, image_decomp_stream(IH_COMP_BZIP2, out,
+						 sizeof(out), &mrd.rd, &len));
+
+	return 0;
+}
+COMPRESSION_TEST(compression_test_stream_bzip2, 0);
+
 int do_ut_compression(struct cmd_tbl *cmdtp, int flag, int argc,
 		      char *const argv[])
 {
@@ -618,3 +827,62 @@ int do_ut_compression(struct cmd_tbl *cmdtp, int flag, int argc,
 	return cmd_ut_category("compression", "compression_test_",
 			       tests, n_ents, argc, argv);
 }
+
+/* Test a zstd payload made of more than one frame */
+static int compression_test_zstd_frames(struct unit_test_state *uts)
+{
+	/* a skippable frame, with four bytes of content */
+	static const char skip[] = "\x50\x2a\x4d\x18\x04\x00\x00\x00skip";
+	ulong unc_len = strlen(plain), size, len;
+	struct abuf in_buf, out_buf;
+	struct mem_reader mrd;
+	char in[1024], out[1024];
+	char *ptr = in;
+
+	ut_assert(2 * zstd_compressed_size + sizeof(skip) + 4 <= sizeof(in));
+	memcpy(ptr, zstd_compressed, zstd_compressed_size);
+	ptr += zstd_compressed_size;
+	memcpy(ptr, skip, sizeof(skip) - 1);
+	ptr += sizeof(skip) - 1;
+	memcpy(ptr, zstd_compressed, zstd_compressed_size);
+	ptr += zstd_compressed_size;
+	/* padding after the last frame is ignored */
+	memset(ptr, '\0', 4);
+	ptr += 4;
+	size = ptr - in;
+
+	/* each frame has its size, so the second can go to another CPU */
+	memset(out, '\0', sizeof(out));
+	abuf_init_set(&in_buf, in, size);
+	abuf_init_set(&out_buf, out, sizeof(out));
+	ut_asserteq(2 * unc_len, zstd_decompress(&in_buf, &out_buf));
+	ut_asserteq_mem(plain, out, unc_len);
+	ut_asserteq_mem(plain, out + unc_len, unc_len);
+#ifdef CONFIG_SANDBOX
+	if (CONFIG_IS_ENABLED(CPU_JOBS)) {
+		struct udevice *cpu;
+
+		ut_assertok(uclass_get_device_by_name(UCLASS_CPU, "cpu@2",
+						      &cpu));
+		ut_asserteq(2, cpu_sandbox_get_jobs(cpu));
+	}
+#endif
+
+	/* too little space for the second frame */
+	abuf_init_set(&out_buf, out, 2 * unc_len - 1);
+	ut_assert(zstd_decompress(&in_buf, &out_buf) < 0);
+
+	/* frames are also handled when decompressing as the image is read */
+	mrd.rd.read = mem_reader_read;
+	mrd.buf = in;
+	mrd.size = size;
+	memset(out, '\0', sizeof(out));
+	ut_assertok(image_decomp_stream(IH_COMP_ZSTD, out, sizeof(out),
+					&mrd.rd, &len));
+	ut_asserteq(2 * unc_len, len);
+	ut_asserteq_mem(plain, out, unc_len);
+	ut_asserteq_mem(plain, out + unc_len, unc_len);
+
+	return 0;
+}
+COMPRESSION_TEST(compression_test_zstd_frames, UT_TESTF_DM | UT_TESTF_SCAN_FDT);
@@ -5,11 +5,15 @@
 
 #include <blk.h>
 #include <dm.h>
+#include <fs_internal.h>
+#include <malloc.h>
+#include <os.h>
 #include <part.h>
 #include <sandbox_host.h>
 #include <usb.h>
 #include <asm/global_data.h>
 #include <asm/state.h>
+#include <dm/device-internal.h>
 #include <dm/test.h>
 #include <test/test.h>
 #include <test/ut.h>
@@ -334,3 +338,216 @@ static int dm_test_blk_foreach(struct unit_test_state *uts)
 	return 0;
 }
 DM_TEST(dm_test_blk_foreach, UT_TESTF_SCAN_PDATA | UT_TESTF_SCAN_FDT);
+
+/* Test asynchronous reads and writes, including a full queue */
+static int dm_test_blk_async(struct unit_test_state *uts)
+{
+	struct blk_req req[6];
+	struct blk_desc *desc;
+	struct udevice *dev, *blk;
+	char fname[256];
+	char *buf, *cmp;
+	int i;
+
+	ut_assertok(os_persistent_file(fname, sizeof(fname), "2MB.ext2.img"));
+	ut_assertok(host_create_attach_file("test", fname, false,
+					    DEFAULT_BLKSZ, &dev));
+	ut_assertok(blk_get_from_parent(dev, &blk));
+	ut_assertok(device_probe(blk));
+	desc = dev_get_uclass_plat(blk);
+
+	buf = malloc(ARRAY_SIZE(req) * 4 * desc->blksz);
+	cmp = malloc(ARRAY_SIZE(req) * 4 * desc->blksz);
+	ut_assertnonnull(buf);
+	ut_assertnonnull(cmp);
+	ut_asserteq(ARRAY_SIZE(req) * 4, blk_read(blk, 0, ARRAY_SIZE(req) * 4,
+						  cmp));
+
+	/* make sure the reads actually reach the driver */
+	blkcache_invalidate(desc->uclass_id, desc->devnum);
+
+	for (i = 0; i < ARRAY_SIZE(req); i++) {
+		req[i].start = i * 4;
+		req[i].blkcnt = 4;
+		req[i].buffer = buf + i * 4 * desc->blksz;
+	}
+
+	/* the sandbox driver holds four requests until polled */
+	for (i = 0; i < desc->queue_depth; i++)
+		ut_assertok(blk_submit_read(blk, &req[i]));
+	ut_asserteq(4, i);
+	ut_asserteq(-EBUSY, blk_submit_read(blk, &req[i]));
+	ut_asserteq(false, req[0].done);
+
+	ut_asserteq(0, blk_poll(blk));
+	for (i = 0; i < 4; i++) {
+		ut_asserteq(true, req[i].done);
+		ut_asserteq(4, req[i].result);
+	}
+
+	ut_assertok(blk_submit_read(blk, &req[4]));
+	ut_assertok(blk_submit_read(blk, &req[5]));
+	ut_asserteq(4, blk_wait(blk, &req[5]));
+	ut_asserteq(true, req[4].done);
+	ut_asserteq_mem(cmp, buf, ARRAY_SIZE(req) * 4 * desc->blksz);
+
+	/* write the same data back, so the image is unchanged */
+	for (i = 0; i < ARRAY_SIZE(req); i++)
+		req[i].buffer = cmp + i * 4 * desc->blksz;
+	for (i = 0; i < desc->queue_depth; i++)
+		ut_assertok(blk_submit_write(blk, &req[i]));
+	ut_asserteq(-EBUSY, blk_submit_write(blk, &req[i]));
+	ut_asserteq(false, req[0].done);
+	ut_asserteq(true, req[0].write);
+	ut_asserteq(0, blk_poll(blk));
+	ut_assertok(blk_submit_write(blk, &req[4]));
+	ut_assertok(blk_submit_write(blk, &req[5]));
+	ut_asserteq(4, blk_wait(blk, &req[5]));
+	for (i = 0; i < ARRAY_SIZE(req); i++) {
+		ut_asserteq(true, req[i].done);
+		ut_asserteq(4, req[i].result);
+	}
+	memset(buf, '\0', ARRAY_SIZE(req) * 4 * desc->blksz);
+	ut_asserteq(ARRAY_SIZE(req) * 4, blk_read(blk, 0, ARRAY_SIZE(req) * 4,
+						  buf));
+	ut_asserteq_mem(cmp, buf, ARRAY_SIZE(req) * 4 * desc->blksz);
+
+	/* waiting for a request that was never submitted should fail */
+	req[0].done = false;
+	ut_asserteq(-EINVAL, blk_wait(blk, &req[0]));
+
+	free(buf);
+	free(cmp);
+	ut_assertok(host_detach_file(dev));
+	ut_assertok(device_unbind(dev));
+
+	return 0;
+}
+DM_TEST(dm_test_blk_async, UT_TESTF_SCAN_FDT);
+
+/* Test the block cache, including widening reads and read-ahead */
+static int dm_test_blk_cache(struct unit_test_state *uts)
+{
+	struct block_cache_dev_stats dstats;
+	struct block_cache_stats stats;
+	struct blk_desc *desc;
+	struct udevice *dev, *blk;
+	char fname[256];
+	char *buf, *cmp;
+	int i;
+
+	ut_assertok(os_persistent_file(fname, sizeof(fname), "2MB.ext2.img"));
+	ut_assertok(host_create_attach_file("test", fname, false,
+					    DEFAULT_BLKSZ, &dev));
+	ut_assertok(blk_get_from_parent(dev, &blk));
+	ut_assertok(device_probe(blk));
+	desc = dev_get_uclass_plat(blk);
+
+	buf = malloc(80 * desc->blksz);
+	cmp = malloc(80 * desc->blksz);
+	ut_assertnonnull(buf);
+	ut_assertnonnull(cmp);
+
+	/* get the expected data with the cache disabled */
+	blkcache_configure(0, 0);
+	ut_asserteq(80, blk_read(blk, 0, 80, cmp));
+
+	blkcache_configure(16, 128);
+	blkcache_set_readahead(4);
+
+	/* reading all the device statistics resets them */
+	for (i = 0; !blkcache_dev_stats(i, &dstats);)
+		i++;
+	blkcache_stats(&stats);
+	ut_asserteq(0, stats.entries);
+	ut_asserteq(4, stats.ways);
+
+	/* a small read fills its whole line, so a nearby read hits */
+	ut_asserteq(1, blk_read(blk, 3, 1, buf));
+	ut_asserteq_mem(cmp + 3 * desc->blksz, buf, desc->blksz);
+	ut_asserteq(2, blk_read(blk, 5, 2, buf));
+	ut_asserteq_mem(cmp + 5 * desc->blksz, buf, 2 * desc->blksz);
+	blkcache_stats(&stats);
+	ut_asserteq(1, stats.hits);
+	ut_asserteq(1, stats.misses);
+	ut_asserteq(1, stats.entries);
+
+	/* a sequential read brings in the following lines too */
+	ut_asserteq(9, blk_read(blk, 7, 9, buf));
+	ut_asserteq(16, blk_read(blk, 16, 16, buf));
+	ut_asserteq_mem(cmp + 16 * desc->blksz, buf, 16 * desc->blksz);
+	blkcache_stats(&stats);
+	ut_asserteq(6, stats.entries);
+	ut_asserteq(48, blk_read(blk, 32, 48, buf));
+	ut_asserteq_mem(cmp + 32 * desc->blksz, buf, 48 * desc->blksz);
+	blkcache_stats(&stats);
+	ut_asserteq(1, stats.hits);
+	ut_asserteq(0, stats.misses);
+
+	/* check the per-device statistics */
+	for (i = 0; !blkcache_dev_stats(i, &dstats); i++) {
+		if (dstats.iftype == UCLASS_HOST &&
+		    dstats.devnum == desc->devnum)
+			break;
+	}
+	ut_asserteq(UCLASS_HOST, dstats.iftype);
+	ut_asserteq(1, dstats.readaheads);
+	ut_asserteq(3, dstats.hits);
+
+	/* writing invalidates the cache for the device */
+	ut_asserteq(1, blk_write(blk, 0, 1, cmp));
+	blkcache_stats(&stats);
+	ut_asserteq(0, stats.entries);
+
+	blkcache_configure(CONFIG_BLOCK_CACHE_LINE_BLOCKS,
+			   CONFIG_BLOCK_CACHE_LINES);
+	blkcache_set_readahead(CONFIG_BLOCK_CACHE_READAHEAD);
+	free(buf);
+	free(cmp);
+	ut_assertok(host_detach_file(dev));
+	ut_assertok(device_unbind(dev));
+
+	return 0;
+}
+DM_TEST(dm_test_blk_cache, UT_TESTF_SCAN_FDT);
+
+/* Test reading whole blocks into a buffer which is not aligned for DMA */
+static int dm_test_blk_fs_dread(struct unit_test_state *uts)
+{
+	struct blk_desc *desc;
+	struct udevice *dev, *blk;
+	char fname[256];
+	char *buf, *cmp;
+	int ofs;
+
+	ut_assertok(os_persistent_file(fname, sizeof(fname), "2MB.ext2.img"));
+	ut_assertok(host_create_attach_file("test", fname, false,
+					    DEFAULT_BLKSZ, &dev));
+	ut_assertok(blk_get_from_parent(dev, &blk));
+	ut_assertok(device_probe(blk));
+	desc = dev_get_uclass_plat(blk);
+
+	buf = memalign(ARCH_DMA_MINALIGN, 10 * desc->blksz);
+	cmp = malloc(8 * desc->blksz);
+	ut_assertnonnull(buf);
+	ut_assertnonnull(cmp);
+	ut_asserteq(8, blk_read(blk, 2, 8, cmp));
+
+	for (ofs = 0; ofs < ARCH_DMA_MINALIGN; ofs += 3) {
+		memset(buf, '\xff', 10 * desc->blksz);
+		ut_asserteq(8, fs_blk_dread(desc, 2, 8, buf + ofs));
+		ut_asserteq_mem(cmp, buf + ofs, 8 * desc->blksz);
+
+		/* a single block must be bounced entirely */
+		ut_asserteq(1, fs_blk_dread(desc, 2, 1, buf + ofs));
+		ut_asserteq_mem(cmp, buf + ofs, desc->blksz);
+	}
+
+	free(buf);
+	free(cmp);
+	ut_assertok(host_detach_file(dev));
+	ut_assertok(device_unbind(dev));
+
+	return 0;
+}
+DM_TEST(dm_test_blk_fs_dread, UT_TESTF_SCAN_FDT);
@@ -136,6 +136,50 @@ static int dm_test_blkmap_slicing(struct unit_test_state *uts)
 }
 DM_TEST(dm_test_blkmap_slicing, 0);
 
+static int dm_test_blkmap_merge(struct unit_test_state *uts)
+{
+	struct udevice *dev, *blk;
+	struct blkmap *bm;
+	void *ptr;
+
+	ut_assertok(blkmap_create("mergetest", &dev));
+	ut_assertok(blk_get_from_parent(dev, &blk));
+	bm = dev_get_plat(dev);
+
+	/* Contiguous memory is merged into a single slice, in any order */
+	ut_assertok(blkmap_map_mem(dev, 0, 2, identity));
+	ut_assertok(blkmap_map_mem(dev, 4, 4, identity + 4 * BLKSZ));
+	ut_assertok(blkmap_map_mem(dev, 2, 2, identity + 2 * BLKSZ));
+	ut_assert(list_is_singular(&bm->slices));
+
+	ut_assertok(blkmap_get_mem(blk, 3, 5, &ptr));
+	ut_asserteq_ptr(identity + 3 * BLKSZ, ptr);
+	ut_asserteq(-ENOENT, blkmap_get_mem(blk, 8, 1, &ptr));
+	ut_assertok(blkmap_destroy(dev));
+
+	/* Discontiguous memory is not */
+	ut_assertok(blkmap_create("mergetest", &dev));
+	ut_assertok(blk_get_from_parent(dev, &blk));
+	bm = dev_get_plat(dev);
+
+	mkblob(unordered, unordered_mapping);
+	mkblob(identity, identity_mapping);
+	ut_assertok(blkmap_map_mem(dev, 0, 4, identity));
+	ut_assertok(blkmap_map_mem(dev, 4, 4, unordered + 4 * BLKSZ));
+	ut_assert(!list_is_singular(&bm->slices));
+
+	/* A read or direct access may not stray outside a slice */
+	ut_asserteq(-ENOENT, blkmap_get_mem(blk, 2, 4, &ptr));
+	ut_asserteq(4, blk_read(blk, 2, 4, buffer));
+	ut_assertok(memcmp(buffer, identity + 2 * BLKSZ, 2 * BLKSZ));
+	ut_assertok(memcmp(buffer + 2 * BLKSZ, unordered + 4 * BLKSZ,
+			   2 * BLKSZ));
+
+	ut_assertok(blkmap_destroy(dev));
+	return 0;
+}
+DM_TEST(dm_test_blkmap_merge, 0);
+
 static int dm_test_blkmap_creation(struct unit_test_state *uts)
 {
 	struct udevice *first, *second;
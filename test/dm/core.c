@@ -1262,6 +1262,48 @@ static int dm_test_uclass_find_device(struct unit_test_state *uts)
 }
 DM_TEST(dm_test_uclass_find_device, UT_TESTF_SCAN_FDT);
 
+/* Test that repeated lookups stay correct when devices change */
+static int dm_test_uclass_find_repeat(struct unit_test_state *uts)
+{
+	struct udevice *dev, *found;
+	int seq;
+
+	ut_assertok(uclass_find_first_device(UCLASS_TEST_FDT, &dev));
+	seq = dev_seq(dev);
+
+	/* Look up twice, so a cached result is used the second time */
+	ut_assertok(uclass_find_device_by_seq(UCLASS_TEST_FDT, seq, &found));
+	ut_asserteq_ptr(dev, found);
+	ut_assertok(uclass_find_device_by_seq(UCLASS_TEST_FDT, seq, &found));
+	ut_asserteq_ptr(dev, found);
+	ut_assertok(uclass_find_device_by_ofnode(UCLASS_TEST_FDT,
+						 dev_ofnode(dev), &found));
+	ut_assertok(uclass_find_device_by_ofnode(UCLASS_TEST_FDT,
+						 dev_ofnode(dev), &found));
+	ut_asserteq_ptr(dev, found);
+	ut_assertok(uclass_find_device_by_name(UCLASS_TEST_FDT, dev->name,
+					       &found));
+	ut_assertok(uclass_find_device_by_name(UCLASS_TEST_FDT, dev->name,
+					       &found));
+	ut_asserteq_ptr(dev, found);
+
+	/* A device which changes its sequence number must not be found */
+	dev->seq_ = 100;
+	ut_asserteq(-ENODEV,
+		    uclass_find_device_by_seq(UCLASS_TEST_FDT, seq, &found));
+	ut_assertok(uclass_find_device_by_seq(UCLASS_TEST_FDT, 100, &found));
+	ut_asserteq_ptr(dev, found);
+	dev->seq_ = seq;
+
+	/* Nor one which has been unbound */
+	ut_assertok(device_unbind(dev));
+	ut_asserteq(-ENODEV,
+		    uclass_find_device_by_seq(UCLASS_TEST_FDT, seq, &found));
+
+	return 0;
+}
+DM_TEST(dm_test_uclass_find_repeat, UT_TESTF_SCAN_FDT);
+
 /* Test getting information about tags attached to devices */
 static int dm_test_dev_get_attach(struct unit_test_state *uts)
 {
@@ -11,6 +11,10 @@
 #include <cpu.h>
 #include <test/test.h>
 #include <test/ut.h>
+#include <asm/cpu.h>
+#include <asm/global_data.h>
+
+DECLARE_GLOBAL_DATA_PTR;
 
 static int dm_test_cpu(struct unit_test_state *uts)
 {
@@ -47,3 +51,78 @@ static int dm_test_cpu(struct unit_test_state *uts)
 }
 
 DM_TEST(dm_test_cpu, UT_TESTF_SCAN_FDT);
+
+static int cpu_test_job(struct cpu_job *job)
+{
+	int *val = job->priv;
+
+	return ++*val;
+}
+
+/* Test running jobs on other CPUs */
+static int dm_test_cpu_job(struct unit_test_state *uts)
+{
+	struct udevice *cpu1, *cpu2, *cpu3;
+	struct cpu_job job;
+	int val = 0;
+
+	ut_assertok(uclass_get_device_by_name(UCLASS_CPU, "cpu@1", &cpu1));
+	ut_assertok(uclass_get_device_by_name(UCLASS_CPU, "cpu@2", &cpu2));
+	ut_assertok(uclass_get_device_by_name(UCLASS_CPU, "cpu@3", &cpu3));
+	ut_asserteq(3, cpu_job_cpus());
+
+	/* The first CPU which is not the current one takes the job */
+	job.func = cpu_test_job;
+	job.priv = &val;
+	ut_assertok(cpu_job_start(&job));
+	ut_asserteq(1, cpu_job_wait(&job));
+	ut_asserteq_ptr(cpu2, job.dev);
+	ut_asserteq(1, cpu_sandbox_get_jobs(cpu2));
+
+	/* Skip a busy CPU */
+	cpu_sandbox_set_busy(cpu2, true);
+	ut_assertok(cpu_job_start(&job));
+	ut_asserteq(2, cpu_job_wait(&job));
+	ut_asserteq_ptr(cpu3, job.dev);
+	ut_asserteq(1, cpu_sandbox_get_jobs(cpu3));
+
+	/* With nothing free the job runs on the current CPU */
+	cpu_sandbox_set_busy(cpu3, true);
+	ut_assertok(cpu_job_start(&job));
+	ut_asserteq(3, cpu_job_wait(&job));
+	ut_assertnull(job.dev);
+	ut_asserteq(0, cpu_sandbox_get_jobs(cpu1));
+	ut_asserteq(1, cpu_sandbox_get_jobs(cpu2));
+	ut_asserteq(1, cpu_sandbox_get_jobs(cpu3));
+
+	return 0;
+}
+DM_TEST(dm_test_cpu_job, UT_TESTF_SCAN_FDT);
+
+/* Test setting the performance level while booting */
+static int dm_test_cpu_perf(struct unit_test_state *uts)
+{
+	ulong boosted = gd->flags & GD_FLG_CPU_BOOST;
+	struct udevice *cpu;
+
+	ut_assertok(uclass_get_device_by_name(UCLASS_CPU, "cpu@1", &cpu));
+	ut_asserteq(CPU_PERF_OS, cpu_sandbox_get_perf(cpu));
+
+	/* The sandbox thermal sensor reads 100C, which is too hot */
+	gd->flags &= ~GD_FLG_CPU_BOOST;
+	ut_asserteq(-EAGAIN, cpu_boot_boost());
+	ut_asserteq(CPU_PERF_OS, cpu_sandbox_get_perf(cpu));
+	ut_assertok(cpu_boot_restore());
+
+	ut_assertok(cpu_set_perf(cpu, CPU_PERF_BOOT));
+	ut_asserteq(CPU_PERF_BOOT, cpu_sandbox_get_perf(cpu));
+	ut_assert(gd->flags & GD_FLG_CPU_BOOST);
+
+	ut_assertok(cpu_boot_restore());
+	ut_asserteq(CPU_PERF_OS, cpu_sandbox_get_perf(cpu));
+	ut_assert(!(gd->flags & GD_FLG_CPU_BOOST));
+	gd->flags |= boosted;
+
+	return 0;
+}
+DM_TEST(dm_test_cpu_perf, UT_TESTF_SCAN_FDT);
@@ -12,6 +12,7 @@
 #include <dma.h>
 #include <test/test.h>
 #include <test/ut.h>
+#include <asm/cache.h>
 
 static int dm_test_dma_m2m(struct unit_test_state *uts)
 {
@@ -36,6 +37,39 @@ static int dm_test_dma_m2m(struct unit_test_state *uts)
 }
 DM_TEST(dm_test_dma_m2m, UT_TESTF_SCAN_FDT);
 
+#if CONFIG_IS_ENABLED(DMA_BULK_COPY)
+static int dm_test_dma_bulk_copy(struct unit_test_state *uts)
+{
+	size_t len = CONFIG_DMA_BULK_COPY_MIN + 3;
+	u8 *src_buf, *dst_buf;
+	int i;
+
+	src_buf = memalign(ARCH_DMA_MINALIGN, len + ARCH_DMA_MINALIGN);
+	dst_buf = memalign(ARCH_DMA_MINALIGN, len + ARCH_DMA_MINALIGN);
+	ut_assertnonnull(src_buf);
+	ut_assertnonnull(dst_buf);
+	for (i = 0; i < len; i++)
+		src_buf[i + 1] = i;
+
+	/* Neither end is on a cache line */
+	memset(dst_buf, '\0', len + 1);
+	ut_assertok(dma_bulk_copy(dst_buf + 1, src_buf + 1, len));
+	ut_asserteq_mem(src_buf + 1, dst_buf + 1, len);
+
+	/* These must be left to the caller */
+	ut_asserteq(-EINVAL, dma_bulk_copy(dst_buf, src_buf, len / 2));
+	ut_asserteq(-EINVAL, dma_bulk_copy(dst_buf + 1, src_buf, len));
+	ut_asserteq(-EINVAL, dma_bulk_copy(src_buf + ARCH_DMA_MINALIGN,
+					   src_buf, len));
+
+	free(src_buf);
+	free(dst_buf);
+
+	return 0;
+}
+DM_TEST(dm_test_dma_bulk_copy, UT_TESTF_SCAN_FDT);
+#endif
+
 static int dm_test_dma(struct unit_test_state *uts)
 {
 	struct udevice *dev;
@@ -616,6 +616,76 @@ static int dm_test_eth_async_ping_reply(struct unit_test_state *uts)
 
 DM_TEST(dm_test_eth_async_ping_reply, UT_TESTF_SCAN_FDT);
 
+/* Number of echo replies sent to the host which pinged us */
+static int sb_batch_replies;
+
+static int sb_with_batch_handler(struct udevice *dev, void *packet,
+				 unsigned int len)
+{
+	struct eth_sandbox_priv *priv = dev_get_priv(dev);
+	struct ethernet_hdr *eth = packet;
+	struct arp_hdr *arp = packet + ETHER_HDR_SIZE;
+	struct ip_udp_hdr *ip = packet + ETHER_HDR_SIZE;
+	struct icmp_hdr *icmp = (struct icmp_hdr *)&ip->udp_src;
+	int i, ret;
+
+	/*
+	 * Before replying to our ARP request, have another host send us
+	 * several pings, so that they arrive together
+	 */
+	if (ntohs(eth->et_protlen) == PROT_ARP &&
+	    ntohs(arp->ar_op) == ARPOP_REQUEST) {
+		priv->fake_host_ipaddr = string_to_ip("1.1.2.4");
+		for (i = 0; i < PKTBUFSRX - 1; i++) {
+			ret = sandbox_eth_recv_ping_req(dev);
+			if (ret)
+				return ret;
+		}
+	}
+
+	if (ntohs(eth->et_protlen) == PROT_IP && ip->ip_p == IPPROTO_ICMP &&
+	    icmp->type == ICMP_ECHO_REPLY &&
+	    net_read_ip(&ip->ip_dst).s_addr == string_to_ip("1.1.2.4").s_addr)
+		sb_batch_replies++;
+
+	sandbox_eth_arp_req_to_reply(dev, packet, len);
+	sandbox_eth_ping_req_to_reply(dev, packet, len);
+
+	return 0;
+}
+
+/* Test receiving and sending packets in batches */
+static int dm_test_eth_batch(struct unit_test_state *uts)
+{
+	struct eth_sandbox_priv *priv;
+	struct udevice *dev;
+
+	net_ping_ip = string_to_ip("1.1.2.2");
+	sb_batch_replies = 0;
+
+	ut_assertok(uclass_get_device(UCLASS_ETH, 0, &dev));
+	priv = dev_get_priv(dev);
+	sandbox_eth_set_tx_handler(0, sb_with_batch_handler);
+	sandbox_eth_set_batch(0, true);
+
+	env_set("ethact", "eth@10002000");
+	ut_assertok(net_loop(PING));
+
+	/*
+	 * All the pings and the ARP reply were received in one batch, so the
+	 * echo replies and our own echo request were sent together
+	 */
+	ut_asserteq(PKTBUFSRX - 1, sb_batch_replies);
+	ut_asserteq(PKTBUFSRX, priv->send_batch_max);
+	ut_asserteq(0, priv->recv_packets);
+
+	sandbox_eth_set_batch(0, false);
+	sandbox_eth_set_tx_handler(0, NULL);
+
+	return 0;
+}
+DM_TEST(dm_test_eth_batch, UT_TESTF_SCAN_FDT);
+
 #if IS_ENABLED(CONFIG_IPV6_ROUTER_DISCOVERY)
 
 static u8 ip6_ra_buf[] = {0x60, 0xf, 0xc5, 0x4a, 0x0, 0x38, 0x3a, 0xff, 0xfe,
@@ -721,6 +721,44 @@ static int dm_test_gpio_get_values_as_int(struct unit_test_state *uts)
 DM_TEST(dm_test_gpio_get_values_as_int,
 	UT_TESTF_SCAN_PDATA | UT_TESTF_SCAN_FDT);
 
+/* Check reading and setting a list of GPIOs across two devices */
+static int dm_test_gpio_values(struct unit_test_state *uts)
+{
+	const int gpio_count = 3;
+	struct gpio_desc desc[gpio_count];
+	struct udevice *dev;
+	ulong values;
+	int i;
+
+	ut_assertok(uclass_get_device(UCLASS_TEST_FDT, 0, &dev));
+	ut_asserteq_str("a-test", dev->name);
+
+	/* gpio_a 1, gpio_a 4 and gpio_b 5 */
+	ut_asserteq(3, gpio_request_list_by_name(dev, "test-gpios", desc,
+						 gpio_count, GPIOD_IS_OUT));
+	ut_assertok(dm_gpio_set_values(desc, gpio_count, 5));
+	ut_asserteq(1, sandbox_gpio_get_value(desc[0].dev, desc[0].offset));
+	ut_asserteq(0, sandbox_gpio_get_value(desc[1].dev, desc[1].offset));
+	ut_asserteq(1, sandbox_gpio_get_value(desc[2].dev, desc[2].offset));
+	ut_assertok(dm_gpio_get_values(desc, gpio_count, &values));
+	ut_asserteq(5, values);
+
+	ut_assertok(dm_gpio_set_values(desc, gpio_count, 2));
+	ut_asserteq(0, sandbox_gpio_get_value(desc[0].dev, desc[0].offset));
+	ut_asserteq(1, sandbox_gpio_get_value(desc[1].dev, desc[1].offset));
+	ut_asserteq(0, sandbox_gpio_get_value(desc[2].dev, desc[2].offset));
+	ut_assertok(dm_gpio_get_values(desc, gpio_count, &values));
+	ut_asserteq(2, values);
+
+	ut_asserteq(-E2BIG, dm_gpio_get_values(desc, BITS_PER_LONG + 1,
+					       &values));
+	for (i = 0; i < gpio_count; i++)
+		ut_assertok(dm_gpio_free(dev, &desc[i]));
+
+	return 0;
+}
+DM_TEST(dm_test_gpio_values, UT_TESTF_SCAN_PDATA | UT_TESTF_SCAN_FDT);
+
 /* Check that an active-low GPIO works as expected */
 static int dm_test_gpio_get_values_as_int_base3(struct unit_test_state *uts)
 {
@@ -0,0 +1,59 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Tests for hashing with hash devices
+ */
+
+#include <dm.h>
+#include <hash.h>
+#include <dm/test.h>
+#include <dm/uclass-internal.h>
+#include <test/test.h>
+#include <test/ut.h>
+#include <u-boot/sha256.h>
+#include <u-boot/sha512.h>
+
+static const char hash_test_data[] =
+	"The quick brown fox jumps over the lazy dog";
+
+/* Test that the SHA algorithms are run on the hash device */
+static int dm_test_hash_lookup(struct unit_test_state *uts)
+{
+	uint8_t expect[SHA384_SUM_LEN], out[SHA384_SUM_LEN];
+	int len = strlen(hash_test_data);
+	struct hash_algo *algo;
+	struct udevice *dev;
+	int size;
+	void *ctx;
+
+	ut_assertok(uclass_find_first_device(UCLASS_HASH, &dev));
+	ut_assertnonnull(dev);
+	ut_assert(!device_active(dev));
+
+	sha256_csum_wd((const uchar *)hash_test_data, len, expect,
+		       CHUNKSZ_SHA256);
+	size = sizeof(out);
+	ut_assertok(hash_block("sha256", hash_test_data, len, out, &size));
+	ut_asserteq(SHA256_SUM_LEN, size);
+	ut_asserteq_mem(expect, out, SHA256_SUM_LEN);
+	ut_assert(device_active(dev));
+
+	/* progressive hashing, in more than one segment */
+	sha384_csum_wd((const uchar *)hash_test_data, len, expect,
+		       CHUNKSZ_SHA384);
+	ut_assertok(hash_progressive_lookup_algo("sha384", &algo));
+	ut_assertok(algo->hash_init(algo, &ctx));
+	ut_assertok(algo->hash_update(algo, ctx, hash_test_data, 10, 0));
+	ut_assertok(algo->hash_update(algo, ctx, hash_test_data + 10,
+				      len - 10, 1));
+	ut_assertok(algo->hash_finish(algo, ctx, out, sizeof(out)));
+	ut_asserteq_mem(expect, out, SHA384_SUM_LEN);
+
+	/* a result buffer which is too small is rejected */
+	ut_assertok(algo->hash_init(algo, &ctx));
+	ut_asserteq(-ENOSPC, algo->hash_finish(algo, ctx, out,
+					       SHA384_SUM_LEN - 1));
+	ut_assertok(algo->hash_finish(algo, ctx, out, sizeof(out)));
+
+	return 0;
+}
+DM_TEST(dm_test_hash_lookup, UT_TESTF_SCAN_PDATA);
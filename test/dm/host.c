@@ -108,6 +108,38 @@ static int dm_test_host_dup(struct unit_test_state *uts)
 }
 DM_TEST(dm_test_host_dup, UT_TESTF_SCAN_FDT);
 
+/* Check that a mapped file reads the same as one accessed with read() */
+static int dm_test_host_mmap(struct unit_test_state *uts)
+{
+	static char buf[2][8 * DEFAULT_BLKSZ];
+	struct host_sb_plat *plat;
+	struct udevice *dev, *blk;
+	enum host_mode mode;
+	char fname[256];
+
+	ut_assertok(os_persistent_file(fname, sizeof(fname), "2MB.ext2.img"));
+	for (mode = HOST_MODE_RW; mode <= HOST_MODE_MMAP; mode++) {
+		ut_assertok(host_create_attach_file_mode("test", fname, false,
+							 DEFAULT_BLKSZ, mode,
+							 &dev));
+		plat = dev_get_plat(dev);
+		ut_asserteq(mode == HOST_MODE_MMAP, !!plat->buf);
+		ut_asserteq(-EBUSY, host_set_mode(dev, HOST_MODE_RW));
+
+		ut_assertok(blk_get_from_parent(dev, &blk));
+		ut_assertok(device_probe(blk));
+		ut_asserteq(8, blk_read(blk, 2, 8, buf[mode]));
+
+		ut_assertok(host_detach_file(dev));
+		ut_assertnull(plat->buf);
+		ut_assertok(device_unbind(dev));
+	}
+	ut_asserteq_mem(buf[HOST_MODE_RW], buf[HOST_MODE_MMAP], sizeof(buf[0]));
+
+	return 0;
+}
+DM_TEST(dm_test_host_mmap, UT_TESTF_SCAN_FDT);
+
 /* Basic test of 'host' command */
 static int dm_test_cmd_host(struct unit_test_state *uts)
 {
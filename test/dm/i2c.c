@@ -57,6 +57,28 @@ static int dm_test_i2c_read_write(struct unit_test_state *uts)
 }
 DM_TEST(dm_test_i2c_read_write, UT_TESTF_SCAN_PDATA | UT_TESTF_SCAN_FDT);
 
+/* Test that a read which may use DMA works with an unaligned buffer */
+static int dm_test_i2c_read_dma(struct unit_test_state *uts)
+{
+	struct udevice *bus, *dev;
+	struct dm_i2c_bus *i2c;
+	uint8_t buf[6];
+
+	ut_assertok(uclass_get_device_by_seq(UCLASS_I2C, busnum, &bus));
+	ut_assertok(i2c_get_chip(bus, chip, 1, &dev));
+	ut_assertok(dm_i2c_write(dev, 2, (uint8_t *)"AB", 2));
+
+	i2c = dev_get_uclass_priv(bus);
+	i2c->dma_min_bytes = 4;
+	memset(buf, '\xff', sizeof(buf));
+	ut_assertok(dm_i2c_read(dev, 0, buf + 1, 5));
+	ut_asserteq_mem(buf, "\xff\0\0AB\0", sizeof(buf));
+	i2c->dma_min_bytes = 0;
+
+	return 0;
+}
+DM_TEST(dm_test_i2c_read_dma, UT_TESTF_SCAN_PDATA | UT_TESTF_SCAN_FDT);
+
 static int dm_test_i2c_speed(struct unit_test_state *uts)
 {
 	struct udevice *bus, *dev;
@@ -3,9 +3,18 @@
  * Copyright (C) 2015 Google, Inc
  */
 
+#include <bloblist.h>
+#include <cyclic.h>
 #include <dm.h>
+#include <malloc.h>
 #include <mmc.h>
 #include <part.h>
+#include <time.h>
+#include <asm/cache.h>
+#include <asm/test.h>
+#include <dm/device-internal.h>
+#include <dm/lists.h>
+#include <dm/root.h>
 #include <dm/test.h>
 #include <test/test.h>
 #include <test/ut.h>
@@ -48,6 +57,183 @@ static int dm_test_mmc_blk(struct unit_test_state *uts)
 	ut_asserteq(4, blk_dread(dev_desc, 0, 4, read));
 	ut_asserteq_mem(write, read, sizeof(write));
 
+	/*
+	 * The read had its length set by CMD23, so it stopped by itself and
+	 * the card refuses CMD12
+	 */
+	if (IS_ENABLED(CONFIG_MMC_SET_BLOCK_COUNT))
+		ut_asserteq(-EILSEQ,
+			    mmc_send_stop_transmission(find_mmc_device(0),
+						       false));
+
 	return 0;
 }
 DM_TEST(dm_test_mmc_blk, UT_TESTF_SCAN_PDATA | UT_TESTF_SCAN_FDT);
+
+/* Power up the cards in the background and then finish initialising one */
+static int dm_test_mmc_parallel_init(struct unit_test_state *uts)
+{
+	struct blk_desc *dev_desc;
+	struct udevice *dev;
+	struct mmc *mmc;
+	char buf[512];
+	ulong start;
+
+	if (!CONFIG_IS_ENABLED(MMC_PARALLEL_INIT))
+		return -EAGAIN;
+
+	ut_assertok(uclass_get_device_by_seq(UCLASS_MMC, 0, &dev));
+	mmc = mmc_get_mmc_dev(dev);
+
+	/* the card is set up when probed, so start again as 'mmc rescan' does */
+	mmc->has_init = 0;
+	ut_asserteq(1, mmc_start_init_all());
+	ut_assert(mmc->init_in_progress);
+	ut_assert(mmc->op_cond_busy);
+
+	/* the cyclic function polls the card until it is ready */
+	start = get_timer(0);
+	while (mmc->op_cond_busy && get_timer(start) < 1000)
+		schedule();
+	ut_assert(!mmc->op_cond_busy);
+	ut_assert(mmc->op_cond_bg);
+
+	ut_assertok(mmc_init(mmc));
+	ut_assert(mmc->has_init);
+	ut_assertnull(mmc->op_cond_cyclic);
+	ut_assertok(blk_get_device_by_str("mmc", "0", &dev_desc));
+	ut_asserteq(1, blk_dread(dev_desc, 0, 1, buf));
+
+	return 0;
+}
+DM_TEST(dm_test_mmc_parallel_init, UT_TESTF_SCAN_PDATA | UT_TESTF_SCAN_FDT);
+
+/* Test that tuning results are recorded and reused */
+static int dm_test_mmc_tuning_cache(struct unit_test_state *uts)
+{
+	struct mmc_tuning_handoff *ho;
+	struct mmc_tuning_rec *rec;
+	struct udevice *dev;
+	struct mmc *mmc;
+	uint bus_width;
+	int i;
+
+	if (!CONFIG_IS_ENABLED(MMC_TUNING_CACHE))
+		return -EAGAIN;
+
+	ut_assertok(uclass_get_device_by_seq(UCLASS_MMC, 0, &dev));
+	mmc = mmc_get_mmc_dev(dev);
+
+	/* tuning blocks are only defined for 4- and 8-bit buses */
+	bus_width = mmc->bus_width;
+	mmc->bus_width = 4;
+
+	/* start with an empty bloblist, so nothing is recorded */
+	ut_assertok(bloblist_new(bloblist_get_base(), bloblist_get_total_size(),
+				 0, 0));
+
+	/* the first time, the card is fully tuned and the result recorded */
+	ut_assertok(mmc_execute_tuning(mmc, MMC_CMD_SEND_TUNING_BLOCK));
+	ut_asserteq(1, sandbox_mmc_get_tunings(dev));
+	ho = bloblist_find(BLOBLISTT_U_BOOT_MMC_TUNING, sizeof(*ho));
+	ut_assertnonnull(ho);
+	for (i = 0; i < MMC_TUNING_RECS; i++) {
+		if (ho->rec[i].opcode)
+			break;
+	}
+	ut_assert(i < MMC_TUNING_RECS);
+	rec = &ho->rec[i];
+	ut_asserteq(MMC_CMD_SEND_TUNING_BLOCK, rec->opcode);
+	ut_asserteq(mmc->selected_mode, rec->mode);
+	ut_asserteq_mem(mmc->cid, rec->cid, sizeof(rec->cid));
+	ut_asserteq(5, rec->val);
+
+	/* next time the recorded result is used */
+	ut_assertok(mmc_execute_tuning(mmc, MMC_CMD_SEND_TUNING_BLOCK));
+	ut_asserteq(1, sandbox_mmc_get_tunings(dev));
+
+	/* a result which no longer works causes the card to be tuned again */
+	rec->val = 2;
+	ut_assertok(mmc_execute_tuning(mmc, MMC_CMD_SEND_TUNING_BLOCK));
+	ut_asserteq(2, sandbox_mmc_get_tunings(dev));
+	ut_asserteq(5, rec->val);
+	mmc->bus_width = bus_width;
+
+	return 0;
+}
+DM_TEST(dm_test_mmc_tuning_cache, UT_TESTF_SCAN_PDATA | UT_TESTF_SCAN_FDT);
+
+/* Test eMMC command queueing, for large reads and asynchronous requests */
+static int dm_test_mmc_cqe(struct unit_test_state *uts)
+{
+	const int blks = 1024, size = blks * 512;
+	struct udevice *dev, *blk;
+	int tasks, max_queued, i;
+	struct blk_req req[4];
+	struct blk_desc *desc;
+	struct mmc *mmc;
+	char *buf, *cmp;
+
+	if (!CONFIG_IS_ENABLED(MMC_CQE))
+		return -EAGAIN;
+
+	ut_assertok(lists_bind_fdt(dm_root(), ofnode_path("/mmc7"), &dev, NULL,
+				   false));
+	ut_assertok(device_probe(dev));
+	mmc = mmc_get_mmc_dev(dev);
+	ut_assert(!IS_SD(mmc));
+	ut_assertok(blk_get_from_parent(dev, &blk));
+	desc = dev_get_uclass_plat(blk);
+	ut_asserteq(16, desc->queue_depth);
+
+	buf = memalign(ARCH_DMA_MINALIGN, size);
+	cmp = malloc(size);
+	ut_assertnonnull(buf);
+	ut_assertnonnull(cmp);
+	for (i = 0; i < size; i++)
+		cmp[i] = i + i / 512;
+
+	/* writes use normal commands */
+	ut_asserteq(blks, blk_write(blk, 0, blks, cmp));
+	ut_asserteq(false, sandbox_mmc_get_cqe(dev, &tasks, &max_queued));
+	ut_asserteq(0, tasks);
+
+	/* a large read is split into tasks, several of them queued at once */
+	ut_asserteq(blks, blk_read(blk, 0, blks, buf));
+	ut_asserteq_mem(cmp, buf, size);
+	ut_asserteq(true, sandbox_mmc_get_cqe(dev, &tasks, &max_queued));
+	ut_asserteq(blks / 64, tasks);
+	ut_asserteq(8, max_queued);
+
+	/* asynchronous reads are queued as tasks and complete when polled */
+	memset(buf, '\0', size);
+	for (i = 0; i < ARRAY_SIZE(req); i++) {
+		req[i].start = i * 8;
+		req[i].blkcnt = 8;
+		req[i].buffer = buf + i * 8 * 512;
+		ut_assertok(blk_submit_read(blk, &req[i]));
+	}
+	ut_asserteq(false, req[0].done);
+	for (i = 0; i < ARRAY_SIZE(req); i++)
+		ut_asserteq(8, blk_wait(blk, &req[i]));
+	ut_asserteq_mem(cmp, buf, ARRAY_SIZE(req) * 8 * 512);
+	ut_asserteq(true, sandbox_mmc_get_cqe(dev, &tasks, &max_queued));
+	ut_asserteq(blks / 64 + ARRAY_SIZE(req), tasks);
+
+	/* a write needs a normal command, so the card leaves the queue mode */
+	ut_asserteq(1, blk_write(blk, 0, 1, cmp));
+	ut_asserteq(false, sandbox_mmc_get_cqe(dev, &tasks, &max_queued));
+
+	/* and a small read is not worth going back for */
+	blkcache_invalidate(desc->uclass_id, desc->devnum);
+	ut_asserteq(1, blk_read(blk, 1, 1, buf));
+	ut_asserteq_mem(cmp + 512, buf, 512);
+	ut_asserteq(false, sandbox_mmc_get_cqe(dev, &tasks, &max_queued));
+	ut_asserteq(blks / 64 + ARRAY_SIZE(req), tasks);
+
+	free(buf);
+	free(cmp);
+
+	return 0;
+}
+DM_TEST(dm_test_mmc_cqe, UT_TESTF_SCAN_PDATA | UT_TESTF_SCAN_FDT);
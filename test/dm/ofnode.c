@@ -22,6 +22,7 @@
 #include <of_live.h>
 #include <dm/device-internal.h>
 #include <dm/lists.h>
+#include <dm/of_access.h>
 #include <dm/of_extra.h>
 #include <dm/root.h>
 #include <dm/test.h>
@@ -147,6 +148,11 @@ static int dm_test_ofnode_get_by_phandle_ot(struct unit_test_state *uts)
 	ut_assert(ofnode_valid(node));
 	ut_asserteq_str("target", ofnode_get_name(node));
 
+	/* Repeated lookups, perhaps cached, must not mix up the trees */
+	ut_assert(!ofnode_equal(node,
+				oftree_get_by_phandle(oftree_default(), 1)));
+	ut_assert(ofnode_equal(node, oftree_get_by_phandle(otree, 1)));
+
 	return 0;
 }
 DM_TEST(dm_test_ofnode_get_by_phandle_ot,
@@ -1141,6 +1147,35 @@ static int dm_test_ofnode_for_each_prop(struct unit_test_state *uts)
 }
 DM_TEST(dm_test_ofnode_for_each_prop, UT_TESTF_SCAN_FDT);
 
+/* check property lookups with interned property names */
+static int dm_test_ofnode_prop_atoms(struct unit_test_state *uts)
+{
+	struct property *pp1, *pp2;
+	ofnode first, second;
+	char name[8];
+
+	first = ofnode_path("/ofnode-foreach/first");
+	second = ofnode_path("/ofnode-foreach/second");
+	ut_assert(ofnode_valid(first));
+	ut_assert(ofnode_valid(second));
+
+	pp1 = of_find_property(ofnode_to_np(first), "prop2", NULL);
+	pp2 = of_find_property(ofnode_to_np(second), "prop2", NULL);
+	ut_assertnonnull(pp1);
+	ut_assertnonnull(pp2);
+	if (CONFIG_IS_ENABLED(OF_LIVE_ATOMS))
+		ut_asserteq_ptr(pp1->name, pp2->name);
+
+	/* a name which is not a string constant */
+	strcpy(name, "prop1");
+	ut_asserteq(1, ofnode_read_u32_default(second, name, 0));
+	strcpy(name, "prop3");
+	ut_asserteq(3, ofnode_read_u32_default(second, name, 3));
+
+	return 0;
+}
+DM_TEST(dm_test_ofnode_prop_atoms, UT_TESTF_SCAN_FDT | UT_TESTF_LIVE_TREE);
+
 static int dm_test_ofnode_by_compatible(struct unit_test_state *uts)
 {
 	const char *compat = "denx,u-boot-fdt-test";
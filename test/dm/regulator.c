@@ -11,6 +11,7 @@
 #include <fdtdec.h>
 #include <log.h>
 #include <malloc.h>
+#include <time.h>
 #include <dm/device-internal.h>
 #include <dm/root.h>
 #include <dm/util.h>
@@ -176,6 +177,35 @@ static int dm_test_power_regulator_set_get_enable(struct unit_test_state *uts)
 }
 DM_TEST(dm_test_power_regulator_set_get_enable, UT_TESTF_SCAN_FDT);
 
+/* Test enabling a regulator without waiting for it to settle */
+static int dm_test_power_regulator_set_enable_nowait(struct unit_test_state *uts)
+{
+	struct dm_regulator_uclass_plat *uc_pdata;
+	const char *platname;
+	struct udevice *dev;
+	ulong ready_us;
+
+	platname = regulator_names[LDO1][PLATNAME];
+	ut_assertok(regulator_get_by_platname(platname, &dev));
+	uc_pdata = dev_get_uclass_plat(dev);
+	ut_assertok(regulator_set_enable_nowait(dev, true));
+	ut_asserteq(true, regulator_get_enable(dev));
+
+	/* The later of two delays is kept */
+	regulator_set_ready_delay(dev, 1000);
+	ready_us = uc_pdata->ready_us;
+	ut_assert(ready_us);
+	regulator_set_ready_delay(dev, 10);
+	ut_asserteq(ready_us, uc_pdata->ready_us);
+
+	regulator_wait_ready(dev);
+	ut_assert((long)(timer_get_us() - ready_us) >= 0);
+	ut_asserteq(0, uc_pdata->ready_us);
+
+	return 0;
+}
+DM_TEST(dm_test_power_regulator_set_enable_nowait, UT_TESTF_SCAN_FDT);
+
 /* Test regulator set and get enable if allowed method */
 static
 int dm_test_power_regulator_set_enable_if_allowed(struct unit_test_state *uts)
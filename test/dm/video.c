@@ -44,6 +44,49 @@ static int dm_test_video_base(struct unit_test_state *uts)
 }
 DM_TEST(dm_test_video_base, UT_TESTF_SCAN_PDATA | UT_TESTF_SCAN_FDT);
 
+/* Test that drawing records the damage and a sync clears it */
+static int dm_test_video_damage(struct unit_test_state *uts)
+{
+	struct video_priv *priv;
+	struct udevice *dev;
+
+	if (!IS_ENABLED(CONFIG_VIDEO_DAMAGE))
+		return -EAGAIN;
+
+	ut_assertok(uclass_get_device(UCLASS_VIDEO, 0, &dev));
+	priv = dev_get_uclass_priv(dev);
+	ut_assertok(video_sync(dev, false));
+	ut_asserteq(0, priv->damage.x1);
+
+	/* part of a single line is tracked by pixel */
+	ut_assertok(video_sync_copy(dev, priv->fb + 20 * priv->line_length + 20,
+				    priv->fb + 20 * priv->line_length + 60));
+	ut_asserteq(10, priv->damage.x0);
+	ut_asserteq(20, priv->damage.y0);
+	ut_asserteq(30, priv->damage.x1);
+	ut_asserteq(21, priv->damage.y1);
+
+	video_damage(dev, 100, 15, 50, 1000);
+	ut_asserteq(10, priv->damage.x0);
+	ut_asserteq(15, priv->damage.y0);
+	ut_asserteq(150, priv->damage.x1);
+	ut_asserteq(768, priv->damage.y1);
+
+	/* more than one line covers the full width */
+	ut_assertok(video_sync(dev, false));
+	ut_assertok(video_fill_part(dev, 0, 40, 20, 50, 0));
+	ut_asserteq(0, priv->damage.x0);
+	ut_asserteq(40, priv->damage.y0);
+	ut_asserteq(1366, priv->damage.x1);
+	ut_asserteq(50, priv->damage.y1);
+
+	ut_assertok(video_sync(dev, false));
+	ut_asserteq(0, priv->damage.x1);
+
+	return 0;
+}
+DM_TEST(dm_test_video_damage, UT_TESTF_SCAN_PDATA | UT_TESTF_SCAN_FDT);
+
 /**
  * compress_frame_buffer() - Compress the frame buffer and return its size
  *
@@ -0,0 +1,58 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Tests for the arena allocator
+ */
+
+#include <arena.h>
+#include <test/lib.h>
+#include <test/test.h>
+#include <test/ut.h>
+
+/* Test allocating, marking and releasing */
+static int lib_test_arena_release(struct unit_test_state *uts)
+{
+	struct arena_mark outer, inner;
+	char *first, *second, *big;
+	struct arena arena;
+	ulong start, used;
+
+	start = ut_check_free();
+	arena_init(&arena, 64);
+
+	/* Nothing is allocated until it is needed */
+	outer = arena_begin(&arena);
+	ut_asserteq(0, ut_check_delta(start));
+
+	first = arena_strdup(&arena, "first");
+	ut_assertnonnull(first);
+	ut_asserteq_str("first", first);
+	ut_asserteq(0, (ulong)first & (ARENA_ALIGN - 1));
+	used = ut_check_delta(start);
+
+	/* A nested operation rewinds to where it started */
+	inner = arena_begin(&arena);
+	second = arena_alloc(&arena, 3);
+	ut_assertnonnull(second);
+	ut_asserteq_ptr(first + ARENA_ALIGN, second);
+
+	/* This does not fit in a block, so gets its own */
+	big = arena_alloc(&arena, 200);
+	ut_assertnonnull(big);
+	ut_assert(ut_check_delta(start) > used);
+
+	arena_release(&arena, inner);
+	ut_asserteq(used, ut_check_delta(start));
+	ut_asserteq_ptr(second, arena_alloc(&arena, 3));
+	ut_asserteq_str("first", first);
+
+	/* Releasing everything keeps the first block for reuse */
+	arena_release(&arena, outer);
+	ut_asserteq(used, ut_check_delta(start));
+	ut_asserteq_ptr(first, arena_alloc(&arena, 1));
+
+	arena_uninit(&arena);
+	ut_assertok(ut_check_delta(start));
+
+	return 0;
+}
+LIB_TEST(lib_test_arena_release, 0);
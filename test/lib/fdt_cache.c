@@ -0,0 +1,315 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Tests for the libfdt path and compatible-string lookup cache
+ *
+ * Each lookup is checked against a plain walk of the tree, which does not use
+ * the cache
+ */
+
+#include <fdt_cache.h>
+#include <linux/libfdt.h>
+#include <test/lib.h>
+#include <test/test.h>
+#include <test/ut.h>
+
+#define FDT_SIZE	8192
+#define MAX_NODES	64
+
+static char fdt_buf[FDT_SIZE] __aligned(8);
+
+static const char *const node_names[] = {
+	"a", "b", "soc", "serial", "serial@10", "serial@20", "cpu@0",
+};
+
+static const char *const compats[] = {
+	"vendor,a", "vendor,b", "other", "last,one",
+};
+
+static const char *const prop_names[] = {
+	"compatible", "reg", "status", "longer-property",
+};
+
+/* Simple generator so that the sequence is the same on every run */
+static uint rand_next(uint *seed, uint range)
+{
+	*seed = *seed * 1103515245 + 12345;
+
+	return (*seed >> 16) % range;
+}
+
+/* Look up an absolute path one node at a time, without the cache */
+static int ref_path_offset(const void *fdt, const char *path)
+{
+	const char *end;
+	int offset = 0;
+
+	while (*path) {
+		while (*path == '/')
+			path++;
+		if (!*path)
+			break;
+		end = strchrnul(path, '/');
+		offset = fdt_subnode_offset_namelen(fdt, offset, path,
+						    end - path);
+		if (offset < 0)
+			return offset;
+		path = end;
+	}
+
+	return offset;
+}
+
+/* Find the next node with a compatible string, without the cache */
+static int ref_compat_offset(const void *fdt, int startoffset,
+			     const char *compat)
+{
+	int offset;
+
+	for (offset = fdt_next_node(fdt, startoffset, NULL); offset >= 0;
+	     offset = fdt_next_node(fdt, offset, NULL)) {
+		if (!fdt_node_check_compatible(fdt, offset, compat))
+			return offset;
+	}
+
+	return -FDT_ERR_NOTFOUND;
+}
+
+static int check_path(struct unit_test_state *uts, const char *path)
+{
+	ut_asserteq(ref_path_offset(fdt_buf, path),
+		    fdt_path_offset(fdt_buf, path));
+
+	return 0;
+}
+
+static int check_compat(struct unit_test_state *uts, int startoffset,
+			const char *compat)
+{
+	ut_asserteq(ref_compat_offset(fdt_buf, startoffset, compat),
+		    fdt_node_offset_by_compatible(fdt_buf, startoffset,
+						  compat));
+
+	return 0;
+}
+
+/* Check every node's path and every compatible string */
+static int check_all(struct unit_test_state *uts)
+{
+	char path[256];
+	int offset, i;
+
+	for (offset = fdt_next_node(fdt_buf, -1, NULL); offset >= 0;
+	     offset = fdt_next_node(fdt_buf, offset, NULL)) {
+		ut_assertok(fdt_get_path(fdt_buf, offset, path, sizeof(path)));
+		ut_assertok(check_path(uts, path));
+	}
+	for (i = 0; i < ARRAY_SIZE(compats); i++) {
+		offset = -1;
+		do {
+			ut_assertok(check_compat(uts, offset, compats[i]));
+			offset = ref_compat_offset(fdt_buf, offset,
+						   compats[i]);
+		} while (offset >= 0);
+	}
+
+	return 0;
+}
+
+static int setup_tree(struct unit_test_state *uts)
+{
+	int soc, node;
+
+	fdt_cache_inval(fdt_buf);
+	ut_assertok(fdt_create_empty_tree(fdt_buf, FDT_SIZE));
+	soc = fdt_add_subnode(fdt_buf, 0, "soc");
+	ut_assert(soc >= 0);
+	node = fdt_add_subnode(fdt_buf, soc, "serial@10");
+	ut_assert(node >= 0);
+	ut_assertok(fdt_setprop_string(fdt_buf, node, "compatible",
+				       "vendor,a"));
+	node = fdt_add_subnode(fdt_buf, soc, "serial@20");
+	ut_assert(node >= 0);
+	ut_assertok(fdt_setprop_string(fdt_buf, node, "compatible",
+				       "vendor,a"));
+	node = fdt_add_subnode(fdt_buf, 0, "cpu@0");
+	ut_assert(node >= 0);
+	ut_assertok(fdt_setprop_string(fdt_buf, node, "compatible",
+				       "vendor,b"));
+
+	return 0;
+}
+
+/* Test that changing the size of a property moves the cached offsets */
+static int lib_test_fdt_cache_setprop(struct unit_test_state *uts)
+{
+	const char *path = "/soc/serial@20";
+	int soc, node;
+	char val[40];
+
+	ut_assertok(setup_tree(uts));
+	node = fdt_path_offset(fdt_buf, path);
+	ut_assert(node >= 0);
+	ut_asserteq(node, fdt_node_offset_by_compatible(fdt_buf, -1,
+							"vendor,a"));
+
+	/* grow a property in an earlier node */
+	soc = fdt_path_offset(fdt_buf, "/soc");
+	memset(val, 'x', sizeof(val));
+	ut_assertok(fdt_setprop(fdt_buf, soc, "reg", val, sizeof(val)));
+	ut_assert(fdt_path_offset(fdt_buf, path) > node);
+	ut_assertok(check_path(uts, path));
+	ut_assertok(check_compat(uts, -1, "vendor,a"));
+
+	/* and shrink it again */
+	ut_assertok(fdt_setprop(fdt_buf, soc, "reg", val, 4));
+	ut_assertok(check_path(uts, path));
+	ut_assertok(check_compat(uts, -1, "vendor,a"));
+
+	/* a new compatible string must be found */
+	ut_asserteq(-FDT_ERR_NOTFOUND,
+		    fdt_node_offset_by_compatible(fdt_buf, -1, "other"));
+	ut_assertok(fdt_setprop_string(fdt_buf, soc, "compatible",
+				       "other"));
+	ut_asserteq(soc,
+		    fdt_node_offset_by_compatible(fdt_buf, -1, "other"));
+
+	/* and one which is replaced must not be */
+	node = fdt_path_offset(fdt_buf, path);
+	ut_assertok(fdt_setprop_string(fdt_buf, node, "compatible",
+				       "last,one"));
+	ut_asserteq(fdt_path_offset(fdt_buf, "/soc/serial@10"),
+		    fdt_node_offset_by_compatible(fdt_buf, -1, "vendor,a"));
+	ut_assertok(check_all(uts));
+	fdt_cache_inval(fdt_buf);
+
+	return 0;
+}
+LIB_TEST(lib_test_fdt_cache_setprop, 0);
+
+/* Test that deleting a node drops it and moves the nodes after it */
+static int lib_test_fdt_cache_del_node(struct unit_test_state *uts)
+{
+	int node;
+
+	ut_assertok(setup_tree(uts));
+	ut_assertok(check_all(uts));
+
+	node = fdt_path_offset(fdt_buf, "/soc/serial@20");
+	ut_assert(node >= 0);
+	ut_asserteq(node, fdt_node_offset_by_compatible(fdt_buf, -1,
+							"vendor,a"));
+	ut_assertok(fdt_del_node(fdt_buf, node));
+	ut_asserteq(-FDT_ERR_NOTFOUND,
+		    fdt_path_offset(fdt_buf, "/soc/serial@20"));
+	ut_asserteq(fdt_path_offset(fdt_buf, "/soc/serial@10"),
+		    fdt_node_offset_by_compatible(fdt_buf, -1, "vendor,a"));
+	ut_assertok(check_all(uts));
+
+	/* deleting the parent drops the child too */
+	ut_assertok(fdt_del_node(fdt_buf, fdt_path_offset(fdt_buf, "/soc")));
+	ut_asserteq(-FDT_ERR_NOTFOUND,
+		    fdt_path_offset(fdt_buf, "/soc/serial@10"));
+	ut_asserteq(-FDT_ERR_NOTFOUND,
+		    fdt_node_offset_by_compatible(fdt_buf, -1, "vendor,a"));
+	ut_assertok(check_all(uts));
+	fdt_cache_inval(fdt_buf);
+
+	return 0;
+}
+LIB_TEST(lib_test_fdt_cache_del_node, 0);
+
+/* Test that a node added after a failed lookup is found */
+static int lib_test_fdt_cache_add_subnode(struct unit_test_state *uts)
+{
+	int soc, node;
+
+	ut_assertok(setup_tree(uts));
+	ut_asserteq(-FDT_ERR_NOTFOUND, fdt_path_offset(fdt_buf, "/soc/b"));
+	ut_asserteq(-FDT_ERR_NOTFOUND,
+		    fdt_node_offset_by_compatible(fdt_buf, -1, "last,one"));
+	ut_assertok(check_all(uts));
+
+	soc = fdt_path_offset(fdt_buf, "/soc");
+	node = fdt_add_subnode(fdt_buf, soc, "b");
+	ut_assert(node >= 0);
+	ut_asserteq(node, fdt_path_offset(fdt_buf, "/soc/b"));
+	ut_assertok(fdt_setprop_string(fdt_buf, node, "compatible",
+				       "last,one"));
+	ut_asserteq(node, fdt_node_offset_by_compatible(fdt_buf, -1,
+							"last,one"));
+
+	/* the new node comes first, so the nodes after it have moved */
+	ut_assertok(check_path(uts, "/soc/serial@10"));
+	ut_assertok(check_path(uts, "/cpu@0"));
+	ut_assertok(check_all(uts));
+	fdt_cache_inval(fdt_buf);
+
+	return 0;
+}
+LIB_TEST(lib_test_fdt_cache_add_subnode, 0);
+
+/* Mix random changes to the tree with lookups */
+static int lib_test_fdt_cache_random(struct unit_test_state *uts)
+{
+	int nodes[MAX_NODES], num_nodes;
+	uint seq, step, seed;
+	char val[40];
+
+	for (seq = 0; seq < 20; seq++) {
+		seed = seq;
+		ut_assertok(setup_tree(uts));
+		for (step = 0; step < 100; step++) {
+			const char *compat = compats[rand_next(&seed, 4)];
+			const char *name;
+			int offset, len;
+
+			num_nodes = 0;
+			for (offset = fdt_next_node(fdt_buf, -1, NULL);
+			     offset >= 0 && num_nodes < MAX_NODES;
+			     offset = fdt_next_node(fdt_buf, offset, NULL))
+				nodes[num_nodes++] = offset;
+			offset = nodes[rand_next(&seed, num_nodes)];
+			name = node_names[rand_next(&seed,
+						    ARRAY_SIZE(node_names))];
+
+			switch (rand_next(&seed, 6)) {
+			case 0:
+				/* may fail if the name is in use */
+				fdt_add_subnode(fdt_buf, offset, name);
+				break;
+			case 1:
+				if (offset)
+					ut_assertok(fdt_del_node(fdt_buf,
+								 offset));
+				break;
+			case 2:
+				ut_assertok(fdt_setprop_string(fdt_buf, offset,
+							       "compatible",
+							       compat));
+				break;
+			case 3:
+				name = prop_names[rand_next(&seed, 4)];
+				len = rand_next(&seed, sizeof(val));
+				memset(val, step, len);
+				ut_assertok(fdt_setprop(fdt_buf, offset, name,
+							val, len));
+				break;
+			case 4:
+				fdt_delprop(fdt_buf, offset,
+					    prop_names[rand_next(&seed, 4)]);
+				break;
+			default:
+				ut_assertok(check_all(uts));
+				break;
+			}
+			ut_assertok(check_path(uts, "/soc/serial"));
+			ut_assertok(check_path(uts, "/soc/serial@20/a"));
+			ut_assertok(check_compat(uts, -1, compat));
+		}
+		ut_assertok(check_all(uts));
+	}
+	fdt_cache_inval(fdt_buf);
+
+	return 0;
+}
+LIB_TEST(lib_test_fdt_cache_random, 0);
@@ -11,6 +11,10 @@
 #include <test/lib.h>
 #include <test/test.h>
 #include <test/ut.h>
+#include <asm/global_data.h>
+#include <linux/sizes.h>
+
+DECLARE_GLOBAL_DATA_PTR;
 
 static inline bool lmb_is_nomap(struct lmb_property *m)
 {
@@ -737,6 +741,56 @@ static int lib_test_lmb_max_regions(struct unit_test_state *uts)
 LIB_TEST(lib_test_lmb_max_regions, 0);
 #endif
 
+#if IS_ENABLED(CONFIG_LMB_GROW)
+static int lib_test_lmb_grow(struct unit_test_state *uts)
+{
+	const phys_addr_t ram = 0x40000000;
+	const phys_size_t ram_size = 0x20000000;
+	const phys_size_t blk_size = 0x10000;
+	const int count = 4 * CONFIG_LMB_RESERVED_REGIONS;
+	struct lmb lmb;
+	int ret, i;
+
+	lmb_init(&lmb);
+
+	ret = lmb_add(&lmb, ram, ram_size);
+	ut_asserteq(ret, 0);
+
+	/* reserve four times as many regions as the initial list holds */
+	for (i = 0; i < count; i++) {
+		ret = lmb_reserve(&lmb, ram + 2 * i * blk_size, blk_size);
+		ut_asserteq(ret, 0);
+	}
+	ut_asserteq(lmb.reserved.cnt, count);
+	ut_assert(lmb.reserved.max >= count);
+	ut_assert(lmb.reserved.alloced);
+
+	for (i = 0; i < count; i++) {
+		ut_asserteq(lmb.reserved.region[i].base,
+			    ram + 2 * i * blk_size);
+		ut_asserteq(lmb.reserved.region[i].size, blk_size);
+	}
+
+	/* the gaps are still free and fill up from the top */
+	ut_asserteq(lmb_get_free_size(&lmb, ram + blk_size), blk_size);
+	ut_asserteq(lmb_alloc_base(&lmb, blk_size, blk_size,
+				   ram + 2 * count * blk_size),
+		    ram + (2 * count - 1) * blk_size);
+
+	/* filling a gap merges the regions either side */
+	ret = lmb_reserve(&lmb, ram + blk_size, blk_size);
+	ut_assert(ret >= 0);
+	ut_asserteq(lmb.reserved.cnt, count - 1);
+	ut_asserteq(lmb.reserved.region[0].size, 3 * blk_size);
+
+	lmb_uninit(&lmb);
+	ut_asserteq(lmb.reserved.alloced, false);
+
+	return 0;
+}
+LIB_TEST(lib_test_lmb_grow, 0);
+#endif
+
 static int lib_test_lmb_flags(struct unit_test_state *uts)
 {
 	const phys_addr_t ram = 0x40000000;
@@ -823,3 +877,92 @@ static int lib_test_lmb_flags(struct unit_test_state *uts)
 	return 0;
 }
 LIB_TEST(lib_test_lmb_flags, 0);
+
+#if IS_ENABLED(CONFIG_LMB_CACHE)
+static int lib_test_lmb_cache(struct unit_test_state *uts)
+{
+	struct lmb first, second;
+	phys_addr_t addr;
+	int i;
+
+	/* the second lmb uses the saved firmware reservations */
+	lmb_init_and_reserve(&first, gd->bd, (void *)gd->fdt_blob);
+	lmb_init_and_reserve(&second, gd->bd, (void *)gd->fdt_blob);
+
+	ut_asserteq(first.memory.cnt, second.memory.cnt);
+	ut_asserteq(first.reserved.cnt, second.reserved.cnt);
+	for (i = 0; i < first.reserved.cnt; i++) {
+		ut_asserteq(first.reserved.region[i].base,
+			    second.reserved.region[i].base);
+		ut_asserteq(first.reserved.region[i].size,
+			    second.reserved.region[i].size);
+		ut_asserteq(first.reserved.region[i].flags,
+			    second.reserved.region[i].flags);
+	}
+
+	/* allocations are not shared */
+	addr = lmb_alloc(&first, 0x1000, 0x1000);
+	ut_assert(addr);
+	lmb_uninit(&second);
+	lmb_init_and_reserve(&second, gd->bd, (void *)gd->fdt_blob);
+	ut_asserteq(1, lmb_is_reserved(&first, addr));
+	ut_asserteq(0, lmb_is_reserved(&second, addr));
+
+	lmb_uninit(&first);
+	lmb_uninit(&second);
+
+	return 0;
+}
+LIB_TEST(lib_test_lmb_cache, 0);
+
+/* Check whether a fresh lmb using @fdt has @addr reserved */
+static int lmb_cache_check(struct unit_test_state *uts, void *fdt,
+			   phys_addr_t addr, int expect)
+{
+	struct lmb lmb;
+
+	lmb_init_and_reserve(&lmb, gd->bd, fdt);
+	ut_asserteq(expect, lmb_is_reserved(&lmb, addr));
+	lmb_uninit(&lmb);
+
+	return 0;
+}
+
+static int lib_test_lmb_cache_fdt(struct unit_test_state *uts)
+{
+	const phys_addr_t addr = gd->bd->bi_dram[0].start + SZ_16M;
+	fdt32_t reg[2];
+	char fdt[512];
+	int node, sub;
+
+	ut_assertok(fdt_create_empty_tree(fdt, sizeof(fdt)));
+	ut_assertok(lmb_cache_check(uts, fdt, addr, 0));
+
+	/* a new memory reservation is seen, as with 'fdt rsvmem add' */
+	ut_assertok(fdt_add_mem_rsv(fdt, addr, 0x1000));
+	ut_assertok(lmb_cache_check(uts, fdt, addr, 1));
+	ut_assertok(fdt_del_mem_rsv(fdt, 0));
+	ut_assertok(lmb_cache_check(uts, fdt, addr, 0));
+
+	/* so is a reserved-memory node */
+	node = fdt_add_subnode(fdt, 0, "reserved-memory");
+	ut_assert(node >= 0);
+	ut_assertok(fdt_setprop_u32(fdt, node, "#address-cells", 1));
+	ut_assertok(fdt_setprop_u32(fdt, node, "#size-cells", 1));
+	sub = fdt_add_subnode(fdt, node, "buf");
+	ut_assert(sub >= 0);
+	reg[0] = cpu_to_fdt32(addr);
+	reg[1] = cpu_to_fdt32(0x1000);
+	ut_assertok(fdt_setprop(fdt, sub, "reg", reg, sizeof(reg)));
+	ut_assertok(lmb_cache_check(uts, fdt, addr, 1));
+
+	/* and moving it, which does not change the size of the devicetree */
+	reg[0] = cpu_to_fdt32(addr + SZ_1M);
+	ut_assertok(fdt_setprop_inplace(fdt, sub, "reg", reg, sizeof(reg)));
+	ut_assertok(lmb_cache_check(uts, fdt, addr, 0));
+	ut_assertok(lmb_cache_check(uts, fdt, addr + SZ_1M, 1));
+
+	return 0;
+}
+LIB_TEST(lib_test_lmb_cache_fdt, 0);
+#endif
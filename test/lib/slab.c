@@ -0,0 +1,132 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Tests for the slab front-end to malloc()
+ */
+
+#include <malloc.h>
+#include <test/lib.h>
+#include <test/test.h>
+#include <test/ut.h>
+
+/* Size classes used by these tests, counting from 0 for 16 bytes */
+enum {
+	CLASS_32	= 1,
+	CLASS_128	= 5,
+};
+
+static int slab_in_use(struct unit_test_state *uts, int class)
+{
+	struct malloc_slab_stats stats;
+
+	ut_assertok(malloc_slab_get_stats(class, &stats));
+
+	return stats.in_use;
+}
+
+/* Test that small allocations come from the slab and large ones do not */
+static int lib_test_slab_alloc(struct unit_test_state *uts)
+{
+	struct malloc_slab_stats stats;
+	int in_use, i;
+	void *ptr[16];
+	ulong start;
+	void *big;
+
+	/* the arena itself comes from the heap, so set it up first */
+	free(malloc(1));
+	start = ut_check_free();
+
+	ut_assertok(malloc_slab_get_stats(CLASS_32, &stats));
+	ut_asserteq(32, stats.size);
+	in_use = stats.in_use;
+	for (i = 0; i < ARRAY_SIZE(ptr); i++) {
+		ptr[i] = malloc(17 + i);
+		ut_assertnonnull(ptr[i]);
+		ut_asserteq(32, malloc_usable_size(ptr[i]));
+	}
+	ut_asserteq(in_use + ARRAY_SIZE(ptr), slab_in_use(uts, CLASS_32));
+	ut_asserteq(0, ut_check_delta(start));
+
+	big = malloc(257);
+	ut_assertnonnull(big);
+	ut_assert(ut_check_delta(start) > 0);
+	free(big);
+
+	for (i = 0; i < ARRAY_SIZE(ptr); i++)
+		free(ptr[i]);
+	ut_asserteq(in_use, slab_in_use(uts, CLASS_32));
+	ut_asserteq(0, ut_check_delta(start));
+
+	return 0;
+}
+LIB_TEST(lib_test_slab_alloc, 0);
+
+/* Test realloc() within a size class, to a larger one and to the heap */
+static int lib_test_slab_realloc(struct unit_test_state *uts)
+{
+	const char *str = "slab realloc test";
+	int in_use32, in_use128;
+	char *ptr, *ptr2;
+	ulong start;
+
+	free(malloc(1));
+	start = ut_check_free();
+	in_use32 = slab_in_use(uts, CLASS_32);
+	in_use128 = slab_in_use(uts, CLASS_128);
+
+	ptr = malloc(20);
+	ut_assertnonnull(ptr);
+	strcpy(ptr, str);
+
+	/* this still fits, so nothing moves */
+	ut_asserteq_ptr(ptr, realloc(ptr, 32));
+
+	/* a larger class needs a new object */
+	ptr2 = realloc(ptr, 100);
+	ut_assertnonnull(ptr2);
+	ut_assert(ptr2 != ptr);
+	ut_asserteq_str(str, ptr2);
+	ut_asserteq(128, malloc_usable_size(ptr2));
+	ut_asserteq(in_use32, slab_in_use(uts, CLASS_32));
+	ut_asserteq(in_use128 + 1, slab_in_use(uts, CLASS_128));
+	ut_asserteq(0, ut_check_delta(start));
+
+	/* too large for any class, so it moves to the heap */
+	ptr = realloc(ptr2, 300);
+	ut_assertnonnull(ptr);
+	ut_asserteq_str(str, ptr);
+	ut_asserteq(in_use128, slab_in_use(uts, CLASS_128));
+	ut_assert(ut_check_delta(start) > 0);
+
+	free(ptr);
+	ut_asserteq(0, ut_check_delta(start));
+
+	return 0;
+}
+LIB_TEST(lib_test_slab_realloc, 0);
+
+/* Test that a freed object is used again by the next allocation */
+static int lib_test_slab_reuse(struct unit_test_state *uts)
+{
+	struct malloc_slab_stats before, after;
+	void *ptr;
+	ulong start;
+
+	free(malloc(1));
+	start = ut_check_free();
+
+	ptr = malloc(120);
+	ut_assertnonnull(ptr);
+	ut_assertok(malloc_slab_get_stats(CLASS_128, &before));
+	free(ptr);
+	ut_asserteq_ptr(ptr, malloc(128));
+	ut_assertok(malloc_slab_get_stats(CLASS_128, &after));
+	ut_asserteq(before.in_use, after.in_use);
+	ut_asserteq(before.allocs + 1, after.allocs);
+	ut_asserteq(before.pages, after.pages);
+	free(ptr);
+	ut_asserteq(0, ut_check_delta(start));
+
+	return 0;
+}
+LIB_TEST(lib_test_slab_reuse, 0);
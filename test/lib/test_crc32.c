@@ -0,0 +1,70 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Unit test for crc32 and crc32c
+ */
+
+#include <test/lib.h>
+#include <test/ut.h>
+#include <u-boot/crc.h>
+
+static const char crc_str[] = "The quick brown fox jumps over the lazy dog";
+
+/* Byte-at-a-time reference, to check the optimised versions against */
+static uint32_t crc32_ref(uint32_t crc, const u8 *buf, uint len, uint32_t poly)
+{
+	int i;
+
+	crc = ~crc;
+	while (len--) {
+		crc ^= *buf++;
+		for (i = 0; i < 8; i++)
+			crc = (crc >> 1) ^ (crc & 1 ? poly : 0);
+	}
+
+	return ~crc;
+}
+
+static int lib_crc32(struct unit_test_state *uts)
+{
+	u8 buf[80];
+	uint start, len;
+
+	ut_asserteq(0, crc32(0, NULL, 0));
+	ut_asserteq(0x414fa339, crc32(0, crc_str, strlen(crc_str)));
+
+	/* Try all alignments and the lengths around a word boundary */
+	for (start = 0; start < 8; start++) {
+		memcpy(buf + start, crc_str, strlen(crc_str));
+		for (len = 0; len <= 19; len++) {
+			ut_asserteq(crc32_ref(0, (u8 *)crc_str, len,
+					      0xedb88320),
+				    crc32(0, buf + start, len));
+		}
+	}
+
+	/* It must be possible to do the CRC in pieces */
+	ut_asserteq(0x414fa339, crc32(crc32(0, crc_str, 13), crc_str + 13,
+				      strlen(crc_str) - 13));
+
+	return 0;
+}
+LIB_TEST(lib_crc32, 0);
+
+#ifdef CONFIG_CRC32C
+static int lib_crc32c(struct unit_test_state *uts)
+{
+	uint32_t table[256];
+	uint len;
+
+	crc32c_init(table, 0x82f63b78);
+	ut_asserteq(0x22620404, ~crc32c_cal(~0, crc_str, strlen(crc_str),
+					    table));
+	for (len = 0; len <= 19; len++) {
+		ut_asserteq(crc32_ref(0, (u8 *)crc_str + 1, len, 0x82f63b78),
+			    ~crc32c_cal(~0, crc_str + 1, len, table));
+	}
+
+	return 0;
+}
+LIB_TEST(lib_crc32c, 0);
+#endif
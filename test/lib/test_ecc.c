@@ -0,0 +1,141 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Unit tests for the software NAND ECC (Hamming and BCH)
+ */
+
+#include <malloc.h>
+#include <rand.h>
+#include <time.h>
+#include <linux/bch.h>
+#include <linux/mtd/nand_ecc.h>
+#include <test/lib.h>
+#include <test/ut.h>
+
+/* Byte-at-a-time reference, to check the optimised version against */
+static void hamming_ref(const u8 *dat, u8 *ecc)
+{
+	u8 reg1 = 0, reg2 = 0, reg3 = 0, par;
+	int i, j;
+
+	for (i = 0; i < 256; i++) {
+		for (j = 0, par = 0; j < 8; j++)
+			par ^= (dat[i] >> j) & 1;
+		if (par) {
+			reg3 ^= i;
+			reg2 ^= ~i;
+		}
+		/* column parity: CP0..CP5 are bits 0..5 */
+		for (j = 0; j < 8; j++) {
+			if (!((dat[i] >> j) & 1))
+				continue;
+			reg1 ^= (j & 1) ? 0x02 : 0x01;
+			reg1 ^= (j & 2) ? 0x08 : 0x04;
+			reg1 ^= (j & 4) ? 0x20 : 0x10;
+		}
+	}
+
+	ecc[0] = 0;
+	ecc[1] = 0;
+	for (j = 0; j < 4; j++) {
+		ecc[0] |= ((reg3 >> (7 - j)) & 1) << (7 - 2 * j);
+		ecc[0] |= ((reg2 >> (7 - j)) & 1) << (6 - 2 * j);
+		ecc[1] |= ((reg3 >> (3 - j)) & 1) << (7 - 2 * j);
+		ecc[1] |= ((reg2 >> (3 - j)) & 1) << (6 - 2 * j);
+	}
+	ecc[0] = ~ecc[0];
+	ecc[1] = ~ecc[1];
+	ecc[2] = ((~reg1) << 2) | 0x03;
+}
+
+static int lib_nand_ecc_hamming(struct unit_test_state *uts)
+{
+	u8 buf[257], ecc[3], ref[3], read_ecc[3];
+	int i, n, bit;
+
+	srand(1);
+	for (n = 0; n < 64; n++) {
+		/* use an odd start too, to check unaligned access */
+		u8 *dat = buf + (n & 1);
+
+		for (i = 0; i < 256; i++)
+			dat[i] = n < 8 ? (i == n * 31 ? 1 << n : 0) : rand();
+		ut_assertok(nand_calculate_ecc(NULL, dat, ecc));
+		hamming_ref(dat, ref);
+		ut_asserteq_mem(ref, ecc, sizeof(ecc));
+
+		/* a single flipped bit is corrected */
+		memcpy(read_ecc, ecc, sizeof(ecc));
+		bit = rand() % (256 * 8);
+		dat[bit / 8] ^= 1 << (bit % 8);
+		ut_assertok(nand_calculate_ecc(NULL, dat, ecc));
+		ut_asserteq(1, nand_correct_data(NULL, dat, read_ecc, ecc));
+		ut_assertok(nand_calculate_ecc(NULL, dat, ecc));
+		ut_asserteq_mem(read_ecc, ecc, sizeof(ecc));
+	}
+
+	return 0;
+}
+LIB_TEST(lib_nand_ecc_hamming, 0);
+
+#if CONFIG_IS_ENABLED(BCH)
+/* Correct up to @t random bit errors in a 512-byte block, for a few codes */
+static int lib_bch(struct unit_test_state *uts)
+{
+	static const int codes[][2] = { {13, 4}, {13, 8}, {14, 16} };
+	unsigned int errloc[16];
+	u8 ecc[32], calc[32];
+	int c, i, n, nerr, ret;
+	struct bch_control *bch;
+	u8 *dat, *orig;
+	ulong start;
+
+	dat = malloc(512);
+	orig = malloc(512);
+	ut_assertnonnull(dat);
+	ut_assertnonnull(orig);
+	srand(2);
+	for (c = 0; c < ARRAY_SIZE(codes); c++) {
+		bch = init_bch(codes[c][0], codes[c][1], 0);
+		ut_assertnonnull(bch);
+		for (n = 0; n < 20; n++) {
+			for (i = 0; i < 512; i++)
+				orig[i] = rand();
+			memset(ecc, '\0', sizeof(ecc));
+			encode_bch(bch, orig, 512, ecc);
+
+			memcpy(dat, orig, 512);
+			nerr = n % (bch->t + 1);
+			for (i = 0; i < nerr; i++) {
+				int bit = (n * 977 + i * 131) % (512 * 8);
+
+				dat[bit / 8] ^= 1 << (bit % 8);
+			}
+			ret = decode_bch(bch, dat, 512, ecc, NULL, NULL,
+					 errloc);
+			ut_asserteq(nerr, ret);
+			for (i = 0; i < ret; i++)
+				dat[errloc[i] / 8] ^= 1 << (errloc[i] % 8);
+			ut_asserteq_mem(orig, dat, 512);
+		}
+
+		/* time decoding with @t errors, the worst case */
+		start = timer_get_us();
+		for (n = 0; n < 100; n++) {
+			memset(calc, '\0', sizeof(calc));
+			encode_bch(bch, dat, 512, calc);
+			for (i = 0; i < bch->t; i++)
+				calc[i] ^= 1;
+			ut_asserteq(bch->t, decode_bch(bch, NULL, 512, ecc,
+						       calc, NULL, errloc));
+		}
+		printf("bch m=%d t=%d: %lu us for 100 decodes\n", codes[c][0],
+		       codes[c][1], timer_get_us() - start);
+		free_bch(bch);
+	}
+	free(orig);
+	free(dat);
+
+	return 0;
+}
+LIB_TEST(lib_bch, 0);
+#endif
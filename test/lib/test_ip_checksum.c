@@ -0,0 +1,52 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Unit test for the IP checksum
+ */
+
+#include <net.h>
+#include <test/lib.h>
+#include <test/ut.h>
+
+/* Add the data as big-endian 16-bit words, one byte at a time */
+static uint ref_checksum(const u8 *ptr, uint nbytes)
+{
+	ulong sum = 0;
+	uint i;
+
+	for (i = 0; i < nbytes; i++)
+		sum += i & 1 ? ptr[i] : ptr[i] << 8;
+	while (sum >> 16)
+		sum = (sum & 0xffff) + (sum >> 16);
+
+	return ~sum & 0xffff;
+}
+
+static int lib_ip_checksum(struct unit_test_state *uts)
+{
+	u8 buf[80] __aligned(8);
+	uint offset, len, i;
+
+	for (i = 0; i < sizeof(buf); i++)
+		buf[i] = i * 37 + 11;
+
+	/* The data can start at any 16-bit boundary and be any length */
+	for (offset = 0; offset < 8; offset += 2) {
+		for (len = 0; len <= sizeof(buf) - offset; len++) {
+			ut_asserteq(ref_checksum(buf + offset, len),
+				    ntohs(compute_ip_checksum(buf + offset,
+							      len)));
+		}
+	}
+
+	/* A header with its checksum filled in must check out */
+	memset(buf, '\xff', 20);
+	buf[10] = 0;
+	buf[11] = 0;
+	*(u16 *)(buf + 10) = compute_ip_checksum(buf, 20);
+	ut_assert(ip_checksum_ok(buf, 20));
+	buf[3] ^= 1;
+	ut_assert(!ip_checksum_ok(buf, 20));
+
+	return 0;
+}
+LIB_TEST(lib_ip_checksum, 0);
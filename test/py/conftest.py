@@ -79,6 +79,10 @@ def pytest_addoption(parser):
     parser.addoption('--gdbserver', default=None,
         help='Run sandbox under gdbserver. The argument is the channel '+
         'over which gdbserver should communicate, e.g. localhost:1234')
+    parser.addoption('--shard', default=None,
+        help='Run only part of the tests, given as INDEX/COUNT, e.g. 2/4 '+
+        'runs the second of four equal parts. Use this to split a run '+
+        'across machines')
 
 def run_build(config, source_dir, build_dir, board_type, log):
     """run_build: Build U-Boot
@@ -174,9 +178,14 @@ def pytest_configure(config):
         build_dir = source_dir + '/build-' + board_type
     mkdir_p(build_dir)
 
+    worker_id = os.environ.get("PYTEST_XDIST_WORKER")
+
     result_dir = config.getoption('result_dir')
     if not result_dir:
         result_dir = build_dir
+    # Parallel workers each need their own log and scratch files
+    if worker_id and worker_id != 'master':
+        result_dir = os.path.join(result_dir, worker_id)
     mkdir_p(result_dir)
 
     persistent_data_dir = config.getoption('persistent_data_dir')
@@ -192,7 +201,6 @@ def pytest_configure(config):
     log = multiplexed_log.Logfile(result_dir + '/test-log.html')
 
     if config.getoption('build'):
-        worker_id = os.environ.get("PYTEST_XDIST_WORKER")
         with filelock.FileLock(os.path.join(build_dir, 'build.lock')):
             build_done_file = Path(build_dir) / 'build.done'
             if (not worker_id or worker_id == 'master' or
@@ -433,6 +441,38 @@ def pytest_itemcollected(item):
 
     tests_not_run.append(item.name)
 
+def pytest_collection_modifyitems(config, items):
+    """pytest hook: Called after collection, to filter or re-order tests.
+
+    This implements the --shard option, selecting every COUNT'th test so that
+    slow groups of tests are spread across the shards.
+
+    Args:
+        config: The pytest configuration.
+        items: List of the collected test items, updated in place.
+
+    Returns:
+        Nothing.
+    """
+
+    shard = config.getoption('shard')
+    if not shard:
+        return
+    try:
+        index, count = [int(val) for val in shard.split('/')]
+    except ValueError:
+        raise pytest.UsageError('--shard must be INDEX/COUNT, e.g. 1/4')
+    if count < 1 or not 1 <= index <= count:
+        raise pytest.UsageError('--shard index must be in the range 1-COUNT')
+
+    selected = items[index - 1::count]
+    keep = set(selected)
+    deselected = [item for item in items if item not in keep]
+    for item in deselected:
+        tests_not_run.remove(item.name)
+    config.hook.pytest_deselected(items=deselected)
+    items[:] = selected
+
 def cleanup():
     """Clean up all global state.
 
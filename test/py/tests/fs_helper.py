@@ -9,7 +9,7 @@ import re
 import os
 from subprocess import call, check_call, check_output, CalledProcessError
 
-def mk_fs(config, fs_type, size, prefix, size_gran = 0x100000):
+def mk_fs(config, fs_type, size, prefix, size_gran = 0x100000, src_dir=None):
     """Create a file system volume
 
     Args:
@@ -18,6 +18,8 @@ def mk_fs(config, fs_type, size, prefix, size_gran = 0x100000):
         size (int): Size of file system in bytes
         prefix (str): Prefix string of volume's file name
         size_gran (int): Size granularity of file system image in bytes
+        src_dir (str): Directory whose contents are copied into the file
+            system, or None to leave it empty. This needs mtools for FAT.
 
     Raises:
         CalledProcessError: if any error occurs when creating the filesystem
@@ -34,6 +36,9 @@ def mk_fs(config, fs_type, size, prefix, size_gran = 0x100000):
     else:
         mkfs_opt = ''
 
+    if src_dir and fs_type.startswith('ext'):
+        mkfs_opt += f' -d {src_dir}'
+
     if re.match('fat', fs_type):
         fs_lnxtype = 'vfat'
     else:
@@ -55,6 +60,8 @@ def mk_fs(config, fs_type, size, prefix, size_gran = 0x100000):
                                       shell=True).decode()
             if 'metadata_csum' in sb_content:
                 check_call(f'tune2fs -O ^metadata_csum {fs_img}', shell=True)
+        if src_dir and re.match('fat', fs_type):
+            check_call(f'mcopy -i {fs_img} -s {src_dir}/* ::/', shell=True)
         return fs_img
     except CalledProcessError:
         call(f'rm -f {fs_img}', shell=True)
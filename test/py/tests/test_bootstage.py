@@ -1,6 +1,7 @@
 # SPDX-License-Identifier: GPL-2.0
 # (C) Copyright 2023, Advanced Micro Devices, Inc.
 
+import os
 import pytest
 
 """
@@ -30,6 +31,25 @@ def test_bootstage_report(u_boot_console):
     assert 'Accumulated time:' in output
     assert 'dm_r' in output
 
+@pytest.mark.buildconfigspec('bootstage')
+@pytest.mark.buildconfigspec('cmd_bootstage')
+@pytest.mark.buildconfigspec('bootstage_profile')
+def test_bootstage_prof(u_boot_console):
+    output = u_boot_console.run_command('bootstage prof 5')
+    assert 'profiled items, in microseconds' in output
+    assert 'initcall' in output
+    assert 'probe' in output
+
+@pytest.mark.buildconfigspec('sandbox')
+@pytest.mark.buildconfigspec('cmd_bootstage')
+@pytest.mark.buildconfigspec('bootstage_pipeline')
+def test_bootstage_pipeline(u_boot_console):
+    fname = os.path.join(u_boot_console.config.build_dir, 'u-boot.dtb')
+    u_boot_console.run_command('host load hostfs - 1000 %s' % fname)
+    output = u_boot_console.run_command('bootstage pipeline')
+    assert 'Boot pipeline, times in microseconds' in output
+    assert 'fs-read' in output
+
 @pytest.mark.buildconfigspec('bootstage')
 @pytest.mark.buildconfigspec('cmd_bootstage')
 @pytest.mark.buildconfigspec('bootstage_stash')
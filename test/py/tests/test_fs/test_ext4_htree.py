@@ -0,0 +1,153 @@
+# SPDX-License-Identifier: GPL-2.0+
+#
+# U-Boot File System: ext4 hash-tree directory test
+
+"""
+This test checks lookups in a directory with a hash-tree (dir_index) index
+against the same directory without one, which is scanned linearly.
+"""
+
+import os
+import pytest
+import shutil
+import subprocess
+
+HTREE_SRC_DIR = 'htree_src_dir'
+HTREE_IMAGE_NAME = 'htree.img'
+LINEAR_IMAGE_NAME = 'linear.img'
+
+# enough entries for an index over several leaf blocks
+NUM_FILES = 3000
+
+def file_name(num):
+    """
+    Returns the name of a file in the large directory.
+    """
+    return 'file-with-a-long-name-%05d' % num
+
+def file_size(num):
+    """
+    Returns the size of a file, which differs between neighbours so that
+    finding the wrong entry is noticed.
+    """
+    return num % 997 + 1
+
+def make_image(build_dir, image_name, dir_index):
+    """
+    Makes an ext4 image of the source directory.
+
+    The directories are rebuilt by e2fsck -D, which adds an index to each
+    directory of more than one block if dir_index is enabled and leaves them
+    unindexed otherwise.
+    """
+    src_dir = os.path.join(build_dir, HTREE_SRC_DIR)
+    image_path = os.path.join(build_dir, image_name)
+    features = '^metadata_csum' + ('' if dir_index else ',^dir_index')
+    subprocess.run(['mkfs.ext4 -q -F -b 4096 -N 4096 -O %s -d %s %s 64M' %
+                    (features, src_dir, image_path)], shell=True, check=True,
+                   stdout=subprocess.DEVNULL)
+
+    # e2fsck returns 1 if it changed the filesystem
+    ret = subprocess.run(['e2fsck -fyD %s' % image_path], shell=True,
+                         stdout=subprocess.DEVNULL).returncode
+    assert ret in (0, 1)
+
+    out = subprocess.run(['debugfs -R "htree /big" %s' % image_path],
+                         shell=True, capture_output=True, text=True).stdout
+    assert ('Root node dump' in out) == dir_index
+    return image_path
+
+def make_htree_images(build_dir):
+    """
+    Makes the source directory and an indexed and an unindexed image of it.
+
+    htree_src_dir/
+    ├── big/
+    │   ├── file-with-a-long-name-00000
+    │   ├── ...
+    │   └── file-with-a-long-name-02999
+    └── small
+    """
+    root = os.path.join(build_dir, HTREE_SRC_DIR)
+    big = os.path.join(root, 'big')
+    os.makedirs(big)
+    for num in range(NUM_FILES):
+        with open(os.path.join(big, file_name(num)), 'w') as file:
+            file.write('x' * file_size(num))
+    with open(os.path.join(root, 'small'), 'w') as file:
+        file.write('small')
+
+    return (make_image(build_dir, HTREE_IMAGE_NAME, True),
+            make_image(build_dir, LINEAR_IMAGE_NAME, False))
+
+def clean_htree_images(build_dir):
+    """
+    Deletes the images and the source directory.
+    """
+    shutil.rmtree(os.path.join(build_dir, HTREE_SRC_DIR))
+    for name in (HTREE_IMAGE_NAME, LINEAR_IMAGE_NAME):
+        path = os.path.join(build_dir, name)
+        if os.path.exists(path):
+            os.remove(path)
+
+def htree_run_lookups(u_boot_console, image_path):
+    """
+    Lists the large directory and looks up some files in it.
+
+    Returns the output of each command, for comparing between images.
+    """
+    results = []
+    u_boot_console.run_command('host bind 0 %s' % image_path)
+
+    output = u_boot_console.run_command('ext4ls host 0 /big')
+    lines = sorted(output.splitlines())
+    assert len([line for line in lines if 'file-with-a-long-name-' in line]) \
+        == NUM_FILES
+    results.append(lines)
+
+    # the first and last names, and a spread in between
+    for num in [0, NUM_FILES - 1] + list(range(1, NUM_FILES, 97)):
+        output = u_boot_console.run_command_list([
+            'setenv filesize',
+            'size host 0 /big/%s' % file_name(num),
+            'printenv filesize'])
+        assert 'filesize=%x' % file_size(num) in ''.join(output)
+        results.append(output)
+
+    # names which are not there, including ones close to real names
+    for name in ['none', file_name(NUM_FILES), file_name(12)[:-1],
+                 file_name(12) + '0', 'FILE-WITH-A-LONG-NAME-00012']:
+        output = u_boot_console.run_command(
+            'size host 0 /big/%s; echo $?' % name)
+        assert output.endswith('1')
+        results.append(output)
+
+    output = u_boot_console.run_command_list([
+        'size host 0 /small',
+        'printenv filesize'])
+    assert 'filesize=5' in ''.join(output)
+    results.append(output)
+
+    return results
+
+@pytest.mark.boardspec('sandbox')
+@pytest.mark.buildconfigspec('cmd_fs_generic')
+@pytest.mark.buildconfigspec('cmd_ext4')
+@pytest.mark.requiredtool('mkfs.ext4')
+@pytest.mark.requiredtool('e2fsck')
+@pytest.mark.requiredtool('debugfs')
+@pytest.mark.slow
+
+def test_ext4_htree(u_boot_console):
+    """
+    Checks that an indexed directory gives the same results as a linear one.
+    """
+    build_dir = u_boot_console.config.build_dir
+
+    try:
+        htree_img, linear_img = make_htree_images(build_dir)
+        htree = htree_run_lookups(u_boot_console, htree_img)
+        linear = htree_run_lookups(u_boot_console, linear_img)
+        assert htree == linear
+    finally:
+        clean_htree_images(build_dir)
@@ -10,6 +10,7 @@ This test verifies fat specific file system behaviour.
 
 import pytest
 import re
+from fstest_defs import *
 
 @pytest.mark.boardspec('sandbox')
 @pytest.mark.slow
@@ -23,3 +24,39 @@ class TestFsFat(object):
                 'host bind 0 %s' % fs_img,
                 'fatinfo host 0:0'])
             assert(re.search('Filesystem: %s' % fs_type.upper(), ''.join(output)))
+
+    def test_fs_fat2(self, u_boot_console, fs_obj_fat):
+        """Test that a directory listing is read again after a write."""
+        fs_type,fs_img = fs_obj_fat
+        with u_boot_console.log.section('Test Case 2 - listing after write'):
+            # Test Case 2a - list a directory and look up a missing file
+            output = u_boot_console.run_command_list([
+                'host bind 0 %s' % fs_img,
+                '%smkdir host 0:0 /dir' % fs_type,
+                '%sls host 0:0 /dir' % fs_type])
+            assert('0 file(s), 2 dir(s)' in ''.join(output))
+            output = u_boot_console.run_command(
+                'size host 0:0 /dir/cache.txt; echo $?')
+            assert(output.endswith('1'))
+
+            # Test Case 2b - the new file must be found
+            output = u_boot_console.run_command_list([
+                'mw.b %x 5a 100' % ADDR,
+                '%swrite host 0:0 %x /dir/cache.txt 100' % (fs_type, ADDR),
+                '%sls host 0:0 /dir' % fs_type])
+            assert('cache.txt' in ''.join(output))
+            assert('1 file(s), 2 dir(s)' in ''.join(output))
+            output = u_boot_console.run_command_list([
+                'size host 0:0 /dir/cache.txt',
+                'printenv filesize'])
+            assert('filesize=100' in ''.join(output))
+
+            # Test Case 2c - and must be gone once deleted
+            output = u_boot_console.run_command_list([
+                '%srm host 0:0 /dir/cache.txt' % fs_type,
+                '%sls host 0:0 /dir' % fs_type])
+            assert('cache.txt' not in ''.join(output))
+            assert('0 file(s), 2 dir(s)' in ''.join(output))
+            output = u_boot_console.run_command(
+                'size host 0:0 /dir/cache.txt; echo $?')
+            assert(output.endswith('1'))
@@ -330,6 +330,49 @@ def test_gpt_write(state_disk_image, u_boot_console):
     output = u_boot_console.run_command('gpt guid host 0')
     assert '375a56f7-d6c9-4e81-b5f0-09d41ca89efe' in output
 
+@pytest.mark.boardspec('sandbox')
+@pytest.mark.buildconfigspec('cmd_gpt')
+@pytest.mark.buildconfigspec('cmd_part')
+@pytest.mark.buildconfigspec('cmd_read')
+@pytest.mark.buildconfigspec('cmd_write')
+@pytest.mark.requiredtool('sgdisk')
+def test_gpt_write_reread(state_disk_image, u_boot_console):
+    """Test that the partitions are read again after the GPT changes."""
+
+    u_boot_console.run_command('host bind 0 ' + state_disk_image.path)
+    output = u_boot_console.run_command('part list host 0')
+    assert '0x00000800	0x00000fff	"part1"' in output
+    output = u_boot_console.run_command('gpt setenv host 0 part2')
+    assert 'success!' in output
+    output = u_boot_console.run_command('echo ${gpt_partition_entry}')
+    assert output.rstrip() == '2'
+
+    # Keep the original primary GPT, to put it back later
+    u_boot_console.run_command('read host 0:0 ${loadaddr} 0 22')
+
+    output = u_boot_console.run_command('gpt write host 0 "name=all,size=0"')
+    assert 'Writing GPT: success!' in output
+    output = u_boot_console.run_command('part list host 0')
+    assert '0x00000022	0x00001fde	"all"' in output
+    assert 'part1' not in output
+    output = u_boot_console.run_command('gpt setenv host 0 all')
+    assert 'success!' in output
+    output = u_boot_console.run_command('echo ${gpt_partition_entry}')
+    assert output.rstrip() == '1'
+    output = u_boot_console.run_command('gpt setenv host 0 part2')
+    assert 'error!' in output
+
+    # A write to the disk which does not go through the GPT code
+    u_boot_console.run_command('write host 0:0 ${loadaddr} 0 22')
+    output = u_boot_console.run_command('part list host 0')
+    assert '0x00000800	0x00000fff	"part1"' in output
+    assert '0x00001000	0x00001bff	"part2"' in output
+    assert '"all"' not in output
+    output = u_boot_console.run_command('gpt setenv host 0 part2')
+    assert 'success!' in output
+    output = u_boot_console.run_command('echo ${gpt_partition_entry}')
+    assert output.rstrip() == '2'
+
 @pytest.mark.buildconfigspec('cmd_gpt')
 @pytest.mark.buildconfigspec('cmd_gpt_rename')
 @pytest.mark.buildconfigspec('cmd_part')
@@ -0,0 +1,345 @@
+# SPDX-License-Identifier: GPL-2.0+
+
+"""
+Performance tests
+
+These measure how quickly U-Boot does some common operations: reading files
+from each filesystem, decompression, hashing, importing an environment,
+binding devices and scanning for bootflows. The results are written to
+perf.json in the result directory, so they can be compared between runs.
+
+On sandbox the files are read from filesystem images created on the host
+and attached with 'host bind'. On other boards they are read from a
+partition which must already hold them, created with --perf-files (see
+below).
+
+A test fails if its result is worse than a threshold, or if it is worse than
+a baseline by more than a tolerance. Both come from boardenv_*. For example:
+
+env__perf = {
+    # Device and partition holding the files, instead of host images
+    'fs_dev': 'mmc 0:2',
+    # Filesystem types of 'fs_dev' (for the names of the results)
+    'fs_types': ['ext4'],
+    # Two free areas of memory, each at least 'size' bytes
+    'addr': 0x10000000,
+    'addr2': 0x18000000,
+    # Size of the files, in bytes
+    'size': 0x1000000,
+    # Label to pass to 'bootflow scan'
+    'bootflow_label': 'mmc',
+    # Lowest throughput (MB/s) or highest time (ms) allowed for each result
+    'thresholds': {
+        'fs_read_ext4': 40,
+        'unzip': 25,
+        'env_import': 5,
+    },
+    # perf.json from an earlier run, and by how much (%) results may be worse
+    'baseline': '/path/to/perf.json',
+    'tolerance': 20,
+}
+
+Timings from the 'time' command have a resolution of one millisecond, so
+'size' should be large enough for each operation to take a good number of
+milliseconds.
+
+The files can be created on the host with:
+
+    python3 test/py/tests/test_perf.py --perf-files <dir> [size]
+"""
+
+import gzip
+import json
+import lzma
+import os
+import re
+import sys
+from subprocess import CalledProcessError
+
+import pytest
+
+# Defaults for sandbox
+PERF_ADDR = 0x1000000
+PERF_ADDR2 = 0x3000000
+PERF_SIZE = 0x1000000
+
+# Number of variables in the environment to import
+ENV_VARS = 2000
+
+# Filesystems to create images for on sandbox
+PERF_FS_TYPES = ['fat32', 'ext4']
+
+def make_files(dirname, size):
+    """Create the files read by the tests
+
+    Args:
+        dirname (str): Directory to write the files to
+        size (int): Size of the data files in bytes
+    """
+    with open(os.path.join(dirname, 'perf.bin'), 'wb') as outf:
+        outf.write(os.urandom(size))
+
+    # Something which compresses about as well as a typical kernel
+    line = 0
+    data = bytearray()
+    while len(data) < size:
+        data += b'%08x: %s\n' % (line, os.urandom(8).hex().encode())
+        line += 1
+    data = bytes(data[:size])
+    with open(os.path.join(dirname, 'perf.gz'), 'wb') as outf:
+        outf.write(gzip.compress(data))
+    with open(os.path.join(dirname, 'perf.lzma'), 'wb') as outf:
+        outf.write(lzma.compress(data, format=lzma.FORMAT_ALONE))
+
+    with open(os.path.join(dirname, 'perf.env'), 'w') as outf:
+        for i in range(ENV_VARS):
+            outf.write(f'perf_var{i}=value {i} of the perf test\n')
+
+class Perf:
+    """Results of the performance tests, with their limits
+
+    Properties:
+        results (dict): Results so far
+            key (str): Name of result
+            value (dict): 'value' and 'unit' of the result
+        thresholds (dict): Worst value allowed for each result
+        baseline (dict): Results from an earlier run, in the same form as
+            'results'
+        tolerance (float): How much worse than 'baseline' a result may be, in
+            percent, or None to not compare
+    """
+    def __init__(self, u_boot_console):
+        self.cons = u_boot_console
+        self.env = u_boot_console.config.env.get('env__perf', {})
+        self.fname = os.path.join(u_boot_console.config.result_dir,
+                                  'perf.json')
+        self.results = {}
+        self.thresholds = self.env.get('thresholds', {})
+        self.baseline = {}
+        self.tolerance = self.env.get('tolerance')
+        if self.env.get('baseline'):
+            with open(self.env['baseline']) as inf:
+                self.baseline = json.load(inf)['results']
+
+    def write(self):
+        """Write out the results collected so far"""
+        config = self.cons.config
+        data = {
+            'board_type': config.board_type,
+            'board_identity': config.board_identity,
+            'results': self.results,
+        }
+        with open(self.fname, 'w') as outf:
+            json.dump(data, outf, indent=4, sort_keys=True)
+
+    def record(self, name, value, unit):
+        """Record a result and check it against the limits
+
+        Args:
+            name (str): Name of the result, e.g. 'fs_read_ext4'
+            value (float): Value of the result
+            unit (str): 'MB/s' for a throughput, where higher is better, or
+                'ms' for a time, where lower is better
+        """
+        higher = unit == 'MB/s'
+        self.results[name] = {'value': round(value, 3), 'unit': unit}
+        self.cons.log.info(f'perf: {name} = {value:.3f} {unit}')
+
+        limit = self.thresholds.get(name)
+        if limit is not None:
+            assert value >= limit if higher else value <= limit, \
+                f'{name}: {value:.3f} {unit} is worse than threshold {limit}'
+
+        base = self.baseline.get(name)
+        if base and self.tolerance is not None:
+            scale = self.tolerance / 100
+            limit = base['value'] * (1 - scale if higher else 1 + scale)
+            assert value >= limit if higher else value <= limit, \
+                (f'{name}: {value:.3f} {unit} is more than {self.tolerance}% '
+                 f"worse than baseline {base['value']}")
+
+    def timed(self, cmd):
+        """Run a command and work out how long it took
+
+        Args:
+            cmd (str): Command to run
+
+        Returns:
+            tuple:
+                str: Output of the command
+                float: Time taken in milliseconds, at least 1
+        """
+        output = self.cons.run_command(f'time {cmd}')
+        m = re.search(r'time: (?:(\d+) minutes, )?(\d+)\.(\d+) seconds', output)
+        assert m, f"No time reported for '{cmd}'"
+        msecs = (int(m.group(1) or 0) * 60 + int(m.group(2))) * 1000
+        msecs += int(m.group(3))
+        self.check_ok(cmd)
+        return output, max(msecs, 1)
+
+    def check_ok(self, cmd):
+        """Check that the last command succeeded
+
+        Args:
+            cmd (str): Command which was run, for the error message
+        """
+        assert self.cons.run_command('echo $?') == '0', f"'{cmd}' failed"
+
+@pytest.fixture(scope='module')
+def perf(u_boot_console):
+    """Collect the results of the tests in this module"""
+    res = Perf(u_boot_console)
+    yield res
+    res.write()
+
+@pytest.fixture(scope='module')
+def perf_fs(u_boot_console, perf):
+    """Get the partitions holding the files for the tests
+
+    Returns:
+        list of tuple:
+            str: Filesystem type
+            str: Interface and partition, e.g. 'host 0:0'
+    """
+    env = perf.env
+    if 'fs_dev' in env:
+        return [(fs_type, env['fs_dev'])
+                for fs_type in env.get('fs_types', ['fs'])]
+    if u_boot_console.config.board_type != 'sandbox':
+        pytest.skip('env__perf has no fs_dev')
+
+    # pylint: disable=import-outside-toplevel
+    import fs_helper
+
+    config = u_boot_console.config
+    src_dir = os.path.join(config.persistent_data_dir, 'perf')
+    os.makedirs(src_dir, exist_ok=True)
+    size = env.get('size', PERF_SIZE)
+    if not os.path.exists(os.path.join(src_dir, 'perf.env')):
+        make_files(src_dir, size)
+    parts = []
+    for seq, fs_type in enumerate(PERF_FS_TYPES):
+        try:
+            fs_img = fs_helper.mk_fs(config, fs_type, size * 4, 'perf',
+                                     src_dir=src_dir)
+        except CalledProcessError:
+            continue
+        u_boot_console.run_command(f'host bind {seq} {fs_img}')
+        perf.check_ok('host bind')
+        parts.append((fs_type, f'host {seq}'))
+    if not parts:
+        pytest.skip('Cannot create filesystem images')
+    return parts
+
+def load(perf, part, fname, addr):
+    """Load a file into memory
+
+    Args:
+        perf (Perf): Results
+        part (str): Interface and partition
+        fname (str): Filename
+        addr (int): Address to load it to
+
+    Returns:
+        tuple:
+            int: Size of the file in bytes
+            float: Time taken in milliseconds, at least 1
+    """
+    output = perf.cons.run_command(f'load {part} {addr:x} {fname}')
+    m = re.search(r'(\d+) bytes read in (\d+) ms', output)
+    assert m, f'Cannot load {fname}'
+    return int(m.group(1)), max(int(m.group(2)), 1)
+
+def throughput(size, msecs):
+    """Work out a throughput in MB/s"""
+    return size / 1e6 / (msecs / 1000)
+
+@pytest.mark.buildconfigspec('cmd_fs_generic')
+def test_perf_fs_read(perf, perf_fs):
+    """Test how quickly files are read from each filesystem"""
+    addr = perf.env.get('addr', PERF_ADDR)
+    for fs_type, part in perf_fs:
+        size, msecs = load(perf, part, 'perf.bin', addr)
+        perf.record(f'fs_read_{fs_type}', throughput(size, msecs), 'MB/s')
+
+@pytest.mark.buildconfigspec('cmd_fs_generic')
+@pytest.mark.buildconfigspec('cmd_time')
+@pytest.mark.buildconfigspec('cmd_unzip')
+def test_perf_unzip(perf, perf_fs):
+    """Test how quickly gzip data is decompressed"""
+    addr = perf.env.get('addr', PERF_ADDR)
+    addr2 = perf.env.get('addr2', PERF_ADDR2)
+    load(perf, perf_fs[0][1], 'perf.gz', addr)
+    output, msecs = perf.timed(f'unzip {addr:x} {addr2:x}')
+    m = re.search(r'Uncompressed size: (\d+) = ', output)
+    assert m
+    perf.record('unzip', throughput(int(m.group(1)), msecs), 'MB/s')
+
+@pytest.mark.buildconfigspec('cmd_fs_generic')
+@pytest.mark.buildconfigspec('cmd_time')
+@pytest.mark.buildconfigspec('cmd_lzmadec')
+def test_perf_lzmadec(perf, perf_fs):
+    """Test how quickly LZMA data is decompressed"""
+    addr = perf.env.get('addr', PERF_ADDR)
+    addr2 = perf.env.get('addr2', PERF_ADDR2)
+    load(perf, perf_fs[0][1], 'perf.lzma', addr)
+    output, msecs = perf.timed(f'lzmadec {addr:x} {addr2:x}')
+    m = re.search(r'Uncompressed size: (\d+) = ', output)
+    assert m
+    perf.record('lzmadec', throughput(int(m.group(1)), msecs), 'MB/s')
+
+@pytest.mark.buildconfigspec('cmd_fs_generic')
+@pytest.mark.buildconfigspec('cmd_time')
+@pytest.mark.buildconfigspec('cmd_hash')
+def test_perf_hash(u_boot_console, perf, perf_fs):
+    """Test how quickly data is hashed with each algorithm"""
+    addr = perf.env.get('addr', PERF_ADDR)
+    size, _ = load(perf, perf_fs[0][1], 'perf.bin', addr)
+    algos = ['crc32']
+    algos += [algo for algo in ['md5', 'sha1', 'sha256', 'sha384', 'sha512']
+              if u_boot_console.config.buildconfig.get(f'config_{algo}')]
+    for algo in algos:
+        _, msecs = perf.timed(f'hash {algo} {addr:x} {size:x}')
+        perf.record(f'hash_{algo}', throughput(size, msecs), 'MB/s')
+
+@pytest.mark.buildconfigspec('cmd_fs_generic')
+@pytest.mark.buildconfigspec('cmd_time')
+@pytest.mark.buildconfigspec('cmd_importenv')
+def test_perf_env_import(u_boot_console, perf, perf_fs):
+    """Test how quickly a text environment is imported"""
+    addr = perf.env.get('addr', PERF_ADDR)
+    size, _ = load(perf, perf_fs[0][1], 'perf.env', addr)
+    try:
+        _, msecs = perf.timed(f'env import -t {addr:x} {size:x}')
+        perf.record('env_import', msecs, 'ms')
+    finally:
+        # Drop the imported variables
+        u_boot_console.restart_uboot()
+
+@pytest.mark.buildconfigspec('bootstage')
+@pytest.mark.buildconfigspec('cmd_bootstage')
+def test_perf_dm_bind(u_boot_console, perf):
+    """Test how long driver model takes to bind and probe devices at start-up
+
+    This is the time recorded by bootstage for setting up driver model after
+    relocation, including the scan of the devicetree.
+    """
+    output = u_boot_console.run_command('bootstage report')
+    m = re.search(r'^\s*([\d,]+)\s.*\bdm_r\s*$', output, re.MULTILINE)
+    assert m, 'No dm_r time in the bootstage report'
+    perf.record('dm_init_r', int(m.group(1).replace(',', '')) / 1000, 'ms')
+
+@pytest.mark.buildconfigspec('cmd_bootflow')
+@pytest.mark.buildconfigspec('cmd_time')
+def test_perf_bootflow_scan(perf):
+    """Test how long it takes to scan for bootflows"""
+    label = perf.env.get('bootflow_label', 'mmc')
+    _, msecs = perf.timed(f'bootflow scan {label}')
+    perf.record('bootflow_scan', msecs, 'ms')
+
+if __name__ == '__main__':
+    if len(sys.argv) < 3 or sys.argv[1] != '--perf-files':
+        print(f'Usage: {sys.argv[0]} --perf-files <dir> [size]')
+        sys.exit(1)
+    make_files(sys.argv[2], int(sys.argv[3], 0) if len(sys.argv) > 3 else
+               PERF_SIZE)
@@ -177,6 +177,22 @@ class Bintool:
         """
         return tools.tool_find(self.name)
 
+    def cache_id(self):
+        """Get a string which changes when the bintool is changed
+
+        This is used as part of the key for outputs of the bintool kept in the
+        cache, so that updating or rebuilding the tool makes binman run it
+        again.
+
+        Returns:
+            str: Identity of the tool, based on its path, size and timestamp
+        """
+        path = self.get_path()
+        if not path:
+            return self.name
+        stat = os.stat(path)
+        return f'{path}:{stat.st_size}:{stat.st_mtime_ns}'
+
     def fetch_tool(self, method, col, skip_present):
         """Fetch a single tool
 
@@ -28,3 +28,19 @@ class Bintoolzstd(bintool.BintoolPacker):
     """
     def __init__(self, name):
         super().__init__(name)
+
+    def compress_frames(self, indata, frame_size):
+        """Compress data as a series of independent frames
+
+        Each frame records its uncompressed size, so that the frames can be
+        decompressed in parallel, e.g. by U-Boot on several CPUs
+
+        Args:
+            indata (bytes): Data to compress
+            frame_size (int): Number of bytes of data to put in each frame
+
+        Returns:
+            bytes: Compressed data
+        """
+        return b''.join(self.compress(indata[pos:pos + frame_size])
+                        for pos in range(0, len(indata), frame_size))
@@ -116,6 +116,11 @@ controlled by a description in the board device tree.'''
             help='Set argument value arg=value')
     build_parser.add_argument('-b', '--board', type=str,
             help='Board name to build')
+    build_parser.add_argument('--cache-dir', type=str,
+            default=os.environ.get('BINMAN_CACHE_DIR'),
+            help='Directory to keep the outputs of bintools in, to reuse '
+                 'when their inputs have not changed (default '
+                 '$BINMAN_CACHE_DIR)')
     build_parser.add_argument('-d', '--dt', type=str,
             help='Configuration file (.dtb) to use')
     build_parser.add_argument('--fake-dtb', action='store_true',
@@ -827,6 +827,7 @@ def Binman(args):
             tools.prepare_output_dir(args.outdir, args.preserve)
             state.SetEntryArgs(args.entry_arg)
             state.SetThreads(args.threads)
+            state.SetCacheDir(args.cache_dir)
 
             images = PrepareImagesAndDtbs(dtb_fname, args.image,
                                           args.update_fdt, use_expanded)
@@ -870,6 +871,10 @@ def Binman(args):
                     tout.error(msg)
                     return 103
 
+            if state.cache_dir:
+                tout.info(f'Cache: {state.cache_hits} hits, '
+                          f'{state.cache_misses} misses')
+
             # Use this to debug the time take to pack the image
             #state.TimingShow()
         finally:
@@ -72,6 +72,8 @@ class Entry(object):
         uncomp_data: Original uncompressed data, if this entry is compressed,
             else None
         compress: Compression algoithm used (e.g. 'lz4'), 'none' if none
+        compress_frame_size: Size of each separately compressed piece of the
+            data, or None to compress it all together
         orig_offset: Original offset value read from node
         orig_size: Original size value read from node
         missing: True if this entry is missing its contents. Note that if it is
@@ -138,6 +140,7 @@ class Entry(object):
         self.image_pos = None
         self.extend_size = False
         self.compress = 'none'
+        self.compress_frame_size = None
         self.missing = False
         self.faked = False
         self.external = False
@@ -318,6 +321,10 @@ class Entry(object):
 
         # This is only supported by blobs and sections at present
         self.compress = fdt_util.GetString(self._node, 'compress', 'none')
+        self.compress_frame_size = fdt_util.GetInt(self._node,
+                                                   'compress-frame-size')
+        if self.compress_frame_size and self.compress != 'zstd':
+            self.Raise('compress-frame-size requires zstd compression')
         self.offset_from_elf = fdt_util.GetPhandleNameOffset(self._node,
                                                              'offset-from-elf')
 
@@ -1197,7 +1204,17 @@ features to produce new behaviours.
         if self.compress != 'none':
             self.uncomp_size = len(indata)
             if self.comp_bintool.is_present():
-                data = self.comp_bintool.compress(indata)
+                key = state.CacheKey('compress', self.compress,
+                                     str(self.compress_frame_size),
+                                     self.comp_bintool.cache_id(), indata)
+                data = state.CacheGet(key)
+                if data is None:
+                    if self.compress_frame_size:
+                        data = self.comp_bintool.compress_frames(
+                            indata, self.compress_frame_size)
+                    else:
+                        data = self.comp_bintool.compress(indata)
+                    state.CachePut(key, data)
             else:
                 self.record_missing_bintool(self.comp_bintool)
                 data = tools.get_bytes(0, 1024)
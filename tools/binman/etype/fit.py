@@ -10,6 +10,7 @@ import libfdt
 from binman.entry import Entry, EntryArg
 from binman.etype.section import Entry_section
 from binman import elf
+from binman import state
 from dtoc import fdt_util
 from dtoc.fdt import Fdt
 from u_boot_pylib import tools
@@ -460,6 +461,15 @@ class Entry_fit(Entry_section):
         align = self._fit_props.get('fit,align')
         if align is not None:
             args.update({'align': fdt_util.fdt32_to_cpu(align.value)})
+
+        key = None
+        if self.mkimage.is_present():
+            key = state.CacheKey('fit', self.mkimage.cache_id(),
+                                 repr(sorted(args.items())), data)
+            fit_data = state.CacheGet(key)
+            if fit_data is not None:
+                tools.write_file(output_fname, fit_data)
+                return fit_data
         if self.mkimage.run(reset_timestamp=True, output_fname=output_fname,
                             **args) is None:
             if not self.GetAllowMissing():
@@ -468,7 +478,9 @@ class Entry_fit(Entry_section):
             self.record_missing_bintool(self.mkimage)
             return tools.get_bytes(0, 1024)
 
-        return tools.read_file(output_fname)
+        fit_data = tools.read_file(output_fname)
+        state.CachePut(key, fit_data)
+        return fit_data
 
     def _raise_subnode(self, node, msg):
         """Raise an error with a paticular FIT subnode
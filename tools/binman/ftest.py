@@ -2653,6 +2653,28 @@ class TestFunctional(unittest.TestCase):
             }
         self.assertEqual(expected, props)
 
+    def testCache(self):
+        """Test that compressed data is reused from the cache"""
+        self._CheckLz4()
+        cache_dir = os.path.join(self._indir, 'binman-cache')
+        shutil.rmtree(cache_dir, ignore_errors=True)
+        old_cache = os.environ.get('BINMAN_CACHE_DIR')
+        os.environ['BINMAN_CACHE_DIR'] = cache_dir
+        try:
+            data = self._DoReadFile('083_compress.dts')
+            self.assertGreater(state.cache_misses, 0)
+
+            # Nothing has changed, so lz4 should not be run again
+            self.assertEqual(data, self._DoReadFile('083_compress.dts'))
+            self.assertGreater(state.cache_hits, 0)
+            self.assertEqual(0, state.cache_misses)
+        finally:
+            if old_cache is None:
+                del os.environ['BINMAN_CACHE_DIR']
+            else:
+                os.environ['BINMAN_CACHE_DIR'] = old_cache
+            shutil.rmtree(cache_dir, ignore_errors=True)
+
     def testCbfsUpdateFdt(self):
         """Test that we can update the device tree with CBFS offset/size info"""
         self._CheckLz4()
@@ -7460,5 +7482,23 @@ fdt         fdtmap                Extract the devicetree blob from the fdtmap
         with self.assertRaises(ValueError) as e:
             self._DoReadFile('323_capsule_accept_revert_missing.dts')
 
+    def testCompressZstdFrames(self):
+        """Test compressing a blob as a series of zstd frames"""
+        bintool = self.comp_bintools['zstd']
+        self._CheckBintool(bintool)
+        data = self._DoReadFile('326_compress_zstd_frames.dts')
+
+        # Each frame starts with the zstd magic number
+        self.assertEqual(-(-len(COMPRESS_DATA) // 16),
+                         data.count(b'\x28\xb5\x2f\xfd'))
+        self.assertEqual(COMPRESS_DATA, bintool.decompress(data))
+
+    def testCompressFramesBadAlgo(self):
+        """Test that compress-frame-size is rejected for other algorithms"""
+        with self.assertRaises(ValueError) as e:
+            self._DoReadFile('327_compress_frames_bad_algo.dts')
+        self.assertIn("Node '/binman/blob': compress-frame-size requires "
+                      'zstd compression', str(e.exception))
+
 if __name__ == "__main__":
     unittest.main()
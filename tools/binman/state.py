@@ -64,6 +64,14 @@ allow_entry_contraction = False
 # Number of threads to use for binman (None means machine-dependent)
 num_threads = None
 
+# Directory holding the outputs of bintools, named by a hash of their inputs
+# (None if there is no cache)
+cache_dir = None
+
+# Number of cache lookups which found an output and which did not
+cache_hits = 0
+cache_misses = 0
+
 
 class Timing:
     """Holds information about an operation that is being timed
@@ -470,6 +478,80 @@ def GetThreads():
     """
     return num_threads
 
+def SetCacheDir(dirname):
+    """Set the directory to use for cached bintool outputs
+
+    Args:
+        dirname (str): Directory to use, or None to disable the cache
+    """
+    global cache_dir, cache_hits, cache_misses
+
+    cache_dir = dirname
+    cache_hits = 0
+    cache_misses = 0
+    if dirname:
+        os.makedirs(dirname, exist_ok=True)
+
+def CacheKey(*parts):
+    """Get the key for a cached output
+
+    Args:
+        parts (list of str or bytes): Everything which affects the output,
+            e.g. the name and version of the tool, its arguments and its input
+
+    Returns:
+        str: Key, or None if there is no cache
+    """
+    if not cache_dir:
+        return None
+    digest = hashlib.sha256()
+    for part in parts:
+        if isinstance(part, str):
+            part = part.encode('utf-8')
+        digest.update(len(part).to_bytes(8, 'little'))
+        digest.update(part)
+    return digest.hexdigest()
+
+def CacheGet(key):
+    """Get an output from the cache
+
+    Args:
+        key (str): Key returned by CacheKey()
+
+    Returns:
+        bytes: Output, or None if not found
+    """
+    global cache_hits, cache_misses
+
+    if not key:
+        return None
+    fname = os.path.join(cache_dir, key[:2], key)
+    if not os.path.exists(fname):
+        cache_misses += 1
+        return None
+    cache_hits += 1
+    tout.debug(f'Cache hit {key}')
+    return tools.read_file(fname)
+
+def CachePut(key, data):
+    """Add an output to the cache
+
+    The file is written under another name and then renamed, so that other
+    binman processes sharing the cache never see a partial file.
+
+    Args:
+        key (str): Key returned by CacheKey(), or None to do nothing
+        data (bytes): Output to add
+    """
+    if not key:
+        return
+    dirname = os.path.join(cache_dir, key[:2])
+    os.makedirs(dirname, exist_ok=True)
+    fname = os.path.join(dirname, key)
+    tmpname = f'{fname}.{os.getpid()}.{threading.get_ident()}'
+    tools.write_file(tmpname, data)
+    os.replace(tmpname, fname)
+
 def GetTiming(name):
     """Get the timing info for a particular operation
 
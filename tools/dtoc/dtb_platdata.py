@@ -19,6 +19,7 @@ from enum import IntEnum
 import os
 import re
 import sys
+import zlib
 
 from dtoc import fdt
 from dtoc import fdt_util
@@ -1113,6 +1114,74 @@ class DtbPlatdata():
 
         self.out(''.join(self.get_buf()))
 
+    def generate_bind(self):
+        """Generate a list of devicetree nodes to bind in U-Boot proper
+
+        This writes out a struct dm_bind_list holding each node with a
+        compatible string, along with the driver which lists_bind_fdt() would
+        pick for it: the driver for the first compatible string that has
+        one. Nodes are numbered in devicetree order, with the root node being
+        0. The entries are sorted by parent so that U-Boot can find the
+        subnodes of a node quickly.
+
+        See CONFIG_DM_BIND_LIST for more information.
+        """
+        entries = []
+        count = 0
+
+        def add_node(node, parent_idx):
+            nonlocal count
+
+            idx = count
+            count += 1
+            compat = node.props.get('compatible')
+            if parent_idx is not None and compat:
+                entries.append((parent_idx, idx, node, compat))
+            for subnode in node.subnodes:
+                add_node(subnode, idx)
+
+        add_node(self._fdt.GetRoot(), None)
+        with open(self._dtb_fname, 'rb') as inf:
+            data = inf.read()
+
+        self.out('#include <dm.h>\n')
+        self.out('#include <dm/bind_list.h>\n')
+        self.out('\n')
+
+        lines = []
+        drivers = set()
+        for parent_idx, idx, node, compat in sorted(entries,
+                                                    key=lambda x: x[:2]):
+            values = compat.value
+            if not isinstance(values, list):
+                values = [values]
+            for value in values:
+                driver = self._scan.get_compat_driver(value)
+                if driver:
+                    break
+            lines.append('\t/* %s */\n' % node.path)
+            if driver:
+                drivers.add(driver.name)
+                lines.append('\t{%d, %d, "%s", DM_DRIVER_REF(%s)},\n' %
+                             (idx, parent_idx, value, driver.name))
+            else:
+                lines.append('\t{%d, %d, NULL, NULL},\n' % (idx, parent_idx))
+
+        for name in sorted(drivers):
+            self.out('DM_BIND_DRIVER(%s);\n' % name)
+        self.out('\n')
+        self.out('static const struct dm_bind_entry dm_bind_entries[] = {\n')
+        self.out(''.join(lines))
+        self.out('};\n')
+        self.out('\n')
+        self.out('const struct dm_bind_list dm_bind_list = {\n')
+        self.out('\t.entries\t= dm_bind_entries,\n')
+        self.out('\t.count\t\t= ARRAY_SIZE(dm_bind_entries),\n')
+        self.out('\t.node_count\t= %d,\n' % count)
+        self.out('\t.fdt_size\t= %#x,\n' % len(data))
+        self.out('\t.fdt_crc32\t= %#x,\n' % zlib.crc32(data))
+        self.out('};\n')
+
 
 # Types of output file we understand
 # key: Command used to generate this file
@@ -1144,6 +1213,13 @@ OUTPUT_FILES_INST = {
                    'Declares the uclass instances (struct uclass)'),
     }
 
+# This is only used for U-Boot proper and needs nothing from the other files
+OUTPUT_FILES_BIND = {
+    'bind':
+        OutputFile(Ftype.SOURCE, 'dt-bind.c', DtbPlatdata.generate_bind,
+                   'Declares the devicetree nodes to bind and their drivers'),
+    }
+
 
 def run_steps(args, dtb_file, include_disabled, output, output_dirs, phase,
               instantiate, warning_disabled=False, drivers_additional=None,
@@ -1190,24 +1266,29 @@ def run_steps(args, dtb_file, include_disabled, output, output_dirs, phase,
         do_process = False
     plat = DtbPlatdata(scan, dtb_file, include_disabled, instantiate)
     plat.scan_dtb()
-    plat.scan_tree(add_root=instantiate)
-    plat.prepare_nodes()
-    plat.scan_reg_sizes()
-    plat.setup_output_dirs(output_dirs)
-    plat.scan_structs()
-    plat.scan_phandles()
-    plat.process_nodes(instantiate)
-    plat.read_aliases()
-    plat.assign_seqs()
-
-    # Figure out what output files we plan to generate
-    output_files = dict(OUTPUT_FILES_COMMON)
-    if instantiate:
-        output_files.update(OUTPUT_FILES_INST)
+    cmds = args[0].split(',')
+    if cmds == ['bind']:
+        # This covers the whole tree and needs none of the steps below
+        plat.setup_output_dirs(output_dirs)
+        output_files = OUTPUT_FILES_BIND
     else:
-        output_files.update(OUTPUT_FILES_NOINST)
+        plat.scan_tree(add_root=instantiate)
+        plat.prepare_nodes()
+        plat.scan_reg_sizes()
+        plat.setup_output_dirs(output_dirs)
+        plat.scan_structs()
+        plat.scan_phandles()
+        plat.process_nodes(instantiate)
+        plat.read_aliases()
+        plat.assign_seqs()
+
+        # Figure out what output files we plan to generate
+        output_files = dict(OUTPUT_FILES_COMMON)
+        if instantiate:
+            output_files.update(OUTPUT_FILES_INST)
+        else:
+            output_files.update(OUTPUT_FILES_NOINST)
 
-    cmds = args[0].split(',')
     if 'all' in cmds:
         cmds = sorted(output_files.keys())
     for cmd in cmds:
@@ -239,6 +239,21 @@ class Scanner:
         """
         return self._drivers.get(name)
 
+    def get_compat_driver(self, compat):
+        """Get the driver which binds to a compatible string
+
+        Where several drivers have the compatible string, this is the one
+        whose name is earliest in the alphabet, which is also the first in
+        the driver linker list
+
+        Args:
+            compat (str): Compatible string, e.g. 'rockchip,rk3288-grf'
+
+        Returns:
+            Driver: Driver or None if not found
+        """
+        return self._compat_to_driver.get(compat)
+
     def get_normalized_compat_name(self, node):
         """Get a node's normalized compat name
 
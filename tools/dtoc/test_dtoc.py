@@ -16,6 +16,7 @@ import os
 import pathlib
 import struct
 import unittest
+import zlib
 
 from dtoc import dtb_platdata
 from dtoc import fdt
@@ -1542,6 +1543,62 @@ U_BOOT_DRVINFO(spl_test2) = {
         self.assertIn("Please specify a command: struct, platdata",
                       str(exc.exception))
 
+    def test_bind(self):
+        """Test output of the list of nodes to bind in U-Boot proper"""
+        dtb_file = get_dtb_file('dtoc_test_simple.dts')
+        output = tools.get_output_filename('output')
+        self.run_test(['bind'], dtb_file, output)
+        data = tools.read_file(output, binary=False)
+        dtb = tools.read_file(dtb_file)
+
+        self._check_strings('''/*
+ * DO NOT MODIFY
+ *
+ * Declares the devicetree nodes to bind and their drivers.
+ * This was generated by dtoc from a .dtb (device tree binary) file.
+ */
+
+#include <dm.h>
+#include <dm/bind_list.h>
+
+DM_BIND_DRIVER(sandbox_i2c);
+DM_BIND_DRIVER(sandbox_pmic);
+DM_BIND_DRIVER(sandbox_spl_test);
+
+static const struct dm_bind_entry dm_bind_entries[] = {
+\t/* /spl-test */
+\t{1, 0, "sandbox,spl-test", DM_DRIVER_REF(sandbox_spl_test)},
+\t/* /spl-test2 */
+\t{2, 0, "sandbox,spl-test", DM_DRIVER_REF(sandbox_spl_test)},
+\t/* /spl-test3 */
+\t{3, 0, "sandbox,spl-test", DM_DRIVER_REF(sandbox_spl_test)},
+\t/* /i2c@0 */
+\t{4, 0, "sandbox,i2c", DM_DRIVER_REF(sandbox_i2c)},
+\t/* /i2c@0/pmic@9 */
+\t{5, 4, "sandbox,pmic", DM_DRIVER_REF(sandbox_pmic)},
+};
+
+const struct dm_bind_list dm_bind_list = {
+\t.entries\t= dm_bind_entries,
+\t.count\t\t= ARRAY_SIZE(dm_bind_entries),
+\t.node_count\t= 7,
+\t.fdt_size\t= %#x,
+\t.fdt_crc32\t= %#x,
+};
+''' % (len(dtb), zlib.crc32(dtb)), data)
+
+        # A node with no driver is left for U-Boot to look up
+        dtb_file = get_dtb_file('dtoc_test_invalid_driver.dts')
+        self.run_test(['bind'], dtb_file, output)
+        data = tools.read_file(output, binary=False)
+        self.assertIn('''
+static const struct dm_bind_entry dm_bind_entries[] = {
+\t/* /spl-test */
+\t{1, 0, NULL, NULL},
+};
+''', data)
+        self.assertNotIn('DM_BIND_DRIVER', data)
+
     def test_bad_command(self):
         """Test running dtoc with an invalid command"""
         dtb_file = get_dtb_file('dtoc_test_simple.dts')
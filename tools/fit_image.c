@@ -80,6 +80,7 @@ static int fit_add_file_data(struct image_tool_params *params, size_t size_inc,
 						params->engine_id,
 						params->cmdname,
 						params->algo_name,
+						params->jobs,
 						&params->summary);
 	}
 
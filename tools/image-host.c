@@ -12,6 +12,7 @@
 #include <bootm.h>
 #include <fdt_region.h>
 #include <image.h>
+#include <pthread.h>
 #include <version.h>
 
 #if CONFIG_IS_ENABLED(FIT_SIGNATURE)
@@ -49,6 +50,208 @@ static int fit_set_hash_value(void *fit, int noffset, uint8_t *value,
 	return 0;
 }
 
+/**
+ * struct fit_hash_job - A hash of an image, calculated ahead of time
+ *
+ * @image_name: Name of the image node
+ * @node_name: Name of the hash node
+ * @algo: Hash algorithm
+ * @data: Image data, only valid until the FIT is changed
+ * @size: Size of @data
+ * @value: Hash value
+ * @value_len: Length of @value
+ * @ret: 0 if @value is valid, -ve if the hash could not be calculated
+ */
+struct fit_hash_job {
+	char *image_name;
+	char *node_name;
+	char *algo;
+	const void *data;
+	size_t size;
+	uint8_t value[FIT_MAX_HASH_LEN];
+	int value_len;
+	int ret;
+};
+
+/**
+ * struct fit_hash_pool - Hashes of all the images in a FIT
+ *
+ * @job: Hashes to calculate
+ * @count: Number of entries in @job
+ * @next: Next entry in @job for a thread to calculate
+ * @lock: Protects @next
+ */
+static struct fit_hash_pool {
+	struct fit_hash_job *job;
+	int count;
+	int next;
+	pthread_mutex_t lock;
+} fit_hash_pool = {
+	.lock = PTHREAD_MUTEX_INITIALIZER,
+};
+
+static void *fit_hash_thread(void *arg)
+{
+	struct fit_hash_pool *pool = arg;
+	struct fit_hash_job *job;
+
+	for (;;) {
+		pthread_mutex_lock(&pool->lock);
+		job = pool->next < pool->count ? &pool->job[pool->next++] :
+			NULL;
+		pthread_mutex_unlock(&pool->lock);
+		if (!job)
+			return NULL;
+		job->ret = calculate_hash(job->data, job->size, job->algo,
+					  job->value, &job->value_len);
+	}
+}
+
+static void fit_hash_free(void)
+{
+	struct fit_hash_pool *pool = &fit_hash_pool;
+	int i;
+
+	for (i = 0; i < pool->count; i++) {
+		free(pool->job[i].image_name);
+		free(pool->job[i].node_name);
+		free(pool->job[i].algo);
+	}
+	free(pool->job);
+	pool->job = NULL;
+	pool->count = 0;
+}
+
+/**
+ * fit_hash_add() - Add the hashes of an image to the pool
+ *
+ * @fit: FIT being processed
+ * @image_noffset: Offset of the image node
+ * Return: 0 if OK, -ENOMEM if out of memory
+ */
+static int fit_hash_add(const void *fit, int image_noffset)
+{
+	struct fit_hash_pool *pool = &fit_hash_pool;
+	const char *image_name, *node_name, *algo;
+	struct fit_hash_job *job;
+	const void *data;
+	size_t size;
+	int noffset;
+
+	if (fit_image_get_data(fit, image_noffset, &data, &size))
+		return 0;
+	image_name = fit_get_name(fit, image_noffset, NULL);
+
+	for (noffset = fdt_first_subnode(fit, image_noffset);
+	     noffset >= 0;
+	     noffset = fdt_next_subnode(fit, noffset)) {
+		node_name = fit_get_name(fit, noffset, NULL);
+		if (strncmp(node_name, FIT_HASH_NODENAME,
+			    strlen(FIT_HASH_NODENAME)) ||
+		    fit_image_hash_get_algo(fit, noffset, &algo))
+			continue;
+		job = realloc(pool->job, (pool->count + 1) * sizeof(*job));
+		if (!job)
+			return -ENOMEM;
+		pool->job = job;
+		job += pool->count++;
+		memset(job, '\0', sizeof(*job));
+		job->image_name = strdup(image_name);
+		job->node_name = strdup(node_name);
+		job->algo = strdup(algo);
+		job->data = data;
+		job->size = size;
+		job->ret = -ENOENT;
+		if (!job->image_name || !job->node_name || !job->algo)
+			return -ENOMEM;
+	}
+
+	return 0;
+}
+
+/**
+ * fit_hash_images() - Calculate the hashes of all images using threads
+ *
+ * The results are used by fit_image_process_hash(). Any failure here just
+ * means that the hashes are calculated there instead.
+ *
+ * @fit: FIT being processed
+ * @images_noffset: Offset of the /images node
+ * @jobs: Number of threads to use, 0 for one per CPU
+ */
+static void fit_hash_images(const void *fit, int images_noffset, int jobs)
+{
+	struct fit_hash_pool *pool = &fit_hash_pool;
+	pthread_t *thread;
+	int noffset, i;
+
+	if (!jobs)
+		jobs = sysconf(_SC_NPROCESSORS_ONLN);
+	if (jobs <= 1)
+		return;
+	for (noffset = fdt_first_subnode(fit, images_noffset);
+	     noffset >= 0;
+	     noffset = fdt_next_subnode(fit, noffset)) {
+		if (fit_hash_add(fit, noffset)) {
+			fit_hash_free();
+			return;
+		}
+	}
+	if (pool->count < 2) {
+		fit_hash_free();
+		return;
+	}
+
+	if (jobs > pool->count)
+		jobs = pool->count;
+	thread = calloc(jobs, sizeof(*thread));
+	if (!thread) {
+		fit_hash_free();
+		return;
+	}
+	pool->next = 0;
+	/* This thread is one of the workers */
+	for (i = 0; i < jobs - 1; i++) {
+		if (pthread_create(&thread[i], NULL, fit_hash_thread, pool))
+			break;
+	}
+	fit_hash_thread(pool);
+	while (i--)
+		pthread_join(thread[i], NULL);
+	free(thread);
+}
+
+/**
+ * fit_hash_lookup() - Look up a hash calculated by fit_hash_images()
+ *
+ * @image_name: Name of the image node
+ * @node_name: Name of the hash node
+ * @algo: Hash algorithm
+ * @value: Returns the hash value
+ * @value_len: Returns the length of @value
+ * Return: 0 if found, -ENOENT if the hash must be calculated
+ */
+static int fit_hash_lookup(const char *image_name, const char *node_name,
+			   const char *algo, uint8_t *value, int *value_len)
+{
+	struct fit_hash_pool *pool = &fit_hash_pool;
+	struct fit_hash_job *job;
+	int i;
+
+	for (i = 0; i < pool->count; i++) {
+		job = &pool->job[i];
+		if (!job->ret && !strcmp(job->image_name, image_name) &&
+		    !strcmp(job->node_name, node_name) &&
+		    !strcmp(job->algo, algo)) {
+			memcpy(value, job->value, job->value_len);
+			*value_len = job->value_len;
+			return 0;
+		}
+	}
+
+	return -ENOENT;
+}
+
 /**
  * fit_image_process_hash - Process a single subnode of the images/ node
  *
@@ -80,7 +283,8 @@ static int fit_image_process_hash(void *fit, const char *image_name,
 		return -ENOENT;
 	}
 
-	if (calculate_hash(data, size, algo, value, &value_len)) {
+	if (fit_hash_lookup(image_name, node_name, algo, value, &value_len) &&
+	    calculate_hash(data, size, algo, value, &value_len)) {
 		fprintf(stderr,
 			"Unsupported hash algorithm (%s) for '%s' hash node in '%s' image node\n",
 			algo, node_name, image_name);
@@ -1305,7 +1509,7 @@ int fit_add_verification_data(const char *keydir, const char *keyfile,
 			      void *keydest, void *fit, const char *comment,
 			      int require_keys, const char *engine_id,
 			      const char *cmdname, const char *algo_name,
-			      struct image_summary *summary)
+			      int jobs, struct image_summary *summary)
 {
 	int images_noffset, confs_noffset;
 	int noffset;
@@ -1319,6 +1523,8 @@ int fit_add_verification_data(const char *keydir, const char *keyfile,
 		return images_noffset;
 	}
 
+	fit_hash_images(fit, images_noffset, jobs);
+
 	/* Process its subnodes, print out component images details */
 	for (noffset = fdt_first_subnode(fit, images_noffset);
 	     noffset >= 0;
@@ -1334,9 +1540,11 @@ int fit_add_verification_data(const char *keydir, const char *keyfile,
 			fprintf(stderr, "Can't add verification data for node '%s' (%s)\n",
 				fdt_get_name(fit, noffset, NULL),
 				fdt_strerror(ret));
+			fit_hash_free();
 			return ret;
 		}
 	}
+	fit_hash_free();
 
 	/* If there are no keys, we can't sign configurations */
 	if (!IMAGE_ENABLE_SIGN || !(keydir || keyfile))
@@ -0,0 +1,117 @@
+#!/usr/bin/env python3
+# SPDX-License-Identifier: GPL-2.0+
+
+"""
+Turn the output of the U-Boot 'profiler dump' command into a histogram of
+time spent in each function.
+
+The dump is read from a console log, which may contain other output. Each
+address is looked up in u-boot.map (from the linker) or System.map (from nm).
+
+Example:
+    tools/profiler.py -m u-boot.map console.log
+"""
+
+import argparse
+import bisect
+import re
+import sys
+
+# Symbol line in u-boot.map: address followed by a symbol name
+RE_MAP = re.compile(r'^\s+0x([0-9a-f]+)\s+([A-Za-z_.$][\w.$]*)\s*$')
+
+# Line in System.map: address, type and symbol name
+RE_NM = re.compile(r'^([0-9a-f]+) [tTwW] (\S+)$')
+
+# Start of the dump and each line in it
+RE_START = re.compile(r'profiler: (\d+) samples')
+RE_SAMPLE = re.compile(r'^([0-9a-f]+) (\d+)\s*$')
+
+def read_symbols(fname):
+    """Read the code symbols from a map file
+
+    Args:
+        fname (str): Filename of u-boot.map or System.map
+
+    Returns:
+        tuple:
+            list of int: Sorted symbol addresses
+            list of str: Symbol name for each address
+    """
+    syms = {}
+    with open(fname, encoding='utf-8', errors='replace') as inf:
+        for line in inf:
+            mat = RE_MAP.match(line) or RE_NM.match(line)
+            if mat:
+                addr = int(mat.group(1), 16)
+                if addr:
+                    syms.setdefault(addr, mat.group(2))
+    addrs = sorted(syms)
+    return addrs, [syms[addr] for addr in addrs]
+
+def read_samples(fname):
+    """Read the last profiler dump from a console log
+
+    Args:
+        fname (str): Filename of the log, or '-' for stdin
+
+    Returns:
+        list of tuple: (address, count) for each address in the dump
+    """
+    samples = None
+    inf = sys.stdin if fname == '-' else open(fname, encoding='utf-8',
+                                              errors='replace')
+    with inf:
+        for line in inf:
+            line = line.rstrip('\r\n')
+            if RE_START.search(line):
+                samples = []
+            elif samples is not None:
+                mat = RE_SAMPLE.match(line)
+                if mat:
+                    samples.append((int(mat.group(1), 16),
+                                    int(mat.group(2))))
+    return samples or []
+
+def make_histogram(samples, addrs, names):
+    """Add up the samples for each function
+
+    Returns:
+        dict: count for each function name
+    """
+    hist = {}
+    for addr, count in samples:
+        pos = bisect.bisect_right(addrs, addr) - 1
+        name = names[pos] if pos >= 0 else '0x%x' % addr
+        hist[name] = hist.get(name, 0) + count
+    return hist
+
+def run():
+    """Parse arguments and show the histogram"""
+    parser = argparse.ArgumentParser(
+        description='Show a function histogram from a U-Boot profiler dump')
+    parser.add_argument('log', help="console log containing 'profiler dump'"
+                        " output, or - for stdin")
+    parser.add_argument('-m', '--map', required=True,
+                        help='u-boot.map or System.map for the same build')
+    parser.add_argument('-n', '--count', type=int, default=30,
+                        help='number of functions to show (0 for all)')
+    args = parser.parse_args()
+
+    samples = read_samples(args.log)
+    if not samples:
+        print('No profiler dump found', file=sys.stderr)
+        return 1
+    addrs, names = read_symbols(args.map)
+    hist = make_histogram(samples, addrs, names)
+    total = sum(hist.values())
+    items = sorted(hist.items(), key=lambda item: item[1], reverse=True)
+    if args.count:
+        items = items[:args.count]
+    print('%8s %6s  %s' % ('Samples', '%', 'Function'))
+    for name, count in items:
+        print('%8d %6.2f  %s' % (count, count * 100 / total, name))
+    return 0
+
+if __name__ == '__main__':
+    sys.exit(run())